@@ -65,15 +65,268 @@ extern "C" {
 #pragma GCC visibility push(default)
 #endif
 
-#define MAX_FEATURES_COUNT 256
+#define MAX_FEATURES_COUNT 65536
 
 typedef enum {
   FEATURE_EXTRACTION_RESULT_OK = 0,
-  FEATURE_EXTRACTION_RESULT_ERROR = 1
+  FEATURE_EXTRACTION_RESULT_ERROR = 1,
+  /// @brief See cancel_extractions() and set_extraction_timeout().
+  FEATURE_EXTRACTION_RESULT_CANCELLED = 2
 } FeatureExtractionResult;
 
+/// @brief How the memory of the transform trees is backed by huge pages,
+/// see set_huge_pages_mode().
+typedef enum {
+  HUGE_PAGES_NONE = 0,
+  /// @brief Align the large blocks to 2 MiB and madvise(MADV_HUGEPAGE).
+  HUGE_PAGES_TRANSPARENT = 1,
+  /// @brief Map the large blocks from the reserved huge pages (MAP_HUGETLB),
+  /// falling back to HUGE_PAGES_TRANSPARENT.
+  HUGE_PAGES_EXPLICIT = 2
+} HugePagesMode;
+
+/// @brief The algorithm which places the buffers of the transform trees,
+/// see set_buffers_allocator().
+typedef enum {
+  /// @brief Tries the traversal variants and slides the buffers blocks.
+  BUFFERS_ALLOCATOR_SLIDING_BLOCKS = 0,
+  /// @brief Packs the buffers by their exact lifetimes (greedy best fit by
+  /// size).
+  BUFFERS_ALLOCATOR_INTERVAL_PACKING = 1
+} BuffersAllocatorType;
+
+/// @brief How much accuracy the transforms may trade for speed, see
+/// set_accuracy().
+typedef enum {
+  /// @brief The default parameters of the transforms.
+  ACCURACY_EXACT = 0,
+  /// @brief The fast logarithms and geometric means and the Illinois LSP
+  /// refinement, the errors are about 1e-6 relative.
+  ACCURACY_BALANCED = 1,
+  /// @brief ACCURACY_BALANCED with fewer LSP refinement steps, the errors
+  /// are about 1e-5 relative.
+  ACCURACY_FAST = 2
+} AccuracyTier;
+
+/// @brief The type which the elements of a feature are converted to when
+/// the results are fetched, see set_feature_output_type().
+typedef enum {
+  /// @brief The elements are fetched as the tree calculates them.
+  FEATURE_OUTPUT_NATIVE = 0,
+  /// @brief Rounded to the nearest integer and saturated, as FloatToInt16.
+  FEATURE_OUTPUT_INT16 = 1,
+  /// @brief Rounded to the nearest integer and saturated, as FloatToInt32.
+  FEATURE_OUTPUT_INT32 = 2,
+  /// @brief Rounded to the nearest IEEE 754 half precision number, as
+  /// Float16.
+  FEATURE_OUTPUT_FLOAT16 = 3
+} FeatureOutputType;
+
+/// @brief How much the transform trees measure about each node, see
+/// set_profiling_level().
+typedef enum {
+  /// @brief Only the total time, report_extraction_time() returns
+  /// just "All" and "Other".
+  PROFILING_LEVEL_OFF = 0,
+  /// @brief The time of each node, measured with the time stamp counter.
+  PROFILING_LEVEL_COARSE = 1,
+  /// @brief PROFILING_LEVEL_COARSE plus the hardware performance counters
+  /// of each node (Linux perf events).
+  PROFILING_LEVEL_FULL = 2
+} ProfilingLevelType;
+
+/// @brief What set_extraction_profiling() records.
+typedef enum {
+  EXTRACTION_PROFILING_NONE = 0,
+  /// @brief The execution times and the processed bytes of each node.
+  EXTRACTION_PROFILING_STATISTICS = 1,
+  /// @brief The statistics plus the Chrome trace events of every execution,
+  /// see save_extraction_trace().
+  EXTRACTION_PROFILING_TRACE = 2
+} ExtractionProfilingMode;
+
+/// @brief The statistics of a single transform tree node. The times are
+/// in seconds; the percentiles are accurate up to 1/8 of their values.
+typedef struct {
+  int calls;
+  float total;
+  float median;
+  float p99;
+  /// @brief The total size of the input buffers.
+  size_t bytes_in;
+  /// @brief The total size of the output buffers.
+  size_t bytes_out;
+} NodeProfile;
+
+/// @brief The hardware performance counters of a single transform tree node
+/// in the last extraction, see report_extraction_counters().
+typedef struct {
+  uint64_t cycles;
+  uint64_t instructions;
+  /// @brief Instructions per cycle.
+  float ipc;
+  uint64_t llc_misses;
+  /// @brief The memory traffic in bytes per second, estimated as 64 bytes
+  /// per LLC miss.
+  float bandwidth;
+} NodeHardwareCounters;
+
+/// @brief The instruction sets of the SIMD kernels, ordered by the vector
+/// width. The kernels are selected at runtime among the ones which the CPU
+/// supports.
+typedef enum {
+  INSTRUCTION_SET_SCALAR = 0,
+  INSTRUCTION_SET_NEON = 1,
+  INSTRUCTION_SET_SSE4_1 = 2,
+  INSTRUCTION_SET_AVX = 3,
+  INSTRUCTION_SET_AVX2 = 4,
+  INSTRUCTION_SET_AVX512 = 5
+} InstructionSetType;
+
+/// @brief Where a transform tree node runs, see
+/// report_extraction_placements().
+typedef enum {
+  /// @brief In the calling thread.
+  NODE_PLACEMENT_SERIAL = 0,
+  /// @brief On the library thread pool.
+  NODE_PLACEMENT_PARALLEL = 1
+} NodePlacementType;
+
+/// @brief The memory of a configuration, see report_extraction_memory().
+typedef struct {
+  /// @brief The size of the memory blocks of the buffers, the one which
+  /// each concurrent extraction allocates.
+  size_t allocated;
+  /// @brief The maximal total size of the buffers which are alive
+  /// simultaneously, the lower bound of "allocated".
+  size_t peak;
+  /// @brief The total size of the buffers of all the nodes.
+  size_t buffers;
+  /// @brief The memory which the transforms hold besides their buffers,
+  /// e.g., the filter weights or the window tables.
+  size_t private_memory;
+} ExtractionMemoryUsage;
+
+/// @brief The memory of a single transform tree node, see
+/// report_extraction_memory().
+typedef struct {
+  /// @brief The size of the node's buffers, 0 if it shares the buffers of
+  /// the parent.
+  size_t buffers;
+  size_t private_memory;
+} NodeMemoryUsage;
+
+/// @brief The arrangement of the channels in the input of
+/// setup_features_extraction_multichannel() configurations.
+typedef enum {
+  /// @brief Each channel's samples go one after another.
+  CHANNELS_LAYOUT_PLANAR = 0,
+  /// @brief The samples of the channels alternate, e.g., L R L R ...
+  CHANNELS_LAYOUT_INTERLEAVED = 1
+} ChannelsLayoutType;
+
+/// @brief How setup_features_extraction_budget() processes the input.
+typedef enum {
+  /// @brief The whole buffer at once.
+  EXTRACTION_PLAN_WHOLE = 0,
+  /// @brief The independent chunks, see set_chunk_size().
+  EXTRACTION_PLAN_CHUNKS = 1,
+  /// @brief The overlapping blocks, see setup_features_extraction_blocks().
+  EXTRACTION_PLAN_BLOCKS = 2
+} ExtractionPlanType;
+
+/// @brief The way to fit the extraction into the memory budget, see
+/// setup_features_extraction_budget().
+typedef struct {
+  ExtractionPlanType type;
+  /// @brief The number of the chunks or blocks, 1 for the whole buffer.
+  int count;
+  /// @brief The number of samples which a tree processes at once.
+  size_t size;
+  /// @brief The size of the buffers of all the trees.
+  size_t memory;
+} ExtractionPlan;
+
 typedef struct FeaturesConfiguration FeaturesConfiguration;
 
+/// @brief The prepared configuration which sfe-compile embeds into
+/// a plugin, see load_compiled_features_configuration().
+typedef struct {
+  /// @brief The feature descriptions joined with '\n'.
+  const char *features;
+  size_t buffer_size;
+  int sampling_rate;
+  /// @brief The contents of the file written by
+  /// save_features_configuration(), aligned to 64 bytes.
+  const void *image;
+  size_t image_size;
+} CompiledFeaturesConfiguration;
+
+/// @brief The name of the CompiledFeaturesConfiguration exported by
+/// the plugins.
+#define COMPILED_FEATURES_CONFIGURATION_SYMBOL \
+    "sfe_compiled_features_configuration"
+
+/// @brief How the chunks of a feature store are encoded,
+/// see open_feature_store().
+typedef enum {
+  /// @brief The rows as they are, so that the file can be memory mapped.
+  FEATURE_STORE_CODEC_NONE = 0,
+  /// @brief Delta between the rows, byte shuffle and LZ4. Falls back to
+  /// FEATURE_STORE_CODEC_NONE if the library was built without LZ4.
+  FEATURE_STORE_CODEC_LZ4 = 1
+} FeatureStoreCodecType;
+
+typedef struct FeatureStore FeatureStore;
+
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+/// @brief The schema of the Apache Arrow C data interface, see
+/// https://arrow.apache.org/docs/format/CDataInterface.html
+struct ArrowSchema {
+  const char *format;
+  const char *name;
+  const char *metadata;
+  int64_t flags;
+  int64_t n_children;
+  struct ArrowSchema **children;
+  struct ArrowSchema *dictionary;
+  void (*release)(struct ArrowSchema *);
+  void *private_data;
+};
+
+/// @brief The array of the Apache Arrow C data interface.
+struct ArrowArray {
+  int64_t length;
+  int64_t null_count;
+  int64_t offset;
+  int64_t n_buffers;
+  int64_t n_children;
+  const void **buffers;
+  struct ArrowArray **children;
+  struct ArrowArray *dictionary;
+  void (*release)(struct ArrowArray *);
+  void *private_data;
+};
+
+#endif  // ARROW_C_DATA_INTERFACE
+
+/// @brief Read-only view of a feature's buffers inside the library's memory.
+typedef struct {
+  const char *name;
+  /// @brief The first buffer. The others follow with "stride" bytes step.
+  const void *data;
+  int count;
+  /// @brief The meaningful size of each buffer in bytes.
+  int size;
+  int stride;
+} FeatureView;
+
 /// @brief Allocates and fills the array of transform names.
 void query_transforms_list(char ***names, int *listSize) NOTNULL(1, 2);
 
@@ -103,11 +356,453 @@ FeaturesConfiguration *setup_features_extraction(
     const char *const *features, int featuresCount,
     size_t bufferSize, int samplingRate) NOTNULL(1) WARN_UNUSED_RESULT MALLOC;
 
+/// @brief The configuration which setup_features_extraction_async() is
+/// preparing.
+typedef struct SetupRequest SetupRequest;
+
+/// @brief setup_features_extraction() which parses the features and
+/// prepares the tree on a background thread, so that the caller is not
+/// blocked by the filter designs, the plans and the allocation.
+/// The features are copied, so they may be released at once. Every request
+/// must be finished with finish_features_setup().
+SetupRequest *setup_features_extraction_async(
+    const char *const *features, int featuresCount,
+    size_t bufferSize, int samplingRate) NOTNULL(1) WARN_UNUSED_RESULT MALLOC;
+
+/// @brief Indicates whether the configuration is ready (or failed), so
+/// that finish_features_setup() does not block.
+bool poll_features_setup(const SetupRequest *request) NOTNULL(1);
+
+/// @brief Waits until the configuration is ready and destroys the request.
+/// @return The same as setup_features_extraction(), NULL on errors.
+FeaturesConfiguration *finish_features_setup(SetupRequest *request)
+    NOTNULL(1) WARN_UNUSED_RESULT;
+
+/// @brief Extracts the features from the buffer of the size which was
+/// specified in setup_features_extraction().
+/// @note This function may be called simultaneously from several threads
+/// with the same configuration; the concurrent calls use separate buffers.
+/// report_extraction_time() and report_extraction_graph() reflect only
+/// the calls which have not overlapped.
 FeatureExtractionResult extract_sound_features(
     const FeaturesConfiguration *fc, int16_t *buffer,
     char ***featureNames, void ***results, int **resultLengths)
     NOTNULL(1, 2, 3, 4, 5);
 
+/// @brief Extracts the features as extract_sound_features() does, but
+/// on at most maxThreads threads. Non-positive maxThreads means no limit
+/// besides the threads governor, see set_threads_governor().
+FeatureExtractionResult extract_sound_features_threads(
+    const FeaturesConfiguration *fc, int16_t *buffer, int maxThreads,
+    char ***featureNames, void ***results, int **resultLengths)
+    NOTNULL(1, 2, 4, 5, 6);
+
+/// @brief Extracts only the specified features out of the configured ones,
+/// skipping the transforms which none of them depends on. The results are
+/// laid out as the ones of extract_sound_features(), but contain only
+/// the requested features.
+FeatureExtractionResult extract_sound_features_subset(
+    const FeaturesConfiguration *fc, int16_t *buffer,
+    const char *const *features, int featuresCount,
+    char ***featureNames, void ***results, int **resultLengths)
+    NOTNULL(1, 2, 3, 5, 6, 7);
+
+/// @brief Receives a feature of extract_sound_features_sink() as soon as it
+/// is calculated. The result of resultLength bytes is laid out as in
+/// extract_sound_features() and is valid only during the call.
+/// @param chunk The index of the part of the input which the result
+/// belongs to, when the tree processes the input in several parts (see
+/// set_chunk_size()); the parts are passed in order.
+typedef void (*FeatureSink)(const char *featureName, const void *result,
+                            int resultLength, int chunk, void *userData);
+
+/// @brief Extracts the features as extract_sound_features() does, but
+/// passes each of them to sink as soon as its calculation is finished,
+/// while the rest are still being calculated, instead of copying all of
+/// them at the end. The sink may be called concurrently from several
+/// threads with the parallel execution.
+/// @note Not supported by the streaming, batch, ragged and block
+/// configurations.
+FeatureExtractionResult extract_sound_features_sink(
+    const FeaturesConfiguration *fc, int16_t *buffer, FeatureSink sink,
+    void *userData) NOTNULL(1, 2, 3);
+
+/// @brief Creates the configuration which extracts the same features as
+/// setup_features_extraction() does, but processes the input of bufferSize
+/// samples in the overlapping blocks, so that the working memory depends on
+/// blockSize instead of bufferSize. Each block contributes about blockSize
+/// samples and also reads the neighbouring ones which the transforms
+/// require (e.g., the windows around each Delta or STMSN row), so
+/// the results are identical to the ones of the whole buffer, unlike with
+/// get_chunk_size(). The configuration is an ordinary one if the input
+/// fits a single block.
+/// @return NULL if some feature depends on the whole input, e.g., through
+/// Stats or an IIR filter.
+/// @note Views, feature stores, dynamic batching and saving are not
+/// supported.
+FeaturesConfiguration *setup_features_extraction_blocks(
+    const char *const *features, int featuresCount,
+    size_t bufferSize, size_t blockSize, int samplingRate)
+    NOTNULL(1) WARN_UNUSED_RESULT MALLOC;
+
+/// @brief Creates the configuration which extracts the features out of
+/// bufferSize samples within memoryBudget bytes of the transform buffers.
+/// If the whole buffer does not fit, it is split into the blocks (see
+/// setup_features_extraction_blocks()) and, if some feature depends on
+/// the whole input, into the independent chunks (see set_chunk_size()),
+/// which change the results of such features.
+/// @param plan If not NULL, receives the chosen way.
+/// @return NULL if even the smallest split does not fit.
+FeaturesConfiguration *setup_features_extraction_budget(
+    const char *const *features, int featuresCount, size_t bufferSize,
+    int samplingRate, size_t memoryBudget, ExtractionPlan *plan)
+    NOTNULL(1) WARN_UNUSED_RESULT MALLOC;
+
+/// @brief Creates the configuration which extracts several variants of
+/// the feature sets, e.g., the same MFCC with different window lengths and
+/// band counts, out of the same input in a single pass. The common prefixes
+/// of the chains are executed once for all the variants.
+/// @param features The features of all the variants one after another.
+/// @param variantsSizes The number of features in each variant.
+/// @note extract_sound_features() names the results "<name>_<variant>",
+/// extract_sound_features_variants() returns the original names.
+FeaturesConfiguration *setup_features_extraction_variants(
+    const char *const *features, const int *variantsSizes, int variantsCount,
+    size_t bufferSize, int samplingRate)
+    NOTNULL(1, 2) WARN_UNUSED_RESULT MALLOC;
+
+/// @brief Does the same as extract_sound_features() with a configuration of
+/// setup_features_extraction_variants(), additionally returning the index
+/// of the variant of each result. The names are the ones in the variants.
+/// @param resultVariants Must be freed with free_result_variants().
+FeatureExtractionResult extract_sound_features_variants(
+    const FeaturesConfiguration *fc, int16_t *buffer,
+    char ***featureNames, void ***results, int **resultLengths,
+    int **resultVariants) NOTNULL(1, 2, 3, 4, 5, 6);
+
+void free_result_variants(int *resultVariants);
+
+/// @brief Sets the priority of the feature in
+/// extract_sound_features_deadline(), 0 by default.
+/// @return false if the configuration does not have such a feature.
+bool set_feature_priority(FeaturesConfiguration *fc, const char *feature,
+                          int priority) NOTNULL(1, 2);
+
+/// @brief Converts the float elements of the feature to the specified type
+/// while its results are copied out, instead of ending the feature with
+/// a format converter which runs even if the results are not fetched.
+/// extract_sound_features() and its _threads, _subset, _deadline, _int32,
+/// _float and asynchronous (without set_dynamic_batching()) variants,
+/// extract_sound_features_into(), _arrow(), _sink() and _views() return
+/// the converted elements, and query_features_layout() and
+/// query_features_dtypes() describe them; the other functions pass
+/// the features as they are. The views of
+/// the converted features point to a copy owned by the configuration.
+/// Must not be called concurrently with the extractions of fc.
+/// @return false if the configuration does not have such a feature or its
+/// elements are not floats.
+bool set_feature_output_type(FeaturesConfiguration *fc, const char *feature,
+                             FeatureOutputType type) NOTNULL(1, 2);
+
+/// @brief Changes the parameter of the transform which calculates
+/// the feature without preparing the configuration again, e.g.,
+/// Preemphasis' value. Only the parameters which keep the format of
+/// the transform's output can be changed, and the configuration must not
+/// share the prepared tree with the other ones. Must not be called
+/// concurrently with the extractions of fc.
+/// @return false if the feature does not depend on such a transform or
+/// the parameter cannot be changed.
+bool set_transform_parameter(FeaturesConfiguration *fc, const char *feature,
+                             const char *transform, const char *name,
+                             const char *value) NOTNULL(1, 2, 3, 4, 5);
+
+/// @brief Extracts the features in the order of decreasing priority (see
+/// set_feature_priority()) while they are expected to finish within
+/// budgetUs microseconds. The expectations come from the times of
+/// the previous extractions, which are not measured with
+/// PROFILING_LEVEL_OFF. The feature with the highest priority is always
+/// extracted. The results are laid out as the ones of
+/// extract_sound_features_subset() and contain featuresCount features.
+/// @param skippedNames The names of the dropped features, released with
+/// free_results(skippedCount, skippedNames, NULL, NULL), or NULL if none
+/// were dropped.
+FeatureExtractionResult extract_sound_features_deadline(
+    const FeaturesConfiguration *fc, int16_t *buffer, int budgetUs,
+    char ***featureNames, void ***results, int **resultLengths,
+    int *featuresCount, char ***skippedNames, int *skippedCount)
+    NOTNULL(1, 2, 4, 5, 6, 7, 8, 9);
+
+/// @brief Receives the results of extract_sound_features_async(). The names,
+/// the results and the lengths are NULL if result is
+/// FEATURE_EXTRACTION_RESULT_ERROR, otherwise the callback owns them and
+/// releases them with free_results().
+typedef void (*FeaturesCallback)(FeatureExtractionResult result,
+                                 int featuresCount, char **featureNames,
+                                 void **results, int *resultLengths,
+                                 void *userData);
+
+typedef struct ExtractionRequest ExtractionRequest;
+
+/// @brief Queues extract_sound_features() onto the library thread pool and
+/// returns immediately. The callback is invoked from a pool thread, or from
+/// the calling thread if the pool has a single thread (see
+/// set_omp_transforms_max_threads_num()).
+/// @note The buffer must stay intact until the callback is invoked.
+/// destroy_features_configuration() waits for the queued extractions, so it
+/// must not be called from their callbacks.
+/// @return FEATURE_EXTRACTION_RESULT_ERROR without queueing if
+/// get_max_pending_extractions() extractions are already queued.
+FeatureExtractionResult extract_sound_features_async(
+    const FeaturesConfiguration *fc, int16_t *buffer,
+    FeaturesCallback callback, void *userData) NOTNULL(1, 2, 3);
+
+/// @brief extract_sound_features_async() which is waited for with
+/// finish_extraction() instead of a callback.
+/// @return NULL if the extraction could not be queued.
+ExtractionRequest *submit_sound_features(
+    const FeaturesConfiguration *fc, int16_t *buffer)
+    NOTNULL(1, 2) WARN_UNUSED_RESULT;
+
+/// @brief Returns whether the submitted extraction has finished, so that
+/// finish_extraction() would not block.
+bool poll_extraction(const ExtractionRequest *request) NOTNULL(1);
+
+/// @brief Waits for the submitted extraction, returns its results in
+/// the layout of extract_sound_features() and destroys the request.
+FeatureExtractionResult finish_extraction(
+    ExtractionRequest *request, char ***featureNames, void ***results,
+    int **resultLengths) NOTNULL(1, 2, 3, 4);
+
+/// @brief Makes extract_sound_features_async() and submit_sound_features()
+/// wait up to latencyBudgetUs microseconds for the other requests with
+/// the same configuration and extract the features of up to maxBatchSize
+/// of them in a single run, as extract_sound_features_batch() does.
+/// The partial batches are padded with silence. Waits for the queued
+/// extractions. If maxBatchSize is 1 or less, batching is disabled.
+/// @return false if the configuration was not created by
+/// setup_features_extraction() or is split into chunks
+/// (see get_chunk_size()), or if some feature relates the adjacent windows
+/// (e.g., Delta, STMSN, Flux, Beat or Stats), which
+/// setup_features_extraction_batch() rejects; the requests are then
+/// extracted one by one.
+bool set_dynamic_batching(FeaturesConfiguration *fc, int maxBatchSize,
+                          int latencyBudgetUs) NOTNULL(1);
+
+/// @brief Reports how many requests the runs of set_dynamic_batching() have
+/// merged: counts[i] is set to the number of the runs of i + 1 requests.
+/// @return The maximal batch size, or 0 if batching is disabled.
+int get_batch_sizes_histogram(const FeaturesConfiguration *fc,
+                              size_t *counts, int size) NOTNULL(1);
+
+/// @brief Creates the configuration which takes int32_t samples. The
+/// features which process them skip the conversion from int16_t.
+FeaturesConfiguration *setup_features_extraction_int32(
+    const char *const *features, int featuresCount,
+    size_t bufferSize, int samplingRate) NOTNULL(1) WARN_UNUSED_RESULT MALLOC;
+
+/// @brief Creates the configuration which takes float samples, e.g.,
+/// decoded PCM, without quantizing them to int16_t. The float pipelines
+/// start without the conversion node.
+FeaturesConfiguration *setup_features_extraction_float(
+    const char *const *features, int featuresCount,
+    size_t bufferSize, int samplingRate) NOTNULL(1) WARN_UNUSED_RESULT MALLOC;
+
+/// @brief extract_sound_features() for setup_features_extraction_int32()
+/// configurations.
+FeatureExtractionResult extract_sound_features_int32(
+    const FeaturesConfiguration *fc, const int32_t *buffer,
+    char ***featureNames, void ***results, int **resultLengths)
+    NOTNULL(1, 2, 3, 4, 5);
+
+/// @brief extract_sound_features() for setup_features_extraction_float()
+/// configurations.
+FeatureExtractionResult extract_sound_features_float(
+    const FeaturesConfiguration *fc, const float *buffer,
+    char ***featureNames, void ***results, int **resultLengths)
+    NOTNULL(1, 2, 3, 4, 5);
+
+/// @brief Allocates and fills the names of the features sorted
+/// alphabetically and the sizes of their results in bytes. Release them with
+/// free_results(featuresCount, featureNames, NULL, resultLengths).
+void query_features_layout(const FeaturesConfiguration *fc,
+                           char ***featureNames, int **resultLengths,
+                           int *featuresCount) NOTNULL(1, 2, 3, 4);
+
+/// @brief Allocates and fills the numpy array interface type strings of
+/// the features' elements and their shapes, in the order of
+/// query_features_layout(). The shape of the i-th feature is
+/// (shapes[2 * i], shapes[2 * i + 1]): the number of the rows (buffers) and
+/// the number of the elements in each row, so that the results are parsed
+/// with numpy.frombuffer(result, dtypes[i]).reshape(shape).
+/// @details The formats of numbers and arrays of numbers map to
+/// the numeric type strings, e.g., "=f4", the others become the opaque
+/// records of "|V<size>" and one element per row. Release them with
+/// free_results(featuresCount, dtypes, NULL, shapes).
+void query_features_dtypes(const FeaturesConfiguration *fc, char ***dtypes,
+                           int **shapes, int *featuresCount)
+    NOTNULL(1, 2, 3, 4);
+
+/// @brief Extracts the features into the caller's memory without allocating
+/// the results. outputs[i] corresponds to the i-th feature reported by
+/// query_features_layout() and must hold at least resultLengths[i] bytes.
+FeatureExtractionResult extract_sound_features_into(
+    const FeaturesConfiguration *fc, int16_t *buffer, void *const *outputs)
+    NOTNULL(1, 2, 3);
+
+/// @brief Creates the chunked columnar file which
+/// extract_sound_features_to_store() appends the features to.
+/// @param chunkRows The number of the rows (buffers) of a feature which are
+/// encoded and written together.
+/// @return NULL if the file cannot be created.
+FeatureStore *open_feature_store(const char *fileName,
+                                 FeatureStoreCodecType codec, int chunkRows)
+    NOTNULL(1) WARN_UNUSED_RESULT MALLOC;
+
+/// @brief Extracts the features and appends them to the store. The chunks
+/// are encoded and written by a background thread, so that the extraction
+/// does not wait for the compression and the disk.
+FeatureExtractionResult extract_sound_features_to_store(
+    const FeaturesConfiguration *fc, int16_t *buffer, FeatureStore *store)
+    NOTNULL(1, 2, 3);
+
+/// @brief Writes the remaining chunks and the index and destroys the store.
+/// @return false if any write failed.
+bool close_feature_store(FeatureStore *store) NOTNULL(1);
+
+/// @brief Extracts the features into the Apache Arrow buffers and exports
+/// them through the Arrow C data interface, so that pyarrow, pandas or Spark
+/// take the memory without copying. schemas[i] and arrays[i] receive
+/// the i-th feature reported by query_features_layout(), named after it.
+/// @details Each buffer of a feature is a row. The arrays of numbers
+/// (e.g., "float *" or FixedArray) become the fixed-size lists of their
+/// elements, the single numbers become the primitive arrays and the other
+/// formats become the fixed-size binary arrays. The consumer calls
+/// the release callbacks, as usual for the C data interface.
+FeatureExtractionResult extract_sound_features_arrow(
+    const FeaturesConfiguration *fc, int16_t *buffer,
+    struct ArrowSchema *schemas, struct ArrowArray *arrays)
+    NOTNULL(1, 2, 3, 4);
+
+/// @brief Extracts the features without copying them anywhere. The views
+/// stay valid until the next extraction with the same configuration or
+/// until it is destroyed. Only the configurations which process the input
+/// in a single chunk (see get_chunk_size()) are supported.
+FeatureExtractionResult extract_sound_features_views(
+    FeaturesConfiguration *fc, int16_t *buffer, const FeatureView **views,
+    int *viewsCount) NOTNULL(1, 2, 3, 4);
+
+/// @brief Creates the configuration which extracts the features from
+/// clipsCount independent clips of clipSize samples at once.
+/// @return NULL if some transform relates the adjacent windows or reduces
+/// all of them (e.g., Delta, STMSN, Flux, Beat or Stats), since it would
+/// mix the successive clips.
+FeaturesConfiguration *setup_features_extraction_batch(
+    const char *const *features, int featuresCount,
+    size_t clipSize, int clipsCount, int samplingRate)
+    NOTNULL(1) WARN_UNUSED_RESULT MALLOC;
+
+/// @brief Creates the configuration which extracts the features from each
+/// of the channels of a multichannel recording in a single pass. The
+/// interleaved input is split into the channels inside the library, so it
+/// does not have to be copied beforehand.
+/// @param channelSize The number of samples in each channel.
+/// @note Feed the samples through extract_sound_features_batch(); the
+/// results are laid out as the ones of setup_features_extraction_batch()
+/// with clipsCount = channels, and the same features are rejected.
+FeaturesConfiguration *setup_features_extraction_multichannel(
+    const char *const *features, int featuresCount,
+    size_t channelSize, int channels, int samplingRate,
+    ChannelsLayoutType layout) NOTNULL(1) WARN_UNUSED_RESULT MALLOC;
+
+/// @brief Extracts the features from all the clips, which go one after
+/// another in memory. Each feature's result is a single contiguous block,
+/// with the part of the i-th clip being the i-th of clipsCount equal parts.
+FeatureExtractionResult extract_sound_features_batch(
+    const FeaturesConfiguration *fc, const int16_t *clips,
+    char ***featureNames, void ***results, int **resultLengths)
+    NOTNULL(1, 2, 3, 4, 5);
+
+/// @brief Creates the configuration which extracts the features from
+/// the clips of different lengths without padding them. Each clip is split
+/// into the overlapping blocks as in setup_features_extraction_blocks(),
+/// and the blocks of all the clips are executed blocksCount at a time,
+/// so the results of each clip are identical to the ones of the clip
+/// alone. The rest of each clip which does not fill a block is executed
+/// separately by the configuration of its size, which is cached.
+/// @return NULL if some feature depends on the whole input, e.g., through
+/// Stats or an IIR filter.
+/// @note Feed the clips through extract_sound_features_ragged().
+FeaturesConfiguration *setup_features_extraction_ragged(
+    const char *const *features, int featuresCount, size_t blockSize,
+    int blocksCount, int samplingRate) NOTNULL(1) WARN_UNUSED_RESULT MALLOC;
+
+/// @brief Extracts the features from each of the clips.
+/// @param clipSizes The number of samples in each clip.
+/// @param featuresCount Receives the number of features.
+/// @param results The result of j-th feature of i-th clip is at
+/// [i * featuresCount + j], the same for resultLengths. Free them with
+/// free_ragged_results().
+FeatureExtractionResult extract_sound_features_ragged(
+    const FeaturesConfiguration *fc, const int16_t *const *clips,
+    const size_t *clipSizes, int clipsCount, int *featuresCount,
+    char ***featureNames, void ***results, int **resultLengths)
+    NOTNULL(1, 2, 3, 5, 6, 7, 8);
+
+void free_ragged_results(int featuresCount, int clipsCount,
+                         char **featureNames, void **results,
+                         int *resultLengths);
+
+/// @brief Creates the configuration for the incremental extraction.
+/// @param blockSize The number of samples processed at once. The state of
+/// the transforms (filters, window tails, deltas) persists between blocks.
+FeaturesConfiguration *setup_features_stream(
+    const char *const *features, int featuresCount,
+    size_t blockSize, int samplingRate) NOTNULL(1) WARN_UNUSED_RESULT MALLOC;
+
+/// @brief Appends the samples to the stream and processes every complete
+/// block. The results are accumulated until pull_features() is called.
+FeatureExtractionResult push_samples(
+    FeaturesConfiguration *fc, const int16_t *samples, size_t count)
+    NOTNULL(1, 2);
+
+/// @brief Returns the results accumulated since the previous call, in the
+/// same layout as extract_sound_features(). Release them with free_results().
+FeatureExtractionResult pull_features(
+    FeaturesConfiguration *fc, char ***featureNames, void ***results,
+    int **resultLengths) NOTNULL(1, 2, 3, 4);
+
+/// @brief Extracts the features from the sliding window of a growing signal,
+/// reusing the results of the previous calls.
+/// @param samples The window, which starts at the absolute sample offset.
+/// @details Only the samples after the end of the previous window are
+/// processed; the state of the transforms (filters, window tails, deltas)
+/// carries over as in push_samples(). The results consist of the blocks
+/// which lie completely inside the window, the blocks being counted from
+/// the absolute sample 0. If the window jumps forward over unseen samples
+/// or goes back beyond the kept blocks, the stream is restarted at it.
+/// Release the results with free_results(). Do not mix with push_samples()
+/// on the same configuration.
+FeatureExtractionResult extract_sound_features_window(
+    FeaturesConfiguration *fc, const int16_t *samples, size_t count,
+    uint64_t offset, char ***featureNames, void ***results,
+    int **resultLengths) NOTNULL(1, 2, 5, 6, 7);
+
+/// @brief Drops the pending samples, the unpulled results and the state
+/// of the transforms, so that a new stream can be started.
+void reset_features_stream(FeaturesConfiguration *fc) NOTNULL(1);
+
+/// @brief Decodes the FLAC or Ogg Opus file and pushes its samples to
+/// the stream (see push_samples()) block by block. The decoding runs on
+/// a separate thread a few blocks ahead of the extraction, so the whole
+/// file takes about the maximum of the decoding and the extraction times
+/// rather than their sum. The channels are averaged; the sampling rate
+/// must match the configuration's (Opus is always decoded at 48000 Hz).
+/// The results are accumulated until pull_features() is called.
+/// @return FEATURE_EXTRACTION_RESULT_ERROR if the file cannot be decoded,
+/// e.g., the library was built without libFLAC or libopusfile.
+FeatureExtractionResult push_audio_file(FeaturesConfiguration *fc,
+                                        const char *fileName) NOTNULL(1, 2);
+
 void report_extraction_time(const FeaturesConfiguration *fc,
                             char ***transformNames,
                             float **values, int *length) NOTNULL(1, 2, 3, 4);
@@ -115,9 +810,146 @@ void report_extraction_time(const FeaturesConfiguration *fc,
 void destroy_extraction_time_report(char **transformNames,
                                     float *values, int length) NOTNULL(1, 2);
 
+/// @brief Starts writing the inputs of every every-th extraction of all
+/// the configurations to fileName, together with their features, so that
+/// sfe-replay can benchmark the real workload. The streaming and batch
+/// extractions are not recorded.
+/// @param maxRecords The limit of the records, 0 means no limit.
+/// @return false if the file cannot be created.
+bool start_traffic_recording(const char *fileName, int every,
+                             int maxRecords) NOTNULL(1);
+
+/// @brief Stops the recording of start_traffic_recording().
+/// @return The number of the written records, -1 if the file is broken.
+int stop_traffic_recording(void);
+
 void report_extraction_graph(const FeaturesConfiguration *fc,
                              const char *fileName) NOTNULL(1, 2);
 
+/// @brief Same as report_extraction_graph(), but additionally labels
+/// the nodes with the columns of explain_features_configuration().
+void report_extraction_graph_annotated(const FeaturesConfiguration *fc,
+                                       const char *fileName) NOTNULL(1, 2);
+
+/// @brief Describes the execution plan of the prepared configuration:
+/// a tab separated line per transform tree node in the execution order with
+/// its storage (own, packed, or aliasing the parent's buffers as a view or
+/// in place), the sizes of its buffers and private memory, the estimated
+/// cost, the serial or parallel placement, the threads, the SIMD
+/// instruction set, the sliced cycle, the transforms fused into it and
+/// its gate. The lines starting with "#" summarize the configuration.
+/// @return nullptr if fc is not prepared.
+/// @note Must be freed with destroy_features_configuration_explanation().
+char *explain_features_configuration(const FeaturesConfiguration *fc)
+    NOTNULL(1) WARN_UNUSED_RESULT MALLOC;
+
+void destroy_features_configuration_explanation(char *explanation);
+
+/// @brief Allocates and fills the hardware performance counters of each
+/// transform tree node in the last extraction, in the pre-order of the tree.
+/// The names are the same as in report_extraction_profile(). They are
+/// counted only if setup used
+/// PROFILING_LEVEL_FULL (see set_profiling_level()) and the perf events are
+/// permitted (/proc/sys/kernel/perf_event_paranoid), otherwise they are
+/// zeros. Only the thread which runs a node is counted, not the OpenMP
+/// threads the node spawns. report_extraction_graph() annotates the nodes
+/// with the same numbers.
+void report_extraction_counters(const FeaturesConfiguration *fc,
+                                char ***nodeNames,
+                                NodeHardwareCounters **counters,
+                                int *length) NOTNULL(1, 2, 3, 4);
+
+void destroy_extraction_counters(char **nodeNames,
+                                 NodeHardwareCounters *counters,
+                                 int length) NOTNULL(1, 2);
+
+/// @brief Allocates and fills the instruction set of the SIMD kernels which
+/// each transform tree node uses, in the same order and with the same names
+/// as report_extraction_counters(). The nodes without the runtime selected
+/// kernels report the instruction set they were compiled for.
+void report_extraction_instruction_sets(const FeaturesConfiguration *fc,
+                                        char ***nodeNames,
+                                        InstructionSetType **instructionSets,
+                                        int *length) NOTNULL(1, 2, 3, 4);
+
+void destroy_extraction_instruction_sets(char **nodeNames,
+                                         InstructionSetType *instructionSets,
+                                         int length) NOTNULL(1, 2);
+
+/// @brief Allocates and fills where each transform tree node currently
+/// runs, in the same order and with the same names as
+/// report_extraction_counters(). The placement is estimated from the sizes
+/// of the buffers, revised by the measured times and may be forced in
+/// the feature string, e.g. "RDFT(placement=serial)".
+void report_extraction_placements(const FeaturesConfiguration *fc,
+                                  char ***nodeNames,
+                                  NodePlacementType **placements,
+                                  int *length) NOTNULL(1, 2, 3, 4);
+
+void destroy_extraction_placements(char **nodeNames,
+                                   NodePlacementType *placements,
+                                   int length) NOTNULL(1, 2);
+
+/// @brief Fills how much memory the configuration needs and allocates
+/// the per node footprints, in the same order and with the same names as
+/// report_extraction_counters(). No extraction is required, so that
+/// the jobs can be admitted by a memory budget right after the setup.
+void report_extraction_memory(const FeaturesConfiguration *fc,
+                              ExtractionMemoryUsage *usage,
+                              char ***nodeNames, NodeMemoryUsage **nodes,
+                              int *length) NOTNULL(1, 2, 3, 4, 5);
+
+void destroy_extraction_memory(char **nodeNames, NodeMemoryUsage *nodes,
+                               int length) NOTNULL(1, 2);
+
+/// @brief Starts or stops collecting the statistics of each transform tree
+/// node in the subsequent extractions, including the concurrent ones.
+/// Enabling it drops the previously collected data. The configurations
+/// which share the same prepared tree share the profile as well.
+/// @note This must not be called during the extractions with fc.
+void set_extraction_profiling(const FeaturesConfiguration *fc,
+                              ExtractionProfilingMode mode) NOTNULL(1);
+
+/// @brief Allocates and fills the per node statistics in the execution
+/// order. The node names are the transform names followed by the features
+/// in brackets. The slices of the cache optimized chains are merged into
+/// their original nodes.
+void report_extraction_profile(const FeaturesConfiguration *fc,
+                               char ***nodeNames, NodeProfile **profiles,
+                               int *length) NOTNULL(1, 2, 3, 4);
+
+void destroy_extraction_profile(char **nodeNames, NodeProfile *profiles,
+                                int length) NOTNULL(1, 2);
+
+/// @brief Writes the trace events recorded with EXTRACTION_PROFILING_TRACE
+/// in the JSON format of chrome://tracing. Each node run is an event on its
+/// thread with the OpenMP thread number, the slice index and the processed
+/// bytes; the whole executions and the parallel slices are separate events.
+FeatureExtractionResult save_extraction_trace(
+    const FeaturesConfiguration *fc, const char *fileName) NOTNULL(1, 2);
+
+/// @brief Writes the prepared configuration to a binary file, so that
+/// the other processes can load it without preparing again. Only
+/// the configurations which process the input in a single chunk (see
+/// get_chunk_size()) are supported. The file is valid only for the same
+/// build of the library.
+FeatureExtractionResult save_features_configuration(
+    const FeaturesConfiguration *fc, const char *fileName) NOTNULL(1, 2);
+
+/// @brief Memory maps the file written by save_features_configuration()
+/// and restores the configuration from it.
+FeaturesConfiguration *load_features_configuration(const char *fileName)
+    NOTNULL(1) WARN_UNUSED_RESULT MALLOC;
+
+/// @brief Loads the plugin built by sfe-compile and restores the
+/// configuration compiled into it. If the plugin cannot be loaded, was
+/// compiled for other features, buffer size or sampling rate or for another
+/// build of the library, falls back to setup_features_extraction().
+FeaturesConfiguration *load_compiled_features_configuration(
+    const char *pluginFileName, const char *const *features,
+    int featuresCount, size_t bufferSize, int samplingRate)
+    NOTNULL(1, 2) WARN_UNUSED_RESULT MALLOC;
+
 void destroy_features_configuration(FeaturesConfiguration *fc) NOTNULL(1);
 
 void free_results(int featuresCount, char **featureNames,
@@ -125,12 +957,57 @@ void free_results(int featuresCount, char **featureNames,
 
 int get_omp_transforms_max_threads_num(void);
 
+/// @brief Sets the maximal number of the threads which execute
+/// the transforms, and restarts the library thread pool with this number
+/// of threads.
 void set_omp_transforms_max_threads_num(int value);
 
+/// @brief Returns whether the FFT plans prefer the GPU backends of FFTF.
+bool get_prefer_gpu_fft(void);
+
+/// @brief Makes the FFT plans (RDFT, DCT, the FFT based correlations)
+/// prefer the cuFFT and OpenCL backends of FFTF over the CPU ones. If FFTF
+/// finds neither, the CPU backends are used. Affects only the subsequent
+/// setup_features_extraction() calls.
+/// @note This is only the choice of the FFTF backend, not an offload of
+/// the tree: the buffers stay in the host memory and are copied to and from
+/// the device on each FFT, and all the other transforms run on the CPU.
+void set_prefer_gpu_fft(int value);
+
+bool get_fft_autotuning(void);
+
+/// @brief If value is true, the first FFT plan of each type, length and
+/// batch size benchmarks all the available FFTF backends and the fastest
+/// one is used for this shape since then. The decisions can be persisted
+/// with save_fft_wisdom().
+void set_fft_autotuning(int value);
+
+/// @brief Loads the fastest FFTF backends saved by save_fft_wisdom(),
+/// so that the known FFT shapes are not benchmarked again. The loaded
+/// decisions are used even if the autotuning is disabled.
+/// @return false if the file cannot be read or is malformed.
+bool load_fft_wisdom(const char *fileName) NOTNULL(1);
+
+/// @brief Saves the fastest FFTF backends measured or loaded so far.
+/// @return false if the file cannot be written.
+bool save_fft_wisdom(const char *fileName) NOTNULL(1);
+
 bool get_use_simd(void);
 
 void set_use_simd(int value);
 
+/// @brief Returns the widest instruction set which the CPU supports, as
+/// detected at startup, within the limits of get_use_simd() and
+/// get_max_instruction_set().
+InstructionSetType get_instruction_set(void);
+
+InstructionSetType get_max_instruction_set(void);
+
+/// @brief Forbids the SIMD kernels wider than value, e.g. to compare
+/// the results or the speed of the different kernels on the same machine.
+/// The default is INSTRUCTION_SET_AVX512, so nothing is forbidden.
+void set_max_instruction_set(InstructionSetType value);
+
 size_t get_cpu_cache_size(void);
 
 void set_cpu_cache_size(size_t value);
@@ -139,6 +1016,247 @@ size_t get_chunk_size(void);
 
 void set_chunk_size(size_t value);
 
+/// @brief The execution settings of a configuration, which replace
+/// the process-wide ones, so that e.g. a latency sensitive configuration
+/// and a throughput oriented one may use different threads numbers in
+/// the same process.
+typedef struct {
+  /// @brief 1 or 0 instead of get_use_simd(), negative to follow it.
+  int useSimd;
+  /// @brief Instead of get_omp_transforms_max_threads_num() if positive.
+  /// The threads of the library pool are shared, so it does not start
+  /// more of them.
+  int threadsNumber;
+  /// @brief Instead of get_cpu_cache_size() if not zero.
+  size_t cpuCacheSize;
+  /// @brief Instead of get_chunk_size() if not zero.
+  size_t chunkSize;
+} ExecutionSettings;
+
+/// @brief Makes the configurations which the calling thread sets up
+/// afterwards use settings instead of the process-wide values. They keep
+/// the settings for all their extractions, on any thread. NULL restores
+/// the process-wide values for the subsequent setups.
+void set_thread_execution_settings(const ExecutionSettings *settings);
+
+/// @brief Returns the effective execution settings of the configuration.
+void get_execution_settings(const FeaturesConfiguration *fc,
+                            ExecutionSettings *settings) NOTNULL(1, 2);
+
+/// @brief Stops the running extract_sound_features*() calls with
+/// the configuration, they return FEATURE_EXTRACTION_RESULT_CANCELLED
+/// without the results. The tree checks the cancellation between
+/// the transforms and between the chunks of their parallel loops, so
+/// the threads are released within milliseconds. The calls which start
+/// afterwards are not affected.
+void cancel_extractions(const FeaturesConfiguration *fc) NOTNULL(1);
+
+/// @brief Limits the duration of each extract_sound_features*() call with
+/// the configuration, the calls which exceed it are cancelled as if by
+/// cancel_extractions(). Zero (the default) means no limit.
+void set_extraction_timeout(FeaturesConfiguration *fc, int milliseconds)
+    NOTNULL(1);
+
+int get_extraction_timeout(const FeaturesConfiguration *fc) NOTNULL(1);
+
+/// @brief Indicates whether the threads governor is enabled.
+bool get_threads_governor(void);
+
+/// @brief Enables or disables the threads governor, which divides
+/// the library threads evenly among the concurrent extract_sound_features*()
+/// calls. Each call gives up its surplus threads as soon as more calls
+/// arrive and takes them back when they finish, instead of oversubscribing
+/// the CPUs. Disabled by default.
+void set_threads_governor(int value);
+
+/// @brief Returns the number of the extractions which the threads governor
+/// is dividing the threads among and the number of the threads of each.
+void get_threads_governor_state(int *executions, int *share) NOTNULL(1, 2);
+
+/// @brief Returns the memory limit of the cache of the prepared
+/// configurations, in bytes.
+/// @brief Returns the operational metrics of the library in the OpenMetrics
+/// text format: the extractions of each configuration by the result, their
+/// latencies and input bytes, the executions of the transform trees,
+/// the memory pool usage, the waits for the executor pools (e.g., the
+/// filters), the cache lookups and the dynamic batch sizes.
+/// The configurations are labeled with the hash of their features and
+/// format.
+/// @note Must be freed with destroy_metrics_snapshot().
+char *snapshot_metrics(void) WARN_UNUSED_RESULT MALLOC;
+
+void destroy_metrics_snapshot(char *snapshot);
+
+size_t get_configurations_cache_size(void);
+
+/// @brief Sets the memory limit of the cache of the prepared configurations,
+/// in bytes. setup_features_extraction() and
+/// setup_features_extraction_batch() with the same features and format
+/// share the prepared transform tree, so the subsequent setups are cheap.
+/// The least recently used trees are evicted when their buffers exceed
+/// the limit. Zero disables the cache.
+void set_configurations_cache_size(size_t value);
+
+size_t get_results_cache_size(void);
+
+/// @brief Sets the limit of the memory taken by the cached results, in bytes.
+/// If it is not zero, extract_sound_features() and its int32 and float
+/// variants remember the results by the contents of the input and
+/// the configuration, so that the repeated clips are not extracted again.
+/// The least recently used results are evicted first. Zero (the default)
+/// disables the cache.
+void set_results_cache_size(size_t value);
+
+int get_results_cache_ttl(void);
+
+/// @brief Sets how long the cached results are valid, in milliseconds.
+/// Zero (the default) means forever.
+void set_results_cache_ttl(int value);
+
+/// @brief Returns the number of the extractions which were served by
+/// the results cache and the number of the ones which were not.
+void get_results_cache_stats(size_t *hits, size_t *misses) NOTNULL(1, 2);
+
+/// @brief Drops all the cached results and zeroes the statistics.
+void reset_results_cache(void);
+
+size_t get_memory_pool_size(void);
+
+/// @brief Sets the limit of the idle memory kept for the extractions,
+/// in bytes. The buffers of a configuration are borrowed from the pool for
+/// the duration of extract_sound_features() and friends, so the memory
+/// scales with the number of the simultaneous extractions rather than with
+/// the number of the configurations. Zero disables the pool: each
+/// configuration keeps its own buffers.
+void set_memory_pool_size(size_t value);
+
+HugePagesMode get_huge_pages_mode(void);
+
+/// @brief Sets how the memory blocks of 2 MiB and more are backed, to reduce
+/// the TLB misses on long inputs. Applies to the blocks allocated afterwards.
+void set_huge_pages_mode(HugePagesMode value);
+
+bool get_numa_binding(void);
+
+/// @brief If value is true, the memory blocks are bound to the NUMA node of
+/// the thread which runs the extraction and are first touched by it.
+void set_numa_binding(int value);
+
+/// @brief Returns the maximal number of the extractions queued by
+/// extract_sound_features_async() and submit_sound_features() which have not
+/// finished yet.
+int get_max_pending_extractions(void);
+
+/// @brief Sets the bound of the asynchronous extractions queue, beyond which
+/// the new extractions are rejected.
+void set_max_pending_extractions(int value);
+
+/// @brief Copies at most size CPUs which the threads of the library pool
+/// are pinned to into cpus.
+/// @return The number of the CPUs, 0 if the threads are not pinned.
+int get_threads_affinity(int *cpus, int size);
+
+/// @brief Pins the threads of the library pool to the specified CPUs,
+/// round robin. The calling thread is not pinned. If count is 0,
+/// the pinning is removed.
+void set_threads_affinity(const int *cpus, int count);
+
+/// @brief Pins the threads of the library pool to the CPUs of the specified
+/// NUMA node, so that they work on the memory bound to it
+/// (see set_numa_binding()).
+/// @return false if the node does not exist.
+bool set_threads_numa_node(int node);
+
+/// @brief Returns whether the independent feature subtrees are executed
+/// concurrently.
+bool get_parallel_execution(void);
+
+/// @brief Enables or disables the concurrent execution of the independent
+/// feature subtrees. Affects only the subsequent setup_features_extraction()
+/// calls.
+void set_parallel_execution(bool value);
+
+AccuracyTier get_accuracy(void);
+
+/// @brief Sets the approximations which the transforms take instead of their
+/// default parameters. The parameters specified in the features take
+/// precedence. Affects only the subsequent setup_features_extraction() calls.
+void set_accuracy(AccuracyTier value);
+
+BuffersAllocatorType get_buffers_allocator(void);
+
+/// @brief Sets the allocator of the buffers of the transform trees. Has no
+/// effect on the parallel execution, which never reuses the buffers. Affects
+/// only the subsequent setup_features_extraction() calls.
+void set_buffers_allocator(BuffersAllocatorType value);
+
+/// @brief Returns whether the slice sizes of the cache optimized transform
+/// chains are chosen by timing.
+bool get_cache_autotuning(void);
+
+/// @brief If value is true, setup_features_extraction() times several slice
+/// sizes of each cache optimized transform chain (see get_cpu_cache_size())
+/// and keeps the fastest one. The numbers of slices are multiples of
+/// get_omp_transforms_max_threads_num(). Affects only the subsequent
+/// setup_features_extraction() calls.
+void set_cache_autotuning(int value);
+
+/// @brief Returns whether the slices of the cache optimized transform chains
+/// are executed concurrently.
+bool get_parallel_slices(void);
+
+/// @brief Enables or disables the concurrent execution of the slices of
+/// the cache optimized transform chains, one slice per pool thread (see
+/// get_omp_transforms_max_threads_num()). Affects only the subsequent
+/// setup_features_extraction() calls.
+void set_parallel_slices(int value);
+
+/// @brief Returns whether setup_features_extraction() warms up the trees.
+bool get_warm_up(void);
+
+/// @brief If value is true, setup_features_extraction() prefaults the buffers
+/// of the transform tree and executes it once on a synthetic input, so that
+/// the first extract_sound_features() runs as fast as the following ones.
+/// Affects only the subsequent setup_features_extraction() calls.
+void set_warm_up(int value);
+
+/// @brief Returns whether the tiny results are packed without the padding.
+bool get_packed_results(void);
+
+/// @brief If value is true, setup_features_extraction() packs the results
+/// which are smaller than the alignment, e.g. a float per frame, instead of
+/// padding each of them to 128 bytes. The extracted values are the same.
+/// Affects only the subsequent setup_features_extraction() calls.
+void set_packed_results(int value);
+
+/// @brief Returns whether the results of the constant inputs are reused.
+bool get_constant_input_shortcut(void);
+
+/// @brief If value is true, the trees recognize the inputs (chunks) in
+/// which all the samples are the same, e.g. the digital silence or DC, and
+/// copy the results of the first such extraction instead of running
+/// the transforms again. The extracted values are the same. The streaming
+/// configurations and the sinks always run the transforms. Affects only
+/// the subsequent setup_features_extraction() calls.
+void set_constant_input_shortcut(int value);
+
+/// @brief Returns how much the transform trees measure about each node.
+ProfilingLevelType get_profiling_level(void);
+
+/// @brief Sets how much the transform trees measure about each node.
+/// The default is PROFILING_LEVEL_COARSE. Affects only the subsequent
+/// setup_features_extraction() calls.
+void set_profiling_level(ProfilingLevelType value);
+
+/// @brief Returns whether the chunks of the input (see get_chunk_size())
+/// are executed concurrently.
+bool get_parallel_chunks(void);
+
+/// @brief Enables or disables the concurrent execution of the input chunks
+/// in extract_sound_features() and extract_sound_features_into(). Each
+/// concurrent chunk takes a separate set of buffers.
+void set_parallel_chunks(int value);
+
 #if __GNUC__ >= 4
 #pragma GCC visibility pop
 #endif
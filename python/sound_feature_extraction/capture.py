@@ -0,0 +1,89 @@
+"""
+Created on Oct 15, 2026
+
+@author: Markovtsev Vadim <v.markovtsev@samsung.com>
+
+███████████████████████████████████████████████████████████████████████████████
+
+Licensed to the Apache Software Foundation (ASF) under one
+or more contributor license agreements.  See the NOTICE file
+distributed with this work for additional information
+regarding copyright ownership.  The ASF licenses this file
+to you under the Apache License, Version 2.0 (the
+"License"); you may not use this file except in compliance
+with the License.  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the License is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied.  See the License for the
+specific language governing permissions and limitations
+under the License.
+
+███████████████████████████████████████████████████████████████████████████████
+"""
+
+import collections
+import numpy
+import struct
+from .formatters import Formatters
+
+
+CaptureRecord = collections.namedtuple(
+    "CaptureRecord", ["execution", "node", "slice", "transform", "format",
+                      "description", "buffers"])
+
+
+class CaptureReader(object):
+    """
+    Reads the files written by TransformTree::StartCapture(), see
+    src/buffer_capture.h for the layout.
+    """
+
+    MAGIC = b"SFECAPTR"
+
+    def __init__(self, file_name):
+        self.file_name = file_name
+
+    def __iter__(self):
+        """
+        Yields CaptureRecord-s; the buffers are the list of the parsed
+        buffers of the node.
+        """
+        with open(self.file_name, "rb") as fin:
+            if fin.read(len(CaptureReader.MAGIC)) != CaptureReader.MAGIC:
+                raise ValueError("%s is not a capture file" % self.file_name)
+            while True:
+                header = fin.read(16)
+                if not header:
+                    return
+                execution, node, slice_index = self._unpack(
+                    "=QIi", header)
+                transform = self._read_string(fin)
+                format_id = self._read_string(fin)
+                description = self._read_string(fin)
+                count, size = self._unpack("=QQ", fin.read(16))
+                data = self._read(fin, count * size)
+                buffers = [Formatters.parse(
+                    numpy.frombuffer(data, dtype=numpy.byte, count=size,
+                                     offset=i * size),
+                    format_id.replace(" *", "*")) for i in range(count)]
+                yield CaptureRecord(execution, node, slice_index, transform,
+                                    format_id, description, buffers)
+
+    def _read(self, fin, size):
+        data = fin.read(size)
+        if len(data) != size:
+            raise ValueError("%s is truncated" % self.file_name)
+        return data
+
+    def _unpack(self, fmt, data):
+        if len(data) != struct.calcsize(fmt):
+            raise ValueError("%s is truncated" % self.file_name)
+        return struct.unpack(fmt, data)
+
+    def _read_string(self, fin):
+        length, = self._unpack("=I", fin.read(4))
+        return self._read(fin, length).decode()
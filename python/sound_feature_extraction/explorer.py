@@ -27,76 +27,162 @@ under the License.
 
 
 import collections
+try:
+    from collections.abc import Mapping
+except ImportError:
+    from collections import Mapping
 import logging
+import os
+import pickle
+import tempfile
 from .library import Library
 from .transform import Transform, TransformParameter
 
 
+class TransformsMap(Mapping):
+    '''
+    Maps the names of the transforms to Transform-s, querying the details
+    of each one on the first access.
+    '''
+    logger = logging.getLogger("sfm.Explorer")
+
+    def __init__(self, names):
+        self._details = dict.fromkeys(names)
+
+    def __getitem__(self, key):
+        transform = self._details[key]
+        if transform is None:
+            transform = self._details[key] = self._query(key)
+        return transform
+
+    def __iter__(self):
+        return iter(self._details)
+
+    def __len__(self):
+        return len(self._details)
+
+    def _query(self, transform_name):
+        description = Library().new("char**")
+        input_format = Library().new("char**")
+        output_format = Library().new("char**")
+        p_names = Library().new("char***")
+        p_descs = Library().new("char***")
+        p_defs = Library().new("char***")
+        p_count = Library().new("int*")
+        self.logger.debug("query_transform_details(%s)", transform_name)
+        Library().query_transform_details(
+            transform_name.encode(), description, input_format,
+            output_format, p_names, p_descs, p_defs, p_count)
+        parameters = {}
+        for j in range(p_count[0]):
+            p_name = Library().string(p_names[0][j]).decode()
+            parameters[p_name] = TransformParameter(
+                p_name,
+                Library().string(p_descs[0][j]).decode(),
+                Library().string(p_defs[0][j]).decode())
+        transform = Transform(
+            transform_name,
+            Library().string(description[0]).decode(), parameters,
+            Library().string(input_format[0]).decode(),
+            Library().string(output_format[0]).decode())
+        Library().destroy_transform_details(
+            description[0], input_format[0], output_format[0],
+            p_names[0], p_descs[0], p_defs[0], p_count[0])
+        return transform
+
+
 class Explorer(object):
     '''
     Provides information about implemented transforms.
+    The instance is shared by the whole process. If cache_dir is set (by
+    default, from $SFE_EXPLORER_CACHE), the complete metadata is saved there
+    once per library build, so that the other processes do not even load
+    the library.
     '''
     logger = logging.getLogger("sfm.Explorer")
+    cache_dir = os.getenv("SFE_EXPLORER_CACHE")
 
     def __init__(self):
-        if not self.transforms:
-            names = Library().new("char***")
-            list_size = Library().new("int*")
-            self.logger.debug("query_transforms_list()")
-            Library().query_transforms_list(names, list_size)
-            self.logger.debug("Got the list of %d transforms", list_size[0])
-            self.transforms = {}
-            for i in range(list_size[0]):
-                description = Library().new("char**")
-                input_format = Library().new("char**")
-                output_format = Library().new("char**")
-                p_names = Library().new("char***")
-                p_descs = Library().new("char***")
-                p_defs = Library().new("char***")
-                p_count = Library().new("int*")
-                transform_name = Library().string(names[0][i]).decode()
-                self.logger.debug("query_transform_details(%s)",
-                                  transform_name)
-                Library().query_transform_details(
-                    names[0][i], description, input_format, output_format,
-                    p_names, p_descs, p_defs, p_count)
-                parameters = {}
-                for j in range(p_count[0]):
-                    p_name = Library().string(p_names[0][j]).decode()
-                    parameters[p_name] = TransformParameter(
-                        Library().string(p_names[0][j]).decode(),
-                        Library().string(p_descs[0][j]).decode(),
-                        Library().string(p_defs[0][j]).decode())
-                self.transforms[transform_name] = Transform(
-                    transform_name,
-                    Library().string(description[0]).decode(), parameters,
-                    Library().string(input_format[0]).decode(),
-                    Library().string(output_format[0]).decode())
-                Library().destroy_transform_details(
-                    description[0], input_format[0], output_format[0],
-                    p_names[0], p_descs[0], p_defs[0], p_count[0])
-            Library().destroy_transforms_list(names[0], list_size[0])
-            self.logger.debug("Done with getting transforms")
-            input_formats = Library().new("char***")
-            output_formats = Library().new("char***")
-            self.logger.debug("query_format_converters_list()")
-            Library().query_format_converters_list(
-                input_formats, output_formats, list_size)
-            self.logger.debug("Got the list of %d format converters",
-                              list_size[0])
-            self.format_converters = collections.defaultdict(list)
-            for i in range(list_size[0]):
-                self.format_converters[
-                    Library().string(input_formats[0][i]).decode()] \
-                    .append(Library().string(output_formats[0][i]).decode())
-            Library().destroy_format_converters_list(
-                input_formats[0], output_formats[0], list_size[0])
-            self.logger.debug("Done with getting format converters")
+        if self.transforms is not None:
+            return
+        cache_file = self._cache_file()
+        if cache_file is not None and os.path.exists(cache_file):
+            try:
+                with open(cache_file, "rb") as fin:
+                    transforms, converters = pickle.load(fin)
+                self.transforms = transforms
+                self._format_converters = converters
+                self.logger.debug("Loaded %d transforms from %s",
+                                  len(transforms), cache_file)
+                return
+            except Exception as e:
+                self.logger.warning("Failed to load %s: %s", cache_file, e)
+        names = Library().new("char***")
+        list_size = Library().new("int*")
+        self.logger.debug("query_transforms_list()")
+        Library().query_transforms_list(names, list_size)
+        self.logger.debug("Got the list of %d transforms", list_size[0])
+        self.transforms = TransformsMap(
+            Library().string(names[0][i]).decode()
+            for i in range(list_size[0]))
+        Library().destroy_transforms_list(names[0], list_size[0])
+        if cache_file is not None:
+            self._save(cache_file)
 
     def __new__(cls):
         if not cls._instance:
             cls._instance = super(Explorer, cls).__new__(cls)
         return cls._instance
 
+    @property
+    def format_converters(self):
+        if self._format_converters is None:
+            self._format_converters = self._query_format_converters()
+        return self._format_converters
+
+    def _query_format_converters(self):
+        input_formats = Library().new("char***")
+        output_formats = Library().new("char***")
+        list_size = Library().new("int*")
+        self.logger.debug("query_format_converters_list()")
+        Library().query_format_converters_list(
+            input_formats, output_formats, list_size)
+        self.logger.debug("Got the list of %d format converters",
+                          list_size[0])
+        format_converters = collections.defaultdict(list)
+        for i in range(list_size[0]):
+            format_converters[
+                Library().string(input_formats[0][i]).decode()] \
+                .append(Library().string(output_formats[0][i]).decode())
+        Library().destroy_format_converters_list(
+            input_formats[0], output_formats[0], list_size[0])
+        return format_converters
+
+    def _cache_file(self):
+        if not self.cache_dir:
+            return None
+        build_id = Library().build_id
+        if build_id is None:
+            return None
+        return os.path.join(self.cache_dir, "explorer-%s.pickle" % build_id)
+
+    def _save(self, cache_file):
+        transforms = dict(self.transforms.items())
+        try:
+            if not os.path.exists(self.cache_dir):
+                os.makedirs(self.cache_dir)
+            # Write to a temporary file first, so that the concurrent
+            # processes never read a partial cache
+            fd, path = tempfile.mkstemp(dir=self.cache_dir)
+            with os.fdopen(fd, "wb") as fout:
+                pickle.dump((transforms, self.format_converters), fout,
+                            pickle.HIGHEST_PROTOCOL)
+            os.rename(path, cache_file)
+            self.logger.debug("Saved %d transforms to %s", len(transforms),
+                              cache_file)
+        except (IOError, OSError) as e:
+            self.logger.warning("Failed to save %s: %s", cache_file, e)
+
     _instance = None
+    _format_converters = None
     transforms = None
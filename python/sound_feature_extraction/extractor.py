@@ -30,7 +30,6 @@ import logging
 import numpy
 from .library import Library
 from .formatters import Formatters
-from .explorer import Explorer
 
 
 class SetupFeaturesFailedException(Exception):
@@ -55,31 +54,75 @@ class Extractor(object):
 
     def __init__(self, features, buffer_size, sampling_rate, channels=1):
         self._config = None
+        self._batch_configs = {}
         self.features = features
         self.features_dict = {f.name: f for f in self.features}
         self.buffer_size = buffer_size
         self.sampling_rate = sampling_rate
         self.channels = channels
+        self._config = self._setup(Library().setup_features_extraction,
+                                   buffer_size, sampling_rate)
+        self._layout = self._query_layout(self._config)
+        self._dtypes = self._query_dtypes(self._config)
+
+    def _setup(self, function, *args):
+        """
+        Creates the native configuration of the features with function,
+        which takes the features descriptions followed by args.
+        """
         flen = len(self.features)
         fstrs = Library().new("char*[]", flen)
         # prevent from garbage collecting fstrs contents
         fstrs_ref = [None] * flen
         for i, f in enumerate(self.features):
             fstrs[i] = fstrs_ref[i] = Library().new("char[]", f.description(
-                {"sampling_rate": sampling_rate,
-                 "channels": channels}).encode())
-        self._config = Library().setup_features_extraction(
-            fstrs, len(self.features), buffer_size, sampling_rate)
+                {"sampling_rate": self.sampling_rate,
+                 "channels": self.channels}).encode())
+        config = function(fstrs, flen, *args)
         # fstrs_ref is still alive at this point
         del fstrs_ref
-        if self._config:
+        if config:
             self.logger.debug("Successfully set up %d features (config %s)",
-                              flen, self._config)
+                              flen, config)
         else:
             self.logger.error("Failed to set up features")
             raise SetupFeaturesFailedException()
+        return config
+
+    def _query_layout(self, config):
+        """
+        Returns the list of (feature name, result size in bytes) in the order
+        of extract_sound_features_into() outputs.
+        """
+        fnames = Library().new("char***")
+        rlengths = Library().new("int**")
+        count = Library().new("int*")
+        Library().query_features_layout(config, fnames, rlengths, count)
+        layout = [(Library().string(fnames[0][i]).decode(), rlengths[0][i])
+                  for i in range(count[0])]
+        Library().free_results(count[0], fnames[0], Library().NULL,
+                               rlengths[0])
+        return layout
+
+    def _query_dtypes(self, config):
+        """
+        Returns the mapping from the feature name to the numpy dtype of its
+        elements and the number of the elements in each row.
+        """
+        dtypes = Library().new("char***")
+        shapes = Library().new("int**")
+        count = Library().new("int*")
+        Library().query_features_dtypes(config, dtypes, shapes, count)
+        ret = {name: (numpy.dtype(Library().string(dtypes[0][i]).decode()),
+                      shapes[0][i * 2 + 1])
+               for i, (name, _) in enumerate(self._layout)}
+        Library().free_results(count[0], dtypes[0], Library().NULL,
+                               shapes[0])
+        return ret
 
     def __del__(self):
+        for config in self._batch_configs.values():
+            Library().destroy_features_configuration(config)
         if not self._config:
             return
         Library().destroy_features_configuration(self._config)
@@ -111,13 +154,8 @@ class Extractor(object):
             fname = Library().string(fnames[0][i]).decode()
             feature = self.features_dict[fname]
             self.logger.debug(feature.name + " yielded %d bytes", length)
-            buffer = Library().buffer(results[0][i], length)
-            format_name = feature.transforms[-1].output_format
-            if format_name == "":
-                format_name = Explorer().transforms[
-                    feature.transforms[-1].name].output_format
-            ret[fname] = Formatters.parse(numpy.frombuffer(
-                buffer, dtype=numpy.byte, count=length), format_name)
+            ret[fname] = Formatters.frombuffer(
+                Library().buffer(results[0][i], length), *self._dtypes[fname])
         ret[Extractor.RAW_KEY_NAME] = results[0]
         Library().free_results(len(self.features), fnames[0],
                                Library().NULL, rlengths[0])
@@ -136,19 +174,134 @@ class Extractor(object):
 
     def calculate(self, buffer):
         """
-        Default is to copy the data from calculate_raw().
+        Calculates the audio features directly into the numpy arrays, which
+        are returned. The library does not allocate or copy the results, and
+        cffi releases the GIL during the extraction, so several Python
+        threads may calculate with the same Extractor simultaneously.
+        """
+        if not self._config:
+            self.logger.error("Unable to calculate features")
+            return None
+        buffer = numpy.ascontiguousarray(buffer, dtype=numpy.int16)
+        arrays = [numpy.empty(length, dtype=numpy.byte)
+                  for _, length in self._layout]
+        outputs = Library().new("void*[]", [
+            Library().cast("void*", array.__array_interface__["data"][0])
+            for array in arrays])
+        status = Library().extract_sound_features_into(
+            self._config, Library().cast(
+                "int16_t*", buffer.__array_interface__["data"][0]), outputs)
+        self.logger.debug("extract_sound_features_into() returned status %d",
+                          status)
+        if status != 0:
+            raise ExtractionFailedException()
+        return {name: Formatters.frombuffer(array, *self._dtypes[name])
+                for (name, _), array in zip(self._layout, arrays)}
+
+    def _parse_stacked(self, fnames, results, rlengths, rows):
+        """
+        Copies the native results of extract_sound_features_batch() or
+        pull_features() into numpy arrays with the specified number of
+        rows and frees them.
+        """
+        flen = len(self.features)
+        ret = {}
+        for i in range(flen):
+            fname = Library().string(fnames[0][i]).decode()
+            length = rlengths[0][i]
+            dtype, _ = self._dtypes[fname]
+            array = numpy.frombuffer(
+                Library().buffer(results[0][i], length), dtype=dtype).copy()
+            ret[fname] = array.reshape(rows(fname), -1)
+        Library().free_results(flen, fnames[0], results[0], rlengths[0])
+        return ret
+
+    def calculate_batch(self, buffers):
+        """
+        Calculates the audio features of several buffers of buffer_size
+        samples in a single native call. buffers is a list of them or a 2D
+        array. Returns the arrays of each feature, whose i-th row is
+        the result of the i-th buffer. Raises SetupFeaturesFailedException
+        if some feature relates the adjacent windows, e.g., through Delta
+        or Stats, since the buffers would affect each other.
+        """
+        buffers = numpy.ascontiguousarray(buffers, dtype=numpy.int16)
+        if buffers.ndim != 2 or buffers.shape[1] != self.buffer_size:
+            raise ValueError("buffers must be of shape (count, %d)" %
+                             self.buffer_size)
+        count = buffers.shape[0]
+        config = self._batch_configs.get(count)
+        if config is None:
+            config = self._setup(Library().setup_features_extraction_batch,
+                                 self.buffer_size, count, self.sampling_rate)
+            self._batch_configs[count] = config
+        fnames = Library().new("char***")
+        results = Library().new("void***")
+        rlengths = Library().new("int**")
+        status = Library().extract_sound_features_batch(
+            config, Library().cast(
+                "int16_t*", buffers.__array_interface__["data"][0]),
+            fnames, results, rlengths)
+        if status != 0:
+            raise ExtractionFailedException()
+        return self._parse_stacked(fnames, results, rlengths,
+                                   lambda name: count)
+
+    def stream(self, chunks):
+        """
+        Generator which feeds the chunks of samples of arbitrary sizes to
+        the native streaming extraction and yields the results of every
+        buffer_size block which the chunk has completed. The arrays of each
+        feature have one row per block and may be empty. The transforms keep
+        their state between the chunks, the end of chunks ends the stream.
+        """
+        config = self._setup(Library().setup_features_stream,
+                             self.buffer_size, self.sampling_rate)
+        try:
+            block_lengths = dict(self._query_layout(config))
+            for chunk in chunks:
+                chunk = numpy.ascontiguousarray(chunk, dtype=numpy.int16)
+                if chunk.size == 0:
+                    continue
+                status = Library().push_samples(
+                    config, Library().cast(
+                        "int16_t*", chunk.__array_interface__["data"][0]),
+                    chunk.size)
+                if status != 0:
+                    raise ExtractionFailedException()
+                fnames = Library().new("char***")
+                results = Library().new("void***")
+                rlengths = Library().new("int**")
+                if Library().pull_features(config, fnames, results,
+                                           rlengths) != 0:
+                    raise ExtractionFailedException()
+                lengths = {Library().string(fnames[0][i]).decode():
+                           rlengths[0][i]
+                           for i in range(len(self.features))}
+                yield self._parse_stacked(
+                    fnames, results, rlengths,
+                    lambda name: lengths[name] // block_lengths[name])
+        finally:
+            Library().destroy_features_configuration(config)
+
+    def report(self, file_name, annotated=False):
+        """
+        Saves the extraction report graph. If annotated is True, the nodes
+        are additionally labeled with the columns of explain().
         """
-        results = self.calculate_raw(buffer)
-        for name in results:
-            if name != Extractor.RAW_KEY_NAME:
-                results[name] = numpy.copy(results[name])
-        self.free_results(results)
-        del(results[Extractor.RAW_KEY_NAME])
-        return results
+        report = Library().report_extraction_graph_annotated if annotated \
+            else Library().report_extraction_graph
+        report(self._config, Library().new("char[]", file_name))
 
-    def report(self, file_name):
+    def explain(self):
         """
-        Saves the extraction report graph.
+        Returns the execution plan of the transform tree as a tab separated
+        table, see explain_features_configuration().
         """
-        Library().report_extraction_graph(
-            self._config, Library().new("char[]", file_name))
+        explanation = Library().explain_features_configuration(self._config)
+        if explanation == Library().NULL:
+            raise ValueError("The configuration cannot be explained")
+        try:
+            return Library().string(explanation).decode()
+        finally:
+            Library().destroy_features_configuration_explanation(explanation)
@@ -41,6 +41,17 @@ class Formatters(object):
     def reinterpret_cast(array, type_name):
         return array.view(ctypes.__dict__["c_" + type_name])
 
+    @staticmethod
+    def frombuffer(buffer, dtype, width):
+        """
+        Interprets the native results as the array of rows of width elements
+        of dtype reported by query_features_dtypes(). Does not copy the data.
+        """
+        array = numpy.frombuffer(buffer, dtype=dtype)
+        if width == 1:
+            return array
+        return array.reshape(-1, width)
+
     @staticmethod
     def parse(array, format_name):
         if format_name.find("<") == -1:
@@ -27,6 +27,8 @@ under the License.
 
 
 import logging
+import os
+import struct
 import cffi
 
 
@@ -37,6 +39,7 @@ class Library(object):
 
     _lib = None
     _ffi = None
+    _build_id = None
     path = "libSoundFeatureExtraction.so"
 
     @property
@@ -50,11 +53,12 @@ class Library(object):
         if Library._ffi is None:
             Library._ffi = cffi.FFI()
             Library._ffi.cdef("""
-#define MAX_FEATURES_COUNT 256
+#define MAX_FEATURES_COUNT 65536
 
 typedef enum {
   FEATURE_EXTRACTION_RESULT_OK = 0,
-  FEATURE_EXTRACTION_RESULT_ERROR = 1
+  FEATURE_EXTRACTION_RESULT_ERROR = 1,
+  FEATURE_EXTRACTION_RESULT_CANCELLED = 2
 } FeatureExtractionResult;
 
 typedef struct FeaturesConfiguration FeaturesConfiguration;
@@ -92,6 +96,35 @@ FeatureExtractionResult extract_sound_features(
     const FeaturesConfiguration *fc, int16_t *buffer,
     char ***featureNames, void ***results, int **resultLengths);
 
+FeaturesConfiguration *setup_features_extraction_batch(
+    const char *const *features, int featuresCount,
+    size_t clipSize, int clipsCount, int samplingRate);
+
+FeatureExtractionResult extract_sound_features_batch(
+    const FeaturesConfiguration *fc, const int16_t *clips,
+    char ***featureNames, void ***results, int **resultLengths);
+
+FeaturesConfiguration *setup_features_stream(
+    const char *const *features, int featuresCount,
+    size_t blockSize, int samplingRate);
+
+FeatureExtractionResult push_samples(
+    FeaturesConfiguration *fc, const int16_t *samples, size_t count);
+
+FeatureExtractionResult pull_features(
+    FeaturesConfiguration *fc, char ***featureNames, void ***results,
+    int **resultLengths);
+
+void query_features_layout(const FeaturesConfiguration *fc,
+                           char ***featureNames, int **resultLengths,
+                           int *featuresCount);
+
+void query_features_dtypes(const FeaturesConfiguration *fc, char ***dtypes,
+                           int **shapes, int *featuresCount);
+
+FeatureExtractionResult extract_sound_features_into(
+    const FeaturesConfiguration *fc, int16_t *buffer, void *const *outputs);
+
 void report_extraction_time(const FeaturesConfiguration *fc,
                             char ***transformNames,
                             float **values, int *length);
@@ -102,6 +135,13 @@ void destroy_extraction_time_report(char **transformNames,
 void report_extraction_graph(const FeaturesConfiguration *fc,
                              const char *fileName);
 
+void report_extraction_graph_annotated(const FeaturesConfiguration *fc,
+                                       const char *fileName);
+
+char *explain_features_configuration(const FeaturesConfiguration *fc);
+
+void destroy_features_configuration_explanation(char *explanation);
+
 void destroy_features_configuration(FeaturesConfiguration *fc);
 
 void free_results(int featuresCount, char **featureNames,
@@ -124,6 +164,95 @@ size_t get_chunk_size(void);
 void set_chunk_size(size_t value);""")
         return Library._ffi
 
+    @property
+    def file_name(self):
+        """
+        The path to the shared library: found in $LD_LIBRARY_PATH if possible,
+        otherwise the library is loaded and looked up in the mappings.
+        """
+        if os.sep in self.path:
+            return self.path
+        for directory in os.getenv("LD_LIBRARY_PATH", "").split(os.pathsep):
+            candidate = os.path.join(directory, self.path)
+            if directory and os.path.exists(candidate):
+                return candidate
+        self.lib
+        try:
+            with open("/proc/self/maps") as fin:
+                for line in fin:
+                    mapped = line.split()[-1]
+                    if os.path.basename(mapped).startswith(self.path):
+                        return mapped
+        except IOError:
+            pass
+        return None
+
+    @property
+    def build_id(self):
+        """
+        The GNU build ID of the shared library, or its size and mtime if
+        it was linked without one.
+        """
+        if Library._build_id is None:
+            file_name = self.file_name
+            if file_name is None:
+                return None
+            try:
+                Library._build_id = Library._read_build_id(file_name)
+            except (IOError, struct.error, ValueError) as e:
+                logging.getLogger("sfm.Library").warning(
+                    "Failed to read the build ID of %s: %s", file_name, e)
+            if Library._build_id is None:
+                stat = os.stat(file_name)
+                Library._build_id = "%x-%x" % (stat.st_size,
+                                               int(stat.st_mtime))
+        return Library._build_id
+
+    @staticmethod
+    def _read_build_id(file_name):
+        """
+        Returns the hex NT_GNU_BUILD_ID note of the ELF file or None.
+        """
+        with open(file_name, "rb") as fin:
+            ident = fin.read(16)
+            if ident[:4] != b"\x7fELF":
+                raise ValueError("not an ELF file")
+            order = "<" if ident[5:6] == b"\x01" else ">"
+            if ident[4:5] == b"\x02":
+                fin.seek(0x28)
+                shoff, = struct.unpack(order + "Q", fin.read(8))
+                fin.seek(0x3A)
+                section_format = order + "IIQQQQIIQQ"
+            else:
+                fin.seek(0x20)
+                shoff, = struct.unpack(order + "I", fin.read(4))
+                fin.seek(0x2E)
+                section_format = order + "IIIIIIIIII"
+            shentsize, shnum = struct.unpack(order + "HH", fin.read(4))
+            for i in range(shnum):
+                fin.seek(shoff + i * shentsize)
+                section = struct.unpack(
+                    section_format,
+                    fin.read(struct.calcsize(section_format)))
+                # SHT_NOTE
+                if section[1] != 7:
+                    continue
+                fin.seek(section[4])
+                notes = fin.read(section[5])
+                pos = 0
+                while pos + 12 <= len(notes):
+                    namesz, descsz, note_type = struct.unpack(
+                        order + "III", notes[pos:pos + 12])
+                    pos += 12
+                    name = notes[pos:pos + namesz]
+                    pos += (namesz + 3) & ~3
+                    desc = notes[pos:pos + descsz]
+                    pos += (descsz + 3) & ~3
+                    # NT_GNU_BUILD_ID
+                    if note_type == 3 and name == b"GNU\x00":
+                        return "".join("%02x" % c for c in bytearray(desc))
+        return None
+
     def __getattr__(self, item):
         try:
             return getattr(self.lib, item)
@@ -0,0 +1,221 @@
+"""
+Created on Oct 15, 2026
+
+@author: Markovtsev Vadim <v.markovtsev@samsung.com>
+
+███████████████████████████████████████████████████████████████████████████████
+
+Licensed to the Apache Software Foundation (ASF) under one
+or more contributor license agreements.  See the NOTICE file
+distributed with this work for additional information
+regarding copyright ownership.  The ASF licenses this file
+to you under the Apache License, Version 2.0 (the
+"License"); you may not use this file except in compliance
+with the License.  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the License is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied.  See the License for the
+specific language governing permissions and limitations
+under the License.
+
+███████████████████████████████████████████████████████████████████████████████
+"""
+
+
+import collections
+import logging
+import mmap
+import multiprocessing
+import numpy
+import os
+from .extractor import ExtractionFailedException
+from .formatters import Formatters
+from .library import Library
+
+
+class ExtractorPool(object):
+    """
+    Extracts the features with a prepared Extractor in several processes
+    forked from the current one, so that the workers share the prepared
+    configuration by copy-on-write instead of setting it up again.
+    The inputs and the outputs are exchanged through the anonymous shared
+    memory, the queues carry only the slot indices, so neither the buffers
+    nor the results are pickled. The idle workers take the next slot from
+    the common queue, which balances the load.
+    Create the pool before starting the threads which extract the features,
+    since fork() copies only the calling thread.
+    """
+
+    logger = logging.getLogger("sfm.ExtractorPool")
+
+    ALIGNMENT = 64
+
+    def __init__(self, extractor, workers=None, slots=None, threads=1):
+        """
+        workers is the number of the processes, the number of CPUs by
+        default; slots is the number of the inputs in flight, twice
+        the number of the workers by default; threads is the number of
+        the library threads in each worker.
+        """
+        self._workers = []
+        self.extractor = extractor
+        self.workers_number = workers or os.cpu_count()
+        self.slots = slots or self.workers_number * 2
+        self._input_size = extractor.buffer_size * extractor.channels
+        self._offsets = []
+        size = 0
+        for _, length in extractor._layout:
+            self._offsets.append(size)
+            size += self._align(length)
+        self._output_size = size
+        input_bytes = self._align(self._input_size * 2)
+        # MAP_SHARED, so the children write into the memory of the parent
+        self._memory = mmap.mmap(
+            -1, self.slots * (input_bytes + self._output_size))
+        memory = numpy.frombuffer(self._memory, dtype=numpy.byte)
+        self._inputs = [
+            memory[i * input_bytes:(i + 1) * input_bytes].view(
+                numpy.int16)[:self._input_size] for i in range(self.slots)]
+        outputs_start = self.slots * input_bytes
+        self._outputs = [
+            memory[outputs_start + i * self._output_size:
+                   outputs_start + (i + 1) * self._output_size]
+            for i in range(self.slots)]
+        self._input_pointers = [
+            Library().cast("int16_t*", array.__array_interface__["data"][0])
+            for array in self._inputs]
+        self._output_pointers = [
+            Library().new("void*[]", [
+                Library().cast("void*", array.__array_interface__["data"][0] +
+                               offset) for offset in self._offsets])
+            for array in self._outputs]
+        self._free = list(range(self.slots))
+        context = multiprocessing.get_context("fork")
+        self._tasks = context.SimpleQueue()
+        self._done = context.SimpleQueue()
+        self._workers = [
+            context.Process(target=self._work, args=(threads,),
+                            name="ExtractorPool-%d" % i, daemon=True)
+            for i in range(self.workers_number)]
+        for worker in self._workers:
+            worker.start()
+        self.logger.debug("Started %d workers with %d slots",
+                          self.workers_number, self.slots)
+
+    def _align(self, size):
+        return (size + self.ALIGNMENT - 1) & ~(self.ALIGNMENT - 1)
+
+    def _work(self, threads):
+        """
+        The body of the worker process.
+        """
+        Library().set_omp_transforms_max_threads_num(threads)
+        config = self.extractor._config
+        while True:
+            slot = self._tasks.get()
+            if slot is None:
+                break
+            status = Library().extract_sound_features_into(
+                config, self._input_pointers[slot],
+                self._output_pointers[slot])
+            self._done.put((slot, status))
+
+    def _results(self, slot, copy):
+        ret = {}
+        for (name, length), offset in zip(self.extractor._layout,
+                                          self._offsets):
+            array = self._outputs[slot][offset:offset + length]
+            if copy:
+                array = array.copy()
+            ret[name] = Formatters.frombuffer(array,
+                                              *self.extractor._dtypes[name])
+        return ret
+
+    def map(self, buffers, copy=True):
+        """
+        Generator which extracts the features from each of the buffers of
+        buffer_size samples and yields the results in the same order, as
+        Extractor.calculate() does. If copy is False, the arrays point to
+        the shared memory and stay valid until the next result is requested.
+        """
+        buffers = iter(buffers)
+        submitted = collections.deque()
+        finished = {}
+        exhausted = False
+        current = None
+        try:
+            while True:
+                if current is not None:
+                    self._free.append(current)
+                    current = None
+                while not exhausted and self._free:
+                    try:
+                        buffer = next(buffers)
+                    except StopIteration:
+                        exhausted = True
+                        break
+                    buffer = numpy.ascontiguousarray(
+                        buffer, dtype=numpy.int16).ravel()
+                    if buffer.size != self._input_size:
+                        raise ValueError("the buffer must have %d samples" %
+                                         self._input_size)
+                    slot = self._free.pop()
+                    self._inputs[slot][:] = buffer
+                    self._tasks.put(slot)
+                    submitted.append(slot)
+                if not submitted:
+                    return
+                current = submitted.popleft()
+                self._wait(current, finished)
+                if finished.pop(current) != 0:
+                    raise ExtractionFailedException()
+                yield self._results(current, copy)
+        finally:
+            # The abandoned slots are reused only after the workers are done
+            if current is not None:
+                self._free.append(current)
+            for slot in submitted:
+                self._wait(slot, finished)
+                finished.pop(slot)
+                self._free.append(slot)
+
+    def _wait(self, slot, finished):
+        """
+        Receives the statuses of the finished slots into finished until
+        slot is among them.
+        """
+        while slot not in finished:
+            done, status = self._done.get()
+            finished[done] = status
+
+    def calculate(self, buffer):
+        """
+        Extracts the features from a single buffer in one of the workers.
+        """
+        return next(self.map([buffer]))
+
+    def close(self):
+        """
+        Stops the workers.
+        """
+        if not self._workers:
+            return
+        for _ in self._workers:
+            self._tasks.put(None)
+        for worker in self._workers:
+            worker.join()
+        self._workers = []
+        self.logger.debug("Stopped the workers")
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+    def __del__(self):
+        self.close()
@@ -27,6 +27,9 @@ under the License.
 
 
 import logging
+import os
+import shutil
+import tempfile
 import unittest
 from sound_feature_extraction.explorer import Explorer
 
@@ -42,6 +45,28 @@ class Test(unittest.TestCase):
             print(value.markdown_description)
 
 
+    def testCache(self):
+        cache_dir = tempfile.mkdtemp()
+        try:
+            Explorer._instance = None
+            Explorer.transforms = None
+            Explorer.cache_dir = cache_dir
+            transforms = dict(Explorer().transforms.items())
+            self.assertEqual(1, len(os.listdir(cache_dir)))
+            Explorer._instance = None
+            Explorer.transforms = None
+            cached = Explorer().transforms
+            self.assertEqual(sorted(transforms), sorted(cached))
+            for name, transform in transforms.items():
+                self.assertEqual(transform, cached[name])
+                self.assertEqual(sorted(transform.supported_parameters),
+                                 sorted(cached[name].supported_parameters))
+        finally:
+            Explorer._instance = None
+            Explorer.transforms = None
+            Explorer.cache_dir = None
+            shutil.rmtree(cache_dir)
+
 if __name__ == "__main__":
     # import sys;sys.argv = ['', 'Test.testExplorer']
     unittest.main()
@@ -28,9 +28,11 @@ under the License.
 
 import logging
 import numpy
+import threading
 import unittest
 from sound_feature_extraction.extractor import Extractor
 from sound_feature_extraction.feature import Feature
+from sound_feature_extraction.pool import ExtractorPool
 from sound_feature_extraction.transform import Transform
 
 
@@ -54,6 +56,79 @@ class Test(unittest.TestCase):
         results = extr.calculate(buffer)
         print("Calculated results: %s" % results["MFCC"])
 
+    def testThreads(self):
+        extr = Extractor([Feature("Energy", [
+            Transform("Window", length=512),
+            Transform("RDFT"),
+            Transform("SpectralEnergy")])],
+            buffer_size=48000, sampling_rate=16000)
+        buffer = (numpy.sin(numpy.arange(48000) / 4.0) * 10000).astype(
+            numpy.int16)
+        reference = extr.calculate(buffer)["Energy"]
+        results = [None] * 4
+
+        def calculate(index):
+            results[index] = extr.calculate(buffer)["Energy"]
+
+        threads = [threading.Thread(target=calculate, args=(i,))
+                   for i in range(len(results))]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+        for result in results:
+            self.assertTrue(numpy.array_equal(reference, result))
+
+    def energy_extractor(self):
+        return Extractor([Feature("Energy", [
+            Transform("Window", length=512),
+            Transform("RDFT"),
+            Transform("SpectralEnergy")])],
+            buffer_size=16000, sampling_rate=16000)
+
+    def testBatch(self):
+        extr = self.energy_extractor()
+        buffers = (numpy.sin(numpy.arange(16000 * 3).reshape(3, 16000) /
+                             numpy.array([[4.0], [5.0], [6.0]])) *
+                   10000).astype(numpy.int16)
+        results = extr.calculate_batch(buffers)["Energy"]
+        self.assertEqual(3, results.shape[0])
+        for i in range(3):
+            single = extr.calculate(buffers[i])["Energy"]
+            self.assertTrue(numpy.allclose(single.ravel(), results[i],
+                                           rtol=1e-4))
+
+    def testDtypes(self):
+        extr = self.energy_extractor()
+        buffer = (numpy.sin(numpy.arange(16000) / 4.0) * 10000).astype(
+            numpy.int16)
+        result = extr.calculate(buffer)["Energy"]
+        self.assertEqual(numpy.float32, result.dtype)
+        self.assertEqual(2, result.ndim)
+        self.assertEqual(dict(extr._layout)["Energy"], result.nbytes)
+
+    def testStream(self):
+        extr = self.energy_extractor()
+        signal = (numpy.sin(numpy.arange(16000 * 4) / 4.0) *
+                  10000).astype(numpy.int16)
+        chunks = numpy.array_split(signal, 7)
+        blocks = [res["Energy"] for res in extr.stream(chunks)]
+        self.assertEqual(7, len(blocks))
+        self.assertEqual(4, sum(block.shape[0] for block in blocks))
+    def testPool(self):
+        extr = self.energy_extractor()
+        buffers = [(numpy.sin(numpy.arange(16000) / (4.0 + i)) *
+                    10000).astype(numpy.int16) for i in range(10)]
+        with ExtractorPool(extr, workers=3, slots=4) as pool:
+            results = list(pool.map(buffers))
+            self.assertEqual(10, len(results))
+            for buffer, result in zip(buffers, results):
+                self.assertTrue(numpy.array_equal(
+                    extr.calculate(buffer)["Energy"], result["Energy"]))
+            # The abandoned map() returns its slots
+            next(pool.map(buffers, copy=False))
+            self.assertEqual(4, len(pool._free))
+
 if __name__ == "__main__":
     # import sys;sys.argv = ['', 'Test.testExtractor']
     unittest.main()
@@ -31,8 +31,10 @@
 #include "src/allocators/buffers_allocator.h"
 #include <fstream>  // NOLINT(*)
 #include <functional>
+#include <algorithm>
 #include <map>
 #include <set>
+#include <unordered_map>
 
 namespace sound_feature_extraction {
 namespace memory_allocation {
@@ -86,6 +88,22 @@ BuffersAllocator::BuffersAllocator()
     : Logger("Allocator", EINA_COLOR_LIGHTRED) {
 }
 
+size_t BuffersAllocator::LiveSetPeak(const Node& root) noexcept {
+  std::unordered_map<const Node*, size_t> pending;
+  size_t live = 0, peak = 0;
+  for (auto node = &root; node != nullptr; node = node->Next) {
+    live += node->Size;
+    peak = std::max(peak, live);
+    if (!node->Children.empty()) {
+      pending[node] = node->Children.size();
+    }
+    if (node->Parent != nullptr && --pending[node->Parent] == 0) {
+      live -= node->Parent->Size;
+    }
+  }
+  return peak;
+}
+
 bool BuffersAllocator::Validate(const Node& root) const {
   const Node* node = &root;
   std::vector<const Node*> leaves;
@@ -86,6 +86,12 @@ class BuffersAllocator : public Logger {
 
   bool Validate(const Node& root) const;
 
+  /// @brief Returns the maximal total size of the buffers which are alive
+  /// simultaneously in the order of Node::Next, that is, the lower bound
+  /// of any solution for this order. A buffer is alive from its node until
+  /// the last of its children, the leaves keep the results until the end.
+  static size_t LiveSetPeak(const Node& root) noexcept;
+
  protected:
   size_t NodesCount(const Node& root) const noexcept;
   static bool NodesOverlap(const Node& n1, const Node& n2) noexcept;
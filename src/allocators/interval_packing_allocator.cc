@@ -0,0 +1,178 @@
+/*! @file interval_packing_allocator.cc
+ *  @brief Lifetime-aware interval packing buffers allocator.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+#include "src/allocators/interval_packing_allocator.h"
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+
+namespace sound_feature_extraction {
+namespace memory_allocation {
+
+size_t IntervalPackingAllocator::Solve(Node* root) const noexcept {
+  ChildrenOrder children_order;
+  Measure(*root, &children_order);
+  std::vector<Lifetime> lifetimes;
+  Link(root, children_order, &lifetimes);
+  std::unordered_map<const Node*, size_t> order;
+  for (size_t i = 0; i < lifetimes.size(); i++) {
+    order[lifetimes[i].Item] = i;
+  }
+  for (auto& lifetime : lifetimes) {
+    auto node = lifetime.Item;
+    if (node->Children.empty()) {
+      lifetime.End = lifetimes.size();
+      continue;
+    }
+    // The last executed child is the last to read this node's buffers
+    lifetime.End = order[&node->Children[
+        children_order.find(node)->second.back()]];
+  }
+  std::vector<Lifetime*> sorted;
+  sorted.reserve(lifetimes.size());
+  for (auto& lifetime : lifetimes) {
+    if (lifetime.Item->Size > 0) {
+      sorted.push_back(&lifetime);
+    } else {
+      lifetime.Item->Address = 0;
+    }
+  }
+  std::stable_sort(sorted.begin(), sorted.end(),
+                   [](const Lifetime* a, const Lifetime* b) {
+    return a->Item->Size > b->Item->Size;
+  });
+  size_t result = 0;
+  std::vector<const Lifetime*> placed;
+  std::vector<const Lifetime*> conflicts;
+  for (auto lifetime : sorted) {
+    conflicts.clear();
+    for (auto other : placed) {
+      if (other->Begin <= lifetime->End && lifetime->Begin <= other->End) {
+        conflicts.push_back(other);
+      }
+    }
+    std::sort(conflicts.begin(), conflicts.end(),
+              [](const Lifetime* a, const Lifetime* b) {
+      return a->Item->Address < b->Item->Address;
+    });
+    size_t size = lifetime->Item->Size;
+    size_t best_address = Node::UNINITIALIZED_ADDRESS;
+    size_t best_gap = Node::UNINITIALIZED_ADDRESS;
+    size_t offset = 0;
+    for (auto other : conflicts) {
+      size_t address = other->Item->Address;
+      if (address >= offset + size && address - offset < best_gap) {
+        best_address = offset;
+        best_gap = address - offset;
+      }
+      offset = std::max(offset, address + other->Item->Size);
+    }
+    if (best_address == Node::UNINITIALIZED_ADDRESS) {
+      best_address = offset;
+    }
+    lifetime->Item->Address = best_address;
+    result = std::max(result, best_address + size);
+    placed.push_back(lifetime);
+  }
+  DBG("Packed %zu buffers into %zu bytes", sorted.size(), result);
+  return result;
+}
+
+IntervalPackingAllocator::Footprint IntervalPackingAllocator::Measure(
+    const Node& node, ChildrenOrder* order) noexcept {
+  if (node.Children.empty()) {
+    return { node.Size, node.Size };
+  }
+  std::vector<Footprint> footprints;
+  footprints.reserve(node.Children.size());
+  for (auto& child : node.Children) {
+    footprints.push_back(Measure(child, order));
+  }
+  // The node's buffers are freed as soon as the last child is executed, so
+  // try each child as the last one. The others go in the classic order which
+  // minimizes max(retained before + peak).
+  std::vector<size_t> sorted(node.Children.size());
+  for (size_t i = 0; i < sorted.size(); i++) {
+    sorted[i] = i;
+  }
+  std::stable_sort(sorted.begin(), sorted.end(), [&](size_t a, size_t b) {
+    return footprints[a].Peak - footprints[a].Retained >
+        footprints[b].Peak - footprints[b].Retained;
+  });
+  Footprint best { std::numeric_limits<size_t>::max(), 0 };  // NOLINT(*)
+  size_t best_last = 0;
+  for (size_t last = 0; last < sorted.size(); last++) {
+    Footprint result { 0, 0 };  // NOLINT(whitespace/braces)
+    for (auto i : sorted) {
+      if (i == sorted[last]) {
+        continue;
+      }
+      result.Peak = std::max(result.Peak,
+                             node.Size + result.Retained + footprints[i].Peak);
+      result.Retained += footprints[i].Retained;
+    }
+    auto& footprint = footprints[sorted[last]];
+    result.Peak = std::max(result.Peak, std::max(
+        node.Size + result.Retained + node.Children[sorted[last]].Size,
+        result.Retained + footprint.Peak));
+    result.Retained += footprint.Retained;
+    if (result.Peak < best.Peak) {
+      best = result;
+      best_last = last;
+    }
+  }
+  auto& indices = (*order)[&node];
+  for (size_t i = 0; i < sorted.size(); i++) {
+    if (i != best_last) {
+      indices.push_back(sorted[i]);
+    }
+  }
+  indices.push_back(sorted[best_last]);
+  return best;
+}
+
+Node* IntervalPackingAllocator::Link(
+    Node* node, const ChildrenOrder& order,
+    std::vector<Lifetime>* lifetimes) noexcept {
+  node->Next = nullptr;
+  lifetimes->push_back({ node, lifetimes->size(), 0 });
+  if (node->Children.empty()) {
+    return node;
+  }
+  Node* last = node;
+  for (auto i : order.find(node)->second) {
+    last->Next = &node->Children[i];
+    last = Link(&node->Children[i], order, lifetimes);
+  }
+  return last;
+}
+
+}  // namespace memory_allocation
+}  // namespace sound_feature_extraction
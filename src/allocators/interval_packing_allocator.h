@@ -0,0 +1,80 @@
+/*! @file interval_packing_allocator.h
+ *  @brief Lifetime-aware interval packing buffers allocator.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+#ifndef SRC_ALLOCATORS_INTERVAL_PACKING_ALLOCATOR_H_
+#define SRC_ALLOCATORS_INTERVAL_PACKING_ALLOCATOR_H_
+
+#include <unordered_map>
+#include <vector>
+#include "src/allocators/buffers_allocator.h"
+
+namespace sound_feature_extraction {
+namespace memory_allocation {
+
+/// @brief Places the buffers knowing exactly when each of them is alive.
+/// @details The nodes are executed depth first, the children of each node
+/// ordered so that the subtrees which need the most memory at their peak
+/// besides the leaves go first. The buffers of a node live from its
+/// execution till the execution of its last child, the leaves live till
+/// the end. The buffers are placed in the order of decreasing size, each
+/// into the smallest gap which fits it between the already placed buffers
+/// with intersecting lifetimes (greedy best fit by size).
+class IntervalPackingAllocator : public BuffersAllocator {
+ public:
+  virtual size_t Solve(Node* root) const noexcept override;
+
+ private:
+  struct Lifetime {
+    Node* Item;
+    size_t Begin;
+    size_t End;
+  };
+
+  struct Footprint {
+    /// @brief The estimated peak memory of the subtree.
+    size_t Peak;
+    /// @brief The size of the leaves of the subtree.
+    size_t Retained;
+  };
+
+  typedef std::unordered_map<const Node*, std::vector<size_t>> ChildrenOrder;
+
+  /// @brief Chooses the execution order of the children in the subtree.
+  static Footprint Measure(const Node& node, ChildrenOrder* order) noexcept;
+  /// @brief Links the subtree in the depth first order and appends
+  /// the nodes without their lifetimes' ends to lifetimes.
+  /// @return The last node of the subtree in the execution order.
+  static Node* Link(Node* node, const ChildrenOrder& order,
+                    std::vector<Lifetime>* lifetimes) noexcept;
+};
+
+}  // namespace memory_allocation
+}  // namespace sound_feature_extraction
+#endif  // SRC_ALLOCATORS_INTERVAL_PACKING_ALLOCATOR_H_
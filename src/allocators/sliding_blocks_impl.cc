@@ -31,8 +31,10 @@
 #include "src/allocators/sliding_blocks_impl.h"
 #include <cassert>
 #include <algorithm>
+#include <limits>
 #include <map>
-#include "src/safe_omp.h"
+#include <mutex>
+#include "src/thread_pool.h"
 
 extern "C" {
   /// @brief Gets the maximal number of threads setting from API.
@@ -51,32 +53,36 @@ size_t SlidingBlocksImpl::Solve(Node* root) noexcept {
     DBG("Simplifying the tree...");
     SimplifyTreeRecursive(treeRoot, root);
     EliminateLeafBranchesRecursive(treeRoot);
+    std::map<std::vector<size_t>, int> shapes;
+    AssignShapesRecursive(treeRoot, &shapes);
     DBG("Generating traversal variants...");
     GenerateTreeTraversalVariants(treeRoot, &traversalVariants);
     DBG("Solving %zu traversal variants...", traversalVariants.size());
   }
   size_t min_height = 0;
   std::vector<Block> solution;
-#ifdef HAVE_OPENMP
-  #pragma omp parallel for num_threads(get_omp_transforms_max_threads_num())
-#endif
-  for (size_t i = 0; i <
+  std::mutex solution_mutex;
 #ifndef DEBUG
-          traversalVariants.size();
+  size_t variants = traversalVariants.size();
 #else
-          std::min(traversalVariants.size(), static_cast<size_t>(50000));
+  size_t variants = std::min(traversalVariants.size(),
+                             static_cast<size_t>(50000));
 #endif
-      i++) {
-    auto blocks_set = GetProblemForTraversalVariant(traversalVariants[i]);
-    std::vector<Block> blocks(blocks_set.begin(), blocks_set.end());
-    GreedySolve(&blocks, &blocks_set);
-    size_t height = CalculateBlocksSolutionPeakHeight(blocks);
-    #pragma omp critical
-    if (height < min_height || min_height == 0) {
-      min_height = height;
-      solution = blocks;
+  ThreadPool::Instance().ParallelFor(
+      variants, 1, get_omp_transforms_max_threads_num(),
+      [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      auto blocks_set = GetProblemForTraversalVariant(traversalVariants[i]);
+      std::vector<Block> blocks(blocks_set.begin(), blocks_set.end());
+      GreedySolve(&blocks, &blocks_set);
+      size_t height = CalculateBlocksSolutionPeakHeight(blocks);
+      std::lock_guard<std::mutex> lock(solution_mutex);
+      if (height < min_height || min_height == 0) {
+        min_height = height;
+        solution = blocks;
+      }
     }
-  }
+  });
   SaveBlocksSolution(solution);
   return min_height;
 }
@@ -115,8 +121,28 @@ void SlidingBlocksImpl::EliminateLeafBranchesRecursive(
   }
 }
 
-constexpr int factorial(int n) {
-  return (n == 1 || n == 0) ? 1 : factorial(n - 1) * n;
+void SlidingBlocksImpl::AssignShapesRecursive(
+    const std::shared_ptr<TraversalTreeNode>& treeNode,
+    std::map<std::vector<size_t>, int>* shapes) noexcept {
+  std::vector<size_t> description;
+  description.reserve(treeNode->Chain.size() * 2 + treeNode->Children.size());
+  for (auto node : treeNode->Chain) {
+    description.push_back(node->Size);
+    description.push_back(node->Children.size());
+  }
+  for (auto& child : treeNode->Children) {
+    AssignShapesRecursive(child, shapes);
+  }
+  std::stable_sort(treeNode->Children.begin(), treeNode->Children.end(),
+                   [](const std::shared_ptr<TraversalTreeNode>& a,
+                      const std::shared_ptr<TraversalTreeNode>& b) {
+    return a->Shape < b->Shape;
+  });
+  for (auto& child : treeNode->Children) {
+    description.push_back(child->Shape);
+  }
+  treeNode->Shape = shapes->insert(std::make_pair(
+      std::move(description), shapes->size())).first->second;
 }
 
 void SlidingBlocksImpl::GenerateTreeTraversalVariants(
@@ -129,42 +155,66 @@ void SlidingBlocksImpl::GenerateTreeTraversalVariants(
   assert(node->Children.size() > 1 && "The tree was not simplified");
   std::vector<std::vector<std::vector<Node*>>> innerVariants(
       node->Children.size());
-  size_t innerVariantsCount = 1;
+  // The children are sorted by their shapes, see AssignShapesRecursive()
+  std::vector<int> shapes(node->Children.size());
   size_t innerVariantSize = 0;
   for (size_t i = 0; i < node->Children.size(); i++) {
     GenerateTreeTraversalVariants(node->Children[i], &innerVariants[i]);
-    innerVariantsCount *= innerVariants[i].size();
+    shapes[i] = node->Children[i]->Shape;
     innerVariantSize += innerVariants[i][0].size();
   }
-  variants->reserve(factorial(node->Children.size()) * innerVariantsCount);
-  std::vector<int> permutation(node->Children.size());
-  for (int i = 0; i < static_cast<int>(permutation.size()); i++) {
-    permutation[i] = i;
+  std::map<int, size_t> firstChild;
+  for (size_t i = node->Children.size(); i > 0; i--) {
+    firstChild[shapes[i - 1]] = i - 1;
   }
+  std::vector<int> shapesOrder(shapes);
+  std::vector<int> permutation(node->Children.size());
+  std::map<int, int> shapeVariants;
   std::vector<Node*> tmpVariant;
   tmpVariant.reserve(node->Chain.size() + innerVariantSize);
   tmpVariant.insert(tmpVariant.end(), node->Chain.begin(), node->Chain.end());
   do {
-    AddTraversalVariantsRecursive(tmpVariant, 0, permutation, innerVariants,
-                                  variants);
-  } while (std::next_permutation(permutation.begin(), permutation.end()));
+    // The identical children follow in their original order
+    auto nextChild = firstChild;
+    for (size_t i = 0; i < shapesOrder.size(); i++) {
+      permutation[i] = nextChild[shapesOrder[i]]++;
+    }
+    AddTraversalVariantsRecursive(tmpVariant, 0, permutation, shapes,
+                                  innerVariants, &shapeVariants, variants);
+  } while (std::next_permutation(shapesOrder.begin(), shapesOrder.end()));
 }
 
 void SlidingBlocksImpl::AddTraversalVariantsRecursive(
       std::vector<Node*> current, size_t index,
       const std::vector<int>& permutation,
+      const std::vector<int>& shapes,
       const std::vector<std::vector<std::vector<Node*>>>& inner,
+      std::map<int, int>* shapeVariants,
       std::vector<std::vector<Node*>>* variants) noexcept {
-  for (auto variant : inner[permutation[index]]) {
+  int child = permutation[index];
+  auto chosen = shapeVariants->find(shapes[child]);
+  size_t begin = 0, end = inner[child].size();
+  if (chosen != shapeVariants->end()) {
+    begin = chosen->second;
+    end = begin + 1;
+  }
+  for (size_t v = begin; v < end; v++) {
+    auto& variant = inner[child][v];
+    if (chosen == shapeVariants->end()) {
+      (*shapeVariants)[shapes[child]] = v;
+    }
     current.insert(current.end(), variant.begin(), variant.end());
     if (index == permutation.size() - 1) {
       variants->push_back(current);
     } else {
-      AddTraversalVariantsRecursive(current, index + 1, permutation, inner,
-                                    variants);
+      AddTraversalVariantsRecursive(current, index + 1, permutation, shapes,
+                                    inner, shapeVariants, variants);
     }
     current.resize(current.size() - variant.size());
   }
+  if (chosen == shapeVariants->end()) {
+    shapeVariants->erase(shapes[child]);
+  }
 }
 
 std::set<Block> SlidingBlocksImpl::GetProblemForTraversalVariant(
@@ -203,28 +253,86 @@ std::set<Block> SlidingBlocksImpl::GetProblemForTraversalVariant(
   return blocks;
 }
 
+/// @brief The heights of the placed blocks along X, an interval tree with
+/// the logarithmic range maximum queries and range assignments.
+class Relief {
+ public:
+  explicit Relief(size_t size)
+      : size_(size), max_(size * 4, 0), assigned_(size * 4, kNone) {
+  }
+
+  size_t Max(size_t begin, size_t end) noexcept {
+    return Max(1, 0, size_, begin, end);
+  }
+
+  void Assign(size_t begin, size_t end, size_t value) noexcept {
+    Assign(1, 0, size_, begin, end, value);
+  }
+
+ private:
+  static constexpr size_t kNone = std::numeric_limits<size_t>::max();
+
+  void Push(size_t index) noexcept {
+    if (assigned_[index] == kNone) {
+      return;
+    }
+    for (size_t child : { index * 2, index * 2 + 1 }) {
+      max_[child] = assigned_[child] = assigned_[index];
+    }
+    assigned_[index] = kNone;
+  }
+
+  size_t Max(size_t index, size_t left, size_t right, size_t begin,
+             size_t end) noexcept {
+    if (end <= left || right <= begin) {
+      return 0;
+    }
+    if (begin <= left && right <= end) {
+      return max_[index];
+    }
+    Push(index);
+    size_t middle = (left + right) / 2;
+    return std::max(Max(index * 2, left, middle, begin, end),
+                    Max(index * 2 + 1, middle, right, begin, end));
+  }
+
+  void Assign(size_t index, size_t left, size_t right, size_t begin,
+              size_t end, size_t value) noexcept {
+    if (end <= left || right <= begin) {
+      return;
+    }
+    if (begin <= left && right <= end) {
+      max_[index] = assigned_[index] = value;
+      return;
+    }
+    Push(index);
+    size_t middle = (left + right) / 2;
+    Assign(index * 2, left, middle, begin, end, value);
+    Assign(index * 2 + 1, middle, right, begin, end, value);
+    max_[index] = std::max(max_[index * 2], max_[index * 2 + 1]);
+  }
+
+  size_t size_;
+  std::vector<size_t> max_;
+  std::vector<size_t> assigned_;
+};
+
+constexpr size_t Relief::kNone;
+
 void SlidingBlocksImpl::GreedySolve(
     std::vector<Block>* blocks,
     std::set<Block>* blocksSet) noexcept {
   std::set<Block>* blocks_left = (blocksSet != nullptr)?
       blocksSet : new std::set<Block>(blocks->begin(), blocks->end());
-  std::vector<size_t> relief(blocks->size());
-  for (size_t i = 0; i < blocks->size(); i++) {
-    relief[i] = 0;
-  }
+  Relief relief(blocks->size());
   while (!blocks_left->empty()) {
     size_t current_x = blocks_left->begin()->X;
     while (current_x < blocks->size()) {
       auto &block = (*blocks)[current_x];
-      size_t max_y = relief[current_x];
       blocks_left->erase(block);
-      for (size_t i = current_x; i < current_x + block.Width; i++) {
-        max_y = std::max(max_y, relief[i]);
-      }
+      size_t max_y = relief.Max(current_x, current_x + block.Width);
       block.Y = max_y;
-      for (size_t i = current_x; i < current_x + block.Width; i++) {
-        relief[i] = max_y + block.Height;
-      }
+      relief.Assign(current_x, current_x + block.Width, max_y + block.Height);
       current_x += block.Width;
     }
   }
@@ -31,6 +31,7 @@
 #ifndef SRC_ALLOCATORS_SLIDING_BLOCKS_IMPL_H_
 #define SRC_ALLOCATORS_SLIDING_BLOCKS_IMPL_H_
 
+#include <map>
 #include <memory>
 #include <set>
 #include <vector>
@@ -42,12 +43,15 @@ namespace memory_allocation {
 
 struct TraversalTreeNode {
   explicit TraversalTreeNode(std::weak_ptr<TraversalTreeNode> parent)
-      : Parent(parent) {
+      : Parent(parent), Shape(0) {
   }
 
   std::vector<Node*> Chain;
   std::vector<std::shared_ptr<TraversalTreeNode>> Children;
   std::weak_ptr<TraversalTreeNode> Parent;
+  /// @brief The identifier of the structure and the sizes of the subtree,
+  /// the same for the clones of a sliced cycle.
+  int Shape;
 };
 
 struct Block {
@@ -110,13 +114,28 @@ class SlidingBlocksImpl : public Logger {
       std::shared_ptr<TraversalTreeNode> treeNode, Node* node) noexcept;
   static void EliminateLeafBranchesRecursive(
       std::shared_ptr<TraversalTreeNode> treeNode) noexcept;
+  /// @brief Sets TraversalTreeNode::Shape and sorts the children by it, so
+  /// that the identical subtrees are adjacent and their traversal variants
+  /// correspond to each other by index.
+  static void AssignShapesRecursive(
+      const std::shared_ptr<TraversalTreeNode>& treeNode,
+      std::map<std::vector<size_t>, int>* shapes) noexcept;
+  /// @brief Generates the traversal variants which differ in the order of
+  /// the children. The identical children are interchangeable, so only
+  /// the distinct orders of their shapes are taken, and they all follow
+  /// the same inner variant: a single clone is solved and the rest are
+  /// tiled after it.
   static void GenerateTreeTraversalVariants(
       const std::shared_ptr<TraversalTreeNode>& node,
       std::vector<std::vector<Node*>>* variants) noexcept;
+  /// @param shapeVariants The inner variant chosen for each shape of
+  /// the children, or -1.
   static void AddTraversalVariantsRecursive(
       std::vector<Node*> current, size_t index,
       const std::vector<int>& permutation,
+      const std::vector<int>& shapes,
       const std::vector<std::vector<std::vector<Node*>>>& inner,
+      std::map<int, int>* shapeVariants,
       std::vector<std::vector<Node*>>* variants) noexcept;
   static std::set<Block> GetProblemForTraversalVariant(
       const std::vector<Node*>& variant) noexcept;
@@ -30,14 +30,41 @@
 
 #define SOUNDFEATUREEXTRACTION_API_IMPLEMENTATION
 #include <sound_feature_extraction/api.h>
+#include <dlfcn.h>
 #undef NOTNULL
+#include <atomic>
+#include <algorithm>
 #include <cassert>
+#include <cctype>
+#include <cstring>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <map>
+#include <mutex>
 #include <stddef.h>
+#include <thread>
 #include <fftf/api.h>
+#include <simd/memory.h>
+#include "src/audio_decoder.h"
+#include "src/cancellation.h"
+#include "src/feature_store.h"
 #include "src/features_parser.h"
+#include "src/fftf_wisdom.h"
+#include "src/formats/float_to_float16.h"
+#include "src/formats/float_to_int16.h"
+#include "src/formats/float_to_int32.h"
 #include "src/make_unique.h"
+#include "src/memory_pool.h"
+#include "src/metrics.h"
+#include "src/profiler.h"
 #include "src/safe_omp.h"
+#include "src/scratch_arena.h"
 #include "src/simd_aware.h"
+#include "src/thread_pool.h"
+#include "src/traffic_recorder.h"
+#include "src/threads_governor.h"
 #include "src/transform_tree.h"
 #include "src/transform_registry.h"
 
@@ -50,22 +77,606 @@ using sound_feature_extraction::IncompatibleTransformFormatException;
 using sound_feature_extraction::RawFeaturesMap;
 using sound_feature_extraction::features::ParseFeaturesException;
 using sound_feature_extraction::TransformTree;
+using sound_feature_extraction::Accuracy;
+using sound_feature_extraction::AllocationStrategy;
+using sound_feature_extraction::ChannelsLayout;
+using sound_feature_extraction::SampleType;
 using sound_feature_extraction::formats::ArrayFormat16;
+using sound_feature_extraction::formats::ArrayFormat32;
+using sound_feature_extraction::formats::ArrayFormatF;
+using sound_feature_extraction::formats::Float16;
+using sound_feature_extraction::formats::FloatToFloat16Raw;
+using sound_feature_extraction::formats::FloatToInt16Raw;
+using sound_feature_extraction::formats::FloatToInt32Raw;
+using sound_feature_extraction::FeatureStoreCodec;
+using sound_feature_extraction::FeatureStoreWriter;
+using sound_feature_extraction::FFTFWisdom;
+using sound_feature_extraction::MemoryPool;
+using sound_feature_extraction::Metrics;
+using sound_feature_extraction::MetricsCounter;
+using sound_feature_extraction::MetricsHistogram;
+using sound_feature_extraction::ScratchArena;
+using sound_feature_extraction::ThreadPool;
+using sound_feature_extraction::ThreadsGovernor;
+using sound_feature_extraction::TrafficRecorder;
+using sound_feature_extraction::TrafficRecorderException;
+using sound_feature_extraction::CancellationSource;
+using sound_feature_extraction::CancellationToken;
+using sound_feature_extraction::AudioDecoder;
+using sound_feature_extraction::AudioDecoderException;
+using sound_feature_extraction::DecodingSource;
+using sound_feature_extraction::ExecutionCancelled;
+using sound_feature_extraction::ExecutionCancelledException;
+using sound_feature_extraction::MemoryBudgetExceededException;
+using sound_feature_extraction::Profiler;
+using sound_feature_extraction::ProfilingLevel;
+using sound_feature_extraction::Placement;
 using sound_feature_extraction::BuffersBase;
 using sound_feature_extraction::Buffers;
 using sound_feature_extraction::SimdAware;
+using sound_feature_extraction::InstructionSet;
+using sound_feature_extraction::ExecutionOverrides;
+using sound_feature_extraction::ScopedExecutionOverrides;
+using sound_feature_extraction::CurrentExecutionOverrides;
+using sound_feature_extraction::SetThreadExecutionOverrides;
 
 extern "C" {
 
+/// @brief Collects the asynchronous extractions with the same configuration
+/// which arrive within the latency budget and executes them as a single run
+/// of the batch configuration (see set_dynamic_batching()).
+class RequestBatcher {
+ public:
+  RequestBatcher(const FeaturesConfiguration* fc, FeaturesConfiguration* batch,
+                 int latencyBudgetUs);
+  ~RequestBatcher();
+
+  void Add(int16_t* buffer, FeaturesCallback callback, void* userData);
+
+  size_t max_size() const {
+    return histogram_.size();
+  }
+
+  /// @brief The i-th element is the number of the runs of i + 1 requests.
+  std::vector<size_t> histogram() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return histogram_;
+  }
+
+ private:
+  struct Request {
+    int16_t* Buffer;
+    FeaturesCallback Callback;
+    void* UserData;
+    std::chrono::steady_clock::time_point Arrival;
+  };
+
+  void Collect();
+  void Execute(const std::vector<Request>& requests);
+
+  const FeaturesConfiguration* fc_;
+  FeaturesConfiguration* batch_;
+  std::chrono::microseconds budget_;
+  int features_count_;
+  std::vector<Request> queue_;
+  std::vector<size_t> histogram_;
+  bool stopping_;
+  mutable std::mutex mutex_;
+  std::condition_variable arrived_;
+  std::thread thread_;
+};
+
+/// @brief How setup_features_extraction_blocks() splits the input into
+/// the overlapping blocks. The k-th block contributes the windows which
+/// start in [k * Step, (k + 1) * Step) and reads the samples from
+/// BlockBegin(k), which is a multiple of each hop.
+struct BlocksLayout {
+  size_t Step;
+  /// @brief The samples before the contributed ones which each block reads.
+  size_t Before;
+  /// @brief The number of the blocks which FeaturesConfiguration::Tree
+  /// executes.
+  size_t Count;
+  /// @brief Executes the rest of the input, from BlockBegin(Count) to
+  /// the end.
+  std::unique_ptr<FeaturesConfiguration> Tail;
+  /// @brief The step of the windows of each feature.
+  std::unordered_map<std::string, size_t> Hops;
+  /// @brief The number of the rows of each feature in the whole results.
+  std::unordered_map<std::string, size_t> Rows;
+
+  size_t BlockBegin(size_t block) const noexcept {
+    return block * Step > Before? block * Step - Before : 0;
+  }
+};
+
+struct FeaturesConfiguration;
+
+/// @brief How setup_features_extraction_ragged() splits the clips. The full
+/// blocks of all the clips are executed by FeaturesConfiguration::Tree
+/// BatchSize at a time, the rest of each clip by a tree of its own size.
+struct RaggedLayout {
+  /// @brief Step, Before and Hops of each block, the rest is not used.
+  BlocksLayout Blocks;
+  /// @brief The number of samples which each block reads.
+  size_t Size;
+  /// @brief The configurations of the tails of the clips by their sizes.
+  std::unordered_map<size_t, std::shared_ptr<FeaturesConfiguration>> Tails;
+  std::mutex TailsMutex;
+};
+
+/// @brief The metrics of a single configuration, see snapshot_metrics().
+struct ConfigurationMetrics {
+  /// @brief Indexed by FeatureExtractionResult.
+  MetricsCounter* Extractions[3];
+  MetricsHistogram* Latency;
+  MetricsCounter* InputBytes;
+};
+
 struct FeaturesConfiguration {
-  std::unique_ptr<TransformTree> Tree;
+  /// @brief The prepared tree, shared with the other configurations which
+  /// have the same features and format (see PreparedTreesCache).
+  std::shared_ptr<TransformTree> Tree;
+  /// @brief Indicates whether Tree is shared with the other configurations.
+  bool Cached;
   size_t InputSize;
   int Chunks;
+  /// @brief The number of clips of InputSize samples in a single call.
+  size_t BatchSize;
+  /// @brief Indicates whether the configuration was created by
+  /// setup_features_stream().
+  bool Streaming;
+  /// @brief The samples which do not fill a complete block yet.
+  std::vector<int16_t> PendingSamples;
+  /// @brief The accumulated streaming results which were not pulled yet.
+  std::map<std::string, std::vector<char>> StreamResults;
+  /// @brief The absolute offset of the sample which follows the ones pushed
+  /// by extract_sound_features_window().
+  uint64_t StreamPosition;
+  /// @brief The results of the complete blocks which are still inside
+  /// the window of extract_sound_features_window(), block by block.
+  std::deque<std::map<std::string, std::vector<char>>> WindowBlocks;
+  /// @brief The absolute index of the first block in WindowBlocks.
+  uint64_t WindowFirstBlock;
+  /// @brief The views returned by extract_sound_features_views().
+  std::vector<FeatureView> Views;
+  std::vector<std::string> ViewNames;
+  /// @brief The converted features of the views, see
+  /// set_feature_output_type().
+  std::vector<std::vector<char>> ViewConversions;
+  /// @brief The buffers of the views if Tree is shared, so that the other
+  /// configurations do not overwrite them.
+  std::shared_ptr<TransformTree::ExecutionContext> ViewsContext;
+  /// @brief Owned by the thread which uses the buffers of Tree itself.
+  /// Shared between the configurations together with Tree.
+  std::shared_ptr<std::mutex> TreeMutex;
+  /// @brief The execution contexts for the concurrent extractions.
+  mutable std::vector<std::shared_ptr<TransformTree::ExecutionContext>>
+      FreeContexts;
+  mutable std::mutex ContextsMutex;
+  /// @brief The number of the unfinished asynchronous extractions, which
+  /// destroy_features_configuration() waits for.
+  mutable int AsyncPending;
+  mutable std::mutex AsyncMutex;
+  mutable std::condition_variable AsyncFinished;
+  /// @brief The original features and sampling rate, which the batch
+  /// configuration of Batcher is created from.
+  std::vector<std::string> Features;
+  int SamplingRate;
+  /// @brief The priorities of extract_sound_features_deadline(), 0 if
+  /// not set.
+  std::map<std::string, int> Priorities;
+  /// @brief The types set by set_feature_output_type(), the features which
+  /// are fetched as they are calculated are absent.
+  std::map<std::string, FeatureOutputType> OutputTypes;
+  /// @brief Merges the asynchronous extractions if set_dynamic_batching()
+  /// was called.
+  std::unique_ptr<RequestBatcher> Batcher;
+  /// @brief Everything which the results depend on besides the input
+  /// (see prepared_tree_key()). Empty if the results are not cached.
+  std::string Fingerprint;
+  /// @brief Set by setup_features_extraction_blocks(), Tree then executes
+  /// a single block.
+  std::unique_ptr<BlocksLayout> Blocks;
+  /// @brief Set by setup_features_extraction_ragged(), Tree then executes
+  /// BatchSize blocks.
+  std::unique_ptr<RaggedLayout> Ragged;
+  /// @brief Cancels the running extractions, see cancel_extractions().
+  mutable CancellationSource Cancellation;
+  /// @brief The time limit of each extraction in milliseconds, 0 if none.
+  std::atomic<int> TimeoutMs;
+  /// @brief The original names and the variants of the features set by
+  /// setup_features_extraction_variants(), by the names in Tree.
+  std::unordered_map<std::string, std::pair<std::string, int>> Variants;
+  /// @brief Created on the first extraction by configuration_metrics().
+  mutable std::once_flag MetersOnce;
+  mutable ConfigurationMetrics Meters;
+};
+
+struct FeatureStore {
+  std::unique_ptr<FeatureStoreWriter> Writer;
+};
+
+struct SetupRequest {
+  mutable std::mutex Mutex;
+  std::condition_variable Finished;
+  bool Done;
+  FeaturesConfiguration *Config;
+};
+
+struct ExtractionRequest {
+  mutable std::mutex Mutex;
+  std::condition_variable Finished;
+  bool Done;
+  FeatureExtractionResult Result;
+  char **FeatureNames;
+  void **Results;
+  int *ResultLengths;
+};
+
+/// @brief Grants the exclusive access to either Tree's own buffers or to one
+/// of the pooled execution contexts, so that the same configuration can be
+/// used by several threads.
+class ExecutionLease {
+ public:
+  explicit ExecutionLease(const FeaturesConfiguration* fc)
+      : fc_(fc), tree_lock_(*fc->TreeMutex, std::try_to_lock) {
+    if (tree_lock_.owns_lock()) {
+      return;
+    }
+    std::lock_guard<std::mutex> lock(fc->ContextsMutex);
+    if (fc->FreeContexts.empty()) {
+      context_ = fc->Tree->CreateExecutionContext();
+    } else {
+      context_ = fc->FreeContexts.back();
+      fc->FreeContexts.pop_back();
+    }
+  }
+
+  ~ExecutionLease() {
+    if (sinking_) {
+      set_feature_sink(nullptr);
+    }
+    // The results are already copied, so the buffers return to the pool
+    // and the idle configurations do not hold any memory
+    bool release = MemoryPool::Instance().max_idle_size() > 0;
+    if (context_) {
+      if (release) {
+        context_->ReleaseMemory();
+      }
+      std::lock_guard<std::mutex> lock(fc_->ContextsMutex);
+      fc_->FreeContexts.push_back(context_);
+    } else if (release) {
+      fc_->Tree->ReleaseMemory();
+    }
+  }
+
+  const std::unordered_map<std::string, std::shared_ptr<Buffers>>& Execute(
+      const void* in) const {
+    if (context_) {
+      return fc_->Tree->Execute(in, context_.get());
+    }
+    return fc_->Tree->Execute(in);
+  }
+
+  /// @brief Executes only the specified features if they are not nullptr.
+  const std::unordered_map<std::string, std::shared_ptr<Buffers>>& Execute(
+      const void* in, const std::vector<std::string>* features) const {
+    if (features == nullptr) {
+      return Execute(in);
+    }
+    if (context_) {
+      return fc_->Tree->Execute(in, *features, context_.get());
+    }
+    return fc_->Tree->Execute(in, *features);
+  }
+
+  /// @brief The results of the last Execute() in the order of
+  /// TransformTree::FeatureNames().
+  const std::vector<std::shared_ptr<Buffers>>& IndexedResults() const {
+    return fc_->Tree->IndexedResults(context_.get());
+  }
+
+  /// @brief Passes the features of the following Execute() calls to sink,
+  /// see TransformTree::set_feature_sink().
+  void set_feature_sink(const TransformTree::FeatureSink& sink) {
+    sinking_ = static_cast<bool>(sink);
+    if (context_) {
+      context_->set_feature_sink(sink);
+    } else {
+      fc_->Tree->set_feature_sink(sink);
+    }
+  }
+
+ private:
+  const FeaturesConfiguration* fc_;
+  std::unique_lock<std::mutex> tree_lock_;
+  std::shared_ptr<TransformTree::ExecutionContext> context_;
+  bool sinking_ = false;
+};
+
+/// @brief The least recently used bounded cache of the prepared trees of
+/// the non-streaming configurations, keyed on the normalized features and
+/// the input format. Setting up the same configuration twice reuses the
+/// tree instead of building and preparing it again.
+class PreparedTreesCache {
+ public:
+  struct Entry {
+    std::shared_ptr<TransformTree> Tree;
+    std::shared_ptr<std::mutex> TreeMutex;
+  };
+
+  PreparedTreesCache() : capacity_(64 * 1024 * 1024), size_(0) {
+  }
+
+  bool Find(const std::string& key, Entry* entry) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+      return false;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second);
+    *entry = it->second->second;
+    return true;
+  }
+
+  void Insert(const std::string& key, const Entry& entry) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (index_.find(key) != index_.end() ||
+        entry.Tree->allocated_size() > capacity_) {
+      return;
+    }
+    lru_.emplace_front(key, entry);
+    index_[key] = lru_.begin();
+    size_ += entry.Tree->allocated_size();
+    Shrink();
+  }
+
+  /// @brief Removes the tree from the cache so that it can be modified.
+  /// @return false if the other configurations share the tree.
+  bool Detach(const std::string& key,
+              const std::shared_ptr<TransformTree>& tree) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it == index_.end() || it->second->second.Tree != tree) {
+      return tree.use_count() == 1;
+    }
+    if (tree.use_count() > 2) {
+      return false;
+    }
+    size_ -= tree->allocated_size();
+    lru_.erase(it->second);
+    index_.erase(it);
+    return true;
+  }
+
+  size_t capacity() const {
+    return capacity_;
+  }
+
+  /// @brief Sets the limit of the sum of the cached trees' buffers sizes.
+  /// The evicted trees live while their configurations are not destroyed.
+  void set_capacity(size_t value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacity_ = value;
+    Shrink();
+  }
+
+ private:
+  typedef std::list<std::pair<std::string, Entry>> LRUList;
+
+  void Shrink() {
+    while (size_ > capacity_) {
+      auto& last = lru_.back();
+      size_ -= last.second.Tree->allocated_size();
+      index_.erase(last.first);
+      lru_.pop_back();
+    }
+  }
+
+  size_t capacity_;
+  size_t size_;
+  LRUList lru_;
+  std::unordered_map<std::string, LRUList::iterator> index_;
+  std::mutex mutex_;
+};
+
+PreparedTreesCache prepared_trees_cache;
+
+/// @brief Keeps the results of the recent extractions by the contents of
+/// their inputs, so that the repeated clips (retries, re-uploads, jingles)
+/// are not extracted again.
+class ResultsCache {
+ public:
+  struct Entry {
+    std::vector<char> Input;
+    std::vector<std::pair<std::string, std::vector<char>>> Results;
+    std::chrono::steady_clock::time_point Inserted;
+
+    size_t size() const {
+      size_t ret = Input.size();
+      for (auto& res : Results) {
+        ret += res.second.size();
+      }
+      return ret;
+    }
+  };
+
+  ResultsCache() : capacity_(0), ttl_(0), size_(0), hits_(0), misses_(0) {
+  }
+
+  /// @brief Looks up the results of the same configuration and input.
+  /// The found entry is immutable, so it is read without copying while
+  /// the cache goes on.
+  std::shared_ptr<const Entry> Find(const std::string& config,
+                                    const char* input, size_t size) {
+    auto key = Key(config, input, size);
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+      misses_++;
+      return nullptr;
+    }
+    auto entry = it->second->second;
+    if (ttl_.count() > 0 &&
+        std::chrono::steady_clock::now() - entry->Inserted > ttl_) {
+      Erase(it->second);
+      misses_++;
+      return nullptr;
+    }
+    // The hash may collide
+    if (entry->Input.size() != size ||
+        memcmp(entry->Input.data(), input, size) != 0) {
+      misses_++;
+      return nullptr;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second);
+    hits_++;
+    return entry;
+  }
+
+  void Insert(const std::string& config,
+              const std::shared_ptr<const Entry>& entry) {
+    auto key = Key(config, entry->Input.data(), entry->Input.size());
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (entry->size() > capacity_) {
+      return;
+    }
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+      Erase(it->second);
+    }
+    lru_.emplace_front(key, entry);
+    index_[key] = lru_.begin();
+    size_ += entry->size();
+    Shrink();
+  }
+
+  size_t capacity() const {
+    return capacity_;
+  }
+
+  /// @brief Sets the limit of the sum of the cached inputs and results
+  /// sizes. 0 disables the cache.
+  void set_capacity(size_t value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacity_ = value;
+    Shrink();
+  }
+
+  std::chrono::milliseconds ttl() const {
+    return ttl_;
+  }
+
+  /// @brief Sets how long the entries are valid, 0 means forever.
+  void set_ttl(const std::chrono::milliseconds& value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ttl_ = value;
+  }
+
+  void stats(size_t* hits, size_t* misses) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    *hits = hits_;
+    *misses = misses_;
+  }
+
+  /// @brief Drops all the entries and zeroes the statistics.
+  void Reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    lru_.clear();
+    index_.clear();
+    size_ = 0;
+    hits_ = 0;
+    misses_ = 0;
+  }
+
+ private:
+  typedef std::list<std::pair<std::string, std::shared_ptr<const Entry>>>
+      LRUList;
+
+  /// @brief Combines the configuration fingerprint with FNV-1a of
+  /// the input, taken by 64-bit words.
+  static std::string Key(const std::string& config, const char* input,
+                         size_t size) {
+    uint64_t hash = 14695981039346656037ULL;
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+      uint64_t word;
+      memcpy(&word, input + i, sizeof(word));
+      hash = (hash ^ word) * 1099511628211ULL;
+    }
+    for (; i < size; i++) {
+      hash = (hash ^ static_cast<uint8_t>(input[i])) * 1099511628211ULL;
+    }
+    return config + '#' + std::to_string(hash);
+  }
+
+  void Erase(LRUList::iterator it) {
+    size_ -= it->second->size();
+    index_.erase(it->first);
+    lru_.erase(it);
+  }
+
+  void Shrink() {
+    while (size_ > capacity_) {
+      Erase(std::prev(lru_.end()));
+    }
+  }
+
+  size_t capacity_;
+  std::chrono::milliseconds ttl_;
+  size_t size_;
+  size_t hits_;
+  size_t misses_;
+  LRUList lru_;
+  std::unordered_map<std::string, LRUList::iterator> index_;
+  std::mutex mutex_;
 };
 
+ResultsCache results_cache;
+
 /// @brief One second of standard 2-channel 44100Hz audio
 size_t chunk_size = 60 * 44100 * 2;
 
+/// @brief Execute independent subtrees of the transform tree concurrently.
+bool parallel_execution = false;
+
+/// @brief Execute the chunks of the input concurrently.
+bool parallel_chunks = false;
+
+/// @brief The allocator of the buffers of the sequentially executed trees.
+BuffersAllocatorType buffers_allocator = BUFFERS_ALLOCATOR_SLIDING_BLOCKS;
+
+/// @brief The approximations the transforms may take.
+AccuracyTier accuracy = ACCURACY_EXACT;
+
+/// @brief Time the slice sizes of the cache optimized cycles on preparation.
+bool cache_autotuning = false;
+
+/// @brief Execute the slices of the cache optimized cycles concurrently.
+bool parallel_slices = false;
+
+/// @brief Execute the trees once on preparation.
+bool warm_up = false;
+
+/// @brief Pack the tiny results of the trees without the padding.
+bool packed_results = false;
+
+/// @brief Reuse the results of the inputs which consist of the same sample.
+bool constant_input_shortcut = false;
+
+/// @brief What the trees measure about each node.
+ProfilingLevelType profiling_level = PROFILING_LEVEL_COARSE;
+
+/// @brief The bound of the asynchronous extractions queue.
+std::atomic<int> max_pending_extractions(64);
+
+/// @brief The number of the unfinished asynchronous extractions.
+std::atomic<int> pending_extractions(0);
+
+/// @brief Set by start_traffic_recording(), accessed atomically.
+std::shared_ptr<TrafficRecorder> traffic_recorder;
+
 #define BLAME(x) EINA_LOG_ERR("Error: " #x " is null (function %s, " \
                               "line %i)\n", \
                               __FUNCTION__, __LINE__)
@@ -192,18 +803,18 @@ void query_transform_details(const char *name, char **description,
     formatName = fullName.substr(bracePos + 1);
     formatName.resize(formatName.size() - 1);
   }
-  auto tit = TransformFactory::Instance().Map().find(transformName);
-  if (tit == TransformFactory::Instance().Map().end()) {
+  auto tit = TransformFactory::Instance().Find(transformName);
+  if (tit == nullptr) {
     EINA_LOG_ERR("Error: transform %s was not found.\n", fullName.c_str());
     return;
   }
 
   std::shared_ptr<Transform> transformInstance;
   if (formatName == "") {
-    transformInstance = tit->second.begin()->second();
+    transformInstance = tit->begin()->second();
   } else {
-    auto tfit = tit->second.find(formatName);
-    if (tfit == tit->second.end()) {
+    auto tfit = tit->find(formatName);
+    if (tfit == tit->end()) {
       EINA_LOG_ERR("Error: transform %s was not found.\n",
                    fullName.c_str());
       return;
@@ -251,9 +862,74 @@ void destroy_transform_details(char *description,
   delete[] parameterDefaultValues;
 }
 
-FeaturesConfiguration *setup_features_extraction(
+/// @brief Strips the whitespace and sorts the comma separated parameters.
+static std::string normalize_parameters(const std::string& params) {
+  std::vector<std::string> items(1);
+  for (char c : params) {
+    if (c == ',') {
+      items.emplace_back();
+    } else if (!isspace(c)) {
+      items.back().push_back(c);
+    }
+  }
+  std::sort(items.begin(), items.end());
+  std::string res;
+  for (auto& item : items) {
+    if (item.empty()) {
+      continue;
+    }
+    if (!res.empty()) {
+      res += ',';
+    }
+    res += item;
+  }
+  return res;
+}
+
+/// @brief Builds the key of PreparedTreesCache. Everything which affects
+/// the tree construction must be included.
+static std::string prepared_tree_key(const RawFeaturesMap& featmap,
+                                     size_t bufferSize, int samplingRate,
+                                     size_t batchSize, bool interleaved,
+                                     SampleType sampleType, int chunks) {
+  std::map<std::string, const sound_feature_extraction::RawTransformsList*>
+      sorted;
+  for (auto& featpair : featmap) {
+    sorted[featpair.first] = &featpair.second;
+  }
+  std::string key;
+  for (auto& featpair : sorted) {
+    key += featpair.first + '[';
+    for (auto& tpair : *featpair.second) {
+      key += tpair.first + '(' + normalize_parameters(tpair.second) + ')';
+    }
+    key += ']';
+  }
+  key += ';' + std::to_string(bufferSize) + ';' +
+      std::to_string(samplingRate) + ';' + std::to_string(batchSize) + ';' +
+      std::to_string(interleaved) + ';' +
+      std::to_string(static_cast<int>(sampleType)) + ';' +
+      std::to_string(chunks) + ';' + std::to_string(parallel_execution) +
+      ';' + std::to_string(buffers_allocator) + ';' +
+      std::to_string(accuracy) + ';' +
+      std::to_string(cache_autotuning) + ';' +
+      std::to_string(parallel_slices) + ';' +
+      std::to_string(packed_results) + ';' +
+      std::to_string(constant_input_shortcut) + ';' +
+      std::to_string(profiling_level) + ';' +
+      std::to_string(get_use_simd()) + ';' +
+      std::to_string(FFTFWisdom::Instance().prefer_gpu()) + ';' +
+      std::to_string(get_omp_transforms_max_threads_num()) + ';' +
+      std::to_string(get_cpu_cache_size());
+  return key;
+}
+
+static FeaturesConfiguration *create_features_configuration(
     const char *const *features, int featuresCount,
-    size_t bufferSize, int samplingRate) {
+    size_t bufferSize, int samplingRate, bool streaming, size_t batchSize,
+    bool interleaved, SampleType sampleType = SampleType::kInt16,
+    bool block = false, size_t memoryBudget = 0,
+    size_t *neededMemory = nullptr) {
   CHECK_NULL_RET(features, nullptr);
   EINA_LOG_DBG("featuresCount=%d, bufferSize=%zu, samplingRate=%i",
       featuresCount, bufferSize, samplingRate);
@@ -289,15 +965,106 @@ FeaturesConfiguration *setup_features_extraction(
   }
 
   int chunks = 1;
-  while (bufferSize / chunks > chunk_size) {
+  // The streaming blocks, the batched clips and the overlapping blocks are
+  // never split into chunks
+  while (!streaming && !block && batchSize == 1 &&
+         bufferSize / chunks > get_chunk_size()) {
     chunks++;
   }
-  auto format = std::make_shared<ArrayFormat16>(
-      std::min(bufferSize, bufferSize / chunks), samplingRate);
+  std::string key;
+  if (!streaming && !block) {
+    key = prepared_tree_key(featmap, bufferSize, samplingRate, batchSize,
+                            interleaved, sampleType, chunks);
+  }
+  if (!key.empty() && prepared_trees_cache.capacity() > 0) {
+    PreparedTreesCache::Entry entry;
+    static MetricsCounter* lookups[] = {
+      Metrics::Instance().Counter(
+          "sfe_configurations_cache_lookups",
+          "The lookups of the prepared trees cache.", "result=\"miss\""),
+      Metrics::Instance().Counter(
+          "sfe_configurations_cache_lookups",
+          "The lookups of the prepared trees cache.", "result=\"hit\"")
+    };
+    bool found = prepared_trees_cache.Find(key, &entry);
+    lookups[found]->Increment();
+    if (found) {
+      if (memoryBudget > 0 && entry.Tree->allocated_size() > memoryBudget) {
+        if (neededMemory != nullptr) {
+          *neededMemory = entry.Tree->allocated_size();
+        }
+        return nullptr;
+      }
+      EINA_LOG_DBG("Reusing the cached prepared tree");
+      auto config = new FeaturesConfiguration();
+      config->Tree = entry.Tree;
+      config->TreeMutex = entry.TreeMutex;
+      config->Cached = true;
+      config->InputSize = bufferSize;
+      config->Chunks = chunks;
+      config->Streaming = false;
+      config->BatchSize = batchSize;
+      config->Features = lines;
+      config->SamplingRate = samplingRate;
+      config->Fingerprint = key;
+      return config;
+    }
+  }
+  size_t rootSize = std::min(bufferSize, bufferSize / chunks);
   auto config = new FeaturesConfiguration();
-  config->Tree = std::make_unique<TransformTree>(format);
+  switch (sampleType) {
+    case SampleType::kInt32:
+      config->Tree = std::make_shared<TransformTree>(
+          std::make_shared<ArrayFormat32>(rootSize, samplingRate));
+      break;
+    case SampleType::kFloat:
+      config->Tree = std::make_shared<TransformTree>(
+          std::make_shared<ArrayFormatF>(rootSize, samplingRate));
+      break;
+    default:
+      config->Tree = std::make_shared<TransformTree>(
+          std::make_shared<ArrayFormat16>(rootSize, samplingRate));
+      break;
+  }
+  config->TreeMutex = std::make_shared<std::mutex>();
+  config->Cached = false;
   config->InputSize = bufferSize;
   config->Chunks = chunks;
+  config->Streaming = streaming;
+  // The configuration keeps the settings of the thread which created it
+  auto overrides = CurrentExecutionOverrides();
+  if (overrides != nullptr) {
+    config->Tree->set_execution_overrides(*overrides);
+  }
+  // The FFT plans are created lazily, so the tree remembers the backends
+  // preference
+  if (config->Tree->execution_overrides().PreferGpu < 0) {
+    auto tree_overrides = config->Tree->execution_overrides();
+    tree_overrides.PreferGpu = FFTFWisdom::Instance().prefer_gpu();
+    config->Tree->set_execution_overrides(tree_overrides);
+  }
+  config->Tree->set_parallel_execution(parallel_execution);
+  config->Tree->set_accuracy(static_cast<Accuracy>(accuracy));
+  config->Tree->set_allocation_strategy(
+      buffers_allocator == BUFFERS_ALLOCATOR_INTERVAL_PACKING?
+      AllocationStrategy::kIntervalPacking :
+      AllocationStrategy::kSlidingBlocks);
+  config->Tree->set_cache_autotuning(cache_autotuning);
+  config->Tree->set_parallel_slices(parallel_slices);
+  config->Tree->set_warm_up(warm_up);
+  config->Tree->set_memory_budget(memoryBudget);
+  config->Tree->set_packed_results(packed_results);
+  config->Tree->set_constant_input_shortcut(constant_input_shortcut);
+  config->Tree->set_profiling_level(
+      static_cast<ProfilingLevel>(profiling_level));
+  config->Tree->set_streaming(streaming);
+  config->Tree->set_batch_size(batchSize);
+  config->Tree->set_channels_layout(
+      interleaved? ChannelsLayout::kInterleaved : ChannelsLayout::kPlanar);
+  config->BatchSize = batchSize;
+  config->Features = lines;
+  config->SamplingRate = samplingRate;
+  config->Fingerprint = key;
   for (auto& featpair : featmap) {
     try {
       config->Tree->AddFeature(featpair.first, featpair.second);
@@ -323,118 +1090,2794 @@ FeaturesConfiguration *setup_features_extraction(
       return nullptr;
     }
   }
-  config->Tree->PrepareForExecution();
-#ifdef DEBUG
-  config->Tree->set_validate_after_each_transform(true);
-#endif
-  return config;
-}
-
-FeatureExtractionResult extract_sound_features(
-    const FeaturesConfiguration *fc, int16_t *buffer,
-    char ***featureNames, void ***results, int **resultLengths) {
-  CHECK_NULL_RET(fc, FEATURE_EXTRACTION_RESULT_ERROR);
-  CHECK_NULL_RET(buffer, FEATURE_EXTRACTION_RESULT_ERROR);
-  CHECK_NULL_RET(results, FEATURE_EXTRACTION_RESULT_ERROR);
-
-  fftf_set_openmp_num_threads(get_omp_transforms_max_threads_num());
-  EINA_LOG_DBG("OpenMP threads number is %d, SIMD is %s, FFTF backend is %d\n",
-               get_omp_transforms_max_threads_num(),
-               get_use_simd()? "enabled" : "disabled",
-               fftf_current_backend());
-  std::unordered_map<std::string, std::shared_ptr<Buffers>> retmap;
-  size_t step = fc->InputSize / fc->Chunks;
-  size_t length = step * fc->Chunks;
-  for (size_t i = 0; i < length; i += step) {
-    EINA_LOG_INFO("Evaluating [%d%%, %d%%]...",
-                  static_cast<int>(i * 100 / length),
-                  static_cast<int>((i + step) * 100 / length));
+  std::string dependent;
+  // The blocks of the ragged clips overlap, so that the relations between
+  // them are cut off afterwards
+  if (batchSize > 1 && !block &&
+      !config->Tree->SignalsIndependent(&dependent)) {
+    EINA_LOG_ERR("Error: %s relates the adjacent buffers, so the batched "
+                 "clips would affect each other\n", dependent.c_str());
+    delete config;
+    return nullptr;
+  }
+  if (streaming) {
+    for (auto& featpair : featmap) {
+      config->StreamResults[featpair.first];
+    }
     try {
-      retmap = fc->Tree->Execute(buffer + i);
+      config->Tree->PrepareForExecution();
     }
     catch(const std::exception& ex) {
-      EINA_LOG_ERR("Caught an exception with message \"%s\".\n", ex.what());
-      return FEATURE_EXTRACTION_RESULT_ERROR;
+      EINA_LOG_ERR("Failed to prepare the transform tree. %s\n", ex.what());
+      delete config;
+      return nullptr;
     }
-    if (i == 0) {
-      *featureNames = new char*[retmap.size()];
-      *results = new void*[retmap.size()];
-      *resultLengths = new int[retmap.size()];
+  } else {
+    try {
+      config->Tree->PrepareForExecution();
     }
-
-    int j = 0;
-    for (auto& res : retmap) {
-      if (i == 0) {
-        copy_string(res.first, *featureNames + j);
-      }
-      size_t size_each = res.second->Format()->UnalignedSizeInBytes();
-      assert(size_each > 0);
-      size_t size = size_each * res.second->Count();
-      if (i == 0) {
-        (*resultLengths)[j] = 0;
-        (*results)[j] = new char[size * fc->Chunks];
-      }
-      for (size_t k = 0; k < res.second->Count(); k++) {
-        memcpy(reinterpret_cast<char *>((*results)[j]) +
-                   (*resultLengths)[j] + k * size_each,
-               (*res.second)[k], size_each);
+    catch(const MemoryBudgetExceededException& ex) {
+      EINA_LOG_DBG("%s", ex.what());
+      if (neededMemory != nullptr) {
+        *neededMemory = ex.needed();
       }
-      (*resultLengths)[j] += size;
-      j++;
+      delete config;
+      return nullptr;
     }
   }
-  return FEATURE_EXTRACTION_RESULT_OK;
+#ifdef DEBUG
+  config->Tree->set_validate_after_each_transform(true);
+#endif
+  if (!key.empty() && prepared_trees_cache.capacity() > 0) {
+    prepared_trees_cache.Insert(key, { config->Tree, config->TreeMutex });
+    config->Cached = true;
+  }
+  return config;
 }
 
-void report_extraction_time(const FeaturesConfiguration *fc,
-                            char ***transformNames,
-                            float **values,
-                            int *length) {
-  CHECK_NULL(fc);
-  CHECK_NULL(transformNames);
-  CHECK_NULL(values);
-  CHECK_NULL(length);
-
-  auto report = fc->Tree->ExecutionTimeReport();
-  *length = report.size();
-  *transformNames = new char*[*length];
-  *values = new float[*length];
+FeaturesConfiguration *setup_features_extraction(
+    const char *const *features, int featuresCount,
+    size_t bufferSize, int samplingRate) {
+  return create_features_configuration(features, featuresCount, bufferSize,
+                                       samplingRate, false, 1, false);
+}
 
-  int i = 0;
-  for (auto pair : report) {
-    copy_string(pair.first, *transformNames + i);
-    (*values)[i] = pair.second;
-    i++;
+SetupRequest *setup_features_extraction_async(
+    const char *const *features, int featuresCount,
+    size_t bufferSize, int samplingRate) {
+  CHECK_NULL_RET(features, nullptr);
+  std::vector<std::string> copies;
+  for (int i = 0; i < featuresCount; i++) {
+    CHECK_NULL_RET(features[i], nullptr);
+    copies.emplace_back(features[i]);
   }
+  auto request = new SetupRequest();
+  request->Done = false;
+  request->Config = nullptr;
+  ThreadPool::Instance().Submit([=]() {
+    std::vector<const char*> pointers;
+    for (auto& feature : copies) {
+      pointers.push_back(feature.c_str());
+    }
+    auto config = setup_features_extraction(
+        pointers.data(), pointers.size(), bufferSize, samplingRate);
+    std::lock_guard<std::mutex> lock(request->Mutex);
+    request->Config = config;
+    request->Done = true;
+    request->Finished.notify_all();
+  });
+  return request;
 }
 
-void destroy_extraction_time_report(char **transformNames,
-                                    float *values,
-                                    int length) {
-  CHECK_NULL(transformNames);
-  CHECK_NULL(values);
+bool poll_features_setup(const SetupRequest *request) {
+  CHECK_NULL_RET(request, false);
+  std::lock_guard<std::mutex> lock(request->Mutex);
+  return request->Done;
+}
 
-  delete[] values;
-  for (int i = 0; i < length; i++) {
-    delete[] transformNames[i];
+FeaturesConfiguration *finish_features_setup(SetupRequest *request) {
+  CHECK_NULL_RET(request, nullptr);
+  {
+    std::unique_lock<std::mutex> lock(request->Mutex);
+    request->Finished.wait(lock, [request] { return request->Done; });
   }
-  delete[] transformNames;
+  auto config = request->Config;
+  delete request;
+  return config;
 }
 
-void report_extraction_graph(const FeaturesConfiguration *fc,
-                             const char *fileName) {
-  CHECK_NULL(fc);
-  CHECK_NULL(fileName);
-  fc->Tree->Dump(fileName);
+FeaturesConfiguration *setup_features_extraction_int32(
+    const char *const *features, int featuresCount,
+    size_t bufferSize, int samplingRate) {
+  return create_features_configuration(features, featuresCount, bufferSize,
+                                       samplingRate, false, 1, false,
+                                       SampleType::kInt32);
 }
 
-void destroy_features_configuration(FeaturesConfiguration* fc) {
-  CHECK_NULL(fc);
+FeaturesConfiguration *setup_features_extraction_float(
+    const char *const *features, int featuresCount,
+    size_t bufferSize, int samplingRate) {
+  return create_features_configuration(features, featuresCount, bufferSize,
+                                       samplingRate, false, 1, false,
+                                       SampleType::kFloat);
+}
 
-  delete fc;
+FeaturesConfiguration *setup_features_extraction_batch(
+    const char *const *features, int featuresCount,
+    size_t clipSize, int clipsCount, int samplingRate) {
+  if (clipsCount < 1) {
+    EINA_LOG_ERR("Error: clipsCount must be positive (%i)\n", clipsCount);
+    return nullptr;
+  }
+  return create_features_configuration(features, featuresCount, clipSize,
+                                       samplingRate, false, clipsCount,
+                                       false);
 }
 
-void free_results(int featuresCount, char **featureNames,
+FeaturesConfiguration *setup_features_extraction_multichannel(
+    const char *const *features, int featuresCount,
+    size_t channelSize, int channels, int samplingRate,
+    ChannelsLayoutType layout) {
+  if (channels < 1) {
+    EINA_LOG_ERR("Error: channels must be positive (%i)\n", channels);
+    return nullptr;
+  }
+  return create_features_configuration(
+      features, featuresCount, channelSize, samplingRate, false, channels,
+      layout == CHANNELS_LAYOUT_INTERLEAVED);
+}
+
+FeaturesConfiguration *setup_features_stream(
+    const char *const *features, int featuresCount,
+    size_t blockSize, int samplingRate) {
+  return create_features_configuration(features, featuresCount, blockSize,
+                                       samplingRate, true, 1, false);
+}
+
+/// @brief Measures how far the features look around the samples which
+/// each block of blockSize contributes and sets Step, Before and Hops of
+/// layout. The overlap depends on the formats, so it is measured on
+/// a probe tree of probeSize samples.
+/// @param bounded Set to false if the features depend on the whole input.
+/// @return The number of samples which each block reads, 0 on failure.
+static size_t plan_blocks(
+    const char *const *features, int featuresCount, size_t probeSize,
+    size_t blockSize, int samplingRate, size_t memoryBudget,
+    size_t *neededMemory, bool *bounded, BlocksLayout *layout) {
+  if (blockSize == 0) {
+    EINA_LOG_ERR("Error: blockSize must be positive\n");
+    return 0;
+  }
+  auto probe = create_features_configuration(
+      features, featuresCount, probeSize, samplingRate, false, 1, false,
+      SampleType::kInt16, true, memoryBudget, neededMemory);
+  if (probe == nullptr) {
+    return 0;
+  }
+  std::unordered_map<std::string, size_t> hops;
+  auto overlap = probe->Tree->BlockOverlap(&hops);
+  delete probe;
+  if (bounded != nullptr) {
+    *bounded = overlap.Bounded();
+  }
+  if (!overlap.Bounded()) {
+    EINA_LOG_ERR("Error: some of the features depend on the whole input, "
+                 "so it cannot be split into blocks\n");
+    return 0;
+  }
+  // The blocks start at the multiples of each hop, so that their windows
+  // are the windows of the whole buffer
+  size_t align = 1;
+  for (auto& hop : hops) {
+    size_t a = align, b = hop.second;
+    while (b != 0) {
+      a %= b;
+      std::swap(a, b);
+    }
+    align = align / a * hop.second;
+  }
+  layout->Step = std::max(blockSize / align, size_t(1)) * align;
+  layout->Before = (overlap.Before + align - 1) / align * align;
+  layout->Hops.swap(hops);
+  return layout->Before + layout->Step + overlap.After;
+}
+
+/// @brief Implements setup_features_extraction_blocks(). If the trees do
+/// not fit into memoryBudget, returns nullptr and sets neededMemory to
+/// the size of the largest one.
+/// @param bounded Set to false if the features depend on the whole input.
+static FeaturesConfiguration *create_blocks_configuration(
+    const char *const *features, int featuresCount,
+    size_t bufferSize, size_t blockSize, int samplingRate,
+    size_t memoryBudget = 0, size_t *neededMemory = nullptr,
+    bool *bounded = nullptr) {
+  auto layout = std::make_unique<BlocksLayout>();
+  size_t size = plan_blocks(features, featuresCount,
+                            std::min(blockSize, bufferSize), blockSize,
+                            samplingRate, memoryBudget, neededMemory,
+                            bounded, layout.get());
+  if (size == 0) {
+    return nullptr;
+  }
+  if (size >= bufferSize) {
+    return create_features_configuration(
+        features, featuresCount, bufferSize, samplingRate, false, 1, false,
+        SampleType::kInt16, false, memoryBudget, neededMemory);
+  }
+  layout->Count = 0;
+  while (layout->BlockBegin(layout->Count) + size <= bufferSize) {
+    layout->Count++;
+  }
+  size_t tail_begin = layout->BlockBegin(layout->Count);
+  auto config = create_features_configuration(
+      features, featuresCount, size, samplingRate, false, 1, false,
+      SampleType::kInt16, true, memoryBudget, neededMemory);
+  if (config == nullptr) {
+    return nullptr;
+  }
+  layout->Tail.reset(create_features_configuration(
+      features, featuresCount, bufferSize - tail_begin, samplingRate, false,
+      1, false, SampleType::kInt16, true, memoryBudget, neededMemory));
+  if (!layout->Tail) {
+    delete config;
+    return nullptr;
+  }
+  auto tail_buffers = layout->Tail->Tree->FeatureBuffers();
+  for (auto& hop : layout->Hops) {
+    size_t contributed = layout->Count * layout->Step;
+    layout->Rows[hop.first] = contributed / hop.second +
+        tail_buffers[hop.first]->Count() -
+        (contributed - tail_begin) / hop.second;
+  }
+  config->InputSize = bufferSize;
+  config->Blocks = std::move(layout);
+  return config;
+}
+
+FeaturesConfiguration *setup_features_extraction_blocks(
+    const char *const *features, int featuresCount,
+    size_t bufferSize, size_t blockSize, int samplingRate) {
+  return create_blocks_configuration(features, featuresCount, bufferSize,
+                                     blockSize, samplingRate);
+}
+
+FeaturesConfiguration *setup_features_extraction_ragged(
+    const char *const *features, int featuresCount, size_t blockSize,
+    int blocksCount, int samplingRate) {
+  if (blocksCount < 1) {
+    EINA_LOG_ERR("Error: blocksCount must be positive (%i)\n", blocksCount);
+    return nullptr;
+  }
+  auto layout = std::make_unique<RaggedLayout>();
+  layout->Size = plan_blocks(features, featuresCount, blockSize, blockSize,
+                             samplingRate, 0, nullptr, nullptr,
+                             &layout->Blocks);
+  if (layout->Size == 0) {
+    return nullptr;
+  }
+  auto config = create_features_configuration(
+      features, featuresCount, layout->Size, samplingRate, false,
+      blocksCount, false, SampleType::kInt16, true);
+  if (config != nullptr) {
+    config->Ragged = std::move(layout);
+  }
+  return config;
+}
+
+FeaturesConfiguration *setup_features_extraction_variants(
+    const char *const *features, const int *variantsSizes, int variantsCount,
+    size_t bufferSize, int samplingRate) {
+  CHECK_NULL_RET(features, nullptr);
+  CHECK_NULL_RET(variantsSizes, nullptr);
+  std::vector<std::string> lines;
+  std::unordered_map<std::string, std::pair<std::string, int>> variants;
+  int index = 0;
+  for (int variant = 0; variant < variantsCount; variant++) {
+    for (int i = 0; i < variantsSizes[variant]; i++, index++) {
+      CHECK_NULL_RET(features[index], nullptr);
+      // Rename "Name [...]" to "Name_<variant> [...]"; the trailing number
+      // tells the variant, so the names never collide
+      std::string line(features[index]);
+      size_t begin = 0;
+      while (begin < line.size() &&
+             isspace(static_cast<unsigned char>(line[begin]))) {
+        begin++;
+      }
+      size_t end = begin;
+      while (end < line.size() &&
+             (isalnum(static_cast<unsigned char>(line[end])) ||
+              line[end] == '_')) {
+        end++;
+      }
+      auto name = line.substr(begin, end - begin);
+      auto unique = name + '_' + std::to_string(variant);
+      line.replace(begin, end - begin, unique);
+      lines.push_back(line);
+      variants[unique] = std::make_pair(name, variant);
+    }
+  }
+  std::vector<const char *> renamed;
+  for (auto& line : lines) {
+    renamed.push_back(line.c_str());
+  }
+  // The tree merges the common prefixes of all the chains, so the shared
+  // front end runs once for all the variants
+  auto config = create_features_configuration(
+      renamed.data(), renamed.size(), bufferSize, samplingRate, false, 1,
+      false);
+  if (config != nullptr) {
+    config->Variants = std::move(variants);
+  }
+  return config;
+}
+
+FeatureExtractionResult extract_sound_features_variants(
+    const FeaturesConfiguration *fc, int16_t *buffer,
+    char ***featureNames, void ***results, int **resultLengths,
+    int **resultVariants) {
+  CHECK_NULL_RET(fc, FEATURE_EXTRACTION_RESULT_ERROR);
+  CHECK_NULL_RET(featureNames, FEATURE_EXTRACTION_RESULT_ERROR);
+  CHECK_NULL_RET(resultVariants, FEATURE_EXTRACTION_RESULT_ERROR);
+  if (fc->Variants.empty()) {
+    EINA_LOG_ERR("Error: the configuration was not created by "
+                 "setup_features_extraction_variants()\n");
+    return FEATURE_EXTRACTION_RESULT_ERROR;
+  }
+  auto result = extract_sound_features(fc, buffer, featureNames, results,
+                                       resultLengths);
+  if (result != FEATURE_EXTRACTION_RESULT_OK) {
+    return result;
+  }
+  int count = fc->Variants.size();
+  *resultVariants = new int[count];
+  for (int i = 0; i < count; i++) {
+    auto& variant = fc->Variants.find((*featureNames)[i])->second;
+    delete[] (*featureNames)[i];
+    copy_string(variant.first, *featureNames + i);
+    (*resultVariants)[i] = variant.second;
+  }
+  return FEATURE_EXTRACTION_RESULT_OK;
+}
+
+void free_result_variants(int *resultVariants) {
+  delete[] resultVariants;
+}
+
+/// @brief The memory of the buffers of all the trees of the configuration.
+static size_t configuration_memory(const FeaturesConfiguration *fc) {
+  size_t memory = fc->Tree->allocated_size();
+  if (fc->Blocks) {
+    memory += fc->Blocks->Tail->Tree->allocated_size();
+  }
+  return memory;
+}
+
+/// @brief Scales the size of the tree input by budget / needed, which is
+/// how the size of the buffers depends on it, minus a margin for the parts
+/// which do not scale.
+static size_t scale_to_budget(size_t size, size_t budget, size_t needed) {
+  auto scaled = static_cast<size_t>(
+      static_cast<double>(size) * budget / needed * 0.9);
+  return std::min(scaled, size - 1);
+}
+
+FeaturesConfiguration *setup_features_extraction_budget(
+    const char *const *features, int featuresCount, size_t bufferSize,
+    int samplingRate, size_t memoryBudget, ExtractionPlan *plan) {
+  CHECK_NULL_RET(features, nullptr);
+  if (memoryBudget == 0) {
+    EINA_LOG_ERR("Error: memoryBudget must be positive\n");
+    return nullptr;
+  }
+  ExtractionPlan chosen { EXTRACTION_PLAN_WHOLE, 1, bufferSize, 0 };
+  size_t needed = 0;
+  auto config = create_features_configuration(
+      features, featuresCount, bufferSize, samplingRate, false, 1, false,
+      SampleType::kInt16, false, memoryBudget, &needed);
+  if (config != nullptr && config->Chunks > 1) {
+    // get_chunk_size() already splits the input
+    chosen = { EXTRACTION_PLAN_CHUNKS, config->Chunks,
+               config->Tree->RootSize(), 0 };
+  }
+  size_t whole_needed = needed;
+  // The blocks overlap by the context of the features, so unlike
+  // the chunks they do not change the results
+  bool bounded = true;
+  size_t size = bufferSize;
+  while (config == nullptr && needed > 0 && bounded) {
+    size = scale_to_budget(size, memoryBudget, needed);
+    if (size == 0) {
+      break;
+    }
+    needed = 0;
+    config = create_blocks_configuration(
+        features, featuresCount, bufferSize, size, samplingRate,
+        memoryBudget, &needed, &bounded);
+    if (config != nullptr && configuration_memory(config) > memoryBudget) {
+      // The block and the tail fit separately but not together
+      needed = configuration_memory(config);
+      delete config;
+      config = nullptr;
+    }
+    if (config != nullptr && config->Blocks) {
+      chosen = { EXTRACTION_PLAN_BLOCKS,
+                 static_cast<int>(config->Blocks->Count + 1),
+                 config->Tree->RootSize(), 0 };
+    }
+  }
+  if (config == nullptr && !bounded) {
+    EINA_LOG_WARN("Some of the features depend on the whole input, "
+                  "so it is split into the independent chunks\n");
+    auto current = CurrentExecutionOverrides();
+    ExecutionOverrides overrides;
+    if (current != nullptr) {
+      overrides = *current;
+    }
+    size = bufferSize;
+    needed = whole_needed;
+    while (config == nullptr && needed > 0) {
+      size = scale_to_budget(size, memoryBudget, needed);
+      if (size == 0) {
+        break;
+      }
+      // create_features_configuration() splits by get_chunk_size()
+      overrides.ChunkSize = size;
+      ScopedExecutionOverrides scope(&overrides);
+      needed = 0;
+      config = create_features_configuration(
+          features, featuresCount, bufferSize, samplingRate, false, 1,
+          false, SampleType::kInt16, false, memoryBudget, &needed);
+    }
+    if (config != nullptr) {
+      chosen = { EXTRACTION_PLAN_CHUNKS, config->Chunks,
+                 config->Tree->RootSize(), 0 };
+    }
+  }
+  if (config == nullptr) {
+    if (needed > 0) {
+      EINA_LOG_ERR("Error: the features do not fit into %zu bytes\n",
+                   memoryBudget);
+    }
+    return nullptr;
+  }
+  chosen.memory = configuration_memory(config);
+  EINA_LOG_INFO("Extraction plan: %s, %d x %zu samples, %zu bytes\n",
+                chosen.type == EXTRACTION_PLAN_WHOLE? "whole" :
+                chosen.type == EXTRACTION_PLAN_BLOCKS? "blocks" : "chunks",
+                chosen.count, chosen.size, chosen.memory);
+  if (plan != nullptr) {
+    *plan = chosen;
+  }
+  return config;
+}
+
+typedef std::unordered_map<std::string, std::shared_ptr<Buffers>> ResultsMap;
+/// @brief The results in the order of TransformTree::FeatureNames().
+typedef std::vector<std::shared_ptr<Buffers>> ResultsArray;
+
+/// @brief The number of the buffers of the feature in the results of
+/// the whole input.
+static size_t feature_rows(const FeaturesConfiguration *fc,
+                           const std::string& name, const Buffers& buffers) {
+  if (fc->Blocks) {
+    return fc->Blocks->Rows.find(name)->second;
+  }
+  return buffers.Count() * fc->Chunks;
+}
+
+/// @brief The description of the numbers which a buffer format consists of.
+struct ElementFormat {
+  /// The format string of the Arrow C data interface.
+  const char *Arrow;
+  /// The numpy array interface type string in the native byte order.
+  const char *NumPy;
+  size_t Size;
+};
+
+/// @brief Finds the format of the elements of the buffer format
+/// from its identifier, e.g. "float *" or "FixedArray<4, float>".
+/// @return nullptr if the elements are not numbers.
+static const ElementFormat *find_element_format(const std::string& id) {
+  std::string type = id;
+  if (type.compare(0, 11, "FixedArray<") == 0) {
+    type = type.substr(type.rfind(',') + 1);
+  }
+  while (!type.empty() &&
+         (type.back() == '*' || type.back() == '>' || type.back() == ' ')) {
+    type.pop_back();
+  }
+  while (!type.empty() && type.front() == ' ') {
+    type.erase(0, 1);
+  }
+  static const std::map<std::string, ElementFormat> formats {
+    { "float", { "f", "=f4", sizeof(float) } },
+    { "double", { "g", "=f8", sizeof(double) } },
+    { "short", { "s", "=i2", sizeof(int16_t) } },
+    { "int", { "i", "=i4", sizeof(int32_t) } },
+    { "long", { "l", "=i8", sizeof(int64_t) } },
+    { "unsigned char", { "C", "|u1", sizeof(uint8_t) } },
+    { "unsigned short", { "S", "=u2", sizeof(uint16_t) } },
+    { "unsigned int", { "I", "=u4", sizeof(uint32_t) } },
+    { "Float16", { "e", "=f2", sizeof(uint16_t) } }
+  };
+  auto it = formats.find(type);
+  if (it == formats.end()) {
+    return nullptr;
+  }
+  return &it->second;
+}
+
+/// @brief The formats of the elements of FeatureOutputType, starting from
+/// FEATURE_OUTPUT_INT16.
+static const ElementFormat kOutputFormats[] {
+  { "s", "=i2", sizeof(int16_t) },
+  { "i", "=i4", sizeof(int32_t) },
+  { "e", "=f2", sizeof(uint16_t) }
+};
+
+/// @brief The type which set_feature_output_type() set for the feature.
+static FeatureOutputType output_type(const FeaturesConfiguration *fc,
+                                     const std::string& name) {
+  auto it = fc->OutputTypes.find(name);
+  return it != fc->OutputTypes.end()? it->second : FEATURE_OUTPUT_NATIVE;
+}
+
+/// @brief The size of a buffer of floats after the conversion to type.
+static size_t converted_size(size_t size, FeatureOutputType type) {
+  if (type == FEATURE_OUTPUT_NATIVE) {
+    return size;
+  }
+  return size / sizeof(float) * kOutputFormats[type - 1].Size;
+}
+
+/// @brief The size of each buffer of the feature as it is fetched.
+static size_t fetched_size(const FeaturesConfiguration *fc,
+                           const std::string& name, const Buffers& buffers) {
+  return converted_size(buffers.Format()->UnalignedSizeInBytes(),
+                        output_type(fc, name));
+}
+
+/// @brief The format of the feature's elements as they are fetched.
+/// @return nullptr if the elements are not numbers.
+static const ElementFormat *fetched_element_format(
+    const FeaturesConfiguration *fc, const std::string& name,
+    const Buffers& buffers) {
+  auto type = output_type(fc, name);
+  if (type != FEATURE_OUTPUT_NATIVE) {
+    return &kOutputFormats[type - 1];
+  }
+  return find_element_format(buffers.Format()->Id());
+}
+
+static void convert_floats(const void* in, size_t length,
+                           FeatureOutputType type, char* out) {
+  auto floats = reinterpret_cast<const float*>(in);
+  switch (type) {
+    case FEATURE_OUTPUT_INT16:
+      FloatToInt16Raw::Convert(
+          floats, length, reinterpret_cast<int16_t*>(out));
+      break;
+    case FEATURE_OUTPUT_INT32:
+      FloatToInt32Raw::Convert(
+          floats, length, reinterpret_cast<int32_t*>(out));
+      break;
+    case FEATURE_OUTPUT_FLOAT16:
+      FloatToFloat16Raw::Convert(
+          floats, length, reinterpret_cast<Float16*>(out));
+      break;
+    default:
+      assert(false && "Unsupported feature output type");
+      break;
+  }
+}
+
+/// @brief Copies count buffers starting from first to the continuous
+/// output, converting their elements to type on the way.
+static void copy_buffers(const Buffers& buffers, size_t first, size_t count,
+                         FeatureOutputType type, char* output) {
+  if (count == 0) {
+    return;
+  }
+  size_t size_each = buffers.Format()->UnalignedSizeInBytes();
+  // Packed, see set_packed_results()
+  bool packed = buffers.Stride() == size_each;
+  if (type == FEATURE_OUTPUT_NATIVE) {
+    if (packed) {
+      memcpy(output, buffers[first], size_each * count);
+      return;
+    }
+    for (size_t k = 0; k < count; k++) {
+      memcpy(output + k * size_each, buffers[first + k], size_each);
+    }
+    return;
+  }
+  size_t length = size_each / sizeof(float);
+  size_t converted_each = converted_size(size_each, type);
+  if (packed) {
+    convert_floats(buffers[first], length * count, type, output);
+    return;
+  }
+  for (size_t k = 0; k < count; k++) {
+    convert_floats(buffers[first + k], length, type,
+                   output + k * converted_each);
+  }
+}
+
+/// @brief Copies the chunk's results of a feature to the continuous output,
+/// converting them to type (see set_feature_output_type()).
+static void copy_chunk(const Buffers& buffers, size_t chunk, void* output,
+                       FeatureOutputType type = FEATURE_OUTPUT_NATIVE) {
+  size_t size_each = converted_size(
+      buffers.Format()->UnalignedSizeInBytes(), type);
+  auto dest = reinterpret_cast<char *>(output) +
+      chunk * size_each * buffers.Count();
+  copy_buffers(buffers, 0, buffers.Count(), type, dest);
+}
+
+/// @brief Runs the tree on each chunk of the input and passes the results
+/// to write(). If parallel_chunks is set, the chunks are executed
+/// concurrently, so write() must only touch the memory of its own chunk.
+static bool execute_chunks(
+    const FeaturesConfiguration *fc, const void *buffer,
+    const std::function<void(size_t, const ResultsArray&)>& write,
+    const std::vector<std::string>* features = nullptr) {
+  // The chunks are measured in bytes to support any sample type
+  size_t step = fc->Tree->RootFormat()->UnalignedSizeInBytes();
+  auto input = reinterpret_cast<const char*>(buffer);
+  if (!parallel_chunks || fc->Chunks == 1) {
+    try {
+      ExecutionLease lease(fc);
+      for (int chunk = 0; chunk < fc->Chunks; chunk++) {
+        EINA_LOG_INFO("Evaluating [%d%%, %d%%]...",
+                      chunk * 100 / fc->Chunks,
+                      (chunk + 1) * 100 / fc->Chunks);
+        lease.Execute(input + chunk * step, features);
+        write(chunk, lease.IndexedResults());
+      }
+    }
+    catch(const ExecutionCancelledException&) {
+      EINA_LOG_INFO("The extraction was cancelled\n");
+      return false;
+    }
+    catch(const std::exception& ex) {
+      EINA_LOG_ERR("Caught an exception with message \"%s\".\n", ex.what());
+      return false;
+    }
+    return true;
+  }
+  std::atomic<bool> failed(false);
+  std::atomic<int> next_chunk(0);
+  auto work = [&]() {
+    // Each thread takes either the tree's own buffers or a separate context
+    std::unique_ptr<ExecutionLease> lease;
+    try {
+      lease = std::make_unique<ExecutionLease>(fc);
+    }
+    catch(const std::exception& ex) {
+      EINA_LOG_ERR("Failed to create the execution context. %s\n",
+                   ex.what());
+      failed = true;
+      return;
+    }
+    for (int chunk = next_chunk++; chunk < fc->Chunks && !failed;
+         chunk = next_chunk++) {
+      EINA_LOG_INFO("Evaluating chunk %d of %d...", chunk + 1, fc->Chunks);
+      try {
+        lease->Execute(input + chunk * step, features);
+        write(chunk, lease->IndexedResults());
+      }
+      catch(const ExecutionCancelledException&) {
+        failed = true;
+      }
+      catch(const std::exception& ex) {
+        EINA_LOG_ERR("Caught an exception with message \"%s\".\n",
+                     ex.what());
+        failed = true;
+      }
+    }
+  };
+  int threads = std::min(std::min(get_omp_transforms_max_threads_num(),
+                                   ThreadsGovernor::CurrentBudget()),
+                          fc->Chunks);
+  ThreadPool::TaskGroup tasks;
+  for (int i = 1; i < threads; i++) {
+    tasks.Spawn(work);
+  }
+  work();
+  tasks.Wait();
+  return !failed;
+}
+
+/// @brief Runs the trees of setup_features_extraction_blocks() on each
+/// block of the input and copies the rows which the block contributes
+/// to destinations.
+static bool execute_blocks(
+    const FeaturesConfiguration *fc, const int16_t *buffer,
+    const std::unordered_map<std::string, void*>& destinations,
+    const std::vector<std::string>* features = nullptr) {
+  auto& blocks = *fc->Blocks;
+  std::unordered_map<std::string, size_t> written;
+  // offset is the first contributed sample in the block, length is
+  // the number of the contributed samples or 0 if the block is the last
+  auto write = [&](const ResultsMap& retmap, size_t offset, size_t length) {
+    for (auto& res : retmap) {
+      auto destination = destinations.find(res.first);
+      if (destination == destinations.end()) {
+        continue;
+      }
+      size_t hop = blocks.Hops.find(res.first)->second;
+      size_t first = offset / hop;
+      size_t count = length > 0? length / hop : res.second->Count() - first;
+      size_t size_each = fetched_size(fc, res.first, *res.second);
+      auto& row = written[res.first];
+      auto dest = reinterpret_cast<char*>(destination->second) +
+          row * size_each;
+      copy_buffers(*res.second, first, count, output_type(fc, res.first),
+                   dest);
+      row += count;
+    }
+  };
+  try {
+    ExecutionLease lease(fc);
+    for (size_t block = 0; block < blocks.Count; block++) {
+      EINA_LOG_INFO("Evaluating block %zu of %zu...", block + 1,
+                    blocks.Count + 1);
+      size_t begin = blocks.BlockBegin(block);
+      write(lease.Execute(buffer + begin, features),
+            block * blocks.Step - begin, blocks.Step);
+    }
+    ExecutionLease tail(blocks.Tail.get());
+    size_t begin = blocks.BlockBegin(blocks.Count);
+    write(tail.Execute(buffer + begin, features),
+          blocks.Count * blocks.Step - begin, 0);
+  }
+  catch(const ExecutionCancelledException&) {
+    EINA_LOG_INFO("The extraction was cancelled\n");
+    return false;
+  }
+  catch(const std::exception& ex) {
+    EINA_LOG_ERR("Caught an exception with message \"%s\".\n", ex.what());
+    return false;
+  }
+  return true;
+}
+
+/// @brief Logs an error if the configuration does not take the samples of
+/// the specified type.
+static bool check_sample_type(const FeaturesConfiguration *fc,
+                              SampleType sampleType) {
+  if (fc->Tree->root_sample_type() != sampleType) {
+    EINA_LOG_ERR("Error: the configuration takes the samples of "
+                 "the other type\n");
+    return false;
+  }
+  return true;
+}
+
+/// @brief Passes the input to the recorder of start_traffic_recording().
+static void record_traffic(const FeaturesConfiguration *fc,
+                           SampleType sampleType, const void *buffer) {
+  auto recorder = std::atomic_load(&traffic_recorder);
+  if (!recorder) {
+    return;
+  }
+  size_t sample_size = sampleType == SampleType::kInt16?
+      sizeof(int16_t) : sizeof(int32_t);
+  recorder->Record(fc->Fingerprint, fc->Features, fc->SamplingRate,
+                   static_cast<int>(sampleType), fc->InputSize, buffer,
+                   fc->InputSize * sample_size);
+}
+
+/// @brief Creates the metrics of the configuration once. They are labeled
+/// with the hash of the features and the format, so that the same
+/// configuration created again continues the same series.
+static const ConfigurationMetrics& configuration_metrics(
+    const FeaturesConfiguration *fc) {
+  std::call_once(fc->MetersOnce, [fc] {
+    std::string description;
+    for (auto& feature : fc->Features) {
+      description += feature + '\n';
+    }
+    description += std::to_string(fc->InputSize) + ' ' +
+        std::to_string(fc->SamplingRate) + ' ' +
+        std::to_string(static_cast<int>(fc->Tree->root_sample_type()));
+    char label[40];
+    snprintf(label, sizeof(label), "configuration=\"%016llx\"",
+             static_cast<unsigned long long>(  // NOLINT(runtime/int)
+                 std::hash<std::string>()(description)));
+    auto& metrics = Metrics::Instance();
+    const char *results[] = { "ok", "error", "cancelled" };
+    for (int i = 0; i < 3; i++) {
+      fc->Meters.Extractions[i] = metrics.Counter(
+          "sfe_extractions", "The extractions of the configuration.",
+          std::string(label) + ",result=\"" + results[i] + '"');
+    }
+    fc->Meters.Latency = metrics.Histogram(
+        "sfe_extraction_seconds",
+        "The time of the extractions of the configuration.",
+        MetricsHistogram::LatencyBounds(), label);
+    fc->Meters.InputBytes = metrics.Counter(
+        "sfe_input_bytes", "The input processed by the configuration.",
+        label);
+  });
+  return fc->Meters;
+}
+
+static FeatureExtractionResult extract_typed_sound_features_unmetered(
+    const FeaturesConfiguration *fc, SampleType sampleType,
+    const void *buffer, char ***featureNames, void ***results,
+    int **resultLengths, int *featuresCount,
+    const std::vector<std::string>* features, int maxThreads) {
+  CHECK_NULL_RET(fc, FEATURE_EXTRACTION_RESULT_ERROR);
+  CHECK_NULL_RET(buffer, FEATURE_EXTRACTION_RESULT_ERROR);
+  CHECK_NULL_RET(results, FEATURE_EXTRACTION_RESULT_ERROR);
+  if (!check_sample_type(fc, sampleType)) {
+    return FEATURE_EXTRACTION_RESULT_ERROR;
+  }
+  if (fc->Streaming) {
+    EINA_LOG_ERR("Error: streaming configurations must be fed through "
+                 "push_samples()\n");
+    return FEATURE_EXTRACTION_RESULT_ERROR;
+  }
+  if (fc->BatchSize > 1) {
+    EINA_LOG_ERR("Error: batch configurations must be fed through "
+                 "extract_sound_features_batch()\n");
+    return FEATURE_EXTRACTION_RESULT_ERROR;
+  }
+  if (fc->Ragged) {
+    EINA_LOG_ERR("Error: ragged configurations must be fed through "
+                 "extract_sound_features_ragged()\n");
+    return FEATURE_EXTRACTION_RESULT_ERROR;
+  }
+  record_traffic(fc, sampleType, buffer);
+
+  fftf_set_openmp_num_threads(get_omp_transforms_max_threads_num());
+  EINA_LOG_DBG("OpenMP threads number is %d, SIMD is %s, FFTF backend is %d\n",
+               get_omp_transforms_max_threads_num(),
+               get_use_simd()? "enabled" : "disabled",
+               fftf_current_backend());
+  bool cacheable = features == nullptr && !fc->Fingerprint.empty() &&
+      results_cache.capacity() > 0;
+  size_t input_size = fc->Tree->RootFormat()->UnalignedSizeInBytes() *
+      fc->Chunks;
+  // The cached results are already converted
+  std::string cache_key = fc->Fingerprint;
+  for (auto& type : fc->OutputTypes) {
+    cache_key += '|' + type.first + '=' + std::to_string(type.second);
+  }
+  if (cacheable) {
+    auto entry = results_cache.Find(
+        cache_key, reinterpret_cast<const char*>(buffer), input_size);
+    if (entry) {
+      EINA_LOG_DBG("Reusing the cached results");
+      int count = entry->Results.size();
+      *featureNames = new char*[count];
+      *results = new void*[count];
+      *resultLengths = new int[count];
+      for (int i = 0; i < count; i++) {
+        auto& res = entry->Results[i];
+        copy_string(res.first, *featureNames + i);
+        (*resultLengths)[i] = res.second.size();
+        (*results)[i] = new char[res.second.size()];
+        memcpy((*results)[i], res.second.data(), res.second.size());
+      }
+      if (featuresCount != nullptr) {
+        *featuresCount = count;
+      }
+      return FEATURE_EXTRACTION_RESULT_OK;
+    }
+  }
+  std::unordered_map<std::string, std::shared_ptr<Buffers>> layout;
+  try {
+    layout = fc->Tree->FeatureBuffers();
+  }
+  catch(const std::exception& ex) {
+    EINA_LOG_ERR("Caught an exception with message \"%s\".\n", ex.what());
+    return FEATURE_EXTRACTION_RESULT_ERROR;
+  }
+  // The destinations are indexed the same as TransformTree::IndexedResults()
+  auto& names = fc->Tree->FeatureNames();
+  std::vector<void*> destinations(names.size(), nullptr);
+  std::vector<FeatureOutputType> types(names.size(), FEATURE_OUTPUT_NATIVE);
+  std::vector<size_t> selected;
+  if (features != nullptr) {
+    std::unordered_map<std::string, size_t> indices;
+    for (size_t i = 0; i < names.size(); i++) {
+      indices.emplace(names[i], i);
+    }
+    for (auto& name : *features) {
+      auto it = indices.find(name);
+      if (it == indices.end()) {
+        EINA_LOG_ERR("Error: feature \"%s\" does not exist\n", name.c_str());
+        return FEATURE_EXTRACTION_RESULT_ERROR;
+      }
+      selected.push_back(it->second);
+    }
+    std::sort(selected.begin(), selected.end());
+    selected.erase(std::unique(selected.begin(), selected.end()),
+                   selected.end());
+  } else {
+    for (size_t i = 0; i < names.size(); i++) {
+      selected.push_back(i);
+    }
+  }
+  *featureNames = new char*[selected.size()];
+  *results = new void*[selected.size()];
+  *resultLengths = new int[selected.size()];
+  int j = 0;
+  for (auto i : selected) {
+    auto& buffers = *layout.find(names[i])->second;
+    copy_string(names[i], *featureNames + j);
+    types[i] = output_type(fc, names[i]);
+    size_t size = fetched_size(fc, names[i], buffers) *
+        feature_rows(fc, names[i], buffers);
+    assert(size > 0);
+    (*resultLengths)[j] = size;
+    (*results)[j] = new char[size];
+    destinations[i] = (*results)[j];
+    j++;
+  }
+  ThreadsGovernor::Lease lease(maxThreads);
+  CancellationToken cancellation(&fc->Cancellation,
+                                 std::chrono::milliseconds(fc->TimeoutMs));
+  bool ok;
+  if (fc->Blocks) {
+    std::unordered_map<std::string, void*> blocks;
+    for (auto i : selected) {
+      blocks[names[i]] = destinations[i];
+    }
+    ok = execute_blocks(fc, reinterpret_cast<const int16_t*>(buffer),
+                        blocks, features);
+  } else {
+    ok = execute_chunks(
+        fc, buffer, [&](size_t chunk, const ResultsArray& retarr) {
+      for (auto i : selected) {
+        copy_chunk(*retarr[i], chunk, destinations[i], types[i]);
+      }
+    }, features);
+  }
+  if (!ok) {
+    free_results(selected.size(), *featureNames, *results, *resultLengths);
+    *featureNames = nullptr;
+    *results = nullptr;
+    *resultLengths = nullptr;
+    return ExecutionCancelled()? FEATURE_EXTRACTION_RESULT_CANCELLED :
+                                 FEATURE_EXTRACTION_RESULT_ERROR;
+  }
+  if (cacheable) {
+    auto entry = std::make_shared<ResultsCache::Entry>();
+    auto input = reinterpret_cast<const char*>(buffer);
+    entry->Input.assign(input, input + input_size);
+    for (int i = 0; i < static_cast<int>(selected.size()); i++) {
+      auto result = reinterpret_cast<const char*>((*results)[i]);
+      entry->Results.emplace_back(
+          (*featureNames)[i],
+          std::vector<char>(result, result + (*resultLengths)[i]));
+    }
+    entry->Inserted = std::chrono::steady_clock::now();
+    results_cache.Insert(cache_key, entry);
+  }
+  if (featuresCount != nullptr) {
+    *featuresCount = selected.size();
+  }
+  return FEATURE_EXTRACTION_RESULT_OK;
+}
+
+static FeatureExtractionResult extract_typed_sound_features(
+    const FeaturesConfiguration *fc, SampleType sampleType,
+    const void *buffer, char ***featureNames, void ***results,
+    int **resultLengths, int *featuresCount = nullptr,
+    const std::vector<std::string>* features = nullptr, int maxThreads = 0) {
+  auto start = std::chrono::steady_clock::now();
+  auto result = extract_typed_sound_features_unmetered(
+      fc, sampleType, buffer, featureNames, results, resultLengths,
+      featuresCount, features, maxThreads);
+  if (fc == nullptr) {
+    return result;
+  }
+  auto& meters = configuration_metrics(fc);
+  meters.Extractions[result]->Increment();
+  if (result == FEATURE_EXTRACTION_RESULT_OK) {
+    meters.Latency->Observe(std::chrono::duration_cast<
+        std::chrono::duration<double>>(
+            std::chrono::steady_clock::now() - start).count());
+    meters.InputBytes->Increment(
+        fc->InputSize * (sampleType == SampleType::kInt16?
+                         sizeof(int16_t) : sizeof(int32_t)));
+  }
+  return result;
+}
+
+FeatureExtractionResult extract_sound_features(
+    const FeaturesConfiguration *fc, int16_t *buffer,
+    char ***featureNames, void ***results, int **resultLengths) {
+  return extract_typed_sound_features(fc, SampleType::kInt16, buffer,
+                                      featureNames, results, resultLengths);
+}
+
+FeatureExtractionResult extract_sound_features_threads(
+    const FeaturesConfiguration *fc, int16_t *buffer, int maxThreads,
+    char ***featureNames, void ***results, int **resultLengths) {
+  return extract_typed_sound_features(fc, SampleType::kInt16, buffer,
+                                      featureNames, results, resultLengths,
+                                      nullptr, nullptr, maxThreads);
+}
+
+FeatureExtractionResult extract_sound_features_subset(
+    const FeaturesConfiguration *fc, int16_t *buffer,
+    const char *const *features, int featuresCount,
+    char ***featureNames, void ***results, int **resultLengths) {
+  CHECK_NULL_RET(features, FEATURE_EXTRACTION_RESULT_ERROR);
+  std::vector<std::string> subset;
+  for (int i = 0; i < featuresCount; i++) {
+    CHECK_NULL_RET(features[i], FEATURE_EXTRACTION_RESULT_ERROR);
+    subset.push_back(features[i]);
+  }
+  return extract_typed_sound_features(fc, SampleType::kInt16, buffer,
+                                      featureNames, results, resultLengths,
+                                      nullptr, &subset);
+}
+
+FeatureExtractionResult extract_sound_features_sink(
+    const FeaturesConfiguration *fc, int16_t *buffer, FeatureSink sink,
+    void *userData) {
+  CHECK_NULL_RET(fc, FEATURE_EXTRACTION_RESULT_ERROR);
+  CHECK_NULL_RET(buffer, FEATURE_EXTRACTION_RESULT_ERROR);
+  CHECK_NULL_RET(sink, FEATURE_EXTRACTION_RESULT_ERROR);
+  if (!check_sample_type(fc, SampleType::kInt16)) {
+    return FEATURE_EXTRACTION_RESULT_ERROR;
+  }
+  if (fc->Streaming || fc->BatchSize > 1 || fc->Ragged || fc->Blocks) {
+    EINA_LOG_ERR("Error: the streaming, batch, ragged and block "
+                 "configurations do not support the sinks\n");
+    return FEATURE_EXTRACTION_RESULT_ERROR;
+  }
+  record_traffic(fc, SampleType::kInt16, buffer);
+  fftf_set_openmp_num_threads(get_omp_transforms_max_threads_num());
+  CancellationToken cancellation(&fc->Cancellation,
+                                 std::chrono::milliseconds(fc->TimeoutMs));
+  size_t step = fc->Tree->RootFormat()->UnalignedSizeInBytes();
+  auto input = reinterpret_cast<const char*>(buffer);
+  try {
+    ExecutionLease lease(fc);
+    for (int chunk = 0; chunk < fc->Chunks; chunk++) {
+      lease.set_feature_sink([&](const std::string& name,
+                                 const Buffers& buffers) {
+        size_t size_each = buffers.Format()->UnalignedSizeInBytes();
+        auto type = output_type(fc, name);
+        size_t size = converted_size(size_each, type) * buffers.Count();
+        if (buffers.Count() > 0 && buffers.Stride() == size_each &&
+            type == FEATURE_OUTPUT_NATIVE) {
+          // Packed, see set_packed_results()
+          sink(name.c_str(), buffers[0], size, chunk, userData);
+          return;
+        }
+        // The sinks of the concurrent nodes pack on their own threads
+        thread_local std::vector<char> packed;
+        packed.resize(size);
+        copy_chunk(buffers, 0, packed.data(), type);
+        sink(name.c_str(), packed.data(), size, chunk, userData);
+      });
+      lease.Execute(input + chunk * step);
+    }
+  }
+  catch(const ExecutionCancelledException&) {
+    EINA_LOG_INFO("The extraction was cancelled\n");
+    return FEATURE_EXTRACTION_RESULT_ERROR;
+  }
+  catch(const std::exception& ex) {
+    EINA_LOG_ERR("Caught an exception with message \"%s\".\n", ex.what());
+    return FEATURE_EXTRACTION_RESULT_ERROR;
+  }
+  return FEATURE_EXTRACTION_RESULT_OK;
+}
+
+bool set_feature_priority(FeaturesConfiguration *fc, const char *feature,
+                          int priority) {
+  CHECK_NULL_RET(fc, false);
+  CHECK_NULL_RET(feature, false);
+  auto layout = fc->Tree->FeatureBuffers();
+  if (layout.find(feature) == layout.end()) {
+    EINA_LOG_ERR("Error: feature \"%s\" does not exist\n", feature);
+    return false;
+  }
+  fc->Priorities[feature] = priority;
+  return true;
+}
+
+bool set_feature_output_type(FeaturesConfiguration *fc, const char *feature,
+                             FeatureOutputType type) {
+  CHECK_NULL_RET(fc, false);
+  CHECK_NULL_RET(feature, false);
+  if (type < FEATURE_OUTPUT_NATIVE || type > FEATURE_OUTPUT_FLOAT16) {
+    EINA_LOG_ERR("Error: invalid feature output type %d\n", type);
+    return false;
+  }
+  auto layout = fc->Tree->FeatureBuffers();
+  auto it = layout.find(feature);
+  if (it == layout.end()) {
+    EINA_LOG_ERR("Error: feature \"%s\" does not exist\n", feature);
+    return false;
+  }
+  auto& format = *it->second->Format();
+  auto element = find_element_format(format.Id());
+  if (element == nullptr || strcmp(element->Arrow, "f") != 0 ||
+      format.UnalignedSizeInBytes() % sizeof(float) != 0) {
+    EINA_LOG_ERR("Error: the elements of feature \"%s\" are not floats\n",
+                 feature);
+    return false;
+  }
+  if (type == FEATURE_OUTPUT_NATIVE) {
+    fc->OutputTypes.erase(feature);
+  } else {
+    fc->OutputTypes[feature] = type;
+  }
+  return true;
+}
+
+bool set_transform_parameter(FeaturesConfiguration *fc, const char *feature,
+                             const char *transform, const char *name,
+                             const char *value) {
+  CHECK_NULL_RET(fc, false);
+  CHECK_NULL_RET(feature, false);
+  CHECK_NULL_RET(transform, false);
+  CHECK_NULL_RET(name, false);
+  CHECK_NULL_RET(value, false);
+  if (fc->Batcher) {
+    EINA_LOG_ERR("Error: the parameters of a configuration with dynamic "
+                 "batching cannot be changed\n");
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(*fc->TreeMutex);
+  if (fc->Cached) {
+    if (!prepared_trees_cache.Detach(fc->Fingerprint, fc->Tree)) {
+      EINA_LOG_ERR("Error: the prepared tree is shared with other "
+                   "configurations\n");
+      return false;
+    }
+    fc->Cached = false;
+  }
+  try {
+    fc->Tree->SetTransformParameter(feature, transform, name, value);
+  }
+  catch(const std::exception& ex) {
+    EINA_LOG_ERR("Error: failed to set %s.%s of \"%s\". %s\n", transform,
+                 name, feature, ex.what());
+    return false;
+  }
+  // The results no longer depend only on the features and the input
+  fc->Fingerprint.clear();
+  return true;
+}
+
+FeatureExtractionResult extract_sound_features_deadline(
+    const FeaturesConfiguration *fc, int16_t *buffer, int budgetUs,
+    char ***featureNames, void ***results, int **resultLengths,
+    int *featuresCount, char ***skippedNames, int *skippedCount) {
+  CHECK_NULL_RET(fc, FEATURE_EXTRACTION_RESULT_ERROR);
+  CHECK_NULL_RET(featuresCount, FEATURE_EXTRACTION_RESULT_ERROR);
+  CHECK_NULL_RET(skippedNames, FEATURE_EXTRACTION_RESULT_ERROR);
+  CHECK_NULL_RET(skippedCount, FEATURE_EXTRACTION_RESULT_ERROR);
+  if (budgetUs < 0) {
+    EINA_LOG_ERR("Error: budgetUs is negative (%i)\n", budgetUs);
+    return FEATURE_EXTRACTION_RESULT_ERROR;
+  }
+  // The higher priorities go first, the equal ones are ordered by name
+  std::vector<std::pair<int, std::string>> order;
+  for (auto& res : fc->Tree->FeatureBuffers()) {
+    auto priority = fc->Priorities.find(res.first);
+    order.emplace_back(
+        priority != fc->Priorities.end()? -priority->second : 0, res.first);
+  }
+  std::sort(order.begin(), order.end());
+  std::vector<std::string> priorities;
+  for (auto& item : order) {
+    priorities.push_back(item.second);
+  }
+  std::vector<std::string> selected, skipped;
+  try {
+    // Each chunk is a separate execution of the tree
+    selected = fc->Tree->SelectFeatures(
+        priorities, std::chrono::microseconds(budgetUs) / fc->Chunks,
+        &skipped);
+  }
+  catch(const std::exception& ex) {
+    EINA_LOG_ERR("Caught an exception with message \"%s\".\n", ex.what());
+    return FEATURE_EXTRACTION_RESULT_ERROR;
+  }
+  auto result = extract_typed_sound_features(
+      fc, SampleType::kInt16, buffer, featureNames, results, resultLengths,
+      featuresCount, &selected);
+  if (result != FEATURE_EXTRACTION_RESULT_OK) {
+    return result;
+  }
+  *skippedCount = skipped.size();
+  *skippedNames = nullptr;
+  if (!skipped.empty()) {
+    *skippedNames = new char*[skipped.size()];
+    for (size_t i = 0; i < skipped.size(); i++) {
+      copy_string(skipped[i], *skippedNames + i);
+    }
+  }
+  return FEATURE_EXTRACTION_RESULT_OK;
+}
+
+FeatureExtractionResult extract_sound_features_int32(
+    const FeaturesConfiguration *fc, const int32_t *buffer,
+    char ***featureNames, void ***results, int **resultLengths) {
+  return extract_typed_sound_features(fc, SampleType::kInt32, buffer,
+                                      featureNames, results, resultLengths);
+}
+
+FeatureExtractionResult extract_sound_features_float(
+    const FeaturesConfiguration *fc, const float *buffer,
+    char ***featureNames, void ***results, int **resultLengths) {
+  return extract_typed_sound_features(fc, SampleType::kFloat, buffer,
+                                      featureNames, results, resultLengths);
+}
+
+/// @brief Passes the results of an asynchronous extraction to its callback
+/// and lets destroy_features_configuration() proceed after the last one.
+static void complete_async(const FeaturesConfiguration *fc,
+                           FeaturesCallback callback, void *userData,
+                           FeatureExtractionResult result, int featuresCount,
+                           char **featureNames, void **results,
+                           int *resultLengths) {
+  pending_extractions--;
+  callback(result, featuresCount, featureNames, results, resultLengths,
+           userData);
+  // The callback may destroy the other configurations, but not this one
+  std::lock_guard<std::mutex> lock(fc->AsyncMutex);
+  if (--fc->AsyncPending == 0) {
+    fc->AsyncFinished.notify_all();
+  }
+}
+
+FeatureExtractionResult extract_sound_features_async(
+    const FeaturesConfiguration *fc, int16_t *buffer,
+    FeaturesCallback callback, void *userData) {
+  CHECK_NULL_RET(fc, FEATURE_EXTRACTION_RESULT_ERROR);
+  CHECK_NULL_RET(buffer, FEATURE_EXTRACTION_RESULT_ERROR);
+  CHECK_NULL_RET(callback, FEATURE_EXTRACTION_RESULT_ERROR);
+  if (++pending_extractions > max_pending_extractions) {
+    pending_extractions--;
+    EINA_LOG_ERR("Error: %d extractions are already queued\n",
+                 max_pending_extractions.load());
+    return FEATURE_EXTRACTION_RESULT_ERROR;
+  }
+  {
+    std::lock_guard<std::mutex> lock(fc->AsyncMutex);
+    fc->AsyncPending++;
+  }
+  if (fc->Batcher) {
+    fc->Batcher->Add(buffer, callback, userData);
+    return FEATURE_EXTRACTION_RESULT_OK;
+  }
+  ThreadPool::Instance().Submit([fc, buffer, callback, userData] {
+    char **featureNames = nullptr;
+    void **results = nullptr;
+    int *resultLengths = nullptr;
+    int featuresCount = 0;
+    auto result = extract_typed_sound_features(
+        fc, SampleType::kInt16, buffer, &featureNames, &results,
+        &resultLengths, &featuresCount);
+    complete_async(fc, callback, userData, result, featuresCount,
+                   featureNames, results, resultLengths);
+  });
+  return FEATURE_EXTRACTION_RESULT_OK;
+}
+
+static void finish_request(FeatureExtractionResult result, int,
+                           char **featureNames, void **results,
+                           int *resultLengths, void *userData) {
+  auto request = reinterpret_cast<ExtractionRequest*>(userData);
+  std::lock_guard<std::mutex> lock(request->Mutex);
+  request->Result = result;
+  request->FeatureNames = featureNames;
+  request->Results = results;
+  request->ResultLengths = resultLengths;
+  request->Done = true;
+  request->Finished.notify_all();
+}
+
+ExtractionRequest *submit_sound_features(
+    const FeaturesConfiguration *fc, int16_t *buffer) {
+  auto request = new ExtractionRequest();
+  if (extract_sound_features_async(fc, buffer, finish_request, request) !=
+      FEATURE_EXTRACTION_RESULT_OK) {
+    delete request;
+    return nullptr;
+  }
+  return request;
+}
+
+bool poll_extraction(const ExtractionRequest *request) {
+  CHECK_NULL_RET(request, false);
+  std::lock_guard<std::mutex> lock(request->Mutex);
+  return request->Done;
+}
+
+FeatureExtractionResult finish_extraction(
+    ExtractionRequest *request, char ***featureNames, void ***results,
+    int **resultLengths) {
+  CHECK_NULL_RET(request, FEATURE_EXTRACTION_RESULT_ERROR);
+  CHECK_NULL_RET(featureNames, FEATURE_EXTRACTION_RESULT_ERROR);
+  CHECK_NULL_RET(results, FEATURE_EXTRACTION_RESULT_ERROR);
+  CHECK_NULL_RET(resultLengths, FEATURE_EXTRACTION_RESULT_ERROR);
+  {
+    std::unique_lock<std::mutex> lock(request->Mutex);
+    request->Finished.wait(lock, [request] { return request->Done; });
+  }
+  auto result = request->Result;
+  *featureNames = request->FeatureNames;
+  *results = request->Results;
+  *resultLengths = request->ResultLengths;
+  delete request;
+  return result;
+}
+
+void query_features_layout(const FeaturesConfiguration *fc,
+                           char ***featureNames, int **resultLengths,
+                           int *featuresCount) {
+  CHECK_NULL(fc);
+  CHECK_NULL(featureNames);
+  CHECK_NULL(resultLengths);
+  CHECK_NULL(featuresCount);
+
+  auto buffers = fc->Tree->FeatureBuffers();
+  std::map<std::string, std::shared_ptr<Buffers>> sorted(buffers.begin(),
+                                                         buffers.end());
+  *featuresCount = sorted.size();
+  *featureNames = new char*[sorted.size()];
+  *resultLengths = new int[sorted.size()];
+  int j = 0;
+  for (auto& res : sorted) {
+    copy_string(res.first, *featureNames + j);
+    (*resultLengths)[j] = fetched_size(fc, res.first, *res.second) *
+        feature_rows(fc, res.first, *res.second);
+    j++;
+  }
+}
+
+void query_features_dtypes(const FeaturesConfiguration *fc, char ***dtypes,
+                           int **shapes, int *featuresCount) {
+  CHECK_NULL(fc);
+  CHECK_NULL(dtypes);
+  CHECK_NULL(shapes);
+  CHECK_NULL(featuresCount);
+
+  auto buffers = fc->Tree->FeatureBuffers();
+  std::map<std::string, std::shared_ptr<Buffers>> sorted(buffers.begin(),
+                                                         buffers.end());
+  *featuresCount = sorted.size();
+  *dtypes = new char*[sorted.size()];
+  *shapes = new int[sorted.size() * 2];
+  int j = 0;
+  for (auto& res : sorted) {
+    size_t size_each = fetched_size(fc, res.first, *res.second);
+    auto element = fetched_element_format(fc, res.first, *res.second);
+    if (element == nullptr || size_each % element->Size != 0) {
+      // Opaque records of size_each bytes
+      copy_string("|V" + std::to_string(size_each), *dtypes + j);
+      (*shapes)[j * 2 + 1] = 1;
+    } else {
+      copy_string(element->NumPy, *dtypes + j);
+      (*shapes)[j * 2 + 1] = size_each / element->Size;
+    }
+    (*shapes)[j * 2] = feature_rows(fc, res.first, *res.second);
+    j++;
+  }
+}
+
+FeatureExtractionResult extract_sound_features_into(
+    const FeaturesConfiguration *fc, int16_t *buffer, void *const *outputs) {
+  CHECK_NULL_RET(fc, FEATURE_EXTRACTION_RESULT_ERROR);
+  CHECK_NULL_RET(buffer, FEATURE_EXTRACTION_RESULT_ERROR);
+  CHECK_NULL_RET(outputs, FEATURE_EXTRACTION_RESULT_ERROR);
+  if (!check_sample_type(fc, SampleType::kInt16)) {
+    return FEATURE_EXTRACTION_RESULT_ERROR;
+  }
+  if (fc->Streaming || fc->BatchSize > 1) {
+    EINA_LOG_ERR("Error: the configuration was not created by "
+                 "setup_features_extraction()\n");
+    return FEATURE_EXTRACTION_RESULT_ERROR;
+  }
+
+  fftf_set_openmp_num_threads(get_omp_transforms_max_threads_num());
+  // outputs are in the same order as in query_features_layout(),
+  // destinations are indexed the same as TransformTree::IndexedResults()
+  auto& names = fc->Tree->FeatureNames();
+  std::map<std::string, size_t> sorted;
+  for (size_t i = 0; i < names.size(); i++) {
+    sorted.emplace(names[i], i);
+  }
+  std::vector<void*> destinations(names.size());
+  std::vector<FeatureOutputType> types(names.size());
+  int j = 0;
+  for (auto& name : sorted) {
+    CHECK_NULL_RET(outputs[j], FEATURE_EXTRACTION_RESULT_ERROR);
+    destinations[name.second] = outputs[j++];
+    types[name.second] = output_type(fc, name.first);
+  }
+  CancellationToken cancellation(&fc->Cancellation,
+                                 std::chrono::milliseconds(fc->TimeoutMs));
+  bool ok;
+  if (fc->Blocks) {
+    std::unordered_map<std::string, void*> blocks;
+    for (auto& name : sorted) {
+      blocks[name.first] = destinations[name.second];
+    }
+    ok = execute_blocks(fc, buffer, blocks);
+  } else {
+    ok = execute_chunks(
+        fc, buffer, [&](size_t chunk, const ResultsArray& retarr) {
+      for (size_t i = 0; i < retarr.size(); i++) {
+        copy_chunk(*retarr[i], chunk, destinations[i], types[i]);
+      }
+    });
+  }
+  if (!ok) {
+    return ExecutionCancelled()? FEATURE_EXTRACTION_RESULT_CANCELLED :
+                                 FEATURE_EXTRACTION_RESULT_ERROR;
+  }
+  return FEATURE_EXTRACTION_RESULT_OK;
+}
+
+FeatureStore *open_feature_store(const char *fileName,
+                                 FeatureStoreCodecType codec, int chunkRows) {
+  CHECK_NULL_RET(fileName, nullptr);
+  if (codec < FEATURE_STORE_CODEC_NONE || codec > FEATURE_STORE_CODEC_LZ4) {
+    EINA_LOG_ERR("Error: invalid feature store codec %d\n", codec);
+    return nullptr;
+  }
+  if (chunkRows <= 0) {
+    EINA_LOG_ERR("Error: chunkRows must be positive (%d)\n", chunkRows);
+    return nullptr;
+  }
+  auto store = new FeatureStore();
+  try {
+    store->Writer = std::make_unique<FeatureStoreWriter>(
+        fileName, static_cast<FeatureStoreCodec>(codec), chunkRows);
+  }
+  catch(const std::exception& ex) {
+    EINA_LOG_ERR("Failed to open the feature store. %s\n", ex.what());
+    delete store;
+    return nullptr;
+  }
+  return store;
+}
+
+FeatureExtractionResult extract_sound_features_to_store(
+    const FeaturesConfiguration *fc, int16_t *buffer, FeatureStore *store) {
+  CHECK_NULL_RET(fc, FEATURE_EXTRACTION_RESULT_ERROR);
+  CHECK_NULL_RET(buffer, FEATURE_EXTRACTION_RESULT_ERROR);
+  CHECK_NULL_RET(store, FEATURE_EXTRACTION_RESULT_ERROR);
+  if (!check_sample_type(fc, SampleType::kInt16)) {
+    return FEATURE_EXTRACTION_RESULT_ERROR;
+  }
+  if (fc->Streaming || fc->BatchSize > 1 || fc->Blocks) {
+    EINA_LOG_ERR("Error: the configuration was not created by "
+                 "setup_features_extraction()\n");
+    return FEATURE_EXTRACTION_RESULT_ERROR;
+  }
+
+  fftf_set_openmp_num_threads(get_omp_transforms_max_threads_num());
+  auto& writer = *store->Writer;
+  auto append = [&writer](const std::string& name, const Buffers& buffers) {
+    writer.Append(name, buffers.Data(),
+                  buffers.Format()->UnalignedSizeInBytes(), buffers.Stride(),
+                  buffers.Count());
+  };
+  // The concurrent chunks may finish in any order, so the early ones are
+  // copied aside until all the previous chunks are appended
+  typedef std::map<std::string, std::pair<size_t, std::vector<char>>>
+      ChunkCopy;
+  std::vector<std::unique_ptr<ChunkCopy>> finished(fc->Chunks);
+  // The features are appended in the order of their names
+  auto& names = fc->Tree->FeatureNames();
+  std::map<std::string, size_t> sorted;
+  for (size_t i = 0; i < names.size(); i++) {
+    sorted.emplace(names[i], i);
+  }
+  int next_chunk = 0;
+  std::mutex mutex;
+  bool ok = execute_chunks(
+      fc, buffer, [&](size_t chunk, const ResultsArray& retarr) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (static_cast<int>(chunk) != next_chunk) {
+      finished[chunk] = std::make_unique<ChunkCopy>();
+      for (auto& name : sorted) {
+        auto& res = *retarr[name.second];
+        size_t size_each = res.Format()->UnalignedSizeInBytes();
+        auto& copy = (*finished[chunk])[name.first];
+        copy.first = size_each;
+        copy.second.resize(size_each * res.Count());
+        copy_chunk(res, 0, copy.second.data());
+      }
+      return;
+    }
+    for (auto& name : sorted) {
+      append(name.first, *retarr[name.second]);
+    }
+    for (next_chunk++;
+         next_chunk < fc->Chunks && finished[next_chunk]; next_chunk++) {
+      for (auto& res : *finished[next_chunk]) {
+        writer.Append(res.first, res.second.second.data(), res.second.first,
+                      res.second.first,
+                      res.second.second.size() / res.second.first);
+      }
+      finished[next_chunk].reset();
+    }
+  });
+  return ok? FEATURE_EXTRACTION_RESULT_OK : FEATURE_EXTRACTION_RESULT_ERROR;
+}
+
+bool close_feature_store(FeatureStore *store) {
+  CHECK_NULL_RET(store, false);
+  bool ok = store->Writer->Close();
+  if (!ok) {
+    EINA_LOG_ERR("Error: failed to write the feature store\n");
+  }
+  delete store;
+  return ok;
+}
+
+/// @brief The private data of the exported ArrowSchema.
+struct ArrowSchemaData {
+  std::string Format;
+  std::string Name;
+  std::vector<ArrowSchema*> Children;
+};
+
+/// @brief The private data of the exported ArrowArray. The children share
+/// the values, so that the consumer may move them out independently.
+struct ArrowArrayData {
+  std::shared_ptr<void> Values;
+  std::vector<const void*> Buffers;
+  std::vector<ArrowArray*> Children;
+};
+
+static void release_arrow_schema(ArrowSchema *schema) {
+  auto data = reinterpret_cast<ArrowSchemaData*>(schema->private_data);
+  for (auto child : data->Children) {
+    if (child->release != nullptr) {
+      child->release(child);
+    }
+    delete child;
+  }
+  delete data;
+  schema->release = nullptr;
+}
+
+static void release_arrow_array(ArrowArray *array) {
+  auto data = reinterpret_cast<ArrowArrayData*>(array->private_data);
+  for (auto child : data->Children) {
+    if (child->release != nullptr) {
+      child->release(child);
+    }
+    delete child;
+  }
+  delete data;
+  array->release = nullptr;
+}
+
+static void init_arrow_schema(const std::string& format,
+                              const std::string& name,
+                              ArrowSchema *child, ArrowSchema *schema) {
+  auto data = new ArrowSchemaData();
+  data->Format = format;
+  data->Name = name;
+  if (child != nullptr) {
+    data->Children.push_back(child);
+  }
+  schema->format = data->Format.c_str();
+  schema->name = data->Name.c_str();
+  schema->metadata = nullptr;
+  schema->flags = 0;
+  schema->n_children = data->Children.size();
+  schema->children = data->Children.data();
+  schema->dictionary = nullptr;
+  schema->release = release_arrow_schema;
+  schema->private_data = data;
+}
+
+/// @brief If values is not null, the array has the single values buffer,
+/// otherwise it has the single child.
+static void init_arrow_array(int64_t length,
+                             const std::shared_ptr<void>& values,
+                             ArrowArray *child, ArrowArray *array) {
+  auto data = new ArrowArrayData();
+  data->Values = values;
+  // No validity bitmap: the features never have nulls
+  data->Buffers.push_back(nullptr);
+  if (child != nullptr) {
+    data->Children.push_back(child);
+  } else {
+    data->Buffers.push_back(values.get());
+  }
+  array->length = length;
+  array->null_count = 0;
+  array->offset = 0;
+  array->n_buffers = data->Buffers.size();
+  array->n_children = data->Children.size();
+  array->buffers = data->Buffers.data();
+  array->children = data->Children.data();
+  array->dictionary = nullptr;
+  array->release = release_arrow_array;
+  array->private_data = data;
+}
+
+FeatureExtractionResult extract_sound_features_arrow(
+    const FeaturesConfiguration *fc, int16_t *buffer,
+    ArrowSchema *schemas, ArrowArray *arrays) {
+  CHECK_NULL_RET(fc, FEATURE_EXTRACTION_RESULT_ERROR);
+  CHECK_NULL_RET(buffer, FEATURE_EXTRACTION_RESULT_ERROR);
+  CHECK_NULL_RET(schemas, FEATURE_EXTRACTION_RESULT_ERROR);
+  CHECK_NULL_RET(arrays, FEATURE_EXTRACTION_RESULT_ERROR);
+
+  auto layout = fc->Tree->FeatureBuffers();
+  // The same order as in query_features_layout()
+  std::map<std::string, std::shared_ptr<Buffers>> sorted(layout.begin(),
+                                                         layout.end());
+  std::vector<std::shared_ptr<void>> values;
+  std::vector<void*> outputs;
+  for (auto& res : sorted) {
+    size_t size = fetched_size(fc, res.first, *res.second) *
+        feature_rows(fc, res.first, *res.second);
+    // Arrow recommends 64-byte aligned buffers
+    void *ptr = nullptr;
+    if (posix_memalign(&ptr, 64, size) != 0) {
+      EINA_LOG_ERR("Error: failed to allocate %zu bytes\n", size);
+      return FEATURE_EXTRACTION_RESULT_ERROR;
+    }
+    values.emplace_back(ptr, std::free);
+    outputs.push_back(ptr);
+  }
+  auto result = extract_sound_features_into(fc, buffer, outputs.data());
+  if (result != FEATURE_EXTRACTION_RESULT_OK) {
+    return result;
+  }
+  int j = 0;
+  for (auto& res : sorted) {
+    size_t size_each = fetched_size(fc, res.first, *res.second);
+    int64_t rows = feature_rows(fc, res.first, *res.second);
+    auto element = fetched_element_format(fc, res.first, *res.second);
+    if (element == nullptr || size_each % element->Size != 0) {
+      init_arrow_schema("w:" + std::to_string(size_each), res.first,
+                        nullptr, &schemas[j]);
+      init_arrow_array(rows, values[j], nullptr, &arrays[j]);
+    } else if (size_each == element->Size) {
+      init_arrow_schema(element->Arrow, res.first, nullptr, &schemas[j]);
+      init_arrow_array(rows, values[j], nullptr, &arrays[j]);
+    } else {
+      size_t elements = size_each / element->Size;
+      auto child_schema = new ArrowSchema();
+      init_arrow_schema(element->Arrow, "item", nullptr, child_schema);
+      init_arrow_schema("+w:" + std::to_string(elements), res.first,
+                        child_schema, &schemas[j]);
+      auto child_array = new ArrowArray();
+      init_arrow_array(rows * elements, values[j], nullptr, child_array);
+      init_arrow_array(rows, values[j], child_array, &arrays[j]);
+    }
+    j++;
+  }
+  return FEATURE_EXTRACTION_RESULT_OK;
+}
+
+FeatureExtractionResult extract_sound_features_views(
+    FeaturesConfiguration *fc, int16_t *buffer, const FeatureView **views,
+    int *viewsCount) {
+  CHECK_NULL_RET(fc, FEATURE_EXTRACTION_RESULT_ERROR);
+  CHECK_NULL_RET(buffer, FEATURE_EXTRACTION_RESULT_ERROR);
+  CHECK_NULL_RET(views, FEATURE_EXTRACTION_RESULT_ERROR);
+  CHECK_NULL_RET(viewsCount, FEATURE_EXTRACTION_RESULT_ERROR);
+  if (!check_sample_type(fc, SampleType::kInt16)) {
+    return FEATURE_EXTRACTION_RESULT_ERROR;
+  }
+  if (fc->Streaming || fc->Chunks > 1 || fc->Blocks) {
+    EINA_LOG_ERR("Error: views are only supported by the configurations "
+                 "which process the input in a single chunk\n");
+    return FEATURE_EXTRACTION_RESULT_ERROR;
+  }
+
+  fftf_set_openmp_num_threads(get_omp_transforms_max_threads_num());
+  std::unordered_map<std::string, std::shared_ptr<Buffers>> retmap;
+  try {
+    if (fc->Cached) {
+      // The other configurations use the tree's own buffers
+      if (!fc->ViewsContext) {
+        fc->ViewsContext = fc->Tree->CreateExecutionContext();
+      }
+      retmap = fc->Tree->Execute(buffer, fc->ViewsContext.get());
+    } else {
+      // The views point to the tree's own buffers, so wait until they are
+      // free
+      std::lock_guard<std::mutex> lock(*fc->TreeMutex);
+      retmap = fc->Tree->Execute(buffer);
+    }
+  }
+  catch(const std::exception& ex) {
+    EINA_LOG_ERR("Caught an exception with message \"%s\".\n", ex.what());
+    return FEATURE_EXTRACTION_RESULT_ERROR;
+  }
+  fc->ViewNames.clear();
+  fc->Views.clear();
+  fc->ViewNames.reserve(retmap.size());
+  fc->ViewConversions.resize(fc->OutputTypes.size());
+  size_t conversions = 0;
+  for (auto& res : retmap) {
+    fc->ViewNames.push_back(res.first);
+    const Buffers& buffers = *res.second;
+    FeatureView view;
+    view.name = fc->ViewNames.back().c_str();
+    view.data = buffers.Data();
+    view.count = buffers.Count();
+    view.size = buffers.Format()->UnalignedSizeInBytes();
+    view.stride = buffers.Stride();
+    auto type = output_type(fc, res.first);
+    if (type != FEATURE_OUTPUT_NATIVE) {
+      // Only the converted features are copied
+      auto& converted = fc->ViewConversions[conversions++];
+      view.size = converted_size(view.size, type);
+      view.stride = view.size;
+      converted.resize(view.size * view.count);
+      copy_chunk(buffers, 0, converted.data(), type);
+      view.data = converted.data();
+    }
+    fc->Views.push_back(view);
+  }
+  *views = fc->Views.data();
+  *viewsCount = fc->Views.size();
+  return FEATURE_EXTRACTION_RESULT_OK;
+}
+
+FeatureExtractionResult extract_sound_features_batch(
+    const FeaturesConfiguration *fc, const int16_t *clips,
+    char ***featureNames, void ***results, int **resultLengths) {
+  CHECK_NULL_RET(fc, FEATURE_EXTRACTION_RESULT_ERROR);
+  CHECK_NULL_RET(clips, FEATURE_EXTRACTION_RESULT_ERROR);
+  CHECK_NULL_RET(featureNames, FEATURE_EXTRACTION_RESULT_ERROR);
+  CHECK_NULL_RET(results, FEATURE_EXTRACTION_RESULT_ERROR);
+  CHECK_NULL_RET(resultLengths, FEATURE_EXTRACTION_RESULT_ERROR);
+  if (!check_sample_type(fc, SampleType::kInt16)) {
+    return FEATURE_EXTRACTION_RESULT_ERROR;
+  }
+  if (fc->Streaming || fc->Chunks > 1 || fc->Blocks || fc->Ragged) {
+    EINA_LOG_ERR("Error: the configuration was not created by "
+                 "setup_features_extraction_batch()\n");
+    return FEATURE_EXTRACTION_RESULT_ERROR;
+  }
+
+  fftf_set_openmp_num_threads(get_omp_transforms_max_threads_num());
+  // The tree expects the clips to be aligned, so repack them if needed.
+  // The interleaved channels are split by the tree itself.
+  size_t clip_bytes = fc->InputSize * sizeof(int16_t);
+  size_t stride = fc->Tree->RootFormat()->SizeInBytes();
+  std::shared_ptr<void> packed;
+  const int16_t* input = clips;
+  if (stride != clip_bytes &&
+      fc->Tree->channels_layout() == ChannelsLayout::kPlanar) {
+    packed = std::shared_ptr<void>(malloc_aligned(stride * fc->BatchSize),
+                                   std::free);
+    CHECK_NULL_RET(packed.get(), FEATURE_EXTRACTION_RESULT_ERROR);
+    for (size_t i = 0; i < fc->BatchSize; i++) {
+      memcpy(reinterpret_cast<char*>(packed.get()) + i * stride,
+             clips + i * fc->InputSize, clip_bytes);
+    }
+    input = reinterpret_cast<const int16_t*>(packed.get());
+  }
+
+  std::unordered_map<std::string, std::shared_ptr<Buffers>> retmap;
+  try {
+    ExecutionLease lease(fc);
+    retmap = lease.Execute(input);
+    *featureNames = new char*[retmap.size()];
+    *results = new void*[retmap.size()];
+    *resultLengths = new int[retmap.size()];
+    int j = 0;
+    for (auto& res : retmap) {
+      copy_string(res.first, *featureNames + j);
+      size_t size_each = res.second->Format()->UnalignedSizeInBytes();
+      size_t size = size_each * res.second->Count();
+      (*resultLengths)[j] = size;
+      (*results)[j] = new char[size];
+      for (size_t k = 0; k < res.second->Count(); k++) {
+        memcpy(reinterpret_cast<char *>((*results)[j]) + k * size_each,
+               (*res.second)[k], size_each);
+      }
+      j++;
+    }
+  }
+  catch(const std::exception& ex) {
+    EINA_LOG_ERR("Caught an exception with message \"%s\".\n", ex.what());
+    return FEATURE_EXTRACTION_RESULT_ERROR;
+  }
+  return FEATURE_EXTRACTION_RESULT_OK;
+}
+
+/// @brief The maximal number of the tail configurations which
+/// a ragged configuration keeps.
+static constexpr size_t kMaxRaggedTails = 64;
+
+/// @brief Returns the configuration which executes the tail of size samples
+/// of a clip with the ragged configuration, creating it if needed.
+static std::shared_ptr<FeaturesConfiguration> ragged_tail(
+    const FeaturesConfiguration *fc, size_t size) {
+  auto& ragged = *fc->Ragged;
+  std::lock_guard<std::mutex> lock(ragged.TailsMutex);
+  auto it = ragged.Tails.find(size);
+  if (it != ragged.Tails.end()) {
+    return it->second;
+  }
+  if (ragged.Tails.size() >= kMaxRaggedTails) {
+    // The trees stay in the prepared trees cache
+    ragged.Tails.clear();
+  }
+  std::vector<const char *> lines;
+  for (auto& line : fc->Features) {
+    lines.push_back(line.c_str());
+  }
+  std::shared_ptr<FeaturesConfiguration> tail(create_features_configuration(
+      lines.data(), lines.size(), size, fc->SamplingRate, false, 1, false,
+      SampleType::kInt16, true));
+  if (tail) {
+    ragged.Tails[size] = tail;
+  }
+  return tail;
+}
+
+FeatureExtractionResult extract_sound_features_ragged(
+    const FeaturesConfiguration *fc, const int16_t *const *clips,
+    const size_t *clipSizes, int clipsCount, int *featuresCount,
+    char ***featureNames, void ***results, int **resultLengths) {
+  CHECK_NULL_RET(fc, FEATURE_EXTRACTION_RESULT_ERROR);
+  CHECK_NULL_RET(clips, FEATURE_EXTRACTION_RESULT_ERROR);
+  CHECK_NULL_RET(clipSizes, FEATURE_EXTRACTION_RESULT_ERROR);
+  CHECK_NULL_RET(featuresCount, FEATURE_EXTRACTION_RESULT_ERROR);
+  CHECK_NULL_RET(featureNames, FEATURE_EXTRACTION_RESULT_ERROR);
+  CHECK_NULL_RET(results, FEATURE_EXTRACTION_RESULT_ERROR);
+  CHECK_NULL_RET(resultLengths, FEATURE_EXTRACTION_RESULT_ERROR);
+  if (!fc->Ragged) {
+    EINA_LOG_ERR("Error: the configuration was not created by "
+                 "setup_features_extraction_ragged()\n");
+    return FEATURE_EXTRACTION_RESULT_ERROR;
+  }
+  if (clipsCount < 1) {
+    EINA_LOG_ERR("Error: clipsCount must be positive (%i)\n", clipsCount);
+    return FEATURE_EXTRACTION_RESULT_ERROR;
+  }
+  for (int i = 0; i < clipsCount; i++) {
+    CHECK_NULL_RET(clips[i], FEATURE_EXTRACTION_RESULT_ERROR);
+    if (clipSizes[i] == 0) {
+      EINA_LOG_ERR("Error: clip %i is empty\n", i);
+      return FEATURE_EXTRACTION_RESULT_ERROR;
+    }
+  }
+  auto& ragged = *fc->Ragged;
+  auto& blocks = ragged.Blocks;
+  // The full blocks of all the clips go one after another, the rest of each
+  // clip is its tail
+  struct Block {
+    int Clip;
+    size_t Begin;
+    /// @brief The first contributed sample relative to Begin.
+    size_t Offset;
+  };
+  std::vector<Block> queue;
+  std::vector<size_t> tail_blocks(clipsCount);
+  for (int i = 0; i < clipsCount; i++) {
+    size_t count = 0;
+    for (; blocks.BlockBegin(count) + ragged.Size <= clipSizes[i]; count++) {
+      size_t begin = blocks.BlockBegin(count);
+      queue.push_back({ i, begin, count * blocks.Step - begin });
+    }
+    tail_blocks[i] = count;
+  }
+  std::vector<std::unordered_map<std::string, std::vector<char>>> rows(
+      clipsCount);
+  auto append = [&rows](int clip, const std::string& name,
+                        const Buffers& buffers, size_t first, size_t count) {
+    size_t size_each = buffers.Format()->UnalignedSizeInBytes();
+    auto& dest = rows[clip][name];
+    size_t offset = dest.size();
+    dest.resize(offset + count * size_each);
+    for (size_t k = 0; k < count; k++) {
+      memcpy(dest.data() + offset + k * size_each, buffers[first + k],
+             size_each);
+    }
+  };
+
+  fftf_set_openmp_num_threads(get_omp_transforms_max_threads_num());
+  size_t stride = fc->Tree->RootFormat()->SizeInBytes();
+  std::shared_ptr<void> packed(malloc_aligned(stride * fc->BatchSize),
+                               std::free);
+  CHECK_NULL_RET(packed.get(), FEATURE_EXTRACTION_RESULT_ERROR);
+  auto input = reinterpret_cast<char*>(packed.get());
+  std::vector<std::string> names;
+  try {
+    ExecutionLease lease(fc);
+    for (size_t first = 0; first < queue.size(); first += fc->BatchSize) {
+      // The last batch is padded with silence
+      size_t filled = std::min(fc->BatchSize, queue.size() - first);
+      memset(input + filled * stride, 0, (fc->BatchSize - filled) * stride);
+      for (size_t i = 0; i < filled; i++) {
+        auto& block = queue[first + i];
+        memcpy(input + i * stride, clips[block.Clip] + block.Begin,
+               ragged.Size * sizeof(int16_t));
+      }
+      for (auto& res : lease.Execute(input)) {
+        size_t hop = blocks.Hops.find(res.first)->second;
+        size_t per_block = res.second->Count() / fc->BatchSize;
+        for (size_t i = 0; i < filled; i++) {
+          auto& block = queue[first + i];
+          append(block.Clip, res.first, *res.second,
+                 i * per_block + block.Offset / hop, blocks.Step / hop);
+        }
+      }
+    }
+    for (auto& res : fc->Tree->FeatureBuffers()) {
+      names.push_back(res.first);
+    }
+    for (int i = 0; i < clipsCount; i++) {
+      size_t begin = blocks.BlockBegin(tail_blocks[i]);
+      auto tail = ragged_tail(fc, clipSizes[i] - begin);
+      if (!tail) {
+        EINA_LOG_ERR("Error: failed to set up the tail of %zu samples of "
+                     "clip %i\n", clipSizes[i] - begin, i);
+        return FEATURE_EXTRACTION_RESULT_ERROR;
+      }
+      ExecutionLease tail_lease(tail.get());
+      for (auto& res : tail_lease.Execute(clips[i] + begin)) {
+        size_t hop = blocks.Hops.find(res.first)->second;
+        size_t offset = (tail_blocks[i] * blocks.Step - begin) / hop;
+        append(i, res.first, *res.second, offset,
+               res.second->Count() - offset);
+      }
+    }
+  }
+  catch(const std::exception& ex) {
+    EINA_LOG_ERR("Caught an exception with message \"%s\".\n", ex.what());
+    return FEATURE_EXTRACTION_RESULT_ERROR;
+  }
+  int count = names.size();
+  *featuresCount = count;
+  *featureNames = new char*[count];
+  *results = new void*[count * clipsCount];
+  *resultLengths = new int[count * clipsCount];
+  for (int j = 0; j < count; j++) {
+    copy_string(names[j], *featureNames + j);
+    for (int i = 0; i < clipsCount; i++) {
+      auto& data = rows[i][names[j]];
+      int index = i * count + j;
+      (*resultLengths)[index] = data.size();
+      (*results)[index] = new char[data.size()];
+      memcpy((*results)[index], data.data(), data.size());
+    }
+  }
+  return FEATURE_EXTRACTION_RESULT_OK;
+}
+
+void free_ragged_results(int featuresCount, int clipsCount,
+                         char **featureNames, void **results,
+                         int *resultLengths) {
+  if (featuresCount <= 0 || clipsCount <= 0) {
+    EINA_LOG_ERR("Warning: free_ragged_results() was called with "
+                 "featuresCount or clipsCount <= 0, skipped\n");
+    return;
+  }
+  free_results(featuresCount, featureNames, nullptr, nullptr);
+  free_results(featuresCount * clipsCount, nullptr, results, resultLengths);
+}
+
+RequestBatcher::RequestBatcher(const FeaturesConfiguration* fc,
+                               FeaturesConfiguration* batch,
+                               int latencyBudgetUs)
+    : fc_(fc), batch_(batch), budget_(latencyBudgetUs),
+      features_count_(batch->Features.size()),
+      histogram_(batch->BatchSize, 0), stopping_(false),
+      thread_(&RequestBatcher::Collect, this) {
+}
+
+RequestBatcher::~RequestBatcher() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  arrived_.notify_one();
+  thread_.join();
+  destroy_features_configuration(batch_);
+}
+
+void RequestBatcher::Add(int16_t* buffer, FeaturesCallback callback,
+                         void* userData) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.push_back({ buffer, callback, userData,
+                       std::chrono::steady_clock::now() });
+  }
+  arrived_.notify_one();
+}
+
+void RequestBatcher::Collect() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    arrived_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+    if (queue_.empty()) {
+      return;
+    }
+    // Waits for more requests until the oldest one runs out of its budget
+    arrived_.wait_until(lock, queue_.front().Arrival + budget_, [this] {
+      return stopping_ || queue_.size() >= max_size();
+    });
+    size_t size = std::min(queue_.size(), max_size());
+    std::vector<Request> requests(queue_.begin(), queue_.begin() + size);
+    queue_.erase(queue_.begin(), queue_.begin() + size);
+    lock.unlock();
+    ThreadPool::Instance().Submit([this, requests] { Execute(requests); });
+    lock.lock();
+  }
+}
+
+void RequestBatcher::Execute(const std::vector<Request>& requests) {
+  // The missing clips are zeros, their results are discarded. batch_
+  // never relates the clips, see set_dynamic_batching().
+  size_t clip = fc_->InputSize;
+  std::unique_ptr<int16_t[]> clips(new int16_t[clip * max_size()]());
+  for (size_t i = 0; i < requests.size(); i++) {
+    memcpy(clips.get() + i * clip, requests[i].Buffer,
+           clip * sizeof(int16_t));
+  }
+  char **featureNames = nullptr;
+  void **results = nullptr;
+  int *resultLengths = nullptr;
+  auto result = extract_sound_features_batch(
+      batch_, clips.get(), &featureNames, &results, &resultLengths);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    histogram_[requests.size() - 1]++;
+  }
+  static auto sizes = Metrics::Instance().Histogram(
+      "sfe_dynamic_batch_size",
+      "The number of the requests merged by the dynamic batching.",
+      MetricsHistogram::PowersOfTwo(1024));
+  sizes->Observe(requests.size());
+  auto fc = fc_;
+  int count = result == FEATURE_EXTRACTION_RESULT_OK? features_count_ : 0;
+  std::vector<char**> names(requests.size(), nullptr);
+  std::vector<void**> parts(requests.size(), nullptr);
+  std::vector<int*> lengths(requests.size(), nullptr);
+  for (size_t i = 0; i < requests.size() && count > 0; i++) {
+    names[i] = new char*[count];
+    parts[i] = new void*[count];
+    lengths[i] = new int[count];
+    for (int j = 0; j < count; j++) {
+      copy_string(featureNames[j], names[i] + j);
+      int size = resultLengths[j] / max_size();
+      lengths[i][j] = size;
+      parts[i][j] = new char[size];
+      memcpy(parts[i][j], reinterpret_cast<char*>(results[j]) + i * size,
+             size);
+    }
+  }
+  if (count > 0) {
+    free_results(count, featureNames, results, resultLengths);
+  }
+  // This may be destroyed after the last callback
+  for (size_t i = 0; i < requests.size(); i++) {
+    complete_async(fc, requests[i].Callback, requests[i].UserData, result,
+                   count, names[i], parts[i], lengths[i]);
+  }
+}
+
+bool set_dynamic_batching(FeaturesConfiguration *fc, int maxBatchSize,
+                          int latencyBudgetUs) {
+  CHECK_NULL_RET(fc, false);
+  if (latencyBudgetUs < 0) {
+    EINA_LOG_ERR("Error: latencyBudgetUs is negative (%i)\n",
+                 latencyBudgetUs);
+    return false;
+  }
+  if (fc->Streaming || fc->BatchSize > 1 || fc->Chunks > 1 || fc->Blocks ||
+      fc->Features.empty() ||
+      fc->Tree->root_sample_type() != SampleType::kInt16) {
+    EINA_LOG_ERR("Error: only the configurations created by "
+                 "setup_features_extraction() which take the whole buffer "
+                 "at once can be batched\n");
+    return false;
+  }
+  {
+    std::unique_lock<std::mutex> lock(fc->AsyncMutex);
+    fc->AsyncFinished.wait(lock, [fc] { return fc->AsyncPending == 0; });
+  }
+  fc->Batcher.reset();
+  if (maxBatchSize <= 1) {
+    return true;
+  }
+  std::vector<const char*> features;
+  for (auto& feature : fc->Features) {
+    features.push_back(feature.c_str());
+  }
+  // The batch configuration inherits the execution settings. It is not
+  // created if some feature relates the adjacent windows, since
+  // the batched requests would affect each other's results.
+  ScopedExecutionOverrides overrides(&fc->Tree->execution_overrides());
+  auto batch = create_features_configuration(
+      features.data(), features.size(), fc->InputSize, fc->SamplingRate,
+      false, maxBatchSize, false);
+  if (batch == nullptr) {
+    EINA_LOG_ERR("Error: the features cannot be batched, the requests "
+                 "are extracted one by one\n");
+    return false;
+  }
+  fc->Batcher.reset(new RequestBatcher(fc, batch, latencyBudgetUs));
+  return true;
+}
+
+int get_batch_sizes_histogram(const FeaturesConfiguration *fc,
+                              size_t *counts, int size) {
+  CHECK_NULL_RET(fc, 0);
+  if (!fc->Batcher) {
+    return 0;
+  }
+  auto histogram = fc->Batcher->histogram();
+  for (int i = 0; i < size && i < static_cast<int>(histogram.size()); i++) {
+    counts[i] = histogram[i];
+  }
+  return histogram.size();
+}
+
+/// @brief Appends the contents of all the buffers to the vector.
+static void append_buffers(const Buffers& buffers, std::vector<char>* dest) {
+  size_t size_each = buffers.Format()->UnalignedSizeInBytes();
+  for (size_t k = 0; k < buffers.Count(); k++) {
+    auto ptr = reinterpret_cast<const char*>(buffers[k]);
+    dest->insert(dest->end(), ptr, ptr + size_each);
+  }
+}
+
+/// @brief Executes the tree on every complete block of the pending samples
+/// of the streaming configuration and drops these samples.
+static bool execute_stream_blocks(
+    FeaturesConfiguration *fc,
+    const std::function<void(const ResultsMap&)>& write) {
+  auto& pending = fc->PendingSamples;
+  size_t offset = 0;
+  for (; offset + fc->InputSize <= pending.size(); offset += fc->InputSize) {
+    try {
+      write(fc->Tree->Execute(pending.data() + offset));
+    }
+    catch(const std::exception& ex) {
+      EINA_LOG_ERR("Caught an exception with message \"%s\".\n", ex.what());
+      pending.erase(pending.begin(), pending.begin() + offset);
+      return false;
+    }
+  }
+  pending.erase(pending.begin(), pending.begin() + offset);
+  return true;
+}
+
+FeatureExtractionResult push_samples(
+    FeaturesConfiguration *fc, const int16_t *samples, size_t count) {
+  CHECK_NULL_RET(fc, FEATURE_EXTRACTION_RESULT_ERROR);
+  CHECK_NULL_RET(samples, FEATURE_EXTRACTION_RESULT_ERROR);
+  if (!fc->Streaming) {
+    EINA_LOG_ERR("Error: the configuration was not created by "
+                 "setup_features_stream()\n");
+    return FEATURE_EXTRACTION_RESULT_ERROR;
+  }
+
+  fftf_set_openmp_num_threads(get_omp_transforms_max_threads_num());
+  fc->PendingSamples.insert(fc->PendingSamples.end(), samples,
+                            samples + count);
+  bool ok = execute_stream_blocks(fc, [fc](const ResultsMap& retmap) {
+    for (auto& res : retmap) {
+      append_buffers(*res.second, &fc->StreamResults[res.first]);
+    }
+  });
+  return ok? FEATURE_EXTRACTION_RESULT_OK : FEATURE_EXTRACTION_RESULT_ERROR;
+}
+
+FeatureExtractionResult extract_sound_features_window(
+    FeaturesConfiguration *fc, const int16_t *samples, size_t count,
+    uint64_t offset, char ***featureNames, void ***results,
+    int **resultLengths) {
+  CHECK_NULL_RET(fc, FEATURE_EXTRACTION_RESULT_ERROR);
+  CHECK_NULL_RET(samples, FEATURE_EXTRACTION_RESULT_ERROR);
+  CHECK_NULL_RET(featureNames, FEATURE_EXTRACTION_RESULT_ERROR);
+  CHECK_NULL_RET(results, FEATURE_EXTRACTION_RESULT_ERROR);
+  CHECK_NULL_RET(resultLengths, FEATURE_EXTRACTION_RESULT_ERROR);
+  if (!fc->Streaming) {
+    EINA_LOG_ERR("Error: the configuration was not created by "
+                 "setup_features_stream()\n");
+    return FEATURE_EXTRACTION_RESULT_ERROR;
+  }
+
+  fftf_set_openmp_num_threads(get_omp_transforms_max_threads_num());
+  uint64_t block = fc->InputSize;
+  // The first block which lies completely inside the window
+  uint64_t first_block = (offset + block - 1) / block;
+  uint64_t end = offset + count;
+  if (offset > fc->StreamPosition || end < fc->StreamPosition ||
+      first_block < fc->WindowFirstBlock) {
+    // The window jumped over the known samples or went back beyond
+    // the kept blocks, so the stream starts anew
+    EINA_LOG_DBG("Restarting the stream at sample %llu",
+                 static_cast<unsigned long long>(first_block * block));
+    reset_features_stream(fc);
+    fc->WindowFirstBlock = first_block;
+    fc->StreamPosition = first_block * block;
+  }
+  if (fc->StreamPosition < end) {
+    // Only the samples which were not pushed before are processed
+    fc->PendingSamples.insert(fc->PendingSamples.end(),
+                              samples + (fc->StreamPosition - offset),
+                              samples + count);
+    fc->StreamPosition = end;
+  }
+  bool ok = execute_stream_blocks(fc, [fc](const ResultsMap& retmap) {
+    fc->WindowBlocks.emplace_back();
+    for (auto& res : retmap) {
+      append_buffers(*res.second, &fc->WindowBlocks.back()[res.first]);
+    }
+  });
+  if (!ok) {
+    return FEATURE_EXTRACTION_RESULT_ERROR;
+  }
+  for (; fc->WindowFirstBlock < first_block && !fc->WindowBlocks.empty();
+       fc->WindowFirstBlock++) {
+    fc->WindowBlocks.pop_front();
+  }
+  fc->WindowFirstBlock = std::max(fc->WindowFirstBlock, first_block);
+
+  auto count_features = fc->StreamResults.size();
+  *featureNames = new char*[count_features];
+  *results = new void*[count_features];
+  *resultLengths = new int[count_features];
+  int j = 0;
+  for (auto& feature : fc->StreamResults) {
+    size_t size = 0;
+    for (auto& blockResults : fc->WindowBlocks) {
+      size += blockResults[feature.first].size();
+    }
+    copy_string(feature.first, *featureNames + j);
+    (*resultLengths)[j] = size;
+    auto ptr = new char[size];
+    (*results)[j] = ptr;
+    for (auto& blockResults : fc->WindowBlocks) {
+      auto& part = blockResults[feature.first];
+      memcpy(ptr, part.data(), part.size());
+      ptr += part.size();
+    }
+    j++;
+  }
+  return FEATURE_EXTRACTION_RESULT_OK;
+}
+
+FeatureExtractionResult pull_features(
+    FeaturesConfiguration *fc, char ***featureNames, void ***results,
+    int **resultLengths) {
+  CHECK_NULL_RET(fc, FEATURE_EXTRACTION_RESULT_ERROR);
+  CHECK_NULL_RET(featureNames, FEATURE_EXTRACTION_RESULT_ERROR);
+  CHECK_NULL_RET(results, FEATURE_EXTRACTION_RESULT_ERROR);
+  CHECK_NULL_RET(resultLengths, FEATURE_EXTRACTION_RESULT_ERROR);
+  if (!fc->Streaming) {
+    EINA_LOG_ERR("Error: the configuration was not created by "
+                 "setup_features_stream()\n");
+    return FEATURE_EXTRACTION_RESULT_ERROR;
+  }
+
+  auto count = fc->StreamResults.size();
+  *featureNames = new char*[count];
+  *results = new void*[count];
+  *resultLengths = new int[count];
+  int j = 0;
+  for (auto& res : fc->StreamResults) {
+    copy_string(res.first, *featureNames + j);
+    (*resultLengths)[j] = res.second.size();
+    (*results)[j] = new char[res.second.size()];
+    memcpy((*results)[j], res.second.data(), res.second.size());
+    res.second.clear();
+    j++;
+  }
+  return FEATURE_EXTRACTION_RESULT_OK;
+}
+
+void reset_features_stream(FeaturesConfiguration *fc) {
+  CHECK_NULL(fc);
+
+  fc->PendingSamples.clear();
+  for (auto& res : fc->StreamResults) {
+    res.second.clear();
+  }
+  fc->StreamPosition = 0;
+  fc->WindowBlocks.clear();
+  fc->WindowFirstBlock = 0;
+  fc->Tree->ResetStream();
+}
+
+FeatureExtractionResult push_audio_file(FeaturesConfiguration *fc,
+                                        const char *fileName) {
+  CHECK_NULL_RET(fc, FEATURE_EXTRACTION_RESULT_ERROR);
+  CHECK_NULL_RET(fileName, FEATURE_EXTRACTION_RESULT_ERROR);
+  if (!fc->Streaming) {
+    EINA_LOG_ERR("Error: the configuration was not created by "
+                 "setup_features_stream()\n");
+    return FEATURE_EXTRACTION_RESULT_ERROR;
+  }
+  try {
+    DecodingSource source(AudioDecoder::Open(fileName), fc->InputSize);
+    if (source.sampling_rate() != fc->SamplingRate) {
+      EINA_LOG_ERR("Error: %s is sampled at %d Hz, the configuration "
+                   "expects %d Hz\n", fileName, source.sampling_rate(),
+                   fc->SamplingRate);
+      return FEATURE_EXTRACTION_RESULT_ERROR;
+    }
+    size_t count;
+    for (auto block = source.Next(&count); block != nullptr;
+         block = source.Next(&count)) {
+      auto result = push_samples(fc, block, count);
+      if (result != FEATURE_EXTRACTION_RESULT_OK) {
+        return result;
+      }
+    }
+  }
+  catch(const AudioDecoderException& ade) {
+    EINA_LOG_ERR("Caught an exception with message \"%s\".\n", ade.what());
+    return FEATURE_EXTRACTION_RESULT_ERROR;
+  }
+  return FEATURE_EXTRACTION_RESULT_OK;
+}
+
+void report_extraction_time(const FeaturesConfiguration *fc,
+                            char ***transformNames,
+                            float **values,
+                            int *length) {
+  CHECK_NULL(fc);
+  CHECK_NULL(transformNames);
+  CHECK_NULL(values);
+  CHECK_NULL(length);
+
+  auto report = fc->Tree->ExecutionTimeReport();
+  *length = report.size();
+  *transformNames = new char*[*length];
+  *values = new float[*length];
+
+  int i = 0;
+  for (auto pair : report) {
+    copy_string(pair.first, *transformNames + i);
+    (*values)[i] = pair.second;
+    i++;
+  }
+}
+
+void destroy_extraction_time_report(char **transformNames,
+                                    float *values,
+                                    int length) {
+  CHECK_NULL(transformNames);
+  CHECK_NULL(values);
+
+  delete[] values;
+  for (int i = 0; i < length; i++) {
+    delete[] transformNames[i];
+  }
+  delete[] transformNames;
+}
+
+void report_extraction_counters(const FeaturesConfiguration *fc,
+                                char ***nodeNames,
+                                NodeHardwareCounters **counters,
+                                int *length) {
+  CHECK_NULL(fc);
+  CHECK_NULL(nodeNames);
+  CHECK_NULL(counters);
+  CHECK_NULL(length);
+
+  auto report = fc->Tree->NodeCountersReport();
+  *length = report.size();
+  *nodeNames = new char*[*length];
+  *counters = new NodeHardwareCounters[*length];
+  for (int i = 0; i < *length; i++) {
+    auto& node = report[i].second;
+    copy_string(report[i].first, *nodeNames + i);
+    (*counters)[i].cycles = node.Cycles;
+    (*counters)[i].instructions = node.Instructions;
+    (*counters)[i].ipc = node.InstructionsPerCycle();
+    (*counters)[i].llc_misses = node.CacheMisses;
+    (*counters)[i].bandwidth = node.MemoryBandwidth();
+  }
+}
+
+void destroy_extraction_counters(char **nodeNames,
+                                 NodeHardwareCounters *counters,
+                                 int length) {
+  CHECK_NULL(nodeNames);
+  CHECK_NULL(counters);
+
+  delete[] counters;
+  for (int i = 0; i < length; i++) {
+    delete[] nodeNames[i];
+  }
+  delete[] nodeNames;
+}
+
+void report_extraction_instruction_sets(const FeaturesConfiguration *fc,
+                                        char ***nodeNames,
+                                        InstructionSetType **instructionSets,
+                                        int *length) {
+  CHECK_NULL(fc);
+  CHECK_NULL(nodeNames);
+  CHECK_NULL(instructionSets);
+  CHECK_NULL(length);
+
+  auto report = fc->Tree->InstructionSetsReport();
+  *length = report.size();
+  *nodeNames = new char*[*length];
+  *instructionSets = new InstructionSetType[*length];
+  for (int i = 0; i < *length; i++) {
+    copy_string(report[i].first, *nodeNames + i);
+    (*instructionSets)[i] = static_cast<InstructionSetType>(report[i].second);
+  }
+}
+
+void destroy_extraction_instruction_sets(char **nodeNames,
+                                         InstructionSetType *instructionSets,
+                                         int length) {
+  CHECK_NULL(nodeNames);
+  CHECK_NULL(instructionSets);
+
+  delete[] instructionSets;
+  for (int i = 0; i < length; i++) {
+    delete[] nodeNames[i];
+  }
+  delete[] nodeNames;
+}
+
+void report_extraction_placements(const FeaturesConfiguration *fc,
+                                  char ***nodeNames,
+                                  NodePlacementType **placements,
+                                  int *length) {
+  CHECK_NULL(fc);
+  CHECK_NULL(nodeNames);
+  CHECK_NULL(placements);
+  CHECK_NULL(length);
+
+  auto report = fc->Tree->PlacementsReport();
+  *length = report.size();
+  *nodeNames = new char*[*length];
+  *placements = new NodePlacementType[*length];
+  for (int i = 0; i < *length; i++) {
+    copy_string(report[i].first, *nodeNames + i);
+    (*placements)[i] = report[i].second == Placement::kParallel?
+        NODE_PLACEMENT_PARALLEL : NODE_PLACEMENT_SERIAL;
+  }
+}
+
+void destroy_extraction_placements(char **nodeNames,
+                                   NodePlacementType *placements,
+                                   int length) {
+  CHECK_NULL(nodeNames);
+  CHECK_NULL(placements);
+
+  delete[] placements;
+  for (int i = 0; i < length; i++) {
+    delete[] nodeNames[i];
+  }
+  delete[] nodeNames;
+}
+
+void report_extraction_memory(const FeaturesConfiguration *fc,
+                              ExtractionMemoryUsage *usage,
+                              char ***nodeNames, NodeMemoryUsage **nodes,
+                              int *length) {
+  CHECK_NULL(fc);
+  CHECK_NULL(usage);
+  CHECK_NULL(nodeNames);
+  CHECK_NULL(nodes);
+  CHECK_NULL(length);
+
+  auto report = fc->Tree->MemoryReport();
+  usage->allocated = report.Allocated;
+  usage->peak = report.Peak;
+  usage->buffers = report.Buffers;
+  usage->private_memory = report.Private;
+  *length = report.Nodes.size();
+  *nodeNames = new char*[*length];
+  *nodes = new NodeMemoryUsage[*length];
+  for (int i = 0; i < *length; i++) {
+    copy_string(std::get<0>(report.Nodes[i]), *nodeNames + i);
+    (*nodes)[i].buffers = std::get<1>(report.Nodes[i]);
+    (*nodes)[i].private_memory = std::get<2>(report.Nodes[i]);
+  }
+}
+
+void destroy_extraction_memory(char **nodeNames, NodeMemoryUsage *nodes,
+                               int length) {
+  CHECK_NULL(nodeNames);
+  CHECK_NULL(nodes);
+
+  delete[] nodes;
+  for (int i = 0; i < length; i++) {
+    delete[] nodeNames[i];
+  }
+  delete[] nodeNames;
+}
+
+void set_extraction_profiling(const FeaturesConfiguration *fc,
+                              ExtractionProfilingMode mode) {
+  CHECK_NULL(fc);
+  switch (mode) {
+    case EXTRACTION_PROFILING_NONE:
+      fc->Tree->DisableProfiling();
+      break;
+    case EXTRACTION_PROFILING_STATISTICS:
+    case EXTRACTION_PROFILING_TRACE:
+      fc->Tree->EnableProfiling(mode == EXTRACTION_PROFILING_TRACE);
+      break;
+    default:
+      EINA_LOG_ERR("Invalid profiling mode %d.", mode);
+      break;
+  }
+}
+
+void report_extraction_profile(const FeaturesConfiguration *fc,
+                               char ***nodeNames,
+                               NodeProfile **profiles,
+                               int *length) {
+  CHECK_NULL(fc);
+  CHECK_NULL(nodeNames);
+  CHECK_NULL(profiles);
+  CHECK_NULL(length);
+
+  auto profiler = fc->Tree->profiler();
+  std::vector<std::pair<std::string, Profiler::NodeStatistics>> stats;
+  if (profiler) {
+    stats = profiler->Statistics();
+  }
+  *length = stats.size();
+  *nodeNames = new char*[*length];
+  *profiles = new NodeProfile[*length];
+  auto seconds = [](Profiler::Clock::duration value) {
+    return std::chrono::duration_cast<std::chrono::duration<float>>(
+        value).count();
+  };
+  for (int i = 0; i < *length; i++) {
+    auto& node = stats[i].second;
+    copy_string(stats[i].first, *nodeNames + i);
+    (*profiles)[i].calls = node.Durations.Count();
+    (*profiles)[i].total = seconds(node.Durations.Sum());
+    (*profiles)[i].median = seconds(node.Durations.Percentile(0.5f));
+    (*profiles)[i].p99 = seconds(node.Durations.Percentile(0.99f));
+    (*profiles)[i].bytes_in = node.BytesIn;
+    (*profiles)[i].bytes_out = node.BytesOut;
+  }
+}
+
+void destroy_extraction_profile(char **nodeNames, NodeProfile *profiles,
+                                int length) {
+  CHECK_NULL(nodeNames);
+  CHECK_NULL(profiles);
+
+  delete[] profiles;
+  for (int i = 0; i < length; i++) {
+    delete[] nodeNames[i];
+  }
+  delete[] nodeNames;
+}
+
+FeatureExtractionResult save_extraction_trace(
+    const FeaturesConfiguration *fc, const char *fileName) {
+  CHECK_NULL_RET(fc, FEATURE_EXTRACTION_RESULT_ERROR);
+  CHECK_NULL_RET(fileName, FEATURE_EXTRACTION_RESULT_ERROR);
+  auto profiler = fc->Tree->profiler();
+  if (!profiler || !profiler->trace()) {
+    EINA_LOG_ERR("Error: the tracing is not enabled, see "
+                 "set_extraction_profiling()\n");
+    return FEATURE_EXTRACTION_RESULT_ERROR;
+  }
+  try {
+    profiler->SaveTrace(fileName);
+  }
+  catch(const std::exception& ex) {
+    EINA_LOG_ERR("Failed to save the trace. %s\n", ex.what());
+    return FEATURE_EXTRACTION_RESULT_ERROR;
+  }
+  return FEATURE_EXTRACTION_RESULT_OK;
+}
+
+bool start_traffic_recording(const char *fileName, int every,
+                             int maxRecords) {
+  CHECK_NULL_RET(fileName, false);
+  std::shared_ptr<TrafficRecorder> recorder;
+  try {
+    recorder = std::make_shared<TrafficRecorder>(
+        fileName, every, std::max(maxRecords, 0));
+  }
+  catch(const TrafficRecorderException& ex) {
+    EINA_LOG_ERR("Failed to start the traffic recording. %s\n", ex.what());
+    return false;
+  }
+  auto previous = std::atomic_exchange(&traffic_recorder, recorder);
+  if (previous) {
+    EINA_LOG_WARN("The recording to %s was stopped\n",
+                  previous->file_name().c_str());
+    previous->Close();
+  }
+  return true;
+}
+
+int stop_traffic_recording(void) {
+  auto recorder = std::atomic_exchange(
+      &traffic_recorder, std::shared_ptr<TrafficRecorder>());
+  if (!recorder) {
+    return 0;
+  }
+  // The concurrent Record() calls finish before Close() takes the lock,
+  // the later ones are ignored
+  if (!recorder->Close()) {
+    EINA_LOG_ERR("Error: failed to write %s\n",
+                 recorder->file_name().c_str());
+    return -1;
+  }
+  return recorder->records();
+}
+
+void report_extraction_graph(const FeaturesConfiguration *fc,
+                             const char *fileName) {
+  CHECK_NULL(fc);
+  CHECK_NULL(fileName);
+  fc->Tree->Dump(fileName);
+}
+
+void report_extraction_graph_annotated(const FeaturesConfiguration *fc,
+                                       const char *fileName) {
+  CHECK_NULL(fc);
+  CHECK_NULL(fileName);
+  fc->Tree->Dump(fileName, true);
+}
+
+char *explain_features_configuration(const FeaturesConfiguration *fc) {
+  CHECK_NULL_RET(fc, nullptr);
+  std::string explanation;
+  try {
+    explanation = fc->Tree->Explain();
+  }
+  catch(const std::exception& e) {
+    EINA_LOG_ERR("Failed to explain the configuration: %s", e.what());
+    return nullptr;
+  }
+  char *ret;
+  copy_string(explanation, &ret);
+  return ret;
+}
+
+void destroy_features_configuration_explanation(char *explanation) {
+  delete[] explanation;
+}
+
+FeatureExtractionResult save_features_configuration(
+    const FeaturesConfiguration *fc, const char *fileName) {
+  CHECK_NULL_RET(fc, FEATURE_EXTRACTION_RESULT_ERROR);
+  CHECK_NULL_RET(fileName, FEATURE_EXTRACTION_RESULT_ERROR);
+  if (fc->Chunks > 1 || fc->Blocks) {
+    EINA_LOG_ERR("Error: only the configurations which process the input "
+                 "in a single chunk can be saved\n");
+    return FEATURE_EXTRACTION_RESULT_ERROR;
+  }
+  try {
+    fc->Tree->Save(fileName);
+  }
+  catch(const std::exception& ex) {
+    EINA_LOG_ERR("Failed to save the configuration. %s\n", ex.what());
+    return FEATURE_EXTRACTION_RESULT_ERROR;
+  }
+  return FEATURE_EXTRACTION_RESULT_OK;
+}
+
+/// @brief Wraps the tree restored by TransformTree::Load().
+static FeaturesConfiguration *wrap_loaded_tree(
+    const std::shared_ptr<TransformTree>& tree) {
+  auto config = new FeaturesConfiguration();
+  config->Tree = tree;
+  config->TreeMutex = std::make_shared<std::mutex>();
+  config->Cached = false;
+  config->InputSize = tree->RootSize();
+  config->Chunks = 1;
+  config->Streaming = tree->streaming();
+  config->BatchSize = tree->batch_size();
+  if (config->Streaming) {
+    for (auto& res : tree->FeatureBuffers()) {
+      config->StreamResults[res.first];
+    }
+  }
+  return config;
+}
+
+FeaturesConfiguration *load_features_configuration(const char *fileName) {
+  CHECK_NULL_RET(fileName, nullptr);
+  std::shared_ptr<TransformTree> tree;
+  try {
+    tree = TransformTree::Load(fileName);
+  }
+  catch(const std::exception& ex) {
+    EINA_LOG_ERR("Failed to load the configuration. %s\n", ex.what());
+    return nullptr;
+  }
+  return wrap_loaded_tree(tree);
+}
+
+/// @brief Restores the tree compiled into the plugin, nullptr if it does not
+/// fit the specified parameters.
+static std::shared_ptr<TransformTree> load_compiled_tree(
+    const char *pluginFileName, const char *const *features,
+    int featuresCount, size_t bufferSize, int samplingRate) {
+  auto handle = dlopen(pluginFileName, RTLD_NOW | RTLD_LOCAL);
+  if (handle == nullptr) {
+    EINA_LOG_ERR("Warning: failed to load %s: %s\n", pluginFileName,
+                 dlerror());
+    return nullptr;
+  }
+  // The image lives in the plugin, so it is closed with the last transform
+  // which references it
+  auto plugin = std::shared_ptr<const void>(handle, [](const void* ptr) {
+    dlclose(const_cast<void*>(ptr));
+  });
+  auto compiled = reinterpret_cast<const CompiledFeaturesConfiguration*>(
+      dlsym(handle, COMPILED_FEATURES_CONFIGURATION_SYMBOL));
+  if (compiled == nullptr) {
+    EINA_LOG_ERR("Warning: %s does not export %s\n", pluginFileName,
+                 COMPILED_FEATURES_CONFIGURATION_SYMBOL);
+    return nullptr;
+  }
+  std::string joined;
+  for (int i = 0; i < featuresCount; i++) {
+    if (i > 0) {
+      joined += '\n';
+    }
+    joined += features[i];
+  }
+  if (joined != compiled->features || bufferSize != compiled->buffer_size ||
+      samplingRate != compiled->sampling_rate) {
+    EINA_LOG_ERR("Warning: %s was compiled for other parameters\n",
+                 pluginFileName);
+    return nullptr;
+  }
+  try {
+    return TransformTree::Load(pluginFileName, compiled->image,
+                               compiled->image_size, plugin);
+  }
+  catch(const std::exception& ex) {
+    EINA_LOG_ERR("Warning: failed to restore the configuration compiled "
+                 "into %s. %s\n", pluginFileName, ex.what());
+    return nullptr;
+  }
+}
+
+FeaturesConfiguration *load_compiled_features_configuration(
+    const char *pluginFileName, const char *const *features,
+    int featuresCount, size_t bufferSize, int samplingRate) {
+  CHECK_NULL_RET(pluginFileName, nullptr);
+  CHECK_NULL_RET(features, nullptr);
+  auto tree = load_compiled_tree(pluginFileName, features, featuresCount,
+                                 bufferSize, samplingRate);
+  if (tree) {
+    return wrap_loaded_tree(tree);
+  }
+  EINA_LOG_INFO("Falling back to setup_features_extraction()\n");
+  return setup_features_extraction(features, featuresCount, bufferSize,
+                                   samplingRate);
+}
+
+void destroy_features_configuration(FeaturesConfiguration* fc) {
+  CHECK_NULL(fc);
+  {
+    std::unique_lock<std::mutex> lock(fc->AsyncMutex);
+    fc->AsyncFinished.wait(lock, [fc] { return fc->AsyncPending == 0; });
+  }
+
+  delete fc;
+}
+
+void free_results(int featuresCount, char **featureNames,
                   void **results, int *resultLengths) {
   if (featuresCount <= 0) {
     EINA_LOG_ERR("Warning: free_results() was called with featuresCount"
@@ -483,6 +3926,10 @@ void get_set_omp_transforms_max_threads_num(int *value, bool get) {
 }
 
 int get_omp_transforms_max_threads_num(void) {
+  auto overrides = CurrentExecutionOverrides();
+  if (overrides != nullptr && overrides->ThreadsNumber > 0) {
+    return std::min(overrides->ThreadsNumber, omp_get_max_threads());
+  }
   int res;
   get_set_omp_transforms_max_threads_num(&res, true);
   return res;
@@ -491,6 +3938,44 @@ int get_omp_transforms_max_threads_num(void) {
 void set_omp_transforms_max_threads_num(int value) {
   get_set_omp_transforms_max_threads_num(&value, false);
   fftf_set_openmp_num_threads(get_omp_transforms_max_threads_num());
+  ThreadPool::Instance().set_threads_number(
+      get_omp_transforms_max_threads_num());
+}
+
+bool get_prefer_gpu_fft(void) {
+  return FFTFWisdom::Instance().prefer_gpu();
+}
+
+void set_prefer_gpu_fft(int value) {
+  // Applied by FFTFWisdom::Select() together with the backend of each plan
+  FFTFWisdom::Instance().set_prefer_gpu(value != 0);
+}
+
+bool get_fft_autotuning(void) {
+  return FFTFWisdom::Instance().autotune();
+}
+
+void set_fft_autotuning(int value) {
+  FFTFWisdom::Instance().set_autotune(value);
+}
+
+bool load_fft_wisdom(const char *fileName) {
+  CHECK_NULL_RET(fileName, false);
+  if (!FFTFWisdom::Instance().Load(fileName)) {
+    EINA_LOG_ERR("Error: failed to load the FFT wisdom from %s\n",
+                 fileName);
+    return false;
+  }
+  return true;
+}
+
+bool save_fft_wisdom(const char *fileName) {
+  CHECK_NULL_RET(fileName, false);
+  if (!FFTFWisdom::Instance().Save(fileName)) {
+    EINA_LOG_ERR("Error: failed to save the FFT wisdom to %s\n", fileName);
+    return false;
+  }
+  return true;
 }
 
 bool get_use_simd(void) {
@@ -501,9 +3986,25 @@ void set_use_simd(int value) {
   SimdAware::set_use_simd(value);
 }
 
+InstructionSetType get_instruction_set(void) {
+  return static_cast<InstructionSetType>(SimdAware::instruction_set());
+}
+
+InstructionSetType get_max_instruction_set(void) {
+  return static_cast<InstructionSetType>(SimdAware::max_instruction_set());
+}
+
+void set_max_instruction_set(InstructionSetType value) {
+  SimdAware::set_max_instruction_set(static_cast<InstructionSet>(value));
+}
+
 size_t cpu_cache_size = 8 * 1024 * 1024;
 
 size_t get_cpu_cache_size() {
+  auto overrides = CurrentExecutionOverrides();
+  if (overrides != nullptr && overrides->CpuCacheSize > 0) {
+    return overrides->CpuCacheSize;
+  }
   return cpu_cache_size;
 }
 
@@ -516,6 +4017,10 @@ void set_cpu_cache_size(size_t value) {
 }
 
 size_t get_chunk_size(void) {
+  auto overrides = CurrentExecutionOverrides();
+  if (overrides != nullptr && overrides->ChunkSize > 0) {
+    return overrides->ChunkSize;
+  }
   return chunk_size;
 }
 
@@ -527,4 +4032,310 @@ void set_chunk_size(size_t value) {
   }
 }
 
+void set_thread_execution_settings(const ExecutionSettings *settings) {
+  if (settings == nullptr) {
+    SetThreadExecutionOverrides(nullptr);
+    return;
+  }
+  ExecutionOverrides overrides;
+  overrides.UseSimd = settings->useSimd < 0? -1 : settings->useSimd != 0;
+  overrides.ThreadsNumber = settings->threadsNumber;
+  overrides.CpuCacheSize = settings->cpuCacheSize;
+  overrides.ChunkSize = settings->chunkSize;
+  SetThreadExecutionOverrides(&overrides);
+}
+
+void get_execution_settings(const FeaturesConfiguration *fc,
+                            ExecutionSettings *settings) {
+  CHECK_NULL(fc);
+  CHECK_NULL(settings);
+  ScopedExecutionOverrides overrides(&fc->Tree->execution_overrides());
+  settings->useSimd = get_use_simd();
+  settings->threadsNumber = get_omp_transforms_max_threads_num();
+  settings->cpuCacheSize = get_cpu_cache_size();
+  settings->chunkSize = get_chunk_size();
+}
+
+void cancel_extractions(const FeaturesConfiguration *fc) {
+  CHECK_NULL(fc);
+  fc->Cancellation.Cancel();
+}
+
+void set_extraction_timeout(FeaturesConfiguration *fc, int milliseconds) {
+  CHECK_NULL(fc);
+  fc->TimeoutMs = std::max(milliseconds, 0);
+}
+
+int get_extraction_timeout(const FeaturesConfiguration *fc) {
+  CHECK_NULL_RET(fc, 0);
+  return fc->TimeoutMs;
+}
+
+bool get_threads_governor(void) {
+  return ThreadsGovernor::Instance().enabled();
+}
+
+void set_threads_governor(int value) {
+  ThreadsGovernor::Instance().set_enabled(value != 0);
+}
+
+void get_threads_governor_state(int *executions, int *share) {
+  CHECK_NULL(executions);
+  CHECK_NULL(share);
+  auto state = ThreadsGovernor::Instance().State();
+  *executions = state.Executions;
+  *share = state.Share;
+}
+
+size_t get_configurations_cache_size(void) {
+  return prepared_trees_cache.capacity();
+}
+
+void set_configurations_cache_size(size_t value) {
+  prepared_trees_cache.set_capacity(value);
+}
+
+size_t get_results_cache_size(void) {
+  return results_cache.capacity();
+}
+
+void set_results_cache_size(size_t value) {
+  results_cache.set_capacity(value);
+}
+
+int get_results_cache_ttl(void) {
+  return results_cache.ttl().count();
+}
+
+void set_results_cache_ttl(int value) {
+  if (value < 0) {
+    EINA_LOG_ERR("Invalid results cache TTL %d.", value);
+    return;
+  }
+  results_cache.set_ttl(std::chrono::milliseconds(value));
+}
+
+void get_results_cache_stats(size_t *hits, size_t *misses) {
+  CHECK_NULL(hits);
+  CHECK_NULL(misses);
+  results_cache.stats(hits, misses);
+}
+
+/// @brief Registers the metrics which are read from the other statistics.
+static void register_metrics_callbacks() {
+  auto& metrics = Metrics::Instance();
+  metrics.Callback("sfe_memory_pool_used_bytes",
+                   "The memory of the trees acquired from the pool.",
+                   Metrics::Type::kGauge, [] {
+    return MemoryPool::Instance().used_size();
+  });
+  metrics.Callback("sfe_memory_pool_idle_bytes",
+                   "The memory which waits in the pool.",
+                   Metrics::Type::kGauge, [] {
+    return MemoryPool::Instance().idle_size();
+  });
+  metrics.Callback("sfe_scratch_bytes",
+                   "The temporary memory of the transforms in all the "
+                   "threads, taken from the pool.",
+                   Metrics::Type::kGauge, [] {
+    return ScratchArena::TotalSize();
+  });
+  const char *help = "The lookups of the results cache.";
+  metrics.Callback("sfe_results_cache_lookups", help,
+                   Metrics::Type::kCounter, [] {
+    size_t hits, misses;
+    results_cache.stats(&hits, &misses);
+    return hits;
+  }, "result=\"hit\"");
+  metrics.Callback("sfe_results_cache_lookups", help,
+                   Metrics::Type::kCounter, [] {
+    size_t hits, misses;
+    results_cache.stats(&hits, &misses);
+    return misses;
+  }, "result=\"miss\"");
+  metrics.Callback("sfe_pending_extractions",
+                   "The unfinished asynchronous extractions.",
+                   Metrics::Type::kGauge, [] {
+    return pending_extractions.load();
+  });
+}
+
+char *snapshot_metrics(void) {
+  static std::once_flag registered;
+  std::call_once(registered, register_metrics_callbacks);
+  char *snapshot;
+  copy_string(Metrics::Instance().Snapshot(), &snapshot);
+  return snapshot;
+}
+
+void destroy_metrics_snapshot(char *snapshot) {
+  delete[] snapshot;
+}
+
+void reset_results_cache(void) {
+  results_cache.Reset();
+}
+
+size_t get_memory_pool_size(void) {
+  return MemoryPool::Instance().max_idle_size();
+}
+
+void set_memory_pool_size(size_t value) {
+  MemoryPool::Instance().set_max_idle_size(value);
+}
+
+HugePagesMode get_huge_pages_mode(void) {
+  return static_cast<HugePagesMode>(MemoryPool::Instance().huge_pages());
+}
+
+void set_huge_pages_mode(HugePagesMode value) {
+  if (value < HUGE_PAGES_NONE || value > HUGE_PAGES_EXPLICIT) {
+    EINA_LOG_ERR("Invalid huge pages mode %d.", value);
+    return;
+  }
+  MemoryPool::Instance().set_huge_pages(
+      static_cast<sound_feature_extraction::HugePages>(value));
+}
+
+bool get_numa_binding(void) {
+  return MemoryPool::Instance().numa_binding();
+}
+
+void set_numa_binding(int value) {
+  MemoryPool::Instance().set_numa_binding(value);
+}
+
+int get_threads_affinity(int *cpus, int size) {
+  auto affinity = ThreadPool::Instance().cpus();
+  for (int i = 0; i < size && i < static_cast<int>(affinity.size()); i++) {
+    cpus[i] = affinity[i];
+  }
+  return affinity.size();
+}
+
+void set_threads_affinity(const int *cpus, int count) {
+  if (count < 0 || (count > 0 && cpus == nullptr)) {
+    EINA_LOG_ERR("Invalid threads affinity (%d CPUs).", count);
+    return;
+  }
+  ThreadPool::Instance().set_cpus(std::vector<int>(cpus, cpus + count));
+}
+
+bool set_threads_numa_node(int node) {
+  auto cpus = ThreadPool::NumaNodeCpus(node);
+  if (cpus.empty()) {
+    EINA_LOG_ERR("NUMA node %d does not exist.", node);
+    return false;
+  }
+  ThreadPool::Instance().set_cpus(cpus);
+  return true;
+}
+
+int get_max_pending_extractions(void) {
+  return max_pending_extractions;
+}
+
+void set_max_pending_extractions(int value) {
+  if (value < 0) {
+    EINA_LOG_ERR("Invalid maximal number of pending extractions %d.", value);
+    return;
+  }
+  max_pending_extractions = value;
+}
+
+bool get_parallel_execution(void) {
+  return parallel_execution;
+}
+
+void set_parallel_execution(bool value) {
+  parallel_execution = value;
+}
+
+AccuracyTier get_accuracy(void) {
+  return accuracy;
+}
+
+void set_accuracy(AccuracyTier value) {
+  if (value != ACCURACY_EXACT && value != ACCURACY_BALANCED &&
+      value != ACCURACY_FAST) {
+    EINA_LOG_ERR("Invalid accuracy tier %d.", value);
+    return;
+  }
+  accuracy = value;
+}
+
+BuffersAllocatorType get_buffers_allocator(void) {
+  return buffers_allocator;
+}
+
+void set_buffers_allocator(BuffersAllocatorType value) {
+  if (value != BUFFERS_ALLOCATOR_SLIDING_BLOCKS &&
+      value != BUFFERS_ALLOCATOR_INTERVAL_PACKING) {
+    EINA_LOG_ERR("Invalid buffers allocator %d.", value);
+    return;
+  }
+  buffers_allocator = value;
+}
+
+bool get_cache_autotuning(void) {
+  return cache_autotuning;
+}
+
+void set_cache_autotuning(int value) {
+  cache_autotuning = value;
+}
+
+bool get_parallel_slices(void) {
+  return parallel_slices;
+}
+
+void set_parallel_slices(int value) {
+  parallel_slices = value;
+}
+
+bool get_warm_up(void) {
+  return warm_up;
+}
+
+void set_warm_up(int value) {
+  warm_up = value;
+}
+
+bool get_packed_results(void) {
+  return packed_results;
+}
+
+void set_packed_results(int value) {
+  packed_results = value;
+}
+
+bool get_constant_input_shortcut(void) {
+  return constant_input_shortcut;
+}
+
+void set_constant_input_shortcut(int value) {
+  constant_input_shortcut = value;
+}
+
+ProfilingLevelType get_profiling_level(void) {
+  return profiling_level;
+}
+
+void set_profiling_level(ProfilingLevelType value) {
+  if (value != PROFILING_LEVEL_OFF && value != PROFILING_LEVEL_COARSE &&
+      value != PROFILING_LEVEL_FULL) {
+    EINA_LOG_ERR("Invalid profiling level %d.", value);
+    return;
+  }
+  profiling_level = value;
+}
+
+bool get_parallel_chunks(void) {
+  return parallel_chunks;
+}
+
+void set_parallel_chunks(int value) {
+  parallel_chunks = value;
+}
+
 }  // extern "C"
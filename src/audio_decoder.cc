@@ -0,0 +1,327 @@
+/*! @file audio_decoder.cc
+ *  @brief Decoding of the compressed audio files ahead of the extraction.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+#include "src/audio_decoder.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#ifdef HAVE_FLAC
+#include <FLAC/stream_decoder.h>
+#endif
+#ifdef HAVE_OPUSFILE
+#include <opusfile.h>
+#endif
+
+namespace sound_feature_extraction {
+
+namespace {
+
+#ifdef HAVE_FLAC
+class FlacFileDecoder : public AudioDecoder {
+ public:
+  explicit FlacFileDecoder(const std::string& fileName)
+      : file_name_(fileName), decoder_(FLAC__stream_decoder_new()),
+        sampling_rate_(0), offset_(0), failed_(false) {
+    if (decoder_ == nullptr) {
+      throw AudioDecoderException(fileName, "failed to create the decoder");
+    }
+    if (FLAC__stream_decoder_init_file(
+            decoder_, fileName.c_str(), OnWrite, OnMetadata, OnError, this) !=
+        FLAC__STREAM_DECODER_INIT_STATUS_OK) {
+      FLAC__stream_decoder_delete(decoder_);
+      throw AudioDecoderException(fileName, "failed to open the FLAC stream");
+    }
+    if (!FLAC__stream_decoder_process_until_end_of_metadata(decoder_) ||
+        sampling_rate_ == 0) {
+      FLAC__stream_decoder_delete(decoder_);
+      throw AudioDecoderException(fileName, "invalid FLAC metadata");
+    }
+  }
+
+  virtual ~FlacFileDecoder() {
+    FLAC__stream_decoder_finish(decoder_);
+    FLAC__stream_decoder_delete(decoder_);
+  }
+
+  virtual int sampling_rate() const noexcept override {
+    return sampling_rate_;
+  }
+
+  virtual size_t Read(int16_t* samples, size_t count) override {
+    size_t read = 0;
+    while (read < count) {
+      if (offset_ == frame_.size()) {
+        frame_.clear();
+        offset_ = 0;
+        if (FLAC__stream_decoder_get_state(decoder_) ==
+            FLAC__STREAM_DECODER_END_OF_STREAM) {
+          break;
+        }
+        if (!FLAC__stream_decoder_process_single(decoder_) || failed_) {
+          throw AudioDecoderException(file_name_,
+                                      "the FLAC stream is corrupted");
+        }
+        continue;
+      }
+      size_t size = std::min(count - read, frame_.size() - offset_);
+      memcpy(samples + read, frame_.data() + offset_,
+             size * sizeof(samples[0]));
+      read += size;
+      offset_ += size;
+    }
+    return read;
+  }
+
+ private:
+  static FLAC__StreamDecoderWriteStatus OnWrite(
+      const FLAC__StreamDecoder*, const FLAC__Frame* frame,
+      const FLAC__int32* const buffer[], void* client) {
+    auto self = static_cast<FlacFileDecoder*>(client);
+    int channels = frame->header.channels;
+    int shift = static_cast<int>(frame->header.bits_per_sample) - 16;
+    for (unsigned i = 0; i < frame->header.blocksize; i++) {
+      int64_t sum = 0;
+      for (int c = 0; c < channels; c++) {
+        sum += buffer[c][i];
+      }
+      sum /= channels;
+      self->frame_.push_back(static_cast<int16_t>(
+          shift >= 0? sum >> shift : sum << -shift));
+    }
+    return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
+  }
+
+  static void OnMetadata(const FLAC__StreamDecoder*,
+                         const FLAC__StreamMetadata* metadata,
+                         void* client) {
+    if (metadata->type == FLAC__METADATA_TYPE_STREAMINFO) {
+      static_cast<FlacFileDecoder*>(client)->sampling_rate_ =
+          metadata->data.stream_info.sample_rate;
+    }
+  }
+
+  static void OnError(const FLAC__StreamDecoder*,
+                      FLAC__StreamDecoderErrorStatus, void* client) {
+    static_cast<FlacFileDecoder*>(client)->failed_ = true;
+  }
+
+  std::string file_name_;
+  FLAC__StreamDecoder* decoder_;
+  int sampling_rate_;
+  /// @brief The mono samples of the last decoded frame.
+  std::vector<int16_t> frame_;
+  /// @brief The number of the samples of frame_ which Read() returned.
+  size_t offset_;
+  bool failed_;
+};
+#endif
+
+#ifdef HAVE_OPUSFILE
+class OpusFileDecoder : public AudioDecoder {
+ public:
+  explicit OpusFileDecoder(const std::string& fileName)
+      : file_name_(fileName), file_(nullptr) {
+    int error;
+    file_ = op_open_file(fileName.c_str(), &error);
+    if (file_ == nullptr) {
+      throw AudioDecoderException(
+          fileName, "failed to open the Ogg Opus stream (error " +
+                    std::to_string(error) + ")");
+    }
+  }
+
+  virtual ~OpusFileDecoder() {
+    op_free(file_);
+  }
+
+  /// @brief Opus is always decoded at 48 kHz.
+  virtual int sampling_rate() const noexcept override {
+    return 48000;
+  }
+
+  virtual size_t Read(int16_t* samples, size_t count) override {
+    stereo_.resize(count * 2);
+    size_t read = 0;
+    while (read < count) {
+      int size = op_read_stereo(file_, stereo_.data(),
+                                static_cast<int>((count - read) * 2));
+      if (size == 0) {
+        break;
+      }
+      if (size == OP_HOLE) {
+        // The lost pages are skipped
+        continue;
+      }
+      if (size < 0) {
+        throw AudioDecoderException(
+            file_name_, "the Ogg Opus stream is corrupted (error " +
+                        std::to_string(size) + ")");
+      }
+      for (int i = 0; i < size; i++) {
+        samples[read + i] = (stereo_[i * 2] + stereo_[i * 2 + 1]) / 2;
+      }
+      read += size;
+    }
+    return read;
+  }
+
+ private:
+  std::string file_name_;
+  OggOpusFile* file_;
+  std::vector<opus_int16> stereo_;
+};
+#endif
+
+}  // namespace
+
+std::unique_ptr<AudioDecoder> AudioDecoder::Open(const std::string& fileName) {
+  char signature[36] = {};
+  std::ifstream file(fileName, std::ios::binary);
+  if (!file) {
+    throw AudioDecoderException(fileName, "failed to open the file");
+  }
+  file.read(signature, sizeof(signature));
+  if (memcmp(signature, "fLaC", 4) == 0) {
+#ifdef HAVE_FLAC
+    return std::unique_ptr<AudioDecoder>(new FlacFileDecoder(fileName));
+#else
+    throw AudioDecoderException(fileName, "FLAC support was not built in");
+#endif
+  }
+  // The first Ogg page starts with the Opus identification header
+  if (memcmp(signature, "OggS", 4) == 0 &&
+      memcmp(signature + 28, "OpusHead", 8) == 0) {
+#ifdef HAVE_OPUSFILE
+    return std::unique_ptr<AudioDecoder>(new OpusFileDecoder(fileName));
+#else
+    throw AudioDecoderException(fileName, "Opus support was not built in");
+#endif
+  }
+  throw AudioDecoderException(fileName, "unsupported format");
+}
+
+DecodingSource::DecodingSource(std::unique_ptr<AudioDecoder>&& decoder,
+                               size_t blockSize, int depth)
+    : decoder_(std::move(decoder)), block_size_(blockSize),
+      blocks_(std::max(depth, 2)), decoded_(0), consumed_(0), released_(0),
+      finished_(false), stopping_(false) {
+  for (auto& block : blocks_) {
+    block.Samples.resize(blockSize);
+    block.Count = 0;
+  }
+  thread_ = std::thread(&DecodingSource::Work, this);
+}
+
+DecodingSource::~DecodingSource() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  changed_.notify_all();
+  thread_.join();
+}
+
+int DecodingSource::sampling_rate() const noexcept {
+  return decoder_->sampling_rate();
+}
+
+size_t DecodingSource::block_size() const noexcept {
+  return block_size_;
+}
+
+int DecodingSource::depth() const noexcept {
+  return blocks_.size();
+}
+
+const int16_t* DecodingSource::Next(size_t* count) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  // The previous block is free to be decoded into
+  released_ = consumed_;
+  changed_.notify_all();
+  changed_.wait(lock, [this] { return decoded_ > consumed_ || finished_; });
+  if (decoded_ > consumed_) {
+    auto& block = blocks_[consumed_++ % blocks_.size()];
+    *count = block.Count;
+    return block.Samples.data();
+  }
+  if (error_) {
+    auto error = error_;
+    error_ = nullptr;
+    std::rethrow_exception(error);
+  }
+  *count = 0;
+  return nullptr;
+}
+
+void DecodingSource::Work() noexcept {
+  for (;;) {
+    uint64_t index;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      changed_.wait(lock, [this] {
+        return stopping_ || decoded_ < released_ + blocks_.size();
+      });
+      if (stopping_) {
+        return;
+      }
+      index = decoded_;
+    }
+    // The consumer does not touch the block until decoded_ is incremented
+    auto& block = blocks_[index % blocks_.size()];
+    block.Count = 0;
+    bool eof = false;
+    try {
+      while (block.Count < block_size_ && !eof) {
+        size_t size = decoder_->Read(block.Samples.data() + block.Count,
+                                     block_size_ - block.Count);
+        block.Count += size;
+        eof = size == 0;
+      }
+    }
+    catch(...) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      error_ = std::current_exception();
+      finished_ = true;
+      changed_.notify_all();
+      return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (block.Count > 0) {
+      decoded_++;
+    }
+    finished_ = eof;
+    changed_.notify_all();
+    if (eof) {
+      return;
+    }
+  }
+}
+
+}  // namespace sound_feature_extraction
@@ -0,0 +1,132 @@
+/*! @file audio_decoder.h
+ *  @brief Decoding of the compressed audio files ahead of the extraction.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+#ifndef SRC_AUDIO_DECODER_H_
+#define SRC_AUDIO_DECODER_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "src/exceptions.h"
+
+namespace sound_feature_extraction {
+
+class AudioDecoderException : public ExceptionBase {
+ public:
+  AudioDecoderException(const std::string& file, const std::string& reason)
+  : ExceptionBase("Audio file \"" + file + "\": " + reason + ".") {
+  }
+};
+
+/// @brief Decodes a compressed audio file into mono 16-bit samples piece
+/// by piece, so that the extraction can start before the whole file is
+/// decoded. The channels are averaged.
+class AudioDecoder {
+ public:
+  virtual ~AudioDecoder() = default;
+
+  /// @brief Opens a FLAC or an Ogg Opus file, which is detected by its
+  /// signature.
+  /// @throw AudioDecoderException if the file cannot be read, its format
+  /// is unknown or the library was built without its decoder.
+  static std::unique_ptr<AudioDecoder> Open(const std::string& fileName);
+
+  virtual int sampling_rate() const noexcept = 0;
+
+  /// @brief Decodes up to count samples.
+  /// @return The number of the decoded samples, 0 at the end of the file.
+  /// @throw AudioDecoderException if the stream is corrupted.
+  virtual size_t Read(int16_t* samples, size_t count) = 0;
+};
+
+/// @brief Runs an AudioDecoder on its own thread ahead of the consumer,
+/// which receives the decoded samples in the blocks of the fixed size.
+/// @details Up to depth blocks are decoded in advance, so while the consumer
+/// extracts the features from a block, the following ones are being
+/// decoded, and the time of a file approaches the maximum of the decoding
+/// and the extraction times instead of their sum.
+class DecodingSource {
+ public:
+  DecodingSource(std::unique_ptr<AudioDecoder>&& decoder, size_t blockSize,
+                 int depth = 4);
+  /// @brief Stops the decoding thread.
+  ~DecodingSource();
+
+  DecodingSource(const DecodingSource&) = delete;
+  DecodingSource& operator=(const DecodingSource&) = delete;
+
+  /// @brief Waits for the next decoded block. It stays valid until
+  /// the next call.
+  /// @param count Receives the number of the samples in the block, which is
+  /// block_size() for all the blocks but the last one.
+  /// @return nullptr after the last block.
+  /// @throw AudioDecoderException which the decoding thread caught.
+  const int16_t* Next(size_t* count);
+
+  int sampling_rate() const noexcept;
+  size_t block_size() const noexcept;
+  int depth() const noexcept;
+
+ private:
+  struct Block {
+    std::vector<int16_t> Samples;
+    size_t Count;
+  };
+
+  /// @brief The body of the decoding thread.
+  void Work() noexcept;
+
+  std::unique_ptr<AudioDecoder> decoder_;
+  size_t block_size_;
+  /// @brief The ring of the blocks, the block Sequence % depth is at
+  /// blocks_[Sequence % depth].
+  std::vector<Block> blocks_;
+  /// @brief The number of the decoded blocks.
+  uint64_t decoded_;
+  /// @brief The number of the blocks returned by Next().
+  uint64_t consumed_;
+  /// @brief The number of the blocks which the consumer no longer reads.
+  uint64_t released_;
+  bool finished_;
+  bool stopping_;
+  std::exception_ptr error_;
+  std::mutex mutex_;
+  std::condition_variable changed_;
+  std::thread thread_;
+};
+
+}  // namespace sound_feature_extraction
+
+#endif  // SRC_AUDIO_DECODER_H_
@@ -0,0 +1,181 @@
+/*! @file buffer_capture.cc
+ *  @brief Asynchronous binary snapshots of the buffers of the transforms.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+
+#include "src/buffer_capture.h"
+#include <algorithm>
+#include <cstring>
+#include "src/buffers.h"
+
+namespace sound_feature_extraction {
+
+constexpr char BufferCapture::kMagic[9];
+constexpr size_t BufferCapture::kDefaultRingSize;
+
+BufferCapture::BufferCapture(const std::string& fileName,
+                             const std::vector<std::string>& transforms,
+                             size_t ringSize)
+    : file_name_(fileName), file_(nullptr),
+      transforms_(transforms.begin(), transforms.end()),
+      ring_size_(ringSize), head_(0), used_(0), executions_(0),
+      captured_records_(0), dropped_records_(0), failed_(false),
+      closed_(false), stop_(false) {
+  if (ringSize == 0) {
+    throw BufferCaptureException(fileName, "the ring must not be empty");
+  }
+  file_ = fopen(fileName.c_str(), "wb");
+  if (file_ == nullptr) {
+    throw BufferCaptureException(fileName, "failed to create the file");
+  }
+  // Touch the pages now, not during the first capture
+  ring_.reset(new char[ringSize]);
+  memset(ring_.get(), 0, ringSize);
+  failed_ = fwrite(kMagic, 1, 8, file_) != 8;
+  worker_ = std::thread(&BufferCapture::Work, this);
+}
+
+BufferCapture::~BufferCapture() {
+  Close();
+}
+
+const std::string& BufferCapture::file_name() const noexcept {
+  return file_name_;
+}
+
+size_t BufferCapture::ring_size() const noexcept {
+  return ring_size_;
+}
+
+size_t BufferCapture::captured_records() const noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return captured_records_;
+}
+
+size_t BufferCapture::dropped_records() const noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return dropped_records_;
+}
+
+bool BufferCapture::Captures(const std::string& transform) const noexcept {
+  return transforms_.empty() || transforms_.count(transform) > 0;
+}
+
+uint64_t BufferCapture::NextExecution() noexcept {
+  return executions_++;
+}
+
+void BufferCapture::Put(const void* data, size_t size) noexcept {
+  auto ptr = reinterpret_cast<const char*>(data);
+  size_t first = std::min(size, ring_size_ - head_);
+  memcpy(ring_.get() + head_, ptr, first);
+  memcpy(ring_.get(), ptr + first, size - first);
+  head_ = (head_ + size) % ring_size_;
+  used_ += size;
+}
+
+void BufferCapture::PutString(const std::string& str) noexcept {
+  uint32_t length = str.size();
+  Put(&length, sizeof(length));
+  Put(str.data(), length);
+}
+
+void BufferCapture::Capture(uint64_t execution, size_t node, int slice,
+                            const std::string& transform,
+                            const Buffers& buffers) noexcept {
+  auto format = buffers.Format();
+  auto description = format->ToString();
+  uint64_t count = buffers.Count();
+  uint64_t size = format->UnalignedSizeInBytes();
+  size_t record_size = sizeof(execution) + sizeof(uint32_t) +
+      sizeof(int32_t) + 3 * sizeof(uint32_t) + transform.size() +
+      format->Id().size() + description.size() + sizeof(count) +
+      sizeof(size) + count * size;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (closed_) {
+      return;
+    }
+    if (ring_size_ - used_ < record_size) {
+      dropped_records_++;
+      return;
+    }
+    uint32_t node32 = node;
+    int32_t slice32 = slice;
+    Put(&execution, sizeof(execution));
+    Put(&node32, sizeof(node32));
+    Put(&slice32, sizeof(slice32));
+    PutString(transform);
+    PutString(format->Id());
+    PutString(description);
+    Put(&count, sizeof(count));
+    Put(&size, sizeof(size));
+    for (size_t i = 0; i < count; i++) {
+      Put(buffers[i], size);
+    }
+    captured_records_++;
+  }
+  changed_.notify_one();
+}
+
+void BufferCapture::Work() noexcept {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    changed_.wait(lock, [this] { return stop_ || used_ > 0; });
+    if (used_ == 0) {
+      return;
+    }
+    // Capture() does not touch the bytes until used_ is decreased
+    size_t tail = (head_ + ring_size_ - used_) % ring_size_;
+    size_t length = std::min(used_, ring_size_ - tail);
+    lock.unlock();
+    bool written = fwrite(ring_.get() + tail, 1, length, file_) == length;
+    lock.lock();
+    failed_ |= !written;
+    used_ -= length;
+  }
+}
+
+bool BufferCapture::Close() noexcept {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (closed_) {
+      return !failed_;
+    }
+    closed_ = true;
+    stop_ = true;
+  }
+  changed_.notify_one();
+  worker_.join();
+  failed_ |= fclose(file_) != 0;
+  return !failed_;
+}
+
+}  // namespace sound_feature_extraction
@@ -0,0 +1,131 @@
+/*! @file buffer_capture.h
+ *  @brief Asynchronous binary snapshots of the buffers of the transforms.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+
+#ifndef SRC_BUFFER_CAPTURE_H_
+#define SRC_BUFFER_CAPTURE_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include "src/exceptions.h"
+
+namespace sound_feature_extraction {
+
+class Buffers;
+
+class BufferCaptureException : public ExceptionBase {
+ public:
+  BufferCaptureException(const std::string& file, const std::string& reason)
+  : ExceptionBase("Buffer capture \"" + file + "\": " + reason + ".") {
+  }
+};
+
+/// @brief Writes the buffers of the selected transforms to a binary file.
+/// @details Unlike TransformTree::dump_buffers_after_each_transform(), the
+/// buffers are not formatted: Capture() copies the raw bytes into a ring of
+/// preallocated memory and a background thread writes the ring to the file.
+/// The records which do not fit into the free space of the ring are dropped
+/// instead of stalling the execution, see dropped_records().
+///
+/// The file starts with kMagic, followed by the records, each of them is
+/// (in the native byte order):
+/// uint64 execution, uint32 node index, int32 slice index,
+/// uint32 length + transform name, uint32 length + format identifier,
+/// uint32 length + format description, uint64 buffers count,
+/// uint64 buffer size in bytes, the unaligned buffers one after another.
+/// python/sound_feature_extraction/capture.py reads it.
+class BufferCapture {
+ public:
+  static constexpr char kMagic[9] = "SFECAPTR";
+  static constexpr size_t kDefaultRingSize = 64 << 20;
+
+  /// @param transforms The names of the captured transforms, all if empty.
+  /// @param ringSize The size of the ring in bytes, it limits the size of
+  /// a single record.
+  BufferCapture(const std::string& fileName,
+                const std::vector<std::string>& transforms,
+                size_t ringSize = kDefaultRingSize);
+  /// @brief Calls Close() if it was not called.
+  ~BufferCapture();
+
+  bool Captures(const std::string& transform) const noexcept;
+  /// @brief Returns the index of the next execution to pass to Capture().
+  uint64_t NextExecution() noexcept;
+  /// @brief Copies the buffers into the ring. It is safe to call this from
+  /// several threads at once.
+  void Capture(uint64_t execution, size_t node, int slice,
+               const std::string& transform, const Buffers& buffers) noexcept;
+  /// @brief Writes the rest of the ring and closes the file.
+  /// @return false if any write failed.
+  bool Close() noexcept;
+
+  const std::string& file_name() const noexcept;
+  size_t ring_size() const noexcept;
+  size_t captured_records() const noexcept;
+  size_t dropped_records() const noexcept;
+
+ private:
+  /// @brief Copies the bytes to the head of the ring, mutex_ must be held.
+  void Put(const void* data, size_t size) noexcept;
+  void PutString(const std::string& str) noexcept;
+  void Work() noexcept;
+
+  std::string file_name_;
+  FILE* file_;
+  std::set<std::string> transforms_;
+  std::unique_ptr<char[]> ring_;
+  size_t ring_size_;
+  /// @brief The position of the next byte put into the ring.
+  size_t head_;
+  /// @brief The number of the bytes which were not written yet.
+  size_t used_;
+  std::atomic<uint64_t> executions_;
+  size_t captured_records_;
+  size_t dropped_records_;
+  bool failed_;
+  bool closed_;
+  bool stop_;
+  mutable std::mutex mutex_;
+  std::condition_variable changed_;
+  std::thread worker_;
+};
+
+}  // namespace sound_feature_extraction
+
+#endif  // SRC_BUFFER_CAPTURE_H_
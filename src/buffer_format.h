@@ -83,6 +83,8 @@ class BufferFormat {
 
   static void ValidateSamplingRate(int value);
 
+  static constexpr int kMinSamplingRate = 2000;
+
   template <typename T>
   static T Aligned(T value) noexcept {
     return (value & (0x80 - 1)) == 0? value : (value & ~(0x80 - 1)) + 0x80;
@@ -92,7 +94,6 @@ class BufferFormat {
   static constexpr const char* kIdentityID = "identity";
 
  private:
-  static constexpr int kMinSamplingRate = 2000;
   static constexpr int kMaxSamplingRate = 48000;
 
   std::string id_;
@@ -32,25 +32,23 @@
 #include <cassert>
 #include <cstring>
 #include <simd/memory.h>
+#include "src/buffers_base.h"
+#include "src/primitives/validate.h"
+#include "src/simd_aware.h"
 
 namespace sound_feature_extraction {
 
 Buffers::Buffers(const std::shared_ptr<BufferFormat>& format,
-                 size_t count, void* reusedMemory) noexcept
+                 size_t count, void* reusedMemory, size_t stride) noexcept
     : format_(format),
-      count_(count) {
+      count_(count),
+      stride_(stride != 0? stride : format->SizeInBytes()) {
   assert(count <= (1 << 30));
-  count_ = count;
-  size_t sizeEach = format_->SizeInBytes();
-  void* memory = reusedMemory == nullptr ?
-      malloc_aligned(count_ * sizeEach) : reusedMemory;
-  buffers_ = std::shared_ptr<void>(
-      memory,
-      [=](void* buffers) {
-        if (reusedMemory == nullptr) {
-          free(buffers);
-        }
-      });
+  if (reusedMemory == nullptr) {
+    buffers_ = std::shared_ptr<void>(malloc_aligned(SizeInBytes()), free);
+  } else {
+    Rebind(reusedMemory);
+  }
 }
 
 Buffers& Buffers::operator=(const Buffers& other) {
@@ -60,6 +58,7 @@ Buffers& Buffers::operator=(const Buffers& other) {
   format_ = other.format_;
   std::memcpy(Data(), other.Data(), other.SizeInBytes());
   count_ = other.count_;
+  stride_ = other.stride_;
   return *this;
 }
 
@@ -68,23 +67,18 @@ size_t Buffers::Count() const noexcept {
 }
 
 size_t Buffers::SizeInBytes() const noexcept {
-  return count_ * format_->SizeInBytes();
-}
-
-std::shared_ptr<BufferFormat> Buffers::Format() const noexcept {
-  return format_;
+  if (count_ == 0) {
+    return 0;
+  }
+  return (count_ - 1) * stride_ + format_->SizeInBytes();
 }
 
-void* Buffers::operator[](size_t index) noexcept {
-  assert(index < Count());
-  return reinterpret_cast<char*>(buffers_.get()) +
-      index * format_->SizeInBytes();
+size_t Buffers::Stride() const noexcept {
+  return stride_;
 }
 
-const void* Buffers::operator[](size_t index) const noexcept {
-  assert(index < Count());
-  return reinterpret_cast<const char*>(buffers_.get()) +
-      index * format_->SizeInBytes();
+std::shared_ptr<BufferFormat> Buffers::Format() const noexcept {
+  return format_;
 }
 
 Buffers Buffers::Slice(size_t index, size_t length) const {
@@ -92,7 +86,13 @@ Buffers Buffers::Slice(size_t index, size_t length) const {
     throw InvalidSliceException(index, length, count_);
   }
   return Buffers(format_, length, reinterpret_cast<char*>(buffers_.get()) +
-                                  index * format_->SizeInBytes());
+                                  index * stride_, stride_);
+}
+
+void Buffers::Rebind(void* reusedMemory) noexcept {
+  // The aliasing constructor with an empty owner does not allocate
+  // the control block, so the views are free
+  buffers_ = std::shared_ptr<void>(std::shared_ptr<void>(), reusedMemory);
 }
 
 void* Buffers::Data() noexcept {
@@ -139,4 +139,18 @@ std::string Buffers::ToString() const noexcept {
   return ret;
 }
 
+namespace validation {
+
+template <>
+size_t FindInvalid(const float* array, size_t length, bool* allZeros)
+    noexcept {
+  int nonzero = 0;
+  size_t index = find_nonfinite(SimdAware::use_simd(), array, length,
+                                &nonzero);
+  *allZeros &= !nonzero;
+  return index;
+}
+
+}  // namespace validation
+
 } /* namespace sound_feature_extraction */
@@ -31,6 +31,7 @@
 #ifndef SRC_BUFFERS_H_
 #define SRC_BUFFERS_H_
 
+#include <cassert>
 #include <memory>
 #include "src/buffer_format.h"
 
@@ -38,8 +39,13 @@ namespace sound_feature_extraction {
 
 class Buffers {
  public:
+  /// @param stride The distance in bytes between the starts of the sequential
+  /// buffers. It may be less than the format's size if the buffers overlap,
+  /// e.g. for the frames of a signal (see ViewTransform). 0 means the format's
+  /// SizeInBytes().
   Buffers(const std::shared_ptr<BufferFormat>& format,
-          size_t count = 0, void* reusedMemory = nullptr) noexcept;
+          size_t count = 0, void* reusedMemory = nullptr,
+          size_t stride = 0) noexcept;
   Buffers& operator=(const Buffers& other);
 
   virtual ~Buffers() {
@@ -47,11 +53,28 @@ class Buffers {
 
   const void* Data() const noexcept;
   size_t Count() const noexcept;
+  /// @brief Returns the number of bytes spanned by the buffers.
   size_t SizeInBytes() const noexcept;
+  size_t Stride() const noexcept;
+
+  /// @brief Returns the address of the buffer with the specified index.
+  /// @note The stride is cached on construction, so that this does not
+  /// involve any virtual call in the Do() loops.
+  void* operator[](size_t index) noexcept {
+    assert(index < count_);
+    return reinterpret_cast<char*>(buffers_.get()) + index * stride_;
+  }
+
+  const void* operator[](size_t index) const noexcept {
+    assert(index < count_);
+    return reinterpret_cast<const char*>(buffers_.get()) + index * stride_;
+  }
 
-  void* operator[](size_t index) noexcept;
-  const void* operator[](size_t index) const noexcept;
   Buffers Slice(size_t index, size_t length) const;
+  /// @brief Points the buffers to the memory which is owned by someone else
+  /// and has the same layout, e.g. after TransformTree::ReleaseMemory().
+  /// This never allocates.
+  void Rebind(void* reusedMemory) noexcept;
 
   std::shared_ptr<BufferFormat> Format() const noexcept;
 
@@ -69,6 +92,8 @@ class Buffers {
   std::shared_ptr<BufferFormat> format_;
   std::shared_ptr<void> buffers_;
   size_t count_;
+  /// @brief The cached format_->SizeInBytes() unless the buffers overlap.
+  size_t stride_;
 };
 
 /// @brief This exception is thrown when an attempt is made to assign "my"
@@ -122,6 +122,25 @@ namespace validation {
           value != -std::numeric_limits<float>::infinity();
     }
   };
+
+  /// @brief Returns the index of the first item of the array which
+  /// Validator rejects, or length. Resets allZeros if some item is not zero.
+  template <class TE>
+  size_t FindInvalid(const TE* array, size_t length, bool* allZeros)
+      noexcept {
+    for (size_t j = 0; j < length; j++) {
+      if (!Validator<TE>::Validate(array[j])) {
+        return j;
+      }
+      *allZeros &= (array[j] == 0);
+    }
+    return length;
+  }
+
+  /// @brief Scans the whole array with SIMD, see find_nonfinite().
+  template <>
+  size_t FindInvalid(const float* array, size_t length, bool* allZeros)
+      noexcept;
 }  // namespace validation
 
 template <typename T>
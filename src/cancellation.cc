@@ -0,0 +1,91 @@
+/*! @file cancellation.cc
+ *  @brief Cancellation of the running extractions.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+#include "src/cancellation.h"
+
+namespace sound_feature_extraction {
+
+static thread_local const CancellationToken* current_token = nullptr;
+
+CancellationSource::CancellationSource() noexcept : epoch_(0) {
+}
+
+void CancellationSource::Cancel() noexcept {
+  epoch_++;
+}
+
+uint64_t CancellationSource::epoch() const noexcept {
+  return epoch_.load(std::memory_order_relaxed);
+}
+
+CancellationToken::CancellationToken(
+    const CancellationSource* source, std::chrono::nanoseconds timeout)
+    noexcept
+    : source_(source), epoch_(source != nullptr? source->epoch() : 0),
+      has_deadline_(timeout > std::chrono::nanoseconds::zero()),
+      deadline_(std::chrono::steady_clock::now() + timeout),
+      cancelled_(false), previous_(current_token) {
+  current_token = this;
+}
+
+CancellationToken::~CancellationToken() {
+  current_token = previous_;
+}
+
+bool CancellationToken::cancelled() const noexcept {
+  if (cancelled_.load(std::memory_order_relaxed)) {
+    return true;
+  }
+  if ((source_ != nullptr && source_->epoch() != epoch_) ||
+      (has_deadline_ && std::chrono::steady_clock::now() >= deadline_)) {
+    cancelled_.store(true, std::memory_order_relaxed);
+    return true;
+  }
+  return false;
+}
+
+CancellationScope::CancellationScope(const CancellationToken* token) noexcept
+    : previous_(current_token) {
+  current_token = token;
+}
+
+CancellationScope::~CancellationScope() {
+  current_token = previous_;
+}
+
+const CancellationToken* CurrentCancellationToken() noexcept {
+  return current_token;
+}
+
+bool ExecutionCancelled() noexcept {
+  return current_token != nullptr && current_token->cancelled();
+}
+
+}  // namespace sound_feature_extraction
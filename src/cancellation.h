@@ -0,0 +1,104 @@
+/*! @file cancellation.h
+ *  @brief Cancellation of the running extractions.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+#ifndef SRC_CANCELLATION_H_
+#define SRC_CANCELLATION_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace sound_feature_extraction {
+
+/// @brief Cancels the executions which have started with its tokens.
+/// The executions which start afterwards are not affected.
+class CancellationSource {
+ public:
+  CancellationSource() noexcept;
+
+  void Cancel() noexcept;
+  uint64_t epoch() const noexcept;
+
+ private:
+  std::atomic<uint64_t> epoch_;
+};
+
+/// @brief Makes the execution in the calling thread cancellable until
+/// the end of the scope. The tree checks ExecutionCancelled() between
+/// the nodes and ThreadPool between the chunks of the parallel loops,
+/// the long transforms check it between their iterations.
+class CancellationToken {
+ public:
+  /// @param source May be nullptr, then only timeout cancels.
+  /// @param timeout Zero means no timeout.
+  explicit CancellationToken(
+      const CancellationSource* source,
+      std::chrono::nanoseconds timeout = std::chrono::nanoseconds::zero())
+      noexcept;
+  ~CancellationToken();
+
+  CancellationToken(const CancellationToken&) = delete;
+  CancellationToken& operator=(const CancellationToken&) = delete;
+
+  bool cancelled() const noexcept;
+
+ private:
+  const CancellationSource* source_;
+  uint64_t epoch_;
+  bool has_deadline_;
+  std::chrono::steady_clock::time_point deadline_;
+  /// @brief Once cancelled, the token stays so without reading the clock.
+  mutable std::atomic<bool> cancelled_;
+  const CancellationToken* previous_;
+};
+
+/// @brief Puts the token in effect in the calling thread until the end of
+/// the scope. ThreadPool passes the tokens to the workers this way.
+class CancellationScope {
+ public:
+  explicit CancellationScope(const CancellationToken* token) noexcept;
+  ~CancellationScope();
+
+  CancellationScope(const CancellationScope&) = delete;
+  CancellationScope& operator=(const CancellationScope&) = delete;
+
+ private:
+  const CancellationToken* previous_;
+};
+
+/// @brief Returns the token in effect in the calling thread or nullptr.
+const CancellationToken* CurrentCancellationToken() noexcept;
+
+/// @brief Indicates whether the execution in the calling thread should stop.
+bool ExecutionCancelled() noexcept;
+
+}  // namespace sound_feature_extraction
+
+#endif  // SRC_CANCELLATION_H_
@@ -0,0 +1,107 @@
+/*! @file elementwise_transform.h
+ *  @brief Interface of the transforms which may be fused into a single pass.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#ifndef SRC_ELEMENTWISE_TRANSFORM_H_
+#define SRC_ELEMENTWISE_TRANSFORM_H_
+
+namespace sound_feature_extraction {
+
+/// @brief Implemented by the transforms of floating point arrays which
+/// calculate each output value only from the input value with the same
+/// index, keeping the size.
+/// @details TransformTree composes the consecutive nodes of such transforms
+/// into a single transforms::ElementwiseChain which runs all the kernels on
+/// a small tile before moving on to the next one, so the intermediate
+/// buffers are never written to memory.
+class ElementwiseTransform {
+ public:
+#if (__GNUC__ == 4 && __GNUC_MINOR__ < 8)
+  virtual ~ElementwiseTransform() {};
+#else
+  virtual ~ElementwiseTransform() = default;
+#endif
+
+  /// @brief Applies the transform to length values.
+  /// @param in The aligned input array.
+  /// @param length The number of values to process.
+  /// @param out The aligned output array, may be equal to in.
+  virtual void DoElementwise(const float* in, int length,
+                             float* out) const noexcept = 0;
+};
+
+/// @brief Implemented by the transforms which convert each floating point
+/// value to a narrower type T, keeping the size.
+/// @details TransformTree appends such a node to the preceding
+/// ElementwiseTransform chain (see transforms::ElementwiseNarrowingChain),
+/// so the float values of the feature are never written to memory.
+template <class T>
+class NarrowingTransform {
+ public:
+#if (__GNUC__ == 4 && __GNUC_MINOR__ < 8)
+  virtual ~NarrowingTransform() {};
+#else
+  virtual ~NarrowingTransform() = default;
+#endif
+
+  /// @brief Converts length values.
+  /// @param in The aligned input array.
+  /// @param length The number of values to process.
+  /// @param out The output array.
+  virtual void DoNarrowing(const float* in, int length,
+                           T* out) const noexcept = 0;
+};
+
+/// @brief Implemented by the transforms which convert each value of type T
+/// to floating point, keeping the size.
+/// @details TransformTree prepends such a node to the following
+/// ElementwiseTransform chain (see transforms::ElementwiseWideningChain),
+/// so the converted values are processed while they are still in the cache.
+template <class T>
+class WideningTransform {
+ public:
+#if (__GNUC__ == 4 && __GNUC_MINOR__ < 8)
+  virtual ~WideningTransform() {};
+#else
+  virtual ~WideningTransform() = default;
+#endif
+
+  /// @brief Converts length values and applies out = value * scale + offset.
+  /// @param in The input array.
+  /// @param length The number of values to process.
+  /// @param scale The multiplier of each converted value.
+  /// @param offset The addend of each scaled value.
+  /// @param out The aligned output array.
+  virtual void DoWidening(const T* in, int length, float scale, float offset,
+                          float* out) const noexcept = 0;
+};
+
+}  // namespace sound_feature_extraction
+#endif  // SRC_ELEMENTWISE_TRANSFORM_H_
@@ -0,0 +1,61 @@
+/*! @file execution_overrides.cc
+ *  @brief Per-configuration overrides of the process-wide execution settings.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+#include "src/execution_overrides.h"
+
+namespace sound_feature_extraction {
+
+static thread_local const ExecutionOverrides* current_overrides = nullptr;
+static thread_local ExecutionOverrides thread_overrides;
+
+const ExecutionOverrides* CurrentExecutionOverrides() noexcept {
+  return current_overrides;
+}
+
+void SetThreadExecutionOverrides(const ExecutionOverrides* value) noexcept {
+  if (value == nullptr) {
+    current_overrides = nullptr;
+    return;
+  }
+  thread_overrides = *value;
+  current_overrides = &thread_overrides;
+}
+
+ScopedExecutionOverrides::ScopedExecutionOverrides(
+    const ExecutionOverrides* overrides) noexcept
+    : previous_(current_overrides) {
+  current_overrides = overrides;
+}
+
+ScopedExecutionOverrides::~ScopedExecutionOverrides() {
+  current_overrides = previous_;
+}
+
+}  // namespace sound_feature_extraction
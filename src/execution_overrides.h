@@ -0,0 +1,87 @@
+/*! @file execution_overrides.h
+ *  @brief Per-configuration overrides of the process-wide execution settings.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+#ifndef SRC_EXECUTION_OVERRIDES_H_
+#define SRC_EXECUTION_OVERRIDES_H_
+
+#include <cstddef>
+
+namespace sound_feature_extraction {
+
+/// @brief The execution settings which replace the process-wide ones
+/// (set_use_simd(), set_omp_transforms_max_threads_num(),
+/// set_cpu_cache_size(), set_chunk_size() and set_prefer_gpu_fft()) while
+/// they are in effect.
+/// @details The negative UseSimd and PreferGpu, the non-positive
+/// ThreadsNumber and the zero sizes follow the process-wide values.
+struct ExecutionOverrides {
+  ExecutionOverrides() noexcept
+      : UseSimd(-1), ThreadsNumber(0), CpuCacheSize(0), ChunkSize(0),
+        PreferGpu(-1) {
+  }
+
+  int UseSimd;
+  int ThreadsNumber;
+  size_t CpuCacheSize;
+  size_t ChunkSize;
+  int PreferGpu;
+};
+
+/// @brief Returns the overrides in effect in the calling thread or nullptr.
+/// @details ThreadPool passes them to the workers which execute the tasks
+/// of ParallelFor() and TaskGroup, so they hold for all the transforms of
+/// a tree execution.
+const ExecutionOverrides* CurrentExecutionOverrides() noexcept;
+
+/// @brief Sets the overrides of the calling thread outside of any
+/// ScopedExecutionOverrides. The value is copied, nullptr resets them.
+void SetThreadExecutionOverrides(const ExecutionOverrides* value) noexcept;
+
+/// @brief Puts the overrides in effect in the calling thread until
+/// the end of the scope.
+class ScopedExecutionOverrides {
+ public:
+  /// @param overrides Must outlive the scope. nullptr means the process-wide
+  /// values.
+  explicit ScopedExecutionOverrides(
+      const ExecutionOverrides* overrides) noexcept;
+  ~ScopedExecutionOverrides();
+
+  ScopedExecutionOverrides(const ScopedExecutionOverrides&) = delete;
+  ScopedExecutionOverrides& operator=(
+      const ScopedExecutionOverrides&) = delete;
+
+ private:
+  const ExecutionOverrides* previous_;
+};
+
+}  // namespace sound_feature_extraction
+
+#endif  // SRC_EXECUTION_OVERRIDES_H_
@@ -0,0 +1,191 @@
+/*! @file execution_pipeline.cc
+ *  @brief Software pipeline of the stages of a transform tree.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+#include "src/execution_pipeline.h"
+#include <algorithm>
+#include <cassert>
+
+namespace sound_feature_extraction {
+
+ExecutionPipeline::ExecutionPipeline(
+    const std::shared_ptr<const TransformTree>& tree, int stagesCount,
+    int depth)
+    : tree_(tree), pushed_(0), popped_(0), stopping_(false) {
+  assert(stagesCount > 0 && depth > 0);
+  if (!tree->tree_is_prepared_) {
+    throw TreeIsNotPreparedException();
+  }
+  PlanStages(stagesCount);
+  slots_.resize(depth);
+  for (auto& slot : slots_) {
+    slot.Context = tree->CreateExecutionContext();
+    slot.Sequence = 0;
+    slot.Stage = stages_count();
+  }
+  for (int stage = 0; stage < stages_count(); stage++) {
+    threads_.emplace_back(&ExecutionPipeline::Work, this, stage);
+  }
+}
+
+ExecutionPipeline::~ExecutionPipeline() {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    changed_.wait(lock, [this] {
+      return std::all_of(slots_.begin(), slots_.end(),
+                         [this](const Slot& slot) {
+        return slot.Stage == stages_count();
+      });
+    });
+    stopping_ = true;
+  }
+  changed_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+void ExecutionPipeline::PlanStages(int stagesCount) {
+  // The last execution times are the best estimation; before the first
+  // execution, the sizes of the buffers are
+  std::vector<TransformTree::Node*> nodes;
+  for (auto node = tree_->root_->Next; node != nullptr; node = node->Next) {
+    nodes.push_back(node);
+  }
+  bool measured = std::any_of(
+      nodes.begin(), nodes.end(), [](const TransformTree::Node* node) {
+    return node->LastTicks.load(std::memory_order_relaxed) > 0;
+  });
+  std::vector<double> weights;
+  double total = 0;
+  for (auto node : nodes) {
+    double weight = 0;
+    if (!node->View) {
+      weight = measured? node->LastTicks.load(std::memory_order_relaxed) :
+                         node->AllocationSize();
+    }
+    weights.push_back(weight);
+    total += weight;
+  }
+  // The stage which starts at the root converts the input; the sliced
+  // cycles are never split between the stages
+  stages_.assign(1, tree_->root_.get());
+  double accumulated = 0;
+  for (size_t i = 0; i < nodes.size(); i++) {
+    int count = stages_.size();
+    if (count < stagesCount && nodes[i]->OriginalNode == nullptr &&
+        accumulated > 0 && accumulated >= total * count / stagesCount) {
+      stages_.push_back(nodes[i]);
+    }
+    accumulated += weights[i];
+  }
+  stages_.push_back(nullptr);
+}
+
+void ExecutionPipeline::Push(const void* in) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (pushed_ - popped_ == slots_.size()) {
+    throw PipelineIsFullException(slots_.size());
+  }
+  // The previous input of the slot was popped, so it is idle
+  auto& slot = slots_[pushed_ % slots_.size()];
+  assert(slot.Stage == stages_count());
+  lock.unlock();
+  tree_->BindContext(in, slot.Context.get());
+  lock.lock();
+  slot.Sequence = pushed_++;
+  slot.Stage = 0;
+  lock.unlock();
+  changed_.notify_all();
+}
+
+const ExecutionPipeline::Results& ExecutionPipeline::Pop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (pushed_ == popped_) {
+    throw PipelineIsEmptyException();
+  }
+  auto& slot = slots_[popped_ % slots_.size()];
+  changed_.wait(lock, [this, &slot] {
+    return slot.Stage == stages_count();
+  });
+  popped_++;
+  return slot.Context->results_;
+}
+
+void ExecutionPipeline::Work(int stage) noexcept {
+  auto first = stages_[stage];
+  auto last = stages_[stage + 1];
+  for (uint64_t sequence = 0;; sequence++) {
+    auto& slot = slots_[sequence % slots_.size()];
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      changed_.wait(lock, [this, &slot, sequence, stage] {
+        return stopping_ ||
+            (slot.Sequence == sequence && slot.Stage == stage);
+      });
+      if (stopping_) {
+        return;
+      }
+    }
+    tree_->RunStage(first, last, slot.Context.get());
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      slot.Stage++;
+    }
+    changed_.notify_all();
+  }
+}
+
+int ExecutionPipeline::InFlight() const noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return pushed_ - popped_;
+}
+
+int ExecutionPipeline::stages_count() const noexcept {
+  return stages_.size() - 1;
+}
+
+int ExecutionPipeline::depth() const noexcept {
+  return slots_.size();
+}
+
+std::vector<size_t> ExecutionPipeline::StageSizes() const noexcept {
+  std::vector<size_t> sizes;
+  for (int stage = 0; stage < stages_count(); stage++) {
+    size_t size = 0;
+    for (auto node = stages_[stage]; node != stages_[stage + 1];
+         node = node->Next) {
+      size++;
+    }
+    sizes.push_back(size);
+  }
+  return sizes;
+}
+
+}  // namespace sound_feature_extraction
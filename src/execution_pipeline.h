@@ -0,0 +1,140 @@
+/*! @file execution_pipeline.h
+ *  @brief Software pipeline of the stages of a transform tree.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+#ifndef SRC_EXECUTION_PIPELINE_H_
+#define SRC_EXECUTION_PIPELINE_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "src/transform_tree.h"
+
+namespace sound_feature_extraction {
+
+class PipelineIsFullException : public ExceptionBase {
+ public:
+  explicit PipelineIsFullException(int depth)
+  : ExceptionBase("The pipeline already has " + std::to_string(depth) +
+                  " inputs in flight, Pop() must be called first.") {
+  }
+};
+
+class PipelineIsEmptyException : public ExceptionBase {
+ public:
+  PipelineIsEmptyException()
+  : ExceptionBase("The pipeline has no inputs in flight.") {
+  }
+};
+
+/// @brief Executes the consecutive stages of a prepared TransformTree on
+/// the successive inputs simultaneously, as a software pipeline.
+/// @details The nodes are split in the execution order into the stages of
+/// about the same estimated time, e.g., the conversion and the windowing,
+/// the spectra and the cepstra with the statistics, and each stage runs on
+/// its own thread. Up to depth() inputs are in flight, each one with its own
+/// TransformTree::ExecutionContext, so while the second stage processes
+/// an input, the first one already processes the next. The latency of
+/// an input stays the same as of TransformTree::Execute(), while
+/// the throughput approaches the one of the slowest stage.
+/// Each stage sees the inputs in the order of Push(), so the streaming
+/// transforms keep their state consistent. The stages follow the serial
+/// order of the nodes, TransformTree::parallel_execution() is not used.
+class ExecutionPipeline {
+ public:
+  typedef std::unordered_map<std::string, std::shared_ptr<Buffers>> Results;
+
+  /// @param tree The prepared tree, which must not change while
+  /// the pipeline exists.
+  /// @param stagesCount The number of the stages (and the threads). It is
+  /// reduced if the tree has not enough nodes.
+  /// @param depth The maximal number of the inputs in flight.
+  ExecutionPipeline(const std::shared_ptr<const TransformTree>& tree,
+                    int stagesCount, int depth = 2);
+  /// @brief Waits for the inputs in flight and stops the threads.
+  ~ExecutionPipeline();
+
+  ExecutionPipeline(const ExecutionPipeline&) = delete;
+  ExecutionPipeline& operator=(const ExecutionPipeline&) = delete;
+
+  /// @brief Starts the extraction of the features from "in", which must
+  /// stay valid until the corresponding Pop() returns.
+  /// @details The input is bound by the calling thread, so the exceptions
+  /// of TransformTree::Execute(in, context) are thrown here.
+  void Push(const void* in);
+
+  /// @brief Waits for the oldest pushed input and returns its features.
+  /// @details The buffers stay valid until the next Push().
+  const Results& Pop();
+
+  /// @brief The number of the pushed inputs which were not popped yet.
+  int InFlight() const noexcept;
+
+  int stages_count() const noexcept;
+  int depth() const noexcept;
+
+  /// @brief The number of the nodes executed by each stage.
+  std::vector<size_t> StageSizes() const noexcept;
+
+ private:
+  /// @brief The context of one of the inputs in flight.
+  struct Slot {
+    std::shared_ptr<TransformTree::ExecutionContext> Context;
+    /// @brief The index of the input in the order of Push().
+    uint64_t Sequence;
+    /// @brief The index of the next stage to execute; stages_count() means
+    /// the features are ready.
+    int Stage;
+  };
+
+  /// @brief Splits the nodes into stages_ by their estimated times.
+  void PlanStages(int stagesCount);
+  /// @brief The body of the thread of the stage.
+  void Work(int stage) noexcept;
+
+  std::shared_ptr<const TransformTree> tree_;
+  /// @brief The first node of each stage followed by nullptr.
+  std::vector<TransformTree::Node*> stages_;
+  std::vector<Slot> slots_;
+  std::vector<std::thread> threads_;
+  mutable std::mutex mutex_;
+  std::condition_variable changed_;
+  uint64_t pushed_;
+  uint64_t popped_;
+  bool stopping_;
+};
+
+}  // namespace sound_feature_extraction
+
+#endif  // SRC_EXECUTION_PIPELINE_H_
@@ -0,0 +1,214 @@
+/*! @file executor_pool.h
+ *  @brief Lock-free pool of the reusable executors with the waiting statistics.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#ifndef SRC_EXECUTOR_POOL_H_
+#define SRC_EXECUTOR_POOL_H_
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "src/metrics.h"
+#include "src/realtime.h"
+
+namespace sound_feature_extraction {
+
+/// @brief How often and for how long the threads had to wait for a free
+/// executor.
+struct ExecutorPoolStatistics {
+  uint64_t Acquisitions;
+  uint64_t Waits;
+  std::chrono::nanoseconds WaitTime;
+};
+
+/// @brief Pool of the executors which must not be used by several threads
+/// simultaneously, e.g. filters or convolution handles.
+/// @details The free executors form a lock-free stack (with the ABA tag in
+/// the upper half of the head), so acquiring and releasing take a few atomic
+/// operations. A thread which finds the pool empty yields until some
+/// executor is returned instead of spinning over the mutexes. Unlike indexing
+/// by omp_get_thread_num(), this stays correct when several trees or
+/// execution contexts call the same transform concurrently.
+template <class T>
+class ExecutorPool {
+ public:
+  typedef std::function<std::shared_ptr<T>()> Factory;
+
+  /// @brief Grants the exclusive access to an executor until destroyed.
+  class Lease {
+   public:
+    Lease(const ExecutorPool* pool, int index) noexcept
+        : pool_(pool), index_(index) {
+    }
+
+    Lease(Lease&& other) noexcept : pool_(other.pool_), index_(other.index_) {
+      other.pool_ = nullptr;
+    }
+
+    Lease(const Lease&) = delete;
+    Lease& operator=(const Lease&) = delete;
+
+    ~Lease() {
+      if (pool_ != nullptr) {
+        pool_->Push(index_);
+      }
+    }
+
+    const std::shared_ptr<T>& operator*() const noexcept {
+      return pool_->executors_[index_];
+    }
+
+    T* operator->() const noexcept {
+      return pool_->executors_[index_].get();
+    }
+
+   private:
+    const ExecutorPool* pool_;
+    int index_;
+  };
+
+  ExecutorPool() noexcept : head_(0), acquisitions_(0), waits_(0),
+                            wait_time_(0) {
+  }
+
+  /// @brief The executors are not copied, the copy must be Reset().
+  ExecutorPool(const ExecutorPool&) noexcept : ExecutorPool() {
+  }
+
+  ExecutorPool& operator=(const ExecutorPool&) = delete;
+
+  /// @brief Replaces the executors with size new ones. Must not be called
+  /// while any executor is acquired.
+  void Reset(size_t size, const Factory& factory) {
+    assert(size > 0 && size < UINT32_MAX);
+    executors_.clear();
+    next_.reset(new std::atomic<uint32_t>[size]);
+    head_ = 0;
+    for (size_t i = 0; i < size; i++) {
+      executors_.push_back(factory());
+      Push(i);
+    }
+    acquisitions_ = 0;
+    waits_ = 0;
+    wait_time_ = 0;
+  }
+
+  size_t size() const noexcept {
+    return executors_.size();
+  }
+
+  /// @brief Takes a free executor, waiting for one if there are none.
+  Lease Acquire() const noexcept {
+    assert(!executors_.empty() && "Reset() was not called");
+    acquisitions_.fetch_add(1, std::memory_order_relaxed);
+    int index = Pop();
+    if (index < 0) {
+      RealtimeSection::Check("ExecutorPool::Acquire() wait");
+      auto start = std::chrono::high_resolution_clock::now();
+      do {
+        std::this_thread::yield();
+        index = Pop();
+      } while (index < 0);
+      auto waited = std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::high_resolution_clock::now() - start);
+      waits_.fetch_add(1, std::memory_order_relaxed);
+      wait_time_.fetch_add(waited.count(), std::memory_order_relaxed);
+      // Only the waits touch the process-wide counters, so that the pools
+      // do not contend on them
+      static auto total_waits = Metrics::Instance().Counter(
+          "sfe_executor_waits",
+          "The times the threads waited for a free executor of a pool.");
+      static auto total_wait_time = Metrics::Instance().Counter(
+          "sfe_executor_wait_nanoseconds",
+          "The total time the threads waited for the executors.");
+      total_waits->Increment();
+      total_wait_time->Increment(waited.count());
+    }
+    return Lease(this, index);
+  }
+
+  ExecutorPoolStatistics Statistics() const noexcept {
+    return { acquisitions_.load(), waits_.load(),
+             std::chrono::nanoseconds(wait_time_.load()) };
+  }
+
+ private:
+  static constexpr uint64_t kIndexMask = 0xFFFFFFFFu;
+
+  /// @brief Returns the index of a free executor or -1 if there are none.
+  int Pop() const noexcept {
+    uint64_t head = head_.load(std::memory_order_acquire);
+    while (true) {
+      uint32_t top = head & kIndexMask;
+      if (top == 0) {
+        return -1;
+      }
+      uint64_t updated = (((head >> 32) + 1) << 32) |
+          next_[top - 1].load(std::memory_order_relaxed);
+      if (head_.compare_exchange_weak(head, updated,
+                                      std::memory_order_acq_rel,
+                                      std::memory_order_acquire)) {
+        return top - 1;
+      }
+    }
+  }
+
+  void Push(uint32_t index) const noexcept {
+    uint64_t head = head_.load(std::memory_order_relaxed);
+    uint64_t updated;
+    do {
+      next_[index].store(head & kIndexMask, std::memory_order_relaxed);
+      updated = (((head >> 32) + 1) << 32) | (index + 1);
+    } while (!head_.compare_exchange_weak(head, updated,
+                                          std::memory_order_release,
+                                          std::memory_order_relaxed));
+  }
+
+  std::vector<std::shared_ptr<T>> executors_;
+  /// @brief next_[i] is the index + 1 of the free executor below i-th.
+  std::unique_ptr<std::atomic<uint32_t>[]> next_;
+  /// @brief The ABA tag (upper 32 bits) and the index + 1 of the top free
+  /// executor (lower 32 bits, 0 means empty).
+  mutable std::atomic<uint64_t> head_;
+  mutable std::atomic<uint64_t> acquisitions_;
+  mutable std::atomic<uint64_t> waits_;
+  mutable std::atomic<int64_t> wait_time_;
+};
+
+template <class T>
+constexpr uint64_t ExecutorPool<T>::kIndexMask;
+
+}  // namespace sound_feature_extraction
+#endif  // SRC_EXECUTOR_POOL_H_
@@ -0,0 +1,368 @@
+/*! @file feature_store.cc
+ *  @brief Chunked columnar on-disk storage of the extracted features.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+
+#include "src/feature_store.h"
+#include <cstring>
+#ifdef HAVE_LZ4
+#include <lz4.h>
+#endif
+
+namespace sound_feature_extraction {
+
+constexpr char FeatureStoreFormat::kMagic[9];
+constexpr size_t FeatureStoreFormat::kChunkAlignment;
+
+/// @brief The bytes of the 32-bit words are grouped by their positions.
+static constexpr size_t kShuffleWidth = 4;
+
+bool FeatureStoreFormat::LZ4Supported() noexcept {
+#ifdef HAVE_LZ4
+  return true;
+#else
+  return false;
+#endif
+}
+
+void FeatureStoreFormat::Encode(size_t rowSize, size_t rows, const char* data,
+                                FeatureStoreCodec codec,
+                                std::vector<char>* stored,
+                                FeatureStoreCodec* used) noexcept {
+  size_t size = rowSize * rows;
+#ifdef HAVE_LZ4
+  if (codec == FeatureStoreCodec::kLZ4) {
+    // The neighbouring frames are similar, so the delta leaves mostly
+    // zero high bytes, which the shuffle gathers into long runs
+    std::vector<char> filtered(size);
+    size_t width = rowSize % kShuffleWidth == 0? kShuffleWidth : 1;
+    size_t words = size / width;
+    for (size_t i = 0; i < size; i++) {
+      char delta = i < rowSize? data[i] : data[i] ^ data[i - rowSize];
+      filtered[(i % width) * words + i / width] = delta;
+    }
+    stored->resize(LZ4_compressBound(size));
+    int compressed = LZ4_compress_default(
+        filtered.data(), stored->data(), size, stored->size());
+    if (compressed > 0 && static_cast<size_t>(compressed) < size) {
+      stored->resize(compressed);
+      *used = FeatureStoreCodec::kLZ4;
+      return;
+    }
+  }
+#else
+  (void)codec;
+#endif
+  stored->assign(data, data + size);
+  *used = FeatureStoreCodec::kNone;
+}
+
+bool FeatureStoreFormat::Decode(const Chunk& chunk, size_t rowSize,
+                                const char* stored, char* rows) noexcept {
+  size_t size = rowSize * chunk.Rows;
+  if (chunk.Codec == FeatureStoreCodec::kNone) {
+    if (chunk.StoredSize != size) {
+      return false;
+    }
+    memcpy(rows, stored, size);
+    return true;
+  }
+#ifdef HAVE_LZ4
+  if (chunk.Codec == FeatureStoreCodec::kLZ4) {
+    std::vector<char> filtered(size);
+    int decompressed = LZ4_decompress_safe(
+        stored, filtered.data(), chunk.StoredSize, size);
+    if (decompressed < 0 || static_cast<size_t>(decompressed) != size) {
+      return false;
+    }
+    size_t width = rowSize % kShuffleWidth == 0? kShuffleWidth : 1;
+    size_t words = size / width;
+    for (size_t i = 0; i < size; i++) {
+      char delta = filtered[(i % width) * words + i / width];
+      rows[i] = i < rowSize? delta : delta ^ rows[i - rowSize];
+    }
+    return true;
+  }
+#endif
+  return false;
+}
+
+FeatureStoreWriter::FeatureStoreWriter(const std::string& fileName,
+                                       FeatureStoreCodec codec,
+                                       size_t chunkRows)
+    : file_name_(fileName), file_(fopen(fileName.c_str(), "wb")),
+      codec_(FeatureStoreFormat::LZ4Supported()?
+             codec : FeatureStoreCodec::kNone),
+      chunk_rows_(chunkRows), position_(0), failed_(false), closed_(false),
+      stop_(false) {
+  if (file_ == nullptr) {
+    throw FeatureStoreException(fileName, "failed to create the file");
+  }
+  if (chunkRows == 0) {
+    fclose(file_);
+    throw FeatureStoreException(fileName, "the chunk must have rows");
+  }
+  position_ = fwrite(FeatureStoreFormat::kMagic, 1, 8, file_);
+  failed_ = position_ != 8;
+  worker_ = std::thread(&FeatureStoreWriter::Work, this);
+}
+
+FeatureStoreWriter::~FeatureStoreWriter() {
+  Close();
+}
+
+FeatureStoreCodec FeatureStoreWriter::codec() const noexcept {
+  return codec_;
+}
+
+size_t FeatureStoreWriter::chunk_rows() const noexcept {
+  return chunk_rows_;
+}
+
+void FeatureStoreWriter::Append(const std::string& feature, const void* data,
+                                size_t rowSize, size_t stride, size_t rows) {
+  std::lock_guard<std::mutex> lock(append_mutex_);
+  if (closed_) {
+    throw FeatureStoreException(file_name_, "the writer is closed");
+  }
+  auto it = pending_.find(feature);
+  if (it == pending_.end()) {
+    it = pending_.insert(std::make_pair(
+        feature, PendingColumn { rowSize, {}, 0 })).first;
+    it->second.Rows.reserve(rowSize * chunk_rows_);
+  } else if (it->second.RowSize != rowSize) {
+    throw FeatureStoreException(
+        file_name_, "the row size of \"" + feature + "\" changed");
+  }
+  auto& column = it->second;
+  auto ptr = reinterpret_cast<const char*>(data);
+  for (size_t i = 0; i < rows; i++, ptr += stride) {
+    column.Rows.insert(column.Rows.end(), ptr, ptr + rowSize);
+    if (++column.Count == chunk_rows_) {
+      Submit(feature, &column);
+    }
+  }
+}
+
+void FeatureStoreWriter::Submit(const std::string& feature,
+                                PendingColumn* column) {
+  Task task { feature, column->RowSize, column->Count, {} };
+  task.Data.swap(column->Rows);
+  column->Rows.reserve(column->RowSize * chunk_rows_);
+  column->Count = 0;
+  {
+    std::lock_guard<std::mutex> lock(tasks_mutex_);
+    tasks_.push_back(std::move(task));
+  }
+  tasks_changed_.notify_one();
+}
+
+void FeatureStoreWriter::Work() noexcept {
+  static const char kPadding[FeatureStoreFormat::kChunkAlignment] = {};
+  std::vector<char> stored;
+  while (true) {
+    Task task;
+    {
+      std::unique_lock<std::mutex> lock(tasks_mutex_);
+      tasks_changed_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+      if (tasks_.empty()) {
+        return;
+      }
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+    FeatureStoreFormat::Chunk chunk;
+    FeatureStoreFormat::Encode(task.RowSize, task.Rows, task.Data.data(),
+                               codec_, &stored, &chunk.Codec);
+    size_t padding = (FeatureStoreFormat::kChunkAlignment -
+        position_ % FeatureStoreFormat::kChunkAlignment) %
+        FeatureStoreFormat::kChunkAlignment;
+    failed_ |= fwrite(kPadding, 1, padding, file_) != padding;
+    chunk.Offset = position_ + padding;
+    chunk.StoredSize = stored.size();
+    chunk.Rows = task.Rows;
+    failed_ |= fwrite(stored.data(), 1, stored.size(), file_) !=
+        stored.size();
+    position_ = chunk.Offset + stored.size();
+    auto& column = index_[task.Feature];
+    column.RowSize = task.RowSize;
+    column.Chunks.push_back(chunk);
+  }
+}
+
+bool FeatureStoreWriter::Close() noexcept {
+  {
+    std::lock_guard<std::mutex> lock(append_mutex_);
+    if (closed_) {
+      return !failed_;
+    }
+    closed_ = true;
+    for (auto& column : pending_) {
+      if (column.second.Count > 0) {
+        Submit(column.first, &column.second);
+      }
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(tasks_mutex_);
+    stop_ = true;
+  }
+  tasks_changed_.notify_one();
+  worker_.join();
+  uint64_t index_offset = position_;
+  auto write = [this](const void* ptr, size_t size) {
+    failed_ |= fwrite(ptr, 1, size, file_) != size;
+  };
+  uint32_t columns = index_.size();
+  write(&columns, sizeof(columns));
+  for (auto& column : index_) {
+    uint32_t length = column.first.size();
+    write(&length, sizeof(length));
+    write(column.first.data(), length);
+    write(&column.second.RowSize, sizeof(column.second.RowSize));
+    uint64_t chunks = column.second.Chunks.size();
+    write(&chunks, sizeof(chunks));
+    for (auto& chunk : column.second.Chunks) {
+      uint32_t codec = static_cast<uint32_t>(chunk.Codec), reserved = 0;
+      write(&chunk.Offset, sizeof(chunk.Offset));
+      write(&chunk.StoredSize, sizeof(chunk.StoredSize));
+      write(&chunk.Rows, sizeof(chunk.Rows));
+      write(&codec, sizeof(codec));
+      write(&reserved, sizeof(reserved));
+    }
+  }
+  write(&index_offset, sizeof(index_offset));
+  write(FeatureStoreFormat::kMagic, 8);
+  failed_ |= fclose(file_) != 0;
+  return !failed_;
+}
+
+FeatureStoreReader::FeatureStoreReader(const std::string& fileName)
+    : file_name_(fileName) {
+  std::unique_ptr<FILE, decltype(&fclose)> file(
+      fopen(fileName.c_str(), "rb"), fclose);
+  if (!file) {
+    throw FeatureStoreException(fileName, "failed to open the file");
+  }
+  auto read = [&](void* ptr, size_t size) {
+    if (fread(ptr, 1, size, file.get()) != size) {
+      throw FeatureStoreException(fileName, "unexpected end of the file");
+    }
+  };
+  char magic[8];
+  uint64_t index_offset;
+  if (fseek(file.get(), -16, SEEK_END) != 0) {
+    throw FeatureStoreException(fileName, "the file is too short");
+  }
+  read(&index_offset, sizeof(index_offset));
+  read(magic, sizeof(magic));
+  if (memcmp(magic, FeatureStoreFormat::kMagic, 8) != 0 ||
+      fseek(file.get(), index_offset, SEEK_SET) != 0) {
+    throw FeatureStoreException(fileName, "the index is corrupted");
+  }
+  uint32_t columns;
+  read(&columns, sizeof(columns));
+  for (uint32_t i = 0; i < columns; i++) {
+    uint32_t length;
+    read(&length, sizeof(length));
+    std::string name(length, 0);
+    read(&name[0], length);
+    auto& column = index_[name];
+    read(&column.RowSize, sizeof(column.RowSize));
+    uint64_t chunks;
+    read(&chunks, sizeof(chunks));
+    column.Chunks.resize(chunks);
+    for (auto& chunk : column.Chunks) {
+      uint32_t codec, reserved;
+      read(&chunk.Offset, sizeof(chunk.Offset));
+      read(&chunk.StoredSize, sizeof(chunk.StoredSize));
+      read(&chunk.Rows, sizeof(chunk.Rows));
+      read(&codec, sizeof(codec));
+      read(&reserved, sizeof(reserved));
+      chunk.Codec = static_cast<FeatureStoreCodec>(codec);
+    }
+  }
+}
+
+std::vector<std::string> FeatureStoreReader::Features() const {
+  std::vector<std::string> ret;
+  for (auto& column : index_) {
+    ret.push_back(column.first);
+  }
+  return ret;
+}
+
+const FeatureStoreFormat::Column& FeatureStoreReader::Find(
+    const std::string& feature) const {
+  auto it = index_.find(feature);
+  if (it == index_.end()) {
+    throw FeatureStoreException(
+        file_name_, "there is no feature \"" + feature + "\"");
+  }
+  return it->second;
+}
+
+size_t FeatureStoreReader::RowSize(const std::string& feature) const {
+  return Find(feature).RowSize;
+}
+
+size_t FeatureStoreReader::Rows(const std::string& feature) const {
+  size_t rows = 0;
+  for (auto& chunk : Find(feature).Chunks) {
+    rows += chunk.Rows;
+  }
+  return rows;
+}
+
+void FeatureStoreReader::Read(const std::string& feature,
+                              std::vector<char>* rows) const {
+  auto& column = Find(feature);
+  rows->resize(Rows(feature) * column.RowSize);
+  std::unique_ptr<FILE, decltype(&fclose)> file(
+      fopen(file_name_.c_str(), "rb"), fclose);
+  if (!file) {
+    throw FeatureStoreException(file_name_, "failed to open the file");
+  }
+  std::vector<char> stored;
+  char* dest = rows->data();
+  for (auto& chunk : column.Chunks) {
+    stored.resize(chunk.StoredSize);
+    if (fseek(file.get(), chunk.Offset, SEEK_SET) != 0 ||
+        fread(stored.data(), 1, stored.size(), file.get()) != stored.size() ||
+        !FeatureStoreFormat::Decode(chunk, column.RowSize, stored.data(),
+                                    dest)) {
+      throw FeatureStoreException(file_name_, "chunk of \"" + feature +
+                                  "\" is corrupted");
+    }
+    dest += chunk.Rows * column.RowSize;
+  }
+}
+
+}  // namespace sound_feature_extraction
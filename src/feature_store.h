@@ -0,0 +1,180 @@
+/*! @file feature_store.h
+ *  @brief Chunked columnar on-disk storage of the extracted features.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+
+#ifndef SRC_FEATURE_STORE_H_
+#define SRC_FEATURE_STORE_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "src/exceptions.h"
+
+namespace sound_feature_extraction {
+
+class FeatureStoreException : public ExceptionBase {
+ public:
+  FeatureStoreException(const std::string& file, const std::string& reason)
+  : ExceptionBase("Feature store \"" + file + "\": " + reason + ".") {
+  }
+};
+
+/// @brief How the chunks of a feature store are encoded.
+enum class FeatureStoreCodec : uint32_t {
+  /// @brief The rows as they are, so that the chunk can be memory mapped.
+  kNone,
+  /// @brief Each byte is XOR-ed with the same byte of the previous row,
+  /// the bytes are shuffled by their position in the 32-bit words and
+  /// the result is compressed with LZ4.
+  kLZ4
+};
+
+/// @brief The layout of a feature store file:
+/// the magic, the chunks aligned to kChunkAlignment, the index and
+/// the offset of the index followed by the magic again.
+/// The index lists the columns (features), each with its name, row size
+/// and chunks (offset, stored size, rows count and codec).
+struct FeatureStoreFormat {
+  static constexpr char kMagic[9] = "SFESTORE";
+  static constexpr size_t kChunkAlignment = 64;
+
+  struct Chunk {
+    uint64_t Offset;
+    uint64_t StoredSize;
+    uint64_t Rows;
+    FeatureStoreCodec Codec;
+  };
+
+  struct Column {
+    uint64_t RowSize;
+    std::vector<Chunk> Chunks;
+  };
+
+  /// @brief Reverses the filters and the compression of kLZ4 chunks.
+  static bool Decode(const Chunk& chunk, size_t rowSize, const char* stored,
+                     char* rows) noexcept;
+  static void Encode(size_t rowSize, size_t rows, const char* data,
+                     FeatureStoreCodec codec, std::vector<char>* stored,
+                     FeatureStoreCodec* used) noexcept;
+  /// @brief Indicates whether the library was built with LZ4.
+  static bool LZ4Supported() noexcept;
+};
+
+/// @brief Appends the features to a chunked columnar file.
+/// @details The rows of each feature are gathered into chunks of
+/// chunkRows rows. The filled chunks are encoded and written by
+/// a background thread, so that the extraction does not wait for
+/// the compression and the I/O.
+class FeatureStoreWriter {
+ public:
+  /// @brief Creates the file, overwriting the existing one. If LZ4 is not
+  /// available, kLZ4 falls back to kNone.
+  FeatureStoreWriter(const std::string& fileName, FeatureStoreCodec codec,
+                     size_t chunkRows);
+  /// @brief Calls Close() if it was not called.
+  ~FeatureStoreWriter();
+
+  /// @brief Appends rows of rowSize bytes, each starting stride bytes
+  /// after the previous one. The row size of a feature must not change.
+  void Append(const std::string& feature, const void* data, size_t rowSize,
+              size_t stride, size_t rows);
+
+  /// @brief Writes the incomplete chunks and the index and closes the file.
+  /// @return false if any write failed.
+  bool Close() noexcept;
+
+  FeatureStoreCodec codec() const noexcept;
+  size_t chunk_rows() const noexcept;
+
+ private:
+  struct PendingColumn {
+    size_t RowSize;
+    std::vector<char> Rows;
+    size_t Count;
+  };
+
+  struct Task {
+    std::string Feature;
+    size_t RowSize;
+    size_t Rows;
+    std::vector<char> Data;
+  };
+
+  void Submit(const std::string& feature, PendingColumn* column);
+  void Work() noexcept;
+
+  std::string file_name_;
+  FILE* file_;
+  FeatureStoreCodec codec_;
+  size_t chunk_rows_;
+  uint64_t position_;
+  bool failed_;
+  bool closed_;
+  /// @brief Accessed by the appending threads only.
+  std::map<std::string, PendingColumn> pending_;
+  std::mutex append_mutex_;
+  /// @brief Accessed by the background thread only until it is joined.
+  std::map<std::string, FeatureStoreFormat::Column> index_;
+  std::deque<Task> tasks_;
+  bool stop_;
+  std::mutex tasks_mutex_;
+  std::condition_variable tasks_changed_;
+  std::thread worker_;
+};
+
+/// @brief Reads the files written by FeatureStoreWriter.
+class FeatureStoreReader {
+ public:
+  explicit FeatureStoreReader(const std::string& fileName);
+
+  std::vector<std::string> Features() const;
+  size_t RowSize(const std::string& feature) const;
+  size_t Rows(const std::string& feature) const;
+  /// @brief Decodes all the rows of the feature.
+  void Read(const std::string& feature, std::vector<char>* rows) const;
+
+ private:
+  const FeatureStoreFormat::Column& Find(const std::string& feature) const;
+
+  std::string file_name_;
+  std::map<std::string, FeatureStoreFormat::Column> index_;
+};
+
+}  // namespace sound_feature_extraction
+
+#endif  // SRC_FEATURE_STORE_H_
@@ -29,94 +29,79 @@
  */
 
 #include "src/features_parser.h"
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wold-style-cast"
-#include <boost/regex.hpp>
-#pragma GCC diagnostic pop
+#include <cctype>
 
 namespace sound_feature_extraction {
 
 namespace features {
 
-void AddToTransformsList(const std::string& str, size_t featureIndex,
-                         RawTransformsList* transforms) {
-  static const boost::regex name_regex("(^\\w+)");
-  static const boost::regex parameters_regex("\\(([^\\)]*)\\)");
-  static const boost::sregex_token_iterator empty;
+static bool IsWordCharacter(char c) noexcept {
+  return isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
 
-  boost::sregex_token_iterator name_iterator(
-      str.begin(), str.end(), name_regex, 1);
-  if (name_iterator == empty) {
-    THROW_PFE(str, featureIndex);
-  }
-  transforms->push_back(std::make_pair(*name_iterator++, ""));
-  if (name_iterator != empty) {
-    THROW_PFE(transforms->back().first, featureIndex);
+static void SkipSpaces(const std::string& str, size_t* pos) noexcept {
+  while (*pos < str.size() && isspace(static_cast<unsigned char>(str[*pos]))) {
+    (*pos)++;
   }
-  boost::sregex_token_iterator parameters_iterator(
-      str.begin(), str.end(), parameters_regex, 1);
-  if (parameters_iterator != empty) {
-    std::string pvalue = *parameters_iterator++;
-    if (pvalue.size() > 0) {
-      transforms->back().second = pvalue;
-    }
-    if (parameters_iterator != empty) {
-      THROW_PFE(transforms->back().first, featureIndex);
-    }
+}
+
+/// @brief Returns the word ([A-Za-z0-9_]+) which starts at pos and moves
+/// pos after it. Returns an empty string if there is no word.
+static std::string ReadWord(const std::string& str, size_t* pos) {
+  size_t begin = *pos;
+  while (*pos < str.size() && IsWordCharacter(str[*pos])) {
+    (*pos)++;
   }
+  return str.substr(begin, *pos - begin);
 }
 
 RawFeaturesMap Parse(const std::vector<std::string>& rawFeatures) {
   RawFeaturesMap ret;
-
-  static const boost::regex featureRegex(
-      "(^\\w+)\\s*\\[([^\\]]+)\\]\\s*");
-  static const boost::regex transformsRegex(
-      "(?<=,)\\s*(\\w+\\s*(\\([^\\)]*\\))?)(?=\\s*,\\s*)");
-  static const boost::regex transformsEndRegex(
-      "(\\w+\\s*(\\([^\\)]*\\))?)\\s*$");
-  static const boost::sregex_token_iterator empty;
-
   for (size_t index = 0; index < rawFeatures.size(); index++) {
-    auto str = rawFeatures[index];
-
-    boost::sregex_token_iterator feature_name_iterator(
-        str.begin(), str.end(), featureRegex, 1);
-    if (feature_name_iterator == empty) {
+    const auto& str = rawFeatures[index];
+    size_t pos = 0;
+    auto fname = ReadWord(str, &pos);
+    if (fname.empty()) {
       THROW_PFE(str, index);
     }
-    std::string fname = *feature_name_iterator++;
-    if (feature_name_iterator != empty) {
+    SkipSpaces(str, &pos);
+    if (pos == str.size() || str[pos] != '[') {
       THROW_PFE(str, index);
     }
-    ret.insert(std::make_pair(fname, RawTransformsList()));
-
-    boost::sregex_token_iterator feature_transforms_iterator(
-        str.begin(), str.end(), featureRegex, 2);
-    if (feature_transforms_iterator == empty) {
-      THROW_PFE(str, index);
-    }
-    auto transformsStr = std::string(",") + *feature_transforms_iterator++;
-    if (feature_transforms_iterator != empty) {
-      THROW_PFE(str, index);
-    }
-
-    boost::sregex_token_iterator feature_each_transform_iterator(
-        transformsStr.begin(), transformsStr.end(), transformsRegex, 1);
-    while (feature_each_transform_iterator != empty) {
-      AddToTransformsList(*feature_each_transform_iterator++, index,
-                          &ret[fname]);
-    }
-
-    boost::sregex_token_iterator feature_transforms_end_iterator(
-        transformsStr.begin(), transformsStr.end(), transformsEndRegex, 1);
-    if (feature_transforms_end_iterator == empty) {
-      THROW_PFE(str, index);
+    pos++;
+    auto& transforms = ret[fname];
+    // <transform name> [(<parameters>)] followed by ',' or ']'
+    while (true) {
+      SkipSpaces(str, &pos);
+      auto tname = ReadWord(str, &pos);
+      if (tname.empty()) {
+        THROW_PFE(str, index);
+      }
+      transforms.push_back(std::make_pair(tname, ""));
+      SkipSpaces(str, &pos);
+      if (pos < str.size() && str[pos] == '(') {
+        auto end = str.find(')', pos + 1);
+        if (end == str.npos) {
+          THROW_PFE(tname, index);
+        }
+        transforms.back().second = str.substr(pos + 1, end - pos - 1);
+        pos = end + 1;
+        SkipSpaces(str, &pos);
+      }
+      if (pos == str.size()) {
+        THROW_PFE(str, index);
+      }
+      if (str[pos] == ']') {
+        pos++;
+        break;
+      }
+      if (str[pos] != ',') {
+        THROW_PFE(tname, index);
+      }
+      pos++;
     }
-    AddToTransformsList(*feature_transforms_end_iterator++,
-                        index,
-                        &ret[fname]);
-    if (feature_transforms_end_iterator != empty) {
+    SkipSpaces(str, &pos);
+    if (pos != str.size()) {
       THROW_PFE(str, index);
     }
   }
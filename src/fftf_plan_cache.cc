@@ -0,0 +1,121 @@
+/*! @file fftf_plan_cache.cc
+ *  @brief Reusable FFTF plans bound to the transform buffers.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#include "src/fftf_plan_cache.h"
+#include "src/fftf_wisdom.h"
+
+namespace sound_feature_extraction {
+
+FFTFPlanCache::FFTFPlanCache(FFTFType type, FFTFDirection direction) noexcept
+    : type_(type), direction_(direction) {
+}
+
+FFTFPlanCache::FFTFPlanCache(const FFTFPlanCache& other) noexcept
+    : type_(other.type_), direction_(other.direction_) {
+}
+
+FFTFPlanCache& FFTFPlanCache::operator=(const FFTFPlanCache& other) noexcept {
+  // Plans are bound to the buffers of the owner, so they are never copied
+  type_ = other.type_;
+  direction_ = other.direction_;
+  Clear();
+  return *this;
+}
+
+bool FFTFPlanCache::Plan::Matches(int length, const BuffersBase<float*>& in,
+                                  const BuffersBase<float*>& out)
+    const noexcept {
+  if (Length != length || Inputs.size() != in.Count() ||
+      Outputs.size() != out.Count()) {
+    return false;
+  }
+  for (size_t i = 0; i < Inputs.size(); i++) {
+    if (Inputs[i] != in[i] || Outputs[i] != out[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::shared_ptr<const FFTFInstance> FFTFPlanCache::Get(
+    int length, const BuffersBase<float*>& in,
+    BuffersBase<float*>* out) noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& plan : plans_) {
+    if (plan.Matches(length, in, *out)) {
+      return plan.Instance;
+    }
+  }
+  Plan plan;
+  plan.Length = length;
+  plan.Inputs.resize(in.Count());
+  plan.Outputs.resize(in.Count());
+  for (size_t i = 0; i < in.Count(); i++) {
+    plan.Inputs[i] = in[i];
+    plan.Outputs[i] = (*out)[i];
+  }
+  auto backend = FFTFWisdom::Instance().Select(
+      type_, direction_, length, in.Count());
+  plan.Instance = std::shared_ptr<FFTFInstance>(
+      fftf_init_batch(
+          type_,
+          direction_,
+          FFTF_DIMENSION_1D,
+          &length,
+          FFTF_NO_OPTIONS,
+          in.Count(),
+          &plan.Inputs[0], &plan.Outputs[0]),
+      fftf_destroy);
+  if (plans_.size() >= kMaxPlans) {
+    plans_.erase(plans_.begin());
+  }
+  plans_.push_back(std::move(plan));
+  return plans_.back().Instance;
+}
+
+void FFTFPlanCache::Calculate(int length, const BuffersBase<float*>& in,
+                              BuffersBase<float*>* out) noexcept {
+  // Holds the plan until fftf_calc() returns
+  auto plan = Get(length, in, out);
+  fftf_calc(plan.get());
+}
+
+void FFTFPlanCache::Clear() noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  plans_.clear();
+}
+
+size_t FFTFPlanCache::size() const noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return plans_.size();
+}
+
+}  // namespace sound_feature_extraction
@@ -0,0 +1,93 @@
+/*! @file fftf_plan_cache.h
+ *  @brief Reusable FFTF plans bound to the transform buffers.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#ifndef SRC_FFTF_PLAN_CACHE_H_
+#define SRC_FFTF_PLAN_CACHE_H_
+
+#include <fftf/api.h>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "src/buffers_base.h"
+
+namespace sound_feature_extraction {
+
+/// @brief Keeps the FFTF plans created by a transform between Do() calls.
+/// @details FFTF binds a plan to the exact input and output pointers, so
+/// a plan is identified by its length and the buffers it was created for.
+/// This implicitly covers the batch size and the alignment. The buffers of
+/// a prepared TransformTree never move, so usually there is a single plan
+/// per transform (or one per slice in case of the cache optimization).
+class FFTFPlanCache {
+ public:
+  FFTFPlanCache(FFTFType type, FFTFDirection direction) noexcept;
+  FFTFPlanCache(const FFTFPlanCache& other) noexcept;
+  FFTFPlanCache& operator=(const FFTFPlanCache& other) noexcept;
+
+  /// @brief Finds the plan for the specified buffers, creating it if
+  /// no one exists yet. The returned reference keeps the plan alive even if
+  /// another thread evicts it meanwhile.
+  std::shared_ptr<const FFTFInstance> Get(int length,
+                                          const BuffersBase<float*>& in,
+                                          BuffersBase<float*>* out) noexcept;
+
+  /// @brief Executes the (cached) plan for the specified buffers.
+  void Calculate(int length, const BuffersBase<float*>& in,
+                 BuffersBase<float*>* out) noexcept;
+
+  /// @brief Destroys all the cached plans.
+  void Clear() noexcept;
+
+  size_t size() const noexcept;
+
+  /// @brief The maximal number of simultaneously cached plans. When it is
+  /// exceeded, the oldest plan is destroyed.
+  static constexpr size_t kMaxPlans = 16;
+
+ private:
+  struct Plan {
+    int Length;
+    std::vector<const float*> Inputs;
+    std::vector<float*> Outputs;
+    std::shared_ptr<FFTFInstance> Instance;
+
+    bool Matches(int length, const BuffersBase<float*>& in,
+                 const BuffersBase<float*>& out) const noexcept;
+  };
+
+  FFTFType type_;
+  FFTFDirection direction_;
+  std::vector<Plan> plans_;
+  mutable std::mutex mutex_;
+};
+
+}  // namespace sound_feature_extraction
+#endif  // SRC_FFTF_PLAN_CACHE_H_
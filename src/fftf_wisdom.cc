@@ -0,0 +1,230 @@
+/*! @file fftf_wisdom.cc
+ *  @brief The fastest FFTF backends for the FFT shapes, measured or loaded.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+
+#include "src/fftf_wisdom.h"
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <vector>
+#include <simd/memory.h>
+#include "src/execution_overrides.h"
+
+namespace sound_feature_extraction {
+
+FFTFWisdom& FFTFWisdom::Instance() noexcept {
+  static FFTFWisdom instance;
+  return instance;
+}
+
+FFTFWisdom::FFTFWisdom() noexcept
+    : autotune_(false), prefer_gpu_(false), gpu_priorities_(false) {
+}
+
+FFTFBackendId FFTFWisdom::Backend(FFTFType type, FFTFDirection direction,
+                                  int length, int batch) noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto shape = std::make_tuple(type, direction, length, batch);
+  auto it = decisions_.find(shape);
+  if (it != decisions_.end()) {
+    return it->second;
+  }
+  if (!autotune_) {
+    return FFTF_BACKEND_NONE;
+  }
+  std::lock_guard<std::mutex> backend_lock(backend_mutex_);
+  auto backend = Benchmark(type, direction, length, batch);
+  if (backend != FFTF_BACKEND_NONE) {
+    decisions_[shape] = backend;
+  }
+  return backend;
+}
+
+std::unique_lock<std::mutex> FFTFWisdom::Select(
+    FFTFType type, FFTFDirection direction, int length, int batch) noexcept {
+  auto backend = Backend(type, direction, length, batch);
+  // The trees remember the preference at setup, so that the change of it
+  // does not affect their lazily created plans
+  auto overrides = CurrentExecutionOverrides();
+  bool gpu = overrides != nullptr && overrides->PreferGpu >= 0?
+      overrides->PreferGpu != 0 : prefer_gpu();
+  std::unique_lock<std::mutex> lock(backend_mutex_);
+  if (gpu != gpu_priorities_) {
+    // FFTF picks the available backend with the highest priority, so
+    // without a GPU the CPU backends are used as before
+    int priority = gpu? kGpuBackendsPriority : -kGpuBackendsPriority;
+    fftf_set_backend_priority(FFTF_BACKEND_CUFFT, priority);
+    fftf_set_backend_priority(FFTF_BACKEND_APPML, priority);
+    gpu_priorities_ = gpu;
+  }
+  fftf_set_backend(backend);
+  if (length > kMaxLibavLength &&
+      fftf_current_backend() == FFTF_BACKEND_LIBAV) {
+    for (auto other = fftf_available_backends(nullptr, nullptr);
+         other->id != FFTF_BACKEND_NONE; other++) {
+      if (other->id == FFTF_BACKEND_LIBAV) {
+        continue;
+      }
+      fftf_set_backend(other->id);
+      if (fftf_current_backend() == other->id) {
+        break;
+      }
+    }
+  }
+  fftf_ensure_is_supported(type, length);
+  return lock;
+}
+
+void FFTFWisdom::Set(FFTFType type, FFTFDirection direction, int length,
+                     int batch, FFTFBackendId backend) noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  decisions_[std::make_tuple(type, direction, length, batch)] = backend;
+}
+
+FFTFBackendId FFTFWisdom::Benchmark(FFTFType type, FFTFDirection direction,
+                                    int length, int batch) noexcept {
+  // Enough for the complex input and for the real output with
+  // the Nyquist frequency
+  int size = 2 * length + 2;
+  std::unique_ptr<float, decltype(&std::free)> memory(
+      mallocf(size * batch * 2), std::free);
+  memsetf(memory.get(), 0, size * batch * 2);
+  std::vector<const float*> inputs(batch);
+  std::vector<float*> outputs(batch);
+  for (int i = 0; i < batch; i++) {
+    inputs[i] = memory.get() + i * size;
+    outputs[i] = memory.get() + (batch + i) * size;
+  }
+  auto best = FFTF_BACKEND_NONE;
+  auto best_time = std::chrono::high_resolution_clock::duration::max();
+  for (auto backend = fftf_available_backends(nullptr, nullptr);
+       backend->id != FFTF_BACKEND_NONE; backend++) {
+    if (backend->id == FFTF_BACKEND_LIBAV && length > kMaxLibavLength) {
+      continue;
+    }
+    fftf_set_backend(backend->id);
+    if (fftf_current_backend() != backend->id) {
+      continue;
+    }
+    std::unique_ptr<FFTFInstance, decltype(&fftf_destroy)> plan(
+        fftf_init_batch(type, direction, FFTF_DIMENSION_1D, &length,
+                        FFTF_NO_OPTIONS, batch, inputs.data(),
+                        outputs.data()),
+        fftf_destroy);
+    if (!plan) {
+      continue;
+    }
+    // Warm up the caches and the lazy initialization of the backend
+    fftf_calc(plan.get());
+    for (int i = 0; i < kBenchmarkRuns; i++) {
+      auto start = std::chrono::high_resolution_clock::now();
+      fftf_calc(plan.get());
+      auto time = std::chrono::high_resolution_clock::now() - start;
+      if (time < best_time) {
+        best_time = time;
+        best = backend->id;
+      }
+    }
+  }
+  fftf_set_backend(FFTF_BACKEND_NONE);
+  return best;
+}
+
+bool FFTFWisdom::Load(const std::string& fileName) noexcept {
+  std::ifstream file(fileName);
+  if (!file) {
+    return false;
+  }
+  std::map<Shape, FFTFBackendId> loaded;
+  int type, direction, length, batch, backend;
+  while (file >> type >> direction >> length >> batch >> backend) {
+    if (length <= 0 || batch <= 0 || backend <= FFTF_BACKEND_NONE ||
+        backend >= FFTF_COUNT_BACKENDS) {
+      return false;
+    }
+    loaded[std::make_tuple(type, direction, length, batch)] =
+        static_cast<FFTFBackendId>(backend);
+  }
+  if (!file.eof()) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& decision : loaded) {
+    decisions_[decision.first] = decision.second;
+  }
+  return true;
+}
+
+bool FFTFWisdom::Save(const std::string& fileName) const noexcept {
+  std::ofstream file(fileName);
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& decision : decisions_) {
+    file << std::get<0>(decision.first) << ' '
+         << std::get<1>(decision.first) << ' '
+         << std::get<2>(decision.first) << ' '
+         << std::get<3>(decision.first) << ' '
+         << decision.second << std::endl;
+  }
+  return static_cast<bool>(file);
+}
+
+void FFTFWisdom::Clear() noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  decisions_.clear();
+}
+
+size_t FFTFWisdom::size() const noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return decisions_.size();
+}
+
+bool FFTFWisdom::autotune() const noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return autotune_;
+}
+
+void FFTFWisdom::set_autotune(bool value) noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  autotune_ = value;
+}
+
+bool FFTFWisdom::prefer_gpu() const noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return prefer_gpu_;
+}
+
+void FFTFWisdom::set_prefer_gpu(bool value) noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  prefer_gpu_ = value;
+}
+
+}  // namespace sound_feature_extraction
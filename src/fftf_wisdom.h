@@ -0,0 +1,127 @@
+/*! @file fftf_wisdom.h
+ *  @brief The fastest FFTF backends for the FFT shapes, measured or loaded.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+
+#ifndef SRC_FFTF_WISDOM_H_
+#define SRC_FFTF_WISDOM_H_
+
+#include <fftf/api.h>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+
+namespace sound_feature_extraction {
+
+/// @brief Remembers the fastest FFTF backend for each FFT shape
+/// (type, direction, length and batch size) used by the transforms.
+/// @details When autotune() is on, the first plan of an unknown shape
+/// benchmarks every available backend and the fastest one is remembered.
+/// The decisions can be saved to a wisdom file and loaded by the later
+/// processes, so that they skip the benchmarking.
+class FFTFWisdom {
+ public:
+  static FFTFWisdom& Instance() noexcept;
+
+  /// @brief Returns the backend to create the plan of the specified shape
+  /// with, which is passed to fftf_set_backend().
+  /// @return FFTF_BACKEND_NONE (the backend with the highest priority)
+  /// if the shape is unknown and autotune() is off.
+  FFTFBackendId Backend(FFTFType type, FFTFDirection direction, int length,
+                        int batch) noexcept;
+
+  /// @brief Makes Backend() of the specified shape the current FFTF backend
+  /// until the returned lock is released. The plans must be created under
+  /// the lock.
+  /// @details The current backend is the global state of FFTF, so
+  /// the threads which set up the transforms concurrently take turns only
+  /// to create their plans. The backend is never libav if the length is
+  /// greater than kMaxLibavLength, the priorities are not changed for that.
+  /// The priorities of the GPU backends follow the PreferGpu of
+  /// the current ExecutionOverrides or else prefer_gpu().
+  std::unique_lock<std::mutex> Select(FFTFType type, FFTFDirection direction,
+                                      int length, int batch) noexcept;
+
+  /// @brief Records the decision for the specified shape.
+  void Set(FFTFType type, FFTFDirection direction, int length, int batch,
+           FFTFBackendId backend) noexcept;
+
+  /// @brief Merges the decisions from the wisdom file.
+  /// @return false if the file cannot be read or is malformed, in which case
+  /// nothing is merged.
+  bool Load(const std::string& fileName) noexcept;
+  /// @brief Writes all the decisions to the wisdom file.
+  bool Save(const std::string& fileName) const noexcept;
+  /// @brief Forgets all the decisions.
+  void Clear() noexcept;
+  size_t size() const noexcept;
+
+  bool autotune() const noexcept;
+  void set_autotune(bool value) noexcept;
+
+  /// @brief Whether Select() prefers the GPU backends of FFTF.
+  bool prefer_gpu() const noexcept;
+  void set_prefer_gpu(bool value) noexcept;
+
+  /// @brief The number of the timed runs of each backend during
+  /// the benchmark, the best one is taken.
+  static constexpr int kBenchmarkRuns = 5;
+  /// @brief libav FFT crashes with the sizes greater than this,
+  /// so it is never selected nor benchmarked on them.
+  static constexpr int kMaxLibavLength = 65536;
+  /// @brief The priority of the GPU backends of FFTF while they are
+  /// preferred, above the ones of the CPU backends, or below them otherwise.
+  static constexpr int kGpuBackendsPriority = 1000;
+
+ private:
+  typedef std::tuple<int, int, int, int> Shape;
+
+  FFTFWisdom() noexcept;
+
+  /// @brief Measures the available backends on the specified shape.
+  /// @return The fastest backend or FFTF_BACKEND_NONE if no one succeeded.
+  static FFTFBackendId Benchmark(FFTFType type, FFTFDirection direction,
+                                 int length, int batch) noexcept;
+
+  mutable std::mutex mutex_;
+  /// @brief Guards the current backend of FFTF, see Select().
+  std::mutex backend_mutex_;
+  std::map<Shape, FFTFBackendId> decisions_;
+  bool autotune_;
+  bool prefer_gpu_;
+  /// @brief Whether the priorities of FFTF prefer the GPU backends now,
+  /// guarded by backend_mutex_. FFTF's own priorities count as off.
+  bool gpu_priorities_;
+};
+
+}  // namespace sound_feature_extraction
+
+#endif  // SRC_FFTF_WISDOM_H_
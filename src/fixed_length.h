@@ -0,0 +1,63 @@
+/*! @file fixed_length.h
+ *  @brief The kernels specialized for the common buffer lengths.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#ifndef SRC_FIXED_LENGTH_H_
+#define SRC_FIXED_LENGTH_H_
+
+/// @brief Calls X(kernel, length) for each buffer length which the kernels
+/// are specialized for: the frames of 256, 512 and 1024 samples, their
+/// packed RDFT spectra (N + 2) and the halves of the spectra (N / 2,
+/// N / 2 + 1).
+#define FOR_EACH_FIXED_LENGTH(X, kernel) \
+  X(kernel, 128) X(kernel, 129) X(kernel, 256) X(kernel, 257) \
+  X(kernel, 258) X(kernel, 512) X(kernel, 513) X(kernel, 514) \
+  X(kernel, 1024) X(kernel, 1026)
+
+#define FIXED_LENGTH_CASE(kernel, length) \
+  case length: \
+    return kernel<length>;
+
+/// @brief Returns kernel<length> if length is one of the fixed lengths and
+/// kernel<0> otherwise. The kernels are templates over the length, where
+/// 0 means the length passed at runtime, so that the loops over the fixed
+/// lengths have constant bounds, are unrolled by the compiler and have no
+/// tails to handle at runtime.
+#define SELECT_FIXED_LENGTH(kernel, length) \
+  switch (length) { \
+    FOR_EACH_FIXED_LENGTH(FIXED_LENGTH_CASE, kernel) \
+    default: \
+      return kernel<0>; \
+  }
+
+/// @brief The loop bound of a kernel<kLength> specialization.
+#define FIXED_LENGTH(kLength, length) ((kLength) > 0? (kLength) : (length))
+
+#endif  // SRC_FIXED_LENGTH_H_
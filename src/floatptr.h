@@ -33,6 +33,7 @@
 #define SRC_FLOATPTR_H_
 
 #include <cstdlib>
+#include <memory>
 #include <mutex>
 
 namespace sound_feature_extraction {
@@ -111,14 +111,11 @@ class ArrayFormat : public BufferFormatBase<T*>,
   virtual void Validate(const BuffersBase<T*>& buffers) const {
     for (size_t i = 0; i < buffers.Count(); i++) {
       bool allZeros = true;
-      for (size_t j = 0; j < size_; j++) {
-        T value = buffers[i][j];
-        if (!validation::Validator<T>::Validate(value)) {
-          throw InvalidBuffersException(this->Id(), i,
-                                        std::string("[") + std::to_string(j) +
-                                        "] = " + std::to_string(value));
-        }
-        allZeros &= (value == 0);
+      size_t j = validation::FindInvalid<T>(buffers[i], size_, &allZeros);
+      if (j < size_) {
+        throw InvalidBuffersException(this->Id(), i,
+                                      std::string("[") + std::to_string(j) +
+                                      "] = " + std::to_string(buffers[i][j]));
       }
       if (allZeros) {
         WRN("%s", InvalidBuffersException(this->Id(), i, "all zeros").what());
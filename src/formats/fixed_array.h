@@ -61,6 +61,21 @@ struct FixedArray : public std::array<F, L> {
   }
 };
 
+/// @brief Returns the column of the field in the buffers which have
+/// the struct of arrays layout (see StructOfArraysTransform).
+/// @details The columns are packed one after another into the memory of
+/// the buffers, which is never smaller, since each buffer is aligned.
+template<std::uint8_t L, typename F>
+F* FieldColumn(BuffersBase<FixedArray<L, F>>* buffers, int field) noexcept {
+  return reinterpret_cast<F*>(&(*buffers)[0]) + field * buffers->Count();
+}
+
+template<std::uint8_t L, typename F>
+const F* FieldColumn(const BuffersBase<FixedArray<L, F>>& buffers,
+                     int field) noexcept {
+  return reinterpret_cast<const F*>(&buffers[0]) + field * buffers.Count();
+}
+
 }  // namespace formats
 
 namespace validation {
@@ -0,0 +1,308 @@
+/*! @file float_to_float16.cc
+ *  @brief float to float16 and bfloat16 converters.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#include "src/formats/float_to_float16.h"
+#include <simd/arithmetic-inl.h>
+#ifdef SIMD_X86
+#include <immintrin.h>
+#elif defined(SIMD_NEON)
+#include <arm_neon.h>
+#endif
+#include <cstring>
+
+namespace sound_feature_extraction {
+namespace formats {
+
+typedef void (*FloatToHalfKernel)(const float* in, int length, uint16_t* out);
+
+/// @brief Rounds to the nearest even binary16 number, the same as F16C does.
+/// Overflows become infinities and NaNs stay quiet NaNs.
+static void FloatToFloat16Scalar(const float* in, int length, uint16_t* out) {
+  for (int i = 0; i < length; i++) {
+    uint32_t bits;
+    memcpy(&bits, in + i, sizeof(bits));
+    uint16_t sign = (bits >> 16) & 0x8000;
+    bits &= 0x7FFFFFFF;
+    if (bits >= 0x47800000) {
+      out[i] = sign | (bits > 0x7F800000? 0x7E00 | ((bits >> 13) & 0x3FF)
+                                        : 0x7C00);
+    } else if (bits < 0x38800000) {
+      // Subnormal result: let the FPU round the mantissa by adding 0.5f
+      float value;
+      memcpy(&value, &bits, sizeof(value));
+      value += 0.5f;
+      memcpy(&bits, &value, sizeof(bits));
+      out[i] = sign | (bits - 0x3F000000);
+    } else {
+      // Rebias the exponent and round the mantissa to the nearest even
+      bits += 0xC8000FFF + ((bits >> 13) & 1);
+      out[i] = sign | (bits >> 13);
+    }
+  }
+}
+
+/// @brief Rounds to the nearest even bfloat16 number, NaNs stay quiet NaNs.
+static void FloatToBFloat16Scalar(const float* in, int length,
+                                  uint16_t* out) {
+  for (int i = 0; i < length; i++) {
+    uint32_t bits;
+    memcpy(&bits, in + i, sizeof(bits));
+    if ((bits & 0x7FFFFFFF) > 0x7F800000) {
+      out[i] = (bits >> 16) | 0x40;
+    } else {
+      out[i] = (bits + 0x7FFF + ((bits >> 16) & 1)) >> 16;
+    }
+  }
+}
+
+#ifdef SIMD_X86
+/// @note Every CPU with AVX2 has F16C, while some AVX ones do not.
+SIMD_TARGET("avx2,f16c")
+static void FloatToFloat16AVX2(const float* in, int length, uint16_t* out) {
+  int i = 0;
+  for (; i < length - 7; i += 8) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                     _mm256_cvtps_ph(_mm256_loadu_ps(in + i),
+                                     _MM_FROUND_TO_NEAREST_INT));
+  }
+  FloatToFloat16Scalar(in + i, length - i, out + i);
+}
+
+SIMD_TARGET_AVX512
+static void FloatToFloat16AVX512(const float* in, int length,
+                                 uint16_t* out) {
+  int i = 0;
+  for (; i < length - 15; i += 16) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),
+                        _mm512_cvtps_ph(_mm512_loadu_ps(in + i),
+                                        _MM_FROUND_TO_NEAREST_INT));
+  }
+  __mmask16 tail = (1u << (length - i)) - 1;
+  __m256i res = _mm512_cvtps_ph(_mm512_maskz_loadu_ps(tail, in + i),
+                                _MM_FROUND_TO_NEAREST_INT);
+  _mm256_mask_storeu_epi16(out + i, tail, res);
+}
+
+/// @brief The integer emulation of the rounding: AVX-512 BF16 is rare and
+/// flushes the subnormals, so every ISA produces the same bits this way.
+SIMD_TARGET("sse4.1")
+static __m128i RoundToBFloat16SSE41(__m128 vec) {
+  __m128i bits = _mm_castps_si128(vec);
+  __m128i lsb = _mm_and_si128(_mm_srli_epi32(bits, 16), _mm_set1_epi32(1));
+  __m128i rounded = _mm_add_epi32(
+      bits, _mm_add_epi32(lsb, _mm_set1_epi32(0x7FFF)));
+  __m128i nan = _mm_cmpgt_epi32(
+      _mm_and_si128(bits, _mm_set1_epi32(0x7FFFFFFF)),
+      _mm_set1_epi32(0x7F800000));
+  rounded = _mm_blendv_epi8(
+      rounded, _mm_or_si128(bits, _mm_set1_epi32(0x400000)), nan);
+  return _mm_srli_epi32(rounded, 16);
+}
+
+SIMD_TARGET("sse4.1")
+static void FloatToBFloat16SSE41(const float* in, int length,
+                                 uint16_t* out) {
+  int i = 0;
+  for (; i < length - 7; i += 8) {
+    __m128i lo = RoundToBFloat16SSE41(_mm_loadu_ps(in + i));
+    __m128i hi = RoundToBFloat16SSE41(_mm_loadu_ps(in + i + 4));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                     _mm_packus_epi32(lo, hi));
+  }
+  FloatToBFloat16Scalar(in + i, length - i, out + i);
+}
+
+SIMD_TARGET("avx2")
+static __m256i RoundToBFloat16AVX2(__m256 vec) {
+  __m256i bits = _mm256_castps_si256(vec);
+  __m256i lsb = _mm256_and_si256(_mm256_srli_epi32(bits, 16),
+                                 _mm256_set1_epi32(1));
+  __m256i rounded = _mm256_add_epi32(
+      bits, _mm256_add_epi32(lsb, _mm256_set1_epi32(0x7FFF)));
+  __m256i nan = _mm256_cmpgt_epi32(
+      _mm256_and_si256(bits, _mm256_set1_epi32(0x7FFFFFFF)),
+      _mm256_set1_epi32(0x7F800000));
+  rounded = _mm256_blendv_epi8(
+      rounded, _mm256_or_si256(bits, _mm256_set1_epi32(0x400000)), nan);
+  return _mm256_srli_epi32(rounded, 16);
+}
+
+SIMD_TARGET("avx2")
+static void FloatToBFloat16AVX2(const float* in, int length, uint16_t* out) {
+  int i = 0;
+  for (; i < length - 15; i += 16) {
+    __m256i lo = RoundToBFloat16AVX2(_mm256_loadu_ps(in + i));
+    __m256i hi = RoundToBFloat16AVX2(_mm256_loadu_ps(in + i + 8));
+    // packus works within 128-bit lanes, restore the order of the quadwords
+    __m256i res = _mm256_permute4x64_epi64(_mm256_packus_epi32(lo, hi), 0xD8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), res);
+  }
+  FloatToBFloat16Scalar(in + i, length - i, out + i);
+}
+
+SIMD_TARGET_AVX512
+static __m256i RoundToBFloat16AVX512(__m512 vec) {
+  __m512i bits = _mm512_castps_si512(vec);
+  __m512i lsb = _mm512_and_si512(_mm512_srli_epi32(bits, 16),
+                                 _mm512_set1_epi32(1));
+  __m512i rounded = _mm512_add_epi32(
+      bits, _mm512_add_epi32(lsb, _mm512_set1_epi32(0x7FFF)));
+  __mmask16 nan = _mm512_cmpgt_epi32_mask(
+      _mm512_and_si512(bits, _mm512_set1_epi32(0x7FFFFFFF)),
+      _mm512_set1_epi32(0x7F800000));
+  rounded = _mm512_mask_mov_epi32(
+      rounded, nan, _mm512_or_si512(bits, _mm512_set1_epi32(0x400000)));
+  return _mm512_cvtepi32_epi16(_mm512_srli_epi32(rounded, 16));
+}
+
+SIMD_TARGET_AVX512
+static void FloatToBFloat16AVX512(const float* in, int length,
+                                  uint16_t* out) {
+  int i = 0;
+  for (; i < length - 15; i += 16) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),
+                        RoundToBFloat16AVX512(_mm512_loadu_ps(in + i)));
+  }
+  __mmask16 tail = (1u << (length - i)) - 1;
+  _mm256_mask_storeu_epi16(
+      out + i, tail,
+      RoundToBFloat16AVX512(_mm512_maskz_loadu_ps(tail, in + i)));
+}
+#elif defined(SIMD_NEON) && defined(__aarch64__)
+static void FloatToFloat16NEON(const float* in, int length, uint16_t* out) {
+  int i = 0;
+  for (; i < length - 3; i += 4) {
+    vst1_u16(out + i, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(in + i))));
+  }
+  FloatToFloat16Scalar(in + i, length - i, out + i);
+}
+
+static void FloatToBFloat16NEON(const float* in, int length, uint16_t* out) {
+  int i = 0;
+  for (; i < length - 3; i += 4) {
+    uint32x4_t bits = vreinterpretq_u32_f32(vld1q_f32(in + i));
+    uint32x4_t lsb = vandq_u32(vshrq_n_u32(bits, 16), vdupq_n_u32(1));
+    uint32x4_t rounded = vaddq_u32(
+        bits, vaddq_u32(lsb, vdupq_n_u32(0x7FFF)));
+    uint32x4_t nan = vcgtq_u32(vandq_u32(bits, vdupq_n_u32(0x7FFFFFFF)),
+                               vdupq_n_u32(0x7F800000));
+    rounded = vbslq_u32(nan, vorrq_u32(bits, vdupq_n_u32(0x400000)),
+                        rounded);
+    vst1_u16(out + i, vshrn_n_u32(rounded, 16));
+  }
+  FloatToBFloat16Scalar(in + i, length - i, out + i);
+}
+#endif
+
+static const SimdKernel<FloatToHalfKernel> kFloatToFloat16Kernels[] {
+#ifdef SIMD_X86
+  { InstructionSet::kAVX512, FloatToFloat16AVX512 },
+  { InstructionSet::kAVX2, FloatToFloat16AVX2 },
+#elif defined(SIMD_NEON) && defined(__aarch64__)
+  { InstructionSet::kNEON, FloatToFloat16NEON },
+#endif
+  { InstructionSet::kScalar, FloatToFloat16Scalar }
+};
+
+static const SimdKernel<FloatToHalfKernel> kFloatToBFloat16Kernels[] {
+#ifdef SIMD_X86
+  { InstructionSet::kAVX512, FloatToBFloat16AVX512 },
+  { InstructionSet::kAVX2, FloatToBFloat16AVX2 },
+  { InstructionSet::kSSE41, FloatToBFloat16SSE41 },
+#elif defined(SIMD_NEON) && defined(__aarch64__)
+  { InstructionSet::kNEON, FloatToBFloat16NEON },
+#endif
+  { InstructionSet::kScalar, FloatToBFloat16Scalar }
+};
+
+void FloatToFloat16Raw::Do(const float* in, Float16* out) const noexcept {
+  DoNarrowing(in, input_format_->Size(), out);
+}
+
+void FloatToFloat16Raw::DoNarrowing(const float* in, int length,
+                                    Float16* out) const noexcept {
+  Convert(in, length, out);
+}
+
+void FloatToFloat16Raw::Convert(const float* in, int length,
+                                Float16* out) noexcept {
+  SimdAware::Dispatch(kFloatToFloat16Kernels).Function(
+      in, length, reinterpret_cast<uint16_t*>(out));
+}
+
+InstructionSet FloatToFloat16Raw::SimdInstructionSet() const noexcept {
+  return SimdAware::Dispatch(kFloatToFloat16Kernels).Isa;
+}
+
+void FloatToBFloat16Raw::Do(const float* in, BFloat16* out) const noexcept {
+  DoNarrowing(in, input_format_->Size(), out);
+}
+
+void FloatToBFloat16Raw::DoNarrowing(const float* in, int length,
+                                     BFloat16* out) const noexcept {
+  SimdAware::Dispatch(kFloatToBFloat16Kernels).Function(
+      in, length, reinterpret_cast<uint16_t*>(out));
+}
+
+InstructionSet FloatToBFloat16Raw::SimdInstructionSet() const noexcept {
+  return SimdAware::Dispatch(kFloatToBFloat16Kernels).Isa;
+}
+
+const std::string& FloatToFloat16::Name() const noexcept {
+  static const std::string str("Float16");
+  return str;
+}
+
+const std::string& FloatToFloat16::Description() const noexcept {
+  static const std::string str(
+      "Rounds each value to the nearest IEEE 754 half precision number.");
+  return str;
+}
+
+const std::string& FloatToBFloat16::Name() const noexcept {
+  static const std::string str("BFloat16");
+  return str;
+}
+
+const std::string& FloatToBFloat16::Description() const noexcept {
+  static const std::string str(
+      "Rounds each value to the nearest bfloat16 number (the upper half of "
+      "the float).");
+  return str;
+}
+
+REGISTER_TRANSFORM(FloatToFloat16Raw);
+REGISTER_TRANSFORM(FloatToBFloat16Raw);
+REGISTER_TRANSFORM(FloatToFloat16);
+REGISTER_TRANSFORM(FloatToBFloat16);
+
+}  // namespace formats
+}  // namespace sound_feature_extraction
@@ -0,0 +1,96 @@
+/*! @file float_to_float16.h
+ *  @brief float to float16 and bfloat16 converters.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#ifndef SRC_FORMATS_FLOAT_TO_FLOAT16_H_
+#define SRC_FORMATS_FLOAT_TO_FLOAT16_H_
+
+#include "src/elementwise_transform.h"
+#include "src/formats/array_format_converter_base.h"
+#include "src/formats/reduced_precision.h"
+
+namespace sound_feature_extraction {
+namespace formats {
+
+/// @brief Rounds each float to the nearest (even) binary16 number.
+class FloatToFloat16Raw
+    : public ArrayFormatConverterBase<ArrayFormatF, ArrayFormatF16>,
+      public NarrowingTransform<Float16> {
+ public:
+  virtual InstructionSet SimdInstructionSet() const noexcept override;
+
+  virtual void DoNarrowing(const float* in, int length,
+                           Float16* out) const noexcept override;
+
+  /// @brief Converts length floats outside of a transform tree, e.g.,
+  /// when the results are copied out (see set_feature_output_type()).
+  static void Convert(const float* in, int length, Float16* out) noexcept;
+
+ protected:
+  virtual void Do(const float* in,
+                  Float16* out) const noexcept override;
+};
+
+/// @brief Rounds each float to the nearest (even) bfloat16 number.
+class FloatToBFloat16Raw
+    : public ArrayFormatConverterBase<ArrayFormatF, ArrayFormatBF16>,
+      public NarrowingTransform<BFloat16> {
+ public:
+  virtual InstructionSet SimdInstructionSet() const noexcept override;
+
+  virtual void DoNarrowing(const float* in, int length,
+                           BFloat16* out) const noexcept override;
+
+ protected:
+  virtual void Do(const float* in,
+                  BFloat16* out) const noexcept override;
+};
+
+/// @brief FloatToFloat16Raw which can be explicitly put at the end of
+/// a feature, e.g. "MFCC [..., DCT, Float16]".
+class FloatToFloat16 : public FloatToFloat16Raw {
+ public:
+  virtual const std::string& Name() const noexcept override;
+
+  virtual const std::string& Description() const noexcept override;
+};
+
+/// @brief FloatToBFloat16Raw which can be explicitly put at the end of
+/// a feature, e.g. "MFCC [..., DCT, BFloat16]".
+class FloatToBFloat16 : public FloatToBFloat16Raw {
+ public:
+  virtual const std::string& Name() const noexcept override;
+
+  virtual const std::string& Description() const noexcept override;
+};
+
+}  // namespace formats
+}  // namespace sound_feature_extraction
+#endif  // SRC_FORMATS_FLOAT_TO_FLOAT16_H_
@@ -30,13 +30,103 @@
 
 #include "src/formats/float_to_int16.h"
 #include <simd/arithmetic-inl.h>
+#ifdef SIMD_X86
+#include <immintrin.h>
+#elif defined(SIMD_NEON)
+#include <arm_neon.h>
+#endif
+#include <algorithm>
+#include <cmath>
 
 namespace sound_feature_extraction {
 namespace formats {
 
+typedef void (*FloatToInt16Kernel)(const float* in, int length, int16_t* out);
+
+/// @brief Rounds to the nearest (even) integer and saturates, the same as
+/// the SIMD conversions do.
+static void FloatToInt16Scalar(const float* in, int length, int16_t* out) {
+  for (int i = 0; i < length; i++) {
+    long rounded = lrintf(in[i]);  // NOLINT(runtime/int)
+    out[i] = std::max(-32768L, std::min(32767L, rounded));
+  }
+}
+
+#ifdef SIMD_X86
+SIMD_TARGET("sse4.1")
+static void FloatToInt16SSE41(const float* in, int length, int16_t* out) {
+  int i = 0;
+  for (; i < length - 7; i += 8) {
+    __m128i lo = _mm_cvtps_epi32(_mm_loadu_ps(in + i));
+    __m128i hi = _mm_cvtps_epi32(_mm_loadu_ps(in + i + 4));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                     _mm_packs_epi32(lo, hi));
+  }
+  FloatToInt16Scalar(in + i, length - i, out + i);
+}
+
+SIMD_TARGET("avx2")
+static void FloatToInt16AVX2(const float* in, int length, int16_t* out) {
+  int i = 0;
+  for (; i < length - 15; i += 16) {
+    __m256i lo = _mm256_cvtps_epi32(_mm256_loadu_ps(in + i));
+    __m256i hi = _mm256_cvtps_epi32(_mm256_loadu_ps(in + i + 8));
+    // packs works within 128-bit lanes, restore the order of the quadwords
+    __m256i res = _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), 0xD8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), res);
+  }
+  FloatToInt16Scalar(in + i, length - i, out + i);
+}
+
+SIMD_TARGET_AVX512
+static void FloatToInt16AVX512(const float* in, int length, int16_t* out) {
+  int i = 0;
+  for (; i < length - 15; i += 16) {
+    __m512i vec = _mm512_cvtps_epi32(_mm512_loadu_ps(in + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),
+                        _mm512_cvtsepi32_epi16(vec));
+  }
+  __mmask16 tail = (1u << (length - i)) - 1;
+  __m512i vec = _mm512_cvtps_epi32(_mm512_maskz_loadu_ps(tail, in + i));
+  _mm256_mask_storeu_epi16(out + i, tail, _mm512_cvtsepi32_epi16(vec));
+}
+#elif defined(SIMD_NEON) && defined(__aarch64__)
+static void FloatToInt16NEON(const float* in, int length, int16_t* out) {
+  int i = 0;
+  for (; i < length - 7; i += 8) {
+    // vcvtnq_s32_f32() rounds to the nearest even, the same as lrintf()
+    int16x8_t res = vcombine_s16(
+        vqmovn_s32(vcvtnq_s32_f32(vld1q_f32(in + i))),
+        vqmovn_s32(vcvtnq_s32_f32(vld1q_f32(in + i + 4))));
+    vst1q_s16(out + i, res);
+  }
+  FloatToInt16Scalar(in + i, length - i, out + i);
+}
+#endif
+
+static const SimdKernel<FloatToInt16Kernel> kFloatToInt16Kernels[] {
+#ifdef SIMD_X86
+  { InstructionSet::kAVX512, FloatToInt16AVX512 },
+  { InstructionSet::kAVX2, FloatToInt16AVX2 },
+  { InstructionSet::kSSE41, FloatToInt16SSE41 },
+#elif defined(SIMD_NEON) && defined(__aarch64__)
+  { InstructionSet::kNEON, FloatToInt16NEON },
+#endif
+  { InstructionSet::kScalar, FloatToInt16Scalar }
+};
+
 void FloatToInt16Raw::Do(const float* in,
                          int16_t* out) const noexcept {
-  float_to_int16(in, input_format_->Size(), out);
+  Convert(in, input_format_->Size(), out);
+}
+
+void FloatToInt16Raw::Convert(const float* in, int length,
+                             int16_t* out) noexcept {
+  SimdAware::Dispatch(kFloatToInt16Kernels).Function(in, length, out);
+}
+
+InstructionSet FloatToInt16Raw::SimdInstructionSet() const noexcept {
+  return SimdAware::Dispatch(kFloatToInt16Kernels).Isa;
 }
 
 REGISTER_TRANSFORM(FloatToInt16Raw);
@@ -39,6 +39,13 @@ namespace formats {
 
 class FloatToInt16Raw
     : public ArrayFormatConverterBase<ArrayFormatF, ArrayFormat16> {
+ public:
+  virtual InstructionSet SimdInstructionSet() const noexcept override;
+
+  /// @brief Converts length floats outside of a transform tree, e.g.,
+  /// when the results are copied out (see set_feature_output_type()).
+  static void Convert(const float* in, int length, int16_t* out) noexcept;
+
  protected:
   virtual void Do(const float* in,
                   int16_t* out) const noexcept override;
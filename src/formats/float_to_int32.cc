@@ -30,13 +30,108 @@
 
 #include "src/formats/float_to_int32.h"
 #include <simd/arithmetic-inl.h>
+#ifdef SIMD_X86
+#include <immintrin.h>
+#elif defined(SIMD_NEON)
+#include <arm_neon.h>
+#endif
+#include <algorithm>
+#include <cmath>
 
 namespace sound_feature_extraction {
 namespace formats {
 
+typedef void (*FloatToInt32Kernel)(const float* in, int length, int32_t* out);
+
+/// @brief The largest float which is less than 2^31.
+static constexpr float kInt32Max = 2147483520.f;
+static constexpr float kInt32Min = -2147483648.f;
+
+/// @brief Rounds to the nearest (even) integer and saturates, the same as
+/// FloatToInt16Raw and the SIMD conversions do.
+static void FloatToInt32Scalar(const float* in, int length, int32_t* out) {
+  for (int i = 0; i < length; i++) {
+    out[i] = lrintf(std::max(kInt32Min, std::min(kInt32Max, in[i])));
+  }
+}
+
+#ifdef SIMD_X86
+SIMD_TARGET("sse4.1")
+static void FloatToInt32SSE41(const float* in, int length, int32_t* out) {
+  const __m128 max = _mm_set1_ps(kInt32Max);
+  const __m128 min = _mm_set1_ps(kInt32Min);
+  int i = 0;
+  for (; i < length - 3; i += 4) {
+    __m128 vec = _mm_max_ps(_mm_min_ps(_mm_loadu_ps(in + i), max), min);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                     _mm_cvtps_epi32(vec));
+  }
+  FloatToInt32Scalar(in + i, length - i, out + i);
+}
+
+SIMD_TARGET("avx2")
+static void FloatToInt32AVX2(const float* in, int length, int32_t* out) {
+  const __m256 max = _mm256_set1_ps(kInt32Max);
+  const __m256 min = _mm256_set1_ps(kInt32Min);
+  int i = 0;
+  for (; i < length - 7; i += 8) {
+    __m256 vec = _mm256_max_ps(_mm256_min_ps(_mm256_loadu_ps(in + i), max),
+                               min);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),
+                        _mm256_cvtps_epi32(vec));
+  }
+  FloatToInt32Scalar(in + i, length - i, out + i);
+}
+
+SIMD_TARGET_AVX512
+static void FloatToInt32AVX512(const float* in, int length, int32_t* out) {
+  const __m512 max = _mm512_set1_ps(kInt32Max);
+  const __m512 min = _mm512_set1_ps(kInt32Min);
+  int i = 0;
+  for (; i < length - 15; i += 16) {
+    __m512 vec = _mm512_max_ps(_mm512_min_ps(_mm512_loadu_ps(in + i), max),
+                               min);
+    _mm512_storeu_si512(out + i, _mm512_cvtps_epi32(vec));
+  }
+  __mmask16 tail = (1u << (length - i)) - 1;
+  __m512 vec = _mm512_max_ps(_mm512_min_ps(
+      _mm512_maskz_loadu_ps(tail, in + i), max), min);
+  _mm512_mask_storeu_epi32(out + i, tail, _mm512_cvtps_epi32(vec));
+}
+#elif defined(SIMD_NEON) && defined(__aarch64__)
+static void FloatToInt32NEON(const float* in, int length, int32_t* out) {
+  int i = 0;
+  for (; i < length - 3; i += 4) {
+    // vcvtnq_s32_f32() rounds to the nearest even and saturates
+    vst1q_s32(out + i, vcvtnq_s32_f32(vld1q_f32(in + i)));
+  }
+  FloatToInt32Scalar(in + i, length - i, out + i);
+}
+#endif
+
+static const SimdKernel<FloatToInt32Kernel> kFloatToInt32Kernels[] {
+#ifdef SIMD_X86
+  { InstructionSet::kAVX512, FloatToInt32AVX512 },
+  { InstructionSet::kAVX2, FloatToInt32AVX2 },
+  { InstructionSet::kSSE41, FloatToInt32SSE41 },
+#elif defined(SIMD_NEON) && defined(__aarch64__)
+  { InstructionSet::kNEON, FloatToInt32NEON },
+#endif
+  { InstructionSet::kScalar, FloatToInt32Scalar }
+};
+
 void FloatToInt32Raw::Do(const float* in,
                          int32_t* out) const noexcept {
-  float_to_int32(in, input_format_->Size(), out);
+  Convert(in, input_format_->Size(), out);
+}
+
+void FloatToInt32Raw::Convert(const float* in, int length,
+                             int32_t* out) noexcept {
+  SimdAware::Dispatch(kFloatToInt32Kernels).Function(in, length, out);
+}
+
+InstructionSet FloatToInt32Raw::SimdInstructionSet() const noexcept {
+  return SimdAware::Dispatch(kFloatToInt32Kernels).Isa;
 }
 
 REGISTER_TRANSFORM(FloatToInt32Raw);
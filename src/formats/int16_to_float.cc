@@ -30,13 +30,121 @@
 
 #include "src/formats/int16_to_float.h"
 #include <simd/arithmetic-inl.h>
+#ifdef SIMD_X86
+#include <immintrin.h>
+#elif defined(SIMD_NEON)
+#include <arm_neon.h>
+#endif
 
 namespace sound_feature_extraction {
 namespace formats {
 
+typedef void (*Int16ToFloatKernel)(const int16_t* in, int length,
+                                   float scale, float offset, float* out);
+
+/// @brief Multiplies and adds separately, the same as the SIMD kernels do.
+static void Int16ToFloatScalar(const int16_t* in, int length, float scale,
+                               float offset, float* out) {
+  for (int i = 0; i < length; i++) {
+    float value = in[i] * scale;
+    out[i] = value + offset;
+  }
+}
+
+#ifdef SIMD_X86
+SIMD_TARGET("sse4.1")
+static void Int16ToFloatSSE41(const int16_t* in, int length, float scale,
+                              float offset, float* out) {
+  const __m128 mul = _mm_set1_ps(scale);
+  const __m128 add = _mm_set1_ps(offset);
+  int i = 0;
+  for (; i < length - 7; i += 8) {
+    __m128i vec = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    __m128 lo = _mm_cvtepi32_ps(_mm_cvtepi16_epi32(vec));
+    __m128 hi = _mm_cvtepi32_ps(_mm_cvtepi16_epi32(_mm_srli_si128(vec, 8)));
+    _mm_storeu_ps(out + i, _mm_add_ps(_mm_mul_ps(lo, mul), add));
+    _mm_storeu_ps(out + i + 4, _mm_add_ps(_mm_mul_ps(hi, mul), add));
+  }
+  Int16ToFloatScalar(in + i, length - i, scale, offset, out + i);
+}
+
+SIMD_TARGET("avx2")
+static void Int16ToFloatAVX2(const int16_t* in, int length, float scale,
+                             float offset, float* out) {
+  const __m256 mul = _mm256_set1_ps(scale);
+  const __m256 add = _mm256_set1_ps(offset);
+  int i = 0;
+  for (; i < length - 15; i += 16) {
+    __m256i vec = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+    __m256 lo = _mm256_cvtepi32_ps(
+        _mm256_cvtepi16_epi32(_mm256_castsi256_si128(vec)));
+    __m256 hi = _mm256_cvtepi32_ps(
+        _mm256_cvtepi16_epi32(_mm256_extracti128_si256(vec, 1)));
+    _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_mul_ps(lo, mul), add));
+    _mm256_storeu_ps(out + i + 8, _mm256_add_ps(_mm256_mul_ps(hi, mul), add));
+  }
+  Int16ToFloatScalar(in + i, length - i, scale, offset, out + i);
+}
+
+SIMD_TARGET_AVX512
+static void Int16ToFloatAVX512(const int16_t* in, int length, float scale,
+                               float offset, float* out) {
+  const __m512 mul = _mm512_set1_ps(scale);
+  const __m512 add = _mm512_set1_ps(offset);
+  int i = 0;
+  for (; i < length - 15; i += 16) {
+    __m256i vec = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+    __m512 res = _mm512_cvtepi32_ps(_mm512_cvtepi16_epi32(vec));
+    _mm512_storeu_ps(out + i, _mm512_add_ps(_mm512_mul_ps(res, mul), add));
+  }
+  __mmask16 tail = (1u << (length - i)) - 1;
+  __m256i vec = _mm256_maskz_loadu_epi16(tail, in + i);
+  __m512 res = _mm512_cvtepi32_ps(_mm512_cvtepi16_epi32(vec));
+  _mm512_mask_storeu_ps(out + i, tail,
+                        _mm512_add_ps(_mm512_mul_ps(res, mul), add));
+}
+#elif defined(SIMD_NEON)
+static void Int16ToFloatNEON(const int16_t* in, int length, float scale,
+                             float offset, float* out) {
+  const float32x4_t mul = vdupq_n_f32(scale);
+  const float32x4_t add = vdupq_n_f32(offset);
+  int i = 0;
+  for (; i < length - 7; i += 8) {
+    int16x8_t vec = vld1q_s16(in + i);
+    float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(vec)));
+    float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(vec)));
+    // vmlaq_f32() may be fused on AArch64, keep the separate rounding
+    vst1q_f32(out + i, vaddq_f32(vmulq_f32(lo, mul), add));
+    vst1q_f32(out + i + 4, vaddq_f32(vmulq_f32(hi, mul), add));
+  }
+  Int16ToFloatScalar(in + i, length - i, scale, offset, out + i);
+}
+#endif
+
+static const SimdKernel<Int16ToFloatKernel> kInt16ToFloatKernels[] {
+#ifdef SIMD_X86
+  { InstructionSet::kAVX512, Int16ToFloatAVX512 },
+  { InstructionSet::kAVX2, Int16ToFloatAVX2 },
+  { InstructionSet::kSSE41, Int16ToFloatSSE41 },
+#elif defined(SIMD_NEON)
+  { InstructionSet::kNEON, Int16ToFloatNEON },
+#endif
+  { InstructionSet::kScalar, Int16ToFloatScalar }
+};
+
 void Int16ToFloatRaw::Do(const int16_t* in,
                          float* out) const noexcept {
-  int16_to_float(in, input_format_->Size(), out);
+  DoWidening(in, input_format_->Size(), 1, 0, out);
+}
+
+void Int16ToFloatRaw::DoWidening(const int16_t* in, int length, float scale,
+                                 float offset, float* out) const noexcept {
+  SimdAware::Dispatch(kInt16ToFloatKernels).Function(
+      in, length, scale, offset, out);
+}
+
+InstructionSet Int16ToFloatRaw::SimdInstructionSet() const noexcept {
+  return SimdAware::Dispatch(kInt16ToFloatKernels).Isa;
 }
 
 REGISTER_TRANSFORM(Int16ToFloatRaw);
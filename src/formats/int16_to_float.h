@@ -31,6 +31,7 @@
 #ifndef SRC_FORMATS_INT16_TO_FLOAT_H_
 #define SRC_FORMATS_INT16_TO_FLOAT_H_
 
+#include "src/elementwise_transform.h"
 #include "src/formats/array_format.h"
 #include "src/formats/array_format_converter_base.h"
 
@@ -38,7 +39,14 @@ namespace sound_feature_extraction {
 namespace formats {
 
 class Int16ToFloatRaw
-    : public ArrayFormatConverterBase<ArrayFormat16, ArrayFormatF> {
+    : public ArrayFormatConverterBase<ArrayFormat16, ArrayFormatF>,
+      public WideningTransform<int16_t> {
+ public:
+  virtual InstructionSet SimdInstructionSet() const noexcept override;
+
+  virtual void DoWidening(const int16_t* in, int length, float scale,
+                          float offset, float* out) const noexcept override;
+
  protected:
   virtual void Do(const int16_t* in,
                   float* out) const noexcept override;
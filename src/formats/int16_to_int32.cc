@@ -30,13 +30,94 @@
 
 #include "src/formats/int16_to_int32.h"
 #include <simd/arithmetic-inl.h>
+#ifdef SIMD_X86
+#include <immintrin.h>
+#elif defined(SIMD_NEON)
+#include <arm_neon.h>
+#endif
 
 namespace sound_feature_extraction {
 namespace formats {
 
+typedef void (*Int16ToInt32Kernel)(const int16_t* in, int length,
+                                   int32_t* out);
+
+static void Int16ToInt32Scalar(const int16_t* in, int length, int32_t* out) {
+  for (int i = 0; i < length; i++) {
+    out[i] = in[i];
+  }
+}
+
+#ifdef SIMD_X86
+SIMD_TARGET("sse4.1")
+static void Int16ToInt32SSE41(const int16_t* in, int length, int32_t* out) {
+  int i = 0;
+  for (; i < length - 7; i += 8) {
+    __m128i vec = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                     _mm_cvtepi16_epi32(vec));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 4),
+                     _mm_cvtepi16_epi32(_mm_srli_si128(vec, 8)));
+  }
+  Int16ToInt32Scalar(in + i, length - i, out + i);
+}
+
+SIMD_TARGET("avx2")
+static void Int16ToInt32AVX2(const int16_t* in, int length, int32_t* out) {
+  int i = 0;
+  for (; i < length - 15; i += 16) {
+    __m256i vec = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),
+                        _mm256_cvtepi16_epi32(_mm256_castsi256_si128(vec)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i + 8),
+                        _mm256_cvtepi16_epi32(
+                            _mm256_extracti128_si256(vec, 1)));
+  }
+  Int16ToInt32Scalar(in + i, length - i, out + i);
+}
+
+SIMD_TARGET_AVX512
+static void Int16ToInt32AVX512(const int16_t* in, int length, int32_t* out) {
+  int i = 0;
+  for (; i < length - 15; i += 16) {
+    __m256i vec = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+    _mm512_storeu_si512(out + i, _mm512_cvtepi16_epi32(vec));
+  }
+  __mmask16 tail = (1u << (length - i)) - 1;
+  __m256i vec = _mm256_maskz_loadu_epi16(tail, in + i);
+  _mm512_mask_storeu_epi32(out + i, tail, _mm512_cvtepi16_epi32(vec));
+}
+#elif defined(SIMD_NEON)
+static void Int16ToInt32NEON(const int16_t* in, int length, int32_t* out) {
+  int i = 0;
+  for (; i < length - 7; i += 8) {
+    int16x8_t vec = vld1q_s16(in + i);
+    vst1q_s32(out + i, vmovl_s16(vget_low_s16(vec)));
+    vst1q_s32(out + i + 4, vmovl_s16(vget_high_s16(vec)));
+  }
+  Int16ToInt32Scalar(in + i, length - i, out + i);
+}
+#endif
+
+static const SimdKernel<Int16ToInt32Kernel> kInt16ToInt32Kernels[] {
+#ifdef SIMD_X86
+  { InstructionSet::kAVX512, Int16ToInt32AVX512 },
+  { InstructionSet::kAVX2, Int16ToInt32AVX2 },
+  { InstructionSet::kSSE41, Int16ToInt32SSE41 },
+#elif defined(SIMD_NEON)
+  { InstructionSet::kNEON, Int16ToInt32NEON },
+#endif
+  { InstructionSet::kScalar, Int16ToInt32Scalar }
+};
+
 void Int16ToInt32Raw::Do(const int16_t* in,
                          int32_t* out) const noexcept {
-  int16_to_int32(in, input_format_->Size(), out);
+  SimdAware::Dispatch(kInt16ToInt32Kernels).Function(
+      in, input_format_->Size(), out);
+}
+
+InstructionSet Int16ToInt32Raw::SimdInstructionSet() const noexcept {
+  return SimdAware::Dispatch(kInt16ToInt32Kernels).Isa;
 }
 
 REGISTER_TRANSFORM(Int16ToInt32Raw);
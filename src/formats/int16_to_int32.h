@@ -39,6 +39,9 @@ namespace formats {
 
 class Int16ToInt32Raw
     : public ArrayFormatConverterBase<ArrayFormat16, ArrayFormat32> {
+ public:
+  virtual InstructionSet SimdInstructionSet() const noexcept override;
+
  protected:
   virtual void Do(const int16_t* in,
                   int32_t* out) const noexcept override;
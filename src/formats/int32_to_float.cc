@@ -30,13 +30,117 @@
 
 #include "src/formats/int32_to_float.h"
 #include <simd/arithmetic-inl.h>
+#ifdef SIMD_X86
+#include <immintrin.h>
+#elif defined(SIMD_NEON)
+#include <arm_neon.h>
+#endif
 
 namespace sound_feature_extraction {
 namespace formats {
 
+typedef void (*Int32ToFloatKernel)(const int32_t* in, int length,
+                                   float scale, float offset, float* out);
+
+/// @brief Multiplies and adds separately, the same as the SIMD kernels do.
+static void Int32ToFloatScalar(const int32_t* in, int length, float scale,
+                               float offset, float* out) {
+  for (int i = 0; i < length; i++) {
+    float value = static_cast<float>(in[i]) * scale;
+    out[i] = value + offset;
+  }
+}
+
+#ifdef SIMD_X86
+SIMD_TARGET("sse4.1")
+static void Int32ToFloatSSE41(const int32_t* in, int length, float scale,
+                              float offset, float* out) {
+  const __m128 mul = _mm_set1_ps(scale);
+  const __m128 add = _mm_set1_ps(offset);
+  int i = 0;
+  for (; i < length - 7; i += 8) {
+    __m128 lo = _mm_cvtepi32_ps(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)));
+    __m128 hi = _mm_cvtepi32_ps(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 4)));
+    _mm_storeu_ps(out + i, _mm_add_ps(_mm_mul_ps(lo, mul), add));
+    _mm_storeu_ps(out + i + 4, _mm_add_ps(_mm_mul_ps(hi, mul), add));
+  }
+  Int32ToFloatScalar(in + i, length - i, scale, offset, out + i);
+}
+
+SIMD_TARGET("avx2")
+static void Int32ToFloatAVX2(const int32_t* in, int length, float scale,
+                             float offset, float* out) {
+  const __m256 mul = _mm256_set1_ps(scale);
+  const __m256 add = _mm256_set1_ps(offset);
+  int i = 0;
+  for (; i < length - 15; i += 16) {
+    __m256 lo = _mm256_cvtepi32_ps(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i)));
+    __m256 hi = _mm256_cvtepi32_ps(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i + 8)));
+    _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_mul_ps(lo, mul), add));
+    _mm256_storeu_ps(out + i + 8, _mm256_add_ps(_mm256_mul_ps(hi, mul), add));
+  }
+  Int32ToFloatScalar(in + i, length - i, scale, offset, out + i);
+}
+
+SIMD_TARGET_AVX512
+static void Int32ToFloatAVX512(const int32_t* in, int length, float scale,
+                               float offset, float* out) {
+  const __m512 mul = _mm512_set1_ps(scale);
+  const __m512 add = _mm512_set1_ps(offset);
+  int i = 0;
+  for (; i < length - 15; i += 16) {
+    __m512 res = _mm512_cvtepi32_ps(_mm512_loadu_si512(in + i));
+    _mm512_storeu_ps(out + i, _mm512_add_ps(_mm512_mul_ps(res, mul), add));
+  }
+  __mmask16 tail = (1u << (length - i)) - 1;
+  __m512 res = _mm512_cvtepi32_ps(_mm512_maskz_loadu_epi32(tail, in + i));
+  _mm512_mask_storeu_ps(out + i, tail,
+                        _mm512_add_ps(_mm512_mul_ps(res, mul), add));
+}
+#elif defined(SIMD_NEON)
+static void Int32ToFloatNEON(const int32_t* in, int length, float scale,
+                             float offset, float* out) {
+  const float32x4_t mul = vdupq_n_f32(scale);
+  const float32x4_t add = vdupq_n_f32(offset);
+  int i = 0;
+  for (; i < length - 7; i += 8) {
+    float32x4_t lo = vcvtq_f32_s32(vld1q_s32(in + i));
+    float32x4_t hi = vcvtq_f32_s32(vld1q_s32(in + i + 4));
+    vst1q_f32(out + i, vaddq_f32(vmulq_f32(lo, mul), add));
+    vst1q_f32(out + i + 4, vaddq_f32(vmulq_f32(hi, mul), add));
+  }
+  Int32ToFloatScalar(in + i, length - i, scale, offset, out + i);
+}
+#endif
+
+static const SimdKernel<Int32ToFloatKernel> kInt32ToFloatKernels[] {
+#ifdef SIMD_X86
+  { InstructionSet::kAVX512, Int32ToFloatAVX512 },
+  { InstructionSet::kAVX2, Int32ToFloatAVX2 },
+  { InstructionSet::kSSE41, Int32ToFloatSSE41 },
+#elif defined(SIMD_NEON)
+  { InstructionSet::kNEON, Int32ToFloatNEON },
+#endif
+  { InstructionSet::kScalar, Int32ToFloatScalar }
+};
+
 void Int32ToFloatRaw::Do(const int32_t* in,
                          float* out) const noexcept {
-  int32_to_float(in, input_format_->Size(), out);
+  DoWidening(in, input_format_->Size(), 1, 0, out);
+}
+
+void Int32ToFloatRaw::DoWidening(const int32_t* in, int length, float scale,
+                                 float offset, float* out) const noexcept {
+  SimdAware::Dispatch(kInt32ToFloatKernels).Function(
+      in, length, scale, offset, out);
+}
+
+InstructionSet Int32ToFloatRaw::SimdInstructionSet() const noexcept {
+  return SimdAware::Dispatch(kInt32ToFloatKernels).Isa;
 }
 
 REGISTER_TRANSFORM(Int32ToFloatRaw);
@@ -31,6 +31,7 @@
 #ifndef SRC_FORMATS_INT32_TO_FLOAT_H_
 #define SRC_FORMATS_INT32_TO_FLOAT_H_
 
+#include "src/elementwise_transform.h"
 #include "src/formats/array_format.h"
 #include "src/formats/array_format_converter_base.h"
 
@@ -38,7 +39,14 @@ namespace sound_feature_extraction {
 namespace formats {
 
 class Int32ToFloatRaw
-    : public ArrayFormatConverterBase<ArrayFormat32, ArrayFormatF> {
+    : public ArrayFormatConverterBase<ArrayFormat32, ArrayFormatF>,
+      public WideningTransform<int32_t> {
+ public:
+  virtual InstructionSet SimdInstructionSet() const noexcept override;
+
+  virtual void DoWidening(const int32_t* in, int length, float scale,
+                          float offset, float* out) const noexcept override;
+
  protected:
   virtual void Do(const int32_t* in,
                   float* out) const noexcept override;
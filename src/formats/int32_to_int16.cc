@@ -30,13 +30,95 @@
 
 #include "src/formats/int32_to_int16.h"
 #include <simd/arithmetic-inl.h>
+#ifdef SIMD_X86
+#include <immintrin.h>
+#elif defined(SIMD_NEON)
+#include <arm_neon.h>
+#endif
+#include <algorithm>
 
 namespace sound_feature_extraction {
 namespace formats {
 
+typedef void (*Int32ToInt16Kernel)(const int32_t* in, int length,
+                                   int16_t* out);
+
+/// @brief Saturates, the same as the SIMD conversions do.
+static void Int32ToInt16Scalar(const int32_t* in, int length, int16_t* out) {
+  for (int i = 0; i < length; i++) {
+    out[i] = std::max(-32768, std::min(32767, in[i]));
+  }
+}
+
+#ifdef SIMD_X86
+SIMD_TARGET("sse4.1")
+static void Int32ToInt16SSE41(const int32_t* in, int length, int16_t* out) {
+  int i = 0;
+  for (; i < length - 7; i += 8) {
+    __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 4));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                     _mm_packs_epi32(lo, hi));
+  }
+  Int32ToInt16Scalar(in + i, length - i, out + i);
+}
+
+SIMD_TARGET("avx2")
+static void Int32ToInt16AVX2(const int32_t* in, int length, int16_t* out) {
+  int i = 0;
+  for (; i < length - 15; i += 16) {
+    __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+    __m256i hi = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(in + i + 8));
+    // packs works within 128-bit lanes, restore the order of the quadwords
+    __m256i res = _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), 0xD8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), res);
+  }
+  Int32ToInt16Scalar(in + i, length - i, out + i);
+}
+
+SIMD_TARGET_AVX512
+static void Int32ToInt16AVX512(const int32_t* in, int length, int16_t* out) {
+  int i = 0;
+  for (; i < length - 15; i += 16) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),
+                        _mm512_cvtsepi32_epi16(_mm512_loadu_si512(in + i)));
+  }
+  __mmask16 tail = (1u << (length - i)) - 1;
+  __m512i vec = _mm512_maskz_loadu_epi32(tail, in + i);
+  _mm256_mask_storeu_epi16(out + i, tail, _mm512_cvtsepi32_epi16(vec));
+}
+#elif defined(SIMD_NEON)
+static void Int32ToInt16NEON(const int32_t* in, int length, int16_t* out) {
+  int i = 0;
+  for (; i < length - 7; i += 8) {
+    int16x8_t res = vcombine_s16(vqmovn_s32(vld1q_s32(in + i)),
+                                 vqmovn_s32(vld1q_s32(in + i + 4)));
+    vst1q_s16(out + i, res);
+  }
+  Int32ToInt16Scalar(in + i, length - i, out + i);
+}
+#endif
+
+static const SimdKernel<Int32ToInt16Kernel> kInt32ToInt16Kernels[] {
+#ifdef SIMD_X86
+  { InstructionSet::kAVX512, Int32ToInt16AVX512 },
+  { InstructionSet::kAVX2, Int32ToInt16AVX2 },
+  { InstructionSet::kSSE41, Int32ToInt16SSE41 },
+#elif defined(SIMD_NEON)
+  { InstructionSet::kNEON, Int32ToInt16NEON },
+#endif
+  { InstructionSet::kScalar, Int32ToInt16Scalar }
+};
+
 void Int32ToInt16Raw::Do(const int32_t* in,
                          int16_t* out) const noexcept {
-  int32_to_int16(in, input_format_->Size(), out);
+  SimdAware::Dispatch(kInt32ToInt16Kernels).Function(
+      in, input_format_->Size(), out);
+}
+
+InstructionSet Int32ToInt16Raw::SimdInstructionSet() const noexcept {
+  return SimdAware::Dispatch(kInt32ToInt16Kernels).Isa;
 }
 
 REGISTER_TRANSFORM(Int32ToInt16Raw);
@@ -39,6 +39,9 @@ namespace formats {
 
 class Int32ToInt16Raw
     : public ArrayFormatConverterBase<ArrayFormat32, ArrayFormat16> {
+ public:
+  virtual InstructionSet SimdInstructionSet() const noexcept override;
+
  protected:
   virtual void Do(const int32_t* in,
                   int16_t* out) const noexcept override;
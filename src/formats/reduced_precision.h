@@ -0,0 +1,95 @@
+/*! @file reduced_precision.h
+ *  @brief Half precision array element types and formats.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#ifndef SRC_FORMATS_REDUCED_PRECISION_H_
+#define SRC_FORMATS_REDUCED_PRECISION_H_
+
+#include <cstring>
+#include "src/formats/array_format.h"
+
+namespace sound_feature_extraction {
+namespace formats {
+
+/// @brief IEEE 754 binary16 number, stored as the raw bits.
+/// @details Converts to float implicitly, so that ArrayFormat can validate
+/// and dump the arrays of such values.
+struct Float16 {
+  uint16_t Bits;
+
+  operator float() const noexcept {
+    const uint32_t kShiftedExponent = 0x7C00 << 13;
+    uint32_t bits = (Bits & 0x7FFF) << 13;
+    uint32_t exponent = bits & kShiftedExponent;
+    bits += (127 - 15) << 23;
+    float value;
+    if (exponent == kShiftedExponent) {
+      // Inf or NaN
+      bits += (128 - 16) << 23;
+      memcpy(&value, &bits, sizeof(value));
+    } else if (exponent == 0) {
+      // Zero or subnormal, renormalize through the FPU
+      bits += 1 << 23;
+      const uint32_t kMagic = 113 << 23;
+      float magic;
+      memcpy(&magic, &kMagic, sizeof(magic));
+      memcpy(&value, &bits, sizeof(value));
+      value -= magic;
+    } else {
+      memcpy(&value, &bits, sizeof(value));
+    }
+    uint32_t sign = (Bits & 0x8000) << 16;
+    memcpy(&bits, &value, sizeof(bits));
+    bits |= sign;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+};
+
+/// @brief Brain floating point number (the upper half of a float), stored as
+/// the raw bits.
+struct BFloat16 {
+  uint16_t Bits;
+
+  operator float() const noexcept {
+    uint32_t bits = static_cast<uint32_t>(Bits) << 16;
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+};
+
+typedef ArrayFormat<Float16> ArrayFormatF16;
+typedef ArrayFormat<BFloat16> ArrayFormatBF16;
+typedef ArrayFormat<int8_t> ArrayFormat8;
+
+}  // namespace formats
+}  // namespace sound_feature_extraction
+#endif  // SRC_FORMATS_REDUCED_PRECISION_H_
@@ -29,7 +29,6 @@
  */
 
 #include "src/logger.h"
-#include <cassert>
 #include <cxxabi.h>
 #include <string.h>
 
@@ -39,59 +38,53 @@ Logger::Logger(const std::string &domain,
                const std::string &color,
                bool suppressLoggingInitialized) noexcept
     : log_domain_(kUnintializedLogDomain)
+    , log_level_(EINA_LOG_LEVEL_DBG)
     , domain_str_(domain)
     , color_(color)
     , suppressLoggingInitialized_(suppressLoggingInitialized) {
-#ifdef EINA
-  InitializeEina();
-#endif
 }
 
 Logger::Logger(const Logger& other) noexcept
     : log_domain_(kUnintializedLogDomain)
+    , log_level_(other.log_level())
     , domain_str_(other.domain_str_)
     , color_(other.color_)
     , suppressLoggingInitialized_(other.suppressLoggingInitialized_) {
-#ifdef EINA
-  InitializeEina();
-#endif
 }
 
 Logger::Logger(Logger&& other) noexcept
     : log_domain_(kUnintializedLogDomain)
+    , log_level_(other.log_level())
     , domain_str_(std::move(std::forward<std::string>(
         other.domain_str_)))
     , color_(std::move(std::forward<std::string>(other.color_)))
     , suppressLoggingInitialized_(
         std::move(std::forward<bool>(
             other.suppressLoggingInitialized_))) {
-#ifdef EINA
-  InitializeEina();
-#endif
 }
 
 Logger& Logger::operator=(const Logger& other) noexcept {
-  log_domain_ = (kUnintializedLogDomain);
+#ifdef EINA
+  DisposeEina();
+#endif
+  log_level_ = other.log_level();
   domain_str_ = (other.domain_str_);
   color_ = (other.color_);
   suppressLoggingInitialized_ = (other.suppressLoggingInitialized_);
-#ifdef EINA
-  InitializeEina();
-#endif
   return *this;
 }
 
 Logger& Logger::operator=(Logger&& other) noexcept {
-  log_domain_ = (kUnintializedLogDomain);
+#ifdef EINA
+  DisposeEina();
+#endif
+  log_level_ = other.log_level();
   domain_str_ = (std::move(std::forward<std::string>(
         other.domain_str_)));
   color_ = (std::move(std::forward<std::string>(other.color_)));
   suppressLoggingInitialized_ = (
         std::move(std::forward<bool>(
             other.suppressLoggingInitialized_)));
-#ifdef EINA
-  InitializeEina();
-#endif
   return *this;
 }
 
@@ -103,48 +96,76 @@ Logger::~Logger() {
 
 #ifdef EINA
 
-void Logger::InitializeEina() noexcept {
-  DisposeEina();
-  eina_init();
-  eina_log_threads_enable();
+int Logger::InitializeEina() const noexcept {
+  static bool initialized = [] {
+    eina_init();
+    eina_log_threads_enable();
+    return true;
+  }();
+  (void)initialized;
   int len = strlen(kCommonDomain) + strlen(domain_str_.c_str()) + 1;
   char *fullDomain = new char[len];
   snprintf(fullDomain, len, "%s%s", kCommonDomain, domain_str_.c_str());
-  log_domain_ = eina_log_domain_register(fullDomain, color_.c_str());
-  if (log_domain_ < 0) {
+  int domain = eina_log_domain_register(fullDomain, color_.c_str());
+  if (domain < 0) {
     int message_len = len + 128;
     char *message = new char[message_len];
     snprintf(message, message_len, "%s%s%s",
             "could not register ", fullDomain, " log domain.");
     EINA_LOG_DOM_ERR(EINA_LOG_DOMAIN_GLOBAL, "%s", message);
-    log_domain_ = EINA_LOG_DOMAIN_GLOBAL;
-  } else {
-    if (!suppressLoggingInitialized_) {
-      DBG("Logging was initialized with domain %i.",
-          log_domain_);
-    }
+    delete[] message;
+    domain = EINA_LOG_DOMAIN_GLOBAL;
   }
   delete[] fullDomain;
+  int expected = kUnintializedLogDomain;
+  if (!log_domain_.compare_exchange_strong(expected, domain)) {
+    // Another thread has registered it meanwhile
+    if (domain != EINA_LOG_DOMAIN_GLOBAL) {
+      eina_log_domain_unregister(domain);
+    }
+    return expected;
+  }
+  UpdateLogLevel(domain);
+  if (!suppressLoggingInitialized_ && domain != EINA_LOG_DOMAIN_GLOBAL) {
+    DBG("Logging was initialized with domain %i.", domain);
+  }
+  return domain;
 }
 
 void Logger::DisposeEina() noexcept {
-  if (log_domain_ != kUnintializedLogDomain &&
-      log_domain_ != EINA_LOG_DOMAIN_GLOBAL) {
+  int domain = log_domain_.exchange(kUnintializedLogDomain);
+  if (domain != kUnintializedLogDomain && domain != EINA_LOG_DOMAIN_GLOBAL) {
     if (!suppressLoggingInitialized_) {
-      DBG("Domain %i is not registered now", log_domain_);
+      EINA_LOG_DOM_DBG(domain, "Domain %i is not registered now", domain);
     }
-    eina_log_domain_unregister(log_domain_);
-    log_domain_ = kUnintializedLogDomain;
+    eina_log_domain_unregister(domain);
   }
 }
 
 #endif
 
 int Logger::log_domain() const noexcept {
+  int domain = log_domain_.load(std::memory_order_acquire);
 #ifdef EINA
-  assert(log_domain_ != kUnintializedLogDomain);
+  if (domain == kUnintializedLogDomain) {
+    domain = InitializeEina();
+  }
+#endif
+  return domain;
+}
+
+void Logger::RefreshLogLevel() noexcept {
+  UpdateLogLevel(log_domain());
+}
+
+void Logger::UpdateLogLevel(int domain) const noexcept {
+#ifdef EINA
+  int level = domain == EINA_LOG_DOMAIN_GLOBAL?
+      eina_log_level_get() : eina_log_domain_registered_level_get(domain);
+  log_level_.store(level, std::memory_order_relaxed);
+#else
+  (void)domain;
 #endif
-  return log_domain_;
 }
 
 std::string Logger::domain_str() const noexcept {
@@ -152,10 +173,10 @@ std::string Logger::domain_str() const noexcept {
 }
 
 void Logger::set_domain_str(const std::string &value) noexcept {
-  domain_str_ = value;
 #ifdef EINA
-  InitializeEina();
+  DisposeEina();
 #endif
+  domain_str_ = value;
 }
 
 std::string Logger::color() const noexcept {
@@ -163,10 +184,10 @@ std::string Logger::color() const noexcept {
 }
 
 void Logger::set_color(const std::string &value) noexcept {
-  color_ = value;
 #ifdef EINA
-  InitializeEina();
+  DisposeEina();
 #endif
+  color_ = value;
 }
 
 }  // namespace sound_feature_extraction
@@ -34,25 +34,73 @@
 #ifdef EINA
 #include <Eina.h>
 #endif
+#include <atomic>
 #include <string>
+#include "src/realtime.h"
 
 namespace sound_feature_extraction {
 
-#ifdef EINA
+/// @brief Type checks the format and the arguments of a message which
+/// configure --disable-debug-logging (NO_DEBUG_LOGGING) compiled out.
+/// @details The call is never evaluated, the same as its arguments.
+inline void DiscardLog(const char*, ...) noexcept
+    __attribute__((format(printf, 1, 2)));
+inline void DiscardLog(const char*, ...) noexcept {
+}
+
+#define LOGGER_DISCARD(...) \
+  do { \
+    if (false) { \
+      ::sound_feature_extraction::DiscardLog(__VA_ARGS__); \
+    } \
+  } while (false)
+
+/// @brief Prints the message if the level is enabled in the cached level of
+/// the logger, so the disabled messages cost a single atomic load and
+/// their arguments are not evaluated. Nothing is printed in a real-time
+/// section (see RealtimeSection).
+#define LOGGER_PRINT(logger, level, print, ...) \
+  do { \
+    if ((logger)->log_level() >= (level) && \
+        !::sound_feature_extraction::RealtimeSection::Active()) { \
+      print(__VA_ARGS__); \
+    } \
+  } while (false)
 
-#define DBG(...) EINA_LOG_DOM_DBG(this->log_domain(), __VA_ARGS__)
-#define INF(...) EINA_LOG_DOM_INFO(this->log_domain(), __VA_ARGS__)
-#define WRN(...) EINA_LOG_DOM_WARN(this->log_domain(), __VA_ARGS__)
-#define ERR(...) EINA_LOG_DOM_ERR(this->log_domain(), __VA_ARGS__)
-#define CRT(...) EINA_LOG_DOM_CRIT(this->log_domain(), __VA_ARGS__)
+#ifdef EINA
 
-#define DBGI(x, ...) EINA_LOG_DOM_DBG((x)->log_domain(), __VA_ARGS__)
-#define INFI(x, ...) EINA_LOG_DOM_INFO((x)->log_domain(), __VA_ARGS__)
-#define WRNI(x, ...) EINA_LOG_DOM_WARN((x)->log_domain(), __VA_ARGS__)
-#define ERRI(x, ...) EINA_LOG_DOM_ERR((x)->log_domain(), __VA_ARGS__)
-#define CRTI(x, ...) EINA_LOG_DOM_CRIT((x)->log_domain(), __VA_ARGS__)
+#define LOGGER_PRINT_EINA(logger, level, print, ...) \
+  LOGGER_PRINT(logger, level, print, (logger)->log_domain(), __VA_ARGS__)
 
+#ifdef NO_DEBUG_LOGGING
+#define DBG(...) LOGGER_DISCARD(__VA_ARGS__)
+#define DBGI(x, ...) LOGGER_DISCARD(__VA_ARGS__)
+#define DBGC(x, ...) LOGGER_DISCARD(__VA_ARGS__)
+#else
+#define DBG(...) LOGGER_PRINT_EINA( \
+    this, EINA_LOG_LEVEL_DBG, EINA_LOG_DOM_DBG, __VA_ARGS__)
+#define DBGI(x, ...) LOGGER_PRINT_EINA( \
+    x, EINA_LOG_LEVEL_DBG, EINA_LOG_DOM_DBG, __VA_ARGS__)
 #define DBGC(x, ...) EINA_LOG_DOM_DBG(x::log_domain(), __VA_ARGS__)
+#endif
+#define INF(...) LOGGER_PRINT_EINA( \
+    this, EINA_LOG_LEVEL_INFO, EINA_LOG_DOM_INFO, __VA_ARGS__)
+#define WRN(...) LOGGER_PRINT_EINA( \
+    this, EINA_LOG_LEVEL_WARN, EINA_LOG_DOM_WARN, __VA_ARGS__)
+#define ERR(...) LOGGER_PRINT_EINA( \
+    this, EINA_LOG_LEVEL_ERR, EINA_LOG_DOM_ERR, __VA_ARGS__)
+#define CRT(...) LOGGER_PRINT_EINA( \
+    this, EINA_LOG_LEVEL_CRITICAL, EINA_LOG_DOM_CRIT, __VA_ARGS__)
+
+#define INFI(x, ...) LOGGER_PRINT_EINA( \
+    x, EINA_LOG_LEVEL_INFO, EINA_LOG_DOM_INFO, __VA_ARGS__)
+#define WRNI(x, ...) LOGGER_PRINT_EINA( \
+    x, EINA_LOG_LEVEL_WARN, EINA_LOG_DOM_WARN, __VA_ARGS__)
+#define ERRI(x, ...) LOGGER_PRINT_EINA( \
+    x, EINA_LOG_LEVEL_ERR, EINA_LOG_DOM_ERR, __VA_ARGS__)
+#define CRTI(x, ...) LOGGER_PRINT_EINA( \
+    x, EINA_LOG_LEVEL_CRITICAL, EINA_LOG_DOM_CRIT, __VA_ARGS__)
+
 #define INFC(x, ...) EINA_LOG_DOM_INFO(x::log_domain(), __VA_ARGS__)
 #define WRNC(x, ...) EINA_LOG_DOM_WARN(x::log_domain(), __VA_ARGS__)
 #define ERRC(x, ...) EINA_LOG_DOM_ERR(x::log_domain(), __VA_ARGS__)
@@ -65,24 +113,46 @@ namespace sound_feature_extraction {
 #define FALLBACK_LOG(...) { fprintf(stderr, __VA_ARGS__); \
                             fprintf(stderr, "\n"); }
 
-#define DBG(...) FALLBACK_LOG(__VA_ARGS__)
-#define INF(...) FALLBACK_LOG(__VA_ARGS__)
-#define WRN(...) FALLBACK_LOG(__VA_ARGS__)
-#define ERR(...) FALLBACK_LOG(__VA_ARGS__)
-#define CRT(...) FALLBACK_LOG(__VA_ARGS__)
-
-#define DBGI(x, ...) FALLBACK_LOG(__VA_ARGS__)
-#define INFI(x, ...) FALLBACK_LOG(__VA_ARGS__)
-#define WRNI(x, ...) FALLBACK_LOG(__VA_ARGS__)
-#define ERRI(x, ...) FALLBACK_LOG(__VA_ARGS__)
-#define CRTI(x, ...) FALLBACK_LOG(__VA_ARGS__)
-
+#ifdef NO_DEBUG_LOGGING
+#define DBG(...) LOGGER_DISCARD(__VA_ARGS__)
+#define DBGI(x, ...) LOGGER_DISCARD(__VA_ARGS__)
+#define DBGC(x, ...) LOGGER_DISCARD(__VA_ARGS__)
+#else
+#define DBG(...) LOGGER_PRINT( \
+    this, EINA_LOG_LEVEL_DBG, FALLBACK_LOG, __VA_ARGS__)
+#define DBGI(x, ...) LOGGER_PRINT( \
+    x, EINA_LOG_LEVEL_DBG, FALLBACK_LOG, __VA_ARGS__)
 #define DBGC(x, ...) FALLBACK_LOG(__VA_ARGS__)
+#endif
+#define INF(...) LOGGER_PRINT( \
+    this, EINA_LOG_LEVEL_INFO, FALLBACK_LOG, __VA_ARGS__)
+#define WRN(...) LOGGER_PRINT( \
+    this, EINA_LOG_LEVEL_WARN, FALLBACK_LOG, __VA_ARGS__)
+#define ERR(...) LOGGER_PRINT( \
+    this, EINA_LOG_LEVEL_ERR, FALLBACK_LOG, __VA_ARGS__)
+#define CRT(...) LOGGER_PRINT( \
+    this, EINA_LOG_LEVEL_CRITICAL, FALLBACK_LOG, __VA_ARGS__)
+
+#define INFI(x, ...) LOGGER_PRINT( \
+    x, EINA_LOG_LEVEL_INFO, FALLBACK_LOG, __VA_ARGS__)
+#define WRNI(x, ...) LOGGER_PRINT( \
+    x, EINA_LOG_LEVEL_WARN, FALLBACK_LOG, __VA_ARGS__)
+#define ERRI(x, ...) LOGGER_PRINT( \
+    x, EINA_LOG_LEVEL_ERR, FALLBACK_LOG, __VA_ARGS__)
+#define CRTI(x, ...) LOGGER_PRINT( \
+    x, EINA_LOG_LEVEL_CRITICAL, FALLBACK_LOG, __VA_ARGS__)
+
 #define INFC(x, ...) FALLBACK_LOG(__VA_ARGS__)
 #define WRNC(x, ...) FALLBACK_LOG(__VA_ARGS__)
 #define ERRC(x, ...) FALLBACK_LOG(__VA_ARGS__)
 #define CRTC(x, ...) FALLBACK_LOG(__VA_ARGS__)
 
+#define EINA_LOG_LEVEL_CRITICAL 0
+#define EINA_LOG_LEVEL_ERR 1
+#define EINA_LOG_LEVEL_WARN 2
+#define EINA_LOG_LEVEL_INFO 3
+#define EINA_LOG_LEVEL_DBG 4
+
 #define EINA_COLOR_LIGHTRED  ""
 #define EINA_COLOR_RED       ""
 #define EINA_COLOR_LIGHTBLUE ""
@@ -120,8 +190,23 @@ class Logger {
 
   virtual ~Logger();
 
+  /// @brief Returns the Eina log domain, registering it on the first call.
+  /// @details The domains are registered lazily, so that constructing and
+  /// copying the transforms, e.g. by the concurrent setups, does not
+  /// contend for the global lock of Eina.
   int log_domain() const noexcept;
 
+  /// @brief The maximal enabled message level (EINA_LOG_LEVEL_*) of the
+  /// domain, cached when the domain is registered. All the levels are
+  /// enabled before that.
+  int log_level() const noexcept {
+    return log_level_.load(std::memory_order_relaxed);
+  }
+
+  /// @brief Updates log_level() after the level of the domain was changed,
+  /// e.g. with eina_log_domain_level_set().
+  void RefreshLogLevel() noexcept;
+
   std::string domain_str() const noexcept;
 
   void set_domain_str(const std::string &value) noexcept;
@@ -136,11 +221,13 @@ class Logger {
   static constexpr int kUnintializedLogDomain = -1;
 
 #ifdef EINA
-  void InitializeEina() noexcept;
+  int InitializeEina() const noexcept;
   void DisposeEina() noexcept;
 #endif
+  void UpdateLogLevel(int domain) const noexcept;
 
-  int log_domain_;
+  mutable std::atomic<int> log_domain_;
+  mutable std::atomic<int> log_level_;
   std::string domain_str_;
   std::string color_;
   bool suppressLoggingInitialized_;
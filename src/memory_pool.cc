@@ -0,0 +1,267 @@
+/*! @file memory_pool.cc
+ *  @brief Process-wide pool of the memory blocks used by the transform trees.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#include "src/memory_pool.h"
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstdint>
+#include <cstdlib>
+#include <iterator>
+#include <simd/memory.h>
+#include "src/metrics.h"
+#include "src/realtime.h"
+
+namespace sound_feature_extraction {
+
+/// @brief The granularity of mbind() and of the first touch.
+static constexpr size_t kPageSize = 4096;
+
+MemoryPool& MemoryPool::Instance() noexcept {
+  // The pool is never destroyed: the trees which live in static objects
+  // may return their blocks after the end of main()
+  static MemoryPool* instance = new MemoryPool();
+  return *instance;
+}
+
+MemoryPool::MemoryPool() noexcept
+    : idle_size_(0), used_size_(0), max_idle_size_(kDefaultMaxIdleSize),
+      huge_pages_(HugePages::kNone), numa_binding_(false) {
+}
+
+size_t MemoryPool::BucketSize(size_t size) noexcept {
+  if (size <= kPageSize) {
+    return kPageSize;
+  }
+  size_t power = kPageSize;
+  while (power * 2 < size) {
+    power *= 2;
+  }
+  // power < size <= 2 * power, split into quarters
+  size_t quarter = power / 4;
+  return power + (size - power + quarter - 1) / quarter * quarter;
+}
+
+int MemoryPool::CurrentNumaNode() noexcept {
+#ifdef SYS_getcpu
+  unsigned cpu, node;
+  if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) {
+    return node;
+  }
+#endif
+  return -1;
+}
+
+std::shared_ptr<void> MemoryPool::Acquire(size_t size) noexcept {
+  RealtimeSection::Check("MemoryPool::Acquire()");
+  size_t bucket = BucketSize(size);
+  Block block { nullptr, 0, -1 };  // NOLINT(whitespace/braces)
+  HugePages huge_pages;
+  int node = -1;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    huge_pages = huge_pages_;
+    if (numa_binding_) {
+      node = CurrentNumaNode();
+    }
+    auto it = idle_.find(bucket);
+    if (it != idle_.end()) {
+      auto& blocks = it->second;
+      for (auto bit = blocks.rbegin(); bit != blocks.rend(); ++bit) {
+        if (node < 0 || bit->Node == node) {
+          block = *bit;
+          blocks.erase(std::next(bit).base());
+          idle_size_ -= bucket;
+          break;
+        }
+      }
+    }
+  }
+  if (block.Data == nullptr) {
+    block = Allocate(bucket, huge_pages, node);
+    if (block.Data == nullptr) {
+      return nullptr;
+    }
+    static auto allocations = Metrics::Instance().Counter(
+        "sfe_memory_pool_allocations",
+        "The blocks which the memory pool had to allocate.");
+    allocations->Increment();
+  }
+  used_size_ += bucket;
+  return std::shared_ptr<void>(block.Data, [this, block, bucket](void*) {
+    RealtimeSection::Check("MemoryPool::Release()");
+    used_size_ -= bucket;
+    Release(block, bucket);
+  });
+}
+
+MemoryPool::Block MemoryPool::Allocate(size_t size, HugePages hugePages,
+                                       int node) noexcept {
+  Block block { nullptr, 0, -1 };  // NOLINT(whitespace/braces)
+  if (hugePages != HugePages::kNone && size >= kHugePageSize) {
+    size_t length = (size + kHugePageSize - 1) / kHugePageSize *
+        kHugePageSize;
+#ifdef MAP_HUGETLB
+    if (hugePages == HugePages::kExplicit) {
+      void* ptr = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+      if (ptr != MAP_FAILED) {
+        block.Data = ptr;
+        block.Mapped = length;
+      }
+    }
+#endif
+    void* ptr;
+    if (block.Data == nullptr &&
+        posix_memalign(&ptr, kHugePageSize, length) == 0) {
+      block.Data = ptr;
+#ifdef MADV_HUGEPAGE
+      madvise(ptr, length, MADV_HUGEPAGE);
+#endif
+    }
+  }
+  if (block.Data == nullptr) {
+    block.Data = malloc_aligned(size);
+    if (block.Data == nullptr) {
+      return block;
+    }
+  }
+  if (node >= 0) {
+    Bind(block.Data, size, node);
+    block.Node = node;
+  }
+  return block;
+}
+
+void MemoryPool::Bind(void* ptr, size_t size, int node) noexcept {
+  // Only the pages which belong to the block entirely
+  auto begin = (reinterpret_cast<uintptr_t>(ptr) + kPageSize - 1) &
+      ~(kPageSize - 1);
+  auto end = (reinterpret_cast<uintptr_t>(ptr) + size) & ~(kPageSize - 1);
+  if (end <= begin) {
+    return;
+  }
+#ifdef SYS_mbind
+  if (node < static_cast<int>(sizeof(unsigned long) * 8)) {  // NOLINT(*)
+    unsigned long mask = 1UL << node;  // NOLINT(runtime/int)
+    syscall(SYS_mbind, begin, end - begin, MPOL_PREFERRED, &mask,
+            sizeof(mask) * 8, 0);
+  }
+#endif
+  // The first touch places the pages on the node even if mbind() failed
+  for (auto page = begin; page < end; page += kPageSize) {
+    *reinterpret_cast<volatile char*>(page) = 0;
+  }
+}
+
+void MemoryPool::Prefault(void* ptr, size_t size) noexcept {
+  auto begin = reinterpret_cast<uintptr_t>(ptr);
+  for (auto page = begin; page < begin + size;
+       page = (page + kPageSize) & ~(kPageSize - 1)) {
+    auto byte = reinterpret_cast<volatile char*>(page);
+    *byte = *byte;
+  }
+}
+
+void MemoryPool::Free(const Block& block) noexcept {
+  if (block.Mapped > 0) {
+    munmap(block.Data, block.Mapped);
+  } else {
+    std::free(block.Data);
+  }
+}
+
+void MemoryPool::Release(const Block& block, size_t bucket) noexcept {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (idle_size_ + bucket <= max_idle_size_) {
+      idle_[bucket].push_back(block);
+      idle_size_ += bucket;
+      return;
+    }
+  }
+  Free(block);
+}
+
+size_t MemoryPool::idle_size() const noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return idle_size_;
+}
+
+size_t MemoryPool::used_size() const noexcept {
+  return used_size_;
+}
+
+size_t MemoryPool::max_idle_size() const noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return max_idle_size_;
+}
+
+void MemoryPool::set_max_idle_size(size_t value) noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  max_idle_size_ = value;
+  Trim(value);
+}
+
+HugePages MemoryPool::huge_pages() const noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return huge_pages_;
+}
+
+void MemoryPool::set_huge_pages(HugePages value) noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  huge_pages_ = value;
+  Trim(0);
+}
+
+bool MemoryPool::numa_binding() const noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return numa_binding_;
+}
+
+void MemoryPool::set_numa_binding(bool value) noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  numa_binding_ = value;
+  Trim(0);
+}
+
+void MemoryPool::Trim(size_t limit) noexcept {
+  for (auto& bucket : idle_) {
+    while (idle_size_ > limit && !bucket.second.empty()) {
+      Free(bucket.second.back());
+      bucket.second.pop_back();
+      idle_size_ -= bucket.first;
+    }
+  }
+}
+
+}  // namespace sound_feature_extraction
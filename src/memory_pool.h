@@ -0,0 +1,143 @@
+/*! @file memory_pool.h
+ *  @brief Process-wide pool of the memory blocks used by the transform trees.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#ifndef SRC_MEMORY_POOL_H_
+#define SRC_MEMORY_POOL_H_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace sound_feature_extraction {
+
+/// @brief How MemoryPool backs the blocks which are not smaller than
+/// a huge page.
+enum class HugePages {
+  /// @brief The regular pages.
+  kNone,
+  /// @brief The blocks are aligned to the huge page size and marked with
+  /// madvise(MADV_HUGEPAGE), so that the kernel may use transparent huge
+  /// pages.
+  kTransparent,
+  /// @brief The blocks are mapped from the preallocated huge pages
+  /// (MAP_HUGETLB). Falls back to kTransparent when they are exhausted.
+  kExplicit
+};
+
+/// @brief Keeps the memory blocks of the transform trees and of their
+/// execution contexts between extractions (Acquire(), ReleaseMemory()).
+/// @details The blocks are bucketed by size, rounded up to a quarter of
+/// a power of two, so that the configurations with similar solved sizes share
+/// the same blocks. Thus the resident memory scales with the number of
+/// the simultaneous extractions rather than with the number of
+/// the configurations. The idle blocks which do not fit into
+/// max_idle_size() are freed.
+/// @note The pool is process-wide and is protected by a mutex instead of
+/// being thread local, because the blocks are often released by a different
+/// thread than the one which acquired them.
+class MemoryPool {
+ public:
+  static MemoryPool& Instance() noexcept;
+
+  /// @brief Returns an aligned block of at least size bytes, which goes back
+  /// to the pool when the last reference is dropped.
+  /// @details If numa_binding() is set, the block is bound to the NUMA node
+  /// of the calling thread and its pages are touched by that thread, and
+  /// only the idle blocks of the same node are reused.
+  /// @return nullptr if the allocation failed.
+  std::shared_ptr<void> Acquire(size_t size) noexcept;
+
+  /// @brief The total size of the blocks which wait in the pool.
+  size_t idle_size() const noexcept;
+  /// @brief The total size of the acquired blocks which were not returned.
+  size_t used_size() const noexcept;
+  size_t max_idle_size() const noexcept;
+  /// @brief Frees the idle blocks which exceed the new limit. 0 disables
+  /// the pooling.
+  void set_max_idle_size(size_t value) noexcept;
+
+  HugePages huge_pages() const noexcept;
+  /// @brief Frees the idle blocks, so that the new blocks are allocated
+  /// according to the new value.
+  void set_huge_pages(HugePages value) noexcept;
+  bool numa_binding() const noexcept;
+  /// @brief Frees the idle blocks, so that the new blocks are allocated
+  /// according to the new value.
+  void set_numa_binding(bool value) noexcept;
+
+  /// @brief The size of the block which Acquire(size) actually allocates.
+  static size_t BucketSize(size_t size) noexcept;
+  /// @brief The NUMA node of the calling thread, -1 if it is unknown.
+  static int CurrentNumaNode() noexcept;
+  /// @brief Writes each page of the memory with its own value, so that
+  /// the subsequent accesses do not page fault.
+  static void Prefault(void* ptr, size_t size) noexcept;
+
+  static constexpr size_t kDefaultMaxIdleSize = 128 * 1024 * 1024;
+  static constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+
+ private:
+  struct Block {
+    void* Data;
+    /// @brief The length of the mapping if the block was mmap()-ed,
+    /// otherwise 0.
+    size_t Mapped;
+    /// @brief The NUMA node which the block is bound to, or -1.
+    int Node;
+  };
+
+  MemoryPool() noexcept;
+
+  static Block Allocate(size_t size, HugePages hugePages, int node) noexcept;
+  static void Free(const Block& block) noexcept;
+  /// @brief Sets the preferred NUMA node of the pages of the block and
+  /// touches them from the calling thread.
+  static void Bind(void* ptr, size_t size, int node) noexcept;
+  void Release(const Block& block, size_t bucket) noexcept;
+  /// @brief Frees the idle blocks until idle_size_ <= limit.
+  /// The caller must hold mutex_.
+  void Trim(size_t limit) noexcept;
+
+  mutable std::mutex mutex_;
+  std::unordered_map<size_t, std::vector<Block>> idle_;
+  size_t idle_size_;
+  std::atomic<size_t> used_size_;
+  size_t max_idle_size_;
+  HugePages huge_pages_;
+  bool numa_binding_;
+};
+
+}  // namespace sound_feature_extraction
+
+#endif  // SRC_MEMORY_POOL_H_
@@ -34,11 +34,13 @@
 #include <cstdio>
 #include <unistd.h>
 #include <sys/mman.h>
+#include "src/realtime.h"
 
 namespace sound_feature_extraction {
 
 MemoryProtector::MemoryProtector(const void* cptr, size_t size) noexcept
     : page_(nullptr), size_(0) {
+  RealtimeSection::Check("mprotect()");
   // mprotect() requires void*, not const void*
   auto ptr = const_cast<char*>(reinterpret_cast<const char*>(cptr));
   auto rem = reinterpret_cast<uintptr_t>(cptr) % PageSize();
@@ -81,6 +83,7 @@ long int MemoryProtector::PageSize() noexcept {
 
 MemoryProtector::~MemoryProtector() noexcept {
   if (page_ != nullptr) {
+    RealtimeSection::Check("mprotect()");
     int res = mprotect(page_, size_, PROT_READ | PROT_WRITE);
     if (res != 0) {
       fprintf(stderr, "mprotect(%p, %zu, PROT_READ | PROT_WRITE) failed with "
@@ -0,0 +1,208 @@
+/*! @file metrics.cc
+ *  @brief The process-wide operational metrics.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+#include "src/metrics.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+
+namespace sound_feature_extraction {
+
+MetricsHistogram::MetricsHistogram(const std::vector<double>& bounds)
+    : bounds_(bounds), buckets_(new std::atomic<uint64_t>[bounds.size() + 1]),
+      sum_(0) {
+  for (size_t i = 0; i <= bounds.size(); i++) {
+    buckets_[i] = 0;
+  }
+}
+
+void MetricsHistogram::Observe(double value) noexcept {
+  size_t bucket = std::lower_bound(bounds_.begin(), bounds_.end(), value) -
+      bounds_.begin();
+  buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+  uint64_t bits = sum_.load(std::memory_order_relaxed), updated;
+  do {
+    double sum;
+    memcpy(&sum, &bits, sizeof(sum));
+    sum += value;
+    memcpy(&updated, &sum, sizeof(sum));
+  } while (!sum_.compare_exchange_weak(bits, updated,
+                                       std::memory_order_relaxed));
+}
+
+const std::vector<double>& MetricsHistogram::bounds() const noexcept {
+  return bounds_;
+}
+
+std::vector<uint64_t> MetricsHistogram::counts() const noexcept {
+  std::vector<uint64_t> counts(bounds_.size() + 1);
+  uint64_t total = 0;
+  for (size_t i = 0; i < counts.size(); i++) {
+    total += buckets_[i].load(std::memory_order_relaxed);
+    counts[i] = total;
+  }
+  return counts;
+}
+
+double MetricsHistogram::sum() const noexcept {
+  uint64_t bits = sum_.load(std::memory_order_relaxed);
+  double sum;
+  memcpy(&sum, &bits, sizeof(sum));
+  return sum;
+}
+
+std::vector<double> MetricsHistogram::LatencyBounds() {
+  std::vector<double> bounds;
+  for (double decade = 1e-5; decade < 10; decade *= 10) {
+    bounds.push_back(decade);
+    bounds.push_back(decade * 2.5);
+    bounds.push_back(decade * 5);
+  }
+  bounds.push_back(10);
+  return bounds;
+}
+
+std::vector<double> MetricsHistogram::PowersOfTwo(double max) {
+  std::vector<double> bounds;
+  for (double bound = 1; bound <= max; bound *= 2) {
+    bounds.push_back(bound);
+  }
+  return bounds;
+}
+
+Metrics& Metrics::Instance() noexcept {
+  // Never destroyed, the counters may be touched during the exit
+  static Metrics* instance = new Metrics();
+  return *instance;
+}
+
+Metrics::Family* Metrics::GetFamily(const std::string& name,
+                                    const std::string& help,
+                                    const std::string& type) {
+  auto& family = families_[name];
+  if (family.Type.empty()) {
+    family.Help = help;
+    family.Type = type;
+  }
+  return &family;
+}
+
+MetricsCounter* Metrics::Counter(const std::string& name,
+                                 const std::string& help,
+                                 const std::string& labels) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto& counter = GetFamily(name, help, "counter")->Counters[labels];
+  if (!counter) {
+    counter.reset(new MetricsCounter());
+  }
+  return counter.get();
+}
+
+MetricsHistogram* Metrics::Histogram(const std::string& name,
+                                     const std::string& help,
+                                     const std::vector<double>& bounds,
+                                     const std::string& labels) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto& histogram = GetFamily(name, help, "histogram")->Histograms[labels];
+  if (!histogram) {
+    histogram.reset(new MetricsHistogram(bounds));
+  }
+  return histogram.get();
+}
+
+void Metrics::Callback(const std::string& name, const std::string& help,
+                       Type type, const std::function<double()>& value,
+                       const std::string& labels) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  GetFamily(name, help, type == Type::kCounter? "counter" : "gauge")->
+      Callbacks[labels] = value;
+}
+
+/// @brief Formats the value as OpenMetrics requires, e.g. "+Inf".
+static std::string FormatValue(double value) {
+  if (std::isinf(value)) {
+    return value > 0? "+Inf" : "-Inf";
+  }
+  std::ostringstream out;
+  out.precision(12);
+  out << value;
+  return out.str();
+}
+
+static std::string Labels(const std::string& labels,
+                          const std::string& extra = "") {
+  if (labels.empty() && extra.empty()) {
+    return "";
+  }
+  if (labels.empty() || extra.empty()) {
+    return '{' + labels + extra + '}';
+  }
+  return '{' + labels + ',' + extra + '}';
+}
+
+std::string Metrics::Snapshot() const {
+  std::ostringstream out;
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& fpair : families_) {
+    auto& name = fpair.first;
+    auto& family = fpair.second;
+    out << "# TYPE " << name << ' ' << family.Type << '\n'
+        << "# HELP " << name << ' ' << family.Help << '\n';
+    auto suffix = family.Type == "counter"? "_total" : "";
+    for (auto& counter : family.Counters) {
+      out << name << suffix << Labels(counter.first) << ' '
+          << counter.second->value() << '\n';
+    }
+    for (auto& callback : family.Callbacks) {
+      out << name << suffix << Labels(callback.first) << ' '
+          << FormatValue(callback.second()) << '\n';
+    }
+    for (auto& hpair : family.Histograms) {
+      auto& histogram = *hpair.second;
+      auto counts = histogram.counts();
+      for (size_t i = 0; i < counts.size(); i++) {
+        double bound = i < histogram.bounds().size()?
+            histogram.bounds()[i] : INFINITY;
+        out << name << "_bucket"
+            << Labels(hpair.first, "le=\"" + FormatValue(bound) + '"')
+            << ' ' << counts[i] << '\n';
+      }
+      out << name << "_count" << Labels(hpair.first) << ' '
+          << counts.back() << '\n'
+          << name << "_sum" << Labels(hpair.first) << ' '
+          << FormatValue(histogram.sum()) << '\n';
+    }
+  }
+  out << "# EOF\n";
+  return out.str();
+}
+
+}  // namespace sound_feature_extraction
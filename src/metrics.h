@@ -0,0 +1,143 @@
+/*! @file metrics.h
+ *  @brief The process-wide operational metrics.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+#ifndef SRC_METRICS_H_
+#define SRC_METRICS_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace sound_feature_extraction {
+
+/// @brief Monotonic counter which is safe to increment from any thread.
+class MetricsCounter {
+ public:
+  MetricsCounter() noexcept : value_(0) {
+  }
+
+  void Increment(uint64_t value = 1) noexcept {
+    value_.fetch_add(value, std::memory_order_relaxed);
+  }
+
+  uint64_t value() const noexcept {
+    return value_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<uint64_t> value_;
+};
+
+/// @brief Counts the observed values in the buckets with the fixed upper
+/// bounds. Observe() is lock-free.
+class MetricsHistogram {
+ public:
+  /// @param bounds The ascending upper bounds of the buckets, the last
+  /// +Inf bucket is implicit.
+  explicit MetricsHistogram(const std::vector<double>& bounds);
+
+  void Observe(double value) noexcept;
+
+  const std::vector<double>& bounds() const noexcept;
+  /// @brief Returns the cumulative counts of the buckets, including +Inf.
+  std::vector<uint64_t> counts() const noexcept;
+  double sum() const noexcept;
+
+  /// @brief The bounds from 10 us to 10 s, for the latencies in seconds.
+  static std::vector<double> LatencyBounds();
+  /// @brief The powers of two up to max.
+  static std::vector<double> PowersOfTwo(double max);
+
+ private:
+  std::vector<double> bounds_;
+  std::unique_ptr<std::atomic<uint64_t>[]> buckets_;
+  /// @brief The bits of the double sum, updated with compare_exchange.
+  std::atomic<uint64_t> sum_;
+};
+
+/// @brief The process-wide registry of the operational metrics, which
+/// Snapshot() writes in the OpenMetrics text format.
+/// @details The metrics are created once and live until the process exits,
+/// so the hot paths keep the returned pointers and only touch the atomics.
+/// The values which are already tracked elsewhere (the memory pool,
+/// the caches) are registered as callbacks and read on each snapshot.
+class Metrics {
+ public:
+  enum class Type {
+    kCounter,
+    kGauge
+  };
+
+  static Metrics& Instance() noexcept;
+
+  /// @brief Returns the counter of the family name (without "_total") with
+  /// the labels, e.g. "result=\"ok\"", creating it on the first call.
+  MetricsCounter* Counter(const std::string& name, const std::string& help,
+                          const std::string& labels = "");
+  MetricsHistogram* Histogram(const std::string& name,
+                              const std::string& help,
+                              const std::vector<double>& bounds,
+                              const std::string& labels = "");
+  /// @brief Registers the metric which value is read by the callback.
+  /// The registration of the same name and labels is replaced.
+  /// @note The callback is called under the lock of the registry, so it must
+  /// not create the metrics.
+  void Callback(const std::string& name, const std::string& help, Type type,
+                const std::function<double()>& value,
+                const std::string& labels = "");
+
+  std::string Snapshot() const;
+
+ private:
+  struct Family {
+    std::string Help;
+    std::string Type;
+    std::map<std::string, std::unique_ptr<MetricsCounter>> Counters;
+    std::map<std::string, std::unique_ptr<MetricsHistogram>> Histograms;
+    std::map<std::string, std::function<double()>> Callbacks;
+  };
+
+  Metrics() = default;
+
+  Family* GetFamily(const std::string& name, const std::string& help,
+                    const std::string& type);
+
+  mutable std::mutex mutex_;
+  std::map<std::string, Family> families_;
+};
+
+}  // namespace sound_feature_extraction
+
+#endif  // SRC_METRICS_H_
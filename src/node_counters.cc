@@ -0,0 +1,151 @@
+/*! @file node_counters.cc
+ *  @brief Cheap per node timers and hardware performance counters.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#include "src/node_counters.h"
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+
+namespace sound_feature_extraction {
+
+double TickClock::TicksPerNanosecond() noexcept {
+  static const double ratio = [] {
+    auto start = std::chrono::steady_clock::now();
+    auto start_ticks = Now();
+    std::chrono::steady_clock::duration elapsed;
+    do {
+      elapsed = std::chrono::steady_clock::now() - start;
+    } while (elapsed < std::chrono::milliseconds(5));
+    auto ticks = Now() - start_ticks;
+    return static_cast<double>(ticks) / std::chrono::duration_cast<
+        std::chrono::nanoseconds>(elapsed).count();
+  }();
+  return ratio;
+}
+
+std::chrono::high_resolution_clock::duration TickClock::ToDuration(
+    uint64_t ticks) noexcept {
+  return std::chrono::duration_cast<
+      std::chrono::high_resolution_clock::duration>(
+          std::chrono::duration<double, std::nano>(
+              ticks / TicksPerNanosecond()));
+}
+
+float NodeCounters::InstructionsPerCycle() const noexcept {
+  return Cycles > 0? static_cast<float>(Instructions) / Cycles : 0;
+}
+
+double NodeCounters::MemoryBandwidth() const noexcept {
+  auto seconds = std::chrono::duration_cast<std::chrono::duration<double>>(
+      TickClock::ToDuration(Ticks)).count();
+  return seconds > 0? CacheMisses * kCacheLineSize / seconds : 0;
+}
+
+namespace {
+
+/// @brief The perf events group of a thread, see HardwareCounters.
+class PerfEventsGroup {
+ public:
+  PerfEventsGroup() noexcept : leader_(-1), fds_ { -1, -1, -1 } {
+    static const uint64_t configs[] = {
+      PERF_COUNT_HW_CPU_CYCLES,
+      PERF_COUNT_HW_INSTRUCTIONS,
+      PERF_COUNT_HW_CACHE_MISSES
+    };
+    for (int i = 0; i < kEventsCount; i++) {
+      perf_event_attr attr;
+      memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = configs[i];
+      attr.read_format = PERF_FORMAT_GROUP;
+      attr.disabled = i == 0;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      fds_[i] = syscall(SYS_perf_event_open, &attr, 0, -1, leader_, 0);
+      if (fds_[i] < 0) {
+        Close();
+        return;
+      }
+      if (i == 0) {
+        leader_ = fds_[0];
+      }
+    }
+    ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  }
+
+  ~PerfEventsGroup() {
+    Close();
+  }
+
+  bool Read(HardwareCounters::Values* values) const noexcept {
+    uint64_t data[1 + kEventsCount];
+    if (leader_ < 0 ||
+        read(leader_, data, sizeof(data)) != sizeof(data)) {
+      return false;
+    }
+    values->Cycles = data[1];
+    values->Instructions = data[2];
+    values->CacheMisses = data[3];
+    return true;
+  }
+
+ private:
+  static constexpr int kEventsCount = 3;
+
+  void Close() noexcept {
+    for (int i = 0; i < kEventsCount; i++) {
+      if (fds_[i] >= 0) {
+        close(fds_[i]);
+        fds_[i] = -1;
+      }
+    }
+    leader_ = -1;
+  }
+
+  int leader_;
+  int fds_[kEventsCount];
+};
+
+}  // namespace
+
+bool HardwareCounters::Read(Values* values) noexcept {
+  static thread_local PerfEventsGroup group;
+  if (!group.Read(values)) {
+    memset(values, 0, sizeof(*values));
+    return false;
+  }
+  return true;
+}
+
+}  // namespace sound_feature_extraction
@@ -0,0 +1,132 @@
+/*! @file node_counters.h
+ *  @brief Cheap per node timers and hardware performance counters.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#ifndef SRC_NODE_COUNTERS_H_
+#define SRC_NODE_COUNTERS_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace sound_feature_extraction {
+
+/// @brief How much the transform tree measures about each node.
+enum class ProfilingLevel {
+  /// @brief Only the total execution time.
+  kOff,
+  /// @brief The elapsed time stamp counter ticks of each node.
+  kCoarse,
+  /// @brief kCoarse plus the CPU cycles, the retired instructions and
+  /// the cache misses of each node (Linux perf events).
+  kFull
+};
+
+/// @brief The statistics of a single node, accumulated over its runs.
+struct NodeCounters {
+  NodeCounters() noexcept
+      : Runs(0), Ticks(0), Cycles(0), Instructions(0), CacheMisses(0) {
+  }
+
+  NodeCounters& operator+=(const NodeCounters& other) noexcept {
+    Runs += other.Runs;
+    Ticks += other.Ticks;
+    Cycles += other.Cycles;
+    Instructions += other.Instructions;
+    CacheMisses += other.CacheMisses;
+    return *this;
+  }
+
+  /// @brief Returns the retired instructions per cycle, or 0 if the cycles
+  /// were not counted.
+  float InstructionsPerCycle() const noexcept;
+  /// @brief Estimates the memory traffic in bytes per second, assuming that
+  /// each cache miss loads a whole cache line.
+  double MemoryBandwidth() const noexcept;
+
+  /// @brief The size of the cache line which a miss loads.
+  static constexpr size_t kCacheLineSize = 64;
+
+  uint64_t Runs;
+  /// @brief See TickClock.
+  uint64_t Ticks;
+  uint64_t Cycles;
+  uint64_t Instructions;
+  /// @brief The last level cache misses.
+  uint64_t CacheMisses;
+};
+
+/// @brief The time stamp counter on x86 and the steady clock nanoseconds
+/// elsewhere. Reading it takes a few nanoseconds, unlike
+/// high_resolution_clock::now().
+class TickClock {
+ public:
+  static uint64_t Now() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+  }
+
+  /// @brief Converts the ticks to time. The first call calibrates the clock,
+  /// which takes a few milliseconds.
+  static std::chrono::high_resolution_clock::duration ToDuration(
+      uint64_t ticks) noexcept;
+
+ private:
+  static double TicksPerNanosecond() noexcept;
+};
+
+/// @brief Owns the perf events group of the calling thread, which counts
+/// the user space cycles, instructions and cache misses.
+/// @note Only the calling thread is counted, so the work which a transform
+/// hands off to the OpenMP threads is missed.
+class HardwareCounters {
+ public:
+  struct Values {
+    uint64_t Cycles;
+    uint64_t Instructions;
+    uint64_t CacheMisses;
+  };
+
+  /// @brief Reads the counters of the calling thread, opening them on
+  /// the first call.
+  /// @return false if the perf events are not available (e.g. because of
+  /// /proc/sys/kernel/perf_event_paranoid), values are zeroed then.
+  static bool Read(Values* values) noexcept;
+};
+
+}  // namespace sound_feature_extraction
+#endif  // SRC_NODE_COUNTERS_H_
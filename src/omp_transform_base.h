@@ -31,7 +31,8 @@
 #ifndef SRC_OMP_TRANSFORM_BASE_H_
 #define SRC_OMP_TRANSFORM_BASE_H_
 
-#include "src/safe_omp.h"
+#include "src/parallel_transform.h"
+#include "src/thread_pool.h"
 #include "src/transform_base.h"
 
 extern "C" {
@@ -43,10 +44,12 @@ extern "C" {
 namespace sound_feature_extraction {
 
 template <typename FIN, typename FOUT>
-class OmpAwareTransform : public virtual TransformBase<FIN, FOUT> {
+class OmpAwareTransform : public virtual TransformBase<FIN, FOUT>,
+                          public ParallelTransform {
  public:
   OmpAwareTransform() noexcept
-    : threads_number_(get_omp_transforms_max_threads_num()) {
+    : threads_number_(get_omp_transforms_max_threads_num()), grainsize_(1),
+      placement_("auto") {
   }
 
   virtual bool BufferInvariant() const noexcept override {
@@ -56,7 +59,31 @@ class OmpAwareTransform : public virtual TransformBase<FIN, FOUT> {
   TRANSFORM_PARAMETERS_SUPPORT(FORWARD_MACROS(OmpAwareTransform<FIN, FOUT>))
 
   TP(threads_number, int, get_omp_transforms_max_threads_num(),
-     "The maximal number of OpenMP threads.")
+     "The maximal number of threads.")
+  TP(grainsize, int, 1,
+     "The minimal number of buffers which are processed by one thread.")
+  TP(placement, std::string, "auto",
+     "Where the transform runs: \"serial\", \"parallel\" or \"auto\", "
+     "which is chosen by the estimated and the measured work.")
+
+  virtual Placement forced_placement() const noexcept override {
+    if (placement_ == "serial") {
+      return Placement::kSerial;
+    }
+    if (placement_ == "parallel") {
+      return Placement::kParallel;
+    }
+    return Placement::kAuto;
+  }
+
+ protected:
+  /// @brief Calls body(begin, end) on the ranges of [0, count) in parallel
+  /// on the library thread pool, or on the whole range if serial().
+  template <typename F>
+  void ParallelFor(size_t count, const F& body) const noexcept {
+    ThreadPool::Instance().ParallelFor(
+        count, grainsize(), serial()? 1 : threads_number(), body);
+  }
 };
 
 template <typename FIN, typename FOUT>
@@ -65,9 +92,27 @@ bool OmpAwareTransform<FIN, FOUT>::validate_threads_number(
   return value >= 1;
 }
 
+template <typename FIN, typename FOUT>
+bool OmpAwareTransform<FIN, FOUT>::validate_grainsize(
+    const int& value) noexcept {
+  return value >= 1;
+}
+
+template <typename FIN, typename FOUT>
+bool OmpAwareTransform<FIN, FOUT>::validate_placement(
+    const std::string& value) noexcept {
+  return value == "auto" || value == "serial" || value == "parallel";
+}
+
 template <typename FIN, typename FOUT>
 RTP(FORWARD_MACROS(OmpAwareTransform<FIN, FOUT>), threads_number)
 
+template <typename FIN, typename FOUT>
+RTP(FORWARD_MACROS(OmpAwareTransform<FIN, FOUT>), grainsize)
+
+template <typename FIN, typename FOUT>
+RTP(FORWARD_MACROS(OmpAwareTransform<FIN, FOUT>), placement)
+
 template <typename F>
 class UniformFormatOmpAwareTransform
     : public virtual OmpAwareTransform<F, F>,
@@ -131,6 +176,13 @@ class OmpTransformBaseInterface
     : public virtual OmpTransformBaseBufferTypeDispatcher<
           typename FIN::BufferType, typename FOUT::BufferType>,
       public virtual OmpAwareTransform<FIN, FOUT> {
+ public:
+  /// @brief Each output buffer is calculated from the input buffer with
+  /// the same index only.
+  virtual Overlap RequiredOverlap(const Overlap& output)
+      const noexcept override {
+    return output;
+  }
 };
 
 template <typename FIN, typename FOUT,
@@ -150,12 +202,11 @@ class OmpTransformBaseBufferTypeProxy
 
   virtual void Do(const InBuffers& in, OutBuffers* out)
       const noexcept override final {
-#ifdef HAVE_OPENMP
-    #pragma omp parallel for num_threads(this->threads_number())
-#endif
-    for (size_t i = 0; i < in.Count(); i++) {
-      this->Do(in[i], &(*out)[i]);
-    }
+    this->ParallelFor(in.Count(), [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        this->Do(in[i], &(*out)[i]);
+      }
+    });
   }
 };
 
@@ -176,12 +227,11 @@ class OmpTransformBaseBufferTypeProxy<FIN, FOUT, FINELEMENT, FOUTELEMENT*>
 
   virtual void Do(const InBuffers& in, OutBuffers* out)
       const noexcept override final {
-#ifdef HAVE_OPENMP
-    #pragma omp parallel for num_threads(this->threads_number())
-#endif
-    for (size_t i = 0; i < in.Count(); i++) {
-      this->Do(in[i], (*out)[i]);
-    }
+    this->ParallelFor(in.Count(), [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        this->Do(in[i], (*out)[i]);
+      }
+    });
   }
 };
 
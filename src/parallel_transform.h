@@ -0,0 +1,98 @@
+/*! @file parallel_transform.h
+ *  @brief Interface of the transforms which split their buffers among threads.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#ifndef SRC_PARALLEL_TRANSFORM_H_
+#define SRC_PARALLEL_TRANSFORM_H_
+
+#include <atomic>
+
+namespace sound_feature_extraction {
+
+/// @brief Where the node of ParallelTransform runs.
+enum class Placement {
+  /// @brief Decided by TransformTree.
+  kAuto,
+  /// @brief In the calling thread.
+  kSerial,
+  /// @brief On the library thread pool.
+  kParallel
+};
+
+/// @brief Implemented by the transforms which process their buffers
+/// on the thread pool (see OmpAwareTransform).
+/// @details Waking the threads costs more than processing a few small
+/// buffers, so TransformTree makes such a node serial() if its estimated
+/// work, the number of the elements times ElementCost(), is small, and
+/// revises the decision by the measured time of the node when profiling
+/// is enabled.
+class ParallelTransform {
+ public:
+  ParallelTransform() noexcept : serial_(false) {
+  }
+
+  ParallelTransform(const ParallelTransform& other) noexcept
+      : serial_(other.serial()) {
+  }
+
+#if (__GNUC__ == 4 && __GNUC_MINOR__ < 8)
+  virtual ~ParallelTransform() {};
+#else
+  virtual ~ParallelTransform() = default;
+#endif
+
+  /// @brief The relative cost of processing one element of the buffers,
+  /// 1 for a simple elementwise operation.
+  virtual float ElementCost() const noexcept {
+    return 1;
+  }
+
+  /// @brief The placement which overrides the decision of TransformTree,
+  /// e.g. the one specified in the feature string.
+  virtual Placement forced_placement() const noexcept {
+    return Placement::kAuto;
+  }
+
+  /// @brief Indicates whether Do() runs in the calling thread only.
+  bool serial() const noexcept {
+    return serial_.load(std::memory_order_relaxed);
+  }
+
+  /// @note May be called concurrently with Do().
+  void set_serial(bool value) noexcept {
+    serial_.store(value, std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<bool> serial_;
+};
+
+}  // namespace sound_feature_extraction
+#endif  // SRC_PARALLEL_TRANSFORM_H_
@@ -29,32 +29,39 @@
  */
 
 #include "src/parameterizable.h"
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wold-style-cast"
-#pragma GCC diagnostic ignored "-Wunused-local-typedefs"
-#include <boost/algorithm/string/trim.hpp>
-#pragma GCC diagnostic pop
-#include <sstream>
+#include <cctype>
 
 namespace sound_feature_extraction {
 
+/// @brief Returns str[begin, end) without the leading and the trailing
+/// whitespace.
+static std::string Trimmed(const std::string& str, size_t begin,
+                           size_t end) {
+  while (begin < end && isspace(static_cast<unsigned char>(str[begin]))) {
+    begin++;
+  }
+  while (end > begin && isspace(static_cast<unsigned char>(str[end - 1]))) {
+    end--;
+  }
+  return str.substr(begin, end - begin);
+}
+
 ParametersMap Parameterizable::Parse(
     const std::string& line) {
   ParametersMap parameters;
-  std::istringstream ss(line);
-  std::string s;
-  int index = 0;
-  while (std::getline(ss, s, ',')) {
-    auto pos = s.find('=');
-    if (pos == s.npos) {
-      throw ParseParametersException(line, index);
+  size_t begin = 0;
+  while (begin < line.size()) {
+    auto end = line.find(',', begin);
+    if (end == line.npos) {
+      end = line.size();
+    }
+    auto pos = line.find('=', begin);
+    if (pos >= end) {
+      throw ParseParametersException(line, begin);
     }
-    auto pname = s.substr(0, pos);
-    boost::algorithm::trim(pname);
-    auto pvalue = s.substr(pos + 1, s.size());
-    boost::algorithm::trim(pvalue);
-    parameters.insert(std::make_pair(pname, pvalue));
-    index += s.size() + 1;
+    parameters.insert(std::make_pair(Trimmed(line, begin, pos),
+                                     Trimmed(line, pos + 1, end)));
+    begin = end + 1;
   }
   return parameters;
 }
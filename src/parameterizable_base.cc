@@ -29,6 +29,9 @@
  */
 
 #include "src/parameterizable_base.h"
+#include <cctype>
+#include <climits>
+#include <cstdio>
 
 namespace sound_feature_extraction {
 
@@ -64,13 +67,18 @@ void ParameterizableBase::SetParameter(const std::string& name,
   if (setter == ParameterSetters().end()) {
     throw ParameterSetterNotRegisteredException(name, HostName());
   }
+  // The typed setters overwrite the raw string with the canonical
+  // representation of the parsed value (the same as for the default one),
+  // so that "1", "01" and the omitted parameter compare equal.
+  auto previous = values_[name];
+  UpdateParameter(name, value);
   try {
     setter->second(this, value);
   }
   catch(const InvalidParameterValueException&) {
+    UpdateParameter(name, previous);
     throw InvalidParameterValueException(name, value, HostName());
   }
-  UpdateParameter(name, value);
 }
 
 void ParameterizableBase::UpdateParameter(const std::string& name,
@@ -135,4 +143,73 @@ std::string Parse(const std::string& value, identity<std::string>) {
   return value;
 }
 
+/// @brief Calls on_token(begin, end) for each whitespace separated token
+/// of the value until it returns false.
+/// @return False if on_token() failed or there are no tokens.
+template <class F>
+static bool ForEachToken(const std::string& value, F on_token) {
+  bool found = false;
+  size_t pos = 0, size = value.size();
+  while (true) {
+    while (pos < size && isspace(static_cast<unsigned char>(value[pos]))) {
+      pos++;
+    }
+    if (pos == size) {
+      return found;
+    }
+    size_t begin = pos;
+    while (pos < size && !isspace(static_cast<unsigned char>(value[pos]))) {
+      pos++;
+    }
+    if (!on_token(begin, pos)) {
+      return false;
+    }
+    found = true;
+  }
+}
+
+bool SplitWords(const std::string& value,
+                std::vector<std::string>* words) noexcept {
+  words->clear();
+  return ForEachToken(value, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      if (!isalnum(static_cast<unsigned char>(value[i])) && value[i] != '_') {
+        return false;
+      }
+    }
+    words->emplace_back(value, begin, end - begin);
+    return true;
+  });
+}
+
+bool SplitIntegers(const std::string& value,
+                   std::vector<int>* numbers) noexcept {
+  numbers->clear();
+  return ForEachToken(value, [&](size_t begin, size_t end) {
+    long number = 0;  // NOLINT(runtime/int)
+    for (size_t i = begin; i < end; i++) {
+      if (!isdigit(static_cast<unsigned char>(value[i]))) {
+        return false;
+      }
+      number = number * 10 + (value[i] - '0');
+      if (number > INT_MAX) {
+        return false;
+      }
+    }
+    numbers->push_back(number);
+    return true;
+  });
+}
+
 }  // namespace sound_feature_extraction
+
+namespace std {
+
+string to_string(const sound_feature_extraction::ExactFloat& value)
+    noexcept {
+  char str[32];
+  snprintf(str, sizeof(str), "%.9g", value.Value);
+  return str;
+}
+
+}  // namespace std
@@ -31,6 +31,8 @@
 #ifndef SRC_PARAMETERIZABLE_BASE_H_
 #define SRC_PARAMETERIZABLE_BASE_H_
 
+#include <string>
+#include <vector>
 #include "src/parameterizable.h"
 
 namespace sound_feature_extraction {
@@ -105,12 +107,51 @@ size_t Parse(const std::string& value, identity<size_t>);
 float Parse(const std::string& value, identity<float>);
 std::string Parse(const std::string& value, identity<std::string>);
 
+/// @brief Splits the list of words ([A-Za-z0-9_]+) separated by whitespace,
+/// e.g. "average skew".
+/// @return False if the value has no words or contains other characters.
+bool SplitWords(const std::string& value,
+                std::vector<std::string>* words) noexcept;
+
+/// @brief Parses the list of non-negative integers separated by whitespace,
+/// e.g. "1 2 3 3".
+/// @return False if the value has no numbers, contains other characters
+/// or a number does not fit into int.
+bool SplitIntegers(const std::string& value,
+                   std::vector<int>* numbers) noexcept;
+
+}  // namespace sound_feature_extraction
+
+namespace sound_feature_extraction {
+
+/// @brief A float parameter value which std::to_string() prints with enough
+/// digits to parse the same value back. The plain std::to_string() keeps
+/// only 6 decimals, so that e.g. 1e-7 and 2e-7 would be stored and
+/// compared as the same parameter.
+struct ExactFloat {
+  float Value;
+};
+
+/// @brief Wraps the value of a parameter for std::to_string(), which
+/// produces its canonical text.
+template <typename T>
+inline const T& ParameterValue(const T& value) noexcept {
+  return value;
+}
+
+inline ExactFloat ParameterValue(float value) noexcept {
+  return { value };
+}
+
 }  // namespace sound_feature_extraction
 
 namespace std {
   inline string to_string(const string& str) noexcept {
     return str;
   }
+
+  string to_string(const sound_feature_extraction::ExactFloat& value)
+      noexcept;
 }
 
 #endif  // SRC_PARAMETERIZABLE_BASE_H_
@@ -0,0 +1,72 @@
+/*! @file precomputed_state.h
+ *  @brief Interface of the transforms which can save their precalculated data.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+
+#ifndef SRC_PRECOMPUTED_STATE_H_
+#define SRC_PRECOMPUTED_STATE_H_
+
+#include <memory>
+#include <string>
+
+namespace sound_feature_extraction {
+
+/// @brief Implemented by the transforms which precalculate a lot of data in
+/// Initialize(), e.g. the filter coefficients.
+/// @details TransformTree::Save() writes the state of each such transform to
+/// the file and TransformTree::Load() passes it back from the memory mapped
+/// file, so that Initialize() does not have to calculate it again.
+class PrecomputedState {
+ public:
+#if (__GNUC__ == 4 && __GNUC_MINOR__ < 8)
+  virtual ~PrecomputedState() {};
+#else
+  virtual ~PrecomputedState() = default;
+#endif
+
+  /// @brief The alignment of the data passed to LoadState(), in bytes.
+  static constexpr size_t kAlignment = 64;
+
+  /// @brief Appends the data calculated by Initialize() to out.
+  virtual void SaveState(std::string* out) const = 0;
+
+  /// @brief Adopts the data previously written by SaveState(). It is called
+  /// before Initialize(), which must skip the calculations then.
+  /// @param owner Keeps data alive, so the transform may reference it
+  /// instead of copying.
+  /// @param data The kAlignment aligned state.
+  /// @param size The size of data in bytes.
+  /// @return False if the state does not fit the transform's parameters.
+  virtual bool LoadState(const std::shared_ptr<const void>& owner,
+                         const char* data, size_t size) const = 0;
+};
+
+}  // namespace sound_feature_extraction
+#endif  // SRC_PRECOMPUTED_STATE_H_
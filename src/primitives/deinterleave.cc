@@ -0,0 +1,269 @@
+/*! @file deinterleave.cc
+ *  @brief Splitting the interleaved channels into the planar buffers.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#include "src/primitives/deinterleave.h"
+#ifdef SIMD_X86
+#include <immintrin.h>
+#elif defined(SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace sound_feature_extraction {
+
+typedef void (*DeinterleaveKernel)(const int16_t* in, size_t length,
+                                   size_t stride, int16_t* out);
+
+/// @brief Deinterleaves the samples [begin, length) of each channel.
+template <class T>
+static void DeinterleaveTail(const T* in, int channels, size_t begin,
+                             size_t length, size_t stride, T* out) {
+  for (size_t i = begin; i < length; i++) {
+    for (int c = 0; c < channels; c++) {
+      out[c * stride + i] = in[i * channels + c];
+    }
+  }
+}
+
+template <int C>
+static void DeinterleaveScalar(const int16_t* in, size_t length,
+                               size_t stride, int16_t* out) {
+  DeinterleaveTail(in, C, 0, length, stride, out);
+}
+
+#ifdef SIMD_X86
+SIMD_TARGET("sse4.1")
+static void Deinterleave2SSE41(const int16_t* in, size_t length,
+                               size_t stride, int16_t* out) {
+  // [l0 r0 l1 r1 l2 r2 l3 r3] -> [l0 l1 l2 l3 r0 r1 r2 r3]
+  const __m128i mask = _mm_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13,
+                                     2, 3, 6, 7, 10, 11, 14, 15);
+  size_t i = 0;
+  for (; i + 8 <= length; i += 8) {
+    auto src = reinterpret_cast<const __m128i*>(in + i * 2);
+    __m128i a = _mm_shuffle_epi8(_mm_loadu_si128(src), mask);
+    __m128i b = _mm_shuffle_epi8(_mm_loadu_si128(src + 1), mask);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                     _mm_unpacklo_epi64(a, b));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + stride + i),
+                     _mm_unpackhi_epi64(a, b));
+  }
+  DeinterleaveTail(in, 2, i, length, stride, out);
+}
+
+SIMD_TARGET("sse4.1")
+static void Deinterleave4SSE41(const int16_t* in, size_t length,
+                               size_t stride, int16_t* out) {
+  // Group the two frames of each channel into a 32-bit word
+  const __m128i mask = _mm_setr_epi8(0, 1, 8, 9, 2, 3, 10, 11,
+                                     4, 5, 12, 13, 6, 7, 14, 15);
+  size_t i = 0;
+  for (; i + 8 <= length; i += 8) {
+    auto src = reinterpret_cast<const __m128i*>(in + i * 4);
+    __m128i v0 = _mm_shuffle_epi8(_mm_loadu_si128(src), mask);
+    __m128i v1 = _mm_shuffle_epi8(_mm_loadu_si128(src + 1), mask);
+    __m128i v2 = _mm_shuffle_epi8(_mm_loadu_si128(src + 2), mask);
+    __m128i v3 = _mm_shuffle_epi8(_mm_loadu_si128(src + 3), mask);
+    __m128i t0 = _mm_unpacklo_epi32(v0, v1);
+    __m128i t1 = _mm_unpacklo_epi32(v2, v3);
+    __m128i t2 = _mm_unpackhi_epi32(v0, v1);
+    __m128i t3 = _mm_unpackhi_epi32(v2, v3);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                     _mm_unpacklo_epi64(t0, t1));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + stride + i),
+                     _mm_unpackhi_epi64(t0, t1));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * stride + i),
+                     _mm_unpacklo_epi64(t2, t3));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 3 * stride + i),
+                     _mm_unpackhi_epi64(t2, t3));
+  }
+  DeinterleaveTail(in, 4, i, length, stride, out);
+}
+
+SIMD_TARGET("sse4.1")
+static void Deinterleave8SSE41(const int16_t* in, size_t length,
+                               size_t stride, int16_t* out) {
+  size_t i = 0;
+  for (; i + 8 <= length; i += 8) {
+    // 8 x 8 transpose, each row is a frame
+    auto src = reinterpret_cast<const __m128i*>(in + i * 8);
+    __m128i r[8];
+    for (int k = 0; k < 8; k++) {
+      r[k] = _mm_loadu_si128(src + k);
+    }
+    __m128i a[8], b[8];
+    for (int k = 0; k < 4; k++) {
+      a[k * 2] = _mm_unpacklo_epi16(r[k * 2], r[k * 2 + 1]);
+      a[k * 2 + 1] = _mm_unpackhi_epi16(r[k * 2], r[k * 2 + 1]);
+    }
+    for (int k = 0; k < 2; k++) {
+      b[k * 4] = _mm_unpacklo_epi32(a[k * 4], a[k * 4 + 2]);
+      b[k * 4 + 1] = _mm_unpackhi_epi32(a[k * 4], a[k * 4 + 2]);
+      b[k * 4 + 2] = _mm_unpacklo_epi32(a[k * 4 + 1], a[k * 4 + 3]);
+      b[k * 4 + 3] = _mm_unpackhi_epi32(a[k * 4 + 1], a[k * 4 + 3]);
+    }
+    for (int k = 0; k < 4; k++) {
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * k * stride + i),
+                       _mm_unpacklo_epi64(b[k], b[k + 4]));
+      _mm_storeu_si128(
+          reinterpret_cast<__m128i*>(out + (2 * k + 1) * stride + i),
+          _mm_unpackhi_epi64(b[k], b[k + 4]));
+    }
+  }
+  DeinterleaveTail(in, 8, i, length, stride, out);
+}
+
+SIMD_TARGET("avx2")
+static void Deinterleave2AVX2(const int16_t* in, size_t length,
+                              size_t stride, int16_t* out) {
+  const __m256i mask = _mm256_setr_epi8(
+      0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15,
+      0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15);
+  size_t i = 0;
+  for (; i + 16 <= length; i += 16) {
+    auto src = reinterpret_cast<const __m256i*>(in + i * 2);
+    __m256i a = _mm256_shuffle_epi8(_mm256_loadu_si256(src), mask);
+    __m256i b = _mm256_shuffle_epi8(_mm256_loadu_si256(src + 1), mask);
+    // unpack works within 128-bit lanes, restore the order of the quadwords
+    __m256i left = _mm256_permute4x64_epi64(_mm256_unpacklo_epi64(a, b),
+                                            0xD8);
+    __m256i right = _mm256_permute4x64_epi64(_mm256_unpackhi_epi64(a, b),
+                                             0xD8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), left);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + stride + i), right);
+  }
+  Deinterleave2SSE41(in + i * 2, length - i, stride, out + i);
+}
+#elif defined(SIMD_NEON)
+static void Deinterleave2NEON(const int16_t* in, size_t length,
+                              size_t stride, int16_t* out) {
+  size_t i = 0;
+  for (; i + 8 <= length; i += 8) {
+    int16x8x2_t vec = vld2q_s16(in + i * 2);
+    vst1q_s16(out + i, vec.val[0]);
+    vst1q_s16(out + stride + i, vec.val[1]);
+  }
+  DeinterleaveTail(in, 2, i, length, stride, out);
+}
+
+static void Deinterleave4NEON(const int16_t* in, size_t length,
+                              size_t stride, int16_t* out) {
+  size_t i = 0;
+  for (; i + 8 <= length; i += 8) {
+    int16x8x4_t vec = vld4q_s16(in + i * 4);
+    for (int c = 0; c < 4; c++) {
+      vst1q_s16(out + c * stride + i, vec.val[c]);
+    }
+  }
+  DeinterleaveTail(in, 4, i, length, stride, out);
+}
+
+static void Deinterleave8NEON(const int16_t* in, size_t length,
+                              size_t stride, int16_t* out) {
+  size_t i = 0;
+  for (; i + 8 <= length; i += 8) {
+    // val[c] holds the channels c and c + 4 of 4 frames alternately
+    int16x8x4_t first = vld4q_s16(in + i * 8);
+    int16x8x4_t second = vld4q_s16(in + i * 8 + 32);
+    for (int c = 0; c < 4; c++) {
+      int16x8x2_t split = vuzpq_s16(first.val[c], second.val[c]);
+      vst1q_s16(out + c * stride + i, split.val[0]);
+      vst1q_s16(out + (c + 4) * stride + i, split.val[1]);
+    }
+  }
+  DeinterleaveTail(in, 8, i, length, stride, out);
+}
+#endif
+
+static const SimdKernel<DeinterleaveKernel> kDeinterleave2Kernels[] {
+#ifdef SIMD_X86
+  { InstructionSet::kAVX2, Deinterleave2AVX2 },
+  { InstructionSet::kSSE41, Deinterleave2SSE41 },
+#elif defined(SIMD_NEON)
+  { InstructionSet::kNEON, Deinterleave2NEON },
+#endif
+  { InstructionSet::kScalar, DeinterleaveScalar<2> }
+};
+
+static const SimdKernel<DeinterleaveKernel> kDeinterleave4Kernels[] {
+#ifdef SIMD_X86
+  { InstructionSet::kSSE41, Deinterleave4SSE41 },
+#elif defined(SIMD_NEON)
+  { InstructionSet::kNEON, Deinterleave4NEON },
+#endif
+  { InstructionSet::kScalar, DeinterleaveScalar<4> }
+};
+
+static const SimdKernel<DeinterleaveKernel> kDeinterleave8Kernels[] {
+#ifdef SIMD_X86
+  { InstructionSet::kSSE41, Deinterleave8SSE41 },
+#elif defined(SIMD_NEON)
+  { InstructionSet::kNEON, Deinterleave8NEON },
+#endif
+  { InstructionSet::kScalar, DeinterleaveScalar<8> }
+};
+
+/// @brief Returns the kernel for the channels or nullptr if there is no
+/// dedicated one.
+static const SimdKernel<DeinterleaveKernel>* DispatchDeinterleave(
+    int channels) noexcept {
+  switch (channels) {
+    case 2:
+      return &SimdAware::Dispatch(kDeinterleave2Kernels);
+    case 4:
+      return &SimdAware::Dispatch(kDeinterleave4Kernels);
+    case 8:
+      return &SimdAware::Dispatch(kDeinterleave8Kernels);
+    default:
+      return nullptr;
+  }
+}
+
+void Deinterleave(bool simd, const int16_t* in, int channels, size_t length,
+                  size_t stride, int16_t* out) noexcept {
+  auto kernel = simd? DispatchDeinterleave(channels) : nullptr;
+  if (kernel == nullptr) {
+    DeinterleaveTail(in, channels, 0, length, stride, out);
+    return;
+  }
+  kernel->Function(in, length, stride, out);
+}
+
+void Deinterleave(const int32_t* in, int channels, size_t length,
+                  size_t stride, int32_t* out) noexcept {
+  DeinterleaveTail(in, channels, 0, length, stride, out);
+}
+
+InstructionSet DeinterleaveInstructionSet(int channels) noexcept {
+  auto kernel = DispatchDeinterleave(channels);
+  return kernel != nullptr? kernel->Isa : InstructionSet::kScalar;
+}
+
+}  // namespace sound_feature_extraction
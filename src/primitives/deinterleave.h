@@ -0,0 +1,63 @@
+/*! @file deinterleave.h
+ *  @brief Splitting the interleaved channels into the planar buffers.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#ifndef SRC_PRIMITIVES_DEINTERLEAVE_H_
+#define SRC_PRIMITIVES_DEINTERLEAVE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "src/simd_aware.h"
+
+namespace sound_feature_extraction {
+
+/// @brief Splits the interleaved samples of several channels into planar
+/// buffers, so that out[c * stride + i] = in[i * channels + c].
+/// @param simd Value indicating whether to use SIMD acceleration. 2, 4 and
+/// 8 channels have dedicated SIMD kernels.
+/// @param in The interleaved samples, channels * length items.
+/// @param channels The number of channels.
+/// @param length The number of samples in each channel.
+/// @param stride The distance between the channels in out, in samples.
+/// @param out The planar samples.
+void Deinterleave(bool simd, const int16_t* in, int channels, size_t length,
+                  size_t stride, int16_t* out) noexcept;
+
+/// @brief Splits the interleaved 32-bit samples (int32_t or float) into
+/// planar buffers, see the int16_t overload.
+void Deinterleave(const int32_t* in, int channels, size_t length,
+                  size_t stride, int32_t* out) noexcept;
+
+/// @brief Returns the instruction set Deinterleave() uses for the channels.
+InstructionSet DeinterleaveInstructionSet(int channels) noexcept;
+
+}  // namespace sound_feature_extraction
+
+#endif  // SRC_PRIMITIVES_DEINTERLEAVE_H_
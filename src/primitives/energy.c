@@ -31,14 +31,49 @@
 #include "src/primitives/energy.h"
 #include <simd/instruction_set.h>
 #include <simd/memory.h>
+#include "src/simd_dispatch.h"
+#ifdef SIMD_X86
+#include <immintrin.h>
+#elif defined(SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
+#ifdef SIMD_X86
+SIMD_TARGET_AVX512
+static float calculate_energy_avx512(const float *signal, int length) {
+  __m512 accum = _mm512_setzero_ps();
+  int j = 0;
+  for (; j < length - 15; j += 16) {
+    __m512 vec = _mm512_loadu_ps(signal + j);
+    accum = _mm512_add_ps(accum, _mm512_mul_ps(vec, vec));
+  }
+  __m512 vec = _mm512_maskz_loadu_ps((1u << (length - j)) - 1, signal + j);
+  accum = _mm512_add_ps(accum, _mm512_mul_ps(vec, vec));
+  return _mm512_reduce_add_ps(accum);
+}
+#endif
 
 float calculate_energy(int simd, int norm, const float *signal, size_t length) {
   float energy = 0.f;
   int ilength = (int)length;
+#ifdef SIMD_X86
+  if (simd && simd_instruction_set_enabled(SIMD_INSTRUCTION_SET_AVX512)) {
+    energy = calculate_energy_avx512(signal, ilength);
+    return norm? energy / length : energy;
+  }
+#endif
+#ifdef __AVX__
+  simd = simd && simd_instruction_set_enabled(SIMD_INSTRUCTION_SET_AVX);
+#elif defined(SIMD_NEON)
+  simd = simd && simd_instruction_set_enabled(SIMD_INSTRUCTION_SET_NEON);
+#endif
   if (simd) {
 #ifdef __AVX__
     __m256 accum = _mm256_setzero_ps();
     int startIndex = align_complement_f32(signal);
+    if (startIndex > ilength) {
+      startIndex = ilength;
+    }
     for (int j = 0; j < startIndex; j++) {
       float val = signal[j];
       energy += val * val;
@@ -59,8 +94,8 @@ float calculate_energy(int simd, int norm, const float *signal, size_t length) {
       energy += val * val;
     }
   } else {
-#elif defined(__ARM_NEON__)
-    float32x4_t accum = { 0.f };
+#elif defined(SIMD_NEON)
+    float32x4_t accum = vdupq_n_f32(0.f);
     for (int j = 0; j < ilength - 3; j += 4) {
       float32x4_t vec = vld1q_f32(signal + j);
       accum = vmlaq_f32(accum, vec, vec);
@@ -82,3 +117,82 @@ float calculate_energy(int simd, int norm, const float *signal, size_t length) {
   }
   return norm? energy / length : energy;
 }
+
+static int64_t calculate_energy16_scalar(const int16_t *signal, int length) {
+  int64_t energy = 0;
+  for (int j = 0; j < length; j++) {
+    int32_t val = signal[j];
+    energy += val * val;
+  }
+  return energy;
+}
+
+/* pmaddwd sums two squares into 32 bits, which overflows the signed range
+ * only for two -32768-s, so the pair sums are widened as unsigned. */
+#ifdef SIMD_X86
+SIMD_TARGET_AVX512
+static int64_t calculate_energy16_avx512(const int16_t *signal, int length) {
+  __m512i accum = _mm512_setzero_si512();
+  int j = 0;
+  for (; j < length - 31; j += 32) {
+    __m512i vec = _mm512_loadu_si512(signal + j);
+    __m512i pairs = _mm512_madd_epi16(vec, vec);
+    accum = _mm512_add_epi64(accum, _mm512_cvtepu32_epi64(
+        _mm512_castsi512_si256(pairs)));
+    accum = _mm512_add_epi64(accum, _mm512_cvtepu32_epi64(
+        _mm512_extracti64x4_epi64(pairs, 1)));
+  }
+  return _mm512_reduce_add_epi64(accum) +
+      calculate_energy16_scalar(signal + j, length - j);
+}
+
+SIMD_TARGET("avx2")
+static int64_t calculate_energy16_avx2(const int16_t *signal, int length) {
+  __m256i accum = _mm256_setzero_si256();
+  int j = 0;
+  for (; j < length - 15; j += 16) {
+    __m256i vec = _mm256_loadu_si256((const __m256i *)(signal + j));
+    __m256i pairs = _mm256_madd_epi16(vec, vec);
+    accum = _mm256_add_epi64(accum, _mm256_cvtepu32_epi64(
+        _mm256_castsi256_si128(pairs)));
+    accum = _mm256_add_epi64(accum, _mm256_cvtepu32_epi64(
+        _mm256_extracti128_si256(pairs, 1)));
+  }
+  int64_t sums[4];
+  _mm256_storeu_si256((__m256i *)sums, accum);
+  return sums[0] + sums[1] + sums[2] + sums[3] +
+      calculate_energy16_scalar(signal + j, length - j);
+}
+#elif defined(SIMD_NEON)
+static int64_t calculate_energy16_neon(const int16_t *signal, int length) {
+  int64x2_t accum = vdupq_n_s64(0);
+  int j = 0;
+  for (; j < length - 7; j += 8) {
+    int16x8_t vec = vld1q_s16(signal + j);
+    int16x4_t low = vget_low_s16(vec), high = vget_high_s16(vec);
+    accum = vpadalq_s32(accum, vmull_s16(low, low));
+    accum = vpadalq_s32(accum, vmull_s16(high, high));
+  }
+  return vgetq_lane_s64(accum, 0) + vgetq_lane_s64(accum, 1) +
+      calculate_energy16_scalar(signal + j, length - j);
+}
+#endif
+
+int64_t calculate_energy16(int simd, const int16_t *signal, size_t length) {
+  int ilength = (int)length;
+  if (simd) {
+#ifdef SIMD_X86
+    if (simd_instruction_set_enabled(SIMD_INSTRUCTION_SET_AVX512)) {
+      return calculate_energy16_avx512(signal, ilength);
+    }
+    if (simd_instruction_set_enabled(SIMD_INSTRUCTION_SET_AVX2)) {
+      return calculate_energy16_avx2(signal, ilength);
+    }
+#elif defined(SIMD_NEON)
+    if (simd_instruction_set_enabled(SIMD_INSTRUCTION_SET_NEON)) {
+      return calculate_energy16_neon(signal, ilength);
+    }
+#endif
+  }
+  return calculate_energy16_scalar(signal, ilength);
+}
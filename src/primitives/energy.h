@@ -32,6 +32,7 @@
 #define SRC_PRIMITIVES_ENERGY_H_
 
 #include <stddef.h>
+#include <stdint.h>
 #include "src/config.h"
 
 #ifdef __cplusplus
@@ -46,6 +47,15 @@ extern "C" {
 float calculate_energy(int simd, int norm, const float *signal,
                        size_t length) NOTNULL(3);
 
+/// @brief Squares each value of the 16-bit signal and sums the results
+/// without converting them to floating point numbers.
+/// @param simd Value indicating whether to use SIMD acceleration.
+/// @param signal The source array of 16-bit integers.
+/// length The number of items in the array.
+/// @return The exact sum of squares.
+int64_t calculate_energy16(int simd, const int16_t *signal,
+                           size_t length) NOTNULL(2);
+
 #ifdef __cplusplus
 }
 #endif
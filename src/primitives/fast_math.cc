@@ -0,0 +1,411 @@
+/*! @file fast_math.cc
+ *  @brief Polynomial approximations of log2 and exp2.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+#include "src/primitives/fast_math.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#ifdef SIMD_X86
+#include <immintrin.h>
+#elif defined(SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace sound_feature_extraction {
+
+/// @brief The bits of sqrt(1/2). The mantissa is reduced to
+/// [sqrt(1/2), sqrt(2)), so that log2(1 + t) is approximated on the
+/// interval centered around 0.
+static constexpr int32_t kSqrtHalfBits = 0x3f3504f3;
+static constexpr int32_t kMantissaMask = 0x007fffff;
+/// @brief Values below FLT_MIN are multiplied by 2^kDenormalShift.
+static constexpr int kDenormalShift = 23;
+static constexpr float kExp2Min = -125.f;
+static constexpr float kExp2Max = 128.f;
+
+/// @brief log2(1 + t) = t * P(t), t in [sqrt(1/2) - 1, sqrt(2) - 1),
+/// fitted at the Chebyshev nodes.
+#define LOG2_P0 1.442696571e+00f
+#define LOG2_P1 -7.213602066e-01f
+#define LOG2_P2 4.806131124e-01f
+#define LOG2_P3 -3.595244586e-01f
+#define LOG2_P4 2.961195707e-01f
+#define LOG2_P5 -2.679638565e-01f
+#define LOG2_P6 1.681865901e-01f
+
+/// @brief 2^f = Q(f), f in [-0.5, 0.5], fitted at the Chebyshev nodes.
+#define EXP2_Q0 1.000000119e+00f
+#define EXP2_Q1 6.931471825e-01f
+#define EXP2_Q2 2.402210683e-01f
+#define EXP2_Q3 5.550356954e-02f
+#define EXP2_Q4 9.676031768e-03f
+#define EXP2_Q5 1.339086331e-03f
+
+static float Log2Scalar(float x) noexcept {
+  if (!(x > 0 && x < std::numeric_limits<float>::infinity())) {
+    if (x == 0) {
+      return -std::numeric_limits<float>::infinity();
+    }
+    return x > 0? x : std::numeric_limits<float>::quiet_NaN();
+  }
+  int shift = 0;
+  if (x < std::numeric_limits<float>::min()) {
+    x *= 1 << kDenormalShift;
+    shift = kDenormalShift;
+  }
+  int32_t bits;
+  memcpy(&bits, &x, sizeof(bits));
+  bits -= kSqrtHalfBits;
+  int32_t exponent = (bits >> 23) - shift;
+  bits = (bits & kMantissaMask) + kSqrtHalfBits;
+  float m;
+  memcpy(&m, &bits, sizeof(m));
+  float t = m - 1;
+  float p = LOG2_P6;
+  p = p * t + LOG2_P5;
+  p = p * t + LOG2_P4;
+  p = p * t + LOG2_P3;
+  p = p * t + LOG2_P2;
+  p = p * t + LOG2_P1;
+  p = p * t + LOG2_P0;
+  return exponent + t * p;
+}
+
+static float Exp2Scalar(float x) noexcept {
+  if (x < kExp2Min) {
+    return 0;
+  }
+  if (x >= kExp2Max) {
+    return std::numeric_limits<float>::infinity();
+  }
+  float n = floorf(x + 0.5f);
+  float f = x - n;
+  float q = EXP2_Q5;
+  q = q * f + EXP2_Q4;
+  q = q * f + EXP2_Q3;
+  q = q * f + EXP2_Q2;
+  q = q * f + EXP2_Q1;
+  q = q * f + EXP2_Q0;
+  int32_t bits;
+  memcpy(&bits, &q, sizeof(bits));
+  bits += static_cast<int32_t>(n) << 23;
+  memcpy(&q, &bits, sizeof(q));
+  return q;
+}
+
+static void FastLog2Scalar(const float* input, size_t length,
+                           float* output) {
+  for (size_t i = 0; i < length; i++) {
+    output[i] = Log2Scalar(input[i]);
+  }
+}
+
+static void FastSumsScalar(const float* input, size_t length, float* sum,
+                           float* log2sum) {
+  float vsum = 0, vlog2sum = 0;
+  for (size_t i = 0; i < length; i++) {
+    vsum += input[i];
+    vlog2sum += Log2Scalar(input[i]);
+  }
+  *sum = vsum;
+  *log2sum = vlog2sum;
+}
+
+static void FastExp2Scalar(const float* input, size_t length,
+                           float* output) {
+  for (size_t i = 0; i < length; i++) {
+    output[i] = Exp2Scalar(input[i]);
+  }
+}
+
+#ifdef SIMD_X86
+SIMD_TARGET("avx2")
+static inline __m256 Log2AVX2(__m256 x) {
+  const __m256 zero = _mm256_setzero_ps();
+  const __m256 inf = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+  // NaN, the non-positive values and inf are patched in the end
+  __m256 regular = _mm256_and_ps(_mm256_cmp_ps(x, zero, _CMP_GT_OQ),
+                                 _mm256_cmp_ps(x, inf, _CMP_LT_OQ));
+  __m256 denormal = _mm256_cmp_ps(
+      x, _mm256_set1_ps(std::numeric_limits<float>::min()), _CMP_LT_OQ);
+  x = _mm256_blendv_ps(
+      x, _mm256_mul_ps(x, _mm256_set1_ps(1 << kDenormalShift)), denormal);
+  __m256i bits = _mm256_sub_epi32(_mm256_castps_si256(x),
+                                  _mm256_set1_epi32(kSqrtHalfBits));
+  __m256 exponent = _mm256_sub_ps(
+      _mm256_cvtepi32_ps(_mm256_srai_epi32(bits, 23)),
+      _mm256_and_ps(denormal, _mm256_set1_ps(kDenormalShift)));
+  __m256 m = _mm256_castsi256_ps(_mm256_add_epi32(
+      _mm256_and_si256(bits, _mm256_set1_epi32(kMantissaMask)),
+      _mm256_set1_epi32(kSqrtHalfBits)));
+  __m256 t = _mm256_sub_ps(m, _mm256_set1_ps(1.f));
+  __m256 p = _mm256_set1_ps(LOG2_P6);
+  p = _mm256_add_ps(_mm256_mul_ps(p, t), _mm256_set1_ps(LOG2_P5));
+  p = _mm256_add_ps(_mm256_mul_ps(p, t), _mm256_set1_ps(LOG2_P4));
+  p = _mm256_add_ps(_mm256_mul_ps(p, t), _mm256_set1_ps(LOG2_P3));
+  p = _mm256_add_ps(_mm256_mul_ps(p, t), _mm256_set1_ps(LOG2_P2));
+  p = _mm256_add_ps(_mm256_mul_ps(p, t), _mm256_set1_ps(LOG2_P1));
+  p = _mm256_add_ps(_mm256_mul_ps(p, t), _mm256_set1_ps(LOG2_P0));
+  __m256 res = _mm256_add_ps(exponent, _mm256_mul_ps(t, p));
+  if (_mm256_movemask_ps(regular) == 0xff) {
+    return res;
+  }
+  // 0 -> -inf, inf -> inf, the rest -> NaN
+  __m256 fix = _mm256_blendv_ps(
+      _mm256_set1_ps(std::numeric_limits<float>::quiet_NaN()),
+      _mm256_sub_ps(zero, inf), _mm256_cmp_ps(x, zero, _CMP_EQ_OQ));
+  fix = _mm256_blendv_ps(fix, inf, _mm256_cmp_ps(x, inf, _CMP_EQ_OQ));
+  return _mm256_blendv_ps(fix, res, regular);
+}
+
+SIMD_TARGET("avx2")
+static inline __m256 Exp2AVX2(__m256 x) {
+  __m256 underflow = _mm256_cmp_ps(x, _mm256_set1_ps(kExp2Min), _CMP_LT_OQ);
+  __m256 overflow = _mm256_cmp_ps(x, _mm256_set1_ps(kExp2Max), _CMP_GE_OQ);
+  x = _mm256_min_ps(x, _mm256_set1_ps(kExp2Max));
+  __m256 n = _mm256_round_ps(x, _MM_FROUND_TO_NEAREST_INT |
+                                _MM_FROUND_NO_EXC);
+  __m256 f = _mm256_sub_ps(x, n);
+  __m256 q = _mm256_set1_ps(EXP2_Q5);
+  q = _mm256_add_ps(_mm256_mul_ps(q, f), _mm256_set1_ps(EXP2_Q4));
+  q = _mm256_add_ps(_mm256_mul_ps(q, f), _mm256_set1_ps(EXP2_Q3));
+  q = _mm256_add_ps(_mm256_mul_ps(q, f), _mm256_set1_ps(EXP2_Q2));
+  q = _mm256_add_ps(_mm256_mul_ps(q, f), _mm256_set1_ps(EXP2_Q1));
+  q = _mm256_add_ps(_mm256_mul_ps(q, f), _mm256_set1_ps(EXP2_Q0));
+  q = _mm256_castsi256_ps(_mm256_add_epi32(
+      _mm256_castps_si256(q),
+      _mm256_slli_epi32(_mm256_cvtps_epi32(n), 23)));
+  q = _mm256_blendv_ps(
+      q, _mm256_set1_ps(std::numeric_limits<float>::infinity()), overflow);
+  return _mm256_andnot_ps(underflow, q);
+}
+
+SIMD_TARGET("avx2")
+static void FastLog2AVX2(const float* input, size_t length, float* output) {
+  size_t i = 0;
+  for (; i + 8 <= length; i += 8) {
+    _mm256_storeu_ps(output + i, Log2AVX2(_mm256_loadu_ps(input + i)));
+  }
+  FastLog2Scalar(input + i, length - i, output + i);
+}
+
+SIMD_TARGET("avx2")
+static inline float HorizontalSumAVX2(__m256 vec) {
+  __m128 half = _mm_add_ps(_mm256_castps256_ps128(vec),
+                           _mm256_extractf128_ps(vec, 1));
+  half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+  half = _mm_add_ss(half, _mm_movehdup_ps(half));
+  return _mm_cvtss_f32(half);
+}
+
+SIMD_TARGET("avx2")
+static void FastSumsAVX2(const float* input, size_t length, float* sum,
+                         float* log2sum) {
+  __m256 vsum = _mm256_setzero_ps();
+  __m256 vlog2sum = _mm256_setzero_ps();
+  size_t i = 0;
+  for (; i + 8 <= length; i += 8) {
+    __m256 vec = _mm256_loadu_ps(input + i);
+    vsum = _mm256_add_ps(vsum, vec);
+    vlog2sum = _mm256_add_ps(vlog2sum, Log2AVX2(vec));
+  }
+  FastSumsScalar(input + i, length - i, sum, log2sum);
+  *sum += HorizontalSumAVX2(vsum);
+  *log2sum += HorizontalSumAVX2(vlog2sum);
+}
+
+SIMD_TARGET("avx2")
+static void FastExp2AVX2(const float* input, size_t length, float* output) {
+  size_t i = 0;
+  for (; i + 8 <= length; i += 8) {
+    _mm256_storeu_ps(output + i, Exp2AVX2(_mm256_loadu_ps(input + i)));
+  }
+  FastExp2Scalar(input + i, length - i, output + i);
+}
+#elif defined(SIMD_NEON)
+static inline float32x4_t Log2NEON(float32x4_t x) {
+  const float32x4_t zero = vdupq_n_f32(0);
+  const float32x4_t inf = vdupq_n_f32(std::numeric_limits<float>::infinity());
+  uint32x4_t regular = vandq_u32(vcgtq_f32(x, zero), vcltq_f32(x, inf));
+  uint32x4_t denormal = vcltq_f32(
+      x, vdupq_n_f32(std::numeric_limits<float>::min()));
+  x = vbslq_f32(denormal, vmulq_n_f32(x, 1 << kDenormalShift), x);
+  int32x4_t bits = vsubq_s32(vreinterpretq_s32_f32(x),
+                             vdupq_n_s32(kSqrtHalfBits));
+  float32x4_t exponent = vsubq_f32(
+      vcvtq_f32_s32(vshrq_n_s32(bits, 23)),
+      vreinterpretq_f32_u32(vandq_u32(
+          denormal, vreinterpretq_u32_f32(vdupq_n_f32(kDenormalShift)))));
+  float32x4_t m = vreinterpretq_f32_s32(vaddq_s32(
+      vandq_s32(bits, vdupq_n_s32(kMantissaMask)),
+      vdupq_n_s32(kSqrtHalfBits)));
+  float32x4_t t = vsubq_f32(m, vdupq_n_f32(1.f));
+  float32x4_t p = vdupq_n_f32(LOG2_P6);
+  p = vmlaq_f32(vdupq_n_f32(LOG2_P5), p, t);
+  p = vmlaq_f32(vdupq_n_f32(LOG2_P4), p, t);
+  p = vmlaq_f32(vdupq_n_f32(LOG2_P3), p, t);
+  p = vmlaq_f32(vdupq_n_f32(LOG2_P2), p, t);
+  p = vmlaq_f32(vdupq_n_f32(LOG2_P1), p, t);
+  p = vmlaq_f32(vdupq_n_f32(LOG2_P0), p, t);
+  float32x4_t res = vmlaq_f32(exponent, t, p);
+  // 0 -> -inf, inf -> inf, the rest -> NaN
+  float32x4_t fix = vbslq_f32(
+      vceqq_f32(x, zero), vnegq_f32(inf),
+      vdupq_n_f32(std::numeric_limits<float>::quiet_NaN()));
+  fix = vbslq_f32(vceqq_f32(x, inf), inf, fix);
+  return vbslq_f32(regular, res, fix);
+}
+
+static inline float32x4_t Exp2NEON(float32x4_t x) {
+  uint32x4_t underflow = vcltq_f32(x, vdupq_n_f32(kExp2Min));
+  uint32x4_t overflow = vcgeq_f32(x, vdupq_n_f32(kExp2Max));
+  x = vminq_f32(x, vdupq_n_f32(kExp2Max));
+  // floor(x + 0.5), the conversion truncates towards zero
+  float32x4_t y = vaddq_f32(x, vdupq_n_f32(0.5f));
+  int32x4_t n = vcvtq_s32_f32(y);
+  n = vaddq_s32(n, vreinterpretq_s32_u32(vcgtq_f32(vcvtq_f32_s32(n), y)));
+  float32x4_t f = vsubq_f32(x, vcvtq_f32_s32(n));
+  float32x4_t q = vdupq_n_f32(EXP2_Q5);
+  q = vmlaq_f32(vdupq_n_f32(EXP2_Q4), q, f);
+  q = vmlaq_f32(vdupq_n_f32(EXP2_Q3), q, f);
+  q = vmlaq_f32(vdupq_n_f32(EXP2_Q2), q, f);
+  q = vmlaq_f32(vdupq_n_f32(EXP2_Q1), q, f);
+  q = vmlaq_f32(vdupq_n_f32(EXP2_Q0), q, f);
+  q = vreinterpretq_f32_s32(vaddq_s32(vreinterpretq_s32_f32(q),
+                                      vshlq_n_s32(n, 23)));
+  q = vbslq_f32(overflow,
+                vdupq_n_f32(std::numeric_limits<float>::infinity()), q);
+  return vreinterpretq_f32_u32(vbicq_u32(vreinterpretq_u32_f32(q),
+                                         underflow));
+}
+
+static void FastLog2NEON(const float* input, size_t length, float* output) {
+  size_t i = 0;
+  for (; i + 4 <= length; i += 4) {
+    vst1q_f32(output + i, Log2NEON(vld1q_f32(input + i)));
+  }
+  FastLog2Scalar(input + i, length - i, output + i);
+}
+
+static inline float HorizontalSumNEON(float32x4_t vec) {
+  float32x2_t half = vadd_f32(vget_low_f32(vec), vget_high_f32(vec));
+  return vget_lane_f32(vpadd_f32(half, half), 0);
+}
+
+static void FastSumsNEON(const float* input, size_t length, float* sum,
+                         float* log2sum) {
+  float32x4_t vsum = vdupq_n_f32(0);
+  float32x4_t vlog2sum = vdupq_n_f32(0);
+  size_t i = 0;
+  for (; i + 4 <= length; i += 4) {
+    float32x4_t vec = vld1q_f32(input + i);
+    vsum = vaddq_f32(vsum, vec);
+    vlog2sum = vaddq_f32(vlog2sum, Log2NEON(vec));
+  }
+  FastSumsScalar(input + i, length - i, sum, log2sum);
+  *sum += HorizontalSumNEON(vsum);
+  *log2sum += HorizontalSumNEON(vlog2sum);
+}
+
+static void FastExp2NEON(const float* input, size_t length, float* output) {
+  size_t i = 0;
+  for (; i + 4 <= length; i += 4) {
+    vst1q_f32(output + i, Exp2NEON(vld1q_f32(input + i)));
+  }
+  FastExp2Scalar(input + i, length - i, output + i);
+}
+#endif
+
+typedef void (*FastMathKernel)(const float* input, size_t length,
+                               float* output);
+typedef void (*FastSumsKernel)(const float* input, size_t length,
+                               float* sum, float* log2sum);
+
+static const SimdKernel<FastMathKernel> kFastLog2Kernels[] {
+#ifdef SIMD_X86
+  { InstructionSet::kAVX2, FastLog2AVX2 },
+#elif defined(SIMD_NEON)
+  { InstructionSet::kNEON, FastLog2NEON },
+#endif
+  { InstructionSet::kScalar, FastLog2Scalar }
+};
+
+static const SimdKernel<FastSumsKernel> kFastSumsKernels[] {
+#ifdef SIMD_X86
+  { InstructionSet::kAVX2, FastSumsAVX2 },
+#elif defined(SIMD_NEON)
+  { InstructionSet::kNEON, FastSumsNEON },
+#endif
+  { InstructionSet::kScalar, FastSumsScalar }
+};
+
+static const SimdKernel<FastMathKernel> kFastExp2Kernels[] {
+#ifdef SIMD_X86
+  { InstructionSet::kAVX2, FastExp2AVX2 },
+#elif defined(SIMD_NEON)
+  { InstructionSet::kNEON, FastExp2NEON },
+#endif
+  { InstructionSet::kScalar, FastExp2Scalar }
+};
+
+void FastLog2(bool simd, const float* input, size_t length,
+              float* output) noexcept {
+  auto kernel = simd? SimdAware::Dispatch(kFastLog2Kernels).Function
+                    : FastLog2Scalar;
+  kernel(input, length, output);
+}
+
+float FastLog2Sum(bool simd, const float* input, size_t length) noexcept {
+  float sum, log2sum;
+  FastSums(simd, input, length, &sum, &log2sum);
+  return log2sum;
+}
+
+void FastSums(bool simd, const float* input, size_t length, float* sum,
+              float* log2sum) noexcept {
+  auto kernel = simd? SimdAware::Dispatch(kFastSumsKernels).Function
+                    : FastSumsScalar;
+  kernel(input, length, sum, log2sum);
+}
+
+void FastExp2(bool simd, const float* input, size_t length,
+              float* output) noexcept {
+  auto kernel = simd? SimdAware::Dispatch(kFastExp2Kernels).Function
+                    : FastExp2Scalar;
+  kernel(input, length, output);
+}
+
+InstructionSet FastMathInstructionSet() noexcept {
+  return SimdAware::Dispatch(kFastLog2Kernels).Isa;
+}
+
+}  // namespace sound_feature_extraction
@@ -0,0 +1,85 @@
+/*! @file fast_math.h
+ *  @brief Polynomial approximations of log2 and exp2.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+#ifndef SRC_PRIMITIVES_FAST_MATH_H_
+#define SRC_PRIMITIVES_FAST_MATH_H_
+
+#include <stddef.h>
+#include "src/simd_aware.h"
+
+namespace sound_feature_extraction {
+
+/// @brief The maximal error of FastLog2() for the positive finite values,
+/// including the denormalized ones, relative to max(1, |log2(x)|).
+constexpr float kFastLog2MaxError = 1e-6f;
+
+/// @brief The maximal relative error of FastExp2() for the arguments which
+/// are not less than -125.
+constexpr float kFastExp2MaxError = 5e-7f;
+
+/// @brief Calculates output[i] = log2(input[i]) with the polynomial of
+/// degree 7 on the mantissa. log2(0) = -inf, log2(inf) = inf, the negative
+/// values and NaN give NaN.
+/// @param simd Value indicating whether to use SIMD acceleration.
+/// @param input The source array.
+/// @param length The number of elements in input.
+/// @param output The destination array, may be the same as input.
+void FastLog2(bool simd, const float* input, size_t length,
+              float* output) noexcept;
+
+/// @brief Calculates the sum of log2(input[i]) with FastLog2() without
+/// storing the logarithms.
+float FastLog2Sum(bool simd, const float* input, size_t length) noexcept;
+
+/// @brief Calculates the sum of input[i] and the sum of log2(input[i])
+/// in a single pass. The zeros and the denormalized values are handled
+/// by the masks without branching.
+/// @param sum The sum of the elements.
+/// @param log2sum The same as FastLog2Sum() returns.
+void FastSums(bool simd, const float* input, size_t length, float* sum,
+              float* log2sum) noexcept;
+
+/// @brief Calculates output[i] = 2^input[i] with the polynomial of degree 5
+/// on the fractional part. The arguments which are less than -125 give 0,
+/// the arguments which are not less than 128 give inf.
+/// @param simd Value indicating whether to use SIMD acceleration.
+/// @param input The source array, must not contain NaN.
+/// @param length The number of elements in input.
+/// @param output The destination array, may be the same as input.
+void FastExp2(bool simd, const float* input, size_t length,
+              float* output) noexcept;
+
+/// @brief Returns the instruction set FastLog2(), FastLog2Sum(), FastSums()
+/// and FastExp2() use.
+InstructionSet FastMathInstructionSet() noexcept;
+
+}  // namespace sound_feature_extraction
+
+#endif  // SRC_PRIMITIVES_FAST_MATH_H_
@@ -15,7 +15,15 @@
 #include "src/primitives/lpc.h"
 #include <assert.h>
 #include <math.h>
+#include <stdlib.h>
 #include <simd/instruction_set.h>
+#include <simd/memory.h>
+#include "src/simd_dispatch.h"
+#ifdef SIMD_X86
+#include <immintrin.h>
+#elif defined(SIMD_NEON)
+#include <arm_neon.h>
+#endif
 
 float ldr_lpc(int simd, const float *ac, int length, float *lpc) {
 #if !defined(__AVX__) && !defined(__ARM_NEON__)
@@ -157,4 +165,380 @@ float ldr_lpc(int simd, const float *ac, int length, float *lpc) {
   return error;
 }
 
+/* The batched kernels work on the structure-of-arrays layout: element k of
+ * the frame in lane l is at [k * lanes + l]. Each lane performs exactly the
+ * same operations as the scalar branch of ldr_lpc(). */
+
+#ifdef SIMD_X86
+SIMD_TARGET_AVX512
+static void ldr_lpc_lanes_avx512(const float *ac, int length, float *lpc,
+                                 float *errors) {
+  const __m512 sign = _mm512_set1_ps(-0.f);
+  __m512 error = _mm512_loadu_ps(ac);
+  for (int i = 0; i < length - 1; i++) {
+    __m512 rr = _mm512_castsi512_ps(_mm512_xor_si512(
+        _mm512_castps_si512(_mm512_loadu_ps(ac + (i + 1) * 16)),
+        _mm512_castps_si512(sign)));
+    for (int j = 0; j < i; j++) {
+      rr = _mm512_sub_ps(rr, _mm512_mul_ps(_mm512_loadu_ps(lpc + j * 16),
+                                           _mm512_loadu_ps(ac + (i - j) * 16)));
+    }
+    __m512 lambda = _mm512_div_ps(rr, error);
+    for (int j = 0; j < i / 2; j++) {
+      int j_supp = i - 1 - j;
+      __m512 tmp = _mm512_loadu_ps(lpc + j * 16);
+      __m512 supp = _mm512_loadu_ps(lpc + j_supp * 16);
+      _mm512_storeu_ps(lpc + j * 16,
+                       _mm512_add_ps(tmp, _mm512_mul_ps(lambda, supp)));
+      _mm512_storeu_ps(lpc + j_supp * 16,
+                       _mm512_add_ps(supp, _mm512_mul_ps(lambda, tmp)));
+    }
+    if (i & 1) {
+      __m512 mid = _mm512_loadu_ps(lpc + (i / 2) * 16);
+      _mm512_storeu_ps(lpc + (i / 2) * 16,
+                       _mm512_add_ps(mid, _mm512_mul_ps(lambda, mid)));
+    }
+    _mm512_storeu_ps(lpc + i * 16, lambda);
+    error = _mm512_sub_ps(error, _mm512_mul_ps(
+        _mm512_mul_ps(lambda, lambda), error));
+  }
+  _mm512_storeu_ps(errors, error);
+}
+
+SIMD_TARGET("avx")
+static void ldr_lpc_lanes_avx(const float *ac, int length, float *lpc,
+                              float *errors) {
+  const __m256 sign = _mm256_set1_ps(-0.f);
+  __m256 error = _mm256_loadu_ps(ac);
+  for (int i = 0; i < length - 1; i++) {
+    __m256 rr = _mm256_xor_ps(_mm256_loadu_ps(ac + (i + 1) * 8), sign);
+    for (int j = 0; j < i; j++) {
+      rr = _mm256_sub_ps(rr, _mm256_mul_ps(_mm256_loadu_ps(lpc + j * 8),
+                                           _mm256_loadu_ps(ac + (i - j) * 8)));
+    }
+    __m256 lambda = _mm256_div_ps(rr, error);
+    for (int j = 0; j < i / 2; j++) {
+      int j_supp = i - 1 - j;
+      __m256 tmp = _mm256_loadu_ps(lpc + j * 8);
+      __m256 supp = _mm256_loadu_ps(lpc + j_supp * 8);
+      _mm256_storeu_ps(lpc + j * 8,
+                       _mm256_add_ps(tmp, _mm256_mul_ps(lambda, supp)));
+      _mm256_storeu_ps(lpc + j_supp * 8,
+                       _mm256_add_ps(supp, _mm256_mul_ps(lambda, tmp)));
+    }
+    if (i & 1) {
+      __m256 mid = _mm256_loadu_ps(lpc + (i / 2) * 8);
+      _mm256_storeu_ps(lpc + (i / 2) * 8,
+                       _mm256_add_ps(mid, _mm256_mul_ps(lambda, mid)));
+    }
+    _mm256_storeu_ps(lpc + i * 8, lambda);
+    error = _mm256_sub_ps(error, _mm256_mul_ps(
+        _mm256_mul_ps(lambda, lambda), error));
+  }
+  _mm256_storeu_ps(errors, error);
+}
+#elif defined(SIMD_NEON)
+static void ldr_lpc_lanes_neon(const float *ac, int length, float *lpc,
+                               float *errors) {
+  float32x4_t error = vld1q_f32(ac);
+  for (int i = 0; i < length - 1; i++) {
+    float32x4_t rr = vnegq_f32(vld1q_f32(ac + (i + 1) * 4));
+    for (int j = 0; j < i; j++) {
+      rr = vsubq_f32(rr, vmulq_f32(vld1q_f32(lpc + j * 4),
+                                   vld1q_f32(ac + (i - j) * 4)));
+    }
+#ifdef __aarch64__
+    float32x4_t lambda = vdivq_f32(rr, error);
+#else
+    /* ARMv7 NEON has no division, refine the reciprocal estimate */
+    float32x4_t inv = vrecpeq_f32(error);
+    inv = vmulq_f32(vrecpsq_f32(error, inv), inv);
+    inv = vmulq_f32(vrecpsq_f32(error, inv), inv);
+    float32x4_t lambda = vmulq_f32(rr, inv);
+#endif
+    for (int j = 0; j < i / 2; j++) {
+      int j_supp = i - 1 - j;
+      float32x4_t tmp = vld1q_f32(lpc + j * 4);
+      float32x4_t supp = vld1q_f32(lpc + j_supp * 4);
+      vst1q_f32(lpc + j * 4, vaddq_f32(tmp, vmulq_f32(lambda, supp)));
+      vst1q_f32(lpc + j_supp * 4, vaddq_f32(supp, vmulq_f32(lambda, tmp)));
+    }
+    if (i & 1) {
+      float32x4_t mid = vld1q_f32(lpc + (i / 2) * 4);
+      vst1q_f32(lpc + (i / 2) * 4, vaddq_f32(mid, vmulq_f32(lambda, mid)));
+    }
+    vst1q_f32(lpc + i * 4, lambda);
+    error = vsubq_f32(error, vmulq_f32(vmulq_f32(lambda, lambda), error));
+  }
+  vst1q_f32(errors, error);
+}
+#endif
+
+typedef void (*ldr_lpc_lanes_kernel)(const float *ac, int length, float *lpc,
+                                     float *errors);
+
+static int ldr_lpc_lanes(int simd, ldr_lpc_lanes_kernel *kernel) {
+  if (!simd) {
+    return 1;
+  }
+#ifdef SIMD_X86
+  if (simd_instruction_set_enabled(SIMD_INSTRUCTION_SET_AVX512)) {
+    *kernel = ldr_lpc_lanes_avx512;
+    return 16;
+  }
+  if (simd_instruction_set_enabled(SIMD_INSTRUCTION_SET_AVX)) {
+    *kernel = ldr_lpc_lanes_avx;
+    return 8;
+  }
+#elif defined(SIMD_NEON)
+  if (simd_instruction_set_enabled(SIMD_INSTRUCTION_SET_NEON)) {
+    *kernel = ldr_lpc_lanes_neon;
+    return 4;
+  }
+#else
+  (void)kernel;
+#endif
+  return 1;
+}
+
+void ldr_lpc_batch(int simd, const float *const *ac, int count, int length,
+                   float *const *lpc, float *errors) {
+  ldr_lpc_lanes_kernel kernel = NULL;
+  /* A single frame is faster with the SIMD inside ldr_lpc() */
+  int lanes = count > 1? ldr_lpc_lanes(simd, &kernel) : 1;
+  float *acs = lanes > 1? mallocf(length * lanes * 2) : NULL;
+  if (acs == NULL) {
+    for (int f = 0; f < count; f++) {
+      float error = ldr_lpc(simd, ac[f], length, lpc[f]);
+      if (errors != NULL) {
+        errors[f] = error;
+      }
+    }
+    return;
+  }
+  float *lpcs = acs + length * lanes;
+  float lane_errors[16];
+  for (int f = 0; f < count; f += lanes) {
+    int size = count - f < lanes? count - f : lanes;
+    for (int k = 0; k < length; k++) {
+      for (int l = 0; l < size; l++) {
+        acs[k * lanes + l] = ac[f + l][k];
+      }
+      /* Idle lanes solve the trivial system */
+      for (int l = size; l < lanes; l++) {
+        acs[k * lanes + l] = k == 0;
+      }
+    }
+    kernel(acs, length, lpcs, lane_errors);
+    for (int l = 0; l < size; l++) {
+      /* See the special case in ldr_lpc() */
+      int silent = ac[f + l][0] == 0;
+      for (int k = 0; k < length - 1; k++) {
+        lpc[f + l][k] = silent? 0 : lpcs[k * lanes + l];
+      }
+      if (errors != NULL) {
+        errors[f + l] = silent? 0 : lane_errors[l];
+      }
+    }
+  }
+  free(acs);
+}
+
+void lpc_to_cc(const float *lpc, int length, float *cc, int size) {
+  cc[0] = logf(lpc[0]);
+  for (int m = 1; m < size; m++) {
+    float cm = 0;
+    for (int k = 1; k < (m < length? m : length); k++) {
+      cm -= (m - k) * lpc[k] * cc[m - k];
+    }
+    cm /= m;
+    if (m < length) {
+      cm -= lpc[m];
+    }
+    cc[m] = cm;
+  }
+}
 
+/* The cepstral kernels expect the logarithms in the first row of cc and
+ * perform exactly the same operations as lpc_to_cc() in each lane. */
+
+#ifdef SIMD_X86
+SIMD_TARGET_AVX512
+static void lpc_to_cc_lanes_avx512(const float *lpc, int length, float *cc,
+                                   int size) {
+  for (int m = 1; m < size; m++) {
+    __m512 cm = _mm512_setzero_ps();
+    for (int k = 1; k < (m < length? m : length); k++) {
+      cm = _mm512_sub_ps(cm, _mm512_mul_ps(
+          _mm512_mul_ps(_mm512_set1_ps(m - k), _mm512_loadu_ps(lpc + k * 16)),
+          _mm512_loadu_ps(cc + (m - k) * 16)));
+    }
+    cm = _mm512_div_ps(cm, _mm512_set1_ps(m));
+    if (m < length) {
+      cm = _mm512_sub_ps(cm, _mm512_loadu_ps(lpc + m * 16));
+    }
+    _mm512_storeu_ps(cc + m * 16, cm);
+  }
+}
+
+SIMD_TARGET("avx")
+static void lpc_to_cc_lanes_avx(const float *lpc, int length, float *cc,
+                                int size) {
+  for (int m = 1; m < size; m++) {
+    __m256 cm = _mm256_setzero_ps();
+    for (int k = 1; k < (m < length? m : length); k++) {
+      cm = _mm256_sub_ps(cm, _mm256_mul_ps(
+          _mm256_mul_ps(_mm256_set1_ps(m - k), _mm256_loadu_ps(lpc + k * 8)),
+          _mm256_loadu_ps(cc + (m - k) * 8)));
+    }
+    cm = _mm256_div_ps(cm, _mm256_set1_ps(m));
+    if (m < length) {
+      cm = _mm256_sub_ps(cm, _mm256_loadu_ps(lpc + m * 8));
+    }
+    _mm256_storeu_ps(cc + m * 8, cm);
+  }
+}
+#elif defined(SIMD_NEON)
+static void lpc_to_cc_lanes_neon(const float *lpc, int length, float *cc,
+                                 int size) {
+  for (int m = 1; m < size; m++) {
+    float32x4_t cm = vdupq_n_f32(0.f);
+    for (int k = 1; k < (m < length? m : length); k++) {
+      cm = vsubq_f32(cm, vmulq_f32(
+          vmulq_f32(vdupq_n_f32(m - k), vld1q_f32(lpc + k * 4)),
+          vld1q_f32(cc + (m - k) * 4)));
+    }
+#ifdef __aarch64__
+    cm = vdivq_f32(cm, vdupq_n_f32(m));
+#else
+    /* ARMv7 NEON has no division, multiply by the reciprocal */
+    cm = vmulq_n_f32(cm, 1.f / m);
+#endif
+    if (m < length) {
+      cm = vsubq_f32(cm, vld1q_f32(lpc + m * 4));
+    }
+    vst1q_f32(cc + m * 4, cm);
+  }
+}
+#endif
+
+typedef void (*lpc_to_cc_lanes_kernel)(const float *lpc, int length,
+                                       float *cc, int size);
+
+static int lpc_to_cc_lanes(int simd, lpc_to_cc_lanes_kernel *kernel) {
+  if (!simd) {
+    return 1;
+  }
+#ifdef SIMD_X86
+  if (simd_instruction_set_enabled(SIMD_INSTRUCTION_SET_AVX512)) {
+    *kernel = lpc_to_cc_lanes_avx512;
+    return 16;
+  }
+  if (simd_instruction_set_enabled(SIMD_INSTRUCTION_SET_AVX)) {
+    *kernel = lpc_to_cc_lanes_avx;
+    return 8;
+  }
+#elif defined(SIMD_NEON)
+  if (simd_instruction_set_enabled(SIMD_INSTRUCTION_SET_NEON)) {
+    *kernel = lpc_to_cc_lanes_neon;
+    return 4;
+  }
+#else
+  (void)kernel;
+#endif
+  return 1;
+}
+
+void lpc_to_cc_batch(int simd, const float *const *lpc, int count, int length,
+                     float *const *cc, int size) {
+  lpc_to_cc_lanes_kernel kernel = NULL;
+  int lanes = count > 1? lpc_to_cc_lanes(simd, &kernel) : 1;
+  float *lpcs = lanes > 1? mallocf((length + size) * lanes) : NULL;
+  if (lpcs == NULL) {
+    for (int f = 0; f < count; f++) {
+      lpc_to_cc(lpc[f], length, cc[f], size);
+    }
+    return;
+  }
+  float *ccs = lpcs + length * lanes;
+  for (int f = 0; f < count; f += lanes) {
+    int frames = count - f < lanes? count - f : lanes;
+    for (int k = 0; k < length; k++) {
+      for (int l = 0; l < frames; l++) {
+        lpcs[k * lanes + l] = lpc[f + l][k];
+      }
+      /* Idle lanes convert the unit predictor */
+      for (int l = frames; l < lanes; l++) {
+        lpcs[k * lanes + l] = k == 0;
+      }
+    }
+    for (int l = 0; l < lanes; l++) {
+      ccs[l] = logf(lpcs[l]);
+    }
+    kernel(lpcs, length, ccs, size);
+    for (int l = 0; l < frames; l++) {
+      for (int m = 0; m < size; m++) {
+        cc[f + l][m] = ccs[m * lanes + l];
+      }
+    }
+  }
+  free(lpcs);
+}
+
+void ldr_lpc_cc_batch(int simd, const float *const *ac, int count, int length,
+                      int error, float *const *cc, int size) {
+  ldr_lpc_lanes_kernel lpc_kernel = NULL;
+  lpc_to_cc_lanes_kernel cc_kernel = NULL;
+  int lanes = count > 1? ldr_lpc_lanes(simd, &lpc_kernel) : 1;
+  if (lanes > 1 && lpc_to_cc_lanes(simd, &cc_kernel) != lanes) {
+    lanes = 1;
+  }
+  /* The prepended error makes the predictor one element longer */
+  int cc_length = error? length : length - 1;
+  /* Rows: ac [0...length), error, lpc [0...length - 1), cc [0...size) */
+  float *acs = lanes > 1? mallocf((length * 2 + size) * lanes) : NULL;
+  if (acs == NULL) {
+    float lpc[length];
+    for (int f = 0; f < count; f++) {
+      float err = ldr_lpc(simd, ac[f], length, lpc + 1);
+      lpc[0] = err;
+      lpc_to_cc(error? lpc : lpc + 1, cc_length, cc[f], size);
+    }
+    return;
+  }
+  float *errors = acs + length * lanes;
+  float *lpcs = errors + lanes;
+  float *ccs = lpcs + (length - 1) * lanes;
+  const float *in = error? errors : lpcs;
+  for (int f = 0; f < count; f += lanes) {
+    int frames = count - f < lanes? count - f : lanes;
+    for (int k = 0; k < length; k++) {
+      for (int l = 0; l < frames; l++) {
+        acs[k * lanes + l] = ac[f + l][k];
+      }
+      for (int l = frames; l < lanes; l++) {
+        acs[k * lanes + l] = k == 0;
+      }
+    }
+    lpc_kernel(acs, length, lpcs, errors);
+    for (int l = 0; l < frames; l++) {
+      /* See the special case in ldr_lpc() */
+      if (ac[f + l][0] == 0) {
+        errors[l] = 0;
+        for (int k = 0; k < length - 1; k++) {
+          lpcs[k * lanes + l] = 0;
+        }
+      }
+    }
+    for (int l = 0; l < lanes; l++) {
+      ccs[l] = logf(in[l]);
+    }
+    cc_kernel(in, cc_length, ccs, size);
+    for (int l = 0; l < frames; l++) {
+      for (int m = 0; m < size; m++) {
+        cc[f + l][m] = ccs[m * lanes + l];
+      }
+    }
+  }
+  free(acs);
+}
@@ -46,6 +46,55 @@ extern "C" {
 /// J. Durbin in 1959.
 float ldr_lpc(int simd,  const float *ac, int length, float *lpc);
 
+/// @brief Calculates LPC of several frames at once, the same as ldr_lpc()
+/// does for each of them. The recursion of every frame runs in its own SIMD
+/// lane, so 16 (AVX-512), 8 (AVX) or 4 (NEON) frames advance together.
+/// @param simd Value indicating whether to use SIMD acceleration.
+/// @param ac The autocorrelation values of the frames, each [0...length).
+/// @param count The number of frames.
+/// @param length The size of each ac (in float-s, not in bytes).
+/// @param lpc The resulting LPC of the frames, each [0...length - 1).
+/// @param errors The minimum mean square errors of the frames [0...count).
+/// May be NULL.
+void ldr_lpc_batch(int simd, const float *const *ac, int count, int length,
+                   float *const *lpc, float *errors);
+
+/// @brief Converts LPC to cepstral coefficients (CC) using the recursion
+/// c[m] = -a[m] - sum_{k=1}^{m-1} (m - k) / m * a[k] * c[m - k].
+/// @param lpc [0...length) LPC. The first element is used as the gain,
+/// cc[0] = log(lpc[0]).
+/// @param length The size of lpc (in float-s, not in bytes).
+/// @param cc The resulting cepstral coefficients [0...size).
+/// @param size The number of cepstral coefficients to calculate.
+void lpc_to_cc(const float *lpc, int length, float *cc, int size);
+
+/// @brief Converts LPC of several frames at once, the same as lpc_to_cc()
+/// does for each of them. The frames are transposed into a small scratch,
+/// so that 16 (AVX-512), 8 (AVX) or 4 (NEON) of them advance together.
+/// @param simd Value indicating whether to use SIMD acceleration.
+/// @param lpc The LPC of the frames, each [0...length).
+/// @param count The number of frames.
+/// @param length The size of each lpc (in float-s, not in bytes).
+/// @param cc The resulting cepstral coefficients of the frames,
+/// each [0...size).
+/// @param size The number of cepstral coefficients to calculate.
+void lpc_to_cc_batch(int simd, const float *const *lpc, int count, int length,
+                     float *const *cc, int size);
+
+/// @brief Calculates the same as ldr_lpc_batch() followed by
+/// lpc_to_cc_batch(), without leaving the transposed scratch in between.
+/// @param simd Value indicating whether to use SIMD acceleration.
+/// @param ac The autocorrelation values of the frames, each [0...length).
+/// @param count The number of frames.
+/// @param length The size of each ac (in float-s, not in bytes).
+/// @param error Value indicating whether the minimum mean square error is
+/// prepended to LPC before the conversion.
+/// @param cc The resulting cepstral coefficients of the frames,
+/// each [0...size).
+/// @param size The number of cepstral coefficients to calculate.
+void ldr_lpc_cc_batch(int simd, const float *const *ac, int count, int length,
+                      int error, float *const *cc, int size);
+
 #ifdef __cplusplus
 }
 #endif
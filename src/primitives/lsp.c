@@ -99,8 +99,15 @@ Original copyright
 #define _XOPEN_SOURCE
 #include <assert.h>
 #include <math.h>
+#include <stdlib.h>
 #include <simd/arithmetic-inl.h>
 #include <simd/mathfun.h>
+#include "src/simd_dispatch.h"
+#ifdef SIMD_X86
+#include <immintrin.h>
+#elif defined(SIMD_NEON)
+#include <arm_neon.h>
+#endif
 
 #define FREQ_SCALE 1.f
 #define LPC_SCALING 1.f
@@ -128,25 +135,13 @@ static float cheb_poly_eval(const float *coef, float x, int m) {
    return -b1 + .5f * x * b0 + coef[m];
 }
 
-int lpc_to_lsp(int simd, const float *lpc, int length, int bisects, float delta,
-               float *freq) {
-  assert(lpc);
-  assert(length >= 2);
-  assert(bisects >= 0);
-  assert(delta > 0);
-  assert(freq);
-  memsetf(freq, 0.f, length);
-  int roots = 0;             /* DR 8/2/94: number of roots found which will be
-                                           returned   */
-  int m = length / 2;              /* order of P'(z) & Q'(z) polynomials   */
-
-  /* Allocate memory space for polynomials */
-  float Q[m + 1];
-  float P[m + 1];
-
-  /* determine P'(z)'s and Q'(z)'s coefficients where
-    P'(z) = P(z)/(1 + z^(-1)) and Q'(z) = Q(z)/(1-z^(-1)) */
-
+/// @brief Determines P'(z)'s and Q'(z)'s coefficients, where
+/// P'(z) = P(z)/(1 + z^(-1)) and Q'(z) = Q(z)/(1-z^(-1)).
+/// @param P The resulting P'(z) [0...length / 2].
+/// @param Q The resulting Q'(z) [0...length / 2].
+static void lsp_polynomials(int simd, const float *lpc, int length,
+                            float *P, float *Q) {
+  int m = length / 2;
   float *px = P;               /* ptrs of respective P'(z) & Q'(z)  */
   float *qx = Q;
   float *p = P;
@@ -166,6 +161,24 @@ int lpc_to_lsp(int simd, const float *lpc, int length, int bisects, float delta,
     real_multiply_scalar_na(P, m, 2.f, P);
     real_multiply_scalar_na(Q, m, 2.f, Q);
   }
+}
+
+int lpc_to_lsp(int simd, const float *lpc, int length, int bisects, float delta,
+               float *freq) {
+  assert(lpc);
+  assert(length >= 2);
+  assert(bisects >= 0);
+  assert(delta > 0);
+  assert(freq);
+  memsetf(freq, 0.f, length);
+  int roots = 0;             /* DR 8/2/94: number of roots found which will be
+                                           returned   */
+  int m = length / 2;              /* order of P'(z) & Q'(z) polynomials   */
+
+  /* Allocate memory space for polynomials */
+  float Q[m + 1];
+  float P[m + 1];
+  lsp_polynomials(simd, lpc, length, P, Q);
 
   /* Search for a zero in P'(z) polynomial first and then alternate to Q'(z).
   Keep alternating between the two polynomials as each zero is found   */
@@ -231,6 +244,266 @@ int lpc_to_lsp(int simd, const float *lpc, int length, int bisects, float delta,
   return roots;
 }
 
+/// @brief Evaluates the same series of Chebyshev polynomials at many points,
+/// doing exactly the same operations as cheb_poly_eval().
+typedef void (*cheb_poly_eval_many_kernel)(const float *coef, int m,
+                                           const float *x, int n, float *res);
+
+static void cheb_poly_eval_many_scalar(const float *coef, int m,
+                                       const float *x, int n, float *res) {
+  for (int i = 0; i < n; i++) {
+    res[i] = cheb_poly_eval(coef, x[i], m);
+  }
+}
+
+#ifdef SIMD_X86
+SIMD_TARGET_AVX512
+static void cheb_poly_eval_many_avx512(const float *coef, int m,
+                                       const float *x, int n, float *res) {
+  const __m512 half = _mm512_set1_ps(.5f), two = _mm512_set1_ps(2.f);
+  for (int i = 0; i < n; i += 16) {
+    __mmask16 mask = n - i >= 16? 0xFFFF : (1u << (n - i)) - 1;
+    __m512 x2 = _mm512_mul_ps(_mm512_maskz_loadu_ps(mask, x + i), two);
+    __m512 b0 = _mm512_setzero_ps(), b1 = _mm512_setzero_ps();
+    for (int k = m; k > 0; k--) {
+      __m512 tmp = b0;
+      b0 = _mm512_add_ps(_mm512_sub_ps(_mm512_mul_ps(x2, b0), b1),
+                         _mm512_set1_ps(coef[m - k]));
+      b1 = tmp;
+    }
+    __m512 sum = _mm512_sub_ps(_mm512_mul_ps(_mm512_mul_ps(half, x2), b0),
+                               b1);
+    _mm512_mask_storeu_ps(res + i, mask,
+                          _mm512_add_ps(sum, _mm512_set1_ps(coef[m])));
+  }
+}
+
+SIMD_TARGET("avx")
+static void cheb_poly_eval_many_avx(const float *coef, int m,
+                                    const float *x, int n, float *res) {
+  const __m256 half = _mm256_set1_ps(.5f), two = _mm256_set1_ps(2.f);
+  int i = 0;
+  for (; i < n - 7; i += 8) {
+    __m256 x2 = _mm256_mul_ps(_mm256_loadu_ps(x + i), two);
+    __m256 b0 = _mm256_setzero_ps(), b1 = _mm256_setzero_ps();
+    for (int k = m; k > 0; k--) {
+      __m256 tmp = b0;
+      b0 = _mm256_add_ps(_mm256_sub_ps(_mm256_mul_ps(x2, b0), b1),
+                         _mm256_set1_ps(coef[m - k]));
+      b1 = tmp;
+    }
+    __m256 sum = _mm256_sub_ps(_mm256_mul_ps(_mm256_mul_ps(half, x2), b0),
+                               b1);
+    _mm256_storeu_ps(res + i, _mm256_add_ps(sum, _mm256_set1_ps(coef[m])));
+  }
+  cheb_poly_eval_many_scalar(coef, m, x + i, n - i, res + i);
+}
+#elif defined(SIMD_NEON)
+static void cheb_poly_eval_many_neon(const float *coef, int m,
+                                     const float *x, int n, float *res) {
+  int i = 0;
+  for (; i < n - 3; i += 4) {
+    float32x4_t x2 = vmulq_n_f32(vld1q_f32(x + i), 2.f);
+    float32x4_t b0 = vdupq_n_f32(0.f), b1 = vdupq_n_f32(0.f);
+    for (int k = m; k > 0; k--) {
+      float32x4_t tmp = b0;
+      b0 = vaddq_f32(vsubq_f32(vmulq_f32(x2, b0), b1),
+                     vdupq_n_f32(coef[m - k]));
+      b1 = tmp;
+    }
+    float32x4_t sum = vsubq_f32(vmulq_f32(vmulq_n_f32(x2, .5f), b0), b1);
+    vst1q_f32(res + i, vaddq_f32(sum, vdupq_n_f32(coef[m])));
+  }
+  cheb_poly_eval_many_scalar(coef, m, x + i, n - i, res + i);
+}
+#endif
+
+static cheb_poly_eval_many_kernel select_cheb_poly_eval_many(int simd) {
+  if (simd) {
+#ifdef SIMD_X86
+    if (simd_instruction_set_enabled(SIMD_INSTRUCTION_SET_AVX512)) {
+      return cheb_poly_eval_many_avx512;
+    }
+    if (simd_instruction_set_enabled(SIMD_INSTRUCTION_SET_AVX)) {
+      return cheb_poly_eval_many_avx;
+    }
+#elif defined(SIMD_NEON)
+    if (simd_instruction_set_enabled(SIMD_INSTRUCTION_SET_NEON)) {
+      return cheb_poly_eval_many_neon;
+    }
+#endif
+  }
+  return cheb_poly_eval_many_scalar;
+}
+
+/// @brief The brackets of the roots of one polynomial, [xr, xl] each.
+typedef struct {
+  float *xl, *xr, *fl, *fr, *xm, *fm, *tol;
+  int *active;
+  int size;
+} lsp_brackets;
+
+/// @brief Finds the sign changes of the polynomial on the grid, from x = 1
+/// downwards, with the same condition as lpc_to_lsp().
+static void lsp_bracket(const float *grid, const float *values, int points,
+                        lsp_brackets *brackets) {
+  brackets->size = 0;
+  for (int g = 0; g < points - 1; g++) {
+    /* A zero at a grid point has already ended the previous bracket */
+    if (values[g] * values[g + 1] <= 0 && (g == 0 || values[g] != 0)) {
+      int b = brackets->size++;
+      brackets->xl[b] = grid[g];
+      brackets->xr[b] = grid[g + 1];
+      brackets->fl[b] = values[g];
+      brackets->fr[b] = values[g + 1];
+    }
+  }
+}
+
+/// @brief Refines all the brackets together, leaving the roots in xm.
+static void lsp_refine(cheb_poly_eval_many_kernel eval, const float *coef,
+                       int m, int bisects, LSPRefinementType refinement,
+                       lsp_brackets *br) {
+  int n = br->size;
+  if (refinement == LSP_REFINEMENT_BISECTION) {
+    /* Exactly the bisection from lpc_to_lsp() */
+    for (int k = 0; k <= bisects; k++) {
+      for (int b = 0; b < n; b++) {
+        br->xm[b] = (br->xl[b] + br->xr[b]) / 2;
+      }
+      eval(coef, m, br->xm, n, br->fm);
+      for (int b = 0; b < n; b++) {
+        if (br->fm[b] * br->fl[b] >= 0) {
+          br->fl[b] = br->fm[b];
+          br->xl[b] = br->xm[b];
+        } else {
+          br->xr[b] = br->xm[b];
+        }
+      }
+    }
+    return;
+  }
+  const float scale = ldexpf(1.f, -(bisects + 1));
+  for (int b = 0; b < n; b++) {
+    br->tol[b] = (br->xl[b] - br->xr[b]) * scale;
+    br->active[b] = 1;
+  }
+  /* Illinois: xl is the retained end point, xr is the latest estimate */
+  for (int k = 0, active = n; k <= bisects && active > 0; k++) {
+    for (int b = 0; b < n; b++) {
+      if (br->active[b]) {
+        float xm = (br->xl[b] * br->fr[b] - br->xr[b] * br->fl[b]) /
+            (br->fr[b] - br->fl[b]);
+        float lo = br->xl[b] < br->xr[b]? br->xl[b] : br->xr[b];
+        float hi = br->xl[b] < br->xr[b]? br->xr[b] : br->xl[b];
+        if (!(xm >= lo && xm <= hi)) {
+          xm = (br->xl[b] + br->xr[b]) / 2;
+        }
+        br->xm[b] = xm;
+      }
+    }
+    eval(coef, m, br->xm, n, br->fm);
+    for (int b = 0; b < n; b++) {
+      if (!br->active[b]) {
+        continue;
+      }
+      if (br->fm[b] * br->fr[b] < 0) {
+        br->xl[b] = br->xr[b];
+        br->fl[b] = br->fr[b];
+      } else {
+        br->fl[b] /= 2;
+      }
+      float step = fabsf(br->xm[b] - br->xr[b]);
+      br->xr[b] = br->xm[b];
+      br->fr[b] = br->fm[b];
+      /* The retained end point may stay far away, so the step tells the
+         convergence as well */
+      if (br->fm[b] == 0 || step < br->tol[b] ||
+          fabsf(br->xl[b] - br->xr[b]) < br->tol[b]) {
+        br->active[b] = 0;
+        active--;
+      }
+    }
+  }
+}
+
+void lpc_to_lsp_batch(int simd, const float *const *lpc, int count,
+                      int length, int bisects, float delta,
+                      LSPRefinementType refinement, float *const *freq,
+                      int *roots) {
+  assert(lpc);
+  assert(length >= 2);
+  assert(bisects >= 0);
+  assert(delta > 0);
+  assert(freq);
+  int m = length / 2;
+  cheb_poly_eval_many_kernel eval = select_cheb_poly_eval_many(simd);
+
+  /* The grid is the same for all the frames. The step is the one which
+     lpc_to_lsp() takes near the roots, where |poly| < 0.2. */
+  int points = 0;
+  for (float x = FREQ_SCALE; ; x -= .5f * delta * (1 - 0.9f * x * x)) {
+    points++;
+    if (x < -FREQ_SCALE) {
+      break;
+    }
+  }
+  float *grid = malloc(points * 3 * sizeof(float));
+  float *pvalues = grid + points, *qvalues = pvalues + points;
+  float x = FREQ_SCALE;
+  for (int g = 0; g < points; g++) {
+    grid[g] = x;
+    x -= .5f * delta * (1 - 0.9f * x * x);
+  }
+  lsp_brackets brackets[2];
+  float *floats = malloc(points * 2 * 7 * sizeof(float));
+  int *ints = malloc(points * 2 * sizeof(int));
+  for (int p = 0; p < 2; p++) {
+    float **arrays[] = { &brackets[p].xl, &brackets[p].xr, &brackets[p].fl,
+                         &brackets[p].fr, &brackets[p].xm, &brackets[p].fm,
+                         &brackets[p].tol };
+    for (int a = 0; a < 7; a++) {
+      *arrays[a] = floats + (p * 7 + a) * points;
+    }
+    brackets[p].active = ints + p * points;
+  }
+
+  for (int f = 0; f < count; f++) {
+    float P[m + 1], Q[m + 1];
+    lsp_polynomials(simd, lpc[f], length, P, Q);
+    eval(P, m, grid, points, pvalues);
+    eval(Q, m, grid, points, qvalues);
+    lsp_bracket(grid, pvalues, points, &brackets[0]);
+    lsp_bracket(grid, qvalues, points, &brackets[1]);
+    lsp_refine(eval, P, m, bisects, refinement, &brackets[0]);
+    lsp_refine(eval, Q, m, bisects, refinement, &brackets[1]);
+
+    /* The roots alternate between P'(z) and Q'(z); each search continues
+       below the previous root, the same as in lpc_to_lsp() */
+    memsetf(freq[f], 0.f, length);
+    int found = 0, next[2] = { 0, 0 };
+    float current = 2 * FREQ_SCALE;
+    for (int j = 0; j < length; j++) {
+      lsp_brackets *br = &brackets[j & 1];
+      while (next[j & 1] < br->size && br->xm[next[j & 1]] >= current) {
+        next[j & 1]++;
+      }
+      if (next[j & 1] == br->size) {
+        break;
+      }
+      current = br->xm[next[j & 1]++];
+      freq[f][j] = acosf(current);
+      found++;
+    }
+    if (roots != NULL) {
+      roots[f] = found;
+    }
+  }
+  free(ints);
+  free(floats);
+  free(grid);
+}
+
 void lsp_to_lpc(int simd, const float *freq, int length, float *lpc) {
   assert(freq);
   assert(length >= 2);
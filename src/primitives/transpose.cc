@@ -0,0 +1,173 @@
+/*! @file transpose.cc
+ *  @brief Cache blocked matrix transposition.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#include "src/primitives/transpose.h"
+#include <algorithm>
+#ifdef SIMD_X86
+#include <immintrin.h>
+#elif defined(SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace sound_feature_extraction {
+
+/// @brief The number of columns in the block of the input, which fits
+/// a 64-byte cache line.
+static constexpr size_t kBlockSize = 16;
+
+typedef void (*TransposeKernel)(const float* in, size_t rows, size_t cols,
+                                size_t inStride, float* out,
+                                size_t outStride);
+
+/// @brief Transposes the rows [rowsBegin, rows) x the columns
+/// [colsBegin, cols).
+static void TransposeTail(const float* in, size_t rowsBegin, size_t rows,
+                          size_t colsBegin, size_t cols, size_t inStride,
+                          float* out, size_t outStride) {
+  for (size_t c = colsBegin; c < cols; c++) {
+    for (size_t r = rowsBegin; r < rows; r++) {
+      out[c * outStride + r] = in[r * inStride + c];
+    }
+  }
+}
+
+/// @brief Transposes the N x N tiles with Tile() block by block and the rest
+/// element by element.
+template <size_t N, void (*Tile)(const float*, size_t, float*, size_t)>
+static void TransposeTiles(const float* in, size_t rows, size_t cols,
+                           size_t inStride, float* out, size_t outStride) {
+  static_assert(kBlockSize % N == 0, "The tiles must not cross the blocks");
+  size_t tiledRows = rows - rows % N;
+  size_t tiledCols = cols - cols % N;
+  for (size_t block = 0; block < tiledCols; block += kBlockSize) {
+    size_t blockEnd = std::min(block + kBlockSize, tiledCols);
+    for (size_t r = 0; r < tiledRows; r += N) {
+      for (size_t c = block; c < blockEnd; c += N) {
+        Tile(in + r * inStride + c, inStride, out + c * outStride + r,
+             outStride);
+      }
+    }
+  }
+  TransposeTail(in, 0, tiledRows, tiledCols, cols, inStride, out, outStride);
+  TransposeTail(in, tiledRows, rows, 0, cols, inStride, out, outStride);
+}
+
+template <size_t N>
+static void TransposeTileScalar(const float* in, size_t inStride, float* out,
+                                size_t outStride) {
+  for (size_t c = 0; c < N; c++) {
+    for (size_t r = 0; r < N; r++) {
+      out[c * outStride + r] = in[r * inStride + c];
+    }
+  }
+}
+
+#ifdef SIMD_X86
+SIMD_TARGET("sse4.1")
+static void TransposeTileSSE41(const float* in, size_t inStride, float* out,
+                               size_t outStride) {
+  __m128 r0 = _mm_loadu_ps(in);
+  __m128 r1 = _mm_loadu_ps(in + inStride);
+  __m128 r2 = _mm_loadu_ps(in + 2 * inStride);
+  __m128 r3 = _mm_loadu_ps(in + 3 * inStride);
+  _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+  _mm_storeu_ps(out, r0);
+  _mm_storeu_ps(out + outStride, r1);
+  _mm_storeu_ps(out + 2 * outStride, r2);
+  _mm_storeu_ps(out + 3 * outStride, r3);
+}
+
+SIMD_TARGET("avx")
+static void TransposeTileAVX(const float* in, size_t inStride, float* out,
+                             size_t outStride) {
+  __m256 r[8];
+  for (int k = 0; k < 8; k++) {
+    r[k] = _mm256_loadu_ps(in + k * inStride);
+  }
+  // Interleave the pairs of rows, then the pairs of pairs within the lanes
+  __m256 a[8], b[8];
+  for (int k = 0; k < 4; k++) {
+    a[k * 2] = _mm256_unpacklo_ps(r[k * 2], r[k * 2 + 1]);
+    a[k * 2 + 1] = _mm256_unpackhi_ps(r[k * 2], r[k * 2 + 1]);
+  }
+  for (int k = 0; k < 2; k++) {
+    b[k * 4] = _mm256_shuffle_ps(a[k * 4], a[k * 4 + 2], 0x44);
+    b[k * 4 + 1] = _mm256_shuffle_ps(a[k * 4], a[k * 4 + 2], 0xEE);
+    b[k * 4 + 2] = _mm256_shuffle_ps(a[k * 4 + 1], a[k * 4 + 3], 0x44);
+    b[k * 4 + 3] = _mm256_shuffle_ps(a[k * 4 + 1], a[k * 4 + 3], 0xEE);
+  }
+  // Exchange the 128-bit lanes of the upper and the lower 4 rows
+  for (int k = 0; k < 4; k++) {
+    _mm256_storeu_ps(out + k * outStride,
+                     _mm256_permute2f128_ps(b[k], b[k + 4], 0x20));
+    _mm256_storeu_ps(out + (k + 4) * outStride,
+                     _mm256_permute2f128_ps(b[k], b[k + 4], 0x31));
+  }
+}
+#elif defined(SIMD_NEON)
+static void TransposeTileNEON(const float* in, size_t inStride, float* out,
+                              size_t outStride) {
+  float32x4x2_t t01 = vtrnq_f32(vld1q_f32(in), vld1q_f32(in + inStride));
+  float32x4x2_t t23 = vtrnq_f32(vld1q_f32(in + 2 * inStride),
+                                vld1q_f32(in + 3 * inStride));
+  vst1q_f32(out, vcombine_f32(vget_low_f32(t01.val[0]),
+                              vget_low_f32(t23.val[0])));
+  vst1q_f32(out + outStride, vcombine_f32(vget_low_f32(t01.val[1]),
+                                          vget_low_f32(t23.val[1])));
+  vst1q_f32(out + 2 * outStride, vcombine_f32(vget_high_f32(t01.val[0]),
+                                              vget_high_f32(t23.val[0])));
+  vst1q_f32(out + 3 * outStride, vcombine_f32(vget_high_f32(t01.val[1]),
+                                              vget_high_f32(t23.val[1])));
+}
+#endif
+
+static const SimdKernel<TransposeKernel> kTransposeKernels[] {
+#ifdef SIMD_X86
+  { InstructionSet::kAVX, TransposeTiles<8, TransposeTileAVX> },
+  { InstructionSet::kSSE41, TransposeTiles<4, TransposeTileSSE41> },
+#elif defined(SIMD_NEON)
+  { InstructionSet::kNEON, TransposeTiles<4, TransposeTileNEON> },
+#endif
+  { InstructionSet::kScalar, TransposeTiles<8, TransposeTileScalar<8>> }
+};
+
+void Transpose(bool simd, const float* in, size_t rows, size_t cols,
+               size_t inStride, float* out, size_t outStride) noexcept {
+  auto kernel = simd? SimdAware::Dispatch(kTransposeKernels).Function
+                    : TransposeTiles<8, TransposeTileScalar<8>>;
+  kernel(in, rows, cols, inStride, out, outStride);
+}
+
+InstructionSet TransposeInstructionSet() noexcept {
+  return SimdAware::Dispatch(kTransposeKernels).Isa;
+}
+
+}  // namespace sound_feature_extraction
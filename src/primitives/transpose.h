@@ -0,0 +1,59 @@
+/*! @file transpose.h
+ *  @brief Cache blocked matrix transposition.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#ifndef SRC_PRIMITIVES_TRANSPOSE_H_
+#define SRC_PRIMITIVES_TRANSPOSE_H_
+
+#include <stddef.h>
+#include "src/simd_aware.h"
+
+namespace sound_feature_extraction {
+
+/// @brief Transposes the rows x cols matrix, so that
+/// out[c * outStride + r] = in[r * inStride + c]. The matrix is processed
+/// by the tiles which are transposed in the vector registers, the tiles of
+/// the same cache lines of the input go one after another.
+/// @param simd Value indicating whether to use SIMD acceleration.
+/// @param in The source matrix.
+/// @param rows The number of rows in the source matrix.
+/// @param cols The number of columns in the source matrix.
+/// @param inStride The distance between the rows of in, in elements.
+/// @param out The transposed matrix, must not overlap with in.
+/// @param outStride The distance between the rows of out, in elements.
+void Transpose(bool simd, const float* in, size_t rows, size_t cols,
+               size_t inStride, float* out, size_t outStride) noexcept;
+
+/// @brief Returns the instruction set Transpose() uses.
+InstructionSet TransposeInstructionSet() noexcept;
+
+}  // namespace sound_feature_extraction
+
+#endif  // SRC_PRIMITIVES_TRANSPOSE_H_
@@ -0,0 +1,137 @@
+/*! @file validate.c
+ *  @brief Low level validation of the floating point arrays.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+#include "src/primitives/validate.h"
+#include <simd/instruction_set.h>
+#include "src/simd_dispatch.h"
+#ifdef SIMD_X86
+#include <immintrin.h>
+#elif defined(SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
+/* x - x is 0 for the finite x and NaN for NaN and the infinities. */
+
+static size_t find_nonfinite_scalar(const float *array, size_t length,
+                                    int *nonzero) {
+  for (size_t j = 0; j < length; j++) {
+    float value = array[j];
+    if (value - value != 0) {
+      return j;
+    }
+    if (value != 0) {
+      *nonzero = 1;
+    }
+  }
+  return length;
+}
+
+#ifdef SIMD_X86
+SIMD_TARGET_AVX512
+static size_t find_nonfinite_avx512(const float *array, size_t length,
+                                    int *nonzero) {
+  const __m512 zero = _mm512_setzero_ps();
+  __mmask16 nonzeros = 0;
+  size_t j = 0;
+  for (; j + 16 <= length; j += 16) {
+    __m512 vec = _mm512_loadu_ps(array + j);
+    if (_mm512_cmp_ps_mask(_mm512_sub_ps(vec, vec), zero, _CMP_NEQ_UQ)) {
+      break;
+    }
+    nonzeros |= _mm512_cmp_ps_mask(vec, zero, _CMP_NEQ_UQ);
+  }
+  if (nonzeros) {
+    *nonzero = 1;
+  }
+  return j + find_nonfinite_scalar(array + j, length - j, nonzero);
+}
+
+SIMD_TARGET("avx")
+static size_t find_nonfinite_avx(const float *array, size_t length,
+                                 int *nonzero) {
+  const __m256 zero = _mm256_setzero_ps();
+  __m256 nonzeros = zero;
+  size_t j = 0;
+  for (; j + 8 <= length; j += 8) {
+    __m256 vec = _mm256_loadu_ps(array + j);
+    if (_mm256_movemask_ps(_mm256_cmp_ps(
+        _mm256_sub_ps(vec, vec), zero, _CMP_NEQ_UQ))) {
+      break;
+    }
+    nonzeros = _mm256_or_ps(nonzeros,
+                            _mm256_cmp_ps(vec, zero, _CMP_NEQ_UQ));
+  }
+  if (_mm256_movemask_ps(nonzeros)) {
+    *nonzero = 1;
+  }
+  return j + find_nonfinite_scalar(array + j, length - j, nonzero);
+}
+#elif defined(SIMD_NEON)
+static size_t find_nonfinite_neon(const float *array, size_t length,
+                                  int *nonzero) {
+  const float32x4_t zero = vdupq_n_f32(0.f);
+  uint32x4_t nonzeros = vdupq_n_u32(0);
+  size_t j = 0;
+  for (; j + 4 <= length; j += 4) {
+    float32x4_t vec = vld1q_f32(array + j);
+    uint32x4_t finite = vceqq_f32(vsubq_f32(vec, vec), zero);
+    uint32x2_t halves = vand_u32(vget_low_u32(finite),
+                                 vget_high_u32(finite));
+    if ((vget_lane_u32(halves, 0) & vget_lane_u32(halves, 1)) == 0) {
+      break;
+    }
+    nonzeros = vorrq_u32(nonzeros, vmvnq_u32(vceqq_f32(vec, zero)));
+  }
+  uint32x2_t any = vorr_u32(vget_low_u32(nonzeros), vget_high_u32(nonzeros));
+  if (vget_lane_u32(any, 0) | vget_lane_u32(any, 1)) {
+    *nonzero = 1;
+  }
+  return j + find_nonfinite_scalar(array + j, length - j, nonzero);
+}
+#endif
+
+size_t find_nonfinite(int simd, const float *array, size_t length,
+                      int *nonzero) {
+  if (simd) {
+#ifdef SIMD_X86
+    if (simd_instruction_set_enabled(SIMD_INSTRUCTION_SET_AVX512)) {
+      return find_nonfinite_avx512(array, length, nonzero);
+    }
+    if (simd_instruction_set_enabled(SIMD_INSTRUCTION_SET_AVX)) {
+      return find_nonfinite_avx(array, length, nonzero);
+    }
+#elif defined(SIMD_NEON)
+    if (simd_instruction_set_enabled(SIMD_INSTRUCTION_SET_NEON)) {
+      return find_nonfinite_neon(array, length, nonzero);
+    }
+#endif
+  }
+  return find_nonfinite_scalar(array, length, nonzero);
+}
@@ -35,37 +35,19 @@
 #include <list>
 #include <memory>
 #include <string>
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wold-style-cast"
-#include <boost/regex.hpp>  // NOLINT(build/include_order)
-#pragma GCC diagnostic pop
 #include <simd/wavelet.h>
-#include "src/stoi_function.h"
+#include "src/simd_dispatch.h"
+#ifdef SIMD_X86
+#include <immintrin.h>
+#elif defined(SIMD_NEON)
+#include <arm_neon.h>
+#endif
 
 namespace sound_feature_extraction {
 
 TreeFingerprint Parse(const std::string& str, identity<TreeFingerprint>) {
-  static const boost::regex all_regex("^\\s*(\\d+\\s*(\\s|$))+");
-  static const boost::regex int_regex("(\\d+\\s*(\\s|$))");
-
-  boost::smatch match;
-  if (!boost::regex_match(str, match, all_regex)) {
-    throw WaveletTreeDescriptionParseException(str);
-  }
-
   TreeFingerprint res;
-  try {
-    std::transform(boost::sregex_token_iterator(str.begin(), str.end(),
-                                                int_regex,
-                                                1),
-                   boost::sregex_token_iterator(),
-                   std::back_inserter(res),
-                   std::stoi_function);
-  }
-  catch(const std::invalid_argument& e) {
-    throw WaveletTreeDescriptionParseException(str);
-  }
-  if (res.empty()) {
+  if (!SplitIntegers(str, &res)) {
     throw WaveletTreeDescriptionParseException(str);
   }
   return res;
@@ -91,8 +73,8 @@ WaveletFilterBank::WaveletFilterBank(WaveletType type, int order,
     : type_(type),
       order_(order),
       tree_(treeDescription) {
-
   ValidateDescription(treeDescription);
+  ExtractTaps();
 }
 
 WaveletFilterBank::WaveletFilterBank(WaveletType type, int order,
@@ -100,7 +82,40 @@ WaveletFilterBank::WaveletFilterBank(WaveletType type, int order,
     : type_(type),
       order_(order),
       tree_(treeDescription) {
-  ValidateDescription(treeDescription);
+  ValidateDescription(tree_);
+  ExtractTaps();
+}
+
+constexpr int WaveletFilterBank::kMaxLanes;
+
+void WaveletFilterBank::ExtractTaps() {
+  offsets_.clear();
+  hi_taps_.clear();
+  lo_taps_.clear();
+  if (!wavelet_validate_order(type_, order_)) {
+    return;
+  }
+  // wavelet_apply() is linear and periodic, so the first outputs of the
+  // unit impulses are the taps
+  size_t length = 2 * order_;
+  std::vector<float> impulse(length, 0.f);
+  auto desthi = std::unique_ptr<float, decltype(&std::free)>(
+      wavelet_allocate_destination(order_, length), free);
+  auto destlo = std::unique_ptr<float, decltype(&std::free)>(
+      wavelet_allocate_destination(order_, length), free);
+  for (size_t i = 0; i < length; i++) {
+    impulse[i] = 1.f;
+    auto src = std::unique_ptr<float, decltype(&std::free)>(
+        wavelet_prepare_array(order_, impulse.data(), length), free);
+    impulse[i] = 0.f;
+    wavelet_apply(type_, order_, EXTENSION_TYPE_PERIODIC, src.get(), length,
+                  desthi.get(), destlo.get());
+    if (desthi.get()[0] != 0 || destlo.get()[0] != 0) {
+      offsets_.push_back(i < length / 2? i : static_cast<int>(i - length));
+      hi_taps_.push_back(desthi.get()[0]);
+      lo_taps_.push_back(destlo.get()[0]);
+    }
+  }
 }
 
 void WaveletFilterBank::ValidateWavelet(WaveletType type,
@@ -201,6 +216,201 @@ void WaveletFilterBank::ApplyInternal(float* source, size_t length,
   }
 }
 
+/// @brief The batched kernels work on the interleaved frames: sample s of
+/// the frame in lane l is at [s * lanes + l].
+static inline int WrapIndex(int index, int length) {
+  if (index >= 0 && index < length) {
+    return index;
+  }
+  index %= length;
+  return index < 0? index + length : index;
+}
+
+static void SplitScalar(const int* offsets, const float* hitaps,
+                        const float* lotaps, int taps, const float* source,
+                        size_t length, float* desthi, float* destlo) {
+  int n = length;
+  for (int i = 0; i < n / 2; i++) {
+    float hi = 0.f, lo = 0.f;
+    for (int t = 0; t < taps; t++) {
+      float x = source[WrapIndex(2 * i + offsets[t], n)];
+      hi += hitaps[t] * x;
+      lo += lotaps[t] * x;
+    }
+    desthi[i] = hi;
+    destlo[i] = lo;
+  }
+}
+
+#ifdef SIMD_X86
+SIMD_TARGET("avx")
+static void SplitAVX(const int* offsets, const float* hitaps,
+                     const float* lotaps, int taps, const float* source,
+                     size_t length, float* desthi, float* destlo) {
+  int n = length;
+  for (int i = 0; i < n / 2; i++) {
+    __m256 hi = _mm256_setzero_ps();
+    __m256 lo = _mm256_setzero_ps();
+    for (int t = 0; t < taps; t++) {
+      __m256 x = _mm256_loadu_ps(
+          source + WrapIndex(2 * i + offsets[t], n) * 8);
+      hi = _mm256_add_ps(hi, _mm256_mul_ps(_mm256_set1_ps(hitaps[t]), x));
+      lo = _mm256_add_ps(lo, _mm256_mul_ps(_mm256_set1_ps(lotaps[t]), x));
+    }
+    _mm256_storeu_ps(desthi + i * 8, hi);
+    _mm256_storeu_ps(destlo + i * 8, lo);
+  }
+}
+
+SIMD_TARGET_AVX512
+static void SplitAVX512(const int* offsets, const float* hitaps,
+                        const float* lotaps, int taps, const float* source,
+                        size_t length, float* desthi, float* destlo) {
+  int n = length;
+  for (int i = 0; i < n / 2; i++) {
+    __m512 hi = _mm512_setzero_ps();
+    __m512 lo = _mm512_setzero_ps();
+    for (int t = 0; t < taps; t++) {
+      __m512 x = _mm512_loadu_ps(
+          source + WrapIndex(2 * i + offsets[t], n) * 16);
+      hi = _mm512_fmadd_ps(_mm512_set1_ps(hitaps[t]), x, hi);
+      lo = _mm512_fmadd_ps(_mm512_set1_ps(lotaps[t]), x, lo);
+    }
+    _mm512_storeu_ps(desthi + i * 16, hi);
+    _mm512_storeu_ps(destlo + i * 16, lo);
+  }
+}
+#elif defined(SIMD_NEON)
+static void SplitNEON(const int* offsets, const float* hitaps,
+                      const float* lotaps, int taps, const float* source,
+                      size_t length, float* desthi, float* destlo) {
+  int n = length;
+  for (int i = 0; i < n / 2; i++) {
+    float32x4_t hi = vdupq_n_f32(0.f);
+    float32x4_t lo = vdupq_n_f32(0.f);
+    for (int t = 0; t < taps; t++) {
+      float32x4_t x = vld1q_f32(
+          source + WrapIndex(2 * i + offsets[t], n) * 4);
+      hi = vmlaq_n_f32(hi, x, hitaps[t]);
+      lo = vmlaq_n_f32(lo, x, lotaps[t]);
+    }
+    vst1q_f32(desthi + i * 4, hi);
+    vst1q_f32(destlo + i * 4, lo);
+  }
+}
+#endif
+
+int WaveletFilterBank::SelectSplitKernel(int simd,
+                                         SplitKernel* kernel) noexcept {
+  *kernel = SplitScalar;
+  if (!simd) {
+    return 1;
+  }
+#ifdef SIMD_X86
+  if (simd_instruction_set_enabled(SIMD_INSTRUCTION_SET_AVX512)) {
+    *kernel = SplitAVX512;
+    return 16;
+  }
+  if (simd_instruction_set_enabled(SIMD_INSTRUCTION_SET_AVX)) {
+    *kernel = SplitAVX;
+    return 8;
+  }
+#elif defined(SIMD_NEON)
+  if (simd_instruction_set_enabled(SIMD_INSTRUCTION_SET_NEON)) {
+    *kernel = SplitNEON;
+    return 4;
+  }
+#endif
+  return 1;
+}
+
+size_t WaveletFilterBank::BatchScratchSize(size_t length) noexcept {
+  // The interleaved frames plus both halves of every level:
+  // length * (1 + 1 + 1/2 + 1/4 + ...) < 3 * length
+  return 3 * length * kMaxLanes;
+}
+
+void WaveletFilterBank::ApplyBatch(int simd, const float* const* sources,
+                                   int count, size_t length, float* scratch,
+                                   float* const* results) const noexcept {
+  ApplyBatchInternal(simd, false, sources, count, length, scratch, results);
+}
+
+void WaveletFilterBank::ApplyBatchEnergy(
+    int simd, const float* const* sources, int count, size_t length,
+    float* scratch, float* const* energies) const noexcept {
+  ApplyBatchInternal(simd, true, sources, count, length, scratch, energies);
+}
+
+void WaveletFilterBank::ApplyBatchInternal(
+    int simd, bool energy, const float* const* sources, int count,
+    size_t length, float* scratch, float* const* results) const noexcept {
+  assert(sources && scratch && results);
+  assert(!offsets_.empty() && "The wavelet is invalid");
+  SplitKernel kernel;
+  int lanes = SelectSplitKernel(simd, &kernel);
+  for (int f = 0; f < count; f += lanes) {
+    int size = std::min(lanes, count - f);
+    for (size_t s = 0; s < length; s++) {
+      for (int l = 0; l < size; l++) {
+        scratch[s * lanes + l] = sources[f + l][s];
+      }
+      for (int l = size; l < lanes; l++) {
+        scratch[s * lanes + l] = 0.f;
+      }
+    }
+    int leaf = 0;
+    size_t offset = 0;
+    RecursivelyIterateBatch(kernel, lanes, 0, length, scratch,
+                            scratch + length * lanes, &leaf, size, &offset,
+                            energy, results + f);
+  }
+}
+
+void WaveletFilterBank::RecursivelyIterateBatch(
+    SplitKernel kernel, int lanes, int depth, size_t length,
+    const float* source, float* spare, int* leaf, int count, size_t* offset,
+    bool energy, float* const* results) const noexcept {
+  if (tree_[*leaf] == depth && energy) {
+    // The lanes are summed independently
+    float sums[kMaxLanes] = { 0.f };
+    for (size_t s = 0; s < length; s++) {
+      for (int l = 0; l < lanes; l++) {
+        float value = source[s * lanes + l];
+        sums[l] += value * value;
+      }
+    }
+    for (int l = 0; l < count; l++) {
+      results[l][*leaf] = sums[l];
+    }
+    (*leaf)++;
+    return;
+  }
+  if (tree_[*leaf] == depth) {
+    for (size_t s = 0; s < length; s++) {
+      for (int l = 0; l < count; l++) {
+        results[l][*offset + s] = source[s * lanes + l];
+      }
+    }
+    *offset += length;
+    (*leaf)++;
+    return;
+  }
+  // The halves of the next level are written over the ones of the previous
+  // sibling, which are no longer needed
+  size_t half = length / 2;
+  float* desthi = spare;
+  float* destlo = spare + half * lanes;
+  kernel(offsets_.data(), hi_taps_.data(), lo_taps_.data(), offsets_.size(),
+         source, length, desthi, destlo);
+  RecursivelyIterateBatch(kernel, lanes, depth + 1, half, desthi,
+                          spare + length * lanes, leaf, count, offset,
+                          energy, results);
+  RecursivelyIterateBatch(kernel, lanes, depth + 1, half, destlo,
+                          spare + length * lanes, leaf, count, offset,
+                          energy, results);
+}
+
 void WaveletFilterBank::RecursivelyIterate(
     WaveletType type, int order, size_t length,
     TreeFingerprint *tree, TreeFingerprint* workingTree, float* source,
@@ -76,6 +76,30 @@ class WaveletFilterBank {
 
   void Apply(const float* source, size_t length, float *result) noexcept;
 
+  /// @brief Applies the filter bank to count frames at once, several frames
+  /// at a time in the SIMD lanes.
+  /// @param simd Use the SIMD kernels if not zero.
+  /// @param sources The input frames of the given length.
+  /// @param count The number of frames.
+  /// @param scratch The temporary memory of at least
+  /// BatchScratchSize(length) floats.
+  /// @param results The output frames.
+  void ApplyBatch(int simd, const float* const* sources, int count,
+                  size_t length, float* scratch,
+                  float* const* results) const noexcept;
+
+  /// @brief Calculates the sums of the squares of the subbands which
+  /// ApplyBatch() would output, without storing the subbands. Each leaf
+  /// is reduced while it is still interleaved in scratch.
+  /// @param energies The output arrays of the tree fingerprint's length.
+  void ApplyBatchEnergy(int simd, const float* const* sources, int count,
+                        size_t length, float* scratch,
+                        float* const* energies) const noexcept;
+
+  /// @brief The number of floats ApplyBatch() and ApplyBatchEnergy() need
+  /// in scratch.
+  static size_t BatchScratchSize(size_t length) noexcept;
+
   static void ValidateWavelet(WaveletType type, int order);
   static void ValidateDescription(const TreeFingerprint& treeDescription);
   static void ValidateLength(const TreeFingerprint& tree, size_t length);
@@ -84,6 +108,39 @@ class WaveletFilterBank {
   WaveletType type_;
   int order_;
   TreeFingerprint tree_;
+  /// @brief The periodic convolution taps of wavelet_apply(): the high-pass
+  /// and the low-pass output i is the sum of hi_taps_[t] (lo_taps_[t]) times
+  /// the input (2i + offsets_[t]) mod length.
+  std::vector<int> offsets_;
+  std::vector<float> hi_taps_;
+  std::vector<float> lo_taps_;
+
+  /// @brief The maximal number of frames in the SIMD lanes.
+  static constexpr int kMaxLanes = 16;
+
+  /// @brief Splits the interleaved frames into the high-pass and the
+  /// low-pass halves using the taps above.
+  typedef void (*SplitKernel)(const int* offsets, const float* hitaps,
+                              const float* lotaps, int taps,
+                              const float* source, size_t length,
+                              float* desthi, float* destlo);
+
+  void ExtractTaps();
+
+  static int SelectSplitKernel(int simd, SplitKernel* kernel) noexcept;
+
+  void ApplyBatchInternal(int simd, bool energy,
+                          const float* const* sources, int count,
+                          size_t length, float* scratch,
+                          float* const* results) const noexcept;
+
+  /// @param energy Write the sums of the squares of the leaves to
+  /// results[lane][leaf] instead of the leaves themselves.
+  void RecursivelyIterateBatch(SplitKernel kernel, int lanes, int depth,
+                               size_t length, const float* source,
+                               float* spare, int* leaf, int count,
+                               size_t* offset, bool energy,
+                               float* const* results) const noexcept;
 
   static void RecursivelyIterate(WaveletType type, int order,
                                  size_t length, TreeFingerprint* tree,
@@ -30,8 +30,14 @@
 
 
 #include "src/primitives/window.h"
+#include <fftf/api.h>
+#include <simd/memory.h>
 #include <cmath>
+#include <map>
+#include <mutex>
+#include <tuple>
 #include <unordered_map>
+#include "src/fftf_wisdom.h"
 #include "src/parameterizable_base.h"
 
 namespace sound_feature_extraction {
@@ -93,6 +99,48 @@ float WindowElement(WindowType type, int length, int index) {
   return 0.0f;
 }
 
+WindowTable SharedWindow(WindowType type, int length, bool predft) {
+  typedef std::tuple<WindowType, int, bool> Key;
+  static std::mutex mutex;
+  static std::map<Key, std::weak_ptr<const float>> cache;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  auto& cached = cache[Key(type, length, predft)];
+  auto table = cached.lock();
+  if (table) {
+    return table;
+  }
+  // Drop the tables which are not used anymore
+  for (auto it = cache.begin(); it != cache.end();) {
+    if (it->second.expired() && &it->second != &cached) {
+      it = cache.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  float* contents = mallocf(length);
+  int windowLength = predft? (length - 2) / 2 : length;
+  for (int i = 0; i < windowLength; i++) {
+    contents[i] = WindowElement(type, windowLength, i);
+  }
+  if (predft) {
+    auto backend = FFTFWisdom::Instance().Select(
+        FFTF_TYPE_REAL, FFTF_DIRECTION_FORWARD, windowLength, 1);
+    auto fftPlan = std::unique_ptr<FFTFInstance, void (*)(FFTFInstance *)>(
+        fftf_init(
+            FFTF_TYPE_REAL, FFTF_DIRECTION_FORWARD,
+            FFTF_DIMENSION_1D,
+            &windowLength, FFTF_NO_OPTIONS,
+            contents, contents),
+        fftf_destroy);
+    backend.unlock();
+    fftf_calc(fftPlan.get());
+  }
+  table = WindowTable(contents, free);
+  cached = table;
+  return table;
+}
+
 }  // namespace sound_feature_extraction
 
 namespace std {
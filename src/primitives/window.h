@@ -31,6 +31,7 @@
 #ifndef SRC_PRIMITIVES_WINDOW_H_
 #define SRC_PRIMITIVES_WINDOW_H_
 
+#include <memory>
 #include <string>
 #include "src/parameterizable_base.h"
 
@@ -55,6 +56,19 @@ WindowType Parse(const std::string& value, identity<WindowType>);
 /// @return The requested window element.
 float WindowElement(WindowType type, int length, int index);
 
+/// @brief Immutable window contents shared between the transforms.
+typedef std::shared_ptr<const float> WindowTable;
+
+/// @brief Returns the contents of the window from the process-wide cache,
+/// calculating them on the first request.
+/// @param type The window type.
+/// @param length The number of floats in the table.
+/// @param predft If true, the table keeps the real DFT of the window of length
+/// (length - 2) / 2 instead of the window itself.
+/// @note The cache holds weak references, so a table is freed as soon as the
+/// last transform which uses it is destroyed.
+WindowTable SharedWindow(WindowType type, int length, bool predft = false);
+
 }  // namespace sound_feature_extraction
 
 namespace std {
@@ -0,0 +1,67 @@
+/*! @file probes.h
+ *  @brief USDT probes for bpftrace, perf and SystemTap.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#ifndef SRC_PROBES_H_
+#define SRC_PROBES_H_
+
+/// @brief Places the static probe sfe:name with the integer or pointer
+/// arguments into the library, e.g.
+/// bpftrace -e 'usdt:libSoundFeatureExtraction.so:sfe:node__end {
+///   @[str(arg1)] = hist(nsecs - @start[tid]); }'
+/// @details A disabled probe is a single nop and its arguments are merely
+/// kept in registers or memory, so they must be cheap to evaluate. Without
+/// <sys/sdt.h> (HAVE_SDT, see configure --disable-probes) the probes are
+/// compiled out.
+#ifdef HAVE_SDT
+
+#include <sys/sdt.h>
+
+#define SFE_PROBE0(name) STAP_PROBE(sfe, name)
+#define SFE_PROBE1(name, a1) STAP_PROBE1(sfe, name, a1)
+#define SFE_PROBE2(name, a1, a2) STAP_PROBE2(sfe, name, a1, a2)
+#define SFE_PROBE3(name, a1, a2, a3) STAP_PROBE3(sfe, name, a1, a2, a3)
+#define SFE_PROBE4(name, a1, a2, a3, a4) \
+  STAP_PROBE4(sfe, name, a1, a2, a3, a4)
+#define SFE_PROBE5(name, a1, a2, a3, a4, a5) \
+  STAP_PROBE5(sfe, name, a1, a2, a3, a4, a5)
+
+#else
+
+#define SFE_PROBE0(name) do {} while (false)
+#define SFE_PROBE1(name, a1) do {} while (false)
+#define SFE_PROBE2(name, a1, a2) do {} while (false)
+#define SFE_PROBE3(name, a1, a2, a3) do {} while (false)
+#define SFE_PROBE4(name, a1, a2, a3, a4) do {} while (false)
+#define SFE_PROBE5(name, a1, a2, a3, a4, a5) do {} while (false)
+
+#endif
+
+#endif  // SRC_PROBES_H_
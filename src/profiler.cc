@@ -0,0 +1,232 @@
+/*! @file profiler.cc
+ *  @brief Per node execution statistics and Chrome trace events.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#include "src/profiler.h"
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include "src/thread_pool.h"
+
+namespace sound_feature_extraction {
+
+Profiler::Histogram::Histogram() noexcept
+    : counts_(kBucketsCount, 0), count_(0),
+      sum_(Clock::duration::zero()) {
+}
+
+int Profiler::Histogram::Bucket(uint64_t nanoseconds) noexcept {
+  if (nanoseconds < kSubBuckets) {
+    return nanoseconds;
+  }
+  int exponent = 63 - __builtin_clzll(nanoseconds);
+  int sub = (nanoseconds >> (exponent - kSubBucketsLog)) & (kSubBuckets - 1);
+  return (exponent - kSubBucketsLog + 1) * kSubBuckets + sub;
+}
+
+uint64_t Profiler::Histogram::UpperBound(int bucket) noexcept {
+  if (bucket < kSubBuckets) {
+    return bucket;
+  }
+  int shift = bucket / kSubBuckets - 1;
+  uint64_t lower = static_cast<uint64_t>(
+      kSubBuckets + bucket % kSubBuckets) << shift;
+  return lower + (1ull << shift) - 1;
+}
+
+void Profiler::Histogram::Add(Clock::duration value) noexcept {
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      value).count();
+  counts_[Bucket(ns > 0? ns : 0)]++;
+  count_++;
+  sum_ += value;
+}
+
+size_t Profiler::Histogram::Count() const noexcept {
+  return count_;
+}
+
+Profiler::Clock::duration Profiler::Histogram::Sum() const noexcept {
+  return sum_;
+}
+
+Profiler::Clock::duration Profiler::Histogram::Percentile(
+    float q) const noexcept {
+  if (count_ == 0) {
+    return Clock::duration::zero();
+  }
+  size_t target = std::ceil(q * count_);
+  if (target == 0) {
+    target = 1;
+  }
+  size_t cumulative = 0;
+  for (int i = 0; i < kBucketsCount; i++) {
+    cumulative += counts_[i];
+    if (cumulative >= target) {
+      return std::chrono::duration_cast<Clock::duration>(
+          std::chrono::nanoseconds(UpperBound(i)));
+    }
+  }
+  return std::chrono::duration_cast<Clock::duration>(
+      std::chrono::nanoseconds(UpperBound(kBucketsCount - 1)));
+}
+
+Profiler::Profiler(bool trace) noexcept
+    : trace_(trace), epoch_(Clock::now()) {
+}
+
+bool Profiler::trace() const noexcept {
+  return trace_;
+}
+
+void Profiler::AddNodeSample(const void* key, const std::string& name,
+                             Clock::time_point start,
+                             Clock::time_point finish,
+                             size_t bytesIn, size_t bytesOut,
+                             int slice) noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = node_indices_.find(key);
+  if (it == node_indices_.end()) {
+    it = node_indices_.insert(std::make_pair(key, nodes_.size())).first;
+    nodes_.push_back(std::make_pair(name, NodeStatistics { Histogram(), 0, 0 }));
+  }
+  auto& stats = nodes_[it->second].second;
+  stats.Durations.Add(finish - start);
+  stats.BytesIn += bytesIn;
+  stats.BytesOut += bytesOut;
+  if (trace_) {
+    AddEvent({ NameIndex(name), false, CurrentThread(),
+               ThreadPool::CurrentThreadIndex(), slice, start,
+               finish - start, bytesIn, bytesOut });
+  }
+}
+
+void Profiler::AddRegion(const std::string& name, Clock::time_point start,
+                         Clock::time_point finish) noexcept {
+  if (!trace_) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  AddEvent({ NameIndex(name), true, CurrentThread(),
+             ThreadPool::CurrentThreadIndex(), -1, start, finish - start,
+             0, 0 });
+}
+
+void Profiler::AddEvent(const TraceEvent& event) noexcept {
+  if (events_.size() < kMaxTraceEvents) {
+    events_.push_back(event);
+  }
+}
+
+int Profiler::NameIndex(const std::string& name) noexcept {
+  auto it = name_indices_.find(name);
+  if (it != name_indices_.end()) {
+    return it->second;
+  }
+  names_.push_back(name);
+  name_indices_[name] = names_.size() - 1;
+  return names_.size() - 1;
+}
+
+int Profiler::CurrentThread() noexcept {
+  return syscall(SYS_gettid);
+}
+
+std::string Profiler::Escape(const std::string& str) noexcept {
+  std::string ret;
+  for (char c : str) {
+    if (c == '"' || c == '\\') {
+      ret += '\\';
+      ret += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char code[8];
+      snprintf(code, sizeof(code), "\\u%04x", c);
+      ret += code;
+    } else {
+      ret += c;
+    }
+  }
+  return ret;
+}
+
+std::vector<std::pair<std::string, Profiler::NodeStatistics>>
+Profiler::Statistics() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return nodes_;
+}
+
+void Profiler::SaveTrace(const std::string& fileName) const {
+  std::ofstream file(fileName);
+  if (!file) {
+    throw FailedToWriteTraceException(fileName);
+  }
+  auto us = [](Clock::duration value) {
+    return std::chrono::duration_cast<std::chrono::duration<double,
+        std::micro>>(value).count();
+  };
+  int pid = getpid();
+  std::lock_guard<std::mutex> lock(mutex_);
+  file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  for (size_t i = 0; i < events_.size(); i++) {
+    auto& event = events_[i];
+    if (i > 0) {
+      file << ',';
+    }
+    file << "\n{\"name\":\"" << Escape(names_[event.Name]) << "\","
+         << "\"cat\":\"" << (event.Region? "region" : "transform") << "\","
+         << "\"ph\":\"X\",\"pid\":" << pid << ",\"tid\":" << event.Thread
+         << ",\"ts\":" << us(event.Start - epoch_)
+         << ",\"dur\":" << us(event.Duration)
+         << ",\"args\":{\"pool_thread\":" << event.PoolThread;
+    if (!event.Region) {
+      file << ",\"slice\":" << event.Slice
+           << ",\"bytes_in\":" << event.BytesIn
+           << ",\"bytes_out\":" << event.BytesOut;
+    }
+    file << "}}";
+  }
+  file << "\n]}\n";
+  if (!file) {
+    throw FailedToWriteTraceException(fileName);
+  }
+}
+
+void Profiler::Reset() noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  node_indices_.clear();
+  nodes_.clear();
+  names_.clear();
+  name_indices_.clear();
+  events_.clear();
+}
+
+}  // namespace sound_feature_extraction
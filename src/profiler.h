@@ -0,0 +1,157 @@
+/*! @file profiler.h
+ *  @brief Per node execution statistics and Chrome trace events.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#ifndef SRC_PROFILER_H_
+#define SRC_PROFILER_H_
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "src/exceptions.h"
+
+namespace sound_feature_extraction {
+
+class FailedToWriteTraceException : public ExceptionBase {
+ public:
+  explicit FailedToWriteTraceException(const std::string& file)
+  : ExceptionBase("Failed to write the trace events to \"" + file + "\".") {
+  }
+};
+
+/// @brief Collects the execution times and the processed bytes of each
+/// transform tree node and, optionally, the Chrome trace events
+/// (chrome://tracing, "Trace Event Format") of every execution.
+/// @note All the methods are thread safe, so that the concurrent execution
+/// contexts may share the same profiler.
+class Profiler {
+ public:
+  typedef std::chrono::high_resolution_clock Clock;
+
+  /// @brief Log-linear histogram of durations: each power of two interval of
+  /// nanoseconds is split into 2^kSubBucketsLog buckets, so the percentiles
+  /// are accurate up to 1/8 of the value and the memory is constant.
+  class Histogram {
+   public:
+    Histogram() noexcept;
+
+    void Add(Clock::duration value) noexcept;
+    size_t Count() const noexcept;
+    Clock::duration Sum() const noexcept;
+    /// @brief Returns the upper bound of the bucket where the q-th quantile
+    /// (0 <= q <= 1) falls.
+    Clock::duration Percentile(float q) const noexcept;
+
+   private:
+    static constexpr int kSubBucketsLog = 3;
+    static constexpr int kSubBuckets = 1 << kSubBucketsLog;
+    static constexpr int kBucketsCount = (64 - kSubBucketsLog + 1) *
+        kSubBuckets;
+
+    static int Bucket(uint64_t nanoseconds) noexcept;
+    static uint64_t UpperBound(int bucket) noexcept;
+
+    std::vector<uint32_t> counts_;
+    size_t count_;
+    Clock::duration sum_;
+  };
+
+  struct NodeStatistics {
+    Histogram Durations;
+    /// @brief The total size of the input buffers.
+    size_t BytesIn;
+    /// @brief The total size of the output buffers.
+    size_t BytesOut;
+  };
+
+  /// @brief The maximal number of the stored trace events; the later events
+  /// are dropped, so that a forgotten trace does not exhaust the memory.
+  static constexpr size_t kMaxTraceEvents = 1 << 20;
+
+  explicit Profiler(bool trace) noexcept;
+
+  bool trace() const noexcept;
+
+  /// @brief Records a single run of the transform of the node identified by
+  /// key. The statistics are reported under name, which must be the same
+  /// for the same key.
+  /// @param slice The index of the slice of the cache optimized cycle, or -1.
+  void AddNodeSample(const void* key, const std::string& name,
+                     Clock::time_point start, Clock::time_point finish,
+                     size_t bytesIn, size_t bytesOut, int slice) noexcept;
+  /// @brief Records the trace event of a whole execution or of a parallel
+  /// region, without the statistics.
+  void AddRegion(const std::string& name, Clock::time_point start,
+                 Clock::time_point finish) noexcept;
+
+  /// @brief Returns the statistics of the nodes in the order of their first
+  /// samples.
+  std::vector<std::pair<std::string, NodeStatistics>> Statistics() const;
+  /// @brief Writes the recorded events in JSON Trace Event Format.
+  void SaveTrace(const std::string& fileName) const;
+  void Reset() noexcept;
+
+ private:
+  struct TraceEvent {
+    /// @brief The index in names_.
+    int Name;
+    bool Region;
+    int Thread;
+    /// @brief ThreadPool::CurrentThreadIndex().
+    int PoolThread;
+    int Slice;
+    Clock::time_point Start;
+    Clock::duration Duration;
+    size_t BytesIn;
+    size_t BytesOut;
+  };
+
+  void AddEvent(const TraceEvent& event) noexcept;
+  int NameIndex(const std::string& name) noexcept;
+  static int CurrentThread() noexcept;
+  static std::string Escape(const std::string& str) noexcept;
+
+  const bool trace_;
+  const Clock::time_point epoch_;
+  mutable std::mutex mutex_;
+  /// @brief Maps the node keys to the indices in nodes_.
+  std::unordered_map<const void*, size_t> node_indices_;
+  std::vector<std::pair<std::string, NodeStatistics>> nodes_;
+  std::vector<std::string> names_;
+  std::unordered_map<std::string, int> name_indices_;
+  std::vector<TraceEvent> events_;
+};
+
+}  // namespace sound_feature_extraction
+#endif  // SRC_PROFILER_H_
@@ -0,0 +1,118 @@
+/*! @file realtime.cc
+ *  @brief Real-time safe execution of the transform trees.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#include "src/realtime.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <sys/mman.h>
+
+namespace sound_feature_extraction {
+
+namespace {
+
+thread_local int depth = 0;
+thread_local int checked_depth = 0;
+std::atomic<size_t> violations(0);
+std::atomic<const char*> last_violation(nullptr);
+#ifdef DEBUG
+std::atomic<bool> trap_violations(true);
+#else
+std::atomic<bool> trap_violations(false);
+#endif
+
+}  // namespace
+
+RealtimeSection::RealtimeSection(bool checked) noexcept
+    : checked_(checked) {
+  depth++;
+  if (checked) {
+    checked_depth++;
+  }
+}
+
+RealtimeSection::~RealtimeSection() {
+  depth--;
+  if (checked_) {
+    checked_depth--;
+  }
+}
+
+bool RealtimeSection::Active() noexcept {
+  return depth > 0;
+}
+
+void RealtimeSection::Check(const char* operation) noexcept {
+  if (checked_depth == 0) {
+    return;
+  }
+  violations.fetch_add(1, std::memory_order_relaxed);
+  last_violation.store(operation, std::memory_order_relaxed);
+  if (trap_violations.load(std::memory_order_relaxed)) {
+    fprintf(stderr, "Real-time section violation: %s\n", operation);
+    std::abort();
+  }
+}
+
+size_t RealtimeSection::Violations() noexcept {
+  return violations.load(std::memory_order_relaxed);
+}
+
+const char* RealtimeSection::LastViolation() noexcept {
+  return last_violation.load(std::memory_order_relaxed);
+}
+
+bool RealtimeSection::trap() noexcept {
+  return trap_violations;
+}
+
+void RealtimeSection::set_trap(bool value) noexcept {
+  trap_violations = value;
+}
+
+MemoryLock::MemoryLock(const void* ptr, size_t size) noexcept
+    : ptr_(ptr), size_(size), locked_(false) {
+  if (ptr != nullptr && size > 0) {
+    locked_ = mlock(ptr, size) == 0;
+  }
+}
+
+MemoryLock::~MemoryLock() {
+  if (locked_) {
+    munlock(ptr_, size_);
+  }
+}
+
+bool MemoryLock::locked() const noexcept {
+  return locked_;
+}
+
+}  // namespace sound_feature_extraction
@@ -0,0 +1,103 @@
+/*! @file realtime.h
+ *  @brief Real-time safe execution of the transform trees.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#ifndef SRC_REALTIME_H_
+#define SRC_REALTIME_H_
+
+#include <cstddef>
+
+namespace sound_feature_extraction {
+
+/// @brief Marks the calling thread as executing a real-time section, e.g.
+/// TransformTree::Execute() in the real-time mode on an audio callback
+/// thread, until destroyed. The sections nest.
+/// @details The operations which are not real-time safe (allocating from
+/// MemoryPool, waiting for an executor, mprotect(), etc.) call Check(),
+/// which counts them as violations and aborts if trap() is set. ThreadPool
+/// executes the parallel loops inline and the log messages are dropped
+/// while a section is active.
+class RealtimeSection {
+ public:
+  /// @param checked False means that the section only executes the loops
+  /// inline and drops the log messages, without counting the violations,
+  /// e.g. to prepare the real-time execution.
+  explicit RealtimeSection(bool checked = true) noexcept;
+  ~RealtimeSection();
+
+  RealtimeSection(const RealtimeSection&) = delete;
+  RealtimeSection& operator=(const RealtimeSection&) = delete;
+
+  /// @brief Indicates whether the calling thread is in a section.
+  static bool Active() noexcept;
+
+  /// @brief Reports the operation if the calling thread is in a checked
+  /// section.
+  /// @param operation The static string which names it.
+  static void Check(const char* operation) noexcept;
+
+  /// @brief The number of the violations reported so far by all threads.
+  static size_t Violations() noexcept;
+
+  /// @brief The operation of the last violation or nullptr.
+  static const char* LastViolation() noexcept;
+
+  /// @brief Indicates whether Check() prints the operation and aborts.
+  /// Enabled in the debug builds by default.
+  static bool trap() noexcept;
+  static void set_trap(bool value) noexcept;
+
+ private:
+  bool checked_;
+};
+
+/// @brief Locks the pages of the memory block in RAM with mlock() until
+/// destroyed, so that touching them never faults.
+class MemoryLock {
+ public:
+  MemoryLock(const void* ptr, size_t size) noexcept;
+  ~MemoryLock();
+
+  MemoryLock(const MemoryLock&) = delete;
+  MemoryLock& operator=(const MemoryLock&) = delete;
+
+  /// @brief Indicates whether mlock() succeeded, it fails e.g. beyond
+  /// RLIMIT_MEMLOCK.
+  bool locked() const noexcept;
+
+ private:
+  const void* ptr_;
+  size_t size_;
+  bool locked_;
+};
+
+}  // namespace sound_feature_extraction
+
+#endif  // SRC_REALTIME_H_
@@ -48,6 +48,10 @@
 inline int omp_get_max_threads() noexcept {
   return 1;
 }
+
+inline int omp_get_thread_num() noexcept {
+  return 0;
+}
 #endif
 
 #endif  // SRC_SAFE_OMP_H_
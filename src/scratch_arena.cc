@@ -0,0 +1,172 @@
+/*! @file scratch_arena.cc
+ *  @brief Per-thread temporary memory shared by all the transforms.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#include "src/scratch_arena.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <memory>
+#include <vector>
+#include "src/memory_pool.h"
+
+namespace sound_feature_extraction {
+
+constexpr size_t ScratchArena::kAlignment;
+
+namespace {
+
+std::atomic<size_t> total_size(0);
+
+struct Block {
+  std::shared_ptr<void> Data;
+  size_t Size;
+  size_t Used;
+};
+
+/// @brief The stack of the blocks of a thread.
+struct ThreadArena {
+  ThreadArena() : Leased(0), Peak(0) {
+  }
+
+  ~ThreadArena() {
+    Clear();
+  }
+
+  void Clear() noexcept {
+    for (auto& block : Blocks) {
+      total_size -= block.Size * sizeof(float);
+    }
+    Blocks.clear();
+  }
+
+  std::vector<Block> Blocks;
+  /// @brief The floats taken by the leases.
+  size_t Leased;
+  /// @brief The maximal Leased so far.
+  size_t Peak;
+};
+
+thread_local ThreadArena arena;
+thread_local ScratchArena::FixedBlock* fixed_block = nullptr;
+
+}  // namespace
+
+ScratchArena::FixedBlock::FixedBlock(float* data, size_t size) noexcept
+    : data_(data), size_(data != nullptr? size : 0), used_(0), leased_(0),
+      peak_(0), previous_(fixed_block) {
+  fixed_block = this;
+}
+
+ScratchArena::FixedBlock::~FixedBlock() {
+  assert(leased_ == 0);
+  fixed_block = previous_;
+}
+
+ScratchArena::Lease ScratchArena::Acquire(size_t size) noexcept {
+  size = (std::max(size, size_t(1)) + kAlignment - 1) & ~(kAlignment - 1);
+  auto fixed = fixed_block;
+  if (fixed != nullptr) {
+    fixed->leased_ += size;
+    fixed->peak_ = std::max(fixed->peak_, fixed->leased_);
+    if (fixed->size_ - fixed->used_ >= size) {
+      float* ptr = fixed->data_ + fixed->used_;
+      fixed->used_ += size;
+      return Lease(ptr, size);
+    }
+  }
+  if (arena.Blocks.empty() ||
+      arena.Blocks.back().Size - arena.Blocks.back().Used < size) {
+    auto data = MemoryPool::Instance().Acquire(size * sizeof(float));
+    if (!data) {
+      if (fixed != nullptr) {
+        fixed->leased_ -= size;
+      }
+      return Lease(nullptr, 0);
+    }
+    arena.Blocks.push_back({ data, size, 0 });
+    total_size += size * sizeof(float);
+  }
+  auto& block = arena.Blocks.back();
+  float* ptr = static_cast<float*>(block.Data.get()) + block.Used;
+  block.Used += size;
+  arena.Leased += size;
+  arena.Peak = std::max(arena.Peak, arena.Leased);
+  return Lease(ptr, size);
+}
+
+void ScratchArena::Release(float* data, size_t size) noexcept {
+  auto fixed = fixed_block;
+  if (fixed != nullptr) {
+    fixed->leased_ -= size;
+    if (data >= fixed->data_ && data < fixed->data_ + fixed->size_) {
+      fixed->used_ -= size;
+      return;
+    }
+  }
+  assert(!arena.Blocks.empty() && arena.Blocks.back().Used >= size);
+  arena.Blocks.back().Used -= size;
+  arena.Leased -= size;
+  if (arena.Blocks.back().Used == 0 && arena.Blocks.size() > 1) {
+    total_size -= arena.Blocks.back().Size * sizeof(float);
+    arena.Blocks.pop_back();
+  }
+  if (arena.Leased == 0 && arena.Blocks.size() == 1 &&
+      arena.Blocks[0].Size < arena.Peak) {
+    // The overflows are merged, so that the next time everything fits
+    arena.Clear();
+    auto data = MemoryPool::Instance().Acquire(arena.Peak * sizeof(float));
+    if (data) {
+      arena.Blocks.push_back({ data, arena.Peak, 0 });
+      total_size += arena.Peak * sizeof(float);
+    }
+  }
+}
+
+size_t ScratchArena::ThreadSize() noexcept {
+  size_t size = 0;
+  for (auto& block : arena.Blocks) {
+    size += block.Size * sizeof(float);
+  }
+  return size;
+}
+
+size_t ScratchArena::TotalSize() noexcept {
+  return total_size;
+}
+
+void ScratchArena::Trim() noexcept {
+  if (arena.Leased == 0) {
+    arena.Clear();
+    arena.Peak = 0;
+  }
+}
+
+}  // namespace sound_feature_extraction
@@ -0,0 +1,137 @@
+/*! @file scratch_arena.h
+ *  @brief Per-thread temporary memory shared by all the transforms.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#ifndef SRC_SCRATCH_ARENA_H_
+#define SRC_SCRATCH_ARENA_H_
+
+#include <cstddef>
+
+namespace sound_feature_extraction {
+
+/// @brief The temporary buffers of the transforms, which live only during
+/// a single Do() call, e.g. the intermediate levels of a wavelet transform.
+/// @details Each thread owns a stack of blocks taken from MemoryPool, and
+/// the leases are pushed on top of it and popped in the reverse order.
+/// If a lease does not fit, another block is added; as soon as the stack
+/// becomes empty, the blocks are merged into one of the peak size. Thus
+/// a thread keeps only its largest simultaneous need instead of a scratch
+/// per transform, per configuration and per thread.
+/// @note The leases must be released by the thread which took them, in
+/// the reverse order.
+class ScratchArena {
+ public:
+  /// @brief Grants the floats until destroyed.
+  class Lease {
+   public:
+    Lease(float* data, size_t size) noexcept : data_(data), size_(size) {
+    }
+
+    Lease(Lease&& other) noexcept : data_(other.data_), size_(other.size_) {
+      other.data_ = nullptr;
+    }
+
+    Lease(const Lease&) = delete;
+    Lease& operator=(const Lease&) = delete;
+
+    ~Lease() {
+      if (data_ != nullptr) {
+        ScratchArena::Release(data_, size_);
+      }
+    }
+
+    float* get() const noexcept {
+      return data_;
+    }
+
+   private:
+    float* data_;
+    size_t size_;
+  };
+
+  /// @brief Serves the leases of the calling thread from the given block
+  /// until destroyed, e.g. from the memory which a real-time TransformTree
+  /// locked beforehand. The leases which do not fit are taken from
+  /// the thread's stack as usual. The scopes nest.
+  /// @note The leases taken in the scope must be released in it.
+  class FixedBlock {
+   public:
+    /// @param data The block aligned to kAlignment floats, may be nullptr
+    /// to only measure peak().
+    /// @param size The number of floats in the block.
+    FixedBlock(float* data, size_t size) noexcept;
+    ~FixedBlock();
+
+    FixedBlock(const FixedBlock&) = delete;
+    FixedBlock& operator=(const FixedBlock&) = delete;
+
+    /// @brief The maximal number of floats leased simultaneously in
+    /// the scope, including the leases which did not fit.
+    size_t peak() const noexcept {
+      return peak_;
+    }
+
+   private:
+    friend class ScratchArena;
+
+    float* data_;
+    size_t size_;
+    /// @brief The floats of the block taken by the leases.
+    size_t used_;
+    /// @brief The floats taken by all the leases of the scope.
+    size_t leased_;
+    size_t peak_;
+    FixedBlock* previous_;
+  };
+
+  /// @brief Takes size aligned floats from the calling thread's stack.
+  /// @return The lease with nullptr if the allocation failed.
+  static Lease Acquire(size_t size) noexcept;
+
+  /// @brief The size of the blocks of the calling thread, in bytes.
+  static size_t ThreadSize() noexcept;
+
+  /// @brief The size of the blocks of all the threads, in bytes.
+  static size_t TotalSize() noexcept;
+
+  /// @brief Returns the blocks of the calling thread to MemoryPool if no
+  /// leases are taken.
+  static void Trim() noexcept;
+
+  /// @brief The leases start at the multiples of this number of floats.
+  static constexpr size_t kAlignment = 16;
+
+ private:
+  static void Release(float* data, size_t size) noexcept;
+};
+
+}  // namespace sound_feature_extraction
+
+#endif  // SRC_SCRATCH_ARENA_H_
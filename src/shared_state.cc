@@ -0,0 +1,98 @@
+/*! @file shared_state.cc
+ *  @brief Process-wide cache of the immutable state of the transforms.
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#include "src/shared_state.h"
+#include <mutex>
+#include <unordered_map>
+
+namespace sound_feature_extraction {
+
+namespace {
+
+std::mutex& CacheMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+std::unordered_map<std::string, std::weak_ptr<const void>>& Cache() {
+  static std::unordered_map<std::string, std::weak_ptr<const void>> cache;
+  return cache;
+}
+
+}  // namespace
+
+namespace internal {
+
+std::shared_ptr<const void> FindSharedState(
+    const std::string& key,
+    const std::function<std::shared_ptr<const void>()>& create) {
+  {
+    std::lock_guard<std::mutex> lock(CacheMutex());
+    auto it = Cache().find(key);
+    if (it != Cache().end()) {
+      auto state = it->second.lock();
+      if (state) {
+        return state;
+      }
+    }
+  }
+  // Building the state may be long, so the other keys are not blocked;
+  // if another thread has built the same state meanwhile, it wins
+  auto state = create();
+  std::lock_guard<std::mutex> lock(CacheMutex());
+  auto& cached = Cache()[key];
+  auto existing = cached.lock();
+  if (existing) {
+    return existing;
+  }
+  // Drop the states which are not used anymore
+  for (auto it = Cache().begin(); it != Cache().end();) {
+    if (it->second.expired() && &it->second != &cached) {
+      it = Cache().erase(it);
+    } else {
+      ++it;
+    }
+  }
+  cached = state;
+  return state;
+}
+
+}  // namespace internal
+
+size_t SharedStatesCount() noexcept {
+  std::lock_guard<std::mutex> lock(CacheMutex());
+  size_t count = 0;
+  for (auto& state : Cache()) {
+    count += !state.second.expired();
+  }
+  return count;
+}
+
+}  // namespace sound_feature_extraction
@@ -0,0 +1,68 @@
+/*! @file shared_state.h
+ *  @brief Process-wide cache of the immutable state of the transforms.
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#ifndef SRC_SHARED_STATE_H_
+#define SRC_SHARED_STATE_H_
+
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace sound_feature_extraction {
+
+namespace internal {
+
+std::shared_ptr<const void> FindSharedState(
+    const std::string& key,
+    const std::function<std::shared_ptr<const void>()>& create);
+
+}  // namespace internal
+
+/// @brief Returns the immutable state from the process-wide cache, calling
+/// create() on the first request with the key. The state must depend only
+/// on the key, which is usually Transform::StateKey(), so that the
+/// transforms of the different configurations share it read-only.
+/// @note The cache holds weak references, so the state is freed as soon as
+/// the last transform which uses it is destroyed, see SharedWindow().
+/// create() is called without holding the lock.
+template <typename T, typename F>
+std::shared_ptr<const T> SharedState(const std::string& key,
+                                     const F& create) {
+  return std::static_pointer_cast<const T>(internal::FindSharedState(
+      key, [&create]() {
+        return std::shared_ptr<const void>(create());
+      }));
+}
+
+/// @brief Returns the number of the states in the cache which are alive.
+size_t SharedStatesCount() noexcept;
+
+}  // namespace sound_feature_extraction
+#endif  // SRC_SHARED_STATE_H_
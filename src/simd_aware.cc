@@ -1,5 +1,6 @@
 /*! @file simd_aware.cc
- *  @brief sound_feature_extraction::SimdAware::useSimd_ initialization.
+ *  @brief sound_feature_extraction::SimdAware initialization and the CPU
+ *  instruction sets detection.
  *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
  *  @version 1.0
  *
@@ -48,7 +49,83 @@ static bool under_valgrind() noexcept {
 }
 #pragma GCC diagnostic pop
 
+static unsigned DetectInstructionSets() noexcept {
+  unsigned res = 1 << static_cast<int>(InstructionSet::kScalar);
+#ifdef SIMD_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("sse4.1")) {
+    res |= 1 << static_cast<int>(InstructionSet::kSSE41);
+  }
+  if (__builtin_cpu_supports("avx")) {
+    res |= 1 << static_cast<int>(InstructionSet::kAVX);
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    res |= 1 << static_cast<int>(InstructionSet::kAVX2);
+  }
+  if (__builtin_cpu_supports("avx512f") &&
+      __builtin_cpu_supports("avx512bw") &&
+      __builtin_cpu_supports("avx512vl")) {
+    res |= 1 << static_cast<int>(InstructionSet::kAVX512);
+  }
+#elif defined(SIMD_NEON)
+  res |= 1 << static_cast<int>(InstructionSet::kNEON);
+#endif
+  return res;
+}
+
+static const unsigned kSupportedInstructionSets = DetectInstructionSets();
+
+const char* InstructionSetName(InstructionSet value) noexcept {
+  switch (value) {
+    case InstructionSet::kScalar:
+      return "scalar";
+    case InstructionSet::kNEON:
+      return "NEON";
+    case InstructionSet::kSSE41:
+      return "SSE4.1";
+    case InstructionSet::kAVX:
+      return "AVX";
+    case InstructionSet::kAVX2:
+      return "AVX2";
+    case InstructionSet::kAVX512:
+      return "AVX-512";
+  }
+  return "";
+}
+
 bool SimdAware::use_simd_ = !under_valgrind();
+InstructionSet SimdAware::max_instruction_set_ = InstructionSet::kAVX512;
+
+bool SimdAware::IsSupported(InstructionSet value) noexcept {
+  return kSupportedInstructionSets & (1 << static_cast<int>(value));
+}
+
+InstructionSet SimdAware::instruction_set() noexcept {
+  for (int isa = static_cast<int>(InstructionSet::kAVX512); isa > 0; isa--) {
+    if (IsEnabled(static_cast<InstructionSet>(isa))) {
+      return static_cast<InstructionSet>(isa);
+    }
+  }
+  return InstructionSet::kScalar;
+}
+
+InstructionSet SimdAware::SimdInstructionSet() const noexcept {
+  if (!use_simd()) {
+    return InstructionSet::kScalar;
+  }
+#ifdef __AVX__
+  return InstructionSet::kAVX;
+#elif defined(__ARM_NEON__)
+  return InstructionSet::kNEON;
+#else
+  return InstructionSet::kScalar;
+#endif
+}
 
 }  // namespace sound_feature_extraction
 
+int simd_instruction_set_enabled(int value) {
+  return sound_feature_extraction::SimdAware::IsEnabled(
+      static_cast<sound_feature_extraction::InstructionSet>(value));
+}
+
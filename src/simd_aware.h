@@ -31,23 +31,98 @@
 #ifndef SRC_SIMD_AWARE_H_
 #define SRC_SIMD_AWARE_H_
 
+#include <cstddef>
+#include "src/execution_overrides.h"
+#include "src/simd_dispatch.h"
+
 void set_use_simd(int /* value */);
 
 namespace sound_feature_extraction {
 
+/// @brief The instruction sets of the SIMD kernels, ordered by the vector
+/// width.
+enum class InstructionSet {
+  kScalar = SIMD_INSTRUCTION_SET_SCALAR,
+  kNEON = SIMD_INSTRUCTION_SET_NEON,
+  kSSE41 = SIMD_INSTRUCTION_SET_SSE41,
+  kAVX = SIMD_INSTRUCTION_SET_AVX,
+  kAVX2 = SIMD_INSTRUCTION_SET_AVX2,
+  kAVX512 = SIMD_INSTRUCTION_SET_AVX512
+};
+
+const char* InstructionSetName(InstructionSet value) noexcept;
+
+/// @brief A SIMD kernel implementation for the specified instruction set.
+template <typename F>
+struct SimdKernel {
+  InstructionSet Isa;
+  F Function;
+};
+
 class SimdAware {
   friend void ::set_use_simd(int /* value */);
  public:
+  virtual ~SimdAware() = default;
+
+  /// @brief Returns the value of set_use_simd() unless the current
+  /// ExecutionOverrides replace it.
   static bool use_simd() noexcept {
+    auto overrides = CurrentExecutionOverrides();
+    if (overrides != nullptr && overrides->UseSimd >= 0) {
+      return overrides->UseSimd;
+    }
     return use_simd_;
   }
 
+  /// @brief Returns true if the CPU supports value, as detected at startup.
+  static bool IsSupported(InstructionSet value) noexcept;
+
+  /// @brief Returns true if the SIMD kernels for value are allowed to run:
+  /// the CPU supports them, use_simd() is true and value does not exceed
+  /// max_instruction_set().
+  static bool IsEnabled(InstructionSet value) noexcept {
+    return value == InstructionSet::kScalar ||
+        (use_simd() && value <= max_instruction_set_ &&
+         IsSupported(value));
+  }
+
+  /// @brief Returns the widest enabled instruction set.
+  static InstructionSet instruction_set() noexcept;
+
+  static InstructionSet max_instruction_set() noexcept {
+    return max_instruction_set_;
+  }
+
+  /// @brief Disables the kernels wider than value.
+  static void set_max_instruction_set(InstructionSet value) noexcept {
+    max_instruction_set_ = value;
+  }
+
+  /// @brief Picks the first enabled kernel. The kernels must be listed from
+  /// the most to the least preferable and end with the kScalar one.
+  template <typename F, size_t N>
+  static const SimdKernel<F>& Dispatch(const SimdKernel<F> (&kernels)[N])
+      noexcept {
+    static_assert(N > 0, "There must be at least the scalar kernel");
+    for (size_t i = 0; i < N - 1; i++) {
+      if (IsEnabled(kernels[i].Isa)) {
+        return kernels[i];
+      }
+    }
+    return kernels[N - 1];
+  }
+
+  /// @brief Returns the instruction set which does the work of this object.
+  /// The default is the one of the #ifdef code paths chosen at compile time.
+  virtual InstructionSet SimdInstructionSet() const noexcept;
+
  protected:
   static void set_use_simd(bool value) noexcept {
     use_simd_ = value;
   }
 
   static bool use_simd_;
+  static InstructionSet max_instruction_set_;
 };
 
 }  // namespace sound_feature_extraction
@@ -0,0 +1,68 @@
+/*! @file simd_dispatch.h
+ *  @brief Runtime selection of the SIMD kernels, shared by C and C++ code.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+#ifndef SRC_SIMD_DISPATCH_H_
+#define SRC_SIMD_DISPATCH_H_
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SIMD_X86
+/// @brief Compiles a function for the specified instruction set regardless
+/// of -march, so that it can be selected at runtime.
+#define SIMD_TARGET(isa) __attribute__((target(isa)))
+/// @brief The AVX-512 kernels use the 16-bit integer (BW) and the 256-bit
+/// masked (VL) operations as well.
+#define SIMD_TARGET_AVX512 SIMD_TARGET("avx512f,avx512bw,avx512vl")
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+/// @brief GCC defines only __ARM_NEON on AArch64, while libSimd checks
+/// __ARM_NEON__. NEON is a part of the base AArch64 instruction set.
+#define SIMD_NEON
+#endif
+
+/// @brief The values of sound_feature_extraction::InstructionSet.
+#define SIMD_INSTRUCTION_SET_SCALAR 0
+#define SIMD_INSTRUCTION_SET_NEON 1
+#define SIMD_INSTRUCTION_SET_SSE41 2
+#define SIMD_INSTRUCTION_SET_AVX 3
+#define SIMD_INSTRUCTION_SET_AVX2 4
+#define SIMD_INSTRUCTION_SET_AVX512 5
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// @brief The same as SimdAware::IsEnabled(), for C code.
+/// @param value One of SIMD_INSTRUCTION_SET_*.
+int simd_instruction_set_enabled(int value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_SIMD_DISPATCH_H_
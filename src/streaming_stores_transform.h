@@ -0,0 +1,111 @@
+/*! @file streaming_stores_transform.h
+ *  @brief Interface of the transforms which write around the cache.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+
+#ifndef SRC_STREAMING_STORES_TRANSFORM_H_
+#define SRC_STREAMING_STORES_TRANSFORM_H_
+
+#include <cstdint>
+#include <cstring>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace sound_feature_extraction {
+
+/// @brief Implemented by the transforms which can write their output with
+/// the non-temporal stores, so that it does not evict the cached data.
+/// @details TransformTree enables them (see
+/// TransformTree::streaming_stores()) for the leaves, whose output is read
+/// only by the caller, and for the nodes whose output does not fit into
+/// the cache anyway.
+class StreamingStoresTransform {
+ public:
+  /// @brief Below this size StoreCopy() is memcpy(), the stores would
+  /// be combined in the cache anyway.
+  static constexpr size_t kMinStreamingSize = 256;
+
+  StreamingStoresTransform() noexcept : streaming_stores_(false) {
+  }
+
+#if (__GNUC__ == 4 && __GNUC_MINOR__ < 8)
+  virtual ~StreamingStoresTransform() {};
+#else
+  virtual ~StreamingStoresTransform() = default;
+#endif
+
+  bool streaming_stores() const noexcept {
+    return streaming_stores_;
+  }
+
+  void set_streaming_stores(bool value) noexcept {
+    streaming_stores_ = value;
+  }
+
+ protected:
+  /// @brief memcpy() which bypasses the cache if streaming_stores().
+  void StoreCopy(void* dest, const void* src, size_t size) const noexcept {
+#ifdef __SSE2__
+    if (streaming_stores_ && size >= kMinStreamingSize) {
+      auto dst = reinterpret_cast<char*>(dest);
+      auto ptr = reinterpret_cast<const char*>(src);
+      size_t head = (16 - reinterpret_cast<uintptr_t>(dst) % 16) % 16;
+      memcpy(dst, ptr, head);
+      size_t i = head;
+      for (; i + 16 <= size; i += 16) {
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dst + i),
+                         _mm_loadu_si128(
+                             reinterpret_cast<const __m128i*>(ptr + i)));
+      }
+      memcpy(dst + i, ptr + i, size - i);
+      StoreFence();
+      return;
+    }
+#endif
+    memcpy(dest, src, size);
+  }
+
+  /// @brief Makes the non-temporal stores visible to the other threads,
+  /// call it at the end of Do() after writing with them directly.
+  void StoreFence() const noexcept {
+#ifdef __SSE2__
+    if (streaming_stores_) {
+      _mm_sfence();
+    }
+#endif
+  }
+
+ private:
+  bool streaming_stores_;
+};
+
+}  // namespace sound_feature_extraction
+#endif  // SRC_STREAMING_STORES_TRANSFORM_H_
@@ -0,0 +1,88 @@
+/*! @file struct_of_arrays_transform.h
+ *  @brief Interface of the transforms which exchange FixedArray buffers as columns.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#ifndef SRC_STRUCT_OF_ARRAYS_TRANSFORM_H_
+#define SRC_STRUCT_OF_ARRAYS_TRANSFORM_H_
+
+namespace sound_feature_extraction {
+
+/// @brief Implemented by the transforms of formats::SingleFormat buffers of
+/// formats::FixedArray, which can write or read them in the struct of arrays
+/// layout: the field j of the buffer i is at formats::FieldColumn(j)[i].
+/// @details TransformTree switches a producer and all its children to that
+/// layout if all of them support it, so that the consumers scan the fields
+/// contiguously instead of with the stride of an aligned buffer. The features
+/// outputs and the validated or dumped buffers always stay in the array of
+/// structs layout.
+class StructOfArraysTransform {
+ public:
+  StructOfArraysTransform() noexcept : soa_input_(false), soa_output_(false) {
+  }
+
+#if (__GNUC__ == 4 && __GNUC_MINOR__ < 8)
+  virtual ~StructOfArraysTransform() {};
+#else
+  virtual ~StructOfArraysTransform() = default;
+#endif
+
+  /// @brief Returns true if the transform can read the columns.
+  virtual bool SupportsSoAInput() const noexcept {
+    return false;
+  }
+
+  /// @brief Returns true if the transform can write the columns.
+  virtual bool SupportsSoAOutput() const noexcept {
+    return false;
+  }
+
+  bool soa_input() const noexcept {
+    return soa_input_;
+  }
+
+  void set_soa_input(bool value) noexcept {
+    soa_input_ = value;
+  }
+
+  bool soa_output() const noexcept {
+    return soa_output_;
+  }
+
+  void set_soa_output(bool value) noexcept {
+    soa_output_ = value;
+  }
+
+ private:
+  bool soa_input_;
+  bool soa_output_;
+};
+
+}  // namespace sound_feature_extraction
+#endif  // SRC_STRUCT_OF_ARRAYS_TRANSFORM_H_
@@ -0,0 +1,314 @@
+/*! @file thread_pool.cc
+ *  @brief Process-wide pool of the threads which execute the parallel work.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+#include "src/thread_pool.h"
+#include <algorithm>
+#include <fstream>
+#include <new>
+#include <sstream>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+#include "src/realtime.h"
+#include "src/safe_omp.h"
+
+namespace sound_feature_extraction {
+
+static thread_local int current_thread_index = 0;
+
+ThreadPool::TaskGroup::TaskGroup() noexcept : pending_(0) {
+}
+
+ThreadPool::TaskGroup::~TaskGroup() {
+  Wait();
+}
+
+void ThreadPool::TaskGroup::Spawn(const std::function<void()>& task) {
+  Instance().Push({ task, nullptr, 0, 0, this, nullptr, nullptr, nullptr },
+                  this);
+}
+
+void ThreadPool::TaskGroup::Wait() noexcept {
+  auto& pool = Instance();
+  std::unique_lock<std::mutex> lock(pool.mutex_);
+  while (pending_ > 0) {
+    if (!pool.RunPending(&lock, this)) {
+      pool.finished_.wait(lock);
+    }
+  }
+}
+
+ThreadPool& ThreadPool::Instance() noexcept {
+  // The pool is never destroyed: the trees which live in static objects
+  // may be executed after the end of main()
+  static ThreadPool* instance = new ThreadPool();
+  return *instance;
+}
+
+ThreadPool::ThreadPool()
+    : threads_number_(std::max(omp_get_max_threads(), 1)), stopping_(false) {
+#ifdef __linux__
+  pthread_atfork(nullptr, nullptr, AfterFork);
+#endif
+  Start();
+}
+
+void ThreadPool::AfterFork() noexcept {
+  auto& pool = Instance();
+  // Another thread of the parent could hold the mutex at the moment of fork
+  new (&pool.mutex_) std::mutex();
+  new (&pool.wake_) std::condition_variable();
+  new (&pool.finished_) std::condition_variable();
+  for (auto& worker : pool.workers_) {
+    // The thread does not exist here, so it must be neither joined nor
+    // destroyed while joinable
+    new (&worker) std::thread();
+  }
+  pool.workers_.clear();
+  // The tasks belong to the groups of the threads which did not survive
+  pool.tasks_.clear();
+  pool.submitted_.clear();
+  pool.stopping_ = false;
+  pool.Start();
+}
+
+int ThreadPool::threads_number() const noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return threads_number_;
+}
+
+void ThreadPool::set_threads_number(int value) {
+  Stop();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    threads_number_ = std::max(value, 1);
+  }
+  Start();
+}
+
+std::vector<int> ThreadPool::cpus() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return cpus_;
+}
+
+void ThreadPool::set_cpus(const std::vector<int>& value) {
+  Stop();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cpus_ = value;
+  }
+  Start();
+}
+
+void ThreadPool::Start() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  // The thread which waits for the tasks is the first one
+  for (int i = 1; i < threads_number_; i++) {
+    workers_.emplace_back(&ThreadPool::Work, this, i);
+    Pin(&workers_.back(), i);
+  }
+}
+
+void ThreadPool::Stop() {
+  std::vector<std::thread> workers;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+    workers.swap(workers_);
+  }
+  wake_.notify_all();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  stopping_ = false;
+}
+
+void ThreadPool::Pin(std::thread* thread, int index) const noexcept {
+#ifdef __linux__
+  if (cpus_.empty()) {
+    // The worker inherits the affinity of the thread which created it
+    return;
+  }
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpus_[(index - 1) % cpus_.size()], &set);
+  pthread_setaffinity_np(thread->native_handle(), sizeof(set), &set);
+#else
+  (void)thread;
+  (void)index;
+#endif
+}
+
+void ThreadPool::Work(int index) noexcept {
+  current_thread_index = index;
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    if (RunPending(&lock, nullptr)) {
+      continue;
+    }
+    if (stopping_) {
+      return;
+    }
+    wake_.wait(lock);
+  }
+}
+
+void ThreadPool::Push(Task&& task, TaskGroup* group) {
+  RealtimeSection::Check("ThreadPool::Push()");
+  task.Overrides = CurrentExecutionOverrides();
+  task.Lease = ThreadsGovernor::CurrentLease();
+  task.Cancellation = CurrentCancellationToken();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks_.push_back(std::move(task));
+    if (group != nullptr) {
+      group->pending_++;
+    }
+  }
+  wake_.notify_one();
+  if (group != nullptr) {
+    // The group may be spawned to while it is waited for
+    finished_.notify_all();
+  }
+}
+
+void ThreadPool::Submit(const std::function<void()>& task) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!workers_.empty()) {
+      // The workers drain the queue before they stop
+      submitted_.push_back(
+          { task, nullptr, 0, 0, nullptr, nullptr, nullptr, nullptr });
+      wake_.notify_one();
+      return;
+    }
+  }
+  task();
+}
+
+bool ThreadPool::RunPending(std::unique_lock<std::mutex>* lock,
+                            const TaskGroup* group) noexcept {
+  // The waiting thread runs only its own tasks: the others may be long or
+  // wait for something which it holds
+  auto found = tasks_.end();
+  for (auto it = tasks_.rbegin(); it != tasks_.rend(); ++it) {
+    if (group == nullptr || it->Group == group) {
+      found = std::prev(it.base());
+      break;
+    }
+  }
+  Task task;
+  if (found != tasks_.end()) {
+    task = std::move(*found);
+    tasks_.erase(found);
+  } else if (group == nullptr && !submitted_.empty()) {
+    task = std::move(submitted_.front());
+    submitted_.pop_front();
+  } else {
+    return false;
+  }
+  lock->unlock();
+  {
+    // A worker may run the tasks of any thread
+    ScopedExecutionOverrides overrides(task.Overrides);
+    ThreadsGovernor::Scope lease(task.Lease);
+    CancellationScope cancellation(task.Cancellation);
+    if (task.Range != nullptr) {
+      if (!ExecutionCancelled()) {
+        (*task.Range)(task.Begin, task.End);
+      }
+    } else {
+      task.Body();
+      // Destroy the captures outside of the lock
+      task.Body = nullptr;
+    }
+  }
+  lock->lock();
+  if (task.Group != nullptr && --task.Group->pending_ == 0) {
+    finished_.notify_all();
+  }
+  return true;
+}
+
+void ThreadPool::RunParallelFor(
+    size_t count, size_t grainsize, int maxThreads,
+    const std::function<void(size_t, size_t)>& body) noexcept {
+  size_t chunks = (count + std::max(grainsize, size_t(1)) - 1) /
+      std::max(grainsize, size_t(1));
+  // The governor sheds the threads of the concurrent extractions
+  maxThreads = std::min(maxThreads, ThreadsGovernor::CurrentBudget());
+  chunks = std::min(chunks, static_cast<size_t>(
+      std::max(std::min(maxThreads, threads_number()), 1)));
+  // Waking the workers takes the lock
+  if (chunks <= 1 || RealtimeSection::Active()) {
+    if (count > 0) {
+      body(0, count);
+    }
+    return;
+  }
+  TaskGroup group;
+  for (size_t i = 1; i < chunks; i++) {
+    Push({ nullptr, &body, count * i / chunks, count * (i + 1) / chunks,
+           &group, nullptr, nullptr, nullptr }, &group);
+  }
+  body(0, count / chunks);
+  group.Wait();
+}
+
+int ThreadPool::CurrentThreadIndex() noexcept {
+  return current_thread_index;
+}
+
+std::vector<int> ThreadPool::NumaNodeCpus(int node) {
+  std::vector<int> cpus;
+  // The format is "0-3,8-11"
+  std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) +
+                     "/cpulist");
+  std::string range;
+  while (std::getline(file, range, ',')) {
+    std::istringstream stream(range);
+    int first, last;
+    if (!(stream >> first)) {
+      break;
+    }
+    last = first;
+    if (stream.get() == '-') {
+      stream >> last;
+    }
+    for (int cpu = first; cpu <= last; cpu++) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+}  // namespace sound_feature_extraction
@@ -0,0 +1,179 @@
+/*! @file thread_pool.h
+ *  @brief Process-wide pool of the threads which execute the parallel work.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+#ifndef SRC_THREAD_POOL_H_
+#define SRC_THREAD_POOL_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "src/cancellation.h"
+#include "src/execution_overrides.h"
+#include "src/threads_governor.h"
+
+namespace sound_feature_extraction {
+
+/// @brief The persistent threads which run the parallel loops of
+/// the transforms, the slices and the independent subtrees of the transform
+/// trees and the chunks of the batch extraction.
+/// @details Unlike the OpenMP regions, the threads are created once and
+/// sleep between the tasks, so a parallel loop over a few small buffers
+/// does not pay for the team fork and the join barrier. The thread which
+/// waits for its tasks executes the pending tasks of its group meanwhile,
+/// and the nested loops wait the same way, so the number of the busy
+/// threads never exceeds threads_number() and the nested parallelism does
+/// not oversubscribe the CPUs. The tasks passed to Submit() are queued
+/// separately and run only by the idle workers, so that a synchronous
+/// extraction never executes an unrelated asynchronous one inline.
+class ThreadPool {
+ public:
+  /// @brief The tasks which are waited for together.
+  class TaskGroup {
+   public:
+    TaskGroup() noexcept;
+    /// @brief Waits for the spawned tasks.
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    void Spawn(const std::function<void()>& task);
+    /// @brief Executes the pending tasks of this group until all of them
+    /// are finished.
+    void Wait() noexcept;
+
+   private:
+    friend class ThreadPool;
+
+    /// @brief The number of the unfinished tasks, guarded by the pool mutex.
+    size_t pending_;
+  };
+
+  static ThreadPool& Instance() noexcept;
+
+  /// @brief The number of the threads which execute the tasks, including
+  /// the one which waits for them.
+  int threads_number() const noexcept;
+  /// @brief Restarts the workers. The running tasks are finished first.
+  void set_threads_number(int value);
+  /// @brief The CPUs which the workers are pinned to, round robin.
+  std::vector<int> cpus() const;
+  /// @brief Pins the workers to the specified CPUs, round robin.
+  /// The empty list removes the pinning.
+  void set_cpus(const std::vector<int>& value);
+
+  /// @brief Executes the task asynchronously, without waiting for it.
+  /// If the pool has no workers, the task is executed in the calling thread.
+  void Submit(const std::function<void()>& task);
+
+  /// @brief Calls body(begin, end) on the consecutive ranges which cover
+  /// [0, count), each at least grainsize long, on at most maxThreads
+  /// threads including the calling one.
+  /// @details Does not allocate after the warm up, so that the steady state
+  /// execution of the trees stays free of the heap.
+  template <typename F>
+  void ParallelFor(size_t count, size_t grainsize, int maxThreads,
+                   const F& body) noexcept {
+    // std::function keeps a reference_wrapper in place
+    RunParallelFor(count, grainsize, maxThreads, std::cref(body));
+  }
+
+  /// @brief The index of the calling worker, starting from 1, or 0 if
+  /// the calling thread does not belong to the pool.
+  static int CurrentThreadIndex() noexcept;
+  /// @brief The CPUs of the specified NUMA node according to sysfs.
+  /// @return The empty list if the node does not exist.
+  static std::vector<int> NumaNodeCpus(int node);
+
+ private:
+  struct Task {
+    std::function<void()> Body;
+    /// @brief If not null, the task is Range(Begin, End) of ParallelFor().
+    const std::function<void(size_t, size_t)>* Range;
+    size_t Begin;
+    size_t End;
+    /// @brief Null if the task was submitted without a group.
+    TaskGroup* Group;
+    /// @brief The ExecutionOverrides of the thread which pushed the task.
+    /// The groups are waited for, so they outlive the task.
+    const ExecutionOverrides* Overrides;
+    /// @brief The ThreadsGovernor lease of the thread which pushed the task.
+    const ThreadsGovernor::Lease* Lease;
+    /// @brief The CancellationToken of the thread which pushed the task.
+    /// The cancelled ranges of ParallelFor() are skipped.
+    const CancellationToken* Cancellation;
+  };
+
+  ThreadPool();
+
+  /// @brief Rebuilds the pool in the child process after fork(), which
+  /// copies only the forking thread: the workers are abandoned and started
+  /// anew, so that the child, e.g., a worker of Python's ExtractorPool,
+  /// can use the prepared configurations of the parent.
+  static void AfterFork() noexcept;
+  void Start();
+  void Stop();
+  void Work(int index) noexcept;
+  void Push(Task&& task, TaskGroup* group);
+  void RunParallelFor(
+      size_t count, size_t grainsize, int maxThreads,
+      const std::function<void(size_t, size_t)>& body) noexcept;
+  /// @brief Executes the last pending task of the group, if any. A worker
+  /// passes nullptr to take the last pending task of any group or else
+  /// the oldest submitted one. The caller must hold mutex_ via lock.
+  bool RunPending(std::unique_lock<std::mutex>* lock,
+                  const TaskGroup* group) noexcept;
+  void Pin(std::thread* thread, int index) const noexcept;
+
+  mutable std::mutex mutex_;
+  /// @brief Wakes the idle workers.
+  std::condition_variable wake_;
+  /// @brief Wakes the threads in TaskGroup::Wait(), which can not run
+  /// the tasks of the other groups.
+  std::condition_variable finished_;
+  /// @brief The pending tasks, executed in LIFO order. The capacity is kept,
+  /// so pushing does not allocate after the warm up.
+  std::vector<Task> tasks_;
+  /// @brief The tasks of Submit(), executed in FIFO order by the idle
+  /// workers only.
+  std::deque<Task> submitted_;
+  std::vector<std::thread> workers_;
+  std::vector<int> cpus_;
+  int threads_number_;
+  bool stopping_;
+};
+
+}  // namespace sound_feature_extraction
+
+#endif  // SRC_THREAD_POOL_H_
@@ -0,0 +1,106 @@
+/*! @file threads_governor.cc
+ *  @brief Division of the pool threads among the concurrent extractions.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+#include "src/threads_governor.h"
+#include <algorithm>
+#include <limits>
+#include "src/thread_pool.h"
+
+namespace sound_feature_extraction {
+
+static thread_local const ThreadsGovernor::Lease* current_lease = nullptr;
+
+ThreadsGovernor::Lease::Lease(int requested) noexcept
+    : requested_(requested), governed_(Instance().enabled()),
+      previous_(current_lease) {
+  if (governed_) {
+    Instance().executions_++;
+  }
+  current_lease = this;
+}
+
+ThreadsGovernor::Lease::~Lease() {
+  current_lease = previous_;
+  if (governed_) {
+    Instance().executions_--;
+  }
+}
+
+int ThreadsGovernor::Lease::threads() const noexcept {
+  int share = governed_? Instance().Share() :
+      std::numeric_limits<int>::max();
+  return requested_ > 0? std::min(requested_, share) : share;
+}
+
+ThreadsGovernor::Scope::Scope(const Lease* lease) noexcept
+    : previous_(current_lease) {
+  current_lease = lease;
+}
+
+ThreadsGovernor::Scope::~Scope() {
+  current_lease = previous_;
+}
+
+ThreadsGovernor& ThreadsGovernor::Instance() noexcept {
+  static ThreadsGovernor instance;
+  return instance;
+}
+
+ThreadsGovernor::ThreadsGovernor() noexcept
+    : enabled_(false), executions_(0) {
+}
+
+bool ThreadsGovernor::enabled() const noexcept {
+  return enabled_;
+}
+
+void ThreadsGovernor::set_enabled(bool value) noexcept {
+  enabled_ = value;
+}
+
+ThreadsGovernorState ThreadsGovernor::State() const noexcept {
+  return { executions_.load(), Share() };
+}
+
+const ThreadsGovernor::Lease* ThreadsGovernor::CurrentLease() noexcept {
+  return current_lease;
+}
+
+int ThreadsGovernor::CurrentBudget() noexcept {
+  return current_lease != nullptr? current_lease->threads() :
+      std::numeric_limits<int>::max();
+}
+
+int ThreadsGovernor::Share() const noexcept {
+  int threads = ThreadPool::Instance().threads_number();
+  return std::max(threads / std::max(executions_.load(), 1), 1);
+}
+
+}  // namespace sound_feature_extraction
@@ -0,0 +1,117 @@
+/*! @file threads_governor.h
+ *  @brief Division of the pool threads among the concurrent extractions.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+#ifndef SRC_THREADS_GOVERNOR_H_
+#define SRC_THREADS_GOVERNOR_H_
+
+#include <atomic>
+
+namespace sound_feature_extraction {
+
+/// @brief The current division of the threads, see ThreadsGovernor.
+struct ThreadsGovernorState {
+  /// @brief The number of the extractions which hold a lease.
+  int Executions;
+  /// @brief The number of the threads of each extraction.
+  int Share;
+};
+
+/// @brief Divides the threads of ThreadPool evenly among the concurrent
+/// extractions, so that they do not oversubscribe the CPUs under load.
+/// @details Each extraction holds a Lease, which limits the parallel loops
+/// started by it. The limit is evaluated on each loop, so the running
+/// extractions shed their threads as soon as the new ones arrive and take
+/// them back when the load drops.
+class ThreadsGovernor {
+ public:
+  /// @brief Takes part in the division of the threads and limits
+  /// the parallel loops of the calling thread for the lifetime of
+  /// the object.
+  class Lease {
+   public:
+    /// @param requested The thread budget of the extraction, non-positive
+    /// means that only the governor limits it.
+    explicit Lease(int requested) noexcept;
+    ~Lease();
+
+    Lease(const Lease&) = delete;
+    Lease& operator=(const Lease&) = delete;
+
+    /// @brief Returns the number of the threads the extraction may use now.
+    int threads() const noexcept;
+
+   private:
+    int requested_;
+    /// @brief Indicates whether the lease is counted in Executions.
+    bool governed_;
+    const Lease* previous_;
+  };
+
+  /// @brief Puts the lease in effect in the calling thread until the end of
+  /// the scope. ThreadPool passes the leases to the workers this way.
+  class Scope {
+   public:
+    explicit Scope(const Lease* lease) noexcept;
+    ~Scope();
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+   private:
+    const Lease* previous_;
+  };
+
+  static ThreadsGovernor& Instance() noexcept;
+
+  /// @brief Indicates whether the threads are divided among the leases.
+  /// Otherwise only their own budgets limit them. Disabled by default.
+  bool enabled() const noexcept;
+  void set_enabled(bool value) noexcept;
+
+  ThreadsGovernorState State() const noexcept;
+
+  /// @brief Returns the lease in effect in the calling thread or nullptr.
+  static const Lease* CurrentLease() noexcept;
+  /// @brief Returns the maximal number of the threads of the parallel loops
+  /// started by the calling thread.
+  static int CurrentBudget() noexcept;
+
+ private:
+  ThreadsGovernor() noexcept;
+
+  int Share() const noexcept;
+
+  std::atomic<bool> enabled_;
+  std::atomic<int> executions_;
+};
+
+}  // namespace sound_feature_extraction
+
+#endif  // SRC_THREADS_GOVERNOR_H_
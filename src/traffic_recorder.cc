@@ -0,0 +1,114 @@
+/*! @file traffic_recorder.cc
+ *  @brief Records the inputs of the extractions for the replay benchmark.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+#include "src/traffic_recorder.h"
+
+namespace sound_feature_extraction {
+
+constexpr char TrafficRecorder::kMagic[9];
+
+TrafficRecorder::TrafficRecorder(const std::string& fileName, int every,
+                                 size_t maxRecords)
+    : file_name_(fileName), file_(nullptr), every_(every),
+      max_records_(maxRecords), calls_(0), records_(0), failed_(false),
+      closed_(false) {
+  if (every < 1) {
+    throw TrafficRecorderException(fileName, "every must be positive");
+  }
+  file_ = fopen(fileName.c_str(), "wb");
+  if (file_ == nullptr) {
+    throw TrafficRecorderException(fileName, "failed to create the file");
+  }
+  failed_ = fwrite(kMagic, 1, 8, file_) != 8;
+}
+
+TrafficRecorder::~TrafficRecorder() {
+  Close();
+}
+
+const std::string& TrafficRecorder::file_name() const noexcept {
+  return file_name_;
+}
+
+size_t TrafficRecorder::records() const noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return records_;
+}
+
+bool TrafficRecorder::Write(const void* data, size_t size) noexcept {
+  return fwrite(data, 1, size, file_) == size;
+}
+
+bool TrafficRecorder::WriteString(const std::string& str) noexcept {
+  uint32_t length = str.size();
+  return Write(&length, sizeof(length)) && Write(str.data(), length);
+}
+
+void TrafficRecorder::Record(const std::string& fingerprint,
+                             const std::vector<std::string>& features,
+                             int samplingRate, int sampleType,
+                             uint64_t samples, const void* data,
+                             size_t size) noexcept {
+  if (calls_++ % every_ != 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (closed_ || failed_ ||
+      (max_records_ > 0 && records_ >= max_records_)) {
+    return;
+  }
+  uint32_t count = features.size();
+  int32_t rate = samplingRate, type = sampleType;
+  uint64_t size64 = size;
+  bool written = WriteString(fingerprint) && Write(&count, sizeof(count));
+  for (auto& feature : features) {
+    written = written && WriteString(feature);
+  }
+  written = written && Write(&rate, sizeof(rate)) &&
+      Write(&type, sizeof(type)) && Write(&samples, sizeof(samples)) &&
+      Write(&size64, sizeof(size64)) && Write(data, size);
+  // A partial record would break the reader, so the rest is not recorded
+  failed_ = !written;
+  if (written) {
+    records_++;
+  }
+}
+
+bool TrafficRecorder::Close() noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (closed_) {
+    return !failed_;
+  }
+  closed_ = true;
+  failed_ |= fclose(file_) != 0;
+  return !failed_;
+}
+
+}  // namespace sound_feature_extraction
@@ -0,0 +1,103 @@
+/*! @file traffic_recorder.h
+ *  @brief Records the inputs of the extractions for the replay benchmark.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+#ifndef SRC_TRAFFIC_RECORDER_H_
+#define SRC_TRAFFIC_RECORDER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "src/exceptions.h"
+
+namespace sound_feature_extraction {
+
+class TrafficRecorderException : public ExceptionBase {
+ public:
+  TrafficRecorderException(const std::string& file, const std::string& reason)
+  : ExceptionBase("Traffic recorder \"" + file + "\": " + reason + ".") {
+  }
+};
+
+/// @brief Writes the inputs of every n-th extraction together with what is
+/// needed to set up the same configuration again, so that sfe-replay can
+/// benchmark the real workload.
+/// @details The file starts with kMagic, followed by the records, each of
+/// them is (in the native byte order):
+/// uint32 length + configuration fingerprint, uint32 features count,
+/// uint32 length + feature for each of them, int32 sampling rate,
+/// int32 sample type (0 - int16, 1 - int32, 2 - float), uint64 samples
+/// count, uint64 size in bytes, the samples.
+/// The skipped calls cost a single atomic increment; the recorded ones
+/// are written synchronously by the calling thread.
+class TrafficRecorder {
+ public:
+  static constexpr char kMagic[9] = "SFETRAFC";
+
+  /// @param every Record each every-th call of Record().
+  /// @param maxRecords Stop recording after this number of records,
+  /// 0 means no limit.
+  TrafficRecorder(const std::string& fileName, int every, size_t maxRecords);
+  /// @brief Calls Close() if it was not called.
+  ~TrafficRecorder();
+
+  /// @brief Writes the record if it is the turn of this call. It is safe
+  /// to call this from several threads at once.
+  void Record(const std::string& fingerprint,
+              const std::vector<std::string>& features, int samplingRate,
+              int sampleType, uint64_t samples, const void* data,
+              size_t size) noexcept;
+  /// @brief Closes the file.
+  /// @return false if any write failed.
+  bool Close() noexcept;
+
+  const std::string& file_name() const noexcept;
+  size_t records() const noexcept;
+
+ private:
+  bool Write(const void* data, size_t size) noexcept;
+  bool WriteString(const std::string& str) noexcept;
+
+  std::string file_name_;
+  FILE* file_;
+  uint64_t every_;
+  size_t max_records_;
+  std::atomic<uint64_t> calls_;
+  size_t records_;
+  bool failed_;
+  bool closed_;
+  mutable std::mutex mutex_;
+};
+
+}  // namespace sound_feature_extraction
+
+#endif  // SRC_TRAFFIC_RECORDER_H_
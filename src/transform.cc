@@ -30,6 +30,7 @@
 
 #include "src/transform.h"
 #include <cassert>
+#include <map>
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wold-style-cast"
 #pragma GCC diagnostic ignored "-Wunused-local-typedefs"
@@ -45,16 +46,62 @@ bool Transform::BufferInvariant() const noexcept {
   return false;
 }
 
+size_t Transform::BufferRatio() const noexcept {
+  return BufferInvariant()? 1 : 0;
+}
+
+bool Transform::InPlace() const noexcept {
+  return false;
+}
+
+bool Transform::streaming() const noexcept {
+  return false;
+}
+
+void Transform::set_streaming(bool) noexcept {
+}
+
+void Transform::ResetState() const noexcept {
+}
+
+void Transform::set_accuracy(Accuracy) noexcept {
+}
+
+size_t Transform::PrivateMemorySize() const noexcept {
+  return 0;
+}
+
+constexpr size_t Overlap::kUnbounded;
+
+Overlap Transform::RequiredOverlap(const Overlap&) const noexcept {
+  return Overlap::Unbounded();
+}
+
+constexpr size_t ElementRange::kAll;
+
+ElementRange Transform::RequiredElements(const ElementRange&) const noexcept {
+  return ElementRange::All();
+}
+
+ElementRange Transform::used_elements() const noexcept {
+  return ElementRange::All();
+}
+
+void Transform::set_used_elements(const ElementRange&) noexcept {
+}
+
 std::shared_ptr<Transform> Transform::Clone() const noexcept {
-  auto copy = TransformFactory::Instance().Map()
-      .find(this->Name())->second
-      .find(this->InputFormat()->Id())->second();
+  auto copy = TransformFactory::Instance().Find(this->Name())
+      ->find(this->InputFormat()->Id())->second();
   copy->SetParameters(this->GetParameters());
+  copy->set_streaming(this->streaming());
+  copy->set_used_elements(this->used_elements());
   return copy;
 }
 
 bool Transform::operator==(const Transform& other) const noexcept {
   if (this->Name() != other.Name()) return false;
+  if (this->streaming() != other.streaming()) return false;
   assert(GetParameters().size() == other.GetParameters().size());
   for (auto p : GetParameters()) {
     if (other.GetParameters().find(p.first)->second != p.second) {
@@ -64,6 +111,22 @@ bool Transform::operator==(const Transform& other) const noexcept {
   return true;
 }
 
+std::string Transform::StateKey() const {
+  // The parameters are unordered
+  std::map<std::string, std::string> parameters(GetParameters().begin(),
+                                                GetParameters().end());
+  std::string key = Name() + '(';
+  for (auto& p : parameters) {
+    key += p.first + '=' + p.second + ',';
+  }
+  key += ") " + InputFormat()->ToString() + " at " +
+      std::to_string(InputFormat()->SamplingRate());
+  if (streaming()) {
+    key += " streaming";
+  }
+  return key;
+}
+
 std::string Transform::SafeName() const noexcept {
   return replace_all_copy(replace_all_copy(replace_all_copy(replace_all_copy(
       replace_all_copy(replace_all_copy(
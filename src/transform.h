@@ -31,6 +31,8 @@
 #ifndef SRC_TRANSFORM_H_
 #define SRC_TRANSFORM_H_
 
+#include <algorithm>
+#include <limits>
 #include "src/config.h"
 #include "src/buffer_format.h"
 #include "src/buffers.h"
@@ -38,6 +40,60 @@
 
 namespace sound_feature_extraction {
 
+/// @brief How much accuracy the transforms may trade for speed, see
+/// Transform::set_accuracy().
+enum class Accuracy {
+  /// @brief The default parameters.
+  kExact,
+  /// @brief The approximations with the errors of about 1e-6 relative.
+  kBalanced,
+  /// @brief The approximations with the errors of about 1e-5 relative.
+  kFast
+};
+
+/// @brief The number of the neighbouring buffers before and after
+/// the calculated ones, or of the samples while the signal is a single
+/// buffer. See Transform::RequiredOverlap().
+struct Overlap {
+  static constexpr size_t kUnbounded = std::numeric_limits<size_t>::max();
+
+  size_t Before;
+  size_t After;
+
+  bool Bounded() const noexcept {
+    return Before != kUnbounded && After != kUnbounded;
+  }
+
+  static Overlap Unbounded() noexcept {
+    return { kUnbounded, kUnbounded };
+  }
+};
+
+/// @brief The half-open range [Begin, End) of the elements of each buffer.
+/// See Transform::RequiredElements().
+struct ElementRange {
+  static constexpr size_t kAll = std::numeric_limits<size_t>::max();
+
+  size_t Begin;
+  size_t End;
+
+  bool Whole() const noexcept {
+    return Begin == 0 && End == kAll;
+  }
+
+  /// @brief Widens the range to the multiples of alignment and clips it
+  /// to [0, size).
+  ElementRange Align(size_t size, size_t alignment) const noexcept {
+    size_t end = std::min(End, size);
+    return { std::min(Begin, end) / alignment * alignment,
+             std::min((end + alignment - 1) / alignment * alignment, size) };
+  }
+
+  static ElementRange All() noexcept {
+    return { 0, kAll };
+  }
+};
+
 /// @brief Abstract class representing a public interface of any transform.
 class Transform : public virtual Parameterizable {
  public:
@@ -49,6 +105,65 @@ class Transform : public virtual Parameterizable {
 
   virtual bool BufferInvariant() const noexcept;
 
+  /// @brief The number of the consecutive output buffers which each input
+  /// buffer produces on its own, regardless of its index and of the other
+  /// buffers, or 0 if there is no such number. TransformTree slices
+  /// the cache optimized cycles through such transforms. The default is 1
+  /// for the buffer invariant transforms and 0 for the rest.
+  virtual size_t BufferRatio() const noexcept;
+
+  /// @brief Indicates whether Do() is correct when out points to the memory
+  /// of in, so that TransformTree may write the output over the input
+  /// buffers which nobody else reads.
+  virtual bool InPlace() const noexcept;
+
+  /// @brief Indicates whether the sequential Do() calls receive the sequential
+  /// parts of the same signal, so that the transforms which depend on
+  /// the previous values carry their state over.
+  virtual bool streaming() const noexcept;
+
+  /// @brief Switches the streaming mode. It must be set before the input
+  /// format, since it can affect the output buffers count.
+  virtual void set_streaming(bool value) noexcept;
+
+  /// @brief Drops the state accumulated during the streaming.
+  virtual void ResetState() const noexcept;
+
+  /// @brief Switches the defaults of the parameters to the cheaper
+  /// approximations of the tier. TransformTree calls it before setting
+  /// the explicit parameters, so that they take precedence. The transforms
+  /// document the errors of each tier.
+  virtual void set_accuracy(Accuracy value) noexcept;
+
+  /// @brief The memory which the initialized transform holds besides its
+  /// output buffers, e.g., the filter weights or the window table, in bytes.
+  /// The memory of the FFTF plans belongs to FFTF and is not counted.
+  virtual size_t PrivateMemorySize() const noexcept;
+
+  /// @brief Returns how many neighbouring input buffers are required to
+  /// calculate the output buffers exactly, given how many neighbouring
+  /// output buffers are, so that TransformTree can split a long input into
+  /// the overlapping blocks (see TransformTree::BlockOverlap()).
+  /// The default is Overlap::Unbounded(), i.e., the outputs may depend on
+  /// the whole input.
+  virtual Overlap RequiredOverlap(const Overlap& output) const noexcept;
+
+  /// @brief Returns which elements of each input buffer are read to
+  /// calculate the given elements of the output buffers, so that
+  /// TransformTree can tell the parent which of its elements are used
+  /// (see set_used_elements()). The default is ElementRange::All().
+  virtual ElementRange RequiredElements(const ElementRange& output)
+      const noexcept;
+
+  /// @brief The elements of each output buffer which the children read.
+  virtual ElementRange used_elements() const noexcept;
+
+  /// @brief Lets the transform calculate only the used elements of each
+  /// output buffer and fill the rest with zeros, e.g., the spectral bins
+  /// beyond the frequencies of FilterBank. TransformTree sets it after
+  /// the fusion; the transforms which ignore it calculate everything.
+  virtual void set_used_elements(const ElementRange& value) noexcept;
+
   virtual const std::shared_ptr<BufferFormat> InputFormat() const noexcept = 0;
 
   virtual size_t SetInputFormat(const std::shared_ptr<BufferFormat>& format,
@@ -70,6 +185,10 @@ class Transform : public virtual Parameterizable {
 
   std::string HtmlEscapedName() const noexcept;
 
+  /// @brief Identifies the state which the transform derives from its name,
+  /// parameters and input format only, see SharedState().
+  std::string StateKey() const;
+
   bool operator==(const Transform& other) const noexcept;
 };
 
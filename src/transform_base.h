@@ -61,7 +61,26 @@ class TransformBase : public virtual Transform,
 
   TransformBase() noexcept
       : input_format_(std::make_shared<FIN>()),
-        output_format_(std::make_shared<FOUT>()) {
+        output_format_(std::make_shared<FOUT>()),
+        streaming_(false),
+        used_elements_(ElementRange::All()) {
+  }
+
+  virtual bool streaming() const noexcept override final {
+    return streaming_;
+  }
+
+  virtual void set_streaming(bool value) noexcept override final {
+    streaming_ = value;
+  }
+
+  virtual ElementRange used_elements() const noexcept override final {
+    return used_elements_;
+  }
+
+  virtual void set_used_elements(const ElementRange& value)
+      noexcept override final {
+    used_elements_ = value;
   }
 
   virtual const std::shared_ptr<BufferFormat> InputFormat()
@@ -105,6 +124,8 @@ class TransformBase : public virtual Transform,
  protected:
   std::shared_ptr<FIN> input_format_;
   std::shared_ptr<FOUT> output_format_;
+  bool streaming_;
+  ElementRange used_elements_;
 
   typedef typename FIN::BufferType InElement;
   typedef typename FOUT::BufferType OutElement;
@@ -166,6 +187,9 @@ class TransformBase : public virtual Transform,
     static ParameterSettersMap own;
     return &own;
   }
+
+  static void FlushParameters() noexcept {
+  }
 };
 
 /// @brief Common base of transforms which do not change the buffer format.
@@ -258,16 +282,30 @@ public:                                                                        \
 protected:                                                                     \
   virtual const SupportedParametersMap&                                        \
   SupportedParameters() const noexcept override {                              \
+    FlushParameters();                                                         \
     return SupportedParametersPtr()->empty()?                                  \
         *ParentType::SupportedParametersPtr() : *SupportedParametersPtr();     \
   }                                                                            \
                                                                                \
   virtual const ParameterSettersMap&                                           \
   ParameterSetters() const noexcept override {                                 \
+    FlushParameters();                                                         \
     return ParameterSettersPtr()->empty()?                                     \
         *ParentType::ParameterSettersPtr() : *ParameterSettersPtr();           \
   }                                                                            \
                                                                                \
+  /* The parameters are registered on the first use, see TP */                 \
+  static void FlushParameters() noexcept {                                     \
+    ParentType::FlushParameters();                                             \
+    static bool flushed = [] {                                                 \
+      for (auto registration : *PendingParametersPtr()) {                      \
+        registration();                                                        \
+      }                                                                        \
+      return true;                                                             \
+    }();                                                                       \
+    (void)flushed;                                                             \
+  }                                                                            \
+                                                                               \
   static SupportedParametersMap* SupportedParametersPtr() noexcept {           \
     static SupportedParametersMap own;                                         \
     return &own;                                                               \
@@ -308,6 +346,11 @@ protected:                                                                     \
   }                                                                            \
                                                                                \
 private:                                                                       \
+  static std::vector<void(*)()>* PendingParametersPtr() noexcept {             \
+    static std::vector<void(*)()> own;                                         \
+    return &own;                                                               \
+  }                                                                            \
+                                                                               \
   static void RegisterParameter(                                               \
       const std::string& pname, const std::string& desc,                       \
       const std::string& defv, ParameterSetter&& setter) {                     \
@@ -332,6 +375,11 @@ private:                                                                       \
     return str;                                                                \
   }                                                                            \
                                                                                \
+  /* Used by RegisterTransform without instantiating */                        \
+  static const char* TransformName() noexcept {                                \
+    return name;                                                               \
+  }                                                                            \
+                                                                               \
   virtual const std::string& Description() const noexcept override {           \
     static const std::string str(description);                                 \
     return str;                                                                \
@@ -361,7 +409,13 @@ private:                                                                       \
   class name##_registration_class {                                            \
   public:                                                                      \
     name##_registration_class() {                                              \
-      SelfType::RegisterParameter(#name, desc, std::to_string(defv),           \
+      SelfType::PendingParametersPtr()->push_back(&Register);                  \
+    }                                                                          \
+    static void Register() {                                                   \
+      SelfType::RegisterParameter(                                             \
+          #name, desc,                                                         \
+          std::to_string(sound_feature_extraction::ParameterValue(             \
+              static_cast<type>(defv))),                                       \
                                   &SelfType::set_##name##_raw);                \
     }                                                                          \
     void Ref() const {}                                                        \
@@ -379,10 +433,14 @@ public:                                                                        \
                                                                                \
   void set_##name(const type& value) {                                         \
     if (!validate_##name(value)) {                                             \
-      throw InvalidParameterValueException(#name, std::to_string(value),       \
-                                           this->HostName());                  \
+      throw InvalidParameterValueException(                                    \
+          #name,                                                               \
+          std::to_string(sound_feature_extraction::ParameterValue(value)),     \
+          this->HostName());                                                   \
     }                                                                          \
-    this->UpdateParameter(#name, std::to_string(value));                       \
+    this->UpdateParameter(                                                     \
+        #name,                                                                 \
+        std::to_string(sound_feature_extraction::ParameterValue(value)));      \
     name##_ = value;                                                           \
   }
 
@@ -29,15 +29,51 @@
  */
 
 #include "src/transform_registry.h"
+#include <assert.h>
 #include <stdio.h>
+#include <string.h>
 #include <string>
 
 namespace sound_feature_extraction {
 
+namespace {
+
+class ReadLock {
+ public:
+  explicit ReadLock(pthread_rwlock_t* lock) noexcept : lock_(lock) {
+    pthread_rwlock_rdlock(lock_);
+  }
+
+  ~ReadLock() {
+    pthread_rwlock_unlock(lock_);
+  }
+
+ private:
+  pthread_rwlock_t* lock_;
+};
+
+class WriteLock {
+ public:
+  explicit WriteLock(pthread_rwlock_t* lock) noexcept : lock_(lock) {
+    pthread_rwlock_wrlock(lock_);
+  }
+
+  ~WriteLock() {
+    pthread_rwlock_unlock(lock_);
+  }
+
+ private:
+  pthread_rwlock_t* lock_;
+};
+
+}  // namespace
+
 TransformFactory::TransformFactory() {
+  pthread_rwlock_init(&lock_, nullptr);
 }
 
 TransformFactory::~TransformFactory() {
+  pthread_rwlock_destroy(&lock_);
 }
 
 const TransformFactory& TransformFactory::Instance() {
@@ -45,20 +81,66 @@ const TransformFactory& TransformFactory::Instance() {
 }
 
 const TransformFactory::FactoryMap& TransformFactory::Map() const {
+  WriteLock lock(&lock_);
+  Resolve(nullptr);
   return map_;
 }
 
+const TransformFactory::ConstructorsMap* TransformFactory::Find(
+    const std::string& name) const {
+  {
+    ReadLock lock(&lock_);
+    if (!Pending(name.c_str())) {
+      auto it = map_.find(name);
+      return it != map_.end()? &it->second : nullptr;
+    }
+  }
+  WriteLock lock(&lock_);
+  Resolve(name.c_str());
+  auto it = map_.find(name);
+  return it != map_.end()? &it->second : nullptr;
+}
+
 TransformFactory& TransformFactory::InstanceRW() {
   static TransformFactory instance;
   return instance;
 }
 
-TransformFactory::FactoryMap& TransformFactory::MapRW() {
-  return map_;
+void TransformFactory::Register(const TransformRegistration& registration) {
+  WriteLock lock(&lock_);
+  pending_.push_back(registration);
+}
+
+bool TransformFactory::Pending(const char* name) const noexcept {
+  for (auto& registration : pending_) {
+    if (registration.Name == nullptr || strcmp(name, registration.Name) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void TransformFactory::Resolve(const char* name) const {
+  for (size_t i = 0; i < pending_.size();) {
+    auto& registration = pending_[i];
+    if (name != nullptr && registration.Name != nullptr &&
+        strcmp(name, registration.Name) != 0) {
+      i++;
+      continue;
+    }
+    auto instance = registration.Create();
+    assert(registration.Name == nullptr ||
+           instance->Name() == registration.Name);
+    map_[instance->Name()].insert({
+      instance->InputFormat()->Id(), registration.Create
+    });
+    pending_[i] = pending_.back();
+    pending_.pop_back();
+  }
 }
 
 void TransformFactory::PrintRegisteredTransforms() const {
-  for (auto tit : map_) {
+  for (auto tit : Map()) {
     printf("%s\n", tit.first.c_str());
   }
 }
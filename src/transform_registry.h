@@ -31,10 +31,21 @@
 #ifndef SRC_TRANSFORM_REGISTRY_H_
 #define SRC_TRANSFORM_REGISTRY_H_
 
+#include <pthread.h>
+#include <vector>
 #include "src/transform.h"
 
 namespace sound_feature_extraction {
 
+/// @brief The entry of the static registration table. Nothing is
+/// instantiated until the transform is looked up.
+struct TransformRegistration {
+  /// @brief The name declared with TRANSFORM_INTRO or nullptr if only
+  /// an instance knows it, e.g. of a format converter.
+  const char* Name;
+  std::shared_ptr<Transform> (*Create)();
+};
+
 /// @brief Meyers singleton ideal for C++11.
 class TransformFactory {
   template <class T>
@@ -42,17 +53,27 @@ class TransformFactory {
  public:
   typedef std::function<std::shared_ptr<Transform>(void)> TransformConstructor;
 
-  typedef std::unordered_map<std::string,
-                             std::unordered_map<std::string,
-                                                TransformConstructor>>
-      FactoryMap;
+  typedef std::unordered_map<std::string, TransformConstructor>
+      ConstructorsMap;
+
+  typedef std::unordered_map<std::string, ConstructorsMap> FactoryMap;
 
   /// @brief Returns a unique instance of TransformFactory class.
   static const TransformFactory& Instance();
 
   /// @brief Returns the hash map which stores the registered transforms.
+  /// @note This instantiates all of them, use Find() to look up a single
+  /// transform.
   const FactoryMap& Map() const;
 
+  /// @brief Returns the constructors of the transform by the input format
+  /// identifiers, or nullptr if it is not registered.
+  /// @details Only the transforms with this name and the ones without
+  /// the static name are instantiated, so the parameters of the rest are
+  /// never registered. The resolved transforms are looked up under a shared
+  /// lock, so that the concurrent setups do not serialize on it.
+  const ConstructorsMap* Find(const std::string& name) const;
+
   /// @brief Prints the names of registered transforms to stdout.
   void PrintRegisteredTransforms() const;
 
@@ -64,11 +85,31 @@ class TransformFactory {
 
   static TransformFactory& InstanceRW();
 
-  FactoryMap& MapRW();
+  void Register(const TransformRegistration& registration);
+
+  /// @brief Moves the pending registrations with the specified name
+  /// (any if nullptr) to map_. The caller must hold lock_ for writing.
+  void Resolve(const char* name) const;
+  /// @brief Indicates whether Resolve(name) has anything to move.
+  /// The caller must hold lock_.
+  bool Pending(const char* name) const noexcept;
 
-  FactoryMap map_;
+  mutable FactoryMap map_;
+  mutable std::vector<TransformRegistration> pending_;
+  mutable pthread_rwlock_t lock_;
 };
 
+/// @brief Returns the name declared with TRANSFORM_INTRO.
+template <class T>
+auto StaticTransformName(int) noexcept -> decltype(T::TransformName()) {
+  return T::TransformName();
+}
+
+template <class T>
+const char* StaticTransformName(...) noexcept {
+  return nullptr;
+}
+
 /// @brief Helper class used to register transforms. Usually, you do not
 /// want to use it explicitly but rather through REGISTER_TRANSFORM macro.
 template<class T>
@@ -79,15 +120,19 @@ class RegisterTransform {
   /// transform's object file (declared in .cc using REGISTER_TRANSFORM macro).
   /// @details Using TransformFactory lazy singleton is safe even during library
   /// load process, thanks to guaranteed local static variables behavior.
+  /// The transform is not instantiated here, it only adds the entry to
+  /// the registration table.
   /// @note Never use any global or static variables in your transform's
   /// default constructor! The order of execution of static constructors is
   /// undefined.
   RegisterTransform() {
-    TransformFactory::FactoryMap& map = TransformFactory::InstanceRW().MapRW();
-    // Instantiate a new instance of the transform "T"
-    T t;
-    // Insert the constructor function make_shared<T> -> shared_ptr<T>
-    map[t.Name()].insert({t.InputFormat()->Id(), std::make_shared<T>});
+    TransformFactory::InstanceRW().Register(
+        { StaticTransformName<T>(0), &RegisterTransform::Create });
+  }
+
+ private:
+  static std::shared_ptr<Transform> Create() {
+    return std::make_shared<T>();
   }
 };
 
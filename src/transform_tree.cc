@@ -29,20 +29,86 @@
  */
 
 #include "src/transform_tree.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <cassert>
+#include <cerrno>
+#include <cstdint>
 #include <cmath>
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <algorithm>
+#include <exception>
 #include <fstream>
 #include <iomanip>
+#include <mutex>
+#include <random>
+#include <set>
+#include <sstream>
 #include <string>
+#include <unordered_set>
 #include <utility>
+#include "src/allocators/interval_packing_allocator.h"
 #include "src/allocators/sliding_blocks_allocator.h"
+#include "src/allocators/worst_allocator.h"
+#include "src/cancellation.h"
 #include "src/formats/array_format.h"
+#include "src/formats/int16_to_float.h"
 #include "src/format_converter.h"
+#include "src/make_unique.h"
 #include "src/transform_registry.h"
+#include "src/memory_pool.h"
 #include "src/memory_protector.h"
+#include "src/metrics.h"
+#include "src/elementwise_transform.h"
+#include "src/parallel_transform.h"
+#include "src/precomputed_state.h"
+#include "src/probes.h"
+#include "src/streaming_stores_transform.h"
+#include "src/struct_of_arrays_transform.h"
+#include "src/view_transform.h"
+#include "src/primitives/deinterleave.h"
+#include "src/profiler.h"
+#include "src/scratch_arena.h"
+#include "src/thread_pool.h"
+#include "src/threads_governor.h"
+#include "src/transforms/autocorrelation.h"
+#include "src/transforms/centroid.h"
+#include "src/transforms/cepstrum.h"
+#include "src/transforms/complex_magnitude.h"
+#include "src/transforms/complex_to_real.h"
+#include "src/transforms/dct.h"
+#include "src/transforms/diff.h"
+#include "src/transforms/dwpt.h"
+#include "src/transforms/elementwise_chain.h"
+#include "src/transforms/energy.h"
+#include "src/transforms/flux.h"
+#include "src/transforms/gate.h"
 #include "src/transforms/identity.h"
+#include "src/transforms/lpc.h"
+#include "src/transforms/lpc_cc.h"
+#include "src/transforms/lpcc.h"
+#include "src/transforms/mix_stereo.h"
+#include "src/transforms/mean.h"
+#include "src/transforms/power_spectrum.h"
+#include "src/transforms/preemphasis.h"
+#include "src/transforms/rdft.h"
+#include "src/transforms/rectify.h"
+#include "src/transforms/rolloff.h"
+#include "src/transforms/rotate.h"
+#include "src/transforms/selector.h"
+#include "src/transforms/sliding_reductions.h"
+#include "src/transforms/spectral_descriptors.h"
+#include "src/transforms/stats.h"
+#include "src/transforms/unpack_rdft.h"
+#include "src/transforms/window_splitter.h"
+#include "src/transforms/spectral_energy.h"
+#include "src/transforms/subband_energy.h"
+#include "src/transforms/zero_padding.h"
+#include "src/transforms/zerocrossings.h"
 
 #if (__GNUC__ == 4 && __GNUC_MINOR__ < 8)
 /// @brief Temporary fix for a buggy system_clock implementation in libstdc++.
@@ -54,15 +120,16 @@
 
 extern "C" {
 extern size_t get_cpu_cache_size(void);
+extern int get_omp_transforms_max_threads_num(void);
 }
 
 namespace sound_feature_extraction {
 
 class RootTransform : public Transform {
  public:
-  explicit RootTransform(
-      const std::shared_ptr<formats::ArrayFormat16>& format) noexcept
-      : format_(format) {
+  RootTransform(const std::shared_ptr<BufferFormat>& format,
+                SampleType sampleType) noexcept
+      : format_(format), sample_type_(sampleType) {
   }
 
   virtual const std::string& Name() const noexcept override {
@@ -83,7 +150,7 @@ class RootTransform : public Transform {
   virtual size_t SetInputFormat(
       const std::shared_ptr<BufferFormat>& format,
       size_t buffersCount) override {
-    format_ = std::static_pointer_cast<formats::ArrayFormat16>(format);
+    format_ = format;
     return buffersCount;
   }
 
@@ -112,8 +179,20 @@ class RootTransform : public Transform {
 
   virtual std::shared_ptr<Buffers> CreateOutputBuffers(
       size_t count, void* reusedMemory = nullptr) const noexcept override {
-    return std::make_shared<BuffersBase<int16_t*>>(format_, count,
-                                                   reusedMemory);
+    switch (sample_type_) {
+      case SampleType::kInt32:
+        return std::make_shared<BuffersBase<int32_t*>>(
+            std::static_pointer_cast<formats::ArrayFormat32>(format_), count,
+            reusedMemory);
+      case SampleType::kFloat:
+        return std::make_shared<BuffersBase<float*>>(
+            std::static_pointer_cast<formats::ArrayFormatF>(format_), count,
+            reusedMemory);
+      default:
+        return std::make_shared<BuffersBase<int16_t*>>(
+            std::static_pointer_cast<formats::ArrayFormat16>(format_), count,
+            reusedMemory);
+    }
   }
 
   virtual void Do(const Buffers& in, Buffers *out) const noexcept override {
@@ -121,7 +200,8 @@ class RootTransform : public Transform {
   }
 
  private:
-  std::shared_ptr<formats::ArrayFormat16> format_;
+  std::shared_ptr<BufferFormat> format_;
+  SampleType sample_type_;
 };
 
 TransformTree::Node::Node(Node* parent,
@@ -133,17 +213,27 @@ TransformTree::Node::Node(Node* parent,
       Parent(parent),
       BoundTransform(boundTransform),
       BoundBuffers(nullptr),
+      Offset(0),
       BuffersCount(buffersCount),
       Protection(nullptr),
       Next(nullptr),
       OriginalNode(nullptr),
       CycleId(0),
+      SliceIndex(-1),
       HasClones(false),
-      ElapsedTime(new std::chrono::high_resolution_clock::duration()) {
+      Id(0),
+      DumpBuffers(false),
+      View(false),
+      InPlace(false),
+      Packed(false),
+      Pinned(false),
+      Gate(nullptr),
+      GateIndex(-1),
+      LastTicks(0) {
 }
 
 void TransformTree::Node::ActionOnEachTransformInSubtree(
-    const std::function<void(const Transform&)> action) const {
+    const std::function<void(const Transform&)>& action) const {
   action(*BoundTransform);
   for (auto& subnodes : Children) {
     for (auto& inode : subnodes.second) {
@@ -153,7 +243,7 @@ void TransformTree::Node::ActionOnEachTransformInSubtree(
 }
 
 void TransformTree::Node::ActionOnSubtree(
-    const std::function<void(const Node&)> action) const {
+    const std::function<void(const Node&)>& action) const {
   action(*this);
   for (auto& subnodes : Children) {
     for (const auto& inode : subnodes.second) {
@@ -164,7 +254,7 @@ void TransformTree::Node::ActionOnSubtree(
 }
 
 void TransformTree::Node::ActionOnSubtree(
-    const std::function<void(Node&)> action) {
+    const std::function<void(Node&)>& action) {
   action(*this);
   for (auto& subnodes : Children) {
     for (auto& inode : subnodes.second) {
@@ -174,7 +264,7 @@ void TransformTree::Node::ActionOnSubtree(
 }
 
 void TransformTree::Node::ActionOnEachImmediateChild(
-    const std::function<void(Node&)> action) {
+    const std::function<void(Node&)>& action) {
   for (auto& subnodes : Children) {
     for (auto& inode : subnodes.second) {
       action(*inode);
@@ -183,7 +273,7 @@ void TransformTree::Node::ActionOnEachImmediateChild(
 }
 
 void TransformTree::Node::ActionOnEachImmediateChild(
-    const std::function<void(const Node&)> action) const {
+    const std::function<void(const Node&)>& action) const {
   for (const auto& subnodes : Children) {  // NOLINT(*)
     for (const auto& inode : subnodes.second) {  // NOLINT(*)
       action(*inode);
@@ -192,7 +282,7 @@ void TransformTree::Node::ActionOnEachImmediateChild(
 }
 
 void TransformTree::Node::ActionOnEachParent(
-    const std::function<void(const Node&)> action) const {
+    const std::function<void(const Node&)>& action) const {
   if (Parent != nullptr) {
     action(*Parent);
     Parent->ActionOnEachParent(action);
@@ -212,31 +302,118 @@ TransformTree::Node::FindIdenticalChildTransform(
   return nullptr;
 }
 
+std::shared_ptr<TransformTree::Node>
+TransformTree::Node::FindEquivalentChildTransform(
+    const Transform& base) const noexcept {
+  auto tv = Children.find(base.Name());
+  if (tv == Children.end()) return nullptr;
+  auto matches = [](const Transform& transform, const ParametersMap& values) {
+    for (auto& value : values) {
+      if (transform.GetParameters().find(value.first)->second !=
+          value.second) {
+        return false;
+      }
+    }
+    return true;
+  };
+  for (auto& equivalence : Host->equivalences_) {
+    if (equivalence.Transform != base.Name() ||
+        !matches(base, equivalence.Values)) {
+      continue;
+    }
+    for (auto node : tv->second) {
+      if (node->BoundTransform->streaming() == base.streaming() &&
+          matches(*node->BoundTransform, equivalence.Values)) {
+        return node;
+      }
+    }
+  }
+  return nullptr;
+}
+
 void TransformTree::Node::BuildAllocationTree(
     memory_allocation::Node* node) const noexcept {
-  DBG("Requires %zu bytes",
-      BuffersCount * BoundTransform->OutputFormat()->SizeInBytes());
-  node->Children.reserve(ChildrenCount());
+  if (!View && !InPlace) {
+    DBG("Requires %zu bytes", AllocationSize());
+    // The children of the views are appended in place, so the pointers
+    // to the elements must stay valid
+    node->Children.reserve(AllocationChildrenCount());
+  }
   for (auto& subnodes : Children) {
     for (auto& inode : subnodes.second) {
-      size_t size =  inode->BuffersCount *
-          inode->BoundTransform->OutputFormat()->SizeInBytes();
-      memory_allocation::Node child(size, node, inode.get());
+      if (inode->View || inode->InPlace) {
+        // The parent's buffers must outlive the children which share them
+        inode->BuildAllocationTree(node);
+        continue;
+      }
+      // The pinned buffers are placed apart, see Prepare()
+      memory_allocation::Node child(
+          inode->Pinned? 0 : inode->AllocationSize(), node, inode.get());
       node->Children.push_back(child);
       inode->BuildAllocationTree(&node->Children.back());
     }
   }
 }
 
+size_t TransformTree::Node::AllocationChildrenCount() const noexcept {
+  size_t count = 0;
+  for (auto& subnodes : Children) {
+    for (auto& inode : subnodes.second) {
+      count += inode->View || inode->InPlace?
+          inode->AllocationChildrenCount() : 1;
+    }
+  }
+  return count;
+}
+
 void TransformTree::Node::ApplyAllocationTree(
     const memory_allocation::Node& node,
     void* allocatedMemory) noexcept {
   auto mem_ptr = reinterpret_cast<char*>(allocatedMemory) + node.Address;
-  BoundBuffers = BoundTransform->CreateOutputBuffers(
-      BuffersCount, mem_ptr);
+  Offset = node.Address;
+  if (Packed) {
+    // BuffersBase adds no data, the same as with the strided views
+    BoundBuffers = std::make_shared<Buffers>(
+        BoundTransform->OutputFormat(), BuffersCount, mem_ptr,
+        PackedStride(*this));
+  } else {
+    BoundBuffers = BoundTransform->CreateOutputBuffers(
+        BuffersCount, mem_ptr);
+  }
   if (node.Next != nullptr) {
     Next = reinterpret_cast<TransformTree::Node*>(node.Next->Item);
   }
+  // The views and the in-place nodes, including their own such children,
+  // share these buffers
+  std::vector<Node*> sharing;
+  auto push_sharing = [&sharing](Node& child) {
+    if (child.View || child.InPlace) {
+      sharing.push_back(&child);
+    }
+  };
+  ActionOnEachImmediateChild(push_sharing);
+  while (!sharing.empty()) {
+    auto child = sharing.back();
+    sharing.pop_back();
+    child->Offset = Offset;
+    auto stride = child->View? ViewStride(*child) : 0;
+    if (stride == 0) {
+      child->BoundBuffers = child->BoundTransform->CreateOutputBuffers(
+          child->BuffersCount, mem_ptr);
+    } else {
+      // The overlapping buffers of a strided view
+      child->BoundBuffers = std::make_shared<Buffers>(
+          child->BoundTransform->OutputFormat(), child->BuffersCount,
+          mem_ptr, stride);
+    }
+    if (child->InPlace) {
+      // Overwrite the parent right after it has been calculated; its
+      // parent is never a view (see IsInPlace())
+      child->Next = child->Parent->Next;
+      child->Parent->Next = child;
+    }
+    child->ActionOnEachImmediateChild(push_sharing);
+  }
 
   for (size_t i = 0; i < node.Children.size(); i++) {
     TransformTree::Node* child = reinterpret_cast<TransformTree::Node*>(
@@ -245,71 +422,329 @@ void TransformTree::Node::ApplyAllocationTree(
   }
 }
 
-void TransformTree::Node::Execute() noexcept {
-  if (Parent != nullptr) {
-    DBG("Executing %s on %zu buffers -> %zu...",
-        BoundTransform->Name().c_str(),
-        Parent->BoundBuffers->Count(), BoundBuffers->Count());
-    auto checkPointStart = std::chrono::high_resolution_clock::now();
-    std::shared_ptr<Buffers> parent_buffers;
-    if (Parent->Slices.size() == 0 || OriginalNode == nullptr) {
-      parent_buffers = Parent->BoundBuffers;
-    } else {
-      size_t index, length;
-      std::tie(index, length) = Parent->Slices[this];
-      assert(length > 0);
-      parent_buffers = std::make_shared<Buffers>(
-          Parent->BoundBuffers->Slice(index, length));
-    }
-    BoundTransform->Do(*parent_buffers, BoundBuffers.get());
-    auto checkPointFinish = std::chrono::high_resolution_clock::now();
-    *ElapsedTime += checkPointFinish - checkPointStart;
-    Host->transforms_cache_[BoundTransform->Name()].ElapsedTime += *ElapsedTime;
-
-    if (Host->memory_protection() && ChildrenCount() == 0 &&
-        OriginalNode == nullptr) {
-      // This is a leaf, disable any further writing to the corr. memory block
-      auto ptr = std::const_pointer_cast<const Buffers>(BoundBuffers)->Data();
-      DBG("Enabling write protection on %p:%zu",
-          ptr, BoundBuffers->SizeInBytes());
-      Protection = std::make_shared<MemoryProtector>(
-          ptr, BoundBuffers->SizeInBytes());
-    }
-
-    if (Host->validate_after_each_transform()) {
-      try {
-        BoundBuffers->Validate();
-      }
-      catch(const InvalidBuffersException& e) {
-#ifdef DEBUG
-        if (BoundBuffers->Count() == Parent->BoundBuffers->Count()) {
-          ERR("Validation failed on index %zu.\n----before----\n%s\n\n"
-              "----after----\n%s\n",
-              e.index(),
-              parent_buffers->Dump(e.index()).c_str(),
-              BoundBuffers->Dump(e.index()).c_str());
-        } else {
-          ERR("Validation failed.\n----Buffers before----\n%s\n\n"
-              "----Buffers after----\n%s\n",
-              parent_buffers->Dump().c_str(),
-              BoundBuffers->Dump().c_str());
+void TransformTree::Node::Execute(ExecutionContext* context) noexcept {
+  if (ExecutionCancelled()) {
+    return;
+  }
+  if (Active(context)) {
+    ExecuteBoundTransform(context);
+  }
+  auto next = Next;
+  if (next != nullptr && next->OriginalNode != nullptr &&
+      Host->parallel_slices()) {
+    next = next->ExecuteSlices(context);
+  }
+  if (next) {
+    next->Execute(context);
+  }
+}
+
+TransformTree::Node* TransformTree::Node::ExecuteSlices(
+    ExecutionContext* context) noexcept {
+  // Each slice starts with a clone of the first node under the cycle's head
+  auto& slices = SliceStarts;
+  assert(!slices.empty());
+  auto node = this;
+  while (node != nullptr && node->OriginalNode != nullptr &&
+         node->CycleId == CycleId) {
+    node = node->Next;
+  }
+  int slices_count = slices.size();
+  auto start = std::chrono::high_resolution_clock::now();
+  SFE_PROBE2(slices__start, CycleId, slices_count);
+  // The slices read the disjoint parts of the head's buffers and write
+  // the disjoint parts of the cycle's buffers (see BuildSlicedCycles()),
+  // so they do not depend on each other. The nested parallel loops of
+  // the transforms are executed by the threads which wait for them.
+  ThreadPool::Instance().ParallelFor(
+      slices_count, 1, get_omp_transforms_max_threads_num(),
+      [&](int begin, int end) {
+    for (int i = begin; i < end; i++) {
+      SFE_PROBE2(slice__start, CycleId, i);
+      auto last = i < slices_count - 1? slices[i + 1] : node;
+      for (auto snode = slices[i]; snode != last; snode = snode->Next) {
+        if (ExecutionCancelled()) {
+          return;
         }
-#endif
-        throw TransformResultedInInvalidBuffersException(BoundTransform->Name(),
-                                                         e.what());
+        if (snode->Active(context)) {
+          snode->ExecuteBoundTransform(context);
+        }
+      }
+      SFE_PROBE2(slice__end, CycleId, i);
+    }
+  });
+  SFE_PROBE2(slices__end, CycleId, slices_count);
+  for (auto snode = slices[0]; snode != node; snode = snode->Next) {
+    Host->Sink(Host->sinks_[snode->Id], context);
+  }
+  if (Host->profiler_ && !Host->realtime_) {
+    Host->profiler_->AddRegion(
+        "Cycle " + std::to_string(CycleId) + " slices", start,
+        std::chrono::high_resolution_clock::now());
+  }
+  return node;
+}
+
+void TransformTree::Node::BindInput(
+    void* input, ExecutionContext* context) const noexcept {
+  ContextBuffers(context)->Rebind(input);
+  for (auto& subnodes : Children) {
+    for (auto& child : subnodes.second) {
+      if (child->View) {
+        child->BindInput(input, context);
+      }
+    }
+  }
+}
+
+std::string TransformTree::Node::ProfileName() const noexcept {
+  auto original = OriginalNode != nullptr? OriginalNode : this;
+  std::string name = original->BoundTransform->Name() + " [";
+  for (size_t i = 0; i < original->RelatedFeatures.size(); i++) {
+    if (i > 0) {
+      name += ", ";
+    }
+    name += Host->FeatureName(original->RelatedFeatures[i]);
+  }
+  return name + "]";
+}
+
+void TransformTree::Node::ExecuteInParallel(
+    ExecutionContext* context) noexcept {
+  // The skipped node's descendants are skipped as well
+  if (!Active(context) || ExecutionCancelled()) {
+    return;
+  }
+  ExecuteBoundTransform(context);
+  // The children only read BoundBuffers of this node and their own buffers
+  // do not overlap (see PrepareForExecution()), so each subtree is a task.
+  // The calling thread takes the last subtree itself.
+  ThreadPool::TaskGroup tasks;
+  Node* last = nullptr;
+  for (auto& subnodes : Children) {
+    for (auto& inode : subnodes.second) {
+      if (last != nullptr) {
+        tasks.Spawn([last, context] { last->ExecuteInParallel(context); });
       }
+      last = inode.get();
+    }
+  }
+  if (last != nullptr) {
+    last->ExecuteInParallel(context);
+  }
+  tasks.Wait();
+}
+
+const std::shared_ptr<Buffers>& TransformTree::Node::ContextBuffers(
+    const ExecutionContext* context) const noexcept {
+  if (context == nullptr) {
+    return BoundBuffers;
+  }
+  return context->buffers_.find(this)->second;
+}
+
+bool TransformTree::Node::Active(
+    const ExecutionContext* context) const noexcept {
+  auto& active = context == nullptr? Host->active_nodes_
+                                   : context->active_nodes_;
+  return active.empty() || active[Id];
+}
+
+void TransformTree::Node::ExecuteBoundTransform(
+    ExecutionContext* context) noexcept {
+  if (Parent == nullptr || View) {
+    return;
+  }
+  auto& bound_buffers = ContextBuffers(context);
+  auto& parent_bound_buffers = Parent->ContextBuffers(context);
+  if (Gate == nullptr) {
+    ExecuteBoundTransform(context, parent_bound_buffers.get(),
+                          bound_buffers.get());
+    // The concurrent slices are sunk by ExecuteSlices() after all of them
+    if (SliceIndex < 0 || !Host->parallel_slices()) {
+      Host->Sink(Host->sinks_[Id], context);
+    }
+    return;
+  }
+  // The gate packed the frames which passed at the beginning
+  auto& selections = context == nullptr? Host->gate_selections_
+                                        : context->gate_selections_;
+  size_t count = selections[Gate->GateIndex].Count;
+  if (count == 0) {
+    return;
+  }
+  auto in = parent_bound_buffers->Slice(0, count);
+  auto out = bound_buffers->Slice(0, count);
+  ExecuteBoundTransform(context, &in, &out);
+}
+
+void TransformTree::Node::ExecuteBoundTransform(
+    ExecutionContext* context, Buffers* in, Buffers* out) noexcept {
+  DBG("Executing %s on %zu buffers -> %zu...",
+      BoundTransform->Name().c_str(), in->Count(), out->Count());
+  // Reading the hardware counters and the profiler are not real-time safe
+  bool realtime = Host->realtime_;
+  auto level = Host->profiling_level_;
+  if (realtime && level == ProfilingLevel::kFull) {
+    level = ProfilingLevel::kCoarse;
+  }
+  bool profiled = Host->profiler_ && !realtime;
+  std::chrono::high_resolution_clock::time_point checkPointStart;
+  if (profiled) {
+    checkPointStart = std::chrono::high_resolution_clock::now();
+  }
+  HardwareCounters::Values hw_start;
+  if (level == ProfilingLevel::kFull) {
+    HardwareCounters::Read(&hw_start);
+  }
+  uint64_t ticks_start = level != ProfilingLevel::kOff? TickClock::Now() : 0;
+  Buffers* parent_buffers = in;
+  if (Parent->Slices.size() > 0 && OriginalNode != nullptr) {
+    size_t index, length;
+    std::tie(index, length) = Parent->Slices.find(this)->second;
+    auto& slice = context == nullptr? ParentSlice
+                                    : context->slices_.find(this)->second;
+    assert(slice && slice->Count() == length);
+    slice->Rebind((*in)[index]);
+    parent_buffers = slice.get();
+  }
+  // The clones are reported as the original nodes with SliceIndex >= 0
+  size_t id = (OriginalNode != nullptr? OriginalNode : this)->Id;
+  SFE_PROBE5(node__start, id, BoundTransform->Name().c_str(),
+             parent_buffers->Count(), out->Count(), SliceIndex);
+  bool guarded = Host->memory_guards_ && OriginalNode == nullptr;
+  if (guarded) {
+    SetGuard(context);
+  }
+  if (GateIndex >= 0) {
+    auto& selections = context == nullptr? Host->gate_selections_
+                                          : context->gate_selections_;
+    auto& selection = selections[GateIndex];
+    selection.Total = parent_buffers->Count();
+    auto& gate = dynamic_cast<const transforms::Gate&>(*BoundTransform);
+    selection.Count = gate.Select(*parent_buffers, selection.Indices.data(),
+                                  out);
+  } else {
+    BoundTransform->Do(*parent_buffers, out);
+  }
+  if (guarded) {
+    CheckGuard(context);
+  }
+  SFE_PROBE4(node__end, id, BoundTransform->Name().c_str(), out->Count(),
+             SliceIndex);
+  if (level != ProfilingLevel::kOff) {
+    // Each node has its own slot, so no synchronization is needed
+    auto& counters = (context == nullptr? Host->counters_
+                                        : context->counters_)[Id];
+    uint64_t ticks = TickClock::Now() - ticks_start;
+    counters.Ticks += ticks;
+    counters.Runs++;
+    LastTicks.store(ticks, std::memory_order_relaxed);
+    if (level == ProfilingLevel::kFull) {
+      HardwareCounters::Values hw_finish;
+      HardwareCounters::Read(&hw_finish);
+      counters.Cycles += hw_finish.Cycles - hw_start.Cycles;
+      counters.Instructions += hw_finish.Instructions -
+          hw_start.Instructions;
+      counters.CacheMisses += hw_finish.CacheMisses - hw_start.CacheMisses;
     }
+  }
+  if (profiled) {
+    Host->profiler_->AddNodeSample(
+        OriginalNode != nullptr? OriginalNode : this, ProfileName(),
+        checkPointStart, std::chrono::high_resolution_clock::now(),
+        parent_buffers->SizeInBytes(), out->SizeInBytes(), SliceIndex);
+  }
 
-    if (Host->transforms_cache_[BoundTransform->Name()].Dump ||
-        Host->dump_buffers_after_each_transform()) {
-      INF("Buffers after %s", BoundTransform->Name().c_str());
-      INF("==============%s",
-          std::string(BoundTransform->Name().size(), '=').c_str());
-      INF("%s", BoundBuffers->Dump().c_str());
+  // The gated leaves are written again by ScatterGated()
+  if (Host->protect_execution_ && ChildrenCount() == 0 &&
+      OriginalNode == nullptr && context == nullptr && Gate == nullptr &&
+      GateIndex < 0) {
+    // This is a leaf, disable any further writing to the corr. memory block
+    auto ptr = std::const_pointer_cast<const Buffers>(BoundBuffers)->Data();
+    DBG("Enabling write protection on %p:%zu",
+        ptr, BoundBuffers->SizeInBytes());
+    Protection = std::make_shared<MemoryProtector>(
+        ptr, BoundBuffers->SizeInBytes());
+  }
+
+  if (context != nullptr? context->validate_ : Host->validate_execution_) {
+    try {
+      out->Validate();
+    }
+    catch(const InvalidBuffersException& e) {
+#ifdef DEBUG
+      if (out->Count() == in->Count()) {
+        ERR("Validation failed on index %zu.\n----before----\n%s\n\n"
+            "----after----\n%s\n",
+            e.index(),
+            parent_buffers->Dump(e.index()).c_str(),
+            out->Dump(e.index()).c_str());
+      } else {
+        ERR("Validation failed.\n----Buffers before----\n%s\n\n"
+            "----Buffers after----\n%s\n",
+            parent_buffers->Dump().c_str(),
+            out->Dump().c_str());
+      }
+#endif
+      throw TransformResultedInInvalidBuffersException(BoundTransform->Name(),
+                                                       e.what());
     }
   }
-  if (Next) {
-    Next->Execute();
+
+  auto& capture = Host->capture_;
+  if (capture && !realtime && capture->Captures(BoundTransform->Name())) {
+    capture->Capture(
+        context != nullptr?
+            context->capture_execution_ : Host->capture_execution_,
+        id, SliceIndex, BoundTransform->Name(), *out);
+  }
+
+  if (!realtime &&
+      (DumpBuffers || Host->dump_buffers_after_each_transform())) {
+    INF("Buffers after %s", BoundTransform->Name().c_str());
+    INF("==============%s",
+        std::string(BoundTransform->Name().size(), '=').c_str());
+    INF("%s", out->Dump().c_str());
+  }
+}
+
+size_t TransformTree::Node::AllocationSize() const noexcept {
+  size_t size = BoundTransform->OutputFormat()->SizeInBytes();
+  if (Packed && BuffersCount > 0 && HasPaddingChild(*this)) {
+    // ZeroPadding fills the whole stride of the last buffer as well
+    size = BuffersCount * PackedStride(*this);
+  } else if (Packed && BuffersCount > 0) {
+    // Matches Buffers::SizeInBytes(), the last buffer keeps the padding
+    size += (BuffersCount - 1) * PackedStride(*this);
+  } else {
+    size *= BuffersCount;
+  }
+  return size + (Host->memory_guards_? kGuardSize : 0);
+}
+
+void TransformTree::Node::SetGuard(ExecutionContext* context) noexcept {
+  auto& buffers = ContextBuffers(context);
+  // Buffers::Data() is protected, the memory is ours anyway
+  auto guard = const_cast<char*>(reinterpret_cast<const char*>(
+      std::const_pointer_cast<const Buffers>(buffers)->Data())) +
+      buffers->SizeInBytes();
+  uint32_t word = kGuardWord;
+  for (size_t i = 0; i < kGuardSize; i += sizeof(word)) {
+    std::memcpy(guard + i, &word, sizeof(word));
+  }
+}
+
+void TransformTree::Node::CheckGuard(ExecutionContext* context) const {
+  auto& buffers = ContextBuffers(context);
+  auto guard = reinterpret_cast<const char*>(
+      std::const_pointer_cast<const Buffers>(buffers)->Data()) +
+      buffers->SizeInBytes();
+  uint32_t word = kGuardWord;
+  for (size_t i = 0; i < kGuardSize; i += sizeof(word)) {
+    if (std::memcmp(guard + i, &word, sizeof(word)) != 0) {
+      throw BufferOverrunException(BoundTransform->Name(), guard + i);
+    }
   }
 }
 
@@ -333,44 +768,98 @@ std::shared_ptr<TransformTree::Node> TransformTree::Node::SelfPtr()
 }
 
 TransformTree::TransformTree(formats::ArrayFormat16&& rootFormat) noexcept
-    : Logger("TransformTree", EINA_COLOR_ORANGE),
-      root_(std::make_shared<Node>(
-        nullptr, std::make_shared<RootTransform>(
-            std::make_shared<formats::ArrayFormat16>(rootFormat)), 1, this)),
-      root_format_(std::make_shared<formats::ArrayFormat16>(rootFormat)),
-      tree_is_prepared_(false),
-      cache_optimization_(true),
-      memory_protection_(true),
-      validate_after_each_transform_(false),
-      dump_buffers_after_each_transform_(false) {
+    : TransformTree(std::make_shared<formats::ArrayFormat16>(rootFormat)) {
 }
 
 TransformTree::TransformTree(
     const std::shared_ptr<formats::ArrayFormat16>& rootFormat) noexcept
+    : TransformTree(rootFormat, rootFormat->Size(), SampleType::kInt16) {
+}
+
+TransformTree::TransformTree(
+    const std::shared_ptr<formats::ArrayFormat32>& rootFormat) noexcept
+    : TransformTree(rootFormat, rootFormat->Size(), SampleType::kInt32) {
+}
+
+TransformTree::TransformTree(
+    const std::shared_ptr<formats::ArrayFormatF>& rootFormat) noexcept
+    : TransformTree(rootFormat, rootFormat->Size(), SampleType::kFloat) {
+}
+
+TransformTree::TransformTree(const std::shared_ptr<BufferFormat>& rootFormat,
+                             size_t rootSize, SampleType sampleType) noexcept
     : Logger("TransformTree", EINA_COLOR_ORANGE),
+      allocated_size_(0),
+      pinned_size_(0),
+      peak_size_(0),
+      prepare_times_(),
       root_(std::make_shared<Node>(
-        nullptr, std::make_shared<RootTransform>(rootFormat), 1, this)),
+        nullptr, std::make_shared<RootTransform>(rootFormat, sampleType), 1,
+        this)),
       root_format_(rootFormat),
+      root_size_(rootSize),
+      root_sample_type_(sampleType),
       tree_is_prepared_(false),
+      layout_version_(0),
       cache_optimization_(true),
+      cache_autotuning_(false),
+      warm_up_(false),
+      memory_budget_(0),
+      parallel_slices_(false),
+      profiling_level_(ProfilingLevel::kCoarse),
+      all_time_(std::chrono::high_resolution_clock::duration::zero()),
       memory_protection_(true),
+      memory_protection_period_(1),
+      protection_counter_(0),
+      protect_execution_(false),
+      memory_guards_(false),
       validate_after_each_transform_(false),
-      dump_buffers_after_each_transform_(false) {
+      validation_period_(1),
+      validation_counter_(0),
+      validate_execution_(false),
+      dump_buffers_after_each_transform_(false),
+      capture_execution_(0),
+      parallel_execution_(false),
+      fuse_transforms_(true),
+      streaming_stores_(false),
+      packed_results_(false),
+      constant_input_shortcut_(false),
+      constant_input_hits_(0),
+      allocation_strategy_(AllocationStrategy::kSlidingBlocks),
+      streaming_(false),
+      accuracy_(Accuracy::kExact),
+      channels_layout_(ChannelsLayout::kPlanar),
+      realtime_(false),
+      realtime_prepared_(false),
+      realtime_version_(0),
+      realtime_scratch_size_(0),
+      merged_nodes_count_(0),
+      merged_bytes_(0),
+      approximately_merged_nodes_count_(0),
+      approximately_saved_work_(0),
+      approximate_chain_(false) {
 }
 
-std::shared_ptr<formats::ArrayFormat16> TransformTree::RootFormat()
-    const noexcept {
+std::shared_ptr<BufferFormat> TransformTree::RootFormat() const noexcept {
   return root_format_;
 }
 
+size_t TransformTree::RootSize() const noexcept {
+  return root_size_;
+}
+
+SampleType TransformTree::root_sample_type() const noexcept {
+  return root_sample_type_;
+}
+
 void TransformTree::AddTransform(const std::string& name,
                                  const std::string& parameters,
                                  const std::string& relatedFeature,
                                  std::shared_ptr<Node>* currentNode) {
   DBG("Adding \"%s\" (parameters \"%s\")", name.c_str(), parameters.c_str());
   // Search for the constructor of the transform "tname"
-  auto tfit = TransformFactory::Instance().Map().find(name);
-  if (tfit == TransformFactory::Instance().Map().end()) {
+  auto tfit = TransformFactory::Instance().Find(name);
+  if (tfit == nullptr) {
     throw TransformNotRegisteredException(name);
   }
   // tfit is actually a map from input format to real constructor
@@ -379,12 +868,12 @@ void TransformTree::AddTransform(const std::string& name,
   if (name == transforms::Identity::kName) {
     format_id = IdentityFormat().Id();
   }
-  auto ctorit = tfit->second.find(format_id);
-  if (ctorit == tfit->second.end()) {
+  auto ctorit = tfit->find(format_id);
+  if (ctorit == tfit->end()) {
     DBG("Formats mismatch, iterating input formats (%zu)",
-        tfit->second.size());
+        tfit->size());
     // No matching format found, try to add the format converter first
-    for (auto& ctoritfmt : tfit->second) {
+    for (auto& ctoritfmt : *tfit) {
       auto t = ctoritfmt.second();
       DBG("Probing %s -> %s",
           (*currentNode)->BoundTransform->OutputFormat()->Id().c_str(),
@@ -410,27 +899,47 @@ void TransformTree::AddTransform(const std::string& name,
 
   // Create the transform "name"
   auto t = ctor();
+  t->set_streaming(streaming_);
+  t->set_accuracy(accuracy_);
   {
     auto tparams = Transform::Parse(parameters);
     t->SetParameters(tparams);
   }
   // Try to reuse an existing node
   auto reused_node = (*currentNode)->FindIdenticalChildTransform(*t);
+  if (reused_node == nullptr && !equivalences_.empty()) {
+    reused_node = (*currentNode)->FindEquivalentChildTransform(*t);
+    approximate_chain_ |= reused_node != nullptr;
+  }
   if (reused_node != nullptr) {
     *currentNode = reused_node;
+    if (name != transforms::Identity::kName) {
+      if (approximate_chain_) {
+        approximately_merged_nodes_count_++;
+        approximately_saved_work_ += EstimatedWork(*reused_node);
+      } else {
+        merged_nodes_count_++;
+        merged_bytes_ += reused_node->BuffersCount *
+            reused_node->BoundTransform->OutputFormat()->SizeInBytes();
+      }
+    }
     // If this node is the exit node for some feature, redirect that feature to
     // an appended Identity transform. This step is necessary due to the way
     // memory allocation works. Particularly, the node is considered to be
     // a leaf if and only if the number of it's children equals to 0.
-    auto related_feature = std::find_if(
-        features_.begin(), features_.end(),
-        [reused_node](const std::pair<std::string, std::shared_ptr<Node>>& el) {
-      return el.second == reused_node;
-    });
-    if (related_feature != features_.end()) {
-      std::shared_ptr<Node> identity_node = reused_node;
-      AddIdentityTransform(related_feature->first, &identity_node);
-      related_feature->second = identity_node;
+    // Only a leaf can be the exit node, so the features are not scanned.
+    if (reused_node->ChildrenCount() == 0) {
+      for (auto id : reused_node->RelatedFeatures) {
+        auto related_feature = features_.find(FeatureName(id));
+        if (related_feature == features_.end() ||
+            related_feature->second != reused_node) {
+          continue;
+        }
+        std::shared_ptr<Node> identity_node = reused_node;
+        AddIdentityTransform(related_feature->first, &identity_node);
+        related_feature->second = identity_node;
+        break;
+      }
     }
   } else {
     // Set the new input format
@@ -440,10 +949,11 @@ void TransformTree::AddTransform(const std::string& name,
     // Append the newly created transform
     auto new_node = std::make_shared<Node>(currentNode->get(), t, buffers_count,
                                            this);
+    InvalidatePlan();
     (*currentNode)->Children[name].push_back(new_node);
     *currentNode = new_node;
   }
-  (*currentNode)->RelatedFeatures.push_back(relatedFeature);
+  (*currentNode)->RelatedFeatures.push_back(InternFeature(relatedFeature));
 
   // Search for the environment variable to activate dumps for this transform
   auto dump_val = std::getenv((std::string(kDumpEnvPrefix) + name).c_str());
@@ -460,201 +970,2587 @@ void TransformTree::AddIdentityTransform(const std::string& feature,
   AddTransform(transforms::Identity::kName, "", feature, parent);
 }
 
+size_t TransformTree::InternFeature(const std::string& name) {
+  auto it = feature_ids_.find(name);
+  if (it != feature_ids_.end()) {
+    return it->second;
+  }
+  feature_ids_.emplace(name, interned_features_.size());
+  interned_features_.push_back(name);
+  return interned_features_.size() - 1;
+}
+
+const std::string& TransformTree::FeatureName(size_t id) const noexcept {
+  return interned_features_[id];
+}
+
 void TransformTree::AddFeature(
     const std::string& name,
     const std::vector<std::pair<std::string, std::string>>& transforms) {
+  ScopedExecutionOverrides overrides(&execution_overrides_);
   DBG("Adding \"%s\"", name.c_str());
-  if (tree_is_prepared_) {
-    throw TreeIsPreparedException();
-  }
   if (features_.find(name) != features_.end()) {
     throw ChainNameAlreadyExistsException(name);
   }
+  if (tree_is_prepared_ && memory_protection()) {
+    DismantleMemoryProtection();
+  }
+  results_.clear();
+  indexed_results_.clear();
 
   auto current_node = root_;
-  root_->RelatedFeatures.push_back(name);
-  for (auto& tpair : transforms) {
-    auto tname = tpair.first;
-    AddTransform(tpair.first, tpair.second, name, &current_node);
+  root_->RelatedFeatures.push_back(InternFeature(name));
+  approximate_chain_ = false;
+  try {
+    for (auto& tpair : transforms) {
+      AddTransform(tpair.first, tpair.second, name, &current_node);
+    }
+    if (current_node->ChildrenCount() > 0) {
+      AddIdentityTransform(name, &current_node);
+    }
+    features_.insert(std::make_pair(name, current_node));
+    if (tree_is_prepared_) {
+      AllocateNewNodes();
+    }
   }
-  if (current_node->ChildrenCount() > 0) {
-    AddIdentityTransform(name, &current_node);
+  catch(...) {
+    if (tree_is_prepared_) {
+      features_.erase(name);
+      RemoveNewNodes(name);
+    }
+    throw;
   }
-
-  features_.insert(std::make_pair(name, current_node));
+  feature_chains_.emplace_back(name, transforms);
+  feature_names_.push_back(name);
 }
 
-int TransformTree::BuildSlicedCycles() noexcept {
-  int ret = 0;  // the resulting number of built cycles
-  auto node = root_.get();
-  decltype(node) prev_node = nullptr;
+void TransformTree::RemoveFeature(const std::string& name) {
+  auto feature = features_.find(name);
+  if (feature == features_.end()) {
+    throw FeatureNotFoundException(name);
+  }
+  DBG("Removing \"%s\"", name.c_str());
+  if (tree_is_prepared_ && memory_protection()) {
+    DismantleMemoryProtection();
+  }
+  results_.clear();
+  indexed_results_.clear();
+  Node* node = feature->second.get();
+  features_.erase(feature);
+  feature_names_.erase(std::find(feature_names_.begin(), feature_names_.end(),
+                                 name));
+  auto id = feature_ids_.find(name)->second;
+  feature_chains_.erase(std::find_if(
+      feature_chains_.begin(), feature_chains_.end(),
+      [&name](const decltype(feature_chains_)::value_type& chain) {
+    return chain.first == name;
+  }));
+  // Walk up to the root, dropping the nodes which became unused
   while (node != nullptr) {
-    // Search for the next cycle entry candidate
-    do {
-      prev_node = node;
-      node = node->Next;
+    auto& related = node->RelatedFeatures;
+    related.erase(std::remove(related.begin(), related.end(), id),
+                  related.end());
+    Node* parent = node->Parent;
+    if (parent != nullptr && related.empty() && node->ChildrenCount() == 0) {
+      if (tree_is_prepared_) {
+        if (node->HasClones) {
+          DismantleSlicedCycle(node->CycleId);
+        }
+        auto prev = PreviousNode(node);
+        if (prev != nullptr) {
+          prev->Next = node->Next;
+        }
+      }
+      // node is destroyed here
+      InvalidatePlan();
+      auto tname = node->BoundTransform->Name();
+      auto& siblings = parent->Children[tname];
+      siblings.erase(std::find_if(
+          siblings.begin(), siblings.end(),
+          [node](const std::shared_ptr<Node>& sibling) {
+        return sibling.get() == node;
+      }));
+      if (siblings.empty()) {
+        parent->Children.erase(tname);
+      }
     }
-    while (node != nullptr && (!node->BoundTransform->BufferInvariant() ||
-        node->ChildrenCount() == 0));
-    if (node == nullptr) {
+    node = parent;
+  }
+  if (tree_is_prepared_) {
+    layout_version_++;
+    IndexNodes();
+    ClearConstantResults();
+  }
+}
+
+void TransformTree::SetTransformParameter(const std::string& feature,
+                                          const std::string& transform,
+                                          const std::string& name,
+                                          const std::string& value) {
+  auto fit = features_.find(feature);
+  if (fit == features_.end()) {
+    throw FeatureNotFoundException(feature);
+  }
+  Node* node = fit->second.get();
+  std::shared_ptr<Transform> target;
+  for (; node->Parent != nullptr; node = node->Parent) {
+    if (node->BoundTransform->Name() == transform) {
+      target = node->BoundTransform;
       break;
     }
-    // Grow the cycle
-    std::vector<Node*> current_cycle;
-    do {
-      current_cycle.push_back(node);
-      node = node->Next;
-    }
-    while (node != nullptr && node->BoundTransform->BufferInvariant() &&
-           node->ChildrenCount() > 0);
-    if (node != nullptr && node->BoundTransform->BufferInvariant() &&
-        node->ChildrenCount() == 0) {
-      current_cycle.push_back(node);
-      node = node->Next;
-    }
-    if (current_cycle.size() == 1) {
+    auto chain = dynamic_cast<const transforms::ElementwiseChain*>(
+        node->BoundTransform.get());
+    if (chain == nullptr) {
       continue;
     }
-    // We have found a cache optimization friendly subpath.
-    // Determine the size bottleneck and mark all the nodes in that subpath.
-    size_t max_size = 0;
-    size_t bufs_count = current_cycle[0]->BoundBuffers->Count();
-    for (auto cn : current_cycle) {
-      auto size = cn->BoundTransform->InputFormat()->SizeInBytes();
-      if (size > max_size) {
-        max_size = size;
+    for (auto& stage : chain->stages()) {
+      if (stage->Name() == transform) {
+        target = stage;
+        break;
       }
-      assert(bufs_count == cn->BoundBuffers->Count());
-    }
-    assert(max_size > 0);
-    size_t slice_buffers_count = get_cpu_cache_size() / max_size;
-    if (slice_buffers_count == 0 || bufs_count <= slice_buffers_count) {
-      continue;
     }
-
-    ret++;
-    // Mark the nodes as cloned
-    for (auto cn : current_cycle) {
-      cn->HasClones = true;
-      cn->CycleId = ret;
-    }
-    // Clone those nodes, connecting each slice's end to the next slice's
-    // beginning.
-    Node* head = current_cycle[0]->Parent;
-    assert(head != nullptr);
-    Node* tail = head;
-    for (size_t i = 0; i < bufs_count; i += slice_buffers_count) {
-      auto my_bufs_count = std::min(slice_buffers_count, bufs_count - i);
-      for (size_t j = 0; j < current_cycle.size(); j++) {
-        auto cn = current_cycle[j];
-        auto cloned = std::make_shared<Node>(j == 0? head : tail,
-                                             cn->BoundTransform,
-                                             my_bufs_count, this);
-        if (j == 0) {
-          head->Slices[cloned.get()] = std::make_tuple(i, my_bufs_count);
-        }
-        cloned->RelatedFeatures = cn->RelatedFeatures;
-        cloned->BoundBuffers = std::make_shared<Buffers>(
-            cn->BoundBuffers->Slice(i, my_bufs_count));
-        cloned->BuffersCount = my_bufs_count;
-        cloned->OriginalNode = cn;
-        cloned->CycleId = ret;
-        cloned->ElapsedTime = cn->ElapsedTime;
-        tail->Children[cloned->BoundTransform->Name()].push_back(cloned);
-        if (head == tail) {
-          // The very first iteration
-          prev_node->Next = cloned.get();
-        } else {
-          tail->Next = cloned.get();
-        }
-        tail = cloned.get();
-      }
+    if (target) {
+      break;
     }
-    tail->Next = current_cycle.back()->Next;
   }
-  return ret;
+  if (!target) {
+    throw TransformNotInFeatureException(feature, transform);
+  }
+  auto& bound = node->BoundTransform;
+  auto format = bound->OutputFormat();
+  auto format_str = format->ToString();
+  auto format_size = format->SizeInBytes();
+  auto format_rate = format->SamplingRate();
+  auto previous = target->GetParameters();
+  // Throws if the parameter does not exist or the value is invalid
+  target->SetParameters({ { name, value } });
+  auto reformat = [&] {
+    return bound->SetInputFormat(node->Parent->BoundTransform->OutputFormat(),
+                                 node->Parent->BuffersCount);
+  };
+  if (reformat() != node->BuffersCount ||
+      format->ToString() != format_str ||
+      format->SizeInBytes() != format_size ||
+      format->SamplingRate() != format_rate) {
+    target->SetParameters({ { name, previous[name] } });
+    reformat();
+    throw FormatChangingParameterException(transform, name);
+  }
+  DBG("Set %s.%s to %s in \"%s\"", transform.c_str(), name.c_str(),
+      value.c_str(), feature.c_str());
+  if (tree_is_prepared_) {
+    PropagateUsedElements();
+    bound->Initialize();
+    ClearConstantResults();
+  }
 }
 
-void TransformTree::DismantleMemoryProtection() noexcept {
-  root_->ActionOnSubtree([this](Node& node) {
-    if (node.Protection) {
-      DBG("Disabling write protection on %p:%zu", node.Protection->page(),
-          node.Protection->size());
+void TransformTree::AllocateNewNodes() {
+  // The new subtrees branch from the already allocated nodes
+  std::vector<Node*> new_nodes;
+  std::vector<Node*> branch_points;
+  root_->ActionOnSubtree([&](Node& node) {
+    if (node.Parent == nullptr || node.BoundBuffers) {
+      return;
+    }
+    new_nodes.push_back(&node);
+    if ((node.Parent->Parent == nullptr || node.Parent->BoundBuffers) &&
+        std::find(branch_points.begin(), branch_points.end(), node.Parent) ==
+            branch_points.end()) {
+      branch_points.push_back(node.Parent);
     }
-    node.Protection.reset();
   });
+  // The new features may read more elements of the existing nodes
+  PropagateUsedElements();
+  if (new_nodes.empty()) {
+    return;
+  }
+  CheckGates();
+  for (auto node : new_nodes) {
+    node->BoundTransform->Initialize();
+    transforms_cache_[node->BoundTransform->Name()];
+  }
+  // Solve and allocate everything first, so that a failure leaves the tree
+  // intact
+  std::vector<std::unique_ptr<memory_allocation::Node>> allocation_trees;
+  std::vector<std::vector<Node*>> branches;
+  std::vector<std::shared_ptr<MemoryBlock>> blocks;
+  for (auto branch_point : branch_points) {
+    allocation_trees.emplace_back(
+        new memory_allocation::Node(0, nullptr, branch_point));
+    auto& allocation_tree_root = *allocation_trees.back();
+    branches.emplace_back();
+    auto& children = branches.back();
+    branch_point->ActionOnEachImmediateChild([&](Node& child) {
+      if (!child.BoundBuffers) {
+        children.push_back(&child);
+      }
+    });
+    allocation_tree_root.Children.reserve(children.size());
+    for (auto child : children) {
+      allocation_tree_root.Children.emplace_back(
+          child->AllocationSize(), &allocation_tree_root, child);
+      child->BuildAllocationTree(&allocation_tree_root.Children.back());
+    }
+    auto allocator = CreateAllocator();
+    auto memory = std::make_shared<MemoryBlock>();
+    memory->Size = allocator->Solve(&allocation_tree_root);
+    SFE_PROBE3(allocate, this, memory->Size, children.size());
+    memory->Data = AcquireMemory(memory->Size);
+    INF("Allocated %zu bytes at %p for %zu new subtrees of %s", memory->Size,
+        memory->Data.get(), children.size(),
+        branch_point->BoundTransform->Name().c_str());
+    blocks.push_back(memory);
+  }
+  for (size_t b = 0; b < branch_points.size(); b++) {
+    auto branch_point = branch_points[b];
+    auto& allocation_tree_root = *allocation_trees[b];
+    auto& children = branches[b];
+    auto& memory = blocks[b];
+    for (size_t i = 0; i < children.size(); i++) {
+      children[i]->ApplyAllocationTree(allocation_tree_root.Children[i],
+                                       memory->Data.get());
+      children[i]->ActionOnSubtree([&memory](Node& node) {
+        node.Memory = memory;
+      });
+    }
+    // Execute the new subtrees right after their parent, while its buffers
+    // are still intact. The parent of a sliced cycle is not executed itself.
+    // The view is never executed, so its buffers are intact right after
+    // the node it shares them with.
+    while (branch_point->View) {
+      branch_point = branch_point->Parent;
+    }
+    if (branch_point->HasClones) {
+      DismantleSlicedCycle(branch_point->CycleId);
+    }
+    auto first = reinterpret_cast<Node*>(allocation_tree_root.Next->Item);
+    auto last = first;
+    while (last->Next != nullptr) {
+      last = last->Next;
+    }
+    last->Next = branch_point->Next;
+    branch_point->Next = first;
+  }
+  layout_version_++;
+  IndexNodes();
+  ClearConstantResults();
 }
 
-void TransformTree::ResetTimers() noexcept {
-  root_->ActionOnSubtree([](Node& node) {
-    *node.ElapsedTime = std::chrono::high_resolution_clock::duration::zero();
+void TransformTree::RemoveNewNodes(const std::string& feature) noexcept {
+  InvalidatePlan();
+  for (auto& other : features_) {
+    while (other.second->Parent != nullptr && !other.second->BoundBuffers) {
+      other.second = other.second->Parent->SelfPtr();
+    }
+  }
+  std::vector<std::pair<Node*, std::string>> branches;
+  auto id = feature_ids_.find(feature)->second;
+  root_->ActionOnSubtree([&](Node& node) {
+    auto& related = node.RelatedFeatures;
+    related.erase(std::remove(related.begin(), related.end(), id),
+                  related.end());
+    if (node.Parent != nullptr && !node.BoundBuffers &&
+        (node.Parent->Parent == nullptr || node.Parent->BoundBuffers)) {
+      branches.emplace_back(node.Parent, node.BoundTransform->Name());
+    }
   });
-  for (auto& ci : transforms_cache_) {
-    ci.second.ElapsedTime =
-        std::chrono::high_resolution_clock::duration::zero();
+  for (auto& branch : branches) {
+    auto children = branch.first->Children.find(branch.second);
+    if (children == branch.first->Children.end()) {
+      continue;
+    }
+    auto& siblings = children->second;
+    siblings.erase(std::remove_if(
+        siblings.begin(), siblings.end(),
+        [](const std::shared_ptr<Node>& sibling) {
+      return !sibling->BoundBuffers;
+    }), siblings.end());
+    if (siblings.empty()) {
+      branch.first->Children.erase(children);
+    }
   }
 }
 
-void TransformTree::PrepareForExecution() {
-  if (tree_is_prepared_) {
-    throw TreeAlreadyPreparedException();
+void TransformTree::DismantleSlicedCycle(int cycleId) noexcept {
+  Node* prev = nullptr;
+  for (auto node = root_.get(); node->Next != nullptr; node = node->Next) {
+    if (node->Next->OriginalNode != nullptr &&
+        node->Next->CycleId == cycleId) {
+      prev = node;
+      break;
+    }
   }
-  DBG("Initializing the transforms...");
-  // Run Initialize() on all transforms
-  root_->ActionOnEachTransformInSubtree([](const Transform& t) {
-    t.Initialize();
-  });
-  DBG("Finished. Baking the allocation plan...");
-  // Solve the allocation problem
-  memory_allocation::Node allocation_tree_root(0, nullptr, root_.get());
-  root_->BuildAllocationTree(&allocation_tree_root);
-  memory_allocation::SlidingBlocksAllocator allocator;
-  size_t neededMemory = allocator.Solve(&allocation_tree_root);
-#if DEBUG
-  allocation_tree_root.Dump("/tmp/last_allocation.dot");
-  assert(allocator.Validate(allocation_tree_root));
-#endif
-  // Allocate the buffers
-  allocated_memory_ = std::shared_ptr<void>(malloc_aligned(neededMemory),
-                                            std::free);
-  if (allocated_memory_.get() == nullptr) {
-    throw FailedToAllocateBuffersException(std::string("Failed to allocate ") +
-                                           std::to_string(neededMemory) +
-                                           " bytes.");
+  if (prev == nullptr) {
+    return;
   }
-  INF("Allocated %zu bytes at %p", neededMemory, allocated_memory_.get());
-  // Finally, apply the memory mapping, creating the actual buffers
-  // We will overwrite root's BoundBuffers on execution stage
-  root_->ApplyAllocationTree(allocation_tree_root, allocated_memory_.get());
-  // Try to do CPU cache optimization by splitting the buffers into slices
-  if (cache_optimization_) {
-    auto cycles_count = BuildSlicedCycles();
-    DBG("Built %d cycles", cycles_count);
+  DBG("Dismantling cycle %d", cycleId);
+  InvalidatePlan();
+  // Each slice starts with a clone of the first node under the cycle's head
+  Node* original = prev->Next->OriginalNode;
+  Node* head = original->Parent;
+  for (auto& subnodes : head->Children) {
+    auto& vec = subnodes.second;
+    for (auto& inode : vec) {
+      if (inode->OriginalNode != nullptr && inode->CycleId == cycleId) {
+        head->Slices.erase(inode.get());
+      }
+    }
+    vec.erase(std::remove_if(
+        vec.begin(), vec.end(),
+        [cycleId](const std::shared_ptr<Node>& inode) {
+      return inode->OriginalNode != nullptr && inode->CycleId == cycleId;
+    }), vec.end());
+  }
+  prev->Next = original;
+  // The originals are still linked with each other
+  for (auto node = original; node != nullptr && node->CycleId == cycleId;
+       node = node->Next) {
+    node->HasClones = false;
+    node->CycleId = 0;
   }
-  tree_is_prepared_ = true;
-  INF("Prepared to extract %zu features", features_.size());
-#if DEBUG
-  Dump("/tmp/last_nodes.dot");
-#endif
 }
 
-std::unordered_map<std::string, std::shared_ptr<Buffers>>
-TransformTree::Execute(const int16_t* in) {
-  if (!tree_is_prepared_) {
-    throw TreeIsNotPreparedException();
+TransformTree::Node* TransformTree::PreviousNode(
+    const Node* node) const noexcept {
+  for (auto prev = root_.get(); prev != nullptr; prev = prev->Next) {
+    if (prev->Next == node) {
+      return prev;
+    }
   }
+  return nullptr;
+}
+
+int TransformTree::FuseTransforms() {
+  int unpacked_count = ElideUnpacking();
+  int sliding_count = FuseSlidingReductions();
+  // Collect the chains first, since the tree is modified afterwards
+  std::vector<std::pair<Node*, Node*>> windows;
+  std::vector<std::pair<Node*, Node*>> spectra;
+  std::vector<std::pair<Node*, Node*>> cepstra;
+  std::vector<std::pair<Node*, Node*>> mfcc_tails;
+  std::unordered_set<const Node*> mfcc_tail_nodes;
+  std::vector<std::pair<Node*, int>> truncated;
+  std::vector<std::pair<Node*, int>> correlations;
+  std::vector<std::pair<Node*, Node*>> rotations;
+  std::vector<std::pair<Node*, Node*>> columns;
+  std::vector<std::pair<Node*, Node*>> preemphases;
+  std::vector<std::pair<Node*, Node*>> rectified;
+  std::vector<std::pair<Node*, Node*>> subbands;
+  auto is_rectified = [&rectified](const Node* node) {
+    return std::any_of(rectified.begin(), rectified.end(),
+                       [node](const std::pair<Node*, Node*>& pair) {
+                         return pair.second == node;
+                       });
+  };
+  std::vector<std::vector<Node*>> elementwise;
+  std::vector<std::vector<Node*>> narrowed;
+  std::vector<std::vector<Node*>> widened;
+  std::vector<std::vector<std::pair<Node*, transforms::SpectralDescriptor>>>
+      descriptors;
+  root_->ActionOnSubtree([&](const Node& node) {
+    if (node.Parent == nullptr) {
+      return;
+    }
+    auto self = const_cast<Node*>(&node);
+    auto siblings = SiblingDescriptors(self);
+    if (siblings.size() > 1) {
+      descriptors.push_back(siblings);
+    }
+    if (node.ChildrenCount() == 1 &&
+        dynamic_cast<const transforms::WindowSplitter16*>(
+            node.BoundTransform.get()) != nullptr) {
+      auto child = node.Children.begin()->second.front().get();
+      // The int16 windows must not be the end of some other feature
+      if (dynamic_cast<const formats::Int16ToFloatRaw*>(
+              child->BoundTransform.get()) != nullptr &&
+          child->RelatedFeatures.size() == node.RelatedFeatures.size()) {
+        windows.push_back({self, child});
+      }
+    }
+    if (node.ChildrenCount() == 1 &&
+        dynamic_cast<const transforms::RDFT*>(
+            node.BoundTransform.get()) != nullptr) {
+      auto child = node.Children.begin()->second.front().get();
+      auto energy = dynamic_cast<const transforms::SpectralEnergy*>(
+          child->BoundTransform.get());
+      if (energy != nullptr && !energy->unpacked()) {
+        spectra.push_back({self, child});
+      }
+    }
+    if (node.ChildrenCount() == 1 &&
+        dynamic_cast<const transforms::LPC*>(
+            node.BoundTransform.get()) != nullptr) {
+      auto child = node.Children.begin()->second.front().get();
+      // LPC must not be the end of some other feature
+      if (dynamic_cast<const transforms::LPC2CC*>(
+              child->BoundTransform.get()) != nullptr &&
+          child->RelatedFeatures.size() == node.RelatedFeatures.size()) {
+        cepstra.push_back({self, child});
+      }
+    }
+    // FilterBank -> Log -> DCT -> Selector, none of them is the end of
+    // some other feature
+    if (node.ChildrenCount() == 1 &&
+        dynamic_cast<const transforms::FilterBank*>(
+            node.BoundTransform.get()) != nullptr) {
+      std::vector<Node*> tail { self };
+      while (tail.size() < 4 && tail.back()->ChildrenCount() == 1) {
+        auto child = tail.back()->Children.begin()->second.front().get();
+        if (child->RelatedFeatures.size() != node.RelatedFeatures.size()) {
+          break;
+        }
+        tail.push_back(child);
+      }
+      if (tail.size() == 4 &&
+          dynamic_cast<const transforms::LogRaw*>(
+              tail[1]->BoundTransform.get()) != nullptr) {
+        auto dct = dynamic_cast<const transforms::DCT*>(
+            tail[2]->BoundTransform.get());
+        auto selector = dynamic_cast<const transforms::Selector*>(
+            tail[3]->BoundTransform.get());
+        if (dct != nullptr && selector != nullptr &&
+            dct->length() == static_cast<int>(
+                std::static_pointer_cast<formats::ArrayFormatF>(
+                    dct->InputFormat())->Size()) &&
+            selector->from() == transforms::Anchor::kLeft &&
+            selector->select() == selector->length() &&
+            selector->offset() == 0 && selector->length() < dct->length()) {
+          mfcc_tails.push_back({self, tail[3]});
+          mfcc_tail_nodes.insert(tail.begin(), tail.end());
+        }
+      }
+    }
+    if (node.ChildrenCount() == 1 &&
+        dynamic_cast<const formats::Int16ToFloatRaw*>(
+            node.BoundTransform.get()) != nullptr &&
+        std::none_of(windows.begin(), windows.end(),
+                     [self](const std::pair<Node*, Node*>& window) {
+                       return window.second == self;
+                     })) {
+      auto child = node.Children.begin()->second.front().get();
+      if (dynamic_cast<const transforms::Preemphasis*>(
+              child->BoundTransform.get()) != nullptr &&
+          child->RelatedFeatures.size() == node.RelatedFeatures.size()) {
+        // The stereo mixing is fused too unless somebody else reads it
+        auto parent = node.Parent;
+        bool mix = parent->Parent != nullptr &&
+            parent->ChildrenCount() == 1 &&
+            dynamic_cast<const transforms::MixStereo*>(
+                parent->BoundTransform.get()) != nullptr &&
+            parent->RelatedFeatures.size() == node.RelatedFeatures.size();
+        preemphases.push_back({mix? parent : self, child});
+      }
+    }
+    auto dct = dynamic_cast<const transforms::DCT*>(node.BoundTransform.get());
+    if (dct != nullptr && node.ChildrenCount() == 1 &&
+        mfcc_tail_nodes.count(self) == 0 &&
+        dct->length() == static_cast<int>(
+            std::static_pointer_cast<formats::ArrayFormatF>(
+                dct->InputFormat())->Size())) {
+      auto child = node.Children.begin()->second.front().get();
+      auto selector = dynamic_cast<const transforms::Selector*>(
+          child->BoundTransform.get());
+      // Only the leading coefficients are kept as is
+      if (selector != nullptr &&
+          selector->from() == transforms::Anchor::kLeft &&
+          selector->select() == selector->length() &&
+          selector->length() < dct->length() &&
+          child->RelatedFeatures.size() == node.RelatedFeatures.size()) {
+        truncated.push_back({self, selector->length()});
+      }
+    }
+    // Only the leading nonnegative lags are read, e.g. by LPC
+    auto acf = dynamic_cast<const transforms::Autocorrelation*>(
+        node.BoundTransform.get());
+    if (acf != nullptr && acf->lags() == 0 && node.ChildrenCount() == 1) {
+      int size = std::static_pointer_cast<formats::ArrayFormatF>(
+          acf->InputFormat())->Size();
+      auto child = node.Children.begin()->second.front().get();
+      auto half = dynamic_cast<const transforms::Selector*>(
+          child->BoundTransform.get());
+      if (half != nullptr && half->from() == transforms::Anchor::kRight &&
+          half->length() == size && half->select() == size &&
+          half->offset() == 0 && child->ChildrenCount() > 0 &&
+          child->RelatedFeatures.size() == node.RelatedFeatures.size()) {
+        int lags = 0;
+        child->ActionOnEachImmediateChild([&](const Node& grandchild) {
+          auto leading = dynamic_cast<const transforms::Selector*>(
+              grandchild.BoundTransform.get());
+          if (leading != nullptr &&
+              leading->from() == transforms::Anchor::kLeft &&
+              leading->select() == leading->length() &&
+              leading->offset() == 0 && lags >= 0) {
+            lags = std::max(lags, leading->length());
+          } else {
+            lags = -1;
+          }
+        });
+        if (lags > 0 && lags < size) {
+          correlations.push_back({self, lags});
+        }
+      }
+    }
+    // Rotating twice restores the input, the pairs must not overlap
+    if (node.ChildrenCount() == 1 &&
+        dynamic_cast<const transforms::RotateF*>(
+            node.BoundTransform.get()) != nullptr &&
+        std::none_of(rotations.begin(), rotations.end(),
+                     [&node](const std::pair<Node*, Node*>& rotation) {
+                       return rotation.second == node.Parent;
+                     })) {
+      auto child = node.Children.begin()->second.front().get();
+      if (dynamic_cast<const transforms::RotateF*>(
+              child->BoundTransform.get()) != nullptr &&
+          child->RelatedFeatures.size() == node.RelatedFeatures.size()) {
+        rotations.push_back({self, child});
+      }
+    }
+    // Stats reads the columns in place instead of the rotated buffers
+    if (node.ChildrenCount() == 1 &&
+        dynamic_cast<const transforms::RotateF*>(
+            node.BoundTransform.get()) != nullptr &&
+        std::none_of(rotations.begin(), rotations.end(),
+                     [&node](const std::pair<Node*, Node*>& rotation) {
+                       return rotation.second == &node;
+                     })) {
+      auto child = node.Children.begin()->second.front().get();
+      if (dynamic_cast<const transforms::Stats*>(
+              child->BoundTransform.get()) != nullptr &&
+          child->RelatedFeatures.size() == node.RelatedFeatures.size()) {
+        columns.push_back({self, child});
+      }
+    }
+    // The subbands are reduced as soon as they are calculated
+    auto dwpt = dynamic_cast<const transforms::DWPT*>(
+        node.BoundTransform.get());
+    if (dwpt != nullptr && node.ChildrenCount() == 1) {
+      auto child = node.Children.begin()->second.front().get();
+      auto energy = dynamic_cast<const transforms::SubbandEnergy*>(
+          child->BoundTransform.get());
+      if (energy != nullptr && energy->tree() == dwpt->tree() &&
+          child->RelatedFeatures.size() == node.RelatedFeatures.size()) {
+        subbands.push_back({self, child});
+      }
+    }
+    // Diff rectifies the differences itself
+    if (node.ChildrenCount() == 1 &&
+        dynamic_cast<const transforms::Diff*>(
+            node.BoundTransform.get()) != nullptr) {
+      auto child = node.Children.begin()->second.front().get();
+      if (dynamic_cast<const transforms::Rectify*>(
+              child->BoundTransform.get()) != nullptr &&
+          child->RelatedFeatures.size() == node.RelatedFeatures.size()) {
+        rectified.push_back({self, child});
+      }
+    }
+    // Start an elementwise chain unless the parent continues it
+    if (!IsElementwise(node) || is_rectified(self) ||
+        mfcc_tail_nodes.count(self) > 0 ||
+        (IsElementwise(*node.Parent) && node.Parent->ChildrenCount() == 1 &&
+         !is_rectified(node.Parent))) {
+      return;
+    }
+    std::vector<Node*> chain { self };
+    Node* narrowing = nullptr;
+    while (chain.back()->ChildrenCount() == 1) {
+      auto child = chain.back()->Children.begin()->second.front().get();
+      if (!IsElementwise(*child)) {
+        // The last node must not be the end of some other feature
+        if (IsNarrowing(*child) && child->RelatedFeatures.size() ==
+            chain.back()->RelatedFeatures.size()) {
+          narrowing = child;
+        }
+        break;
+      }
+      chain.push_back(child);
+    }
+    if (narrowing != nullptr) {
+      chain.push_back(narrowing);
+      narrowed.push_back(chain);
+    } else if (IsWidening(*node.Parent) &&
+               node.Parent->ChildrenCount() == 1 &&
+               std::none_of(windows.begin(), windows.end(),
+                            [&node](const std::pair<Node*, Node*>& window) {
+                              return window.second == node.Parent;
+                            }) &&
+               node.Parent->RelatedFeatures.size() ==
+               node.RelatedFeatures.size()) {
+      // The converter writes the tile which the chain processes in place
+      chain.insert(chain.begin(), node.Parent);
+      widened.push_back(chain);
+    } else if (chain.size() > 1) {
+      elementwise.push_back(chain);
+    }
+  });
+  for (auto& window : windows) {
+    ReplaceChain(window.first, window.second,
+                 std::make_shared<transforms::WindowSplitter16F>(
+                     window.first->BoundTransform));
+  }
+  for (auto& spectrum : spectra) {
+    auto fused = std::make_shared<transforms::PowerSpectrum>();
+    Node* first = spectrum.first;
+    auto window = dynamic_cast<const transforms::Window*>(
+        first->Parent->BoundTransform.get());
+    if (window != nullptr && !window->predft() &&
+        first->Parent->ChildrenCount() == 1 &&
+        first->Parent->Parent != nullptr) {
+      fused->set_window(window->type());
+      first = first->Parent;
+    }
+    ReplaceChain(first, spectrum.second, fused);
+  }
+  for (auto& cepstrum : cepstra) {
+    auto lpc = dynamic_cast<const transforms::LPC*>(
+        cepstrum.first->BoundTransform.get());
+    auto cc = dynamic_cast<const transforms::LPC2CC*>(
+        cepstrum.second->BoundTransform.get());
+    auto fused = std::make_shared<transforms::LPCC>();
+    fused->set_error(lpc->error());
+    if (cc->size() != 0) {
+      fused->set_size(cc->size());
+    }
+    ReplaceChain(cepstrum.first, cepstrum.second, fused);
+  }
+  for (auto& tail : mfcc_tails) {
+    auto log = tail.first->Children.begin()->second.front();
+    auto selector = std::static_pointer_cast<transforms::Selector>(
+        tail.second->BoundTransform);
+    ReplaceChain(tail.first, tail.second,
+                 std::make_shared<transforms::Cepstrum>(
+                     tail.first->BoundTransform, log->BoundTransform,
+                     selector->length()));
+  }
+  for (auto& dct : truncated) {
+    auto fused = std::make_shared<transforms::DCT>();
+    fused->set_length(dct.second);
+    ReplaceChain(dct.first, dct.first->Children.begin()->second.front().get(),
+                 fused);
+  }
+  for (auto& acf : correlations) {
+    auto fused = std::make_shared<transforms::Autocorrelation>();
+    fused->set_normalize(dynamic_cast<const transforms::Autocorrelation*>(
+        acf.first->BoundTransform.get())->normalize());
+    fused->set_lags(acf.second);
+    ReplaceChain(acf.first, acf.first->Children.begin()->second.front().get(),
+                 fused);
+  }
+  for (auto& preemphasis : preemphases) {
+    bool mix = dynamic_cast<const transforms::MixStereo*>(
+        preemphasis.first->BoundTransform.get()) != nullptr;
+    ReplaceChain(preemphasis.first, preemphasis.second,
+                 std::make_shared<transforms::Preemphasis16F>(
+                     preemphasis.second->BoundTransform, mix));
+  }
+  for (auto& pair : rectified) {
+    auto diff = dynamic_cast<const transforms::Diff*>(
+        pair.first->BoundTransform.get());
+    auto fused = std::make_shared<transforms::Diff>();
+    fused->set_swt(diff->swt());
+    fused->set_rectify(true);
+    ReplaceChain(pair.first, pair.second, fused);
+  }
+  for (auto& pair : subbands) {
+    ReplaceChain(pair.first, pair.second,
+                 std::make_shared<transforms::DWPTSubbandEnergy>(
+                     pair.first->BoundTransform));
+  }
+  for (auto& rotation : rotations) {
+    ReplaceChain(rotation.first, rotation.second,
+                 std::make_shared<transforms::Identity>());
+  }
+  for (auto& pair : columns) {
+    ReplaceChain(pair.first, pair.second,
+                 std::make_shared<transforms::RotatedStats>(
+                     pair.second->BoundTransform));
+  }
+  for (auto& chain : elementwise) {
+    auto fused = std::make_shared<transforms::ElementwiseChain>();
+    for (auto node : chain) {
+      fused->AddStage(node->BoundTransform);
+    }
+    ReplaceChain(chain.front(), chain.back(), fused);
+  }
+  for (auto& chain : narrowed) {
+    std::vector<std::shared_ptr<Transform>> stages;
+    for (size_t i = 0; i < chain.size() - 1; i++) {
+      stages.push_back(chain[i]->BoundTransform);
+    }
+    ReplaceChain(chain.front(), chain.back(), transforms::CreateNarrowingChain(
+        stages, chain.back()->BoundTransform));
+  }
+  for (auto& chain : widened) {
+    std::vector<std::shared_ptr<Transform>> stages;
+    for (size_t i = 1; i < chain.size(); i++) {
+      stages.push_back(chain[i]->BoundTransform);
+    }
+    ReplaceChain(chain.front(), chain.back(), transforms::CreateWideningChain(
+        chain.front()->BoundTransform, stages));
+  }
+  for (auto& siblings : descriptors) {
+    FuseDescriptors(siblings);
+  }
+  return unpacked_count + sliding_count + windows.size() + spectra.size() +
+      cepstra.size() + mfcc_tails.size() + truncated.size() +
+      correlations.size() + rotations.size() + columns.size() +
+      preemphases.size() + rectified.size() + subbands.size() +
+      elementwise.size() + narrowed.size() + widened.size() +
+      descriptors.size();
+}
+
+int TransformTree::FuseSlidingReductions() {
+  std::vector<std::pair<Node*, std::vector<Node*>>> splitters;
+  root_->ActionOnSubtree([&](const Node& node) {
+    if (node.Parent == nullptr || node.Parent->BuffersCount != 1 ||
+        node.BoundTransform->streaming()) {
+      return;
+    }
+    // The windows which do not overlap are cheap to sum directly
+    auto splitter = dynamic_cast<const transforms::WindowSplitterTemplate<
+        float>*>(node.BoundTransform.get());
+    auto splitter16 = dynamic_cast<const transforms::WindowSplitterTemplate<
+        int16_t>*>(node.BoundTransform.get());
+    bool overlapping = splitter != nullptr?
+        splitter->type() == WindowType::kWindowTypeRectangular &&
+            splitter->step() < splitter->length() :
+        splitter16 != nullptr &&
+            splitter16->type() == WindowType::kWindowTypeRectangular &&
+            splitter16->step() < splitter16->length();
+    if (!overlapping) {
+      return;
+    }
+    // SpectralDescriptors takes the sibling Energy nodes
+    if (SiblingDescriptors(const_cast<Node*>(&node)).size() > 1) {
+      return;
+    }
+    std::vector<Node*> reductions;
+    node.ActionOnEachImmediateChild([&](const Node& child) {
+      if (SlidingReduction(node, *child.BoundTransform) != nullptr) {
+        reductions.push_back(const_cast<Node*>(&child));
+      }
+    });
+    if (!reductions.empty()) {
+      splitters.push_back({const_cast<Node*>(&node), reductions});
+    }
+  });
+  for (auto& splitter : splitters) {
+    auto node = splitter.first;
+    for (auto reduction : splitter.second) {
+      GraftNode(node->Parent, reduction,
+                SlidingReduction(*node, *reduction->BoundTransform));
+      DetachNode(reduction, "the sliding reduction");
+    }
+    // The windows are not needed anymore unless they are a feature
+    auto self = node->SelfPtr();
+    bool feature = false;
+    for (auto& f : features_) {
+      feature |= f.second == self;
+    }
+    if (node->ChildrenCount() == 0 && !feature) {
+      DetachNode(node, "the sliding reductions");
+    }
+  }
+  int count = 0;
+  for (auto& splitter : splitters) {
+    count += splitter.second.size();
+  }
+  return count;
+}
+
+std::shared_ptr<Transform> TransformTree::SlidingReduction(
+    const Node& splitter, const Transform& transform) {
+  auto& bound = splitter.BoundTransform;
+  if (dynamic_cast<const transforms::Energy*>(&transform) != nullptr) {
+    return std::make_shared<transforms::SlidingEnergy<float>>(bound);
+  }
+  if (dynamic_cast<const transforms::Energy16*>(&transform) != nullptr) {
+    return std::make_shared<transforms::SlidingEnergy<int16_t>>(bound);
+  }
+  if (dynamic_cast<const transforms::ZeroCrossingsF*>(&transform) !=
+      nullptr) {
+    return std::make_shared<transforms::SlidingZeroCrossings<float>>(bound);
+  }
+  if (dynamic_cast<const transforms::ZeroCrossings16*>(&transform) !=
+      nullptr) {
+    return std::make_shared<transforms::SlidingZeroCrossings<int16_t>>(
+        bound);
+  }
+  auto mean = dynamic_cast<const transforms::Mean*>(&transform);
+  if (mean != nullptr && mean->types() == std::set<transforms::MeanType> {
+      transforms::kMeanTypeArithmetic }) {
+    return std::make_shared<transforms::SlidingMean>(bound);
+  }
+  return nullptr;
+}
+
+int TransformTree::ElideUnpacking() {
+  std::vector<Node*> unpacks;
+  root_->ActionOnSubtree([&](const Node& node) {
+    // The odd sizes are the real spectra, which are mirrored as is
+    if (node.Parent == nullptr || node.ChildrenCount() == 0 ||
+        dynamic_cast<const transforms::UnpackRDFT*>(
+            node.BoundTransform.get()) == nullptr ||
+        std::static_pointer_cast<formats::ArrayFormatF>(
+            node.BoundTransform->InputFormat())->Size() % 2 == 1) {
+      return;
+    }
+    // The unpacked spectrum must not be the end of some feature
+    auto self = node.SelfPtr();
+    for (auto& feature : features_) {
+      if (feature.second == self) {
+        return;
+      }
+    }
+    bool packed = true;
+    node.ActionOnEachImmediateChild([&packed](const Node& child) {
+      packed &= UnpackingConsumer(*child.BoundTransform) != nullptr;
+    });
+    if (packed) {
+      unpacks.push_back(const_cast<Node*>(&node));
+    }
+  });
+  for (auto unpack : unpacks) {
+    std::vector<Node*> consumers;
+    unpack->ActionOnEachImmediateChild([&consumers](Node& child) {
+      consumers.push_back(&child);
+    });
+    for (auto consumer : consumers) {
+      GraftNode(unpack->Parent, consumer,
+                UnpackingConsumer(*consumer->BoundTransform));
+    }
+    DetachNode(unpack, "the packed spectrum consumers");
+  }
+  return unpacks.size();
+}
+
+std::shared_ptr<Transform> TransformTree::UnpackingConsumer(
+    const Transform& transform) {
+  auto energy = dynamic_cast<const transforms::SpectralEnergy*>(&transform);
+  if (energy != nullptr && !energy->unpacked()) {
+    auto consumer = std::make_shared<transforms::SpectralEnergy>();
+    consumer->set_unpacked(true);
+    return consumer;
+  }
+  auto magnitude = dynamic_cast<const transforms::ComplexMagnitude*>(
+      &transform);
+  if (magnitude != nullptr && !magnitude->unpacked()) {
+    auto consumer = std::make_shared<transforms::ComplexMagnitude>();
+    consumer->set_unpacked(true);
+    return consumer;
+  }
+  auto real = dynamic_cast<const transforms::ComplexToReal*>(&transform);
+  if (real != nullptr && !real->unpacked()) {
+    auto consumer = std::make_shared<transforms::ComplexToReal>();
+    consumer->set_unpacked(true);
+    return consumer;
+  }
+  return nullptr;
+}
+
+std::vector<std::pair<TransformTree::Node*, transforms::SpectralDescriptor>>
+TransformTree::SiblingDescriptors(Node* node) noexcept {
+  std::vector<std::pair<Node*, transforms::SpectralDescriptor>> siblings;
+  if (dynamic_cast<const formats::ArrayFormatF*>(
+      node->BoundTransform->OutputFormat().get()) == nullptr) {
+    return siblings;
+  }
+  std::set<transforms::SpectralDescriptor> found;
+  node->ActionOnEachImmediateChild([&](Node& child) {
+    auto transform = child.BoundTransform.get();
+    transforms::SpectralDescriptor descriptor;
+    if (dynamic_cast<const transforms::Centroid*>(transform) != nullptr) {
+      descriptor = transforms::kSpectralDescriptorCentroid;
+    } else if (dynamic_cast<const transforms::Rolloff*>(
+        transform) != nullptr) {
+      // Rolloffs with different ratios are left as is except the first one
+      descriptor = transforms::kSpectralDescriptorRolloff;
+    } else if (dynamic_cast<const transforms::Flux*>(transform) != nullptr) {
+      descriptor = transforms::kSpectralDescriptorFlux;
+    } else if (dynamic_cast<const transforms::Energy*>(
+        transform) != nullptr) {
+      descriptor = transforms::kSpectralDescriptorEnergy;
+    } else {
+      return;
+    }
+    if (found.insert(descriptor).second) {
+      siblings.push_back({&child, descriptor});
+    }
+  });
+  return siblings;
+}
+
+void TransformTree::FuseDescriptors(
+    const std::vector<std::pair<Node*, transforms::SpectralDescriptor>>&
+        siblings) {
+  InvalidatePlan();
+  auto fused = std::make_shared<transforms::SpectralDescriptors>();
+  std::set<transforms::SpectralDescriptor> descriptors;
+  for (auto& sibling : siblings) {
+    descriptors.insert(sibling.second);
+    auto rolloff = dynamic_cast<const transforms::Rolloff*>(
+        sibling.first->BoundTransform.get());
+    if (rolloff != nullptr) {
+      fused->set_ratio(rolloff->ratio());
+    }
+  }
+  fused->set_descriptors(descriptors);
+  fused->set_streaming(streaming_);
+  Node* parent = siblings.front().first->Parent;
+  size_t buffers_count = fused->SetInputFormat(
+      parent->BoundTransform->OutputFormat(), parent->BuffersCount);
+  auto node = std::make_shared<Node>(parent, fused, buffers_count, this);
+  // Each sibling is replaced with the selector of its value
+  for (auto& sibling : siblings) {
+    Node* original = sibling.first;
+    auto selector = std::make_shared<transforms::DescriptorSelector>();
+    selector->set_descriptor(sibling.second);
+    selector->set_streaming(streaming_);
+    size_t selected_count = selector->SetInputFormat(
+        fused->OutputFormat(), buffers_count);
+    assert(selected_count == original->BuffersCount);
+    assert(*selector->OutputFormat() ==
+           *original->BoundTransform->OutputFormat());
+    auto selected = std::make_shared<Node>(
+        node.get(), selector, selected_count, this);
+    selected->Children = original->Children;
+    selected->ActionOnEachImmediateChild([&selected](Node& child) {
+      child.Parent = selected.get();
+    });
+    selected->RelatedFeatures = original->RelatedFeatures;
+    std::unordered_set<size_t> related(node->RelatedFeatures.begin(),
+                                       node->RelatedFeatures.end());
+    for (auto feature : original->RelatedFeatures) {
+      if (related.insert(feature).second) {
+        node->RelatedFeatures.push_back(feature);
+      }
+    }
+    auto original_ptr = original->SelfPtr();
+    for (auto& feature : features_) {
+      if (feature.second == original_ptr) {
+        feature.second = selected;
+      }
+    }
+    DetachNode(original, fused->Name());
+    node->Children[selector->Name()].push_back(selected);
+  }
+  parent->Children[fused->Name()].push_back(node);
+}
+
+bool TransformTree::IsWidening(const Node& node) noexcept {
+  return node.Parent != nullptr &&
+      transforms::IsWidening(*node.BoundTransform);
+}
+
+bool TransformTree::IsNarrowing(const Node& node) noexcept {
+  return transforms::IsNarrowing(*node.BoundTransform) &&
+      dynamic_cast<const formats::ArrayFormatF*>(
+          node.BoundTransform->InputFormat().get()) != nullptr;
+}
+
+bool TransformTree::IsElementwise(const Node& node) noexcept {
+  return node.Parent != nullptr &&
+      dynamic_cast<const ElementwiseTransform*>(
+          node.BoundTransform.get()) != nullptr &&
+      dynamic_cast<const formats::ArrayFormatF*>(
+          node.BoundTransform->InputFormat().get()) != nullptr;
+}
+
+bool TransformTree::IsView(const Node& node) noexcept {
+  // The views of the root are rebound to the input together with it,
+  // see BindInput()
+  if (node.Parent == nullptr) {
+    return false;
+  }
+  auto view = dynamic_cast<const ViewTransform*>(node.BoundTransform.get());
+  if (view == nullptr || !view->IsView()) {
+    return false;
+  }
+  if (view->DenseInput()) {
+    // The parent is packed without the padding (see IsPacked()) and becomes
+    // a leaf of the allocation tree, so it keeps the view's results.
+    // The root's buffers are the input, which is laid out by the caller.
+    auto parent = node.Parent;
+    return parent->Parent != nullptr && parent->ChildrenCount() == 1 &&
+        !parent->View && PackedStride(*parent) ==
+            parent->BoundTransform->OutputFormat()->UnalignedSizeInBytes();
+  }
+  // The leaves must keep their results
+  if (node.ChildrenCount() == 0) {
+    return false;
+  }
+  return node.BuffersCount == node.Parent->BuffersCount ||
+      view->ViewStride() != 0;
+}
+
+bool TransformTree::IsDenseView(const Node& node) noexcept {
+  auto view = dynamic_cast<const ViewTransform*>(node.BoundTransform.get());
+  return node.View && view->DenseInput();
+}
+
+size_t TransformTree::ViewStride(const Node& node) noexcept {
+  auto view = dynamic_cast<const ViewTransform*>(node.BoundTransform.get());
+  return view != nullptr? view->ViewStride() : 0;
+}
+
+void TransformTree::BindInput(const void* in, ExecutionContext* context)
+    const noexcept {
+  // "in" is not going to be overwritten, since the children of the views
+  // never work in place
+  root_->BindInput(const_cast<void*>(in), context);
+}
+
+bool TransformTree::IsInPlace(const Node& node) noexcept {
+  // The root's buffers are the input and the siblings would read the
+  // overwritten values
+  if (node.Parent == nullptr || node.Parent->Parent == nullptr ||
+      node.Parent->View || node.Parent->ChildrenCount() > 1 || node.View ||
+      node.BuffersCount != node.Parent->BuffersCount ||
+      !node.BoundTransform->InPlace() || HasDenseView(node) ||
+      HasPaddingChild(node)) {
+    return false;
+  }
+  if (HasPaddingChild(*node.Parent)) {
+    // The parent's buffers are already as large as the padded ones
+    return true;
+  }
+  return node.BoundTransform->OutputFormat()->SizeInBytes() ==
+      node.Parent->BoundTransform->OutputFormat()->SizeInBytes();
+}
+
+void TransformTree::PropagateUsedElements() noexcept {
+  std::unordered_set<const Node*> results;
+  for (auto& feature : features_) {
+    results.insert(feature.second.get());
+  }
+  std::function<ElementRange(Node*)> propagate = [&](Node* node) {
+    // The union of the ranges which the children require
+    ElementRange used { ElementRange::kAll, 0 };
+    node->ActionOnEachImmediateChild([&](Node& child) {
+      auto required = child.BoundTransform->RequiredElements(
+          propagate(&child));
+      used.Begin = std::min(used.Begin, required.Begin);
+      used.End = std::max(used.End, required.End);
+    });
+    if (results.find(node) != results.end() || used.Begin > used.End) {
+      used = ElementRange::All();
+    }
+    node->BoundTransform->set_used_elements(used);
+    return used;
+  };
+  propagate(root_.get());
+}
+
+bool TransformTree::IsGate(const Node& node) noexcept {
+  return dynamic_cast<const transforms::Gate*>(node.BoundTransform.get()) !=
+      nullptr;
+}
+
+void TransformTree::CheckGates() const {
+  root_->ActionOnSubtree([](const Node& node) {
+    auto gate = node.Parent;
+    while (gate != nullptr && !IsGate(*gate)) {
+      gate = gate->Parent;
+    }
+    if (gate == nullptr) {
+      return;
+    }
+    // E.g., Delta is buffer invariant but reads the neighbours
+    auto overlap = node.BoundTransform->RequiredOverlap({ 0, 0 });
+    if ((!node.BoundTransform->BufferInvariant() && !IsGate(node)) ||
+        (overlap.Bounded() && overlap.Before + overlap.After > 0) ||
+        node.BuffersCount != node.Parent->BuffersCount) {
+      throw UngateableTransformException(node.BoundTransform->Name());
+    }
+  });
+}
+
+void TransformTree::AssignGates() noexcept {
+  gate_selections_.clear();
+  root_->ActionOnSubtree([this](Node& node) {
+    auto parent = node.Parent;
+    node.Gate = parent == nullptr? nullptr
+                                 : parent->GateIndex >= 0? parent
+                                                         : parent->Gate;
+    node.GateIndex = -1;
+    if (IsGate(node)) {
+      node.GateIndex = gate_selections_.size();
+      gate_selections_.push_back(
+          { std::vector<uint32_t>(node.BuffersCount), 0, 0 });
+    }
+  });
+  std::set<const Node*> gated;
+  for (auto& feature : features_) {
+    auto node = feature.second.get();
+    if (node->Gate != nullptr || node->GateIndex >= 0) {
+      gated.insert(node);
+    }
+  }
+  // The feature which shares the memory with another one moves together
+  // with it
+  gated_results_.clear();
+  for (auto node : gated) {
+    bool shared = false;
+    for (auto alias = node; (alias->View || alias->InPlace) && !shared;) {
+      alias = alias->Parent;
+      shared = gated.find(alias) != gated.end();
+    }
+    if (!shared) {
+      gated_results_.push_back(node);
+    }
+  }
+}
+
+void TransformTree::ScatterGated(ExecutionContext* context) const noexcept {
+  auto& selections = context == nullptr? gate_selections_
+                                        : context->gate_selections_;
+  for (auto node : gated_results_) {
+    auto& buffers = *node->ContextBuffers(context);
+    size_t size = buffers.Format()->UnalignedSizeInBytes();
+    // The other formats are zeroed
+    bool floats = buffers.Format()->Id().find("float") != std::string::npos;
+    for (auto gate = node->GateIndex >= 0? node : node->Gate;
+         gate != nullptr; gate = gate->Gate) {
+      auto& selection = selections[gate->GateIndex];
+      float fill = dynamic_cast<const transforms::Gate&>(
+          *gate->BoundTransform).fill();
+      // Backwards, since the selected frames are packed at the beginning
+      size_t passed = selection.Count;
+      for (size_t i = selection.Total; i-- > 0;) {
+        auto frame = buffers[i];
+        if (passed > 0 && selection.Indices[passed - 1] == i) {
+          passed--;
+          if (passed != i) {
+            memcpy(frame, buffers[passed], size);
+          }
+        } else if (floats) {
+          std::fill_n(reinterpret_cast<float*>(frame), size / sizeof(float),
+                      fill);
+        } else {
+          memset(frame, 0, size);
+        }
+      }
+    }
+  }
+  for (auto& selection : selections) {
+    selection.Count = 0;
+    selection.Total = 0;
+  }
+  Sink(late_sinks_, context);
+}
+
+void TransformTree::Sink(const SinkList& features,
+                         const ExecutionContext* context) const noexcept {
+  auto& sink = context == nullptr? feature_sink_ : context->feature_sink_;
+  if (!sink) {
+    return;
+  }
+  for (auto& feature : features) {
+    if (feature.second->Active(context)) {
+      sink(feature.first, *feature.second->ContextBuffers(context));
+    }
+  }
+}
+
+bool TransformTree::HasDenseView(const Node& node) noexcept {
+  return node.ChildrenCount() == 1 &&
+      IsDenseView(*node.Children.begin()->second.front());
+}
+
+bool TransformTree::HasPaddingChild(const Node& node) noexcept {
+  if (node.Parent == nullptr || node.View || node.ChildrenCount() != 1) {
+    return false;
+  }
+  auto& child = *node.Children.begin()->second.front();
+  if (dynamic_cast<const transforms::ZeroPadding*>(
+          child.BoundTransform.get()) == nullptr) {
+    return false;
+  }
+  size_t padded = child.BoundTransform->OutputFormat()->SizeInBytes();
+  return padded == PackedStride(node) &&
+      padded > node.BoundTransform->OutputFormat()->SizeInBytes();
+}
+
+bool TransformTree::IsPacked(const Node& node) const noexcept {
+  if (HasDenseView(node) || HasPaddingChild(node)) {
+    return true;
+  }
+  // The in-place leaves share the buffers of their parents
+  if (!packed_results_ || node.Parent == nullptr ||
+      node.ChildrenCount() > 0 || node.View || node.InPlace) {
+    return false;
+  }
+  return PackedStride(node) <
+      node.BoundTransform->OutputFormat()->SizeInBytes();
+}
+
+size_t TransformTree::PackedStride(const Node& node) noexcept {
+  size_t size = node.BoundTransform->OutputFormat()->UnalignedSizeInBytes();
+  size_t stride = 1;
+  while (stride < size) {
+    stride <<= 1;
+  }
+  return stride;
+}
+
+void TransformTree::ReplaceChain(Node* first, Node* last,
+                                 const std::shared_ptr<Transform>& fused) {
+  GraftNode(first->Parent, last, fused);
+  DetachNode(first, fused->Name());
+}
+
+void TransformTree::GraftNode(Node* parent, Node* last,
+                              const std::shared_ptr<Transform>& fused) {
+  InvalidatePlan();
+  fused->set_streaming(streaming_);
+  size_t buffers_count = fused->SetInputFormat(
+      parent->BoundTransform->OutputFormat(), parent->BuffersCount);
+  assert(buffers_count == last->BuffersCount);
+  assert(*fused->OutputFormat() == *last->BoundTransform->OutputFormat());
+  auto node = std::make_shared<Node>(parent, fused, buffers_count, this);
+  for (auto replaced = last; replaced != parent; replaced = replaced->Parent) {
+    std::string name = replaced->Fused.empty()?
+        replaced->BoundTransform->Name() : replaced->Fused;
+    node->Fused = node->Fused.empty()? name : name + " + " + node->Fused;
+  }
+  node->Children = last->Children;
+  node->ActionOnEachImmediateChild([&node](Node& child) {
+    child.Parent = node.get();
+  });
+  node->RelatedFeatures = last->RelatedFeatures;
+  auto last_ptr = last->SelfPtr();
+  for (auto& feature : features_) {
+    if (feature.second == last_ptr) {
+      feature.second = node;
+    }
+  }
+  parent->Children[fused->Name()].push_back(node);
+}
+
+void TransformTree::DetachNode(Node* node, const std::string& fused_name) {
+  InvalidatePlan();
+  // Detach the fused node from the parent, this destroys it
+  auto name = node->BoundTransform->Name();
+  DBG("Fusing %s into %s", name.c_str(), fused_name.c_str());
+  auto& siblings = node->Parent->Children[name];
+  siblings.erase(std::find_if(
+      siblings.begin(), siblings.end(),
+      [node](const std::shared_ptr<Node>& sibling) {
+    return sibling.get() == node;
+  }));
+  if (siblings.empty()) {
+    node->Parent->Children.erase(name);
+  }
+}
+
+std::vector<std::vector<TransformTree::Node*>>
+TransformTree::FindCacheFriendlyChains() const noexcept {
+  std::vector<std::vector<Node*>> chains;
+  auto node = root_.get();
+  while (node != nullptr) {
+    // Search for the next cycle entry candidate
+    do {
+      node = node->Next;
+    }
+    while (node != nullptr && (!Sliceable(*node) || node->Gate != nullptr));
+    if (node == nullptr) {
+      break;
+    }
+    // Grow the cycle
+    std::vector<Node*> current_cycle;
+    // The child of a view follows the node the view shares the buffers with
+    while (node != nullptr && Sliceable(*node) &&
+           node->Gate == nullptr && node->ChildrenCount() > 0 &&
+           (current_cycle.empty() || node->Parent == current_cycle.back())) {
+      current_cycle.push_back(node);
+      node = node->Next;
+    }
+    // The sibling leaves, e.g. the reductions of the same buffers, are
+    // executed one after another on each slice while it is in the cache
+    Node* leaves_parent = current_cycle.empty()? node->Parent
+                                               : current_cycle.back();
+    while (node != nullptr && Sliceable(*node) &&
+           node->Gate == nullptr && node->ChildrenCount() == 0 &&
+           node->Parent == leaves_parent) {
+      current_cycle.push_back(node);
+      node = node->Next;
+    }
+    // The slices are interleaved, so the buffers of the cycle and of its
+    // parent must not overlap, though the allocator could reuse the memory
+    // of the nodes which are no longer needed in the original order
+    auto overlap = [](const Node* n1, const Node* n2) {
+      auto begin1 = reinterpret_cast<uintptr_t>(
+          std::const_pointer_cast<const Buffers>(n1->BoundBuffers)->Data());
+      auto begin2 = reinterpret_cast<uintptr_t>(
+          std::const_pointer_cast<const Buffers>(n2->BoundBuffers)->Data());
+      return begin1 < begin2 + n2->BoundBuffers->SizeInBytes() &&
+          begin2 < begin1 + n1->BoundBuffers->SizeInBytes();
+    };
+    for (size_t i = 0; i < current_cycle.size(); i++) {
+      bool overlaps = current_cycle[0]->Parent->Parent != nullptr &&
+          overlap(current_cycle[i], current_cycle[0]->Parent);
+      for (size_t j = 0; j < i && !overlaps; j++) {
+        overlaps = overlap(current_cycle[i], current_cycle[j]);
+      }
+      if (overlaps) {
+        current_cycle.resize(i);
+        break;
+      }
+    }
+    if (current_cycle.size() <= 1) {
+      continue;
+    }
+#ifndef NDEBUG
+    auto ratios = ChainRatios(current_cycle);
+    for (size_t i = 0; i < current_cycle.size(); i++) {
+      assert(current_cycle[0]->Parent->BuffersCount * ratios[i] ==
+             current_cycle[i]->BoundBuffers->Count());
+    }
+#endif
+    chains.push_back(std::move(current_cycle));
+  }
+  return chains;
+}
+
+bool TransformTree::Sliceable(const Node& node) noexcept {
+  auto ratio = node.BoundTransform->BufferRatio();
+  return ratio > 0 && node.Parent != nullptr &&
+      node.BuffersCount == node.Parent->BuffersCount * ratio;
+}
+
+std::vector<size_t> TransformTree::ChainRatios(
+    const std::vector<Node*>& chain) noexcept {
+  std::unordered_map<const Node*, size_t> ratios { { chain[0]->Parent, 1 } };
+  std::vector<size_t> ret;
+  for (auto cn : chain) {
+    ret.push_back(ratios[cn->Parent] * cn->BoundTransform->BufferRatio());
+    ratios[cn] = ret.back();
+  }
+  return ret;
+}
+
+size_t TransformTree::MaxInputSize(const std::vector<Node*>& chain) noexcept {
+  auto ratios = ChainRatios(chain);
+  size_t max_size = 0;
+  for (size_t i = 0; i < chain.size(); i++) {
+    // The buffers which a single buffer of the head turns into
+    auto size = chain[i]->BoundTransform->InputFormat()->SizeInBytes() *
+        ratios[i] / chain[i]->BoundTransform->BufferRatio();
+    if (size > max_size) {
+      max_size = size;
+    }
+  }
+  assert(max_size > 0);
+  return max_size;
+}
+
+void TransformTree::SliceCycle(const std::vector<Node*>& cycle,
+                               size_t sliceBuffersCount,
+                               int cycleId) noexcept {
+  InvalidatePlan();
+  auto prev_node = PreviousNode(cycle[0]);
+  assert(prev_node != nullptr);
+  // The slices are counted in the buffers of the head
+  size_t bufs_count = cycle[0]->Parent->BuffersCount;
+  auto ratios = ChainRatios(cycle);
+  // Mark the nodes as cloned
+  for (auto cn : cycle) {
+    cn->HasClones = true;
+    cn->CycleId = cycleId;
+  }
+  // Clone those nodes, connecting each slice's end to the next slice's
+  // beginning.
+  Node* head = cycle[0]->Parent;
+  assert(head != nullptr);
+  Node* tail = head;
+  Node* first = nullptr;
+  for (size_t i = 0; i < bufs_count; i += sliceBuffersCount) {
+    auto my_bufs_count = std::min(sliceBuffersCount, bufs_count - i);
+    // The clones of the slice by their originals, the trailing leaves
+    // are the siblings
+    std::unordered_map<const Node*, Node*> clones { { head, head } };
+    for (size_t j = 0; j < cycle.size(); j++) {
+      auto cn = cycle[j];
+      auto parent = clones[cn->Parent];
+      auto cloned = std::make_shared<Node>(parent, cn->BoundTransform,
+                                           my_bufs_count * ratios[j], this);
+      clones[cn] = cloned.get();
+      if (parent == head) {
+        head->Slices[cloned.get()] = std::make_tuple(i, my_bufs_count);
+        cloned->ParentSlice = std::make_shared<Buffers>(
+            head->BoundBuffers->Slice(i, my_bufs_count));
+      }
+      if (j == 0) {
+        if (i == 0) {
+          first = cloned.get();
+        }
+        first->SliceStarts.push_back(cloned.get());
+      }
+      cloned->RelatedFeatures = cn->RelatedFeatures;
+      cloned->BoundBuffers = std::make_shared<Buffers>(
+          cn->BoundBuffers->Slice(i * ratios[j], my_bufs_count * ratios[j]));
+      cloned->Offset = cn->Offset + (
+          reinterpret_cast<const char*>(std::const_pointer_cast<
+              const Buffers>(cloned->BoundBuffers)->Data()) -
+          reinterpret_cast<const char*>(std::const_pointer_cast<
+              const Buffers>(cn->BoundBuffers)->Data()));
+      cloned->BuffersCount = my_bufs_count * ratios[j];
+      cloned->OriginalNode = cn;
+      cloned->CycleId = cycleId;
+      cloned->SliceIndex = i / sliceBuffersCount;
+      parent->Children[cloned->BoundTransform->Name()].push_back(cloned);
+      if (head == tail) {
+        // The very first iteration
+        prev_node->Next = cloned.get();
+      } else {
+        tail->Next = cloned.get();
+      }
+      tail = cloned.get();
+    }
+  }
+  tail->Next = cycle.back()->Next;
+  IndexNodes();
+}
+
+int TransformTree::BuildSlicedCycles() {
+  int ret = 0;  // the resulting number of built cycles
+  auto chains = FindCacheFriendlyChains();
+  for (size_t i = 0; i < chains.size(); i++) {
+    // Determine the size bottleneck
+    size_t bufs_count = chains[i][0]->Parent->BuffersCount;
+    size_t slice_buffers_count = get_cpu_cache_size() / MaxInputSize(chains[i]);
+    if (slice_buffers_count > 0 && bufs_count > slice_buffers_count) {
+      SliceCycle(chains[i], slice_buffers_count, i + 1);
+      ret++;
+    }
+  }
+  if (cache_autotuning_ && !chains.empty()) {
+    ret = TuneSlicedCycles(chains);
+  }
+  return ret;
+}
+
+std::vector<size_t> TransformTree::SliceCandidates(
+    const std::vector<Node*>& chain) const noexcept {
+  size_t bufs_count = chain[0]->Parent->BuffersCount;
+  size_t max_size = MaxInputSize(chain);
+  // Not sliced at all
+  std::set<size_t> candidates { bufs_count };
+  std::vector<size_t> caches { get_cpu_cache_size() };
+#ifdef _SC_LEVEL1_DCACHE_SIZE
+  for (auto name : { _SC_LEVEL1_DCACHE_SIZE, _SC_LEVEL2_CACHE_SIZE,
+                     _SC_LEVEL3_CACHE_SIZE }) {
+    auto size = sysconf(name);
+    if (size > 0) {
+      caches.push_back(size);
+    }
+  }
+#endif
+  size_t threads = std::max(get_omp_transforms_max_threads_num(), 1);
+  for (auto cache : caches) {
+    // The halves account for the cache shared by SMT siblings and for
+    // the working sets of the transforms
+    for (size_t share : { 1, 2 }) {
+      size_t slice = cache / share / max_size;
+      if (slice == 0 || slice >= bufs_count) {
+        continue;
+      }
+      // Make the number of slices a multiple of the number of threads
+      size_t slices = (bufs_count + slice - 1) / slice;
+      slices = (slices + threads - 1) / threads * threads;
+      candidates.insert((bufs_count + slices - 1) / slices);
+    }
+  }
+  return std::vector<size_t>(candidates.begin(), candidates.end());
+}
+
+std::shared_ptr<void> TransformTree::SyntheticInput() const {
+  size_t input_size = root_format_->SizeInBytes() * root_->BuffersCount;
+  std::shared_ptr<void> input(malloc_aligned(input_size), std::free);
+  if (input.get() == nullptr) {
+    throw FailedToAllocateBuffersException(std::string("Failed to allocate ") +
+                                           std::to_string(input_size) +
+                                           " bytes.");
+  }
+  std::minstd_rand rng(kAutotuningSeed);
+  switch (root_sample_type_) {
+    case SampleType::kInt16: {
+      auto samples = reinterpret_cast<int16_t*>(input.get());
+      for (size_t i = 0; i < input_size / sizeof(int16_t); i++) {
+        samples[i] = static_cast<int16_t>(rng());
+      }
+      break;
+    }
+    case SampleType::kInt32: {
+      auto samples = reinterpret_cast<int32_t*>(input.get());
+      for (size_t i = 0; i < input_size / sizeof(int32_t); i++) {
+        samples[i] = static_cast<int16_t>(rng());
+      }
+      break;
+    }
+    case SampleType::kFloat: {
+      auto samples = reinterpret_cast<float*>(input.get());
+      for (size_t i = 0; i < input_size / sizeof(float); i++) {
+        samples[i] = static_cast<int16_t>(rng()) / 32768.f;
+      }
+      break;
+    }
+  }
+  return input;
+}
+
+void TransformTree::WarmUp() {
+  MemoryPool::Prefault(allocated_memory_.get(), allocated_size_);
+  auto input = SyntheticInput();
+  auto root_buffers = root_->BoundBuffers;
+  root_->BoundBuffers = root_->BoundTransform->CreateOutputBuffers(
+      root_->BuffersCount, input.get());
+  BindInput(input.get(), nullptr);
+  // Nothing observes this execution
+  auto profiling = std::move(profiler_);
+  auto capture = std::move(capture_);
+  auto sink = std::move(feature_sink_);
+  validate_execution_ = false;
+  auto check_point_start = std::chrono::high_resolution_clock::now();
+  RunNodes(nullptr);
+  INF("Warmed up in %f s", ConvertDuration(
+      std::chrono::high_resolution_clock::now() - check_point_start));
+  DismantleMemoryProtection();
+  root_->BoundBuffers = root_buffers;
+  profiler_ = std::move(profiling);
+  capture_ = std::move(capture);
+  feature_sink_ = std::move(sink);
+  ResetTimers();
+  ResetStream();
+}
+
+int TransformTree::TuneSlicedCycles(
+    const std::vector<std::vector<Node*>>& chains) {
+  // The timings of the buffer invariant transforms do not depend on
+  // the actual data, so feed the noise
+  auto input = SyntheticInput();
+  auto samples = input.get();
+  auto root_buffers = root_->BoundBuffers;
+  root_->BoundBuffers = root_->BoundTransform->CreateOutputBuffers(
+      root_->BuffersCount, samples);
+  BindInput(samples, nullptr);
+  auto profiling = std::move(profiler_);
+  auto sink = std::move(feature_sink_);
+  // Fill the heads of the chains
+  RunNodes(nullptr);
+  DismantleMemoryProtection();
+  int ret = 0;
+  for (size_t c = 0; c < chains.size(); c++) {
+    auto& chain = chains[c];
+    int cycle_id = c + 1;
+    DismantleSlicedCycle(cycle_id);
+    auto prev = PreviousNode(chain[0]);
+    auto end = chain.back()->Next;
+    size_t bufs_count = chain[0]->Parent->BuffersCount;
+    size_t best = bufs_count;
+    auto best_time = std::chrono::high_resolution_clock::duration::max();
+    for (auto candidate : SliceCandidates(chain)) {
+      DismantleSlicedCycle(cycle_id);
+      if (candidate < bufs_count) {
+        SliceCycle(chain, candidate, cycle_id);
+      }
+      auto elapsed = std::chrono::high_resolution_clock::duration::max();
+      for (int run = 0; run < kAutotuningRuns; run++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (auto node = prev->Next; node != end;) {
+          if (node->OriginalNode != nullptr && parallel_slices_) {
+            node = node->ExecuteSlices(nullptr);
+          } else {
+            node->ExecuteBoundTransform(nullptr);
+            node = node->Next;
+          }
+        }
+        elapsed = std::min(elapsed,
+                           std::chrono::high_resolution_clock::now() - start);
+        DismantleMemoryProtection();
+      }
+      DBG("%s chain: %zu buffers per slice took %f s",
+          chain[0]->BoundTransform->Name().c_str(), candidate,
+          ConvertDuration(elapsed));
+      if (elapsed < best_time) {
+        best_time = elapsed;
+        best = candidate;
+      }
+    }
+    DismantleSlicedCycle(cycle_id);
+    if (best < bufs_count) {
+      SliceCycle(chain, best, cycle_id);
+      ret++;
+    }
+    INF("Tuned %s chain of %zu transforms: %zu buffers per slice out of %zu",
+        chain[0]->BoundTransform->Name().c_str(), chain.size(), best,
+        bufs_count);
+  }
+  root_->BoundBuffers = root_buffers;
+  profiler_ = std::move(profiling);
+  feature_sink_ = std::move(sink);
+  ResetTimers();
+  return ret;
+}
+
+void TransformTree::RunNodes(ExecutionContext* context) const noexcept {
+  std::chrono::high_resolution_clock::time_point start;
+  if (profiler_) {
+    start = std::chrono::high_resolution_clock::now();
+  }
+  SFE_PROBE3(execute__start, this, context, root_->BuffersCount);
+  if (parallel_execution_) {
+    root_->ExecuteInParallel(context);
+  } else {
+    root_->Execute(context);
+  }
+  ScatterGated(context);
+  SFE_PROBE3(execute__end, this, context, root_->BuffersCount);
+  if (profiler_) {
+    profiler_->AddRegion(context == nullptr? "Execute" : "Execute (context)",
+                         start, std::chrono::high_resolution_clock::now());
+  }
+}
+
+void TransformTree::RunStage(Node* first, Node* last,
+                             ExecutionContext* context) const noexcept {
+  for (auto node = first; node != last && !ExecutionCancelled();) {
+    if (node->Active(context)) {
+      node->ExecuteBoundTransform(context);
+    }
+    auto next = node->Next;
+    if (next != nullptr && next->OriginalNode != nullptr &&
+        parallel_slices()) {
+      next = next->ExecuteSlices(context);
+    }
+    node = next;
+  }
+  if (last == nullptr) {
+    ScatterGated(context);
+  }
+}
+
+void TransformTree::UpdateTotalTimes(
+    const std::chrono::high_resolution_clock::duration& all,
+    TimersMap* timers) const noexcept {
+  auto other = all;
+  for (auto& timer : *timers) {
+    if (timer.first != "All" && timer.first != "Other") {
+      other -= timer.second;
+    }
+  }
+  if (other.count() < 0) {
+    other = std::chrono::high_resolution_clock::duration::zero();
+  }
+  (*timers)["All"] = all;
+  (*timers)["Other"] = other;
+}
+
+TransformTree::TimersMap TransformTree::Timers(
+    const std::vector<NodeCounters>& counters,
+    const std::chrono::high_resolution_clock::duration& all) const noexcept {
+  TimersMap timers;
+  if (all.count() == 0) {
+    // Not executed yet
+    return timers;
+  }
+  if (profiling_level_ != ProfilingLevel::kOff) {
+    for (auto& cit : transforms_cache_) {
+      timers[cit.first] =
+          std::chrono::high_resolution_clock::duration::zero();
+    }
+    ForEachNode([&](const Node& node) {
+      if (node.Parent != nullptr && node.Id < counters.size()) {
+        timers[node.BoundTransform->Name()] +=
+            TickClock::ToDuration(counters[node.Id].Ticks);
+      }
+    });
+  }
+  UpdateTotalTimes(all, &timers);
+  return timers;
+}
+
+std::unordered_map<const TransformTree::Node*, NodeCounters>
+TransformTree::OriginalNodesCounters(
+    const std::vector<NodeCounters>& counters) const noexcept {
+  std::unordered_map<const Node*, NodeCounters> ret;
+  ForEachNode([&](const Node& node) {
+    if (node.Parent != nullptr && node.Id < counters.size()) {
+      ret[node.OriginalNode != nullptr? node.OriginalNode : &node] +=
+          counters[node.Id];
+    }
+  });
+  return ret;
+}
+
+void TransformTree::IndexNodes() noexcept {
+  size_t id = 0;
+  root_->ActionOnSubtree([&](Node& node) {
+    node.Id = id++;
+    auto cit = transforms_cache_.find(node.BoundTransform->Name());
+    node.DumpBuffers = cit != transforms_cache_.end() && cit->second.Dump;
+  });
+  counters_.assign(id, NodeCounters());
+  AssignGates();
+  BuildPlan();
+  AssignBuffersLayouts();
+  AssignStreamingStores();
+  EstimateParallelism();
+  IndexFeatureNodes();
+}
+
+void TransformTree::BuildPlan() noexcept {
+  plan_.assign(counters_.size(), PlanRecord());
+  plan_children_.clear();
+  root_->ActionOnSubtree([this](Node& node) {
+    auto& record = plan_[node.Id];
+    record.Self = &node;
+    record.Parent = node.Parent != nullptr? node.Parent->Id : -1;
+    record.FirstChild = plan_children_.size();
+    node.ActionOnEachImmediateChild([this](const Node& child) {
+      plan_children_.push_back(child.Id);
+    });
+    record.ChildrenCount = plan_children_.size() - record.FirstChild;
+  });
+}
+
+void TransformTree::InvalidatePlan() noexcept {
+  plan_.clear();
+  plan_children_.clear();
+}
+
+void TransformTree::IndexFeatureNodes() noexcept {
+  feature_nodes_.clear();
+  active_nodes_.clear();
+  for (auto& feature : features_) {
+    auto& nodes = feature_nodes_[feature.first];
+    nodes.assign(counters_.size(), false);
+    for (int id = feature.second->Id; id >= 0; id = plan_[id].Parent) {
+      nodes[id] = true;
+    }
+    // The clones in the sliced cycles are executed instead of the originals
+    for (auto& record : plan_) {
+      auto original = record.Self->OriginalNode;
+      if (original != nullptr && nodes[original->Id]) {
+        nodes[record.Self->Id] = true;
+      }
+    }
+  }
+  sinks_.assign(counters_.size(), SinkList());
+  late_sinks_.clear();
+  for (auto& feature : features_) {
+    // A view is written by the node it shares the buffers with
+    const Node* node = feature.second.get();
+    while (node->View && node->Parent != nullptr) {
+      node = node->Parent;
+    }
+    if (node->Parent == nullptr || feature.second->Gate != nullptr ||
+        feature.second->GateIndex >= 0) {
+      late_sinks_.emplace_back(feature.first, feature.second.get());
+      continue;
+    }
+    // The sliced cycle completes the buffers in its last slice
+    const Node* last = node;
+    for (auto& record : plan_) {
+      if (record.Self->OriginalNode == node &&
+          (last == node || record.Self->SliceIndex > last->SliceIndex)) {
+        last = record.Self;
+      }
+    }
+    sinks_[last->Id].emplace_back(feature.first, feature.second.get());
+  }
+}
+
+void TransformTree::ActivateFeatures(const std::vector<std::string>& features,
+                                     std::vector<bool>* active) const {
+  if (!tree_is_prepared_) {
+    throw TreeIsNotPreparedException();
+  }
+  active->assign(counters_.size(), false);
+  for (auto& name : features) {
+    auto nodes = feature_nodes_.find(name);
+    if (nodes == feature_nodes_.end()) {
+      throw FeatureNotFoundException(name);
+    }
+    for (size_t i = 0; i < nodes->second.size(); i++) {
+      if (nodes->second[i]) {
+        (*active)[i] = true;
+      }
+    }
+  }
+}
+
+void TransformTree::EstimateParallelism() noexcept {
+  root_->ActionOnSubtree([](Node& node) {
+    auto parallel = dynamic_cast<ParallelTransform*>(
+        node.BoundTransform.get());
+    if (parallel == nullptr || node.Parent == nullptr || !node.BoundBuffers ||
+        !node.Parent->BoundBuffers) {
+      return;
+    }
+    size_t in_count = node.Parent->BoundBuffers->Count();
+    if (node.OriginalNode != nullptr && node.Parent->Slices.size() > 0) {
+      in_count = std::get<1>(node.Parent->Slices.find(&node)->second);
+    }
+    size_t bytes = std::max(
+        in_count * node.BoundTransform->InputFormat()->SizeInBytes(),
+        node.BoundBuffers->Count() *
+            node.BoundTransform->OutputFormat()->SizeInBytes());
+    float work = bytes / sizeof(float) * parallel->ElementCost();
+    auto forced = parallel->forced_placement();
+    if (forced != Placement::kAuto) {
+      parallel->set_serial(forced == Placement::kSerial);
+    } else {
+      parallel->set_serial(work < kParallelWorkThreshold);
+    }
+  });
+}
+
+void TransformTree::RefineParallelism(
+    const std::vector<NodeCounters>& counters) const noexcept {
+  ForEachNode([&counters](const Node& node) {
+    if (node.Id >= counters.size() || counters[node.Id].Runs == 0) {
+      return;
+    }
+    auto parallel = dynamic_cast<ParallelTransform*>(
+        node.BoundTransform.get());
+    if (parallel == nullptr ||
+        parallel->forced_placement() != Placement::kAuto) {
+      return;
+    }
+    auto time = TickClock::ToDuration(
+        counters[node.Id].Ticks / counters[node.Id].Runs);
+    auto threshold = std::chrono::microseconds(+kParallelTimeThreshold);
+    if (parallel->serial()) {
+      if (time > 2 * threshold) {
+        parallel->set_serial(false);
+      }
+    } else if (time < threshold) {
+      parallel->set_serial(true);
+    }
+  });
+}
+
+bool TransformTree::KeepsArrayOfStructs(const Node& node) const noexcept {
+  if (node.DumpBuffers) {
+    return true;
+  }
+  for (auto& feature : features_) {
+    if (feature.second.get() == &node) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void TransformTree::AssignStreamingStores() noexcept {
+  root_->ActionOnSubtree([this](Node& node) {
+    auto sst = dynamic_cast<StreamingStoresTransform*>(
+        node.BoundTransform.get());
+    // The clones share the transform with the original node
+    if (sst == nullptr || node.OriginalNode != nullptr) {
+      return;
+    }
+    size_t size = node.BuffersCount *
+        node.BoundTransform->OutputFormat()->SizeInBytes();
+    // The sliced cycles keep the outputs of the slices in the cache
+    bool enabled = streaming_stores_ && (node.ChildrenCount() == 0 ||
+        (!node.HasClones && size > get_cpu_cache_size()));
+    sst->set_streaming_stores(enabled);
+  });
+}
+
+void TransformTree::AssignBuffersLayouts() noexcept {
+  // Start from scratch, since the live changes may have broken the pairs
+  root_->ActionOnSubtree([](Node& node) {
+    auto soa = dynamic_cast<StructOfArraysTransform*>(
+        node.BoundTransform.get());
+    if (soa != nullptr) {
+      soa->set_soa_input(false);
+      soa->set_soa_output(false);
+    }
+  });
+  // Validate(), Dump() and the capture readers treat the buffers as structs
+  if (validate_after_each_transform_ || dump_buffers_after_each_transform_ ||
+      capture_) {
+    return;
+  }
+  root_->ActionOnSubtree([this](Node& node) {
+    auto producer = dynamic_cast<StructOfArraysTransform*>(
+        node.BoundTransform.get());
+    // The clones share the transform with the original node
+    if (producer == nullptr || !producer->SupportsSoAOutput() ||
+        node.OriginalNode != nullptr || node.ChildrenCount() == 0 ||
+        KeepsArrayOfStructs(node)) {
+      return;
+    }
+    std::vector<StructOfArraysTransform*> consumers;
+    bool supported = true;
+    node.ActionOnEachImmediateChild([&](Node& child) {
+      auto consumer = dynamic_cast<StructOfArraysTransform*>(
+          child.BoundTransform.get());
+      // The columns of a slice span only that slice, so both nodes must be
+      // sliced in the same way
+      if (consumer == nullptr || !consumer->SupportsSoAInput() ||
+          child.CycleId != node.CycleId) {
+        supported = false;
+      } else {
+        consumers.push_back(consumer);
+      }
+    });
+    if (!supported) {
+      return;
+    }
+    DBG("%s passes the struct of arrays to its children",
+        node.BoundTransform->Name().c_str());
+    producer->set_soa_output(true);
+    for (auto consumer : consumers) {
+      consumer->set_soa_input(true);
+    }
+  });
+}
+
+std::chrono::high_resolution_clock::duration
+TransformTree::ReportBaseTime(const TimersMap& timers) noexcept {
+  auto all_time = timers.find("All")->second;
+  // Transforms overlap in time during the parallel execution, so their sum
+  // may exceed the wall time
+  auto busy_time = std::chrono::high_resolution_clock::duration::zero();
+  for (auto& timer : timers) {
+    if (timer.first != "All" && timer.first != "Other") {
+      busy_time += timer.second;
+    }
+  }
+  return std::max(all_time, busy_time);
+}
+
+std::unordered_map<std::string, float> TransformTree::TimeReport(
+    const TimersMap& timers) noexcept {
+  std::unordered_map<std::string, float> ret;
+  if (timers.find("All") == timers.end()) {
+    return ret;
+  }
+  auto base_time = ReportBaseTime(timers);
+  for (auto& timer : timers) {
+    if (timer.first != "All") {
+      ret.insert(std::make_pair(
+          timer.first, (timer.second.count() + 0.f) / base_time.count()));
+    } else {
+      ret.insert(std::make_pair(timer.first, ConvertDuration(timer.second)));
+    }
+  }
+  return ret;
+}
+
+std::unique_ptr<memory_allocation::BuffersAllocator>
+TransformTree::CreateAllocator() const {
+  if (parallel_execution_) {
+    // Sibling subtrees run simultaneously, so no buffers may be reused
+    return std::make_unique<memory_allocation::WorstAllocator>();
+  }
+  if (allocation_strategy_ == AllocationStrategy::kIntervalPacking) {
+    return std::make_unique<memory_allocation::IntervalPackingAllocator>();
+  }
+  return std::make_unique<memory_allocation::SlidingBlocksAllocator>();
+}
+
+void TransformTree::DismantleMemoryProtection() noexcept {
+  ForEachNode([this](Node& node) {
+    if (node.Protection) {
+      DBG("Disabling write protection on %p:%zu", node.Protection->page(),
+          node.Protection->size());
+    }
+    node.Protection.reset();
+  });
+}
+
+void TransformTree::ResetTimers() noexcept {
+  std::fill(counters_.begin(), counters_.end(), NodeCounters());
+  all_time_ = std::chrono::high_resolution_clock::duration::zero();
+}
+
+void TransformTree::PrepareForExecution() {
+  Prepare(nullptr);
+}
+
+void TransformTree::FlattenAllocationTree(
+    memory_allocation::Node* node,
+    std::vector<memory_allocation::Node*>* nodes) noexcept {
+  nodes->push_back(node);
+  for (auto& child : node->Children) {
+    FlattenAllocationTree(&child, nodes);
+  }
+}
+
+void TransformTree::Prepare(const PreparedImage* image) {
+  if (tree_is_prepared_) {
+    throw TreeAlreadyPreparedException();
+  }
+  ScopedExecutionOverrides overrides(&execution_overrides_);
+  SFE_PROBE2(prepare__start, this, features_.size());
+  auto prepare_start = std::chrono::high_resolution_clock::now();
+  INF("Sharing identical transforms saved %zu nodes (%zu bytes)",
+      merged_nodes_count_, merged_bytes_);
+  if (approximately_merged_nodes_count_ > 0) {
+    INF("Sharing equivalent transforms saved %zu nodes, the estimated "
+        "speedup is %.2f", approximately_merged_nodes_count_,
+        approximate_sharing_speedup());
+  }
+  if (fuse_transforms_) {
+    auto fused_count = FuseTransforms();
+    DBG("Fused %d chains", fused_count);
+  }
+  if (image != nullptr && !image->States.empty()) {
+    // Restore the precomputed states, so that Initialize() skips them
+    size_t index = 0;
+    bool mismatch = false;
+    root_->ActionOnSubtree([&](const Node& node) {
+      if (index >= image->States.size() ||
+          std::get<0>(image->States[index]) != node.BoundTransform->Name()) {
+        mismatch = true;
+        index++;
+        return;
+      }
+      auto& state = image->States[index++];
+      auto pcs = dynamic_cast<const PrecomputedState*>(
+          node.BoundTransform.get());
+      if (pcs != nullptr && std::get<2>(state) > 0 &&
+          !pcs->LoadState(image->Mapping, std::get<1>(state),
+                          std::get<2>(state))) {
+        WRN("Failed to restore the state of %s, it will be recalculated",
+            node.BoundTransform->Name().c_str());
+      }
+    });
+    if (mismatch || index != image->States.size()) {
+      throw InvalidTreeFileException(image->FileName,
+                                     "the nodes do not match the features");
+    }
+  }
+  CheckGates();
+  PropagateUsedElements();
+  DBG("Initializing the transforms...");
+  // The transforms do not depend on each other's state, so the long
+  // initializations (filter designs, wavelet banks, plans) run in parallel
+  std::vector<const Transform*> transforms;
+  root_->ActionOnEachTransformInSubtree([&transforms](const Transform& t) {
+    transforms.push_back(&t);
+  });
+  std::exception_ptr failure;
+  std::mutex failure_mutex;
+  auto phase_start = std::chrono::high_resolution_clock::now();
+  ThreadPool::Instance().ParallelFor(
+      transforms.size(), 1, get_omp_transforms_max_threads_num(),
+      [&](int begin, int end) {
+    for (int i = begin; i < end; i++) {
+      try {
+        transforms[i]->Initialize();
+      }
+      catch(...) {
+        std::lock_guard<std::mutex> lock(failure_mutex);
+        if (!failure) {
+          failure = std::current_exception();
+        }
+      }
+    }
+  });
+  if (failure) {
+    std::rethrow_exception(failure);
+  }
+  prepare_times_.Initialize =
+      std::chrono::high_resolution_clock::now() - phase_start;
+  // Register every transform in the timers cache beforehand, so that
+  // the parallel execution never inserts into transforms_cache_
+  root_->ActionOnSubtree([this](const Node& node) {
+    if (node.Parent != nullptr) {
+      transforms_cache_[node.BoundTransform->Name()];
+    }
+  });
+  DBG("Finished. Baking the allocation plan...");
+  root_->ActionOnSubtree([](Node& node) {
+    node.View = IsView(node);
+  });
+  root_->ActionOnSubtree([](Node& node) {
+    node.InPlace = IsInPlace(node);
+  });
+  root_->ActionOnSubtree([this](Node& node) {
+    node.Packed = IsPacked(node);
+  });
+  root_->ActionOnSubtree([](Node& node) {
+    if (!node.Packed || node.BuffersCount == 0 || !HasPaddingChild(node)) {
+      return;
+    }
+    auto& child = *node.Children.begin()->second.front();
+    if (child.InPlace) {
+      node.Pinned = true;
+      std::dynamic_pointer_cast<transforms::ZeroPadding>(
+          child.BoundTransform)->set_pad_zeroed(true);
+    }
+  });
+  // Solve the allocation problem
+  phase_start = std::chrono::high_resolution_clock::now();
+  memory_allocation::Node allocation_tree_root(0, nullptr, root_.get());
+  root_->BuildAllocationTree(&allocation_tree_root);
+  std::vector<memory_allocation::Node*> allocation_nodes;
+  FlattenAllocationTree(&allocation_tree_root, &allocation_nodes);
+  size_t neededMemory;
+  if (image != nullptr && !image->Allocation.empty()) {
+    // Apply the saved solution
+    if (image->Allocation.size() != allocation_nodes.size()) {
+      throw InvalidTreeFileException(image->FileName,
+                                     "the allocation plan does not match");
+    }
+    neededMemory = image->AllocatedSize;
+    for (size_t i = 0; i < allocation_nodes.size(); i++) {
+      auto& record = image->Allocation[i];
+      auto node = allocation_nodes[i];
+      if (record.Size != node->Size ||
+          record.Next >= static_cast<int>(allocation_nodes.size()) ||
+          (record.Size > 0 && record.Address + record.Size > neededMemory)) {
+        throw InvalidTreeFileException(image->FileName,
+                                       "the allocation plan does not match");
+      }
+      node->Address = record.Address;
+      node->Next = record.Next < 0? nullptr : allocation_nodes[record.Next];
+    }
+  } else {
+    auto allocator = CreateAllocator();
+    neededMemory = allocator->Solve(&allocation_tree_root);
+#if DEBUG
+    allocation_tree_root.Dump("/tmp/last_allocation.dot");
+    assert(allocator->Validate(allocation_tree_root));
+#endif
+  }
+  // Remember the solution for Save()
+  std::unordered_map<const memory_allocation::Node*, int> indices;
+  for (size_t i = 0; i < allocation_nodes.size(); i++) {
+    indices[allocation_nodes[i]] = i;
+  }
+  allocation_plan_.clear();
+  for (auto node : allocation_nodes) {
+    allocation_plan_.push_back({
+      node->Size, node->Address,
+      node->Next == nullptr? -1 : indices[node->Next]
+    });
+  }
+  // No other buffer may overwrite the zeroed pads, so the pinned buffers
+  // go after the solution
+  pinned_size_ = 0;
+  for (auto node : allocation_nodes) {
+    auto item = reinterpret_cast<Node*>(node->Item);
+    if (item->Pinned) {
+      node->Address = neededMemory + pinned_size_;
+      pinned_size_ += item->AllocationSize();
+    }
+  }
+  neededMemory += pinned_size_;
+  SFE_PROBE3(allocate, this, neededMemory, allocation_nodes.size());
+  if (memory_budget_ > 0 && neededMemory > memory_budget_) {
+    throw MemoryBudgetExceededException(neededMemory, memory_budget_);
+  }
+  prepare_times_.Plan =
+      std::chrono::high_resolution_clock::now() - phase_start;
+  // Allocate the buffers
+  phase_start = std::chrono::high_resolution_clock::now();
+  allocated_memory_ = AcquireMemory(neededMemory);
+  prepare_times_.Allocate =
+      std::chrono::high_resolution_clock::now() - phase_start;
+  INF("Allocated %zu bytes at %p", neededMemory, allocated_memory_.get());
+  allocated_size_ = neededMemory;
+  ClearPinnedMemory(allocated_memory_.get());
+  peak_size_ = memory_allocation::BuffersAllocator::LiveSetPeak(
+      allocation_tree_root) + pinned_size_;
+  // Finally, apply the memory mapping, creating the actual buffers
+  // We will overwrite root's BoundBuffers on execution stage
+  root_->ApplyAllocationTree(allocation_tree_root, allocated_memory_.get());
+  // Try to do CPU cache optimization by splitting the buffers into slices.
+  // The sliced cycles are linked through Next, so they are incompatible with
+  // the parallel execution. Besides, the streaming transforms rely on seeing
+  // all the buffers in a single call.
+  IndexNodes();
+  if (cache_optimization_ && !parallel_execution_ && !streaming_) {
+    auto cycles_count = BuildSlicedCycles();
+    DBG("Built %d cycles", cycles_count);
+  }
+  tree_is_prepared_ = true;
+  if (warm_up_) {
+    WarmUp();
+  }
+  if (realtime_) {
+    PrepareRealtime();
+  }
+  prepare_times_.Total =
+      std::chrono::high_resolution_clock::now() - prepare_start;
+  SFE_PROBE2(prepare__end, this, allocated_size_);
+  INF("Prepared to extract %zu features", features_.size());
+#if DEBUG
+  Dump("/tmp/last_nodes.dot");
+#endif
+}
+
+/// @brief The first bytes of the files written by TransformTree::Save().
+static constexpr char kTreeFileMagic[8] = "SFETREE";
+static constexpr uint32_t kTreeFileVersion = 8;
+
+template <class T>
+static void AppendValue(const T& value, std::string* out) {
+  out->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+static void AppendString(const std::string& str, std::string* out) {
+  AppendValue(static_cast<uint32_t>(str.size()), out);
+  out->append(str);
+}
+
+/// @brief Sequentially reads the memory mapped file written by Save().
+class TreeFileReader {
+ public:
+  TreeFileReader(const std::string& fileName, const char* data, size_t size)
+      : file_name_(fileName), begin_(data), ptr_(data), end_(data + size) {
+  }
+
+  template <class T>
+  T Read() {
+    T value;
+    memcpy(&value, Advance(sizeof(T)), sizeof(T));
+    return value;
+  }
+
+  std::string ReadString() {
+    auto size = Read<uint32_t>();
+    return std::string(Advance(size), size);
+  }
+
+  /// @brief Skips the padding and returns the aligned blob.
+  const char* ReadBlob(size_t size) {
+    auto offset = ptr_ - begin_;
+    auto aligned = (offset + PrecomputedState::kAlignment - 1) &
+        ~(PrecomputedState::kAlignment - 1);
+    Advance(aligned - offset);
+    return Advance(size);
+  }
+
+ private:
+  const char* Advance(size_t size) {
+    if (static_cast<size_t>(end_ - ptr_) < size) {
+      throw InvalidTreeFileException(file_name_, "unexpected end of file");
+    }
+    auto res = ptr_;
+    ptr_ += size;
+    return res;
+  }
+
+  const std::string& file_name_;
+  const char* begin_;
+  const char* ptr_;
+  const char* end_;
+};
+
+void TransformTree::Save(const std::string& fileName) const {
+  if (!tree_is_prepared_) {
+    throw TreeIsNotPreparedException();
+  }
+  std::string data(kTreeFileMagic, sizeof(kTreeFileMagic));
+  AppendValue(kTreeFileVersion, &data);
+  AppendValue(static_cast<uint8_t>(root_sample_type_), &data);
+  AppendValue(static_cast<uint32_t>(root_size_), &data);
+  AppendValue(static_cast<int32_t>(root_format_->SamplingRate()), &data);
+  AppendValue(static_cast<uint64_t>(root_->BuffersCount), &data);
+  for (bool flag : { streaming_, parallel_execution_, cache_optimization_,
+                     memory_protection_, fuse_transforms_, memory_guards_ }) {
+    AppendValue(static_cast<uint8_t>(flag), &data);
+  }
+  AppendValue(static_cast<uint8_t>(channels_layout_), &data);
+  AppendValue(static_cast<uint8_t>(accuracy_), &data);
+  AppendValue(static_cast<uint32_t>(equivalences_.size()), &data);
+  for (auto& equivalence : equivalences_) {
+    AppendString(equivalence.Transform, &data);
+    AppendString(equivalence.Parameters, &data);
+  }
+  AppendValue(static_cast<uint32_t>(feature_chains_.size()), &data);
+  for (auto& chain : feature_chains_) {
+    AppendString(chain.first, &data);
+    AppendValue(static_cast<uint32_t>(chain.second.size()), &data);
+    for (auto& tpair : chain.second) {
+      AppendString(tpair.first, &data);
+      AppendString(tpair.second, &data);
+    }
+  }
+  // The tree which was changed after PrepareForExecution() is built
+  // differently by Load(), so neither the plan nor the states apply
+  bool changed = layout_version_ > 0;
+  // Prepare() appends the pinned buffers to the solution anew
+  AppendValue(static_cast<uint64_t>(allocated_size_ - pinned_size_), &data);
+  AppendValue(static_cast<uint32_t>(changed? 0 : allocation_plan_.size()),
+              &data);
+  if (!changed) {
+    for (auto& record : allocation_plan_) {
+      AppendValue(static_cast<uint64_t>(record.Size), &data);
+      AppendValue(static_cast<uint64_t>(record.Address), &data);
+      AppendValue(static_cast<int32_t>(record.Next), &data);
+    }
+  }
+  // The states of the original nodes; the clones made by BuildSlicedCycles()
+  // are skipped since Load() builds them again
+  std::vector<const Node*> nodes;
+  root_->ActionOnSubtree([&](const Node& node) {
+    if (node.OriginalNode == nullptr && !changed) {
+      nodes.push_back(&node);
+    }
+  });
+  AppendValue(static_cast<uint32_t>(nodes.size()), &data);
+  for (auto node : nodes) {
+    AppendString(node->BoundTransform->Name(), &data);
+    std::string state;
+    auto pcs = dynamic_cast<const PrecomputedState*>(
+        node->BoundTransform.get());
+    if (pcs != nullptr) {
+      pcs->SaveState(&state);
+    }
+    AppendValue(static_cast<uint64_t>(state.size()), &data);
+    if (state.size() > 0) {
+      data.resize((data.size() + PrecomputedState::kAlignment - 1) &
+                  ~(PrecomputedState::kAlignment - 1), 0);
+      data += state;
+    }
+  }
+  std::ofstream file(fileName, std::ios::out | std::ios::binary);
+  file.write(data.data(), data.size());
+  if (!file) {
+    throw FailedToSaveTreeException(fileName);
+  }
+  INF("Saved %zu bytes to %s", data.size(), fileName.c_str());
+}
+
+std::shared_ptr<TransformTree> TransformTree::Load(
+    const std::string& fileName) {
+  int fd = open(fileName.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw InvalidTreeFileException(fileName, strerror(errno));
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    throw InvalidTreeFileException(fileName, strerror(errno));
+  }
+  size_t size = st.st_size;
+  void* addr = size > 0?
+      mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+  close(fd);
+  if (addr == MAP_FAILED) {
+    throw InvalidTreeFileException(fileName, "failed to map the file");
+  }
+  return Load(fileName, addr, size, std::shared_ptr<const void>(
+      addr, [size](const void* ptr) {
+        munmap(const_cast<void*>(ptr), size);
+      }));
+}
+
+std::shared_ptr<TransformTree> TransformTree::Load(
+    const std::string& fileName, const void* data, size_t size,
+    const std::shared_ptr<const void>& owner) {
+  if (reinterpret_cast<uintptr_t>(data) % PrecomputedState::kAlignment != 0) {
+    throw InvalidTreeFileException(fileName, "the image is misaligned");
+  }
+  PreparedImage image;
+  image.FileName = fileName;
+  image.Mapping = owner;
+  TreeFileReader reader(fileName, reinterpret_cast<const char*>(data), size);
+  char magic[sizeof(kTreeFileMagic)];
+  for (auto& c : magic) {
+    c = reader.Read<char>();
+  }
+  if (memcmp(magic, kTreeFileMagic, sizeof(magic)) != 0) {
+    throw InvalidTreeFileException(fileName, "wrong signature");
+  }
+  if (reader.Read<uint32_t>() != kTreeFileVersion) {
+    throw InvalidTreeFileException(fileName, "unsupported version");
+  }
+  auto sampleType = static_cast<SampleType>(reader.Read<uint8_t>());
+  auto rootSize = reader.Read<uint32_t>();
+  auto samplingRate = reader.Read<int32_t>();
+  std::shared_ptr<TransformTree> tree;
+  switch (sampleType) {
+    case SampleType::kInt16:
+      tree = std::make_shared<TransformTree>(
+          std::make_shared<formats::ArrayFormat16>(rootSize, samplingRate));
+      break;
+    case SampleType::kInt32:
+      tree = std::make_shared<TransformTree>(
+          std::make_shared<formats::ArrayFormat32>(rootSize, samplingRate));
+      break;
+    case SampleType::kFloat:
+      tree = std::make_shared<TransformTree>(
+          std::make_shared<formats::ArrayFormatF>(rootSize, samplingRate));
+      break;
+    default:
+      throw InvalidTreeFileException(fileName, "unknown sample type");
+  }
+  tree->set_batch_size(reader.Read<uint64_t>());
+  tree->set_streaming(reader.Read<uint8_t>());
+  tree->set_parallel_execution(reader.Read<uint8_t>());
+  tree->set_cache_optimization(reader.Read<uint8_t>());
+  tree->set_memory_protection(reader.Read<uint8_t>());
+  tree->set_fuse_transforms(reader.Read<uint8_t>());
+  tree->set_memory_guards(reader.Read<uint8_t>());
+  tree->set_channels_layout(static_cast<ChannelsLayout>(
+      reader.Read<uint8_t>()));
+  tree->set_accuracy(static_cast<Accuracy>(reader.Read<uint8_t>()));
+  auto equivalencesCount = reader.Read<uint32_t>();
+  for (uint32_t i = 0; i < equivalencesCount; i++) {
+    auto transform = reader.ReadString();
+    tree->AddEquivalence(transform, reader.ReadString());
+  }
+  auto featuresCount = reader.Read<uint32_t>();
+  for (uint32_t i = 0; i < featuresCount; i++) {
+    auto name = reader.ReadString();
+    std::vector<std::pair<std::string, std::string>> transforms(
+        reader.Read<uint32_t>());
+    for (auto& tpair : transforms) {
+      tpair.first = reader.ReadString();
+      tpair.second = reader.ReadString();
+    }
+    tree->AddFeature(name, transforms);
+  }
+  image.AllocatedSize = reader.Read<uint64_t>();
+  image.Allocation.resize(reader.Read<uint32_t>());
+  for (auto& record : image.Allocation) {
+    record.Size = reader.Read<uint64_t>();
+    record.Address = reader.Read<uint64_t>();
+    record.Next = reader.Read<int32_t>();
+  }
+  image.States.resize(reader.Read<uint32_t>());
+  for (auto& state : image.States) {
+    std::get<0>(state) = reader.ReadString();
+    std::get<2>(state) = reader.Read<uint64_t>();
+    std::get<1>(state) = std::get<2>(state) > 0?
+        reader.ReadBlob(std::get<2>(state)) : nullptr;
+  }
+  tree->Prepare(&image);
+  return tree;
+}
+
+const std::unordered_map<std::string, std::shared_ptr<Buffers>>&
+TransformTree::Execute(const void* in) {
+  active_nodes_.clear();
+  return ExecuteActive(in);
+}
+
+const std::unordered_map<std::string, std::shared_ptr<Buffers>>&
+TransformTree::Execute(const void* in,
+                       const std::vector<std::string>& features) {
+  ActivateFeatures(features, &active_nodes_);
+  return ExecuteActive(in);
+}
+
+std::vector<std::string> TransformTree::SelectFeatures(
+    const std::vector<std::string>& priorities,
+    const std::chrono::high_resolution_clock::duration& budget,
+    std::vector<std::string>* skipped) const {
+  if (!tree_is_prepared_) {
+    throw TreeIsNotPreparedException();
+  }
+  std::vector<uint64_t> ticks(counters_.size());
+  root_->ActionOnSubtree([&ticks](const Node& node) {
+    ticks[node.Id] = node.LastTicks.load(std::memory_order_relaxed);
+  });
+  // The shared nodes are accounted once
+  std::vector<bool> picked(counters_.size(), false);
+  uint64_t total = 0;
+  std::vector<std::string> selected;
+  for (auto& name : priorities) {
+    auto nodes = feature_nodes_.find(name);
+    if (nodes == feature_nodes_.end()) {
+      throw FeatureNotFoundException(name);
+    }
+    uint64_t extra = 0;
+    for (size_t i = 0; i < ticks.size(); i++) {
+      if (nodes->second[i] && !picked[i]) {
+        extra += ticks[i];
+      }
+    }
+    if (!selected.empty() && TickClock::ToDuration(total + extra) > budget) {
+      if (skipped != nullptr) {
+        skipped->push_back(name);
+      }
+      continue;
+    }
+    total += extra;
+    for (size_t i = 0; i < ticks.size(); i++) {
+      if (nodes->second[i]) {
+        picked[i] = true;
+      }
+    }
+    selected.push_back(name);
+  }
+  return selected;
+}
+
+/// @brief The metrics of the executions of all the trees. They are
+/// registered when the library is loaded, so that the real-time executions
+/// never take the lock of Metrics.
+static auto tree_executions = Metrics::Instance().Counter(
+    "sfe_tree_executions", "The executions of the transform trees.");
+static auto tree_execution_latency = Metrics::Instance().Histogram(
+    "sfe_tree_execution_seconds",
+    "The time of the executions of the transform trees.",
+    MetricsHistogram::LatencyBounds());
+
+/// @brief Accounts a finished execution of any tree in Metrics.
+static void RecordExecutionMetrics(
+    const std::chrono::high_resolution_clock::duration& duration) noexcept {
+  tree_executions->Increment();
+  tree_execution_latency->Observe(std::chrono::duration_cast<
+      std::chrono::duration<double>>(duration).count());
+}
+
+const std::unordered_map<std::string, std::shared_ptr<Buffers>>&
+TransformTree::ExecuteActive(const void* in) {
+  if (!tree_is_prepared_) {
+    throw TreeIsNotPreparedException();
+  }
+  ScopedExecutionOverrides overrides(&execution_overrides_);
   if (features_.size() == 0) {
     throw TreeIsEmptyException();
   }
+  if (realtime_) {
+    if (!realtime_prepared_ || realtime_version_ != layout_version_) {
+      PrepareRealtime();
+    }
+    return ExecuteRealtime(in);
+  }
   if (memory_protection()) {
     DismantleMemoryProtection();
   }
+  protect_execution_ = memory_protection() &&
+      protection_counter_++ % memory_protection_period() == 0;
+  if (!allocated_memory_) {
+    BindMemory();
+  }
   ResetTimers();
-  // Initialize input. We have to const_cast here, but "in" is not going
-  // to be overwritten anyway.
-  root_->BoundBuffers = root_->BoundTransform->CreateOutputBuffers(
-      1, const_cast<int16_t*>(in));
-  if (validate_after_each_transform()) {
+  // Populate the results once, the buffers objects stay the same
+  if (results_.empty()) {
+    for (auto& feature : features_) {
+      results_[feature.first] = feature.second->BoundBuffers;
+    }
+    IndexResults(results_, &indexed_results_);
+  }
+  auto constant = ConstantInputKey(in, nullptr);
+  if (!constant.empty()) {
+    auto start = std::chrono::high_resolution_clock::now();
+    if (SubstituteConstantResults(constant, indexed_results_)) {
+      all_time_ = std::chrono::high_resolution_clock::now() - start;
+      RecordExecutionMetrics(all_time_);
+      return results_;
+    }
+  }
+  // Initialize input. The root's buffers were created by
+  // PrepareForExecution().
+  BindInput(PlanarInput(in, &planar_input_), nullptr);
+  if (capture_) {
+    capture_execution_ = capture_->NextExecution();
+  }
+  validate_execution_ = SampleValidation();
+  if (validate_execution_) {
     try {
       root_->BoundBuffers->Validate();
     }
@@ -666,21 +3562,256 @@ TransformTree::Execute(const int16_t* in) {
   DBG("Executing the tree...");
   // Run the transforms, measuring the elapsed time
   auto check_point_start = std::chrono::high_resolution_clock::now();
-  root_->Execute();
+  RunNodes(nullptr);
   auto check_point_finish = std::chrono::high_resolution_clock::now();
+  if (ExecutionCancelled()) {
+    throw ExecutionCancelledException();
+  }
+  if (profiling_level_ != ProfilingLevel::kOff) {
+    RefineParallelism(counters_);
+  }
   auto all_duration = check_point_finish - check_point_start;
   INF("Finished. Execution took %f s", ConvertDuration(all_duration));
-  auto other_duration = all_duration;
-  for (auto& cit : transforms_cache_) {
-    other_duration -= cit.second.ElapsedTime;
+  all_time_ = all_duration;
+  RecordExecutionMetrics(all_duration);
+  if (!constant.empty() && active_nodes_.empty()) {
+    SaveConstantResults(constant, indexed_results_);
+  }
+  return results_;
+}
+
+void TransformTree::PrepareRealtime() {
+  memory_locks_.clear();
+  if (!allocated_memory_) {
+    BindMemory();
+  }
+  if (channels_layout_ != ChannelsLayout::kPlanar &&
+      root_->BuffersCount > 1 && !planar_input_) {
+    planar_input_ = AcquireMemory(
+        root_format_->SizeInBytes() * root_->BuffersCount);
+  }
+  results_.clear();
+  for (auto& feature : features_) {
+    results_[feature.first] = feature.second->BoundBuffers;
+  }
+  IndexResults(results_, &indexed_results_);
+  DismantleMemoryProtection();
+  protect_execution_ = false;
+  validate_execution_ = false;
+  // The transforms create some things lazily, and their scratch leases
+  // are known only after they run the same way, on this thread
+  auto input = SyntheticInput();
+  {
+    RealtimeSection section(false);
+    ScratchArena::FixedBlock measure(nullptr, 0);
+    auto sink = std::move(feature_sink_);
+    RunRealtime(input.get());
+    feature_sink_ = std::move(sink);
+    realtime_scratch_size_ = measure.peak();
+  }
+  realtime_scratch_.reset();
+  if (realtime_scratch_size_ > 0) {
+    realtime_scratch_ = AcquireMemory(realtime_scratch_size_ * sizeof(float));
+  }
+  ResetStream();
+  ResetTimers();
+  std::pair<const void*, size_t> blocks[] {
+    { allocated_memory_.get(), allocated_size_ },
+    { planar_input_.get(), planar_input_?
+          root_format_->SizeInBytes() * root_->BuffersCount : 0 },
+    { realtime_scratch_.get(), realtime_scratch_size_ * sizeof(float) }
+  };
+  for (auto& block : blocks) {
+    if (block.first == nullptr || block.second == 0) {
+      continue;
+    }
+    memory_locks_.push_back(std::unique_ptr<MemoryLock>(
+        new MemoryLock(block.first, block.second)));
+    if (!memory_locks_.back()->locked()) {
+      WRN("Failed to lock %zu bytes in RAM, check RLIMIT_MEMLOCK",
+          block.second);
+    }
+  }
+  realtime_prepared_ = true;
+  realtime_version_ = layout_version_;
+}
+
+const std::unordered_map<std::string, std::shared_ptr<Buffers>>&
+TransformTree::ExecuteRealtime(const void* in) {
+  RealtimeSection section;
+  ScratchArena::FixedBlock scratch(
+      static_cast<float*>(realtime_scratch_.get()), realtime_scratch_size_);
+  auto check_point_start = std::chrono::high_resolution_clock::now();
+  RunRealtime(in);
+  all_time_ = std::chrono::high_resolution_clock::now() - check_point_start;
+  if (ExecutionCancelled()) {
+    throw ExecutionCancelledException();
+  }
+  RecordExecutionMetrics(all_time_);
+  return results_;
+}
+
+void TransformTree::RunRealtime(const void* in) {
+  ResetTimers();
+  BindInput(PlanarInput(in, &planar_input_), nullptr);
+  SFE_PROBE3(execute__start, this, nullptr, root_->BuffersCount);
+  root_->Execute(nullptr);
+  ScatterGated(nullptr);
+  SFE_PROBE3(execute__end, this, nullptr, root_->BuffersCount);
+}
+
+void TransformTree::ReleaseMemory() noexcept {
+  if (!tree_is_prepared_ || !allocated_memory_) {
+    return;
+  }
+  // The locked pages must not get into the pool either
+  memory_locks_.clear();
+  realtime_prepared_ = false;
+  // The protected pages must not get into the pool
+  DismantleMemoryProtection();
+  allocated_memory_.reset();
+  planar_input_.reset();
+}
+
+void TransformTree::BindMemory() {
+  allocated_memory_ = AcquireMemory(allocated_size_);
+  ClearPinnedMemory(allocated_memory_.get());
+  auto memory = reinterpret_cast<char*>(allocated_memory_.get());
+  root_->ActionOnSubtree([memory](Node& node) {
+    // The buffers objects stay the same, since FeatureBuffers() and
+    // CreateExecutionContext() may read their formats concurrently
+    if (node.Parent != nullptr && !node.Memory) {
+      node.BoundBuffers->Rebind(memory + node.Offset);
+    }
+  });
+}
+
+std::shared_ptr<void> TransformTree::AcquireMemory(size_t size) {
+  auto memory = MemoryPool::Instance().Acquire(size);
+  if (memory.get() == nullptr) {
+    throw FailedToAllocateBuffersException(std::string("Failed to allocate ") +
+                                           std::to_string(size) + " bytes.");
+  }
+  return memory;
+}
+
+void TransformTree::ClearPinnedMemory(void* memory) const noexcept {
+  memset(reinterpret_cast<char*>(memory) + allocated_size_ - pinned_size_, 0,
+         pinned_size_);
+}
+
+void TransformTree::ExecutionContext::ReleaseMemory() noexcept {
+  memory_.reset();
+  planar_input_.reset();
+}
+
+void TransformTree::ExecutionContext::set_feature_sink(
+    const FeatureSink& sink) {
+  feature_sink_ = sink;
+}
+
+const void* TransformTree::PlanarInput(
+    const void* in, std::shared_ptr<void>* buffer) const noexcept {
+  if (channels_layout_ == ChannelsLayout::kPlanar ||
+      root_->BuffersCount == 1) {
+    return in;
+  }
+  if (!*buffer) {
+    *buffer = AcquireMemory(root_format_->SizeInBytes() * root_->BuffersCount);
+  }
+  if (root_sample_type_ == SampleType::kInt16) {
+    Deinterleave(true, reinterpret_cast<const int16_t*>(in),
+                 root_->BuffersCount, root_size_,
+                 root_format_->SizeInBytes() / sizeof(int16_t),
+                 reinterpret_cast<int16_t*>(buffer->get()));
+  } else {
+    // int32_t and float samples are moved as the same 32-bit words
+    Deinterleave(reinterpret_cast<const int32_t*>(in), root_->BuffersCount,
+                 root_size_, root_format_->SizeInBytes() / sizeof(int32_t),
+                 reinterpret_cast<int32_t*>(buffer->get()));
   }
-  if (other_duration.count() < 0) {
-    other_duration = std::chrono::high_resolution_clock::duration::zero();
+  return buffer->get();
+}
+
+std::string TransformTree::ConstantInputKey(
+    const void* in, const ExecutionContext* context) const noexcept {
+  auto& sink = context == nullptr? feature_sink_ : context->feature_sink_;
+  if (!constant_input_shortcut_ || streaming_ || capture_ || sink ||
+      (channels_layout_ == ChannelsLayout::kPlanar &&
+       root_->BuffersCount > 1)) {
+    // The planar channels may be padded
+    return std::string();
+  }
+  size_t sample = root_sample_type_ == SampleType::kInt16?
+      sizeof(int16_t) : sizeof(int32_t);
+  size_t size = root_size_ * root_->BuffersCount * sample;
+  auto bytes = reinterpret_cast<const char*>(in);
+  // All the samples are the same if the input equals itself shifted by
+  // a sample; memcmp() is vectorized and stops at the first difference
+  if (size < sample || memcmp(bytes, bytes + sample, size - sample) != 0) {
+    return std::string();
+  }
+  return std::string(bytes, sample);
+}
+
+bool TransformTree::SubstituteConstantResults(
+    const std::string& key,
+    const std::vector<std::shared_ptr<Buffers>>& results) const {
+  std::shared_ptr<const std::vector<std::vector<char>>> saved;
+  {
+    std::lock_guard<std::mutex> lock(constant_results_mutex_);
+    auto it = constant_results_.find(key);
+    if (it == constant_results_.end()) {
+      return false;
+    }
+    saved = it->second;
+  }
+  for (size_t i = 0; i < results.size(); i++) {
+    auto& buffers = *results[i];
+    size_t size_each = buffers.Format()->UnalignedSizeInBytes();
+    auto data = (*saved)[i].data();
+    for (size_t k = 0; k < buffers.Count(); k++) {
+      memcpy(buffers[k], data + k * size_each, size_each);
+    }
+  }
+  constant_input_hits_++;
+  return true;
+}
+
+void TransformTree::SaveConstantResults(
+    const std::string& key,
+    const std::vector<std::shared_ptr<Buffers>>& results) const {
+  {
+    std::lock_guard<std::mutex> lock(constant_results_mutex_);
+    if (constant_results_.size() >= kMaxConstantInputs ||
+        constant_results_.find(key) != constant_results_.end()) {
+      return;
+    }
   }
-  transforms_cache_["All"].ElapsedTime = all_duration;
-  transforms_cache_["Other"].ElapsedTime = other_duration;
+  auto saved = std::make_shared<std::vector<std::vector<char>>>();
+  for (auto& buffers : results) {
+    size_t size_each = buffers->Format()->UnalignedSizeInBytes();
+    saved->emplace_back(size_each * buffers->Count());
+    for (size_t k = 0; k < buffers->Count(); k++) {
+      memcpy(saved->back().data() + k * size_each, (*buffers)[k], size_each);
+    }
+  }
+  std::lock_guard<std::mutex> lock(constant_results_mutex_);
+  if (constant_results_.size() < kMaxConstantInputs) {
+    constant_results_.emplace(key, saved);
+  }
+}
 
-  // Populate the results
+void TransformTree::ClearConstantResults() const noexcept {
+  std::lock_guard<std::mutex> lock(constant_results_mutex_);
+  constant_results_.clear();
+}
+
+std::unordered_map<std::string, std::shared_ptr<Buffers>>
+TransformTree::FeatureBuffers() const {
+  if (!tree_is_prepared_) {
+    throw TreeIsNotPreparedException();
+  }
   std::unordered_map<std::string, std::shared_ptr<Buffers>> results;
   for (auto& feature : features_) {
     results[feature.first] = feature.second->BoundBuffers;
@@ -688,27 +3819,250 @@ TransformTree::Execute(const int16_t* in) {
   return results;
 }
 
+const std::vector<std::string>& TransformTree::FeatureNames() const noexcept {
+  return feature_names_;
+}
+
+const std::vector<std::shared_ptr<Buffers>>& TransformTree::IndexedResults(
+    const ExecutionContext* context) const noexcept {
+  return context != nullptr? context->indexed_results_ : indexed_results_;
+}
+
+void TransformTree::IndexResults(
+    const std::unordered_map<std::string, std::shared_ptr<Buffers>>& results,
+    std::vector<std::shared_ptr<Buffers>>* indexed_results) const {
+  indexed_results->clear();
+  indexed_results->reserve(feature_names_.size());
+  for (auto& name : feature_names_) {
+    indexed_results->push_back(results.find(name)->second);
+  }
+}
+
+std::shared_ptr<TransformTree::ExecutionContext>
+TransformTree::CreateExecutionContext() const {
+  if (!tree_is_prepared_) {
+    throw TreeIsNotPreparedException();
+  }
+  std::shared_ptr<ExecutionContext> context(new ExecutionContext());
+  context->memory_ = AcquireMemory(allocated_size_);
+  ClearPinnedMemory(context->memory_.get());
+  // Replicate the memory layout of the tree
+  auto memory = reinterpret_cast<char*>(context->memory_.get());
+  root_->ActionOnSubtree([&](const Node& node) {
+    if (node.Parent == nullptr) {
+      // Root's buffers are rebound to the input on each execution
+      context->buffers_[&node] = std::make_shared<Buffers>(
+          node.BoundBuffers->Format(), node.BuffersCount, memory);
+      return;
+    }
+    if (node.ParentSlice) {
+      // Rebound to the context's parent buffers on each execution
+      context->slices_[&node] = std::make_shared<Buffers>(
+          node.ParentSlice->Format(), node.ParentSlice->Count(), memory,
+          node.ParentSlice->Stride());
+    }
+    auto node_memory = memory;
+    if (node.Memory) {
+      // The node was added after PrepareForExecution()
+      auto& copy = context->extra_memory_[node.Memory.get()];
+      if (!copy) {
+        copy = AcquireMemory(node.Memory->Size);
+      }
+      node_memory = reinterpret_cast<char*>(copy.get());
+    }
+    context->buffers_[&node] = std::make_shared<Buffers>(
+        node.BoundBuffers->Format(), node.BoundBuffers->Count(),
+        node_memory + node.Offset, node.BoundBuffers->Stride());
+  });
+  for (auto& feature : features_) {
+    context->results_[feature.first] =
+        context->buffers_.find(feature.second.get())->second;
+  }
+  IndexResults(context->results_, &context->indexed_results_);
+  context->counters_.resize(counters_.size());
+  context->all_time_ = std::chrono::high_resolution_clock::duration::zero();
+  context->gate_selections_ = gate_selections_;
+  context->version_ = layout_version_;
+  return context;
+}
+
+const std::unordered_map<std::string, std::shared_ptr<Buffers>>&
+TransformTree::Execute(const void* in, ExecutionContext* context) const {
+  context->active_nodes_.clear();
+  return ExecuteActive(in, context);
+}
+
+const std::unordered_map<std::string, std::shared_ptr<Buffers>>&
+TransformTree::Execute(const void* in,
+                       const std::vector<std::string>& features,
+                       ExecutionContext* context) const {
+  ActivateFeatures(features, &context->active_nodes_);
+  return ExecuteActive(in, context);
+}
+
+const std::unordered_map<std::string, std::shared_ptr<Buffers>>&
+TransformTree::ExecuteActive(const void* in,
+                             ExecutionContext* context) const {
+  ScopedExecutionOverrides overrides(&execution_overrides_);
+  BindContext(in, context);
+  auto constant = ConstantInputKey(in, context);
+  auto check_point_start = std::chrono::high_resolution_clock::now();
+  if (!constant.empty() &&
+      SubstituteConstantResults(constant, context->indexed_results_)) {
+    context->all_time_ =
+        std::chrono::high_resolution_clock::now() - check_point_start;
+    RecordExecutionMetrics(context->all_time_);
+    return context->results_;
+  }
+  RunNodes(context);
+  auto check_point_finish = std::chrono::high_resolution_clock::now();
+  if (ExecutionCancelled()) {
+    throw ExecutionCancelledException();
+  }
+  if (profiling_level_ != ProfilingLevel::kOff) {
+    RefineParallelism(context->counters_);
+  }
+  context->all_time_ = check_point_finish - check_point_start;
+  RecordExecutionMetrics(context->all_time_);
+  if (!constant.empty() && context->active_nodes_.empty()) {
+    SaveConstantResults(constant, context->indexed_results_);
+  }
+  return context->results_;
+}
+
+void TransformTree::BindContext(const void* in,
+                                ExecutionContext* context) const {
+  if (!tree_is_prepared_) {
+    throw TreeIsNotPreparedException();
+  }
+  if (context->version_ != layout_version_) {
+    throw StaleExecutionContextException();
+  }
+  if (features_.size() == 0) {
+    throw TreeIsEmptyException();
+  }
+  assert(context != nullptr);
+  if (!context->memory_) {
+    context->memory_ = AcquireMemory(allocated_size_);
+    ClearPinnedMemory(context->memory_.get());
+    auto memory = reinterpret_cast<char*>(context->memory_.get());
+    for (auto& buffers : context->buffers_) {
+      auto node = buffers.first;
+      if (node->Parent != nullptr && !node->Memory) {
+        buffers.second->Rebind(memory + node->Offset);
+      }
+    }
+  }
+  std::fill(context->counters_.begin(), context->counters_.end(),
+            NodeCounters());
+  auto& root_buffers = context->buffers_.find(root_.get())->second;
+  BindInput(PlanarInput(in, &context->planar_input_), context);
+  if (capture_) {
+    context->capture_execution_ = capture_->NextExecution();
+  }
+  context->validate_ = SampleValidation();
+  if (context->validate_) {
+    try {
+      root_buffers->Validate();
+    }
+    catch(const InvalidBuffersException& e) {
+      throw InvalidInputBuffersException(e.what());
+    }
+  }
+}
+
+std::vector<TransformTree::Task> TransformTree::ExportTasks(
+    ExecutionContext* context) const {
+  if (!tree_is_prepared_) {
+    throw TreeIsNotPreparedException();
+  }
+  if (!parallel_execution_) {
+    throw ParallelExecutionRequiredException();
+  }
+  if (context->version_ != layout_version_) {
+    throw StaleExecutionContextException();
+  }
+  std::vector<Task> tasks;
+  // The index of the task which writes the buffers each node reads
+  std::unordered_map<const Node*, size_t> producers;
+  root_->ActionOnSubtree([&](Node& node) {
+    if (node.Parent == nullptr) {
+      return;
+    }
+    auto producer = producers.find(node.Parent);
+    if (node.View) {
+      if (producer != producers.end()) {
+        producers[&node] = producer->second;
+      }
+      return;
+    }
+    Task task;
+    task.Name = node.ProfileName();
+    if (producer != producers.end()) {
+      task.Dependencies.push_back(producer->second);
+    }
+    auto& in = node.Parent->ContextBuffers(context);
+    auto& out = node.ContextBuffers(context);
+    // The sink is called when the node runs as a whole
+    task.Ranges = node.BoundTransform->BufferInvariant() &&
+        node.Gate == nullptr && in->Count() == out->Count() &&
+        sinks_[node.Id].empty()? out->Count() : 1;
+    Node* self = &node;
+    task.Run = [self, context](size_t begin, size_t end) {
+      // The host owns the threads
+      ThreadsGovernor::Lease serial(1);
+      auto& in = self->Parent->ContextBuffers(context);
+      auto& out = self->ContextBuffers(context);
+      if (begin == 0 && end >= out->Count()) {
+        self->ExecuteBoundTransform(context);
+        return;
+      }
+      auto in_range = in->Slice(begin, end - begin);
+      auto out_range = out->Slice(begin, end - begin);
+      self->BoundTransform->Do(in_range, &out_range);
+    };
+    producers[&node] = tasks.size();
+    tasks.push_back(std::move(task));
+  });
+  if (!gated_results_.empty()) {
+    Task scatter;
+    scatter.Name = "Gate";
+    for (auto node : gated_results_) {
+      scatter.Dependencies.push_back(producers.find(node)->second);
+    }
+    scatter.Ranges = 1;
+    scatter.Run = [this, context](size_t, size_t) {
+      ScatterGated(context);
+    };
+    tasks.push_back(std::move(scatter));
+  }
+  return tasks;
+}
+
+const std::unordered_map<std::string, std::shared_ptr<Buffers>>&
+TransformTree::StartTasks(const void* in, ExecutionContext* context) const {
+  context->active_nodes_.clear();
+  BindContext(in, context);
+  return context->results_;
+}
+
 std::unordered_map<std::string, float>
 TransformTree::ExecutionTimeReport() const noexcept {
-  std::unordered_map<std::string, float> ret;
-  auto allIt = transforms_cache_.find("All");
-  if (allIt == transforms_cache_.end()) {
-    return ret;
-  }
-  auto all_time = allIt->second.ElapsedTime;
-  for (auto& cit : transforms_cache_) {
-    if (cit.first != "All") {
-      ret.insert(std::make_pair(
-          cit.first, (cit.second.ElapsedTime.count() + 0.f) / all_time.count()));
-    } else {
-      ret.insert(std::make_pair(
-          cit.first, ConvertDuration(all_time)));
-    }
-  }
-  return ret;
+  return TimeReport(Timers(counters_, all_time_));
+}
+
+std::unordered_map<std::string, float> TransformTree::ExecutionTimeReport(
+    const ExecutionContext& context) const noexcept {
+  return TimeReport(Timers(context.counters_, context.all_time_));
 }
 
-void TransformTree::Dump(const std::string& dotFileName) const {
+static const char* const kExplainColumns[] {
+  "id", "node", "buffers", "storage", "bytes", "private", "cost",
+  "placement", "threads", "simd", "cycle", "fused", "gate"
+};
+
+void TransformTree::Dump(const std::string& dotFileName,
+                         bool annotated) const {
   // I am very sorry for such a complicated code. Please forgive me.
   // It just has to be here.
   DBG("Writing %s...", dotFileName.c_str());
@@ -727,13 +4081,25 @@ void TransformTree::Dump(const std::string& dotFileName) const {
   }
   float redShift = redThreshold * maxTimeRatio;
   const int initialLight = 0x30;
-  auto allTime = time_report["All"];
+  auto timers = Timers(counters_, all_time_);
+  auto allTime = include_time? ConvertDuration(ReportBaseTime(timers)) : 0.f;
+  auto nodes_counters = OriginalNodesCounters(counters_);
+  auto node_time = [&nodes_counters](const Node& node) {
+    return TickClock::ToDuration(nodes_counters[&node].Ticks);
+  };
   std::ofstream fw;
   fw.exceptions(std::ifstream::failbit | std::ifstream::badbit);
   fw.open(dotFileName);
   fw << "digraph TransformsTree {" << std::endl;
   std::unordered_map<std::string, int> counters;
   std::unordered_map<const Node*, int> node_counters;
+  std::unordered_map<int, int> slices;
+  if (annotated) {
+    if (!tree_is_prepared_) {
+      throw TreeIsNotPreparedException();
+    }
+    slices = SlicesCounts();
+  }
   root_->ActionOnSubtree([&](const Node& node) {
     if (node.OriginalNode != nullptr) {
       return;
@@ -753,13 +4119,35 @@ void TransformTree::Dump(const std::string& dotFileName) const {
         << "<br /><font point-size=\"10\">";
     if (include_time) {
       auto cur_percent = static_cast<int>(
-          (roundf(ConvertDuration(*node.ElapsedTime) * 100.f / allTime)));
+          (roundf(ConvertDuration(node_time(node)) * 100.f / allTime)));
       assert(cur_percent >=0 && cur_percent <= 100);
       auto all_percent = static_cast<int>(
           roundf(time_report[t->Name()] * 100.f));
       assert(all_percent >=0 && all_percent <= 100);
       fw << "<b>" << std::to_string(cur_percent) << "% ("
           << std::to_string(all_percent) << "%)</b>";
+      auto& hw = nodes_counters[&node];
+      if (profiling_level_ == ProfilingLevel::kFull && hw.Cycles > 0) {
+        char annotation[128];
+        snprintf(annotation, sizeof(annotation),
+                 "<br />IPC %.2f, %llu LLC misses, %.1f MB/s",
+                 hw.InstructionsPerCycle(),
+                 static_cast<unsigned long long>(hw.CacheMisses),  // NOLINT
+                 hw.MemoryBandwidth() / 1000000);
+        fw << annotation;
+      }
+    }
+    auto parallel = dynamic_cast<const ParallelTransform*>(t.get());
+    if (parallel != nullptr) {
+      fw << "<br /><i>" << (parallel->serial()? "serial" : "parallel")
+         << "</i>";
+    }
+    if (annotated && node.Parent != nullptr) {
+      // Skip the id, the name and the buffers count
+      auto values = ExplainNode(node, slices);
+      for (size_t i = 3; i < values.size(); i++) {
+        fw << "<br />" << kExplainColumns[i] << " = " << values[i];
+      }
     }
     if (t->GetParameters().size() > 0) {
       fw << "<br /> <br />";
@@ -783,14 +4171,14 @@ void TransformTree::Dump(const std::string& dotFileName) const {
 
     // If this node is a leaf, append related feature node
     if (node.Children.size() == 0) {
-      std::string feature = *node.RelatedFeatures.begin();
+      std::string feature = FeatureName(*node.RelatedFeatures.begin());
       fw << feature << " [style=\"filled\", "
           "fillcolor=\"#85b3de\", label=<" << feature;
       if (include_time) {
         fw << "<br /><font point-size=\"10\">";
-        auto featureTime = *node.ElapsedTime;
+        auto featureTime = node_time(node);
         node.ActionOnEachParent([&](const Node& parent) {
-          featureTime += *parent.ElapsedTime / parent.RelatedFeatures.size();
+          featureTime += node_time(parent) / parent.RelatedFeatures.size();
         });
         auto cur_percent = static_cast<int>(
             (roundf((ConvertDuration(featureTime) * 100.f) / allTime)));
@@ -855,7 +4243,8 @@ void TransformTree::Dump(const std::string& dotFileName) const {
       fw << std::endl;
     });
     if (node.Children.size() == 0) {
-      fw << "\t" << node_name << " -> " << *node.RelatedFeatures.begin()
+      fw << "\t" << node_name << " -> "
+          << FeatureName(*node.RelatedFeatures.begin())
           << std::endl;
     }
   });
@@ -869,6 +4258,24 @@ bool TransformTree::validate_after_each_transform() const noexcept {
 
 void TransformTree::set_validate_after_each_transform(bool value) noexcept {
   validate_after_each_transform_ = value;
+  validation_counter_ = 0;
+  if (tree_is_prepared_) {
+    AssignBuffersLayouts();
+  }
+}
+
+size_t TransformTree::validation_period() const noexcept {
+  return std::max(validation_period_, static_cast<size_t>(1));
+}
+
+void TransformTree::set_validation_period(size_t value) noexcept {
+  validation_period_ = value;
+  validation_counter_ = 0;
+}
+
+bool TransformTree::SampleValidation() const noexcept {
+  return validate_after_each_transform() &&
+      validation_counter_++ % validation_period() == 0;
 }
 
 bool TransformTree::dump_buffers_after_each_transform() const noexcept {
@@ -877,6 +4284,52 @@ bool TransformTree::dump_buffers_after_each_transform() const noexcept {
 
 void TransformTree::set_dump_buffers_after_each_transform(bool value) noexcept {
   dump_buffers_after_each_transform_ = value;
+  if (tree_is_prepared_) {
+    AssignBuffersLayouts();
+  }
+}
+
+void TransformTree::StartCapture(const std::string& fileName,
+                                 const std::vector<std::string>& transforms,
+                                 size_t ringSize) {
+  StopCapture();
+  for (auto& name : transforms) {
+    if (TransformFactory::Instance().Find(name) == nullptr) {
+      throw TransformNotRegisteredException(name);
+    }
+  }
+  capture_ = std::make_shared<BufferCapture>(fileName, transforms, ringSize);
+  INF("Capturing the buffers to %s", fileName.c_str());
+  if (tree_is_prepared_) {
+    AssignBuffersLayouts();
+  }
+}
+
+bool TransformTree::StopCapture() noexcept {
+  if (!capture_) {
+    return true;
+  }
+  auto capture = capture_;
+  capture_.reset();
+  bool written = capture->Close();
+  if (!written) {
+    ERR("Failed to write %s", capture->file_name().c_str());
+  }
+  size_t dropped = capture->dropped_records();
+  if (dropped > 0) {
+    WRN("%zu of %zu buffer records did not fit into the ring of %zu bytes "
+        "and were dropped from %s", dropped,
+        dropped + capture->captured_records(), capture->ring_size(),
+        capture->file_name().c_str());
+  }
+  if (tree_is_prepared_) {
+    AssignBuffersLayouts();
+  }
+  return written && dropped == 0;
+}
+
+std::shared_ptr<const BufferCapture> TransformTree::capture() const noexcept {
+  return capture_;
 }
 
 bool TransformTree::cache_optimization() const noexcept {
@@ -887,12 +4340,568 @@ void TransformTree::set_cache_optimization(bool value) noexcept {
   cache_optimization_ = value;
 }
 
+ProfilingLevel TransformTree::profiling_level() const noexcept {
+  return profiling_level_;
+}
+
+void TransformTree::set_profiling_level(ProfilingLevel value) noexcept {
+  profiling_level_ = value;
+}
+
+const TransformTree::FeatureSink& TransformTree::feature_sink()
+    const noexcept {
+  return feature_sink_;
+}
+
+void TransformTree::set_feature_sink(const FeatureSink& sink) {
+  feature_sink_ = sink;
+}
+
+std::vector<std::pair<std::string, NodeCounters>>
+TransformTree::NodeCountersReport() const noexcept {
+  return NodeCountersReport(counters_);
+}
+
+std::vector<std::pair<std::string, NodeCounters>>
+TransformTree::NodeCountersReport(
+    const ExecutionContext& context) const noexcept {
+  return NodeCountersReport(context.counters_);
+}
+
+std::vector<std::pair<std::string, NodeCounters>>
+TransformTree::NodeCountersReport(
+    const std::vector<NodeCounters>& counters) const noexcept {
+  auto nodes_counters = OriginalNodesCounters(counters);
+  std::vector<std::pair<std::string, NodeCounters>> ret;
+  ForEachNode([&](const Node& node) {
+    if (node.Parent != nullptr && node.OriginalNode == nullptr) {
+      ret.push_back(std::make_pair(node.ProfileName(), nodes_counters[&node]));
+    }
+  });
+  return ret;
+}
+
+std::vector<std::pair<std::string, InstructionSet>>
+TransformTree::InstructionSetsReport() const noexcept {
+  std::vector<std::pair<std::string, InstructionSet>> ret;
+  root_->ActionOnSubtree([&](const Node& node) {
+    if (node.Parent != nullptr && node.OriginalNode == nullptr) {
+      auto simd = dynamic_cast<const SimdAware*>(node.BoundTransform.get());
+      ret.push_back(std::make_pair(
+          node.ProfileName(), simd != nullptr? simd->SimdInstructionSet() :
+                                               InstructionSet::kScalar));
+    }
+  });
+  return ret;
+}
+
+TransformTree::MemoryUsage TransformTree::MemoryReport() const {
+  if (!tree_is_prepared_) {
+    throw TreeIsNotPreparedException();
+  }
+  MemoryUsage usage { allocated_size_, peak_size_, 0, 0, {} };
+  std::set<const MemoryBlock*> blocks;
+  root_->ActionOnSubtree([&](const Node& node) {
+    if (node.Parent == nullptr || node.OriginalNode != nullptr) {
+      return;
+    }
+    size_t buffers = node.View || node.InPlace? 0 : node.AllocationSize();
+    size_t private_size = node.BoundTransform->PrivateMemorySize();
+    usage.Buffers += buffers;
+    usage.Private += private_size;
+    usage.Nodes.emplace_back(node.ProfileName(), buffers, private_size);
+    if (node.Memory && blocks.insert(node.Memory.get()).second) {
+      usage.Allocated += node.Memory->Size;
+    }
+  });
+  return usage;
+}
+
+Overlap TransformTree::BlockOverlap(
+    std::unordered_map<std::string, size_t>* hops) const {
+  assert(hops != nullptr);
+  hops->clear();
+  if (streaming_ || batch_size() > 1 || features_.empty()) {
+    return Overlap::Unbounded();
+  }
+  Overlap total { 0, 0 };
+  for (auto& feature : features_) {
+    Overlap overlap { 0, 0 };
+    size_t hop = 0;
+    for (const Node* node = feature.second.get();
+         node->Parent != nullptr && overlap.Bounded(); node = node->Parent) {
+      auto& transform = *node->BoundTransform;
+      size_t inputs = node->Parent->BuffersCount;
+      if (inputs > 1) {
+        overlap = node->BuffersCount == inputs?
+            transform.RequiredOverlap(overlap) : Overlap::Unbounded();
+      } else if (node->BuffersCount > 1) {
+        // The splitter: a single preceding window takes the hop samples
+        hop = transform.RequiredOverlap({ 1, 0 }).Before;
+        overlap = transform.RequiredOverlap(overlap);
+      } else if (dynamic_cast<const FormatConverter*>(&transform) ==
+                 nullptr) {
+        overlap = Overlap::Unbounded();
+      }
+    }
+    if (!overlap.Bounded() || hop == 0) {
+      hops->clear();
+      return Overlap::Unbounded();
+    }
+    (*hops)[feature.first] = hop;
+    total.Before = std::max(total.Before, overlap.Before);
+    total.After = std::max(total.After, overlap.After);
+  }
+  return total;
+}
+
+bool TransformTree::SignalsIndependent(std::string* culprit) const noexcept {
+  const Node* dependent = nullptr;
+  root_->ActionOnSubtree([&dependent](const Node& node) {
+    if (node.Parent == nullptr || dependent != nullptr) {
+      return;
+    }
+    auto& transform = *node.BoundTransform;
+    if (dynamic_cast<const FormatConverter*>(&transform) != nullptr &&
+        node.BuffersCount == node.Parent->BuffersCount) {
+      return;
+    }
+    // The splitters read the samples of a single buffer, while, e.g., Delta
+    // is buffer invariant but reads the neighbours
+    auto ratio = transform.BufferRatio();
+    auto overlap = transform.RequiredOverlap({ 0, 0 });
+    if (ratio == 0 || (ratio == 1 && (!overlap.Bounded() ||
+                                      overlap.Before + overlap.After > 0))) {
+      dependent = &node;
+    }
+  });
+  if (dependent != nullptr && culprit != nullptr) {
+    *culprit = dependent->BoundTransform->Name();
+  }
+  return dependent == nullptr;
+}
+
+std::vector<std::pair<std::string, Placement>>
+TransformTree::PlacementsReport() const noexcept {
+  std::vector<std::pair<std::string, Placement>> ret;
+  root_->ActionOnSubtree([&](const Node& node) {
+    if (node.Parent != nullptr && node.OriginalNode == nullptr) {
+      auto parallel = dynamic_cast<const ParallelTransform*>(
+          node.BoundTransform.get());
+      ret.push_back(std::make_pair(
+          node.ProfileName(), parallel != nullptr && !parallel->serial()?
+              Placement::kParallel : Placement::kSerial));
+    }
+  });
+  return ret;
+}
+
+std::unordered_map<int, int> TransformTree::SlicesCounts() const noexcept {
+  std::unordered_map<int, int> ret;
+  for (auto node = root_->Next; node != nullptr; node = node->Next) {
+    if (node->OriginalNode != nullptr) {
+      auto& count = ret[node->CycleId];
+      count = std::max(count, node->SliceIndex + 1);
+    }
+  }
+  return ret;
+}
+
+std::vector<std::string> TransformTree::ExplainNode(
+    const Node& node, const std::unordered_map<int, int>& slices) const {
+  auto& transform = node.BoundTransform;
+  std::vector<std::string> ret;
+  ret.push_back(std::to_string(node.Id));
+  ret.push_back(node.ProfileName());
+  ret.push_back(std::to_string(node.BuffersCount));
+  ret.push_back(node.View? "view" : node.InPlace? "in-place" :
+                node.Packed? "packed" : "own");
+  ret.push_back(std::to_string(
+      node.View || node.InPlace? 0 : node.AllocationSize()));
+  ret.push_back(std::to_string(transform->PrivateMemorySize()));
+  char cost[32];
+  snprintf(cost, sizeof(cost), "%.0f", EstimatedWork(node));
+  ret.push_back(cost);
+  auto parallel = dynamic_cast<const ParallelTransform*>(transform.get());
+  std::string threads = "1";
+  if (parallel != nullptr && !parallel->serial()) {
+    auto params = transform->GetParameters();
+    auto it = params.find("threads_number");
+    threads = it != params.end()? it->second : "-";
+  }
+  ret.push_back(parallel == nullptr? "-" :
+                parallel->serial()? "serial" : "parallel");
+  ret.push_back(threads);
+  auto simd = dynamic_cast<const SimdAware*>(transform.get());
+  ret.push_back(InstructionSetName(
+      simd != nullptr? simd->SimdInstructionSet() : InstructionSet::kScalar));
+  // The cycle of the node is recorded in its clones
+  std::string cycle = "-";
+  for (auto clone = root_->Next; clone != nullptr; clone = clone->Next) {
+    if (clone->OriginalNode == &node) {
+      cycle = std::to_string(clone->CycleId) + "/" +
+          std::to_string(slices.at(clone->CycleId));
+      break;
+    }
+  }
+  ret.push_back(cycle);
+  ret.push_back(node.Fused.empty()? "-" : node.Fused);
+  ret.push_back(node.Gate != nullptr?
+      std::to_string(node.Gate->Id) : "-");
+  return ret;
+}
+
+std::string TransformTree::Explain() const {
+  if (!tree_is_prepared_) {
+    throw TreeIsNotPreparedException();
+  }
+  auto slices = SlicesCounts();
+  std::vector<const Node*> order;
+  std::unordered_set<const Node*> listed;
+  for (auto node = root_->Next; node != nullptr; node = node->Next) {
+    auto original = node->OriginalNode != nullptr? node->OriginalNode : node;
+    if (listed.insert(original).second) {
+      order.push_back(original);
+    }
+  }
+  size_t executed = order.size();
+  // Views are never executed
+  ForEachNode([&](const Node& node) {
+    if (node.Parent != nullptr && node.OriginalNode == nullptr &&
+        listed.insert(&node).second) {
+      order.push_back(&node);
+    }
+  });
+  std::ostringstream out;
+  out << "# features:";
+  for (auto& feature : feature_chains_) {
+    out << " " << feature.first;
+  }
+  out << std::endl << "# nodes: " << order.size() << ", executed: "
+      << executed << std::endl;
+  out << "# memory: " << allocated_size_ << " allocated, " << peak_size_
+      << " peak" << std::endl;
+  out << "# execution: " << (realtime_? "real-time" :
+      parallel_execution_? "parallel subtrees" : "sequential");
+  if (!slices.empty()) {
+    out << ", " << slices.size() << " sliced cycles"
+        << (parallel_slices_? " in parallel" : "");
+  }
+  out << std::endl << "order";
+  for (auto column : kExplainColumns) {
+    out << "\t" << column;
+  }
+  out << std::endl;
+  for (size_t i = 0; i < order.size(); i++) {
+    out << (i < executed? std::to_string(i) : "-");
+    for (auto& value : ExplainNode(*order[i], slices)) {
+      out << "\t" << value;
+    }
+    out << std::endl;
+  }
+  return out.str();
+}
+
+void TransformTree::EnableProfiling(bool trace) noexcept {
+  profiler_ = std::make_shared<Profiler>(trace);
+}
+
+void TransformTree::DisableProfiling() noexcept {
+  profiler_.reset();
+}
+
+std::shared_ptr<Profiler> TransformTree::profiler() const noexcept {
+  return profiler_;
+}
+
+bool TransformTree::parallel_slices() const noexcept {
+  return parallel_slices_;
+}
+
+void TransformTree::set_parallel_slices(bool value) noexcept {
+  parallel_slices_ = value;
+}
+
+bool TransformTree::cache_autotuning() const noexcept {
+  return cache_autotuning_;
+}
+
+void TransformTree::set_cache_autotuning(bool value) noexcept {
+  cache_autotuning_ = value;
+}
+
+bool TransformTree::warm_up() const noexcept {
+  return warm_up_;
+}
+
+void TransformTree::set_warm_up(bool value) noexcept {
+  warm_up_ = value;
+}
+
+size_t TransformTree::memory_budget() const noexcept {
+  return memory_budget_;
+}
+
+void TransformTree::set_memory_budget(size_t value) noexcept {
+  memory_budget_ = value;
+}
+
 bool TransformTree::memory_protection() const noexcept {
   return memory_protection_;
 }
 
 void TransformTree::set_memory_protection(bool value) noexcept {
   memory_protection_ = value;
+  protection_counter_ = 0;
+}
+
+size_t TransformTree::memory_protection_period() const noexcept {
+  return std::max(memory_protection_period_, static_cast<size_t>(1));
+}
+
+void TransformTree::set_memory_protection_period(size_t value) noexcept {
+  memory_protection_period_ = value;
+  protection_counter_ = 0;
+}
+
+bool TransformTree::memory_guards() const noexcept {
+  return memory_guards_;
+}
+
+void TransformTree::set_memory_guards(bool value) noexcept {
+  if (tree_is_prepared_) {
+    WRN("The tree is already prepared, memory guards remain %s",
+        memory_guards_? "enabled" : "disabled");
+    return;
+  }
+  memory_guards_ = value;
+}
+
+bool TransformTree::parallel_execution() const noexcept {
+  return parallel_execution_;
+}
+
+void TransformTree::set_parallel_execution(bool value) noexcept {
+  if (tree_is_prepared_) {
+    WRN("The tree is already prepared, parallel execution remains %s",
+        parallel_execution_? "enabled" : "disabled");
+    return;
+  }
+  parallel_execution_ = value;
+}
+
+bool TransformTree::realtime() const noexcept {
+  return realtime_;
+}
+
+void TransformTree::set_realtime(bool value) noexcept {
+  if (tree_is_prepared_) {
+    WRN("The tree is already prepared, the real-time mode remains %s",
+        realtime_? "enabled" : "disabled");
+    return;
+  }
+  realtime_ = value;
+}
+
+size_t TransformTree::merged_nodes_count() const noexcept {
+  return merged_nodes_count_;
+}
+
+size_t TransformTree::merged_bytes() const noexcept {
+  return merged_bytes_;
+}
+
+void TransformTree::AddEquivalence(const std::string& transform,
+                                   const std::string& parameters) {
+  if (features_.size() > 0) {
+    WRN("The tree already has features, the equivalence of %s (%s) is "
+        "ignored", transform.c_str(), parameters.c_str());
+    return;
+  }
+  auto tfit = TransformFactory::Instance().Find(transform);
+  if (tfit == nullptr) {
+    throw TransformNotRegisteredException(transform);
+  }
+  // Bring the values to the same representation as AddTransform() does
+  auto probe = tfit->begin()->second();
+  auto values = Transform::Parse(parameters);
+  probe->SetParameters(values);
+  for (auto& value : values) {
+    value.second = probe->GetParameters().find(value.first)->second;
+  }
+  equivalences_.push_back({ transform, parameters, values });
+}
+
+size_t TransformTree::approximately_merged_nodes_count() const noexcept {
+  return approximately_merged_nodes_count_;
+}
+
+float TransformTree::approximate_sharing_speedup() const noexcept {
+  float work = 0;
+  root_->ActionOnSubtree([&work](const Node& node) {
+    if (node.OriginalNode == nullptr) {
+      work += EstimatedWork(node);
+    }
+  });
+  if (work == 0) {
+    return 1;
+  }
+  return (work + approximately_saved_work_) / work;
+}
+
+float TransformTree::EstimatedWork(const Node& node) noexcept {
+  if (node.Parent == nullptr) {
+    return 0;
+  }
+  size_t bytes = std::max(
+      node.Parent->BuffersCount *
+          node.BoundTransform->InputFormat()->SizeInBytes(),
+      node.BuffersCount * node.BoundTransform->OutputFormat()->SizeInBytes());
+  auto parallel = dynamic_cast<const ParallelTransform*>(
+      node.BoundTransform.get());
+  return static_cast<float>(bytes) / sizeof(float) *
+      (parallel != nullptr? parallel->ElementCost() : 1);
+}
+
+size_t TransformTree::allocated_size() const noexcept {
+  return allocated_size_;
+}
+
+const TransformTree::PrepareTimes& TransformTree::prepare_times()
+    const noexcept {
+  return prepare_times_;
+}
+
+bool TransformTree::fuse_transforms() const noexcept {
+  return fuse_transforms_;
+}
+
+void TransformTree::set_fuse_transforms(bool value) noexcept {
+  if (tree_is_prepared_) {
+    WRN("The tree is already prepared, transforms fusion remains %s",
+        fuse_transforms_? "enabled" : "disabled");
+    return;
+  }
+  fuse_transforms_ = value;
+}
+
+bool TransformTree::streaming_stores() const noexcept {
+  return streaming_stores_;
+}
+
+void TransformTree::set_streaming_stores(bool value) noexcept {
+  streaming_stores_ = value;
+  if (tree_is_prepared_) {
+    AssignStreamingStores();
+  }
+}
+
+bool TransformTree::packed_results() const noexcept {
+  return packed_results_;
+}
+
+void TransformTree::set_packed_results(bool value) noexcept {
+  if (tree_is_prepared_) {
+    WRN("The tree is already prepared, results packing remains %s",
+        packed_results_? "enabled" : "disabled");
+    return;
+  }
+  packed_results_ = value;
+}
+
+bool TransformTree::constant_input_shortcut() const noexcept {
+  return constant_input_shortcut_;
+}
+
+void TransformTree::set_constant_input_shortcut(bool value) noexcept {
+  constant_input_shortcut_ = value;
+  ClearConstantResults();
+}
+
+size_t TransformTree::constant_input_hits() const noexcept {
+  return constant_input_hits_;
+}
+
+const ExecutionOverrides& TransformTree::execution_overrides()
+    const noexcept {
+  return execution_overrides_;
+}
+
+void TransformTree::set_execution_overrides(
+    const ExecutionOverrides& value) noexcept {
+  execution_overrides_ = value;
+}
+
+AllocationStrategy TransformTree::allocation_strategy() const noexcept {
+  return allocation_strategy_;
+}
+
+void TransformTree::set_allocation_strategy(AllocationStrategy value) noexcept {
+  if (tree_is_prepared_) {
+    WRN("The tree is already prepared, the allocation strategy remains "
+        "unchanged");
+    return;
+  }
+  allocation_strategy_ = value;
+}
+
+bool TransformTree::streaming() const noexcept {
+  return streaming_;
+}
+
+void TransformTree::set_streaming(bool value) noexcept {
+  if (features_.size() > 0) {
+    WRN("The tree already has features, streaming remains %s",
+        streaming_? "enabled" : "disabled");
+    return;
+  }
+  streaming_ = value;
+}
+
+Accuracy TransformTree::accuracy() const noexcept {
+  return accuracy_;
+}
+
+void TransformTree::set_accuracy(Accuracy value) noexcept {
+  if (features_.size() > 0) {
+    WRN("The tree already has features, accuracy remains %d",
+        static_cast<int>(accuracy_));
+    return;
+  }
+  accuracy_ = value;
+}
+
+size_t TransformTree::batch_size() const noexcept {
+  return root_->BuffersCount;
+}
+
+void TransformTree::set_batch_size(size_t value) noexcept {
+  if (features_.size() > 0) {
+    WRN("The tree already has features, batch size remains %zu",
+        root_->BuffersCount);
+    return;
+  }
+  assert(value > 0);
+  root_->BuffersCount = value;
+}
+
+ChannelsLayout TransformTree::channels_layout() const noexcept {
+  return channels_layout_;
+}
+
+void TransformTree::set_channels_layout(ChannelsLayout value) noexcept {
+  if (features_.size() > 0) {
+    WRN("The tree already has features, channels layout remains %s",
+        channels_layout_ == ChannelsLayout::kPlanar? "planar" : "interleaved");
+    return;
+  }
+  channels_layout_ = value;
+}
+
+void TransformTree::ResetStream() const noexcept {
+  root_->ActionOnEachTransformInSubtree([](const Transform& t) {
+    t.ResetState();
+  });
 }
 
 float TransformTree::ConvertDuration(
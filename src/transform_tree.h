@@ -31,13 +31,24 @@
 #ifndef SRC_TRANSFORM_TREE_H_
 #define SRC_TRANSFORM_TREE_H_
 
+#include <atomic>
 #include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <tuple>
 #include <vector>
 #include "src/formats/array_format.h"
 #include "src/exceptions.h"
 #include "src/logger.h"
 #include "src/transform.h"
 #include "src/allocators/buffers_allocator.h"
+#include "src/buffer_capture.h"
+#include "src/execution_overrides.h"
+#include "src/node_counters.h"
+#include "src/parallel_transform.h"
+#include "src/realtime.h"
+#include "src/simd_aware.h"
+#include "src/transforms/spectral_descriptors.h"
 
 namespace sound_feature_extraction {
 
@@ -100,6 +111,47 @@ class TreeIsPreparedException : public ExceptionBase {
   }
 };
 
+class FeatureNotFoundException : public ExceptionBase {
+ public:
+  explicit FeatureNotFoundException(const std::string& name)
+  : ExceptionBase("Feature \"" + name + "\" does not exist.") {
+  }
+};
+
+class TransformNotInFeatureException : public ExceptionBase {
+ public:
+  TransformNotInFeatureException(const std::string& feature,
+                                 const std::string& transform)
+  : ExceptionBase("Feature \"" + feature + "\" is not calculated by "
+                  "transform \"" + transform + "\".") {
+  }
+};
+
+class FormatChangingParameterException : public ExceptionBase {
+ public:
+  FormatChangingParameterException(const std::string& transform,
+                                   const std::string& parameter)
+  : ExceptionBase("Parameter \"" + parameter + "\" of transform \"" +
+                  transform + "\" changes the output format, the tree "
+                  "must be prepared again.") {
+  }
+};
+
+class StaleExecutionContextException : public ExceptionBase {
+ public:
+  StaleExecutionContextException()
+  : ExceptionBase("The execution context was created before the features "
+                  "of the tree were changed.") {
+  }
+};
+
+class ExecutionCancelledException : public ExceptionBase {
+ public:
+  ExecutionCancelledException()
+  : ExceptionBase("The execution was cancelled.") {
+  }
+};
+
 class TreeIsNotPreparedException : public ExceptionBase {
  public:
   TreeIsNotPreparedException()
@@ -123,6 +175,16 @@ class TransformResultedInInvalidBuffersException : public ExceptionBase {
   }
 };
 
+class BufferOverrunException : public ExceptionBase {
+ public:
+  BufferOverrunException(const std::string& transform, const void* address)
+  : ExceptionBase("Transform " + transform + " wrote past the end of its "
+                  "buffers, overwriting the guard at " +
+                  std::to_string(reinterpret_cast<uintptr_t>(address)) +
+                  ".") {
+  }
+};
+
 class InvalidInputBuffersException : public ExceptionBase {
  public:
   explicit InvalidInputBuffersException(const std::string& message)
@@ -130,6 +192,23 @@ class InvalidInputBuffersException : public ExceptionBase {
   }
 };
 
+class InvalidTreeFileException : public ExceptionBase {
+ public:
+  InvalidTreeFileException(const std::string& fileName,
+                           const std::string& reason)
+  : ExceptionBase("Transform tree file \"" + fileName + "\" is invalid: " +
+                  reason + ".") {
+  }
+};
+
+class FailedToSaveTreeException : public ExceptionBase {
+ public:
+  explicit FailedToSaveTreeException(const std::string& fileName)
+  : ExceptionBase("Failed to write the transform tree to \"" + fileName +
+                  "\".") {
+  }
+};
+
 class FailedToAllocateBuffersException : public std::bad_alloc {
  public:
   explicit FailedToAllocateBuffersException(const char* message) noexcept
@@ -146,73 +225,725 @@ class FailedToAllocateBuffersException : public std::bad_alloc {
   std::string message_;
 };
 
+/// @brief PrepareForExecution() found that the buffers do not fit into
+/// TransformTree::memory_budget(), nothing was allocated.
+class MemoryBudgetExceededException : public ExceptionBase {
+ public:
+  MemoryBudgetExceededException(size_t needed, size_t budget)
+  : ExceptionBase("The buffers need " + std::to_string(needed) +
+                  " bytes, which exceeds the memory budget of " +
+                  std::to_string(budget) + " bytes."),
+    needed_(needed) {
+  }
+
+  size_t needed() const noexcept {
+    return needed_;
+  }
+
+ private:
+  size_t needed_;
+};
+
+/// @brief TransformTree::ExportTasks() needs the buffers of the independent
+/// nodes not to overlap.
+class ParallelExecutionRequiredException : public ExceptionBase {
+ public:
+  ParallelExecutionRequiredException()
+  : ExceptionBase("The tasks can only be exported from a tree with "
+                  "parallel_execution() prepared.") {
+  }
+};
+
+/// @brief The transforms under transforms::Gate run on the frames which
+/// pass, so each of their buffers must depend only on the same buffer of
+/// the parent.
+class UngateableTransformException : public ExceptionBase {
+ public:
+  explicit UngateableTransformException(const std::string& transform)
+  : ExceptionBase("Transform \"" + transform + "\" cannot follow Gate, "
+                  "since its buffers depend on each other.") {
+  }
+};
+
+class ExecutionPipeline;
 class MemoryProtector;
+class Profiler;
+
+namespace memory_allocation {
+class BuffersAllocator;
+}
+
+/// @brief The algorithm which places the buffers of the sequentially
+/// executed trees into the memory block.
+enum class AllocationStrategy {
+  /// @brief memory_allocation::SlidingBlocksAllocator.
+  kSlidingBlocks,
+  /// @brief memory_allocation::IntervalPackingAllocator.
+  kIntervalPacking
+};
+
+/// @brief The type of the samples in the input of TransformTree::Execute().
+enum class SampleType {
+  kInt16,
+  kInt32,
+  kFloat
+};
+
+/// @brief The arrangement of the channels in the input of
+/// TransformTree::Execute().
+enum class ChannelsLayout {
+  /// @brief Each channel occupies RootFormat() samples one after another.
+  kPlanar,
+  /// @brief The samples of the channels alternate: L R L R ...
+  kInterleaved
+};
 
 class TransformTree : public Logger {
+  class Node;
+  friend class ExecutionPipeline;
+
+  /// @brief The frames which passed a gate in the current execution.
+  struct GateSelection {
+    /// @brief The indices of the frames which passed, Count of them.
+    std::vector<uint32_t> Indices;
+    size_t Count;
+    /// @brief The number of the frames which the gate received.
+    size_t Total;
+  };
+
  public:
+  typedef std::unordered_map<
+      std::string, std::chrono::high_resolution_clock::duration> TimersMap;
+  /// @brief Receives the buffers of a feature as soon as they are final,
+  /// see set_feature_sink().
+  typedef std::function<void(const std::string& feature,
+                             const Buffers& buffers)> FeatureSink;
+
+  /// @brief The mutable state of a single extraction: the buffers and
+  /// the timers. The prepared tree itself is not modified by
+  /// Execute(in, context), so any number of threads may extract the features
+  /// simultaneously, provided that each of them uses its own context.
+  /// @note Streaming transforms keep their state inside, so the streaming
+  /// trees must not be shared.
+  class ExecutionContext {
+   public:
+    ExecutionContext(const ExecutionContext&) = delete;
+    ExecutionContext& operator=(const ExecutionContext&) = delete;
+
+    /// @brief Returns the buffers to MemoryPool until the next
+    /// Execute(in, context), invalidating the previous results.
+    void ReleaseMemory() noexcept;
+
+    /// @brief The sink of Execute(in, context), see
+    /// TransformTree::set_feature_sink().
+    void set_feature_sink(const FeatureSink& sink);
+
+   private:
+    friend class TransformTree;
+    friend class ExecutionPipeline;
+    ExecutionContext() = default;
+
+    /// @brief The copy of the tree's memory block, with the same layout.
+    std::shared_ptr<void> memory_;
+    /// @brief The copies of the blocks of the nodes added after
+    /// PrepareForExecution().
+    std::unordered_map<const void*, std::shared_ptr<void>> extra_memory_;
+    /// @brief The value of layout_version_ of the tree at creation time.
+    size_t version_;
+    std::unordered_map<const Node*, std::shared_ptr<Buffers>> buffers_;
+    /// @brief The views of the parent's buffers of the first clones in
+    /// the slices, see Node::ParentSlice.
+    std::unordered_map<const Node*, std::shared_ptr<Buffers>> slices_;
+    /// @brief The value of Execute(in, context), built once.
+    std::unordered_map<std::string, std::shared_ptr<Buffers>> results_;
+    /// @brief results_ in the order of FeatureNames().
+    std::vector<std::shared_ptr<Buffers>> indexed_results_;
+    /// @brief Indexed by Node::Id.
+    std::vector<NodeCounters> counters_;
+    std::chrono::high_resolution_clock::duration all_time_;
+    /// @brief The deinterleaved input, see channels_layout().
+    std::shared_ptr<void> planar_input_;
+    /// @brief Indexed by Node::Id, empty means that all the nodes are
+    /// executed, see Execute(in, features, context).
+    std::vector<bool> active_nodes_;
+    /// @brief Indicates whether the current execution validates
+    /// the buffers, see validation_period().
+    bool validate_;
+    /// @brief The index of the current execution in the capture file, see
+    /// StartCapture().
+    uint64_t capture_execution_;
+    /// @brief Indexed by Node::GateIndex.
+    std::vector<GateSelection> gate_selections_;
+    FeatureSink feature_sink_;
+  };
+
   explicit TransformTree(formats::ArrayFormat16&& rootFormat) noexcept;
   explicit TransformTree(
       const std::shared_ptr<formats::ArrayFormat16>& rootFormat) noexcept;
+  /// @brief Creates the tree which takes the samples as int32_t, so that
+  /// the features which work with them skip the conversion from int16_t.
+  explicit TransformTree(
+      const std::shared_ptr<formats::ArrayFormat32>& rootFormat) noexcept;
+  /// @brief Creates the tree which takes the samples as float, e.g.,
+  /// decoded PCM. The float pipelines start without the conversion node.
+  explicit TransformTree(
+      const std::shared_ptr<formats::ArrayFormatF>& rootFormat) noexcept;
   virtual ~TransformTree() = default;
 
-  std::shared_ptr<formats::ArrayFormat16> RootFormat() const noexcept;
+  /// @brief The format of each of the batch_size() input buffers, one of
+  /// formats::ArrayFormat16, formats::ArrayFormat32 or formats::ArrayFormatF.
+  std::shared_ptr<BufferFormat> RootFormat() const noexcept;
+  /// @brief The number of samples in each of the input buffers.
+  size_t RootSize() const noexcept;
+  /// @brief The type of the samples in the input buffers.
+  SampleType root_sample_type() const noexcept;
 
+  /// @brief Adds the chain of transforms which calculates the feature.
+  /// @details If the tree is already prepared, only the new nodes are
+  /// initialized and allocated: they get a separate memory block and are
+  /// executed right after the node they branch from, while the rest of
+  /// the tree keeps its buffers. The execution contexts created before
+  /// become stale.
   void AddFeature(
       const std::string& name,
       const std::vector<std::pair<std::string, std::string>>& transforms);
 
+  /// @brief Removes the feature and the nodes which no other feature needs.
+  /// @details The nodes added after PrepareForExecution() release their
+  /// memory block as soon as all of them are removed; the buffers of
+  /// the other nodes stay reserved until the tree is destroyed. The
+  /// execution contexts created before become stale.
+  void RemoveFeature(const std::string& name);
+
+  /// @brief Changes the parameter of the transform which calculates
+  /// the feature, without preparing the tree again.
+  /// @details The nearest to the feature node of the transform is updated,
+  /// including the stages of the fused elementwise chains. Only the
+  /// parameters which keep the output format and the number of buffers
+  /// may change, e.g., Preemphasis' value. The transform is initialized
+  /// again and the buffers stay the same; if the node is shared, the other
+  /// features change as well. Must not run concurrently with Execute().
+  void SetTransformParameter(const std::string& feature,
+                             const std::string& transform,
+                             const std::string& name,
+                             const std::string& value);
+
+  /// @brief Initializes the transforms and allocates the buffers.
+  /// @details The views (see ViewTransform) and the nodes which may
+  /// overwrite the buffers of their parent (see Transform::InPlace()) if
+  /// nothing else reads them do not get their own memory.
   void PrepareForExecution();
 
-  std::unordered_map<std::string, std::shared_ptr<Buffers>> Execute(
-      const int16_t* in);
+  /// @brief Writes the prepared tree to a binary file: the features, the tree
+  /// settings, the solution of the memory allocation problem and the states
+  /// of the transforms which implement PrecomputedState.
+  /// @note The file is only valid for the same build of the library on
+  /// the same architecture.
+  void Save(const std::string& fileName) const;
+
+  /// @brief Memory maps the file written by Save() and restores the prepared
+  /// tree without solving the allocation problem and recalculating
+  /// the precomputed states. The mapping lives while some transform
+  /// references it.
+  static std::shared_ptr<TransformTree> Load(const std::string& fileName);
+
+  /// @brief Restores the tree from the contents of a file written by Save()
+  /// which are already in memory, e.g. compiled into a plugin by
+  /// sfe-compile. data must be aligned to PrecomputedState::kAlignment.
+  /// @param fileName The name of the image in the error messages.
+  /// @param owner Keeps data alive while some transform references it.
+  static std::shared_ptr<TransformTree> Load(
+      const std::string& fileName, const void* data, size_t size,
+      const std::shared_ptr<const void>& owner);
+
+  /// @brief Extracts the features. "in" points to the samples of
+  /// root_sample_type() type.
+  /// @details The returned map is built by the first execution and reused
+  /// by the following ones, which do not allocate any memory unless
+  /// memory_protection(), parallel_execution() or profiling is on.
+  const std::unordered_map<std::string, std::shared_ptr<Buffers>>& Execute(
+      const void* in);
+
+  /// @brief Returns the buffers of Execute(in) to MemoryPool, invalidating
+  /// the previous results. The next Execute(in) borrows a block of
+  /// the same size again. The memory of the nodes added after
+  /// PrepareForExecution() is kept.
+  void ReleaseMemory() noexcept;
+
+  /// @brief Returns the buffers which Execute(in) writes the features to.
+  /// They are suitable to learn the results layout before the execution.
+  std::unordered_map<std::string, std::shared_ptr<Buffers>> FeatureBuffers()
+      const;
+
+  /// @brief The names of the features in the order of AddFeature().
+  const std::vector<std::string>& FeatureNames() const noexcept;
+
+  /// @brief Returns the buffers of the map of Execute(in) or
+  /// Execute(in, context) in the order of FeatureNames(), so that
+  /// the callers with thousands of features do not look each one up by name.
+  /// @details Valid after the first execution, the same as the map.
+  const std::vector<std::shared_ptr<Buffers>>& IndexedResults(
+      const ExecutionContext* context = nullptr) const noexcept;
+
+  /// @brief Allocates the buffers for Execute(in, context).
+  std::shared_ptr<ExecutionContext> CreateExecutionContext() const;
+
+  /// @brief Extracts the features using the buffers of the specified context.
+  /// @details The resulting buffers stay valid until the next execution with
+  /// the same context or until the context is destroyed. The returned map
+  /// belongs to the context.
+  const std::unordered_map<std::string, std::shared_ptr<Buffers>>& Execute(
+      const void* in, ExecutionContext* context) const;
+
+  /// @brief Extracts only the specified features, skipping the nodes which
+  /// none of them depends on.
+  /// @details The returned map is the same as of Execute(in); the buffers
+  /// of the other features are not updated. The streaming transforms of
+  /// the skipped nodes do not see the input, so their state gets
+  /// out of sync.
+  const std::unordered_map<std::string, std::shared_ptr<Buffers>>& Execute(
+      const void* in, const std::vector<std::string>& features);
+  const std::unordered_map<std::string, std::shared_ptr<Buffers>>& Execute(
+      const void* in, const std::vector<std::string>& features,
+      ExecutionContext* context) const;
+
+  /// @brief A node of the execution plan, see ExportTasks().
+  struct Task {
+    /// @brief The transform and the features of the node, see
+    /// Node::ProfileName().
+    std::string Name;
+    /// @brief The indices of the tasks which must finish before this one.
+    std::vector<size_t> Dependencies;
+    /// @brief The number of the buffers which may be processed by
+    /// the concurrent Run() calls, 1 if the node runs as a whole.
+    size_t Ranges;
+    /// @brief Processes the buffers [begin, end) out of Ranges.
+    std::function<void(size_t begin, size_t end)> Run;
+  };
+
+  /// @brief Returns the execution plan of the context, so that a host
+  /// scheduler, e.g. TBB or Taskflow, runs the nodes on its own threads
+  /// instead of ThreadPool.
+  /// @details The tasks are topologically sorted. The parallel loops of
+  /// the transforms are serial inside Run(), the host splits the buffers
+  /// of the nodes with Ranges > 1 instead. Such partial runs skip
+  /// the guards, the validation and the profiling of the node. If there are
+  /// gates (see transforms::Gate), the last task scatters their features.
+  /// Call StartTasks() before running the tasks of each execution.
+  /// @note The tree must be prepared with parallel_execution(), since
+  /// the independent tasks run simultaneously.
+  std::vector<Task> ExportTasks(ExecutionContext* context) const;
+
+  /// @brief Binds the input to the context for the tasks of ExportTasks().
+  /// @return The map of Execute(in, context), it holds the features after
+  /// all the tasks have finished.
+  const std::unordered_map<std::string, std::shared_ptr<Buffers>>&
+  StartTasks(const void* in, ExecutionContext* context) const;
+
+  /// @brief Picks the features from the list ordered by decreasing
+  /// priority while the estimated time of their nodes fits into the budget,
+  /// so that Execute(in, features) meets a deadline. The time of a node is
+  /// the one of its last execution, which is measured unless
+  /// profiling_level() is ProfilingLevel::kOff. The first feature is always
+  /// picked, the rest go to skipped.
+  std::vector<std::string> SelectFeatures(
+      const std::vector<std::string>& priorities,
+      const std::chrono::high_resolution_clock::duration& budget,
+      std::vector<std::string>* skipped) const;
 
   std::unordered_map<std::string, float> ExecutionTimeReport() const noexcept;
-  void Dump(const std::string& dotFileName) const;
+  std::unordered_map<std::string, float> ExecutionTimeReport(
+      const ExecutionContext& context) const noexcept;
+  /// @brief Writes the tree in the Graphviz format.
+  /// @param annotated Add the columns of Explain() to the labels.
+  void Dump(const std::string& dotFileName, bool annotated = false) const;
+  /// @brief Describes what the prepared tree executes after sharing,
+  /// fusion, slicing, placement and pruning: a tab separated line per node
+  /// in the execution order with its id, the buffers count, whether it owns
+  /// its buffers or aliases its parent's (view, in-place), the sizes of its
+  /// buffers and of its private memory, EstimatedWork(), the placement,
+  /// the threads, the SIMD instruction set, the sliced cycle and the number
+  /// of its slices, the fused transforms and the gate. The comment lines
+  /// starting with "#" summarize the tree.
+  std::string Explain() const;
 
+  /// @brief Indicates whether the output of each transform is checked by
+  /// its format, e.g., for NaN and infinite values, and
+  /// TransformResultedInInvalidBuffersException is thrown on failure.
   bool validate_after_each_transform() const noexcept;
   void set_validate_after_each_transform(bool value) noexcept;
+  /// @brief With validate_after_each_transform(), only one execution out of
+  /// this many, including Execute(in, context), validates the buffers, so
+  /// that the checks stay cheap under a continuous load. The default is 1,
+  /// that is, every execution. 0 is treated as 1.
+  size_t validation_period() const noexcept;
+  void set_validation_period(size_t value) noexcept;
   bool dump_buffers_after_each_transform() const noexcept;
   void set_dump_buffers_after_each_transform(bool value) noexcept;
+  /// @brief Starts writing the output buffers of the nodes of the specified
+  /// transforms (all if empty) to fileName after each execution, see
+  /// BufferCapture. It is the binary and asynchronous alternative to
+  /// dump_buffers_after_each_transform() for the large inputs.
+  /// @note This must not be called during an execution.
+  void StartCapture(const std::string& fileName,
+                    const std::vector<std::string>& transforms = {},
+                    size_t ringSize = BufferCapture::kDefaultRingSize);
+  /// @brief Finishes writing the file started by StartCapture().
+  /// @return false if any write failed or any record was dropped.
+  bool StopCapture() noexcept;
+  /// @brief Returns the active capture or nullptr.
+  std::shared_ptr<const BufferCapture> capture() const noexcept;
   bool cache_optimization() const noexcept;
   void set_cache_optimization(bool value) noexcept;
+  /// @brief Indicates whether the slice sizes of the cache optimized cycles
+  /// are chosen by timing the candidates on a synthetic input instead of
+  /// being derived from get_cpu_cache_size().
+  /// @note This must be set before PrepareForExecution().
+  bool cache_autotuning() const noexcept;
+  void set_cache_autotuning(bool value) noexcept;
+  /// @brief Indicates whether PrepareForExecution() prefaults the allocated
+  /// buffers and executes the tree once on a synthetic input, so that
+  /// the first Execute() does not pay for the page faults and the cold
+  /// private memory of the transforms. The counters and the streaming
+  /// state are reset afterwards.
+  /// @note This must be set before PrepareForExecution().
+  bool warm_up() const noexcept;
+  void set_warm_up(bool value) noexcept;
+  /// @brief The maximal size of the buffers of the nodes in bytes, 0 if
+  /// unlimited. PrepareForExecution() throws MemoryBudgetExceededException
+  /// before allocating them if the allocation plan does not fit.
+  /// @note This must be set before PrepareForExecution().
+  size_t memory_budget() const noexcept;
+  void set_memory_budget(size_t value) noexcept;
+  /// @brief Indicates whether the slices of each cache optimized cycle are
+  /// executed concurrently, one slice per OpenMP thread, instead of one
+  /// after another.
+  bool parallel_slices() const noexcept;
+  void set_parallel_slices(bool value) noexcept;
+  /// @brief How much is measured about each node in the subsequent
+  /// executions. kCoarse by default; kOff leaves only "All" and "Other" in
+  /// ExecutionTimeReport().
+  ProfilingLevel profiling_level() const noexcept;
+  void set_profiling_level(ProfilingLevel value) noexcept;
+  /// @brief Passes each feature of Execute(in) to the sink as soon as its
+  /// buffers are final, so that the caller serializes, compresses or sends
+  /// it while the rest of the nodes are executing instead of after all of
+  /// them. The features behind a gate are passed after all the nodes,
+  /// the features skipped by Execute(in, features) are not passed.
+  /// @note The sink is called on the thread which executed the feature's
+  /// node, concurrently with the other nodes under parallel_execution(),
+  /// must not modify the buffers and must not throw. An empty sink
+  /// disables the calls.
+  const FeatureSink& feature_sink() const noexcept;
+  void set_feature_sink(const FeatureSink& sink);
+  /// @brief Returns the counters of each node of the last execution in
+  /// the pre-order, named like Profiler. The slices of the sliced cycles are
+  /// merged into their original nodes.
+  std::vector<std::pair<std::string, NodeCounters>> NodeCountersReport()
+      const noexcept;
+  std::vector<std::pair<std::string, NodeCounters>> NodeCountersReport(
+      const ExecutionContext& context) const noexcept;
+  /// @brief Returns the instruction set of the SIMD kernels which each node
+  /// currently uses, in the same order and with the same names as
+  /// NodeCountersReport().
+  std::vector<std::pair<std::string, InstructionSet>> InstructionSetsReport()
+      const noexcept;
+  /// @brief The memory of a prepared tree, see MemoryReport().
+  struct MemoryUsage {
+    /// @brief The memory blocks of the buffers, including those of
+    /// the features added after PrepareForExecution().
+    size_t Allocated;
+    /// @brief The maximal total size of the buffers which are alive
+    /// simultaneously, the lower bound of the block which
+    /// PrepareForExecution() allocates.
+    size_t Peak;
+    /// @brief The total size of the buffers of all the nodes.
+    size_t Buffers;
+    /// @brief The total size of Transform::PrivateMemorySize().
+    size_t Private;
+    /// @brief The name, the buffers size (0 for the views and the in-place
+    /// nodes) and the private memory of each node, in the same order and
+    /// with the same names as NodeCountersReport().
+    std::vector<std::tuple<std::string, size_t, size_t>> Nodes;
+  };
+  /// @brief Returns how much memory the prepared tree needs and which nodes
+  /// drive it, without executing it.
+  MemoryUsage MemoryReport() const;
+  /// @brief The wall time of the phases of PrepareForExecution(), see
+  /// prepare_times().
+  struct PrepareTimes {
+    /// @brief Transform::Initialize() of all the nodes.
+    std::chrono::high_resolution_clock::duration Initialize;
+    /// @brief Solving the allocation problem or applying the saved plan.
+    std::chrono::high_resolution_clock::duration Plan;
+    /// @brief Acquiring the memory block of the buffers.
+    std::chrono::high_resolution_clock::duration Allocate;
+    /// @brief The whole PrepareForExecution().
+    std::chrono::high_resolution_clock::duration Total;
+  };
+  /// @brief Returns how many samples before and after a range of the input
+  /// are required to calculate the features of that range exactly, so that
+  /// a long input can be processed in the overlapping blocks of a bounded
+  /// size (see Transform::RequiredOverlap()). It is bounded only if each
+  /// feature splits the signal into windows (format conversions aside) and
+  /// the following transforms keep the number of buffers.
+  /// @param hops Receives the step of the windows of each feature, that is,
+  /// the number of samples which each row of its results corresponds to.
+  Overlap BlockOverlap(std::unordered_map<std::string, size_t>* hops) const;
+  /// @brief Indicates whether the results of each of the batch_size() input
+  /// signals depend on that signal only, i.e., each transform calculates
+  /// its output buffers from a single input buffer (see
+  /// Transform::BufferRatio()) and reads no neighbours (see
+  /// Transform::RequiredOverlap()). Delta, Flux, Rotate, Stats and the like
+  /// relate the buffers of the adjacent signals otherwise.
+  /// @param culprit Receives the name of the first transform which does not
+  /// qualify, may be nullptr.
+  bool SignalsIndependent(std::string* culprit) const noexcept;
+  /// @brief Returns where each node currently runs, in the same order and
+  /// with the same names as NodeCountersReport(). The nodes which do not
+  /// implement ParallelTransform are kSerial.
+  std::vector<std::pair<std::string, Placement>> PlacementsReport()
+      const noexcept;
+  /// @brief Starts collecting the statistics of each node (see Profiler)
+  /// in all the subsequent executions, including Execute(in, context).
+  /// @param trace Record the Chrome trace events as well.
+  /// @note This must not be called while the tree is being executed.
+  void EnableProfiling(bool trace) noexcept;
+  void DisableProfiling() noexcept;
+  /// @brief Returns nullptr unless EnableProfiling() was called.
+  std::shared_ptr<Profiler> profiler() const noexcept;
+  /// @brief Indicates whether Execute(in) write protects the buffers of
+  /// the leaves with mprotect() until the next Execute(in).
   bool memory_protection() const noexcept;
   void set_memory_protection(bool value) noexcept;
+  /// @brief With memory_protection(), only one Execute(in) out of this many
+  /// protects the leaves, to keep the syscalls off the most of the runs.
+  /// The default is 1, that is, every execution. 0 is treated as 1.
+  size_t memory_protection_period() const noexcept;
+  void set_memory_protection_period(size_t value) noexcept;
+  /// @brief Indicates whether each node's buffers are followed by a guard
+  /// which is checked after the transform is executed. The overwritten
+  /// guard throws BufferOverrunException. The clones of the sliced cycles
+  /// are not checked.
+  /// @note This must be set before PrepareForExecution(), since the guards
+  /// take kGuardSize bytes of the allocated memory per node.
+  bool memory_guards() const noexcept;
+  void set_memory_guards(bool value) noexcept;
+  /// @brief Indicates whether independent subtrees are executed concurrently
+  /// as OpenMP tasks instead of following the linear Next chain.
+  /// @note This must be set before PrepareForExecution(), since the buffers
+  /// of the branches which run simultaneously must not share memory.
+  bool parallel_execution() const noexcept;
+  void set_parallel_execution(bool value) noexcept;
+  /// @brief Indicates whether Execute(in) is real-time safe, e.g. on
+  /// an audio callback thread: it does not allocate, take locks, log or
+  /// make syscalls. PrepareForExecution() executes the tree once, so that
+  /// everything the transforms create lazily exists and their scratch
+  /// memory is measured, and locks all the memory in RAM. The transforms
+  /// run sequentially on the calling thread; memory protection,
+  /// validation, dumps, capture and profiling, except the coarse counters,
+  /// are skipped. RealtimeSection reports the violations.
+  /// @note This must be set before PrepareForExecution(). The first
+  /// Execute(in) after the features are changed or ReleaseMemory() repeats
+  /// the preparation. Execute(in, context) is not affected.
+  bool realtime() const noexcept;
+  void set_realtime(bool value) noexcept;
+  /// @brief Indicates whether PrepareForExecution() substitutes the chains
+  /// of transforms which have a fused implementation, e.g. RDFT ->
+  /// SpectralEnergy with PowerSpectrum, DCT -> Selector with the truncated
+  /// DCT, FilterBank -> Log -> DCT -> Selector with Cepstrum,
+  /// Autocorrelation -> Selector with the leading lags only or Log ->
+  /// Square with ElementwiseChain. The features are not changed.
+  /// @note This must be set before PrepareForExecution().
+  bool fuse_transforms() const noexcept;
+  void set_fuse_transforms(bool value) noexcept;
+  /// @brief Indicates whether the StreamingStoresTransform nodes write
+  /// the leaves and the outputs larger than get_cpu_cache_size() with
+  /// the non-temporal stores, so that they do not evict the buffers which
+  /// the rest of the tree reads. Disabled by default.
+  bool streaming_stores() const noexcept;
+  void set_streaming_stores(bool value) noexcept;
+  /// @brief Indicates whether PrepareForExecution() packs the tiny outputs
+  /// of the leaves, e.g. a float per frame, with the stride of the nearest
+  /// power of two instead of padding each buffer to the alignment, so that
+  /// the results do not waste the cache lines. Disabled by default.
+  /// @note This must be set before PrepareForExecution().
+  bool packed_results() const noexcept;
+  void set_packed_results(bool value) noexcept;
+  /// @brief Indicates whether Execute() recognizes the inputs in which
+  /// all the samples are the same, e.g. the digital silence or DC, and
+  /// copies the results of the first such execution instead of running
+  /// the transforms again. The streaming trees and the executions with
+  /// a capture or a feature sink always run the transforms. Disabled by
+  /// default.
+  bool constant_input_shortcut() const noexcept;
+  void set_constant_input_shortcut(bool value) noexcept;
+  /// @brief The number of the executions which copied the results of
+  /// a constant input, see constant_input_shortcut().
+  size_t constant_input_hits() const noexcept;
+  /// @brief The buffers allocator of PrepareForExecution(). The parallel
+  /// execution always uses memory_allocation::WorstAllocator.
+  /// @note This must be set before PrepareForExecution().
+  AllocationStrategy allocation_strategy() const noexcept;
+  void set_allocation_strategy(AllocationStrategy value) noexcept;
+  /// @brief The execution settings which AddFeature(),
+  /// PrepareForExecution() and Execute() use instead of the process-wide
+  /// ones, including on the pool threads. The default follows them.
+  /// @note This must be set before AddFeature(), since the transforms take
+  /// their threads number when they are created.
+  const ExecutionOverrides& execution_overrides() const noexcept;
+  void set_execution_overrides(const ExecutionOverrides& value) noexcept;
+  /// @brief The number of nodes which AddFeature() did not create because
+  /// an identical transform (after applying the parameter defaults) with
+  /// the same input already existed.
+  size_t merged_nodes_count() const noexcept;
+  /// @brief The size of the buffers of the nodes counted by
+  /// merged_nodes_count().
+  size_t merged_bytes() const noexcept;
+  /// @brief Declares the transforms named transform with the same values of
+  /// the specified parameters equivalent, so that AddFeature() shares
+  /// a single node between them even if the rest of the parameters differ.
+  /// For example, ("Window", "length=512,step=256") builds one spectral
+  /// front end for all the features which take 512 samples long windows
+  /// with the step of 256, whatever the window types are. The transform of
+  /// the first added feature is calculated, so the other features become
+  /// approximate.
+  /// @note This must be called before AddFeature().
+  void AddEquivalence(const std::string& transform,
+                      const std::string& parameters);
+  /// @brief The number of nodes which AddFeature() did not create because of
+  /// AddEquivalence(), including the identical descendants of the shared
+  /// nodes. They are not counted by merged_nodes_count().
+  size_t approximately_merged_nodes_count() const noexcept;
+  /// @brief The estimated ratio of the work of the tree built without
+  /// AddEquivalence() to the work of this tree. The work of a node is
+  /// the number of the values it reads or writes, whichever is greater,
+  /// times ParallelTransform::ElementCost().
+  float approximate_sharing_speedup() const noexcept;
+  /// @brief The size of the memory block which PrepareForExecution()
+  /// allocated for the buffers of all the nodes.
+  size_t allocated_size() const noexcept;
+  /// @brief How long the phases of PrepareForExecution() took.
+  const PrepareTimes& prepare_times() const noexcept;
+  /// @brief Indicates whether the transforms keep their state between
+  /// the successive calls to Execute(), so that the input is treated as
+  /// the continuous stream of blocks.
+  /// @note This must be set before AddFeature().
+  bool streaming() const noexcept;
+  void set_streaming(bool value) noexcept;
+  /// @brief Drops the state which the transforms have accumulated in
+  /// the streaming mode.
+  void ResetStream() const noexcept;
+  /// @brief The approximations the transforms may take instead of their
+  /// default parameters, see Transform::set_accuracy(). The explicit
+  /// parameters of the features take precedence.
+  /// @note This must be set before AddFeature().
+  Accuracy accuracy() const noexcept;
+  void set_accuracy(Accuracy value) noexcept;
+  /// @brief The number of independent input signals of RootFormat() size
+  /// processed by a single Execute(). They must be laid out in memory with
+  /// RootFormat()->SizeInBytes() stride.
+  /// @note This must be set before AddFeature(). The transforms which relate
+  /// adjacent windows (e.g., Delta) see the signals as concatenated, see
+  /// SignalsIndependent().
+  size_t batch_size() const noexcept;
+  void set_batch_size(size_t value) noexcept;
+  /// @brief The layout of the batch_size() channels in the input. The
+  /// interleaved input is split into the planar buffers right before
+  /// the execution, so the transforms process each channel as a separate
+  /// buffer in a single pass.
+  /// @note This must be set before AddFeature().
+  ChannelsLayout channels_layout() const noexcept;
+  void set_channels_layout(ChannelsLayout value) noexcept;
 
  private:
+  TransformTree(const std::shared_ptr<BufferFormat>& rootFormat,
+                size_t rootSize, SampleType sampleType) noexcept;
+
+  /// @brief The memory of the nodes added after PrepareForExecution().
+  struct MemoryBlock {
+    std::shared_ptr<void> Data;
+    size_t Size;
+  };
+
   class Node : public Logger {
    public:
     Node(Node* parent, const std::shared_ptr<Transform>& boundTransform,
          size_t buffersCount, TransformTree* host) noexcept;
 
     void ActionOnEachTransformInSubtree(
-        const std::function<void(const Transform&)> action) const;
+        const std::function<void(const Transform&)>& action) const;
     void ActionOnSubtree(
-        const std::function<void(const Node&)> action) const;
-    void ActionOnSubtree(const std::function<void(Node&)> action);
+        const std::function<void(const Node&)>& action) const;
+    void ActionOnSubtree(const std::function<void(Node&)>& action);
     void ActionOnEachImmediateChild(
-        const std::function<void(Node&)> action);
+        const std::function<void(Node&)>& action);
     void ActionOnEachImmediateChild(
-        const std::function<void(const Node&)> action) const;
+        const std::function<void(const Node&)>& action) const;
     void ActionOnEachParent(
-        const std::function<void(const Node&)> action) const;
+        const std::function<void(const Node&)>& action) const;
 
     std::shared_ptr<Node> FindIdenticalChildTransform(const Transform& base)
         const noexcept;
+    /// @brief Returns the child which belongs to the same class of
+    /// TransformTree::AddEquivalence() as base, or nullptr.
+    std::shared_ptr<Node> FindEquivalentChildTransform(const Transform& base)
+        const noexcept;
 
+    /// @brief Appends the children to node. The children of the views and
+    /// of the in-place nodes are appended instead of the nodes themselves.
     void BuildAllocationTree(memory_allocation::Node* node) const noexcept;
+    /// @brief The number of children BuildAllocationTree() appends.
+    size_t AllocationChildrenCount() const noexcept;
 
     void ApplyAllocationTree(const memory_allocation::Node& node,
                              void* allocatedMemory) noexcept;
 
-    void Execute() noexcept;
+    /// @brief The following methods use the node's own buffers and timers
+    /// if context is nullptr.
+    void Execute(ExecutionContext* context) noexcept;
+    void ExecuteBoundTransform(ExecutionContext* context) noexcept;
+    /// @brief Runs the transform from in to out, which are the frames
+    /// selected by Gate if it is set.
+    void ExecuteBoundTransform(ExecutionContext* context, Buffers* in,
+                               Buffers* out) noexcept;
+    /// @brief Executes this node and then spawns a task per child subtree.
+    void ExecuteInParallel(ExecutionContext* context) noexcept;
+    /// @brief Executes the slices of the sliced cycle which starts with
+    /// this node concurrently.
+    /// @return The node executed after the cycle.
+    Node* ExecuteSlices(ExecutionContext* context) noexcept;
+    /// @brief Points the buffers of this node and of its views (see
+    /// ViewTransform) to the input.
+    void BindInput(void* input, ExecutionContext* context) const noexcept;
+    /// @brief Returns the transform name and the related features of
+    /// the original node, e.g. "Window [MFCC, Centroid]".
+    std::string ProfileName() const noexcept;
+
+    const std::shared_ptr<Buffers>& ContextBuffers(
+        const ExecutionContext* context) const noexcept;
+    /// @brief Returns false if the node is skipped by the current
+    /// Execute(in, features).
+    bool Active(const ExecutionContext* context) const noexcept;
 
     size_t ChildrenCount() const noexcept;
     std::shared_ptr<Node> SelfPtr() const noexcept;
+    /// @brief The size of the node's buffers including the guard,
+    /// see TransformTree::memory_guards().
+    size_t AllocationSize() const noexcept;
+    void SetGuard(ExecutionContext* context) noexcept;
+    void CheckGuard(ExecutionContext* context) const;
 
     TransformTree* Host;
     Node* Parent;
     const std::shared_ptr<Transform> BoundTransform;
     std::shared_ptr<Buffers> BoundBuffers;
+    /// @brief The offset of BoundBuffers in their memory block, to rebind
+    /// them after ReleaseMemory().
+    size_t Offset;
+    /// @brief The block which BoundBuffers point to; nullptr means
+    /// TransformTree::allocated_memory_.
+    std::shared_ptr<MemoryBlock> Memory;
     size_t BuffersCount;
     std::shared_ptr<MemoryProtector> Protection;
     std::unordered_map<std::string, std::vector<std::shared_ptr<Node>>>
@@ -221,23 +952,111 @@ class TransformTree : public Logger {
     Node* Next;
     std::unordered_map<Node*, std::tuple<size_t, size_t>> Slices;
     Node* OriginalNode;
+    /// @brief The view of the parent's buffers which the first clone in
+    /// a slice reads. It is rebound on each execution, since the parent's
+    /// memory may change, e.g. the root's.
+    std::shared_ptr<Buffers> ParentSlice;
+    /// @brief The first clones of each slice, set in the first clone of
+    /// the cycle for ExecuteSlices().
+    std::vector<Node*> SliceStarts;
     int CycleId;
+    /// @brief The index of the slice of the clone, or -1.
+    int SliceIndex;
     bool HasClones;
+    /// @brief The index of the node's slot in the counters, see IndexNodes().
+    size_t Id;
+    /// @brief The transforms which FuseTransforms() replaced with this
+    /// node, e.g. "RDFT + SpectralEnergy", or empty.
+    std::string Fused;
+    /// @brief Copied from TransformCacheItem::Dump.
+    bool DumpBuffers;
+    /// @brief BoundBuffers point to the memory of the parent, possibly with
+    /// a smaller stride, and the node is never executed, see ViewTransform.
+    bool View;
+    /// @brief BoundBuffers point to the memory of the parent, which is
+    /// overwritten on execution, see Transform::InPlace().
+    bool InPlace;
+    /// @brief BoundBuffers follow each other with PackedStride() instead of
+    /// the aligned size of the format, see packed_results().
+    bool Packed;
+    /// @brief The buffers lie after all the reused ones, so their pads stay
+    /// zero after ClearPinnedMemory(), see HasPaddingChild().
+    bool Pinned;
+    /// @brief The nearest transforms::Gate above the node, whose selected
+    /// frames the node processes, or nullptr.
+    Node* Gate;
+    /// @brief The index of the node's selection if it is a gate, or -1.
+    int GateIndex;
+    /// @brief The interned names of the features which depend on the node,
+    /// see FeatureName().
+    std::vector<size_t> RelatedFeatures;
+    /// @brief The ticks of the last execution, see SelectFeatures().
+    std::atomic<uint64_t> LastTicks;
+  };
+
+  /// @brief The buffers placement of a node of the allocation tree.
+  struct AllocationRecord {
+    size_t Size;
+    size_t Address;
+    /// @brief The index of the next executed node in the pre-order
+    /// traversal, or -1.
+    int Next;
+  };
 
-    std::shared_ptr<std::chrono::high_resolution_clock::duration> ElapsedTime;
-    std::vector<std::string> RelatedFeatures;
+  /// @brief A node of the flat copy of the tree, see plan_.
+  struct PlanRecord {
+    Node* Self;
+    /// @brief The index of the parent in plan_, or -1 for the root.
+    int Parent;
+    /// @brief The children are plan_children_[FirstChild,
+    /// FirstChild + ChildrenCount).
+    int FirstChild;
+    int ChildrenCount;
+  };
+
+  /// @brief The data passed from Load() to Prepare().
+  struct PreparedImage {
+    std::string FileName;
+    /// @brief Keeps the memory mapped file alive.
+    std::shared_ptr<const void> Mapping;
+    size_t AllocatedSize;
+    std::vector<AllocationRecord> Allocation;
+    /// @brief The transform name and the state of each original node in
+    /// the pre-order traversal.
+    std::vector<std::tuple<std::string, const char*, size_t>> States;
+  };
+
+  /// @brief The class of transforms declared by AddEquivalence().
+  struct Equivalence {
+    std::string Transform;
+    std::string Parameters;
+    /// @brief The canonical values of Parameters.
+    ParametersMap Values;
   };
 
   struct TransformCacheItem {
-    TransformCacheItem() : ElapsedTime(0), Dump(false) {
+    TransformCacheItem() : Dump(false) {
     }
 
     std::shared_ptr<Transform> BoundTransform;
-    std::chrono::high_resolution_clock::duration ElapsedTime;
     bool Dump;
   };
 
   static constexpr const char* kDumpEnvPrefix = "SFE_DUMP_";
+  /// @brief The number of timed runs of each slice size candidate.
+  static constexpr int kAutotuningRuns = 3;
+  static constexpr unsigned kAutotuningSeed = 777;
+  /// @brief The size of the guard after each node's buffers, it keeps
+  /// the alignment of the following buffers.
+  static constexpr size_t kGuardSize = 64;
+  static constexpr uint32_t kGuardWord = 0xFEEDFACE;
+  /// @brief The estimated work of a ParallelTransform node, in simple
+  /// elementwise operations, below which it runs serially.
+  static constexpr float kParallelWorkThreshold = 1 << 16;
+  /// @brief The measured time of a ParallelTransform node in microseconds
+  /// below which it runs serially. A serial node becomes parallel again
+  /// if it takes more than twice as long.
+  static constexpr int kParallelTimeThreshold = 50;
 
   void AddTransform(const std::string& name,
                     const std::string& parameters,
@@ -245,10 +1064,301 @@ class TransformTree : public Logger {
                     std::shared_ptr<Node>* currentNode);
   void AddIdentityTransform(const std::string& feature,
                             std::shared_ptr<Node>* currentNode);
+  /// @brief Returns the permanent integer id of the feature name, which
+  /// Node::RelatedFeatures hold instead of the strings.
+  size_t InternFeature(const std::string& name);
+  const std::string& FeatureName(size_t id) const noexcept;
+  /// @brief Fills indexed_results of results in the order of FeatureNames().
+  void IndexResults(
+      const std::unordered_map<std::string, std::shared_ptr<Buffers>>& results,
+      std::vector<std::shared_ptr<Buffers>>* indexed_results) const;
+  /// @brief Returns the estimated work of the node, see
+  /// approximate_sharing_speedup().
+  static float EstimatedWork(const Node& node) noexcept;
+  /// @brief The columns of Explain() after the order, in the same order as
+  /// kExplainColumns.
+  std::vector<std::string> ExplainNode(
+      const Node& node, const std::unordered_map<int, int>& slices) const;
+  /// @brief The number of the slices of each sliced cycle by CycleId.
+  std::unordered_map<int, int> SlicesCounts() const noexcept;
+
+  /// @brief Implements PrepareForExecution(). If image is not nullptr,
+  /// the allocation plan and the transforms states are taken from it.
+  void Prepare(const PreparedImage* image);
+  static void FlattenAllocationTree(
+      memory_allocation::Node* node,
+      std::vector<memory_allocation::Node*>* nodes) noexcept;
+
+  /// @brief Initializes and allocates the nodes without buffers, which
+  /// AddFeature() has added to the prepared tree.
+  void AllocateNewNodes();
+  /// @brief Reverts the failed AddFeature() of the prepared tree.
+  void RemoveNewNodes(const std::string& feature) noexcept;
+  /// @brief Restores the original nodes of the sliced cycle in the execution
+  /// order and drops the clones.
+  void DismantleSlicedCycle(int cycleId) noexcept;
+  /// @brief Returns the node executed before the specified one, or nullptr.
+  Node* PreviousNode(const Node* node) const noexcept;
 
-  int BuildSlicedCycles() noexcept;
+  /// @brief Finds the linear chains of Sliceable() nodes which can be
+  /// executed slice by slice. A chain ends with the sliceable leaves
+  /// of its last node (or it consists only of the sibling leaves), so that
+  /// several reductions of the same buffers read each slice while it is
+  /// still in the cache.
+  std::vector<std::vector<Node*>> FindCacheFriendlyChains() const noexcept;
+  /// @brief Returns true if each buffer of the node's parent produces
+  /// a fixed number of the node's buffers, e.g., the windows of
+  /// WindowSplitter, see Transform::BufferRatio().
+  static bool Sliceable(const Node& node) noexcept;
+  /// @brief Returns the number of the buffers of each node of the chain
+  /// which a single buffer of its head produces.
+  static std::vector<size_t> ChainRatios(
+      const std::vector<Node*>& chain) noexcept;
+  /// @brief Returns the size in bytes of the biggest input of a node
+  /// in the chain per buffer of the chain's head.
+  static size_t MaxInputSize(const std::vector<Node*>& chain) noexcept;
+  /// @brief Links the clones of the chain's nodes, each handling
+  /// sliceBuffersCount buffers of the head, instead of the originals.
+  void SliceCycle(const std::vector<Node*>& cycle, size_t sliceBuffersCount,
+                  int cycleId) noexcept;
+  int BuildSlicedCycles();
+  /// @brief Returns the slice sizes to try for the chain, including
+  /// the unsliced buffers count. The numbers of slices are rounded up to
+  /// a multiple of the OpenMP threads count.
+  std::vector<size_t> SliceCandidates(
+      const std::vector<Node*>& chain) const noexcept;
+  /// @brief Returns the pseudo random samples for the whole root buffers.
+  std::shared_ptr<void> SyntheticInput() const;
+  /// @brief Runs the nodes on SyntheticInput() and leaves no trace of it,
+  /// see warm_up().
+  void WarmUp();
+  /// @brief Allocates, initializes and locks everything which
+  /// the real-time Execute(in) needs, see realtime().
+  void PrepareRealtime();
+  /// @brief The body of the real-time Execute(in).
+  const std::unordered_map<std::string, std::shared_ptr<Buffers>>&
+  ExecuteRealtime(const void* in);
+  /// @brief Runs the nodes sequentially on the input, without any
+  /// bookkeeping which is not real-time safe.
+  void RunRealtime(const void* in);
+  /// @brief Times SliceCandidates() of each chain on a pseudo-random input
+  /// and leaves the fastest slicing.
+  /// @return The number of sliced cycles.
+  int TuneSlicedCycles(const std::vector<std::vector<Node*>>& chains);
+  /// @brief Replaces [WindowFunction ->] RDFT -> SpectralEnergy chains
+  /// with PowerSpectrum nodes and the chains of ElementwiseTransform nodes
+  /// with ElementwiseChain nodes. The chains which end with
+  /// a NarrowingTransform node become ElementwiseNarrowingChain nodes,
+  /// the rest which follow a WideningTransform converter become
+  /// ElementwiseWideningChain nodes. The sibling Centroid, Rolloff, Flux and
+  /// Energy nodes are merged into a single SpectralDescriptors node.
+  /// The pairs of Rotate nodes which cancel out become Identity views and
+  /// Rotate -> Stats chains become RotatedStats nodes.
+  /// Autocorrelation -> Selector(from=right) chains, whose children select
+  /// only the leading lags (e.g. for LPC), become Autocorrelation with
+  /// "lags" set to the longest selection.
+  /// [MixStereo ->] Int16ToFloatRaw -> Preemphasis chains are replaced with
+  /// Preemphasis16F nodes, Diff -> Rectify chains with Diff(rectify=true)
+  /// and DWPT -> SubbandEnergy chains with DWPTSubbandEnergy nodes.
+  /// FilterBank -> Log -> DCT -> Selector chains, which keep the leading
+  /// coefficients only, become Cepstrum nodes.
+  /// UnpackRDFT nodes are removed first, see ElideUnpacking(), and
+  /// the reductions of the rectangular windows are fused next, see
+  /// FuseSlidingReductions().
+  /// @return The number of replaced chains and merged siblings.
+  int FuseTransforms();
+  /// @brief Removes the UnpackRDFT nodes whose children all read the packed
+  /// spectrum natively (SpectralEnergy, ComplexMagnitude and C2R with
+  /// "unpacked" set), which saves a pass and the buffers of the whole
+  /// spectrum.
+  /// @return The number of removed nodes.
+  int ElideUnpacking();
+  /// @brief Replaces the Energy, ZeroCrossings and arithmetic Mean children
+  /// of the overlapping rectangular windows of a single buffer with
+  /// the transforms which slide over the signal (see SlidingReduction),
+  /// and removes the windows if nothing else reads them.
+  /// @return The number of replaced children.
+  int FuseSlidingReductions();
+  /// @brief Returns the sliding equivalent of transform applied to
+  /// the windows of splitter, or nullptr if there is none.
+  static std::shared_ptr<Transform> SlidingReduction(
+      const Node& splitter, const Transform& transform);
+  /// @brief Returns the equivalent of transform which reads the packed RDFT
+  /// spectrum, or nullptr if there is none.
+  static std::shared_ptr<Transform> UnpackingConsumer(
+      const Transform& transform);
+  /// @brief Returns the children of node which SpectralDescriptors can
+  /// calculate, at most one per descriptor.
+  static std::vector<std::pair<Node*, transforms::SpectralDescriptor>>
+  SiblingDescriptors(Node* node) noexcept;
+  /// @brief Substitutes the siblings with a single SpectralDescriptors node
+  /// followed by a DescriptorSelector per sibling.
+  void FuseDescriptors(
+      const std::vector<std::pair<Node*, transforms::SpectralDescriptor>>&
+          siblings);
+  static bool IsElementwise(const Node& node) noexcept;
+  /// @brief Indicates whether the node may share the buffers of its parent
+  /// instead of executing its transform, see ViewTransform.
+  static bool IsView(const Node& node) noexcept;
+  /// @brief Indicates whether the node is a view which requires the dense
+  /// buffers of its parent, see ViewTransform::DenseInput().
+  static bool IsDenseView(const Node& node) noexcept;
+  /// @brief Indicates whether the only child of the node is a dense view,
+  /// so that the node writes its buffers without the padding.
+  static bool HasDenseView(const Node& node) noexcept;
+  /// @brief Indicates whether the only child of the node is ZeroPadding
+  /// which pads the buffers to PackedStride(). The node then writes its
+  /// buffers with that stride and ZeroPadding zeroes the rest of each in
+  /// place instead of copying them. Prepare() pins such buffers, so the
+  /// pads are zeroed once per memory block instead of on each execution.
+  static bool HasPaddingChild(const Node& node) noexcept;
+  /// @brief Returns ViewTransform::ViewStride() of the node's transform.
+  static size_t ViewStride(const Node& node) noexcept;
+  /// @brief Indicates whether the node may write its output over the buffers
+  /// of its parent, which are not read by anything else.
+  static bool IsInPlace(const Node& node) noexcept;
+  static bool IsGate(const Node& node) noexcept;
+  /// @brief Throws UngateableTransformException if a transform under a gate
+  /// cannot run on the selected frames.
+  void CheckGates() const;
+  /// @brief Sets Node::Gate and Node::GateIndex and collects the features
+  /// to scatter, see IndexNodes().
+  void AssignGates() noexcept;
+  /// @brief Tells each transform which elements of its output buffers
+  /// the children read, see Transform::set_used_elements(). The features
+  /// are used entirely.
+  void PropagateUsedElements() noexcept;
+  /// @brief Moves the features of the selected frames back to their
+  /// positions and fills the skipped ones, innermost gate first.
+  void ScatterGated(ExecutionContext* context) const noexcept;
+  /// @brief The features and their nodes which are passed to the sink
+  /// together.
+  typedef std::vector<std::pair<std::string, const Node*>> SinkList;
+  /// @brief Passes the features to the sink of the context, see
+  /// set_feature_sink().
+  void Sink(const SinkList& features,
+            const ExecutionContext* context) const noexcept;
+  /// @brief Indicates whether the node is a leaf which is packed, see
+  /// packed_results(), or the parent of a dense view or of a padding child.
+  bool IsPacked(const Node& node) const noexcept;
+  /// @brief Returns the smallest power of two which fits the output buffer
+  /// of the node, so that the vectorized writes stay aligned.
+  static size_t PackedStride(const Node& node) noexcept;
+  static bool IsNarrowing(const Node& node) noexcept;
+  static bool IsWidening(const Node& node) noexcept;
+  /// @brief Substitutes the nodes from first to last (which must be
+  /// a single linear path) with a single node bound to fused.
+  void ReplaceChain(Node* first, Node* last,
+                    const std::shared_ptr<Transform>& fused);
+  /// @brief Adds a child of parent bound to fused, which takes over the
+  /// children and the features of last.
+  void GraftNode(Node* parent, Node* last,
+                 const std::shared_ptr<Transform>& fused);
+  /// @brief Removes the node from the children of its parent.
+  void DetachNode(Node* node, const std::string& fused_name);
+  /// @brief The bodies of Execute(in) and Execute(in, context), which run
+  /// the nodes selected by active_nodes_.
+  const std::unordered_map<std::string, std::shared_ptr<Buffers>>&
+  ExecuteActive(const void* in);
+  const std::unordered_map<std::string, std::shared_ptr<Buffers>>&
+  ExecuteActive(const void* in, ExecutionContext* context) const;
+  /// @brief Binds the input and the memory of the context, so that
+  /// the nodes can be executed with it.
+  void BindContext(const void* in, ExecutionContext* context) const;
+  void RunNodes(ExecutionContext* context) const noexcept;
+  /// @brief Executes the nodes from first up to, excluding, last in
+  /// the order of Node::Next, see ExecutionPipeline.
+  void RunStage(Node* first, Node* last,
+                ExecutionContext* context) const noexcept;
+  void UpdateTotalTimes(
+      const std::chrono::high_resolution_clock::duration& all,
+      TimersMap* timers) const noexcept;
+  /// @brief Sums the ticks of the nodes by transform name and adds "All"
+  /// and "Other". Returns an empty map if all is zero.
+  TimersMap Timers(
+      const std::vector<NodeCounters>& counters,
+      const std::chrono::high_resolution_clock::duration& all) const noexcept;
+  /// @brief Sums the counters of the clones into their original nodes.
+  std::unordered_map<const Node*, NodeCounters> OriginalNodesCounters(
+      const std::vector<NodeCounters>& counters) const noexcept;
+  std::vector<std::pair<std::string, NodeCounters>> NodeCountersReport(
+      const std::vector<NodeCounters>& counters) const noexcept;
+  /// @brief Numbers the nodes in the pre-order, resets counters_ and
+  /// rebuilds plan_. Must be called after any change of the nodes set.
+  void IndexNodes() noexcept;
+  /// @brief Fills plan_ and plan_children_ from the numbered nodes.
+  void BuildPlan() noexcept;
+  /// @brief Drops plan_ after the nodes set changes, so that ForEachNode()
+  /// walks the tree itself until the next IndexNodes().
+  void InvalidatePlan() noexcept;
+  /// @brief Calls action(Node&) for each node in the pre-order, through
+  /// plan_ if it is up to date, without the recursion and the children maps.
+  template <class F>
+  void ForEachNode(const F& action) const;
+  /// @brief Fills feature_nodes_, sinks_ and late_sinks_, see IndexNodes().
+  void IndexFeatureNodes() noexcept;
+  /// @brief Sets the nodes which the features depend on in active.
+  void ActivateFeatures(const std::vector<std::string>& features,
+                        std::vector<bool>* active) const;
+  /// @brief Makes the ParallelTransform nodes with little work serial,
+  /// see kParallelWorkThreshold.
+  void EstimateParallelism() noexcept;
+  /// @brief Returns whether the current execution validates the buffers
+  /// and advances validation_counter_.
+  bool SampleValidation() const noexcept;
+  /// @brief Revises the decisions of EstimateParallelism() by the measured
+  /// times of the nodes, see kParallelTimeThreshold.
+  void RefineParallelism(
+      const std::vector<NodeCounters>& counters) const noexcept;
+  /// @brief Switches the pairs of the StructOfArraysTransform producers and
+  /// consumers to the struct of arrays layout, see IndexNodes().
+  void AssignBuffersLayouts() noexcept;
+  /// @brief Returns true if the buffers of the node must stay in the array
+  /// of structs layout: they are a feature or they are dumped.
+  bool KeepsArrayOfStructs(const Node& node) const noexcept;
+  /// @brief Enables the non-temporal stores of the nodes chosen by
+  /// streaming_stores(), see IndexNodes().
+  void AssignStreamingStores() noexcept;
+  static std::chrono::high_resolution_clock::duration ReportBaseTime(
+      const TimersMap& timers) noexcept;
+  static std::unordered_map<std::string, float> TimeReport(
+      const TimersMap& timers) noexcept;
 
   void DismantleMemoryProtection() noexcept;
+  std::unique_ptr<memory_allocation::BuffersAllocator> CreateAllocator()
+      const;
+  /// @brief Borrows allocated_memory_ from MemoryPool after ReleaseMemory()
+  /// and points the buffers of the nodes to it.
+  void BindMemory();
+  /// @brief MemoryPool::Acquire() which throws
+  /// FailedToAllocateBuffersException.
+  static std::shared_ptr<void> AcquireMemory(size_t size);
+  /// @brief Zeroes the pinned buffers at the end of the memory block of
+  /// allocated_size_ bytes, see Node::Pinned.
+  void ClearPinnedMemory(void* memory) const noexcept;
+  /// @brief Returns the input laid out as channels_layout() kPlanar,
+  /// deinterleaving it into the buffer if needed.
+  const void* PlanarInput(const void* in,
+                          std::shared_ptr<void>* buffer) const noexcept;
+  /// @brief Returns the bytes of the sample if all the samples of
+  /// the input are the same and the execution may take the saved results,
+  /// see constant_input_shortcut(), otherwise the empty string.
+  std::string ConstantInputKey(const void* in,
+                               const ExecutionContext* context) const noexcept;
+  /// @brief Copies the results saved for the constant input into results.
+  /// @return false if they were not saved yet.
+  bool SubstituteConstantResults(
+      const std::string& key,
+      const std::vector<std::shared_ptr<Buffers>>& results) const;
+  /// @brief Saves the results of the constant input.
+  void SaveConstantResults(
+      const std::string& key,
+      const std::vector<std::shared_ptr<Buffers>>& results) const;
+  /// @brief Drops the saved results, since the tree calculates other ones.
+  void ClearConstantResults() const noexcept;
+  /// @brief Points the buffers of the root and of its views (see
+  /// ViewTransform) to the input, either the tree's or the context's.
+  void BindInput(const void* in, ExecutionContext* context) const noexcept;
   void ResetTimers() noexcept;
 
   static float ConvertDuration(
@@ -257,17 +1367,151 @@ class TransformTree : public Logger {
   /// @brief The continuous memory block containing all the buffers. It MUST
   /// go before root_ because of the memory protection scheme (mprotect).
   std::shared_ptr<void> allocated_memory_;
+  size_t allocated_size_;
+  /// @brief The trailing part of allocated_size_ taken by the pinned
+  /// buffers.
+  size_t pinned_size_;
+  /// @brief See MemoryUsage::Peak.
+  size_t peak_size_;
+  PrepareTimes prepare_times_;
   /// @brief The transform tree to extract the features.
   std::shared_ptr<Node> root_;
-  std::shared_ptr<formats::ArrayFormat16> root_format_;
+  std::shared_ptr<BufferFormat> root_format_;
+  size_t root_size_;
+  SampleType root_sample_type_;
   bool tree_is_prepared_;
+  /// @brief Incremented on each change of the features of the prepared tree.
+  size_t layout_version_;
   std::unordered_map<std::string, std::shared_ptr<Node>> features_;
+  /// @brief The keys of features_ in the order of AddFeature().
+  std::vector<std::string> feature_names_;
+  /// @brief The names of the features ever added, indexed by the ids of
+  /// InternFeature(). The ids are never reused, so Node::RelatedFeatures
+  /// stay valid after RemoveFeature().
+  std::vector<std::string> interned_features_;
+  std::unordered_map<std::string, size_t> feature_ids_;
+  /// @brief The nodes each feature depends on, indexed by Node::Id.
+  std::unordered_map<std::string, std::vector<bool>> feature_nodes_;
+  /// @brief The features which are final after each node, indexed by
+  /// Node::Id, see IndexFeatureNodes().
+  std::vector<SinkList> sinks_;
+  /// @brief The features which are final after ScatterGated().
+  SinkList late_sinks_;
+  FeatureSink feature_sink_;
+  /// @brief The nodes executed by the current Execute(in), see
+  /// ExecutionContext::active_nodes_.
+  std::vector<bool> active_nodes_;
+  /// @brief The arguments of AddFeature() calls in order, to rebuild
+  /// the tree in Load().
+  std::vector<std::pair<std::string,
+                        std::vector<std::pair<std::string, std::string>>>>
+      feature_chains_;
+  /// @brief The solution of the allocation problem, see Save().
+  std::vector<AllocationRecord> allocation_plan_;
   std::unordered_map<std::string, TransformCacheItem> transforms_cache_;
   bool cache_optimization_;
+  bool cache_autotuning_;
+  bool warm_up_;
+  size_t memory_budget_;
+  bool parallel_slices_;
+  ProfilingLevel profiling_level_;
+  /// @brief The counters of Execute(in), indexed by Node::Id.
+  std::vector<NodeCounters> counters_;
+  /// @brief The nodes in the pre-order, indexed by Node::Id, which
+  /// the bookkeeping walks instead of the recursive traversal of
+  /// the children maps. It is empty while the tree is being changed.
+  std::vector<PlanRecord> plan_;
+  /// @brief The indices of the children of each PlanRecord in plan_.
+  std::vector<int> plan_children_;
+  /// @brief The duration of the last Execute(in).
+  std::chrono::high_resolution_clock::duration all_time_;
+  std::shared_ptr<Profiler> profiler_;
   bool memory_protection_;
+  size_t memory_protection_period_;
+  /// @brief The number of Execute(in) calls since memory protection was
+  /// enabled, to sample memory_protection_period().
+  size_t protection_counter_;
+  /// @brief Indicates whether the current Execute(in) protects the leaves.
+  bool protect_execution_;
+  bool memory_guards_;
   bool validate_after_each_transform_;
+  size_t validation_period_;
+  /// @brief The number of the executions since validation was enabled,
+  /// to sample validation_period(). Execute(in, context) increments it
+  /// concurrently.
+  mutable std::atomic<size_t> validation_counter_;
+  /// @brief Indicates whether the current Execute(in) validates the buffers.
+  bool validate_execution_;
   bool dump_buffers_after_each_transform_;
+  std::shared_ptr<BufferCapture> capture_;
+  /// @brief The index of the current Execute(in) in the capture file.
+  uint64_t capture_execution_;
+  bool parallel_execution_;
+  bool fuse_transforms_;
+  bool streaming_stores_;
+  bool packed_results_;
+  bool constant_input_shortcut_;
+  /// @brief The maximal number of the different constant inputs whose
+  /// results are saved.
+  static constexpr size_t kMaxConstantInputs = 16;
+  /// @brief The results of the constant inputs in the order of
+  /// feature_names_, by the sample, see constant_input_shortcut().
+  mutable std::unordered_map<
+      std::string, std::shared_ptr<const std::vector<std::vector<char>>>>
+      constant_results_;
+  mutable std::mutex constant_results_mutex_;
+  mutable std::atomic<size_t> constant_input_hits_;
+  AllocationStrategy allocation_strategy_;
+  ExecutionOverrides execution_overrides_;
+  bool streaming_;
+  Accuracy accuracy_;
+  ChannelsLayout channels_layout_;
+  /// @brief The deinterleaved input of Execute(in).
+  std::shared_ptr<void> planar_input_;
+  /// @brief The value of Execute(in), rebuilt after the features change.
+  std::unordered_map<std::string, std::shared_ptr<Buffers>> results_;
+  /// @brief results_ in the order of FeatureNames().
+  std::vector<std::shared_ptr<Buffers>> indexed_results_;
+  /// @brief The selections of Execute(in), indexed by Node::GateIndex.
+  /// ScatterGated() resets them.
+  mutable std::vector<GateSelection> gate_selections_;
+  /// @brief The features under the gates which do not share the memory
+  /// with each other, see ScatterGated().
+  std::vector<const Node*> gated_results_;
+  bool realtime_;
+  /// @brief Indicates whether PrepareRealtime() has been called for
+  /// the current layout_version_ and memory.
+  bool realtime_prepared_;
+  size_t realtime_version_;
+  /// @brief The scratch memory of the transforms in the real-time mode,
+  /// see ScratchArena::FixedBlock.
+  std::shared_ptr<void> realtime_scratch_;
+  size_t realtime_scratch_size_;
+  size_t merged_nodes_count_;
+  size_t merged_bytes_;
+  std::vector<Equivalence> equivalences_;
+  size_t approximately_merged_nodes_count_;
+  /// @brief The sum of EstimatedWork() of the nodes counted by
+  /// approximately_merged_nodes_count().
+  float approximately_saved_work_;
+  /// @brief The feature being added shares an equivalent node, so its
+  /// following nodes are shared approximately as well.
+  bool approximate_chain_;
+  /// @brief The locks of the real-time memory. They are declared last, so
+  /// that they are released before the memory returns to MemoryPool.
+  std::vector<std::unique_ptr<MemoryLock>> memory_locks_;
 };
 
+template <class F>
+void TransformTree::ForEachNode(const F& action) const {
+  if (plan_.empty()) {
+    root_->ActionOnSubtree([&action](Node& node) { action(node); });
+    return;
+  }
+  for (auto& record : plan_) {
+    action(*record.Self);
+  }
+}
+
 }  // namespace sound_feature_extraction
 #endif  // SRC_TRANSFORM_TREE_H_
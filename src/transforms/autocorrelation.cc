@@ -29,61 +29,239 @@
  */
 
 #include "src/transforms/autocorrelation.h"
-#include <simd/arithmetic-inl.h>
-#include <simd/correlate.h>
-#include <fftf/api.h>
-#include <mutex>
+#include <algorithm>
+#include <cmath>
+#include <simd/memory.h>
+#ifdef SIMD_X86
+#include <immintrin.h>
+#elif defined(SIMD_NEON)
+#include <arm_neon.h>
+#endif
+#include "src/fftf_wisdom.h"
 
 namespace sound_feature_extraction {
 namespace transforms {
 
-Autocorrelation::Autocorrelation() : normalize_(kDefaultNormalize) {
+constexpr int Autocorrelation::kBatchSize;
+constexpr int Autocorrelation::kMaxBatchFloats;
+constexpr int Autocorrelation::kDirectCostRatio;
+
+Autocorrelation::Autocorrelation()
+    : normalize_(kDefaultNormalize), lags_(kDefaultLags), fft_length_(0),
+      batch_size_(1), direct_(false) {
 }
 
 ALWAYS_VALID_TP(Autocorrelation, normalize)
 
-void Autocorrelation::Initialize() const {
-  // Workaround for SIGSEGV in libav FFT with sizes greater than 2^16
-  if (input_format_->Size() > 32768) {
-    fftf_set_backend_priority(FFTF_BACKEND_LIBAV, -1000);
-    fftf_set_backend(FFTF_BACKEND_NONE);
+bool Autocorrelation::validate_lags(const int& value) noexcept {
+  return value >= 0;
+}
+
+Autocorrelation::Batch::Batch(int length, int count)
+    : Frames(mallocf(length * count), std::free),
+      Spectra(mallocf((length + 2) * count), std::free),
+      FramePtrs(count), SpectrumPtrs(count) {
+  memsetf(Frames.get(), 0, length * count);
+  for (int i = 0; i < count; i++) {
+    FramePtrs[i] = Frames.get() + i * length;
+    SpectrumPtrs[i] = Spectra.get() + i * (length + 2);
   }
-  correlation_handles_.resize(threads_number());
-  for (int i = 0; i < threads_number(); i++) {
-    correlation_handles_[i].handle = std::shared_ptr<CrossCorrelationHandle>(
-        new CrossCorrelationHandle(cross_correlate_initialize(
-            input_format_->Size(), input_format_->Size())),
-        [](CrossCorrelationHandle *ptr) {
-          cross_correlate_finalize(*ptr);
-          delete ptr;
-        });
+  auto backend = FFTFWisdom::Instance().Select(
+      FFTF_TYPE_REAL, FFTF_DIRECTION_FORWARD, length, count);
+  Forward = std::shared_ptr<FFTFInstance>(
+      fftf_init_batch(FFTF_TYPE_REAL, FFTF_DIRECTION_FORWARD,
+                      FFTF_DIMENSION_1D, &length, FFTF_NO_OPTIONS, count,
+                      const_cast<const float* const*>(FramePtrs.data()),
+                      SpectrumPtrs.data()),
+      fftf_destroy);
+  Inverse = std::shared_ptr<FFTFInstance>(
+      fftf_init_batch(FFTF_TYPE_REAL, FFTF_DIRECTION_BACKWARD,
+                      FFTF_DIMENSION_1D, &length, FFTF_NO_OPTIONS, count,
+                      const_cast<const float* const*>(SpectrumPtrs.data()),
+                      FramePtrs.data()),
+      fftf_destroy);
+}
+
+void Autocorrelation::Initialize() const {
+  if (direct_) {
+    return;
   }
+  int length = fft_length_, count = batch_size_;
+  batches_.Reset(threads_number(), [length, count]() {
+    return std::make_shared<Batch>(length, count);
+  });
 }
 
 size_t Autocorrelation::OnFormatChanged(size_t buffersCount) {
-  output_format_->SetSize(input_format_->Size() * 2 - 1);
+  int size = input_format_->Size();
+  if (lags_ > size) {
+    throw InvalidParameterValueException("lags", std::to_string(lags_),
+                                         HostName());
+  }
+  output_format_->SetSize(lags_ > 0? lags_ : size * 2 - 1);
+  // The linear correlation requires at least 2 * size - 1 points
+  fft_length_ = 1;
+  while (fft_length_ < size * 2 - 1) {
+    fft_length_ <<= 1;
+  }
+  direct_ = lags_ > 0 && static_cast<float>(lags_) * size <=
+      kDirectCostRatio * fft_length_ * log2f(fft_length_);
+  batch_size_ = std::max(1, std::min(
+      std::min(kBatchSize, kMaxBatchFloats / (fft_length_ * 2 + 2)),
+      static_cast<int>(buffersCount)));
   return buffersCount;
 }
 
-void Autocorrelation::Do(const float* in, float* out) const noexcept {
-  bool executed = false;
-  while (!executed) {
-    for (auto& hp : correlation_handles_) {
-      if (hp.mutex.try_lock()) {
-        cross_correlate(*hp.handle, in, in, out);
-        hp.mutex.unlock();
-        if (normalize_) {
-          float norm = 1 / out[input_format_->Size() - 1];
-          real_multiply_scalar(out, output_format_->Size(), norm, out);
+typedef float (*DotKernel)(const float* x, const float* y, int length);
+
+static float DotScalar(const float* x, const float* y, int length) {
+  float sum = 0;
+  for (int i = 0; i < length; i++) {
+    sum += x[i] * y[i];
+  }
+  return sum;
+}
+
+#ifdef SIMD_X86
+SIMD_TARGET("avx")
+static float DotAVX(const float* x, const float* y, int length) {
+  int vectorized = length & ~7;
+  __m256 acc = _mm256_setzero_ps();
+  for (int i = 0; i < vectorized; i += 8) {
+    acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(x + i),
+                                           _mm256_loadu_ps(y + i)));
+  }
+  __m128 half = _mm_add_ps(_mm256_castps256_ps128(acc),
+                           _mm256_extractf128_ps(acc, 1));
+  half = _mm_hadd_ps(half, half);
+  half = _mm_hadd_ps(half, half);
+  float sum = _mm_cvtss_f32(half);
+  for (int i = vectorized; i < length; i++) {
+    sum += x[i] * y[i];
+  }
+  return sum;
+}
+
+SIMD_TARGET_AVX512
+static float DotAVX512(const float* x, const float* y, int length) {
+  int vectorized = length & ~15;
+  __m512 acc = _mm512_setzero_ps();
+  for (int i = 0; i < vectorized; i += 16) {
+    acc = _mm512_fmadd_ps(_mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i),
+                          acc);
+  }
+  float sum = _mm512_reduce_add_ps(acc);
+  for (int i = vectorized; i < length; i++) {
+    sum += x[i] * y[i];
+  }
+  return sum;
+}
+#elif defined(SIMD_NEON)
+static float DotNEON(const float* x, const float* y, int length) {
+  int vectorized = length & ~3;
+  float32x4_t acc = vdupq_n_f32(0);
+  for (int i = 0; i < vectorized; i += 4) {
+    acc = vmlaq_f32(acc, vld1q_f32(x + i), vld1q_f32(y + i));
+  }
+  float32x2_t half = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+  float sum = vget_lane_f32(vpadd_f32(half, half), 0);
+  for (int i = vectorized; i < length; i++) {
+    sum += x[i] * y[i];
+  }
+  return sum;
+}
+#endif
+
+static const SimdKernel<DotKernel> kDotKernels[] {
+#ifdef SIMD_X86
+  { InstructionSet::kAVX512, DotAVX512 },
+  { InstructionSet::kAVX, DotAVX },
+#elif defined(SIMD_NEON)
+  { InstructionSet::kNEON, DotNEON },
+#endif
+  { InstructionSet::kScalar, DotScalar }
+};
+
+InstructionSet Autocorrelation::SimdInstructionSet() const noexcept {
+  return direct_? SimdAware::Dispatch(kDotKernels).Isa :
+      SimdAware::SimdInstructionSet();
+}
+
+void Autocorrelation::DoDirect(const float* in, float* out) const noexcept {
+  int size = input_format_->Size();
+  auto dot = use_simd()? SimdAware::Dispatch(kDotKernels).Function
+                       : DotScalar;
+  for (int l = 0; l < lags_; l++) {
+    out[l] = dot(in, in + l, size - l);
+  }
+  if (normalize_) {
+    float norm = 1 / out[0];
+    for (int l = 0; l < lags_; l++) {
+      out[l] *= norm;
+    }
+  }
+}
+
+void Autocorrelation::Do(const BuffersBase<float*>& in,
+                         BuffersBase<float*>* out) const noexcept {
+  if (direct_) {
+    ParallelFor(in.Count(), [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        DoDirect(in[i], (*out)[i]);
+      }
+    });
+    return;
+  }
+  int size = input_format_->Size();
+  int length = fft_length_;
+  int batches = (in.Count() + batch_size_ - 1) / batch_size_;
+  ParallelFor(batches, [&](int begin, int end) {
+    for (int b = begin; b < end; b++) {
+      auto batch = batches_.Acquire();
+      int first = b * batch_size_;
+      int count = std::min(batch_size_, static_cast<int>(in.Count()) - first);
+      for (int i = 0; i < batch_size_; i++) {
+        float* frame = batch->FramePtrs[i];
+        if (i < count) {
+          memcpy(frame, in[first + i], size * sizeof(float));
+          memsetf(frame + size, 0, length - size);
+        } else {
+          memsetf(frame, 0, length);
+        }
+      }
+      fftf_calc(batch->Forward.get());
+      for (int i = 0; i < count; i++) {
+        float* spectrum = batch->SpectrumPtrs[i];
+        for (int k = 0; k < length + 2; k += 2) {
+          float re = spectrum[k], im = spectrum[k + 1];
+          spectrum[k] = re * re + im * im;
+          spectrum[k + 1] = 0;
+        }
+      }
+      fftf_calc(batch->Inverse.get());
+      for (int i = 0; i < count; i++) {
+        const float* lags = batch->FramePtrs[i];
+        // The inverse FFT is not normalized
+        float norm = normalize_? 1 / lags[0] : 1.f / length;
+        float* res = (*out)[first + i];
+        if (lags_ > 0) {
+          for (int l = 0; l < lags_; l++) {
+            res[l] = lags[l] * norm;
+          }
+          continue;
+        }
+        for (int l = 0; l < size; l++) {
+          float value = lags[l] * norm;
+          res[size - 1 + l] = value;
+          res[size - 1 - l] = value;
         }
-        executed = true;
-        break;
       }
     }
-  }
+  });
 }
 
 RTP(Autocorrelation, normalize)
+RTP(Autocorrelation, lags)
 REGISTER_TRANSFORM(Autocorrelation);
 
 }  // namespace transforms
@@ -31,17 +31,23 @@
 #ifndef SRC_TRANSFORMS_AUTOCORRELATION_H_
 #define SRC_TRANSFORMS_AUTOCORRELATION_H_
 
+#include <fftf/api.h>
 #include <vector>
-#include <mutex>
+#include "src/executor_pool.h"
 #include "src/transforms/common.h"
 
-typedef struct ConvolutionHandle CrossCorrelationHandle;
-
 namespace sound_feature_extraction {
 namespace transforms {
 
+/// @brief Calculates the full autocorrelation of each buffer through a
+/// batched FFT: the zero padded frames go through one forward RDFT plan,
+/// the spectra are replaced with the power spectra and one inverse plan
+/// gives the nonnegative lags. The plans are created once for the
+/// scratch memory of each thread. When only the first "lags" values are
+/// needed, e.g. by LPC, and their direct dot products are cheaper than
+/// the FFTs, they are calculated directly.
 class Autocorrelation
-    : public OmpUniformFormatTransform<formats::ArrayFormatF> {
+    : public UniformFormatOmpAwareTransform<formats::ArrayFormatF> {
  public:
   Autocorrelation();
 
@@ -52,29 +58,72 @@ class Autocorrelation
   TP(normalize, bool, kDefaultNormalize,
      "Calculate normalized autocorrelation by dividing each "
      "value by lag 0 result (squared signal sum).")
+  TP(lags, int, kDefaultLags,
+     "The number of the calculated nonnegative lags, starting from 0. "
+     "0 means the whole symmetric autocorrelation of 2 * size - 1 values.")
 
   void Initialize() const override;
 
+  virtual InstructionSet SimdInstructionSet() const noexcept override;
+
+  /// @brief Two FFTs per buffer or a dot product per lag.
+  virtual float ElementCost() const noexcept override {
+    return direct_? 2 : 16;
+  }
+
+  /// @brief Indicates whether the lags are calculated without FFT.
+  bool direct() const noexcept {
+    return direct_;
+  }
+
+  virtual Overlap RequiredOverlap(const Overlap& output)
+      const noexcept override {
+    return output;
+  }
+
+  /// @brief Returns how often Do() had to wait for a free batch.
+  ExecutorPoolStatistics handles_statistics() const noexcept {
+    return batches_.Statistics();
+  }
+
  protected:
   virtual size_t OnFormatChanged(size_t buffersCount) override;
 
-  virtual void Do(const float* in, float* out) const noexcept override;
+  virtual void Do(const BuffersBase<float*>& in,
+                  BuffersBase<float*>* out) const noexcept override;
 
   static constexpr bool kDefaultNormalize = false;
+  static constexpr int kDefaultLags = 0;
+  /// @brief The direct calculation is chosen if lags * size does not
+  /// exceed this number times fft_length * log2(fft_length).
+  static constexpr int kDirectCostRatio = 4;
+  /// @brief The maximal number of frames transformed by the same plan.
+  static constexpr int kBatchSize = 64;
+  /// @brief The maximal number of floats in the scratch of a single batch.
+  static constexpr int kMaxBatchFloats = 1 << 20;
 
  private:
-  struct SyncHandle {
-    SyncHandle() : handle(nullptr, std::free) {
-    }
-
-    SyncHandle(const SyncHandle&) : handle(nullptr, std::free) {
-    }
-
-    std::shared_ptr<CrossCorrelationHandle> handle;
-    std::mutex mutex;
+  /// @brief The scratch memory and the FFTF plans bound to it.
+  struct Batch {
+    Batch(int length, int count);
+
+    /// @brief count zero padded frames of the FFT length.
+    FloatPtr Frames;
+    /// @brief count spectra of (length + 2) floats.
+    FloatPtr Spectra;
+    std::vector<float*> FramePtrs;
+    std::vector<float*> SpectrumPtrs;
+    std::shared_ptr<FFTFInstance> Forward;
+    std::shared_ptr<FFTFInstance> Inverse;
   };
 
-  mutable std::vector<SyncHandle> correlation_handles_;
+  /// @brief Calculates the lags of a single buffer with dot products.
+  void DoDirect(const float* in, float* out) const noexcept;
+
+  mutable ExecutorPool<Batch> batches_;
+  int fft_length_;
+  int batch_size_;
+  bool direct_;
 };
 
 }  // namespace transforms
@@ -31,9 +31,13 @@
 #include "src/transforms/beat.h"
 #include <algorithm>
 #include <cmath>
+#include <simd/correlate.h>
 #include <simd/detect_peaks.h>
-#include "src/make_unique.h"
-#include "src/primitives/energy.h"
+#include <fftf/api.h>
+#include "src/cancellation.h"
+#include "src/fftf_wisdom.h"
+#include "src/primitives/window.h"
+#include "src/scratch_arena.h"
 
 namespace sound_feature_extraction {
 namespace transforms {
@@ -46,6 +50,7 @@ RTP(Beat, resolution1)
 RTP(Beat, resolution2)
 RTP(Beat, peaks)
 RTP(Beat, debug)
+RTP(Beat, decimate)
 
 Beat::Beat()
     : bands_(kDefaultBands),
@@ -55,10 +60,13 @@ Beat::Beat()
       resolution1_(kDefaultResolution1),
       resolution2_(kDefaultResolution2),
       peaks_(kDefaultPeaks),
-      debug_(kDefaultDebug) {
+      debug_(kDefaultDebug),
+      decimate_(kDefaultDecimate),
+      decimation_(1) {
 }
 
 ALWAYS_VALID_TP(Beat, debug)
+ALWAYS_VALID_TP(Beat, decimate)
 
 bool Beat::validate_bands(const int& value) noexcept {
   return value >= 1;
@@ -92,22 +100,78 @@ size_t Beat::PulsesLength(int pulses_count, int period) noexcept {
   return (pulses_count - 1) * period + 1;
 }
 
+int Beat::decimation() const noexcept {
+  return decimation_;
+}
+
+size_t Beat::LagsSize() const noexcept {
+  return (input_format_->Size() + decimation_ - 1) / decimation_;
+}
+
+void Beat::Decimate(const float* in, float* out) const noexcept {
+  int size = input_format_->Size();
+  int half = decimation_filter_.size() / 2;
+  const float* filter = decimation_filter_.data() + half;
+  for (int i = 0, center = 0; center < size; i++, center += decimation_) {
+    int first = std::max(-half, -center);
+    int last = std::min(half, size - 1 - center);
+    float sum = 0;
+    for (int k = first; k <= last; k++) {
+      sum += filter[k] * in[center + k];
+    }
+    out[i] = sum;
+  }
+}
+
 size_t Beat::OnInputFormatChanged(size_t buffersCount) {
   output_format_->SetSize(peaks_);
   return buffersCount / bands_;
 }
 
 void Beat::Initialize() const {
-  float max_period = floorf(60 * input_format_->SamplingRate() / min_bpm_);
-  size_t max_pulses_length = PulsesLength(pulses_, max_period);
-
-  int count = threads_number();
-  buffers_.resize(count);
-  for (int i = 0; i < count; i++) {
-    buffers_[i].data = std::uniquify(mallocf(
-        (this->input_format_->Size() + max_pulses_length - 1) * sizeof(float)),
-        std::free);
+  decimation_ = 1;
+  decimation_filter_.clear();
+  if (decimate_) {
+    float step = std::min(resolution1_, resolution2_);
+    float bpm = std::max(min_bpm_, max_bpm_);
+    // 60 is the number of seconds in one minute
+    float rate = bpm * (bpm + step) / (60 * step);
+    decimation_ = std::max(1, static_cast<int>(
+        floorf(input_format_->SamplingRate() / rate)));
   }
+  if (decimation_ > 1) {
+    int half = kDecimationTaps * decimation_;
+    int length = 2 * half + 1;
+    decimation_filter_.resize(length);
+    double sum = 0;
+    for (int i = 0; i < length; i++) {
+      double x = static_cast<double>(i - half) / decimation_;
+      double sinc = x == 0? 1 : sin(M_PI * x) / (M_PI * x);
+      decimation_filter_[i] = sinc * WindowElement(
+          WindowType::kWindowTypeHamming, length, i);
+      sum += decimation_filter_[i];
+    }
+    for (auto& tap : decimation_filter_) {
+      tap /= sum;
+    }
+  }
+  size_t size = LagsSize();
+  correlators_.Reset(threads_number(), [size]() {
+    // The cross-correlation plans its FFT of the doubled size with
+    // the current backend
+    auto backend = FFTFWisdom::Instance().Select(
+        FFTF_TYPE_REAL, FFTF_DIRECTION_FORWARD, size * 2, 1);
+    return std::make_shared<Correlator>(size);
+  });
+}
+
+Beat::Correlator::Correlator(size_t size)
+    : Handle(new CrossCorrelationHandle(
+                 cross_correlate_initialize(size, size)),
+             [](CrossCorrelationHandle *ptr) {
+               cross_correlate_finalize(*ptr);
+               delete ptr;
+             }) {
 }
 
 void Beat::CombConvolve(const float* in, size_t size, int pulses,
@@ -138,109 +202,132 @@ void Beat::CombConvolve(const float* in, size_t size, int pulses,
   }
 }
 
+float Beat::CombEnergy(const float* lags, size_t size, int pulses,
+                       int period) noexcept {
+  double energy = static_cast<double>(pulses) * lags[0];
+  for (int d = 1; d < pulses && static_cast<size_t>(d * period) < size;
+       d++) {
+    energy += 2.0 * (pulses - d) * lags[d * period];
+  }
+  return energy;
+}
+
 void Beat::Do(const BuffersBase<float*>& in,
               BuffersBase<formats::FixedArray<2>*>* out)
     const noexcept {
-#ifdef HAVE_OPENMP
-  #pragma omp parallel for num_threads(threads_number())
-#endif
-  for (size_t ini = 0; ini < in.Count(); ini += bands_) {
-    std::vector<float> energies;
-
-    // First pass - rough peaks estimation
-    CalculateBeatEnergies(in, ini, min_bpm_, max_bpm_, resolution1_, &energies);
-
-    // Output the energies for the reference
-    if (debug_) {
-      std::string dump("----Energies----\n");
-      for (size_t i = 0; i < energies.size(); i++) {
-        dump += std::to_string(energies[i]) + "    ";
-        if (i % 10 == 0 && i > 0) {
-          dump += '\n';
+  size_t groups = (in.Count() + bands_ - 1) / bands_;
+  ParallelFor(groups, [&](size_t begin, size_t end) {
+    for (size_t ini = begin * bands_; ini < end * bands_; ini += bands_) {
+      // Each group takes milliseconds on the long inputs
+      if (ExecutionCancelled()) {
+        return;
+      }
+      std::vector<float> energies;
+      auto lags_lease = ScratchArena::Acquire(LagsSize());
+      float* lags = lags_lease.get();
+      CalculateLags(in, ini, (*correlators_.Acquire()).get(), lags);
+
+      // First pass - rough peaks estimation
+      CalculateBeatEnergies(lags, min_bpm_, max_bpm_, resolution1_, &energies);
+
+      // Output the energies for the reference
+      if (debug_) {
+        std::string dump("----Energies----\n");
+        for (size_t i = 0; i < energies.size(); i++) {
+          dump += std::to_string(energies[i]) + "    ";
+          if (i % 10 == 0 && i > 0) {
+            dump += '\n';
+          }
         }
+        INF("%s\n----\n", dump.c_str());
       }
-      INF("%s\n----\n", dump.c_str());
-    }
 
-    // Find maximums and sort them
-    ExtremumPoint* results;
-    size_t found_peaks_count;
-    detect_peaks(use_simd(), energies.data(), energies.size(),
-                 kExtremumTypeMaximum, &results, &found_peaks_count);
-    if (results == nullptr) {
-      for (int i = 0; i < peaks_; i++) {
-        (*out)[ini / bands_][i][0] = 0;
-        (*out)[ini / bands_][i][1] = 0;
+      // Find maximums and sort them
+      ExtremumPoint* results;
+      size_t found_peaks_count;
+      detect_peaks(use_simd(), energies.data(), energies.size(),
+                   kExtremumTypeMaximum, &results, &found_peaks_count);
+      if (results == nullptr) {
+        for (int i = 0; i < peaks_; i++) {
+          (*out)[ini / bands_][i][0] = 0;
+          (*out)[ini / bands_][i][1] = 0;
+        }
+        continue;
+      }
+      std::sort(results, results + found_peaks_count,
+                [](const ExtremumPoint& f, const ExtremumPoint& s) {
+                  return f.value > s.value;
+                });
+      int rcount = static_cast<int>(found_peaks_count) > peaks_?
+          peaks_ : found_peaks_count;
+      std::sort(results, results + rcount,
+                [](const ExtremumPoint& f, const ExtremumPoint& s) {
+                  return f.position < s.position;
+                });
+
+      // Second pass - increase peaks precision
+      for (int pind = 0; pind < rcount; pind++) {
+        auto position = results[pind].position;
+        CalculateBeatEnergies(lags,
+                              min_bpm_ + (position - 1) * resolution1_,
+                              min_bpm_ + (position + 1) * resolution1_,
+                              resolution2_, &energies,
+                              &(*out)[ini / bands_][pind][0],
+                              &(*out)[ini / bands_][pind][1]);
       }
-      continue;
+      for (int pind = rcount; pind < peaks_; pind++) {
+        (*out)[ini / bands_][pind][0] = 0;
+        (*out)[ini / bands_][pind][1] = 0;
+      }
+      free(results);
     }
-    std::sort(results, results + found_peaks_count,
-              [](const ExtremumPoint& f, const ExtremumPoint& s) {
-                return f.value > s.value;
-              });
-    int rcount = static_cast<int>(found_peaks_count) > peaks_?
-        peaks_ : found_peaks_count;
-    std::sort(results, results + rcount,
-              [](const ExtremumPoint& f, const ExtremumPoint& s) {
-                return f.position < s.position;
-              });
-
-    // Second pass - increase peaks precision
-    for (int pind = 0; pind < rcount; pind++) {
-      CalculateBeatEnergies(in, ini,
-                            min_bpm_ + (results[pind].position-1)*resolution1_,
-                            min_bpm_ + (results[pind].position+1)*resolution1_,
-                            resolution2_, &energies,
-                            &(*out)[ini / bands_][pind][0],
-                            &(*out)[ini / bands_][pind][1]);
+  });
+}
+
+void Beat::CalculateLags(const BuffersBase<float*>& in, size_t inIndex,
+                         Correlator* correlator, float* lags) const noexcept {
+  size_t size = LagsSize();
+  // The full autocorrelation of a single band
+  auto scratch = ScratchArena::Acquire(size * 2 - 1);
+  float* buffer = scratch.get();
+  auto decimated_lease = ScratchArena::Acquire(
+      decimation_ > 1? size : 0);
+  float* decimated = decimated_lease.get();
+  memset(lags, 0, size * sizeof(lags[0]));
+  for (size_t i = inIndex; i < inIndex + bands_ && i < in.Count(); i++) {
+    const float* band = in[i];
+    if (decimation_ > 1) {
+      Decimate(band, decimated);
+      band = decimated;
     }
-    for (int pind = rcount; pind < peaks_; pind++) {
-      (*out)[ini / bands_][pind][0] = 0;
-      (*out)[ini / bands_][pind][1] = 0;
+    cross_correlate(*correlator->Handle, band, band, buffer);
+    for (size_t l = 0; l < size; l++) {
+      lags[l] += buffer[size - 1 + l];
     }
-    free(results);
   }
 }
 
-void Beat::CalculateBeatEnergies(const BuffersBase<float*>& in, size_t inIndex,
-                                 float min_bpm, float max_bpm, float step,
+void Beat::CalculateBeatEnergies(const float* lags, float min_bpm,
+                                 float max_bpm, float step,
                                  std::vector<float>* energies,
                                  float* max_energy_bpm_found,
                                  float* max_energy_found) const noexcept {
-  auto size = this->input_format_->Size();
+  auto size = LagsSize();
+  float rate = static_cast<float>(input_format_->SamplingRate()) /
+      decimation_;
   int search_size = floorf((max_bpm - min_bpm) / step);
   energies->resize(search_size);
   float max_energy = 0;
   float max_energy_bpm = min_bpm;
-
-  bool executed = false;
-  while (!executed) {
-    for (auto& tsbuf : buffers_) {
-      if (tsbuf.mutex.try_lock()) {
-        auto buffer = tsbuf.data.get();
-        for (int i = 0; i < search_size; i++) {
-          float bpm = min_bpm + step * i;
-          // 60 is the number of seconds in one minute
-          int period = floorf(60 * input_format_->SamplingRate() / bpm);
-          float current_energy = 0;
-          size_t conv_length = size + PulsesLength(pulses_, period) - 1;
-          for (size_t i = inIndex;
-              i < inIndex + bands_ && i < in.Count();
-              i++) {
-            CombConvolve(in[i], size, pulses_, period, buffer);
-            current_energy += calculate_energy(Beat::use_simd(), false, buffer,
-                                               conv_length);
-          }
-          (*energies)[i] = current_energy;
-          if (current_energy > max_energy) {
-            max_energy = current_energy;
-            max_energy_bpm = bpm;
-          }
-        }
-        tsbuf.mutex.unlock();
-        executed = true;
-        break;
-      }
+  for (int i = 0; i < search_size; i++) {
+    float bpm = min_bpm + step * i;
+    // 60 is the number of seconds in one minute
+    int period = floorf(60 * rate / bpm);
+    float current_energy = CombEnergy(lags, size, pulses_, period);
+    (*energies)[i] = current_energy;
+    if (current_energy > max_energy) {
+      max_energy = current_energy;
+      max_energy_bpm = bpm;
     }
   }
 
@@ -34,13 +34,25 @@
 #include <mutex>
 #include <tuple>
 #include <vector>
+#include "src/executor_pool.h"
 #include "src/formats/fixed_array.h"
 #include "src/formats/single_format.h"
 #include "src/transforms/common.h"
 
+typedef struct ConvolutionHandle CrossCorrelationHandle;
+
 namespace sound_feature_extraction {
 namespace transforms {
 
+/// @brief Finds the tempo as the periods of the pulse trains (combs) which
+/// produce the most energy when convolved with the envelopes of the bands.
+/// @details The energy of the convolution with a comb of P pulses and
+/// period T is a weighted sum of the autocorrelation R at the lags dT:
+/// P R(0) + 2 sum over d in [1, P) of (P - d) R(dT). So the envelopes are
+/// autocorrelated once through FFT and every candidate period costs O(P)
+/// instead of a full convolution. Beforehand the envelopes are lowpass
+/// filtered and decimated to the lowest rate at which the periods of
+/// the adjacent bpm steps still differ, see decimation().
 class Beat
     : public OmpAwareTransform<formats::ArrayFormatF,
                                formats::ArrayFormat<formats::FixedArray<2>>>,
@@ -61,6 +73,9 @@ class Beat
   TP(peaks, int, kDefaultPeaks,
      "The number of the most significant peaks to record.")
   TP(debug, bool, kDefaultDebug, "Dump the resulting energy vectors.")
+  TP(decimate, bool, kDefaultDecimate,
+     "Decimate the envelopes to the lowest rate which still resolves "
+     "resolution1 and resolution2 at max_bpm.")
 
   virtual bool BufferInvariant() const noexcept override final {
     return false;
@@ -68,6 +83,18 @@ class Beat
 
   virtual void Initialize() const override;
 
+  /// @brief The factor by which the envelopes are decimated, 1 if they are
+  /// not. A period of T seconds at bpm b changes by about T * step / b
+  /// between the bpm steps, so the rate must be at least
+  /// b (b + step) / (60 step) for the finest of resolution1 and resolution2
+  /// and the highest b.
+  int decimation() const noexcept;
+
+  /// @brief Each buffer is cross-correlated and scanned for every bpm.
+  virtual float ElementCost() const noexcept override {
+    return 64;
+  }
+
  protected:
   virtual size_t OnInputFormatChanged(size_t buffersCount) override;
 
@@ -78,11 +105,31 @@ class Beat
   static void CombConvolve(const float* in, size_t size, int pulses,
                            int period, float* out) noexcept;
 
+  /// @brief Calculates the energy of CombConvolve() output.
+  /// @param lags The autocorrelation of the input, [0...size) lags.
+  static float CombEnergy(const float* lags, size_t size, int pulses,
+                          int period) noexcept;
+
  private:
+  /// @brief The per-thread autocorrelation state.
+  struct Correlator {
+    explicit Correlator(size_t size);
+
+    std::shared_ptr<CrossCorrelationHandle> Handle;
+  };
+
   static size_t PulsesLength(int pulses_count, int period) noexcept;
-  void CalculateBeatEnergies(const BuffersBase<float*>& in, size_t inIndex,
-                             float min_bpm, float max_bpm, float step,
-                             std::vector<float>* energies,
+  /// @brief The size of the decimated envelopes and their autocorrelation.
+  size_t LagsSize() const noexcept;
+  /// @brief Applies decimation_filter_ to in and takes every
+  /// decimation_-th sample; the filter is centered, so there is no delay.
+  void Decimate(const float* in, float* out) const noexcept;
+  /// @brief Sums the autocorrelations of in[inIndex...inIndex + bands_)
+  /// into the nonnegative lags.
+  void CalculateLags(const BuffersBase<float*>& in, size_t inIndex,
+                     Correlator* correlator, float* lags) const noexcept;
+  void CalculateBeatEnergies(const float* lags, float min_bpm, float max_bpm,
+                             float step, std::vector<float>* energies,
                              float* max_energy_bpm_found = nullptr,
                              float* max_energy_found = nullptr) const noexcept;
 
@@ -94,8 +141,16 @@ class Beat
   static constexpr float kDefaultResolution2 = 0.1f;
   static constexpr int kDefaultPeaks = 3;
   static constexpr bool kDefaultDebug = false;
+  static constexpr bool kDefaultDecimate = true;
+  /// @brief The number of the lowpass filter taps per the decimation factor.
+  static constexpr int kDecimationTaps = 8;
 
-  mutable std::vector<ThreadSafeFloatPtr> buffers_;
+  mutable ExecutorPool<Correlator> correlators_;
+  /// @brief See decimation().
+  mutable int decimation_;
+  /// @brief The windowed sinc with the cutoff at the decimated Nyquist
+  /// frequency, 2 * kDecimationTaps * decimation_ + 1 taps.
+  mutable std::vector<float> decimation_filter_;
 };
 
 }  // namespace transforms
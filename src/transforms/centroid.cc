@@ -30,19 +30,23 @@
 
 #include "src/transforms/centroid.h"
 #include <simd/instruction_set.h>
+#include "src/fixed_length.h"
 
 namespace sound_feature_extraction {
 namespace transforms {
 
+Centroid::Centroid() : kernel_(Do) {
+}
+
 void Centroid::Do(const float* in,
                   float* out) const noexcept {
-  *out = Do(use_simd(), in, input_format_->Size()) /
+  *out = kernel_(use_simd(), in, input_format_->Size()) /
       input_format_->Duration();
 }
 
-float Centroid::Do(bool simd, const float* input, size_t length)
-    noexcept {
-  int ilength = length;
+template <int kLength>
+static float CentroidKernel(bool simd, const float* input, size_t length) {
+  int ilength = FIXED_LENGTH(kLength, length);
   if (simd) {
 #ifdef __AVX__
     __m256 upperSums = _mm256_setzero_ps(), lowerSums = _mm256_setzero_ps();
@@ -124,6 +128,17 @@ float Centroid::Do(bool simd, const float* input, size_t length)
   }
 }
 
+float Centroid::Do(bool simd, const float* input, size_t length)
+    noexcept {
+  return CentroidKernel<0>(simd, input, length);
+}
+
+void Centroid::Initialize() const {
+  kernel_ = [](int length) -> Kernel {
+    SELECT_FIXED_LENGTH(CentroidKernel, length)
+  }(input_format_->Size());
+}
+
 REGISTER_TRANSFORM(Centroid);
 
 }  // namespace transforms
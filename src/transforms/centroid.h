@@ -42,15 +42,25 @@ namespace transforms {
 class Centroid : public OmpTransformBase<formats::ArrayFormatF,
                                          formats::SingleFormatF>  {
  public:
+  Centroid();
+
   TRANSFORM_INTRO("Centroid", "Window's center of mass in frequency domain "
                               "calculation.",
                   Centroid)
 
+  /// @brief Picks the kernel specialized for the input length, if any.
+  virtual void Initialize() const override;
+
  protected:
   virtual void Do(const float* in,
                   float* out) const noexcept override;
 
   static float Do(bool simd, const float* input, size_t length) noexcept;
+
+ private:
+  typedef float (*Kernel)(bool simd, const float* input, size_t length);
+
+  mutable Kernel kernel_;
 };
 
 }  // namespace transforms
@@ -0,0 +1,109 @@
+/*! @file cepstrum.cc
+ *  @brief Fused filter bank, logarithm and truncated DCT.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+#include "src/transforms/cepstrum.h"
+#include <algorithm>
+#include <cassert>
+#include "src/scratch_arena.h"
+
+namespace sound_feature_extraction {
+namespace transforms {
+
+constexpr int Cepstrum::kFramesBlock;
+
+Cepstrum::Cepstrum(const std::shared_ptr<Transform>& bank,
+                   const std::shared_ptr<Transform>& log, int length)
+    : bank_(std::dynamic_pointer_cast<FilterBank>(bank)),
+      log_(std::dynamic_pointer_cast<LogRaw>(log)),
+      dct_(std::make_shared<DCT>()) {
+  assert(bank_ && log_);
+  dct_->set_length(length);
+}
+
+size_t Cepstrum::OnInputFormatChanged(size_t buffersCount) {
+  size_t count = bank_->SetInputFormat(input_format_, buffersCount);
+  count = log_->SetInputFormat(bank_->OutputFormat(), count);
+  count = dct_->SetInputFormat(log_->OutputFormat(), count);
+  output_format_->SetSize(dct_->length());
+  return count;
+}
+
+void Cepstrum::Initialize() const {
+  bank_->Initialize();
+  log_->Initialize();
+  dct_->Initialize();
+}
+
+size_t Cepstrum::PrivateMemorySize() const noexcept {
+  return bank_->PrivateMemorySize() + dct_->PrivateMemorySize();
+}
+
+ElementRange Cepstrum::RequiredElements(const ElementRange& output)
+    const noexcept {
+  return bank_->RequiredElements(output);
+}
+
+void Cepstrum::Do(const BuffersBase<float*>& in,
+                  BuffersBase<float*>* out) const noexcept {
+  int count = in.Count();
+  int bands = bank_->number();
+  auto& filters = bank_->filter_bank();
+  int blocks = (count + kFramesBlock - 1) / kFramesBlock;
+  ParallelFor(blocks, [&](int begin, int end) {
+    auto tile = ScratchArena::Acquire(kFramesBlock * bands);
+    const float* rows[kFramesBlock];
+    float* outs[kFramesBlock];
+    for (int i = 0; i < kFramesBlock; i++) {
+      rows[i] = tile.get() + i * bands;
+    }
+    for (int block = begin; block < end; block++) {
+      int first = block * kFramesBlock;
+      int frames = std::min(kFramesBlock, count - first);
+      // Each row of the filter bank is loaded once per tile
+      for (int index = 0; index < bands; index++) {
+        auto& filter = filters[index];
+        int length = filter.end - filter.begin + 1;
+        for (int frame = 0; frame < frames; frame++) {
+          tile.get()[frame * bands + index] = FilterBank::FilterEnergy(
+              use_simd(), in[first + frame] + filter.begin, filter.data,
+              length);
+        }
+      }
+      log_->DoElementwise(tile.get(), frames * bands, tile.get());
+      for (int frame = 0; frame < frames; frame++) {
+        outs[frame] = (*out)[first + frame];
+      }
+      dct_->DoTruncated(rows, outs, frames);
+    }
+  });
+}
+
+}  // namespace transforms
+}  // namespace sound_feature_extraction
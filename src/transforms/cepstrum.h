@@ -0,0 +1,93 @@
+/*! @file cepstrum.h
+ *  @brief Fused filter bank, logarithm and truncated DCT.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+#ifndef SRC_TRANSFORMS_CEPSTRUM_H_
+#define SRC_TRANSFORMS_CEPSTRUM_H_
+
+#include "src/transforms/dct.h"
+#include "src/transforms/filter_bank.h"
+#include "src/transforms/log.h"
+
+namespace sound_feature_extraction {
+namespace transforms {
+
+/// @brief Calculates the same as FilterBank -> Log -> DCT -> Selector
+/// (the tail of MFCC) without storing the band energies and the full DCT.
+/// @details TransformTree substitutes the matching chains with this
+/// transform (see TransformTree::set_fuse_transforms()). The energies of
+/// kFramesBlock frames are written to a tile which stays in L1, the log is
+/// taken from the whole tile at once and only the selected leading
+/// coefficients are calculated with the cosine matrix of DCT.
+/// @note This transform is not registered in the factory.
+class Cepstrum : public OmpAwareTransform<formats::ArrayFormatF,
+                                          formats::ArrayFormatF> {
+ public:
+  /// @param bank The FilterBank which starts the chain.
+  /// @param log The Log which follows it.
+  /// @param length The number of the leading coefficients of DCT which
+  /// Selector keeps.
+  Cepstrum(const std::shared_ptr<Transform>& bank,
+           const std::shared_ptr<Transform>& log, int length);
+
+  TRANSFORM_INTRO("Cepstrum", "Calculates the leading cepstral coefficients "
+                              "of the filter bank energies (FilterBank -> "
+                              "Log -> DCT -> Selector).",
+                  Cepstrum)
+
+  virtual void Initialize() const override;
+
+  virtual size_t PrivateMemorySize() const noexcept override;
+
+  virtual Overlap RequiredOverlap(const Overlap& output)
+      const noexcept override {
+    return output;
+  }
+
+  virtual ElementRange RequiredElements(const ElementRange& output)
+      const noexcept override;
+
+ protected:
+  /// @brief The number of frames in the tile.
+  static constexpr int kFramesBlock = 8;
+
+  virtual size_t OnInputFormatChanged(size_t buffersCount) override;
+
+  virtual void Do(const BuffersBase<float*>& in,
+                  BuffersBase<float*>* out) const noexcept override;
+
+ private:
+  std::shared_ptr<FilterBank> bank_;
+  std::shared_ptr<LogRaw> log_;
+  std::shared_ptr<DCT> dct_;
+};
+
+}  // namespace transforms
+}  // namespace sound_feature_extraction
+#endif  // SRC_TRANSFORMS_CEPSTRUM_H_
@@ -30,31 +30,61 @@
 
 #include "src/transforms/complex_magnitude.h"
 #include <cmath>
+#include <cstring>
 #ifdef __AVX__
 #include <simd/instruction_set.h>
 #elif defined(__ARM_NEON__)
 #include <simd/neon_mathfun.h>
 #endif
+#include "src/fixed_length.h"
+#include "src/transforms/unpack_rdft.h"
 
 namespace sound_feature_extraction {
 namespace transforms {
 
+constexpr bool ComplexMagnitude::kDefaultUnpacked;
+
+ComplexMagnitude::ComplexMagnitude()
+    : unpacked_(kDefaultUnpacked), kernel_(Do) {
+}
+
+ALWAYS_VALID_TP(ComplexMagnitude, unpacked)
+
 size_t ComplexMagnitude::OnFormatChanged(size_t buffersCount) {
   if (input_format_->Size() % 2 == 1) {
     WRN("Input buffer size is odd (%zu), truncated.\n",
         input_format_->Size());
   }
-  output_format_->SetSize(input_format_->Size() / 2);
+  if (unpacked_) {
+    output_format_->SetSize(input_format_->Size() / 2 * 2 - 2);
+  } else {
+    output_format_->SetSize(input_format_->Size() / 2);
+  }
   return buffersCount;
 }
 
 void ComplexMagnitude::Do(const float* in,
                           float* out) const noexcept {
-  Do(use_simd(), in, input_format_->Size(), out);
+  size_t size = output_format_->Size();
+  // The aligned loads and stores need the multiples of 8 bins
+  auto used = used_elements_.Align(size, 8);
+  if (!unpacked_ && (used.Begin > 0 || used.End < size)) {
+    Do(use_simd(), in + used.Begin * 2, (used.End - used.Begin) * 2,
+       out + used.Begin);
+    memset(out, 0, used.Begin * sizeof(float));
+    memset(out + used.End, 0, (size - used.End) * sizeof(float));
+    return;
+  }
+  kernel_(use_simd(), in, input_format_->Size(), out);
+  if (unpacked_) {
+    UnpackRDFT::Mirror(out, output_format_->Size());
+  }
 }
 
-void ComplexMagnitude::Do(bool simd, const float* input, int length,
-                          float* output) noexcept {
+template <int kLength>
+static void ComplexMagnitudeKernel(bool simd, const float* input, int length,
+                                   float* output) {
+  length = FIXED_LENGTH(kLength, length);
   if (simd) {
 #ifdef __AVX__
     for (int i = 0; i < length - 15; i += 16) {
@@ -108,6 +138,18 @@ void ComplexMagnitude::Do(bool simd, const float* input, int length,
   }
 }
 
+void ComplexMagnitude::Do(bool simd, const float* input, int length,
+                          float* output) noexcept {
+  ComplexMagnitudeKernel<0>(simd, input, length, output);
+}
+
+void ComplexMagnitude::Initialize() const {
+  kernel_ = [](int length) -> Kernel {
+    SELECT_FIXED_LENGTH(ComplexMagnitudeKernel, length)
+  }(input_format_->Size());
+}
+
+RTP(ComplexMagnitude, unpacked)
 REGISTER_TRANSFORM(ComplexMagnitude);
 
 }  // namespace transforms
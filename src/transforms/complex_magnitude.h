@@ -40,13 +40,25 @@ class ComplexMagnitude
     : public OmpUniformFormatTransform<formats::ArrayFormatF>,
       public TransformLogger<ComplexMagnitude> {
  public:
+  ComplexMagnitude();
+
   TRANSFORM_INTRO("ComplexMagnitude",
                   "Calculates the magnitude of each complex number, that is, "
                   " a square root of the sum of squared real and imaginary "
                   "parts.",
                   ComplexMagnitude)
 
+  TP(unpacked, bool, kDefaultUnpacked,
+     "The input is the packed RDFT spectrum and the magnitudes "
+     "of the whole spectrum are calculated, as if UnpackRDFT was applied "
+     "before.")
+
+  /// @brief Picks the kernel specialized for the input length, if any.
+  virtual void Initialize() const override;
+
  protected:
+  static constexpr bool kDefaultUnpacked = false;
+
   virtual size_t OnFormatChanged(size_t buffersCount) override;
 
   virtual void Do(const float* in,
@@ -54,6 +66,12 @@ class ComplexMagnitude
 
   static void Do(bool simd, const float* input, int length,
                  float* output) noexcept;
+
+ private:
+  typedef void (*Kernel)(bool simd, const float* input, int length,
+                         float* output);
+
+  mutable Kernel kernel_;
 };
 
 }  // namespace transforms
@@ -30,17 +30,32 @@
 
 #include "src/transforms/complex_to_real.h"
 #include <simd/instruction_set.h>
+#include "src/transforms/unpack_rdft.h"
 
 namespace sound_feature_extraction {
 namespace transforms {
 
+constexpr bool ComplexToReal::kDefaultUnpacked;
+
+ComplexToReal::ComplexToReal() : unpacked_(kDefaultUnpacked) {
+}
+
+ALWAYS_VALID_TP(ComplexToReal, unpacked)
+
 size_t ComplexToReal::OnFormatChanged(size_t buffersCount) {
-  output_format_->SetSize(input_format_->Size() / 2);
+  if (unpacked_) {
+    output_format_->SetSize(input_format_->Size() / 2 * 2 - 2);
+  } else {
+    output_format_->SetSize(input_format_->Size() / 2);
+  }
   return buffersCount;
 }
 
 void ComplexToReal::Do(const float* in, float* out) const noexcept {
   Do(use_simd(), in, input_format_->Size(), out);
+  if (unpacked_) {
+    UnpackRDFT::Mirror(out, output_format_->Size());
+  }
 }
 
 void ComplexToReal::Do(bool simd, const float* input, int length,
@@ -81,6 +96,7 @@ void ComplexToReal::Do(bool simd, const float* input, int length,
   }
 }
 
+RTP(ComplexToReal, unpacked)
 REGISTER_TRANSFORM(ComplexToReal);
 
 }  // namespace transforms
@@ -39,11 +39,20 @@ namespace transforms {
 class ComplexToReal : public OmpUniformFormatTransform<formats::ArrayFormatF> {
   friend class Subsampling;
  public:
+  ComplexToReal();
+
   TRANSFORM_INTRO("C2R", "Converts each complex number to corresponding "
                          "real numbers.",
                   ComplexToReal)
 
+  TP(unpacked, bool, kDefaultUnpacked,
+     "The input is the packed RDFT spectrum and the real parts "
+     "of the whole spectrum are calculated, as if UnpackRDFT was applied "
+     "before.")
+
  protected:
+  static constexpr bool kDefaultUnpacked = false;
+
   virtual size_t OnFormatChanged(size_t buffersCount) override;
 
   virtual void Do(const float* in, float* out) const noexcept override;
@@ -0,0 +1,261 @@
+/*! @file constant_q.cc
+ *  @brief Constant-Q transform with the precomputed sparse spectral kernel.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#include "src/transforms/constant_q.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <simd/arithmetic-inl.h>
+#include <simd/instruction_set.h>
+#include "src/transforms/filter_bank.h"
+#include "src/transforms/filter_base.h"
+#include "src/make_unique.h"
+#include "src/shared_state.h"
+
+namespace sound_feature_extraction {
+namespace transforms {
+
+constexpr int ConstantQ::kFramesBlock;
+constexpr float ConstantQ::kSparsityThreshold;
+
+ConstantQ::ConstantQ()
+    : bins_per_octave_(kDefaultBinsPerOctave),
+      frequency_min_(kDefaultMinFrequency),
+      frequency_max_(kDefaultMaxFrequency),
+      chroma_(kDefaultChroma) {
+}
+
+bool ConstantQ::validate_bins_per_octave(const int& value) noexcept {
+  return value >= 1 && value <= 96;
+}
+
+bool ConstantQ::validate_frequency_min(const float& value) noexcept {
+  return value > 0 && FilterBase<std::nullptr_t>::ValidateFrequency(value);
+}
+
+bool ConstantQ::validate_frequency_max(const float& value) noexcept {
+  return FilterBase<std::nullptr_t>::ValidateFrequency(value);
+}
+
+ALWAYS_VALID_TP(ConstantQ, chroma)
+
+const std::vector<ConstantQ::Kernel>& ConstantQ::kernels() const noexcept {
+  return kernels_;
+}
+
+int ConstantQ::BinsCount() const noexcept {
+  return floorf(bins_per_octave_ * log2f(frequency_max_ / frequency_min_)) +
+      1;
+}
+
+size_t ConstantQ::OnInputFormatChanged(size_t buffersCount) {
+  if (frequency_max_ < frequency_min_ ||
+      frequency_max_ > input_format_->SamplingRate() / 2) {
+    throw InvalidFrequencyRangeException(frequency_min_, frequency_max_);
+  }
+  output_format_->SetSize(chroma_? bins_per_octave_ : BinsCount());
+  return buffersCount;
+}
+
+void ConstantQ::Initialize() const {
+  auto kernels = SharedState<SharedKernels>(StateKey(), [this]() {
+    return CalculateKernels();
+  });
+  kernels_ = kernels->Kernels;
+  weights_ = kernels;
+}
+
+std::shared_ptr<const ConstantQ::SharedKernels>
+ConstantQ::CalculateKernels() const {
+  auto kernels = std::make_shared<SharedKernels>();
+  int count = BinsCount();
+  kernels->Kernels.resize(count);
+  // The frame length and the number of the RDFT bins
+  const int N = input_format_->Size() - 2;
+  const int bins = N / 2 + 1;
+  const float rate = input_format_->SamplingRate();
+  const double Q = 1 / (pow(2., 1. / bins_per_octave_) - 1);
+
+  std::vector<float> packed;
+  std::vector<size_t> offsets(count);
+  std::vector<double> re, im;
+  for (int k = 0; k < count; k++) {
+    double freq = frequency_min_ * pow(2., static_cast<double>(k) /
+                                       bins_per_octave_);
+    int length = std::min(static_cast<int>(ceil(Q * rate / freq)), N);
+    int start = (N - length) / 2;
+    // The Hamming window's main lobe spans 2 bins of the kernel length
+    // on each side, take the first sidelobes as well
+    double center = freq * N / rate;
+    double width = 4. * N / length + 2;
+    int first = std::max(0, static_cast<int>(floor(center - width)));
+    int last = std::min(bins - 1, static_cast<int>(ceil(center + width)));
+    re.assign(last - first + 1, 0);
+    im.assign(last - first + 1, 0);
+    double peak = 0;
+    for (int j = first; j <= last; j++) {
+      // DFT of the temporal kernel w(n) / length * exp(2 pi i freq n / rate)
+      // placed at the center of the frame
+      double sre = 0, sim = 0;
+      for (int n = 0; n < length; n++) {
+        double w = (0.54 - 0.46 * cos(2 * M_PI * n / (length - 1 + 1e-9))) /
+            length;
+        double phase = 2 * M_PI * (freq * n / rate -
+                                   static_cast<double>(j) * (start + n) / N);
+        sre += w * cos(phase);
+        sim += w * sin(phase);
+      }
+      // The conjugated kernel divided by N, so that the sum over the
+      // spectrum equals the dot product in the time domain
+      re[j - first] = sre / N;
+      im[j - first] = -sim / N;
+      peak = std::max(peak, sre * sre + sim * sim);
+    }
+    double threshold = kSparsityThreshold * kSparsityThreshold * peak / N / N;
+    while (first < last &&
+           re[0] * re[0] + im[0] * im[0] < threshold) {
+      re.erase(re.begin());
+      im.erase(im.begin());
+      first++;
+    }
+    while (last > first &&
+           re.back() * re.back() + im.back() * im.back() < threshold) {
+      re.pop_back();
+      im.pop_back();
+      last--;
+    }
+    auto& kernel = kernels->Kernels[k];
+    kernel.begin = first;
+    kernel.end = last;
+    offsets[k] = packed.size();
+    for (int j = 0; j <= last - first; j++) {
+      packed.push_back(re[j]);
+      packed.push_back(im[j]);
+    }
+    packed.resize(offsets[k] + RowLength(kernel), 0.f);
+  }
+  kernels->Weights = std::uniquify(
+      mallocf(std::max(packed.size(), size_t(1))), std::free);
+  memcpy(kernels->Weights.get(), packed.data(),
+         packed.size() * sizeof(float));
+  for (int k = 0; k < count; k++) {
+    kernels->Kernels[k].data = kernels->Weights.get() + offsets[k];
+  }
+  return kernels;
+}
+
+size_t ConstantQ::RowLength(const Kernel& kernel) noexcept {
+  // Complex weights, rows are aligned to 8 floats
+  return ((kernel.end - kernel.begin + 1) * 2 + 7) & ~7;
+}
+
+void ConstantQ::Do(const BuffersBase<float*>& in,
+                   BuffersBase<float*>* out) const noexcept {
+  int count = in.Count();
+  int blocks = (count + kFramesBlock - 1) / kFramesBlock;
+  int outSize = output_format_->Size();
+  ParallelFor(blocks, [&](int begin, int end) {
+    for (int block = begin; block < end; block++) {
+      int first = block * kFramesBlock;
+      int last = std::min(first + kFramesBlock, count);
+      if (chroma_) {
+        for (int frame = first; frame < last; frame++) {
+          memset((*out)[frame], 0, outSize * sizeof(float));
+        }
+      }
+      for (const auto& kernel : kernels_) {
+        int index = &kernel - &kernels_[0];
+        if (chroma_) {
+          index %= bins_per_octave_;
+        }
+        int length = kernel.end - kernel.begin + 1;
+        for (int frame = first; frame < last; frame++) {
+          float energy = KernelEnergy(
+              use_simd(), in[frame] + kernel.begin * 2, kernel.data, length);
+          if (chroma_) {
+            (*out)[frame][index] += energy;
+          } else {
+            (*out)[frame][index] = energy;
+          }
+        }
+      }
+    }
+  });
+}
+
+float ConstantQ::KernelEnergy(bool simd, const float* in,
+                              const float* weights, int length) noexcept {
+  float re = 0.f, im = 0.f;
+  int i = 0;
+  if (simd) {
+#ifdef __AVX__
+    // Four complex numbers at once: the products of the same lanes give
+    // the real parts with the alternating signs, the products with
+    // the swapped pairs give the imaginary parts
+    __m256 sumre = _mm256_setzero_ps(), sumim = _mm256_setzero_ps();
+    for (; i < length - 3; i += 4) {
+      __m256 x = _mm256_loadu_ps(in + i * 2);
+      __m256 w = _mm256_load_ps(weights + i * 2);
+      sumre = _mm256_add_ps(sumre, _mm256_mul_ps(x, w));
+      sumim = _mm256_add_ps(sumim, _mm256_mul_ps(
+          x, _mm256_permute_ps(w, 0xB1)));
+    }
+    for (int j = 0; j < 8; j += 2) {
+      re += _mm256_get_ps(sumre, j) - _mm256_get_ps(sumre, j + 1);
+      im += _mm256_get_ps(sumim, j) + _mm256_get_ps(sumim, j + 1);
+    }
+#endif
+  }
+  for (; i < length; i++) {
+    float xre = in[i * 2], xim = in[i * 2 + 1];
+    float wre = weights[i * 2], wim = weights[i * 2 + 1];
+    re += xre * wre - xim * wim;
+    im += xre * wim + xim * wre;
+  }
+  return re * re + im * im;
+}
+
+size_t ConstantQ::PrivateMemorySize() const noexcept {
+  size_t size = kernels_.size() * sizeof(Kernel);
+  for (auto& kernel : kernels_) {
+    size += RowLength(kernel) * sizeof(float);
+  }
+  return size;
+}
+
+RTP(ConstantQ, bins_per_octave)
+RTP(ConstantQ, frequency_min)
+RTP(ConstantQ, frequency_max)
+RTP(ConstantQ, chroma)
+REGISTER_TRANSFORM(ConstantQ);
+
+}  // namespace transforms
+}  // namespace sound_feature_extraction
@@ -0,0 +1,143 @@
+/*! @file constant_q.h
+ *  @brief Constant-Q transform with the precomputed sparse spectral kernel.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#ifndef SRC_TRANSFORMS_CONSTANT_Q_H_
+#define SRC_TRANSFORMS_CONSTANT_Q_H_
+
+#include <vector>
+#include "src/transforms/common.h"
+
+namespace sound_feature_extraction {
+namespace transforms {
+
+/// @brief Calculates the energy of the constant-Q transform bins from
+/// the RDFT output, optionally folded into the chroma vector.
+/// @details The spectral kernel of each bin (the DFT of the windowed
+/// complex exponential, Brown & Puckette, 1992) is computed once per
+/// the parameters and the input format, shared with the other instances
+/// through SharedState and stored sparsely like the rows of FilterBank:
+/// only the contiguous range of bins above the threshold is kept. The
+/// frames are processed in blocks of kFramesBlock so that each row is loaded
+/// into the cache once per block. The kernels of the bins which would need
+/// the window longer than the frame are truncated to the frame length.
+class ConstantQ : public OmpAwareTransform<formats::ArrayFormatF,
+                                           formats::ArrayFormatF> {
+ public:
+  ConstantQ();
+
+  TRANSFORM_INTRO("ConstantQ",
+                  "Calculates the energy of the constant-Q transform bins "
+                  "from the RDFT output, or the chroma vector.",
+                  ConstantQ)
+
+  TP(bins_per_octave, int, kDefaultBinsPerOctave,
+     "The number of bins in each octave.")
+  TP(frequency_min, float, kDefaultMinFrequency,
+     "The center frequency of the first bin.")
+  TP(frequency_max, float, kDefaultMaxFrequency,
+     "The upper bound of the center frequencies of the bins.")
+  TP(chroma, bool, kDefaultChroma,
+     "Sum the bins of the same pitch class in all the octaves, yielding "
+     "bins_per_octave values.")
+
+  virtual void Initialize() const override;
+
+  virtual size_t PrivateMemorySize() const noexcept override;
+
+  virtual Overlap RequiredOverlap(const Overlap& output)
+      const noexcept override {
+    return output;
+  }
+
+  /// @brief The number of the constant-Q bins before the chroma folding.
+  int BinsCount() const noexcept;
+
+ protected:
+  /// @brief The sparse spectral kernel of a single bin: the conjugated
+  /// complex weights of the RDFT bins in the range [begin, end],
+  /// interleaved like the input.
+  struct Kernel {
+    Kernel() : data(nullptr), begin(0), end(0) {
+    }
+
+    const float* data;
+    int begin;
+    int end;
+  };
+
+  /// @brief The number of frames processed against each kernel at once.
+  static constexpr int kFramesBlock = 8;
+  /// @brief The kernel weights below this fraction of the maximal one are
+  /// dropped.
+  static constexpr float kSparsityThreshold = 0.0054f;
+
+  static constexpr int kDefaultBinsPerOctave = 12;
+  static constexpr float kDefaultMinFrequency = 65.406f;
+  static constexpr float kDefaultMaxFrequency = 4186.f;
+  static constexpr bool kDefaultChroma = false;
+
+  virtual size_t OnInputFormatChanged(size_t buffersCount) override;
+
+  virtual void Do(const BuffersBase<float*>& in,
+                  BuffersBase<float*>* out) const noexcept override;
+
+  /// @brief Calculates $|\sum_i in_i w_i|^2$ over complex numbers.
+  static float KernelEnergy(bool simd, const float* in, const float* weights,
+                            int length) noexcept;
+
+  const std::vector<Kernel>& kernels() const noexcept;
+
+ private:
+  /// @brief The kernels and their weights, shared by the transforms with
+  /// the same parameters and input format.
+  struct SharedKernels {
+    SharedKernels() : Weights(nullptr, std::free) {
+    }
+
+    std::vector<Kernel> Kernels;
+    /// @brief The weights of all the kernels, Kernels point inside.
+    FloatPtr Weights;
+  };
+
+  std::shared_ptr<const SharedKernels> CalculateKernels() const;
+
+  /// @brief The padded length of the weights row of the kernel.
+  static size_t RowLength(const Kernel& kernel) noexcept;
+
+  mutable std::vector<Kernel> kernels_;
+  /// @brief The SharedKernels which kernels_ points inside.
+  mutable std::shared_ptr<const void> weights_;
+};
+
+}  // namespace transforms
+}  // namespace sound_feature_extraction
+
+#endif  // SRC_TRANSFORMS_CONSTANT_Q_H_
@@ -29,19 +29,158 @@
  */
 
 #include "src/transforms/convolve.h"
+#include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <simd/memory.h>
+#include "src/fftf_wisdom.h"
+#include "src/make_unique.h"
 
 namespace sound_feature_extraction {
 namespace transforms {
 
-ConvolveFilter::ConvolveFilter() noexcept : window_(kDefaultWindowType) {
+constexpr size_t ConvolveFilter::kMinFFTBatch;
+constexpr size_t ConvolveFilter::kMaxFFTScratch;
+
+ConvolveFilter::ConvolveFilter() noexcept
+    : window_(kDefaultWindowType),
+      window_spectrum_(nullptr, std::free),
+      fft_length_(0),
+      forward_plans_(FFTF_TYPE_REAL, FFTF_DIRECTION_FORWARD),
+      backward_plans_(FFTF_TYPE_REAL, FFTF_DIRECTION_BACKWARD) {
 }
 
 ALWAYS_VALID_TP(ConvolveFilter, window)
 
 void ConvolveFilter::CalculateFilter(float* window) const noexcept {
-  for (int i = 0; i < length(); i++) {
-    window[i] = WindowElement(window_, length(), i);
+  memcpy(window, SharedWindow(window_, length()).get(),
+         length() * sizeof(window[0]));
+}
+
+int ConvolveFilter::fft_length() const noexcept {
+  return fft_length_;
+}
+
+int ConvolveFilter::ChooseFFTLength(size_t inputLength,
+                                    size_t filterLength) noexcept {
+  if (filterLength < static_cast<size_t>(kMinOverlapSaveFilterLength)) {
+    return 0;
+  }
+  size_t outputLength = inputLength + filterLength - 1;
+  size_t length = 1;
+  while (length < outputLength) {
+    length <<= 1;
+  }
+  if (2 * length + 2 > kMaxFFTScratch) {
+    return 0;
+  }
+  // forward + backward real FFTs and L / 2 complex multiplications
+  float cost = kFFTCost * length * std::log2(length) + 2.f * length;
+  if (cost >= static_cast<float>(inputLength) * filterLength) {
+    return 0;
+  }
+  return length;
+}
+
+void ConvolveFilter::Initialize() const {
+  FIRFilterBase::Initialize();
+  forward_plans_.Clear();
+  backward_plans_.Clear();
+  signals_.reset();
+  spectra_.reset();
+  fft_length_ = ChooseFFTLength(input_format_->Size(), length());
+  if (fft_length_ == 0) {
+    window_spectrum_.reset();
+    return;
+  }
+  // The spectrum is calculated once and reused by all the batches
+  window_spectrum_ = std::uniquify(mallocf(fft_length_ + 2), std::free);
+  auto padded = std::uniquify(mallocf(fft_length_), std::free);
+  memcpy(padded.get(), filter().data(), filter().size() * sizeof(float));
+  memset(padded.get() + filter().size(), 0,
+         (fft_length_ - filter().size()) * sizeof(float));
+  auto backend = FFTFWisdom::Instance().Select(
+      FFTF_TYPE_REAL, FFTF_DIRECTION_FORWARD, fft_length_, 1);
+  auto fftPlan = std::unique_ptr<FFTFInstance, void (*)(FFTFInstance *)>(
+      fftf_init(
+          FFTF_TYPE_REAL, FFTF_DIRECTION_FORWARD,
+          FFTF_DIMENSION_1D,
+          &fft_length_, FFTF_NO_OPTIONS,
+          padded.get(), window_spectrum_.get()),
+      fftf_destroy);
+  backend.unlock();
+  fftf_calc(fftPlan.get());
+  float norm = 1.f / fft_length_;
+  for (int i = 0; i < fft_length_ + 2; i++) {
+    window_spectrum_[i] *= norm;
+  }
+}
+
+size_t ConvolveFilter::PrivateMemorySize() const noexcept {
+  return FIRFilterBase::PrivateMemorySize() +
+      (window_spectrum_? fft_length_ + 2 : 0) * sizeof(float);
+}
+
+void ConvolveFilter::Do(const BuffersBase<float*>& in,
+                        BuffersBase<float*>* out) const noexcept {
+  // The decision is taken per call: the batch must be large enough to pay
+  // for the full length transforms and the scratch memory
+  if (fft_length_ == 0 || streaming() || in.Count() < kMinFFTBatch) {
+    FIRFilterBase::Do(in, out);
+    return;
+  }
+  DoFFT(in, out);
+}
+
+void ConvolveFilter::DoFFT(const BuffersBase<float*>& in,
+                           BuffersBase<float*>* out) const noexcept {
+  size_t count = in.Count();
+  size_t maxBatch = std::max(kMaxFFTScratch / (2 * fft_length_ + 2),
+                             kMinFFTBatch);
+  // Split into the batches of equal sizes, so that the same plans serve
+  // all of them
+  size_t batches = (count + maxBatch - 1) / maxBatch;
+  size_t batch = (count + batches - 1) / batches;
+  int inputLength = input_format_->Size();
+  int outputLength = output_format_->Size();
+
+  std::lock_guard<std::mutex> lock(fft_mutex_);
+  if (!signals_ || signals_->Count() != batch) {
+    signals_ = std::make_unique<BuffersBase<float*>>(
+        std::make_shared<formats::ArrayFormatF>(
+            fft_length_, input_format_->SamplingRate()), batch);
+    spectra_ = std::make_unique<BuffersBase<float*>>(
+        std::make_shared<formats::ArrayFormatF>(
+            fft_length_ + 2, input_format_->SamplingRate()), batch);
+  }
+  const float* h = window_spectrum_.get();
+  for (size_t begin = 0; begin < count; begin += batch) {
+    size_t end = std::min(begin + batch, count);
+    for (size_t i = begin; i < end; i++) {
+      float* signal = (*signals_)[i - begin];
+      memcpy(signal, in[i], inputLength * sizeof(float));
+      memset(signal + inputLength, 0,
+             (fft_length_ - inputLength) * sizeof(float));
+    }
+    // The last batch may be incomplete, the spare buffers are transformed
+    // along with the others and ignored
+    forward_plans_.Calculate(fft_length_, *signals_, spectra_.get());
+    this->ParallelFor(end - begin, [&](size_t first, size_t last) {
+      for (size_t i = first; i < last; i++) {
+        float* spectrum = (*spectra_)[i];
+        for (int j = 0; j < fft_length_ + 2; j += 2) {
+          float re = spectrum[j] * h[j] - spectrum[j + 1] * h[j + 1];
+          float im = spectrum[j] * h[j + 1] + spectrum[j + 1] * h[j];
+          spectrum[j] = re;
+          spectrum[j + 1] = im;
+        }
+      }
+    });
+    backward_plans_.Calculate(fft_length_, *spectra_, signals_.get());
+    for (size_t i = begin; i < end; i++) {
+      memcpy((*out)[i], (*signals_)[i - begin],
+             outputLength * sizeof(float));
+    }
   }
 }
 
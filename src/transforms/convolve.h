@@ -31,6 +31,8 @@
 #ifndef SRC_TRANSFORMS_CONVOLVE_H_
 #define SRC_TRANSFORMS_CONVOLVE_H_
 
+#include <mutex>
+#include "src/fftf_plan_cache.h"
 #include "src/transforms/fir_filter_base.h"
 #include "src/primitives/window.h"
 
@@ -38,20 +40,62 @@ namespace sound_feature_extraction {
 namespace transforms {
 
 /// @brief Convolves a raw signal with a window function.
+/// @details Long windows are applied to the batches of buffers in
+/// the frequency domain: the window spectrum is calculated once and the
+/// buffers are transformed together with the plans cached the same way
+/// RDFT does. Single buffers and short windows go through FIRFilterBase.
 class ConvolveFilter : public FIRFilterBase {
  public:
   ConvolveFilter() noexcept;
 
+  using FIRFilterBase::Do;
+
   TRANSFORM_INTRO("Convolve", "Convolve a raw signal with a window function.",
                   ConvolveFilter)
 
   TP(window, WindowType, kDefaultWindowType,
      "Type of the window. E.g. \"rectangular\" or \"hamming\".")
 
+  virtual void Initialize() const override;
+
+  virtual size_t PrivateMemorySize() const noexcept override;
+
+  /// @brief The FFT length of the batched frequency domain convolution,
+  /// 0 if it is never used.
+  int fft_length() const noexcept;
+
+  /// @brief Chooses the FFT length which covers the whole linear
+  /// convolution of the specified signal and filter sizes.
+  /// @return The FFT length or 0 if the direct convolution is cheaper.
+  static int ChooseFFTLength(size_t inputLength,
+                             size_t filterLength) noexcept;
+
+  /// @brief Batches with fewer buffers are filtered one by one.
+  static constexpr size_t kMinFFTBatch = 2;
+  /// @brief The maximal number of floats in the scratch buffers of a batch.
+  static constexpr size_t kMaxFFTScratch = 1 << 24;
+
  protected:
   static constexpr WindowType kDefaultWindowType =
       WindowType::kWindowTypeRectangular;
   virtual void CalculateFilter(float* filter) const noexcept;
+
+  virtual void Do(const BuffersBase<float*>& in,
+                  BuffersBase<float*>* out) const noexcept override;
+
+ private:
+  void DoFFT(const BuffersBase<float*>& in,
+             BuffersBase<float*>* out) const noexcept;
+
+  /// @brief The spectrum of the zero padded window, scaled by
+  /// 1 / fft_length_ to fold in the inverse FFT normalization.
+  mutable FloatPtr window_spectrum_;
+  mutable int fft_length_;
+  mutable FFTFPlanCache forward_plans_;
+  mutable FFTFPlanCache backward_plans_;
+  mutable std::unique_ptr<BuffersBase<float*>> signals_;
+  mutable std::unique_ptr<BuffersBase<float*>> spectra_;
+  mutable std::mutex fft_mutex_;
 };
 
 }  // namespace transforms
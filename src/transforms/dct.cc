@@ -29,66 +29,237 @@
  */
 
 #include "src/transforms/dct.h"
-#include <fftf/api.h>
-#include <vector>
 #include <simd/arithmetic-inl.h>
+#ifdef SIMD_X86
+#include <immintrin.h>
+#elif defined(SIMD_NEON)
+#include <arm_neon.h>
+#endif
+#include <cassert>
+#include <algorithm>
+#include <cmath>
 
 namespace sound_feature_extraction {
 namespace transforms {
 
+/// @brief Multiplies kDCTFrames frames by the rows x size matrix, loading
+/// each row once.
+typedef void (*DCTKernel)(const float* matrix, int rows, int size,
+                          const float* const* in, float* const* out);
+
+static constexpr int kDCTFrames = 4;
+
+static void DCTScalar(const float* matrix, int rows, int size,
+                      const float* const* in, float* const* out) {
+  for (int r = 0; r < rows; r++) {
+    const float* row = matrix + r * size;
+    for (int f = 0; f < kDCTFrames; f++) {
+      float sum = 0;
+      for (int i = 0; i < size; i++) {
+        sum += row[i] * in[f][i];
+      }
+      out[f][r] = sum;
+    }
+  }
+}
+
+#ifdef SIMD_X86
+SIMD_TARGET("avx")
+static void DCTAVX(const float* matrix, int rows, int size,
+                   const float* const* in, float* const* out) {
+  int vectorized = size & ~7;
+  for (int r = 0; r < rows; r++) {
+    const float* row = matrix + r * size;
+    __m256 acc[kDCTFrames];
+    for (int f = 0; f < kDCTFrames; f++) {
+      acc[f] = _mm256_setzero_ps();
+    }
+    for (int i = 0; i < vectorized; i += 8) {
+      __m256 weights = _mm256_loadu_ps(row + i);
+      for (int f = 0; f < kDCTFrames; f++) {
+        acc[f] = _mm256_add_ps(acc[f], _mm256_mul_ps(
+            weights, _mm256_loadu_ps(in[f] + i)));
+      }
+    }
+    for (int f = 0; f < kDCTFrames; f++) {
+      __m128 half = _mm_add_ps(_mm256_castps256_ps128(acc[f]),
+                               _mm256_extractf128_ps(acc[f], 1));
+      half = _mm_hadd_ps(half, half);
+      half = _mm_hadd_ps(half, half);
+      float sum = _mm_cvtss_f32(half);
+      for (int i = vectorized; i < size; i++) {
+        sum += row[i] * in[f][i];
+      }
+      out[f][r] = sum;
+    }
+  }
+}
+
+SIMD_TARGET_AVX512
+static void DCTAVX512(const float* matrix, int rows, int size,
+                      const float* const* in, float* const* out) {
+  int vectorized = size & ~15;
+  __mmask16 tail = (1u << (size - vectorized)) - 1;
+  for (int r = 0; r < rows; r++) {
+    const float* row = matrix + r * size;
+    __m512 acc[kDCTFrames];
+    for (int f = 0; f < kDCTFrames; f++) {
+      acc[f] = _mm512_setzero_ps();
+    }
+    for (int i = 0; i < vectorized; i += 16) {
+      __m512 weights = _mm512_loadu_ps(row + i);
+      for (int f = 0; f < kDCTFrames; f++) {
+        acc[f] = _mm512_fmadd_ps(weights, _mm512_loadu_ps(in[f] + i), acc[f]);
+      }
+    }
+    __m512 weights = _mm512_maskz_loadu_ps(tail, row + vectorized);
+    for (int f = 0; f < kDCTFrames; f++) {
+      acc[f] = _mm512_fmadd_ps(
+          weights, _mm512_maskz_loadu_ps(tail, in[f] + vectorized), acc[f]);
+      out[f][r] = _mm512_reduce_add_ps(acc[f]);
+    }
+  }
+}
+#elif defined(SIMD_NEON)
+static void DCTNEON(const float* matrix, int rows, int size,
+                    const float* const* in, float* const* out) {
+  int vectorized = size & ~3;
+  for (int r = 0; r < rows; r++) {
+    const float* row = matrix + r * size;
+    float32x4_t acc[kDCTFrames];
+    for (int f = 0; f < kDCTFrames; f++) {
+      acc[f] = vdupq_n_f32(0);
+    }
+    for (int i = 0; i < vectorized; i += 4) {
+      float32x4_t weights = vld1q_f32(row + i);
+      for (int f = 0; f < kDCTFrames; f++) {
+        acc[f] = vmlaq_f32(acc[f], weights, vld1q_f32(in[f] + i));
+      }
+    }
+    for (int f = 0; f < kDCTFrames; f++) {
+      float32x2_t half = vadd_f32(vget_low_f32(acc[f]),
+                                  vget_high_f32(acc[f]));
+      float sum = vget_lane_f32(vpadd_f32(half, half), 0);
+      for (int i = vectorized; i < size; i++) {
+        sum += row[i] * in[f][i];
+      }
+      out[f][r] = sum;
+    }
+  }
+}
+#endif
+
+static const SimdKernel<DCTKernel> kDCTKernels[] {
+#ifdef SIMD_X86
+  { InstructionSet::kAVX512, DCTAVX512 },
+  { InstructionSet::kAVX, DCTAVX },
+#elif defined(SIMD_NEON)
+  { InstructionSet::kNEON, DCTNEON },
+#endif
+  { InstructionSet::kScalar, DCTScalar }
+};
+
+DCT::DCT() noexcept
+    : length_(kDefaultLength),
+      plans_(FFTF_TYPE_DCT, FFTF_DIRECTION_FORWARD) {
+}
+
+bool DCT::validate_length(const int& value) noexcept {
+  return value >= 0;
+}
+
+size_t DCT::OnFormatChanged(size_t buffersCount) {
+  int size = input_format_->Size();
+  if (length_ == 0) {
+    length_ = size;
+  }
+  if (length_ > size) {
+    throw InvalidParameterValueException("length", std::to_string(length_),
+                                         HostName());
+  }
+  output_format_->SetSize(length_);
+  return buffersCount;
+}
+
+void DCT::Initialize() const {
+  int size = input_format_->Size();
+  if (length_ == size) {
+    matrix_.clear();
+    return;
+  }
+  matrix_.resize(length_ * size);
+  for (int k = 0; k < length_; k++) {
+    for (int n = 0; n < size; n++) {
+      matrix_[k * size + n] = 2 * cos(M_PI * k * (2 * n + 1) / (2. * size));
+    }
+  }
+}
+
+InstructionSet DCT::SimdInstructionSet() const noexcept {
+  if (matrix_.empty()) {
+    return SimdAware::SimdInstructionSet();
+  }
+  return SimdAware::Dispatch(kDCTKernels).Isa;
+}
+
 void DCT::Do(const BuffersBase<float*>& in,
              BuffersBase<float*>* out) const noexcept {
-  int length = output_format_->Size();
-  std::vector<const float*> inputs(in.Count());
-  std::vector<float*> outputs(in.Count());
-  for (size_t i = 0; i < in.Count(); i++) {
-    inputs[i] = in[i];
-    outputs[i] = (*out)[i];
+  int size = input_format_->Size();
+  if (matrix_.empty()) {
+    plans_.Calculate(size, in, out);
+    return;
   }
-  fftf_set_backend(FFTF_BACKEND_NONE);
-  fftf_ensure_is_supported(FFTF_TYPE_DCT, input_format_->Size());
-  auto fft_plan = std::unique_ptr<FFTFInstance, void (*)(FFTFInstance *)>(
-      fftf_init_batch(
-          FFTF_TYPE_DCT,
-          FFTF_DIRECTION_FORWARD,
-          FFTF_DIMENSION_1D,
-          &length,
-          FFTF_NO_OPTIONS,
-          in.Count(),
-          &inputs[0], &outputs[0]),
-      fftf_destroy);
-
-  fftf_calc(fft_plan.get());
+  int count = in.Count();
+  for (int first = 0; first < count; first += kDCTFrames) {
+    const float* ins[kDCTFrames];
+    float* outs[kDCTFrames];
+    int frames = std::min(kDCTFrames, count - first);
+    for (int f = 0; f < frames; f++) {
+      ins[f] = in[first + f];
+      outs[f] = (*out)[first + f];
+    }
+    DoTruncated(ins, outs, frames);
+  }
+}
+
+void DCT::DoTruncated(const float* const* in, float* const* out,
+                      int count) const noexcept {
+  assert(!matrix_.empty());
+  int size = input_format_->Size();
+  auto kernel = use_simd()? SimdAware::Dispatch(kDCTKernels).Function
+                          : DCTScalar;
+  for (int first = 0; first < count; first += kDCTFrames) {
+    // Repeat the last frame to fill the block, it is written twice
+    // with the same values
+    const float* ins[kDCTFrames];
+    float* outs[kDCTFrames];
+    for (int f = 0; f < kDCTFrames; f++) {
+      int frame = std::min(first + f, count - 1);
+      ins[f] = in[frame];
+      outs[f] = out[frame];
+    }
+    kernel(matrix_.data(), length_, size, ins, outs);
+  }
+}
+
+DCTInverse::DCTInverse() noexcept
+    : plans_(FFTF_TYPE_DCT, FFTF_DIRECTION_BACKWARD) {
 }
 
 void DCTInverse::Do(const BuffersBase<float*>& in,
                     BuffersBase<float*>* out) const noexcept {
   int length = output_format_->Size();
-  std::vector<const float*> inputs(in.Count());
-  std::vector<float*> outputs(in.Count());
-  for (size_t i = 0; i < in.Count(); i++) {
-    inputs[i] = in[i];
-    outputs[i] = (*out)[i];
-  }
-  fftf_set_backend(FFTF_BACKEND_NONE);
-  fftf_ensure_is_supported(FFTF_TYPE_DCT, input_format_->Size());
-  auto fft_plan = std::unique_ptr<FFTFInstance, void (*)(FFTFInstance *)>(
-      fftf_init_batch(
-          FFTF_TYPE_DCT,
-          FFTF_DIRECTION_BACKWARD,
-          FFTF_DIMENSION_1D,
-          &length,
-          FFTF_NO_OPTIONS,
-          in.Count(),
-          &inputs[0], &outputs[0]),
-      fftf_destroy);
-
-  fftf_calc(fft_plan.get());
+  plans_.Calculate(length, in, out);
   for (size_t i = 0; i < in.Count(); i++) {
-    real_multiply_scalar(outputs[i], length, 0.5f / length, outputs[i]);
+    real_multiply_scalar((*out)[i], length, 0.5f / length, (*out)[i]);
   }
 }
 
+size_t DCT::PrivateMemorySize() const noexcept {
+  return matrix_.size() * sizeof(float);
+}
+
+RTP(DCT, length)
 REGISTER_TRANSFORM(DCT);
 REGISTER_TRANSFORM(DCTInverse);
 
@@ -31,29 +31,72 @@
 #ifndef SRC_TRANSFORMS_DCT_H_
 #define SRC_TRANSFORMS_DCT_H_
 
+#include <vector>
+#include "src/fftf_plan_cache.h"
 #include "src/formats/array_format.h"
 #include "src/transform_base.h"
 
 namespace sound_feature_extraction {
 namespace transforms {
 
+/// @brief DCT-II with the FFTF scale, X_k = 2 \sum_n x_n cos(pi k (2n + 1) / 2N).
+/// @details When only the leading coefficients are needed (length is less
+/// than the input size, e.g. 13 MFCC out of 32 bands), they are calculated
+/// directly with the precomputed length x N cosine matrix, 4 frames per pass
+/// over it. TransformTree fuses DCT -> Selector(length=k) into
+/// DCT(length=k), and FilterBank -> Log -> DCT -> Selector(length=k) into
+/// Cepstrum.
 class DCT : public UniformFormatTransform<formats::ArrayFormatF> {
  public:
+  DCT() noexcept;
+
   TRANSFORM_INTRO("DCT", "Performs Discrete Cosine Transform "
                          "on the signal.",
                   DCT)
 
+  TP(length, int, kDefaultLength,
+     "The number of the leading coefficients to calculate. 0 means "
+     "the length of the input.")
+
   virtual bool BufferInvariant() const noexcept override final {
     return true;
   }
 
+  virtual void Initialize() const override;
+
+  virtual InstructionSet SimdInstructionSet() const noexcept override;
+
+  virtual size_t PrivateMemorySize() const noexcept override;
+
+  virtual Overlap RequiredOverlap(const Overlap& output)
+      const noexcept override {
+    return output;
+  }
+
+  /// @brief Calculates the leading length() coefficients of count frames
+  /// with the cosine matrix, which exists if length() is less than
+  /// the input size.
+  void DoTruncated(const float* const* in, float* const* out,
+                   int count) const noexcept;
+
  protected:
+  static constexpr int kDefaultLength = 0;
+
+  virtual size_t OnFormatChanged(size_t buffersCount) override;
+
   virtual void Do(const BuffersBase<float*>& in,
                   BuffersBase<float*>* out) const noexcept override;
+
+ private:
+  mutable FFTFPlanCache plans_;
+  /// @brief The cosine matrix of the truncated transform, row major.
+  mutable std::vector<float> matrix_;
 };
 
 class DCTInverse : public InverseUniformFormatTransform<DCT> {
  public:
+  DCTInverse() noexcept;
+
   virtual bool BufferInvariant() const noexcept override final {
     return true;
   }
@@ -61,6 +104,9 @@ class DCTInverse : public InverseUniformFormatTransform<DCT> {
  protected:
   virtual void Do(const BuffersBase<float*>& in,
                   BuffersBase<float*>* out) const noexcept override;
+
+ private:
+  mutable FFTFPlanCache plans_;
 };
 
 }  // namespace transforms
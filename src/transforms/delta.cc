@@ -29,7 +29,14 @@
  */
 
 #include "src/transforms/delta.h"
+#include <algorithm>
+#include <cstring>
 #include <simd/arithmetic-inl.h>
+#ifdef SIMD_X86
+#include <immintrin.h>
+#elif defined(SIMD_NEON)
+#include <arm_neon.h>
+#endif
 
 namespace sound_feature_extraction {
 namespace transforms {
@@ -47,166 +54,275 @@ DeltaType Parse(const std::string& value, identity<DeltaType>) {
 }
 
 constexpr DeltaType Delta::kDefaultDeltaType;
+constexpr int Delta::kColumns;
+constexpr int Delta::kFrameBlock;
 
 Delta::Delta()
     : type_(kDefaultDeltaType),
-      rlength_(kDefaultRegressionLength) {
+      rlength_(kDefaultRegressionLength),
+      append_(kDefaultAppend),
+      acceleration_(kDefaultAcceleration) {
 }
 
 ALWAYS_VALID_TP(Delta, type)
 bool Delta::validate_rlength(const int& value) noexcept {
   return value >= 3 && (value % 2) == 1;
 }
+ALWAYS_VALID_TP(Delta, append)
+ALWAYS_VALID_TP(Delta, acceleration)
+
+size_t Delta::OnFormatChanged(size_t buffersCount) {
+  output_format_->SetSize(input_format_->Size() *
+                          ((append_? 1 : 0) + (acceleration_? 2 : 1)));
+  return buffersCount;
+}
 
 void Delta::Do(const BuffersBase<float*>& in,
                BuffersBase<float*>* out) const noexcept {
+  int count = in.Count();
+  int size = input_format_->Size();
+  int delta = append_? size : 0;
+  std::vector<const float*> rows(count), outs(count);
+  std::vector<float*> results(count);
+  for (int i = 0; i < count; i++) {
+    rows[i] = in[i];
+    outs[i] = results[i] = (*out)[i];
+    if (append_) {
+      memcpy(results[i], rows[i], size * sizeof(rows[i][0]));
+    }
+  }
   switch (type_) {
     case DeltaType::kSimple:
-      for (size_t i = 1; i < in.Count(); i++) {
-        DoSimple(use_simd(), in[i - 1], in[i],
-                 input_format_->Size(), (*out)[i]);
-      }
-      for (size_t i = 0; i < input_format_->Size(); i++) {
-        (*out)[0][i] = (*out)[1][i];
+      DoSimpleWindows(rows.data(), 0, count, &stream_last_, results.data(),
+                      delta);
+      if (acceleration_) {
+        DoSimpleWindows(outs.data(), delta, count, &stream_last_delta_,
+                        results.data(), delta + size);
       }
-    break;
+      break;
     case DeltaType::kRegression: {
-      int rstep = rlength_ / 2;
-      float norm = 2 * rstep * (rstep + 1) * (2 * rstep + 1) / 6;
-      for (size_t i = rstep; i < in.Count() - rstep; i++) {
-        DoRegression(use_simd(), in, rstep, i, norm, input_format_->Size(),
-                     out);
-      }
-      for (size_t i = rstep - 1; i > 0; i--) {
-        norm = 2 * i * (i + 1) * (2 * i + 1) / 6;
-        DoRegression(use_simd(), in, i, i, norm, input_format_->Size(), out);
-        DoRegression(use_simd(), in, in.Count() - i, i, norm,
-                     input_format_->Size(), out);
-      }
-      for (size_t i = 0; i < input_format_->Size(); i++) {
-        (*out)[0][i] = (*out)[1][i];
-        (*out)[in.Count() - 1][i] = (*out)[in.Count() - 2][i];
-      }
+      int chunks = (size + kColumns - 1) / kColumns;
+      ParallelFor(chunks, [&](int begin, int end) {
+        for (int c = begin; c < end; c++) {
+          DoRegressionColumns(rows.data(), outs.data(), results.data(), count,
+                              c * kColumns,
+                              std::min(kColumns, size - c * kColumns));
+        }
+      });
       break;
     }
   }
 }
 
-void Delta::DoSimple(bool simd, const float* prev, const float* cur,
-                     size_t length, float* res) noexcept {
-  int ilength = length;
-  if (simd) {
-#ifdef __AVX__
-    for (int i = 0; i < ilength - 15; i += 16) {
-      __m256 vecp1 = _mm256_load_ps(prev + i);
-      __m256 vecp2 = _mm256_load_ps(prev + i + 8);
-      __m256 vecc1 = _mm256_load_ps(cur + i);
-      __m256 vecc2 = _mm256_load_ps(cur + i + 8);
-      __m256 diff1 = _mm256_sub_ps(vecc1, vecp1);
-      __m256 diff2 = _mm256_sub_ps(vecc2, vecp2);
-      _mm256_store_ps(res + i, diff1);
-      _mm256_store_ps(res + i + 8, diff2);
-    }
-    for (int i = (ilength & ~0xF); i < ilength; i++) {
-      res[i] = cur[i] - prev[i];
-    }
-    return;
+void Delta::DoSimpleWindows(const float* const* rows, int offset, int count,
+                            std::vector<float>* last, float* const* results,
+                            int result_offset) const noexcept {
+  size_t size = input_format_->Size();
+  for (int i = 1; i < count; i++) {
+    DoSimple(use_simd(), rows[i - 1] + offset, rows[i] + offset, size,
+             results[i] + result_offset);
+  }
+  if (streaming() && !last->empty()) {
+    DoSimple(false, last->data(), rows[0] + offset, size,
+             results[0] + result_offset);
   } else {
-#elif defined(__ARM_NEON__)
-    for (int i = 0; i < ilength - 7; i += 8) {
-      float32x4_t vecp1 = vld1q_f32(prev + i);
-      float32x4_t vecp2 = vld1q_f32(prev + i + 4);
-      float32x4_t vecc1 = vld1q_f32(cur + i);
-      float32x4_t vecc2 = vld1q_f32(cur + i + 4);
-      float32x4_t diff1 = vsubq_f32(vecc1, vecp1);
-      float32x4_t diff2 = vsubq_f32(vecc2, vecp2);
-      vst1q_f32(res + i, diff1);
-      vst1q_f32(res + i + 4, diff2);
+    memcpy(results[0] + result_offset, results[1] + result_offset,
+           size * sizeof(results[0][0]));
+  }
+  if (streaming()) {
+    last->assign(rows[count - 1] + offset, rows[count - 1] + offset + size);
+  }
+}
+
+void Delta::DoRegressionColumns(const float* const* in,
+                                const float* const* outs, float* const* out,
+                                int count, int first,
+                                int width) const noexcept {
+  int size = input_format_->Size();
+  int delta = (append_? size : 0) + first;
+  int rstep = rlength_ / 2;
+  int done = 0;
+  for (int begin = 0; begin < count; begin += kFrameBlock) {
+    int end = std::min(begin + kFrameBlock, count);
+    DoRegression(in, first, count, rstep, begin, end, width, out, delta);
+    if (!acceleration_) {
+      continue;
     }
-    for (int i = (ilength & ~0x7); i < ilength; i++) {
-      res[i] = cur[i] - prev[i];
+    // Each delta-delta needs the deltas up to rstep windows ahead, they
+    // are still in the cache
+    int ready = end == count? count : end - rstep;
+    if (ready > done) {
+      DoRegression(outs, delta, count, rstep, done, ready, width, out,
+                   delta + size);
+      done = ready;
     }
-    return;
-  } else {
-#else
-  } {
+  }
+}
+
+Overlap Delta::RequiredOverlap(const Overlap& output) const noexcept {
+  if (!output.Bounded()) {
+    return output;
+  }
+  // The first simple delta repeats the second one, the regression ones
+  // shrink within rlength / 2 windows of the edges
+  size_t before = type_ == DeltaType::kSimple? 1 : rlength_ / 2;
+  size_t after = type_ == DeltaType::kSimple? 0 : rlength_ / 2;
+  if (acceleration_) {
+    before *= 2;
+    after *= 2;
+  }
+  return { output.Before + before, output.After + after };
+}
+
+void Delta::ResetState() const noexcept {
+  stream_last_.clear();
+  stream_last_delta_.clear();
+}
+
+typedef void (*DeltaSimpleKernel)(const float* prev, const float* cur,
+                                  int length, float* res);
+
+static void DeltaSimpleScalar(const float* prev, const float* cur,
+                              int length, float* res) {
+  for (int i = 0; i < length; i++) {
+    res[i] = cur[i] - prev[i];
+  }
+}
+
+#ifdef SIMD_X86
+SIMD_TARGET("sse4.1")
+static void DeltaSimpleSSE41(const float* prev, const float* cur,
+                             int length, float* res) {
+  int i = 0;
+  for (; i < length - 7; i += 8) {
+    __m128 diff1 = _mm_sub_ps(_mm_loadu_ps(cur + i), _mm_loadu_ps(prev + i));
+    __m128 diff2 = _mm_sub_ps(_mm_loadu_ps(cur + i + 4),
+                              _mm_loadu_ps(prev + i + 4));
+    _mm_storeu_ps(res + i, diff1);
+    _mm_storeu_ps(res + i + 4, diff2);
+  }
+  DeltaSimpleScalar(prev + i, cur + i, length - i, res + i);
+}
+
+SIMD_TARGET("avx")
+static void DeltaSimpleAVX(const float* prev, const float* cur,
+                           int length, float* res) {
+  int i = 0;
+  for (; i < length - 15; i += 16) {
+    __m256 diff1 = _mm256_sub_ps(_mm256_loadu_ps(cur + i),
+                                 _mm256_loadu_ps(prev + i));
+    __m256 diff2 = _mm256_sub_ps(_mm256_loadu_ps(cur + i + 8),
+                                 _mm256_loadu_ps(prev + i + 8));
+    _mm256_storeu_ps(res + i, diff1);
+    _mm256_storeu_ps(res + i + 8, diff2);
+  }
+  DeltaSimpleScalar(prev + i, cur + i, length - i, res + i);
+}
+#elif defined(SIMD_NEON)
+static void DeltaSimpleNEON(const float* prev, const float* cur,
+                            int length, float* res) {
+  int i = 0;
+  for (; i < length - 7; i += 8) {
+    float32x4_t diff1 = vsubq_f32(vld1q_f32(cur + i), vld1q_f32(prev + i));
+    float32x4_t diff2 = vsubq_f32(vld1q_f32(cur + i + 4),
+                                  vld1q_f32(prev + i + 4));
+    vst1q_f32(res + i, diff1);
+    vst1q_f32(res + i + 4, diff2);
+  }
+  DeltaSimpleScalar(prev + i, cur + i, length - i, res + i);
+}
 #endif
-    for (int i = 0; i < ilength; i++) {
-      res[i] = cur[i] - prev[i];
-    }
+
+static const SimdKernel<DeltaSimpleKernel> kDeltaSimpleKernels[] {
+#ifdef SIMD_X86
+  { InstructionSet::kAVX, DeltaSimpleAVX },
+  { InstructionSet::kSSE41, DeltaSimpleSSE41 },
+#elif defined(SIMD_NEON)
+  { InstructionSet::kNEON, DeltaSimpleNEON },
+#endif
+  { InstructionSet::kScalar, DeltaSimpleScalar }
+};
+
+void Delta::DoSimple(bool simd, const float* prev, const float* cur,
+                     size_t length, float* res) noexcept {
+  if (!simd) {
+    DeltaSimpleScalar(prev, cur, length, res);
     return;
   }
+  SimdAware::Dispatch(kDeltaSimpleKernels).Function(prev, cur, length, res);
 }
 
-void Delta::DoRegression(bool simd, const BuffersBase<float*>& in,
-                         int rstep, int i, float norm, int windowSize,
-                         BuffersBase<float*>* out) noexcept {
-  assert(false && "Unstable implementation of Delta regression");
-  if (simd) {
-#ifdef __AVX__
-    __m256 normvec = _mm256_set1_ps(norm);
-    for (int j = 0; j < windowSize - 7; j += 8) {
-      __m256 sum = _mm256_setzero_ps();
-      __m256 kvec = _mm256_set1_ps(1.f);
-      for (int k = 1; k <= rstep; k++) {
-        __m256 rvec = _mm256_load_ps(in[i + k] + j);
-        __m256 lvec = _mm256_load_ps(in[i - k] + j);
-        __m256 diff = _mm256_sub_ps(rvec, lvec);
-        diff = _mm256_mul_ps(diff, kvec);
-        sum = _mm256_add_ps(sum, diff);
-        kvec = _mm256_add_ps(kvec, _mm256_set1_ps(1.f));
-      }
-      sum = _mm256_div_ps(sum, normvec);
-      _mm256_store_ps((*out)[i] + j, sum);
+InstructionSet Delta::SimdInstructionSet() const noexcept {
+  if (type_ != DeltaType::kSimple) {
+    return SimdAware::SimdInstructionSet();
+  }
+  return SimdAware::Dispatch(kDeltaSimpleKernels).Isa;
+}
+
+void Delta::DoRegression(const float* const* rows, int offset, int count,
+                         int rstep, int begin, int end, int width,
+                         float* const* results, int result_offset) noexcept {
+  assert(width <= kColumns);
+  // Double precision keeps the incremental updates as exact as the direct
+  // sums are
+  double sums[kColumns], weighted[kColumns];
+  int last = -1;
+  for (int t = begin; t < end; t++) {
+    float* res = results[t] + result_offset;
+    if (count < 3) {
+      memset(res, 0, width * sizeof(res[0]));
+      continue;
     }
-    for (int j = windowSize & ~7; j < windowSize; j++) {
-      float sum = 0.f;
-      for (int k = 1; k <= rstep; k++) {
-        sum += (in[i + k][j] - in[i - k][j]) * k;
+    // The first and the last windows repeat their neighbors
+    int frame = t == 0? 1 : t == count - 1? count - 2 : t;
+    int k = std::min(rstep, std::min(frame, count - 1 - frame));
+    float norm = k * (k + 1) * (2 * k + 1) / 3;
+    if (k < rstep) {
+      for (int j = 0; j < width; j++) {
+        float sum = 0.f;
+        for (int m = 1; m <= k; m++) {
+          sum += (rows[frame + m][offset + j] -
+                  rows[frame - m][offset + j]) * m;
+        }
+        res[j] = sum / norm;
       }
-      (*out)[i][j] = sum / norm;
+      continue;
     }
-    return;
-  } else {
-#elif defined(__ARM_NEON__)
-    float32x4_t normvec = vdupq_n_f32(1.f / norm);
-    for (int j = 0; j < windowSize - 3; j += 4) {
-      float32x4_t sum = vdupq_n_f32(0.f);
-      float32x4_t kvec = vdupq_n_f32(1.f);
-      for (int k = 1; k <= rstep; k++) {
-        float32x4_t rvec = vld1q_f32(in[i + k] + j);
-        float32x4_t lvec = vld1q_f32(in[i - k] + j);
-        float32x4_t diff = vsubq_f32(rvec, lvec);
-        sum = vmlaq_f32(diff, kvec, sum);
-        kvec = vaddq_f32(kvec, vdupq_n_f32(1.f));
+    if (frame != last + 1 || (frame - begin) % kFrameBlock == 0) {
+      for (int j = 0; j < width; j++) {
+        sums[j] = rows[frame][offset + j];
+        weighted[j] = 0;
       }
-      sum = vmulq_f32(sum, normvec);
-      vst1q_f32((*out)[i] + j, sum);
-    }
-    for (int j = windowSize & ~3; j < windowSize; j++) {
-      float sum = 0.f;
-      for (int k = 1; k <= rstep; k++) {
-        sum += (in[i + k][j] - in[i - k][j]) * k;
+      for (int m = 1; m <= rstep; m++) {
+        const float* head = rows[frame + m] + offset;
+        const float* tail = rows[frame - m] + offset;
+        for (int j = 0; j < width; j++) {
+          sums[j] += static_cast<double>(head[j]) + tail[j];
+          weighted[j] += static_cast<double>(head[j] - tail[j]) * m;
+        }
       }
-      (*out)[i][j] = sum / norm;
-    }
-    return;
-  } else {
-#else
-  } {
-#endif
-    for (int j = 0; j < windowSize; j++) {
-      float sum = 0.f;
-      for (int k = 1; k <= rstep; k++) {
-        sum += (in[i + k][j] - in[i - k][j]) * k;
+    } else {
+      // Slide the window by one: the weights of the common windows
+      // decrease by one
+      const float* head = rows[frame + rstep] + offset;
+      const float* tail = rows[frame - rstep - 1] + offset;
+      for (int j = 0; j < width; j++) {
+        sums[j] += static_cast<double>(head[j]) - tail[j];
+        weighted[j] += static_cast<double>(rstep) * tail[j] +
+            (rstep + 1.) * head[j] - sums[j];
       }
-      (*out)[i][j] = sum / norm;
+    }
+    last = frame;
+    for (int j = 0; j < width; j++) {
+      res[j] = static_cast<float>(weighted[j] / norm);
     }
   }
 }
 
 RTP(Delta, rlength)
 RTP(Delta, type)
+RTP(Delta, append)
+RTP(Delta, acceleration)
 REGISTER_TRANSFORM(Delta);
 
 }  // namespace transforms
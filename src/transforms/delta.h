@@ -31,8 +31,9 @@
 #ifndef SRC_TRANSFORMS_DELTA_H_
 #define SRC_TRANSFORMS_DELTA_H_
 
+#include <vector>
 #include "src/formats/array_format.h"
-#include "src/transform_base.h"
+#include "src/omp_transform_base.h"
 
 namespace sound_feature_extraction {
 namespace transforms {
@@ -72,7 +73,12 @@ namespace std {
 namespace sound_feature_extraction {
 namespace transforms {
 
-class Delta : public UniformFormatTransform<formats::ArrayFormatF> {
+/// @brief The regression deltas are a fixed FIR along the windows:
+/// d[t] = sum_{k=1}^{K} k (c[t + k] - c[t - k]) / (2 sum_{k=1}^{K} k^2),
+/// with K shrinking near the edges. The weighted and the plain window sums
+/// are updated incrementally inside the blocks of kFrameBlock windows, and
+/// the chunks of kColumns elements are processed by different threads.
+class Delta : public UniformFormatOmpAwareTransform<formats::ArrayFormatF> {
  public:
   Delta();
 
@@ -86,10 +92,31 @@ class Delta : public UniformFormatTransform<formats::ArrayFormatF> {
       TP(rlength, int, kDefaultRegressionLength,
          "The linear regression window length. Only odd values "
          " greater than 1 are accepted.")
+      TP(append, bool, kDefaultAppend,
+         "Output the original values followed by the deltas.")
+      TP(acceleration, bool, kDefaultAcceleration,
+         "Also calculate the deltas of the deltas (delta-delta) in the same "
+         "pass and output them after the deltas.")
+
+  virtual void ResetState() const noexcept override;
+
+  virtual Overlap RequiredOverlap(const Overlap& output)
+      const noexcept override;
+
+  virtual InstructionSet SimdInstructionSet() const noexcept override;
 
  protected:
   static constexpr DeltaType kDefaultDeltaType = DeltaType::kSimple;
   static constexpr int kDefaultRegressionLength = 5;
+  static constexpr bool kDefaultAppend = false;
+  static constexpr bool kDefaultAcceleration = false;
+  /// @brief The number of elements processed together.
+  static constexpr int kColumns = 16;
+  /// @brief The number of windows after which the incrementally updated
+  /// sums are calculated again, so that the rounding errors do not add up.
+  static constexpr int kFrameBlock = 64;
+
+  virtual size_t OnFormatChanged(size_t buffersCount) override;
 
   virtual void Do(const BuffersBase<float*>& in,
                   BuffersBase<float*>* out) const noexcept override;
@@ -97,9 +124,28 @@ class Delta : public UniformFormatTransform<formats::ArrayFormatF> {
   static void DoSimple(bool simd, const float* prev, const float* cur,
                        size_t length, float* res) noexcept;
 
-  static void DoRegression(bool simd, const BuffersBase<float*>& in,
-                           int rstep, int i, float norm, int windowSize,
-                           BuffersBase<float*>* out) noexcept;
+  /// @brief Calculates the regression deltas of the windows [begin, end).
+  /// @param rows All the windows, offset is added to each of them.
+  /// @param count The number of windows.
+  /// @param width The number of elements to process, at most kColumns.
+  /// @param results The output windows, result_offset is added to each.
+  static void DoRegression(const float* const* rows, int offset, int count,
+                           int rstep, int begin, int end, int width,
+                           float* const* results,
+                           int result_offset) noexcept;
+
+ private:
+  void DoSimpleWindows(const float* const* rows, int offset, int count,
+                       std::vector<float>* last, float* const* results,
+                       int result_offset) const noexcept;
+  void DoRegressionColumns(const float* const* in, const float* const* outs,
+                           float* const* out, int count, int first,
+                           int width) const noexcept;
+
+  /// @brief The last window of the previous buffers in the streaming mode.
+  mutable std::vector<float> stream_last_;
+  /// @brief The last delta of the previous buffers in the streaming mode.
+  mutable std::vector<float> stream_last_delta_;
 };
 
 }  // namespace transforms
@@ -31,13 +31,12 @@
 #include "src/transforms/diff.h"
 #include <simd/instruction_set.h>
 #include <simd/wavelet.h>
-#include "src/make_unique.h"
+#include "src/scratch_arena.h"
 
 namespace sound_feature_extraction {
 namespace transforms {
 
-Diff::Diff()
-    : rectify_(false), swt_(kNoSWT), swt_buffer_(nullptr, std::free) {
+Diff::Diff() : rectify_(false), swt_(kNoSWT) {
 }
 
 ALWAYS_VALID_TP(Diff, rectify)
@@ -46,28 +45,21 @@ bool Diff::validate_swt(const int& value) noexcept {
   return value >= 1 || value == kNoSWT;
 }
 
-
-void Diff::Initialize() const {
-  if (swt_ != kNoSWT) {
-    swt_buffer_ = std::uniquify(mallocf(input_format_->Size()),
-                                std::free);
-  }
-}
-
 void Diff::Do(const float* in, float* out) const noexcept {
   if (swt_ != kNoSWT) {
-    // swt_buffer_ is shared among all the threads; we just do not care
-    // because it is not really used.
+    // The levels go back and forth between out and the scratch
+    auto scratch = ScratchArena::Acquire(input_format_->Size());
+    float* buffer = scratch.get();
     stationary_wavelet_apply(WAVELET_TYPE_DAUBECHIES, 2, 1,
                              EXTENSION_TYPE_CONSTANT, in, input_format_->Size(),
-                             swt_ == 1? out : swt_buffer_.get(),
-                             swt_ == 1? swt_buffer_.get() : out);
+                             swt_ == 1? out : buffer,
+                             swt_ == 1? buffer : out);
     for (int i = 2; i <= swt_; i++) {
       stationary_wavelet_apply(
           WAVELET_TYPE_DAUBECHIES, 2, i, EXTENSION_TYPE_CONSTANT,
           out, input_format_->Size(),
-          i == swt_? out : swt_buffer_.get(),
-          i == swt_? swt_buffer_.get() : out);
+          i == swt_? out : buffer,
+          i == swt_? buffer : out);
     }
     if (rectify_) {
       Rectify(use_simd(), out, input_format_->Size(), out);
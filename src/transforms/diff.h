@@ -52,8 +52,6 @@ class Diff : public OmpUniformFormatTransform<formats::ArrayFormatF> {
      "or equal to 0. If set to zero, this parameter is ignored.")
 
  protected:
-  virtual void Initialize() const override;
-
   virtual void Do(const float* in, float* out) const noexcept override;
 
   static void Do(bool simd, const float* input, int length,
@@ -66,9 +64,6 @@ class Diff : public OmpUniformFormatTransform<formats::ArrayFormatF> {
                       float* output) noexcept;
 
   static constexpr int kNoSWT = 0;
-
- private:
-  mutable FloatPtr swt_buffer_;
 };
 
 }  // namespace transforms
@@ -29,13 +29,17 @@
  */
 
 #include "src/transforms/dwpt.h"
-#include "src/make_unique.h"
+#include <algorithm>
+#include "src/scratch_arena.h"
+#include "src/shared_state.h"
 
 namespace sound_feature_extraction {
 namespace transforms {
 
 using primitives::WaveletFilterBank;
 
+constexpr int DWPT::kBatchSize;
+
 DWPT::DWPT()
     : tree_(kDefaultTreeFingerprint()),
       type_(kDefaultWaveletType),
@@ -65,15 +69,100 @@ size_t DWPT::OnFormatChanged(size_t buffersCount) {
 }
 
 void DWPT::Initialize() const {
-  filter_bank_ = std::make_unique<WaveletFilterBank>(
-      type_, order_, tree_);
   WaveletFilterBank::ValidateWavelet(type_, order_);
+  filter_bank_ = SharedState<WaveletFilterBank>(
+      "WaveletFilterBank " + std::to_string(type_) + ' ' +
+      std::to_string(order_) + ' ' + std::to_string(tree_), [this]() {
+    return std::make_shared<WaveletFilterBank>(type_, order_, tree_);
+  });
 }
 
-void DWPT::Do(const float* in,
-              float* out) const noexcept {
+void DWPT::Do(const BuffersBase<float*>& in,
+              BuffersBase<float*>* out) const noexcept {
   assert(filter_bank_ != nullptr && "Initialize() was not called");
-  filter_bank_->Apply(in, input_format_->Size(), out);
+  int count = in.Count();
+  int batches = (count + kBatchSize - 1) / kBatchSize;
+  this->ParallelFor(batches, [&](int begin, int end) {
+    for (int b = begin; b < end; b++) {
+      const float* ins[kBatchSize];
+      float* outs[kBatchSize];
+      int size = std::min(kBatchSize, count - b * kBatchSize);
+      for (int i = 0; i < size; i++) {
+        ins[i] = in[b * kBatchSize + i];
+        outs[i] = (*out)[b * kBatchSize + i];
+      }
+      auto scratch = ScratchArena::Acquire(
+          WaveletFilterBank::BatchScratchSize(input_format_->Size()));
+      filter_bank_->ApplyBatch(use_simd(), ins, size, input_format_->Size(),
+                               scratch.get(), outs);
+    }
+  });
+}
+
+InstructionSet DWPT::SimdInstructionSet() const noexcept {
+#ifdef SIMD_X86
+  if (IsEnabled(InstructionSet::kAVX512)) {
+    return InstructionSet::kAVX512;
+  }
+  if (IsEnabled(InstructionSet::kAVX)) {
+    return InstructionSet::kAVX;
+  }
+#elif defined(SIMD_NEON)
+  if (IsEnabled(InstructionSet::kNEON)) {
+    return InstructionSet::kNEON;
+  }
+#endif
+  return InstructionSet::kScalar;
+}
+
+const std::shared_ptr<const WaveletFilterBank>& DWPT::filter_bank()
+    const noexcept {
+  return filter_bank_;
+}
+
+constexpr int DWPTSubbandEnergy::kBatchSize;
+
+DWPTSubbandEnergy::DWPTSubbandEnergy(const std::shared_ptr<Transform>& dwpt)
+    : dwpt_(std::dynamic_pointer_cast<DWPT>(dwpt)) {
+  assert(dwpt_);
+}
+
+size_t DWPTSubbandEnergy::OnFormatChanged(size_t buffersCount) {
+  buffersCount = dwpt_->SetInputFormat(input_format_, buffersCount);
+  output_format_->SetSize(dwpt_->tree().size());
+  return buffersCount;
+}
+
+void DWPTSubbandEnergy::Initialize() const {
+  dwpt_->Initialize();
+}
+
+void DWPTSubbandEnergy::Do(const BuffersBase<float*>& in,
+                           BuffersBase<float*>* out) const noexcept {
+  auto& filter_bank = dwpt_->filter_bank();
+  assert(filter_bank != nullptr && "Initialize() was not called");
+  int count = in.Count();
+  int batches = (count + kBatchSize - 1) / kBatchSize;
+  this->ParallelFor(batches, [&](int begin, int end) {
+    for (int b = begin; b < end; b++) {
+      const float* ins[kBatchSize];
+      float* outs[kBatchSize];
+      int size = std::min(kBatchSize, count - b * kBatchSize);
+      for (int i = 0; i < size; i++) {
+        ins[i] = in[b * kBatchSize + i];
+        outs[i] = (*out)[b * kBatchSize + i];
+      }
+      auto scratch = ScratchArena::Acquire(
+          WaveletFilterBank::BatchScratchSize(input_format_->Size()));
+      filter_bank->ApplyBatchEnergy(use_simd(), ins, size,
+                                    input_format_->Size(), scratch.get(),
+                                    outs);
+    }
+  });
+}
+
+InstructionSet DWPTSubbandEnergy::SimdInstructionSet() const noexcept {
+  return dwpt_->SimdInstructionSet();
 }
 
 RTP(DWPT, tree)
@@ -64,7 +64,9 @@ namespace transforms {
 ///             |
 ///             ------ 3
 ///
-class DWPT : public OmpUniformFormatTransform<formats::ArrayFormatF> {
+/// The frames are transformed in batches of kBatchSize through
+/// WaveletFilterBank::ApplyBatch(), several frames in the SIMD lanes.
+class DWPT : public UniformFormatOmpAwareTransform<formats::ArrayFormatF> {
  public:
   DWPT();
 
@@ -80,11 +82,17 @@ class DWPT : public OmpUniformFormatTransform<formats::ArrayFormatF> {
 
   virtual void Initialize() const override;
 
+  virtual InstructionSet SimdInstructionSet() const noexcept override;
+
+  /// @brief The filter bank which Initialize() prepares.
+  const std::shared_ptr<const primitives::WaveletFilterBank>& filter_bank()
+      const noexcept;
+
  protected:
   virtual size_t OnFormatChanged(size_t buffersCount) override;
 
-  virtual void Do(const float* in,
-                  float* out) const noexcept override;
+  virtual void Do(const BuffersBase<float*>& in,
+                  BuffersBase<float*>* out) const noexcept override;
 
   static TreeFingerprint kDefaultTreeFingerprint() noexcept {
     return TreeFingerprint {
@@ -94,9 +102,46 @@ class DWPT : public OmpUniformFormatTransform<formats::ArrayFormatF> {
   };
   static constexpr WaveletType kDefaultWaveletType = WAVELET_TYPE_DAUBECHIES;
   static constexpr int kDefaultWaveletOrder = 8;
+  /// @brief The number of frames passed to one ApplyBatch() call.
+  static constexpr int kBatchSize = 64;
+
+ private:
+  /// @brief Shared by all the transforms with the same wavelet and tree.
+  mutable std::shared_ptr<const primitives::WaveletFilterBank> filter_bank_;
+};
+
+/// @brief DWPT followed by SubbandEnergy with the same tree, which never
+/// stores the subbands.
+/// @details TransformTree creates this transform instead of such pairs of
+/// nodes, it is not registered in the factory. The leaves are reduced to
+/// the sums of squares by WaveletFilterBank::ApplyBatchEnergy() while they
+/// are in the scratch, which holds one batch of the tree levels only.
+class DWPTSubbandEnergy
+    : public UniformFormatOmpAwareTransform<formats::ArrayFormatF> {
+ public:
+  /// @param dwpt The DWPT to execute.
+  explicit DWPTSubbandEnergy(const std::shared_ptr<Transform>& dwpt);
+
+  TRANSFORM_INTRO("SubbandEnergy", "Calculates the subband energies of "
+                                   "Discrete Wavelet Packet Transform "
+                                   "(DWPT -> SubbandEnergy).",
+                  DWPTSubbandEnergy)
+
+  virtual void Initialize() const override;
+
+  virtual InstructionSet SimdInstructionSet() const noexcept override;
+
+ protected:
+  virtual size_t OnFormatChanged(size_t buffersCount) override;
+
+  virtual void Do(const BuffersBase<float*>& in,
+                  BuffersBase<float*>* out) const noexcept override;
+
+  /// @brief The number of frames passed to one ApplyBatchEnergy() call.
+  static constexpr int kBatchSize = 64;
 
  private:
-  mutable std::unique_ptr<primitives::WaveletFilterBank> filter_bank_;
+  std::shared_ptr<DWPT> dwpt_;
 };
 
 }  // namespace transforms
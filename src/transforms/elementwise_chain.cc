@@ -0,0 +1,156 @@
+/*! @file elementwise_chain.cc
+ *  @brief Several elementwise transforms applied in a single pass.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#include "src/transforms/elementwise_chain.h"
+#include <algorithm>
+#include <cstring>
+
+namespace sound_feature_extraction {
+namespace transforms {
+
+constexpr int ElementwiseChain::kTileLength;
+
+void ElementwiseChain::AddStage(const std::shared_ptr<Transform>& stage) {
+  auto kernel = dynamic_cast<const ElementwiseTransform*>(stage.get());
+  if (kernel == nullptr) {
+    throw NotElementwiseTransformException(stage->Name());
+  }
+  stages_.push_back(stage);
+  kernels_.push_back(kernel);
+}
+
+const std::vector<std::shared_ptr<Transform>>& ElementwiseChain::stages()
+    const noexcept {
+  return stages_;
+}
+
+size_t ElementwiseChain::OnFormatChanged(size_t buffersCount) {
+  for (auto& stage : stages_) {
+    stage->SetInputFormat(input_format_, buffersCount);
+  }
+  return buffersCount;
+}
+
+void ElementwiseChain::Initialize() const {
+  for (auto& stage : stages_) {
+    stage->Initialize();
+  }
+}
+
+bool ElementwiseChain::InPlace() const noexcept {
+  return true;
+}
+
+void ElementwiseChain::DoTile(const float* in, int length,
+                              float* out) const noexcept {
+  if (kernels_.empty()) {
+    if (in != out) {
+      memcpy(out, in, length * sizeof(in[0]));
+    }
+    return;
+  }
+  kernels_.front()->DoElementwise(in, length, out);
+  for (size_t i = 1; i < kernels_.size(); i++) {
+    kernels_[i]->DoElementwise(out, length, out);
+  }
+}
+
+void ElementwiseChain::Do(const float* in, float* out) const noexcept {
+  int length = input_format_->Size();
+  for (int offset = 0; offset < length; offset += kTileLength) {
+    DoTile(in + offset, std::min(kTileLength, length - offset), out + offset);
+  }
+}
+
+template <class T>
+static std::shared_ptr<Transform> NarrowingChain(
+    const std::vector<std::shared_ptr<Transform>>& stages,
+    const std::shared_ptr<Transform>& narrowing) {
+  auto chain = std::make_shared<ElementwiseNarrowingChain<T>>(narrowing);
+  for (auto& stage : stages) {
+    chain->AddStage(stage);
+  }
+  return chain;
+}
+
+bool IsNarrowing(const Transform& transform) noexcept {
+  return dynamic_cast<const NarrowingTransform<formats::Float16>*>(
+             &transform) != nullptr ||
+         dynamic_cast<const NarrowingTransform<formats::BFloat16>*>(
+             &transform) != nullptr ||
+         dynamic_cast<const NarrowingTransform<int8_t>*>(
+             &transform) != nullptr;
+}
+
+std::shared_ptr<Transform> CreateNarrowingChain(
+    const std::vector<std::shared_ptr<Transform>>& stages,
+    const std::shared_ptr<Transform>& narrowing) {
+  if (dynamic_cast<const NarrowingTransform<formats::Float16>*>(
+          narrowing.get()) != nullptr) {
+    return NarrowingChain<formats::Float16>(stages, narrowing);
+  }
+  if (dynamic_cast<const NarrowingTransform<formats::BFloat16>*>(
+          narrowing.get()) != nullptr) {
+    return NarrowingChain<formats::BFloat16>(stages, narrowing);
+  }
+  return NarrowingChain<int8_t>(stages, narrowing);
+}
+
+template <class T>
+static std::shared_ptr<Transform> WideningChain(
+    const std::shared_ptr<Transform>& widening,
+    const std::vector<std::shared_ptr<Transform>>& stages) {
+  auto chain = std::make_shared<ElementwiseWideningChain<T>>(widening);
+  for (auto& stage : stages) {
+    chain->AddStage(stage);
+  }
+  return chain;
+}
+
+bool IsWidening(const Transform& transform) noexcept {
+  return dynamic_cast<const WideningTransform<int16_t>*>(
+             &transform) != nullptr ||
+         dynamic_cast<const WideningTransform<int32_t>*>(
+             &transform) != nullptr;
+}
+
+std::shared_ptr<Transform> CreateWideningChain(
+    const std::shared_ptr<Transform>& widening,
+    const std::vector<std::shared_ptr<Transform>>& stages) {
+  if (dynamic_cast<const WideningTransform<int16_t>*>(
+          widening.get()) != nullptr) {
+    return WideningChain<int16_t>(widening, stages);
+  }
+  return WideningChain<int32_t>(widening, stages);
+}
+
+}  // namespace transforms
+}  // namespace sound_feature_extraction
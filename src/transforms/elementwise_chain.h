@@ -0,0 +1,298 @@
+/*! @file elementwise_chain.h
+ *  @brief Several elementwise transforms applied in a single pass.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#ifndef SRC_TRANSFORMS_ELEMENTWISE_CHAIN_H_
+#define SRC_TRANSFORMS_ELEMENTWISE_CHAIN_H_
+
+#include <algorithm>
+#include <vector>
+#include "src/elementwise_transform.h"
+#include "src/formats/reduced_precision.h"
+#include "src/transforms/common.h"
+#include "src/transforms/scale.h"
+
+namespace sound_feature_extraction {
+namespace transforms {
+
+class NotElementwiseTransformException : public ExceptionBase {
+ public:
+  explicit NotElementwiseTransformException(const std::string& name)
+  : ExceptionBase("Transform \"" + name + "\" is not elementwise.") {
+  }
+};
+
+class NotNarrowingTransformException : public ExceptionBase {
+ public:
+  explicit NotNarrowingTransformException(const std::string& name)
+  : ExceptionBase("Transform \"" + name + "\" is not narrowing.") {
+  }
+};
+
+class NotWideningTransformException : public ExceptionBase {
+ public:
+  explicit NotWideningTransformException(const std::string& name)
+  : ExceptionBase("Transform \"" + name + "\" is not widening.") {
+  }
+};
+
+/// @brief Applies the stages one after another to each tile of the buffer.
+/// @details TransformTree creates this transform instead of the chains of
+/// ElementwiseTransform nodes, it is not registered in the factory.
+class ElementwiseChain
+    : public OmpUniformFormatTransform<formats::ArrayFormatF> {
+ public:
+  TRANSFORM_INTRO("ElementwiseChain",
+                  "Applies several elementwise transforms in a single pass.",
+                  ElementwiseChain)
+
+  /// @brief Appends the transform to the chain. It must implement
+  /// ElementwiseTransform.
+  void AddStage(const std::shared_ptr<Transform>& stage);
+
+  const std::vector<std::shared_ptr<Transform>>& stages() const noexcept;
+
+  virtual void Initialize() const override;
+
+  virtual bool InPlace() const noexcept override;
+
+  /// @brief Applies all the stages to a single tile. Copies the values
+  /// if the chain is empty.
+  /// @param in The aligned input array.
+  /// @param length The number of values, at most kTileLength.
+  /// @param out The aligned output array, may be equal to in.
+  void DoTile(const float* in, int length, float* out) const noexcept;
+
+  /// @brief The number of values which pass through all the stages at once.
+  static constexpr int kTileLength = 1024;
+
+ protected:
+  virtual size_t OnFormatChanged(size_t buffersCount) override;
+
+  virtual void Do(const float* in,
+                  float* out) const noexcept override;
+
+ private:
+  std::vector<std::shared_ptr<Transform>> stages_;
+  std::vector<const ElementwiseTransform*> kernels_;
+};
+
+/// @brief ElementwiseChain followed by a NarrowingTransform<T> which
+/// converts each tile while it is still in the cache.
+/// @details TransformTree creates this transform instead of the chains of
+/// ElementwiseTransform nodes which end with a narrowing node, it is not
+/// registered in the factory.
+template <class T>
+class ElementwiseNarrowingChain
+    : public OmpTransformBase<formats::ArrayFormatF, formats::ArrayFormat<T>> {
+ public:
+  TRANSFORM_INTRO("ElementwiseNarrowingChain",
+                  "Applies several elementwise transforms and the narrowing "
+                  "conversion in a single pass.",
+                  ElementwiseNarrowingChain<T>)
+
+  /// @brief Sets the final transform, it must implement
+  /// NarrowingTransform<T>.
+  explicit ElementwiseNarrowingChain(
+      const std::shared_ptr<Transform>& narrowing)
+      : narrowing_(narrowing),
+        kernel_(dynamic_cast<const NarrowingTransform<T>*>(narrowing.get())) {
+    if (kernel_ == nullptr) {
+      throw NotNarrowingTransformException(narrowing->Name());
+    }
+  }
+
+  /// @brief Appends the transform to the chain. It must implement
+  /// ElementwiseTransform.
+  void AddStage(const std::shared_ptr<Transform>& stage) {
+    chain_.AddStage(stage);
+  }
+
+  const std::vector<std::shared_ptr<Transform>>& stages() const noexcept {
+    return chain_.stages();
+  }
+
+  const std::shared_ptr<Transform>& narrowing() const noexcept {
+    return narrowing_;
+  }
+
+  virtual void Initialize() const override {
+    chain_.Initialize();
+    narrowing_->Initialize();
+  }
+
+ protected:
+  virtual size_t OnInputFormatChanged(size_t buffersCount) override {
+    chain_.SetInputFormat(this->input_format_, buffersCount);
+    narrowing_->SetInputFormat(this->input_format_, buffersCount);
+    this->output_format_->SetSize(this->input_format_->Size());
+    return buffersCount;
+  }
+
+  virtual void Do(const float* in, T* out) const noexcept override {
+    float tile[ElementwiseChain::kTileLength] __attribute__((aligned(64)));
+    int length = this->input_format_->Size();
+    for (int offset = 0; offset < length;
+         offset += ElementwiseChain::kTileLength) {
+      int size = std::min(ElementwiseChain::kTileLength, length - offset);
+      chain_.DoTile(in + offset, size, tile);
+      kernel_->DoNarrowing(tile, size, out + offset);
+    }
+  }
+
+ private:
+  ElementwiseChain chain_;
+  std::shared_ptr<Transform> narrowing_;
+  const NarrowingTransform<T>* kernel_;
+};
+
+/// @brief A WideningTransform<T> converter followed by ElementwiseChain
+/// which runs on each converted tile while it is still in the cache.
+/// @details TransformTree creates this transform instead of the converter
+/// nodes which are followed by the chains of ElementwiseTransform nodes,
+/// it is not registered in the factory. The leading Scale stage is applied
+/// by the converter itself.
+template <class T>
+class ElementwiseWideningChain
+    : public OmpTransformBase<formats::ArrayFormat<T>, formats::ArrayFormatF> {
+ public:
+  TRANSFORM_INTRO("ElementwiseWideningChain",
+                  "Converts to floating point and applies several "
+                  "elementwise transforms in a single pass.",
+                  ElementwiseWideningChain<T>)
+
+  /// @brief Sets the converter, it must implement WideningTransform<T>.
+  explicit ElementwiseWideningChain(
+      const std::shared_ptr<Transform>& widening)
+      : widening_(widening),
+        kernel_(dynamic_cast<const WideningTransform<T>*>(widening.get())),
+        scale_(1), offset_(0) {
+    if (kernel_ == nullptr) {
+      throw NotWideningTransformException(widening->Name());
+    }
+  }
+
+  /// @brief Appends the transform to the chain. It must implement
+  /// ElementwiseTransform.
+  void AddStage(const std::shared_ptr<Transform>& stage) {
+    auto scale = dynamic_cast<const Scale*>(stage.get());
+    if (scale != nullptr && chain_.stages().empty() && folded_ == nullptr) {
+      folded_ = stage;
+      scale_ = scale->scale();
+      offset_ = scale->offset();
+      return;
+    }
+    chain_.AddStage(stage);
+  }
+
+  /// @brief Returns the stages which follow the conversion, excluding
+  /// the folded Scale.
+  const std::vector<std::shared_ptr<Transform>>& stages() const noexcept {
+    return chain_.stages();
+  }
+
+  const std::shared_ptr<Transform>& widening() const noexcept {
+    return widening_;
+  }
+
+  /// @brief The multiplier which the converter applies.
+  float scale() const noexcept {
+    return scale_;
+  }
+
+  /// @brief The addend which the converter applies.
+  float offset() const noexcept {
+    return offset_;
+  }
+
+  virtual void Initialize() const override {
+    widening_->Initialize();
+    if (folded_ != nullptr) {
+      folded_->Initialize();
+    }
+    chain_.Initialize();
+  }
+
+ protected:
+  virtual size_t OnInputFormatChanged(size_t buffersCount) override {
+    widening_->SetInputFormat(this->input_format_, buffersCount);
+    if (folded_ != nullptr) {
+      folded_->SetInputFormat(widening_->OutputFormat(), buffersCount);
+    }
+    chain_.SetInputFormat(widening_->OutputFormat(), buffersCount);
+    this->output_format_->SetSize(this->input_format_->Size());
+    return buffersCount;
+  }
+
+  virtual void Do(const T* in, float* out) const noexcept override {
+    bool empty = chain_.stages().empty();
+    int length = this->input_format_->Size();
+    for (int offset = 0; offset < length;
+         offset += ElementwiseChain::kTileLength) {
+      int size = std::min(ElementwiseChain::kTileLength, length - offset);
+      kernel_->DoWidening(in + offset, size, scale_, offset_, out + offset);
+      if (!empty) {
+        chain_.DoTile(out + offset, size, out + offset);
+      }
+    }
+  }
+
+ private:
+  std::shared_ptr<Transform> widening_;
+  const WideningTransform<T>* kernel_;
+  std::shared_ptr<Transform> folded_;
+  float scale_;
+  float offset_;
+  ElementwiseChain chain_;
+};
+
+/// @brief Checks whether the transform implements WideningTransform of
+/// int16_t or int32_t.
+bool IsWidening(const Transform& transform) noexcept;
+
+/// @brief Creates ElementwiseWideningChain of the converter (see
+/// IsWidening()) and the stages which follow it.
+std::shared_ptr<Transform> CreateWideningChain(
+    const std::shared_ptr<Transform>& widening,
+    const std::vector<std::shared_ptr<Transform>>& stages);
+
+/// @brief Checks whether the transform implements NarrowingTransform of
+/// any of the reduced precision element types.
+bool IsNarrowing(const Transform& transform) noexcept;
+
+/// @brief Creates ElementwiseNarrowingChain of the stages, which ends with
+/// the narrowing transform (see IsNarrowing()).
+std::shared_ptr<Transform> CreateNarrowingChain(
+    const std::vector<std::shared_ptr<Transform>>& stages,
+    const std::shared_ptr<Transform>& narrowing);
+
+}  // namespace transforms
+}  // namespace sound_feature_extraction
+#endif  // SRC_TRANSFORMS_ELEMENTWISE_CHAIN_H_
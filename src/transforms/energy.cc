@@ -40,7 +40,46 @@ void Energy::Do(const float* in, float* out) const noexcept {
   *out = calculate_energy(use_simd(), true, in, length);
 }
 
+InstructionSet Energy::SimdInstructionSet() const noexcept {
+  if (IsEnabled(InstructionSet::kAVX512)) {
+    return InstructionSet::kAVX512;
+  }
+#ifdef __AVX__
+  if (IsEnabled(InstructionSet::kAVX)) {
+    return InstructionSet::kAVX;
+  }
+#elif defined(SIMD_NEON)
+  if (IsEnabled(InstructionSet::kNEON)) {
+    return InstructionSet::kNEON;
+  }
+#endif
+  return InstructionSet::kScalar;
+}
+
+void Energy16::Do(const int16_t* in, float* out) const noexcept {
+  int length = input_format_->Size();
+  *out = static_cast<float>(calculate_energy16(use_simd(), in, length)) /
+      length;
+}
+
+InstructionSet Energy16::SimdInstructionSet() const noexcept {
+#ifdef SIMD_X86
+  if (IsEnabled(InstructionSet::kAVX512)) {
+    return InstructionSet::kAVX512;
+  }
+  if (IsEnabled(InstructionSet::kAVX2)) {
+    return InstructionSet::kAVX2;
+  }
+#elif defined(SIMD_NEON)
+  if (IsEnabled(InstructionSet::kNEON)) {
+    return InstructionSet::kNEON;
+  }
+#endif
+  return InstructionSet::kScalar;
+}
+
 REGISTER_TRANSFORM(Energy);
+REGISTER_TRANSFORM(Energy16);
 
 }  // namespace transforms
 }  // namespace sound_feature_extraction
@@ -42,11 +42,27 @@ class Energy : public OmpTransformBase<formats::ArrayFormatF,
  public:
   TRANSFORM_INTRO("Energy", "Sound energy calculation.", Energy)
 
+  virtual InstructionSet SimdInstructionSet() const noexcept override;
+
  protected:
   virtual void Do(const float* in,
                   float* out) const noexcept override;
 };
 
+/// @brief Calculates the energy of 16-bit frames directly, so that
+/// the integer samples need not be converted to floats beforehand.
+class Energy16 : public OmpTransformBase<formats::ArrayFormat16,
+                                      formats::SingleFormatF> {
+ public:
+  TRANSFORM_INTRO("Energy", "Sound energy calculation.", Energy16)
+
+  virtual InstructionSet SimdInstructionSet() const noexcept override;
+
+ protected:
+  virtual void Do(const int16_t* in,
+                  float* out) const noexcept override;
+};
+
 }  // namespace transforms
 }  // namespace sound_feature_extraction
 #endif  // SRC_TRANSFORMS_ENERGY_H_
@@ -29,12 +29,15 @@
  */
 
 #include "src/transforms/filter_bank.h"
+#include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <sstream>
 #include <simd/arithmetic-inl.h>
+#include <simd/instruction_set.h>
 #include "src/transforms/filter_base.h"
-#include "src/primitives/energy.h"
 #include "src/make_unique.h"
+#include "src/shared_state.h"
 
 namespace sound_feature_extraction {
 namespace transforms {
@@ -55,6 +58,8 @@ ScaleType Parse(const std::string& value, identity<ScaleType>) {
 
 constexpr ScaleType FilterBank::kDefaultScale;
 constexpr float FilterBank::kMidiFreqs[];
+constexpr int FilterBank::kFramesBlock;
+constexpr int FilterBank::kRowAlignment;
 
 FilterBank::FilterBank()
     : type_(kDefaultScale),
@@ -160,7 +165,7 @@ float FilterBank::ScaleToLinear(ScaleType type, float value) {
 }
 
 void FilterBank::CalcTriangularFilter(float center, float halfWidth,
-                                      Filter* out) const {
+                                      float* weights, Filter* out) const {
   float left_freq = ScaleToLinear(type_, center - halfWidth);
   float center_freq = ScaleToLinear(type_, center);
   float right_freq = ScaleToLinear(type_, center + halfWidth);
@@ -211,38 +216,20 @@ void FilterBank::CalcTriangularFilter(float center, float halfWidth,
       // Right slope
       value += dist;
     }
-    out->data[i - left_index] = value;
+    weights[i - left_index] = value;
   }
-  out->data[roundf(center_index) - left_index] = 1.f;
+  weights[static_cast<int>(roundf(center_index)) - left_index] = 1.f;
 }
 
 void FilterBank::Initialize() const {
-  filter_bank_.resize(number_);
-  int count = threads_number();
-  buffers_.resize(count);
-  for (int i = 0; i < count; i++) {
-    buffers_[i].data = std::uniquify(mallocf(input_format_->Size()),
-                                     std::free);
-  }
-
-  float scaleMin = LinearToScale(type_, frequency_min_);
-  float scaleMax = LinearToScale(type_, frequency_max_);
-  float dsc = (scaleMax - scaleMin) / (number_ + 1);
-
-  for (int i = 0; i < number_; i++) {
-    filter_bank_[i].data = std::uniquify(mallocf(input_format_->Size()),
-                                         std::free);
-    CalcTriangularFilter(scaleMin + dsc * (i + 1), dsc, &filter_bank_[i]);
-  }
-
-  if (squared_) {
-    for (int i = 0; i < number_; i++) {
-      real_multiply_array(filter_bank_[i].data.get(),
-                          filter_bank_[i].data.get(),
-                          filter_bank_[i].end - filter_bank_[i].begin + 1,
-                          filter_bank_[i].data.get());
-    }
+  if (loaded_state_) {
+    return;
   }
+  auto filters = SharedState<SharedFilters>(StateKey(), [this]() {
+    return CalculateFilters();
+  });
+  filter_bank_ = filters->Filters;
+  weights_ = filters;
   if (debug_) {
     std::stringstream ss;
     for (int i = 0; i < number_; i++) {
@@ -263,6 +250,98 @@ void FilterBank::Initialize() const {
   }
 }
 
+std::shared_ptr<const FilterBank::SharedFilters>
+FilterBank::CalculateFilters() const {
+  auto filters = std::make_shared<SharedFilters>();
+  auto& filter_bank = filters->Filters;
+  filter_bank.resize(number_);
+
+  float scaleMin = LinearToScale(type_, frequency_min_);
+  float scaleMax = LinearToScale(type_, frequency_max_);
+  float dsc = (scaleMax - scaleMin) / (number_ + 1);
+
+  // Calculate the filters one by one, then pack all of them into a single
+  // block with aligned rows
+  std::vector<float> filter(input_format_->Size());
+  std::vector<float> packed;
+  std::vector<size_t> offsets(number_);
+  for (int i = 0; i < number_; i++) {
+    CalcTriangularFilter(scaleMin + dsc * (i + 1), dsc, filter.data(),
+                         &filter_bank[i]);
+    int length = filter_bank[i].end - filter_bank[i].begin + 1;
+    if (squared_) {
+      real_multiply_array(filter.data(), filter.data(), length,
+                          filter.data());
+    }
+    offsets[i] = packed.size();
+    packed.insert(packed.end(), filter.begin(), filter.begin() + length);
+    packed.resize((packed.size() + kRowAlignment - 1) & ~(kRowAlignment - 1),
+                  0.f);
+  }
+  filters->Weights = std::uniquify(
+      mallocf(std::max(packed.size(), size_t(1))), std::free);
+  memcpy(filters->Weights.get(), packed.data(),
+         packed.size() * sizeof(float));
+  for (int i = 0; i < number_; i++) {
+    filter_bank[i].data = filters->Weights.get() + offsets[i];
+  }
+  return filters;
+}
+
+size_t FilterBank::RowLength(const Filter& filter) noexcept {
+  return (filter.end - filter.begin + 1 + kRowAlignment - 1) &
+      ~(kRowAlignment - 1);
+}
+
+size_t FilterBank::StateHeaderSize() const noexcept {
+  return (sizeof(int32_t) * (1 + 2 * number_) + kAlignment - 1) &
+      ~(kAlignment - 1);
+}
+
+void FilterBank::SaveState(std::string* out) const {
+  // The rows bounds, then the padded rows in the same order
+  std::string state(StateHeaderSize(), 0);
+  auto header = reinterpret_cast<int32_t*>(&state[0]);
+  header[0] = number_;
+  for (int i = 0; i < number_; i++) {
+    header[1 + i * 2] = filter_bank_[i].begin;
+    header[2 + i * 2] = filter_bank_[i].end;
+  }
+  for (int i = 0; i < number_; i++) {
+    state.append(reinterpret_cast<const char*>(filter_bank_[i].data),
+                 RowLength(filter_bank_[i]) * sizeof(float));
+  }
+  *out += state;
+}
+
+bool FilterBank::LoadState(const std::shared_ptr<const void>& owner,
+                           const char* data, size_t size) const {
+  auto header = reinterpret_cast<const int32_t*>(data);
+  if (size < sizeof(int32_t) || header[0] != number_ ||
+      size < StateHeaderSize()) {
+    return false;
+  }
+  std::vector<Filter> filters(number_);
+  size_t offset = StateHeaderSize();
+  for (int i = 0; i < number_; i++) {
+    filters[i].begin = header[1 + i * 2];
+    filters[i].end = header[2 + i * 2];
+    if (filters[i].begin < 0 || filters[i].end < filters[i].begin ||
+        filters[i].end >= static_cast<int>(input_format_->Size())) {
+      return false;
+    }
+    filters[i].data = reinterpret_cast<const float*>(data + offset);
+    offset += RowLength(filters[i]) * sizeof(float);
+    if (offset > size) {
+      return false;
+    }
+  }
+  filter_bank_.swap(filters);
+  weights_.reset();
+  loaded_state_ = owner;
+  return true;
+}
+
 size_t FilterBank::OnInputFormatChanged(size_t buffersCount) {
   size_t start = frequency_min_ * 2 * input_format_->Size() /
       input_format_->SamplingRate();
@@ -276,24 +355,101 @@ size_t FilterBank::OnInputFormatChanged(size_t buffersCount) {
   return buffersCount;
 }
 
-void FilterBank::Do(const float* in, float* out) const noexcept {
-  bool executed = false;
-  while (!executed) {
-    for (auto& buf : buffers_) {
-      if (buf.mutex.try_lock()) {
-        for (int i = 0; i < number_; i++) {
-          size_t length = filter_bank_[i].end - filter_bank_[i].begin + 1;
-          real_multiply_array(in + filter_bank_[i].begin,
-                              filter_bank_[i].data.get(),
-                              length, buf.data.get());
-          out[i] = calculate_energy(use_simd(), false, buf.data.get(), length);
+ElementRange FilterBank::RequiredElements(const ElementRange&)
+    const noexcept {
+  // The filters span [frequency_min, frequency_max] (see
+  // CalcTriangularFilter()), the margin covers the scale conversion errors
+  const float df = input_format_->SamplingRate() /
+      (2.f * input_format_->Size());
+  size_t begin = frequency_min_ / df;
+  size_t end = frequency_max_ / df + 3;
+  return { begin > 2? begin - 2 : 0,
+           std::min(end, input_format_->Size()) };
+}
+
+void FilterBank::Do(const BuffersBase<float*>& in,
+                    BuffersBase<float*>* out) const noexcept {
+  int count = in.Count();
+  int blocks = (count + kFramesBlock - 1) / kFramesBlock;
+  ParallelFor(blocks, [&](int begin, int end) {
+    for (int block = begin; block < end; block++) {
+      int first = block * kFramesBlock;
+      int last = std::min(first + kFramesBlock, count);
+      for (const auto& filter : filter_bank_) {
+        int index = &filter - &filter_bank_[0];
+        int length = filter.end - filter.begin + 1;
+        for (int frame = first; frame < last; frame++) {
+          (*out)[frame][index] = FilterEnergy(
+              use_simd(), in[frame] + filter.begin, filter.data, length);
         }
-        buf.mutex.unlock();
-        executed = true;
-        break;
       }
     }
+  });
+}
+
+void FilterBank::Do(const float* in, float* out) const noexcept {
+  for (int i = 0; i < number_; i++) {
+    out[i] = FilterEnergy(use_simd(), in + filter_bank_[i].begin,
+                          filter_bank_[i].data,
+                          filter_bank_[i].end - filter_bank_[i].begin + 1);
+  }
+}
+
+float FilterBank::FilterEnergy(bool simd, const float* in,
+                               const float* weights, int length) noexcept {
+  if (simd) {
+#ifdef __AVX__
+    __m256 sum = _mm256_setzero_ps();
+    for (int i = 0; i < length - 7; i += 8) {
+      __m256 vec = _mm256_mul_ps(_mm256_loadu_ps(in + i),
+                                 _mm256_load_ps(weights + i));
+#ifndef __AVX2__
+      sum = _mm256_add_ps(sum, _mm256_mul_ps(vec, vec));
+#else
+      sum = _mm256_fmadd_ps(vec, vec, sum);
+#endif
+    }
+    sum = _mm256_hadd_ps(sum, sum);
+    sum = _mm256_hadd_ps(sum, sum);
+    float res = _mm256_get_ps(sum, 0) + _mm256_get_ps(sum, 4);
+    for (int i = (length & ~0x7); i < length; i++) {
+      float val = in[i] * weights[i];
+      res += val * val;
+    }
+    return res;
+  } else {
+#elif defined(__ARM_NEON__)
+    float32x4_t sum = vdupq_n_f32(0.f);
+    for (int i = 0; i < length - 3; i += 4) {
+      float32x4_t vec = vmulq_f32(vld1q_f32(in + i), vld1q_f32(weights + i));
+      sum = vmlaq_f32(sum, vec, vec);
+    }
+    float32x2_t sum2 = vpadd_f32(vget_high_f32(sum), vget_low_f32(sum));
+    float res = vget_lane_f32(sum2, 0) + vget_lane_f32(sum2, 1);
+    for (int i = (length & ~0x3); i < length; i++) {
+      float val = in[i] * weights[i];
+      res += val * val;
+    }
+    return res;
+  } else {
+#else
+  } {
+#endif
+    float res = 0.f;
+    for (int i = 0; i < length; i++) {
+      float val = in[i] * weights[i];
+      res += val * val;
+    }
+    return res;
+  }
+}
+
+size_t FilterBank::PrivateMemorySize() const noexcept {
+  size_t size = filter_bank_.size() * sizeof(Filter);
+  for (auto& filter : filter_bank_) {
+    size += RowLength(filter) * sizeof(float);
   }
+  return size;
 }
 
 RTP(FilterBank, type)
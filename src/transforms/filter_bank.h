@@ -33,6 +33,7 @@
 
 #include "src/transforms/common.h"
 #include <vector>
+#include "src/precomputed_state.h"
 
 namespace sound_feature_extraction {
 namespace transforms {
@@ -91,9 +92,17 @@ class InvalidFrequencyRangeException : public ExceptionBase {
   }
 };
 
-class FilterBank : public OmpTransformBase<formats::ArrayFormatF,
-                                           formats::ArrayFormatF>,
-                   public TransformLogger<FilterBank> {
+/// @brief Applies a bank of triangular filters to the spectrum and
+/// calculates the energy in each band.
+/// @details All the filters are stored in a single contiguous block, one
+/// padded and aligned row of nonzero weights per filter. The frames are
+/// processed in blocks of kFramesBlock so that each row is loaded into
+/// the cache once per block instead of once per frame. The block is saved
+/// together with the prepared tree (see PrecomputedState).
+class FilterBank : public OmpAwareTransform<formats::ArrayFormatF,
+                                            formats::ArrayFormatF>,
+                   public TransformLogger<FilterBank>,
+                   public PrecomputedState {
  public:
   FilterBank();
 
@@ -115,17 +124,39 @@ class FilterBank : public OmpTransformBase<formats::ArrayFormatF,
 
   virtual void Initialize() const override;
 
+  virtual size_t PrivateMemorySize() const noexcept override;
+
+  virtual Overlap RequiredOverlap(const Overlap& output)
+      const noexcept override {
+    return output;
+  }
+
+  /// @brief The bins between frequency_min and frequency_max.
+  virtual ElementRange RequiredElements(const ElementRange& output)
+      const noexcept override;
+
+  virtual void SaveState(std::string* out) const override;
+
+  virtual bool LoadState(const std::shared_ptr<const void>& owner,
+                         const char* data, size_t size) const override;
+
  protected:
+  /// @brief A row of the filter bank: the nonzero weights of the filter
+  /// in the range [begin, end].
   struct Filter {
-    Filter() : data(nullptr, std::free),
-               begin(0), end(0) {
+    Filter() : data(nullptr), begin(0), end(0) {
     }
 
-    FloatPtr data;
+    const float* data;
     int begin;
     int end;
   };
 
+  /// @brief The number of frames processed against each row at once.
+  static constexpr int kFramesBlock = 8;
+  /// @brief Rows start at multiples of this number of floats.
+  static constexpr int kRowAlignment = 8;
+
   static constexpr ScaleType kDefaultScale = ScaleType::kMel;
   static constexpr int kDefaultNumber = 32;
   static constexpr float kDefaultMinFrequency = 130;
@@ -139,8 +170,15 @@ class FilterBank : public OmpTransformBase<formats::ArrayFormatF,
 
   virtual size_t OnInputFormatChanged(size_t buffersCount) override;
 
-  virtual void Do(const float* in,
-                  float* out) const noexcept override;
+  virtual void Do(const BuffersBase<float*>& in,
+                  BuffersBase<float*>* out) const noexcept override;
+
+  /// @brief Applies the filter bank to a single frame.
+  void Do(const float* in, float* out) const noexcept;
+
+  /// @brief Calculates $\sum_i (in_i w_i)^2$.
+  static float FilterEnergy(bool simd, const float* in, const float* weights,
+                            int length) noexcept;
 
   static float LinearToScale(ScaleType type, float freq);
   static float ScaleToLinear(ScaleType type, float value);
@@ -148,16 +186,41 @@ class FilterBank : public OmpTransformBase<formats::ArrayFormatF,
   const std::vector<Filter>& filter_bank() const;
 
  private:
+  friend class Cepstrum;
+
   /// @brief Adds a triangular filter to the filter bank.
   /// @param center The value of the peak of the triangle,
   /// in psychoacoustic scale units.
   /// @param halfWidth The half width of the base of the triangle,
   /// in psychoacoustic scale units.
   /// @param out The resulting filter.
-  void CalcTriangularFilter(float center, float halfWidth, Filter* out) const;
+  void CalcTriangularFilter(float center, float halfWidth, float* weights,
+                            Filter* out) const;
+
+  /// @brief The padded length of the weights row of the filter.
+  static size_t RowLength(const Filter& filter) noexcept;
+  /// @brief The padded size of the rows bounds in the saved state.
+  size_t StateHeaderSize() const noexcept;
+
+  /// @brief The filters and their weights, shared by the transforms with
+  /// the same parameters and input format.
+  struct SharedFilters {
+    SharedFilters() : Weights(nullptr, std::free) {
+    }
+
+    std::vector<Filter> Filters;
+    /// @brief The weights of all the filters, Filters point inside.
+    FloatPtr Weights;
+  };
+
+  std::shared_ptr<const SharedFilters> CalculateFilters() const;
 
   mutable std::vector<Filter> filter_bank_;
-  mutable std::vector<ThreadSafeFloatPtr> buffers_;
+  /// @brief The SharedFilters which filter_bank_ points inside.
+  mutable std::shared_ptr<const void> weights_;
+  /// @brief Keeps the weights restored by LoadState() alive, filter_bank_
+  /// points inside them instead of weights_ then.
+  mutable std::shared_ptr<const void> loaded_state_;
 };
 
 }  // namespace transforms
@@ -34,6 +34,8 @@
 #include <cassert>
 #include <vector>
 #include <mutex>
+#include <unordered_map>
+#include "src/executor_pool.h"
 #include "src/formats/array_format.h"
 #include "src/omp_transform_base.h"
 
@@ -41,7 +43,8 @@ namespace sound_feature_extraction {
 namespace transforms {
 
 template <class E>
-class FilterBase : public OmpUniformFormatTransform<formats::ArrayFormatF> {
+class FilterBase
+    : public UniformFormatOmpAwareTransform<formats::ArrayFormatF> {
  public:
   FilterBase() noexcept
       : length_(kDefaultFilterLength),
@@ -53,25 +56,28 @@ class FilterBase : public OmpUniformFormatTransform<formats::ArrayFormatF> {
   TP(length, int, kDefaultFilterLength, "Filter size in samples (order).")
 
   virtual void Initialize() const override {
-    executors_.resize(max_executors_);
-    for (int i = 0; i < max_executors_; i++) {
-      executors_[i].executor = CreateExecutor();
-      executors_[i].mutex = std::make_shared<std::mutex>();
-    }
+    executors_.Reset(max_executors_, [this]() { return CreateExecutor(); });
   }
 
-  virtual void Do(const float* in, float* out) const noexcept override final {
-    bool executed = false;
-    while (!executed) {
-      for (auto& sse : executors_) {
-        if (sse.mutex->try_lock()) {
-          Execute(sse.executor, in, out);
-          sse.mutex->unlock();
-          executed = true;
-          break;
-        }
-      }
+  /// @brief Each output buffer is calculated from the input buffer with
+  /// the same index only.
+  virtual Overlap RequiredOverlap(const Overlap& output)
+      const noexcept override {
+    return output;
+  }
+
+  virtual void Do(const float* in, float* out) const noexcept final {
+    if (this->streaming()) {
+      ExecuteStreaming(in, out);
+      return;
     }
+    auto executor = executors_.Acquire();
+    Execute(*executor, in, out);
+  }
+
+  virtual void ResetState() const noexcept override {
+    std::lock_guard<std::mutex> lock(stream_executors_mutex_);
+    stream_executors_.clear();
   }
 
   int max_executors() const {
@@ -83,6 +89,11 @@ class FilterBase : public OmpUniformFormatTransform<formats::ArrayFormatF> {
     max_executors_ = value;
   }
 
+  /// @brief Returns how often Do() had to wait for a free executor.
+  ExecutorPoolStatistics executors_statistics() const noexcept {
+    return executors_.Statistics();
+  }
+
   static bool ValidateFrequency(const int& value) noexcept {
     return value >= kMinFilterFrequency && value <= kMaxFilterFrequency;
   }
@@ -94,18 +105,48 @@ class FilterBase : public OmpUniformFormatTransform<formats::ArrayFormatF> {
   static constexpr int kMaxFilterFrequency = 24000;
 
  protected:
+  /// @brief Filters the buffers one by one. The descendants which can filter
+  /// several buffers at once override it.
+  virtual void Do(const BuffersBase<float*>& in,
+                  BuffersBase<float*>* out) const noexcept override {
+    this->ParallelFor(in.Count(), [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        Do(in[i], (*out)[i]);
+      }
+    });
+  }
+
+  /// @brief Borrows an executor for several Execute() calls.
+  typename ExecutorPool<E>::Lease AcquireExecutor() const noexcept {
+    return executors_.Acquire();
+  }
+
   virtual std::shared_ptr<E> CreateExecutor() const noexcept = 0;
   virtual void Execute(const std::shared_ptr<E>& exec, const float* in,
                        float* out) const = 0;
 
  private:
-  struct ThreadSafeExecutor {
+  /// @brief Runs the filter with the state which persists between the calls.
+  /// @details The memory of the buffers is fixed after the transform tree is
+  /// prepared, so each input pointer corresponds to the same channel.
+  void ExecuteStreaming(const float* in, float* out) const noexcept {
     std::shared_ptr<E> executor;
-    std::shared_ptr<std::mutex> mutex;
-  };
+    {
+      std::lock_guard<std::mutex> lock(stream_executors_mutex_);
+      auto& ptr = stream_executors_[in];
+      if (!ptr) {
+        ptr = CreateExecutor();
+      }
+      executor = ptr;
+    }
+    Execute(executor, in, out);
+  }
 
-  mutable std::vector<ThreadSafeExecutor> executors_;
+  mutable ExecutorPool<E> executors_;
   int max_executors_;
+  mutable std::unordered_map<const float*, std::shared_ptr<E>>
+      stream_executors_;
+  mutable std::mutex stream_executors_mutex_;
 };
 
 template <class E>
@@ -29,16 +29,132 @@
  */
 
 #include "src/transforms/fir_filter_base.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include <fftf/api.h>
 #include <simd/convolve.h>
+#include <simd/memory.h>
+#include "src/fftf_wisdom.h"
+#include "src/make_unique.h"
 
 namespace sound_feature_extraction {
 namespace transforms {
 
+/// @brief Either the libSimd convolution handle (direct mode) or the
+/// overlap-save workspace with the FFT plans bound to it. The batched plans
+/// transform all the blocks, the single ones the first block only.
+struct FIRFilterExecutor {
+  FIRFilterExecutor() : Direct(nullptr), Blocks(nullptr, std::free),
+      Spectra(nullptr, std::free), Forward(nullptr, fftf_destroy),
+      Backward(nullptr, fftf_destroy), BatchForward(nullptr, fftf_destroy),
+      BatchBackward(nullptr, fftf_destroy) {
+  }
+
+  ~FIRFilterExecutor() {
+    if (Direct) {
+      convolve_finalize(*Direct);
+    }
+  }
+
+  std::unique_ptr<ConvolutionHandle> Direct;
+  FloatPtr Blocks;
+  FloatPtr Spectra;
+  std::vector<float*> BlockPtrs;
+  std::vector<float*> SpectrumPtrs;
+  std::unique_ptr<FFTFInstance, void (*)(FFTFInstance*)> Forward;
+  std::unique_ptr<FFTFInstance, void (*)(FFTFInstance*)> Backward;
+  std::unique_ptr<FFTFInstance, void (*)(FFTFInstance*)> BatchForward;
+  std::unique_ptr<FFTFInstance, void (*)(FFTFInstance*)> BatchBackward;
+};
+
+constexpr int FIRFilterBase::kMaxBatchBlocks;
+constexpr int FIRFilterBase::kMaxBatchFloats;
+
+FIRFilterBase::FIRFilterBase() noexcept
+    : filter_spectrum_(nullptr, std::free), block_length_(0),
+      batch_blocks_(1) {
+}
+
+bool FIRFilterBase::overlap_save() const noexcept {
+  return block_length_ > 0;
+}
+
+size_t FIRFilterBase::PrivateMemorySize() const noexcept {
+  return (filter_.size() + (filter_spectrum_? block_length_ + 2 : 0)) *
+      sizeof(float);
+}
+
+int FIRFilterBase::block_length() const noexcept {
+  return block_length_;
+}
+
+const std::vector<float>& FIRFilterBase::filter() const noexcept {
+  return filter_;
+}
+
+int FIRFilterBase::ChooseBlockLength(size_t inputLength,
+                                     size_t filterLength) noexcept {
+  if (filterLength < static_cast<size_t>(kMinOverlapSaveFilterLength)) {
+    return 0;
+  }
+  size_t outputLength = inputLength + filterLength - 1;
+  float bestCost = static_cast<float>(inputLength) * filterLength;
+  int best = 0;
+  size_t length = 1;
+  while (length < 2 * filterLength) {
+    length <<= 1;
+  }
+  // Blocks longer than the whole output are never better
+  for (; length < 4 * (outputLength + filterLength); length <<= 1) {
+    size_t step = length - filterLength + 1;
+    size_t blocks = (outputLength + step - 1) / step;
+    // forward + backward real FFTs and L / 2 complex multiplications
+    float cost = blocks * (kFFTCost * length * std::log2(length) +
+                           2.f * length);
+    if (cost < bestCost) {
+      bestCost = cost;
+      best = length;
+    }
+  }
+  return best;
+}
+
 void FIRFilterBase::Initialize() const {
   filter_.resize(length());
   CalculateFilter(filter_.data());
 
-  FilterBase<ConvolutionHandle>::Initialize();
+  block_length_ = ChooseBlockLength(input_format_->Size(), filter_.size());
+  if (block_length_ > 0) {
+    // The spectrum is calculated once and reused by all the executors
+    filter_spectrum_ = std::uniquify(mallocf(block_length_ + 2), std::free);
+    auto padded = std::uniquify(mallocf(block_length_), std::free);
+    memcpy(padded.get(), filter_.data(), filter_.size() * sizeof(float));
+    memset(padded.get() + filter_.size(), 0,
+           (block_length_ - filter_.size()) * sizeof(float));
+    auto backend = FFTFWisdom::Instance().Select(
+        FFTF_TYPE_REAL, FFTF_DIRECTION_FORWARD, block_length_, 1);
+    auto fftPlan = std::unique_ptr<FFTFInstance, void (*)(FFTFInstance *)>(
+        fftf_init(
+            FFTF_TYPE_REAL, FFTF_DIRECTION_FORWARD,
+            FFTF_DIMENSION_1D,
+            &block_length_, FFTF_NO_OPTIONS,
+            padded.get(), filter_spectrum_.get()),
+        fftf_destroy);
+    backend.unlock();
+    fftf_calc(fftPlan.get());
+    float norm = 1.f / block_length_;
+    for (int i = 0; i < block_length_ + 2; i++) {
+      filter_spectrum_[i] *= norm;
+    }
+    batch_blocks_ = std::max(1, std::min(
+        kMaxBatchBlocks, kMaxBatchFloats / (2 * block_length_ + 2)));
+  } else {
+    filter_spectrum_.reset();
+  }
+
+  FilterBase<FIRFilterExecutor>::Initialize();
 }
 
 size_t FIRFilterBase::OnFormatChanged(size_t buffersCount) {
@@ -46,20 +162,158 @@ size_t FIRFilterBase::OnFormatChanged(size_t buffersCount) {
   return buffersCount;
 }
 
-std::shared_ptr<ConvolutionHandle> FIRFilterBase::CreateExecutor()
+std::shared_ptr<FIRFilterExecutor> FIRFilterBase::CreateExecutor()
     const noexcept {
-  return std::shared_ptr<ConvolutionHandle>(
-      new ConvolutionHandle(convolve_initialize(input_format_->Size(),
-                                                filter_.size())),
-      [](ConvolutionHandle* ptr) {
-        convolve_finalize(*ptr);
-        delete ptr;
-      });
+  auto exec = std::make_shared<FIRFilterExecutor>();
+  if (block_length_ == 0) {
+    // The convolution may plan its FFT with the current backend
+    auto backend = FFTFWisdom::Instance().Select(
+        FFTF_TYPE_REAL, FFTF_DIRECTION_FORWARD,
+        input_format_->Size() + filter_.size(), 1);
+    exec->Direct.reset(new ConvolutionHandle(
+        convolve_initialize(input_format_->Size(), filter_.size())));
+    return exec;
+  }
+  int count = batch_blocks_;
+  exec->Blocks = std::uniquify(mallocf(block_length_ * count), std::free);
+  exec->Spectra = std::uniquify(mallocf((block_length_ + 2) * count),
+                                std::free);
+  // The spare blocks of the incomplete batches must stay finite
+  memset(exec->Blocks.get(), 0, block_length_ * count * sizeof(float));
+  for (int i = 0; i < count; i++) {
+    exec->BlockPtrs.push_back(exec->Blocks.get() + i * block_length_);
+    exec->SpectrumPtrs.push_back(exec->Spectra.get() +
+                                 i * (block_length_ + 2));
+  }
+  auto backend = FFTFWisdom::Instance().Select(
+      FFTF_TYPE_REAL, FFTF_DIRECTION_FORWARD, block_length_, 1);
+  exec->Forward.reset(fftf_init(
+      FFTF_TYPE_REAL, FFTF_DIRECTION_FORWARD, FFTF_DIMENSION_1D,
+      &block_length_, FFTF_NO_OPTIONS, exec->BlockPtrs[0],
+      exec->SpectrumPtrs[0]));
+  exec->Backward.reset(fftf_init(
+      FFTF_TYPE_REAL, FFTF_DIRECTION_BACKWARD, FFTF_DIMENSION_1D,
+      &block_length_, FFTF_NO_OPTIONS, exec->SpectrumPtrs[0],
+      exec->BlockPtrs[0]));
+  backend.unlock();
+  if (count > 1) {
+    auto batch_backend = FFTFWisdom::Instance().Select(
+        FFTF_TYPE_REAL, FFTF_DIRECTION_FORWARD, block_length_, count);
+    exec->BatchForward.reset(fftf_init_batch(
+        FFTF_TYPE_REAL, FFTF_DIRECTION_FORWARD, FFTF_DIMENSION_1D,
+        &block_length_, FFTF_NO_OPTIONS, count,
+        const_cast<const float* const*>(exec->BlockPtrs.data()),
+        exec->SpectrumPtrs.data()));
+    exec->BatchBackward.reset(fftf_init_batch(
+        FFTF_TYPE_REAL, FFTF_DIRECTION_BACKWARD, FFTF_DIMENSION_1D,
+        &block_length_, FFTF_NO_OPTIONS, count,
+        const_cast<const float* const*>(exec->SpectrumPtrs.data()),
+        exec->BlockPtrs.data()));
+  }
+  return exec;
 }
 
-void FIRFilterBase::Execute(const std::shared_ptr<ConvolutionHandle>& exec,
+void FIRFilterBase::Execute(const std::shared_ptr<FIRFilterExecutor>& exec,
                             const float* in, float* out) const {
-  convolve(*exec, in, &filter_[0], out);
+  if (exec->Direct) {
+    convolve(*exec->Direct, in, &filter_[0], out);
+  } else {
+    ExecuteOverlapSave(exec.get(), in, 0, out, 0, 1);
+  }
+}
+
+void FIRFilterBase::Do(const BuffersBase<float*>& in,
+                       BuffersBase<float*>* out) const noexcept {
+  if (!overlap_save() || streaming() || batch_blocks_ == 1) {
+    FilterBase<FIRFilterExecutor>::Do(in, out);
+    return;
+  }
+  size_t inStride = in.Stride() / sizeof(float);
+  size_t outStride = out->Stride() / sizeof(float);
+  this->ParallelFor(in.Count(), [&](size_t begin, size_t end) {
+    auto executor = AcquireExecutor();
+    ExecuteOverlapSave((*executor).get(), in[begin], inStride,
+                       (*out)[begin], outStride, end - begin);
+  });
+}
+
+void FIRFilterBase::ExecuteOverlapSave(FIRFilterExecutor* exec,
+                                       const float* in, size_t inStride,
+                                       float* out, size_t outStride,
+                                       int count) const noexcept {
+  int inputLength = input_format_->Size();
+  int filterLength = filter_.size();
+  int outputLength = inputLength + filterLength - 1;
+  int step = block_length_ - filterLength + 1;
+  const float* h = filter_spectrum_.get();
+  // The buffer and the output offset of each pending block
+  int buffers[kMaxBatchBlocks], offsets[kMaxBatchBlocks];
+  int pending = 0;
+  auto multiply = [&](float* spectrum) {
+    for (int i = 0; i < block_length_ + 2; i += 2) {
+      float re = spectrum[i] * h[i] - spectrum[i + 1] * h[i + 1];
+      float im = spectrum[i] * h[i + 1] + spectrum[i + 1] * h[i];
+      spectrum[i] = re;
+      spectrum[i + 1] = im;
+    }
+  };
+  // The first filterLength - 1 samples are wrapped around, drop them
+  auto store = [&](int index, const float* result) {
+    int offset = offsets[index];
+    int size = std::min(step, outputLength - offset);
+    memcpy(out + buffers[index] * outStride + offset,
+           result + filterLength - 1,
+           size * sizeof(float));
+  };
+  auto flush = [&]() {
+    if (pending == batch_blocks_ && exec->BatchForward) {
+      fftf_calc(exec->BatchForward.get());
+      for (int j = 0; j < pending; j++) {
+        multiply(exec->SpectrumPtrs[j]);
+      }
+      fftf_calc(exec->BatchBackward.get());
+      for (int j = 0; j < pending; j++) {
+        store(j, exec->BlockPtrs[j]);
+      }
+    } else {
+      // The tail is cheaper to transform block by block in the first slot
+      for (int j = 0; j < pending; j++) {
+        if (j > 0) {
+          memcpy(exec->BlockPtrs[0], exec->BlockPtrs[j],
+                 block_length_ * sizeof(float));
+        }
+        fftf_calc(exec->Forward.get());
+        multiply(exec->SpectrumPtrs[0]);
+        fftf_calc(exec->Backward.get());
+        store(j, exec->BlockPtrs[0]);
+      }
+    }
+    pending = 0;
+  };
+  for (int b = 0; b < count; b++) {
+    for (int offset = 0; offset < outputLength; offset += step) {
+      // The block covers in[offset - filterLength + 1, offset + step)
+      float* block = exec->BlockPtrs[pending];
+      int start = offset - filterLength + 1;
+      int head = std::max(-start, 0);
+      int end = std::min(start + block_length_, inputLength);
+      memset(block, 0, head * sizeof(float));
+      if (end > start + head) {
+        memcpy(block + head, in + b * inStride + start + head,
+               (end - start - head) * sizeof(float));
+      }
+      int tail = std::max(start + head, end) - start;
+      memset(block + tail, 0, (block_length_ - tail) * sizeof(float));
+      buffers[pending] = b;
+      offsets[pending] = offset;
+      if (++pending == batch_blocks_) {
+        flush();
+      }
+    }
+  }
+  if (pending > 0) {
+    flush();
+  }
 }
 
 }  // namespace formats
@@ -32,26 +32,83 @@
 #define SRC_TRANSFORMS_FIR_FILTER_BASE_H_
 
 #include "src/transforms/filter_base.h"
-
-struct ConvolutionHandle;
+#include "src/floatptr.h"
 
 namespace sound_feature_extraction {
 namespace transforms {
 
-class FIRFilterBase : public FilterBase<ConvolutionHandle> {
+/// @brief The per-thread state of FIRFilterBase::Execute().
+struct FIRFilterExecutor;
+
+class FIRFilterBase : public FilterBase<FIRFilterExecutor> {
  public:
+  FIRFilterBase() noexcept;
+
+  using FilterBase<FIRFilterExecutor>::Do;
+
   virtual void Initialize() const override;
 
+  virtual size_t PrivateMemorySize() const noexcept override;
+
+  /// @brief Indicates whether the filter is applied with FFT overlap-save
+  /// block convolution instead of the direct one.
+  bool overlap_save() const noexcept;
+
+  /// @brief The FFT length of the overlap-save blocks, 0 if the direct
+  /// convolution is used.
+  int block_length() const noexcept;
+
+  /// @brief Chooses the overlap-save FFT length for the specified signal
+  /// and filter sizes, comparing the estimated costs of both methods.
+  /// @return The FFT length or 0 if the direct convolution is cheaper.
+  static int ChooseBlockLength(size_t inputLength,
+                               size_t filterLength) noexcept;
+
+  /// @brief Filters shorter than this are always applied directly.
+  static constexpr int kMinOverlapSaveFilterLength = 64;
+
+  /// @brief The relative cost of a single FFT butterfly against
+  /// a multiply-add, used by the convolution method heuristics.
+  static constexpr float kFFTCost = 1.5f;
+
+  /// @brief The maximal number of the overlap-save blocks transformed by
+  /// a single batched FFT plan.
+  static constexpr int kMaxBatchBlocks = 16;
+  /// @brief The maximal number of floats in the batch scratch of each
+  /// executor.
+  static constexpr int kMaxBatchFloats = 1 << 20;
+
  protected:
+  /// @brief The taps calculated by CalculateFilter() in Initialize().
+  const std::vector<float>& filter() const noexcept;
+
   virtual void CalculateFilter(float* filter) const noexcept = 0;
   virtual size_t OnFormatChanged(size_t buffersCount) override;
-  virtual std::shared_ptr<ConvolutionHandle> CreateExecutor()
+  /// @brief Filters each chunk of the buffers with a single executor, so
+  /// that the overlap-save blocks of several buffers share the batches.
+  virtual void Do(const BuffersBase<float*>& in,
+                  BuffersBase<float*>* out) const noexcept override;
+  virtual std::shared_ptr<FIRFilterExecutor> CreateExecutor()
       const noexcept override final;
-  virtual void Execute(const std::shared_ptr<ConvolutionHandle>& exec,
+  virtual void Execute(const std::shared_ptr<FIRFilterExecutor>& exec,
                        const float* in, float* out) const override final;
 
  private:
+  /// @brief Convolves the buffers block by block, transforming up to
+  /// batch_blocks_ blocks at once.
+  /// @param inStride The distance between the input buffers in floats.
+  /// @param outStride The distance between the output buffers in floats.
+  void ExecuteOverlapSave(FIRFilterExecutor* exec, const float* in,
+                          size_t inStride, float* out, size_t outStride,
+                          int count) const noexcept;
+
   mutable std::vector<float> filter_;
+  /// @brief The spectrum of the zero padded filter, scaled by
+  /// 1 / block_length_ to fold in the inverse FFT normalization.
+  mutable FloatPtr filter_spectrum_;
+  mutable int block_length_;
+  /// @brief The number of the blocks in the batched FFT plans.
+  mutable int batch_blocks_;
 };
 
 }  // namespace formats
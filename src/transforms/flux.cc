@@ -32,26 +32,53 @@
 #include <cmath>
 #include <simd/instruction_set.h>
 #include <simd/normalize.h>
+#include "src/fixed_length.h"
+#include "src/omp_transform_base.h"
+#include "src/thread_pool.h"
 
 namespace sound_feature_extraction {
 namespace transforms {
 
+Overlap Flux::RequiredOverlap(const Overlap& output) const noexcept {
+  if (!output.Bounded()) {
+    return output;
+  }
+  // The first flux repeats the second one
+  return { output.Before + 1, output.After };
+}
+
 void Flux::Do(const BuffersBase<float*>& in,
               BuffersBase<float> *out) const noexcept {
-  for (size_t i = 1; i < in.Count(); i++) {
-    (*out)[i] = Do(use_simd(), in[i], input_format_->Size(), in[i - 1]);
-  }
+  size_t length = input_format_->Size();
+  bool simd = use_simd();
+  ThreadPool::Instance().ParallelFor(
+      in.Count() - 1, 1, serial()? 1 : get_omp_transforms_max_threads_num(),
+      [&](size_t begin, size_t end) {
+    // The normalization of each buffer is reused by its successor
+    float norm_prev = Normalization(simd, in[begin], length);
+    for (size_t i = begin + 1; i <= end; i++) {
+      float norm_input = Normalization(simd, in[i], length);
+      (*out)[i] = kernel_(simd, in[i], length, norm_input, in[i - 1],
+                          norm_prev);
+      norm_prev = norm_input;
+    }
+  });
   (*out)[0] = (*out)[1];
 }
 
-float Flux::Do(bool simd, const float* input, size_t length,
-               const float* prev) noexcept {
+float Flux::Normalization(bool simd, const float* input,
+                          size_t length) noexcept {
+  float max;
+  minmax1D(simd, input, length, nullptr, &max);
+  return (max == 0)? 1 : 1 / max;
+}
+
+template <int kLength>
+static float FluxKernel(bool simd, const float* input, size_t length,
+                        float imax_input, const float* prev,
+                        float imax_prev) {
+  length = FIXED_LENGTH(kLength, length);
   int ilength = length;
-  float max_input, max_prev;
-  minmax1D(simd, input, length, nullptr, &max_input);
-  minmax1D(simd, prev, length, nullptr, &max_prev);
-  const float imax_input = (max_input == 0)? 1 : 1 / max_input;
-  const float imax_prev = (max_prev == 0)? 1 : 1 / max_prev;
   if (simd) {
 #ifdef __AVX__
     __m256 diff = _mm256_setzero_ps();
@@ -126,6 +153,22 @@ float Flux::Do(bool simd, const float* input, size_t length,
   }
 }
 
+float Flux::Do(bool simd, const float* input, size_t length,
+               const float* prev) noexcept {
+  return FluxKernel<0>(simd, input, length,
+                       Normalization(simd, input, length), prev,
+                       Normalization(simd, prev, length));
+}
+
+Flux::Flux() : kernel_(FluxKernel<0>) {
+}
+
+void Flux::Initialize() const {
+  kernel_ = [](int length) -> Kernel {
+    SELECT_FIXED_LENGTH(FluxKernel, length)
+  }(input_format_->Size());
+}
+
 REGISTER_TRANSFORM(Flux);
 
 }  // namespace transforms
@@ -33,23 +33,47 @@
 
 #include "src/formats/array_format.h"
 #include "src/formats/single_format.h"
+#include "src/parallel_transform.h"
 #include "src/transform_base.h"
 
 namespace sound_feature_extraction {
 namespace transforms {
 
 /// @brief \f$||\overrightarrow{Value(f)}-\overrightarrow{Value_pre(f)}||\f$.
+/// @details The pairs of the neighbour buffers are split into the ranges
+/// which run on the thread pool, each range normalizes its first previous
+/// buffer itself.
 class Flux
-    : public TransformBase<formats::ArrayFormatF, formats::SingleFormatF> {
+    : public TransformBase<formats::ArrayFormatF, formats::SingleFormatF>,
+      public ParallelTransform {
  public:
+  Flux();
+
   TRANSFORM_INTRO("Flux", "Measure of spectral change.", Flux)
 
+  /// @brief Picks the kernel specialized for the input length, if any.
+  virtual void Initialize() const override;
+
+  virtual Overlap RequiredOverlap(const Overlap& output)
+      const noexcept override;
+
  protected:
   virtual void Do(const BuffersBase<float*>& in,
                   BuffersBase<float> *out) const noexcept override;
 
   static float Do(bool simd, const float* input, size_t length,
                   const float* prev) noexcept;
+
+  /// @brief Returns the factor which normalizes the maximum of input to 1.
+  static float Normalization(bool simd, const float* input,
+                             size_t length) noexcept;
+
+ private:
+  typedef float (*Kernel)(bool simd, const float* input, size_t length,
+                          float norm_input, const float* prev,
+                          float norm_prev);
+
+  mutable Kernel kernel_;
 };
 
 }  // namespace transforms
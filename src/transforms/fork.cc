@@ -40,6 +40,10 @@ bool Fork::validate_factor(const int& value) noexcept {
   return value >= 1;
 }
 
+size_t Fork::BufferRatio() const noexcept {
+  return factor_;
+}
+
 size_t Fork::OnFormatChanged(size_t buffersCount) {
   return factor_ * buffersCount;
 }
@@ -51,7 +55,7 @@ void Fork::Do(
   for (size_t i = 0, j = 0; i < in.Count(); i++, j += factor_) {
     auto input = in[i];
     for (int k = 0; k < factor_; k++) {
-      memcpy((*out)[j + k], input, copy_size);
+      StoreCopy((*out)[j + k], input, copy_size);
     }
   }
 }
@@ -32,12 +32,14 @@
 #define SRC_TRANSFORMS_FORK_H_
 
 #include "src/formats/array_format.h"
+#include "src/streaming_stores_transform.h"
 #include "src/transform_base.h"
 
 namespace sound_feature_extraction {
 namespace transforms {
 
-class Fork : public UniformFormatTransform<formats::ArrayFormatF> {
+class Fork : public UniformFormatTransform<formats::ArrayFormatF>,
+             public StreamingStoresTransform {
   friend class FrequencyBands;
  public:
   Fork();
@@ -48,6 +50,8 @@ class Fork : public UniformFormatTransform<formats::ArrayFormatF> {
 
   TP(factor, int, kDefaultFactor, "Windows number multiplier value.")
 
+  virtual size_t BufferRatio() const noexcept override;
+
  protected:
   static constexpr int kDefaultFactor = 4;
 
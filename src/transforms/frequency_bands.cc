@@ -30,15 +30,17 @@
 
 #include "src/transforms/frequency_bands.h"
 #include <algorithm>
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wold-style-cast"
-#include <boost/regex.hpp>
-#pragma GCC diagnostic pop
-#include "src/safe_omp.h"
+#include <cmath>
 #include "src/transforms/lowpass_filter.h"
 #include "src/transforms/bandpass_filter.h"
 #include "src/transforms/highpass_filter.h"
-#include "src/stoi_function.h"
+#include "src/scratch_arena.h"
+#include "src/shared_state.h"
+#ifdef SIMD_X86
+#include <immintrin.h>
+#elif defined(SIMD_NEON)
+#include <arm_neon.h>
+#endif
 
 namespace sound_feature_extraction {
 namespace transforms {
@@ -48,25 +50,24 @@ FilterOrders Parse(const std::string& value, identity<FilterOrders>) {
     return FilterOrders();
   }
   FilterOrders result;
-  std::transform(boost::sregex_token_iterator(value.begin(), value.end(),
-                                              boost::regex("\\s*(\\d+)\\s*"),
-                                              1),
-                 boost::sregex_token_iterator(),
-                 std::back_inserter(result),
-                 std::stoi_function);
-  if (result.empty()) {
+  if (!SplitIntegers(value, &result)) {
     throw InvalidParameterValueException();
   }
   return result;
 }
 
 constexpr IIRFilterType FrequencyBands::kDefaultFilterType;
+constexpr int FrequencyBands::kBandLanes;
+constexpr int FrequencyBands::kDefaultDecimation;
 
 FrequencyBands::FrequencyBands()
     : number_(kDefaultBandsNumber),
       bands_(),
       filter_(kDefaultFilterType),
-      lengths_() {
+      lengths_(),
+      parallel_(kDefaultParallel),
+      decimation_(kDefaultDecimation),
+      decimation_factor_(kDefaultDecimation) {
 }
 
 bool FrequencyBands::validate_number(const int& value) noexcept {
@@ -77,19 +78,8 @@ bool FrequencyBands::validate_bands(const std::string& value) noexcept {
   if (value.empty()) {
     return true;
   }
-  static const boost::regex all_regex("^\\s*(\\d+\\s*(\\s|$))+");
-  boost::smatch match;
-  if (!boost::regex_match(value, match, all_regex)) {
-    return false;
-  }
   std::vector<int> bands;
-  std::transform(boost::sregex_token_iterator(value.begin(), value.end(),
-                                              boost::regex("\\s*(\\d+)\\s*"),
-                                              1),
-                 boost::sregex_token_iterator(),
-                 std::back_inserter(bands),
-                 std::stoi_function);
-  if (bands.size() < 1) {
+  if (!SplitIntegers(value, &bands)) {
     return false;
   }
   for (size_t i = 1; i < bands.size(); i++) {
@@ -110,13 +100,17 @@ bool FrequencyBands::validate_lengths(const FilterOrders& value) noexcept {
   return true;
 }
 
-const std::vector<std::shared_ptr<IIRFilterBase>>&
-FrequencyBands::filters() const {
-  return filters_;
+ALWAYS_VALID_TP(FrequencyBands, parallel)
+
+bool FrequencyBands::validate_decimation(const int& value) noexcept {
+  return value >= 0;
 }
 
-void FrequencyBands::Initialize() const {
-  filters_.clear();
+int FrequencyBands::decimation_factor() const noexcept {
+  return decimation_factor_;
+}
+
+std::vector<int> FrequencyBands::Edges() const {
   std::string bands = bands_;
   if (bands.empty()) {
     for (int i = 1; i < number_; i++) {
@@ -124,24 +118,110 @@ void FrequencyBands::Initialize() const {
           input_format_->SamplingRate() / (2.f * number_) * i)) + " ";
     }
   }
+  std::vector<int> frequencies;
+  SplitIntegers(bands, &frequencies);
+  auto nyquist = std::find_if(
+      frequencies.begin(), frequencies.end(),
+      [this](int freq) { return freq > input_format_->SamplingRate() / 2; });
+  frequencies.erase(nyquist, frequencies.end());
+  return frequencies;
+}
+
+bool FrequencyBands::Decimatable(const std::vector<int>& edges,
+                                 int factor) const noexcept {
+  float zone = input_format_->SamplingRate() / (2.f * factor);
+  float low = 0;
+  for (size_t i = 0; i <= edges.size(); i++) {
+    float high = i < edges.size()?
+        edges[i] : input_format_->SamplingRate() / 2.f;
+    float first = floorf(low / zone);
+    if (high > (first + 1) * zone * (1 + 1e-6f)) {
+      return false;
+    }
+    low = high;
+  }
+  return true;
+}
+
+size_t FrequencyBands::OnFormatChanged(size_t buffersCount) {
+  int size = input_format_->Size();
+  auto edges = Edges();
+  if (decimation_ == 0) {
+    decimation_factor_ = 1;
+    for (int factor = 2; factor <= size &&
+         input_format_->SamplingRate() / factor >=
+             BufferFormat::kMinSamplingRate; factor++) {
+      if (Decimatable(edges, factor)) {
+        decimation_factor_ = factor;
+      }
+    }
+  } else {
+    decimation_factor_ = decimation_;
+    if (!Decimatable(edges, decimation_)) {
+      WRN("Some bands do not fit into a single Nyquist zone of the "
+          "sampling rate decimated by %d and alias\n", decimation_);
+    }
+  }
+  output_format_->SetSize((size + decimation_factor_ - 1) /
+                          decimation_factor_);
+  output_format_->SetSamplingRate(
+      input_format_->SamplingRate() / decimation_factor_);
+  return buffersCount;
+}
+
+void FrequencyBands::Decimate(const float* in, float* out) const noexcept {
+  size_t size = output_format_->Size();
+  for (size_t i = 0; i < size; i++) {
+    out[i] = in[i * decimation_factor_];
+  }
+}
+
+const std::vector<std::shared_ptr<IIRFilterBase>>&
+FrequencyBands::filters() const {
+  return filters_;
+}
+
+void FrequencyBands::Initialize() const {
+  if (streaming() && input_format_->Size() % decimation_factor_ != 0) {
+    // Otherwise the phase of the kept samples would change between buffers
+    throw InvalidParameterValueException(
+        "decimation", std::to_string(decimation_), HostName());
+  }
+  // The filters of a stream keep its state between the blocks, the rest
+  // are immutable after the initialization
+  if (streaming()) {
+    shared_filters_ = DesignFilters();
+  } else {
+    shared_filters_ = SharedState<Filters>(StateKey(), [this]() {
+      return DesignFilters();
+    });
+  }
+  filters_ = *shared_filters_;
+  cascades_.clear();
+  if (parallel_) {
+    InitializeParallel();
+  }
+}
 
+std::shared_ptr<FrequencyBands::Filters>
+FrequencyBands::DesignFilters() const {
+  auto filters = std::make_shared<Filters>();
   int last_freq = 0, index = 0;
-  static const boost::regex numbers_regex("\\s*(\\d+)\\s*");
-  static const boost::sregex_token_iterator empty;
-  boost::sregex_token_iterator bands_iterator(
-        bands.begin(), bands.end(), numbers_regex, 1);
-  assert(bands_iterator != empty);
-  while (bands_iterator != empty) {
-    int freq = std::stoi(*bands_iterator++);
-    if (freq > input_format_->SamplingRate() / 2) {
+  auto frequencies = Edges();
+  assert(!frequencies.empty());
+  if (bands_.size() > 0) {
+    std::vector<int> requested;
+    SplitIntegers(bands_, &requested);
+    if (requested.size() > frequencies.size()) {
       WRN("Warning: the bands after %i (defined by sampling "
           "rate %i) will be discarded (first greater band was "
           "%i).\n",
           input_format_->SamplingRate() / 2,
           input_format_->SamplingRate(),
-          freq);
-      break;
+          requested[frequencies.size()]);
     }
+  }
+  for (int freq : frequencies) {
     std::shared_ptr<IIRFilterBase> filter;
     if (last_freq == 0) {
       auto f = std::make_shared<LowpassFilter>();
@@ -154,19 +234,50 @@ void FrequencyBands::Initialize() const {
       filter = f;
     }
     SetupFilter(index++, freq, filter.get());
-    filters_.push_back(filter);
+    filters->push_back(filter);
     last_freq = freq;
   }
   // Append high-pass filter
   auto filter = std::make_shared<HighpassFilter>();
   filter->set_frequency(last_freq);
   SetupFilter(index, last_freq, filter.get());
-  filters_.push_back(filter);
+  filters->push_back(filter);
 
-  for (const auto& filter : filters_) {  // NOLINT(*)
+  for (const auto& filter : *filters) {  // NOLINT(*)
     filter->SetInputFormat(input_format_, 1);
     filter->Initialize();
   }
+  return filters;
+}
+
+void FrequencyBands::InitializeParallel() const {
+  for (size_t first = 0; first < filters_.size(); first += kBandLanes) {
+    BandsCascade cascade;
+    cascade.Bands = std::min(filters_.size() - first,
+                             static_cast<size_t>(kBandLanes));
+    std::vector<std::vector<BiquadCoefficients>> sections;
+    cascade.Sections = 0;
+    for (int b = 0; b < cascade.Bands; b++) {
+      sections.push_back(filters_[first + b]->Sections());
+      cascade.Sections = std::max(cascade.Sections,
+                                  static_cast<int>(sections.back().size()));
+    }
+    cascade.Coefficients.assign(cascade.Sections * 5 * kBandLanes, 0.f);
+    for (int s = 0; s < cascade.Sections; s++) {
+      float* coeffs = &cascade.Coefficients[s * 5 * kBandLanes];
+      for (int b = 0; b < cascade.Bands; b++) {
+        BiquadCoefficients identity { 1, 0, 0, 0, 0 };
+        const auto& bq = static_cast<size_t>(s) < sections[b].size()?
+            sections[b][s] : identity;
+        coeffs[b] = bq.b0;
+        coeffs[kBandLanes + b] = bq.b1;
+        coeffs[2 * kBandLanes + b] = bq.b2;
+        coeffs[3 * kBandLanes + b] = bq.a1;
+        coeffs[4 * kBandLanes + b] = bq.a2;
+      }
+    }
+    cascades_.push_back(std::move(cascade));
+  }
 }
 
 void FrequencyBands::SetupFilter(size_t index, int frequency,
@@ -184,20 +295,244 @@ void FrequencyBands::SetupFilter(size_t index, int frequency,
   }
 }
 
-void FrequencyBands::Do(const BuffersBase<float*>& in,
-                        BuffersBase<float*>* out) const noexcept {
-#ifdef HAVE_OPENMP
-  #pragma omp parallel for num_threads(threads_number())
+/// @brief Filters the same input with up to kBandLanes cascades at once.
+/// @details The state of section s is x[n-1], x[n-2], y[n-1], y[n-2] at
+/// [(s * 4 + k) * kBandLanes + b] and is reset before the input.
+typedef void (*BandsKernel)(const float* coeffs, int sections, int bands,
+                            float* state, const float* input, int length,
+                            float* const* outputs);
+
+static void FilterBandsScalar(const float* coeffs, int sections, int bands,
+                              float* state, const float* input, int length,
+                              float* const* outputs) {
+  const int lanes = 16;
+  memset(state, 0, sections * 4 * lanes * sizeof(state[0]));
+  for (int n = 0; n < length; n++) {
+    for (int b = 0; b < bands; b++) {
+      float x = input[n];
+      for (int s = 0; s < sections; s++) {
+        const float* c = coeffs + s * 5 * lanes + b;
+        float* st = state + s * 4 * lanes + b;
+        float y = c[0] * x + c[lanes] * st[0] + c[2 * lanes] * st[lanes] -
+            c[3 * lanes] * st[2 * lanes] - c[4 * lanes] * st[3 * lanes];
+        st[lanes] = st[0];
+        st[0] = x;
+        st[3 * lanes] = st[2 * lanes];
+        st[2 * lanes] = y;
+        x = y;
+      }
+      outputs[b][n] = x;
+    }
+  }
+}
+
+#ifdef SIMD_X86
+SIMD_TARGET("avx")
+static void FilterBandsAVX(const float* coeffs, int sections, int bands,
+                           float* state, const float* input, int length,
+                           float* const* outputs) {
+  const int lanes = 16;
+  memset(state, 0, sections * 4 * lanes * sizeof(state[0]));
+  int vectors = (bands + 7) / 8;
+  float result[16];
+  for (int n = 0; n < length; n++) {
+    for (int v = 0; v < vectors; v++) {
+      __m256 x = _mm256_set1_ps(input[n]);
+      for (int s = 0; s < sections; s++) {
+        const float* c = coeffs + s * 5 * lanes + v * 8;
+        float* st = state + s * 4 * lanes + v * 8;
+        __m256 x1 = _mm256_loadu_ps(st);
+        __m256 y1 = _mm256_loadu_ps(st + 2 * lanes);
+        __m256 y = _mm256_mul_ps(_mm256_loadu_ps(c), x);
+        y = _mm256_add_ps(y, _mm256_mul_ps(_mm256_loadu_ps(c + lanes), x1));
+        y = _mm256_add_ps(y, _mm256_mul_ps(_mm256_loadu_ps(c + 2 * lanes),
+                                           _mm256_loadu_ps(st + lanes)));
+        y = _mm256_sub_ps(y, _mm256_mul_ps(_mm256_loadu_ps(c + 3 * lanes),
+                                           y1));
+        y = _mm256_sub_ps(y, _mm256_mul_ps(_mm256_loadu_ps(c + 4 * lanes),
+                                           _mm256_loadu_ps(st + 3 * lanes)));
+        _mm256_storeu_ps(st + lanes, x1);
+        _mm256_storeu_ps(st, x);
+        _mm256_storeu_ps(st + 3 * lanes, y1);
+        _mm256_storeu_ps(st + 2 * lanes, y);
+        x = y;
+      }
+      _mm256_storeu_ps(result + v * 8, x);
+    }
+    for (int b = 0; b < bands; b++) {
+      outputs[b][n] = result[b];
+    }
+  }
+}
+
+SIMD_TARGET_AVX512
+static void FilterBandsAVX512(const float* coeffs, int sections, int bands,
+                              float* state, const float* input, int length,
+                              float* const* outputs) {
+  const int lanes = 16;
+  memset(state, 0, sections * 4 * lanes * sizeof(state[0]));
+  float result[16];
+  for (int n = 0; n < length; n++) {
+    __m512 x = _mm512_set1_ps(input[n]);
+    for (int s = 0; s < sections; s++) {
+      const float* c = coeffs + s * 5 * lanes;
+      float* st = state + s * 4 * lanes;
+      __m512 x1 = _mm512_loadu_ps(st);
+      __m512 y1 = _mm512_loadu_ps(st + 2 * lanes);
+      __m512 y = _mm512_mul_ps(_mm512_loadu_ps(c), x);
+      y = _mm512_fmadd_ps(_mm512_loadu_ps(c + lanes), x1, y);
+      y = _mm512_fmadd_ps(_mm512_loadu_ps(c + 2 * lanes),
+                          _mm512_loadu_ps(st + lanes), y);
+      y = _mm512_fnmadd_ps(_mm512_loadu_ps(c + 3 * lanes), y1, y);
+      y = _mm512_fnmadd_ps(_mm512_loadu_ps(c + 4 * lanes),
+                           _mm512_loadu_ps(st + 3 * lanes), y);
+      _mm512_storeu_ps(st + lanes, x1);
+      _mm512_storeu_ps(st, x);
+      _mm512_storeu_ps(st + 3 * lanes, y1);
+      _mm512_storeu_ps(st + 2 * lanes, y);
+      x = y;
+    }
+    _mm512_storeu_ps(result, x);
+    for (int b = 0; b < bands; b++) {
+      outputs[b][n] = result[b];
+    }
+  }
+}
+#elif defined(SIMD_NEON)
+static void FilterBandsNEON(const float* coeffs, int sections, int bands,
+                            float* state, const float* input, int length,
+                            float* const* outputs) {
+  const int lanes = 16;
+  memset(state, 0, sections * 4 * lanes * sizeof(state[0]));
+  int vectors = (bands + 3) / 4;
+  float result[16];
+  for (int n = 0; n < length; n++) {
+    for (int v = 0; v < vectors; v++) {
+      float32x4_t x = vdupq_n_f32(input[n]);
+      for (int s = 0; s < sections; s++) {
+        const float* c = coeffs + s * 5 * lanes + v * 4;
+        float* st = state + s * 4 * lanes + v * 4;
+        float32x4_t x1 = vld1q_f32(st);
+        float32x4_t y1 = vld1q_f32(st + 2 * lanes);
+        float32x4_t y = vmulq_f32(vld1q_f32(c), x);
+        y = vmlaq_f32(y, vld1q_f32(c + lanes), x1);
+        y = vmlaq_f32(y, vld1q_f32(c + 2 * lanes), vld1q_f32(st + lanes));
+        y = vmlsq_f32(y, vld1q_f32(c + 3 * lanes), y1);
+        y = vmlsq_f32(y, vld1q_f32(c + 4 * lanes), vld1q_f32(st + 3 * lanes));
+        vst1q_f32(st + lanes, x1);
+        vst1q_f32(st, x);
+        vst1q_f32(st + 3 * lanes, y1);
+        vst1q_f32(st + 2 * lanes, y);
+        x = y;
+      }
+      vst1q_f32(result + v * 4, x);
+    }
+    for (int b = 0; b < bands; b++) {
+      outputs[b][n] = result[b];
+    }
+  }
+}
+#endif
+
+static const SimdKernel<BandsKernel> kBandsKernels[] {
+#ifdef SIMD_X86
+  { InstructionSet::kAVX512, FilterBandsAVX512 },
+  { InstructionSet::kAVX, FilterBandsAVX },
+#elif defined(SIMD_NEON)
+  { InstructionSet::kNEON, FilterBandsNEON },
 #endif
-  for (size_t i = 0; i < in.Count(); i++) {
+  { InstructionSet::kScalar, FilterBandsScalar }
+};
+
+void FrequencyBands::DoParallel(const BuffersBase<float*>& in,
+                                BuffersBase<float*>* out) const noexcept {
+  int bands = filters_.size();
+  int groups = in.Count() / bands;
+  int chunks = cascades_.size();
+  auto kernel = SimdAware::Dispatch(kBandsKernels).Function;
+  ParallelFor(groups * chunks, [&](int begin, int end) {
+    for (int i = begin; i < end; i++) {
+      int group = i / chunks;
+      const auto& cascade = cascades_[i % chunks];
+      float* outputs[kBandLanes];
+      int first = group * bands + (i % chunks) * kBandLanes;
+      for (int b = 0; b < cascade.Bands; b++) {
+        outputs[b] = (*out)[first + b];
+      }
+      auto state = ScratchArena::Acquire(cascade.Sections * 4 * kBandLanes);
+      kernel(cascade.Coefficients.data(), cascade.Sections, cascade.Bands,
+             state.get(), in[group * bands], input_format_->Size(), outputs);
+    }
+  });
+  // The incomplete group, if any
+  for (size_t i = groups * bands; i < in.Count(); i++) {
     filters_[i % filters_.size()]->Do(in[i], (*out)[i]);
   }
 }
 
+InstructionSet FrequencyBands::SimdInstructionSet() const noexcept {
+  if (!parallel_ || decimation_factor_ > 1) {
+    return filters_.empty()? InstructionSet::kScalar :
+        filters_.front()->SimdInstructionSet();
+  }
+  return SimdAware::Dispatch(kBandsKernels).Isa;
+}
+
+void FrequencyBands::Do(const BuffersBase<float*>& in,
+                        BuffersBase<float*>* out) const noexcept {
+  if (decimation_factor_ > 1) {
+    // The bands are filtered at the full rate and thinned afterwards
+    ParallelFor(in.Count(), [&](size_t begin, size_t end) {
+      auto filtered = ScratchArena::Acquire(input_format_->Size());
+      for (size_t i = begin; i < end; i++) {
+        filters_[i % filters_.size()]->Do(in[i], filtered.get());
+        Decimate(filtered.get(), (*out)[i]);
+      }
+    });
+    return;
+  }
+  if (parallel_ && use_simd()) {
+    DoParallel(in, out);
+    return;
+  }
+  int bands = filters_.size();
+  int lanes = filters_.front()->BufferLanes();
+  if (lanes > 1 && !streaming()) {
+    // The same band of several windows shares the coefficients
+    int windows = (in.Count() + bands - 1) / bands;
+    int batches = (windows + lanes - 1) / lanes;
+    ParallelFor(bands * batches, [&](int begin, int end) {
+      for (int i = begin; i < end; i++) {
+        int band = i % bands;
+        const float* ins[IIRFilterBase::kMaxBufferLanes];
+        float* outs[IIRFilterBase::kMaxBufferLanes];
+        int count = 0;
+        for (int w = (i / bands) * lanes; w < (i / bands + 1) * lanes; w++) {
+          size_t index = w * bands + band;
+          if (index >= in.Count()) {
+            break;
+          }
+          ins[count] = in[index];
+          outs[count++] = (*out)[index];
+        }
+        filters_[band]->FilterBuffers(ins, outs, count);
+      }
+    });
+    return;
+  }
+  ParallelFor(in.Count(), [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      filters_[i % filters_.size()]->Do(in[i], (*out)[i]);
+    }
+  });
+}
+
 RTP(FrequencyBands, number)
 RTP(FrequencyBands, bands)
 RTP(FrequencyBands, filter)
 RTP(FrequencyBands, lengths)
+RTP(FrequencyBands, parallel)
+RTP(FrequencyBands, decimation)
 REGISTER_TRANSFORM(FrequencyBands);
 
 }  // namespace transforms
@@ -81,6 +81,15 @@ class FrequencyBands
   TP(filter, IIRFilterType, kDefaultFilterType, "IIR filter type to apply.")
   TP(lengths, FilterOrders, FilterOrders(),
      "IIR filter orders. \"auto\" for automatic selection.")
+  TP(parallel, bool, kDefaultParallel,
+     "Filter all the bands of a window in a single pass, one SIMD lane per "
+     "band. Each group of \"number\" buffers must share the same input, "
+     "as after Fork.")
+  TP(decimation, int, kDefaultDecimation,
+     "Keep every n-th sample of the filtered bands, reducing the sampling "
+     "rate of the following transforms, e.g. Rectify and Beat. 0 chooses "
+     "the largest factor at which each band still lies within a single "
+     "Nyquist zone, so that it is sampled without aliasing.")
 
   virtual bool BufferInvariant() const noexcept override final {
     return false;
@@ -88,11 +97,21 @@ class FrequencyBands
 
   virtual void Initialize() const override;
 
+  virtual InstructionSet SimdInstructionSet() const noexcept override;
+
+  /// @brief The value of "decimation" with 0 resolved.
+  int decimation_factor() const noexcept;
+
  protected:
   static constexpr IIRFilterType kDefaultFilterType =
       IIRFilterType::kChebyshevII;
   static constexpr int kDefaultBandsNumber = Fork::kDefaultFactor;
+  static constexpr bool kDefaultParallel = false;
+  static constexpr int kDefaultDecimation = 1;
+  /// @brief The maximal number of bands filtered in a single pass.
+  static constexpr int kBandLanes = 16;
 
+  virtual size_t OnFormatChanged(size_t buffersCount) override;
   virtual void Do(const BuffersBase<float*>& in,
                   BuffersBase<float*>* out) const noexcept override;
   void SetupFilter(size_t index, int frequency, IIRFilterBase* filter) const;
@@ -100,7 +119,39 @@ class FrequencyBands
   const std::vector<std::shared_ptr<IIRFilterBase>>& filters() const;
 
  private:
+  /// @brief The second order sections of up to kBandLanes bands which are
+  /// filtered together. Coefficient k (b0, b1, b2, a1, a2) of section s of
+  /// band b is at [(s * 5 + k) * kBandLanes + b]. The bands with fewer
+  /// sections are padded with the identity ones.
+  struct BandsCascade {
+    int Bands;
+    int Sections;
+    std::vector<float> Coefficients;
+  };
+
+  typedef std::vector<std::shared_ptr<IIRFilterBase>> Filters;
+
+  /// @brief The edges between the bands which lie below the Nyquist
+  /// frequency.
+  std::vector<int> Edges() const;
+  /// @brief Returns true if each band lies within a single Nyquist zone
+  /// of the sampling rate divided by factor (the bandpass sampling
+  /// theorem), so that decimating it by factor does not alias.
+  bool Decimatable(const std::vector<int>& edges, int factor) const noexcept;
+  /// @brief Keeps every decimation_factor()-th sample of in.
+  void Decimate(const float* in, float* out) const noexcept;
+  /// @brief Creates and initializes the filters of the bands.
+  std::shared_ptr<Filters> DesignFilters() const;
+  void InitializeParallel() const;
+  void DoParallel(const BuffersBase<float*>& in,
+                  BuffersBase<float*>* out) const noexcept;
+
   mutable std::vector<std::shared_ptr<IIRFilterBase>> filters_;
+  /// @brief Keeps the filters shared by the transforms with the same
+  /// parameters and input format alive, see SharedState().
+  mutable std::shared_ptr<const Filters> shared_filters_;
+  mutable std::vector<BandsCascade> cascades_;
+  int decimation_factor_;
 };
 
 }  // namespace transforms
@@ -0,0 +1,84 @@
+/*! @file gate.cc
+ *  @brief Runs the subtree on the frames which pass the energy threshold.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+#include "src/transforms/gate.h"
+#include <cmath>
+#include <cstring>
+#include "src/primitives/energy.h"
+
+namespace sound_feature_extraction {
+namespace transforms {
+
+constexpr float Gate::kDefaultThreshold;
+constexpr float Gate::kDefaultFill;
+
+Gate::Gate() : threshold_(kDefaultThreshold), fill_(kDefaultFill) {
+}
+
+bool Gate::validate_threshold(const float& value) noexcept {
+  return std::isfinite(value);
+}
+
+bool Gate::validate_fill(const float& value) noexcept {
+  return std::isfinite(value);
+}
+
+bool Gate::BufferInvariant() const noexcept {
+  return false;
+}
+
+void Gate::Do(const float* in, float* out) const noexcept {
+  if (in != out) {
+    memcpy(out, in, input_format_->Size() * sizeof(float));
+  }
+}
+
+size_t Gate::Select(const Buffers& in, uint32_t* selected,
+                    Buffers* out) const noexcept {
+  auto& input = reinterpret_cast<const InBuffers&>(in);
+  auto& output = *reinterpret_cast<OutBuffers*>(out);
+  size_t length = input_format_->Size();
+  size_t count = 0;
+  for (size_t i = 0; i < input.Count(); i++) {
+    if (calculate_energy(use_simd(), true, input[i], length) <= threshold_) {
+      continue;
+    }
+    selected[count] = i;
+    Do(input[i], output[count++]);
+  }
+  return count;
+}
+
+RTP(Gate, threshold)
+RTP(Gate, fill)
+REGISTER_TRANSFORM(Gate);
+
+}  // namespace transforms
+}  // namespace sound_feature_extraction
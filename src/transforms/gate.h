@@ -0,0 +1,81 @@
+/*! @file gate.h
+ *  @brief Runs the subtree on the frames which pass the energy threshold.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+#ifndef SRC_TRANSFORMS_GATE_H_
+#define SRC_TRANSFORMS_GATE_H_
+
+#include <cstdint>
+#include "src/transforms/common.h"
+
+namespace sound_feature_extraction {
+namespace transforms {
+
+/// @brief Skips the frames whose mean energy does not exceed the threshold,
+/// e.g. Gate(threshold=1e5) after Window drops the silence.
+/// @details TransformTree packs the frames which pass at the beginning of
+/// the buffers (see Select()), runs the transforms under the gate only on
+/// them and scatters the features back, writing the fill value to
+/// the skipped frames. Thus the work scales with the number of the frames
+/// which pass. Every transform under the gate must map each buffer to
+/// a single buffer independently of the others. Outside of the tree, Do()
+/// passes all the frames.
+class Gate : public OmpUniformFormatTransform<formats::ArrayFormatF> {
+ public:
+  Gate();
+
+  TRANSFORM_INTRO("Gate", "Runs the following transforms only on the frames "
+                          "with the mean energy above the threshold.",
+                  Gate)
+
+  TP(threshold, float, kDefaultThreshold,
+     "The mean energy of the frames which are skipped, inclusive.")
+  TP(fill, float, kDefaultFill,
+     "The value of the features of the skipped frames.")
+
+  /// @brief The tree compacts the buffers after the gate, so they cannot
+  /// be sliced.
+  virtual bool BufferInvariant() const noexcept override;
+
+  /// @brief Copies the frames which pass to the beginning of out and writes
+  /// their indices to selected.
+  /// @return The number of the frames which pass.
+  size_t Select(const Buffers& in, uint32_t* selected,
+                Buffers* out) const noexcept;
+
+ protected:
+  static constexpr float kDefaultThreshold = 0.f;
+  static constexpr float kDefaultFill = 0.f;
+
+  virtual void Do(const float* in, float* out) const noexcept override;
+};
+
+}  // namespace transforms
+}  // namespace sound_feature_extraction
+#endif  // SRC_TRANSFORMS_GATE_H_
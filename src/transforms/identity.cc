@@ -94,6 +94,14 @@ void Identity::SetParameters(
     const ParametersMap&) {
 }
 
+bool Identity::IsView() const noexcept {
+  return true;
+}
+
+Overlap Identity::RequiredOverlap(const Overlap& output) const noexcept {
+  return output;
+}
+
 REGISTER_TRANSFORM(Identity);
 
 }  // namespace transforms
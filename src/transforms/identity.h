@@ -32,16 +32,21 @@
 #define SRC_TRANSFORMS_IDENTITY_H_
 
 #include "src/transform.h"
+#include "src/view_transform.h"
 
 namespace sound_feature_extraction {
 namespace transforms {
 
-class Identity : public Transform {
+class Identity : public Transform, public ViewTransform {
  public:
   Identity();
 
   static constexpr const char* kName = "Identity";
 
+  static const char* TransformName() noexcept {
+    return kName;
+  }
+
   virtual const std::string& Name() const noexcept;
 
   virtual const std::string& Description() const noexcept;
@@ -70,6 +75,11 @@ class Identity : public Transform {
   virtual void SetParameters(
       const ParametersMap& params);
 
+  virtual bool IsView() const noexcept override;
+
+  virtual Overlap RequiredOverlap(const Overlap& output)
+      const noexcept override;
+
  protected:
   std::shared_ptr<BufferFormat> input_format_;
   std::shared_ptr<BufferFormat> output_format_;
@@ -29,6 +29,13 @@
  */
 
 #include "src/transforms/iir_filter_base.h"
+#include <algorithm>
+#include <simd/memory.h>
+#ifdef SIMD_X86
+#include <immintrin.h>
+#elif defined(SIMD_NEON)
+#include <arm_neon.h>
+#endif
 
 namespace sound_feature_extraction {
 namespace transforms {
@@ -36,6 +43,7 @@ namespace transforms {
 RTP(IIRFilterBase, type)
 RTP(IIRFilterBase, ripple)
 RTP(IIRFilterBase, rolloff)
+RTP(IIRFilterBase, min_segment_length)
 
 IIRFilterType Parse(const std::string& value, identity<IIRFilterType>) {
   static const std::unordered_map<std::string, IIRFilterType> map {
@@ -54,11 +62,16 @@ IIRFilterType Parse(const std::string& value, identity<IIRFilterType>) {
 }
 
 constexpr IIRFilterType IIRFilterBase::kDefaultIIRFilterType;
+constexpr int IIRFilterBase::kMaxBufferLanes;
+constexpr int IIRFilterBase::kTileLength;
+constexpr int IIRFilterBase::kDefaultMinSegmentLength;
 
 IIRFilterBase::IIRFilterBase() noexcept
     : type_(kDefaultIIRFilterType),
       ripple_(kDefaultIIRFilterRipple),
-      rolloff_(kDefaultIIRFilterRolloff) {
+      rolloff_(kDefaultIIRFilterRolloff),
+      min_segment_length_(kDefaultMinSegmentLength),
+      segments_(1) {
 }
 ALWAYS_VALID_TP(IIRFilterBase, type)
 
@@ -68,5 +81,378 @@ bool IIRFilterBase::validate_ripple(const float& value) noexcept {
 
 ALWAYS_VALID_TP(IIRFilterBase, rolloff)
 
-}  // namespace formats
+bool IIRFilterBase::validate_min_segment_length(const int& value) noexcept {
+  return value >= 0;
+}
+
+std::vector<BiquadCoefficients> IIRFilterBase::Sections() const noexcept {
+  auto cascade = CreateExecutor();
+  std::vector<BiquadCoefficients> sections;
+  if (!cascade) {
+    return sections;
+  }
+  for (int i = 0; i < cascade->getNumStages(); i++) {
+    const auto& stage = (*cascade)[i];
+    double a0 = stage.getA0();
+    sections.push_back({
+      static_cast<float>(stage.getB0() / a0),
+      static_cast<float>(stage.getB1() / a0),
+      static_cast<float>(stage.getB2() / a0),
+      static_cast<float>(stage.getA1() / a0),
+      static_cast<float>(stage.getA2() / a0)
+    });
+  }
+  return sections;
+}
+
+/// @brief Applies the cascade to the transposed samples in place.
+/// @details Sample t of lane l is at tile[t * lanes + l]. The state of
+/// section s is x[n-1], x[n-2], y[n-1], y[n-2] at [(s * 4 + k) * lanes + l]
+/// and carries over to the next tile. Each section runs over the whole
+/// tile, so that its state and coefficients stay in the registers.
+typedef void (*LanesKernel)(const BiquadCoefficients* sections, int count,
+                            float* state, float* tile, int length);
+
+#ifdef SIMD_X86
+SIMD_TARGET("avx")
+static void FilterLanesAVX(const BiquadCoefficients* sections, int count,
+                           float* state, float* tile, int length) {
+  const int lanes = 8;
+  for (int s = 0; s < count; s++) {
+    const auto& c = sections[s];
+    const __m256 b0 = _mm256_set1_ps(c.b0), b1 = _mm256_set1_ps(c.b1),
+        b2 = _mm256_set1_ps(c.b2), a1 = _mm256_set1_ps(c.a1),
+        a2 = _mm256_set1_ps(c.a2);
+    float* st = state + s * 4 * lanes;
+    __m256 x1 = _mm256_loadu_ps(st), x2 = _mm256_loadu_ps(st + lanes);
+    __m256 y1 = _mm256_loadu_ps(st + 2 * lanes);
+    __m256 y2 = _mm256_loadu_ps(st + 3 * lanes);
+    for (int t = 0; t < length; t++) {
+      __m256 x = _mm256_loadu_ps(tile + t * lanes);
+      __m256 y = _mm256_mul_ps(b0, x);
+      y = _mm256_add_ps(y, _mm256_mul_ps(b1, x1));
+      y = _mm256_add_ps(y, _mm256_mul_ps(b2, x2));
+      y = _mm256_sub_ps(y, _mm256_mul_ps(a1, y1));
+      y = _mm256_sub_ps(y, _mm256_mul_ps(a2, y2));
+      x2 = x1;
+      x1 = x;
+      y2 = y1;
+      y1 = y;
+      _mm256_storeu_ps(tile + t * lanes, y);
+    }
+    _mm256_storeu_ps(st, x1);
+    _mm256_storeu_ps(st + lanes, x2);
+    _mm256_storeu_ps(st + 2 * lanes, y1);
+    _mm256_storeu_ps(st + 3 * lanes, y2);
+  }
+}
+
+SIMD_TARGET_AVX512
+static void FilterLanesAVX512(const BiquadCoefficients* sections, int count,
+                              float* state, float* tile, int length) {
+  const int lanes = 16;
+  for (int s = 0; s < count; s++) {
+    const auto& c = sections[s];
+    const __m512 b0 = _mm512_set1_ps(c.b0), b1 = _mm512_set1_ps(c.b1),
+        b2 = _mm512_set1_ps(c.b2), a1 = _mm512_set1_ps(c.a1),
+        a2 = _mm512_set1_ps(c.a2);
+    float* st = state + s * 4 * lanes;
+    __m512 x1 = _mm512_loadu_ps(st), x2 = _mm512_loadu_ps(st + lanes);
+    __m512 y1 = _mm512_loadu_ps(st + 2 * lanes);
+    __m512 y2 = _mm512_loadu_ps(st + 3 * lanes);
+    for (int t = 0; t < length; t++) {
+      __m512 x = _mm512_loadu_ps(tile + t * lanes);
+      __m512 y = _mm512_mul_ps(b0, x);
+      y = _mm512_fmadd_ps(b1, x1, y);
+      y = _mm512_fmadd_ps(b2, x2, y);
+      y = _mm512_fnmadd_ps(a1, y1, y);
+      y = _mm512_fnmadd_ps(a2, y2, y);
+      x2 = x1;
+      x1 = x;
+      y2 = y1;
+      y1 = y;
+      _mm512_storeu_ps(tile + t * lanes, y);
+    }
+    _mm512_storeu_ps(st, x1);
+    _mm512_storeu_ps(st + lanes, x2);
+    _mm512_storeu_ps(st + 2 * lanes, y1);
+    _mm512_storeu_ps(st + 3 * lanes, y2);
+  }
+}
+#elif defined(SIMD_NEON)
+static void FilterLanesNEON(const BiquadCoefficients* sections, int count,
+                            float* state, float* tile, int length) {
+  const int lanes = 4;
+  for (int s = 0; s < count; s++) {
+    const auto& c = sections[s];
+    float* st = state + s * 4 * lanes;
+    float32x4_t x1 = vld1q_f32(st), x2 = vld1q_f32(st + lanes);
+    float32x4_t y1 = vld1q_f32(st + 2 * lanes);
+    float32x4_t y2 = vld1q_f32(st + 3 * lanes);
+    for (int t = 0; t < length; t++) {
+      float32x4_t x = vld1q_f32(tile + t * lanes);
+      float32x4_t y = vmulq_n_f32(x, c.b0);
+      y = vmlaq_n_f32(y, x1, c.b1);
+      y = vmlaq_n_f32(y, x2, c.b2);
+      y = vmlsq_n_f32(y, y1, c.a1);
+      y = vmlsq_n_f32(y, y2, c.a2);
+      x2 = x1;
+      x1 = x;
+      y2 = y1;
+      y1 = y;
+      vst1q_f32(tile + t * lanes, y);
+    }
+    vst1q_f32(st, x1);
+    vst1q_f32(st + lanes, x2);
+    vst1q_f32(st + 2 * lanes, y1);
+    vst1q_f32(st + 3 * lanes, y2);
+  }
+}
+#endif
+
+/// @brief The scalar code path is DSPFilters itself.
+static const SimdKernel<LanesKernel> kLanesKernels[] {
+#ifdef SIMD_X86
+  { InstructionSet::kAVX512, FilterLanesAVX512 },
+  { InstructionSet::kAVX, FilterLanesAVX },
+#elif defined(SIMD_NEON)
+  { InstructionSet::kNEON, FilterLanesNEON },
+#endif
+  { InstructionSet::kScalar, nullptr }
+};
+
+static int KernelLanes(InstructionSet isa) {
+  switch (isa) {
+    case InstructionSet::kAVX512:
+      return 16;
+    case InstructionSet::kAVX:
+      return 8;
+    case InstructionSet::kNEON:
+      return 4;
+    default:
+      return 1;
+  }
+}
+
+/// @brief Applies the cascade to a single sample in the direct form I.
+/// The state of section s is x[n-1], x[n-2], y[n-1], y[n-2] at [s * 4 + k].
+static inline double FilterSample(const BiquadCoefficients* sections,
+                                  int count, double* state,
+                                  double value) noexcept {
+  for (int s = 0; s < count; s++, state += 4) {
+    const auto& c = sections[s];
+    double y = c.b0 * value + c.b1 * state[0] + c.b2 * state[1] -
+        c.a1 * state[2] - c.a2 * state[3];
+    state[1] = state[0];
+    state[0] = value;
+    state[3] = state[2];
+    state[2] = y;
+    value = y;
+  }
+  return value;
+}
+
+/// @brief Filters length samples starting from state, out may be nullptr
+/// if only the final state is needed.
+static void FilterSegment(const BiquadCoefficients* sections, int count,
+                          double* state, const float* in, float* out,
+                          int length) noexcept {
+  if (out == nullptr) {
+    for (int t = 0; t < length; t++) {
+      FilterSample(sections, count, state, in[t]);
+    }
+    return;
+  }
+  for (int t = 0; t < length; t++) {
+    out[t] = FilterSample(sections, count, state, in[t]);
+  }
+}
+
+static std::vector<double> MultiplyMatrices(const std::vector<double>& a,
+                                            const std::vector<double>& b,
+                                            int size) {
+  std::vector<double> result(size * size, 0.);
+  for (int i = 0; i < size; i++) {
+    for (int k = 0; k < size; k++) {
+      double value = a[i * size + k];
+      for (int j = 0; j < size; j++) {
+        result[i * size + j] += value * b[k * size + j];
+      }
+    }
+  }
+  return result;
+}
+
+void IIRFilterBase::Initialize() const {
+  FilterBase<IIRFilter>::Initialize();
+  sections_ = Sections();
+  size_t size = (kTileLength + std::max<size_t>(sections_.size(), 1) * 4) *
+      kMaxBufferLanes;
+  lanes_.Reset(threads_number(), [size]() {
+    return std::make_shared<FloatPtr>(mallocf(size), std::free);
+  });
+  segments_ = 1;
+  segment_transition_.clear();
+  int length = input_format_->Size();
+  if (min_segment_length() > 0 && !sections_.empty()) {
+    segments_ = std::max(1, std::min(threads_number(),
+                                     length / min_segment_length()));
+  }
+  if (segments_ < 2) {
+    return;
+  }
+  // Column i of the transition over a single sample is the state after
+  // the zero input from the unit state i; raise it to the segment length
+  int order = sections_.size() * 4;
+  std::vector<double> step(order * order), column(order);
+  for (int i = 0; i < order; i++) {
+    std::fill(column.begin(), column.end(), 0.);
+    column[i] = 1;
+    FilterSample(sections_.data(), sections_.size(), column.data(), 0);
+    for (int j = 0; j < order; j++) {
+      step[j * order + i] = column[j];
+    }
+  }
+  segment_transition_.assign(order * order, 0.);
+  for (int i = 0; i < order; i++) {
+    segment_transition_[i * order + i] = 1;
+  }
+  for (int power = length / segments_; power > 0; power >>= 1) {
+    if (power & 1) {
+      segment_transition_ = MultiplyMatrices(segment_transition_, step,
+                                             order);
+    }
+    step = MultiplyMatrices(step, step, order);
+  }
+  size = segments_ * order * 2;
+  segment_states_.Reset(threads_number(), [size]() {
+    return std::make_shared<std::vector<double>>(size);
+  });
+}
+
+InstructionSet IIRFilterBase::SimdInstructionSet() const noexcept {
+  return SimdAware::Dispatch(kLanesKernels).Isa;
+}
+
+int IIRFilterBase::BufferLanes() const noexcept {
+  if (!use_simd()) {
+    return 1;
+  }
+  return KernelLanes(SimdAware::Dispatch(kLanesKernels).Isa);
+}
+
+void IIRFilterBase::FilterBuffers(const float* const* in, float* const* out,
+                                  int count) const noexcept {
+  int lanes = BufferLanes();
+  if (lanes == 1) {
+    for (int i = 0; i < count; i++) {
+      Do(in[i], out[i]);
+    }
+    return;
+  }
+  assert(count <= lanes);
+  auto kernel = SimdAware::Dispatch(kLanesKernels).Function;
+  auto scratch = lanes_.Acquire();
+  float* tile = scratch->get();
+  float* state = tile + kTileLength * kMaxBufferLanes;
+  int sections = sections_.size();
+  memsetf(state, 0.f, sections * 4 * lanes);
+  int length = input_format_->Size();
+  for (int first = 0; first < length; first += kTileLength) {
+    int size = std::min(kTileLength, length - first);
+    for (int l = 0; l < lanes; l++) {
+      if (l < count) {
+        for (int t = 0; t < size; t++) {
+          tile[t * lanes + l] = in[l][first + t];
+        }
+      } else {
+        for (int t = 0; t < size; t++) {
+          tile[t * lanes + l] = 0;
+        }
+      }
+    }
+    kernel(sections_.data(), sections, state, tile, size);
+    for (int l = 0; l < count; l++) {
+      for (int t = 0; t < size; t++) {
+        out[l][first + t] = tile[t * lanes + l];
+      }
+    }
+  }
+}
+
+int IIRFilterBase::Segments() const noexcept {
+  return segments_;
+}
+
+void IIRFilterBase::FilterSegments(const float* in,
+                                   float* out) const noexcept {
+  int length = input_format_->Size();
+  if (segments_ < 2) {
+    Do(in, out);
+    return;
+  }
+  int count = sections_.size();
+  int order = count * 4;
+  int segment = length / segments_;
+  auto states = segment_states_.Acquire();
+  double* initial = states->data();
+  double* finals = initial + segments_ * order;
+  std::fill(states->begin(), states->end(), 0.);
+  // The zero state responses; the first segment starts from the true state
+  // and the final state of the last one is not needed
+  ParallelFor(segments_ - 1, [&](size_t begin, size_t end) {
+    for (size_t k = begin; k < end; k++) {
+      FilterSegment(sections_.data(), count, finals + k * order,
+                    in + k * segment, k == 0? out : nullptr, segment);
+    }
+  });
+  for (int k = 1; k < segments_; k++) {
+    const double* previous = initial + (k - 1) * order;
+    double* state = initial + k * order;
+    for (int i = 0; i < order; i++) {
+      double value = finals[(k - 1) * order + i];
+      for (int j = 0; j < order; j++) {
+        value += segment_transition_[i * order + j] * previous[j];
+      }
+      state[i] = value;
+    }
+  }
+  ParallelFor(segments_ - 1, [&](size_t begin, size_t end) {
+    for (size_t k = begin + 1; k < end + 1; k++) {
+      int size = static_cast<int>(k) < segments_ - 1?
+          segment : length - k * segment;
+      FilterSegment(sections_.data(), count, initial + k * order,
+                    in + k * segment, out + k * segment, size);
+    }
+  });
+}
+
+void IIRFilterBase::Do(const BuffersBase<float*>& in,
+                       BuffersBase<float*>* out) const noexcept {
+  int count = in.Count();
+  if (count == 1 && segments_ > 1 && !streaming() && !serial()) {
+    FilterSegments(in[0], (*out)[0]);
+    return;
+  }
+  int lanes = BufferLanes();
+  if (streaming() || lanes == 1 || count < 2) {
+    FilterBase<IIRFilter>::Do(in, out);
+    return;
+  }
+  int batches = (count + lanes - 1) / lanes;
+  ParallelFor(batches, [&](int begin, int end) {
+    for (int b = begin; b < end; b++) {
+      const float* ins[kMaxBufferLanes];
+      float* outs[kMaxBufferLanes];
+      int size = std::min(lanes, count - b * lanes);
+      for (int i = 0; i < size; i++) {
+        ins[i] = in[b * lanes + i];
+        outs[i] = (*out)[b * lanes + i];
+      }
+      FilterBuffers(ins, outs, size);
+    }
+  });
+}
+
+}  // namespace transforms
 }  // namespace sound_feature_extraction
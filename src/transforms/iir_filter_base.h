@@ -38,6 +38,7 @@
 #pragma GCC diagnostic ignored "-Wsequence-point"
 #include <DspFilters/Dsp.h>
 #pragma GCC diagnostic pop
+#include "src/floatptr.h"
 #include "src/transforms/filter_base.h"
 
 namespace sound_feature_extraction {
@@ -100,10 +101,61 @@ namespace transforms {
 
 typedef Dsp::Cascade IIRFilter;
 
+/// @brief The coefficients of a second order section normalized by a0,
+/// applied in the direct form I:
+/// y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] - a1 y[n-1] - a2 y[n-2].
+struct BiquadCoefficients {
+  float b0, b1, b2, a1, a2;
+};
+
+/// @brief Filters the batches of buffers in a single pass: the buffers are
+/// transposed by kTileLength samples so that each of them occupies its own
+/// SIMD lane and the cascade of Sections() runs over all the lanes at once.
+/// A single long buffer is split into segments which are filtered in
+/// parallel instead, see FilterSegments().
+/// The streaming mode keeps the per-buffer DSPFilters path.
 class IIRFilterBase : public FilterBase<IIRFilter> {
  public:
   IIRFilterBase() noexcept;
 
+  using FilterBase<IIRFilter>::Do;
+
+  /// @brief Returns the second order sections of the designed filter in the
+  /// order they are applied.
+  std::vector<BiquadCoefficients> Sections() const noexcept;
+
+  virtual void Initialize() const override;
+
+  virtual InstructionSet SimdInstructionSet() const noexcept override;
+
+  /// @brief The number of buffers which FilterBuffers() processes in
+  /// a single pass, 1 without SIMD.
+  int BufferLanes() const noexcept;
+
+  /// @brief Filters count (at most kMaxBufferLanes) buffers, the same as
+  /// Do() does for each of them in the batch mode.
+  void FilterBuffers(const float* const* in, float* const* out,
+                     int count) const noexcept;
+
+  /// @brief The maximal value of BufferLanes().
+  static constexpr int kMaxBufferLanes = 16;
+
+  /// @brief The number of the segments which FilterSegments() splits
+  /// a single buffer into, 1 if it is filtered serially.
+  int Segments() const noexcept;
+
+  /// @brief Filters a single buffer the same as Do() does, splitting it
+  /// into Segments() parts. The filter is linear, so the output of each
+  /// segment is its response from the zero state plus the response of
+  /// the true initial state to the zero input. The final zero state
+  /// responses of the segments are calculated in parallel, then the true
+  /// initial states are propagated serially with the precomputed state
+  /// transition over a segment, and finally the segments are filtered in
+  /// parallel from those states. Each segment except the first and the last
+  /// one is filtered twice, so that n threads run about n / 2 times faster.
+  /// @note in and out may be the same.
+  void FilterSegments(const float* in, float* out) const noexcept;
+
   TRANSFORM_PARAMETERS_SUPPORT(IIRFilterBase)
 
   TP(type, IIRFilterType, kDefaultIIRFilterType,
@@ -112,6 +164,9 @@ class IIRFilterBase : public FilterBase<IIRFilter> {
      "Ripple level in dB (used by a subset of filter types).")
   TP(rolloff, float, kDefaultIIRFilterRolloff,
      "Rolloff level in dB (used by a subset of filter types).")
+  TP(min_segment_length, int, kDefaultMinSegmentLength,
+     "The minimal length of the segments a single buffer is split into to "
+     "filter them in parallel, 0 disables the splitting.")
 
  protected:
   template <class F>
@@ -119,14 +174,35 @@ class IIRFilterBase : public FilterBase<IIRFilter> {
                float* out) const {
     memcpy(out, in, input_format_->UnalignedSizeInBytes());
     auto ptr = std::const_pointer_cast<F>(exec);
-    ptr->reset();
+    if (!this->streaming()) {
+      ptr->reset();
+    }
     ptr->process(input_format_->Size(), &out);
   }
 
+  virtual void Do(const BuffersBase<float*>& in,
+                  BuffersBase<float*>* out) const noexcept override;
+
   static constexpr IIRFilterType kDefaultIIRFilterType =
       IIRFilterType::kChebyshevII;
   static constexpr float kDefaultIIRFilterRipple = 1;
   static constexpr float kDefaultIIRFilterRolloff = 0;
+  static constexpr int kDefaultMinSegmentLength = 65536;
+  /// @brief The number of samples of each buffer transposed at once.
+  static constexpr int kTileLength = 64;
+
+ private:
+  mutable std::vector<BiquadCoefficients> sections_;
+  /// @brief The per-thread transposed samples and the filter states of
+  /// FilterBuffers().
+  mutable ExecutorPool<FloatPtr> lanes_;
+  /// @brief See Segments().
+  mutable int segments_;
+  /// @brief The row-major matrix which transforms the state of the cascade
+  /// before a segment into the state after it for the zero input.
+  mutable std::vector<double> segment_transition_;
+  /// @brief The per-thread initial and final states of FilterSegments().
+  mutable ExecutorPool<std::vector<double>> segment_states_;
 };
 
 }  // namespace transforms
@@ -30,11 +30,16 @@
 
 #include "src/transforms/log.h"
 #include <cmath>
+#ifdef SIMD_X86
+#include <immintrin.h>
+#endif
 #ifdef __AVX__
 #include <simd/avx_mathfun.h>
 #elif defined(__ARM_NEON__)
 #include <simd/neon_mathfun.h>
 #endif
+#include "src/fixed_length.h"
+#include "src/primitives/fast_math.h"
 
 namespace sound_feature_extraction {
 namespace transforms {
@@ -52,55 +57,213 @@ LogarithmBase Parse(const std::string& value, identity<LogarithmBase>) {
   return lbit->second;
 }
 
+Precision Parse(const std::string& value, identity<Precision>) {
+  static const std::unordered_map<std::string, Precision> map {
+    { internal::kPrecisionAccurateStr, Precision::kAccurate },
+    { internal::kPrecisionFastStr, Precision::kFast }
+  };
+  auto pit = map.find(value);
+  if (pit == map.end()) {
+    throw InvalidParameterValueException();
+  }
+  return pit->second;
+}
+
+/// @brief The multiplier which converts the base 2 logarithms to base.
+static float Log2Factor(LogarithmBase base) noexcept {
+  switch (base) {
+    case LogarithmBase::kE:
+      return static_cast<float>(M_LN2);
+    case LogarithmBase::k10:
+      return static_cast<float>(M_LN2 / M_LN10);
+    case LogarithmBase::k2:
+      break;
+  }
+  return 1.f;
+}
+
+typedef void (*LogKernel)(const float* input, int length, float scale,
+                          bool add1, float* output);
+
+template <int kLength>
+static void LogScalar(const float* input, int length, float scale,
+                      bool add1, float* output) {
+  length = FIXED_LENGTH(kLength, length);
+  for (int j = 0; j < length; j++) {
+    output[j] = logf(input[j] * scale + add1);
+  }
+}
+
+#ifdef SIMD_X86
+/// @brief The natural logarithm of each element, the same Cephes based
+/// approximation as log256_ps() from simd/avx_mathfun.h.
+SIMD_TARGET_AVX512
+static inline __m512 log512_ps(__m512 x) {
+  __mmask16 invalid = _mm512_cmp_ps_mask(x, _mm512_setzero_ps(), _CMP_LE_OQ);
+  // Cut off the denormalized values
+  x = _mm512_max_ps(x, _mm512_castsi512_ps(_mm512_set1_epi32(0x00800000)));
+  __m512i exponent = _mm512_srli_epi32(_mm512_castps_si512(x), 23);
+  // Keep only the mantissa and scale it to [0.5, 1)
+  x = _mm512_castsi512_ps(_mm512_and_si512(
+      _mm512_castps_si512(x), _mm512_set1_epi32(~0x7f800000)));
+  x = _mm512_castsi512_ps(_mm512_or_si512(
+      _mm512_castps_si512(x), _mm512_castps_si512(_mm512_set1_ps(0.5f))));
+  __m512 e = _mm512_cvtepi32_ps(_mm512_sub_epi32(
+      exponent, _mm512_set1_epi32(0x7f)));
+  e = _mm512_add_ps(e, _mm512_set1_ps(1.f));
+  // if x < sqrt(1/2) then e -= 1, x = x + x - 1 else x = x - 1
+  __mmask16 small = _mm512_cmp_ps_mask(x, _mm512_set1_ps(0.707106781186547524f),
+                                       _CMP_LT_OQ);
+  __m512 tmp = _mm512_maskz_mov_ps(small, x);
+  x = _mm512_sub_ps(x, _mm512_set1_ps(1.f));
+  e = _mm512_mask_sub_ps(e, small, e, _mm512_set1_ps(1.f));
+  x = _mm512_add_ps(x, tmp);
+  __m512 z = _mm512_mul_ps(x, x);
+  __m512 y = _mm512_set1_ps(7.0376836292E-2f);
+  y = _mm512_add_ps(_mm512_mul_ps(y, x), _mm512_set1_ps(-1.1514610310E-1f));
+  y = _mm512_add_ps(_mm512_mul_ps(y, x), _mm512_set1_ps(1.1676998740E-1f));
+  y = _mm512_add_ps(_mm512_mul_ps(y, x), _mm512_set1_ps(-1.2420140846E-1f));
+  y = _mm512_add_ps(_mm512_mul_ps(y, x), _mm512_set1_ps(1.4249322787E-1f));
+  y = _mm512_add_ps(_mm512_mul_ps(y, x), _mm512_set1_ps(-1.6668057665E-1f));
+  y = _mm512_add_ps(_mm512_mul_ps(y, x), _mm512_set1_ps(2.0000714765E-1f));
+  y = _mm512_add_ps(_mm512_mul_ps(y, x), _mm512_set1_ps(-2.4999993993E-1f));
+  y = _mm512_add_ps(_mm512_mul_ps(y, x), _mm512_set1_ps(3.3333331174E-1f));
+  y = _mm512_mul_ps(_mm512_mul_ps(y, x), z);
+  y = _mm512_add_ps(y, _mm512_mul_ps(e, _mm512_set1_ps(-2.12194440e-4f)));
+  y = _mm512_sub_ps(y, _mm512_mul_ps(z, _mm512_set1_ps(0.5f)));
+  x = _mm512_add_ps(x, y);
+  x = _mm512_add_ps(x, _mm512_mul_ps(e, _mm512_set1_ps(0.693359375f)));
+  // The logarithm of a non-positive number is NaN
+  return _mm512_mask_mov_ps(x, invalid,
+                            _mm512_castsi512_ps(_mm512_set1_epi32(-1)));
+}
+
+template <int kLength>
+SIMD_TARGET_AVX512
+static void LogAVX512(const float* input, int length, float scale,
+                      bool add1, float* output) {
+  length = FIXED_LENGTH(kLength, length);
+  const __m512 vscale = _mm512_set1_ps(scale);
+  const __m512 vadd1 = _mm512_set1_ps(add1);
+  int j = 0;
+  for (; j < length - 15; j += 16) {
+    __m512 vec = _mm512_loadu_ps(input + j);
+    vec = _mm512_add_ps(_mm512_mul_ps(vec, vscale), vadd1);
+    _mm512_storeu_ps(output + j, log512_ps(vec));
+  }
+  __mmask16 tail = (1u << (length - j)) - 1;
+  __m512 vec = _mm512_mask_loadu_ps(_mm512_set1_ps(1.f), tail, input + j);
+  vec = _mm512_add_ps(_mm512_mul_ps(vec, vscale), vadd1);
+  _mm512_mask_storeu_ps(output + j, tail, log512_ps(vec));
+}
+#endif
+
+#ifdef __AVX__
+template <int kLength>
+static void LogAVX(const float* input, int length, float scale,
+                   bool add1, float* output) {
+  length = FIXED_LENGTH(kLength, length);
+  int j = 0;
+  for (; j < length - 7; j += 8) {
+    __m256 vec = _mm256_loadu_ps(input + j);
+    if (scale != 1.f) {
+      vec = _mm256_mul_ps(vec, _mm256_set1_ps(scale));
+    }
+    if (add1) {
+      vec = _mm256_add_ps(vec, _mm256_set1_ps(1.f));
+    }
+    _mm256_storeu_ps(output + j, log256_ps(vec));
+  }
+  LogScalar<0>(input + j, length - j, scale, add1, output + j);
+}
+#elif defined(__ARM_NEON__)
+template <int kLength>
+static void LogNEON(const float* input, int length, float scale,
+                    bool add1, float* output) {
+  length = FIXED_LENGTH(kLength, length);
+  int j = 0;
+  for (; j < length - 3; j += 4) {
+    float32x4_t vec = vld1q_f32(input + j);
+    if (scale != 1.f) {
+      vec = vmulq_f32(vec, vdupq_n_f32(scale));
+    }
+    if (add1) {
+      vec = vaddq_f32(vec, vdupq_n_f32(1.f));
+    }
+    vst1q_f32(output + j, log_ps(vec));
+  }
+  LogScalar<0>(input + j, length - j, scale, add1, output + j);
+}
+#endif
+
+/// @brief The natural logarithm kernels, from the most to the least
+/// preferable, specialized for kLength.
+template <int kLength>
+struct LogKernels {
+  static constexpr SimdKernel<LogKernel> kTable[] {
+#ifdef SIMD_X86
+    { InstructionSet::kAVX512, LogAVX512<kLength> },
+#endif
+#ifdef __AVX__
+    { InstructionSet::kAVX, LogAVX<kLength> },
+#elif defined(__ARM_NEON__)
+    { InstructionSet::kNEON, LogNEON<kLength> },
+#endif
+    { InstructionSet::kScalar, LogScalar<kLength> }
+  };
+};
+
+template <int kLength>
+constexpr SimdKernel<LogKernel> LogKernels<kLength>::kTable[];
+
+template <int kLength>
+static void LogE(bool simd, const float* input, int length, float scale,
+                 bool add1, float* output) {
+  if (simd) {
+    SimdAware::Dispatch(LogKernels<kLength>::kTable).Function(
+        input, length, scale, add1, output);
+  } else {
+    LogScalar<kLength>(input, length, scale, add1, output);
+  }
+}
+
+LogRaw::LogRaw() : kernel_(LogE<0>) {
+}
+
+void LogRaw::Initialize() const {
+  kernel_ = [](int length) -> Kernel {
+    SELECT_FIXED_LENGTH(LogE, length)
+  }(input_format_->Size());
+}
+
 void LogRaw::Do(bool simd, const float* input, int length,
                 float* output) const noexcept {
   bool vadd1 = add1();
   float vscale = scale();
+  if (precision() == Precision::kFast) {
+    if (vscale != 1.f || vadd1) {
+      for (int j = 0; j < length; j++) {
+        output[j] = input[j] * vscale + vadd1;
+      }
+      input = output;
+    }
+    FastLog2(simd, input, length, output);
+    float factor = Log2Factor(base());
+    if (factor != 1.f) {
+      for (int j = 0; j < length; j++) {
+        output[j] *= factor;
+      }
+    }
+    return;
+  }
   switch (base()) {
-    case LogarithmBase::kE: {
-      if (simd) {
-#ifdef __AVX__
-        for (int j = 0; j < length - 7; j += 8) {
-          __m256 vec = _mm256_load_ps(input + j);
-          if (vscale != 1.f) {
-            vec = _mm256_mul_ps(vec, _mm256_set1_ps(vscale));
-          }
-          if (vadd1) {
-            vec = _mm256_add_ps(vec, _mm256_set1_ps(1.f));
-          }
-          vec = log256_ps(vec);
-          _mm256_store_ps(output + j, vec);
-        }
-        for (int j = (length & ~0x7); j < length; j++) {
-          output[j] = logf(input[j] * vscale + vadd1);
-        }
-      } else {
-#elif defined(__ARM_NEON__)
-        int length = input_format_->Size();
-        for (int j = 0; j < length - 3; j += 4) {
-          float32x4_t vec = vld1q_f32(input + j);
-          if (vscale != 1.f) {
-            vec = vmulq_f32(vec, vdupq_n_f32(vscale));
-          }
-          if (vadd1) {
-            vec = vaddq_f32(vec, vdupq_n_f32(1.f));
-          }
-          vec = log_ps(vec);
-          vst1q_f32(output + j, vec);
-        }
-        for (int j = (length & ~0x3); j < length; j++) {
-          output[j] = logf(input[j] * vscale + vadd1);
-        }
+    case LogarithmBase::kE:
+      if (length == static_cast<int>(input_format_->Size())) {
+        kernel_(simd, input, length, vscale, vadd1, output);
       } else {
-#else
-      } {
-#endif
-        for (int j = 0; j < length; j++) {
-          output[j] = logf(input[j] * vscale + vadd1);
-        }
+        LogE<0>(simd, input, length, vscale, vadd1, output);
       }
       break;
-    }
     case LogarithmBase::k2:
       for (int j = 0; j < length; j++) {
         output[j] = log2f(input[j] * vscale + vadd1);
@@ -114,10 +277,29 @@ void LogRaw::Do(bool simd, const float* input, int length,
   }
 }
 
+InstructionSet LogRaw::SimdInstructionSet() const noexcept {
+  if (precision() == Precision::kFast) {
+    return FastMathInstructionSet();
+  }
+  if (base() != LogarithmBase::kE) {
+    return InstructionSet::kScalar;
+  }
+  return SimdAware::Dispatch(LogKernels<0>::kTable).Isa;
+}
+
+bool LogRaw::InPlace() const noexcept {
+  return true;
+}
+
 void LogRaw::Do(const float* in, float* out) const noexcept {
   Do(use_simd(), in, this->input_format_->Size(), out);
 }
 
+void LogRaw::DoElementwise(const float* in, int length,
+                           float* out) const noexcept {
+  Do(use_simd(), in, length, out);
+}
+
 void LogRawInverse::Do(const float* in UNUSED, float* out UNUSED)
     const noexcept {
   assert("Not implemented yet");
@@ -127,6 +309,11 @@ void LogSingle::Do(const float& in, float* out) const noexcept {
   float val = in;
   val *= scale();
   val += add1();
+  if (precision() == Precision::kFast) {
+    FastLog2(false, &val, 1, out);
+    *out *= Log2Factor(base());
+    return;
+  }
   switch (base()) {
     case LogarithmBase::kE:
       *out = logf(val);
@@ -31,6 +31,7 @@
 #ifndef SRC_TRANSFORMS_LOG_H_
 #define SRC_TRANSFORMS_LOG_H_
 
+#include "src/elementwise_transform.h"
 #include "src/formats/single_format.h"
 #include "src/transforms/common.h"
 
@@ -43,13 +44,25 @@ enum class LogarithmBase {
   kE
 };
 
+/// @brief The accuracy of the logarithms and the exponents.
+enum class Precision {
+  /// libm or the equivalent SIMD approximations.
+  kAccurate,
+  /// The polynomial approximations from src/primitives/fast_math.h, with
+  /// the error of about 1e-6.
+  kFast
+};
+
 namespace internal {
 constexpr const char* kLogBaseEStr = "e";
 constexpr const char* kLogBase2Str = "2";
 constexpr const char* kLogBase10Str = "10";
+constexpr const char* kPrecisionAccurateStr = "accurate";
+constexpr const char* kPrecisionFastStr = "fast";
 }
 
 LogarithmBase Parse(const std::string& value, identity<LogarithmBase>);
+Precision Parse(const std::string& value, identity<Precision>);
 
 }  // namespace transforms
 }  // namespace sound_feature_extraction
@@ -69,6 +82,21 @@ namespace std {
     }
     return "";
   }
+
+  using sound_feature_extraction::transforms::Precision;
+
+  inline string
+  to_string(const Precision& value) noexcept {
+    switch (value) {
+      case Precision::kAccurate:
+        return sound_feature_extraction::transforms::internal::
+            kPrecisionAccurateStr;
+      case Precision::kFast:
+        return sound_feature_extraction::transforms::internal::
+            kPrecisionFastStr;
+    }
+    return "";
+  }
 }  // namespace std
 
 namespace sound_feature_extraction {
@@ -78,7 +106,7 @@ template <class F>
 class LogBase : public virtual OmpUniformFormatTransform<F> {
  public:
   LogBase() : base_(kDefaultLogBase), add1_(kDefaultAdd1),
-              scale_(kDefaultScale) {
+              scale_(kDefaultScale), precision_(kDefaultPrecision) {
   }
 
   TRANSFORM_INTRO("Log",
@@ -91,16 +119,30 @@ class LogBase : public virtual OmpUniformFormatTransform<F> {
      "NaNs on zeros.")
   TP(scale, float, kDefaultScale,
      "The number to multiply each value by before taking the logarithm.")
+  TP(precision, Precision, kDefaultPrecision,
+     "The accuracy of the logarithm: \"accurate\" or \"fast\" (the "
+     "polynomial approximation with the error of about 1e-6).")
+
+  /// @brief Accuracy::kBalanced and Accuracy::kFast take the fast
+  /// logarithm, its absolute error is about 1e-6.
+  virtual void set_accuracy(Accuracy value) noexcept override {
+    precision_ = value == Accuracy::kExact? kDefaultPrecision
+                                          : Precision::kFast;
+  }
 
  protected:
   static constexpr LogarithmBase kDefaultLogBase = LogarithmBase::kE;
   static constexpr bool kDefaultAdd1 = true;
   static constexpr float kDefaultScale = 1.f;
+  static constexpr Precision kDefaultPrecision = Precision::kAccurate;
 };
 
 template <class F>
 constexpr LogarithmBase LogBase<F>::kDefaultLogBase;
 
+template <class F>
+constexpr Precision LogBase<F>::kDefaultPrecision;
+
 template <class F>
 bool LogBase<F>::validate_base(const LogarithmBase&) noexcept {
   return true;
@@ -116,6 +158,11 @@ bool LogBase<F>::validate_scale(const float& val) noexcept {
   return val > 0;
 }
 
+template <class F>
+bool LogBase<F>::validate_precision(const Precision&) noexcept {
+  return true;
+}
+
 template <class F>
 RTP(LogBase<F>, base)
 
@@ -125,12 +172,35 @@ RTP(LogBase<F>, add1)
 template <class F>
 RTP(LogBase<F>, scale)
 
-class LogRaw : public LogBase<formats::ArrayFormatF> {
+template <class F>
+RTP(LogBase<F>, precision)
+
+class LogRaw : public LogBase<formats::ArrayFormatF>,
+               public ElementwiseTransform {
+ public:
+  LogRaw();
+
+  /// @brief Picks the kernels specialized for the input length, if any.
+  virtual void Initialize() const override;
+
+  virtual void DoElementwise(const float* in, int length,
+                             float* out) const noexcept override;
+
+  virtual InstructionSet SimdInstructionSet() const noexcept override;
+
+  virtual bool InPlace() const noexcept override;
+
  protected:
   virtual void Do(const float* in, float* out) const noexcept override;
 
   void Do(bool simd, const float* input, int length,
           float* output) const noexcept;
+
+ private:
+  typedef void (*Kernel)(bool simd, const float* input, int length,
+                         float scale, bool add1, float* output);
+
+  mutable Kernel kernel_;
 };
 
 class LogRawInverse : public OmpInverseUniformFormatTransform<LogRaw> {
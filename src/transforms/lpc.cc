@@ -30,6 +30,7 @@
  */
 
 #include "src/transforms/lpc.h"
+#include <algorithm>
 #include "src/primitives/lpc.h"
 
 namespace sound_feature_extraction {
@@ -38,6 +39,8 @@ namespace transforms {
 LPC::LPC() : error_(kDefaultError) {
 }
 
+constexpr int LPC::kBatchSize;
+
 ALWAYS_VALID_TP(LPC, error)
 
 size_t LPC::OnFormatChanged(size_t buffersCount) {
@@ -49,12 +52,45 @@ size_t LPC::OnFormatChanged(size_t buffersCount) {
   return buffersCount;
 }
 
-void LPC::Do(const float* in, float* out) const noexcept {
-  float err = ldr_lpc(use_simd(), in, input_format_->Size(),
-                      out + (error_? 1 : 0));
-  if (error_) {
-    out[0] = err;
+void LPC::Do(const BuffersBase<float*>& in,
+             BuffersBase<float*>* out) const noexcept {
+  int count = in.Count();
+  int batches = (count + kBatchSize - 1) / kBatchSize;
+  this->ParallelFor(batches, [&](int begin, int end) {
+    for (int b = begin; b < end; b++) {
+      const float* acs[kBatchSize];
+      float* lpcs[kBatchSize];
+      float errors[kBatchSize];
+      int size = std::min(kBatchSize, count - b * kBatchSize);
+      for (int i = 0; i < size; i++) {
+        acs[i] = in[b * kBatchSize + i];
+        lpcs[i] = (*out)[b * kBatchSize + i] + (error_? 1 : 0);
+      }
+      ldr_lpc_batch(use_simd(), acs, size, input_format_->Size(), lpcs,
+                    error_? errors : nullptr);
+      if (error_) {
+        for (int i = 0; i < size; i++) {
+          (*out)[b * kBatchSize + i][0] = errors[i];
+        }
+      }
+    }
+  });
+}
+
+InstructionSet LPC::SimdInstructionSet() const noexcept {
+#ifdef SIMD_X86
+  if (IsEnabled(InstructionSet::kAVX512)) {
+    return InstructionSet::kAVX512;
+  }
+  if (IsEnabled(InstructionSet::kAVX)) {
+    return InstructionSet::kAVX;
+  }
+#elif defined(SIMD_NEON)
+  if (IsEnabled(InstructionSet::kNEON)) {
+    return InstructionSet::kNEON;
   }
+#endif
+  return InstructionSet::kScalar;
 }
 
 RTP(LPC, error)
@@ -37,7 +37,9 @@
 namespace sound_feature_extraction {
 namespace transforms {
 
-class LPC : public OmpUniformFormatTransform<formats::ArrayFormatF> {
+/// @brief Solves the frames in batches of kBatchSize through
+/// ldr_lpc_batch(), so that several frames share the SIMD registers.
+class LPC : public UniformFormatOmpAwareTransform<formats::ArrayFormatF> {
  public:
   LPC();
 
@@ -48,12 +50,22 @@ class LPC : public OmpUniformFormatTransform<formats::ArrayFormatF> {
 
   TP(error, bool, kDefaultError, "Include total estimation error")
 
+  virtual InstructionSet SimdInstructionSet() const noexcept override;
+
+  virtual Overlap RequiredOverlap(const Overlap& output)
+      const noexcept override {
+    return output;
+  }
+
  protected:
   virtual size_t OnFormatChanged(size_t buffersCount) override;
 
-  virtual void Do(const float* in, float* out) const noexcept override;
+  virtual void Do(const BuffersBase<float*>& in,
+                  BuffersBase<float*>* out) const noexcept override;
 
   static constexpr bool kDefaultError = false;
+  /// @brief The number of frames passed to one ldr_lpc_batch() call.
+  static constexpr int kBatchSize = 64;
 };
 
 }  // namespace transforms
@@ -29,7 +29,8 @@
  */
 
 #include "src/transforms/lpc_cc.h"
-#include <cmath>
+#include <algorithm>
+#include "src/primitives/lpc.h"
 
 namespace sound_feature_extraction {
 namespace transforms {
@@ -39,6 +40,8 @@ RTP(LPC2CC, size)
 LPC2CC::LPC2CC() : size_(kDefaultSize) {
 }
 
+constexpr int LPC2CC::kBatchSize;
+
 bool LPC2CC::validate_size(const int& value) noexcept {
   return value >= 2;
 }
@@ -52,21 +55,43 @@ size_t LPC2CC::OnFormatChanged(size_t buffersCount) {
   return buffersCount;
 }
 
-void LPC2CC::Do(const float* in, float* out) const noexcept {
-  out[0] = logf(in[0]);
-  int in_size = input_format_->Size();
-  int size = size_ == 0? (in_size + 1) : size_;
-  for (int m = 1; m < size; m++) {
-    float cm = 0;
-    for (int k = 1; k < std::min(m, in_size); k++) {
-      cm -= (m - k) * in[k] * out[m - k];
-    }
-    cm /= m;
-    if (m < in_size) {
-      cm -= in[m];
+void LPC2CC::Do(const BuffersBase<float*>& in,
+                BuffersBase<float*>* out) const noexcept {
+  int count = in.Count();
+  int batches = (count + kBatchSize - 1) / kBatchSize;
+  this->ParallelFor(batches, [&](int begin, int end) {
+    for (int b = begin; b < end; b++) {
+      const float* lpcs[kBatchSize];
+      float* ccs[kBatchSize];
+      int size = std::min(kBatchSize, count - b * kBatchSize);
+      for (int i = 0; i < size; i++) {
+        lpcs[i] = in[b * kBatchSize + i];
+        ccs[i] = (*out)[b * kBatchSize + i];
+      }
+      lpc_to_cc_batch(use_simd(), lpcs, size, input_format_->Size(), ccs,
+                      output_format_->Size());
     }
-    out[m] = cm;
+  });
+}
+
+void LPC2CC::Do(const float* in, float* out) const noexcept {
+  lpc_to_cc(in, input_format_->Size(), out, output_format_->Size());
+}
+
+InstructionSet LPC2CC::SimdInstructionSet() const noexcept {
+#ifdef SIMD_X86
+  if (IsEnabled(InstructionSet::kAVX512)) {
+    return InstructionSet::kAVX512;
+  }
+  if (IsEnabled(InstructionSet::kAVX)) {
+    return InstructionSet::kAVX;
+  }
+#elif defined(SIMD_NEON)
+  if (IsEnabled(InstructionSet::kNEON)) {
+    return InstructionSet::kNEON;
   }
+#endif
+  return InstructionSet::kScalar;
 }
 
 REGISTER_TRANSFORM(LPC2CC);
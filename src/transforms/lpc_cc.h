@@ -36,7 +36,9 @@
 namespace sound_feature_extraction {
 namespace transforms {
 
-class LPC2CC : public OmpUniformFormatTransform<formats::ArrayFormatF> {
+/// @brief Converts the frames in batches of kBatchSize through
+/// lpc_to_cc_batch(), so that several frames share the SIMD registers.
+class LPC2CC : public UniformFormatOmpAwareTransform<formats::ArrayFormatF> {
  public:
   LPC2CC();
 
@@ -47,12 +49,24 @@ class LPC2CC : public OmpUniformFormatTransform<formats::ArrayFormatF> {
   TP(size, int, kDefaultSize,
      "The number of cepstral coefficients. 0 means original LPC length.")
 
+  virtual InstructionSet SimdInstructionSet() const noexcept override;
+
+  virtual Overlap RequiredOverlap(const Overlap& output)
+      const noexcept override {
+    return output;
+  }
+
  protected:
   virtual size_t OnFormatChanged(size_t buffersCount) override;
 
-  virtual void Do(const float* in, float* out) const noexcept override;
+  virtual void Do(const BuffersBase<float*>& in,
+                  BuffersBase<float*>* out) const noexcept override;
+  /// @brief Converts a single frame.
+  void Do(const float* in, float* out) const noexcept;
 
   static constexpr int kDefaultSize = 0;
+  /// @brief The number of frames passed to one lpc_to_cc_batch() call.
+  static constexpr int kBatchSize = 64;
 };
 
 }  // namespace transforms
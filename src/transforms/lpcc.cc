@@ -0,0 +1,100 @@
+/*! @file lpcc.cc
+ *  @brief Fused LPC calculation and conversion to cepstral coefficients.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+#include "src/transforms/lpcc.h"
+#include <algorithm>
+#include "src/primitives/lpc.h"
+
+namespace sound_feature_extraction {
+namespace transforms {
+
+LPCC::LPCC() : error_(kDefaultError), size_(kDefaultSize) {
+}
+
+constexpr int LPCC::kBatchSize;
+
+ALWAYS_VALID_TP(LPCC, error)
+
+bool LPCC::validate_size(const int& value) noexcept {
+  return value >= 2;
+}
+
+size_t LPCC::OnFormatChanged(size_t buffersCount) {
+  if (size_ != kDefaultSize) {
+    output_format_->SetSize(size_);
+  } else if (!error_) {
+    output_format_->SetSize(input_format_->Size() - 1);
+  } else {
+    output_format_->SetSize(input_format_->Size());
+  }
+  return buffersCount;
+}
+
+void LPCC::Do(const BuffersBase<float*>& in,
+              BuffersBase<float*>* out) const noexcept {
+  int count = in.Count();
+  int batches = (count + kBatchSize - 1) / kBatchSize;
+  this->ParallelFor(batches, [&](int begin, int end) {
+    for (int b = begin; b < end; b++) {
+      const float* acs[kBatchSize];
+      float* ccs[kBatchSize];
+      int size = std::min(kBatchSize, count - b * kBatchSize);
+      for (int i = 0; i < size; i++) {
+        acs[i] = in[b * kBatchSize + i];
+        ccs[i] = (*out)[b * kBatchSize + i];
+      }
+      ldr_lpc_cc_batch(use_simd(), acs, size, input_format_->Size(), error_,
+                       ccs, output_format_->Size());
+    }
+  });
+}
+
+InstructionSet LPCC::SimdInstructionSet() const noexcept {
+#ifdef SIMD_X86
+  if (IsEnabled(InstructionSet::kAVX512)) {
+    return InstructionSet::kAVX512;
+  }
+  if (IsEnabled(InstructionSet::kAVX)) {
+    return InstructionSet::kAVX;
+  }
+#elif defined(SIMD_NEON)
+  if (IsEnabled(InstructionSet::kNEON)) {
+    return InstructionSet::kNEON;
+  }
+#endif
+  return InstructionSet::kScalar;
+}
+
+RTP(LPCC, error)
+RTP(LPCC, size)
+REGISTER_TRANSFORM(LPCC);
+
+}  // namespace transforms
+}  // namespace sound_feature_extraction
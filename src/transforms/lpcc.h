@@ -0,0 +1,80 @@
+/*! @file lpcc.h
+ *  @brief Fused LPC calculation and conversion to cepstral coefficients.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+#ifndef SRC_TRANSFORMS_LPCC_H_
+#define SRC_TRANSFORMS_LPCC_H_
+
+#include "src/transforms/common.h"
+
+namespace sound_feature_extraction {
+namespace transforms {
+
+/// @brief Calculates the same as LPC and LPCtoCC applied in a row, without
+/// storing the intermediate buffers.
+/// @details TransformTree substitutes the matching chains with this
+/// transform (see TransformTree::set_fuse_transforms()). The frames are
+/// solved in batches of kBatchSize through ldr_lpc_cc_batch(), which
+/// converts LPC while they are still transposed in the SIMD scratch.
+class LPCC : public UniformFormatOmpAwareTransform<formats::ArrayFormatF> {
+ public:
+  LPCC();
+
+  TRANSFORM_INTRO("LPCC", "Calculates the cepstral coefficients of Linear "
+                          "Prediction from autocorrelation coefficients "
+                          "(LPC -> LPCtoCC).",
+                  LPCC)
+
+  TP(error, bool, kDefaultError,
+     "Include total estimation error into LPC before the conversion")
+  TP(size, int, kDefaultSize,
+     "The number of cepstral coefficients. 0 means original LPC length.")
+
+  virtual InstructionSet SimdInstructionSet() const noexcept override;
+
+  virtual Overlap RequiredOverlap(const Overlap& output)
+      const noexcept override {
+    return output;
+  }
+
+ protected:
+  virtual size_t OnFormatChanged(size_t buffersCount) override;
+
+  virtual void Do(const BuffersBase<float*>& in,
+                  BuffersBase<float*>* out) const noexcept override;
+
+  static constexpr bool kDefaultError = false;
+  static constexpr int kDefaultSize = 0;
+  /// @brief The number of frames passed to one ldr_lpc_cc_batch() call.
+  static constexpr int kBatchSize = 64;
+};
+
+}  // namespace transforms
+}  // namespace sound_feature_extraction
+#endif  // SRC_TRANSFORMS_LPCC_H_
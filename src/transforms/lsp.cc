@@ -30,12 +30,33 @@
  */
 
 #include "src/transforms/lsp.h"
+#include <algorithm>
 #include "src/primitives/lsp.h"
 
 namespace sound_feature_extraction {
 namespace transforms {
 
-LSP::LSP() : intervals_(kDefaultIntervals), bisects_(kDefaultBisects) {
+LSPRefinement Parse(const std::string& value, identity<LSPRefinement>) {
+  static const std::unordered_map<std::string, LSPRefinement> map {
+    { internal::kLSPRefinementBisectionStr, LSPRefinement::kBisection },
+    { internal::kLSPRefinementIllinoisStr, LSPRefinement::kIllinois }
+  };
+  auto lri = map.find(value);
+  if (lri == map.end()) {
+    throw InvalidParameterValueException();
+  }
+  return lri->second;
+}
+
+constexpr int LSP::kDefaultBisects;
+constexpr int LSP::kFastBisects;
+constexpr LSPRefinement LSP::kDefaultRefinement;
+constexpr int LSP::kBatchSize;
+
+LSP::LSP()
+    : intervals_(kDefaultIntervals),
+      bisects_(kDefaultBisects),
+      refinement_(kDefaultRefinement) {
 }
 
 bool LSP::validate_intervals(const int& value) noexcept {
@@ -46,13 +67,54 @@ bool LSP::validate_bisects(const int& value) noexcept {
   return value > 1;
 }
 
-void LSP::Do(const float* in, float* out) const noexcept {
-  lpc_to_lsp(use_simd(), in, input_format_->Size(), bisects_,
-             2.f / intervals_, out);
+ALWAYS_VALID_TP(LSP, refinement)
+
+void LSP::set_accuracy(Accuracy value) noexcept {
+  refinement_ = value == Accuracy::kExact? kDefaultRefinement
+                                         : LSPRefinement::kIllinois;
+  bisects_ = value == Accuracy::kFast? kFastBisects : kDefaultBisects;
+}
+
+void LSP::Do(const BuffersBase<float*>& in,
+             BuffersBase<float*>* out) const noexcept {
+  int count = in.Count();
+  int batches = (count + kBatchSize - 1) / kBatchSize;
+  auto refinement = refinement_ == LSPRefinement::kIllinois?
+      LSP_REFINEMENT_ILLINOIS : LSP_REFINEMENT_BISECTION;
+  this->ParallelFor(batches, [&](int begin, int end) {
+    for (int b = begin; b < end; b++) {
+      const float* lpcs[kBatchSize];
+      float* freqs[kBatchSize];
+      int size = std::min(kBatchSize, count - b * kBatchSize);
+      for (int i = 0; i < size; i++) {
+        lpcs[i] = in[b * kBatchSize + i];
+        freqs[i] = (*out)[b * kBatchSize + i];
+      }
+      lpc_to_lsp_batch(use_simd(), lpcs, size, input_format_->Size(), bisects_,
+                       2.f / intervals_, refinement, freqs, nullptr);
+    }
+  });
+}
+
+InstructionSet LSP::SimdInstructionSet() const noexcept {
+#ifdef SIMD_X86
+  if (IsEnabled(InstructionSet::kAVX512)) {
+    return InstructionSet::kAVX512;
+  }
+  if (IsEnabled(InstructionSet::kAVX)) {
+    return InstructionSet::kAVX;
+  }
+#elif defined(SIMD_NEON)
+  if (IsEnabled(InstructionSet::kNEON)) {
+    return InstructionSet::kNEON;
+  }
+#endif
+  return InstructionSet::kScalar;
 }
 
 RTP(LSP, intervals)
 RTP(LSP, bisects)
+RTP(LSP, refinement)
 REGISTER_TRANSFORM(LSP);
 
 }  // namespace transforms
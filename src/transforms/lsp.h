@@ -37,7 +37,44 @@
 namespace sound_feature_extraction {
 namespace transforms {
 
-class LSP : public OmpUniformFormatTransform<formats::ArrayFormatF> {
+enum class LSPRefinement {
+  kBisection,
+  kIllinois
+};
+
+namespace internal {
+constexpr const char* kLSPRefinementBisectionStr = "bisection";
+constexpr const char* kLSPRefinementIllinoisStr = "illinois";
+}
+
+LSPRefinement Parse(const std::string& value, identity<LSPRefinement>);
+
+}  // namespace transforms
+}  // namespace sound_feature_extraction
+
+namespace std {
+  using sound_feature_extraction::transforms::LSPRefinement;
+
+  inline string
+  to_string(const LSPRefinement& value) noexcept {
+    switch (value) {
+      case LSPRefinement::kBisection:
+        return sound_feature_extraction::transforms::internal::
+            kLSPRefinementBisectionStr;
+      case LSPRefinement::kIllinois:
+        return sound_feature_extraction::transforms::internal::
+            kLSPRefinementIllinoisStr;
+    }
+    return "";
+  }
+}  // namespace std
+
+namespace sound_feature_extraction {
+namespace transforms {
+
+/// @brief Converts the frames in batches of kBatchSize through
+/// lpc_to_lsp_batch().
+class LSP : public UniformFormatOmpAwareTransform<formats::ArrayFormatF> {
  public:
   LSP();
 
@@ -54,12 +91,30 @@ class LSP : public OmpUniformFormatTransform<formats::ArrayFormatF> {
      "The number of bisections for the root value refinement. "
      "The bigger the number, the more precise the values are "
      "and the less probability is to skip a root.")
+  TP(refinement, LSPRefinement, kDefaultRefinement,
+     "The root refinement method. Allowed values are \"bisection\" and "
+     "\"illinois\". The latter converges in fewer steps.")
+
+  /// @brief Accuracy::kBalanced refines the roots with the Illinois method
+  /// to the same bracket of 2 / intervals / 2^(bisects + 1), about 1e-7 in
+  /// the cosine domain. Accuracy::kFast also takes kFastBisects, which
+  /// leaves the bracket of about 8e-6.
+  virtual void set_accuracy(Accuracy value) noexcept override;
+
+  virtual InstructionSet SimdInstructionSet() const noexcept override;
 
  protected:
-  virtual void Do(const float* in, float* out) const noexcept override;
+  virtual void Do(const BuffersBase<float*>& in,
+                  BuffersBase<float*>* out) const noexcept override;
 
   static constexpr int kDefaultIntervals = 128;
   static constexpr int kDefaultBisects = 16;
+  /// @brief The bisects of Accuracy::kFast.
+  static constexpr int kFastBisects = 10;
+  static constexpr LSPRefinement kDefaultRefinement =
+      LSPRefinement::kBisection;
+  /// @brief The number of frames passed to one lpc_to_lsp_batch() call.
+  static constexpr int kBatchSize = 64;
 };
 
 }  // namespace transforms
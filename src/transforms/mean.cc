@@ -30,13 +30,11 @@
 
 #include "src/transforms/mean.h"
 #include <algorithm>
+#include <cmath>
 #include <limits>
 #include <simd/arithmetic-inl.h>
 #include <simd/mathfun.h>
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wold-style-cast"
-#include <boost/regex.hpp>
-#pragma GCC diagnostic pop
+#include "src/primitives/fast_math.h"
 
 namespace sound_feature_extraction {
 namespace transforms {
@@ -50,40 +48,80 @@ std::set<MeanType> Parse(const std::string& value,
     { internal::kMeanTypeGeometricStr, kMeanTypeGeometric },
   };
 
-  static const boost::regex all_regex("^\\s*(\\w+\\s*(\\s|$))+");
-  boost::smatch match;
-  if (!boost::regex_match(value, match, all_regex)) {
+  std::vector<std::string> words;
+  if (!SplitWords(value, &words)) {
     throw InvalidParameterValueException();
   }
 
   std::set<MeanType> ret;
-  std::transform(boost::sregex_token_iterator(value.begin(), value.end(),
-                                            boost::regex("\\s*(\\w+)\\s*"),
-                                            1),
-                 boost::sregex_token_iterator(),
-                 std::inserter(ret, ret.begin()),
-                 [](const std::string& subval) {
-    auto mtypeit = map.find(subval);
+  for (auto& word : words) {
+    auto mtypeit = map.find(word);
     if (mtypeit == map.end()) {
       throw InvalidParameterValueException();
     }
-    return mtypeit->second;
-  });
-
+    ret.insert(mtypeit->second);
+  }
   return ret;
 }
 
-Mean::Mean() : types_(kDefaultMeanTypes()) {
+constexpr Precision Mean::kDefaultPrecision;
+
+Mean::Mean() : types_(kDefaultMeanTypes()), precision_(kDefaultPrecision) {
 }
 
 ALWAYS_VALID_TP(Mean, types)
+ALWAYS_VALID_TP(Mean, precision)
+
+bool Mean::SupportsSoAOutput() const noexcept {
+  return true;
+}
+
+void Mean::set_accuracy(Accuracy value) noexcept {
+  precision_ = value == Accuracy::kExact? kDefaultPrecision : Precision::kFast;
+}
+
+void Mean::Do(const InBuffers& in, OutBuffers* out) const noexcept {
+  if (!soa_output()) {
+    this->ParallelFor(in.Count(), [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        Do(in[i], &(*out)[i]);
+      }
+    });
+    return;
+  }
+  float* columns[kMeanTypeCount];
+  for (int j = 0; j < kMeanTypeCount; j++) {
+    columns[j] = formats::FieldColumn(out, j);
+  }
+  this->ParallelFor(in.Count(), [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      FixedArray<kMeanTypeCount> means;
+      Do(in[i], &means);
+      for (int j = 0; j < kMeanTypeCount; j++) {
+        columns[j][i] = means[j];
+      }
+    }
+  });
+}
 
 void Mean::Do(const float* in,
             FixedArray<kMeanTypeCount>* out) const noexcept {
+  if (precision_ == Precision::kFast &&
+      types_.find(kMeanTypeArithmetic) != types_.end() &&
+      types_.find(kMeanTypeGeometric) != types_.end()) {
+    // Both means in a single pass over the input
+    size_t length = input_format_->Size();
+    float sum, log2sum;
+    FastSums(use_simd(), in, length, &sum, &log2sum);
+    (*out)[kMeanTypeArithmetic] = sum / length;
+    (*out)[kMeanTypeGeometric] = exp2f(log2sum / length);
+    return;
+  }
   for (int j = 0; j < kMeanTypeCount; j++) {
     auto mt = static_cast<MeanType>(j);
     if (types_.find(mt) != types_.end()) {
-      (*out)[j] = Do(use_simd(), in, input_format_->Size(), mt);
+      (*out)[j] = Do(use_simd(), in, input_format_->Size(), mt,
+                     precision_);
     } else {
       (*out)[j] = 0;
     }
@@ -91,7 +129,7 @@ void Mean::Do(const float* in,
 }
 
 float Mean::Do(bool simd, const float* input, size_t length,
-               MeanType type) noexcept {
+               MeanType type, Precision precision) noexcept {
   int ilength = static_cast<int>(length);
   switch (type) {
     case kMeanTypeArithmetic: {
@@ -109,6 +147,10 @@ float Mean::Do(bool simd, const float* input, size_t length,
       return res;
     }
     case kMeanTypeGeometric: {
+      if (precision == Precision::kFast) {
+        // The sum of the logarithms neither overflows nor underflows
+        return exp2f(FastLog2Sum(simd, input, length) / length);
+      }
       const float power = 1.f / ilength;
       if (simd) {
 #ifdef __AVX__
@@ -210,6 +252,7 @@ float Mean::Do(bool simd, const float* input, size_t length,
 }
 
 RTP(Mean, types)
+RTP(Mean, precision)
 REGISTER_TRANSFORM(Mean);
 
 }  // namespace transforms
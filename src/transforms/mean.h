@@ -33,7 +33,9 @@
 
 #include <set>
 #include "src/formats/single_format.h"
+#include "src/struct_of_arrays_transform.h"
 #include "src/transforms/common.h"
+#include "src/transforms/log.h"
 
 namespace sound_feature_extraction {
 namespace transforms {
@@ -84,9 +86,10 @@ namespace sound_feature_extraction {
 namespace transforms {
 
 class Mean
-    : public OmpTransformBase<formats::ArrayFormatF,
-                              formats::SingleFormat<
-                                  formats::FixedArray<kMeanTypeCount>>> {
+    : public OmpAwareTransform<formats::ArrayFormatF,
+                               formats::SingleFormat<
+                                   formats::FixedArray<kMeanTypeCount>>>,
+      public StructOfArraysTransform {
  public:
   Mean();
 
@@ -94,18 +97,37 @@ class Mean
 
   TP(types, std::set<MeanType>, kDefaultMeanTypes(),
      "Mean types to calculate (names separated with spaces).")
+  TP(precision, Precision, kDefaultPrecision,
+     "The accuracy of the geometric mean: \"accurate\" or \"fast\" (the "
+     "exponent of the mean of the approximated logarithms).")
+
+  virtual bool SupportsSoAOutput() const noexcept override;
+
+  /// @brief Accuracy::kBalanced and Accuracy::kFast take the fast geometric
+  /// mean, its relative error is about 1e-6.
+  virtual void set_accuracy(Accuracy value) noexcept override;
+
+  virtual Overlap RequiredOverlap(const Overlap& output)
+      const noexcept override {
+    return output;
+  }
 
  protected:
-  virtual void Do(const float* in,
-                  formats::FixedArray<kMeanTypeCount>* out)
+  virtual void Do(const InBuffers& in, OutBuffers* out)
       const noexcept override;
 
+  void Do(const float* in,
+          formats::FixedArray<kMeanTypeCount>* out) const noexcept;
+
   static float Do(bool simd, const float* input, size_t length,
-                  MeanType type) noexcept;
+                  MeanType type,
+                  Precision precision = kDefaultPrecision) noexcept;
 
   static std::set<MeanType> kDefaultMeanTypes() noexcept {
     return { kMeanTypeArithmetic };
   }
+
+  static constexpr Precision kDefaultPrecision = Precision::kAccurate;
 };
 
 }  // namespace transforms
@@ -30,6 +30,11 @@
 
 #include "src/transforms/mix_stereo.h"
 #include <simd/instruction_set.h>
+#ifdef SIMD_X86
+#include <immintrin.h>
+#elif defined(SIMD_NEON)
+#include <arm_neon.h>
+#endif
 
 namespace sound_feature_extraction {
 namespace transforms {
@@ -39,54 +44,93 @@ size_t MixStereo::OnFormatChanged(size_t buffersCount) {
   return buffersCount;
 }
 
-void MixStereo::Do(const int16_t* in, int16_t* out) const noexcept {
-  int length = input_format_->Size();
-  if (use_simd()) {
-#ifdef __AVX__
-    int offset = align_complement_i16(in);
-    for (int i = 0; i < offset; i += 2) {
-      int16_t l = in[i] / 2;
-      int16_t r = in[i + 1] / 2;
-      out[i / 2] = l + r;
-    }
-    for (int i = offset; i < length - offset - 15; i += 16) {
-      __m128i vec1 = _mm_load_si128(
-          reinterpret_cast<const __m128i*>(in + i));
-      __m128i vec2 = _mm_load_si128(
-          reinterpret_cast<const __m128i*>(in + i + 8));
-      vec1 = _mm_srai_epi16(vec1, 1);
-      vec2 = _mm_srai_epi16(vec2, 1);
-      __m128i res = _mm_hadd_epi16(vec1, vec2);
-      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i / 2), res);
-    }
-    for (int i = ((length - offset) & ~0xF); i < length; i += 2) {
-      int16_t l = in[i] / 2;
-      int16_t r = in[i + 1] / 2;
-      out[i / 2] = l + r;
-    }
-  } else {
-#elif defined(__ARM_NEON__)
-    for (int i = 0; i < length - 15; i += 16) {
-      int16x8x2_t vec = vld2q_s16(in + i);
-      int16x8_t res = vshrq_n_s16(vec.val[0], 1);
-      res = vsraq_n_s16(res, vec.val[1], 1);
-      vst1q_s16(out + i / 2, res);
-    }
-    for (int i = (length & ~0xF); i < length; i += 2) {
-      int16_t l = in[i] / 2;
-      int16_t r = in[i + 1] / 2;
-      out[i / 2] = l + r;
-    }
-  } else {
-#else
-  } {
-#endif
-    for (int i = 0; i < length; i += 2) {
-      int16_t l = in[i] / 2;
-      int16_t r = in[i + 1] / 2;
-      out[i / 2] = l + r;
-    }
+typedef void (*MixStereoKernel)(const int16_t* in, int length, int16_t* out);
+
+static void MixStereoScalar(const int16_t* in, int length, int16_t* out) {
+  for (int i = 0; i < length; i += 2) {
+    int16_t l = in[i] / 2;
+    int16_t r = in[i + 1] / 2;
+    out[i / 2] = l + r;
+  }
+}
+
+#ifdef SIMD_X86
+/// @brief Divides each element by 2 rounding towards zero, the same as
+/// the scalar division does.
+SIMD_TARGET("sse4.1")
+static inline __m128i halve_epi16(__m128i vec) {
+  return _mm_srai_epi16(_mm_add_epi16(vec, _mm_srli_epi16(vec, 15)), 1);
+}
+
+SIMD_TARGET("sse4.1")
+static void MixStereoSSE41(const int16_t* in, int length, int16_t* out) {
+  int i = 0;
+  for (; i < length - 15; i += 16) {
+    __m128i vec1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    __m128i vec2 = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(in + i + 8));
+    __m128i res = _mm_hadd_epi16(halve_epi16(vec1), halve_epi16(vec2));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i / 2), res);
+  }
+  MixStereoScalar(in + i, length - i, out + i / 2);
+}
+
+SIMD_TARGET("avx2")
+static inline __m256i halve_epi16_avx2(__m256i vec) {
+  return _mm256_srai_epi16(
+      _mm256_add_epi16(vec, _mm256_srli_epi16(vec, 15)), 1);
+}
+
+SIMD_TARGET("avx2")
+static void MixStereoAVX2(const int16_t* in, int length, int16_t* out) {
+  int i = 0;
+  for (; i < length - 31; i += 32) {
+    __m256i vec1 = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(in + i));
+    __m256i vec2 = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(in + i + 16));
+    __m256i res = _mm256_hadd_epi16(halve_epi16_avx2(vec1),
+                                    halve_epi16_avx2(vec2));
+    // hadd works within 128-bit lanes, restore the order of the quadwords
+    res = _mm256_permute4x64_epi64(res, 0xD8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i / 2), res);
   }
+  MixStereoScalar(in + i, length - i, out + i / 2);
+}
+#elif defined(SIMD_NEON)
+static inline int16x8_t halve_s16(int16x8_t vec) {
+  uint16x8_t sign = vshrq_n_u16(vreinterpretq_u16_s16(vec), 15);
+  return vshrq_n_s16(vaddq_s16(vec, vreinterpretq_s16_u16(sign)), 1);
+}
+
+static void MixStereoNEON(const int16_t* in, int length, int16_t* out) {
+  int i = 0;
+  for (; i < length - 15; i += 16) {
+    int16x8x2_t vec = vld2q_s16(in + i);
+    int16x8_t res = vaddq_s16(halve_s16(vec.val[0]), halve_s16(vec.val[1]));
+    vst1q_s16(out + i / 2, res);
+  }
+  MixStereoScalar(in + i, length - i, out + i / 2);
+}
+#endif
+
+static const SimdKernel<MixStereoKernel> kMixStereoKernels[] {
+#ifdef SIMD_X86
+  { InstructionSet::kAVX2, MixStereoAVX2 },
+  { InstructionSet::kSSE41, MixStereoSSE41 },
+#elif defined(SIMD_NEON)
+  { InstructionSet::kNEON, MixStereoNEON },
+#endif
+  { InstructionSet::kScalar, MixStereoScalar }
+};
+
+void MixStereo::Do(const int16_t* in, int16_t* out) const noexcept {
+  SimdAware::Dispatch(kMixStereoKernels).Function(
+      in, input_format_->Size(), out);
+}
+
+InstructionSet MixStereo::SimdInstructionSet() const noexcept {
+  return SimdAware::Dispatch(kMixStereoKernels).Isa;
 }
 
 
@@ -41,6 +41,8 @@ class MixStereo : public OmpUniformFormatTransform<formats::ArrayFormat16> {
  public:
   TRANSFORM_INTRO("Mix", "Mix stereo audio channels together.", MixStereo)
 
+  virtual InstructionSet SimdInstructionSet() const noexcept override;
+
  protected:
   virtual size_t OnFormatChanged(size_t buffersCount) override;
 
@@ -0,0 +1,134 @@
+/*! @file multi_resolution_spectrum.cc
+ *  @brief Power spectra of several window lengths on the same hops.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#include "src/transforms/multi_resolution_spectrum.h"
+#include <cstring>
+#include <simd/memory.h>
+#include "src/fftf_wisdom.h"
+#include "src/make_unique.h"
+#include "src/transforms/spectral_energy.h"
+
+namespace sound_feature_extraction {
+namespace transforms {
+
+constexpr WindowType MultiResolutionSpectrum::kDefaultWindow;
+
+MultiResolutionSpectrum::MultiResolutionSpectrum() noexcept
+    : levels_(kDefaultLevels), window_(kDefaultWindow) {
+}
+
+bool MultiResolutionSpectrum::validate_levels(const int& value) noexcept {
+  return value >= 1 && value <= 16;
+}
+
+ALWAYS_VALID_TP(MultiResolutionSpectrum, window)
+
+int MultiResolutionSpectrum::LevelLength(int level) const noexcept {
+  return input_format_->Size() >> level;
+}
+
+size_t MultiResolutionSpectrum::OnFormatChanged(size_t buffersCount) {
+  size_t size = 0;
+  for (int level = 0; level < levels_; level++) {
+    int length = LevelLength(level);
+    if (length < 2 || (length & 1) != 0) {
+      throw InvalidParameterValueException(
+          "levels", std::to_string(levels_), HostName());
+    }
+    size += length / 2 + 1;
+  }
+  output_format_->SetSize(size);
+  return buffersCount;
+}
+
+void MultiResolutionSpectrum::Initialize() const {
+  windows_.clear();
+  for (int level = 0; level < levels_; level++) {
+    windows_.push_back(window_ != WindowType::kWindowTypeRectangular?
+        SharedWindow(window_, LevelLength(level)) : nullptr);
+  }
+  executors_.Reset(threads_number(), [this]() { return CreateExecutor(); });
+}
+
+std::shared_ptr<MultiResolutionSpectrum::Executor>
+MultiResolutionSpectrum::CreateExecutor() const noexcept {
+  auto exec = std::make_shared<Executor>();
+  int longest = LevelLength(0);
+  exec->Frame = std::uniquify(mallocf(longest + 2), std::free);
+  for (int level = 0; level < levels_; level++) {
+    int length = LevelLength(level);
+    auto backend = FFTFWisdom::Instance().Select(
+        FFTF_TYPE_REAL, FFTF_DIRECTION_FORWARD, length, 1);
+    exec->Plans.emplace_back(fftf_init(
+        FFTF_TYPE_REAL, FFTF_DIRECTION_FORWARD, FFTF_DIMENSION_1D,
+        &length, FFTF_NO_OPTIONS, exec->Frame.get(), exec->Frame.get()),
+        fftf_destroy);
+  }
+  return exec;
+}
+
+void MultiResolutionSpectrum::Do(const float* in,
+                                 float* out) const noexcept {
+  auto exec = executors_.Acquire();
+  float* frame = exec->Frame.get();
+  int longest = LevelLength(0);
+  for (int level = 0; level < levels_; level++) {
+    int length = LevelLength(level);
+    // The levels share the center of the frame
+    const float* part = in + (longest - length) / 2;
+    if (windows_[level]) {
+      Window::ApplyWindow(use_simd(), windows_[level].get(), length, part,
+                          frame);
+    } else {
+      memcpy(frame, part, length * sizeof(float));
+    }
+    fftf_calc(exec->Plans[level].get());
+    SpectralEnergy::Do(use_simd(), frame, length + 2, out);
+    out += length / 2 + 1;
+  }
+}
+
+size_t MultiResolutionSpectrum::PrivateMemorySize() const noexcept {
+  size_t windows = 0;
+  for (int level = 0; level < levels_; level++) {
+    if (window_ != WindowType::kWindowTypeRectangular) {
+      windows += LevelLength(level) * sizeof(float);
+    }
+  }
+  return windows + threads_number() * (LevelLength(0) + 2) * sizeof(float);
+}
+
+RTP(MultiResolutionSpectrum, levels)
+RTP(MultiResolutionSpectrum, window)
+REGISTER_TRANSFORM(MultiResolutionSpectrum);
+
+}  // namespace transforms
+}  // namespace sound_feature_extraction
@@ -0,0 +1,107 @@
+/*! @file multi_resolution_spectrum.h
+ *  @brief Power spectra of several window lengths on the same hops.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#ifndef SRC_TRANSFORMS_MULTI_RESOLUTION_SPECTRUM_H_
+#define SRC_TRANSFORMS_MULTI_RESOLUTION_SPECTRUM_H_
+
+#include <fftf/api.h>
+#include <vector>
+#include "src/executor_pool.h"
+#include "src/transforms/window.h"
+
+namespace sound_feature_extraction {
+namespace transforms {
+
+/// @brief Calculates the power spectra of the window and of its central
+/// halves, quarters, etc., which share the centers and thus the hops.
+/// @details Instead of a separate Window -> WindowFunction -> RDFT ->
+/// SpectralEnergy branch per window length, the input is split into
+/// the longest windows once, e.g. "Window(length=1024, type=rectangular)",
+/// and each frame is read once: every level windows its central part into
+/// a per-thread scratch, which stays in the cache together with all
+/// the FFT plans, and converts it to the squared magnitudes right away.
+/// The output is the spectra of all the levels one after another, from
+/// the longest window, (L / 2^k) / 2 + 1 values each; Selector(offset=...)
+/// picks one of them.
+class MultiResolutionSpectrum
+    : public OmpUniformFormatTransform<formats::ArrayFormatF> {
+ public:
+  MultiResolutionSpectrum() noexcept;
+
+  TRANSFORM_INTRO("MultiResolutionSpectrum",
+                  "Calculates the power spectra of the window and of its "
+                  "central halves, quarters, etc., one after another.",
+                  MultiResolutionSpectrum)
+
+  TP(levels, int, kDefaultLevels,
+     "The number of the window lengths, each next is the half of "
+     "the previous.")
+  TP(window, WindowType, kDefaultWindow,
+     "Type of the window function applied before each FFT. "
+     "\"rectangular\" means no windowing.")
+
+  virtual void Initialize() const override;
+
+  /// @brief Includes the window functions and the per-thread frames.
+  virtual size_t PrivateMemorySize() const noexcept override;
+
+ protected:
+  static constexpr int kDefaultLevels = 3;
+  static constexpr WindowType kDefaultWindow = WindowType::kWindowTypeHamming;
+
+  virtual size_t OnFormatChanged(size_t buffersCount) override;
+
+  virtual void Do(const float* in,
+                  float* out) const noexcept override;
+
+ private:
+  /// @brief The scratch of a single thread with the in-place FFT plans of
+  /// all the levels.
+  struct Executor {
+    Executor() : Frame(nullptr, std::free) {
+    }
+
+    FloatPtr Frame;
+    std::vector<std::unique_ptr<FFTFInstance, void (*)(FFTFInstance*)>>
+        Plans;
+  };
+
+  /// @brief The window length of the level.
+  int LevelLength(int level) const noexcept;
+  std::shared_ptr<Executor> CreateExecutor() const noexcept;
+
+  mutable std::vector<WindowTable> windows_;
+  mutable ExecutorPool<Executor> executors_;
+};
+
+}  // namespace transforms
+}  // namespace sound_feature_extraction
+#endif  // SRC_TRANSFORMS_MULTI_RESOLUTION_SPECTRUM_H_
@@ -41,27 +41,29 @@ size_t PeakAnalysis::OnInputFormatChanged(size_t buffersCount) {
 
 void PeakAnalysis::Do(const formats::FixedArray<2>* in, float *out)
     const noexcept {
-  float sum = in[0][1];
-  for (size_t i = 1; i < input_format_->Size(); i++) {
-    sum += in[i][1];
-  }
-  if (sum == 0) {
-    sum = 1;
-  }
+  size_t size = input_format_->Size();
+  // The sum and the highest peak are found in the same pass, the selects
+  // compile into blends instead of the data dependent branches
+  float sum = 0;
   float max_pos = in[0][0];
   float max_val = in[0][1];
-  for (size_t i = 1; i < input_format_->Size(); i++) {
-    if (in[i][1] > max_val) {
-      max_val = in[i][1];
-      max_pos = in[i][0];
-    }
-  }
-  if (max_pos == 0) {
-    max_pos = 1;
+  for (size_t i = 0; i < size; i++) {
+    float pos = in[i][0], val = in[i][1];
+    sum += val;
+    bool higher = val > max_val;
+    max_pos = higher? pos : max_pos;
+    max_val = higher? val : max_val;
   }
-  for (size_t i = 0; i < input_format_->Size(); i++) {
-    out[i * 2 + 1] = in[i][0] / max_pos;
-    out[i * 2 + 2] = in[i][1] / sum;
+  sum = sum == 0? 1 : sum;
+  max_pos = max_pos == 0? 1 : max_pos;
+  // The pairs are normalized as the flat array of the interleaved positions
+  // and values, which vectorizes
+  static_assert(sizeof(formats::FixedArray<2>) == 2 * sizeof(float),
+                "FixedArray<2> must be packed");
+  auto flat = reinterpret_cast<const float*>(in);
+  const float norms[2] { max_pos, sum };
+  for (size_t i = 0; i < size * 2; i++) {
+    out[i + 1] = flat[i] / norms[i & 1];
   }
   out[0] = max_pos;
 }
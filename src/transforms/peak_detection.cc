@@ -29,9 +29,15 @@
  */
 
 #include "src/transforms/peak_detection.h"
+#include <cassert>
 #include <algorithm>
 #include <simd/wavelet.h>
-#include "src/make_unique.h"
+#ifdef SIMD_X86
+#include <immintrin.h>
+#elif defined(SIMD_NEON)
+#include <arm_neon.h>
+#endif
+#include "src/scratch_arena.h"
 
 namespace sound_feature_extraction {
 
@@ -63,6 +69,159 @@ ExtremumType Parse(const std::string& value, identity<ExtremumType>) {
 
 namespace transforms {
 
+/// @brief Appends the strict extrema at the positions from start to end
+/// (exclusive).
+/// @return The new number of the extrema in results.
+static int ExtremaTail(const float* input, int start, int end,
+                       ExtremumType type, ExtremumPoint* results, int count) {
+  bool maxima = (type & kExtremumTypeMaximum) != 0;
+  bool minima = (type & kExtremumTypeMinimum) != 0;
+  for (int i = start; i < end; i++) {
+    float val = input[i];
+    if ((maxima && val > input[i - 1] && val > input[i + 1]) ||
+        (minima && val < input[i - 1] && val < input[i + 1])) {
+      results[count].position = i;
+      results[count].value = val;
+      count++;
+    }
+  }
+  return count;
+}
+
+/// @brief Appends the extrema which are marked in the mask, the lowest bit
+/// corresponds to start.
+static inline int AppendExtrema(const float* input, int start, uint32_t mask,
+                                ExtremumPoint* results, int count) {
+  while (mask != 0) {
+    int pos = start + __builtin_ctz(mask);
+    results[count].position = pos;
+    results[count].value = input[pos];
+    count++;
+    mask &= mask - 1;
+  }
+  return count;
+}
+
+typedef int (*ExtremaKernel)(const float* input, int length,
+                             ExtremumType type, ExtremumPoint* results);
+
+static int ExtremaScalar(const float* input, int length, ExtremumType type,
+                         ExtremumPoint* results) {
+  return ExtremaTail(input, 1, length - 1, type, results, 0);
+}
+
+#ifdef SIMD_X86
+SIMD_TARGET("avx")
+static int ExtremaAVX(const float* input, int length, ExtremumType type,
+                      ExtremumPoint* results) {
+  bool maxima = (type & kExtremumTypeMaximum) != 0;
+  bool minima = (type & kExtremumTypeMinimum) != 0;
+  int count = 0;
+  int i = 1;
+  for (; i + 8 < length; i += 8) {
+    __m256 prev = _mm256_loadu_ps(input + i - 1);
+    __m256 cur = _mm256_loadu_ps(input + i);
+    __m256 next = _mm256_loadu_ps(input + i + 1);
+    int mask = 0;
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wold-style-cast"
+    if (maxima) {
+      mask |= _mm256_movemask_ps(_mm256_and_ps(
+          _mm256_cmp_ps(cur, prev, _CMP_GT_OQ),
+          _mm256_cmp_ps(cur, next, _CMP_GT_OQ)));
+    }
+    if (minima) {
+      mask |= _mm256_movemask_ps(_mm256_and_ps(
+          _mm256_cmp_ps(cur, prev, _CMP_LT_OQ),
+          _mm256_cmp_ps(cur, next, _CMP_LT_OQ)));
+    }
+#pragma GCC diagnostic pop
+    count = AppendExtrema(input, i, mask, results, count);
+  }
+  return ExtremaTail(input, i, length - 1, type, results, count);
+}
+
+SIMD_TARGET_AVX512
+static int ExtremaAVX512(const float* input, int length, ExtremumType type,
+                         ExtremumPoint* results) {
+  if (length < 3) {
+    return 0;
+  }
+  bool maxima = (type & kExtremumTypeMaximum) != 0;
+  bool minima = (type & kExtremumTypeMinimum) != 0;
+  int count = 0;
+  int i = 1;
+  for (; i + 16 < length; i += 16) {
+    __m512 prev = _mm512_loadu_ps(input + i - 1);
+    __m512 cur = _mm512_loadu_ps(input + i);
+    __m512 next = _mm512_loadu_ps(input + i + 1);
+    __mmask16 mask = 0;
+    if (maxima) {
+      mask |= _mm512_cmp_ps_mask(cur, prev, _CMP_GT_OQ) &
+          _mm512_cmp_ps_mask(cur, next, _CMP_GT_OQ);
+    }
+    if (minima) {
+      mask |= _mm512_cmp_ps_mask(cur, prev, _CMP_LT_OQ) &
+          _mm512_cmp_ps_mask(cur, next, _CMP_LT_OQ);
+    }
+    count = AppendExtrema(input, i, mask, results, count);
+  }
+  // The remaining candidates, the last of them is input[length - 2]
+  __mmask16 tail = (1u << (length - 1 - i)) - 1;
+  __m512 prev = _mm512_maskz_loadu_ps(tail, input + i - 1);
+  __m512 cur = _mm512_maskz_loadu_ps(tail, input + i);
+  __m512 next = _mm512_maskz_loadu_ps(tail, input + i + 1);
+  __mmask16 mask = 0;
+  if (maxima) {
+    mask |= _mm512_mask_cmp_ps_mask(tail, cur, prev, _CMP_GT_OQ) &
+        _mm512_mask_cmp_ps_mask(tail, cur, next, _CMP_GT_OQ);
+  }
+  if (minima) {
+    mask |= _mm512_mask_cmp_ps_mask(tail, cur, prev, _CMP_LT_OQ) &
+        _mm512_mask_cmp_ps_mask(tail, cur, next, _CMP_LT_OQ);
+  }
+  return AppendExtrema(input, i, mask, results, count);
+}
+#elif defined(SIMD_NEON)
+static int ExtremaNEON(const float* input, int length, ExtremumType type,
+                       ExtremumPoint* results) {
+  bool maxima = (type & kExtremumTypeMaximum) != 0;
+  bool minima = (type & kExtremumTypeMinimum) != 0;
+  static const uint32_t kLaneBits[4] = { 1, 2, 4, 8 };
+  const uint32x4_t bits = vld1q_u32(kLaneBits);
+  int count = 0;
+  int i = 1;
+  for (; i + 4 < length; i += 4) {
+    float32x4_t prev = vld1q_f32(input + i - 1);
+    float32x4_t cur = vld1q_f32(input + i);
+    float32x4_t next = vld1q_f32(input + i + 1);
+    uint32x4_t found = vdupq_n_u32(0);
+    if (maxima) {
+      found = vandq_u32(vcgtq_f32(cur, prev), vcgtq_f32(cur, next));
+    }
+    if (minima) {
+      found = vorrq_u32(found, vandq_u32(vcltq_f32(cur, prev),
+                                         vcltq_f32(cur, next)));
+    }
+    found = vandq_u32(found, bits);
+    uint32_t mask = vgetq_lane_u32(found, 0) | vgetq_lane_u32(found, 1) |
+        vgetq_lane_u32(found, 2) | vgetq_lane_u32(found, 3);
+    count = AppendExtrema(input, i, mask, results, count);
+  }
+  return ExtremaTail(input, i, length - 1, type, results, count);
+}
+#endif
+
+static const SimdKernel<ExtremaKernel> kExtremaKernels[] {
+#ifdef SIMD_X86
+  { InstructionSet::kAVX512, ExtremaAVX512 },
+  { InstructionSet::kAVX, ExtremaAVX },
+#elif defined(SIMD_NEON)
+  { InstructionSet::kNEON, ExtremaNEON },
+#endif
+  { InstructionSet::kScalar, ExtremaScalar }
+};
+
 PeakDetection::PeakDetection()
     : sort_(kDefaultSortOrder),
       number_(kDefaultPeaksNumber),
@@ -71,8 +230,7 @@ PeakDetection::PeakDetection()
       max_pos_(kDefaultMaxPos),
       swt_type_(kDefaultSWTType),
       swt_order_(kDefaultWaveletOrder),
-      swt_level_(kDefaultSWTLevel),
-      swt_details_buffer_(nullptr, std::free) {
+      swt_level_(kDefaultSWTLevel) {
 }
 ALWAYS_VALID_TP(PeakDetection, sort)
 
@@ -98,63 +256,56 @@ size_t PeakDetection::OnInputFormatChanged(size_t buffersCount) {
   return buffersCount;
 }
 
-void PeakDetection::Initialize() const {
-  if (swt_level_ != 0) {
-    swt_details_buffer_ = std::uniquify(mallocf(input_format_->Size()),
-                                        std::free);
-    int count = threads_number();
-    swt_buffers_.resize(count);
-    for (int i = 0; i < count; i++) {
-      swt_buffers_[i].data = std::uniquify(mallocf(input_format_->Size()),
-                                           std::free);
-    }
+InstructionSet PeakDetection::SimdInstructionSet() const noexcept {
+  return SimdAware::Dispatch(kExtremaKernels).Isa;
+}
+
+int PeakDetection::FindExtrema(bool simd, const float* input, int length,
+                               ExtremumType type,
+                               ExtremumPoint* results) noexcept {
+  if (!simd) {
+    return ExtremaScalar(input, length, type, results);
   }
+  return SimdAware::Dispatch(kExtremaKernels).Function(
+      input, length, type, results);
 }
 
 void PeakDetection::Do(const float* in,
                        formats::FixedArray<2>* out) const noexcept {
-  ExtremumPoint* results;
-  size_t count;
+  int length = input_format_->Size();
+  auto extrema = ScratchArena::Acquire(
+      (length * sizeof(ExtremumPoint) + sizeof(float) - 1) / sizeof(float));
+  // The SWT details are discarded
+  int swt_length = swt_level_ > 0? length : 0;
+  auto smoothed = ScratchArena::Acquire(swt_length);
+  auto details = ScratchArena::Acquire(swt_length);
+  const float* signal = in;
   if (swt_level_ > 0) {
-    bool executed = false;
-    while (!executed) {
-      for (auto& buf : swt_buffers_) {
-        if (buf.mutex.try_lock()) {
-          // swt_details_buffer_ is shared among all the threads; we just
-          // do not care because it is not really used.
-          stationary_wavelet_apply(swt_type_, swt_order_, 1,
-                                   EXTENSION_TYPE_CONSTANT, in,
-                                   input_format_->Size(),
-                                   swt_details_buffer_.get(),
-                                   buf.data.get());
-          for (int i = 2; i <= swt_level_; i++) {
-            stationary_wavelet_apply(
-                swt_type_, swt_order_, i, EXTENSION_TYPE_CONSTANT,
-                buf.data.get(), input_format_->Size(),
-                swt_details_buffer_.get(), buf.data.get());
-          }
-          detect_peaks(use_simd(), buf.data.get(), input_format_->Size(), type_,
-                       &results, &count);
-          buf.mutex.unlock();
-          executed = true;
-          break;
-        }
-      }
+    stationary_wavelet_apply(swt_type_, swt_order_, 1,
+                             EXTENSION_TYPE_CONSTANT, in, length,
+                             details.get(), smoothed.get());
+    for (int i = 2; i <= swt_level_; i++) {
+      stationary_wavelet_apply(swt_type_, swt_order_, i,
+                               EXTENSION_TYPE_CONSTANT, smoothed.get(), length,
+                               details.get(), smoothed.get());
     }
-  } else {
-    detect_peaks(use_simd(), in, input_format_->Size(), type_, &results,
-                 &count);
+    signal = smoothed.get();
   }
-  if ((sort_ & kSortOrderValue) != 0 && results != nullptr) {
+  auto results = reinterpret_cast<ExtremumPoint*>(extrema.get());
+  int count = FindExtrema(use_simd(), signal, length, type_, results);
+  int rcount = std::min(count, number_);
+  if ((sort_ & kSortOrderValue) != 0) {
+    // Only the leading rcount values are ordered, the heap selection
+    // is linear in count
     auto extr_type = type_;
-    std::sort(results, results + count,
-              [extr_type](const ExtremumPoint& f, const ExtremumPoint& s) {
-                return (extr_type & kExtremumTypeMinimum) != 0?
-                    f.value < s.value : f.value > s.value;
-              });
+    std::partial_sort(
+        results, results + rcount, results + count,
+        [extr_type](const ExtremumPoint& f, const ExtremumPoint& s) {
+          return (extr_type & kExtremumTypeMinimum) != 0?
+              f.value < s.value : f.value > s.value;
+        });
   }
-  int rcount = static_cast<int>(count) > number_? number_ : count;
-  if (sort_ == kSortOrderBoth  && results != nullptr) {
+  if (sort_ == kSortOrderBoth) {
     std::sort(results, results + rcount,
               [](const ExtremumPoint& f, const ExtremumPoint& s) {
                 return f.position < s.position;
@@ -162,7 +313,7 @@ void PeakDetection::Do(const float* in,
   }
   for (int i = 0; i < rcount; i++) {
     float pos = results[i].position;
-    out[i][0] = min_pos_ + pos * (max_pos_ - min_pos_) / input_format_->Size();
+    out[i][0] = min_pos_ + pos * (max_pos_ - min_pos_) / length;
     float val = results[i].value;
     if (swt_type_ == WAVELET_TYPE_DAUBECHIES) {
       for (int i = 0; i < swt_level_; i++) {
@@ -171,11 +322,10 @@ void PeakDetection::Do(const float* in,
     }
     out[i][1] = val;
   }
-  for (int i = count; i < number_; i++) {
+  for (int i = rcount; i < number_; i++) {
     out[i][0] = min_pos_;
     out[i][1] = 0;
   }
-  free(results);
 }
 
 RTP(PeakDetection, sort)
@@ -31,7 +31,6 @@
 #ifndef SRC_TRANSFORMS_PEAK_DETECTION_H_
 #define SRC_TRANSFORMS_PEAK_DETECTION_H_
 
-#include <mutex>
 #include <vector>
 #include <simd/detect_peaks.h>
 #include <simd/wavelet_types.h>
@@ -93,11 +92,18 @@ class PeakDetection : public OmpTransformBase<
      "SWT level, that is, the number of smoothing passes."
      "\"0\" means do not do SWT.")
 
+  virtual InstructionSet SimdInstructionSet() const noexcept override;
+
+  /// @brief Finds the strict extrema of the specified type, in the order of
+  /// their positions.
+  /// @param results The array of at least length elements.
+  /// @return The number of the extrema written to results.
+  static int FindExtrema(bool simd, const float* input, int length,
+                         ExtremumType type, ExtremumPoint* results) noexcept;
+
  protected:
   virtual size_t OnInputFormatChanged(size_t buffersCount) override;
 
-  virtual void Initialize() const override;
-
   virtual void Do(const float* in, formats::FixedArray<2>* out)
       const noexcept override;
 
@@ -110,10 +116,6 @@ class PeakDetection : public OmpTransformBase<
   static constexpr WaveletType kDefaultSWTType = WAVELET_TYPE_DAUBECHIES;
   static constexpr int kDefaultWaveletOrder = 4;
   static constexpr int kDefaultSWTLevel = 0;
-
- private:
-  mutable FloatPtr swt_details_buffer_;
-  mutable std::vector<ThreadSafeFloatPtr> swt_buffers_;
 };
 
 }  // namespace transforms
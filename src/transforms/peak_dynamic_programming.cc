@@ -29,94 +29,141 @@
  */
 
 #include "src/transforms/peak_dynamic_programming.h"
+#include <algorithm>
 #include <cmath>
-#include <vector>
+#include <limits>
 
 namespace sound_feature_extraction {
 namespace transforms {
 
 RTP(PeakDynamicProgramming, mind_values)
+RTP(PeakDynamicProgramming, beam)
 
 PeakDynamicProgramming::PeakDynamicProgramming()
-    : mind_values_(kDefaultMindValues) {
+    : mind_values_(kDefaultMindValues),
+      beam_(kDefaultBeam) {
 }
 
 ALWAYS_VALID_TP(PeakDynamicProgramming, mind_values)
 
+bool PeakDynamicProgramming::validate_beam(const int& value) noexcept {
+  return value >= 0;
+}
+
+size_t PeakDynamicProgramming::OnInputFormatChanged(size_t buffersCount) {
+  costs_.resize(buffersCount * input_format_->Size());
+  backpointers_.resize(buffersCount * input_format_->Size());
+  survivors_.reserve(input_format_->Size());
+  return buffersCount;
+}
+
+float PeakDynamicProgramming::TransitionCost(
+    const formats::FixedArray<2>& from, const formats::FixedArray<2>& to)
+    const noexcept {
+  float cost = to[0] - from[0];
+  cost *= cost;
+  if (mind_values_) {
+    if (to[1] != 0) {
+      cost *= sqrtf(from[1] / to[1]);
+    } else {
+      cost = std::numeric_limits<float>::infinity();
+    }
+  }
+  return cost;
+}
+
 void PeakDynamicProgramming::Do(const BuffersBase<formats::FixedArray<2>*>& in,
                                 BuffersBase<float>* out)
     const noexcept {
-  std::vector<std::vector<std::tuple<float, int>>> costs(in.Count());
-  std::vector<int> candidates_counts(in.Count());
-  for (size_t i = 0; i < in.Count(); i++) {
-    int candidates_count = 0;
-    for (size_t j = 0; in[i][j][0] != 0 && j < input_format_->Size(); j++) {
-      candidates_count++;
+  int size = input_format_->Size();
+  costs_.resize(in.Count() * size);
+  backpointers_.resize(in.Count() * size);
+  auto candidates = [&](size_t i) {
+    int count = 0;
+    while (count < size && in[i][count][0] != 0) {
+      count++;
     }
-    candidates_counts[i] = candidates_count;
-    costs[i].resize(candidates_count);
-    if (i > 0) {
-      for (int j = 0; j < candidates_count; j++) {
-        float min_cost = std::numeric_limits<float>::max();
-        int index = -1;
-        for (int k = 0; k < candidates_counts[i - 1]; k++) {
-          float cost = in[i][j][0] - in[i - 1][k][0];
-          cost *= cost;
-          if (mind_values_) {
-            if (in[i][j][1] != 0) {
-              cost *= sqrtf(in[i - 1][k][1] / in[i][j][1]);
-            } else {
-              cost = std::numeric_limits<float>::infinity();
-            }
-          }
-          cost += std::get<0>(costs[i - 1][k]);
+    return count;
+  };
+  // Forward pass, which continues the previous call's paths in
+  // the streaming mode
+  int prev_count = streaming()? static_cast<int>(stream_last_.size()) : 0;
+  for (size_t i = 0; i < in.Count(); i++) {
+    int count = candidates(i);
+    float* costs = &costs_[i * size];
+    int* backpointers = &backpointers_[i * size];
+    if (prev_count == 0) {
+      // The path starts again after the buffers without peaks
+      for (int j = 0; j < count; j++) {
+        costs[j] = 0;
+        backpointers[j] = -1;
+      }
+    } else {
+      const float* prev_costs = i > 0?
+          &costs_[(i - 1) * size] : stream_costs_.data();
+      const formats::FixedArray<2>* prev = i > 0?
+          in[i - 1] : stream_last_.data();
+      for (int j = 0; j < count; j++) {
+        float min_cost = std::numeric_limits<float>::infinity();
+        int index = survivors_[0];
+        for (int k : survivors_) {
+          float cost = TransitionCost(prev[k], in[i][j]) + prev_costs[k];
           if (cost < min_cost) {
             min_cost = cost;
             index = k;
           }
         }
-        costs[i][j] = std::make_tuple(min_cost, index);
-      }
-    } else {
-      for (int j = 0; j < candidates_count; j++) {
-        costs[0][j] = std::make_tuple(0, j);
+        costs[j] = min_cost;
+        backpointers[j] = index;
       }
     }
+    survivors_.resize(count);
+    for (int j = 0; j < count; j++) {
+      survivors_[j] = j;
+    }
+    if (beam_ > 0 && count > beam_) {
+      std::nth_element(survivors_.begin(), survivors_.begin() + beam_,
+                       survivors_.end(), [costs](int a, int b) {
+        return costs[a] < costs[b];
+      });
+      survivors_.resize(beam_);
+    }
+    prev_count = count;
   }
-  for (int j = 0; j < candidates_counts[0]; j++) {
-    float min_cost = std::numeric_limits<float>::max();
-    int index = -1;
-    for (int k = 0; k < candidates_counts[1]; k++) {
-      float cost = in[0][j][0] - in[1][k][0];
-      cost *= cost;
-      if (mind_values_) {
-        if (in[0][j][1] != 0) {
-          cost *= sqrtf(in[1][k][1] / in[0][j][1]);
-        } else {
-          cost = std::numeric_limits<float>::infinity();
-        }
-      }
-      if (cost < min_cost) {
-        min_cost = cost;
-        index = k;
-      }
+  if (streaming() && in.Count() > 0) {
+    // The costs are kept relative, so that they do not grow without bound
+    size_t last = in.Count() - 1;
+    stream_last_.assign(in[last], in[last] + prev_count);
+    const float* costs = &costs_[last * size];
+    float min_cost = prev_count > 0?
+        *std::min_element(costs, costs + prev_count) : 0;
+    stream_costs_.resize(prev_count);
+    for (int j = 0; j < prev_count; j++) {
+      stream_costs_[j] = costs[j] - min_cost;
     }
-    costs[0][j] = std::make_tuple(min_cost, index);
   }
+  // Backtracking
+  int index = -1;
   for (int i = in.Count() - 1; i >= 0; i--) {
-    float min_cost = std::numeric_limits<float>::max();
-    int index = 0;
-    for (int j = 0; j < candidates_counts[i]; j++) {
-      float cost = std::get<0>(costs[i][j]);
-      if (cost < min_cost) {
-        min_cost = cost;
-        index = j;
+    if (index < 0) {
+      int count = candidates(i);
+      if (count == 0) {
+        (*out)[i] = 0;
+        continue;
       }
+      const float* costs = &costs_[i * size];
+      index = std::min_element(costs, costs + count) - costs;
     }
     (*out)[i] = in[i][index][0];
+    index = backpointers_[i * size + index];
   }
 }
 
+void PeakDynamicProgramming::ResetState() const noexcept {
+  stream_last_.clear();
+  stream_costs_.clear();
+}
+
 REGISTER_TRANSFORM(PeakDynamicProgramming);
 
 }  // namespace transforms
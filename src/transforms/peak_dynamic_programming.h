@@ -31,6 +31,7 @@
 #ifndef SRC_TRANSFORMS_PEAK_DYNAMIC_PROGRAMMING_H_
 #define SRC_TRANSFORMS_PEAK_DYNAMIC_PROGRAMMING_H_
 
+#include <vector>
 #include "src/formats/fixed_array.h"
 #include "src/formats/single_format.h"
 #include "src/transforms/common.h"
@@ -38,6 +39,14 @@
 namespace sound_feature_extraction {
 namespace transforms {
 
+/// @brief Chooses one peak in each buffer so that the path through the
+/// chosen peaks changes as smoothly as possible (Viterbi algorithm).
+/// @details The costs and the backpointers live in the flat arrays of
+/// size buffers × candidates which are allocated once per input format.
+/// With the nonzero beam, only the beam cheapest candidates of each buffer
+/// are considered as the predecessors.
+/// In the streaming mode, the paths continue from the last buffer of
+/// the previous call, whose choices are final.
 class PeakDynamicProgramming : public TransformBase<
     formats::ArrayFormat<formats::FixedArray<2>>, formats::SingleFormatF> {
  public:
@@ -50,13 +59,37 @@ class PeakDynamicProgramming : public TransformBase<
 
   TP(mind_values, bool, kDefaultMindValues,
      "Whether to favor points with higher values.")
+  TP(beam, int, kDefaultBeam,
+     "The maximal number of the cheapest candidates which are continued to "
+     "the next buffer. Zero means all candidates.")
+
+  virtual void ResetState() const noexcept override;
 
  protected:
+  virtual size_t OnInputFormatChanged(size_t buffersCount) override;
+
   virtual void Do(const BuffersBase<formats::FixedArray<2>*>& in,
                   BuffersBase<float>* out)
       const noexcept override;
 
   static constexpr bool kDefaultMindValues = false;
+  static constexpr int kDefaultBeam = 0;
+
+ private:
+  float TransitionCost(const formats::FixedArray<2>& from,
+                       const formats::FixedArray<2>& to) const noexcept;
+
+  /// @brief The accumulated path costs, buffers × candidates.
+  mutable std::vector<float> costs_;
+  /// @brief The previous candidate on the cheapest path, buffers × candidates.
+  mutable std::vector<int> backpointers_;
+  /// @brief The candidates which are continued to the next buffer.
+  mutable std::vector<int> survivors_;
+  /// @brief The candidates of the last buffer of the previous call in
+  /// the streaming mode.
+  mutable std::vector<formats::FixedArray<2>> stream_last_;
+  /// @brief The path costs of stream_last_, relative to the cheapest one.
+  mutable std::vector<float> stream_costs_;
 };
 
 }  // namespace transforms
@@ -0,0 +1,105 @@
+/*! @file power_spectrum.cc
+ *  @brief Fused window function, real FFT and spectral energy calculation.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#include "src/transforms/power_spectrum.h"
+#include <cstring>
+#include <simd/memory.h>
+#include "src/fftf_wisdom.h"
+#include "src/make_unique.h"
+#include "src/transforms/spectral_energy.h"
+
+namespace sound_feature_extraction {
+namespace transforms {
+
+constexpr WindowType PowerSpectrum::kDefaultWindow;
+
+PowerSpectrum::PowerSpectrum() noexcept
+    : window_(kDefaultWindow) {
+}
+
+ALWAYS_VALID_TP(PowerSpectrum, window)
+
+size_t PowerSpectrum::OnFormatChanged(size_t buffersCount) {
+  output_format_->SetSize((input_format_->Size() + 2) / 2);
+  return buffersCount;
+}
+
+void PowerSpectrum::Initialize() const {
+  window_contents_.reset();
+  if (window_ != WindowType::kWindowTypeRectangular) {
+    window_contents_ = SharedWindow(window_, input_format_->Size());
+  }
+  executors_.Reset(threads_number(), [this]() { return CreateExecutor(); });
+}
+
+std::shared_ptr<PowerSpectrum::Executor> PowerSpectrum::CreateExecutor()
+    const noexcept {
+  auto exec = std::make_shared<Executor>();
+  int length = input_format_->Size();
+  exec->Frame = std::uniquify(mallocf(length + 2), std::free);
+  auto backend = FFTFWisdom::Instance().Select(
+      FFTF_TYPE_REAL, FFTF_DIRECTION_FORWARD, length, 1);
+  exec->Plan.reset(fftf_init(
+      FFTF_TYPE_REAL, FFTF_DIRECTION_FORWARD, FFTF_DIMENSION_1D,
+      &length, FFTF_NO_OPTIONS, exec->Frame.get(), exec->Frame.get()));
+  return exec;
+}
+
+void PowerSpectrum::Do(const float* in, float* out) const noexcept {
+  auto exec = executors_.Acquire();
+  int length = input_format_->Size();
+  float* frame = exec->Frame.get();
+  if (window_contents_) {
+    Window::ApplyWindow(use_simd(), window_contents_.get(), length, in, frame);
+  } else {
+    memcpy(frame, in, length * sizeof(float));
+  }
+  fftf_calc(exec->Plan.get());
+  // FFTF has no pruned transforms, only the energies are limited
+  size_t size = output_format_->Size();
+  auto used = used_elements_.Align(size, 8);
+  SpectralEnergy::Do(use_simd(), frame + used.Begin * 2,
+                     (used.End - used.Begin) * 2, out + used.Begin);
+  memset(out, 0, used.Begin * sizeof(float));
+  memset(out + used.End, 0, (size - used.End) * sizeof(float));
+}
+
+size_t PowerSpectrum::PrivateMemorySize() const noexcept {
+  size_t length = input_format_->Size();
+  return (window_contents_? length * sizeof(float) : 0) +
+      threads_number() * (length + 2) * sizeof(float);
+}
+
+RTP(PowerSpectrum, window)
+REGISTER_TRANSFORM(PowerSpectrum);
+
+}  // namespace transforms
+}  // namespace sound_feature_extraction
@@ -0,0 +1,94 @@
+/*! @file power_spectrum.h
+ *  @brief Fused window function, real FFT and spectral energy calculation.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#ifndef SRC_TRANSFORMS_POWER_SPECTRUM_H_
+#define SRC_TRANSFORMS_POWER_SPECTRUM_H_
+
+#include <fftf/api.h>
+#include "src/executor_pool.h"
+#include "src/transforms/window.h"
+
+namespace sound_feature_extraction {
+namespace transforms {
+
+/// @brief Calculates the same as WindowFunction, RDFT and SpectralEnergy
+/// applied in a row, without storing the intermediate buffers.
+/// @details TransformTree substitutes the matching chains with this
+/// transform (see TransformTree::set_fuse_transforms()). Each frame is
+/// windowed into a small per-thread scratch which stays in the cache,
+/// transformed in place and converted to the squared magnitudes right away.
+class PowerSpectrum
+    : public OmpUniformFormatTransform<formats::ArrayFormatF> {
+ public:
+  PowerSpectrum() noexcept;
+
+  TRANSFORM_INTRO("PowerSpectrum",
+                  "Calculates the squared magnitudes of the real FFT of "
+                  "each window (WindowFunction -> RDFT -> SpectralEnergy).",
+                  PowerSpectrum)
+
+  TP(window, WindowType, kDefaultWindow,
+     "Type of the window function applied before the FFT. "
+     "\"rectangular\" means no windowing.")
+
+  virtual void Initialize() const override;
+
+  /// @brief Includes the per-thread frames.
+  virtual size_t PrivateMemorySize() const noexcept override;
+
+ protected:
+  static constexpr WindowType kDefaultWindow =
+      WindowType::kWindowTypeRectangular;
+
+  virtual size_t OnFormatChanged(size_t buffersCount) override;
+
+  virtual void Do(const float* in,
+                  float* out) const noexcept override;
+
+ private:
+  /// @brief The scratch of a single thread with the in-place FFT plan.
+  struct Executor {
+    Executor() : Frame(nullptr, std::free), Plan(nullptr, fftf_destroy) {
+    }
+
+    FloatPtr Frame;
+    std::unique_ptr<FFTFInstance, void (*)(FFTFInstance*)> Plan;
+  };
+
+  std::shared_ptr<Executor> CreateExecutor() const noexcept;
+
+  mutable WindowTable window_contents_;
+  mutable ExecutorPool<Executor> executors_;
+};
+
+}  // namespace transforms
+}  // namespace sound_feature_extraction
+#endif  // SRC_TRANSFORMS_POWER_SPECTRUM_H_
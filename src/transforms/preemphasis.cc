@@ -29,7 +29,14 @@
  */
 
 #include "src/transforms/preemphasis.h"
+#include <algorithm>
 #include <simd/instruction_set.h>
+#ifdef SIMD_X86
+#include <immintrin.h>
+#elif defined(SIMD_NEON)
+#include <arm_neon.h>
+#endif
+#include "src/thread_pool.h"
 
 namespace sound_feature_extraction {
 namespace transforms {
@@ -48,50 +55,216 @@ void Preemphasis::Do(const float* in,
   Do(use_simd(), in, input_format_->Size(), value_, out);
 }
 
+bool Preemphasis::InPlace() const noexcept {
+  return true;
+}
+
 void Preemphasis::Do(bool simd, const float* input, size_t length,
                      float k, float* output)
     noexcept {
+  // Go from the end, so that input may be equal to output: each value
+  // depends only on itself and on the preceding one
   int ilength = length;
-  output[0] = input[0];
+  int i = ilength - 1;
   if (simd) {
 #ifdef __AVX__
     const __m256 veck = _mm256_set1_ps(-k);
-    for (int i = 1; i < ilength - 8; i += 8) {
-      __m256 vecpre = _mm256_load_ps(input + i - 1);
-      __m256 vec = _mm256_loadu_ps(input + i);
+    for (; i >= 8; i -= 8) {
+      __m256 vecpre = _mm256_loadu_ps(input + i - 8);
+      __m256 vec = _mm256_loadu_ps(input + i - 7);
       vecpre = _mm256_mul_ps(vecpre, veck);
       vec = _mm256_add_ps(vec, vecpre);
-      _mm256_storeu_ps(output + i, vec);
+      _mm256_storeu_ps(output + i - 7, vec);
     }
-    for (int i = ((ilength - 1) & ~7); i < ilength; i++) {
-      output[i] = input[i] - k * input[i - 1];
-    }
-    return;
-  } else {
 #elif defined(__ARM_NEON__)
     const float32x4_t veck = vdupq_n_f32(-k);
-    for (int i = 1; i < ilength - 4; i += 4) {
-      float32x4_t vecpre = vld1q_f32(input + i - 1);
-      float32x4_t vec = vld1q_f32(input + i);
+    for (; i >= 4; i -= 4) {
+      float32x4_t vecpre = vld1q_f32(input + i - 4);
+      float32x4_t vec = vld1q_f32(input + i - 3);
       vec = vmlaq_f32(vec, vecpre, veck);
-      vst1q_f32(output + i, vec);
-    }
-    for (int i = ((ilength - 1) & ~3); i < ilength; i++) {
-      output[i] = input[i] - k * input[i - 1];
+      vst1q_f32(output + i - 3, vec);
     }
-    return;
+#endif
+  }
+  for (; i > 0; i--) {
+    output[i] = input[i] - k * input[i - 1];
+  }
+  output[0] = input[0];
+}
+
+typedef void (*Preemphasis16Kernel)(const int16_t* in, size_t begin,
+                                    size_t end, float k, float* out);
+
+/// @brief Returns the i-th sample, mixed the same way as MixStereo does.
+template <bool Mix>
+static inline float Sample16(const int16_t* in, size_t i) {
+  if (!Mix) {
+    return in[i];
+  }
+  int16_t l = in[i * 2] / 2;
+  int16_t r = in[i * 2 + 1] / 2;
+  return static_cast<int16_t>(l + r);
+}
+
+/// @brief Filters the samples [begin, end), begin must be positive.
+template <bool Mix>
+static void Preemphasis16Scalar(const int16_t* in, size_t begin, size_t end,
+                                float k, float* out) {
+  for (size_t i = begin; i < end; i++) {
+    out[i] = Sample16<Mix>(in, i) - k * Sample16<Mix>(in, i - 1);
+  }
+}
+
+#ifdef SIMD_X86
+/// @brief Divides each element by 2 rounding towards zero, the same as
+/// the scalar division does.
+SIMD_TARGET("avx2")
+static inline __m128i halve_epi16(__m128i vec) {
+  return _mm_srai_epi16(_mm_add_epi16(vec, _mm_srli_epi16(vec, 15)), 1);
+}
+
+/// @brief Loads the samples [i, i + 8) as floats.
+template <bool Mix>
+SIMD_TARGET("avx2")
+static inline __m256 LoadSamples16AVX2(const int16_t* in, size_t i) {
+  __m128i vec;
+  if (Mix) {
+    auto src = reinterpret_cast<const __m128i*>(in + i * 2);
+    vec = _mm_hadd_epi16(halve_epi16(_mm_loadu_si128(src)),
+                         halve_epi16(_mm_loadu_si128(src + 1)));
   } else {
-#else
-  } {
+    vec = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+  }
+  return _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(vec));
+}
+
+template <bool Mix>
+SIMD_TARGET("avx2")
+static void Preemphasis16AVX2(const int16_t* in, size_t begin, size_t end,
+                              float k, float* out) {
+  const __m256 veck = _mm256_set1_ps(-k);
+  size_t i = begin;
+  for (; i + 8 <= end; i += 8) {
+    // The preceding samples are loaded again instead of shifting the lanes
+    __m256 vec = LoadSamples16AVX2<Mix>(in, i);
+    __m256 vecpre = LoadSamples16AVX2<Mix>(in, i - 1);
+    _mm256_storeu_ps(out + i,
+                     _mm256_add_ps(vec, _mm256_mul_ps(vecpre, veck)));
+  }
+  Preemphasis16Scalar<Mix>(in, i, end, k, out);
+}
+#elif defined(SIMD_NEON)
+static inline int16x4_t halve_s16(int16x4_t vec) {
+  uint16x4_t sign = vshr_n_u16(vreinterpret_u16_s16(vec), 15);
+  return vshr_n_s16(vadd_s16(vec, vreinterpret_s16_u16(sign)), 1);
+}
+
+/// @brief Loads the samples [i, i + 4) as floats.
+template <bool Mix>
+static inline float32x4_t LoadSamples16NEON(const int16_t* in, size_t i) {
+  int16x4_t vec;
+  if (Mix) {
+    int16x4x2_t channels = vld2_s16(in + i * 2);
+    vec = vadd_s16(halve_s16(channels.val[0]), halve_s16(channels.val[1]));
+  } else {
+    vec = vld1_s16(in + i);
+  }
+  return vcvtq_f32_s32(vmovl_s16(vec));
+}
+
+template <bool Mix>
+static void Preemphasis16NEON(const int16_t* in, size_t begin, size_t end,
+                              float k, float* out) {
+  const float32x4_t veck = vdupq_n_f32(-k);
+  size_t i = begin;
+  for (; i + 4 <= end; i += 4) {
+    float32x4_t vec = LoadSamples16NEON<Mix>(in, i);
+    float32x4_t vecpre = LoadSamples16NEON<Mix>(in, i - 1);
+    vst1q_f32(out + i, vmlaq_f32(vec, vecpre, veck));
+  }
+  Preemphasis16Scalar<Mix>(in, i, end, k, out);
+}
 #endif
-    for (int i = 1; i < ilength; i++) {
-      output[i] = input[i] - k * input[i - 1];
-    }
+
+static const SimdKernel<Preemphasis16Kernel> kPreemphasis16Kernels[] {
+#ifdef SIMD_X86
+  { InstructionSet::kAVX2, Preemphasis16AVX2<false> },
+#elif defined(SIMD_NEON)
+  { InstructionSet::kNEON, Preemphasis16NEON<false> },
+#endif
+  { InstructionSet::kScalar, Preemphasis16Scalar<false> }
+};
+
+static const SimdKernel<Preemphasis16Kernel> kMixPreemphasis16Kernels[] {
+#ifdef SIMD_X86
+  { InstructionSet::kAVX2, Preemphasis16AVX2<true> },
+#elif defined(SIMD_NEON)
+  { InstructionSet::kNEON, Preemphasis16NEON<true> },
+#endif
+  { InstructionSet::kScalar, Preemphasis16Scalar<true> }
+};
+
+constexpr size_t Preemphasis16F::kChunkSize;
+constexpr float Preemphasis16F::kDefaultValue;
+
+Preemphasis16F::Preemphasis16F(const std::shared_ptr<Transform>& preemphasis,
+                               bool mix)
+    : value_(kDefaultValue), mix_(mix) {
+  // Through the setter, so that the value can be read back and updated
+  // after the fusion
+  set_value(std::dynamic_pointer_cast<Preemphasis>(preemphasis)->value());
+}
+
+bool Preemphasis16F::validate_value(const float& value) noexcept {
+  return value > 0 && value <= 1;
+}
+
+bool Preemphasis16F::mix() const noexcept {
+  return mix_;
+}
+
+size_t Preemphasis16F::OnInputFormatChanged(size_t buffersCount) {
+  output_format_->SetSize(input_format_->Size() / (mix_? 2 : 1));
+  return buffersCount;
+}
+
+void Preemphasis16F::Do(const BuffersBase<int16_t*>& in,
+                        BuffersBase<float*>* out) const noexcept {
+  size_t length = output_format_->Size();
+  size_t chunks = (length + kChunkSize - 1) / kChunkSize;
+  Preemphasis16Kernel kernel;
+  if (use_simd()) {
+    kernel = mix_? SimdAware::Dispatch(kMixPreemphasis16Kernels).Function
+                 : SimdAware::Dispatch(kPreemphasis16Kernels).Function;
+  } else {
+    kernel = mix_? Preemphasis16Scalar<true> : Preemphasis16Scalar<false>;
   }
+  ThreadPool::Instance().ParallelFor(
+      in.Count() * chunks, 1,
+      serial()? 1 : get_omp_transforms_max_threads_num(),
+      [&](size_t begin, size_t end) {
+    for (size_t task = begin; task < end; task++) {
+      size_t i = task / chunks;
+      size_t first = task % chunks * kChunkSize;
+      size_t last = std::min(first + kChunkSize, length);
+      if (first == 0) {
+        (*out)[i][0] = mix_? Sample16<true>(in[i], 0)
+                           : Sample16<false>(in[i], 0);
+        first = 1;
+      }
+      kernel(in[i], first, last, value_, (*out)[i]);
+    }
+  });
+}
+
+InstructionSet Preemphasis16F::SimdInstructionSet() const noexcept {
+  return mix_? SimdAware::Dispatch(kMixPreemphasis16Kernels).Isa
+             : SimdAware::Dispatch(kPreemphasis16Kernels).Isa;
 }
 
 RTP(Preemphasis, value)
 REGISTER_TRANSFORM(Preemphasis);
+RTP(Preemphasis16F, value)
 
 }  // namespace transforms
 }  // namespace sound_feature_extraction
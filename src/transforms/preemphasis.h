@@ -31,6 +31,8 @@
 #ifndef SRC_TRANSFORMS_PREEMPHASIS_H_
 #define SRC_TRANSFORMS_PREEMPHASIS_H_
 
+#include <memory>
+#include "src/parallel_transform.h"
 #include "src/transforms/common.h"
 
 namespace sound_feature_extraction {
@@ -48,6 +50,8 @@ class Preemphasis : public OmpUniformFormatTransform<formats::ArrayFormatF> {
      "The filter coefficient from range (0..1]. "
      "The higher, the more emphasis occurs.")
 
+  virtual bool InPlace() const noexcept override;
+
  protected:
   static constexpr float kDefaultValue = 0.9f;
 
@@ -57,6 +61,48 @@ class Preemphasis : public OmpUniformFormatTransform<formats::ArrayFormatF> {
                  float k, float* output) noexcept;
 };
 
+/// @brief [MixStereo ->] Int16ToFloatRaw -> Preemphasis, which mixes,
+/// converts and filters the samples in a single pass.
+/// @details TransformTree creates this transform instead of such chains of
+/// nodes, it is not registered in the factory. Each filtered sample depends
+/// only on two input samples, so the buffers are split into the chunks of
+/// kChunkSize which run in parallel.
+class Preemphasis16F
+    : public TransformBase<formats::ArrayFormat16, formats::ArrayFormatF>,
+      public ParallelTransform {
+ public:
+  /// @param preemphasis The Preemphasis to apply.
+  /// @param mix Mix the interleaved stereo channels the same way as
+  /// MixStereo does before the conversion.
+  Preemphasis16F(const std::shared_ptr<Transform>& preemphasis, bool mix);
+
+  TRANSFORM_INTRO("Preemphasis", "Filter the 16-bit signal with a first-order "
+                                 "high-pass filter y[n] = x[n] - k * "
+                                 "x[n - 1].",
+                  Preemphasis16F)
+
+  TP(value, float, kDefaultValue,
+     "The filter coefficient from range (0..1]. "
+     "The higher, the more emphasis occurs.")
+
+  bool mix() const noexcept;
+
+  virtual InstructionSet SimdInstructionSet() const noexcept override;
+
+ protected:
+  virtual size_t OnInputFormatChanged(size_t buffersCount) override;
+
+  virtual void Do(const BuffersBase<int16_t*>& in,
+                  BuffersBase<float*>* out) const noexcept override;
+
+  /// @brief The number of output samples processed by a thread at once.
+  static constexpr size_t kChunkSize = 1 << 16;
+  static constexpr float kDefaultValue = 0.9f;
+
+ private:
+  bool mix_;
+};
+
 }  // namespace transforms
 }  // namespace sound_feature_extraction
 #endif  // SRC_TRANSFORMS_PREEMPHASIS_H_
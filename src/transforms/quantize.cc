@@ -0,0 +1,199 @@
+/*! @file quantize.cc
+ *  @brief Scaled float to int8 quantization.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#include "src/transforms/quantize.h"
+#include <simd/arithmetic-inl.h>
+#ifdef SIMD_X86
+#include <immintrin.h>
+#elif defined(SIMD_NEON)
+#include <arm_neon.h>
+#endif
+#include <cmath>
+
+namespace sound_feature_extraction {
+namespace transforms {
+
+typedef void (*QuantizeKernel)(const float* in, int length, float scale,
+                               int8_t* out);
+
+/// @brief Clamps before the rounding, the same as the SIMD versions do
+/// with max(value, -128) and min(value, 127): NaNs become -128.
+static void QuantizeScalar(const float* in, int length, float scale,
+                           int8_t* out) {
+  for (int i = 0; i < length; i++) {
+    float value = in[i] * scale;
+    if (!(value >= -128.f)) {
+      value = -128.f;
+    }
+    if (value > 127.f) {
+      value = 127.f;
+    }
+    out[i] = lrintf(value);
+  }
+}
+
+#ifdef SIMD_X86
+SIMD_TARGET("sse4.1")
+static __m128i QuantizeVectorSSE41(__m128 vec, __m128 scale) {
+  vec = _mm_max_ps(_mm_mul_ps(vec, scale), _mm_set1_ps(-128.f));
+  return _mm_cvtps_epi32(_mm_min_ps(vec, _mm_set1_ps(127.f)));
+}
+
+SIMD_TARGET("sse4.1")
+static void QuantizeSSE41(const float* in, int length, float scale,
+                          int8_t* out) {
+  const __m128 vscale = _mm_set1_ps(scale);
+  int i = 0;
+  for (; i < length - 15; i += 16) {
+    __m128i lo = _mm_packs_epi32(
+        QuantizeVectorSSE41(_mm_loadu_ps(in + i), vscale),
+        QuantizeVectorSSE41(_mm_loadu_ps(in + i + 4), vscale));
+    __m128i hi = _mm_packs_epi32(
+        QuantizeVectorSSE41(_mm_loadu_ps(in + i + 8), vscale),
+        QuantizeVectorSSE41(_mm_loadu_ps(in + i + 12), vscale));
+    __m128i res = _mm_packs_epi16(lo, hi);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), res);
+  }
+  QuantizeScalar(in + i, length - i, scale, out + i);
+}
+
+SIMD_TARGET("avx2")
+static __m256i QuantizeVectorAVX2(__m256 vec, __m256 scale) {
+  vec = _mm256_max_ps(_mm256_mul_ps(vec, scale), _mm256_set1_ps(-128.f));
+  return _mm256_cvtps_epi32(_mm256_min_ps(vec, _mm256_set1_ps(127.f)));
+}
+
+SIMD_TARGET("avx2")
+static void QuantizeAVX2(const float* in, int length, float scale,
+                         int8_t* out) {
+  const __m256 vscale = _mm256_set1_ps(scale);
+  // packs works within 128-bit lanes, restore the order of the doublewords
+  const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+  int i = 0;
+  for (; i < length - 31; i += 32) {
+    __m256i lo = _mm256_packs_epi32(
+        QuantizeVectorAVX2(_mm256_loadu_ps(in + i), vscale),
+        QuantizeVectorAVX2(_mm256_loadu_ps(in + i + 8), vscale));
+    __m256i hi = _mm256_packs_epi32(
+        QuantizeVectorAVX2(_mm256_loadu_ps(in + i + 16), vscale),
+        QuantizeVectorAVX2(_mm256_loadu_ps(in + i + 24), vscale));
+    __m256i res = _mm256_packs_epi16(lo, hi);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),
+                        _mm256_permutevar8x32_epi32(res, order));
+  }
+  QuantizeScalar(in + i, length - i, scale, out + i);
+}
+
+SIMD_TARGET_AVX512
+static __m128i QuantizeVectorAVX512(__m512 vec, __m512 scale) {
+  vec = _mm512_max_ps(_mm512_mul_ps(vec, scale), _mm512_set1_ps(-128.f));
+  vec = _mm512_min_ps(vec, _mm512_set1_ps(127.f));
+  return _mm512_cvtepi32_epi8(_mm512_cvtps_epi32(vec));
+}
+
+SIMD_TARGET_AVX512
+static void QuantizeAVX512(const float* in, int length, float scale,
+                           int8_t* out) {
+  const __m512 vscale = _mm512_set1_ps(scale);
+  int i = 0;
+  for (; i < length - 15; i += 16) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                     QuantizeVectorAVX512(_mm512_loadu_ps(in + i), vscale));
+  }
+  __mmask16 tail = (1u << (length - i)) - 1;
+  _mm_mask_storeu_epi8(
+      out + i, tail,
+      QuantizeVectorAVX512(_mm512_maskz_loadu_ps(tail, in + i), vscale));
+}
+#elif defined(SIMD_NEON) && defined(__aarch64__)
+static void QuantizeNEON(const float* in, int length, float scale,
+                         int8_t* out) {
+  const float32x4_t vscale = vdupq_n_f32(scale);
+  const float32x4_t low = vdupq_n_f32(-128.f);
+  const float32x4_t high = vdupq_n_f32(127.f);
+  int i = 0;
+  for (; i < length - 7; i += 8) {
+    // vmaxnmq_f32() returns the number if the other operand is NaN
+    float32x4_t lo = vminnmq_f32(vmaxnmq_f32(
+        vmulq_f32(vld1q_f32(in + i), vscale), low), high);
+    float32x4_t hi = vminnmq_f32(vmaxnmq_f32(
+        vmulq_f32(vld1q_f32(in + i + 4), vscale), low), high);
+    int16x8_t res = vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(lo)),
+                                 vqmovn_s32(vcvtnq_s32_f32(hi)));
+    vst1_s8(out + i, vqmovn_s16(res));
+  }
+  QuantizeScalar(in + i, length - i, scale, out + i);
+}
+#endif
+
+static const SimdKernel<QuantizeKernel> kQuantizeKernels[] {
+#ifdef SIMD_X86
+  { InstructionSet::kAVX512, QuantizeAVX512 },
+  { InstructionSet::kAVX2, QuantizeAVX2 },
+  { InstructionSet::kSSE41, QuantizeSSE41 },
+#elif defined(SIMD_NEON) && defined(__aarch64__)
+  { InstructionSet::kNEON, QuantizeNEON },
+#endif
+  { InstructionSet::kScalar, QuantizeScalar }
+};
+
+constexpr float Quantize::kDefaultScale;
+
+Quantize::Quantize() : scale_(kDefaultScale) {
+}
+
+bool Quantize::validate_scale(const float& value) noexcept {
+  return std::isfinite(value) && value != 0;
+}
+
+size_t Quantize::OnInputFormatChanged(size_t buffersCount) {
+  output_format_->SetSize(input_format_->Size());
+  return buffersCount;
+}
+
+void Quantize::Do(const float* in, int8_t* out) const noexcept {
+  DoNarrowing(in, input_format_->Size(), out);
+}
+
+void Quantize::DoNarrowing(const float* in, int length,
+                           int8_t* out) const noexcept {
+  SimdAware::Dispatch(kQuantizeKernels).Function(in, length, scale_, out);
+}
+
+InstructionSet Quantize::SimdInstructionSet() const noexcept {
+  return SimdAware::Dispatch(kQuantizeKernels).Isa;
+}
+
+RTP(Quantize, scale)
+REGISTER_TRANSFORM(Quantize);
+
+}  // namespace transforms
+}  // namespace sound_feature_extraction
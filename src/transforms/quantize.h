@@ -0,0 +1,70 @@
+/*! @file quantize.h
+ *  @brief Scaled float to int8 quantization.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#ifndef SRC_TRANSFORMS_QUANTIZE_H_
+#define SRC_TRANSFORMS_QUANTIZE_H_
+
+#include "src/elementwise_transform.h"
+#include "src/formats/reduced_precision.h"
+#include "src/transforms/common.h"
+
+namespace sound_feature_extraction {
+namespace transforms {
+
+class Quantize : public OmpTransformBase<formats::ArrayFormatF,
+                                         formats::ArrayFormat8>,
+                 public NarrowingTransform<int8_t> {
+ public:
+  Quantize();
+
+  TRANSFORM_INTRO("Int8", "Multiplies each value by the scale and rounds it "
+                          "to the nearest (even) int8, saturating.",
+                  Quantize)
+
+  TP(scale, float, kDefaultScale,
+     "The number to multiply each value by before the rounding.")
+
+  virtual InstructionSet SimdInstructionSet() const noexcept override;
+
+  virtual void DoNarrowing(const float* in, int length,
+                           int8_t* out) const noexcept override;
+
+ protected:
+  static constexpr float kDefaultScale = 1.f;
+
+  virtual size_t OnInputFormatChanged(size_t buffersCount) override;
+
+  virtual void Do(const float* in, int8_t* out) const noexcept override;
+};
+
+}  // namespace transforms
+}  // namespace sound_feature_extraction
+#endif  // SRC_TRANSFORMS_QUANTIZE_H_
@@ -12,6 +12,14 @@
  */
 
 #include "src/transforms/rasta.h"
+#include <algorithm>
+#include <simd/memory.h>
+#include "src/scratch_arena.h"
+#ifdef SIMD_X86
+#include <immintrin.h>
+#elif defined(SIMD_NEON)
+#include <arm_neon.h>
+#endif
 
 namespace sound_feature_extraction {
 namespace transforms {
@@ -41,8 +49,202 @@ void RASTA::Execute(const std::shared_ptr<IIRFilter>& exec,
       >(ptr), in, out);
 }
 
+BandRASTA::BandRASTA() noexcept : pole_(RASTA::kDefaultPole) {
+}
+
+constexpr int BandRASTA::kBandLanes;
+
+bool BandRASTA::validate_pole(const float& value) noexcept {
+  return value < 1 && value > 0;
+}
+
+int BandRASTA::StateSize() const noexcept {
+  return std::max(static_cast<int>(sections_.size()), 1) * 4 * kBandLanes;
+}
+
+void BandRASTA::Initialize() const {
+  RASTA rasta;
+  rasta.set_pole(pole_);
+  sections_ = rasta.Sections();
+  int state = StateSize();
+  int chunks = (input_format_->Size() + kBandLanes - 1) / kBandLanes;
+  stream_states_.assign(chunks * state, 0.f);
+}
+
+void BandRASTA::ResetState() const noexcept {
+  std::fill(stream_states_.begin(), stream_states_.end(), 0.f);
+}
+
+size_t BandRASTA::PrivateMemorySize() const noexcept {
+  return stream_states_.size() * sizeof(float);
+}
+
+/// @brief Filters the bands [first, first + width) of all the frames.
+/// @details The state of section s is x[n-1], x[n-2], y[n-1], y[n-2] at
+/// [(s * 4 + k) * kBandLanes + b]. The SIMD kernels require all the
+/// kBandLanes bands.
+typedef void (*BandsKernel)(const BiquadCoefficients* sections, int count,
+                            float* state, const BuffersBase<float*>& in,
+                            BuffersBase<float*>* out, int first, int width);
+
+static void FilterBandsScalar(const BiquadCoefficients* sections, int count,
+                              float* state, const BuffersBase<float*>& in,
+                              BuffersBase<float*>* out, int first,
+                              int width) {
+  const int lanes = 16;
+  for (size_t n = 0; n < in.Count(); n++) {
+    for (int b = 0; b < width; b++) {
+      float x = in[n][first + b];
+      for (int s = 0; s < count; s++) {
+        const auto& c = sections[s];
+        float* st = state + s * 4 * lanes + b;
+        float y = c.b0 * x + c.b1 * st[0] + c.b2 * st[lanes] -
+            c.a1 * st[2 * lanes] - c.a2 * st[3 * lanes];
+        st[lanes] = st[0];
+        st[0] = x;
+        st[3 * lanes] = st[2 * lanes];
+        st[2 * lanes] = y;
+        x = y;
+      }
+      (*out)[n][first + b] = x;
+    }
+  }
+}
+
+#ifdef SIMD_X86
+SIMD_TARGET("avx")
+static void FilterBandsAVX(const BiquadCoefficients* sections, int count,
+                           float* state, const BuffersBase<float*>& in,
+                           BuffersBase<float*>* out, int first, int) {
+  const int lanes = 16;
+  for (size_t n = 0; n < in.Count(); n++) {
+    for (int v = 0; v < lanes; v += 8) {
+      __m256 x = _mm256_loadu_ps(in[n] + first + v);
+      for (int s = 0; s < count; s++) {
+        const auto& c = sections[s];
+        float* st = state + s * 4 * lanes + v;
+        __m256 x1 = _mm256_loadu_ps(st);
+        __m256 y1 = _mm256_loadu_ps(st + 2 * lanes);
+        __m256 y = _mm256_mul_ps(_mm256_set1_ps(c.b0), x);
+        y = _mm256_add_ps(y, _mm256_mul_ps(_mm256_set1_ps(c.b1), x1));
+        y = _mm256_add_ps(y, _mm256_mul_ps(_mm256_set1_ps(c.b2),
+                                           _mm256_loadu_ps(st + lanes)));
+        y = _mm256_sub_ps(y, _mm256_mul_ps(_mm256_set1_ps(c.a1), y1));
+        y = _mm256_sub_ps(y, _mm256_mul_ps(_mm256_set1_ps(c.a2),
+                                           _mm256_loadu_ps(st + 3 * lanes)));
+        _mm256_storeu_ps(st + lanes, x1);
+        _mm256_storeu_ps(st, x);
+        _mm256_storeu_ps(st + 3 * lanes, y1);
+        _mm256_storeu_ps(st + 2 * lanes, y);
+        x = y;
+      }
+      _mm256_storeu_ps((*out)[n] + first + v, x);
+    }
+  }
+}
+
+SIMD_TARGET_AVX512
+static void FilterBandsAVX512(const BiquadCoefficients* sections, int count,
+                              float* state, const BuffersBase<float*>& in,
+                              BuffersBase<float*>* out, int first, int) {
+  const int lanes = 16;
+  for (size_t n = 0; n < in.Count(); n++) {
+    __m512 x = _mm512_loadu_ps(in[n] + first);
+    for (int s = 0; s < count; s++) {
+      const auto& c = sections[s];
+      float* st = state + s * 4 * lanes;
+      __m512 x1 = _mm512_loadu_ps(st);
+      __m512 y1 = _mm512_loadu_ps(st + 2 * lanes);
+      __m512 y = _mm512_mul_ps(_mm512_set1_ps(c.b0), x);
+      y = _mm512_fmadd_ps(_mm512_set1_ps(c.b1), x1, y);
+      y = _mm512_fmadd_ps(_mm512_set1_ps(c.b2),
+                          _mm512_loadu_ps(st + lanes), y);
+      y = _mm512_fnmadd_ps(_mm512_set1_ps(c.a1), y1, y);
+      y = _mm512_fnmadd_ps(_mm512_set1_ps(c.a2),
+                           _mm512_loadu_ps(st + 3 * lanes), y);
+      _mm512_storeu_ps(st + lanes, x1);
+      _mm512_storeu_ps(st, x);
+      _mm512_storeu_ps(st + 3 * lanes, y1);
+      _mm512_storeu_ps(st + 2 * lanes, y);
+      x = y;
+    }
+    _mm512_storeu_ps((*out)[n] + first, x);
+  }
+}
+#elif defined(SIMD_NEON)
+static void FilterBandsNEON(const BiquadCoefficients* sections, int count,
+                            float* state, const BuffersBase<float*>& in,
+                            BuffersBase<float*>* out, int first, int) {
+  const int lanes = 16;
+  for (size_t n = 0; n < in.Count(); n++) {
+    for (int v = 0; v < lanes; v += 4) {
+      float32x4_t x = vld1q_f32(in[n] + first + v);
+      for (int s = 0; s < count; s++) {
+        const auto& c = sections[s];
+        float* st = state + s * 4 * lanes + v;
+        float32x4_t x1 = vld1q_f32(st);
+        float32x4_t y1 = vld1q_f32(st + 2 * lanes);
+        float32x4_t y = vmulq_n_f32(x, c.b0);
+        y = vmlaq_n_f32(y, x1, c.b1);
+        y = vmlaq_n_f32(y, vld1q_f32(st + lanes), c.b2);
+        y = vmlsq_n_f32(y, y1, c.a1);
+        y = vmlsq_n_f32(y, vld1q_f32(st + 3 * lanes), c.a2);
+        vst1q_f32(st + lanes, x1);
+        vst1q_f32(st, x);
+        vst1q_f32(st + 3 * lanes, y1);
+        vst1q_f32(st + 2 * lanes, y);
+        x = y;
+      }
+      vst1q_f32((*out)[n] + first + v, x);
+    }
+  }
+}
+#endif
+
+static const SimdKernel<BandsKernel> kBandsKernels[] {
+#ifdef SIMD_X86
+  { InstructionSet::kAVX512, FilterBandsAVX512 },
+  { InstructionSet::kAVX, FilterBandsAVX },
+#elif defined(SIMD_NEON)
+  { InstructionSet::kNEON, FilterBandsNEON },
+#endif
+  { InstructionSet::kScalar, FilterBandsScalar }
+};
+
+InstructionSet BandRASTA::SimdInstructionSet() const noexcept {
+  return SimdAware::Dispatch(kBandsKernels).Isa;
+}
+
+void BandRASTA::Do(const BuffersBase<float*>& in,
+                   BuffersBase<float*>* out) const noexcept {
+  int size = input_format_->Size();
+  int chunks = (size + kBandLanes - 1) / kBandLanes;
+  int state_size = StateSize();
+  auto kernel = use_simd()? SimdAware::Dispatch(kBandsKernels).Function :
+      FilterBandsScalar;
+  ParallelFor(chunks, [&](int begin, int end) {
+    for (int c = begin; c < end; c++) {
+      int width = std::min(kBandLanes, size - c * kBandLanes);
+      auto filter = width == kBandLanes? kernel : FilterBandsScalar;
+      if (streaming()) {
+        filter(sections_.data(), sections_.size(),
+               &stream_states_[c * state_size], in, out, c * kBandLanes,
+               width);
+        continue;
+      }
+      auto state = ScratchArena::Acquire(state_size);
+      memsetf(state.get(), 0.f, state_size);
+      filter(sections_.data(), sections_.size(), state.get(), in, out,
+             c * kBandLanes, width);
+    }
+  });
+}
+
 RTP(RASTA, pole)
 REGISTER_TRANSFORM(RASTA);
 
+RTP(BandRASTA, pole)
+REGISTER_TRANSFORM(BandRASTA);
+
 }  // namespace transforms
 }  // namespace sound_feature_extraction
@@ -18,6 +18,7 @@
 #ifndef SRC_TRANSFORMS_RASTA_H_
 #define SRC_TRANSFORMS_RASTA_H_
 
+#include <vector>
 #include "src/transforms/iir_filter_base.h"
 
 namespace sound_feature_extraction {
@@ -40,6 +41,49 @@ class RASTA : public IIRFilterBase, public TransformLogger<RASTA> {
                        float* out) const override;
 };
 
+/// @brief Applies RASTA filter to each band along time: every buffer is
+/// a frame of the band values, e.g., the critical band energies in PLP.
+/// @details The frames are band-major already, so the recurrence runs over
+/// the buffers with kBandLanes adjacent bands in the lanes of one register.
+/// The second order sections are the ones of RASTA with the same pole.
+/// In the streaming mode, the filter state carries over to the next call.
+class BandRASTA
+    : public UniformFormatOmpAwareTransform<formats::ArrayFormatF> {
+ public:
+  BandRASTA() noexcept;
+
+  TRANSFORM_INTRO("BandRASTA", "Perform RASTA filtering of each band along "
+                               "the frames.",
+                  BandRASTA)
+
+  TP(pole, float, RASTA::kDefaultPole,
+     "Pole value. It normally lies within (1, 0.9].")
+
+  virtual void Initialize() const override;
+
+  virtual void ResetState() const noexcept override;
+
+  virtual InstructionSet SimdInstructionSet() const noexcept override;
+
+  /// @brief Includes the streaming filter states.
+  virtual size_t PrivateMemorySize() const noexcept override;
+
+ protected:
+  /// @brief The number of bands filtered together.
+  static constexpr int kBandLanes = 16;
+
+  virtual void Do(const BuffersBase<float*>& in,
+                  BuffersBase<float*>* out) const noexcept override;
+
+ private:
+  /// @brief The size of the state of kBandLanes bands, in float-s.
+  int StateSize() const noexcept;
+
+  mutable std::vector<BiquadCoefficients> sections_;
+  /// @brief The filter states of all the bands in the streaming mode.
+  mutable std::vector<float> stream_states_;
+};
+
 }  // namespace transforms
 }  // namespace sound_feature_extraction
 #endif  // SRC_TRANSFORMS_RASTA_H_
@@ -31,6 +31,7 @@
 #ifndef SRC_TRANSFORMS_RDFT_H_
 #define SRC_TRANSFORMS_RDFT_H_
 
+#include "src/fftf_plan_cache.h"
 #include "src/formats/array_format.h"
 #include "src/transform_base.h"
 
@@ -39,6 +40,8 @@ namespace transforms {
 
 class RDFT : public UniformFormatTransform<formats::ArrayFormatF> {
  public:
+  RDFT() noexcept;
+
   TRANSFORM_INTRO("RDFT", "Performs Discrete Fourier Transform "
                           "on the input signal (using real FFT).",
                   RDFT)
@@ -47,16 +50,26 @@ class RDFT : public UniformFormatTransform<formats::ArrayFormatF> {
     return true;
   }
 
+  virtual Overlap RequiredOverlap(const Overlap& output)
+      const noexcept override {
+    return output;
+  }
+
  protected:
   virtual size_t OnFormatChanged(size_t buffersCount) override;
 
   virtual void Do(const BuffersBase<float*>& in,
                   BuffersBase<float*>* out) const noexcept override;
+
+ private:
+  mutable FFTFPlanCache plans_;
 };
 
 class RDFTInverse
     : public InverseUniformFormatTransform<RDFT> {
  public:
+  RDFTInverse() noexcept;
+
   virtual bool BufferInvariant() const noexcept override final {
     return true;
   }
@@ -66,6 +79,9 @@ class RDFTInverse
 
   virtual void Do(const BuffersBase<float*>& in,
                   BuffersBase<float*>* out) const noexcept override;
+
+ private:
+  mutable FFTFPlanCache plans_;
 };
 
 }  // namespace transforms
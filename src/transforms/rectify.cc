@@ -31,6 +31,11 @@
 #include "src/transforms/rectify.h"
 #include <cmath>
 #include <simd/instruction_set.h>
+#ifdef SIMD_X86
+#include <immintrin.h>
+#elif defined(SIMD_NEON)
+#include <arm_neon.h>
+#endif
 
 namespace sound_feature_extraction {
 namespace transforms {
@@ -39,44 +44,80 @@ void Rectify::Do(const float* in, float* out) const noexcept {
   Do(use_simd(), in, input_format_->Size(), out);
 }
 
+void Rectify::DoElementwise(const float* in, int length,
+                            float* out) const noexcept {
+  Do(use_simd(), in, length, out);
+}
+
+typedef void (*RectifyKernel)(const float* input, int length, float* output);
+
+static void RectifyScalar(const float* input, int length, float* output) {
+  for (int i = 0; i < length; i++) {
+    output[i] = fabsf(input[i]);
+  }
+}
+
+#ifdef SIMD_X86
+SIMD_TARGET("avx")
+static void RectifyAVX(const float* input, int length, float* output) {
+  const __m256 SIGNMASK = _mm256_set1_ps(-0.f);
+  int i = 0;
+  // Unroll 1 time
+  for (; i < length - 15; i += 16) {
+    __m256 vec1 = _mm256_loadu_ps(input + i);
+    __m256 vec2 = _mm256_loadu_ps(input + i + 8);
+    _mm256_storeu_ps(output + i, _mm256_andnot_ps(SIGNMASK, vec1));
+    _mm256_storeu_ps(output + i + 8, _mm256_andnot_ps(SIGNMASK, vec2));
+  }
+  RectifyScalar(input + i, length - i, output + i);
+}
+
+SIMD_TARGET_AVX512
+static void RectifyAVX512(const float* input, int length, float* output) {
+  int i = 0;
+  for (; i < length - 15; i += 16) {
+    _mm512_storeu_ps(output + i, _mm512_abs_ps(_mm512_loadu_ps(input + i)));
+  }
+  __mmask16 tail = (1u << (length - i)) - 1;
+  _mm512_mask_storeu_ps(output + i, tail, _mm512_abs_ps(
+      _mm512_maskz_loadu_ps(tail, input + i)));
+}
+#elif defined(SIMD_NEON)
+static void RectifyNEON(const float* input, int length, float* output) {
+  int i = 0;
+  for (; i < length - 7; i += 8) {
+    vst1q_f32(output + i, vabsq_f32(vld1q_f32(input + i)));
+    vst1q_f32(output + i + 4, vabsq_f32(vld1q_f32(input + i + 4)));
+  }
+  RectifyScalar(input + i, length - i, output + i);
+}
+#endif
+
+static const SimdKernel<RectifyKernel> kRectifyKernels[] {
+#ifdef SIMD_X86
+  { InstructionSet::kAVX512, RectifyAVX512 },
+  { InstructionSet::kAVX, RectifyAVX },
+#elif defined(SIMD_NEON)
+  { InstructionSet::kNEON, RectifyNEON },
+#endif
+  { InstructionSet::kScalar, RectifyScalar }
+};
+
 void Rectify::Do(bool simd, const float* input, int length,
                      float* output) noexcept {
-  if (simd) {
-#ifdef __AVX__
-    const __m256 SIGNMASK =  _mm256_set1_ps(-0.f);
-    // Unroll 1 time
-    for (int i = 0; i < length - 15; i += 16) {
-      __m256 vec1 = _mm256_load_ps(input + i);
-      __m256 vec2 = _mm256_load_ps(input + i + 8);
-      __m256 vecabs1 = _mm256_andnot_ps(SIGNMASK, vec1);
-      __m256 vecabs2 = _mm256_andnot_ps(SIGNMASK, vec2);
-      _mm256_store_ps(output + i, vecabs1);
-      _mm256_store_ps(output + i + 8, vecabs2);
-    }
-    for (int i = (length & ~0xF); i < length; i++) {
-      output[i] = fabsf(input[i]);
-    }
-  } else {
-#elif defined(__ARM_NEON__)
-    for (int i = 0; i < length - 7; i += 8) {
-      float32x4_t vec1 = vld1q_f32(input + i);
-      float32x4_t vec2 = vld1q_f32(input + i + 4);
-      float32x4_t res1 = vabsq_f32(vec1);
-      float32x4_t res2 = vabsq_f32(vec2);
-      vst1q_f32(output + i, res1);
-      vst1q_f32(output + i + 4, res2);
-    }
-    for (int i = (length & ~0x7); i < length; i++) {
-      output[i] = fabsf(input[i]);
-    }
-  } else {
-#else
-  } {
-#endif
-    for (int i = 0; i < length; i++) {
-      output[i] = abs(input[i]);
-    }
+  if (!simd) {
+    RectifyScalar(input, length, output);
+    return;
   }
+  SimdAware::Dispatch(kRectifyKernels).Function(input, length, output);
+}
+
+InstructionSet Rectify::SimdInstructionSet() const noexcept {
+  return SimdAware::Dispatch(kRectifyKernels).Isa;
+}
+
+bool Rectify::InPlace() const noexcept {
+  return true;
 }
 
 REGISTER_TRANSFORM(Rectify);
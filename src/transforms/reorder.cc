@@ -29,6 +29,9 @@
  */
 
 #include "src/transforms/reorder.h"
+#ifdef SIMD_X86
+#include <immintrin.h>
+#endif
 
 namespace sound_feature_extraction {
 namespace transforms {
@@ -61,23 +64,80 @@ size_t Reorder::OnFormatChanged(size_t buffersCount) {
   return buffersCount;
 }
 
-void Reorder::Do(const float* in, float* out) const noexcept {
+void Reorder::Initialize() const {
+  indices_.resize(output_format_->Size());
   switch (algorithm_) {
     case ReorderAlgorithm::kChroma:
-      DoChroma(in, out);
+      ChromaIndices(indices_.size() / 12, indices_.data());
       break;
   }
 }
 
-void Reorder::DoChroma(const float* in, float* out) const noexcept {
-  int step = output_format_->Size() / 12;
-  for (int i = 0; i < step; i++) {
-    for (int j = 0; j < 12; j++) {
-      out[j * step + i] = in[i * 12];
+const std::vector<int>& Reorder::indices() const noexcept {
+  return indices_;
+}
+
+void Reorder::ChromaIndices(int step, int* indices) noexcept {
+  for (int j = 0; j < 12; j++) {
+    for (int i = 0; i < step; i++) {
+      indices[j * step + i] = i * 12 + j;
     }
   }
 }
 
+typedef void (*GatherKernel)(const int* indices, int size, const float* in,
+                             float* out);
+
+static void GatherScalar(const int* indices, int size, const float* in,
+                         float* out) {
+  for (int i = 0; i < size; i++) {
+    out[i] = in[indices[i]];
+  }
+}
+
+#ifdef SIMD_X86
+SIMD_TARGET("avx2")
+static void GatherAVX2(const int* indices, int size, const float* in,
+                       float* out) {
+  int i = 0;
+  for (; i < size - 7; i += 8) {
+    __m256i index = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(indices + i));
+    _mm256_storeu_ps(out + i, _mm256_i32gather_ps(in, index, 4));
+  }
+  GatherScalar(indices + i, size - i, in, out + i);
+}
+
+SIMD_TARGET_AVX512
+static void GatherAVX512(const int* indices, int size, const float* in,
+                         float* out) {
+  int i = 0;
+  for (; i < size - 15; i += 16) {
+    __m512i index = _mm512_loadu_si512(indices + i);
+    _mm512_storeu_ps(out + i, _mm512_i32gather_ps(index, in, 4));
+  }
+  GatherScalar(indices + i, size - i, in, out + i);
+}
+#endif
+
+static const SimdKernel<GatherKernel> kGatherKernels[] {
+#ifdef SIMD_X86
+  { InstructionSet::kAVX512, GatherAVX512 },
+  { InstructionSet::kAVX2, GatherAVX2 },
+#endif
+  { InstructionSet::kScalar, GatherScalar }
+};
+
+InstructionSet Reorder::SimdInstructionSet() const noexcept {
+  return SimdAware::Dispatch(kGatherKernels).Isa;
+}
+
+void Reorder::Do(const float* in, float* out) const noexcept {
+  auto gather = use_simd()? SimdAware::Dispatch(kGatherKernels).Function :
+      GatherScalar;
+  gather(indices_.data(), indices_.size(), in, out);
+}
+
 RTP(Reorder, algorithm)
 REGISTER_TRANSFORM(Reorder);
 
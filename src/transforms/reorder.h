@@ -31,6 +31,7 @@
 #ifndef SRC_TRANSFORMS_REORDER_H_
 #define SRC_TRANSFORMS_REORDER_H_
 
+#include <vector>
 #include "src/transforms/common.h"
 
 namespace sound_feature_extraction {
@@ -76,16 +77,28 @@ class Reorder : public OmpUniformFormatTransform<formats::ArrayFormatF> {
   TP(algorithm, ReorderAlgorithm, kDefaultAlgorithm,
      "The way to reorder the values.")
 
+  /// @brief Builds the gather table of the algorithm for the current format.
+  virtual void Initialize() const override;
+
+  virtual InstructionSet SimdInstructionSet() const noexcept override;
+
+  /// @brief out[i] = in[indices()[i]].
+  const std::vector<int>& indices() const noexcept;
 
  protected:
   virtual size_t OnFormatChanged(size_t buffersCount) override final;
 
   virtual void Do(const float* in, float* out) const noexcept override;
 
-  void DoChroma(const float* in, float* out) const noexcept;
+  /// @brief Fills the table which transposes step rows of 12 chroma values
+  /// into 12 rows of step values.
+  static void ChromaIndices(int step, int* indices) noexcept;
 
   static constexpr ReorderAlgorithm kDefaultAlgorithm =
       ReorderAlgorithm::kChroma;
+
+ private:
+  mutable std::vector<int> indices_;
 };
 
 }  // namespace transforms
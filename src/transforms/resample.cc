@@ -0,0 +1,233 @@
+/*! @file resample.cc
+ *  @brief Polyphase rational resampling.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#include "src/transforms/resample.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#ifdef SIMD_X86
+#include <immintrin.h>
+#elif defined(SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace sound_feature_extraction {
+namespace transforms {
+
+Resample::Resample() noexcept
+    : up_(kDefaultUp), down_(kDefaultDown), window_(kDefaultWindowType),
+      phase_length_(0) {
+}
+
+ALWAYS_VALID_TP(Resample, window)
+
+bool Resample::validate_up(const int& value) noexcept {
+  return value >= 1;
+}
+
+bool Resample::validate_down(const int& value) noexcept {
+  return value >= 1;
+}
+
+static int GreatestCommonDivisor(int a, int b) noexcept {
+  while (b != 0) {
+    int r = a % b;
+    a = b;
+    b = r;
+  }
+  return a;
+}
+
+int Resample::reduced_up() const noexcept {
+  return up_ / GreatestCommonDivisor(up_, down_);
+}
+
+int Resample::reduced_down() const noexcept {
+  return down_ / GreatestCommonDivisor(up_, down_);
+}
+
+int Resample::phase_length() const noexcept {
+  return phase_length_;
+}
+
+size_t Resample::OnFormatChanged(size_t buffersCount) {
+  int64_t up = reduced_up(), down = reduced_down();
+  output_format_->SetSize((input_format_->Size() * up + down - 1) / down);
+  output_format_->SetSamplingRate(
+      static_cast<int64_t>(input_format_->SamplingRate()) * up / down);
+  return buffersCount;
+}
+
+void Resample::Initialize() const {
+  int up = reduced_up(), down = reduced_down();
+  if (streaming() && (input_format_->Size() * up) % down != 0) {
+    // Otherwise the phase of the first output would change between buffers
+    throw InvalidParameterValueException(
+        "down", std::to_string(down_), HostName());
+  }
+  // The windowed sinc lowpass at the upsampled rate with the cutoff at the
+  // lowest Nyquist frequency
+  std::vector<double> filter(length());
+  double cutoff = 0.5 / std::max(up, down);
+  double center = (length() - 1) / 2.;
+  double sum = 0;
+  for (int i = 0; i < length(); i++) {
+    double x = 2 * cutoff * (i - center);
+    double sinc = x == 0? 1 : sin(M_PI * x) / (M_PI * x);
+    filter[i] = sinc * WindowElement(window_, length(), i);
+    sum += filter[i];
+  }
+  // Every phase sums to 1 on average, so the DC gain is preserved
+  double norm = up / sum;
+  phase_length_ = (length() + up - 1) / up;
+  phases_.assign(up * phase_length_, 0.f);
+  for (int i = 0; i < length(); i++) {
+    int phase = i % up, k = i / up;
+    phases_[phase * phase_length_ + phase_length_ - 1 - k] = filter[i] * norm;
+  }
+  FilterBase<ResampleExecutor>::Initialize();
+}
+
+std::shared_ptr<ResampleExecutor> Resample::CreateExecutor() const noexcept {
+  auto exec = std::make_shared<ResampleExecutor>();
+  exec->History.assign(phase_length_ - 1 + input_format_->Size(), 0.f);
+  return exec;
+}
+
+typedef float (*DotKernel)(const float* x, const float* y, int length);
+
+static float DotScalar(const float* x, const float* y, int length) {
+  float sum = 0;
+  for (int i = 0; i < length; i++) {
+    sum += x[i] * y[i];
+  }
+  return sum;
+}
+
+#ifdef SIMD_X86
+SIMD_TARGET("avx")
+static float DotAVX(const float* x, const float* y, int length) {
+  int vectorized = length & ~7;
+  __m256 acc = _mm256_setzero_ps();
+  for (int i = 0; i < vectorized; i += 8) {
+    acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(x + i),
+                                           _mm256_loadu_ps(y + i)));
+  }
+  __m128 half = _mm_add_ps(_mm256_castps256_ps128(acc),
+                           _mm256_extractf128_ps(acc, 1));
+  half = _mm_hadd_ps(half, half);
+  half = _mm_hadd_ps(half, half);
+  float sum = _mm_cvtss_f32(half);
+  for (int i = vectorized; i < length; i++) {
+    sum += x[i] * y[i];
+  }
+  return sum;
+}
+
+SIMD_TARGET_AVX512
+static float DotAVX512(const float* x, const float* y, int length) {
+  int vectorized = length & ~15;
+  __m512 acc = _mm512_setzero_ps();
+  for (int i = 0; i < vectorized; i += 16) {
+    acc = _mm512_fmadd_ps(_mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i),
+                          acc);
+  }
+  float sum = _mm512_reduce_add_ps(acc);
+  for (int i = vectorized; i < length; i++) {
+    sum += x[i] * y[i];
+  }
+  return sum;
+}
+#elif defined(SIMD_NEON)
+static float DotNEON(const float* x, const float* y, int length) {
+  int vectorized = length & ~3;
+  float32x4_t acc = vdupq_n_f32(0);
+  for (int i = 0; i < vectorized; i += 4) {
+    acc = vmlaq_f32(acc, vld1q_f32(x + i), vld1q_f32(y + i));
+  }
+  float32x2_t half = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+  float sum = vget_lane_f32(vpadd_f32(half, half), 0);
+  for (int i = vectorized; i < length; i++) {
+    sum += x[i] * y[i];
+  }
+  return sum;
+}
+#endif
+
+static const SimdKernel<DotKernel> kDotKernels[] {
+#ifdef SIMD_X86
+  { InstructionSet::kAVX512, DotAVX512 },
+  { InstructionSet::kAVX, DotAVX },
+#elif defined(SIMD_NEON)
+  { InstructionSet::kNEON, DotNEON },
+#endif
+  { InstructionSet::kScalar, DotScalar }
+};
+
+InstructionSet Resample::SimdInstructionSet() const noexcept {
+  return SimdAware::Dispatch(kDotKernels).Isa;
+}
+
+void Resample::Execute(const std::shared_ptr<ResampleExecutor>& exec,
+                       const float* in, float* out) const {
+  int size = input_format_->Size();
+  int taps = phase_length_;
+  int64_t up = reduced_up(), down = reduced_down();
+  float* history = exec->History.data();
+  if (!streaming()) {
+    memset(history, 0, (taps - 1) * sizeof(float));
+  }
+  memcpy(history + taps - 1, in, size * sizeof(float));
+  auto dot = use_simd()? SimdAware::Dispatch(kDotKernels).Function
+                       : DotScalar;
+  const float* phases = phases_.data();
+  for (int m = 0; m < static_cast<int>(output_format_->Size()); m++) {
+    // The position in the upsampled signal
+    int64_t t = m * down;
+    int phase = t % up;
+    out[m] = dot(phases + phase * taps, history + t / up, taps);
+  }
+  if (streaming()) {
+    memmove(history, history + size, (taps - 1) * sizeof(float));
+  }
+}
+
+size_t Resample::PrivateMemorySize() const noexcept {
+  return phases_.size() * sizeof(float);
+}
+
+RTP(Resample, up)
+RTP(Resample, down)
+RTP(Resample, window)
+REGISTER_TRANSFORM(Resample);
+
+}  // namespace transforms
+}  // namespace sound_feature_extraction
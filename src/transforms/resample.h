@@ -0,0 +1,104 @@
+/*! @file resample.h
+ *  @brief Polyphase rational resampling.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#ifndef SRC_TRANSFORMS_RESAMPLE_H_
+#define SRC_TRANSFORMS_RESAMPLE_H_
+
+#include <vector>
+#include "src/primitives/window.h"
+#include "src/transforms/filter_base.h"
+
+namespace sound_feature_extraction {
+namespace transforms {
+
+/// @brief The per-channel state of Resample::Execute().
+struct ResampleExecutor {
+  /// @brief The last taps - 1 input samples followed by the current buffer.
+  std::vector<float> History;
+};
+
+/// @brief Changes the sampling rate by a rational factor up / down.
+/// @details The signal is conceptually upsampled by inserting up - 1 zeros
+/// after each sample, lowpass filtered with a windowed sinc of "length"
+/// taps and decimated by down. Only the filter taps which multiply the
+/// nonzero samples are evaluated: they form up phases of ceil(length / up)
+/// taps each, which are stored reversed and contiguous for the SIMD dot
+/// products. The filter is causal, so the output lags by
+/// (length - 1) / 2 upsampled samples. In the streaming mode the history
+/// of each channel persists between the buffers.
+class Resample : public FilterBase<ResampleExecutor> {
+ public:
+  Resample() noexcept;
+
+  TRANSFORM_INTRO("Resample", "Resample the signal by a rational factor "
+                              "up / down with a polyphase lowpass filter.",
+                  Resample)
+
+  TP(up, int, kDefaultUp, "The upsampling factor (the ratio numerator).")
+  TP(down, int, kDefaultDown,
+     "The downsampling factor (the ratio denominator).")
+  TP(window, WindowType, kDefaultWindowType,
+     "The window applied to the sinc filter, e.g. \"hamming\".")
+
+  virtual void Initialize() const override;
+
+  virtual InstructionSet SimdInstructionSet() const noexcept override;
+
+  virtual size_t PrivateMemorySize() const noexcept override;
+
+  /// @brief The number of taps in each polyphase branch.
+  int phase_length() const noexcept;
+
+ protected:
+  virtual size_t OnFormatChanged(size_t buffersCount) override;
+  virtual std::shared_ptr<ResampleExecutor> CreateExecutor()
+      const noexcept override;
+  virtual void Execute(const std::shared_ptr<ResampleExecutor>& exec,
+                       const float* in, float* out) const override;
+
+  static constexpr int kDefaultUp = 1;
+  static constexpr int kDefaultDown = 2;
+  static constexpr WindowType kDefaultWindowType =
+      WindowType::kWindowTypeHamming;
+
+ private:
+  /// @brief up and down divided by their greatest common divisor.
+  int reduced_up() const noexcept;
+  int reduced_down() const noexcept;
+
+  /// @brief The reversed phases, phase_length_ taps each.
+  mutable std::vector<float> phases_;
+  mutable int phase_length_;
+};
+
+}  // namespace transforms
+}  // namespace sound_feature_extraction
+#endif  // SRC_TRANSFORMS_RESAMPLE_H_
@@ -29,11 +29,37 @@
  */
 
 #include "src/transforms/rotate.h"
+#include <algorithm>
+#include "src/primitives/transpose.h"
 
 namespace sound_feature_extraction {
 namespace transforms {
 
-using RotateF = Rotate<float>;
+/// @brief The number of the columns of the input which a thread transposes
+/// at least, 64 bytes.
+static constexpr size_t kStripSize = 16;
+
+template <>
+void Rotate<float>::Do(const BuffersBase<float*>& in,
+                       BuffersBase<float*>* out) const noexcept {
+  size_t size = input_format_->Size();
+  size_t count = in.Count();
+  // Buffers keep a constant stride, which may exceed the size
+  size_t inStride = count > 1? in[1] - in[0] : size;
+  size_t outStride = size > 1? (*out)[1] - (*out)[0] : count;
+  size_t strips = (size + kStripSize - 1) / kStripSize;
+  ParallelFor(strips, [&](size_t begin, size_t end) {
+    size_t first = begin * kStripSize;
+    size_t last = std::min(end * kStripSize, size);
+    Transpose(use_simd(), in[0] + first, count, last - first, inStride,
+              (*out)[first], outStride);
+  });
+}
+
+template <>
+InstructionSet Rotate<float>::SimdInstructionSet() const noexcept {
+  return TransposeInstructionSet();
+}
 
 REGISTER_TRANSFORM(RotateF);
 
@@ -47,6 +47,10 @@ class Rotate : public UniformFormatOmpAwareTransform<formats::ArrayFormat<T>> {
     return false;
   }
 
+  virtual InstructionSet SimdInstructionSet() const noexcept override {
+    return InstructionSet::kScalar;
+  }
+
  protected:
   virtual size_t OnFormatChanged(size_t buffersCount) override final {
     this->output_format_->SetSize(buffersCount);
@@ -55,17 +59,28 @@ class Rotate : public UniformFormatOmpAwareTransform<formats::ArrayFormat<T>> {
 
   virtual void Do(const BuffersBase<T*>& in,
                   BuffersBase<T*>* out) const noexcept override {
-#ifdef HAVE_OPENMP
-    #pragma omp parallel for num_threads(this->threads_number())
-#endif
-    for (size_t i = 0; i < this->input_format_->Size(); i++) {
-      for (size_t j = 0; j < in.Count(); j++) {
-        (*out)[i][j] = in[j][i];
+    size_t size = this->input_format_->Size();
+    this->ParallelFor(size, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        for (size_t j = 0; j < in.Count(); j++) {
+          (*out)[i][j] = in[j][i];
+        }
       }
-    }
+    });
   }
 };
 
+/// @brief Transposes the buffers with Transpose() by the strips of columns,
+/// so that the threads do not share the cache lines they read.
+template <>
+void Rotate<float>::Do(const BuffersBase<float*>& in,
+                       BuffersBase<float*>* out) const noexcept;
+
+template <>
+InstructionSet Rotate<float>::SimdInstructionSet() const noexcept;
+
+using RotateF = Rotate<float>;
+
 }  // namespace transforms
 }  // namespace sound_feature_extraction
 #endif  // SRC_TRANSFORMS_ROTATE_H_
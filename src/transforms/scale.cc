@@ -0,0 +1,148 @@
+/*! @file scale.cc
+ *  @brief Linear transformation of each value.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+#include "src/transforms/scale.h"
+#include <simd/arithmetic-inl.h>
+#ifdef SIMD_X86
+#include <immintrin.h>
+#elif defined(SIMD_NEON)
+#include <arm_neon.h>
+#endif
+#include <cmath>
+
+namespace sound_feature_extraction {
+namespace transforms {
+
+typedef void (*ScaleKernel)(const float* in, int length, float scale,
+                            float offset, float* out);
+
+/// @brief Multiplies and adds separately, the same as the SIMD kernels and
+/// the widening converters do.
+static void ScaleScalar(const float* in, int length, float scale,
+                        float offset, float* out) {
+  for (int i = 0; i < length; i++) {
+    float value = in[i] * scale;
+    out[i] = value + offset;
+  }
+}
+
+#ifdef SIMD_X86
+SIMD_TARGET("avx")
+static void ScaleAVX(const float* in, int length, float scale, float offset,
+                     float* out) {
+  const __m256 mul = _mm256_set1_ps(scale);
+  const __m256 add = _mm256_set1_ps(offset);
+  int i = 0;
+  for (; i < length - 7; i += 8) {
+    __m256 vec = _mm256_loadu_ps(in + i);
+    _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_mul_ps(vec, mul), add));
+  }
+  ScaleScalar(in + i, length - i, scale, offset, out + i);
+}
+
+SIMD_TARGET_AVX512
+static void ScaleAVX512(const float* in, int length, float scale,
+                        float offset, float* out) {
+  const __m512 mul = _mm512_set1_ps(scale);
+  const __m512 add = _mm512_set1_ps(offset);
+  int i = 0;
+  for (; i < length - 15; i += 16) {
+    __m512 vec = _mm512_loadu_ps(in + i);
+    _mm512_storeu_ps(out + i, _mm512_add_ps(_mm512_mul_ps(vec, mul), add));
+  }
+  __mmask16 tail = (1u << (length - i)) - 1;
+  __m512 vec = _mm512_maskz_loadu_ps(tail, in + i);
+  _mm512_mask_storeu_ps(out + i, tail,
+                        _mm512_add_ps(_mm512_mul_ps(vec, mul), add));
+}
+#elif defined(SIMD_NEON)
+static void ScaleNEON(const float* in, int length, float scale, float offset,
+                      float* out) {
+  const float32x4_t mul = vdupq_n_f32(scale);
+  const float32x4_t add = vdupq_n_f32(offset);
+  int i = 0;
+  for (; i < length - 7; i += 8) {
+    float32x4_t lo = vld1q_f32(in + i);
+    float32x4_t hi = vld1q_f32(in + i + 4);
+    vst1q_f32(out + i, vaddq_f32(vmulq_f32(lo, mul), add));
+    vst1q_f32(out + i + 4, vaddq_f32(vmulq_f32(hi, mul), add));
+  }
+  ScaleScalar(in + i, length - i, scale, offset, out + i);
+}
+#endif
+
+static const SimdKernel<ScaleKernel> kScaleKernels[] {
+#ifdef SIMD_X86
+  { InstructionSet::kAVX512, ScaleAVX512 },
+  { InstructionSet::kAVX, ScaleAVX },
+#elif defined(SIMD_NEON)
+  { InstructionSet::kNEON, ScaleNEON },
+#endif
+  { InstructionSet::kScalar, ScaleScalar }
+};
+
+constexpr float Scale::kDefaultScale;
+constexpr float Scale::kDefaultOffset;
+
+Scale::Scale() : scale_(kDefaultScale), offset_(kDefaultOffset) {
+}
+
+bool Scale::validate_scale(const float& value) noexcept {
+  return std::isfinite(value);
+}
+
+bool Scale::validate_offset(const float& value) noexcept {
+  return std::isfinite(value);
+}
+
+void Scale::Do(const float* in, float* out) const noexcept {
+  DoElementwise(in, input_format_->Size(), out);
+}
+
+void Scale::DoElementwise(const float* in, int length,
+                          float* out) const noexcept {
+  SimdAware::Dispatch(kScaleKernels).Function(in, length, scale_, offset_,
+                                              out);
+}
+
+InstructionSet Scale::SimdInstructionSet() const noexcept {
+  return SimdAware::Dispatch(kScaleKernels).Isa;
+}
+
+bool Scale::InPlace() const noexcept {
+  return true;
+}
+
+RTP(Scale, scale)
+RTP(Scale, offset)
+REGISTER_TRANSFORM(Scale);
+
+}  // namespace transforms
+}  // namespace sound_feature_extraction
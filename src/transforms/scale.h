@@ -0,0 +1,75 @@
+/*! @file scale.h
+ *  @brief Linear transformation of each value.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+#ifndef SRC_TRANSFORMS_SCALE_H_
+#define SRC_TRANSFORMS_SCALE_H_
+
+#include "src/elementwise_transform.h"
+#include "src/transforms/common.h"
+
+namespace sound_feature_extraction {
+namespace transforms {
+
+/// @brief Calculates value * scale + offset, e.g. Scale(scale=0.000030517578)
+/// normalizes int16 samples to [-1, 1).
+/// @details When the node follows a WideningTransform converter, TransformTree
+/// fuses both into ElementwiseWideningChain which applies the scale and the
+/// offset during the conversion.
+class Scale : public OmpUniformFormatTransform<formats::ArrayFormatF>,
+              public ElementwiseTransform {
+ public:
+  Scale();
+
+  TRANSFORM_INTRO("Scale", "Multiplies each value by the scale and adds "
+                           "the offset.",
+                  Scale)
+
+  TP(scale, float, kDefaultScale,
+     "The number to multiply each value by.")
+  TP(offset, float, kDefaultOffset,
+     "The number to add to each scaled value.")
+
+  virtual InstructionSet SimdInstructionSet() const noexcept override;
+
+  virtual bool InPlace() const noexcept override;
+
+  virtual void DoElementwise(const float* in, int length,
+                             float* out) const noexcept override;
+
+ protected:
+  static constexpr float kDefaultScale = 1.f;
+  static constexpr float kDefaultOffset = 0.f;
+
+  virtual void Do(const float* in, float* out) const noexcept override;
+};
+
+}  // namespace transforms
+}  // namespace sound_feature_extraction
+#endif  // SRC_TRANSFORMS_SCALE_H_
@@ -49,7 +49,11 @@ constexpr Anchor Selector::kDefaultAnchor;
 Selector::Selector()
     : length_(kDefaultLength),
       select_(kDefaultSelect),
-      from_(kDefaultAnchor) {
+      from_(kDefaultAnchor),
+      offset_(kDefaultOffset),
+      input_offset_(0),
+      output_offset_(0),
+      zero_offset_(0) {
 }
 
 bool Selector::validate_length(const int& value) noexcept {
@@ -60,6 +64,10 @@ bool Selector::validate_select(const int& value) noexcept {
   return value >= 0;
 }
 
+bool Selector::validate_offset(const int& value) noexcept {
+  return value >= 0;
+}
+
 ALWAYS_VALID_TP(Selector, from)
 
 size_t Selector::OnFormatChanged(size_t buffersCount) {
@@ -74,26 +82,42 @@ size_t Selector::OnFormatChanged(size_t buffersCount) {
     throw InvalidParameterValueException("select", std::to_string(select_),
                                          HostName());
   }
+  if (offset_ + select_ > static_cast<int>(input_format_->Size())) {
+    throw InvalidParameterValueException("offset", std::to_string(offset_),
+                                         HostName());
+  }
   return buffersCount;
 }
 
-void Selector::Do(const float* in, float* out) const noexcept {
+bool Selector::IsView() const noexcept {
+  return from_ == Anchor::kLeft && offset_ == 0 && select_ == length_ &&
+      output_format_->SizeInBytes() == input_format_->SizeInBytes();
+}
+
+void Selector::Initialize() const {
   switch (from_) {
     case Anchor::kLeft:
-      memcpy(out, in, select_ * sizeof(in[0]));
-      memsetf(out + select_, 0.f, length_ - select_);
+      input_offset_ = offset_;
+      output_offset_ = 0;
+      zero_offset_ = select_;
       break;
     case Anchor::kRight:
-      memcpy(out + length_ - select_, in + input_format_->Size() - select_,
-             select_ * sizeof(in[0]));
-      memsetf(out, 0.f, length_ - select_);
+      input_offset_ = input_format_->Size() - select_ - offset_;
+      output_offset_ = length_ - select_;
+      zero_offset_ = 0;
       break;
   }
 }
 
+void Selector::Do(const float* in, float* out) const noexcept {
+  memcpy(out + output_offset_, in + input_offset_, select_ * sizeof(in[0]));
+  memsetf(out + zero_offset_, 0.f, length_ - select_);
+}
+
 RTP(Selector, from)
 RTP(Selector, length)
 RTP(Selector, select)
+RTP(Selector, offset)
 REGISTER_TRANSFORM(Selector);
 
 }  // namespace transforms
@@ -32,6 +32,7 @@
 #define SRC_TRANSFORMS_SELECTOR_H_
 
 #include "src/transforms/common.h"
+#include "src/view_transform.h"
 
 namespace sound_feature_extraction {
 namespace transforms {
@@ -64,7 +65,8 @@ namespace std {
 namespace sound_feature_extraction {
 namespace transforms {
 
-class Selector : public OmpUniformFormatTransform<formats::ArrayFormatF> {
+class Selector : public OmpUniformFormatTransform<formats::ArrayFormatF>,
+                 public ViewTransform {
  public:
   Selector();
 
@@ -78,6 +80,16 @@ class Selector : public OmpUniformFormatTransform<formats::ArrayFormatF> {
      "0 means the length of the output.")
   TP(from, Anchor, kDefaultAnchor,
      "The anchor of the selection. Can be either \"left\" or \"right\".")
+  TP(offset, int, kDefaultOffset,
+     "The number of the skipped input values between the anchor and "
+     "the selection, e.g. to pick a part of MultiResolutionSpectrum.")
+
+  /// @brief The leading part of each input buffer is the output if nothing
+  /// is zeroed and the stride is the same.
+  virtual bool IsView() const noexcept override;
+
+  /// @brief Calculates the copied and the zeroed ranges once.
+  virtual void Initialize() const override;
 
  protected:
   virtual size_t OnFormatChanged(size_t buffersCount) override;
@@ -87,6 +99,12 @@ class Selector : public OmpUniformFormatTransform<formats::ArrayFormatF> {
   static constexpr int kDefaultLength = 0;
   static constexpr int kDefaultSelect = 0;
   static constexpr Anchor kDefaultAnchor = Anchor::kLeft;
+  static constexpr int kDefaultOffset = 0;
+
+ private:
+  mutable int input_offset_;
+  mutable int output_offset_;
+  mutable int zero_offset_;
 };
 
 }  // namespace transforms
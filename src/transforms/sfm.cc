@@ -36,26 +36,80 @@ namespace transforms {
 
 using formats::FixedArray;
 
+SFM::SFM() noexcept
+    : zero_geometric_(0), zero_arithmetic_(0), different_signs_(0) {
+}
+
+bool SFM::SupportsSoAInput() const noexcept {
+  return true;
+}
+
+void SFM::Do(const InBuffers& in, OutBuffers* out) const noexcept {
+  const float* gMeans = nullptr;
+  const float* aMeans = nullptr;
+  if (soa_input()) {
+    gMeans = formats::FieldColumn(in, kMeanTypeGeometric);
+    aMeans = formats::FieldColumn(in, kMeanTypeArithmetic);
+  }
+  this->ParallelFor(in.Count(), [&](size_t begin, size_t end) {
+    SFMStatistics total {};
+    for (size_t i = begin; i < end; i++) {
+      SFMStatistics degenerate {};
+      if (gMeans == nullptr) {
+        (*out)[i] = Calculate(in[i][kMeanTypeGeometric],
+                              in[i][kMeanTypeArithmetic], &degenerate);
+      } else {
+        (*out)[i] = Calculate(gMeans[i], aMeans[i], &degenerate);
+      }
+      total.ZeroGeometric += degenerate.ZeroGeometric;
+      total.ZeroArithmetic += degenerate.ZeroArithmetic;
+      total.DifferentSigns += degenerate.DifferentSigns;
+    }
+    Count(total);
+  });
+}
+
 void SFM::Do(const FixedArray<kMeanTypeCount>& in,
              float* out) const noexcept {
-  float gMean = in[kMeanTypeGeometric];
-  float aMean = in[kMeanTypeArithmetic];
+  SFMStatistics degenerate {};
+  *out = Calculate(in[kMeanTypeGeometric], in[kMeanTypeArithmetic],
+                   &degenerate);
+  Count(degenerate);
+}
+
+float SFM::Calculate(float gMean, float aMean,
+                     SFMStatistics* degenerate) noexcept {
   if (gMean == 0) {
-    DBG("Buffer has geometric mean equal to 0. Setting the result to 0");
-    *out = 0;
-    return;
+    degenerate->ZeroGeometric++;
+    return 0;
   }
   if (aMean == 0) {
-    WRN("Buffer has arithmetic mean equal to 0. Setting the result to 0.");
-    *out = 0;
-    return;
+    degenerate->ZeroArithmetic++;
+    return 0;
   }
   if (gMean / aMean < 0) {
-    ERR("Buffer has geometric and arithmetic means of different sign.");
-    *out = 0;
-    return;
+    degenerate->DifferentSigns++;
+    return 0;
+  }
+  return logf(gMean / aMean);
+}
+
+void SFM::Count(const SFMStatistics& degenerate) const noexcept {
+  // The atomics are touched only when something degenerate happened
+  if (degenerate.ZeroGeometric > 0) {
+    zero_geometric_ += degenerate.ZeroGeometric;
   }
-  *out = logf(gMean / aMean);
+  if (degenerate.ZeroArithmetic > 0) {
+    zero_arithmetic_ += degenerate.ZeroArithmetic;
+  }
+  if (degenerate.DifferentSigns > 0) {
+    different_signs_ += degenerate.DifferentSigns;
+  }
+}
+
+SFMStatistics SFM::Statistics() const noexcept {
+  return { zero_geometric_.load(), zero_arithmetic_.load(),
+           different_signs_.load() };
 }
 
 REGISTER_TRANSFORM(SFM);
@@ -31,20 +31,51 @@
 #ifndef SRC_TRANSFORMS_SFM_H_
 #define SRC_TRANSFORMS_SFM_H_
 
+#include <atomic>
 #include "src/transforms/mean.h"
 
 namespace sound_feature_extraction {
 namespace transforms {
 
-class SFM : public OmpTransformBase<
+/// @brief The numbers of the buffers for which SFM could not be calculated
+/// and was set to 0.
+struct SFMStatistics {
+  uint64_t ZeroGeometric;
+  uint64_t ZeroArithmetic;
+  uint64_t DifferentSigns;
+};
+
+class SFM : public OmpAwareTransform<
     formats::SingleFormat<formats::FixedArray<kMeanTypeCount>>,
-    formats::SingleFormat<float>>, public TransformLogger<SFM> {
+    formats::SingleFormat<float>>, public StructOfArraysTransform,
+    public TransformLogger<SFM> {
  public:
   TRANSFORM_INTRO("SFM", "Spectral Flatness Measure calculation.", SFM)
 
+  SFM() noexcept;
+
+  virtual bool SupportsSoAInput() const noexcept override;
+
+  /// @brief Returns the numbers of the degenerate buffers met since
+  /// the transform was created. They are counted instead of being logged
+  /// on each Do().
+  SFMStatistics Statistics() const noexcept;
+
  protected:
-  virtual void Do(const formats::FixedArray<kMeanTypeCount>& in,
-                  float* out) const noexcept override;
+  virtual void Do(const InBuffers& in, OutBuffers* out)
+      const noexcept override;
+
+  void Do(const formats::FixedArray<kMeanTypeCount>& in,
+          float* out) const noexcept;
+
+ private:
+  static float Calculate(float gMean, float aMean,
+                         SFMStatistics* degenerate) noexcept;
+  void Count(const SFMStatistics& degenerate) const noexcept;
+
+  mutable std::atomic<uint64_t> zero_geometric_;
+  mutable std::atomic<uint64_t> zero_arithmetic_;
+  mutable std::atomic<uint64_t> different_signs_;
 };
 
 }  // namespace transforms
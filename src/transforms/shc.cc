@@ -29,12 +29,15 @@
  */
 
 #include "src/transforms/shc.h"
+#include <algorithm>
 #include <simd/normalize.h>
 #include <simd/arithmetic-inl.h>
 
 namespace sound_feature_extraction {
 namespace transforms {
 
+constexpr int SHC::kFrames;
+
 SHC::SHC()
     : harmonics_(kDefaultHarmonicsNumber),
       window_(kDefaultWindowWidth),
@@ -83,6 +86,15 @@ size_t SHC::OnFormatChanged(size_t buffersCount) {
   return buffersCount;
 }
 
+ElementRange SHC::RequiredElements(const ElementRange&) const noexcept {
+  // Initialize() has not necessarily been called yet
+  int half_window = input_format_->Size() * window_ /
+      input_format_->SamplingRate();
+  size_t end = max_samples_ * harmonics_ + half_window + 1;
+  return { static_cast<size_t>(std::max(min_samples_ - half_window, 0)),
+           std::min(end, input_format_->Size()) };
+}
+
 void SHC::Do(const float* in, float* out) const noexcept {
   for (int i = min_samples_; i <= max_samples_; i++) {
     float sum = 0;
@@ -147,6 +159,101 @@ void SHC::Do(const float* in, float* out) const noexcept {
     }
     out[i - min_samples_] = sum;
   }
+  Normalize(out);
+}
+
+void SHC::Do(const BuffersBase<float*>& in,
+             BuffersBase<float*>* out) const noexcept {
+  int count = in.Count();
+  int groups = (count + kFrames - 1) / kFrames;
+  ParallelFor(groups, [&](int begin, int end) {
+    std::vector<float> tile;
+    for (int g = begin; g < end; g++) {
+      int first = g * kFrames;
+      int frames = std::min(kFrames, count - first);
+      Transpose(in, first, frames, &tile);
+      DoFrames(tile.data(), first, frames, out);
+    }
+  });
+}
+
+void SHC::Transpose(const BuffersBase<float*>& in, int first, int frames,
+                    std::vector<float>* tile) const noexcept {
+  int bins = max_samples_ * harmonics_ + half_window_samples_ + 1;
+  tile->assign(bins * kFrames, 0.f);
+  int size = std::min(bins, static_cast<int>(input_format_->Size()));
+  for (int k = 0; k < frames; k++) {
+    const float* spectrum = in[first + k];
+    float* column = tile->data() + k;
+    for (int b = 0; b < size; b++) {
+      column[b * kFrames] = spectrum[b];
+    }
+  }
+}
+
+void SHC::DoFrames(const float* tile, int first, int frames,
+                   BuffersBase<float*>* out) const noexcept {
+  // Each lane repeats the scalar order of the operations of its frame,
+  // so the results do not depend on use_simd()
+  float sums[kFrames];
+  for (int i = min_samples_; i <= max_samples_; i++) {
+    if (use_simd()) {
+#ifdef __AVX__
+      static_assert(kFrames == 8, "kFrames must match the AVX width");
+      __m256 sum = _mm256_setzero_ps();
+      for (int f = -half_window_samples_; f <= half_window_samples_; f++) {
+        __m256 prod = _mm256_set1_ps(1);
+        for (int j = 0; j < harmonics_; j++) {
+          prod = _mm256_mul_ps(prod, _mm256_loadu_ps(
+              tile + (i * (j + 1) + f) * kFrames));
+        }
+        sum = _mm256_add_ps(sum, prod);
+      }
+      _mm256_storeu_ps(sums, sum);
+    } else {
+#elif defined(__ARM_NEON__)
+      float32x4_t sum_lo = vdupq_n_f32(0), sum_hi = vdupq_n_f32(0);
+      for (int f = -half_window_samples_; f <= half_window_samples_; f++) {
+        float32x4_t prod_lo = vdupq_n_f32(1), prod_hi = vdupq_n_f32(1);
+        for (int j = 0; j < harmonics_; j++) {
+          const float* bin = tile + (i * (j + 1) + f) * kFrames;
+          prod_lo = vmulq_f32(prod_lo, vld1q_f32(bin));
+          prod_hi = vmulq_f32(prod_hi, vld1q_f32(bin + 4));
+        }
+        sum_lo = vaddq_f32(sum_lo, prod_lo);
+        sum_hi = vaddq_f32(sum_hi, prod_hi);
+      }
+      vst1q_f32(sums, sum_lo);
+      vst1q_f32(sums + 4, sum_hi);
+    } else {
+#else
+    } {
+#endif
+      std::fill(sums, sums + kFrames, 0.f);
+      for (int f = -half_window_samples_; f <= half_window_samples_; f++) {
+        float prod[kFrames];
+        std::fill(prod, prod + kFrames, 1.f);
+        for (int j = 0; j < harmonics_; j++) {
+          const float* bin = tile + (i * (j + 1) + f) * kFrames;
+          for (int k = 0; k < kFrames; k++) {
+            prod[k] *= bin[k];
+          }
+        }
+        for (int k = 0; k < kFrames; k++) {
+          sums[k] += prod[k];
+        }
+      }
+    }
+    for (int k = 0; k < frames; k++) {
+      (*out)[first + k][i - min_samples_] = sums[k];
+    }
+  }
+  for (int k = 0; k < frames; k++) {
+    Normalize((*out)[first + k]);
+  }
+}
+
+void SHC::Normalize(float* out) const noexcept {
   float max;
   minmax1D(use_simd(), out, output_format_->Size(), nullptr, &max);
   if (use_simd()) {
@@ -31,6 +31,7 @@
 #ifndef SRC_TRANSFORMS_SHC_H_
 #define SRC_TRANSFORMS_SHC_H_
 
+#include <vector>
 #include "src/formats/single_format.h"
 #include "src/transforms/common.h"
 
@@ -51,7 +52,10 @@ class SHCInvalidMinMaxWindowWidthException : public ExceptionBase {
 
 /// @brief Prepare for fundamental frequency extraction using Spectral Harmonics
 /// Correlation.
-class SHC : public OmpUniformFormatTransform<formats::ArrayFormatF>,
+/// @details The spectra are processed in the groups of kFrames: each group
+/// is transposed once, so that a bin of all the frames is contiguous, and
+/// the harmonic products of all the frames are calculated together.
+class SHC : public UniformFormatOmpAwareTransform<formats::ArrayFormatF>,
       public TransformLogger<SHC> {
  public:
   SHC();
@@ -63,10 +67,25 @@ class SHC : public OmpUniformFormatTransform<formats::ArrayFormatF>,
   TP(min, int, kDefaultMinFrequency, "The minimal frequency to scan.")
   TP(max, int, kDefaultMaxFrequency, "The maximal frequency to scan.")
 
+  virtual Overlap RequiredOverlap(const Overlap& output)
+      const noexcept override {
+    return output;
+  }
+
+  /// @brief The bins of the harmonics of [min, max] within the window.
+  virtual ElementRange RequiredElements(const ElementRange& output)
+      const noexcept override;
+
  protected:
+  /// @brief The number of the frames processed together.
+  static constexpr int kFrames = 8;
+
   virtual void Initialize() const override;
   virtual size_t OnFormatChanged(size_t buffersCount) override;
-  virtual void Do(const float* in, float* out) const noexcept override;
+  virtual void Do(const BuffersBase<float*>& in,
+                  BuffersBase<float*>* out) const noexcept override;
+  /// @brief Processes a single spectrum.
+  void Do(const float* in, float* out) const noexcept;
 
  private:
   static constexpr int kDefaultHarmonicsNumber = 3;
@@ -74,6 +93,15 @@ class SHC : public OmpUniformFormatTransform<formats::ArrayFormatF>,
   static constexpr int kDefaultMinFrequency = 50;
   static constexpr int kDefaultMaxFrequency = 600;
 
+  /// @brief Copies the spectra of frames (at most kFrames) starting from
+  /// first so that tile[bin * kFrames + k] is the bin of the k-th one.
+  /// The bins beyond the input are zeros.
+  void Transpose(const BuffersBase<float*>& in, int first, int frames,
+                 std::vector<float>* tile) const noexcept;
+  void DoFrames(const float* tile, int first, int frames,
+                BuffersBase<float*>* out) const noexcept;
+  void Normalize(float* out) const noexcept;
+
   mutable int half_window_samples_;
   mutable int min_samples_;
   mutable int max_samples_;
@@ -28,6 +28,7 @@
  *  under the License.
  */
 
+#include <algorithm>
 #include <simd/arithmetic-inl.h>
 #include "src/transforms/short_time_msn.h"
 
@@ -38,6 +39,8 @@ ShortTimeMeanScaleNormalization::ShortTimeMeanScaleNormalization()
     : length_(kDefaultLength) {
 }
 
+constexpr int ShortTimeMeanScaleNormalization::kColumns;
+
 bool ShortTimeMeanScaleNormalization::validate_length(
     const int& value) noexcept {
   return value >= 2;
@@ -47,42 +50,135 @@ void ShortTimeMeanScaleNormalization::Do(
     const BuffersBase<float*>& in,
     BuffersBase<float*>* out) const noexcept {
   int back = length_ / 2;
-  int front = length_ - back;
+  // In the streaming mode, the windows of the previous buffers take part
+  // in the averaging as if they were prepended to the current ones
+  int history = streaming()? stream_history_.size() : 0;
+  int total = history + in.Count();
+  std::vector<const float*> rows(total);
+  for (int k = 0; k < history; k++) {
+    rows[k] = stream_history_[k].data();
+  }
   for (size_t i = 0; i < in.Count(); i++) {
-    for (int j = 0; j < static_cast<int>(input_format_->Size()); j++) {
-      int len = length_;
-      int backind = i - back;
-      if (backind < 0) {
-        len += backind;
-        backind = 0;
+    rows[history + i] = in[i];
+  }
+  int size = input_format_->Size();
+  int chunks = (size + kColumns - 1) / kColumns;
+  ParallelFor(chunks, [&](int begin, int end) {
+    for (int c = begin; c < end; c++) {
+      NormalizeColumns(rows.data(), total, history, c * kColumns,
+                       std::min(kColumns, size - c * kColumns), out);
+    }
+  });
+  if (streaming()) {
+    std::vector<std::vector<float>> updated;
+    for (int k = std::max(total - back, 0); k < total; k++) {
+      updated.emplace_back(rows[k], rows[k] + size);
+    }
+    stream_history_.swap(updated);
+  }
+}
+
+void ShortTimeMeanScaleNormalization::NormalizeColumns(
+    const float* const* rows, int total, int history, int first, int width,
+    BuffersBase<float*>* out) const noexcept {
+  int back = length_ / 2;
+  int front = length_ - back;
+  // Every window [begin, end) is at most length_ long, so it either starts
+  // a block of length_ rows, or ends the last block, or spans two blocks:
+  // its extrema are the suffix ones of the first block and the prefix ones
+  // of the second
+  std::vector<float> suffix_min(length_ * kColumns);
+  std::vector<float> suffix_max(length_ * kColumns);
+  float prefix_min[kColumns], prefix_max[kColumns];
+  double sum[kColumns] = {};
+  int begin = 0, end = 0, suffix_block = -1, prefix_block = -1, prefix_end = 0;
+  for (int i = history; i < total; i++) {
+    int next_begin = std::max(i - back, 0);
+    int next_end = std::min(i + front, total);
+    for (; end < next_end; end++) {
+      for (int j = 0; j < width; j++) {
+        sum[j] += rows[end][first + j];
       }
-      int frontind = i + front;
-      if (frontind > static_cast<int>(in.Count())) {
-        len += in.Count() - frontind;
-        frontind = static_cast<int>(in.Count());
+    }
+    for (; begin < next_begin; begin++) {
+      for (int j = 0; j < width; j++) {
+        sum[j] -= rows[begin][first + j];
       }
-      float sum = 0.f;
-      float thisval = in[i][j];
-      float min = thisval;
-      float max = thisval;
-      for (int k = backind; k < frontind; k++) {
-        float val = in[k][j];
-        sum += val;
-        if (min > val) {
-          min = val;
-        } else if (max < val) {
-          max = val;
+    }
+    if ((end - 1) / length_ != prefix_block) {
+      prefix_block = (end - 1) / length_;
+      prefix_end = prefix_block * length_;
+      for (int j = 0; j < width; j++) {
+        prefix_min[j] = rows[prefix_end][first + j];
+        prefix_max[j] = prefix_min[j];
+      }
+      prefix_end++;
+    }
+    for (; prefix_end < end; prefix_end++) {
+      for (int j = 0; j < width; j++) {
+        float val = rows[prefix_end][first + j];
+        prefix_min[j] = std::min(prefix_min[j], val);
+        prefix_max[j] = std::max(prefix_max[j], val);
+      }
+    }
+    int block_begin = begin - begin % length_;
+    if (begin / length_ != suffix_block) {
+      suffix_block = begin / length_;
+      int last = std::min(block_begin + length_, total) - 1 - block_begin;
+      for (int j = 0; j < width; j++) {
+        suffix_min[last * kColumns + j] = rows[block_begin + last][first + j];
+        suffix_max[last * kColumns + j] = suffix_min[last * kColumns + j];
+      }
+      for (int k = last - 1; k >= 0; k--) {
+        for (int j = 0; j < width; j++) {
+          float val = rows[block_begin + k][first + j];
+          suffix_min[k * kColumns + j] =
+              std::min(suffix_min[(k + 1) * kColumns + j], val);
+          suffix_max[k * kColumns + j] =
+              std::max(suffix_max[(k + 1) * kColumns + j], val);
         }
       }
+    }
+    const float* smin = &suffix_min[(begin - block_begin) * kColumns];
+    const float* smax = &suffix_max[(begin - block_begin) * kColumns];
+    bool same_block = suffix_block == prefix_block;
+    bool aligned = begin == block_begin;
+    float len = end - begin;
+    float* result = (*out)[i - history] + first;
+    for (int j = 0; j < width; j++) {
+      float min, max;
+      if (same_block) {
+        min = aligned? prefix_min[j] : smin[j];
+        max = aligned? prefix_max[j] : smax[j];
+      } else {
+        min = std::min(smin[j], prefix_min[j]);
+        max = std::max(smax[j], prefix_max[j]);
+      }
+      float thisval = rows[i][first + j];
       if (max - min > 0) {
-        (*out)[i][j] = (thisval - sum / len) / (max - min);
+        result[j] = (thisval - static_cast<float>(sum[j]) / len) / (max - min);
       } else {
-        (*out)[i][j] = 0;
+        result[j] = 0;
       }
     }
   }
 }
 
+Overlap ShortTimeMeanScaleNormalization::RequiredOverlap(
+    const Overlap& output) const noexcept {
+  if (!output.Bounded()) {
+    return output;
+  }
+  // See NormalizeColumns() for the window of each row
+  size_t back = length_ / 2;
+  size_t front = length_ - back;
+  return { output.Before + back, output.After + front - 1 };
+}
+
+void ShortTimeMeanScaleNormalization::ResetState() const noexcept {
+  stream_history_.clear();
+}
+
 RTP(ShortTimeMeanScaleNormalization, length)
 REGISTER_TRANSFORM(ShortTimeMeanScaleNormalization);
 
@@ -31,14 +31,19 @@
 #ifndef SRC_TRANSFORMS_SHORT_TIME_MSN_H_
 #define SRC_TRANSFORMS_SHORT_TIME_MSN_H_
 
+#include <vector>
 #include "src/formats/array_format.h"
-#include "src/transform_base.h"
+#include "src/omp_transform_base.h"
 
 namespace sound_feature_extraction {
 namespace transforms {
 
+/// @brief The sums are updated as the window slides and the minimums and
+/// the maximums are taken from the block-wise prefix and suffix extrema
+/// (van Herk/Gil-Werman), so the cost does not depend on "length". The
+/// columns are processed in independent chunks of kColumns.
 class ShortTimeMeanScaleNormalization
-    : public UniformFormatTransform<formats::ArrayFormatF> {
+    : public UniformFormatOmpAwareTransform<formats::ArrayFormatF> {
  public:
   ShortTimeMeanScaleNormalization();
 
@@ -52,11 +57,27 @@ class ShortTimeMeanScaleNormalization
 
   TP(length, int, kDefaultLength, "The amount of local values to average.")
 
+  virtual void ResetState() const noexcept override;
+
+  virtual Overlap RequiredOverlap(const Overlap& output)
+      const noexcept override;
+
  protected:
   virtual void Do(const BuffersBase<float*>& in,
                   BuffersBase<float*>* out) const noexcept override;
 
   static constexpr int kDefaultLength = 300;
+  /// @brief The number of columns processed together.
+  static constexpr int kColumns = 16;
+
+ private:
+  void NormalizeColumns(const float* const* rows, int total, int history,
+                        int first, int width,
+                        BuffersBase<float*>* out) const noexcept;
+
+  /// @brief The last length / 2 windows of the previous buffers in the
+  /// streaming mode, the oldest first.
+  mutable std::vector<std::vector<float>> stream_history_;
 };
 
 }  // namespace transforms
@@ -34,17 +34,33 @@
 #include "src/transform_base.h"
 #include "src/formats/single_format.h"
 #include "src/formats/array_format.h"
+#include "src/view_transform.h"
 
 namespace sound_feature_extraction {
 namespace transforms {
 
 template <class T>
 class SinglesToArray : public TransformBase<formats::SingleFormat<T>,
-                                         formats::ArrayFormat<T>> {
+                                         formats::ArrayFormat<T>>,
+                       public ViewTransform {
  public:
   TRANSFORM_INTRO("Merge", "Merge all single-s to one solid array.",
                   SinglesToArray)
 
+  /// @brief The array is the singles themselves if they are dense.
+  virtual bool IsView() const noexcept override {
+    return true;
+  }
+
+  /// @brief There is only one output buffer, any stride would do.
+  virtual size_t ViewStride() const noexcept override {
+    return this->output_format_->SizeInBytes();
+  }
+
+  virtual bool DenseInput() const noexcept override {
+    return true;
+  }
+
  protected:
   virtual size_t OnInputFormatChanged(size_t buffersCount) override final {
     this->output_format_->SetSize(buffersCount);
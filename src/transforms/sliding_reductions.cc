@@ -1,6 +1,6 @@
-/*! @file stoi_function.h
- *  @brief std::transform friendly std::stoi wrapper.
- *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+/*! @file sliding_reductions.cc
+ *  @brief Fused rectangular windows and their energy, zero crossings or mean.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
  *  @version 1.0
  *
  *  @section Notes
@@ -28,18 +28,23 @@
  *  under the License.
  */
 
-#ifndef SRC_STOI_FUNCTION_H_
-#define SRC_STOI_FUNCTION_H_
+#include "src/transforms/sliding_reductions.h"
 
-#include <functional>
-#include <string>
+namespace sound_feature_extraction {
+namespace transforms {
 
-namespace std {
+void SlidingMean::Do(const BuffersBase<float*>& in,
+                     BuffersBase<formats::FixedArray<kMeanTypeCount>>* out)
+    const noexcept {
+  float length = splitter_->length();
+  Slide(in, 0, [](const float* signal, size_t i) {
+    return static_cast<Accumulator>(signal[i]);
+  }, [&](const float*, size_t, Accumulator sum, size_t index) {
+    auto& means = (*out)[index];
+    means.fill(0);
+    means[kMeanTypeArithmetic] = static_cast<float>(sum) / length;
+  });
+}
 
-static const auto stoi_function = bind(  // NOLINT(*)
-    static_cast<int(*)(const string&, size_t*, int)>(&stoi),
-    placeholders::_1, nullptr, 10);
-
-}  // namespace std
-
-#endif  // SRC_STOI_FUNCTION_H_
+}  // namespace transforms
+}  // namespace sound_feature_extraction
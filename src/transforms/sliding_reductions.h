@@ -0,0 +1,221 @@
+/*! @file sliding_reductions.h
+ *  @brief Fused rectangular windows and their energy, zero crossings or mean.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+#ifndef SRC_TRANSFORMS_SLIDING_REDUCTIONS_H_
+#define SRC_TRANSFORMS_SLIDING_REDUCTIONS_H_
+
+#include <algorithm>
+#include <memory>
+#include <type_traits>
+#include "src/formats/single_format.h"
+#include "src/transforms/mean.h"
+#include "src/transforms/window_splitter.h"
+
+namespace sound_feature_extraction {
+namespace transforms {
+
+/// @brief WindowSplitter with the rectangular windows followed by
+/// a reduction of each window, which is calculated from the running sums
+/// over the signal instead of summing each window from scratch.
+/// @details The sum of the next window is the sum of the current one plus
+/// the samples which enter minus the samples which leave, so the cost is
+/// O(samples) instead of O(windows x length) and the windows are never
+/// split. The sums start over every kBlockSize windows, which bounds
+/// the accumulated rounding error and lets the blocks run in parallel.
+/// The integer samples are summed exactly. TransformTree creates these
+/// transforms instead of such pairs of nodes when the splitter has
+/// a single input buffer, they are not registered in the factory.
+template <class T, class FOUT>
+class SlidingReduction
+    : public TransformBase<formats::ArrayFormat<T>, FOUT>,
+      public ParallelTransform {
+ public:
+  /// @brief The type of the running sums.
+  typedef typename std::conditional<std::is_integral<T>::value,
+                                    int64_t, double>::type Accumulator;
+
+  /// @param splitter The WindowSplitterTemplate<T> with the rectangular
+  /// windows, its input format must be already set.
+  explicit SlidingReduction(const std::shared_ptr<Transform>& splitter)
+      : splitter_(std::dynamic_pointer_cast<WindowSplitterTemplate<T>>(
+            splitter)),
+        windows_count_(0) {
+    assert(splitter_);
+  }
+
+  const std::shared_ptr<WindowSplitterTemplate<T>>& splitter()
+      const noexcept {
+    return splitter_;
+  }
+
+  virtual void Initialize() const override {
+    splitter_->Initialize();
+  }
+
+  virtual Overlap RequiredOverlap(const Overlap& output)
+      const noexcept override {
+    return splitter_->RequiredOverlap(output);
+  }
+
+ protected:
+  virtual size_t OnInputFormatChanged(size_t buffersCount) override {
+    size_t count = splitter_->SetInputFormat(this->input_format_,
+                                             buffersCount);
+    windows_count_ = count / buffersCount;
+    return count;
+  }
+
+  /// @brief Calls finish(signal, start, sum, index) for each window, where
+  /// sum is the sum of value(signal, i) over the window's samples except
+  /// the first skip ones.
+  template <class V, class F>
+  void Slide(const BuffersBase<T*>& in, size_t skip, const V& value,
+             const F& finish) const noexcept {
+    assert(in.Count() == 1);
+    const T* signal = in[0];
+    size_t step = splitter_->step();
+    size_t length = splitter_->length();
+    size_t blocks = (windows_count_ + kBlockSize - 1) / kBlockSize;
+    ThreadPool::Instance().ParallelFor(
+        blocks, 1, serial()? 1 : get_omp_transforms_max_threads_num(),
+        [&](size_t begin, size_t end) {
+      for (size_t block = begin; block < end; block++) {
+        size_t first = block * kBlockSize;
+        size_t last = std::min(first + kBlockSize, windows_count_);
+        Accumulator sum = 0;
+        for (size_t i = first * step + skip; i < first * step + length;
+             i++) {
+          sum += value(signal, i);
+        }
+        finish(signal, first * step, sum, first);
+        for (size_t j = first + 1; j < last; j++) {
+          size_t prev = (j - 1) * step, next = j * step;
+          for (size_t i = prev + length; i < next + length; i++) {
+            sum += value(signal, i);
+          }
+          for (size_t i = prev + skip; i < next + skip; i++) {
+            sum -= value(signal, i);
+          }
+          finish(signal, next, sum, j);
+        }
+      }
+    });
+  }
+
+  /// @brief The number of windows after which the running sums start over.
+  static constexpr size_t kBlockSize = 64;
+
+  std::shared_ptr<WindowSplitterTemplate<T>> splitter_;
+  size_t windows_count_;
+};
+
+template <class T, class FOUT>
+constexpr size_t SlidingReduction<T, FOUT>::kBlockSize;
+
+/// @brief Calculates the same as Energy (or Energy16) of the rectangular
+/// windows.
+template <class T>
+class SlidingEnergy : public SlidingReduction<T, formats::SingleFormatF> {
+ public:
+  using SlidingReduction<T, formats::SingleFormatF>::SlidingReduction;
+
+  TRANSFORM_INTRO("SlidingEnergy", "Sound energy of the rectangular windows "
+                                   "(Window -> Energy).",
+                  SlidingEnergy<T>)
+
+ protected:
+  typedef typename SlidingReduction<T, formats::SingleFormatF>::Accumulator
+      Accumulator;
+
+  virtual void Do(const BuffersBase<T*>& in,
+                  BuffersBase<float>* out) const noexcept override {
+    float length = this->splitter_->length();
+    this->Slide(in, 0, [](const T* signal, size_t i) {
+      return static_cast<Accumulator>(signal[i]) * signal[i];
+    }, [&](const T*, size_t, Accumulator sum, size_t index) {
+      (*out)[index] = static_cast<float>(sum) / length;
+    });
+  }
+};
+
+/// @brief Calculates the same as ZeroCrossings of the rectangular windows.
+/// @details The window [start, start + length) counts the pairs of
+/// the neighbouring samples which change the sign or start with zero, plus
+/// one if the last sample is zero. The pairs are summed by their second
+/// sample, so the first sample of the window is skipped.
+template <class T>
+class SlidingZeroCrossings
+    : public SlidingReduction<T, formats::SingleFormat32> {
+ public:
+  using SlidingReduction<T, formats::SingleFormat32>::SlidingReduction;
+
+  TRANSFORM_INTRO("SlidingZeroCrossings", "Number of time domain zero "
+                                          "crossings of the rectangular "
+                                          "windows (Window -> ZeroCrossings).",
+                  SlidingZeroCrossings<T>)
+
+ protected:
+  typedef typename SlidingReduction<T, formats::SingleFormat32>::Accumulator
+      Accumulator;
+
+  virtual void Do(const BuffersBase<T*>& in,
+                  BuffersBase<int32_t>* out) const noexcept override {
+    size_t length = this->splitter_->length();
+    this->Slide(in, 1, [](const T* signal, size_t i) {
+      T prev = signal[i - 1], val = signal[i];
+      return static_cast<Accumulator>(prev * val < 0 || prev == 0);
+    }, [&](const T* signal, size_t start, Accumulator sum, size_t index) {
+      (*out)[index] = sum + (signal[start + length - 1] == 0);
+    });
+  }
+};
+
+/// @brief Calculates the same as Mean with only the arithmetic type of
+/// the rectangular windows.
+class SlidingMean
+    : public SlidingReduction<float, formats::SingleFormat<
+          formats::FixedArray<kMeanTypeCount>>> {
+ public:
+  using SlidingReduction<float, formats::SingleFormat<
+      formats::FixedArray<kMeanTypeCount>>>::SlidingReduction;
+
+  TRANSFORM_INTRO("SlidingMean", "Arithmetic mean of the rectangular windows "
+                                 "(Window -> Mean).",
+                  SlidingMean)
+
+ protected:
+  virtual void Do(const BuffersBase<float*>& in,
+                  BuffersBase<formats::FixedArray<kMeanTypeCount>>* out)
+      const noexcept override;
+};
+
+}  // namespace transforms
+}  // namespace sound_feature_extraction
+#endif  // SRC_TRANSFORMS_SLIDING_REDUCTIONS_H_
@@ -0,0 +1,472 @@
+/*! @file spectral_descriptors.cc
+ *  @brief Spectral descriptors calculated in a single pass.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+#include "src/transforms/spectral_descriptors.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#ifdef SIMD_X86
+#include <immintrin.h>
+#elif defined(SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace sound_feature_extraction {
+namespace transforms {
+
+SpectralDescriptor Parse(const std::string& value,
+                         identity<SpectralDescriptor>) {
+  for (int i = 0; i < kSpectralDescriptorCount; i++) {
+    if (value == internal::kSpectralDescriptorStrs[i]) {
+      return static_cast<SpectralDescriptor>(i);
+    }
+  }
+  throw InvalidParameterValueException();
+}
+
+std::set<SpectralDescriptor> Parse(const std::string& value,
+                                   identity<std::set<SpectralDescriptor>>) {
+  std::vector<std::string> words;
+  if (!SplitWords(value, &words)) {
+    throw InvalidParameterValueException();
+  }
+  std::set<SpectralDescriptor> ret;
+  for (auto& word : words) {
+    ret.insert(Parse(word, identity<SpectralDescriptor>()));
+  }
+  return ret;
+}
+
+typedef SpectralDescriptors::Sums (*SumsKernel)(const float* input,
+                                                int length);
+
+static SpectralDescriptors::Sums SumsScalar(const float* input, int length) {
+  SpectralDescriptors::Sums sums { 0, 0, 0, input[0] };
+  for (int i = 0; i < length; i++) {
+    float val = input[i];
+    sums.Sum += val;
+    sums.Weighted += i * val;
+    sums.Squares += val * val;
+    sums.Max = std::max(sums.Max, val);
+  }
+  return sums;
+}
+
+typedef int (*RolloffKernel)(const float* input, int length,
+                             float threshold);
+
+static int RolloffScalar(const float* input, int length, float threshold) {
+  float psum = 0.f;
+  int i;
+  for (i = 0; i < length && psum < threshold; i++) {
+    psum += input[i];
+  }
+  return i - 1;
+}
+
+typedef float (*FluxKernel)(const float* input, const float* prev,
+                            int length, float normInput, float normPrev);
+
+static float FluxScalar(const float* input, const float* prev, int length,
+                        float normInput, float normPrev) {
+  float sqr = 0.f;
+  for (int i = 0; i < length; i++) {
+    float val = input[i] * normInput - prev[i] * normPrev;
+    sqr += val * val;
+  }
+  return sqr;
+}
+
+#ifdef SIMD_X86
+SIMD_TARGET("avx")
+static float HorizontalSumAVX(__m256 vec) {
+  __m128 half = _mm_add_ps(_mm256_castps256_ps128(vec),
+                           _mm256_extractf128_ps(vec, 1));
+  half = _mm_hadd_ps(half, half);
+  half = _mm_hadd_ps(half, half);
+  return _mm_cvtss_f32(half);
+}
+
+SIMD_TARGET("avx")
+static SpectralDescriptors::Sums SumsAVX(const float* input, int length) {
+  int vectorized = length & ~7;
+  __m256 sum = _mm256_setzero_ps(), weighted = _mm256_setzero_ps(),
+      squares = _mm256_setzero_ps(), max = _mm256_set1_ps(input[0]);
+  __m256 indexes = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+  const __m256 step = _mm256_set1_ps(8);
+  for (int i = 0; i < vectorized; i += 8) {
+    __m256 vec = _mm256_loadu_ps(input + i);
+    sum = _mm256_add_ps(sum, vec);
+    weighted = _mm256_add_ps(weighted, _mm256_mul_ps(vec, indexes));
+    squares = _mm256_add_ps(squares, _mm256_mul_ps(vec, vec));
+    max = _mm256_max_ps(max, vec);
+    indexes = _mm256_add_ps(indexes, step);
+  }
+  __m128 max4 = _mm_max_ps(_mm256_castps256_ps128(max),
+                           _mm256_extractf128_ps(max, 1));
+  max4 = _mm_max_ps(max4, _mm_movehl_ps(max4, max4));
+  max4 = _mm_max_ss(max4, _mm_shuffle_ps(max4, max4, 1));
+  SpectralDescriptors::Sums sums {
+    HorizontalSumAVX(sum), HorizontalSumAVX(weighted),
+    HorizontalSumAVX(squares), _mm_cvtss_f32(max4)
+  };
+  for (int i = vectorized; i < length; i++) {
+    float val = input[i];
+    sums.Sum += val;
+    sums.Weighted += i * val;
+    sums.Squares += val * val;
+    sums.Max = std::max(sums.Max, val);
+  }
+  return sums;
+}
+
+SIMD_TARGET("avx")
+static int RolloffAVX(const float* input, int length, float threshold) {
+  // Skip the whole blocks which do not reach the threshold
+  int vectorized = length & ~7;
+  float psum = 0.f;
+  int i = 0;
+  for (; i < vectorized; i += 8) {
+    float block = HorizontalSumAVX(_mm256_loadu_ps(input + i));
+    if (!(psum + block < threshold)) {
+      break;
+    }
+    psum += block;
+  }
+  for (; i < length && psum < threshold; i++) {
+    psum += input[i];
+  }
+  return i - 1;
+}
+
+SIMD_TARGET("avx")
+static float FluxAVX(const float* input, const float* prev, int length,
+                     float normInput, float normPrev) {
+  int vectorized = length & ~7;
+  const __m256 norm_input = _mm256_set1_ps(normInput);
+  const __m256 norm_prev = _mm256_set1_ps(normPrev);
+  __m256 acc = _mm256_setzero_ps();
+  for (int i = 0; i < vectorized; i += 8) {
+    __m256 diff = _mm256_sub_ps(
+        _mm256_mul_ps(_mm256_loadu_ps(input + i), norm_input),
+        _mm256_mul_ps(_mm256_loadu_ps(prev + i), norm_prev));
+    acc = _mm256_add_ps(acc, _mm256_mul_ps(diff, diff));
+  }
+  float sqr = HorizontalSumAVX(acc);
+  for (int i = vectorized; i < length; i++) {
+    float val = input[i] * normInput - prev[i] * normPrev;
+    sqr += val * val;
+  }
+  return sqr;
+}
+
+SIMD_TARGET_AVX512
+static SpectralDescriptors::Sums SumsAVX512(const float* input,
+                                            int length) {
+  __m512 sum = _mm512_setzero_ps(), weighted = _mm512_setzero_ps(),
+      squares = _mm512_setzero_ps(), max = _mm512_set1_ps(input[0]);
+  __m512 indexes = _mm512_setr_ps(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12,
+                                  13, 14, 15);
+  const __m512 step = _mm512_set1_ps(16);
+  int i = 0;
+  for (; i < length - 15; i += 16) {
+    __m512 vec = _mm512_loadu_ps(input + i);
+    sum = _mm512_add_ps(sum, vec);
+    weighted = _mm512_fmadd_ps(vec, indexes, weighted);
+    squares = _mm512_fmadd_ps(vec, vec, squares);
+    max = _mm512_max_ps(max, vec);
+    indexes = _mm512_add_ps(indexes, step);
+  }
+  // The masked out values are zeros, which do not change the sums
+  __mmask16 tail = (1u << (length - i)) - 1;
+  __m512 vec = _mm512_maskz_loadu_ps(tail, input + i);
+  sum = _mm512_add_ps(sum, vec);
+  weighted = _mm512_fmadd_ps(vec, indexes, weighted);
+  squares = _mm512_fmadd_ps(vec, vec, squares);
+  max = _mm512_mask_max_ps(max, tail, max, vec);
+  return { _mm512_reduce_add_ps(sum), _mm512_reduce_add_ps(weighted),
+           _mm512_reduce_add_ps(squares), _mm512_reduce_max_ps(max) };
+}
+
+SIMD_TARGET_AVX512
+static float FluxAVX512(const float* input, const float* prev, int length,
+                        float normInput, float normPrev) {
+  const __m512 norm_input = _mm512_set1_ps(normInput);
+  const __m512 norm_prev = _mm512_set1_ps(normPrev);
+  __m512 acc = _mm512_setzero_ps();
+  int i = 0;
+  for (; i < length - 15; i += 16) {
+    __m512 diff = _mm512_fmsub_ps(
+        _mm512_loadu_ps(input + i), norm_input,
+        _mm512_mul_ps(_mm512_loadu_ps(prev + i), norm_prev));
+    acc = _mm512_fmadd_ps(diff, diff, acc);
+  }
+  __mmask16 tail = (1u << (length - i)) - 1;
+  __m512 diff = _mm512_fmsub_ps(
+      _mm512_maskz_loadu_ps(tail, input + i), norm_input,
+      _mm512_mul_ps(_mm512_maskz_loadu_ps(tail, prev + i), norm_prev));
+  acc = _mm512_fmadd_ps(diff, diff, acc);
+  return _mm512_reduce_add_ps(acc);
+}
+#elif defined(SIMD_NEON)
+static float HorizontalSumNEON(float32x4_t vec) {
+  float32x2_t half = vadd_f32(vget_low_f32(vec), vget_high_f32(vec));
+  return vget_lane_f32(vpadd_f32(half, half), 0);
+}
+
+static SpectralDescriptors::Sums SumsNEON(const float* input, int length) {
+  int vectorized = length & ~3;
+  float32x4_t sum = vdupq_n_f32(0), weighted = vdupq_n_f32(0),
+      squares = vdupq_n_f32(0), max = vdupq_n_f32(input[0]);
+  float32x4_t indexes = { 0.f, 1.f, 2.f, 3.f };
+  const float32x4_t step = vdupq_n_f32(4.f);
+  for (int i = 0; i < vectorized; i += 4) {
+    float32x4_t vec = vld1q_f32(input + i);
+    sum = vaddq_f32(sum, vec);
+    weighted = vmlaq_f32(weighted, vec, indexes);
+    squares = vmlaq_f32(squares, vec, vec);
+    max = vmaxq_f32(max, vec);
+    indexes = vaddq_f32(indexes, step);
+  }
+  float32x2_t max2 = vpmax_f32(vget_low_f32(max), vget_high_f32(max));
+  SpectralDescriptors::Sums sums {
+    HorizontalSumNEON(sum), HorizontalSumNEON(weighted),
+    HorizontalSumNEON(squares), vget_lane_f32(vpmax_f32(max2, max2), 0)
+  };
+  for (int i = vectorized; i < length; i++) {
+    float val = input[i];
+    sums.Sum += val;
+    sums.Weighted += i * val;
+    sums.Squares += val * val;
+    sums.Max = std::max(sums.Max, val);
+  }
+  return sums;
+}
+
+static int RolloffNEON(const float* input, int length, float threshold) {
+  // Skip the whole blocks which do not reach the threshold
+  int vectorized = length & ~3;
+  float psum = 0.f;
+  int i = 0;
+  for (; i < vectorized; i += 4) {
+    float block = HorizontalSumNEON(vld1q_f32(input + i));
+    if (!(psum + block < threshold)) {
+      break;
+    }
+    psum += block;
+  }
+  for (; i < length && psum < threshold; i++) {
+    psum += input[i];
+  }
+  return i - 1;
+}
+
+static float FluxNEON(const float* input, const float* prev, int length,
+                      float normInput, float normPrev) {
+  int vectorized = length & ~3;
+  const float32x4_t norm_input = vdupq_n_f32(normInput);
+  const float32x4_t norm_prev = vdupq_n_f32(normPrev);
+  float32x4_t acc = vdupq_n_f32(0);
+  for (int i = 0; i < vectorized; i += 4) {
+    float32x4_t diff = vsubq_f32(
+        vmulq_f32(vld1q_f32(input + i), norm_input),
+        vmulq_f32(vld1q_f32(prev + i), norm_prev));
+    acc = vmlaq_f32(acc, diff, diff);
+  }
+  float sqr = HorizontalSumNEON(acc);
+  for (int i = vectorized; i < length; i++) {
+    float val = input[i] * normInput - prev[i] * normPrev;
+    sqr += val * val;
+  }
+  return sqr;
+}
+#endif
+
+static const SimdKernel<SumsKernel> kSumsKernels[] {
+#ifdef SIMD_X86
+  { InstructionSet::kAVX512, SumsAVX512 },
+  { InstructionSet::kAVX, SumsAVX },
+#elif defined(SIMD_NEON)
+  { InstructionSet::kNEON, SumsNEON },
+#endif
+  { InstructionSet::kScalar, SumsScalar }
+};
+
+static const SimdKernel<RolloffKernel> kRolloffKernels[] {
+#ifdef SIMD_X86
+  { InstructionSet::kAVX, RolloffAVX },
+#elif defined(SIMD_NEON)
+  { InstructionSet::kNEON, RolloffNEON },
+#endif
+  { InstructionSet::kScalar, RolloffScalar }
+};
+
+static const SimdKernel<FluxKernel> kFluxKernels[] {
+#ifdef SIMD_X86
+  { InstructionSet::kAVX512, FluxAVX512 },
+  { InstructionSet::kAVX, FluxAVX },
+#elif defined(SIMD_NEON)
+  { InstructionSet::kNEON, FluxNEON },
+#endif
+  { InstructionSet::kScalar, FluxScalar }
+};
+
+constexpr float SpectralDescriptors::kDefaultRatio;
+
+SpectralDescriptors::SpectralDescriptors()
+    : descriptors_(kDefaultDescriptors()), ratio_(kDefaultRatio) {
+}
+
+ALWAYS_VALID_TP(SpectralDescriptors, descriptors)
+
+bool SpectralDescriptors::validate_ratio(const float& value) noexcept {
+  return value > 0.f && value < 1.f;
+}
+
+bool SpectralDescriptors::BufferInvariant() const noexcept {
+  return descriptors_.find(kSpectralDescriptorFlux) == descriptors_.end();
+}
+
+bool SpectralDescriptors::SupportsSoAOutput() const noexcept {
+  return true;
+}
+
+InstructionSet SpectralDescriptors::SimdInstructionSet() const noexcept {
+  return SimdAware::Dispatch(kSumsKernels).Isa;
+}
+
+SpectralDescriptors::Sums SpectralDescriptors::Calculate(
+    bool simd, const float* input, int length) noexcept {
+  if (!simd) {
+    return SumsScalar(input, length);
+  }
+  return SimdAware::Dispatch(kSumsKernels).Function(input, length);
+}
+
+int SpectralDescriptors::Rolloff(bool simd, const float* input, int length,
+                                 float threshold) noexcept {
+  if (!simd) {
+    return RolloffScalar(input, length, threshold);
+  }
+  return SimdAware::Dispatch(kRolloffKernels).Function(
+      input, length, threshold);
+}
+
+float SpectralDescriptors::Flux(bool simd, const float* input,
+                                const float* prev, int length,
+                                float maxInput, float maxPrev) noexcept {
+  float norm_input = maxInput == 0? 1 : 1 / maxInput;
+  float norm_prev = maxPrev == 0? 1 : 1 / maxPrev;
+  auto kernel = simd? SimdAware::Dispatch(kFluxKernels).Function
+                    : FluxScalar;
+  return sqrtf(kernel(input, prev, length, norm_input, norm_prev));
+}
+
+void SpectralDescriptors::Do(const InBuffers& in, OutBuffers* out)
+    const noexcept {
+  int length = input_format_->Size();
+  float duration = input_format_->Duration();
+  int count = in.Count();
+  bool wanted[kSpectralDescriptorCount];
+  for (int j = 0; j < kSpectralDescriptorCount; j++) {
+    wanted[j] = descriptors_.find(static_cast<SpectralDescriptor>(j)) !=
+        descriptors_.end();
+  }
+  bool soa = soa_output();
+  float* columns[kSpectralDescriptorCount];
+  for (int j = 0; j < kSpectralDescriptorCount; j++) {
+    columns[j] = soa? formats::FieldColumn(out, j) : nullptr;
+  }
+  auto value = [&](int i, int field) -> float& {
+    return soa? columns[field][i] : (*out)[i][field];
+  };
+  bool simd = use_simd();
+  this->ParallelFor(count, [&](int begin, int end) {
+    for (int i = begin; i < end; i++) {
+      auto sums = Calculate(simd, in[i], length);
+      value(i, kSpectralDescriptorCentroid) =
+          wanted[kSpectralDescriptorCentroid] && sums.Sum != 0?
+          sums.Weighted / sums.Sum / duration : 0;
+      value(i, kSpectralDescriptorRolloff) =
+          wanted[kSpectralDescriptorRolloff]?
+          Rolloff(simd, in[i], length, sums.Sum * ratio_) / duration : 0;
+      value(i, kSpectralDescriptorEnergy) =
+          wanted[kSpectralDescriptorEnergy]? sums.Squares / length : 0;
+      // Flux needs the maxima of the adjacent buffers, see below
+      value(i, kSpectralDescriptorFlux) = sums.Max;
+    }
+  });
+  if (!wanted[kSpectralDescriptorFlux] || count == 1) {
+    for (int i = 0; i < count; i++) {
+      value(i, kSpectralDescriptorFlux) = 0;
+    }
+    return;
+  }
+  // Backwards, so that the maximum of the previous buffer is still there
+  for (int i = count - 1; i > 0; i--) {
+    value(i, kSpectralDescriptorFlux) = Flux(
+        simd, in[i], in[i - 1], length, value(i, kSpectralDescriptorFlux),
+        value(i - 1, kSpectralDescriptorFlux));
+  }
+  value(0, kSpectralDescriptorFlux) = value(1, kSpectralDescriptorFlux);
+}
+
+constexpr SpectralDescriptor DescriptorSelector::kDefaultDescriptor;
+
+DescriptorSelector::DescriptorSelector() : descriptor_(kDefaultDescriptor) {
+}
+
+ALWAYS_VALID_TP(DescriptorSelector, descriptor)
+
+bool DescriptorSelector::SupportsSoAInput() const noexcept {
+  return true;
+}
+
+void DescriptorSelector::Do(const InBuffers& in, OutBuffers* out)
+    const noexcept {
+  if (soa_input()) {
+    memcpy(&(*out)[0], formats::FieldColumn(in, descriptor_),
+           in.Count() * sizeof(float));
+    return;
+  }
+  for (size_t i = 0; i < in.Count(); i++) {
+    (*out)[i] = in[i][descriptor_];
+  }
+}
+
+RTP(SpectralDescriptors, descriptors)
+RTP(SpectralDescriptors, ratio)
+REGISTER_TRANSFORM(SpectralDescriptors);
+RTP(DescriptorSelector, descriptor)
+REGISTER_TRANSFORM(DescriptorSelector);
+
+}  // namespace transforms
+}  // namespace sound_feature_extraction
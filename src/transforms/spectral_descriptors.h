@@ -0,0 +1,190 @@
+/*! @file spectral_descriptors.h
+ *  @brief Spectral descriptors calculated in a single pass.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#ifndef SRC_TRANSFORMS_SPECTRAL_DESCRIPTORS_H_
+#define SRC_TRANSFORMS_SPECTRAL_DESCRIPTORS_H_
+
+#include <set>
+#include "src/formats/single_format.h"
+#include "src/struct_of_arrays_transform.h"
+#include "src/transforms/common.h"
+
+namespace sound_feature_extraction {
+namespace transforms {
+
+enum SpectralDescriptor {
+  kSpectralDescriptorCentroid = 0,
+  kSpectralDescriptorRolloff,
+  kSpectralDescriptorFlux,
+  kSpectralDescriptorEnergy,
+  kSpectralDescriptorCount
+};
+
+namespace internal {
+constexpr const char* kSpectralDescriptorCentroidStr = "centroid";
+constexpr const char* kSpectralDescriptorRolloffStr = "rolloff";
+constexpr const char* kSpectralDescriptorFluxStr = "flux";
+constexpr const char* kSpectralDescriptorEnergyStr = "energy";
+
+constexpr const char* kSpectralDescriptorStrs[kSpectralDescriptorCount] {
+  kSpectralDescriptorCentroidStr, kSpectralDescriptorRolloffStr,
+  kSpectralDescriptorFluxStr, kSpectralDescriptorEnergyStr
+};
+}
+
+SpectralDescriptor Parse(const std::string& value,
+                         identity<SpectralDescriptor>);
+
+std::set<SpectralDescriptor> Parse(const std::string& value,
+                                   identity<std::set<SpectralDescriptor>>);
+
+}  // namespace transforms
+}  // namespace sound_feature_extraction
+
+namespace std {
+  inline string to_string(
+      const sound_feature_extraction::transforms::SpectralDescriptor& value)
+      noexcept {
+    return sound_feature_extraction::transforms::internal::
+        kSpectralDescriptorStrs[value];
+  }
+
+  inline string to_string(
+      const set<sound_feature_extraction::transforms::SpectralDescriptor>&
+          value) noexcept {
+    string res;
+    for (auto descriptor : value) {
+      res += to_string(descriptor) + " ";
+    }
+    return res.empty()? "" : res.substr(0, res.size() - 1);
+  }
+}  // namespace std
+
+namespace sound_feature_extraction {
+namespace transforms {
+
+typedef formats::FixedArray<kSpectralDescriptorCount> SpectralDescriptorsArray;
+
+/// @brief Calculates the values of Centroid, Rolloff, Flux and Energy
+/// of each buffer at once.
+/// @details A single pass over a buffer yields the sums which Centroid and
+/// Energy need, the total of Rolloff and the maximum which Flux normalizes
+/// by, so the buffer is read once, plus the leading part of it for Rolloff
+/// while it is still in the cache and once more together with the previous
+/// buffer for Flux. TransformTree::FuseTransforms() substitutes the sibling
+/// single-valued transforms with this one followed by DescriptorSelector-s.
+class SpectralDescriptors
+    : public OmpAwareTransform<formats::ArrayFormatF,
+                               formats::SingleFormat<SpectralDescriptorsArray>>,
+      public StructOfArraysTransform {
+ public:
+  SpectralDescriptors();
+
+  TRANSFORM_INTRO("SpectralDescriptors",
+                  "Calculates the spectral centroid, rolloff, flux and energy "
+                  "in a single pass.",
+                  SpectralDescriptors)
+
+  TP(descriptors, std::set<SpectralDescriptor>, kDefaultDescriptors(),
+     "Descriptors to calculate (names separated with spaces), the rest are "
+     "set to zero.")
+  TP(ratio, float, kDefaultRatio,
+     "The ratio between the partial sum and the whole sum of the rolloff.")
+
+  /// @brief Flux relates the adjacent buffers.
+  virtual bool BufferInvariant() const noexcept override;
+
+  virtual bool SupportsSoAOutput() const noexcept override;
+
+  virtual InstructionSet SimdInstructionSet() const noexcept override;
+
+  /// @brief The results of a single pass over a buffer.
+  struct Sums {
+    float Sum;
+    /// @brief \f$\displaystyle\sum_{f}{f Value[f]}\f$.
+    float Weighted;
+    float Squares;
+    float Max;
+  };
+
+  static Sums Calculate(bool simd, const float* input, int length) noexcept;
+
+  /// @brief Returns the same index as Rolloff, given the threshold which
+  /// is ratio times the sum.
+  static int Rolloff(bool simd, const float* input, int length,
+                     float threshold) noexcept;
+
+  /// @brief Returns the same value as Flux, given the maxima of the both
+  /// buffers.
+  static float Flux(bool simd, const float* input, const float* prev,
+                    int length, float maxInput, float maxPrev) noexcept;
+
+ protected:
+  virtual void Do(const InBuffers& in, OutBuffers* out)
+      const noexcept override;
+
+  static std::set<SpectralDescriptor> kDefaultDescriptors() noexcept {
+    return { kSpectralDescriptorCentroid, kSpectralDescriptorRolloff,
+             kSpectralDescriptorFlux, kSpectralDescriptorEnergy };
+  }
+
+  static constexpr float kDefaultRatio = 0.85f;
+};
+
+/// @brief Picks a single value of SpectralDescriptors.
+class DescriptorSelector
+    : public TransformBase<formats::SingleFormat<SpectralDescriptorsArray>,
+                           formats::SingleFormatF>,
+      public StructOfArraysTransform {
+ public:
+  DescriptorSelector();
+
+  TRANSFORM_INTRO("DescriptorSelector",
+                  "Picks one of the values calculated by SpectralDescriptors.",
+                  DescriptorSelector)
+
+  TP(descriptor, SpectralDescriptor, kDefaultDescriptor,
+     "The picked value: \"centroid\", \"rolloff\", \"flux\" or \"energy\".")
+
+  virtual bool SupportsSoAInput() const noexcept override;
+
+ protected:
+  virtual void Do(const InBuffers& in, OutBuffers* out)
+      const noexcept override;
+
+  static constexpr SpectralDescriptor kDefaultDescriptor =
+      kSpectralDescriptorCentroid;
+};
+
+}  // namespace transforms
+}  // namespace sound_feature_extraction
+
+#endif  // SRC_TRANSFORMS_SPECTRAL_DESCRIPTORS_H_
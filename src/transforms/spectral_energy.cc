@@ -30,27 +30,57 @@
 
 #include "src/transforms/spectral_energy.h"
 #include <cmath>
+#include <cstring>
 #include <simd/instruction_set.h>
+#include "src/fixed_length.h"
+#include "src/transforms/unpack_rdft.h"
 
 namespace sound_feature_extraction {
 namespace transforms {
 
+constexpr bool SpectralEnergy::kDefaultUnpacked;
+
+SpectralEnergy::SpectralEnergy()
+    : unpacked_(kDefaultUnpacked), kernel_(Do) {
+}
+
+ALWAYS_VALID_TP(SpectralEnergy, unpacked)
+
 size_t SpectralEnergy::OnFormatChanged(size_t buffersCount) {
   if (input_format_->Size() % 2 == 1) {
     WRN("Input buffer size is odd (%zu), truncated\n",
         input_format_->Size());
   }
-  output_format_->SetSize(input_format_->Size() / 2);
+  if (unpacked_) {
+    output_format_->SetSize(input_format_->Size() / 2 * 2 - 2);
+  } else {
+    output_format_->SetSize(input_format_->Size() / 2);
+  }
   return buffersCount;
 }
 
 void SpectralEnergy::Do(const float* in,
                         float* out) const noexcept {
-  Do(use_simd(), in, input_format_->Size(), out);
+  size_t size = output_format_->Size();
+  // The aligned loads and stores need the multiples of 8 bins
+  auto used = used_elements_.Align(size, 8);
+  if (!unpacked_ && (used.Begin > 0 || used.End < size)) {
+    Do(use_simd(), in + used.Begin * 2, (used.End - used.Begin) * 2,
+       out + used.Begin);
+    memset(out, 0, used.Begin * sizeof(float));
+    memset(out + used.End, 0, (size - used.End) * sizeof(float));
+    return;
+  }
+  kernel_(use_simd(), in, input_format_->Size(), out);
+  if (unpacked_) {
+    UnpackRDFT::Mirror(out, output_format_->Size());
+  }
 }
 
-void SpectralEnergy::Do(bool simd, const float* input, int length,
-                float* output) noexcept {
+template <int kLength>
+static void SpectralEnergyKernel(bool simd, const float* input, int length,
+                                 float* output) {
+  length = FIXED_LENGTH(kLength, length);
   if (simd) {
 #ifdef __AVX__
     for (int j = 0; j < length - 15; j += 16) {
@@ -97,6 +127,18 @@ void SpectralEnergy::Do(bool simd, const float* input, int length,
   }
 }
 
+void SpectralEnergy::Do(bool simd, const float* input, int length,
+                        float* output) noexcept {
+  SpectralEnergyKernel<0>(simd, input, length, output);
+}
+
+void SpectralEnergy::Initialize() const {
+  kernel_ = [](int length) -> Kernel {
+    SELECT_FIXED_LENGTH(SpectralEnergyKernel, length)
+  }(input_format_->Size());
+}
+
+RTP(SpectralEnergy, unpacked)
 REGISTER_TRANSFORM(SpectralEnergy);
 
 }  // namespace transforms
@@ -38,13 +38,27 @@ namespace transforms {
 
 class SpectralEnergy : public OmpUniformFormatTransform<formats::ArrayFormatF>,
       public TransformLogger<SpectralEnergy> {
+  friend class PowerSpectrum;
+  friend class MultiResolutionSpectrum;
  public:
+  SpectralEnergy();
+
   TRANSFORM_INTRO("SpectralEnergy",
                   "Calculates the squared magnitude of each complex number, "
                   "that is, the sum of squared real and imaginary parts.",
                   SpectralEnergy)
 
+  TP(unpacked, bool, kDefaultUnpacked,
+     "The input is the packed RDFT spectrum and the energies "
+     "of the whole spectrum are calculated, as if UnpackRDFT was applied "
+     "before.")
+
+  /// @brief Picks the kernel specialized for the input length, if any.
+  virtual void Initialize() const override;
+
  protected:
+  static constexpr bool kDefaultUnpacked = false;
+
   virtual size_t OnFormatChanged(size_t buffersCount) override;
 
   virtual void Do(const float* in,
@@ -52,6 +66,12 @@ class SpectralEnergy : public OmpUniformFormatTransform<formats::ArrayFormatF>,
 
   static void Do(bool simd, const float* input, int length,
                  float* output) noexcept;
+
+ private:
+  typedef void (*Kernel)(bool simd, const float* input, int length,
+                         float* output);
+
+  mutable Kernel kernel_;
 };
 
 }  // namespace transforms
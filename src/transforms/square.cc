@@ -30,6 +30,11 @@
 
 #include "src/transforms/square.h"
 #include <simd/arithmetic-inl.h>
+#ifdef SIMD_X86
+#include <immintrin.h>
+#elif defined(SIMD_NEON)
+#include <arm_neon.h>
+#endif
 
 namespace sound_feature_extraction {
 namespace transforms {
@@ -38,13 +43,79 @@ void Square::Do(const float* in, float* out) const noexcept {
   Do(use_simd(), in, output_format_->Size(), out);
 }
 
+void Square::DoElementwise(const float* in, int length,
+                           float* out) const noexcept {
+  Do(use_simd(), in, length, out);
+}
+
+typedef void (*SquareKernel)(const float* input, int length, float* output);
+
+static void SquareScalar(const float* input, int length, float* output) {
+  for (int i = 0; i < length; i++) {
+    output[i] = input[i] * input[i];
+  }
+}
+
+#ifdef SIMD_X86
+SIMD_TARGET("avx")
+static void SquareAVX(const float* input, int length, float* output) {
+  int i = 0;
+  for (; i < length - 7; i += 8) {
+    __m256 vec = _mm256_loadu_ps(input + i);
+    _mm256_storeu_ps(output + i, _mm256_mul_ps(vec, vec));
+  }
+  SquareScalar(input + i, length - i, output + i);
+}
+
+SIMD_TARGET_AVX512
+static void SquareAVX512(const float* input, int length, float* output) {
+  int i = 0;
+  for (; i < length - 15; i += 16) {
+    __m512 vec = _mm512_loadu_ps(input + i);
+    _mm512_storeu_ps(output + i, _mm512_mul_ps(vec, vec));
+  }
+  __mmask16 tail = (1u << (length - i)) - 1;
+  __m512 vec = _mm512_maskz_loadu_ps(tail, input + i);
+  _mm512_mask_storeu_ps(output + i, tail, _mm512_mul_ps(vec, vec));
+}
+#elif defined(SIMD_NEON)
+static void SquareNEON(const float* input, int length, float* output) {
+  int i = 0;
+  for (; i < length - 7; i += 8) {
+    float32x4_t lo = vld1q_f32(input + i);
+    float32x4_t hi = vld1q_f32(input + i + 4);
+    vst1q_f32(output + i, vmulq_f32(lo, lo));
+    vst1q_f32(output + i + 4, vmulq_f32(hi, hi));
+  }
+  SquareScalar(input + i, length - i, output + i);
+}
+#endif
+
+static const SimdKernel<SquareKernel> kSquareKernels[] {
+#ifdef SIMD_X86
+  { InstructionSet::kAVX512, SquareAVX512 },
+  { InstructionSet::kAVX, SquareAVX },
+#elif defined(SIMD_NEON)
+  { InstructionSet::kNEON, SquareNEON },
+#endif
+  { InstructionSet::kScalar, SquareScalar }
+};
+
 void Square::Do(bool simd, const float* input, int length,
                 float* output) noexcept {
-  if (simd) {
-    real_multiply_array(input, input, length, output);
-  } else {
-    real_multiply_array_na(input, input, length, output);
+  if (!simd) {
+    SquareScalar(input, length, output);
+    return;
   }
+  SimdAware::Dispatch(kSquareKernels).Function(input, length, output);
+}
+
+InstructionSet Square::SimdInstructionSet() const noexcept {
+  return SimdAware::Dispatch(kSquareKernels).Isa;
+}
+
+bool Square::InPlace() const noexcept {
+  return true;
 }
 
 void SquareInverse::Do(const float* in UNUSED,
@@ -31,17 +31,26 @@
 #ifndef SRC_TRANSFORMS_SQUARE_H_
 #define SRC_TRANSFORMS_SQUARE_H_
 
+#include "src/elementwise_transform.h"
 #include "src/transforms/common.h"
 
 namespace sound_feature_extraction {
 namespace transforms {
 
-class Square : public OmpUniformFormatTransform<formats::ArrayFormatF> {
+class Square : public OmpUniformFormatTransform<formats::ArrayFormatF>,
+               public ElementwiseTransform {
  public:
   TRANSFORM_INTRO("Square", "Squares the signal (window floating point "
                             "format).",
                   Square)
 
+  virtual void DoElementwise(const float* in, int length,
+                             float* out) const noexcept override;
+
+  virtual InstructionSet SimdInstructionSet() const noexcept override;
+
+  virtual bool InPlace() const noexcept override;
+
  protected:
   virtual void Do(const float* in, float* out) const noexcept override;
 
@@ -29,12 +29,15 @@
  */
 
 #include "src/transforms/stats.h"
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wold-style-cast"
-#include <boost/regex.hpp>
-#pragma GCC diagnostic pop
+#include <algorithm>
+#include <cassert>
 #include <cmath>
-#include <simd/instruction_set.h>
+#include <limits>
+#ifdef SIMD_X86
+#include <immintrin.h>
+#elif defined(SIMD_NEON)
+#include <arm_neon.h>
+#endif
 
 namespace sound_feature_extraction {
 namespace transforms {
@@ -48,9 +51,8 @@ std::set<StatsType> Parse(const std::string& value,
     { internal::kStatsTypeKurtosisStr, kStatsTypeKurtosis }
   };
 
-  static const boost::regex all_regex("^\\s*(\\w+\\s*(\\s|$))+");
-  boost::smatch match;
-  if (!boost::regex_match(value, match, all_regex)) {
+  std::vector<std::string> words;
+  if (!SplitWords(value, &words)) {
     throw InvalidParameterValueException();
   }
 
@@ -59,29 +61,16 @@ std::set<StatsType> Parse(const std::string& value,
              kStatsTypeKurtosis };
   }
   std::set<StatsType> ret;
-  std::transform(boost::sregex_token_iterator(value.begin(), value.end(),
-                                            boost::regex("\\s*(\\w+)\\s*"),
-                                            1),
-                 boost::sregex_token_iterator(),
-                 std::inserter(ret, ret.begin()),
-                 [](const std::string& subval) {
-    auto stit = map.find(subval);
+  for (auto& word : words) {
+    auto stit = map.find(word);
     if (stit == map.end()) {
       throw InvalidParameterValueException();
     }
-    return stit->second;
-  });
-
+    ret.insert(stit->second);
+  }
   return ret;
 }
 
-const std::unordered_map<int, Stats::CalculateFunc> Stats::kStatsFuncs {
-  { kStatsTypeAverage, Stats::CalculateAverage },
-  { kStatsTypeStdDeviation, Stats::CalculateStdDeviation },
-  { kStatsTypeSkewness, Stats::CalculateSkewness },
-  { kStatsTypeKurtosis, Stats::CalculateKurtosis }
-};
-
 Stats::Stats()
     : types_(kDefaultStatsTypes()),
       interval_(kDefaultInterval),
@@ -123,189 +112,442 @@ size_t Stats::OnInputFormatChanged(size_t buffersCount) {
   return buffersCount;
 }
 
+void Stats::ResetState() const noexcept {
+  std::lock_guard<std::mutex> lock(stream_moments_mutex_);
+  stream_moments_.clear();
+}
+
 void Stats::Do(const float* in, float* out) const noexcept {
-  float rawMoments[kStatsTypeCount];
+  int order = Order();
+  CentralMoments moments;
   if (interval_ == 0) {
-    CalculateRawMoments(true, in, 0, input_format_->Size(), rawMoments);
-    Calculate(rawMoments, out);
+    CalculateMoments(use_simd(), in, input_format_->Size(), order, &moments);
+    if (streaming()) {
+      std::lock_guard<std::mutex> lock(stream_moments_mutex_);
+      auto& total = stream_moments_[in];
+      total.Merge(moments, order);
+      moments = total;
+    }
+    Calculate(moments, out);
   } else {
     size_t i;
     size_t step = interval_ - overlap_;
     for (i = 0; i < input_format_->Size() - interval_ + 1; i += step) {
-      CalculateRawMoments(true, in, i, interval_, rawMoments);
-      Calculate(rawMoments, out + i / step * types_.size());
+      CalculateMoments(use_simd(), in + i, interval_, order, &moments);
+      Calculate(moments, out + i / step * types_.size());
     }
     if ((input_format_->Size() - interval_) % step != 0) {
       int index = input_format_->Size() - interval_;
-      CalculateRawMoments(true, in, index, interval_, rawMoments);
-      Calculate(rawMoments, out + i / step * types_.size());
+      CalculateMoments(use_simd(), in + index, interval_, order, &moments);
+      Calculate(moments, out + i / step * types_.size());
     }
   }
 }
 
-void Stats::Calculate(const float* rawMoments, float* out) const noexcept {
+int Stats::Order() const noexcept {
+  int order = 1;
+  if (!types_.empty()) {
+    int last = *types_.rbegin();
+    while (last >>= 1) {
+      order++;
+    }
+  }
+  return order;
+}
+
+void Stats::Calculate(const CentralMoments& moments, float* out)
+    const noexcept {
+  double u2 = std::max(moments.M2 / moments.Count, 0.);
+  // Float inputs cannot represent a smaller relative deviation, so such
+  // a variance is the rounding noise of a constant sample
+  constexpr double eps = std::numeric_limits<float>::epsilon();
+  bool constant = u2 <= eps * eps * moments.Mean * moments.Mean;
   for (auto stat : types_) {
-    int sind = 0;
-    int istat = stat;
-    while (istat >>= 1) {
-      sind++;
+    switch (stat) {
+      case kStatsTypeAverage:
+        *out = moments.Mean;
+        break;
+      case kStatsTypeStdDeviation:
+        *out = constant? 0 : sqrt(u2);
+        break;
+      case kStatsTypeSkewness:
+        *out = constant? 0 : moments.M3 / moments.Count / (sqrt(u2) * u2);
+        break;
+      case kStatsTypeKurtosis:
+        *out = constant? -2 : moments.M4 / moments.Count / (u2 * u2) - 3;
+        break;
+      default:
+        break;
     }
-    out[sind] = kStatsFuncs.find(stat)->second(rawMoments);
+    out++;
   }
 }
 
-void Stats::CalculateRawMoments(bool simd, const float* in, int startIndex,
-                                int length, float* rawMoments) noexcept {
-  float avg1 = 0, avg2 = 0, avg3 = 0, avg4 = 0;
-  auto end_index = startIndex + length;
-  if (simd) {
-#ifdef __AVX__
-    __m256 avg1vec = _mm256_setzero_ps();
-    __m256 avg2vec = _mm256_setzero_ps();
-    __m256 avg3vec = _mm256_setzero_ps();
-    __m256 avg4vec = _mm256_setzero_ps();
-    for (int i = startIndex; i < end_index - 7; i+=8) {
-      __m256 val = _mm256_loadu_ps(in + i);
-      avg1vec = _mm256_add_ps(avg1vec, val);
-      __m256 val2 = _mm256_mul_ps(val, val);
-      avg2vec = _mm256_add_ps(avg2vec, val2);
-      val = _mm256_mul_ps(val2, val);
-      avg3vec = _mm256_add_ps(avg3vec, val);
-      val2 = _mm256_mul_ps(val2, val2);
-      avg4vec = _mm256_add_ps(avg4vec, val2);
+void CentralMoments::Merge(const CentralMoments& other, int order) noexcept {
+  if (other.Count == 0) {
+    return;
+  }
+  if (Count == 0) {
+    *this = other;
+    return;
+  }
+  double na = Count, nb = other.Count, n = na + nb;
+  double delta = other.Mean - Mean;
+  double delta_n = delta / n;
+  if (order > 3) {
+    M4 += other.M4 +
+        delta * delta_n * delta_n * delta_n * na * nb *
+            (na * na - na * nb + nb * nb) +
+        6 * delta_n * delta_n * (na * na * other.M2 + nb * nb * M2) +
+        4 * delta_n * (na * other.M3 - nb * M3);
+  }
+  if (order > 2) {
+    M3 += other.M3 + delta * delta_n * delta_n * na * nb * (na - nb) +
+        3 * delta_n * (na * other.M2 - nb * M2);
+  }
+  M2 += other.M2 + delta * delta_n * na * nb;
+  Mean += delta_n * nb;
+  Count = n;
+}
+
+/// @brief Calculates the average of a block and the sums of the first four
+/// powers of the deviations from it. The third and the fourth sums are
+/// left zero if order is less than 3.
+/// @param sums The average followed by the four sums.
+typedef void (*BlockMomentsKernel)(const float* in, int length, int order,
+                                   double* sums);
+
+/// @brief Adds the deviations of in[begin, length) from center to sums.
+static void AccumulateTail(const float* in, int begin, int length,
+                           int order, float center, double* sums) {
+  for (int i = begin; i < length; i++) {
+    double d = in[i] - center;
+    double d2 = d * d;
+    sums[1] += d;
+    sums[2] += d2;
+    if (order > 2) {
+      sums[3] += d2 * d;
+      sums[4] += d2 * d2;
     }
-    avg1vec = _mm256_hadd_ps(avg1vec, avg1vec);
-    avg1vec = _mm256_hadd_ps(avg1vec, avg1vec);
-    avg1 += _mm256_get_ps(avg1vec, 0);
-    avg1 += _mm256_get_ps(avg1vec, 4);
-    avg2vec = _mm256_hadd_ps(avg2vec, avg2vec);
-    avg2vec = _mm256_hadd_ps(avg2vec, avg2vec);
-    avg2 += _mm256_get_ps(avg2vec, 0);
-    avg2 += _mm256_get_ps(avg2vec, 4);
-    avg3vec = _mm256_hadd_ps(avg3vec, avg3vec);
-    avg3vec = _mm256_hadd_ps(avg3vec, avg3vec);
-    avg3 += _mm256_get_ps(avg3vec, 0);
-    avg3 += _mm256_get_ps(avg3vec, 4);
-    avg4vec = _mm256_hadd_ps(avg4vec, avg4vec);
-    avg4vec = _mm256_hadd_ps(avg4vec, avg4vec);
-    avg4 += _mm256_get_ps(avg4vec, 0);
-    avg4 += _mm256_get_ps(avg4vec, 4);
-    for (int i = ((end_index) & ~0x7); i < end_index; i++) {
-      float v = in[i];
-      avg1 += v;
-      float v2 = v * v;
-      avg2 += v2;
-      v *= v2;
-      avg3 += v;
-      v2 *= v2;
-      avg4 += v2;
+  }
+}
+
+/// @brief Adds the vector lanes of the four sums to sums in double precision.
+static void ReduceLanes(const float* lanes, int count, double* sums) {
+  for (int k = 0; k < 4; k++) {
+    for (int l = 0; l < count; l++) {
+      sums[k + 1] += lanes[k * count + l];
+    }
+  }
+}
+
+static void BlockMomentsScalar(const float* in, int length, int order,
+                               double* sums) {
+  float center = 0;
+  for (int i = 0; i < length; i++) {
+    center += in[i];
+  }
+  center /= length;
+  float s[4] {};
+  for (int i = 0; i < length; i++) {
+    float d = in[i] - center;
+    float d2 = d * d;
+    s[0] += d;
+    s[1] += d2;
+    if (order > 2) {
+      s[2] += d2 * d;
+      s[3] += d2 * d2;
+    }
+  }
+  sums[0] = center;
+  for (int k = 0; k < 4; k++) {
+    sums[k + 1] = s[k];
+  }
+}
+
+#ifdef SIMD_X86
+SIMD_TARGET("avx")
+static void BlockMomentsAVX(const float* in, int length, int order,
+                            double* sums) {
+  int vectorized = length & ~7;
+  float lanes[32];
+  __m256 sum = _mm256_setzero_ps();
+  for (int i = 0; i < vectorized; i += 8) {
+    sum = _mm256_add_ps(sum, _mm256_loadu_ps(in + i));
+  }
+  _mm256_storeu_ps(lanes, sum);
+  float center = 0;
+  for (int l = 0; l < 8; l++) {
+    center += lanes[l];
+  }
+  for (int i = vectorized; i < length; i++) {
+    center += in[i];
+  }
+  center /= length;
+  __m256 c = _mm256_set1_ps(center);
+  __m256 s1 = _mm256_setzero_ps(), s2 = _mm256_setzero_ps();
+  __m256 s3 = _mm256_setzero_ps(), s4 = _mm256_setzero_ps();
+  if (order > 2) {
+    for (int i = 0; i < vectorized; i += 8) {
+      __m256 d = _mm256_sub_ps(_mm256_loadu_ps(in + i), c);
+      __m256 d2 = _mm256_mul_ps(d, d);
+      s1 = _mm256_add_ps(s1, d);
+      s2 = _mm256_add_ps(s2, d2);
+      s3 = _mm256_add_ps(s3, _mm256_mul_ps(d2, d));
+      s4 = _mm256_add_ps(s4, _mm256_mul_ps(d2, d2));
     }
   } else {
-#elif defined(__ARM_NEON__)
-    float32x4_t avg1vec = vdupq_n_f32(0);
-    float32x4_t avg2vec = vdupq_n_f32(0);
-    float32x4_t avg3vec = vdupq_n_f32(0);
-    float32x4_t avg4vec = vdupq_n_f32(0);
-    for (int i = startIndex; i < end_index - 3; i+=4) {
-      float32x4_t val = vld1q_f32(in + i);
-      avg1vec = vaddq_f32(avg1vec, val);
-      float32x4_t val2 = vmulq_f32(val, val);
-      avg2vec = vaddq_f32(avg2vec, val2);
-      val = vmulq_f32(val2, val);
-      avg3vec = vaddq_f32(avg3vec, val);
-      val2 = vmulq_f32(val2, val2);
-      avg4vec = vaddq_f32(avg4vec, val2);
+    for (int i = 0; i < vectorized; i += 8) {
+      __m256 d = _mm256_sub_ps(_mm256_loadu_ps(in + i), c);
+      s1 = _mm256_add_ps(s1, d);
+      s2 = _mm256_add_ps(s2, _mm256_mul_ps(d, d));
     }
-    avg1 += vgetq_lane_f32(avg1vec, 0);
-    avg1 += vgetq_lane_f32(avg1vec, 1);
-    avg1 += vgetq_lane_f32(avg1vec, 2);
-    avg1 += vgetq_lane_f32(avg1vec, 3);
-    avg2 += vgetq_lane_f32(avg2vec, 0);
-    avg2 += vgetq_lane_f32(avg2vec, 1);
-    avg2 += vgetq_lane_f32(avg2vec, 2);
-    avg2 += vgetq_lane_f32(avg2vec, 3);
-    avg3 += vgetq_lane_f32(avg3vec, 0);
-    avg3 += vgetq_lane_f32(avg3vec, 1);
-    avg3 += vgetq_lane_f32(avg3vec, 2);
-    avg3 += vgetq_lane_f32(avg3vec, 3);
-    avg4 += vgetq_lane_f32(avg4vec, 0);
-    avg4 += vgetq_lane_f32(avg4vec, 1);
-    avg4 += vgetq_lane_f32(avg4vec, 2);
-    avg4 += vgetq_lane_f32(avg4vec, 3);
-    for (int i = ((end_index) & ~0x3); i < end_index; i++) {
-      float v = in[i];
-      avg1 += v;
-      float v2 = v * v;
-      avg2 += v2;
-      v *= v2;
-      avg3 += v;
-      v2 *= v2;
-      avg4 += v2;
+  }
+  _mm256_storeu_ps(lanes, s1);
+  _mm256_storeu_ps(lanes + 8, s2);
+  _mm256_storeu_ps(lanes + 16, s3);
+  _mm256_storeu_ps(lanes + 24, s4);
+  sums[0] = center;
+  sums[1] = sums[2] = sums[3] = sums[4] = 0;
+  ReduceLanes(lanes, 8, sums);
+  AccumulateTail(in, vectorized, length, order, center, sums);
+}
+
+SIMD_TARGET_AVX512
+static void BlockMomentsAVX512(const float* in, int length, int order,
+                               double* sums) {
+  int vectorized = length & ~15;
+  float lanes[64];
+  __m512 sum = _mm512_setzero_ps();
+  for (int i = 0; i < vectorized; i += 16) {
+    sum = _mm512_add_ps(sum, _mm512_loadu_ps(in + i));
+  }
+  float center = _mm512_reduce_add_ps(sum);
+  for (int i = vectorized; i < length; i++) {
+    center += in[i];
+  }
+  center /= length;
+  __m512 c = _mm512_set1_ps(center);
+  __m512 s1 = _mm512_setzero_ps(), s2 = _mm512_setzero_ps();
+  __m512 s3 = _mm512_setzero_ps(), s4 = _mm512_setzero_ps();
+  if (order > 2) {
+    for (int i = 0; i < vectorized; i += 16) {
+      __m512 d = _mm512_sub_ps(_mm512_loadu_ps(in + i), c);
+      __m512 d2 = _mm512_mul_ps(d, d);
+      s1 = _mm512_add_ps(s1, d);
+      s2 = _mm512_add_ps(s2, d2);
+      s3 = _mm512_fmadd_ps(d2, d, s3);
+      s4 = _mm512_fmadd_ps(d2, d2, s4);
     }
   } else {
-#else
-  } {
-#endif
-    for (int i = startIndex; i < end_index; i++) {
-      float v = in[i];
-      avg1 += v;
-      float v2 = v * v;
-      avg2 += v2;
-      v *= v2;
-      avg3 += v;
-      v2 *= v2;
-      avg4 += v2;
+    for (int i = 0; i < vectorized; i += 16) {
+      __m512 d = _mm512_sub_ps(_mm512_loadu_ps(in + i), c);
+      s1 = _mm512_add_ps(s1, d);
+      s2 = _mm512_fmadd_ps(d, d, s2);
+    }
+  }
+  _mm512_storeu_ps(lanes, s1);
+  _mm512_storeu_ps(lanes + 16, s2);
+  _mm512_storeu_ps(lanes + 32, s3);
+  _mm512_storeu_ps(lanes + 48, s4);
+  sums[0] = center;
+  sums[1] = sums[2] = sums[3] = sums[4] = 0;
+  ReduceLanes(lanes, 16, sums);
+  AccumulateTail(in, vectorized, length, order, center, sums);
+}
+#elif defined(SIMD_NEON)
+static void BlockMomentsNEON(const float* in, int length, int order,
+                             double* sums) {
+  int vectorized = length & ~3;
+  float lanes[16];
+  float32x4_t sum = vdupq_n_f32(0);
+  for (int i = 0; i < vectorized; i += 4) {
+    sum = vaddq_f32(sum, vld1q_f32(in + i));
+  }
+  vst1q_f32(lanes, sum);
+  float center = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+  for (int i = vectorized; i < length; i++) {
+    center += in[i];
+  }
+  center /= length;
+  float32x4_t c = vdupq_n_f32(center);
+  float32x4_t s1 = vdupq_n_f32(0), s2 = vdupq_n_f32(0);
+  float32x4_t s3 = vdupq_n_f32(0), s4 = vdupq_n_f32(0);
+  for (int i = 0; i < vectorized; i += 4) {
+    float32x4_t d = vsubq_f32(vld1q_f32(in + i), c);
+    float32x4_t d2 = vmulq_f32(d, d);
+    s1 = vaddq_f32(s1, d);
+    s2 = vaddq_f32(s2, d2);
+    if (order > 2) {
+      s3 = vmlaq_f32(s3, d2, d);
+      s4 = vmlaq_f32(s4, d2, d2);
     }
   }
-  avg1 /= length;
-  avg2 /= length;
-  avg3 /= length;
-  avg4 /= length;
-  rawMoments[0] = avg1;
-  rawMoments[1] = avg2;
-  rawMoments[2] = avg3;
-  rawMoments[3] = avg4;
+  vst1q_f32(lanes, s1);
+  vst1q_f32(lanes + 4, s2);
+  vst1q_f32(lanes + 8, s3);
+  vst1q_f32(lanes + 12, s4);
+  sums[0] = center;
+  sums[1] = sums[2] = sums[3] = sums[4] = 0;
+  ReduceLanes(lanes, 4, sums);
+  AccumulateTail(in, vectorized, length, order, center, sums);
 }
+#endif
 
-float Stats::CalculateAverage(const float* rawMoments) noexcept {
-  return rawMoments[0];
+static const SimdKernel<BlockMomentsKernel> kBlockMomentsKernels[] {
+#ifdef SIMD_X86
+  { InstructionSet::kAVX512, BlockMomentsAVX512 },
+  { InstructionSet::kAVX, BlockMomentsAVX },
+#elif defined(SIMD_NEON)
+  { InstructionSet::kNEON, BlockMomentsNEON },
+#endif
+  { InstructionSet::kScalar, BlockMomentsScalar }
+};
+
+/// @brief Calculates the moments of a block from the average and the sums
+/// of the powers of the deviations the kernels return.
+static CentralMoments BlockMoments(int n, const double* sums) noexcept {
+  // Move the moments from the float average to the exact one
+  double e = sums[1] / n;
+  CentralMoments block;
+  block.Count = n;
+  block.Mean = sums[0] + e;
+  block.M2 = sums[2] - n * e * e;
+  block.M3 = sums[3] - 3 * e * sums[2] + 2 * n * e * e * e;
+  block.M4 = sums[4] - 4 * e * sums[3] + 6 * e * e * sums[2] -
+      3 * n * e * e * e * e;
+  return block;
 }
 
-float Stats::CalculateStdDeviation(const float* rawMoments) noexcept {
-  auto value = rawMoments[1] - rawMoments[0] * rawMoments[0];
-  if (value < 0) {
-    return 0;
-  }
-  value = sqrtf(value);
-  return value;
+InstructionSet Stats::SimdInstructionSet() const noexcept {
+  return SimdAware::Dispatch(kBlockMomentsKernels).Isa;
 }
 
-float Stats::CalculateSkewness(const float* rawMoments) noexcept {
-  float avg1 = rawMoments[0];
-  float avg2 = rawMoments[1];
-  float avg3 = rawMoments[2];
-  double u2 = avg2 - avg1 * avg1;
-  if (u2 <= 0) {
-    return 0;
+void Stats::CalculateMoments(bool simd, const float* in, int length,
+                             int order, CentralMoments* moments) noexcept {
+  auto kernel = simd? SimdAware::Dispatch(kBlockMomentsKernels).Function
+                    : BlockMomentsScalar;
+  *moments = CentralMoments();
+  for (int offset = 0; offset < length; offset += kBlockSize) {
+    int n = std::min(kBlockSize, length - offset);
+    double sums[5];
+    kernel(in + offset, n, order, sums);
+    moments->Merge(BlockMoments(n, sums), order);
   }
-  double u3 = avg3 - 3 * avg2 * avg1 + 2 * avg1 * avg1 * avg1;
-  auto value = u3 / (sqrt(u2) * u2);
-  return value;
 }
 
-float Stats::CalculateKurtosis(const float* rawMoments) noexcept {
-  float avg1 = rawMoments[0];
-  float avg2 = rawMoments[1];
-  float avg3 = rawMoments[2];
-  float avg4 = rawMoments[3];
-  double u2 = avg2 - avg1 * avg1;
-  if (u2 == 0) {
-    return -2.f;
+constexpr int RotatedStats::kStripSize;
+
+RotatedStats::RotatedStats(const std::shared_ptr<Transform>& stats)
+    : stats_(std::dynamic_pointer_cast<Stats>(stats)) {
+  assert(stats_);
+}
+
+size_t RotatedStats::OnFormatChanged(size_t buffersCount) {
+  // Stats receives a buffer per column with a value per row
+  auto rotated = std::make_shared<formats::ArrayFormatF>(*input_format_);
+  rotated->SetSize(buffersCount);
+  stats_->SetInputFormat(rotated, input_format_->Size());
+  output_format_->SetSize(stats_->output_format_->Size());
+  return input_format_->Size();
+}
+
+void RotatedStats::Initialize() const {
+  stats_->Initialize();
+  stream_moments_.resize(input_format_->Size());
+}
+
+void RotatedStats::ResetState() const noexcept {
+  std::fill(stream_moments_.begin(), stream_moments_.end(),
+            CentralMoments());
+}
+
+void RotatedStats::Do(const BuffersBase<float*>& in,
+                      BuffersBase<float*>* out) const noexcept {
+  int columns = input_format_->Size();
+  int rows = in.Count();
+  int order = stats_->Order();
+  int interval = stats_->interval();
+  int types = stats_->types().size();
+  int strips = (columns + kStripSize - 1) / kStripSize;
+  this->ParallelFor(strips, [&](size_t begin, size_t end) {
+    CentralMoments moments[kStripSize];
+    for (size_t s = begin; s < end; s++) {
+      int column = s * kStripSize;
+      int width = std::min(kStripSize, columns - column);
+      if (interval == 0) {
+        CalculateMoments(in, 0, rows, column, width, moments);
+        for (int c = 0; c < width; c++) {
+          if (streaming()) {
+            // Each column belongs to a single thread
+            auto& total = stream_moments_[column + c];
+            total.Merge(moments[c], order);
+            moments[c] = total;
+          }
+          stats_->Calculate(moments[c], (*out)[column + c]);
+        }
+        continue;
+      }
+      int step = interval - stats_->overlap();
+      int window = 0;
+      for (int i = 0; i < rows - interval + 1; i += step, window++) {
+        CalculateMoments(in, i, interval, column, width, moments);
+        for (int c = 0; c < width; c++) {
+          stats_->Calculate(moments[c], (*out)[column + c] + window * types);
+        }
+      }
+      if ((rows - interval) % step != 0) {
+        CalculateMoments(in, rows - interval, interval, column, width,
+                         moments);
+        for (int c = 0; c < width; c++) {
+          stats_->Calculate(moments[c], (*out)[column + c] + window * types);
+        }
+      }
+    }
+  });
+}
+
+void RotatedStats::CalculateMoments(
+    const BuffersBase<float*>& in, int row, int length, int column,
+    int width, CentralMoments* moments) const noexcept {
+  int order = stats_->Order();
+  for (int c = 0; c < width; c++) {
+    moments[c] = CentralMoments();
+  }
+  // The same blocks as in Stats::CalculateMoments(), but each row updates
+  // the sums of the whole strip
+  for (int offset = row; offset < row + length; offset += Stats::kBlockSize) {
+    int n = std::min(Stats::kBlockSize, row + length - offset);
+    float center[kStripSize] {};
+    for (int r = offset; r < offset + n; r++) {
+      const float* values = in[r] + column;
+      for (int c = 0; c < width; c++) {
+        center[c] += values[c];
+      }
+    }
+    for (int c = 0; c < width; c++) {
+      center[c] /= n;
+    }
+    float s1[kStripSize] {}, s2[kStripSize] {};
+    float s3[kStripSize] {}, s4[kStripSize] {};
+    for (int r = offset; r < offset + n; r++) {
+      const float* values = in[r] + column;
+      for (int c = 0; c < width; c++) {
+        float d = values[c] - center[c];
+        float d2 = d * d;
+        s1[c] += d;
+        s2[c] += d2;
+        if (order > 2) {
+          s3[c] += d2 * d;
+          s4[c] += d2 * d2;
+        }
+      }
+    }
+    for (int c = 0; c < width; c++) {
+      double sums[5] { center[c], s1[c], s2[c], s3[c], s4[c] };
+      moments[c].Merge(BlockMoments(n, sums), order);
+    }
   }
-  double u4 = avg4 - 4 * avg3 * avg1 + 6 * avg2 * avg1 * avg1
-      - 3 * avg1 * avg1 * avg1 * avg1;
-  auto value = u4 / (u2 * u2) - 3;
-  return value;
 }
 
 RTP(Stats, types)
@@ -31,7 +31,10 @@
 #ifndef SRC_TRANSFORMS_STATS_H_
 #define SRC_TRANSFORMS_STATS_H_
 
+#include <mutex>
 #include <set>
+#include <unordered_map>
+#include <vector>
 #include "src/formats/array_format.h"
 #include "src/omp_transform_base.h"
 
@@ -106,6 +109,28 @@ class UnableToCalculateStatsException : public ExceptionBase {
                   std::to_string(inputSize) + ".") {}
 };
 
+/// @brief The central moments of a sample, which can be merged with the
+/// moments of another sample (Terriberry's extension of Welford's method).
+struct CentralMoments {
+  CentralMoments() noexcept : Count(0), Mean(0), M2(0), M3(0), M4(0) {
+  }
+
+  /// @brief Adds the moments of other to this ones.
+  /// @param order The highest moment to update.
+  void Merge(const CentralMoments& other, int order) noexcept;
+
+  double Count;
+  double Mean;
+  /// @brief The sums of the powers of the deviations from Mean.
+  double M2, M3, M4;
+};
+
+/// @brief Calculates the requested moments of each interval in a single
+/// pass. The interval is processed in the blocks of kBlockSize, the sums of
+/// the powers of the deviations from the block average are accumulated in
+/// the SIMD lanes and the blocks are merged through CentralMoments. In the
+/// streaming mode with zero interval, the moments of each buffer keep being
+/// merged with the ones of the next buffers.
 class Stats : public OmpTransformBase<formats::ArrayFormatF,
                                       formats::ArrayFormatF>  {
  public:
@@ -124,28 +149,88 @@ class Stats : public OmpTransformBase<formats::ArrayFormatF,
 
   virtual void Initialize() const override;
 
- protected:
-  typedef float(*CalculateFunc)(const float*);
+  virtual void ResetState() const noexcept override;
+
+  virtual InstructionSet SimdInstructionSet() const noexcept override;
 
+ protected:
   static std::set<StatsType> kDefaultStatsTypes() noexcept {
     return { kStatsTypeAverage, kStatsTypeStdDeviation,
              kStatsTypeSkewness, kStatsTypeKurtosis };
   }
   static constexpr int kDefaultInterval = 0;
   static constexpr int kDefaultOverlap = 0;
-  static const std::unordered_map<int, CalculateFunc> kStatsFuncs;
+  /// @brief The number of values whose moments are calculated around the
+  /// same average.
+  static constexpr int kBlockSize = 256;
 
   virtual size_t OnInputFormatChanged(size_t buffersCount) override;
 
   virtual void Do(const float* in, float* out) const noexcept override;
 
-  void Calculate(const float* rawMoments, float* out) const noexcept;
-  static void CalculateRawMoments(bool simd, const float* in, int startIndex,
-                                  int length, float* rawMoments) noexcept;
-  static float CalculateAverage(const float* rawMoments) noexcept;
-  static float CalculateStdDeviation(const float* rawMoments) noexcept;
-  static float CalculateSkewness(const float* rawMoments) noexcept;
-  static float CalculateKurtosis(const float* rawMoments) noexcept;
+  /// @brief Returns the highest moment required by types_.
+  int Order() const noexcept;
+  void Calculate(const CentralMoments& moments, float* out) const noexcept;
+  static void CalculateMoments(bool simd, const float* in, int length,
+                               int order, CentralMoments* moments) noexcept;
+
+ private:
+  friend class RotatedStats;
+
+  /// @brief The moments of each buffer in the streaming mode.
+  /// @details The memory of the buffers is fixed after the transform tree is
+  /// prepared, so each input pointer corresponds to the same channel.
+  mutable std::unordered_map<const float*, CentralMoments> stream_moments_;
+  mutable std::mutex stream_moments_mutex_;
+};
+
+/// @brief Calculates the stats of the columns of the buffers, the same as
+/// Rotate -> Stats but without storing the rotated matrix. The rows are
+/// read in their order and the moments of the contiguous strips of columns
+/// are accumulated in parallel, so the reads are never strided.
+/// @note This transform is not registered in the factory.
+class RotatedStats
+    : public UniformFormatOmpAwareTransform<formats::ArrayFormatF> {
+ public:
+  /// @param stats The Stats which follows Rotate.
+  explicit RotatedStats(const std::shared_ptr<Transform>& stats);
+
+  TRANSFORM_INTRO("Stats", "Calculate statistical measures of the columns "
+                           "(Rotate -> Stats).",
+                  RotatedStats)
+
+  virtual void Initialize() const override;
+
+  virtual void ResetState() const noexcept override;
+
+  virtual bool BufferInvariant() const noexcept override {
+    return false;
+  }
+
+  virtual InstructionSet SimdInstructionSet() const noexcept override {
+    return InstructionSet::kScalar;
+  }
+
+ protected:
+  /// @brief The number of the columns whose moments are accumulated
+  /// together.
+  static constexpr int kStripSize = 16;
+
+  virtual size_t OnFormatChanged(size_t buffersCount) override;
+
+  virtual void Do(const BuffersBase<float*>& in,
+                  BuffersBase<float*>* out) const noexcept override;
+
+  /// @brief Calculates the moments of the columns [column, column + width)
+  /// over the rows [row, row + length).
+  void CalculateMoments(const BuffersBase<float*>& in, int row, int length,
+                        int column, int width,
+                        CentralMoments* moments) const noexcept;
+
+ private:
+  std::shared_ptr<Stats> stats_;
+  /// @brief The moments of each column in the streaming mode.
+  mutable std::vector<CentralMoments> stream_moments_;
 };
 
 }  // namespace transforms
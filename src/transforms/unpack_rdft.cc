@@ -60,6 +60,10 @@ void UnpackRDFT::Do(const float* in,
   }
 }
 
+void UnpackRDFT::Mirror(float* values, size_t length) noexcept {
+  rmemcpyf(values + length / 2 + 1, values + 1, length / 2 - 1);
+}
+
 REGISTER_TRANSFORM(UnpackRDFT);
 
 }  // namespace transforms
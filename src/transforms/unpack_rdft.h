@@ -43,6 +43,13 @@ class UnpackRDFT : public OmpUniformFormatTransform<formats::ArrayFormatF> {
 
   void Initialize() const override;
 
+  /// @brief Mirrors the values of the first length / 2 + 1 complex numbers
+  /// of the packed spectrum into the rest, the same way Do() mirrors the
+  /// complex numbers themselves.
+  /// @param values The values of the whole spectrum, one per complex number.
+  /// @param length The number of complex numbers in the whole spectrum.
+  static void Mirror(float* values, size_t length) noexcept;
+
  protected:
   virtual size_t OnFormatChanged(size_t buffersCount) override;
 
@@ -29,8 +29,12 @@
  */
 
 #include "src/transforms/window.h"
-#include <fftf/api.h>
 #include <simd/arithmetic-inl.h>
+#ifdef SIMD_X86
+#include <immintrin.h>
+#elif defined(SIMD_NEON)
+#include <arm_neon.h>
+#endif
 
 namespace sound_feature_extraction {
 namespace transforms {
@@ -40,68 +44,105 @@ constexpr bool Window::kDefaultPreDft;
 
 Window::Window()
   : type_(kDefaultType),
-    predft_(kDefaultPreDft),
-    window_(nullptr, free) {
+    predft_(kDefaultPreDft) {
 }
 
 ALWAYS_VALID_TP(Window, type)
 ALWAYS_VALID_TP(Window, predft)
 
-Window::WindowContentsPtr Window::InitializeWindow(size_t length,
-                                                   WindowType type,
-                                                   int allocSize) noexcept {
-  if (allocSize == -1) {
-    allocSize = length;
+typedef void (*ApplyWindowKernel)(const float* window, int length,
+                                   const float* input, float* output);
+
+static void ApplyWindowScalar(const float* window, int length,
+                              const float* input, float* output) {
+  for (int i = 0; i < length; i++) {
+    output[i] = input[i] * window[i];
   }
+}
 
-  auto window = WindowContentsPtr(mallocf(allocSize), free);
+#ifdef SIMD_X86
+SIMD_TARGET("sse4.1")
+static void ApplyWindowSSE41(const float* window, int length,
+                             const float* input, float* output) {
+  int i = 0;
+  for (; i < length - 3; i += 4) {
+    _mm_storeu_ps(output + i, _mm_mul_ps(_mm_loadu_ps(input + i),
+                                         _mm_loadu_ps(window + i)));
+  }
+  ApplyWindowScalar(window + i, length - i, input + i, output + i);
+}
 
-  auto windowContents = window.get();
-  for (int i = 0; i < static_cast<int>(length); i++) {
-    windowContents[i] = WindowElement(type, length, i);
+SIMD_TARGET("avx")
+static void ApplyWindowAVX(const float* window, int length,
+                           const float* input, float* output) {
+  int i = 0;
+  for (; i < length - 7; i += 8) {
+    _mm256_storeu_ps(output + i, _mm256_mul_ps(_mm256_loadu_ps(input + i),
+                                               _mm256_loadu_ps(window + i)));
   }
+  ApplyWindowScalar(window + i, length - i, input + i, output + i);
+}
 
-  return window;
+SIMD_TARGET_AVX512
+static void ApplyWindowAVX512(const float* window, int length,
+                              const float* input, float* output) {
+  int i = 0;
+  for (; i < length - 15; i += 16) {
+    _mm512_storeu_ps(output + i, _mm512_mul_ps(_mm512_loadu_ps(input + i),
+                                               _mm512_loadu_ps(window + i)));
+  }
+  __mmask16 tail = (1u << (length - i)) - 1;
+  _mm512_mask_storeu_ps(output + i, tail, _mm512_mul_ps(
+      _mm512_maskz_loadu_ps(tail, input + i),
+      _mm512_maskz_loadu_ps(tail, window + i)));
+}
+#elif defined(SIMD_NEON)
+static void ApplyWindowNEON(const float* window, int length,
+                            const float* input, float* output) {
+  int i = 0;
+  for (; i < length - 3; i += 4) {
+    vst1q_f32(output + i, vmulq_f32(vld1q_f32(input + i),
+                                    vld1q_f32(window + i)));
+  }
+  ApplyWindowScalar(window + i, length - i, input + i, output + i);
 }
+#endif
+
+static const SimdKernel<ApplyWindowKernel> kApplyWindowKernels[] {
+#ifdef SIMD_X86
+  { InstructionSet::kAVX512, ApplyWindowAVX512 },
+  { InstructionSet::kAVX, ApplyWindowAVX },
+  { InstructionSet::kSSE41, ApplyWindowSSE41 },
+#elif defined(SIMD_NEON)
+  { InstructionSet::kNEON, ApplyWindowNEON },
+#endif
+  { InstructionSet::kScalar, ApplyWindowScalar }
+};
 
 void Window::ApplyWindow(bool simd, const float* window, int length,
                          const float* input, float* output) noexcept {
-  if (simd) {
-#ifdef SIMD
-    for (int i = 0; i < length - FLOAT_STEP + 1; i += FLOAT_STEP) {
-      real_multiply(input + i, window + i, output + i);
-    }
-    for (int i = ((length >> FLOAT_STEP_LOG2) << FLOAT_STEP_LOG2);
-        i < length; i++) {
-      output[i] = input[i] * window[i];
-    }
-  } else {
-#else
-  } {
-#endif
-    for (int i = 0; i < length; i++) {
-      output[i] = input[i] * window[i];
-    }
+  if (!simd) {
+    ApplyWindowScalar(window, length, input, output);
+    return;
   }
+  SimdAware::Dispatch(kApplyWindowKernels).Function(
+      window, length, input, output);
+}
+
+InstructionSet Window::ApplyWindowInstructionSet() noexcept {
+  return SimdAware::Dispatch(kApplyWindowKernels).Isa;
+}
+
+InstructionSet Window::SimdInstructionSet() const noexcept {
+  return ApplyWindowInstructionSet();
+}
+
+bool Window::InPlace() const noexcept {
+  return true;
 }
 
 void Window::Initialize() const {
-  if (!predft_) {
-    window_ = InitializeWindow(input_format_->Size(), type_);
-  } else {
-    int length = input_format_->Size();
-    int fftLength = (length - 2) / 2;
-    window_ = InitializeWindow(fftLength, type_, length);
-    auto fftPlan = std::unique_ptr<FFTFInstance, void (*)(FFTFInstance *)>(
-        fftf_init(
-            FFTF_TYPE_REAL, FFTF_DIRECTION_FORWARD,
-            FFTF_DIMENSION_1D,
-            &fftLength, FFTF_NO_OPTIONS,
-            window_.get(), window_.get()),
-        fftf_destroy);
-
-    fftf_calc(fftPlan.get());
-  }
+  window_ = SharedWindow(type_, input_format_->Size(), predft_);
 }
 
 void Window::Do(const float* in,
@@ -110,6 +151,10 @@ const noexcept {
   ApplyWindow(use_simd(), window_.get(), input_format_->Size(), in, out);
 }
 
+size_t Window::PrivateMemorySize() const noexcept {
+  return window_? input_format_->Size() * sizeof(float) : 0;
+}
+
 RTP(Window, type)
 RTP(Window, predft)
 REGISTER_TRANSFORM(Window);
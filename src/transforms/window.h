@@ -42,6 +42,8 @@ class Window : public OmpUniformFormatTransform<formats::ArrayFormatF> {
   template <class T> friend class WindowSplitterTemplate;
   friend class WindowSplitter16;
   friend class WindowSplitterF;
+  friend class PowerSpectrum;
+  friend class MultiResolutionSpectrum;
  public:
   Window();
 
@@ -56,23 +58,27 @@ class Window : public OmpUniformFormatTransform<formats::ArrayFormatF> {
 
   virtual void Initialize() const override;
 
+  virtual InstructionSet SimdInstructionSet() const noexcept override;
+
+  virtual bool InPlace() const noexcept override;
+
+  virtual size_t PrivateMemorySize() const noexcept override;
+
  protected:
-  typedef std::unique_ptr<float, void(*)(void*)> WindowContentsPtr;
   static constexpr WindowType kDefaultType = WindowType::kWindowTypeHamming;
   static constexpr bool kDefaultPreDft = false;
 
   virtual void Do(const float* in,
                   float* out) const noexcept override;
 
-  mutable WindowContentsPtr window_;
+  mutable WindowTable window_;
 
   static void ApplyWindow(bool simd, const float* window, int length,
                           const float* input, float* output) noexcept;
 
- private:
-  static WindowContentsPtr InitializeWindow(size_t length,
-                                            WindowType type,
-                                            int allocSize = -1) noexcept;
+  /// @brief Returns the instruction set of the kernel which ApplyWindow()
+  /// currently selects.
+  static InstructionSet ApplyWindowInstructionSet() noexcept;
 };
 
 }  // namespace transforms
@@ -30,73 +30,342 @@
 
 #include "src/transforms/window_splitter.h"
 #include <simd/arithmetic-inl.h>
+#ifdef SIMD_X86
+#include <immintrin.h>
+#elif defined(SIMD_NEON)
+#include <arm_neon.h>
+#endif
+#include <algorithm>
+#include <cassert>
+#include <cmath>
 
 namespace sound_feature_extraction {
 namespace transforms {
 
+typedef void (*ApplyWindow16Kernel)(const int16_t* input, const float* window,
+                                    int length, int16_t* output);
+
+static inline int16_t round_to_int16(float value) {
+  long rounded = lrintf(value);  // NOLINT(runtime/int)
+  return std::max(-32768L, std::min(32767L, rounded));
+}
+
+static void ApplyWindow16Scalar(const int16_t* input, const float* window,
+                                int length, int16_t* output) {
+  for (int i = 0; i < length; i++) {
+    output[i] = round_to_int16(input[i] * window[i]);
+  }
+}
+
+#ifdef SIMD_X86
+SIMD_TARGET("sse4.1")
+static void ApplyWindow16SSE41(const int16_t* input, const float* window,
+                               int length, int16_t* output) {
+  int i = 0;
+  for (; i < length - 7; i += 8) {
+    __m128i vec = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+    __m128 lo = _mm_cvtepi32_ps(_mm_cvtepi16_epi32(vec));
+    __m128 hi = _mm_cvtepi32_ps(_mm_cvtepi16_epi32(_mm_srli_si128(vec, 8)));
+    lo = _mm_mul_ps(lo, _mm_loadu_ps(window + i));
+    hi = _mm_mul_ps(hi, _mm_loadu_ps(window + i + 4));
+    __m128i res = _mm_packs_epi32(_mm_cvtps_epi32(lo), _mm_cvtps_epi32(hi));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), res);
+  }
+  ApplyWindow16Scalar(input + i, window + i, length - i, output + i);
+}
+
+SIMD_TARGET("avx2")
+static void ApplyWindow16AVX2(const int16_t* input, const float* window,
+                              int length, int16_t* output) {
+  int i = 0;
+  for (; i < length - 15; i += 16) {
+    __m256i vec = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(input + i));
+    __m256 lo = _mm256_cvtepi32_ps(
+        _mm256_cvtepi16_epi32(_mm256_castsi256_si128(vec)));
+    __m256 hi = _mm256_cvtepi32_ps(
+        _mm256_cvtepi16_epi32(_mm256_extracti128_si256(vec, 1)));
+    lo = _mm256_mul_ps(lo, _mm256_loadu_ps(window + i));
+    hi = _mm256_mul_ps(hi, _mm256_loadu_ps(window + i + 8));
+    __m256i res = _mm256_packs_epi32(_mm256_cvtps_epi32(lo),
+                                     _mm256_cvtps_epi32(hi));
+    // packs works within 128-bit lanes, restore the order of the quadwords
+    res = _mm256_permute4x64_epi64(res, 0xD8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), res);
+  }
+  ApplyWindow16Scalar(input + i, window + i, length - i, output + i);
+}
+
+SIMD_TARGET_AVX512
+static void ApplyWindow16AVX512(const int16_t* input, const float* window,
+                                int length, int16_t* output) {
+  int i = 0;
+  for (; i < length - 15; i += 16) {
+    __m512 vec = _mm512_cvtepi32_ps(_mm512_cvtepi16_epi32(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i))));
+    vec = _mm512_mul_ps(vec, _mm512_loadu_ps(window + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i),
+                        _mm512_cvtsepi32_epi16(_mm512_cvtps_epi32(vec)));
+  }
+  __mmask16 tail = (1u << (length - i)) - 1;
+  __m512 vec = _mm512_cvtepi32_ps(_mm512_cvtepi16_epi32(
+      _mm256_maskz_loadu_epi16(tail, input + i)));
+  vec = _mm512_mul_ps(vec, _mm512_maskz_loadu_ps(tail, window + i));
+  _mm256_mask_storeu_epi16(output + i, tail,
+                           _mm512_cvtsepi32_epi16(_mm512_cvtps_epi32(vec)));
+}
+#elif defined(SIMD_NEON) && defined(__aarch64__)
+static void ApplyWindow16NEON(const int16_t* input, const float* window,
+                              int length, int16_t* output) {
+  int i = 0;
+  for (; i < length - 7; i += 8) {
+    int16x8_t vec = vld1q_s16(input + i);
+    float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(vec)));
+    float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(vec)));
+    lo = vmulq_f32(lo, vld1q_f32(window + i));
+    hi = vmulq_f32(hi, vld1q_f32(window + i + 4));
+    // vcvtq_s32_f32() truncates, so round to the nearest even first
+    int16x8_t res = vcombine_s16(
+        vqmovn_s32(vcvtq_s32_f32(vrndnq_f32(lo))),
+        vqmovn_s32(vcvtq_s32_f32(vrndnq_f32(hi))));
+    vst1q_s16(output + i, res);
+  }
+  ApplyWindow16Scalar(input + i, window + i, length - i, output + i);
+}
+#endif
+
+static const SimdKernel<ApplyWindow16Kernel> kApplyWindow16Kernels[] {
+#ifdef SIMD_X86
+  { InstructionSet::kAVX512, ApplyWindow16AVX512 },
+  { InstructionSet::kAVX2, ApplyWindow16AVX2 },
+  { InstructionSet::kSSE41, ApplyWindow16SSE41 },
+#elif defined(SIMD_NEON) && defined(__aarch64__)
+  { InstructionSet::kNEON, ApplyWindow16NEON },
+#endif
+  { InstructionSet::kScalar, ApplyWindow16Scalar }
+};
+
 void WindowSplitter16::Do(const BuffersBase<int16_t*>& in,
                           BuffersBase<int16_t*> *out)
 const noexcept {
-#ifdef __AVX__
-  int16_t intbuf[output_format_->Size()] __attribute__ ((aligned (32)));  // NOLINT(*)
-#endif
-  float fbuf[output_format_->Size()] __attribute__ ((aligned (64)));  // NOLINT(*)
-  float* window = window_.get();
-
-  for (size_t i = 0; i < in.Count(); i++) {
-    for (int j = 0; j < windows_count_; j++) {
-      auto input = in[i] + j * step();
-      auto output = interleaved()? (*out)[i * windows_count_ + j] :
-                                  (*out)[j * in.Count() + i];
-      if (type() != WindowType::kWindowTypeRectangular) {
-#ifdef __AVX__
-        if (align_complement_i16(input) != 0) {
-          memcpy(intbuf, input, output_format_->Size() * sizeof(int16_t));
-          int16_to_float(intbuf, output_format_->Size(), fbuf);
-        } else {
-          int16_to_float(input, output_format_->Size(), fbuf);
-        }
-#else
-        int16_to_float(input, output_format_->Size(), fbuf);
-#endif
-        Window::ApplyWindow(use_simd(), window, output_format_->Size(),
-                            fbuf, fbuf);
-        float_to_int16(fbuf, output_format_->Size(), output);
-      } else {  // type() != kWindowTypeRectangular
-        memcpy(output, input, output_format_->Size() * sizeof(input[0]));
-      }
+  auto& kernel = SimdAware::Dispatch(kApplyWindow16Kernels);
+  const float* window = window_.get();
+  int length = output_format_->Size();
+  bool rectangular = type() == WindowType::kWindowTypeRectangular;
+  Split(in, out, interleaved(), serial(), false,
+        [&](const int16_t* input, int16_t* output) {
+    if (!rectangular) {
+      kernel.Function(input, window, length, output);
+    } else {
+      StoreCopy(output, input, length * sizeof(input[0]));
     }
+  });
+}
+
+InstructionSet WindowSplitter16::SimdInstructionSet() const noexcept {
+  if (type() == WindowType::kWindowTypeRectangular) {
+    return InstructionSet::kScalar;
   }
+  return SimdAware::Dispatch(kApplyWindow16Kernels).Isa;
 }
 
-void WindowSplitterF::Do(const BuffersBase<float*>& in,
-                         BuffersBase<float*> *out)
-const noexcept {
-#ifdef __AVX__
-  float intbuf[output_format_->Size()] __attribute__ ((aligned (32)));  // NOLINT(*)
+typedef void (*ApplyWindow16FKernel)(const int16_t* input,
+                                     const float* window, int length,
+                                     float* output);
+
+static void ApplyWindow16FScalar(const int16_t* input, const float* window,
+                                 int length, float* output) {
+  for (int i = 0; i < length; i++) {
+    output[i] = round_to_int16(input[i] * window[i]);
+  }
+}
+
+#ifdef SIMD_X86
+/// @brief kStream kernels write the aligned outputs with the non-temporal
+/// stores, see StreamingStoresTransform.
+template <bool kStream>
+SIMD_TARGET("sse4.1")
+static void ApplyWindow16FSSE41(const int16_t* input, const float* window,
+                                int length, float* output) {
+  bool stream = kStream && reinterpret_cast<uintptr_t>(output) % 16 == 0;
+  int i = 0;
+  for (; i < length - 3; i += 4) {
+    __m128 vec = _mm_cvtepi32_ps(_mm_cvtepi16_epi32(_mm_loadl_epi64(
+        reinterpret_cast<const __m128i*>(input + i))));
+    vec = _mm_round_ps(_mm_mul_ps(vec, _mm_loadu_ps(window + i)),
+                       _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    if (stream) {
+      _mm_stream_ps(output + i, vec);
+    } else {
+      _mm_storeu_ps(output + i, vec);
+    }
+  }
+  ApplyWindow16FScalar(input + i, window + i, length - i, output + i);
+}
+
+template <bool kStream>
+SIMD_TARGET("avx2")
+static void ApplyWindow16FAVX2(const int16_t* input, const float* window,
+                               int length, float* output) {
+  bool stream = kStream && reinterpret_cast<uintptr_t>(output) % 32 == 0;
+  int i = 0;
+  for (; i < length - 7; i += 8) {
+    __m256 vec = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(input + i))));
+    vec = _mm256_round_ps(_mm256_mul_ps(vec, _mm256_loadu_ps(window + i)),
+                          _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    if (stream) {
+      _mm256_stream_ps(output + i, vec);
+    } else {
+      _mm256_storeu_ps(output + i, vec);
+    }
+  }
+  ApplyWindow16FScalar(input + i, window + i, length - i, output + i);
+}
+
+template <bool kStream>
+SIMD_TARGET_AVX512
+static void ApplyWindow16FAVX512(const int16_t* input, const float* window,
+                                 int length, float* output) {
+  bool stream = kStream && reinterpret_cast<uintptr_t>(output) % 64 == 0;
+  int i = 0;
+  for (; i < length - 15; i += 16) {
+    __m512 vec = _mm512_cvtepi32_ps(_mm512_cvtepi16_epi32(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i))));
+    vec = _mm512_roundscale_ps(
+        _mm512_mul_ps(vec, _mm512_loadu_ps(window + i)),
+        _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    if (stream) {
+      _mm512_stream_ps(output + i, vec);
+    } else {
+      _mm512_storeu_ps(output + i, vec);
+    }
+  }
+  __mmask16 tail = (1u << (length - i)) - 1;
+  __m512 vec = _mm512_cvtepi32_ps(_mm512_cvtepi16_epi32(
+      _mm256_maskz_loadu_epi16(tail, input + i)));
+  vec = _mm512_mul_ps(vec, _mm512_maskz_loadu_ps(tail, window + i));
+  _mm512_mask_storeu_ps(output + i, tail, _mm512_roundscale_ps(
+      vec, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+}
+#elif defined(SIMD_NEON) && defined(__aarch64__)
+static void ApplyWindow16FNEON(const int16_t* input, const float* window,
+                               int length, float* output) {
+  int i = 0;
+  for (; i < length - 3; i += 4) {
+    float32x4_t vec = vcvtq_f32_s32(vmovl_s16(vld1_s16(input + i)));
+    vst1q_f32(output + i, vrndnq_f32(vmulq_f32(vec, vld1q_f32(window + i))));
+  }
+  ApplyWindow16FScalar(input + i, window + i, length - i, output + i);
+}
 #endif
-  for (size_t i = 0; i < in.Count(); i++) {
-    for (int j = 0; j < windows_count_; j++) {
-      auto input = in[i] + j * step();
-      auto output = (*out)[i * windows_count_ + j];
-      if (type() != WindowType::kWindowTypeRectangular) {
-#ifdef __AVX__
-        if (align_complement_f32(input) != 0) {
-          memcpy(intbuf, input, output_format_->Size() * sizeof(input[0]));
-          Window::ApplyWindow(use_simd(), window_.get(), output_format_->Size(),
-                              intbuf, output);
-        } else {
+
+static const SimdKernel<ApplyWindow16FKernel> kApplyWindow16FKernels[] {
+#ifdef SIMD_X86
+  { InstructionSet::kAVX512, ApplyWindow16FAVX512<false> },
+  { InstructionSet::kAVX2, ApplyWindow16FAVX2<false> },
+  { InstructionSet::kSSE41, ApplyWindow16FSSE41<false> },
+#elif defined(SIMD_NEON) && defined(__aarch64__)
+  { InstructionSet::kNEON, ApplyWindow16FNEON },
 #endif
-        Window::ApplyWindow(use_simd(), window_.get(), output_format_->Size(),
-                            input, output);
-#ifdef __AVX__
-        }
+  { InstructionSet::kScalar, ApplyWindow16FScalar }
+};
+
+static const SimdKernel<ApplyWindow16FKernel>
+kApplyWindow16FStreamingKernels[] {
+#ifdef SIMD_X86
+  { InstructionSet::kAVX512, ApplyWindow16FAVX512<true> },
+  { InstructionSet::kAVX2, ApplyWindow16FAVX2<true> },
+  { InstructionSet::kSSE41, ApplyWindow16FSSE41<true> },
+#elif defined(SIMD_NEON) && defined(__aarch64__)
+  { InstructionSet::kNEON, ApplyWindow16FNEON },
 #endif
-      } else {
-        memcpy(output, input, output_format_->Size() * sizeof(input[0]));
-      }
+  { InstructionSet::kScalar, ApplyWindow16FScalar }
+};
+
+void WindowSplitter16::DoFloat(const BuffersBase<int16_t*>& in,
+                               BuffersBase<float*>* out,
+                               bool streamingStores,
+                               bool serial) const noexcept {
+  auto& kernel = SimdAware::Dispatch(streamingStores?
+      kApplyWindow16FStreamingKernels : kApplyWindow16FKernels);
+  const float* window = window_.get();
+  int length = output_format_->Size();
+  Split(in, out, interleaved(), serial, streamingStores,
+        [&](const int16_t* input, float* output) {
+    kernel.Function(input, window, length, output);
+  });
+}
+
+InstructionSet WindowSplitter16::FloatInstructionSet() const noexcept {
+  return SimdAware::Dispatch(kApplyWindow16FKernels).Isa;
+}
+
+WindowSplitter16F::WindowSplitter16F(
+    const std::shared_ptr<Transform>& splitter)
+    : splitter_(std::dynamic_pointer_cast<WindowSplitter16>(splitter)) {
+  assert(splitter_);
+}
+
+const std::shared_ptr<WindowSplitter16>& WindowSplitter16F::splitter()
+    const noexcept {
+  return splitter_;
+}
+
+size_t WindowSplitter16F::OnInputFormatChanged(size_t buffersCount) {
+  buffersCount = splitter_->SetInputFormat(input_format_, buffersCount);
+  output_format_->SetSize(splitter_->length());
+  return buffersCount;
+}
+
+void WindowSplitter16F::Initialize() const {
+  splitter_->Initialize();
+}
+
+void WindowSplitter16F::ResetState() const noexcept {
+  splitter_->ResetState();
+}
+
+Overlap WindowSplitter16F::RequiredOverlap(
+    const Overlap& output) const noexcept {
+  return splitter_->RequiredOverlap(output);
+}
+
+size_t WindowSplitter16F::BufferRatio() const noexcept {
+  return splitter_->BufferRatio();
+}
+
+InstructionSet WindowSplitter16F::SimdInstructionSet() const noexcept {
+  return splitter_->FloatInstructionSet();
+}
+
+void WindowSplitter16F::Do(const BuffersBase<int16_t*>& in,
+                           BuffersBase<float*>* out) const noexcept {
+  splitter_->DoFloat(in, out, streaming_stores(), serial());
+}
+
+void WindowSplitterF::Do(const BuffersBase<float*>& in,
+                         BuffersBase<float*> *out)
+const noexcept {
+  const float* window = window_.get();
+  int length = output_format_->Size();
+  bool rectangular = type() == WindowType::kWindowTypeRectangular;
+  bool simd = use_simd();
+  Split(in, out, true, serial(), false,
+        [&](const float* input, float* output) {
+    if (!rectangular) {
+      Window::ApplyWindow(simd, window, length, input, output);
+    } else {
+      StoreCopy(output, input, length * sizeof(input[0]));
     }
+  });
+}
+
+InstructionSet WindowSplitterF::SimdInstructionSet() const noexcept {
+  if (type() == WindowType::kWindowTypeRectangular) {
+    return InstructionSet::kScalar;
   }
+  return Window::ApplyWindowInstructionSet();
 }
 
 REGISTER_TRANSFORM(WindowSplitter16);
@@ -31,11 +31,27 @@
 #ifndef SRC_TRANSFORMS_WINDOW_SPLITTER_H_
 #define SRC_TRANSFORMS_WINDOW_SPLITTER_H_
 
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "src/parallel_transform.h"
+#include "src/streaming_stores_transform.h"
+#include "src/thread_pool.h"
 #include "src/transforms/window.h"
+#include "src/view_transform.h"
 
 namespace sound_feature_extraction {
 namespace transforms {
 
+class StreamingBlockSizeException : public ExceptionBase {
+ public:
+  StreamingBlockSizeException(size_t size, int step)
+  : ExceptionBase("Streaming block size " + std::to_string(size) +
+                  " is not divisible by window step " + std::to_string(step) +
+                  ".") {
+  }
+};
+
 template <class T>
 class WindowSplitterTemplateBase
     : public virtual UniformFormatTransform<formats::ArrayFormat<T>> {
@@ -95,11 +111,14 @@ RTP(WindowSplitterTemplateBase<T>, interleaved)
 template <class T>
 class WindowSplitterTemplate
     : public WindowSplitterTemplateBase<T>,
-      public TransformLogger<WindowSplitterTemplate<T>> {
+      public TransformLogger<WindowSplitterTemplate<T>>,
+      public ViewTransform,
+      public StreamingStoresTransform,
+      public ParallelTransform {
  public:
   WindowSplitterTemplate()
       : type_(kDefaultWindowType),
-        window_(nullptr, free) {
+        inputs_count_(0) {
   }
 
   TRANSFORM_INTRO("Window", "Splits the raw input signal into numerous "
@@ -111,6 +130,14 @@ class WindowSplitterTemplate
      "Type of the window. E.g. \"rectangular\" or \"hamming\".")
 
   virtual void Initialize() const {
+    if (this->streaming()) {
+      if (this->input_format_->Size() % this->step() != 0) {
+        throw StreamingBlockSizeException(this->input_format_->Size(),
+                                          this->step());
+      }
+      window_ = SharedWindow(type_, this->output_format_->Size());
+      return;
+    }
     int realSize = this->input_format_->Size() - this->output_format_->Size();
     int excess = realSize % this->step();
     if (excess != 0) {
@@ -121,21 +148,187 @@ class WindowSplitterTemplate
           realSize, this->step(), excess);
     }
 
-    window_ = Window::InitializeWindow(this->output_format_->Size(), type_);
+    window_ = SharedWindow(type_, this->output_format_->Size());
+  }
+
+  virtual size_t PrivateMemorySize() const noexcept override {
+    size_t size = window_? this->output_format_->Size() * sizeof(float) : 0;
+    for (auto& buffer : stream_buffers_) {
+      size += buffer.size() * sizeof(T);
+    }
+    return size;
+  }
+
+  /// @brief The rectangular windows are the overlapping frames of the input
+  /// which are read in place if the output buffers are ordered by the frame
+  /// position.
+  virtual bool IsView() const noexcept override {
+    if (type_ != WindowType::kWindowTypeRectangular || this->streaming()) {
+      return false;
+    }
+    return inputs_count_ == 1 || (this->interleaved() &&
+        this->input_format_->Size() ==
+            static_cast<size_t>(this->windows_count_ * this->step()));
+  }
+
+  virtual size_t ViewStride() const noexcept override {
+    return this->step() * sizeof(T);
+  }
+
+  /// @brief The interleaved windows of each buffer are consecutive,
+  /// unless the stream tails are kept by the buffer index.
+  virtual size_t BufferRatio() const noexcept override {
+    if (!this->interleaved() || this->streaming()) {
+      return 0;
+    }
+    return this->windows_count_;
+  }
+
+  /// @brief Converts the windows into the samples: the i-th window starts
+  /// at i * step, so the preceding windows require step samples each and
+  /// the following ones also require the tail of the last window.
+  virtual Overlap RequiredOverlap(const Overlap& output)
+      const noexcept override {
+    if (!output.Bounded() || this->streaming() || inputs_count_ != 1) {
+      return Overlap::Unbounded();
+    }
+    size_t step = this->step();
+    return { output.Before * step,
+             output.After * step + StreamTailLength() };
+  }
+
+  virtual void ResetState() const noexcept override {
+    for (auto& sb : stream_buffers_) {
+      std::fill(sb.begin(), sb.end(), 0);
+    }
   }
 
  protected:
   virtual size_t OnFormatChanged(size_t buffersCount) override final {
     this->output_format_->SetSize(this->length());
+    inputs_count_ = buffersCount;
+    if (this->streaming()) {
+      // The tail of the previous block is prepended to the current one,
+      // so that each block produces exactly size / step new windows
+      this->windows_count_ = this->input_format_->Size() / this->step();
+      return this->windows_count_ * buffersCount;
+    }
     int realSize = this->input_format_->Size() - this->output_format_->Size();
     this->windows_count_ = realSize / this->step()+ 1;
     return this->windows_count_ * buffersCount;
   }
 
+  /// @brief The number of samples from the previous block which are
+  /// required to continue splitting in the streaming mode.
+  int StreamTailLength() const noexcept {
+    return std::max(this->length() - this->step(), 0);
+  }
+
+  /// @brief Returns the signal to split. In the streaming mode, this is
+  /// the input prepended with the tail of the previous block (initially
+  /// zeros).
+  const T* StreamInput(size_t index, const T* input) const noexcept {
+    if (!this->streaming()) {
+      return input;
+    }
+    size_t size = this->input_format_->Size();
+    int tail = StreamTailLength();
+    if (stream_buffers_.size() <= index) {
+      stream_buffers_.resize(index + 1, std::vector<T>(tail + size, 0));
+    }
+    auto& sb = stream_buffers_[index];
+    memcpy(sb.data() + tail, input, size * sizeof(T));
+    return sb.data();
+  }
+
+  /// @brief Keeps the tail of the current block for the next one.
+  void SaveStreamTail(size_t index) const noexcept {
+    if (!this->streaming()) {
+      return;
+    }
+    auto& sb = stream_buffers_[index];
+    memmove(sb.data(), sb.data() + this->input_format_->Size(),
+            StreamTailLength() * sizeof(T));
+  }
+
+  /// @brief Calls apply(input, output) for each window of each buffer.
+  /// @details The windows are processed by the tiles of kTileSize buffers
+  /// by kTileSize windows on the thread pool. The tiles turn the scattered
+  /// writes of the non-interleaved layout, where the consecutive windows of
+  /// a buffer are in.Count() apart, into a blocked transpose. The hardware
+  /// prefetcher does not follow the large steps through several buffers,
+  /// so the samples of the next window are prefetched explicitly.
+  /// @param interleaved The windows of each buffer are consecutive in out.
+  /// @param fence Issue the store fence in each thread, since apply() writes
+  /// with the non-temporal stores.
+  template <typename U, typename F>
+  void Split(const BuffersBase<T*>& in, BuffersBase<U*>* out,
+             bool interleaved, bool serial, bool fence,
+             const F& apply) const noexcept {
+    size_t count = in.Count();
+    // The stream buffers must not be resized concurrently
+    for (size_t i = 0; i < count && this->streaming(); i++) {
+      StreamInput(i, in[i]);
+    }
+    size_t windows = this->windows_count_;
+    size_t window_tiles = (windows + kTileSize - 1) / kTileSize;
+    size_t tiles = (count + kTileSize - 1) / kTileSize * window_tiles;
+    size_t step = this->step();
+    size_t length = this->output_format_->Size();
+    // Only the part which does not overlap the current window
+    size_t prefetch_offset = std::max(length, step);
+    size_t prefetch_size = step + length - prefetch_offset;
+    ThreadPool::Instance().ParallelFor(
+        tiles, 1, serial? 1 : get_omp_transforms_max_threads_num(),
+        [&](size_t begin, size_t end) {
+      for (size_t tile = begin; tile < end; tile++) {
+        // The neighbouring tiles share the buffers, so that each thread
+        // reads them sequentially
+        size_t first_buffer = tile / window_tiles * kTileSize;
+        size_t first_window = tile % window_tiles * kTileSize;
+        size_t last_buffer = std::min(first_buffer + kTileSize, count);
+        size_t last_window = std::min(first_window + kTileSize, windows);
+        for (size_t i = first_buffer; i < last_buffer; i++) {
+          const T* signal = this->streaming()?
+              stream_buffers_[i].data() : in[i];
+          for (size_t j = first_window; j < last_window; j++) {
+            auto input = signal + j * step;
+            if (j + 1 < windows) {
+              Prefetch(input + prefetch_offset, prefetch_size * sizeof(T));
+            }
+            auto output = interleaved? (*out)[i * windows + j] :
+                                       (*out)[j * count + i];
+            apply(input, output);
+          }
+        }
+      }
+      if (fence) {
+#ifdef __SSE2__
+        _mm_sfence();
+#endif
+      }
+    });
+    for (size_t i = 0; i < count && this->streaming(); i++) {
+      SaveStreamTail(i);
+    }
+  }
+
+  static void Prefetch(const T* ptr, size_t size) noexcept {
+    auto bytes = reinterpret_cast<const char*>(ptr);
+    for (size_t offset = 0; offset < size; offset += kCacheLineSize) {
+      __builtin_prefetch(bytes + offset);
+    }
+  }
+
+  static constexpr size_t kTileSize = 8;
+  static constexpr size_t kCacheLineSize = 64;
+
   static constexpr WindowType kDefaultWindowType =
       WindowType::kWindowTypeHamming;
 
-  mutable Window::WindowContentsPtr window_;
+  mutable WindowTable window_;
+  mutable std::vector<std::vector<T>> stream_buffers_;
+  size_t inputs_count_;
 };
 
 template <class T>
@@ -209,6 +402,22 @@ template <class T>
 RTP(WindowSplitterInverseTemplate<T>, count)
 
 class WindowSplitter16 : public WindowSplitterTemplate<int16_t> {
+ public:
+  virtual InstructionSet SimdInstructionSet() const noexcept override;
+
+  /// @brief Splits the input into the windows of floats. The products are
+  /// rounded the same way as Do() does, so the result equals Int16ToFloatRaw
+  /// applied to the output of Do(), without the int16 round trip.
+  /// @param streamingStores Write the windows with the non-temporal stores.
+  /// @param serial Do not split the windows on the thread pool.
+  void DoFloat(const BuffersBase<int16_t*>& in,
+               BuffersBase<float*>* out,
+               bool streamingStores = false,
+               bool serial = false) const noexcept;
+
+  /// @brief Returns the instruction set of the DoFloat() kernel.
+  InstructionSet FloatInstructionSet() const noexcept;
+
  protected:
   virtual void Do(const BuffersBase<int16_t*>& in,
                   BuffersBase<int16_t*> *out) const noexcept override;
@@ -219,7 +428,50 @@ class WindowSplitter16Inverse
       public virtual InverseUniformFormatTransform<WindowSplitter16> {
 };
 
+/// @brief WindowSplitter16 followed by Int16ToFloatRaw, which writes
+/// the windows of floats in a single pass.
+/// @details TransformTree creates this transform instead of such pairs of
+/// nodes, it is not registered in the factory.
+class WindowSplitter16F
+    : public TransformBase<formats::ArrayFormat16, formats::ArrayFormatF>,
+      public StreamingStoresTransform,
+      public ParallelTransform {
+ public:
+  /// @param splitter The WindowSplitter16 to execute, its input format
+  /// must be already set.
+  explicit WindowSplitter16F(const std::shared_ptr<Transform>& splitter);
+
+  TRANSFORM_INTRO("Window", "Splits the raw input signal into numerous "
+                            "windows of floats.",
+                  WindowSplitter16F)
+
+  const std::shared_ptr<WindowSplitter16>& splitter() const noexcept;
+
+  virtual void Initialize() const override;
+
+  virtual void ResetState() const noexcept override;
+
+  virtual Overlap RequiredOverlap(const Overlap& output)
+      const noexcept override;
+
+  virtual size_t BufferRatio() const noexcept override;
+
+  virtual InstructionSet SimdInstructionSet() const noexcept override;
+
+ protected:
+  virtual size_t OnInputFormatChanged(size_t buffersCount) override;
+
+  virtual void Do(const BuffersBase<int16_t*>& in,
+                  BuffersBase<float*>* out) const noexcept override;
+
+ private:
+  std::shared_ptr<WindowSplitter16> splitter_;
+};
+
 class WindowSplitterF : public WindowSplitterTemplate<float> {
+ public:
+  virtual InstructionSet SimdInstructionSet() const noexcept override;
+
  protected:
   virtual void Do(const BuffersBase<float*>& in,
                   BuffersBase<float*> *out) const noexcept override;
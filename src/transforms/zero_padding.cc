@@ -44,10 +44,16 @@ size_t ZeroPadding::OnFormatChanged(size_t buffersCount) {
   return buffersCount;
 }
 
+bool ZeroPadding::InPlace() const noexcept {
+  return true;
+}
+
 void ZeroPadding::Do(const float* in,
                      float* out) const noexcept {
   if (in != out) {
     memcpy(out, in, input_format_->Size() * sizeof(in[0]));
+  } else if (pad_zeroed_) {
+    return;
   }
   memsetf(out + input_format_->Size(),
           0.f,
@@ -42,11 +42,32 @@ class ZeroPadding : public OmpUniformFormatTransform<formats::ArrayFormatF> {
                                  "a power of 2.",
                   ZeroPadding)
 
+  ZeroPadding() noexcept : pad_zeroed_(false) {
+  }
+
+  /// @brief Indicates whether the pads already hold zeros, so that Do()
+  /// leaves them intact. TransformTree sets it when the padded buffers are
+  /// never shared with the other nodes, see TransformTree::Node::Pinned.
+  bool pad_zeroed() const noexcept {
+    return pad_zeroed_;
+  }
+
+  void set_pad_zeroed(bool value) noexcept {
+    pad_zeroed_ = value;
+  }
+
+  /// @brief The padded buffers may start at the same addresses as the input
+  /// ones if TransformTree lays the input out with the padded stride.
+  virtual bool InPlace() const noexcept override;
+
  protected:
   virtual size_t OnFormatChanged(size_t buffersCount) override;
 
   virtual void Do(const float* in,
                   float* out) const noexcept override;
+
+ private:
+  bool pad_zeroed_;
 };
 
 }  // namespace transforms
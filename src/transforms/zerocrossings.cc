@@ -30,188 +30,271 @@
 
 #include "src/transforms/zerocrossings.h"
 #include <simd/instruction_set.h>
+#ifdef SIMD_X86
+#include <immintrin.h>
+#elif defined(SIMD_NEON)
+#include <arm_neon.h>
+#endif
 
 namespace sound_feature_extraction {
 namespace transforms {
 
-int ZeroCrossingsF::DoInternal(bool simd, const float* input,
-                               size_t length) const noexcept {
-  int ilength = length;
-  if (simd) {
-#ifdef __AVX__
-    __m256 crossings = _mm256_setzero_ps();
-    const __m256 zeros = _mm256_setzero_ps();
-    const __m256 ones = _mm256_set1_ps(1.f);
-    for (int i = 0; i < ilength - 8; i += 8) {
-      __m256 vecpre = _mm256_load_ps(input + i);
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wold-style-cast"
-      __m256 zerocheck =  _mm256_cmp_ps(vecpre, zeros, _CMP_EQ_OQ);
-      __m256 vec = _mm256_loadu_ps(input + i + 1);
-      __m256 tmp = _mm256_mul_ps(vecpre, vec);
-      tmp = _mm256_cmp_ps(tmp, zeros, _CMP_LT_OQ);
-#pragma GCC diagnostic pop
-      tmp = _mm256_or_ps(tmp, zerocheck);
-      tmp = _mm256_blendv_ps(zeros, ones, tmp);
-      crossings = _mm256_add_ps(crossings, tmp);
-    }
-    crossings = _mm256_hadd_ps(crossings, crossings);
-    crossings = _mm256_hadd_ps(crossings, crossings);
-    int res = _mm256_get_ps(crossings, 0) + _mm256_get_ps(crossings, 4);
-    int startIndex = (ilength - 1) & ~0x7;
-    float valpre = input[startIndex];
-    for (int i = startIndex + 1; i < ilength; i++) {
-      float val = input[i];
-      if (valpre * val < 0 || valpre == 0) {
-        res++;
-      }
-      valpre = val;
-    }
-    if (valpre == 0) {
+/// @brief Counts the crossings starting from the specified index.
+template <typename T>
+static int ZeroCrossingsTail(const T* input, int start, int length) {
+  int res = 0;
+  T valpre = input[start];
+  for (int i = start + 1; i < length; i++) {
+    T val = input[i];
+    if (valpre * val < 0 || valpre == 0) {
       res++;
     }
-    return res;
-  } else {
-#elif defined(__ARM_NEON__)
-    uint32x4_t crossings = vdupq_n_u32(0), ones = vdupq_n_u32(1);
-    const float32x4_t zeros = vdupq_n_f32(0.f);
-    for (int i = 0; i < ilength - 4; i += 4) {
-      float32x4_t vecpre = vld1q_f32(input + i);
-      uint32x4_t zerocheck =  vceqq_f32(vecpre, zeros);
-      float32x4_t vec = vld1q_f32(input + i + 1);
-      float32x4_t tmp = vmulq_f32(vecpre, vec);
-      uint32x4_t cmpres = vcltq_f32(tmp, zeros);
-      cmpres = vorrq_u32(cmpres, zerocheck);
-      cmpres = vandq_u32(cmpres, ones);
-      crossings = vaddq_u32(crossings, cmpres);
-    }
-    uint64x2_t crossings64 = vpaddlq_u32(crossings);
-    int res = vgetq_lane_u64(crossings64, 0) + vgetq_lane_u64(crossings64, 1);
-    int startIndex = (ilength - 1) & ~0x3;
-    float valpre = input[startIndex];
-    for (int i = startIndex + 1; i < ilength; i++) {
-      float val = input[i];
-      if (valpre * val < 0 || valpre == 0) {
-        res++;
-      }
-      valpre = val;
-    }
-    if (valpre == 0) {
-      res++;
-    }
-    return res;
-  } else {
-#else
-  } {
-#endif
-    int res = 0;
-    float valpre = input[0];
-    for (int i = 1; i < ilength; i++) {
-      float val = input[i];
-      if (valpre * val < 0 || valpre == 0) {
-        res++;
-      }
-      valpre = val;
-    }
-    if (valpre == 0) {
-      res++;
-    }
-    return res;
+    valpre = val;
+  }
+  if (valpre == 0) {
+    res++;
   }
+  return res;
 }
 
-int ZeroCrossings16::DoInternal(bool simd, const int16_t* input,
-                                size_t length) const noexcept {
-  int ilength = length;
-  if (simd) {
-#ifdef __AVX__
-#ifdef __AVX2__
-#error TODO(v.markovtsev): AVX2 adds integer operations, implement Do properly
-#endif
-    __m128i crossings = _mm_setzero_si128();
-    const __m128i zeros = _mm_setzero_si128();
-    const __m128i ones = _mm_set1_epi16(1);
-    for (int i = 0; i < ilength - 8; i += 8) {
-      __m128i vecpre = _mm_loadu_si128(
-          reinterpret_cast<const __m128i*>(input + i));
-      __m128i zerocheck =  _mm_cmpeq_epi16(vecpre, zeros);
-      __m128i vec = _mm_loadu_si128(
-          reinterpret_cast<const __m128i*>(input + i + 1));
-      __m128i tmp = _mm_xor_si128(vecpre, vec);
-      tmp = _mm_cmplt_epi16(tmp, ones);
-      tmp = _mm_xor_si128(tmp, zerocheck);
-      tmp = _mm_and_si128(tmp, ones);
-      __m128i tmplo = _mm_unpacklo_epi16(tmp, zeros);
-      __m128i tmphi = _mm_unpackhi_epi16(tmp, zeros);
-      crossings = _mm_add_epi32(crossings, tmplo);
-      crossings = _mm_add_epi32(crossings, tmphi);
-    }
-    crossings = _mm_hadd_epi32(crossings, crossings);
+typedef int (*ZeroCrossingsFKernel)(const float* input, int length);
+typedef int (*ZeroCrossings16Kernel)(const int16_t* input, int length);
+
+static int ZeroCrossingsFScalar(const float* input, int length) {
+  return ZeroCrossingsTail(input, 0, length);
+}
+
+static int ZeroCrossings16Scalar(const int16_t* input, int length) {
+  return ZeroCrossingsTail(input, 0, length);
+}
+
+#ifdef SIMD_X86
+SIMD_TARGET("sse4.1")
+static int ZeroCrossingsFSSE41(const float* input, int length) {
+  __m128 crossings = _mm_setzero_ps();
+  const __m128 zeros = _mm_setzero_ps();
+  const __m128 ones = _mm_set1_ps(1.f);
+  int i = 0;
+  for (; i < length - 4; i += 4) {
+    __m128 vecpre = _mm_loadu_ps(input + i);
+    __m128 zerocheck = _mm_cmpeq_ps(vecpre, zeros);
+    __m128 vec = _mm_loadu_ps(input + i + 1);
+    __m128 tmp = _mm_cmplt_ps(_mm_mul_ps(vecpre, vec), zeros);
+    tmp = _mm_and_ps(_mm_or_ps(tmp, zerocheck), ones);
+    crossings = _mm_add_ps(crossings, tmp);
+  }
+  float sums[4];
+  _mm_storeu_ps(sums, crossings);
+  int res = sums[0] + sums[1] + sums[2] + sums[3];
+  return res + ZeroCrossingsTail(input, i, length);
+}
+
+SIMD_TARGET("avx")
+static int ZeroCrossingsFAVX(const float* input, int length) {
+  __m256 crossings = _mm256_setzero_ps();
+  const __m256 zeros = _mm256_setzero_ps();
+  const __m256 ones = _mm256_set1_ps(1.f);
+  int i = 0;
+  for (; i < length - 8; i += 8) {
+    __m256 vecpre = _mm256_loadu_ps(input + i);
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wold-style-cast"
-    int res = _mm_extract_epi32(crossings, 0) + _mm_extract_epi32(crossings, 2);
+    __m256 zerocheck = _mm256_cmp_ps(vecpre, zeros, _CMP_EQ_OQ);
+    __m256 vec = _mm256_loadu_ps(input + i + 1);
+    __m256 tmp = _mm256_cmp_ps(_mm256_mul_ps(vecpre, vec), zeros,
+                               _CMP_LT_OQ);
 #pragma GCC diagnostic pop
-    int startIndex = ((ilength - 1) >> 3) << 3;
-    int16_t valpre = input[startIndex];
-    for (int i = startIndex + 1; i < ilength; i++) {
-      int16_t val = input[i];
-      if (valpre * val < 0 || valpre == 0) {
-        res++;
-      }
-      valpre = val;
-    }
-    if (valpre == 0) {
-      res++;
-    }
-    return res;
-  } else {
-#elif defined(__ARM_NEON__)
-    uint32x4_t crossings = vdupq_n_u32(0);
-    uint16x8_t ones = vdupq_n_u16(1);
-    const int16x8_t zeros = vdupq_n_s16(0);
-    for (int i = 0; i < ilength - 8; i += 8) {
-      int16x8_t vecpre = vld1q_s16(input + i);
-      uint16x8_t zerocheck =  vceqq_s16(vecpre, zeros);
-      int16x8_t vec = vld1q_s16(input + i + 1);
-      int16x8_t tmp = veorq_s16(vecpre, vec);
-      uint16x8_t cmpres = vcleq_s16(tmp, zeros);
-      cmpres = veorq_u16(cmpres, zerocheck);
-      cmpres = vandq_u16(cmpres, ones);
-      crossings = vpadalq_u16(crossings, cmpres);
-    }
-    uint64x2_t crossings64 = vpaddlq_u32(crossings);
-    int res = vgetq_lane_u64(crossings64, 0) + vgetq_lane_u64(crossings64, 1);
-    int startIndex = ((ilength - 1) >> 3) << 3;
-    int16_t valpre = input[startIndex];
-    for (int i = startIndex + 1; i < ilength; i++) {
-      int16_t val = input[i];
-      if (valpre * val < 0 || valpre == 0) {
-        res++;
-      }
-      valpre = val;
-    }
-    if (valpre == 0) {
-      res++;
-    }
-    return res;
-  } else {
-#else
-  } {
+    tmp = _mm256_and_ps(_mm256_or_ps(tmp, zerocheck), ones);
+    crossings = _mm256_add_ps(crossings, tmp);
+  }
+  float sums[8];
+  _mm256_storeu_ps(sums, crossings);
+  int res = 0;
+  for (int j = 0; j < 8; j++) {
+    res += sums[j];
+  }
+  return res + ZeroCrossingsTail(input, i, length);
+}
+
+/// @brief Counts the pairs where the previous value is zero or both values
+/// are nonzero and have the opposite signs, as ZeroCrossingsTail() does.
+SIMD_TARGET("sse4.1")
+static int ZeroCrossings16SSE41(const int16_t* input, int length) {
+  __m128i crossings = _mm_setzero_si128();
+  const __m128i zeros = _mm_setzero_si128();
+  const __m128i ones = _mm_set1_epi16(1);
+  int i = 0;
+  for (; i < length - 8; i += 8) {
+    __m128i vecpre = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(input + i));
+    __m128i vec = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(input + i + 1));
+    __m128i signs = _mm_cmplt_epi16(_mm_xor_si128(vecpre, vec), zeros);
+    __m128i tmp = _mm_andnot_si128(_mm_cmpeq_epi16(vec, zeros), signs);
+    tmp = _mm_or_si128(tmp, _mm_cmpeq_epi16(vecpre, zeros));
+    tmp = _mm_madd_epi16(_mm_and_si128(tmp, ones), ones);
+    crossings = _mm_add_epi32(crossings, tmp);
+  }
+  int32_t sums[4];
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(sums), crossings);
+  int res = sums[0] + sums[1] + sums[2] + sums[3];
+  return res + ZeroCrossingsTail(input, i, length);
+}
+
+SIMD_TARGET("avx2")
+static int ZeroCrossings16AVX2(const int16_t* input, int length) {
+  __m256i crossings = _mm256_setzero_si256();
+  const __m256i zeros = _mm256_setzero_si256();
+  const __m256i ones = _mm256_set1_epi16(1);
+  int i = 0;
+  for (; i < length - 16; i += 16) {
+    __m256i vecpre = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(input + i));
+    __m256i vec = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(input + i + 1));
+    __m256i signs = _mm256_cmpgt_epi16(zeros, _mm256_xor_si256(vecpre, vec));
+    __m256i tmp = _mm256_andnot_si256(_mm256_cmpeq_epi16(vec, zeros), signs);
+    tmp = _mm256_or_si256(tmp, _mm256_cmpeq_epi16(vecpre, zeros));
+    tmp = _mm256_madd_epi16(_mm256_and_si256(tmp, ones), ones);
+    crossings = _mm256_add_epi32(crossings, tmp);
+  }
+  int32_t sums[8];
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(sums), crossings);
+  int res = 0;
+  for (int j = 0; j < 8; j++) {
+    res += sums[j];
+  }
+  return res + ZeroCrossingsTail(input, i, length);
+}
+SIMD_TARGET_AVX512
+static int ZeroCrossingsFAVX512(const float* input, int length) {
+  const __m512 zeros = _mm512_setzero_ps();
+  int res = 0;
+  int i = 0;
+  for (; i < length - 16; i += 16) {
+    __m512 vecpre = _mm512_loadu_ps(input + i);
+    __m512 vec = _mm512_loadu_ps(input + i + 1);
+    __mmask16 crossed = _mm512_cmp_ps_mask(_mm512_mul_ps(vecpre, vec), zeros,
+                                           _CMP_LT_OQ);
+    crossed |= _mm512_cmp_ps_mask(vecpre, zeros, _CMP_EQ_OQ);
+    res += __builtin_popcount(crossed);
+  }
+  // The remaining pairs, the last value of each is input[length - 1]
+  __mmask16 tail = (1u << (length - 1 - i)) - 1;
+  __m512 vecpre = _mm512_maskz_loadu_ps(tail, input + i);
+  __m512 vec = _mm512_maskz_loadu_ps(tail, input + i + 1);
+  __mmask16 crossed = _mm512_mask_cmp_ps_mask(
+      tail, _mm512_mul_ps(vecpre, vec), zeros, _CMP_LT_OQ);
+  crossed |= _mm512_mask_cmp_ps_mask(tail, vecpre, zeros, _CMP_EQ_OQ);
+  res += __builtin_popcount(crossed);
+  return res + (input[length - 1] == 0);
+}
+
+SIMD_TARGET_AVX512
+static int ZeroCrossings16AVX512(const int16_t* input, int length) {
+  const __m512i zeros = _mm512_setzero_si512();
+  int res = 0;
+  int i = 0;
+  for (; i < length - 32; i += 32) {
+    __m512i vecpre = _mm512_loadu_si512(input + i);
+    __m512i vec = _mm512_loadu_si512(input + i + 1);
+    __mmask32 signs = _mm512_cmplt_epi16_mask(
+        _mm512_xor_si512(vecpre, vec), zeros);
+    __mmask32 crossed = signs & ~_mm512_cmpeq_epi16_mask(vec, zeros);
+    crossed |= _mm512_cmpeq_epi16_mask(vecpre, zeros);
+    res += __builtin_popcount(crossed);
+  }
+  __mmask32 tail = (1ull << (length - 1 - i)) - 1;
+  __m512i vecpre = _mm512_maskz_loadu_epi16(tail, input + i);
+  __m512i vec = _mm512_maskz_loadu_epi16(tail, input + i + 1);
+  __mmask32 signs = _mm512_cmplt_epi16_mask(
+      _mm512_xor_si512(vecpre, vec), zeros);
+  __mmask32 crossed = signs & ~_mm512_cmpeq_epi16_mask(vec, zeros);
+  crossed |= _mm512_cmpeq_epi16_mask(vecpre, zeros);
+  res += __builtin_popcount(crossed & tail);
+  return res + (input[length - 1] == 0);
+}
+#elif defined(SIMD_NEON)
+static int ZeroCrossingsFNEON(const float* input, int length) {
+  uint32x4_t crossings = vdupq_n_u32(0), ones = vdupq_n_u32(1);
+  const float32x4_t zeros = vdupq_n_f32(0.f);
+  int i = 0;
+  for (; i < length - 4; i += 4) {
+    float32x4_t vecpre = vld1q_f32(input + i);
+    uint32x4_t zerocheck = vceqq_f32(vecpre, zeros);
+    float32x4_t vec = vld1q_f32(input + i + 1);
+    uint32x4_t cmpres = vcltq_f32(vmulq_f32(vecpre, vec), zeros);
+    cmpres = vandq_u32(vorrq_u32(cmpres, zerocheck), ones);
+    crossings = vaddq_u32(crossings, cmpres);
+  }
+  uint64x2_t crossings64 = vpaddlq_u32(crossings);
+  int res = vgetq_lane_u64(crossings64, 0) + vgetq_lane_u64(crossings64, 1);
+  return res + ZeroCrossingsTail(input, i, length);
+}
+
+static int ZeroCrossings16NEON(const int16_t* input, int length) {
+  uint32x4_t crossings = vdupq_n_u32(0);
+  const uint16x8_t ones = vdupq_n_u16(1);
+  const int16x8_t zeros = vdupq_n_s16(0);
+  int i = 0;
+  for (; i < length - 8; i += 8) {
+    int16x8_t vecpre = vld1q_s16(input + i);
+    int16x8_t vec = vld1q_s16(input + i + 1);
+    uint16x8_t signs = vcltq_s16(veorq_s16(vecpre, vec), zeros);
+    uint16x8_t cmpres = vbicq_u16(signs, vceqq_s16(vec, zeros));
+    cmpres = vorrq_u16(cmpres, vceqq_s16(vecpre, zeros));
+    crossings = vpadalq_u16(crossings, vandq_u16(cmpres, ones));
+  }
+  uint64x2_t crossings64 = vpaddlq_u32(crossings);
+  int res = vgetq_lane_u64(crossings64, 0) + vgetq_lane_u64(crossings64, 1);
+  return res + ZeroCrossingsTail(input, i, length);
+}
 #endif
-    int res = 0;
-    int16_t valpre = input[0];
-    for (int i = 1; i < ilength; i++) {
-      int16_t val = input[i];
-      if (valpre * val < 0 || valpre == 0) {
-        res++;
-      }
-      valpre = val;
-    }
-    if (valpre == 0) {
-      res++;
-    }
-    return res;
+
+static const SimdKernel<ZeroCrossingsFKernel> kZeroCrossingsFKernels[] {
+#ifdef SIMD_X86
+  { InstructionSet::kAVX512, ZeroCrossingsFAVX512 },
+  { InstructionSet::kAVX, ZeroCrossingsFAVX },
+  { InstructionSet::kSSE41, ZeroCrossingsFSSE41 },
+#elif defined(SIMD_NEON)
+  { InstructionSet::kNEON, ZeroCrossingsFNEON },
+#endif
+  { InstructionSet::kScalar, ZeroCrossingsFScalar }
+};
+
+static const SimdKernel<ZeroCrossings16Kernel> kZeroCrossings16Kernels[] {
+#ifdef SIMD_X86
+  { InstructionSet::kAVX512, ZeroCrossings16AVX512 },
+  { InstructionSet::kAVX2, ZeroCrossings16AVX2 },
+  { InstructionSet::kSSE41, ZeroCrossings16SSE41 },
+#elif defined(SIMD_NEON)
+  { InstructionSet::kNEON, ZeroCrossings16NEON },
+#endif
+  { InstructionSet::kScalar, ZeroCrossings16Scalar }
+};
+
+int ZeroCrossingsF::DoInternal(bool simd, const float* input,
+                               size_t length) const noexcept {
+  if (!simd) {
+    return ZeroCrossingsFScalar(input, length);
   }
+  return SimdAware::Dispatch(kZeroCrossingsFKernels).Function(input, length);
+}
+
+InstructionSet ZeroCrossingsF::SimdInstructionSet() const noexcept {
+  return SimdAware::Dispatch(kZeroCrossingsFKernels).Isa;
+}
+
+int ZeroCrossings16::DoInternal(bool simd, const int16_t* input,
+                                size_t length) const noexcept {
+  if (!simd) {
+    return ZeroCrossings16Scalar(input, length);
+  }
+  return SimdAware::Dispatch(kZeroCrossings16Kernels).Function(input, length);
+}
+
+InstructionSet ZeroCrossings16::SimdInstructionSet() const noexcept {
+  return SimdAware::Dispatch(kZeroCrossings16Kernels).Isa;
 }
 
 REGISTER_TRANSFORM(ZeroCrossingsF);
@@ -64,6 +64,9 @@ class ZeroCrossingsTemplate : public ZeroCrossingsTemplateBase<F> {
 
 class ZeroCrossingsF
     : public ZeroCrossingsTemplate<formats::ArrayFormatF> {
+ public:
+  virtual InstructionSet SimdInstructionSet() const noexcept override;
+
  protected:
   virtual int DoInternal(bool simd, const float* input, size_t length)
       const noexcept override;
@@ -71,6 +74,9 @@ class ZeroCrossingsF
 
 class ZeroCrossings16
     : public ZeroCrossingsTemplate<formats::ArrayFormat16> {
+ public:
+  virtual InstructionSet SimdInstructionSet() const noexcept override;
+
  protected:
   virtual int DoInternal(bool simd, const int16_t* input, size_t length)
       const noexcept override;
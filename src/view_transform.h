@@ -0,0 +1,77 @@
+/*! @file view_transform.h
+ *  @brief Interface of the transforms which may alias their input.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+
+#ifndef SRC_VIEW_TRANSFORM_H_
+#define SRC_VIEW_TRANSFORM_H_
+
+#include <cstddef>
+
+namespace sound_feature_extraction {
+
+/// @brief Implemented by the transforms whose output may be the input
+/// itself, laid out with the same or a smaller stride.
+/// @details TransformTree points the buffers of such a node, if it has
+/// children, at the memory of its parent instead of allocating a new block,
+/// and never executes it. The children are allocated as if they were
+/// the children of the parent, so the parent's buffers stay intact until
+/// they have been executed. Since the buffers are shared, the children
+/// never write over them in place (see Transform::InPlace()). A smaller
+/// stride makes the output buffers overlap, e.g. the frames of a signal.
+class ViewTransform {
+ public:
+#if (__GNUC__ == 4 && __GNUC_MINOR__ < 8)
+  virtual ~ViewTransform() {};
+#else
+  virtual ~ViewTransform() = default;
+#endif
+
+  /// @brief Indicates whether Do() would produce exactly the input buffers
+  /// with the current parameters and formats.
+  virtual bool IsView() const noexcept = 0;
+
+  /// @brief Returns the distance in bytes between the starts of the
+  /// sequential output buffers, or 0 if they are laid out like the input.
+  virtual size_t ViewStride() const noexcept {
+    return 0;
+  }
+
+  /// @brief Indicates whether the view requires the input buffers to follow
+  /// each other without the padding, e.g. the scalars which form an array.
+  /// TransformTree then makes the parent write the buffers so and keeps
+  /// them alive as long as the view's own, even if the view is a leaf.
+  virtual bool DenseInput() const noexcept {
+    return false;
+  }
+};
+
+}  // namespace sound_feature_extraction
+#endif  // SRC_VIEW_TRANSFORM_H_
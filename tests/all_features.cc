@@ -30,6 +30,7 @@
 
 #include <gtest/gtest.h>
 #include <fftf/api.h>
+#include <memory>
 #include "src/transform_tree.h"
 #include "src/transform_registry.h"
 #include "src/formats/array_format.h"
@@ -187,4 +188,41 @@ TEST(Features, All) {
   }
 }
 
+TEST(Features, SFMStructOfArrays) {
+  // Validation keeps the array of structs layout, so the first tree is
+  // the reference; the second one passes the means as columns
+  std::unique_ptr<TransformTree> trees[2];
+  std::unordered_map<std::string, std::shared_ptr<
+      sound_feature_extraction::Buffers>> results[2];
+  int16_t* buffers = new int16_t[48000];
+  memcpy(buffers, data, sizeof(data));
+  for (int soa = 0; soa < 2; soa++) {
+    trees[soa].reset(new TransformTree({ 48000, 22050 }));  // NOLINT(*)
+    auto& tt = *trees[soa];
+    tt.set_validate_after_each_transform(!soa);
+    tt.AddFeature("SFM", { { "Window", "type=rectangular" },
+        { "Window", "" }, { "RDFT", "" }, { "ComplexMagnitude", "" },
+        { "Mean", "types=arithmetic geometric" }, { "SFM", "" }
+    });
+    // The features must keep the layout of their buffers
+    tt.AddFeature("Means", { { "Window", "type=rectangular" },
+        { "Window", "length=256" }, { "RDFT", "" },
+        { "ComplexMagnitude", "" }, { "Mean", "types=arithmetic geometric" }
+    });
+    tt.PrepareForExecution();
+    results[soa] = tt.Execute(buffers);
+  }
+  delete[] buffers;
+  for (auto& feature : results[0]) {
+    auto& actual = results[1][feature.first];
+    ASSERT_EQ(feature.second->Count(), actual->Count());
+    actual->Validate();
+    size_t size = actual->Format()->UnalignedSizeInBytes();
+    for (size_t i = 0; i < actual->Count(); i++) {
+      ASSERT_EQ(0, memcmp((*feature.second)[i], (*actual)[i], size))
+          << feature.first << " differs at " << i;
+    }
+  }
+}
+
 #include "tests/google/src/gtest_main.cc"
@@ -0,0 +1,223 @@
+/*! @file allocators_comparison.cc
+ *  @brief Compares the memory which the buffers allocators need.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "src/allocators/interval_packing_allocator.h"
+#include "src/allocators/sliding_blocks_allocator.h"
+#include "src/allocators/worst_allocator.h"
+#include "src/transform_tree.h"
+
+using sound_feature_extraction::AllocationStrategy;
+using sound_feature_extraction::TransformTree;
+using sound_feature_extraction::memory_allocation::BuffersAllocator;
+using sound_feature_extraction::memory_allocation::IntervalPackingAllocator;
+using sound_feature_extraction::memory_allocation::Node;
+using sound_feature_extraction::memory_allocation::SlidingBlocksAllocator;
+using sound_feature_extraction::memory_allocation::WorstAllocator;
+
+typedef std::vector<std::pair<std::string,
+                              std::vector<std::pair<std::string,
+                                                    std::string>>>> Features;
+
+/// @brief The peak total size of the simultaneously live buffers
+/// in the execution order which the allocator chose (Node::Next).
+static size_t PeakLiveSize(const Node& root) {
+  std::unordered_map<const Node*, size_t> order;
+  std::vector<const Node*> nodes;
+  for (auto node = &root; node != nullptr; node = node->Next) {
+    order[node] = nodes.size();
+    nodes.push_back(node);
+  }
+  std::vector<size_t> live(nodes.size(), 0);
+  for (auto node : nodes) {
+    size_t end = nodes.size() - 1;
+    if (!node->Children.empty()) {
+      end = 0;
+      for (auto& child : node->Children) {
+        end = std::max(end, order[&child]);
+      }
+    }
+    for (size_t t = order[node]; t <= end; t++) {
+      live[t] += node->Size;
+    }
+  }
+  return *std::max_element(live.begin(), live.end());
+}
+
+static void GenerateTree(std::mt19937* rng, size_t count, Node* root,
+                         int* items) {
+  std::vector<std::vector<size_t>> children(count);
+  std::vector<size_t> sizes(count);
+  for (size_t i = 0; i < count; i++) {
+    sizes[i] = std::uniform_int_distribution<size_t>(1, 100)(*rng) * 1024;
+    if (i > 0) {
+      children[std::uniform_int_distribution<size_t>(0, i - 1)(*rng)]
+          .push_back(i);
+    }
+  }
+  std::function<void(Node*, size_t)> build = [&](Node* node, size_t index) {
+    node->Children.reserve(children[index].size());
+    for (auto child : children[index]) {
+      node->Children.push_back(Node(sizes[child], node, items + child));
+    }
+    for (size_t i = 0; i < children[index].size(); i++) {
+      build(&node->Children[i], children[index][i]);
+    }
+  };
+  root->Size = sizes[0];
+  root->Item = items;
+  build(root, 0);
+}
+
+TEST(AllocatorsComparison, RandomTrees) {
+  std::mt19937 rng(1234);
+  int items[32];
+  const int kTrees = 50;
+  double ratios[3] = { 0, 0, 0 }, relative[3] = { 0, 0, 0 };
+  const char* names[3] = { "worst", "sliding blocks", "interval packing" };
+  for (int i = 0; i < kTrees; i++) {
+    Node root(0, nullptr, nullptr);
+    GenerateTree(&rng, 4 + i % 12, &root, items);
+    std::unique_ptr<BuffersAllocator> allocators[3] = {
+      std::unique_ptr<BuffersAllocator>(new WorstAllocator()),
+      std::unique_ptr<BuffersAllocator>(new SlidingBlocksAllocator()),
+      std::unique_ptr<BuffersAllocator>(new IntervalPackingAllocator())
+    };
+    size_t sizes[3];
+    for (int a = 0; a < 3; a++) {
+      sizes[a] = allocators[a]->Solve(&root);
+      ASSERT_TRUE(allocators[a]->Validate(root)) << names[a] << ", tree " << i;
+      ratios[a] += static_cast<double>(sizes[a]) / PeakLiveSize(root);
+    }
+    ASSERT_LE(sizes[2], sizes[0]) << "tree " << i;
+    for (int a = 0; a < 3; a++) {
+      relative[a] += static_cast<double>(sizes[a]) / sizes[0];
+    }
+  }
+  printf("Average on %d random trees:\n%-18s %10s %16s\n", kTrees,
+         "Allocator", "/ worst", "/ peak live");
+  for (int a = 0; a < 3; a++) {
+    printf("%-18s %10.3f %16.3f\n", names[a], relative[a] / kTrees,
+           ratios[a] / kTrees);
+  }
+}
+
+static size_t PreparedSize(const Features& features, bool parallel,
+                           AllocationStrategy strategy) {
+  TransformTree tt( { 48000, 16000 } );  // NOLINT(*)
+  tt.set_parallel_execution(parallel);
+  tt.set_allocation_strategy(strategy);
+  for (auto& feature : features) {
+    tt.AddFeature(feature.first, feature.second);
+  }
+  tt.PrepareForExecution();
+  return tt.allocated_size();
+}
+
+TEST(AllocatorsComparison, FeatureTrees) {
+  std::vector<std::pair<std::string, Features>> trees {
+    { "MFCC + Centroid", {
+      { "MFCC", { { "Window", "length=512" }, { "RDFT", "" },
+          { "SpectralEnergy", "" }, { "FilterBank", "squared=true" },
+          { "Log", "" }, { "Square", "" }, { "DCT", "" },
+          { "Selector", "length=16" } } },
+      { "Centroid", { { "Window", "length=512" }, { "RDFT", "" },
+          { "ComplexMagnitude", "" }, { "Centroid", "" } } }
+    } },
+    { "Spectral", {
+      { "Energy", { { "Window", "type=rectangular" }, { "Window", "" },
+          { "Energy", "" } } },
+      { "Centroid", { { "Window", "type=rectangular" }, { "Window", "" },
+          { "RDFT", "" }, { "ComplexMagnitude", "" }, { "Centroid", "" } } },
+      { "Rolloff", { { "Window", "type=rectangular" }, { "Window", "" },
+          { "RDFT", "" }, { "ComplexMagnitude", "" }, { "Rolloff", "" } } },
+      { "Flux", { { "Window", "type=rectangular" }, { "Window", "" },
+          { "RDFT", "" }, { "ComplexMagnitude", "" }, { "Flux", "" } } },
+      { "SFM", { { "Window", "type=rectangular" }, { "Window", "" },
+          { "RDFT", "" }, { "ComplexMagnitude", "" },
+          { "Mean", "types=arithmetic geometric" }, { "SFM", "" } } },
+      { "DominantFrequency", { { "Window", "type=rectangular" },
+          { "Window", "" }, { "RDFT", "" }, { "ComplexMagnitude", "" },
+          { "Peaks", "number=1" } } },
+      { "MFCC", { { "Preemphasis", "value=0.2" },
+          { "Window", "type=rectangular" }, { "Window", "" },
+          { "RDFT", "" }, { "SpectralEnergy", "" },
+          { "FilterBank", "squared=true" }, { "Log", "" }, { "Square", "" },
+          { "DCT", "" }, { "Selector", "length=16, threads_number=1" },
+          { "STMSN", "length=25" } } },
+      { "MFCC_D1", { { "Preemphasis", "value=0.2" },
+          { "Window", "type=rectangular" }, { "Window", "" },
+          { "RDFT", "" }, { "SpectralEnergy", "" },
+          { "FilterBank", "squared=true" }, { "Log", "" }, { "Square", "" },
+          { "DCT", "" }, { "Selector", "length=16, threads_number=1" },
+          { "Delta", "" }, { "STMSN", "length=25" } } }
+    } },
+    { "Wavelets", {
+      { "WPP", { { "Preemphasis", "value=0.2" },
+          { "Window", "type=rectangular" }, { "DWPT", "" },
+          { "SubbandEnergy", "" }, { "Log", "" },
+          { "DWPT", "order=4, tree=1 2 3 3" },
+          { "Selector", "length=16, threads_number=1" },
+          { "STMSN", "length=25" } } },
+      { "SBC", { { "Preemphasis", "value=0.2" },
+          { "Window", "type=rectangular" }, { "DWPT", "" },
+          { "SubbandEnergy", "" }, { "Log", "" }, { "ZeroPadding", "" },
+          { "DCT", "" }, { "Selector", "length=16, threads_number=1" },
+          { "STMSN", "length=25" } } },
+      { "SBC_D1", { { "Preemphasis", "value=0.2" },
+          { "Window", "type=rectangular" }, { "DWPT", "" },
+          { "SubbandEnergy", "" }, { "Log", "" }, { "ZeroPadding", "" },
+          { "DCT", "" }, { "Selector", "length=16, threads_number=1" },
+          { "Delta", "" }, { "STMSN", "length=25" } } }
+    } }
+  };
+  printf("%-16s %12s %16s %18s\n", "Tree", "worst", "sliding blocks",
+         "interval packing");
+  for (auto& tree : trees) {
+    auto worst = PreparedSize(tree.second, true,
+                              AllocationStrategy::kSlidingBlocks);
+    auto sliding = PreparedSize(tree.second, false,
+                                AllocationStrategy::kSlidingBlocks);
+    auto packing = PreparedSize(tree.second, false,
+                                AllocationStrategy::kIntervalPacking);
+    printf("%-16s %12zu %16zu %18zu\n", tree.first.c_str(), worst, sliding,
+           packing);
+    ASSERT_LE(packing, worst) << tree.first;
+  }
+}
+
+#include "tests/google/src/gtest_main.cc"
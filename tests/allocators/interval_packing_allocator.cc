@@ -0,0 +1,120 @@
+/*! @file interval_packing_allocator.cc
+ *  @brief Tests for sound_feature_extraction::memory_allocation::IntervalPackingAllocator.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+#include "src/allocators/interval_packing_allocator.h"
+#include <gtest/gtest.h>
+#include <functional>
+#include <memory>
+#include <random>
+#include "src/allocators/worst_allocator.h"
+
+using sound_feature_extraction::memory_allocation::Node;
+using sound_feature_extraction::memory_allocation::IntervalPackingAllocator;
+using sound_feature_extraction::memory_allocation::WorstAllocator;
+
+TEST(IntervalPackingAllocator, Solve) {
+  int data;
+  int *item = &data;
+  auto root = std::make_shared<Node>(1, nullptr, item++);
+  Node* node = root.get();
+  node->Children.push_back(Node(1, node, item++));
+
+  node = &node->Children[0];
+  node->Children.push_back(Node(1, node, item++));
+
+  node->Children.push_back(Node(1, node, item++));
+  node->Children.push_back(Node(2, node, item++));
+
+  node = &node->Children[1];
+  node->Children.push_back(Node(3, node, item++));
+  node->Children.push_back(Node(2, node, item++));
+  node->Children.push_back(Node(4, node, item++));
+
+  node = &node->Children[0];
+  node->Children.push_back(Node(1, node, item++));
+  node->Children.push_back(Node(2, node, item++));
+
+  node = &node->Parent->Children[1];
+  node->Children.push_back(Node(1, node, item++));
+
+  node = &node->Children[0];
+  node->Children.push_back(Node(1, node, item++));
+
+  IntervalPackingAllocator alloc;
+  auto size = alloc.Solve(root.get());
+  root->Dump("/tmp/interval_packing_allocator_test.dot");
+  ASSERT_TRUE(alloc.Validate(*root));
+  // The leaves alone take 1 + 1 + 2 + 4 + 1 = 9
+  ASSERT_GE(size, 9U);
+  ASSERT_LT(size, WorstAllocator().Solve(root.get()));
+}
+
+/// @brief Generates a random tree with the specified number of nodes.
+static void GenerateTree(std::mt19937* rng, size_t count, Node* root,
+                         int* items) {
+  std::vector<Node*> nodes { root };
+  // The children are stored by value, so build the shape first
+  std::vector<std::vector<size_t>> children(count);
+  std::vector<size_t> sizes(count);
+  for (size_t i = 0; i < count; i++) {
+    sizes[i] = std::uniform_int_distribution<size_t>(1, 100)(*rng);
+    if (i > 0) {
+      children[std::uniform_int_distribution<size_t>(0, i - 1)(*rng)]
+          .push_back(i);
+    }
+  }
+  std::function<void(Node*, size_t)> build = [&](Node* node, size_t index) {
+    node->Children.reserve(children[index].size());
+    for (auto child : children[index]) {
+      node->Children.push_back(Node(sizes[child], node, items + child));
+    }
+    for (size_t i = 0; i < children[index].size(); i++) {
+      build(&node->Children[i], children[index][i]);
+    }
+  };
+  root->Size = sizes[0];
+  root->Item = items;
+  build(root, 0);
+}
+
+TEST(IntervalPackingAllocator, Random) {
+  std::mt19937 rng(777);
+  int items[64];
+  for (int i = 0; i < 200; i++) {
+    Node root(0, nullptr, nullptr);
+    GenerateTree(&rng, 2 + i % 60, &root, items);
+    IntervalPackingAllocator alloc;
+    auto size = alloc.Solve(&root);
+    ASSERT_TRUE(alloc.Validate(root)) << "tree " << i;
+    ASSERT_LE(size, WorstAllocator().Solve(&root)) << "tree " << i;
+  }
+}
+
+#include "tests/google/src/gtest_main.cc"
@@ -32,6 +32,7 @@
 #include "src/allocators/sliding_blocks_allocator.h"
 #include <gtest/gtest.h>
 #include <memory>
+#include <vector>
 
 using sound_feature_extraction::memory_allocation::Node;
 using sound_feature_extraction::memory_allocation::BuffersAllocator;
@@ -72,4 +73,29 @@ TEST(SlidingBlocksAllocator, Solve) {
   ASSERT_TRUE(alloc.Validate(*root));
 }
 
+TEST(SlidingBlocksAllocator, SolveClones) {
+  // The slices of a sliced cycle, too many to try all their orders
+  const int kClones = 12;
+  std::vector<int> data((kClones + 1) * 4 + 1);
+  int *item = data.data();
+  auto root = std::make_shared<Node>(4, nullptr, item++);
+  Node* node = root.get();
+  node->Children.reserve(kClones + 1);
+  for (int i = 0; i < kClones; i++) {
+    node->Children.push_back(Node(2, node, item++));
+  }
+  node->Children.push_back(Node(3, node, item++));
+  for (auto& child : node->Children) {
+    child.Children.reserve(2);
+    child.Children.push_back(Node(5, &child, item++));
+    child.Children.push_back(Node(1, &child, item++));
+    child.Children[0].Children.push_back(
+        Node(1, &child.Children[0], item++));
+  }
+
+  SlidingBlocksAllocator alloc;
+  ASSERT_EQ(alloc.Solve(root.get()), 45U);
+  ASSERT_TRUE(alloc.Validate(*root));
+}
+
 #include "tests/google/src/gtest_main.cc"
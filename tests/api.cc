@@ -29,7 +29,12 @@
  */
 
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <map>
+#include <mutex>
 #include <sound_feature_extraction/api.h>
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wold-style-cast"
@@ -37,6 +42,7 @@
 #pragma GCC diagnostic pop
 #include <fstream>
 #include <streambuf>
+#include <thread>
 
 TEST(API, query_transforms_list) {
   char** names = nullptr;
@@ -162,13 +168,32 @@ TEST(API, report_extraction_graph) {
   destroy_features_configuration(config);
 }
 
+TEST(API, explain_features_configuration) {
+  auto config = test_calculate_features();
+  auto explanation = explain_features_configuration(config);
+  ASSERT_NE(nullptr, explanation);
+  std::string plan(explanation);
+  destroy_features_configuration_explanation(explanation);
+  EXPECT_EQ(0U, plan.find("# features: MFCC"));
+  EXPECT_NE(std::string::npos, plan.find("RDFT + SpectralEnergy"));
+  report_extraction_graph_annotated(
+      config, "/tmp/test_report_extraction_graph_annotated.dot");
+  struct stat res;
+  ASSERT_EQ(0, stat("/tmp/test_report_extraction_graph_annotated.dot",
+                    &res));
+  destroy_features_configuration(config);
+}
+
 TEST(API, report_extraction_time) {
   auto config = test_calculate_features();
   char** transformNames;
   float* values;
   int length;
   report_extraction_time(config, &transformNames, &values, &length);
-  ASSERT_EQ(10 + 1, length);
+  // Window and the int16 to float conversion are fused into a single
+  // splitter, RDFT and SpectralEnergy - into PowerSpectrum, Log and Square -
+  // into ElementwiseChain, DCT and Selector - into DCT
+  ASSERT_EQ(6 + 1, length);
   ASSERT_NE(nullptr, transformNames);
   ASSERT_NE(nullptr, values);
   for (int i = 0; i < length; i++) {
@@ -182,5 +207,2062 @@ TEST(API, report_extraction_time) {
   destroy_features_configuration(config);
 }
 
+TEST(API, extraction_profile) {
+  const char *features[] = {
+      "MFCC [Window(length=512), RDFT, SpectralEnergy,"
+      "FilterBank(squared=true), Log, Square, DCT, Selector(length=16)]",
+      "Energy [Window(length=512), Energy]"
+  };
+  auto config = setup_features_extraction(features, 2, 48000, 16000);
+  ASSERT_NE(nullptr, config);
+  auto buffer = new int16_t[48000];
+  for (int i = 0; i < 48000; i++) {
+    buffer[i] = sinf(i / 4.0f) * INT16_MAX;
+  }
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_ERROR,
+            save_extraction_trace(config, "/tmp/test_extraction_trace.json"));
+  set_extraction_profiling(config, EXTRACTION_PROFILING_TRACE);
+  for (int i = 0; i < 3; i++) {
+    char **featureNames;
+    void **results;
+    int *lengths;
+    ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+        config, buffer, &featureNames, &results, &lengths));
+    free_results(2, featureNames, results, lengths);
+  }
+  char **nodeNames;
+  NodeProfile *profiles;
+  int length;
+  report_extraction_profile(config, &nodeNames, &profiles, &length);
+  ASSERT_GT(length, 0);
+  bool window_found = false;
+  for (int i = 0; i < length; i++) {
+    ASSERT_NE(nullptr, nodeNames[i]);
+    ASSERT_EQ(3, profiles[i].calls);
+    ASSERT_GT(profiles[i].total, 0.f);
+    ASSERT_LE(profiles[i].median, profiles[i].p99);
+    ASSERT_GT(profiles[i].bytes_in, 0U);
+    ASSERT_GT(profiles[i].bytes_out, 0U);
+    if (!strcmp(nodeNames[i], "Window [Energy, MFCC]") ||
+        !strcmp(nodeNames[i], "Window [MFCC, Energy]")) {
+      window_found = true;
+    }
+  }
+  ASSERT_TRUE(window_found);
+  destroy_extraction_profile(nodeNames, profiles, length);
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK,
+            save_extraction_trace(config, "/tmp/test_extraction_trace.json"));
+  set_extraction_profiling(config, EXTRACTION_PROFILING_NONE);
+  report_extraction_profile(config, &nodeNames, &profiles, &length);
+  ASSERT_EQ(0, length);
+  destroy_extraction_profile(nodeNames, profiles, length);
+  destroy_features_configuration(config);
+  delete[] buffer;
+}
+
+TEST(API, report_extraction_counters) {
+  ASSERT_EQ(PROFILING_LEVEL_COARSE, get_profiling_level());
+  set_profiling_level(PROFILING_LEVEL_FULL);
+  ASSERT_EQ(PROFILING_LEVEL_FULL, get_profiling_level());
+  auto config = test_calculate_features();
+  set_profiling_level(PROFILING_LEVEL_COARSE);
+  char **nodeNames;
+  NodeHardwareCounters *counters;
+  int length;
+  report_extraction_counters(config, &nodeNames, &counters, &length);
+  ASSERT_GT(length, 0);
+  for (int i = 0; i < length; i++) {
+    ASSERT_NE(nullptr, nodeNames[i]);
+    ASSERT_GE(counters[i].ipc, 0.f);
+    ASSERT_GE(counters[i].bandwidth, 0.f);
+    if (counters[i].cycles > 0) {
+      ASSERT_GT(counters[i].instructions, 0U) << nodeNames[i];
+      ASSERT_GT(counters[i].ipc, 0.f) << nodeNames[i];
+    }
+  }
+  bool counted = counters[0].cycles > 0;
+  destroy_extraction_counters(nodeNames, counters, length);
+  report_extraction_graph(config, "/tmp/test_report_extraction_counters.dot");
+  std::ifstream dotFile("/tmp/test_report_extraction_counters.dot");
+  std::string dotStr((std::istreambuf_iterator<char>(dotFile)),
+                     std::istreambuf_iterator<char>());
+  ASSERT_EQ(counted, dotStr.find("LLC misses") != std::string::npos);
+  // Without PROFILING_LEVEL_FULL the counters are zeros
+  destroy_features_configuration(config);
+  config = test_calculate_features();
+  report_extraction_counters(config, &nodeNames, &counters, &length);
+  for (int i = 0; i < length; i++) {
+    ASSERT_EQ(0U, counters[i].cycles);
+    ASSERT_EQ(0U, counters[i].llc_misses);
+  }
+  destroy_extraction_counters(nodeNames, counters, length);
+  destroy_features_configuration(config);
+}
+
+TEST(API, report_extraction_instruction_sets) {
+  auto best = get_instruction_set();
+  ASSERT_EQ(INSTRUCTION_SET_AVX512, get_max_instruction_set());
+  auto config = test_calculate_features();
+  char **nodeNames;
+  InstructionSetType *instructionSets;
+  int length;
+  report_extraction_instruction_sets(config, &nodeNames, &instructionSets,
+                                     &length);
+  ASSERT_GT(length, 0);
+  bool windowFound = false;
+  for (int i = 0; i < length; i++) {
+    ASSERT_NE(nullptr, nodeNames[i]);
+    if (std::string(nodeNames[i]).find("Window ") == 0) {
+      windowFound = true;
+      ASSERT_LE(instructionSets[i], best) << nodeNames[i];
+    }
+  }
+  ASSERT_TRUE(windowFound);
+  destroy_extraction_instruction_sets(nodeNames, instructionSets, length);
+  set_max_instruction_set(INSTRUCTION_SET_SCALAR);
+  ASSERT_EQ(INSTRUCTION_SET_SCALAR, get_instruction_set());
+  report_extraction_instruction_sets(config, &nodeNames, &instructionSets,
+                                     &length);
+  for (int i = 0; i < length; i++) {
+    if (std::string(nodeNames[i]).find("Window ") == 0) {
+      ASSERT_EQ(INSTRUCTION_SET_SCALAR, instructionSets[i]) << nodeNames[i];
+    }
+  }
+  destroy_extraction_instruction_sets(nodeNames, instructionSets, length);
+  set_max_instruction_set(INSTRUCTION_SET_AVX512);
+  ASSERT_EQ(best, get_instruction_set());
+  destroy_features_configuration(config);
+}
+
+TEST(API, report_extraction_memory) {
+  const char *feature = "MFCC [Window(length=512), RDFT, SpectralEnergy,"
+      "FilterBank(squared=true), Log, Square, DCT, Selector(length=16)]";
+  auto config = setup_features_extraction(&feature, 1, 48000, 16000);
+  ASSERT_NE(nullptr, config);
+  ExtractionMemoryUsage usage;
+  char **nodeNames;
+  NodeMemoryUsage *nodes;
+  int length;
+  report_extraction_memory(config, &usage, &nodeNames, &nodes, &length);
+  ASSERT_GT(length, 0);
+  ASSERT_GT(usage.peak, 0U);
+  ASSERT_LE(usage.peak, usage.allocated);
+  ASSERT_GE(usage.buffers, usage.peak);
+  size_t buffers = 0, privateMemory = 0;
+  bool filterBankFound = false;
+  for (int i = 0; i < length; i++) {
+    ASSERT_NE(nullptr, nodeNames[i]);
+    buffers += nodes[i].buffers;
+    privateMemory += nodes[i].private_memory;
+    if (std::string(nodeNames[i]).find("FilterBank ") == 0) {
+      filterBankFound = true;
+      ASSERT_GT(nodes[i].private_memory, 0U);
+    }
+  }
+  ASSERT_TRUE(filterBankFound);
+  ASSERT_EQ(usage.buffers, buffers);
+  ASSERT_EQ(usage.private_memory, privateMemory);
+  destroy_extraction_memory(nodeNames, nodes, length);
+  destroy_features_configuration(config);
+}
+
+TEST(API, setup_features_extraction_blocks) {
+  const char *features[] = {
+      "MFCC [Window(length=512), RDFT, SpectralEnergy,"
+      "FilterBank(squared=true), Log, DCT, Selector(length=16),"
+      "Delta(type=regression, acceleration=true), STMSN(length=25)]",
+      "Energy [Window(length=400, step=160), Energy]"
+  };
+  const size_t size = 48000;
+  auto whole = setup_features_extraction(features, 2, size, 16000);
+  ASSERT_NE(nullptr, whole);
+  auto blocks = setup_features_extraction_blocks(features, 2, size, 4096,
+                                                 16000);
+  ASSERT_NE(nullptr, blocks);
+  auto buffer = new int16_t[size];
+  for (size_t i = 0; i < size; i++) {
+    buffer[i] = sinf(i / 4.0f) * INT16_MAX * (i % 1000) / 1000;
+  }
+  char **wholeNames, **blocksNames;
+  float **wholeResults, **blocksResults;
+  int *wholeLengths, *blocksLengths;
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+      whole, buffer, &wholeNames, reinterpret_cast<void ***>(&wholeResults),
+      &wholeLengths));
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+      blocks, buffer, &blocksNames,
+      reinterpret_cast<void ***>(&blocksResults), &blocksLengths));
+  for (int i = 0; i < 2; i++) {
+    int j = std::string(wholeNames[i]) == blocksNames[0]? 0 : 1;
+    ASSERT_STREQ(wholeNames[i], blocksNames[j]);
+    ASSERT_EQ(wholeLengths[i], blocksLengths[j]);
+    ASSERT_EQ(0, memcmp(wholeResults[i], blocksResults[j], wholeLengths[i]))
+        << wholeNames[i];
+  }
+  free_results(2, wholeNames, reinterpret_cast<void **>(wholeResults),
+               wholeLengths);
+  free_results(2, blocksNames, reinterpret_cast<void **>(blocksResults),
+               blocksLengths);
+  delete[] buffer;
+  destroy_features_configuration(blocks);
+  destroy_features_configuration(whole);
+  // Stats depend on all the windows of the interval
+  const char *stats = "Stats [Window, Energy, Stats(interval=50)]";
+  ASSERT_EQ(nullptr, setup_features_extraction_blocks(&stats, 1, size, 4096,
+                                                      16000));
+}
+
+TEST(API, extract_sound_features_ragged) {
+  const char *features[] = {
+      "MFCC [Window(length=512), RDFT, SpectralEnergy,"
+      "FilterBank(squared=true), Log, DCT, Selector(length=16),"
+      "Delta(type=regression, acceleration=true), STMSN(length=25)]",
+      "Energy [Window(length=400, step=160), Energy]"
+  };
+  const size_t sizes[] = { 48000, 7000, 21000 };
+  auto ragged = setup_features_extraction_ragged(features, 2, 4096, 4,
+                                                 16000);
+  ASSERT_NE(nullptr, ragged);
+  const int16_t *clips[3];
+  for (int c = 0; c < 3; c++) {
+    auto clip = new int16_t[sizes[c]];
+    for (size_t i = 0; i < sizes[c]; i++) {
+      clip[i] = sinf(i / (4.0f + c)) * INT16_MAX * (i % 1000) / 1000;
+    }
+    clips[c] = clip;
+  }
+  int count;
+  char **raggedNames;
+  void **raggedResults;
+  int *raggedLengths;
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features_ragged(
+      ragged, clips, sizes, 3, &count, &raggedNames, &raggedResults,
+      &raggedLengths));
+  ASSERT_EQ(2, count);
+  for (int c = 0; c < 3; c++) {
+    auto whole = setup_features_extraction(features, 2, sizes[c], 16000);
+    ASSERT_NE(nullptr, whole);
+    char **wholeNames;
+    void **wholeResults;
+    int *wholeLengths;
+    ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+        whole, const_cast<int16_t *>(clips[c]), &wholeNames, &wholeResults,
+        &wholeLengths));
+    for (int i = 0; i < 2; i++) {
+      int j = std::string(wholeNames[i]) == raggedNames[0]? 0 : 1;
+      ASSERT_STREQ(wholeNames[i], raggedNames[j]);
+      ASSERT_EQ(wholeLengths[i], raggedLengths[c * count + j]);
+      ASSERT_EQ(0, memcmp(wholeResults[i], raggedResults[c * count + j],
+                          wholeLengths[i])) << wholeNames[i] << " " << c;
+    }
+    free_results(2, wholeNames, wholeResults, wholeLengths);
+    destroy_features_configuration(whole);
+  }
+  free_ragged_results(count, 3, raggedNames, raggedResults, raggedLengths);
+  for (int c = 0; c < 3; c++) {
+    delete[] clips[c];
+  }
+  destroy_features_configuration(ragged);
+  const char *stats = "Stats [Window, Energy, Stats(interval=50)]";
+  ASSERT_EQ(nullptr, setup_features_extraction_ragged(&stats, 1, 4096, 4,
+                                                      16000));
+}
+
+TEST(API, setup_features_extraction_budget) {
+  const char *features[] = {
+      "MFCC [Window(length=512), RDFT, SpectralEnergy,"
+      "FilterBank(squared=true), Log, DCT, Selector(length=16),"
+      "Delta(type=regression, acceleration=true), STMSN(length=25)]",
+      "Energy [Window(length=400, step=160), Energy]"
+  };
+  const size_t size = 48000;
+  ExtractionPlan plan;
+  auto whole = setup_features_extraction_budget(features, 2, size, 16000,
+                                                1 << 30, &plan);
+  ASSERT_NE(nullptr, whole);
+  ASSERT_EQ(EXTRACTION_PLAN_WHOLE, plan.type);
+  ASSERT_EQ(1, plan.count);
+  ASSERT_EQ(size, plan.size);
+  size_t budget = plan.memory / 4;
+  auto blocks = setup_features_extraction_budget(features, 2, size, 16000,
+                                                 budget, &plan);
+  ASSERT_NE(nullptr, blocks);
+  ASSERT_EQ(EXTRACTION_PLAN_BLOCKS, plan.type);
+  ASSERT_GT(plan.count, 1);
+  ASSERT_LT(plan.size, size);
+  ASSERT_LE(plan.memory, budget);
+  auto buffer = new int16_t[size];
+  for (size_t i = 0; i < size; i++) {
+    buffer[i] = sinf(i / 4.0f) * INT16_MAX * (i % 1000) / 1000;
+  }
+  char **wholeNames, **blocksNames;
+  float **wholeResults, **blocksResults;
+  int *wholeLengths, *blocksLengths;
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+      whole, buffer, &wholeNames, reinterpret_cast<void ***>(&wholeResults),
+      &wholeLengths));
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+      blocks, buffer, &blocksNames,
+      reinterpret_cast<void ***>(&blocksResults), &blocksLengths));
+  for (int i = 0; i < 2; i++) {
+    int j = std::string(wholeNames[i]) == blocksNames[0]? 0 : 1;
+    ASSERT_STREQ(wholeNames[i], blocksNames[j]);
+    ASSERT_EQ(wholeLengths[i], blocksLengths[j]);
+    ASSERT_EQ(0, memcmp(wholeResults[i], blocksResults[j], wholeLengths[i]))
+        << wholeNames[i];
+  }
+  free_results(2, wholeNames, reinterpret_cast<void **>(wholeResults),
+               wholeLengths);
+  free_results(2, blocksNames, reinterpret_cast<void **>(blocksResults),
+               blocksLengths);
+  delete[] buffer;
+  destroy_features_configuration(blocks);
+  destroy_features_configuration(whole);
+  // Stats depend on all the windows of the interval
+  const char *stats = "Stats [Window, Energy, Stats(interval=50)]";
+  auto config = setup_features_extraction_budget(&stats, 1, size, 16000,
+                                                 1 << 30, &plan);
+  ASSERT_NE(nullptr, config);
+  budget = plan.memory / 4;
+  destroy_features_configuration(config);
+  config = setup_features_extraction_budget(&stats, 1, size, 16000, budget,
+                                            &plan);
+  ASSERT_NE(nullptr, config);
+  ASSERT_EQ(EXTRACTION_PLAN_CHUNKS, plan.type);
+  ASSERT_GT(plan.count, 1);
+  ASSERT_LE(plan.memory, budget);
+  destroy_features_configuration(config);
+  ASSERT_EQ(nullptr, setup_features_extraction_budget(features, 2, size,
+                                                      16000, 16, &plan));
+}
+
+TEST(API, setup_features_extraction_variants) {
+  const char *features[] = {
+      "MFCC [Window(length=512), RDFT, SpectralEnergy,"
+      "FilterBank(number=32), Log, DCT, Selector(length=16)]",
+      "Energy [Window(length=512), Energy]",
+      "MFCC [Window(length=512), RDFT, SpectralEnergy,"
+      "FilterBank(number=40), Log, DCT, Selector(length=20)]",
+      "Energy [Window(length=512), Energy]"
+  };
+  const int sizes[] = { 2, 2 };
+  const size_t size = 48000;
+  auto config = setup_features_extraction_variants(features, sizes, 2, size,
+                                                   16000);
+  ASSERT_NE(nullptr, config);
+  auto buffer = new int16_t[size];
+  for (size_t i = 0; i < size; i++) {
+    buffer[i] = sinf(i / 4.0f) * INT16_MAX * (i % 1000) / 1000;
+  }
+  char **names;
+  float **results;
+  int *lengths, *variants;
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features_variants(
+      config, buffer, &names, reinterpret_cast<void ***>(&results), &lengths,
+      &variants));
+  int seen[2] = { 0, 0 };
+  for (int variant = 0; variant < 2; variant++) {
+    auto single = setup_features_extraction(features + variant * 2, 2, size,
+                                            16000);
+    ASSERT_NE(nullptr, single);
+    char **singleNames;
+    float **singleResults;
+    int *singleLengths;
+    ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+        single, buffer, &singleNames,
+        reinterpret_cast<void ***>(&singleResults), &singleLengths));
+    for (int i = 0; i < 4; i++) {
+      if (variants[i] != variant) {
+        continue;
+      }
+      seen[variant]++;
+      int j = std::string(names[i]) == singleNames[0]? 0 : 1;
+      ASSERT_STREQ(singleNames[j], names[i]);
+      ASSERT_EQ(singleLengths[j], lengths[i]);
+      ASSERT_EQ(0, memcmp(singleResults[j], results[i], lengths[i]))
+          << names[i];
+    }
+    free_results(2, singleNames, reinterpret_cast<void **>(singleResults),
+                 singleLengths);
+    destroy_features_configuration(single);
+  }
+  ASSERT_EQ(2, seen[0]);
+  ASSERT_EQ(2, seen[1]);
+  free_results(4, names, reinterpret_cast<void **>(results), lengths);
+  free_result_variants(variants);
+  // The windows and the spectrum are shared
+  ExtractionMemoryUsage usage;
+  char **nodeNames;
+  NodeMemoryUsage *nodes;
+  int nodesCount;
+  report_extraction_memory(config, &usage, &nodeNames, &nodes, &nodesCount);
+  int windows = 0;
+  for (int i = 0; i < nodesCount; i++) {
+    if (std::string(nodeNames[i]).find("Window") == 0) {
+      windows++;
+    }
+  }
+  ASSERT_EQ(1, windows);
+  destroy_extraction_memory(nodeNames, nodes, nodesCount);
+  delete[] buffer;
+  destroy_features_configuration(config);
+}
+
+TEST(API, extract_sound_features_subset) {
+  const char *features[] = {
+      "MFCC [Window(length=512), RDFT, SpectralEnergy,"
+      "FilterBank(squared=true), Log, Square, DCT, Selector(length=16)]",
+      "Energy [Window(length=512), Energy]"
+  };
+  auto config = setup_features_extraction(features, 2, 48000, 16000);
+  ASSERT_NE(nullptr, config);
+  auto buffer = new int16_t[48000];
+  for (int i = 0; i < 48000; i++) {
+    buffer[i] = sinf(i / 4.0f) * INT16_MAX;
+  }
+  char **featureNames = nullptr;
+  void **results = nullptr;
+  int *lengths = nullptr;
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+      config, buffer, &featureNames, &results, &lengths));
+  int mfcc = strcmp(featureNames[0], "MFCC")? 1 : 0;
+  const char *subset = "MFCC";
+  char **subsetNames = nullptr;
+  void **subsetResults = nullptr;
+  int *subsetLengths = nullptr;
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features_subset(
+      config, buffer, &subset, 1, &subsetNames, &subsetResults,
+      &subsetLengths));
+  ASSERT_STREQ("MFCC", subsetNames[0]);
+  ASSERT_EQ(lengths[mfcc], subsetLengths[0]);
+  ASSERT_EQ(0, memcmp(results[mfcc], subsetResults[0], lengths[mfcc]));
+  free_results(1, subsetNames, subsetResults, subsetLengths);
+  const char *missing = "Centroid";
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_ERROR, extract_sound_features_subset(
+      config, buffer, &missing, 1, &subsetNames, &subsetResults,
+      &subsetLengths));
+  free_results(2, featureNames, results, lengths);
+  destroy_features_configuration(config);
+  delete[] buffer;
+}
+
+static void sink_feature(const char *featureName, const void *result,
+                         int resultLength, int chunk, void *userData) {
+  auto sunk = reinterpret_cast<
+      std::map<std::string, std::vector<char>>*>(userData);
+  static std::mutex mutex;
+  std::lock_guard<std::mutex> lock(mutex);
+  EXPECT_EQ(0, chunk);
+  auto bytes = reinterpret_cast<const char*>(result);
+  (*sunk)[featureName].assign(bytes, bytes + resultLength);
+}
+
+TEST(API, extract_sound_features_sink) {
+  const char *features[] = {
+      "MFCC [Window(length=512), RDFT, SpectralEnergy,"
+      "FilterBank(squared=true), Log, Square, DCT, Selector(length=16)]",
+      "Energy [Window(length=512), Energy]"
+  };
+  auto config = setup_features_extraction(features, 2, 48000, 16000);
+  ASSERT_NE(nullptr, config);
+  auto buffer = new int16_t[48000];
+  for (int i = 0; i < 48000; i++) {
+    buffer[i] = sinf(i / 4.0f) * INT16_MAX;
+  }
+  char **featureNames = nullptr;
+  void **results = nullptr;
+  int *lengths = nullptr;
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+      config, buffer, &featureNames, &results, &lengths));
+  std::map<std::string, std::vector<char>> sunk;
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features_sink(
+      config, buffer, sink_feature, &sunk));
+  ASSERT_EQ(2U, sunk.size());
+  for (int i = 0; i < 2; i++) {
+    auto& result = sunk[featureNames[i]];
+    ASSERT_EQ(lengths[i], static_cast<int>(result.size()));
+    ASSERT_EQ(0, memcmp(results[i], result.data(), lengths[i]))
+        << featureNames[i];
+  }
+  // The sink is not left in the tree
+  sunk.clear();
+  free_results(2, featureNames, results, lengths);
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+      config, buffer, &featureNames, &results, &lengths));
+  ASSERT_TRUE(sunk.empty());
+  free_results(2, featureNames, results, lengths);
+  destroy_features_configuration(config);
+  delete[] buffer;
+}
+
+TEST(API, extract_sound_features_deadline) {
+  const char *features[] = {
+      "MFCC [Window(length=512), RDFT, SpectralEnergy,"
+      "FilterBank(squared=true), Log, Square, DCT, Selector(length=16)]",
+      "Energy [Window(length=512), Energy]"
+  };
+  auto config = setup_features_extraction(features, 2, 48000, 16000);
+  ASSERT_NE(nullptr, config);
+  auto buffer = new int16_t[48000];
+  for (int i = 0; i < 48000; i++) {
+    buffer[i] = sinf(i / 4.0f) * INT16_MAX;
+  }
+  ASSERT_TRUE(set_feature_priority(config, "Energy", 1));
+  ASSERT_FALSE(set_feature_priority(config, "Centroid", 1));
+  char **featureNames = nullptr;
+  void **results = nullptr;
+  int *lengths = nullptr;
+  int count = 0;
+  char **skippedNames = nullptr;
+  int skippedCount = 0;
+  // Measures the times of the nodes
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features_deadline(
+      config, buffer, 1000000000, &featureNames, &results, &lengths, &count,
+      &skippedNames, &skippedCount));
+  ASSERT_EQ(2, count);
+  ASSERT_EQ(0, skippedCount);
+  ASSERT_EQ(nullptr, skippedNames);
+  free_results(count, featureNames, results, lengths);
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features_deadline(
+      config, buffer, 0, &featureNames, &results, &lengths, &count,
+      &skippedNames, &skippedCount));
+  ASSERT_EQ(1, count);
+  ASSERT_STREQ("Energy", featureNames[0]);
+  ASSERT_EQ(1, skippedCount);
+  ASSERT_STREQ("MFCC", skippedNames[0]);
+  free_results(count, featureNames, results, lengths);
+  free_results(skippedCount, skippedNames, nullptr, nullptr);
+  destroy_features_configuration(config);
+  delete[] buffer;
+}
+
+TEST(API, set_transform_parameter) {
+  const char *features[] = {
+      "Energy [Preemphasis, Window(length=512), Energy]"
+  };
+  const char *updatedFeatures[] = {
+      "Energy [Preemphasis(value=0.5), Window(length=512), Energy]"
+  };
+  auto config = setup_features_extraction(features, 1, 48000, 16000);
+  ASSERT_NE(nullptr, config);
+  ASSERT_TRUE(set_transform_parameter(config, "Energy", "Preemphasis",
+                                      "value", "0.5"));
+  ASSERT_FALSE(set_transform_parameter(config, "Energy", "Preemphasis",
+                                       "value", "2"));
+  ASSERT_FALSE(set_transform_parameter(config, "Energy", "Window",
+                                       "length", "256"));
+  ASSERT_FALSE(set_transform_parameter(config, "Energy", "RDFT", "", ""));
+  auto expectedConfig = setup_features_extraction(updatedFeatures, 1, 48000,
+                                                  16000);
+  ASSERT_NE(nullptr, expectedConfig);
+  auto buffer = new int16_t[48000];
+  for (int i = 0; i < 48000; i++) {
+    buffer[i] = sinf(i / 4.0f) * INT16_MAX;
+  }
+  char **featureNames[2];
+  void **results[2];
+  int *lengths[2];
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+      config, buffer, &featureNames[0], &results[0], &lengths[0]));
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+      expectedConfig, buffer, &featureNames[1], &results[1], &lengths[1]));
+  ASSERT_EQ(lengths[1][0], lengths[0][0]);
+  ASSERT_EQ(0, memcmp(results[1][0], results[0][0], lengths[0][0]));
+  free_results(1, featureNames[0], results[0], lengths[0]);
+  free_results(1, featureNames[1], results[1], lengths[1]);
+  destroy_features_configuration(expectedConfig);
+  destroy_features_configuration(config);
+  delete[] buffer;
+}
+
+TEST(API, extract_sound_features_into) {
+  const char *features[] = {
+      "MFCC [Window(length=512), RDFT, SpectralEnergy,"
+      "FilterBank(squared=true), Log, Square, DCT, Selector(length=16)]",
+      "Energy [Window(length=512), Energy]"
+  };
+  auto config = setup_features_extraction(features, 2, 48000, 16000);
+  ASSERT_NE(nullptr, config);
+  auto buffer = new int16_t[48000];
+  for (int i = 0; i < 48000; i++) {
+    buffer[i] = sinf(i / 4.0f) * INT16_MAX;
+  }
+  char **layoutNames = nullptr;
+  int *layoutLengths = nullptr;
+  int count = 0;
+  query_features_layout(config, &layoutNames, &layoutLengths, &count);
+  ASSERT_EQ(2, count);
+  ASSERT_STREQ("Energy", layoutNames[0]);
+  ASSERT_STREQ("MFCC", layoutNames[1]);
+  void *outputs[2];
+  for (int i = 0; i < count; i++) {
+    outputs[i] = new char[layoutLengths[i]];
+  }
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK,
+            extract_sound_features_into(config, buffer, outputs));
+
+  char **featureNames = nullptr;
+  void **results = nullptr;
+  int *lengths = nullptr;
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+      config, buffer, &featureNames, &results, &lengths));
+  const FeatureView *views = nullptr;
+  int viewsCount = 0;
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features_views(
+      config, buffer, &views, &viewsCount));
+  ASSERT_EQ(2, viewsCount);
+  for (int i = 0; i < count; i++) {
+    int index = strcmp(featureNames[i], layoutNames[0])? 1 : 0;
+    ASSERT_EQ(layoutLengths[index], lengths[i]);
+    ASSERT_EQ(0, memcmp(results[i], outputs[index], lengths[i]));
+    const FeatureView& view = views[strcmp(views[0].name, featureNames[i])?
+                                    1 : 0];
+    ASSERT_STREQ(featureNames[i], view.name);
+    ASSERT_EQ(lengths[i], view.count * view.size);
+    ASSERT_GE(view.stride, view.size);
+    for (int k = 0; k < view.count; k++) {
+      ASSERT_EQ(0, memcmp(reinterpret_cast<const char*>(view.data) +
+                              k * view.stride,
+                          reinterpret_cast<char*>(results[i]) + k * view.size,
+                          view.size));
+    }
+  }
+  for (int i = 0; i < count; i++) {
+    delete[] reinterpret_cast<char*>(outputs[i]);
+  }
+  free_results(count, layoutNames, nullptr, layoutLengths);
+  free_results(count, featureNames, results, lengths);
+  destroy_features_configuration(config);
+  delete[] buffer;
+}
+
+TEST(API, extract_sound_features_arrow) {
+  const char *features[] = {
+      "MFCC [Window(length=512), RDFT, SpectralEnergy,"
+      "FilterBank(squared=true), Log, Square, DCT, Selector(length=16)]",
+      "Energy [Window(length=512), Energy]"
+  };
+  auto config = setup_features_extraction(features, 2, 48000, 16000);
+  ASSERT_NE(nullptr, config);
+  auto buffer = new int16_t[48000];
+  for (int i = 0; i < 48000; i++) {
+    buffer[i] = sinf(i / 4.0f) * INT16_MAX;
+  }
+  char **layoutNames = nullptr;
+  int *layoutLengths = nullptr;
+  int count = 0;
+  query_features_layout(config, &layoutNames, &layoutLengths, &count);
+  ASSERT_EQ(2, count);
+  void *outputs[2];
+  for (int i = 0; i < count; i++) {
+    outputs[i] = new char[layoutLengths[i]];
+  }
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK,
+            extract_sound_features_into(config, buffer, outputs));
+  ArrowSchema schemas[2];
+  ArrowArray arrays[2];
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK,
+            extract_sound_features_arrow(config, buffer, schemas, arrays));
+  // Energy is a single number per window
+  ASSERT_STREQ("Energy", schemas[0].name);
+  ASSERT_STREQ("f", schemas[0].format);
+  ASSERT_EQ(2, arrays[0].n_buffers);
+  ASSERT_EQ(layoutLengths[0], arrays[0].length * 4);
+  ASSERT_EQ(0, memcmp(outputs[0], arrays[0].buffers[1], layoutLengths[0]));
+  // MFCC is a list of 16 numbers per window
+  ASSERT_STREQ("MFCC", schemas[1].name);
+  ASSERT_STREQ("+w:16", schemas[1].format);
+  ASSERT_EQ(1, schemas[1].n_children);
+  ASSERT_STREQ("f", schemas[1].children[0]->format);
+  ASSERT_EQ(1, arrays[1].n_children);
+  ASSERT_EQ(arrays[1].length * 16, arrays[1].children[0]->length);
+  ASSERT_EQ(layoutLengths[1], arrays[1].length * 16 * 4);
+  ASSERT_EQ(0, memcmp(outputs[1], arrays[1].children[0]->buffers[1],
+                      layoutLengths[1]));
+  for (int i = 0; i < count; i++) {
+    schemas[i].release(&schemas[i]);
+    ASSERT_EQ(nullptr, schemas[i].release);
+    arrays[i].release(&arrays[i]);
+    ASSERT_EQ(nullptr, arrays[i].release);
+    delete[] reinterpret_cast<char*>(outputs[i]);
+  }
+  free_results(count, layoutNames, nullptr, layoutLengths);
+  destroy_features_configuration(config);
+  delete[] buffer;
+}
+
+TEST(API, query_features_dtypes) {
+  const char *features[] = {
+      "MFCC [Window(length=512), RDFT, SpectralEnergy,"
+      "FilterBank(squared=true), Log, Square, DCT, Selector(length=16)]",
+      "Energy [Window(length=512), Energy]"
+  };
+  auto config = setup_features_extraction(features, 2, 48000, 16000);
+  ASSERT_NE(nullptr, config);
+  char **layoutNames = nullptr;
+  int *layoutLengths = nullptr;
+  int count = 0;
+  query_features_layout(config, &layoutNames, &layoutLengths, &count);
+  char **dtypes = nullptr;
+  int *shapes = nullptr;
+  int dtypesCount = 0;
+  query_features_dtypes(config, &dtypes, &shapes, &dtypesCount);
+  ASSERT_EQ(count, dtypesCount);
+  // Energy is a single number per window
+  ASSERT_STREQ("=f4", dtypes[0]);
+  ASSERT_EQ(1, shapes[1]);
+  ASSERT_EQ(layoutLengths[0], shapes[0] * 4);
+  // MFCC is 16 numbers per window
+  ASSERT_STREQ("=f4", dtypes[1]);
+  ASSERT_EQ(16, shapes[3]);
+  ASSERT_EQ(shapes[0], shapes[2]);
+  ASSERT_EQ(layoutLengths[1], shapes[2] * 16 * 4);
+  free_results(count, dtypes, nullptr, shapes);
+  free_results(count, layoutNames, nullptr, layoutLengths);
+  destroy_features_configuration(config);
+}
+
+TEST(API, set_feature_output_type) {
+  const char *features[] = {
+      "MFCC [Window(length=512), RDFT, SpectralEnergy,"
+      "FilterBank(squared=true), Log, Square, DCT, Selector(length=16)]",
+      "Energy [Window(length=512), Energy]"
+  };
+  auto config = setup_features_extraction(features, 2, 48000, 16000);
+  ASSERT_NE(nullptr, config);
+  auto buffer = new int16_t[48000];
+  for (int i = 0; i < 48000; i++) {
+    buffer[i] = sinf(i / 4.0f) * 8000;
+  }
+  char **nativeNames = nullptr;
+  void **nativeResults = nullptr;
+  int *nativeLengths = nullptr;
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+      config, buffer, &nativeNames, &nativeResults, &nativeLengths));
+  ASSERT_FALSE(set_feature_output_type(config, "Centroid",
+                                       FEATURE_OUTPUT_INT16));
+  ASSERT_TRUE(set_feature_output_type(config, "MFCC", FEATURE_OUTPUT_INT16));
+
+  char **dtypes = nullptr;
+  int *shapes = nullptr;
+  int count = 0;
+  query_features_dtypes(config, &dtypes, &shapes, &count);
+  ASSERT_STREQ("=f4", dtypes[0]);
+  ASSERT_STREQ("=i2", dtypes[1]);
+  ASSERT_EQ(16, shapes[3]);
+  char **layoutNames = nullptr;
+  int *layoutLengths = nullptr;
+  query_features_layout(config, &layoutNames, &layoutLengths, &count);
+  ASSERT_EQ(shapes[2] * 16 * 2, layoutLengths[1]);
+  void *outputs[2];
+  for (int i = 0; i < count; i++) {
+    outputs[i] = new char[layoutLengths[i]];
+  }
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK,
+            extract_sound_features_into(config, buffer, outputs));
+  char **featureNames = nullptr;
+  void **results = nullptr;
+  int *lengths = nullptr;
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+      config, buffer, &featureNames, &results, &lengths));
+  const FeatureView *views = nullptr;
+  int viewsCount = 0;
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features_views(
+      config, buffer, &views, &viewsCount));
+  ASSERT_EQ(2, viewsCount);
+  for (int i = 0; i < count; i++) {
+    int index = strcmp(featureNames[i], layoutNames[0])? 1 : 0;
+    ASSERT_STREQ(nativeNames[i], featureNames[i]);
+    ASSERT_EQ(layoutLengths[index], lengths[i]);
+    ASSERT_EQ(0, memcmp(results[i], outputs[index], lengths[i]));
+    const FeatureView& view = views[strcmp(views[0].name, featureNames[i])?
+                                    1 : 0];
+    ASSERT_EQ(lengths[i], view.count * view.size);
+    for (int k = 0; k < view.count; k++) {
+      ASSERT_EQ(0, memcmp(reinterpret_cast<const char*>(view.data) +
+                              k * view.stride,
+                          reinterpret_cast<char*>(results[i]) + k * view.size,
+                          view.size));
+    }
+    if (index == 0) {
+      // Energy is fetched as it is
+      ASSERT_EQ(nativeLengths[i], lengths[i]);
+      ASSERT_EQ(0, memcmp(nativeResults[i], results[i], lengths[i]));
+      continue;
+    }
+    ASSERT_EQ(nativeLengths[i], lengths[i] * 2);
+    auto native = reinterpret_cast<const float*>(nativeResults[i]);
+    auto converted = reinterpret_cast<const int16_t*>(results[i]);
+    for (int j = 0; j < lengths[i] / 2; j++) {
+      long expected = lrintf(native[j]);  // NOLINT(runtime/int)
+      expected = std::max(-32768L, std::min(32767L, expected));
+      ASSERT_EQ(expected, converted[j]) << j;
+    }
+  }
+  free_results(count, featureNames, results, lengths);
+
+  // Back to the floats
+  ASSERT_TRUE(set_feature_output_type(config, "MFCC", FEATURE_OUTPUT_NATIVE));
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+      config, buffer, &featureNames, &results, &lengths));
+  for (int i = 0; i < count; i++) {
+    ASSERT_EQ(nativeLengths[i], lengths[i]);
+    ASSERT_EQ(0, memcmp(nativeResults[i], results[i], lengths[i]));
+  }
+  for (int i = 0; i < count; i++) {
+    delete[] reinterpret_cast<char*>(outputs[i]);
+  }
+  free_results(count, featureNames, results, lengths);
+  free_results(count, nativeNames, nativeResults, nativeLengths);
+  free_results(count, layoutNames, nullptr, layoutLengths);
+  free_results(count, dtypes, nullptr, shapes);
+  destroy_features_configuration(config);
+  delete[] buffer;
+}
+
+TEST(API, setup_features_extraction_async) {
+  const char *features[] = {
+      "MFCC [Window(length=512), RDFT, SpectralEnergy,"
+      "FilterBank(squared=true), Log, Square, DCT, Selector(length=16)]",
+      "Energy [Window(length=512), Energy]"
+  };
+  // The features are copied
+  std::string mfcc(features[0]);
+  const char *copies[] = { mfcc.c_str(), features[1] };
+  auto request = setup_features_extraction_async(copies, 2, 48000, 16000);
+  ASSERT_NE(nullptr, request);
+  mfcc.assign(mfcc.size(), ' ');
+  auto broken = "Broken [Window(length=512), NoSuchTransform]";
+  auto failed = setup_features_extraction_async(&broken, 1, 48000, 16000);
+  ASSERT_NE(nullptr, failed);
+  auto config = setup_features_extraction(features, 2, 48000, 16000);
+  ASSERT_NE(nullptr, config);
+  while (!poll_features_setup(request)) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  auto async_config = finish_features_setup(request);
+  ASSERT_NE(nullptr, async_config);
+  ASSERT_EQ(nullptr, finish_features_setup(failed));
+
+  auto buffer = new int16_t[48000];
+  for (int i = 0; i < 48000; i++) {
+    buffer[i] = sinf(i / 4.0f) * 8000;
+  }
+  char **featureNames = nullptr;
+  void **results = nullptr;
+  int *lengths = nullptr;
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+      config, buffer, &featureNames, &results, &lengths));
+  char **asyncNames = nullptr;
+  void **asyncResults = nullptr;
+  int *asyncLengths = nullptr;
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+      async_config, buffer, &asyncNames, &asyncResults, &asyncLengths));
+  for (int i = 0; i < 2; i++) {
+    ASSERT_STREQ(featureNames[i], asyncNames[i]);
+    ASSERT_EQ(lengths[i], asyncLengths[i]);
+    ASSERT_EQ(0, memcmp(results[i], asyncResults[i], lengths[i]));
+  }
+  free_results(2, asyncNames, asyncResults, asyncLengths);
+  free_results(2, featureNames, results, lengths);
+  destroy_features_configuration(async_config);
+  destroy_features_configuration(config);
+  delete[] buffer;
+}
+
+struct AsyncResults {
+  std::atomic<int> calls;
+  std::atomic<int> lengths;
+};
+
+static void on_features(FeatureExtractionResult result, int featuresCount,
+                        char **featureNames, void **results,
+                        int *resultLengths, void *userData) {
+  auto async = reinterpret_cast<AsyncResults*>(userData);
+  if (result == FEATURE_EXTRACTION_RESULT_OK) {
+    async->lengths += resultLengths[0];
+    free_results(featuresCount, featureNames, results, resultLengths);
+  }
+  async->calls++;
+}
+
+TEST(API, extract_sound_features_async) {
+  const char *feature = "MFCC [Window(length=512), RDFT, SpectralEnergy,"
+      "FilterBank(squared=true), Log, Square, DCT, Selector(length=16)]";
+  auto config = setup_features_extraction(&feature, 1, 48000, 16000);
+  ASSERT_NE(nullptr, config);
+  auto buffer = new int16_t[48000];
+  for (int i = 0; i < 48000; i++) {
+    buffer[i] = sinf(i / 4.0f) * INT16_MAX;
+  }
+  char **featureNames = nullptr;
+  void **results = nullptr;
+  int *lengths = nullptr;
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+      config, buffer, &featureNames, &results, &lengths));
+
+  auto request = submit_sound_features(config, buffer);
+  ASSERT_NE(nullptr, request);
+  char **asyncNames = nullptr;
+  void **asyncResults = nullptr;
+  int *asyncLengths = nullptr;
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, finish_extraction(
+      request, &asyncNames, &asyncResults, &asyncLengths));
+  ASSERT_STREQ(featureNames[0], asyncNames[0]);
+  ASSERT_EQ(lengths[0], asyncLengths[0]);
+  ASSERT_EQ(0, memcmp(results[0], asyncResults[0], lengths[0]));
+  free_results(1, asyncNames, asyncResults, asyncLengths);
+
+  AsyncResults async;
+  async.calls = 0;
+  async.lengths = 0;
+  for (int i = 0; i < 4; i++) {
+    ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features_async(
+        config, buffer, on_features, &async));
+  }
+  // The queue is bounded
+  int max_pending = get_max_pending_extractions();
+  set_max_pending_extractions(0);
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_ERROR, extract_sound_features_async(
+      config, buffer, on_features, &async));
+  ASSERT_EQ(nullptr, submit_sound_features(config, buffer));
+  set_max_pending_extractions(max_pending);
+  // Waits for the queued extractions
+  destroy_features_configuration(config);
+  ASSERT_EQ(4, async.calls);
+  ASSERT_EQ(4 * lengths[0], async.lengths);
+  free_results(1, featureNames, results, lengths);
+  delete[] buffer;
+}
+
+TEST(API, set_dynamic_batching) {
+  const char *feature = "MFCC [Window(length=512), RDFT, SpectralEnergy,"
+      "FilterBank(squared=true), Log, Square, DCT, Selector(length=16)]";
+  const int clip = 4810, count = 6, maxBatch = 4;
+  auto config = setup_features_extraction(&feature, 1, clip, 16000);
+  ASSERT_NE(nullptr, config);
+  auto buffer = new int16_t[clip * count];
+  for (int i = 0; i < clip * count; i++) {
+    buffer[i] = sinf(i / (4.0f + i / clip)) * INT16_MAX;
+  }
+  ASSERT_EQ(0, get_batch_sizes_histogram(config, nullptr, 0));
+  ASSERT_TRUE(set_dynamic_batching(config, maxBatch, 100000));
+  ExtractionRequest *requests[count];
+  for (int c = 0; c < count; c++) {
+    requests[c] = submit_sound_features(config, buffer + c * clip);
+    ASSERT_NE(nullptr, requests[c]);
+  }
+  for (int c = 0; c < count; c++) {
+    char **featureNames = nullptr;
+    float **results = nullptr;
+    int *lengths = nullptr;
+    ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+        config, buffer + c * clip, &featureNames,
+        reinterpret_cast<void ***>(&results), &lengths));
+    char **batchedNames = nullptr;
+    float **batchedResults = nullptr;
+    int *batchedLengths = nullptr;
+    ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, finish_extraction(
+        requests[c], &batchedNames,
+        reinterpret_cast<void ***>(&batchedResults), &batchedLengths));
+    ASSERT_STREQ(featureNames[0], batchedNames[0]);
+    ASSERT_EQ(lengths[0], batchedLengths[0]);
+    int floats = lengths[0] / sizeof(float);
+    for (int i = 0; i < floats; i++) {
+      ASSERT_NEAR(results[0][i], batchedResults[0][i],
+                  std::abs(results[0][i]) * 0.0001f + 0.0001f);
+    }
+    free_results(1, batchedNames, reinterpret_cast<void **>(batchedResults),
+                 batchedLengths);
+    free_results(1, featureNames, reinterpret_cast<void **>(results),
+                 lengths);
+  }
+  size_t histogram[maxBatch];
+  ASSERT_EQ(maxBatch, get_batch_sizes_histogram(config, histogram,
+                                                maxBatch));
+  size_t batched = 0;
+  for (int i = 0; i < maxBatch; i++) {
+    batched += histogram[i] * (i + 1);
+  }
+  ASSERT_EQ(static_cast<size_t>(count), batched);
+  ASSERT_TRUE(set_dynamic_batching(config, 1, 0));
+  ASSERT_EQ(0, get_batch_sizes_histogram(config, nullptr, 0));
+  auto stream = setup_features_stream(&feature, 1, clip, 16000);
+  ASSERT_NE(nullptr, stream);
+  ASSERT_FALSE(set_dynamic_batching(stream, maxBatch, 1000));
+  destroy_features_configuration(stream);
+  destroy_features_configuration(config);
+  delete[] buffer;
+}
+
+TEST(API, set_dynamic_batching_dependent) {
+  const char *feature = "Delta [Window(length=512), RDFT, SpectralEnergy, "
+      "Delta]";
+  const int clip = 4810, count = 4;
+  auto config = setup_features_extraction(&feature, 1, clip, 16000);
+  ASSERT_NE(nullptr, config);
+  auto buffer = new int16_t[clip * count];
+  for (int i = 0; i < clip * count; i++) {
+    buffer[i] = sinf(i / (4.0f + i / clip)) * INT16_MAX;
+  }
+  // Delta would read the windows of the neighbouring requests
+  ASSERT_FALSE(set_dynamic_batching(config, count, 100000));
+  ASSERT_EQ(0, get_batch_sizes_histogram(config, nullptr, 0));
+  ExtractionRequest *requests[count];
+  for (int c = 0; c < count; c++) {
+    requests[c] = submit_sound_features(config, buffer + c * clip);
+    ASSERT_NE(nullptr, requests[c]);
+  }
+  for (int c = 0; c < count; c++) {
+    char **featureNames = nullptr;
+    float **results = nullptr;
+    int *lengths = nullptr;
+    ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+        config, buffer + c * clip, &featureNames,
+        reinterpret_cast<void ***>(&results), &lengths));
+    char **asyncNames = nullptr;
+    float **asyncResults = nullptr;
+    int *asyncLengths = nullptr;
+    ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, finish_extraction(
+        requests[c], &asyncNames,
+        reinterpret_cast<void ***>(&asyncResults), &asyncLengths));
+    ASSERT_EQ(lengths[0], asyncLengths[0]);
+    int floats = lengths[0] / sizeof(float);
+    for (int i = 0; i < floats; i++) {
+      ASSERT_NEAR(results[0][i], asyncResults[0][i],
+                  std::abs(results[0][i]) * 0.0001f + 0.0001f) << c;
+    }
+    free_results(1, asyncNames, reinterpret_cast<void **>(asyncResults),
+                 asyncLengths);
+    free_results(1, featureNames, reinterpret_cast<void **>(results),
+                 lengths);
+  }
+  destroy_features_configuration(config);
+  delete[] buffer;
+}
+
+TEST(API, configurations_cache) {
+  const char *feature = "MFCC [Window(length=512), RDFT, SpectralEnergy,"
+      "FilterBank(squared=true), Log, Square, DCT, Selector(length=16)]";
+  // Differs only in the whitespace
+  const char *same = "MFCC [Window( length = 512 ), RDFT, SpectralEnergy,"
+      "FilterBank(squared=true), Log, Square, DCT, Selector(length=16)]";
+  auto buffer = new int16_t[48000];
+  for (int i = 0; i < 48000; i++) {
+    buffer[i] = sinf(i / 4.0f) * INT16_MAX;
+  }
+  auto cacheSize = get_configurations_cache_size();
+  set_configurations_cache_size(0);
+  auto reference = setup_features_extraction(&feature, 1, 48000, 16000);
+  ASSERT_NE(nullptr, reference);
+  set_configurations_cache_size(cacheSize);
+  ASSERT_EQ(cacheSize, get_configurations_cache_size());
+  auto first = setup_features_extraction(&feature, 1, 48000, 16000);
+  ASSERT_NE(nullptr, first);
+  auto second = setup_features_extraction(&same, 1, 48000, 16000);
+  ASSERT_NE(nullptr, second);
+  // The shared tree must outlive the configuration which created it
+  destroy_features_configuration(first);
+
+  char **featureNames[2];
+  void **results[2];
+  int *lengths[2];
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+      reference, buffer, &featureNames[0], &results[0], &lengths[0]));
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+      second, buffer, &featureNames[1], &results[1], &lengths[1]));
+  ASSERT_EQ(lengths[0][0], lengths[1][0]);
+  ASSERT_EQ(0, memcmp(results[0][0], results[1][0], lengths[0][0]));
+  const FeatureView *views = nullptr;
+  int viewsCount = 0;
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features_views(
+      second, buffer, &views, &viewsCount));
+  ASSERT_EQ(1, viewsCount);
+  ASSERT_EQ(0, memcmp(views[0].data, results[0][0], views[0].size));
+  for (int i = 0; i < 2; i++) {
+    free_results(1, featureNames[i], results[i], lengths[i]);
+  }
+  destroy_features_configuration(reference);
+  destroy_features_configuration(second);
+  delete[] buffer;
+}
+
+TEST(API, memory_pool) {
+  const char *feature = "MFCC [Window(length=512), RDFT, SpectralEnergy,"
+      "FilterBank(squared=true), Log, Square, DCT, Selector(length=16)]";
+  auto buffer = new int16_t[48000];
+  for (int i = 0; i < 48000; i++) {
+    buffer[i] = sinf(i / 4.0f) * INT16_MAX;
+  }
+  auto poolSize = get_memory_pool_size();
+  auto cacheSize = get_configurations_cache_size();
+  set_configurations_cache_size(0);
+  set_memory_pool_size(0);
+  ASSERT_EQ(0U, get_memory_pool_size());
+  auto reference = setup_features_extraction(&feature, 1, 48000, 16000);
+  ASSERT_NE(nullptr, reference);
+  set_memory_pool_size(poolSize);
+  ASSERT_EQ(poolSize, get_memory_pool_size());
+  FeaturesConfiguration *configs[2];
+  for (int i = 0; i < 2; i++) {
+    configs[i] = setup_features_extraction(&feature, 1, 48000, 16000);
+    ASSERT_NE(nullptr, configs[i]);
+  }
+  set_configurations_cache_size(cacheSize);
+
+  char **featureNames[3];
+  void **results[3];
+  int *lengths[3];
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+      reference, buffer, &featureNames[0], &results[0], &lengths[0]));
+  // Both configurations borrow the same buffers one after another
+  for (int i = 0; i < 2; i++) {
+    ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+        configs[i], buffer, &featureNames[i + 1], &results[i + 1],
+        &lengths[i + 1]));
+    ASSERT_EQ(lengths[0][0], lengths[i + 1][0]);
+    ASSERT_EQ(0, memcmp(results[0][0], results[i + 1][0], lengths[0][0]));
+  }
+  for (int i = 0; i < 3; i++) {
+    free_results(1, featureNames[i], results[i], lengths[i]);
+  }
+  destroy_features_configuration(reference);
+  for (int i = 0; i < 2; i++) {
+    destroy_features_configuration(configs[i]);
+  }
+  delete[] buffer;
+}
+
+TEST(API, results_cache) {
+  const char *feature = "MFCC [Window(length=512), RDFT, SpectralEnergy,"
+      "FilterBank(squared=true), Log, Square, DCT, Selector(length=16)]";
+  auto buffer = new int16_t[48000];
+  for (int i = 0; i < 48000; i++) {
+    buffer[i] = sinf(i / 4.0f) * INT16_MAX;
+  }
+  auto config = setup_features_extraction(&feature, 1, 48000, 16000);
+  ASSERT_NE(nullptr, config);
+  ASSERT_EQ(0U, get_results_cache_size());
+  set_results_cache_size(16 * 1024 * 1024);
+  reset_results_cache();
+
+  char **featureNames[3];
+  void **results[3];
+  int *lengths[3];
+  for (int i = 0; i < 2; i++) {
+    ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+        config, buffer, &featureNames[i], &results[i], &lengths[i]));
+  }
+  size_t hits, misses;
+  get_results_cache_stats(&hits, &misses);
+  ASSERT_EQ(1U, hits);
+  ASSERT_EQ(1U, misses);
+  ASSERT_STREQ(featureNames[0][0], featureNames[1][0]);
+  ASSERT_EQ(lengths[0][0], lengths[1][0]);
+  ASSERT_EQ(0, memcmp(results[0][0], results[1][0], lengths[0][0]));
+  // A different clip is not served from the cache
+  buffer[100]++;
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+      config, buffer, &featureNames[2], &results[2], &lengths[2]));
+  get_results_cache_stats(&hits, &misses);
+  ASSERT_EQ(1U, hits);
+  ASSERT_EQ(2U, misses);
+  for (int i = 0; i < 3; i++) {
+    free_results(1, featureNames[i], results[i], lengths[i]);
+  }
+  set_results_cache_ttl(1);
+  ASSERT_EQ(1, get_results_cache_ttl());
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+      config, buffer, &featureNames[0], &results[0], &lengths[0]));
+  free_results(1, featureNames[0], results[0], lengths[0]);
+  get_results_cache_stats(&hits, &misses);
+  ASSERT_EQ(1U, hits);
+  ASSERT_EQ(3U, misses);
+  set_results_cache_ttl(0);
+  set_results_cache_size(0);
+  reset_results_cache();
+  destroy_features_configuration(config);
+  delete[] buffer;
+}
+
+TEST(API, huge_pages_and_numa) {
+  const char *feature = "MFCC [Window(length=512), RDFT, SpectralEnergy,"
+      "FilterBank(squared=true), Log, Square, DCT, Selector(length=16)]";
+  auto buffer = new int16_t[480000];
+  for (int i = 0; i < 480000; i++) {
+    buffer[i] = sinf(i / 4.0f) * INT16_MAX;
+  }
+  auto config = setup_features_extraction(&feature, 1, 480000, 16000);
+  ASSERT_NE(nullptr, config);
+  char **featureNames[2];
+  void **results[2];
+  int *lengths[2];
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+      config, buffer, &featureNames[0], &results[0], &lengths[0]));
+  ASSERT_EQ(HUGE_PAGES_NONE, get_huge_pages_mode());
+  ASSERT_FALSE(get_numa_binding());
+  set_huge_pages_mode(HUGE_PAGES_TRANSPARENT);
+  ASSERT_EQ(HUGE_PAGES_TRANSPARENT, get_huge_pages_mode());
+  set_numa_binding(true);
+  ASSERT_TRUE(get_numa_binding());
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+      config, buffer, &featureNames[1], &results[1], &lengths[1]));
+  set_huge_pages_mode(HUGE_PAGES_NONE);
+  set_numa_binding(false);
+  ASSERT_EQ(lengths[0][0], lengths[1][0]);
+  ASSERT_EQ(0, memcmp(results[0][0], results[1][0], lengths[0][0]));
+  for (int i = 0; i < 2; i++) {
+    free_results(1, featureNames[i], results[i], lengths[i]);
+  }
+  destroy_features_configuration(config);
+  delete[] buffer;
+}
+
+TEST(API, buffers_allocator) {
+  const char *features[] = {
+    "MFCC [Window(length=512), RDFT, SpectralEnergy, "
+        "FilterBank(squared=true), Log, Square, DCT, Selector(length=16)]",
+    "Centroid [Window(length=512), RDFT, ComplexMagnitude, Centroid]"
+  };
+  auto buffer = new int16_t[48000];
+  for (int i = 0; i < 48000; i++) {
+    buffer[i] = sinf(i / 4.0f) * INT16_MAX;
+  }
+  ASSERT_EQ(BUFFERS_ALLOCATOR_SLIDING_BLOCKS, get_buffers_allocator());
+  auto reference = setup_features_extraction(features, 2, 48000, 16000);
+  ASSERT_NE(nullptr, reference);
+  set_buffers_allocator(BUFFERS_ALLOCATOR_INTERVAL_PACKING);
+  ASSERT_EQ(BUFFERS_ALLOCATOR_INTERVAL_PACKING, get_buffers_allocator());
+  auto config = setup_features_extraction(features, 2, 48000, 16000);
+  set_buffers_allocator(BUFFERS_ALLOCATOR_SLIDING_BLOCKS);
+  ASSERT_NE(nullptr, config);
+  char **featureNames[2];
+  void **results[2];
+  int *lengths[2];
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+      reference, buffer, &featureNames[0], &results[0], &lengths[0]));
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+      config, buffer, &featureNames[1], &results[1], &lengths[1]));
+  for (int i = 0; i < 2; i++) {
+    int j = strcmp(featureNames[0][i], featureNames[1][0])? 1 : 0;
+    ASSERT_STREQ(featureNames[0][i], featureNames[1][j]);
+    ASSERT_EQ(lengths[0][i], lengths[1][j]);
+    ASSERT_EQ(0, memcmp(results[0][i], results[1][j], lengths[0][i]));
+  }
+  for (int i = 0; i < 2; i++) {
+    free_results(2, featureNames[i], results[i], lengths[i]);
+  }
+  destroy_features_configuration(reference);
+  destroy_features_configuration(config);
+  delete[] buffer;
+}
+
+TEST(API, cache_autotuning) {
+  const char *features[] = {
+    "MFCC [Window(length=512), RDFT, SpectralEnergy, "
+        "FilterBank(squared=true), Log, Square, DCT, Selector(length=16)]",
+    "Centroid [Window(length=512), RDFT, ComplexMagnitude, Centroid]"
+  };
+  auto buffer = new int16_t[48000];
+  for (int i = 0; i < 48000; i++) {
+    buffer[i] = sinf(i / 4.0f) * INT16_MAX;
+  }
+  ASSERT_FALSE(get_cache_autotuning());
+  auto reference = setup_features_extraction(features, 2, 48000, 16000);
+  ASSERT_NE(nullptr, reference);
+  // The interval packing leaves the chain of FilterBank and the fused
+  // elementwise transforms to slice
+  set_buffers_allocator(BUFFERS_ALLOCATOR_INTERVAL_PACKING);
+  set_cache_autotuning(true);
+  ASSERT_TRUE(get_cache_autotuning());
+  auto config = setup_features_extraction(features, 2, 48000, 16000);
+  set_cache_autotuning(false);
+  set_buffers_allocator(BUFFERS_ALLOCATOR_SLIDING_BLOCKS);
+  ASSERT_NE(nullptr, config);
+  char **featureNames[2];
+  void **results[2];
+  int *lengths[2];
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+      reference, buffer, &featureNames[0], &results[0], &lengths[0]));
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+      config, buffer, &featureNames[1], &results[1], &lengths[1]));
+  for (int i = 0; i < 2; i++) {
+    int j = strcmp(featureNames[0][i], featureNames[1][0])? 1 : 0;
+    ASSERT_STREQ(featureNames[0][i], featureNames[1][j]);
+    ASSERT_EQ(lengths[0][i], lengths[1][j]);
+    ASSERT_EQ(0, memcmp(results[0][i], results[1][j], lengths[0][i]));
+  }
+  for (int i = 0; i < 2; i++) {
+    free_results(2, featureNames[i], results[i], lengths[i]);
+  }
+  destroy_features_configuration(reference);
+  destroy_features_configuration(config);
+  delete[] buffer;
+}
+
+TEST(API, parallel_slices) {
+  const char *features[] = {
+    "MFCC [Window(length=512), RDFT, SpectralEnergy, "
+        "FilterBank(squared=true), Log, Square, DCT, Selector(length=16)]",
+    "Centroid [Window(length=512), RDFT, ComplexMagnitude, Centroid]"
+  };
+  auto buffer = new int16_t[48000];
+  for (int i = 0; i < 48000; i++) {
+    buffer[i] = sinf(i / 4.0f) * INT16_MAX;
+  }
+  auto cache_size = get_cpu_cache_size();
+  set_cpu_cache_size(32 * 1024);
+  auto reference = setup_features_extraction(features, 2, 48000, 16000);
+  ASSERT_NE(nullptr, reference);
+  ASSERT_FALSE(get_parallel_slices());
+  set_buffers_allocator(BUFFERS_ALLOCATOR_INTERVAL_PACKING);
+  set_parallel_slices(true);
+  ASSERT_TRUE(get_parallel_slices());
+  auto config = setup_features_extraction(features, 2, 48000, 16000);
+  set_parallel_slices(false);
+  set_buffers_allocator(BUFFERS_ALLOCATOR_SLIDING_BLOCKS);
+  set_cpu_cache_size(cache_size);
+  ASSERT_NE(nullptr, config);
+  char **featureNames[2];
+  void **results[2];
+  int *lengths[2];
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+      reference, buffer, &featureNames[0], &results[0], &lengths[0]));
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+      config, buffer, &featureNames[1], &results[1], &lengths[1]));
+  for (int i = 0; i < 2; i++) {
+    int j = strcmp(featureNames[0][i], featureNames[1][0])? 1 : 0;
+    ASSERT_STREQ(featureNames[0][i], featureNames[1][j]);
+    ASSERT_EQ(lengths[0][i], lengths[1][j]);
+    ASSERT_EQ(0, memcmp(results[0][i], results[1][j], lengths[0][i]));
+  }
+  for (int i = 0; i < 2; i++) {
+    free_results(2, featureNames[i], results[i], lengths[i]);
+  }
+  destroy_features_configuration(reference);
+  destroy_features_configuration(config);
+  delete[] buffer;
+}
+
+TEST(API, packed_results) {
+  const char *features[] = {
+    "Centroid [Window(length=512), RDFT, ComplexMagnitude, Centroid]",
+    "Energy [Window(length=512), Energy]"
+  };
+  auto buffer = new int16_t[48000];
+  for (int i = 0; i < 48000; i++) {
+    buffer[i] = sinf(i / 4.0f) * INT16_MAX;
+  }
+  auto reference = setup_features_extraction(features, 2, 48000, 16000);
+  ASSERT_NE(nullptr, reference);
+  ASSERT_FALSE(get_packed_results());
+  set_packed_results(true);
+  ASSERT_TRUE(get_packed_results());
+  auto config = setup_features_extraction(features, 2, 48000, 16000);
+  set_packed_results(false);
+  ASSERT_NE(nullptr, config);
+  ExtractionMemoryUsage usage[2];
+  char **nodeNames;
+  NodeMemoryUsage *nodes;
+  int length;
+  report_extraction_memory(reference, &usage[0], &nodeNames, &nodes, &length);
+  destroy_extraction_memory(nodeNames, nodes, length);
+  report_extraction_memory(config, &usage[1], &nodeNames, &nodes, &length);
+  destroy_extraction_memory(nodeNames, nodes, length);
+  ASSERT_LT(usage[1].buffers, usage[0].buffers);
+  char **featureNames[2];
+  void **results[2];
+  int *lengths[2];
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+      reference, buffer, &featureNames[0], &results[0], &lengths[0]));
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+      config, buffer, &featureNames[1], &results[1], &lengths[1]));
+  for (int i = 0; i < 2; i++) {
+    int j = strcmp(featureNames[0][i], featureNames[1][0])? 1 : 0;
+    ASSERT_STREQ(featureNames[0][i], featureNames[1][j]);
+    ASSERT_EQ(lengths[0][i], lengths[1][j]);
+    ASSERT_EQ(0, memcmp(results[0][i], results[1][j], lengths[0][i]));
+  }
+  for (int i = 0; i < 2; i++) {
+    free_results(2, featureNames[i], results[i], lengths[i]);
+  }
+  destroy_features_configuration(reference);
+  destroy_features_configuration(config);
+  delete[] buffer;
+}
+
+TEST(API, constant_input_shortcut) {
+  const char *features[] = {
+    "MFCC [Window(length=512), RDFT, SpectralEnergy,"
+    "FilterBank(squared=true), Log, Square, DCT, Selector(length=16)]",
+    "Energy [Window(length=512), Energy]"
+  };
+  auto reference = setup_features_extraction(features, 2, 48000, 16000);
+  ASSERT_NE(nullptr, reference);
+  ASSERT_FALSE(get_constant_input_shortcut());
+  set_constant_input_shortcut(true);
+  ASSERT_TRUE(get_constant_input_shortcut());
+  auto config = setup_features_extraction(features, 2, 48000, 16000);
+  set_constant_input_shortcut(false);
+  ASSERT_NE(nullptr, config);
+  auto buffer = new int16_t[48000];
+  // Silence, silence again (copied), DC, silence and a signal
+  const int16_t values[] = { 0, 0, 1000, 0, -1 };
+  for (int pass = 0; pass < 5; pass++) {
+    for (int i = 0; i < 48000; i++) {
+      buffer[i] = values[pass] >= 0? values[pass] : sinf(i / 4.0f) * 8000;
+    }
+    char **featureNames[2];
+    void **results[2];
+    int *lengths[2];
+    ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+        reference, buffer, &featureNames[0], &results[0], &lengths[0]));
+    ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+        config, buffer, &featureNames[1], &results[1], &lengths[1]));
+    for (int i = 0; i < 2; i++) {
+      int j = strcmp(featureNames[0][i], featureNames[1][0])? 1 : 0;
+      ASSERT_STREQ(featureNames[0][i], featureNames[1][j]);
+      ASSERT_EQ(lengths[0][i], lengths[1][j]);
+      ASSERT_EQ(0, memcmp(results[0][i], results[1][j], lengths[0][i]))
+          << "pass " << pass;
+    }
+    for (int i = 0; i < 2; i++) {
+      free_results(2, featureNames[i], results[i], lengths[i]);
+    }
+  }
+  destroy_features_configuration(reference);
+  destroy_features_configuration(config);
+  delete[] buffer;
+}
+
+TEST(API, save_features_configuration) {
+  const char *feature = "MFCC [Window(length=512), RDFT, SpectralEnergy,"
+      "FilterBank(squared=true), Log, Square, DCT, Selector(length=16)]";
+  auto config = setup_features_extraction(&feature, 1, 48000, 16000);
+  ASSERT_NE(nullptr, config);
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, save_features_configuration(
+      config, "/tmp/test_save_features_configuration.bin"));
+  auto loaded = load_features_configuration(
+      "/tmp/test_save_features_configuration.bin");
+  ASSERT_NE(nullptr, loaded);
+  auto buffer = new int16_t[48000];
+  for (int i = 0; i < 48000; i++) {
+    buffer[i] = sinf(i / 4.0f) * INT16_MAX;
+  }
+  char **featureNames[2];
+  void **results[2];
+  int *lengths[2];
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+      config, buffer, &featureNames[0], &results[0], &lengths[0]));
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+      loaded, buffer, &featureNames[1], &results[1], &lengths[1]));
+  ASSERT_EQ(lengths[0][0], lengths[1][0]);
+  ASSERT_EQ(0, memcmp(results[0][0], results[1][0], lengths[0][0]));
+  for (int i = 0; i < 2; i++) {
+    free_results(1, featureNames[i], results[i], lengths[i]);
+  }
+  ASSERT_EQ(nullptr, load_features_configuration("/tmp/nonexistent.bin"));
+  destroy_features_configuration(config);
+  destroy_features_configuration(loaded);
+  delete[] buffer;
+}
+
+TEST(API, load_compiled_features_configuration) {
+  const char *feature = "MFCC [Window(length=512), RDFT, SpectralEnergy,"
+      "FilterBank(squared=true), Log, Square, DCT, Selector(length=16)]";
+  // The missing plugin falls back to the interpreted tree
+  auto config = load_compiled_features_configuration(
+      "/tmp/nonexistent_plugin.so", &feature, 1, 48000, 16000);
+  ASSERT_NE(nullptr, config);
+  auto buffer = new int16_t[48000];
+  for (int i = 0; i < 48000; i++) {
+    buffer[i] = sinf(i / 4.0f) * INT16_MAX;
+  }
+  char **featureNames = nullptr;
+  void **results = nullptr;
+  int *lengths = nullptr;
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+      config, buffer, &featureNames, &results, &lengths));
+  free_results(1, featureNames, results, lengths);
+  destroy_features_configuration(config);
+  delete[] buffer;
+}
+
+TEST(API, parallel_chunks) {
+  const char *feature = "MFCC [Window(length=512), RDFT, SpectralEnergy,"
+      "FilterBank(squared=true), Log, Square, DCT, Selector(length=16)]";
+  auto chunk_size = get_chunk_size();
+  set_chunk_size(12000);
+  auto config = setup_features_extraction(&feature, 1, 48000, 16000);
+  set_chunk_size(chunk_size);
+  ASSERT_NE(nullptr, config);
+  auto buffer = new int16_t[48000];
+  for (int i = 0; i < 48000; i++) {
+    buffer[i] = sinf(i / 4.0f) * INT16_MAX;
+  }
+  char **featureNames = nullptr;
+  void **results = nullptr;
+  int *lengths = nullptr;
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+      config, buffer, &featureNames, &results, &lengths));
+  ASSERT_FALSE(get_parallel_chunks());
+  set_parallel_chunks(true);
+  char **parallelNames = nullptr;
+  void **parallelResults = nullptr;
+  int *parallelLengths = nullptr;
+  auto res = extract_sound_features(config, buffer, &parallelNames,
+                                    &parallelResults, &parallelLengths);
+  set_parallel_chunks(false);
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, res);
+  ASSERT_EQ(lengths[0], parallelLengths[0]);
+  ASSERT_EQ(0, memcmp(results[0], parallelResults[0], lengths[0]));
+  free_results(1, parallelNames, parallelResults, parallelLengths);
+  free_results(1, featureNames, results, lengths);
+  destroy_features_configuration(config);
+  delete[] buffer;
+}
+
+TEST(API, execution_settings) {
+  const char *feature = "MFCC [Window(length=512), RDFT, SpectralEnergy,"
+      "FilterBank(squared=true), Log, Square, DCT, Selector(length=16)]";
+  auto reference = setup_features_extraction(&feature, 1, 48000, 16000);
+  ASSERT_NE(nullptr, reference);
+  ExecutionSettings settings { 0, 1, 0, 12000 };
+  set_thread_execution_settings(&settings);
+  auto config = setup_features_extraction(&feature, 1, 48000, 16000);
+  set_thread_execution_settings(nullptr);
+  ASSERT_NE(nullptr, config);
+  ExecutionSettings actual;
+  get_execution_settings(config, &actual);
+  ASSERT_FALSE(actual.useSimd);
+  ASSERT_EQ(1, actual.threadsNumber);
+  ASSERT_EQ(get_cpu_cache_size(), actual.cpuCacheSize);
+  ASSERT_EQ(12000U, actual.chunkSize);
+  // The process-wide values are intact
+  get_execution_settings(reference, &actual);
+  ASSERT_EQ(get_use_simd(), static_cast<bool>(actual.useSimd));
+  ASSERT_EQ(get_omp_transforms_max_threads_num(), actual.threadsNumber);
+  ASSERT_EQ(get_chunk_size(), actual.chunkSize);
+  auto buffer = new int16_t[48000];
+  for (int i = 0; i < 48000; i++) {
+    buffer[i] = sinf(i / 4.0f) * INT16_MAX;
+  }
+  char **featureNames = nullptr;
+  void **results = nullptr;
+  int *lengths = nullptr;
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+      reference, buffer, &featureNames, &results, &lengths));
+  char **chunkedNames = nullptr;
+  void **chunkedResults = nullptr;
+  int *chunkedLengths = nullptr;
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+      config, buffer, &chunkedNames, &chunkedResults, &chunkedLengths));
+  ASSERT_EQ(lengths[0], chunkedLengths[0]);
+  auto expected = reinterpret_cast<const float*>(results[0]);
+  auto chunked = reinterpret_cast<const float*>(chunkedResults[0]);
+  for (size_t i = 0; i < lengths[0] / sizeof(float); i++) {
+    ASSERT_NEAR(expected[i], chunked[i], std::abs(expected[i]) * 1e-4f + 1e-4f)
+        << i;
+  }
+  free_results(1, chunkedNames, chunkedResults, chunkedLengths);
+  free_results(1, featureNames, results, lengths);
+  destroy_features_configuration(config);
+  destroy_features_configuration(reference);
+  delete[] buffer;
+}
+
+TEST(API, threads_governor) {
+  const char *feature = "MFCC [Window(length=512), RDFT, SpectralEnergy,"
+      "FilterBank(squared=true), Log, Square, DCT, Selector(length=16)]";
+  auto config = setup_features_extraction(&feature, 1, 48000, 16000);
+  ASSERT_NE(nullptr, config);
+  auto buffer = new int16_t[48000];
+  for (int i = 0; i < 48000; i++) {
+    buffer[i] = sinf(i / 4.0f) * INT16_MAX;
+  }
+  ASSERT_FALSE(get_threads_governor());
+  set_threads_governor(true);
+  ASSERT_TRUE(get_threads_governor());
+  int executions = -1, share = 0;
+  get_threads_governor_state(&executions, &share);
+  ASSERT_EQ(0, executions);
+  ASSERT_EQ(get_omp_transforms_max_threads_num(), share);
+  char **featureNames = nullptr;
+  void **results = nullptr;
+  int *lengths = nullptr;
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+      config, buffer, &featureNames, &results, &lengths));
+  char **limitedNames = nullptr;
+  void **limitedResults = nullptr;
+  int *limitedLengths = nullptr;
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features_threads(
+      config, buffer, 1, &limitedNames, &limitedResults, &limitedLengths));
+  set_threads_governor(false);
+  get_threads_governor_state(&executions, &share);
+  ASSERT_EQ(0, executions);
+  ASSERT_EQ(lengths[0], limitedLengths[0]);
+  ASSERT_EQ(0, memcmp(results[0], limitedResults[0], lengths[0]));
+  free_results(1, limitedNames, limitedResults, limitedLengths);
+  free_results(1, featureNames, results, lengths);
+  destroy_features_configuration(config);
+  delete[] buffer;
+}
+
+TEST(API, concurrent_setup) {
+  const char *features[] = {
+    "MFCC [Window(length=512), RDFT, SpectralEnergy, FilterBank, Log, DCT]",
+    "Energy [Window(length=512), Energy]",
+    "Autocorrelation [Window(length=512), Autocorrelation]",
+    "Centroid [Window(length=512), RDFT, SpectralEnergy, Centroid]"
+  };
+  const int count = sizeof(features) / sizeof(features[0]);
+  // The sizes differ so that the configurations are not reused
+  const int threads = 8;
+  std::vector<FeaturesConfiguration*> configs(threads);
+  std::vector<std::thread> setups;
+  for (int i = 0; i < threads; i++) {
+    setups.emplace_back([&, i]() {
+      configs[i] = setup_features_extraction(
+          features, count, 32000 + i * 512, 16000);
+    });
+  }
+  for (auto& setup : setups) {
+    setup.join();
+  }
+  for (int i = 0; i < threads; i++) {
+    ASSERT_NE(nullptr, configs[i]) << i;
+    size_t size = 32000 + i * 512;
+    auto reference = setup_features_extraction(
+        features, count, size, 16000);
+    ASSERT_NE(nullptr, reference);
+    std::vector<int16_t> buffer(size);
+    for (size_t j = 0; j < size; j++) {
+      buffer[j] = sinf(j / 4.0f) * INT16_MAX;
+    }
+    char **names = nullptr, **referenceNames = nullptr;
+    void **results = nullptr, **referenceResults = nullptr;
+    int *lengths = nullptr, *referenceLengths = nullptr;
+    ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+        configs[i], buffer.data(), &names, &results, &lengths));
+    ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+        reference, buffer.data(), &referenceNames, &referenceResults,
+        &referenceLengths));
+    for (int j = 0; j < count; j++) {
+      int k = 0;
+      while (k < count && strcmp(referenceNames[k], names[j]) != 0) {
+        k++;
+      }
+      ASSERT_LT(k, count) << names[j];
+      ASSERT_EQ(referenceLengths[k], lengths[j]);
+      ASSERT_EQ(0, memcmp(referenceResults[k], results[j], lengths[j]));
+    }
+    free_results(count, referenceNames, referenceResults, referenceLengths);
+    free_results(count, names, results, lengths);
+    destroy_features_configuration(reference);
+    destroy_features_configuration(configs[i]);
+  }
+}
+
+TEST(API, cancellation) {
+  const char *feature = "MFCC [Window(length=512), RDFT, SpectralEnergy,"
+      "FilterBank(squared=true), Log, Square, DCT, Selector(length=16)]";
+  auto config = setup_features_extraction(&feature, 1, 48000, 16000);
+  ASSERT_NE(nullptr, config);
+  ASSERT_EQ(0, get_extraction_timeout(config));
+  set_extraction_timeout(config, 60000);
+  ASSERT_EQ(60000, get_extraction_timeout(config));
+  auto buffer = new int16_t[48000];
+  for (int i = 0; i < 48000; i++) {
+    buffer[i] = sinf(i / 4.0f) * INT16_MAX;
+  }
+  // Cancels nothing, since no extraction is running
+  cancel_extractions(config);
+  char **featureNames = nullptr;
+  void **results = nullptr;
+  int *lengths = nullptr;
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+      config, buffer, &featureNames, &results, &lengths));
+  free_results(1, featureNames, results, lengths);
+  std::atomic<bool> stop(false);
+  std::thread canceller([&]() {
+    while (!stop) {
+      cancel_extractions(config);
+      std::this_thread::yield();
+    }
+  });
+  // Some of the extractions are interrupted
+  int cancelled = 0;
+  for (int i = 0; i < 100 && cancelled == 0; i++) {
+    auto result = extract_sound_features(
+        config, buffer, &featureNames, &results, &lengths);
+    if (result == FEATURE_EXTRACTION_RESULT_OK) {
+      free_results(1, featureNames, results, lengths);
+    } else {
+      ASSERT_EQ(FEATURE_EXTRACTION_RESULT_CANCELLED, result);
+      ASSERT_EQ(nullptr, results);
+      cancelled++;
+    }
+  }
+  stop = true;
+  canceller.join();
+  ASSERT_GT(cancelled, 0);
+  destroy_features_configuration(config);
+  delete[] buffer;
+}
+
+TEST(API, extract_sound_features_batch) {
+  const char *feature = "MFCC [Window(length=512), RDFT, SpectralEnergy,"
+      "FilterBank(squared=true), Log, Square, DCT, Selector(length=16)]";
+  // 4810 samples do not fill the aligned stride, so the clips are repacked
+  const int clip = 4810, count = 8;
+  auto buffer = new int16_t[clip * count];
+  for (int i = 0; i < clip * count; i++) {
+    buffer[i] = sinf(i / (4.0f + i / clip)) * INT16_MAX;
+  }
+  auto batch = setup_features_extraction_batch(&feature, 1, clip, count,
+                                               16000);
+  ASSERT_NE(nullptr, batch);
+  char **featureNames = nullptr;
+  float **results = nullptr;
+  int *lengths = nullptr;
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_ERROR, extract_sound_features(
+      batch, buffer, &featureNames, reinterpret_cast<void ***>(&results),
+      &lengths));
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features_batch(
+      batch, buffer, &featureNames, reinterpret_cast<void ***>(&results),
+      &lengths));
+  ASSERT_EQ(0, lengths[0] % count);
+  auto single = setup_features_extraction(&feature, 1, clip, 16000);
+  ASSERT_NE(nullptr, single);
+  for (int c = 0; c < count; c++) {
+    char **singleNames = nullptr;
+    float **singleResults = nullptr;
+    int *singleLengths = nullptr;
+    ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+        single, buffer + c * clip, &singleNames,
+        reinterpret_cast<void ***>(&singleResults), &singleLengths));
+    ASSERT_EQ(lengths[0] / count, singleLengths[0]);
+    int floats = singleLengths[0] / sizeof(float);
+    for (int i = 0; i < floats; i++) {
+      ASSERT_NEAR(singleResults[0][i], results[0][c * floats + i],
+                  std::abs(singleResults[0][i]) * 0.0001f + 0.0001f);
+    }
+    free_results(1, singleNames, reinterpret_cast<void **>(singleResults),
+                 singleLengths);
+  }
+  free_results(1, featureNames, reinterpret_cast<void **>(results), lengths);
+  destroy_features_configuration(single);
+  destroy_features_configuration(batch);
+  delete[] buffer;
+}
+
+TEST(API, setup_features_extraction_batch_dependent) {
+  const char *features[] = {
+    "Delta [Window(length=512), RDFT, SpectralEnergy, Delta]",
+    "Stats [Window, Energy, Stats]"
+  };
+  const int clip = 4810, count = 8;
+  auto buffer = new int16_t[clip * count];
+  for (int i = 0; i < clip * count; i++) {
+    buffer[i] = sinf(i / (4.0f + i / clip)) * INT16_MAX;
+  }
+  for (auto feature : features) {
+    // Each clip alone is fine
+    auto single = setup_features_extraction(&feature, 1, clip, 16000);
+    ASSERT_NE(nullptr, single) << feature;
+    char **featureNames = nullptr;
+    float **results = nullptr;
+    int *lengths = nullptr;
+    ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+        single, buffer + clip, &featureNames,
+        reinterpret_cast<void ***>(&results), &lengths));
+    free_results(1, featureNames, reinterpret_cast<void **>(results),
+                 lengths);
+    destroy_features_configuration(single);
+    // The batch would read the windows or the stats of the previous clip
+    ASSERT_EQ(nullptr, setup_features_extraction_batch(&feature, 1, clip,
+                                                       count, 16000))
+        << feature;
+    ASSERT_EQ(nullptr, setup_features_extraction_multichannel(
+        &feature, 1, clip, count, 16000, CHANNELS_LAYOUT_PLANAR)) << feature;
+  }
+  delete[] buffer;
+}
+
+TEST(API, setup_features_extraction_multichannel) {
+  const char *feature = "MFCC [Window(length=512), RDFT, SpectralEnergy,"
+      "FilterBank(squared=true), Log, Square, DCT, Selector(length=16)]";
+  const int size = 4810, channels = 4;
+  auto planar = new int16_t[size * channels];
+  auto interleaved = new int16_t[size * channels];
+  for (int c = 0; c < channels; c++) {
+    for (int i = 0; i < size; i++) {
+      planar[c * size + i] = sinf(i / (4.0f + c)) * INT16_MAX;
+      interleaved[i * channels + c] = planar[c * size + i];
+    }
+  }
+  auto batch = setup_features_extraction_multichannel(
+      &feature, 1, size, channels, 16000, CHANNELS_LAYOUT_PLANAR);
+  ASSERT_NE(nullptr, batch);
+  auto multi = setup_features_extraction_multichannel(
+      &feature, 1, size, channels, 16000, CHANNELS_LAYOUT_INTERLEAVED);
+  ASSERT_NE(nullptr, multi);
+  char **featureNames = nullptr, **multiNames = nullptr;
+  float **results = nullptr, **multiResults = nullptr;
+  int *lengths = nullptr, *multiLengths = nullptr;
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features_batch(
+      batch, planar, &featureNames, reinterpret_cast<void ***>(&results),
+      &lengths));
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features_batch(
+      multi, interleaved, &multiNames,
+      reinterpret_cast<void ***>(&multiResults), &multiLengths));
+  ASSERT_EQ(lengths[0], multiLengths[0]);
+  for (int i = 0; i < lengths[0] / static_cast<int>(sizeof(float)); i++) {
+    ASSERT_EQ(results[0][i], multiResults[0][i]) << i;
+  }
+  free_results(1, featureNames, reinterpret_cast<void **>(results), lengths);
+  free_results(1, multiNames, reinterpret_cast<void **>(multiResults),
+               multiLengths);
+  destroy_features_configuration(multi);
+  destroy_features_configuration(batch);
+  delete[] interleaved;
+  delete[] planar;
+}
+
+TEST(API, setup_features_extraction_float) {
+  const char *feature = "MFCC [Window(length=512), RDFT, SpectralEnergy,"
+      "FilterBank(squared=true), Log, Square, DCT, Selector(length=16)]";
+  const int size = 4810;
+  int16_t buffer[size];
+  int32_t buffer32[size];
+  float bufferF[size];
+  for (int i = 0; i < size; i++) {
+    buffer[i] = sinf(i / 4.0f) * INT16_MAX;
+    buffer32[i] = buffer[i];
+    bufferF[i] = buffer[i];
+  }
+  FeaturesConfiguration *configs[] {
+    setup_features_extraction_float(&feature, 1, size, 16000),
+    setup_features_extraction_int32(&feature, 1, size, 16000),
+    setup_features_extraction(&feature, 1, size, 16000)
+  };
+  char **names[3] {};
+  float **results[3] {};
+  int *lengths[3] {};
+  for (auto config : configs) {
+    ASSERT_NE(nullptr, config);
+  }
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_ERROR, extract_sound_features(
+      configs[0], buffer, &names[0], reinterpret_cast<void ***>(&results[0]),
+      &lengths[0]));
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features_float(
+      configs[0], bufferF, &names[0],
+      reinterpret_cast<void ***>(&results[0]), &lengths[0]));
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features_int32(
+      configs[1], buffer32, &names[1],
+      reinterpret_cast<void ***>(&results[1]), &lengths[1]));
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+      configs[2], buffer, &names[2], reinterpret_cast<void ***>(&results[2]),
+      &lengths[2]));
+  int floats = lengths[0][0] / sizeof(float);
+  float scale = 0;
+  for (int i = 0; i < floats; i++) {
+    scale = std::max(scale, std::abs(results[0][0][i]));
+  }
+  // The int32_t samples are converted to float before Window, while
+  // the int16_t ones are windowed as integers
+  const float tolerances[] { 0, 0.00001f, 0.01f };
+  for (int type = 1; type < 3; type++) {
+    ASSERT_EQ(lengths[0][0], lengths[type][0]);
+    for (int i = 0; i < floats; i++) {
+      ASSERT_NEAR(results[0][0][i], results[type][0][i],
+                  scale * tolerances[type]) << type << " " << i;
+    }
+  }
+  for (int type = 0; type < 3; type++) {
+    free_results(1, names[type], reinterpret_cast<void **>(results[type]),
+                 lengths[type]);
+    destroy_features_configuration(configs[type]);
+  }
+}
+
+TEST(API, push_samples) {
+  const char *feature = "Energy [Window(length=512,step=256), RDFT, "
+      "SpectralEnergy]";
+  const int size = 40960;
+  auto buffer = new int16_t[size];
+  for (int i = 0; i < size; i++) {
+    buffer[i] = sinf(i / 4.0f) * (INT16_MAX / 2) +
+                sinf(i / 50.0f) * (INT16_MAX / 4);
+  }
+  auto config = setup_features_extraction(&feature, 1, size, 16000);
+  ASSERT_NE(nullptr, config);
+  char **featureNames = nullptr;
+  float **results = nullptr;
+  int *lengths = nullptr;
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+      config, buffer, &featureNames, reinterpret_cast<void ***>(&results),
+      &lengths));
+  destroy_features_configuration(config);
+
+  auto stream = setup_features_stream(&feature, 1, 4096, 16000);
+  ASSERT_NE(nullptr, stream);
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_ERROR, extract_sound_features(
+      stream, buffer, &featureNames, reinterpret_cast<void ***>(&results),
+      &lengths));
+  for (int i = 0; i < size; i += 320) {
+    ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK,
+              push_samples(stream, buffer + i, 320));
+  }
+  char **streamNames = nullptr;
+  float **streamResults = nullptr;
+  int *streamLengths = nullptr;
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, pull_features(
+      stream, &streamNames, reinterpret_cast<void ***>(&streamResults),
+      &streamLengths));
+  ASSERT_STREQ("Energy", streamNames[0]);
+  // 159 windows in the whole signal, 16 windows per streaming block
+  int window = lengths[0] / 159;
+  ASSERT_EQ(160 * window, streamLengths[0]);
+  // The first streaming window overlaps the zero padding, so the streamed
+  // windows are shifted by one
+  int count = window / sizeof(float);
+  for (int i = 0; i < 159 * count; i++) {
+    ASSERT_NEAR(results[0][i], streamResults[0][i + count],
+                std::abs(results[0][i]) * 0.0001f + 0.001f) << i;
+  }
+  free_results(1, streamNames, reinterpret_cast<void **>(streamResults),
+               streamLengths);
+
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, pull_features(
+      stream, &streamNames, reinterpret_cast<void ***>(&streamResults),
+      &streamLengths));
+  ASSERT_EQ(0, streamLengths[0]);
+  free_results(1, streamNames, reinterpret_cast<void **>(streamResults),
+               streamLengths);
+  destroy_features_configuration(stream);
+  free_results(1, featureNames, reinterpret_cast<void **>(results), lengths);
+  delete[] buffer;
+}
+
+TEST(API, extract_sound_features_window) {
+  const char *feature = "Energy [Window(length=512,step=256), RDFT, "
+      "SpectralEnergy]";
+  const int size = 40960, block = 4096, window = 16384;
+  auto buffer = new int16_t[size];
+  for (int i = 0; i < size; i++) {
+    buffer[i] = sinf(i / 4.0f) * (INT16_MAX / 2) +
+                sinf(i / 50.0f) * (INT16_MAX / 4);
+  }
+  auto stream = setup_features_stream(&feature, 1, block, 16000);
+  ASSERT_NE(nullptr, stream);
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK,
+            push_samples(stream, buffer, size));
+  char **names = nullptr;
+  char **reference = nullptr;
+  int *lengths = nullptr;
+  ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, pull_features(
+      stream, &names, reinterpret_cast<void ***>(&reference), &lengths));
+  int blockSize = lengths[0] / (size / block);
+  free_results(1, names, nullptr, lengths);
+  reset_features_stream(stream);
+
+  // The window grows and then slides, each block is computed once
+  for (int offset = 0, end = block; end <= size;) {
+    char **windowNames = nullptr;
+    char **results = nullptr;
+    int *windowLengths = nullptr;
+    ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features_window(
+        stream, buffer + offset, end - offset, offset, &windowNames,
+        reinterpret_cast<void ***>(&results), &windowLengths));
+    ASSERT_STREQ("Energy", windowNames[0]);
+    int first = (offset + block - 1) / block, last = end / block;
+    ASSERT_EQ((last - first) * blockSize, windowLengths[0]);
+    ASSERT_EQ(0, memcmp(reference[0] + first * blockSize, results[0],
+                        windowLengths[0])) << offset;
+    free_results(1, windowNames, reinterpret_cast<void **>(results),
+                 windowLengths);
+    end += block / 2;
+    if (end - offset > window) {
+      offset = end - window;
+    }
+  }
+  delete[] reference[0];
+  delete[] reference;
+  destroy_features_configuration(stream);
+  delete[] buffer;
+}
+
+TEST(API, traffic_recording) {
+  const char *feature = "Energy [Window(length=512), Energy]";
+  const size_t size = 4096;
+  auto config = setup_features_extraction(&feature, 1, size, 16000);
+  ASSERT_NE(nullptr, config);
+  auto buffer = new int16_t[size];
+  for (size_t i = 0; i < size; i++) {
+    buffer[i] = sinf(i / 4.0f) * (INT16_MAX / 2);
+  }
+  const char *fileName = "/tmp/test_traffic_recording.sfet";
+  ASSERT_TRUE(start_traffic_recording(fileName, 2, 2));
+  for (int i = 0; i < 6; i++) {
+    char **names;
+    void **results;
+    int *lengths;
+    ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+        config, buffer, &names, &results, &lengths));
+    free_results(1, names, results, lengths);
+  }
+  // Every second call until the limit
+  ASSERT_EQ(2, stop_traffic_recording());
+  ASSERT_EQ(0, stop_traffic_recording());
+  std::ifstream file(fileName, std::ios::in | std::ios::binary);
+  std::string contents((std::istreambuf_iterator<char>(file)),
+                       std::istreambuf_iterator<char>());
+  ASSERT_EQ(0U, contents.find("SFETRAFC"));
+  uint32_t fingerprint;
+  memcpy(&fingerprint, contents.data() + 8, sizeof(fingerprint));
+  size_t record = 4 + fingerprint + 4 + 4 + strlen(feature) + 4 + 4 + 8 + 8 +
+      size * sizeof(int16_t);
+  ASSERT_EQ(8 + 2 * record, contents.size());
+  ASSERT_EQ(0, memcmp(contents.data() + 8 + record - size * sizeof(int16_t),
+                      buffer, size * sizeof(int16_t)));
+  delete[] buffer;
+  destroy_features_configuration(config);
+}
+
+TEST(API, snapshot_metrics) {
+  const char *feature = "Energy [Window(length=256), Energy]";
+  const size_t size = 8192;
+  auto config = setup_features_extraction(&feature, 1, size, 16000);
+  ASSERT_NE(nullptr, config);
+  auto buffer = new int16_t[size]();
+  for (int i = 0; i < 3; i++) {
+    char **names;
+    void **results;
+    int *lengths;
+    ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract_sound_features(
+        config, buffer, &names, &results, &lengths));
+    free_results(1, names, results, lengths);
+  }
+  delete[] buffer;
+  auto snapshot = snapshot_metrics();
+  ASSERT_NE(nullptr, snapshot);
+  std::string text(snapshot);
+  destroy_metrics_snapshot(snapshot);
+  ASSERT_NE(std::string::npos, text.find("# TYPE sfe_extractions counter\n"));
+  boost::regex extractions(
+      "sfe_extractions_total\\{configuration=\"[0-9a-f]{16}\","
+      "result=\"ok\"\\} 3\n");
+  ASSERT_TRUE(boost::regex_search(text, extractions)) << text;
+  ASSERT_NE(std::string::npos,
+            text.find("sfe_extraction_seconds_bucket{configuration="));
+  ASSERT_NE(std::string::npos, text.find("le=\"+Inf\"} 3\n"));
+  ASSERT_NE(std::string::npos, text.find("sfe_tree_executions_total "));
+  ASSERT_NE(std::string::npos, text.find("sfe_memory_pool_used_bytes "));
+  ASSERT_EQ(text.size() - 6, text.rfind("# EOF\n"));
+  destroy_features_configuration(config);
+}
+
 #include "tests/google/src/gtest_main.cc"
 
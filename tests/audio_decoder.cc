@@ -0,0 +1,127 @@
+/*! @file audio_decoder.cc
+ *  @brief Tests for AudioDecoder and DecodingSource.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include "src/audio_decoder.h"
+
+using sound_feature_extraction::AudioDecoder;
+using sound_feature_extraction::AudioDecoderException;
+using sound_feature_extraction::DecodingSource;
+
+/// @brief Returns the samples 0, 1, 2, ... in the pieces of 7 and fails
+/// after fail_after samples if it is not zero.
+class CounterDecoder : public AudioDecoder {
+ public:
+  CounterDecoder(size_t length, size_t fail_after = 0)
+      : length_(length), fail_after_(fail_after), position_(0) {
+  }
+
+  virtual int sampling_rate() const noexcept override {
+    return 16000;
+  }
+
+  virtual size_t Read(int16_t* samples, size_t count) override {
+    if (fail_after_ > 0 && position_ >= fail_after_) {
+      throw AudioDecoderException("counter", "failed");
+    }
+    // Pretend that decoding takes time
+    std::this_thread::sleep_for(std::chrono::microseconds(10));
+    size_t size = std::min(std::min(count, length_ - position_), size_t(7));
+    for (size_t i = 0; i < size; i++) {
+      samples[i] = position_ + i;
+    }
+    position_ += size;
+    return size;
+  }
+
+ private:
+  size_t length_;
+  size_t fail_after_;
+  size_t position_;
+};
+
+TEST(DecodingSource, Blocks) {
+  DecodingSource source(std::unique_ptr<AudioDecoder>(
+      new CounterDecoder(1000)), 64, 3);
+  ASSERT_EQ(16000, source.sampling_rate());
+  ASSERT_EQ(3, source.depth());
+  size_t count, total = 0;
+  for (auto block = source.Next(&count); block != nullptr;
+       block = source.Next(&count)) {
+    ASSERT_TRUE(count == 64 || total + count == 1000);
+    for (size_t i = 0; i < count; i++) {
+      ASSERT_EQ(static_cast<int16_t>(total + i), block[i]);
+    }
+    total += count;
+    // The consumer is slower than the decoder
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+  ASSERT_EQ(1000U, total);
+  ASSERT_EQ(nullptr, source.Next(&count));
+}
+
+TEST(DecodingSource, Error) {
+  DecodingSource source(std::unique_ptr<AudioDecoder>(
+      new CounterDecoder(1000, 200)), 64);
+  size_t count, total = 0;
+  // The blocks decoded before the error are returned first
+  ASSERT_THROW({
+    for (auto block = source.Next(&count); block != nullptr;
+         block = source.Next(&count)) {
+      total += count;
+    }
+  }, AudioDecoderException);
+  ASSERT_EQ(192U, total);
+}
+
+TEST(DecodingSource, Abandoned) {
+  DecodingSource source(std::unique_ptr<AudioDecoder>(
+      new CounterDecoder(100000)), 64);
+  size_t count;
+  ASSERT_NE(nullptr, source.Next(&count));
+  // The destructor stops the decoding thread
+}
+
+TEST(AudioDecoder, Open) {
+  ASSERT_THROW(AudioDecoder::Open("/tmp/sfe_no_such_file.flac"),
+               AudioDecoderException);
+  auto file = fopen("/tmp/sfe_audio_decoder_test.wav", "wb");
+  ASSERT_NE(nullptr, file);
+  fputs("RIFF....WAVEfmt ", file);
+  fclose(file);
+  ASSERT_THROW(AudioDecoder::Open("/tmp/sfe_audio_decoder_test.wav"),
+               AudioDecoderException);
+}
+
+#include "tests/google/src/gtest_main.cc"
@@ -0,0 +1,549 @@
+/*! @file benchmark.cc
+ *  @brief End-to-end benchmarks of the feature sets defined by the tests.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#include <gtest/gtest.h>
+#include <sys/resource.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <sound_feature_extraction/api.h>
+#include "src/simd_aware.h"
+#include "src/transform_registry.h"
+#include "src/transform_tree.h"
+#include "tests/speech_sample.inc"
+
+using sound_feature_extraction::Accuracy;
+using sound_feature_extraction::InstructionSet;
+using sound_feature_extraction::InstructionSetName;
+using sound_feature_extraction::NodeCounters;
+using sound_feature_extraction::ProfilingLevel;
+using sound_feature_extraction::TickClock;
+using sound_feature_extraction::TransformFactory;
+using sound_feature_extraction::TransformTree;
+
+/// @brief Each benchmark prints one JSON object per line to stdout. When
+/// SFE_BENCHMARK_OUTPUT is set, the same lines are appended to that file.
+/// When SFE_BENCHMARK_BASELINE points to such a file from a previous run,
+/// every configuration is checked not to lose more than
+/// SFE_BENCHMARK_TOLERANCE (0.1 by default) of its samples/s.
+/// SFE_BENCHMARK_RUNS sets the number of timed executions (5 by default).
+/// The Transforms benchmark prints a table instead and appends the JSON
+/// lines to SFE_BENCHMARK_OUTPUT only.
+class Benchmark : public ::testing::Test {
+ public:
+  typedef std::vector<std::pair<std::string,
+      std::vector<std::pair<std::string, std::string>>>> FeatureSet;
+
+  static constexpr int kDefaultRuns = 5;
+  static constexpr float kDefaultTolerance = 0.1f;
+
+  static void SetUpTestCase() {
+    max_threads_ = get_omp_transforms_max_threads_num();
+    LoadBaseline();
+  }
+
+  static void TearDownTestCase() {
+    set_omp_transforms_max_threads_num(max_threads_);
+    set_use_simd(true);
+    set_max_instruction_set(INSTRUCTION_SET_AVX512);
+  }
+
+  /// @brief Runs the feature set for every input length, thread count,
+  /// SIMD and cache optimization mode. When AVX-512 is supported, SIMD runs
+  /// twice: with the AVX-512 kernels and capped at AVX2, giving the
+  /// before/after numbers of the wider kernels.
+  /// @param name The name of the feature set in the results.
+  /// @param features The features to extract.
+  /// @param samplingRate The sampling rate of the input.
+  /// @param lengths The input lengths in samples.
+  /// @param frameStep The step of the first Window, used to count frames.
+  void Run(const std::string& name, const FeatureSet& features,
+           int samplingRate, const std::vector<size_t>& lengths,
+           int frameStep) {
+    std::vector<int> threads { 1 };
+    if (max_threads_ > 1) {
+      threads.push_back(max_threads_);
+    }
+    for (size_t length : lengths) {
+      auto input = MakeInput(length);
+      size_t frames = (length - kFrameLength) / frameStep + 1;
+      for (int threadsNum : threads) {
+        for (auto isa : InstructionSets()) {
+          for (bool cache : { true, false }) {
+            set_omp_transforms_max_threads_num(threadsNum);
+            set_use_simd(isa != INSTRUCTION_SET_SCALAR);
+            set_max_instruction_set(isa);
+            TransformTree tt({ length, samplingRate });  // NOLINT(*)
+            tt.set_cache_optimization(cache);
+            for (auto& feature : features) {
+              tt.AddFeature(feature.first, feature.second);
+            }
+            tt.PrepareForExecution();
+            // Warm up the caches and the allocated memory
+            tt.Execute(input.data());
+            auto best = std::chrono::high_resolution_clock::duration::max();
+            int runs = Runs();
+            for (int i = 0; i < runs; i++) {
+              auto start = std::chrono::high_resolution_clock::now();
+              tt.Execute(input.data());
+              auto finish = std::chrono::high_resolution_clock::now();
+              best = std::min(best, finish - start);
+            }
+            double seconds = std::chrono::duration_cast<
+                std::chrono::duration<double>>(best).count();
+            Report(name, length, threadsNum, isa, cache,
+                   length / seconds, seconds * 1e9 / frames,
+                   tt.allocated_size());
+          }
+        }
+      }
+    }
+  }
+
+  /// @brief Runs the feature set with each accuracy tier (see
+  /// TransformTree::set_accuracy()) and reports the speed together with
+  /// the maximal relative difference of the features from the exact tier.
+  void RunAccuracy(const std::string& name, const FeatureSet& features,
+                   int samplingRate, size_t length) {
+    static const std::pair<Accuracy, const char*> tiers[] {
+      { Accuracy::kExact, "exact" },
+      { Accuracy::kBalanced, "balanced" },
+      { Accuracy::kFast, "fast" }
+    };
+    set_omp_transforms_max_threads_num(1);
+    auto input = MakeInput(length);
+    std::map<std::string, std::vector<float>> exact;
+    for (auto& tier : tiers) {
+      TransformTree tt({ length, samplingRate });  // NOLINT(*)
+      tt.set_accuracy(tier.first);
+      for (auto& feature : features) {
+        tt.AddFeature(feature.first, feature.second);
+      }
+      tt.PrepareForExecution();
+      auto results = tt.Execute(input.data());
+      auto best = std::chrono::high_resolution_clock::duration::max();
+      int runs = Runs();
+      for (int i = 0; i < runs; i++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        tt.Execute(input.data());
+        auto finish = std::chrono::high_resolution_clock::now();
+        best = std::min(best, finish - start);
+      }
+      float drift = 0;
+      for (auto& result : results) {
+        auto& buffers = *result.second;
+        size_t size = buffers.Format()->UnalignedSizeInBytes() /
+            sizeof(float);
+        auto& values = exact[result.first];
+        for (size_t i = 0; i < buffers.Count(); i++) {
+          auto ptr = reinterpret_cast<const float*>(buffers[i]);
+          for (size_t j = 0; j < size; j++) {
+            size_t index = i * size + j;
+            if (tier.first == Accuracy::kExact) {
+              values.push_back(ptr[j]);
+              continue;
+            }
+            drift = std::max(drift, std::abs(ptr[j] - values[index]) /
+                                    std::max(std::abs(values[index]), 1.f));
+          }
+        }
+      }
+      double seconds = std::chrono::duration_cast<
+          std::chrono::duration<double>>(best).count();
+      char line[512];
+      snprintf(line, sizeof(line),
+               "{\"set\": \"%s\", \"length\": %zu, \"accuracy\": \"%s\", "
+               "\"samples_per_second\": %.1f, \"max_drift\": %g}",
+               name.c_str(), length, tier.second, length / seconds, drift);
+      printf("%s\n", line);
+      auto output = std::getenv("SFE_BENCHMARK_OUTPUT");
+      if (output != nullptr) {
+        std::ofstream(output, std::ios::app) << line << std::endl;
+      }
+    }
+  }
+
+  /// @brief Runs each registered transform alone for every input length and
+  /// thread count. The transform is appended to the first of kChains
+  /// which it accepts, the time is taken from its node counters.
+  /// The elements are the float words of the input, as in
+  /// TransformTree::approximate_sharing_speedup().
+  void RunTransforms(int samplingRate, const std::vector<size_t>& lengths) {
+    std::vector<int> threads { 1 };
+    if (max_threads_ > 1) {
+      threads.push_back(max_threads_);
+    }
+    set_use_simd(true);
+    set_max_instruction_set(INSTRUCTION_SET_AVX512);
+    std::vector<std::string> names;
+    for (auto& transform : TransformFactory::Instance().Map()) {
+      names.push_back(transform.first);
+    }
+    std::sort(names.begin(), names.end());
+    printf("%-24s %8s %7s %12s %8s  %s\n", "Transform", "Length", "Threads",
+           "ns/element", "GB/s", "Chain");
+    std::vector<std::string> skipped;
+    for (auto& name : names) {
+      const FeatureSet::value_type::second_type* chain = nullptr;
+      for (auto& candidate : kChains) {
+        if (Accepts(name, candidate, samplingRate, lengths.front())) {
+          chain = &candidate;
+          break;
+        }
+      }
+      if (chain == nullptr) {
+        skipped.push_back(name);
+        continue;
+      }
+      std::string chain_str;
+      for (auto& transform : *chain) {
+        chain_str += transform.first + ", ";
+      }
+      chain_str += name;
+      for (size_t length : lengths) {
+        auto input = MakeInput(length);
+        for (int threadsNum : threads) {
+          set_omp_transforms_max_threads_num(threadsNum);
+          auto tt = BuildChain(name, *chain, samplingRate, length);
+          tt->set_profiling_level(ProfilingLevel::kCoarse);
+          tt->PrepareForExecution();
+          auto results = tt->Execute(input.data());
+          size_t in_bytes = length * sizeof(int16_t);
+          if (!chain->empty()) {
+            in_bytes = results["Input"]->Count() *
+                results["Input"]->Format()->UnalignedSizeInBytes();
+          }
+          size_t out_bytes = results["Output"]->Count() *
+              results["Output"]->Format()->UnalignedSizeInBytes();
+          uint64_t best = std::numeric_limits<uint64_t>::max();
+          int runs = Runs();
+          for (int i = 0; i < runs; i++) {
+            tt->Execute(input.data());
+            for (auto& counters : tt->NodeCountersReport()) {
+              if (counters.first == name + " [Output]") {
+                best = std::min(best, counters.second.Ticks);
+              }
+            }
+          }
+          if (best == std::numeric_limits<uint64_t>::max()) {
+            // The views are never executed
+            printf("%-24s %8zu %7i %12s %8s  %s\n", name.c_str(), length,
+                   threadsNum, "-", "-", chain_str.c_str());
+            continue;
+          }
+          double seconds = std::chrono::duration_cast<
+              std::chrono::duration<double>>(
+                  TickClock::ToDuration(best)).count();
+          double elements = in_bytes / sizeof(float);
+          ReportTransform(name, chain_str, length, threadsNum,
+                          length / seconds, seconds * 1e9 / elements,
+                          (in_bytes + out_bytes) / seconds / 1e9);
+        }
+      }
+    }
+    for (auto& name : skipped) {
+      printf("%-24s skipped: accepts none of the chains\n", name.c_str());
+    }
+  }
+
+ private:
+  static constexpr size_t kFrameLength = 512;
+  /// @brief The chains which produce the representative inputs of
+  /// RunTransforms(), from the raw samples to the spectra and the values.
+  static const std::vector<FeatureSet::value_type::second_type> kChains;
+
+  static std::shared_ptr<TransformTree> BuildChain(
+      const std::string& name,
+      const FeatureSet::value_type::second_type& chain, int samplingRate,
+      size_t length) {
+    auto tt = std::make_shared<TransformTree>(
+        sound_feature_extraction::formats::ArrayFormat16(
+            length, samplingRate));
+    // The node must be measured alone
+    tt->set_fuse_transforms(false);
+    auto full = chain;
+    full.push_back({ name, "" });
+    tt->AddFeature("Output", full);
+    if (!chain.empty()) {
+      tt->AddFeature("Input", chain);
+    }
+    return tt;
+  }
+
+  static bool Accepts(const std::string& name,
+                      const FeatureSet::value_type::second_type& chain,
+                      int samplingRate, size_t length) {
+    try {
+      auto tt = BuildChain(name, chain, samplingRate, length);
+      tt->PrepareForExecution();
+      tt->Execute(MakeInput(length).data());
+      return true;
+    }
+    catch(const std::exception&) {
+      return false;
+    }
+  }
+
+  static std::vector<int16_t> MakeInput(size_t length) {
+    std::vector<int16_t> input(length);
+    const int16_t* speech = reinterpret_cast<const int16_t*>(data);
+    const size_t speechLength = sizeof(data) / sizeof(int16_t);
+    for (size_t i = 0; i < length; i++) {
+      input[i] = speech[i % speechLength];
+    }
+    return input;
+  }
+
+  /// @brief Returns the best supported instruction set, AVX2 if the best is
+  /// AVX-512, and scalar.
+  static std::vector<InstructionSetType> InstructionSets() {
+    set_max_instruction_set(INSTRUCTION_SET_AVX512);
+    std::vector<InstructionSetType> isas { get_instruction_set() };
+    if (isas.front() == INSTRUCTION_SET_AVX512) {
+      set_max_instruction_set(INSTRUCTION_SET_AVX2);
+      isas.push_back(get_instruction_set());
+    }
+    if (isas.back() != INSTRUCTION_SET_SCALAR) {
+      isas.push_back(INSTRUCTION_SET_SCALAR);
+    }
+    return isas;
+  }
+
+  static int Runs() {
+    auto runs = std::getenv("SFE_BENCHMARK_RUNS");
+    if (runs == nullptr) {
+      return kDefaultRuns;
+    }
+    return std::max(1, std::atoi(runs));
+  }
+
+  static std::string Key(const std::string& name, size_t length, int threads,
+                         InstructionSetType isa, bool cache) {
+    char key[256];
+    snprintf(key, sizeof(key),
+             "{\"set\": \"%s\", \"length\": %zu, \"threads\": %i, "
+             "\"simd\": %s, \"instruction_set\": \"%s\", "
+             "\"cache_optimization\": %s",
+             name.c_str(), length, threads,
+             isa != INSTRUCTION_SET_SCALAR? "true" : "false",
+             InstructionSetName(static_cast<InstructionSet>(isa)),
+             cache? "true" : "false");
+    return key;
+  }
+
+  void ReportTransform(const std::string& name, const std::string& chain,
+                       size_t length, int threads, double samplesPerSecond,
+                       double nsPerElement, double gbPerSecond) {
+    printf("%-24s %8zu %7i %12.3f %8.2f  %s\n", name.c_str(), length,
+           threads, nsPerElement, gbPerSecond, chain.c_str());
+    char key[256];
+    snprintf(key, sizeof(key),
+             "{\"transform\": \"%s\", \"length\": %zu, \"threads\": %i",
+             name.c_str(), length, threads);
+    auto output = std::getenv("SFE_BENCHMARK_OUTPUT");
+    if (output != nullptr) {
+      char line[512];
+      snprintf(line, sizeof(line),
+               "%s, \"samples_per_second\": %.1f, "
+               "\"ns_per_element\": %.3f, \"gb_per_second\": %.3f}",
+               key, samplesPerSecond, nsPerElement, gbPerSecond);
+      std::ofstream(output, std::ios::app) << line << std::endl;
+    }
+    auto baseline = baseline_.find(key);
+    if (baseline != baseline_.end()) {
+      EXPECT_GE(samplesPerSecond, baseline->second * (1 - Tolerance()))
+          << key << "} regressed";
+    }
+  }
+
+  static long PeakMemory() {  // NOLINT(runtime/int)
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+  }
+
+  void Report(const std::string& name, size_t length, int threads,
+              InstructionSetType isa, bool cache, double samplesPerSecond,
+              double nsPerFrame, size_t treeMemory) {
+    auto key = Key(name, length, threads, isa, cache);
+    char line[512];
+    snprintf(line, sizeof(line),
+             "%s, \"samples_per_second\": %.1f, \"ns_per_frame\": %.1f, "
+             "\"tree_memory\": %zu, \"peak_memory_kb\": %ld}",
+             key.c_str(), samplesPerSecond, nsPerFrame, treeMemory,
+             PeakMemory());
+    printf("%s\n", line);
+    auto output = std::getenv("SFE_BENCHMARK_OUTPUT");
+    if (output != nullptr) {
+      std::ofstream(output, std::ios::app) << line << std::endl;
+    }
+    auto baseline = baseline_.find(key);
+    if (baseline != baseline_.end()) {
+      EXPECT_GE(samplesPerSecond, baseline->second * (1 - Tolerance()))
+          << key << "} regressed";
+    }
+  }
+
+  static float Tolerance() {
+    auto tolerance = std::getenv("SFE_BENCHMARK_TOLERANCE");
+    if (tolerance == nullptr) {
+      return kDefaultTolerance;
+    }
+    return std::atof(tolerance);
+  }
+
+  static void LoadBaseline() {
+    baseline_.clear();
+    auto file = std::getenv("SFE_BENCHMARK_BASELINE");
+    if (file == nullptr) {
+      return;
+    }
+    std::ifstream baseline(file);
+    std::string line;
+    const std::string marker(", \"samples_per_second\": ");
+    while (std::getline(baseline, line)) {
+      auto pos = line.find(marker);
+      if (pos == std::string::npos) {
+        continue;
+      }
+      // Later runs in the same file override the earlier ones
+      baseline_[line.substr(0, pos)] =
+          std::atof(line.c_str() + pos + marker.size());
+    }
+  }
+
+  static int max_threads_;
+  static std::map<std::string, double> baseline_;
+};
+
+int Benchmark::max_threads_ = 1;
+std::map<std::string, double> Benchmark::baseline_;
+const std::vector<Benchmark::FeatureSet::value_type::second_type>
+Benchmark::kChains {
+  {},
+  { { "Window", "length=512" } },
+  { { "Window", "length=512" }, { "RDFT", "" } },
+  { { "Window", "length=512" }, { "RDFT", "" }, { "ComplexMagnitude", "" } },
+  { { "Window", "length=512" }, { "RDFT", "" }, { "SpectralEnergy", "" },
+    { "FilterBank", "" } },
+  { { "Window", "length=512" }, { "Energy", "" } },
+  { { "Window", "length=512" }, { "Energy", "" }, { "Merge", "" } }
+};
+
+TEST_F(Benchmark, MFCC) {
+  Run("MFCC", { { "MFCC", { { "Window", "length=512" }, { "RDFT", "" },
+      { "SpectralEnergy", "" }, { "FilterBank", "squared=true" },
+      { "Log", "" }, { "Square", "" }, { "DCT", "" },
+      { "Selector", "length=16" } } } }, 16000, { 48000, 480000 }, 205);
+}
+
+TEST_F(Benchmark, SBC) {
+  Run("SBC", { { "SBC", { { "Window", "length=512, type=rectangular" },
+      { "DWPT", "" }, { "SubbandEnergy", "" }, { "Log", "" },
+      { "ZeroPadding", "" }, { "DCT", "" } } } },
+      16000, { 48000, 480000 }, 205);
+}
+
+TEST_F(Benchmark, WPP) {
+  Run("WPP", { { "WPP", { { "Window", "length=512, type=rectangular" },
+      { "DWPT", "" }, { "SubbandEnergy", "" }, { "Log", "" },
+      { "DWPT", "order=4, tree=1 2 3 3" } } } },
+      16000, { 48000, 480000 }, 205);
+}
+
+TEST_F(Benchmark, VAD) {
+  Run("VAD", {
+      { "Energy", { { "Window", "length=512" }, { "Energy", "" } } },
+      { "SFM", { { "Window", "length=512" }, { "RDFT", "" },
+          { "ComplexMagnitude", "" }, { "Mean", "types=arithmetic geometric" },
+          { "SFM", "" } } },
+      { "DominantFrequency", { { "Window", "length=512" },
+          { "RDFT", "" }, { "ComplexMagnitude", "" },
+          { "Peaks", "number=1, threads_number=1" } } }
+  }, 16000, { 48000, 480000 }, 205);
+}
+
+TEST_F(Benchmark, Tempo) {
+  Run("Tempo", { { "Tempo", {
+      { "Window", "type=rectangular,length=512,step=205" },
+      { "Window", "type=hamming" },
+      { "Fork", "factor=6" },
+      { "RDFT", "" },
+      { "FrequencyBands", "bands=200 400 800 1600 3200" },
+      { "IRDFT", "" },
+      { "IWindow", "length=512,count=6,interleaved=true" },
+      { "Rectify", "" },
+      { "Convolve", "window=half-hanning-right, length=12800" },
+      { "Diff", "rectify=true" },
+      { "Beat", "bands=6" } } } }, 22050, { 100000, 400000 }, 205);
+}
+
+TEST_F(Benchmark, MusicalSurface) {
+  FeatureSet features;
+  for (auto& feature : { "Centroid", "Rolloff", "Flux" }) {
+    features.push_back({ feature, {
+        { "Window", "length=512,step=205" }, { "RDFT", "" },
+        { "ComplexMagnitude", "" }, { feature, "" }, { "Merge", "" },
+        { "Stats", "" } } });
+  }
+  features.push_back({ "Energy", { { "Window", "length=512,step=205" },
+      { "Energy", "" }, { "Merge", "" }, { "Stats", "" } } });
+  features.push_back({ "ZeroCrossings", {
+      { "Window", "type=rectangular,length=512,step=205" },
+      { "ZeroCrossings", "" }, { "Merge", "" }, { "Stats", "" } } });
+  Run("MusicalSurface", features, 16000, { 48000, 480000 }, 205);
+}
+
+TEST_F(Benchmark, Accuracy) {
+  RunAccuracy("MFCC", { { "MFCC", { { "Window", "length=512" },
+      { "RDFT", "" }, { "SpectralEnergy", "" },
+      { "FilterBank", "squared=true" }, { "Log", "" }, { "Square", "" },
+      { "DCT", "" }, { "Selector", "length=16" } } } }, 16000, 480000);
+  RunAccuracy("LSP", { { "LSP", { { "Window", "length=512" },
+      { "Autocorrelation", "" }, { "Selector", "length=512,from=right" },
+      { "Selector", "length=13" }, { "LPC", "" }, { "LSP", "" } } },
+      { "SFM", { { "Window", "length=512" }, { "RDFT", "" },
+          { "ComplexMagnitude", "" }, { "Mean", "types=arithmetic geometric" },
+          { "SFM", "" } } } }, 16000, 480000);
+}
+
+TEST_F(Benchmark, Transforms) {
+  RunTransforms(16000, { 48000, 480000 });
+}
+
+#include "tests/google/src/gtest_main.cc"
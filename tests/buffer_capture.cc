@@ -0,0 +1,138 @@
+/*! @file buffer_capture.cc
+ *  @brief Tests for BufferCapture.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include "src/buffer_capture.h"
+#include "src/buffers.h"
+#include "src/formats/array_format.h"
+
+using sound_feature_extraction::BufferCapture;
+using sound_feature_extraction::BufferCaptureException;
+using sound_feature_extraction::Buffers;
+using sound_feature_extraction::formats::ArrayFormatF;
+
+/// @brief Reads the next record, returns false on the end of the file.
+static bool ReadRecord(FILE* file, uint64_t* execution, int32_t* slice,
+                       std::string* transform, std::vector<float>* data) {
+  uint32_t node;
+  if (fread(execution, sizeof(*execution), 1, file) != 1) {
+    return false;
+  }
+  EXPECT_EQ(1U, fread(&node, sizeof(node), 1, file));
+  EXPECT_EQ(1U, fread(slice, sizeof(*slice), 1, file));
+  for (int i = 0; i < 3; i++) {
+    uint32_t length;
+    EXPECT_EQ(1U, fread(&length, sizeof(length), 1, file));
+    std::string str(length, 0);
+    EXPECT_EQ(length, fread(&str[0], 1, length, file));
+    if (i == 0) {
+      *transform = str;
+    }
+  }
+  uint64_t count, size;
+  EXPECT_EQ(1U, fread(&count, sizeof(count), 1, file));
+  EXPECT_EQ(1U, fread(&size, sizeof(size), 1, file));
+  data->resize(count * size / sizeof(float));
+  EXPECT_EQ(count * size, fread(data->data(), 1, count * size, file));
+  return true;
+}
+
+TEST(BufferCapture, WriteRead) {
+  const int kCount = 3, kSize = 100;
+  Buffers buffers(std::make_shared<ArrayFormatF>(kSize, 16000), kCount);
+  for (int i = 0; i < kCount; i++) {
+    for (int j = 0; j < kSize; j++) {
+      reinterpret_cast<float*>(buffers[i])[j] = i * kSize + j;
+    }
+  }
+  {
+    // The ring holds less than two records, so it wraps around
+    BufferCapture capture("/tmp/sfe_buffer_capture.bin", { "Window" },
+                          kCount * kSize * sizeof(float) * 3 / 2);
+    ASSERT_TRUE(capture.Captures("Window"));
+    ASSERT_FALSE(capture.Captures("RDFT"));
+    for (int i = 0; i < 10; i++) {
+      auto execution = capture.NextExecution();
+      // Retry until the writer frees the ring
+      size_t dropped;
+      do {
+        dropped = capture.dropped_records();
+        capture.Capture(execution, 1, -1, "Window", buffers);
+        std::this_thread::yield();
+      } while (capture.dropped_records() != dropped);
+    }
+    ASSERT_TRUE(capture.Close());
+    ASSERT_EQ(10U, capture.captured_records());
+  }
+  std::unique_ptr<FILE, decltype(&fclose)> file(
+      fopen("/tmp/sfe_buffer_capture.bin", "rb"), fclose);
+  ASSERT_TRUE(static_cast<bool>(file));
+  char magic[8];
+  ASSERT_EQ(8U, fread(magic, 1, 8, file.get()));
+  ASSERT_EQ(0, memcmp(magic, BufferCapture::kMagic, 8));
+  uint64_t execution;
+  int32_t slice;
+  std::string transform;
+  std::vector<float> data;
+  int records = 0;
+  while (ReadRecord(file.get(), &execution, &slice, &transform, &data)) {
+    ASSERT_EQ(static_cast<uint64_t>(records), execution);
+    ASSERT_EQ(-1, slice);
+    ASSERT_EQ("Window", transform);
+    ASSERT_EQ(static_cast<size_t>(kCount * kSize), data.size());
+    for (int i = 0; i < kCount * kSize; i++) {
+      ASSERT_EQ(i, data[i]);
+    }
+    records++;
+  }
+  ASSERT_EQ(10, records);
+}
+
+TEST(BufferCapture, Drop) {
+  Buffers buffers(std::make_shared<ArrayFormatF>(1000, 16000), 2);
+  BufferCapture capture("/tmp/sfe_buffer_capture.bin", {}, 1000);
+  ASSERT_TRUE(capture.Captures("Window"));
+  capture.Capture(capture.NextExecution(), 0, -1, "Window", buffers);
+  ASSERT_EQ(0U, capture.captured_records());
+  ASSERT_EQ(1U, capture.dropped_records());
+  ASSERT_TRUE(capture.Close());
+}
+
+TEST(BufferCapture, Errors) {
+  ASSERT_THROW(BufferCapture("/nonexistent/capture.bin", {}),
+               BufferCaptureException);
+  ASSERT_THROW(BufferCapture("/tmp/sfe_buffer_capture.bin", {}, 0),
+               BufferCaptureException);
+}
@@ -0,0 +1,322 @@
+/*! @file cold_start.cc
+ *  @brief Measures how long it takes from loading the library to the first
+ *  extracted features and where that time goes.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#include <gtest/gtest.h>
+#include <dlfcn.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <sound_feature_extraction/api.h>
+#include "src/features_parser.h"
+#include "src/transform_tree.h"
+
+using sound_feature_extraction::TransformTree;
+
+/// @brief Loads a fresh copy of the library and measures every phase of
+/// the cold start: dlopen() (the static registration of the transforms),
+/// the metadata queries of Explorer, setup_features_extraction(), the first
+/// extract_sound_features() and the steady state, for each of kFeatureSets.
+/// Then it breaks the setup and the first extraction of the same feature
+/// sets down with TransformTree in this process: parsing, building
+/// the tree, Transform::Initialize(), the allocation plan, the allocation
+/// and the first touch of the buffers. Each phase is printed as a JSON line
+/// with the wall time and the page faults; the lines are appended to
+/// SFE_BENCHMARK_OUTPUT if it is set. SFE_COLD_START_LIBRARY overrides
+/// the path to the shared library, SFE_BENCHMARK_RUNS the number of
+/// the steady state executions (5 by default).
+/// @note The copy is read from the page cache, so the disk is not measured.
+class ColdStart : public ::testing::Test {
+ public:
+  struct Phase {
+    double Seconds;
+    long MinorFaults;  // NOLINT(runtime/int)
+    long MajorFaults;  // NOLINT(runtime/int)
+  };
+
+  static constexpr int kDefaultRuns = 5;
+  static constexpr int kSamplingRate = 16000;
+  static constexpr size_t kLength = 48000;
+
+  /// @brief The named representative feature sets.
+  static const std::vector<std::pair<const char*, std::vector<const char*>>>
+      kFeatureSets;
+
+  void Run() {
+    auto input = MakeInput(kLength);
+    auto path = LibraryPath();
+    if (path.empty()) {
+      printf("The library is linked statically, skipped loading it\n");
+    } else {
+      RunLibrary(path, &input);
+    }
+    for (auto& set : kFeatureSets) {
+      RunTree(set.first, set.second, input);
+    }
+  }
+
+ private:
+  void RunLibrary(const std::string& path, std::vector<int16_t>* input) {
+    auto copy = CopyLibrary(path);
+    ASSERT_FALSE(copy.empty());
+    // The copy has its own singletons, e.g. TransformFactory, instead of
+    // binding to those of the library this test is linked with
+    void* library = nullptr;
+    Report("", "dlopen", Measure([&]() {
+      library = dlopen(copy.c_str(), RTLD_NOW | RTLD_LOCAL | RTLD_DEEPBIND);
+    }));
+    unlink(copy.c_str());
+    ASSERT_NE(nullptr, library) << dlerror();
+    // The copy is never closed: its thread pool may still be running
+    auto query_list = Symbol<decltype(query_transforms_list)>(
+        library, "query_transforms_list");
+    auto destroy_list = Symbol<decltype(destroy_transforms_list)>(
+        library, "destroy_transforms_list");
+    auto query_details = Symbol<decltype(query_transform_details)>(
+        library, "query_transform_details");
+    auto destroy_details = Symbol<decltype(destroy_transform_details)>(
+        library, "destroy_transform_details");
+    auto query_converters = Symbol<decltype(query_format_converters_list)>(
+        library, "query_format_converters_list");
+    auto destroy_converters =
+        Symbol<decltype(destroy_format_converters_list)>(
+            library, "destroy_format_converters_list");
+    auto setup = Symbol<decltype(setup_features_extraction)>(
+        library, "setup_features_extraction");
+    auto extract = Symbol<decltype(extract_sound_features)>(
+        library, "extract_sound_features");
+    auto release = Symbol<decltype(free_results)>(library, "free_results");
+    auto destroy = Symbol<decltype(destroy_features_configuration)>(
+        library, "destroy_features_configuration");
+    ASSERT_FALSE(HasFailure());
+    // The same queries as Explorer
+    Report("", "metadata", Measure([&]() {
+      char** names;
+      int count;
+      query_list(&names, &count);
+      for (int i = 0; i < count; i++) {
+        char *description, *inputFormat, *outputFormat;
+        char **parameterNames, **parameterDescriptions, **defaultValues;
+        int parametersCount;
+        query_details(names[i], &description, &inputFormat, &outputFormat,
+                      &parameterNames, &parameterDescriptions,
+                      &defaultValues, &parametersCount);
+        destroy_details(description, inputFormat, outputFormat,
+                        parameterNames, parameterDescriptions,
+                        defaultValues, parametersCount);
+      }
+      destroy_list(names, count);
+      char **inputFormats, **outputFormats;
+      query_converters(&inputFormats, &outputFormats, &count);
+      destroy_converters(inputFormats, outputFormats, count);
+    }));
+    for (auto& set : kFeatureSets) {
+      auto& features = set.second;
+      FeaturesConfiguration* config = nullptr;
+      Report(set.first, "setup", Measure([&]() {
+        config = setup(features.data(), features.size(), kLength,
+                       kSamplingRate);
+      }));
+      ASSERT_NE(nullptr, config);
+      auto execute = [&]() {
+        char** names;
+        void** results;
+        int* lengths;
+        ASSERT_EQ(FEATURE_EXTRACTION_RESULT_OK, extract(
+            config, input->data(), &names, &results, &lengths));
+        release(features.size(), names, results, lengths);
+      };
+      Report(set.first, "first_extract", Measure(execute));
+      Report(set.first, "steady_extract", Best(execute));
+      destroy(config);
+    }
+  }
+
+  void RunTree(const char* name, const std::vector<const char*>& features,
+               const std::vector<int16_t>& input) {
+    sound_feature_extraction::RawFeaturesMap parsed;
+    Report(name, "parse", Measure([&]() {
+      parsed = sound_feature_extraction::features::Parse(
+          std::vector<std::string>(features.begin(), features.end()));
+    }), "tree");
+    TransformTree tt({ kLength, kSamplingRate });  // NOLINT(*)
+    Report(name, "build", Measure([&]() {
+      for (auto& feature : parsed) {
+        tt.AddFeature(feature.first, feature.second);
+      }
+    }), "tree");
+    auto prepare = Measure([&]() { tt.PrepareForExecution(); });
+    auto& times = tt.prepare_times();
+    char details[256];
+    snprintf(details, sizeof(details),
+             ", \"initialize_seconds\": %.6f, \"plan_seconds\": %.6f, "
+             "\"allocate_seconds\": %.6f, \"allocated\": %zu",
+             Seconds(times.Initialize), Seconds(times.Plan),
+             Seconds(times.Allocate), tt.allocated_size());
+    Report(name, "prepare", prepare, "tree", details);
+    // Mostly the first touch of the buffers
+    Report(name, "first_execute",
+           Measure([&]() { tt.Execute(input.data()); }), "tree");
+    Report(name, "steady_execute",
+           Best([&]() { tt.Execute(input.data()); }), "tree");
+  }
+
+  template <class F>
+  static Phase Measure(F&& function) {
+    rusage before, after;
+    getrusage(RUSAGE_SELF, &before);
+    auto start = std::chrono::steady_clock::now();
+    function();
+    auto finish = std::chrono::steady_clock::now();
+    getrusage(RUSAGE_SELF, &after);
+    return { Seconds(finish - start), after.ru_minflt - before.ru_minflt,
+             after.ru_majflt - before.ru_majflt };
+  }
+
+  template <class F>
+  static Phase Best(F&& function) {
+    Phase best = Measure(function);
+    for (int i = 1; i < Runs(); i++) {
+      auto phase = Measure(function);
+      if (phase.Seconds < best.Seconds) {
+        best = phase;
+      }
+    }
+    return best;
+  }
+
+  template <class Duration>
+  static double Seconds(const Duration& duration) {
+    return std::chrono::duration_cast<std::chrono::duration<double>>(
+        duration).count();
+  }
+
+  template <class T>
+  static T* Symbol(void* library, const char* name) {
+    auto symbol = dlsym(library, name);
+    EXPECT_NE(nullptr, symbol) << name;
+    return reinterpret_cast<T*>(symbol);
+  }
+
+  static int Runs() {
+    auto runs = std::getenv("SFE_BENCHMARK_RUNS");
+    if (runs == nullptr) {
+      return kDefaultRuns;
+    }
+    return std::max(1, std::atoi(runs));
+  }
+
+  /// @brief Returns the path to the shared library which this test is
+  /// linked with, or the empty string if it is linked statically.
+  static std::string LibraryPath() {
+    auto path = std::getenv("SFE_COLD_START_LIBRARY");
+    if (path != nullptr) {
+      return path;
+    }
+    Dl_info info;
+    if (dladdr(reinterpret_cast<void*>(&setup_features_extraction),
+               &info) == 0 || info.dli_fname == nullptr) {
+      return "";
+    }
+    std::string name(info.dli_fname);
+    return name.find(".so") != std::string::npos? name : "";
+  }
+
+  /// @brief The dynamic loader recognizes an already loaded library by its
+  /// device and inode, so the static initializers run again only for
+  /// a copy.
+  static std::string CopyLibrary(const std::string& path) {
+    char name[] = "/tmp/sfe_cold_start_XXXXXX.so";
+    int fd = mkstemps(name, 3);
+    if (fd < 0) {
+      return "";
+    }
+    close(fd);
+    std::ifstream source(path, std::ios::binary);
+    std::ofstream destination(name, std::ios::binary);
+    destination << source.rdbuf();
+    return destination.good()? name : "";
+  }
+
+  static std::vector<int16_t> MakeInput(size_t length) {
+    std::vector<int16_t> input(length);
+    for (size_t i = 0; i < length; i++) {
+      input[i] = sinf(i / 4.0f) * 8000 + (i * 7919 % 2000) - 1000;
+    }
+    return input;
+  }
+
+  static void Report(const char* features, const char* phase,
+                     const Phase& measured, const char* source = "library",
+                     const char* details = "") {
+    char line[768];
+    snprintf(line, sizeof(line),
+             "{\"set\": \"ColdStart\", \"source\": \"%s\", "
+             "\"features\": \"%s\", \"phase\": \"%s\", \"seconds\": %.6f, "
+             "\"minor_faults\": %ld, \"major_faults\": %ld%s}",
+             source, features, phase, measured.Seconds, measured.MinorFaults,
+             measured.MajorFaults, details);
+    printf("%s\n", line);
+    fflush(stdout);
+    auto output = std::getenv("SFE_BENCHMARK_OUTPUT");
+    if (output != nullptr) {
+      std::ofstream(output, std::ios::app) << line << std::endl;
+    }
+  }
+};
+
+const std::vector<std::pair<const char*, std::vector<const char*>>>
+ColdStart::kFeatureSets {
+  { "MFCC", {
+    "MFCC [Window(length=512), RDFT, SpectralEnergy, "
+    "FilterBank(squared=true), Log, Square, DCT, Selector(length=16)]" } },
+  { "Spectral", {
+    "Centroid [Window, RDFT, ComplexMagnitude, Centroid]",
+    "Rolloff [Window, RDFT, ComplexMagnitude, Rolloff]",
+    "Stats [Window, Energy, Stats(interval=50)]" } },
+  { "SBC", {
+    "SBC [Window(length=512, type=rectangular), DWPT, SubbandEnergy, Log, "
+    "ZeroPadding, DCT]" } }
+};
+
+TEST_F(ColdStart, FromLoadToSteadyState) {
+  Run();
+}
+
+#include "tests/google/src/gtest_main.cc"
@@ -0,0 +1,103 @@
+/*! @file execution_pipeline.cc
+ *  @brief Tests for sound_feature_extraction::ExecutionPipeline.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <random>
+#include "src/execution_pipeline.h"
+
+using sound_feature_extraction::Buffers;
+using sound_feature_extraction::ExecutionPipeline;
+using sound_feature_extraction::PipelineIsEmptyException;
+using sound_feature_extraction::PipelineIsFullException;
+using sound_feature_extraction::formats::ArrayFormat16;
+using sound_feature_extraction::TransformTree;
+
+namespace {
+
+std::vector<float> Flatten(const ExecutionPipeline::Results& results) {
+  std::vector<float> values;
+  for (auto& name : { "MFCC", "Energy" }) {
+    auto& buffers = *results.find(name)->second;
+    size_t size = buffers.Format()->UnalignedSizeInBytes() / sizeof(float);
+    for (size_t i = 0; i < buffers.Count(); i++) {
+      auto data = reinterpret_cast<const float*>(buffers[i]);
+      values.insert(values.end(), data, data + size);
+    }
+  }
+  return values;
+}
+
+}  // namespace
+
+TEST(ExecutionPipeline, SameAsExecute) {
+  auto tree = std::make_shared<TransformTree>(ArrayFormat16(8192, 16000));
+  tree->AddFeature("MFCC", { { "Window", "length=512" }, { "RDFT", "" },
+      { "SpectralEnergy", "" }, { "FilterBank", "squared=true" },
+      { "Log", "" }, { "DCT", "" } });
+  tree->AddFeature("Energy", { { "Window", "length=512" },
+      { "Energy", "" } });
+  tree->PrepareForExecution();
+  std::mt19937 random(7);
+  std::uniform_int_distribution<int> samples(-8000, 8000);
+  std::vector<std::vector<int16_t>> inputs(7, std::vector<int16_t>(8192));
+  std::vector<std::vector<float>> expected;
+  auto context = tree->CreateExecutionContext();
+  for (auto& input : inputs) {
+    for (auto& sample : input) {
+      sample = samples(random);
+    }
+    expected.push_back(Flatten(tree->Execute(input.data(), context.get())));
+  }
+
+  ExecutionPipeline pipeline(tree, 3, 2);
+  ASSERT_LE(1, pipeline.stages_count());
+  ASSERT_GE(3, pipeline.stages_count());
+  ASSERT_EQ(2, pipeline.depth());
+  size_t nodes = 0;
+  for (auto size : pipeline.StageSizes()) {
+    ASSERT_LT(0U, size);
+    nodes += size;
+  }
+  ASSERT_LT(static_cast<size_t>(pipeline.stages_count()), nodes);
+  ASSERT_THROW(pipeline.Pop(), PipelineIsEmptyException);
+  pipeline.Push(inputs[0].data());
+  pipeline.Push(inputs[1].data());
+  ASSERT_THROW(pipeline.Push(inputs[2].data()), PipelineIsFullException);
+  for (size_t i = 0; i < inputs.size(); i++) {
+    auto actual = Flatten(pipeline.Pop());
+    ASSERT_EQ(expected[i], actual) << "input " << i;
+    if (i + 2 < inputs.size()) {
+      pipeline.Push(inputs[i + 2].data());
+    }
+  }
+  ASSERT_EQ(0, pipeline.InFlight());
+  // The destructor waits for the inputs in flight
+  pipeline.Push(inputs[0].data());
+}
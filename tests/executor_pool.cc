@@ -0,0 +1,80 @@
+/*! @file executor_pool.cc
+ *  @brief Tests for ExecutorPool.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+
+#include <gtest/gtest.h>
+#include <set>
+#include "src/executor_pool.h"
+#include "src/safe_omp.h"
+
+using sound_feature_extraction::ExecutorPool;
+
+TEST(ExecutorPool, AcquireRelease) {
+  ExecutorPool<int> pool;
+  int counter = 0;
+  pool.Reset(3, [&counter]() { return std::make_shared<int>(counter++); });
+  ASSERT_EQ(3U, pool.size());
+  std::set<int> taken;
+  {
+    auto first = pool.Acquire();
+    auto second = pool.Acquire();
+    auto third = pool.Acquire();
+    taken.insert(**first);
+    taken.insert(**second);
+    taken.insert(**third);
+  }
+  ASSERT_EQ(3U, taken.size());
+  auto again = pool.Acquire();
+  ASSERT_EQ(1U, taken.count(**again));
+  auto stats = pool.Statistics();
+  ASSERT_EQ(4U, stats.Acquisitions);
+  ASSERT_EQ(0U, stats.Waits);
+}
+
+TEST(ExecutorPool, Contention) {
+  ExecutorPool<int> pool;
+  pool.Reset(1, []() { return std::make_shared<int>(0); });
+  const int kIterations = 10000;
+  #pragma omp parallel for num_threads(4)
+  for (int i = 0; i < kIterations; i++) {
+    auto executor = pool.Acquire();
+    // The executor is exclusive, so this is not a data race
+    (**executor)++;
+  }
+  ASSERT_EQ(kIterations, **pool.Acquire());
+  auto stats = pool.Statistics();
+  ASSERT_EQ(kIterations + 1U, stats.Acquisitions);
+  if (stats.Waits == 0) {
+    ASSERT_EQ(0, stats.WaitTime.count());
+  }
+}
+
+#include "tests/google/src/gtest_main.cc"
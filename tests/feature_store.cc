@@ -0,0 +1,92 @@
+/*! @file feature_store.cc
+ *  @brief Tests for FeatureStoreWriter and FeatureStoreReader.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstring>
+#include "src/feature_store.h"
+
+using sound_feature_extraction::FeatureStoreCodec;
+using sound_feature_extraction::FeatureStoreException;
+using sound_feature_extraction::FeatureStoreFormat;
+using sound_feature_extraction::FeatureStoreReader;
+using sound_feature_extraction::FeatureStoreWriter;
+
+class FeatureStoreTest : public ::testing::TestWithParam<FeatureStoreCodec> {
+};
+
+TEST_P(FeatureStoreTest, WriteRead) {
+  const int kRows = 1000, kWidth = 13;
+  std::vector<float> frames(kRows * kWidth);
+  for (int i = 0; i < kRows * kWidth; i++) {
+    frames[i] = sinf(i / 100.0f);
+  }
+  std::vector<int16_t> energy(kRows);
+  for (int i = 0; i < kRows; i++) {
+    energy[i] = i;
+  }
+  {
+    FeatureStoreWriter writer("/tmp/sfe_feature_store.bin", GetParam(), 64);
+    // Strided rows, as in the buffers of the transform tree
+    std::vector<float> padded(kRows * 16);
+    for (int i = 0; i < kRows; i++) {
+      memcpy(&padded[i * 16], &frames[i * kWidth], kWidth * sizeof(float));
+    }
+    for (int i = 0; i < kRows; i += 100) {
+      writer.Append("MFCC", &padded[i * 16], kWidth * sizeof(float),
+                    16 * sizeof(float), 100);
+      writer.Append("Energy", &energy[i], sizeof(int16_t), sizeof(int16_t),
+                    100);
+    }
+    ASSERT_THROW(writer.Append("Energy", energy.data(), 1, 1, 1),
+                 FeatureStoreException);
+    ASSERT_TRUE(writer.Close());
+  }
+  FeatureStoreReader reader("/tmp/sfe_feature_store.bin");
+  ASSERT_EQ(std::vector<std::string>({ "Energy", "MFCC" }),
+            reader.Features());
+  ASSERT_EQ(kWidth * sizeof(float), reader.RowSize("MFCC"));
+  ASSERT_EQ(static_cast<size_t>(kRows), reader.Rows("MFCC"));
+  std::vector<char> rows;
+  reader.Read("MFCC", &rows);
+  ASSERT_EQ(frames.size() * sizeof(float), rows.size());
+  ASSERT_EQ(0, memcmp(frames.data(), rows.data(), rows.size()));
+  reader.Read("Energy", &rows);
+  ASSERT_EQ(energy.size() * sizeof(int16_t), rows.size());
+  ASSERT_EQ(0, memcmp(energy.data(), rows.data(), rows.size()));
+  ASSERT_THROW(reader.Read("SBC", &rows), FeatureStoreException);
+}
+
+INSTANTIATE_TEST_CASE_P(Codecs, FeatureStoreTest, ::testing::Values(
+    FeatureStoreCodec::kNone, FeatureStoreCodec::kLZ4));
+
+#include "tests/google/src/gtest_main.cc"
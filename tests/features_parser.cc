@@ -34,6 +34,7 @@
 #include "src/features_parser.h"
 
 using sound_feature_extraction::features::Parse;
+using sound_feature_extraction::features::ParseFeaturesException;
 
 TEST(features, Parse) {
   std::vector<std::string> lines = {
@@ -91,4 +92,24 @@ TEST(features, Parse) {
   EXPECT_STREQ("order=4, tree=1 2 3 3", tit++->second.c_str());
 }
 
+TEST(features, ParseErrors) {
+  for (auto line : { "MFCC", "MFCC[", "MFCC[]", "[Window]", "MFCC[Window,]",
+                     "MFCC[Window RDFT]", "MFCC[Window(length=25]",
+                     "MFCC[Window] DCT", "MFCC(Window)" }) {
+    ASSERT_THROW(Parse({ "SBC[RDFT]", line }), ParseFeaturesException)
+        << line;
+  }
+}
+
+TEST(features, ParseSpaces) {
+  auto result = Parse({ "SBC \t[ Window ( length = 32 ) ,RDFT ]  " });
+  ASSERT_EQ(1U, result.size());
+  auto& transforms = result["SBC"];
+  ASSERT_EQ(2U, transforms.size());
+  EXPECT_STREQ("Window", transforms[0].first.c_str());
+  EXPECT_STREQ(" length = 32 ", transforms[0].second.c_str());
+  EXPECT_STREQ("RDFT", transforms[1].first.c_str());
+  EXPECT_STREQ("", transforms[1].second.c_str());
+}
+
 #include "tests/google/src/gtest_main.cc"
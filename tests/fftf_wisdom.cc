@@ -0,0 +1,125 @@
+/*! @file fftf_wisdom.cc
+ *  @brief Tests for FFTFWisdom.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+
+#include <gtest/gtest.h>
+#include <fstream>
+#include "src/execution_overrides.h"
+#include "src/fftf_wisdom.h"
+
+using sound_feature_extraction::FFTFWisdom;
+using sound_feature_extraction::ExecutionOverrides;
+using sound_feature_extraction::ScopedExecutionOverrides;
+
+TEST(FFTFWisdom, SaveLoad) {
+  auto& wisdom = FFTFWisdom::Instance();
+  wisdom.Clear();
+  ASSERT_EQ(FFTF_BACKEND_NONE, wisdom.Backend(
+      FFTF_TYPE_REAL, FFTF_DIRECTION_FORWARD, 512, 4));
+  wisdom.Set(FFTF_TYPE_REAL, FFTF_DIRECTION_FORWARD, 512, 4,
+             FFTF_BACKEND_KISS);
+  wisdom.Set(FFTF_TYPE_DCT, FFTF_DIRECTION_FORWARD, 256, 1,
+             FFTF_BACKEND_KISS);
+  ASSERT_TRUE(wisdom.Save("/tmp/sfe_fftf_wisdom.txt"));
+  wisdom.Clear();
+  ASSERT_EQ(0U, wisdom.size());
+  ASSERT_TRUE(wisdom.Load("/tmp/sfe_fftf_wisdom.txt"));
+  ASSERT_EQ(2U, wisdom.size());
+  ASSERT_EQ(FFTF_BACKEND_KISS, wisdom.Backend(
+      FFTF_TYPE_REAL, FFTF_DIRECTION_FORWARD, 512, 4));
+  ASSERT_EQ(FFTF_BACKEND_NONE, wisdom.Backend(
+      FFTF_TYPE_REAL, FFTF_DIRECTION_BACKWARD, 512, 4));
+  {
+    std::ofstream file("/tmp/sfe_fftf_wisdom.txt");
+    file << "1 0 1024 1 garbage" << std::endl;
+  }
+  wisdom.Clear();
+  ASSERT_FALSE(wisdom.Load("/tmp/sfe_fftf_wisdom.txt"));
+  ASSERT_EQ(0U, wisdom.size());
+  ASSERT_FALSE(wisdom.Load("/tmp/sfe_fftf_wisdom_missing.txt"));
+}
+
+TEST(FFTFWisdom, Autotune) {
+  auto& wisdom = FFTFWisdom::Instance();
+  wisdom.Clear();
+  wisdom.set_autotune(true);
+  auto backend = wisdom.Backend(
+      FFTF_TYPE_REAL, FFTF_DIRECTION_FORWARD, 512, 4);
+  wisdom.set_autotune(false);
+  ASSERT_NE(FFTF_BACKEND_NONE, backend);
+  ASSERT_EQ(1U, wisdom.size());
+  // The decision is remembered
+  ASSERT_EQ(backend, wisdom.Backend(
+      FFTF_TYPE_REAL, FFTF_DIRECTION_FORWARD, 512, 4));
+  wisdom.Clear();
+}
+
+TEST(FFTFWisdom, Select) {
+  auto& wisdom = FFTFWisdom::Instance();
+  wisdom.Clear();
+  wisdom.Set(FFTF_TYPE_REAL, FFTF_DIRECTION_FORWARD, 512, 1,
+             FFTF_BACKEND_KISS);
+  {
+    auto lock = wisdom.Select(FFTF_TYPE_REAL, FFTF_DIRECTION_FORWARD, 512, 1);
+    ASSERT_TRUE(lock.owns_lock());
+    ASSERT_EQ(FFTF_BACKEND_KISS, fftf_current_backend());
+  }
+  int length = FFTFWisdom::kMaxLibavLength * 2;
+  wisdom.Set(FFTF_TYPE_REAL, FFTF_DIRECTION_FORWARD, length, 1,
+             FFTF_BACKEND_LIBAV);
+  {
+    auto lock = wisdom.Select(FFTF_TYPE_REAL, FFTF_DIRECTION_FORWARD,
+                              length, 1);
+    ASSERT_NE(FFTF_BACKEND_LIBAV, fftf_current_backend());
+  }
+  wisdom.Clear();
+}
+
+TEST(FFTFWisdom, PreferGpu) {
+  auto& wisdom = FFTFWisdom::Instance();
+  wisdom.Clear();
+  ASSERT_FALSE(wisdom.prefer_gpu());
+  wisdom.set_prefer_gpu(true);
+  ASSERT_TRUE(wisdom.prefer_gpu());
+  // The tree set up before the change keeps the CPU backends
+  ExecutionOverrides overrides;
+  overrides.PreferGpu = 0;
+  {
+    ScopedExecutionOverrides scope(&overrides);
+    auto lock = wisdom.Select(FFTF_TYPE_REAL, FFTF_DIRECTION_FORWARD, 512, 1);
+    ASSERT_NE(FFTF_BACKEND_CUFFT, fftf_current_backend());
+    ASSERT_NE(FFTF_BACKEND_APPML, fftf_current_backend());
+  }
+  wisdom.set_prefer_gpu(false);
+  ASSERT_FALSE(wisdom.prefer_gpu());
+}
+
+#include "tests/google/src/gtest_main.cc"
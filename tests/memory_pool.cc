@@ -0,0 +1,133 @@
+/*! @file memory_pool.cc
+ *  @brief Tests for MemoryPool.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include "src/memory_pool.h"
+
+using sound_feature_extraction::HugePages;
+using sound_feature_extraction::MemoryPool;
+
+TEST(MemoryPool, BucketSize) {
+  ASSERT_EQ(4096U, MemoryPool::BucketSize(1));
+  ASSERT_EQ(4096U, MemoryPool::BucketSize(4096));
+  ASSERT_EQ(5120U, MemoryPool::BucketSize(4097));
+  ASSERT_EQ(8192U, MemoryPool::BucketSize(8192));
+  ASSERT_EQ(10240U, MemoryPool::BucketSize(8193));
+  ASSERT_EQ(14336U, MemoryPool::BucketSize(13000));
+  for (size_t size = 1; size < 1000000; size += 777) {
+    size_t bucket = MemoryPool::BucketSize(size);
+    ASSERT_GE(bucket, size);
+    ASSERT_LE(bucket, std::max(size * 5 / 4 + 1, static_cast<size_t>(4096)));
+  }
+}
+
+TEST(MemoryPool, Reuse) {
+  auto& pool = MemoryPool::Instance();
+  pool.set_max_idle_size(1024 * 1024);
+  void* first;
+  {
+    auto block = pool.Acquire(100000);
+    ASSERT_NE(nullptr, block.get());
+    first = block.get();
+    memset(block.get(), 0, 100000);
+  }
+  ASSERT_EQ(MemoryPool::BucketSize(100000), pool.idle_size());
+  {
+    // The similar size falls into the same bucket
+    auto block = pool.Acquire(99000);
+    ASSERT_EQ(first, block.get());
+    ASSERT_EQ(0U, pool.idle_size());
+    auto other = pool.Acquire(99000);
+    ASSERT_NE(first, other.get());
+  }
+  ASSERT_EQ(2 * MemoryPool::BucketSize(100000), pool.idle_size());
+  pool.set_max_idle_size(MemoryPool::kDefaultMaxIdleSize);
+}
+
+TEST(MemoryPool, MaxIdleSize) {
+  auto& pool = MemoryPool::Instance();
+  pool.set_max_idle_size(0);
+  ASSERT_EQ(0U, pool.idle_size());
+  {
+    auto block = pool.Acquire(100000);
+    ASSERT_NE(nullptr, block.get());
+  }
+  ASSERT_EQ(0U, pool.idle_size());
+  pool.set_max_idle_size(200000);
+  {
+    auto a = pool.Acquire(100000);
+    auto b = pool.Acquire(100000);
+  }
+  ASSERT_EQ(MemoryPool::BucketSize(100000), pool.idle_size());
+  pool.set_max_idle_size(1000);
+  ASSERT_EQ(0U, pool.idle_size());
+  pool.set_max_idle_size(MemoryPool::kDefaultMaxIdleSize);
+}
+
+TEST(MemoryPool, HugePages) {
+  auto& pool = MemoryPool::Instance();
+  const size_t size = 3 * MemoryPool::kHugePageSize;
+  for (auto mode : { HugePages::kTransparent, HugePages::kExplicit }) {
+    pool.set_huge_pages(mode);
+    ASSERT_EQ(mode, pool.huge_pages());
+    ASSERT_EQ(0U, pool.idle_size());
+    auto block = pool.Acquire(size);
+    ASSERT_NE(nullptr, block.get());
+    // Explicit huge pages may be absent, then the block must still be aligned
+    ASSERT_EQ(0U, reinterpret_cast<uintptr_t>(block.get()) %
+              MemoryPool::kHugePageSize);
+    memset(block.get(), 0xFF, size);
+    auto small = pool.Acquire(1000);
+    ASSERT_NE(nullptr, small.get());
+    memset(small.get(), 0xFF, 1000);
+  }
+  pool.set_huge_pages(HugePages::kNone);
+  ASSERT_EQ(0U, pool.idle_size());
+}
+
+TEST(MemoryPool, NumaBinding) {
+  auto& pool = MemoryPool::Instance();
+  pool.set_numa_binding(true);
+  ASSERT_TRUE(pool.numa_binding());
+  for (int i = 0; i < 2; i++) {
+    auto block = pool.Acquire(100000);
+    ASSERT_NE(nullptr, block.get());
+    memset(block.get(), 0, 100000);
+  }
+  ASSERT_EQ(MemoryPool::BucketSize(100000), pool.idle_size());
+  pool.set_numa_binding(false);
+  ASSERT_EQ(0U, pool.idle_size());
+}
+
+#include "tests/google/src/gtest_main.cc"
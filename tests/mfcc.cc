@@ -29,13 +29,13 @@
  */
 
 #include <gtest/gtest.h>
+#include <sound_feature_extraction/api.h>
 #include "src/transform_tree.h"
 #include "src/transform_registry.h"
 #include "src/formats/array_format.h"
 #include "tests/speech_sample.inc"
 
 using sound_feature_extraction::TransformTree;
-using sound_feature_extraction::BuffersBase;
 
 TEST(Features, MFCC) {
   TransformTree tt( { 48000, 16000 } );  // NOLINT(*)
@@ -0,0 +1,89 @@
+/*! @file deinterleave.cc
+ *  @brief Tests for the channels deinterleaving.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+
+#include <gtest/gtest.h>
+#include <vector>
+#include "src/primitives/deinterleave.h"
+
+using sound_feature_extraction::Deinterleave;
+using sound_feature_extraction::DeinterleaveInstructionSet;
+using sound_feature_extraction::InstructionSet;
+using sound_feature_extraction::SimdAware;
+
+TEST(Deinterleave, Scalar) {
+  const int channels = 3;
+  const size_t length = 5, stride = 7;
+  std::vector<int16_t> in(channels * length);
+  for (size_t i = 0; i < in.size(); i++) {
+    in[i] = i;
+  }
+  std::vector<int16_t> out(channels * stride, -1);
+  Deinterleave(false, in.data(), channels, length, stride, out.data());
+  for (int c = 0; c < channels; c++) {
+    for (size_t i = 0; i < length; i++) {
+      ASSERT_EQ(static_cast<int16_t>(i * channels + c), out[c * stride + i]);
+    }
+    for (size_t i = length; i < stride; i++) {
+      ASSERT_EQ(-1, out[c * stride + i]);
+    }
+  }
+}
+
+TEST(Deinterleave, InstructionSets) {
+  for (int channels : { 1, 2, 3, 4, 6, 8 }) {
+    for (size_t length : { 1, 7, 8, 15, 16, 33, 517 }) {
+      size_t stride = length + 3;
+      std::vector<int16_t> in(channels * length);
+      for (size_t i = 0; i < in.size(); i++) {
+        in[i] = static_cast<int16_t>((i * 7919) % 65536 - 32768);
+      }
+      std::vector<int16_t> reference(channels * stride);
+      Deinterleave(false, in.data(), channels, length, stride,
+                   reference.data());
+      for (int isa = 0; isa <= static_cast<int>(InstructionSet::kAVX512);
+           isa++) {
+        if (!SimdAware::IsSupported(static_cast<InstructionSet>(isa))) {
+          continue;
+        }
+        SimdAware::set_max_instruction_set(static_cast<InstructionSet>(isa));
+        std::vector<int16_t> out(channels * stride);
+        Deinterleave(true, in.data(), channels, length, stride, out.data());
+        ASSERT_EQ(reference, out) << isa << " " << channels << " " << length
+                                  << " " << static_cast<int>(
+                                      DeinterleaveInstructionSet(channels));
+      }
+    }
+  }
+  SimdAware::set_max_instruction_set(InstructionSet::kAVX512);
+}
+
+#include "tests/google/src/gtest_main.cc"
@@ -32,6 +32,11 @@
 #include <gtest/gtest.h>
 #include "src/primitives/energy.h"
 #include <simd/arithmetic-inl.h>
+#include <vector>
+#include "src/simd_aware.h"
+
+using sound_feature_extraction::InstructionSet;
+using sound_feature_extraction::SimdAware;
 
 TEST(Energy, calculate_energy) {
   const int length = 510;
@@ -51,6 +56,27 @@ TEST(Energy, calculate_energy) {
   ASSERT_NEAR((length + 1) * (2 * length + 1.0f) / 6, result, 0.01f);
 }
 
+TEST(Energy, InstructionSets) {
+  std::vector<float> array(530);
+  for (size_t i = 0; i < array.size(); i++) {
+    array[i] = (static_cast<int>((i * 7919) % 200) - 100) / 10.f;
+  }
+  for (int length = 1; length <= static_cast<int>(array.size()); length++) {
+    float reference = calculate_energy(false, false, array.data(), length);
+    for (int isa = 0; isa <= static_cast<int>(InstructionSet::kAVX512);
+         isa++) {
+      if (!SimdAware::IsSupported(static_cast<InstructionSet>(isa))) {
+        continue;
+      }
+      SimdAware::set_max_instruction_set(static_cast<InstructionSet>(isa));
+      ASSERT_NEAR(reference, calculate_energy(true, false, array.data(),
+                                              length),
+                  reference * 1e-5f + 1e-5f) << isa << " " << length;
+    }
+  }
+  SimdAware::set_max_instruction_set(InstructionSet::kAVX512);
+}
+
 #define TEST_NAME Energy
 #define ITER_COUNT 500000
 #define CUSTOM_FUNC_BASELINE(input, length) calculate_energy(false, true, \
@@ -0,0 +1,168 @@
+/*! @file fast_math.cc
+ *  @brief Tests for the approximations of log2 and exp2.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+#include "src/primitives/fast_math.h"
+
+using sound_feature_extraction::FastLog2;
+using sound_feature_extraction::FastLog2Sum;
+using sound_feature_extraction::FastSums;
+using sound_feature_extraction::FastExp2;
+using sound_feature_extraction::FastMathInstructionSet;
+using sound_feature_extraction::kFastLog2MaxError;
+using sound_feature_extraction::kFastExp2MaxError;
+using sound_feature_extraction::InstructionSet;
+using sound_feature_extraction::SimdAware;
+
+class FastMathTest : public ::testing::TestWithParam<int> {
+ protected:
+  virtual void SetUp() override {
+    auto isa = static_cast<InstructionSet>(GetParam());
+    if (!SimdAware::IsSupported(isa)) {
+      return;
+    }
+    SimdAware::set_max_instruction_set(isa);
+  }
+
+  virtual void TearDown() override {
+    SimdAware::set_max_instruction_set(InstructionSet::kAVX512);
+  }
+
+  bool Skip() const {
+    return !SimdAware::IsSupported(static_cast<InstructionSet>(GetParam()));
+  }
+};
+
+TEST_P(FastMathTest, Log2) {
+  if (Skip()) {
+    return;
+  }
+  // Walk over all the positive finite values with the odd step
+  std::vector<float> input;
+  for (int32_t bits = 1; bits < 0x7f800000; bits += 997) {
+    float x;
+    memcpy(&x, &bits, sizeof(x));
+    input.push_back(x);
+  }
+  std::vector<float> output(input.size());
+  FastLog2(true, input.data(), input.size(), output.data());
+  for (size_t i = 0; i < input.size(); i++) {
+    double expected = log2(static_cast<double>(input[i]));
+    ASSERT_NEAR(expected, output[i],
+                kFastLog2MaxError * std::max(1., std::abs(expected)))
+        << input[i] << " " << static_cast<int>(FastMathInstructionSet());
+  }
+  float sum = FastLog2Sum(true, input.data(), 1000);
+  double expected = 0;
+  for (size_t i = 0; i < 1000; i++) {
+    expected += output[i];
+  }
+  ASSERT_NEAR(expected, sum, std::abs(expected) * 1e-5);
+}
+
+TEST_P(FastMathTest, Sums) {
+  if (Skip()) {
+    return;
+  }
+  // The odd length exercises the scalar tail
+  std::vector<float> input(1003);
+  double expected_sum = 0, expected_log2sum = 0;
+  for (size_t i = 0; i < input.size(); i++) {
+    input[i] = 0.5f + i * 0.25f;
+    expected_sum += input[i];
+    expected_log2sum += log2(static_cast<double>(input[i]));
+  }
+  float sum, log2sum;
+  FastSums(true, input.data(), input.size(), &sum, &log2sum);
+  ASSERT_NEAR(expected_sum, sum, expected_sum * 1e-5);
+  ASSERT_NEAR(expected_log2sum, log2sum, expected_log2sum * 1e-5);
+  ASSERT_EQ(log2sum, FastLog2Sum(true, input.data(), input.size()));
+  input[input.size() / 2] = 0;
+  FastSums(true, input.data(), input.size(), &sum, &log2sum);
+  ASSERT_EQ(-std::numeric_limits<float>::infinity(), log2sum);
+}
+
+TEST_P(FastMathTest, Log2Special) {
+  if (Skip()) {
+    return;
+  }
+  const float inf = std::numeric_limits<float>::infinity();
+  std::vector<float> input { 0, -1, inf, -inf,
+                             std::numeric_limits<float>::quiet_NaN(), 1, 8,
+                             0.5f, 0 };
+  std::vector<float> output(input.size());
+  FastLog2(true, input.data(), input.size(), output.data());
+  EXPECT_EQ(-inf, output[0]);
+  EXPECT_TRUE(std::isnan(output[1]));
+  EXPECT_EQ(inf, output[2]);
+  EXPECT_TRUE(std::isnan(output[3]));
+  EXPECT_TRUE(std::isnan(output[4]));
+  EXPECT_NEAR(0, output[5], kFastLog2MaxError);
+  EXPECT_NEAR(3, output[6], kFastLog2MaxError * 3);
+  EXPECT_NEAR(-1, output[7], kFastLog2MaxError);
+  EXPECT_EQ(-inf, output[8]);
+}
+
+TEST_P(FastMathTest, Exp2) {
+  if (Skip()) {
+    return;
+  }
+  std::vector<float> input;
+  for (float x = -125; x < 128; x += 0.0013f) {
+    input.push_back(x);
+  }
+  input.push_back(-126);
+  input.push_back(-std::numeric_limits<float>::infinity());
+  input.push_back(128);
+  input.push_back(1000);
+  std::vector<float> output(input.size());
+  FastExp2(true, input.data(), input.size(), output.data());
+  size_t size = input.size() - 4;
+  for (size_t i = 0; i < size; i++) {
+    double expected = exp2(static_cast<double>(input[i]));
+    ASSERT_NEAR(1, output[i] / expected, kFastExp2MaxError)
+        << input[i] << " " << static_cast<int>(FastMathInstructionSet());
+  }
+  EXPECT_EQ(0, output[size]);
+  EXPECT_EQ(0, output[size + 1]);
+  EXPECT_EQ(std::numeric_limits<float>::infinity(), output[size + 2]);
+  EXPECT_EQ(std::numeric_limits<float>::infinity(), output[size + 3]);
+}
+
+INSTANTIATE_TEST_CASE_P(
+    InstructionSets, FastMathTest,
+    ::testing::Range(0, static_cast<int>(InstructionSet::kAVX512) + 1));
+
+#include "tests/google/src/gtest_main.cc"
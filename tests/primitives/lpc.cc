@@ -33,8 +33,13 @@
 #include <simd/correlate.h>
 #include <simd/memory.h>
 #include <simd/arithmetic-inl.h>
+#include <vector>
 #include "src/primitives/lpc.h"
 #include "src/make_unique.h"
+#include "src/simd_aware.h"
+
+using sound_feature_extraction::InstructionSet;
+using sound_feature_extraction::SimdAware;
 
 float CalculateLPCError(const float* ac, int length, const float* lpc) {
   float serr = 0;
@@ -82,6 +87,54 @@ TEST(LPC, ldr_lpc) {
   }
 }
 
+TEST(LPC, ldr_lpc_batch) {
+  const int length = 13, count = 37;
+  std::vector<std::vector<float>> ac(count), reference(count), lpc(count);
+  std::vector<const float*> acs(count);
+  std::vector<float*> lpcs(count);
+  std::vector<float> reference_errors(count), errors(count);
+  for (int f = 0; f < count; f++) {
+    float signal[length * 2];
+    for (int i = 0; i < length * 2; i++) {
+      signal[i] = sinf(i * (f + 1) * 0.1f) + ((i * 7919 + f) % 17) / 17.f;
+    }
+    ac[f].resize(length);
+    for (int k = 0; k < length; k++) {
+      ac[f][k] = 0;
+      for (int i = k; i < length * 2; i++) {
+        ac[f][k] += signal[i] * signal[i - k];
+      }
+    }
+    reference[f].resize(length - 1);
+    lpc[f].resize(length - 1);
+    acs[f] = ac[f].data();
+    lpcs[f] = lpc[f].data();
+  }
+  // Silence is the special case
+  std::fill(ac[5].begin(), ac[5].end(), 0.f);
+  for (int f = 0; f < count; f++) {
+    reference_errors[f] = ldr_lpc(false, acs[f], length, reference[f].data());
+  }
+  for (int isa = 0; isa <= static_cast<int>(InstructionSet::kAVX512); isa++) {
+    if (!SimdAware::IsSupported(static_cast<InstructionSet>(isa))) {
+      continue;
+    }
+    SimdAware::set_max_instruction_set(static_cast<InstructionSet>(isa));
+    ldr_lpc_batch(true, acs.data(), count, length, lpcs.data(),
+                  errors.data());
+    for (int f = 0; f < count; f++) {
+      ASSERT_NEAR(reference_errors[f], errors[f],
+                  fabsf(reference_errors[f]) * 1e-4f) << isa << " " << f;
+      for (int k = 0; k < length - 1; k++) {
+        ASSERT_NEAR(reference[f][k], lpc[f][k],
+                    fabsf(reference[f][k]) * 1e-4f + 1e-5f)
+            << isa << " " << f << " " << k;
+      }
+    }
+  }
+  SimdAware::set_max_instruction_set(InstructionSet::kAVX512);
+}
+
 #ifdef BENCHMARK
 class LPCTest : public ::testing::TestWithParam<bool> {
  public:
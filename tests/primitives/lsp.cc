@@ -34,8 +34,13 @@
 #include <simd/correlate.h>
 #include <simd/memory.h>
 #include <simd/arithmetic-inl.h>
+#include <vector>
 #include "src/primitives/lsp.h"
 #include "src/primitives/lpc.h"
+#include "src/simd_aware.h"
+
+using sound_feature_extraction::InstructionSet;
+using sound_feature_extraction::SimdAware;
 
 TEST(LSP, lpc_to_lsp) {
   const int length = 16;
@@ -61,5 +66,50 @@ TEST(LSP, lpc_to_lsp) {
   }
 }
 
+TEST(LSP, lpc_to_lsp_batch) {
+  const int length = 16, count = 21, bisects = 16;
+  const float delta = 0.015625f;
+  std::vector<std::vector<float>> lpc(count), reference(count), freq(count);
+  std::vector<const float*> lpcs(count);
+  std::vector<float*> freqs(count);
+  std::vector<int> reference_roots(count), roots(count);
+  for (int f = 0; f < count; f++) {
+    // LPC of an exponentially decaying autocorrelation is stable
+    float ac[length + 1];
+    for (int k = 0; k <= length; k++) {
+      ac[k] = powf(0.95f - f * 0.04f, k) * cosf(k * (f + 1) * 0.13f) +
+          (k == 0) * 0.01f;
+    }
+    lpc[f].resize(length);
+    ldr_lpc(false, ac, length + 1, lpc[f].data());
+    reference[f].resize(length);
+    freq[f].resize(length);
+    lpcs[f] = lpc[f].data();
+    freqs[f] = freq[f].data();
+    reference_roots[f] = lpc_to_lsp(false, lpcs[f], length, bisects, delta,
+                                    reference[f].data());
+  }
+  for (auto refinement : { LSP_REFINEMENT_BISECTION,
+                           LSP_REFINEMENT_ILLINOIS }) {
+    for (int isa = 0; isa <= static_cast<int>(InstructionSet::kAVX512);
+         isa++) {
+      if (!SimdAware::IsSupported(static_cast<InstructionSet>(isa))) {
+        continue;
+      }
+      SimdAware::set_max_instruction_set(static_cast<InstructionSet>(isa));
+      lpc_to_lsp_batch(true, lpcs.data(), count, length, bisects, delta,
+                       refinement, freqs.data(), roots.data());
+      for (int f = 0; f < count; f++) {
+        ASSERT_EQ(reference_roots[f], roots[f]) << refinement << " " << isa
+                                                  << " " << f;
+        for (int i = 0; i < length; i++) {
+          ASSERT_NEAR(cosf(reference[f][i]), cosf(freq[f][i]), delta)
+              << refinement << " " << isa << " " << f << " " << i;
+        }
+      }
+    }
+  }
+  SimdAware::set_max_instruction_set(InstructionSet::kAVX512);
+}
 
 #include "tests/google/src/gtest_main.cc"
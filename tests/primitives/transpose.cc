@@ -0,0 +1,86 @@
+/*! @file transpose.cc
+ *  @brief Tests for the cache blocked matrix transposition.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#include <gtest/gtest.h>
+#include <vector>
+#include "src/primitives/transpose.h"
+
+using sound_feature_extraction::Transpose;
+using sound_feature_extraction::TransposeInstructionSet;
+using sound_feature_extraction::InstructionSet;
+using sound_feature_extraction::SimdAware;
+
+TEST(Transpose, Scalar) {
+  const size_t rows = 3, cols = 5, inStride = 7, outStride = 4;
+  std::vector<float> in(rows * inStride);
+  for (size_t i = 0; i < in.size(); i++) {
+    in[i] = i;
+  }
+  std::vector<float> out(cols * outStride, -1);
+  Transpose(false, in.data(), rows, cols, inStride, out.data(), outStride);
+  for (size_t c = 0; c < cols; c++) {
+    for (size_t r = 0; r < rows; r++) {
+      ASSERT_EQ(in[r * inStride + c], out[c * outStride + r]);
+    }
+    ASSERT_EQ(-1, out[c * outStride + rows]);
+  }
+}
+
+TEST(Transpose, InstructionSets) {
+  for (size_t rows : { 1, 4, 7, 8, 17, 64 }) {
+    for (size_t cols : { 1, 3, 8, 16, 31, 100 }) {
+      size_t inStride = cols + 5, outStride = rows + 3;
+      std::vector<float> in(rows * inStride);
+      for (size_t i = 0; i < in.size(); i++) {
+        in[i] = i * 0.5f - 100;
+      }
+      std::vector<float> reference(cols * outStride);
+      Transpose(false, in.data(), rows, cols, inStride, reference.data(),
+                outStride);
+      for (int isa = 0; isa <= static_cast<int>(InstructionSet::kAVX512);
+           isa++) {
+        if (!SimdAware::IsSupported(static_cast<InstructionSet>(isa))) {
+          continue;
+        }
+        SimdAware::set_max_instruction_set(static_cast<InstructionSet>(isa));
+        std::vector<float> out(cols * outStride);
+        Transpose(true, in.data(), rows, cols, inStride, out.data(),
+                  outStride);
+        ASSERT_EQ(reference, out) << isa << " " << rows << " " << cols
+                                  << " " << static_cast<int>(
+                                      TransposeInstructionSet());
+      }
+    }
+  }
+  SimdAware::set_max_instruction_set(InstructionSet::kAVX512);
+}
+
+#include "tests/google/src/gtest_main.cc"
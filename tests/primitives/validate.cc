@@ -0,0 +1,86 @@
+/*! @file validate.cc
+ *  @brief Tests for src/primitives/validate.c.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#include <gtest/gtest.h>
+#include "src/primitives/validate.h"
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "src/simd_aware.h"
+
+using sound_feature_extraction::InstructionSet;
+using sound_feature_extraction::SimdAware;
+
+TEST(Validate, find_nonfinite) {
+  std::vector<float> array(100, 0.f);
+  int nonzero = 0;
+  ASSERT_EQ(array.size(), find_nonfinite(true, array.data(), array.size(),
+                                         &nonzero));
+  ASSERT_FALSE(nonzero);
+  array[77] = 1;
+  ASSERT_EQ(array.size(), find_nonfinite(true, array.data(), array.size(),
+                                         &nonzero));
+  ASSERT_TRUE(nonzero);
+}
+
+TEST(Validate, InstructionSets) {
+  const float invalid[] = { std::numeric_limits<float>::quiet_NaN(),
+                            std::numeric_limits<float>::infinity(),
+                            -std::numeric_limits<float>::infinity() };
+  std::vector<float> array(70, 0.f);
+  for (int isa = 0; isa <= static_cast<int>(InstructionSet::kAVX512); isa++) {
+    if (!SimdAware::IsSupported(static_cast<InstructionSet>(isa))) {
+      continue;
+    }
+    SimdAware::set_max_instruction_set(static_cast<InstructionSet>(isa));
+    for (size_t length = 1; length <= array.size(); length++) {
+      for (size_t index = 0; index < length; index++) {
+        for (float value : invalid) {
+          array[index] = value;
+          int nonzero = 0;
+          ASSERT_EQ(index, find_nonfinite(true, array.data(), length,
+                                          &nonzero))
+              << isa << " " << length << " " << value;
+          ASSERT_FALSE(nonzero);
+          array[index] = 0;
+        }
+      }
+      array[length - 1] = -1;
+      int nonzero = 0;
+      ASSERT_EQ(length, find_nonfinite(true, array.data(), length, &nonzero));
+      ASSERT_TRUE(nonzero) << isa << " " << length;
+      array[length - 1] = 0;
+    }
+  }
+  SimdAware::set_max_instruction_set(InstructionSet::kAVX512);
+}
+
+#include "tests/google/src/gtest_main.cc"
@@ -28,8 +28,11 @@
  *  under the License.
  */
 
+#include <cmath>
 #include <gtest/gtest.h>
+#include <simd/memory.h>
 #include "src/primitives/wavelet_filter_bank.h"
+#include "src/simd_aware.h"
 
 using sound_feature_extraction::primitives::WaveletFilterBank;
 using sound_feature_extraction::TreeFingerprint;
@@ -37,6 +40,8 @@ using sound_feature_extraction::Parse;
 using sound_feature_extraction::primitives::
     WaveletTreeInvalidDescriptionException;
 using sound_feature_extraction::WaveletTreeDescriptionParseException;
+using sound_feature_extraction::InstructionSet;
+using sound_feature_extraction::SimdAware;
 
 TEST(WaveletFilterBank, ValidateDescription) {
   std::vector<int> desc { 3, 3, 2, 2, 3, 3 };  // NOLINT(*)
@@ -132,4 +137,106 @@ TEST(WaveletFilterBank, ApplyNotAPowerOf2) {
   }
 }
 
+TEST(WaveletFilterBank, ApplyBatch) {
+  const int count = 21;
+  std::vector<TreeFingerprint> trees {
+    { 3, 4, 4, 2, 2, 5, 5, 4, 3 },
+    { 3, 3, 3, 4, 4, 4, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 6, 6, 6, 6, 6, 6, 6, 6 }
+  };
+  for (size_t length : { 512, 320 }) {
+    std::vector<std::vector<float>> src(count), reference(count), res(count);
+    std::vector<const float*> srcs(count);
+    std::vector<float*> ress(count);
+    for (int f = 0; f < count; f++) {
+      src[f].resize(length);
+      reference[f].resize(length);
+      res[f].resize(length);
+      for (size_t i = 0; i < length; i++) {
+        src[f][i] = sinf(i * (f + 1) * 0.05f) + ((i * 7919 + f) % 17) / 17.f;
+      }
+      srcs[f] = src[f].data();
+      ress[f] = res[f].data();
+    }
+    auto scratch = std::unique_ptr<float, decltype(&std::free)>(
+        mallocf(WaveletFilterBank::BatchScratchSize(length)), std::free);
+    for (auto wp : Wavelets) {
+      for (int order : wp.second) {
+        for (auto& tree : trees) {
+          WaveletFilterBank wfb(wp.first, order, tree);
+          for (int f = 0; f < count; f++) {
+            wfb.Apply(srcs[f], length, reference[f].data());
+          }
+          for (int isa = 0; isa <= static_cast<int>(InstructionSet::kAVX512);
+               isa++) {
+            if (!SimdAware::IsSupported(static_cast<InstructionSet>(isa))) {
+              continue;
+            }
+            SimdAware::set_max_instruction_set(
+                static_cast<InstructionSet>(isa));
+            wfb.ApplyBatch(isa != 0, srcs.data(), count, length,
+                           scratch.get(), ress.data());
+            for (int f = 0; f < count; f++) {
+              for (size_t i = 0; i < length; i++) {
+                ASSERT_NEAR(reference[f][i], res[f][i],
+                            fabsf(reference[f][i]) * 1e-4f + 1e-4f)
+                    << order << " " << isa << " " << f << " " << i;
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+  SimdAware::set_max_instruction_set(InstructionSet::kAVX512);
+}
+
+TEST(WaveletFilterBank, ApplyBatchEnergy) {
+  const int count = 19;
+  const size_t length = 512;
+  TreeFingerprint tree { 3, 4, 4, 2, 2, 5, 5, 4, 3 };
+  std::vector<std::vector<float>> src(count), subbands(count),
+      energies(count);
+  std::vector<const float*> srcs(count);
+  std::vector<float*> subbandss(count), energiess(count);
+  for (int f = 0; f < count; f++) {
+    src[f].resize(length);
+    subbands[f].resize(length);
+    energies[f].resize(tree.size());
+    for (size_t i = 0; i < length; i++) {
+      src[f][i] = cosf(i * (f + 2) * 0.03f) + ((i * 104729 + f) % 13) / 13.f;
+    }
+    srcs[f] = src[f].data();
+    subbandss[f] = subbands[f].data();
+    energiess[f] = energies[f].data();
+  }
+  auto scratch = std::unique_ptr<float, decltype(&std::free)>(
+      mallocf(WaveletFilterBank::BatchScratchSize(length)), std::free);
+  WaveletFilterBank wfb(WAVELET_TYPE_DAUBECHIES, 8, tree);
+  for (int isa = 0; isa <= static_cast<int>(InstructionSet::kAVX512);
+       isa++) {
+    if (!SimdAware::IsSupported(static_cast<InstructionSet>(isa))) {
+      continue;
+    }
+    SimdAware::set_max_instruction_set(static_cast<InstructionSet>(isa));
+    wfb.ApplyBatch(isa != 0, srcs.data(), count, length, scratch.get(),
+                   subbandss.data());
+    wfb.ApplyBatchEnergy(isa != 0, srcs.data(), count, length,
+                         scratch.get(), energiess.data());
+    for (int f = 0; f < count; f++) {
+      size_t offset = 0;
+      for (size_t leaf = 0; leaf < tree.size(); leaf++) {
+        size_t size = length >> tree[leaf];
+        float energy = 0;
+        for (size_t i = offset; i < offset + size; i++) {
+          energy += subbands[f][i] * subbands[f][i];
+        }
+        offset += size;
+        ASSERT_NEAR(energy, energies[f][leaf], energy * 1e-5f)
+            << isa << " " << f << " " << leaf;
+      }
+    }
+  }
+  SimdAware::set_max_instruction_set(InstructionSet::kAVX512);
+}
+
 #include "tests/google/src/gtest_main.cc"
@@ -0,0 +1,107 @@
+/*! @file profiler.cc
+ *  @brief Tests for Profiler.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#include <gtest/gtest.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "src/profiler.h"
+
+using sound_feature_extraction::Profiler;
+
+TEST(Profiler, Histogram) {
+  Profiler::Histogram histogram;
+  ASSERT_EQ(0U, histogram.Count());
+  ASSERT_EQ(0, histogram.Percentile(0.5f).count());
+  for (int i = 1; i <= 1000; i++) {
+    histogram.Add(std::chrono::microseconds(i));
+  }
+  ASSERT_EQ(1000U, histogram.Count());
+  ASSERT_EQ(std::chrono::microseconds(500500), histogram.Sum());
+  auto us = [](Profiler::Clock::duration value) {
+    return std::chrono::duration_cast<std::chrono::duration<float,
+        std::micro>>(value).count();
+  };
+  float median = us(histogram.Percentile(0.5f));
+  ASSERT_GE(median, 500.f);
+  ASSERT_LE(median, 500.f * 9 / 8);
+  float p99 = us(histogram.Percentile(0.99f));
+  ASSERT_GE(p99, 990.f);
+  ASSERT_LE(p99, 990.f * 9 / 8);
+  ASSERT_GE(us(histogram.Percentile(1.f)), 1000.f);
+  ASSERT_LE(us(histogram.Percentile(0.f)), 1.f * 9 / 8);
+}
+
+TEST(Profiler, Statistics) {
+  Profiler profiler(false);
+  ASSERT_FALSE(profiler.trace());
+  int first, second;
+  auto start = Profiler::Clock::now();
+  auto finish = start + std::chrono::milliseconds(1);
+  profiler.AddNodeSample(&first, "First", start, finish, 100, 200, -1);
+  profiler.AddNodeSample(&second, "Second", start, finish, 10, 20, 0);
+  profiler.AddNodeSample(&first, "First", start, finish, 100, 200, -1);
+  auto stats = profiler.Statistics();
+  ASSERT_EQ(2U, stats.size());
+  ASSERT_EQ("First", stats[0].first);
+  ASSERT_EQ(2U, stats[0].second.Durations.Count());
+  ASSERT_EQ(200U, stats[0].second.BytesIn);
+  ASSERT_EQ(400U, stats[0].second.BytesOut);
+  ASSERT_EQ("Second", stats[1].first);
+  ASSERT_EQ(1U, stats[1].second.Durations.Count());
+  profiler.Reset();
+  ASSERT_EQ(0U, profiler.Statistics().size());
+}
+
+TEST(Profiler, SaveTrace) {
+  Profiler profiler(true);
+  ASSERT_TRUE(profiler.trace());
+  int node;
+  auto start = Profiler::Clock::now();
+  auto finish = start + std::chrono::milliseconds(1);
+  profiler.AddNodeSample(&node, "Window [\"MFCC\"]", start, finish, 1, 2, 3);
+  profiler.AddRegion("Execute", start, finish);
+  profiler.SaveTrace("/tmp/test_profiler_trace.json");
+  std::ifstream file("/tmp/test_profiler_trace.json");
+  std::stringstream contents;
+  contents << file.rdbuf();
+  auto trace = contents.str();
+  ASSERT_EQ(0U, trace.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["));
+  ASSERT_NE(std::string::npos, trace.find("\"name\":\"Window [\\\"MFCC\\\"]\""));
+  ASSERT_NE(std::string::npos, trace.find("\"slice\":3"));
+  ASSERT_NE(std::string::npos, trace.find("\"bytes_out\":2"));
+  ASSERT_NE(std::string::npos, trace.find("\"name\":\"Execute\""));
+  ASSERT_NE(std::string::npos, trace.find("\"cat\":\"region\""));
+  ASSERT_THROW(profiler.SaveTrace("/nonexistent/trace.json"),
+               sound_feature_extraction::FailedToWriteTraceException);
+}
+
+#include "tests/google/src/gtest_main.cc"
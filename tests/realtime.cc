@@ -0,0 +1,154 @@
+/*! @file realtime.cc
+ *  @brief Tests for the real-time execution mode.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <thread>
+#include "src/memory_pool.h"
+#include "src/realtime.h"
+#include "src/transform_tree.h"
+#include "tests/speech_sample.inc"
+
+using sound_feature_extraction::MemoryPool;
+using sound_feature_extraction::RealtimeSection;
+using sound_feature_extraction::TransformTree;
+
+// Any allocation in a real-time section is a violation as well
+void* operator new(size_t size) {
+  RealtimeSection::Check("operator new");
+  void* ptr = malloc(size > 0? size : 1);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+  if (ptr != nullptr) {
+    RealtimeSection::Check("operator delete");
+  }
+  free(ptr);
+}
+
+TEST(Realtime, Violations) {
+  RealtimeSection::set_trap(false);
+  size_t violations = RealtimeSection::Violations();
+  RealtimeSection::Check("outside");
+  ASSERT_EQ(violations, RealtimeSection::Violations());
+  ASSERT_FALSE(RealtimeSection::Active());
+  {
+    RealtimeSection section;
+    ASSERT_TRUE(RealtimeSection::Active());
+    {
+      RealtimeSection nested;
+    }
+    ASSERT_TRUE(RealtimeSection::Active());
+    RealtimeSection::Check("test");
+    ASSERT_EQ(violations + 1, RealtimeSection::Violations());
+    ASSERT_STREQ("test", RealtimeSection::LastViolation());
+    auto memory = MemoryPool::Instance().Acquire(1000);
+    ASSERT_LT(violations + 1, RealtimeSection::Violations());
+  }
+  ASSERT_FALSE(RealtimeSection::Active());
+  violations = RealtimeSection::Violations();
+  {
+    RealtimeSection unchecked(false);
+    ASSERT_TRUE(RealtimeSection::Active());
+    RealtimeSection::Check("test");
+  }
+  ASSERT_EQ(violations, RealtimeSection::Violations());
+}
+
+void AddFeatures(TransformTree* tt) {
+  tt->AddFeature("MFCC", { { "Window", "length=512" }, { "RDFT", "" },
+      { "SpectralEnergy", "" }, { "FilterBank", "squared=true" },
+      { "Log", "" }, { "Square", "" }, { "DCT", "" },
+      { "Selector", "length=16" } });
+  tt->AddFeature("Centroid", { { "Window", "length=512" }, { "RDFT", "" },
+      { "ComplexMagnitude", "" }, { "Centroid", "" } });
+}
+
+void CompareResults(TransformTree* reference, TransformTree* actual,
+                    const int16_t* buffers) {
+  auto expected = reference->Execute(buffers);
+  auto& res = actual->Execute(buffers);
+  ASSERT_EQ(expected.size(), res.size());
+  for (auto& feature : expected) {
+    auto& buffers = res.find(feature.first)->second;
+    ASSERT_EQ(feature.second->Count(), buffers->Count());
+    size_t size = feature.second->Format()->UnalignedSizeInBytes();
+    for (size_t i = 0; i < buffers->Count(); i++) {
+      ASSERT_EQ(0, memcmp((*feature.second)[i], (*buffers)[i], size))
+          << feature.first << " differs at " << i;
+    }
+  }
+}
+
+TEST(Realtime, Execute) {
+  RealtimeSection::set_trap(false);
+  int16_t* buffers = new int16_t[48000];
+  memcpy(buffers, data, sizeof(data));
+  TransformTree reference( { 48000, 16000 } );  // NOLINT(*)
+  AddFeatures(&reference);
+  reference.PrepareForExecution();
+  TransformTree tt( { 48000, 16000 } );  // NOLINT(*)
+  tt.set_realtime(true);
+  ASSERT_TRUE(tt.realtime());
+  tt.set_validate_after_each_transform(true);
+  AddFeatures(&tt);
+  tt.PrepareForExecution();
+  size_t violations = RealtimeSection::Violations();
+  // The audio callback thread has never executed anything
+  std::thread audio([&]() {
+    for (int i = 0; i < 3; i++) {
+      tt.Execute(buffers);
+    }
+  });
+  audio.join();
+  ASSERT_EQ(violations, RealtimeSection::Violations())
+      << RealtimeSection::LastViolation();
+  CompareResults(&reference, &tt, buffers);
+  // The changed features are prepared again by the next execution
+  reference.AddFeature("Energy", { { "Window", "length=512" },
+                                   { "Energy", "" } });
+  tt.AddFeature("Energy", { { "Window", "length=512" }, { "Energy", "" } });
+  CompareResults(&reference, &tt, buffers);
+  violations = RealtimeSection::Violations();
+  tt.Execute(buffers);
+  ASSERT_EQ(violations, RealtimeSection::Violations())
+      << RealtimeSection::LastViolation();
+  delete[] buffers;
+}
+
+#include "tests/google/src/gtest_main.cc"
@@ -0,0 +1,141 @@
+/*! @file scratch_arena.cc
+ *  @brief Tests for ScratchArena.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <thread>
+#include "src/scratch_arena.h"
+
+using sound_feature_extraction::ScratchArena;
+
+TEST(ScratchArena, Nested) {
+  ScratchArena::Trim();
+  auto first = ScratchArena::Acquire(100);
+  auto second = ScratchArena::Acquire(10);
+  ASSERT_NE(nullptr, first.get());
+  ASSERT_NE(nullptr, second.get());
+  ASSERT_EQ(0U, reinterpret_cast<uintptr_t>(first.get()) % 64);
+  ASSERT_EQ(0U, reinterpret_cast<uintptr_t>(second.get()) % 64);
+  // The leases do not overlap
+  ASSERT_TRUE(second.get() >= first.get() + 100 ||
+              second.get() + 10 <= first.get());
+  for (int i = 0; i < 100; i++) {
+    first.get()[i] = i;
+  }
+  for (int i = 0; i < 10; i++) {
+    second.get()[i] = -1;
+  }
+  for (int i = 0; i < 100; i++) {
+    ASSERT_EQ(i, first.get()[i]);
+  }
+}
+
+TEST(ScratchArena, Reuse) {
+  ScratchArena::Trim();
+  ASSERT_EQ(0U, ScratchArena::ThreadSize());
+  float* ptr;
+  {
+    auto lease = ScratchArena::Acquire(1000);
+    ptr = lease.get();
+  }
+  // The next lease of another transform takes the same memory
+  auto lease = ScratchArena::Acquire(500);
+  ASSERT_EQ(ptr, lease.get());
+}
+
+TEST(ScratchArena, Merge) {
+  ScratchArena::Trim();
+  {
+    auto small = ScratchArena::Acquire(16);
+    auto large = ScratchArena::Acquire(4096);
+    ASSERT_EQ((16 + 4096) * sizeof(float), ScratchArena::ThreadSize());
+  }
+  // The blocks are merged into a single one of the peak size
+  ASSERT_EQ((16 + 4096) * sizeof(float), ScratchArena::ThreadSize());
+  size_t total = ScratchArena::TotalSize();
+  {
+    auto small = ScratchArena::Acquire(16);
+    auto large = ScratchArena::Acquire(4096);
+    ASSERT_EQ((16 + 4096) * sizeof(float), ScratchArena::ThreadSize());
+  }
+  ASSERT_EQ(total, ScratchArena::TotalSize());
+  ScratchArena::Trim();
+  ASSERT_EQ(0U, ScratchArena::ThreadSize());
+  ASSERT_EQ(total - (16 + 4096) * sizeof(float), ScratchArena::TotalSize());
+}
+
+TEST(ScratchArena, Threads) {
+  ScratchArena::Trim();
+  auto lease = ScratchArena::Acquire(256);
+  float* other = nullptr;
+  size_t other_size = 0;
+  std::thread thread([&]() {
+    auto own = ScratchArena::Acquire(256);
+    other = own.get();
+    other_size = ScratchArena::ThreadSize();
+  });
+  thread.join();
+  ASSERT_NE(lease.get(), other);
+  ASSERT_EQ(256 * sizeof(float), other_size);
+  ASSERT_EQ(256 * sizeof(float), ScratchArena::ThreadSize());
+}
+
+TEST(ScratchArena, FixedBlock) {
+  ScratchArena::Trim();
+  alignas(64) float block[64];
+  {
+    ScratchArena::FixedBlock fixed(block, 64);
+    {
+      auto first = ScratchArena::Acquire(10);
+      auto second = ScratchArena::Acquire(20);
+      ASSERT_EQ(block, first.get());
+      ASSERT_EQ(block + 16, second.get());
+      // Does not fit, taken from the stack of the thread
+      auto third = ScratchArena::Acquire(100);
+      ASSERT_NE(nullptr, third.get());
+      ASSERT_TRUE(third.get() < block || third.get() >= block + 64);
+      ASSERT_EQ(16U + 32 + 112, fixed.peak());
+    }
+    auto again = ScratchArena::Acquire(64);
+    ASSERT_EQ(block, again.get());
+  }
+  {
+    ScratchArena::FixedBlock measure(nullptr, 0);
+    auto first = ScratchArena::Acquire(10);
+    auto second = ScratchArena::Acquire(20);
+    ASSERT_EQ(16U + 32, measure.peak());
+  }
+  auto lease = ScratchArena::Acquire(10);
+  ASSERT_TRUE(lease.get() < block || lease.get() >= block + 64);
+}
+
+#include "tests/google/src/gtest_main.cc"
@@ -0,0 +1,75 @@
+/*! @file shared_state.cc
+ *  @brief Tests for SharedState().
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include "src/shared_state.h"
+
+using sound_feature_extraction::SharedState;
+using sound_feature_extraction::SharedStatesCount;
+
+TEST(SharedState, Intern) {
+  int created = 0;
+  auto create = [&created]() {
+    created++;
+    return std::make_shared<std::string>("state");
+  };
+  size_t count = SharedStatesCount();
+  auto first = SharedState<std::string>("SharedState.Intern", create);
+  auto second = SharedState<std::string>("SharedState.Intern", create);
+  ASSERT_EQ(1, created);
+  ASSERT_EQ(first.get(), second.get());
+  ASSERT_EQ("state", *first);
+  ASSERT_EQ(count + 1, SharedStatesCount());
+  auto other = SharedState<std::string>("SharedState.Other", create);
+  ASSERT_EQ(2, created);
+  ASSERT_NE(first.get(), other.get());
+  ASSERT_EQ(count + 2, SharedStatesCount());
+}
+
+TEST(SharedState, Expire) {
+  int created = 0;
+  auto create = [&created]() {
+    created++;
+    return std::make_shared<int>(created);
+  };
+  size_t count = SharedStatesCount();
+  auto state = SharedState<int>("SharedState.Expire", create);
+  ASSERT_EQ(1, *state);
+  state.reset();
+  ASSERT_EQ(count, SharedStatesCount());
+  // The cache does not keep the states alive
+  state = SharedState<int>("SharedState.Expire", create);
+  ASSERT_EQ(2, *state);
+  ASSERT_EQ(count + 1, SharedStatesCount());
+}
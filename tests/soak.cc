@@ -0,0 +1,278 @@
+/*! @file soak.cc
+ *  @brief Long-running check of the memory growth under the configuration
+ *  churn and the concurrent extractions.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#include <gtest/gtest.h>
+#include <malloc.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sound_feature_extraction/api.h>
+#include "src/memory_pool.h"
+
+#ifdef __GLIBC__
+#if __GLIBC_PREREQ(2, 33)
+#define HAVE_MALLINFO2
+#endif
+#endif
+
+using sound_feature_extraction::MemoryPool;
+
+/// @brief Sets up, uses and destroys the configurations from several
+/// threads for SFE_SOAK_SECONDS (60 by default; hours on the soak hosts),
+/// while a long-lived configuration is extracted concurrently from
+/// the same threads. Every SFE_SOAK_PERIOD seconds (5 by default) it prints
+/// a JSON line with RSS, the heap and the memory pool usage and
+/// the throughput; the lines are appended to SFE_BENCHMARK_OUTPUT if it is
+/// set. Fails if RSS or the heap in use grow by more than SFE_SOAK_TOLERANCE
+/// (0.1 by default) between the first and the last thirds of the samples
+/// after the first quarter, which is the warm-up.
+/// SFE_SOAK_THREADS overrides the number of the threads.
+class Soak : public ::testing::Test {
+ public:
+  struct Sample {
+    double Seconds;
+    size_t Rss;
+    size_t HeapUsed;
+    size_t HeapFree;
+    size_t PoolUsed;
+    size_t PoolIdle;
+    double Extractions;
+    double Setups;
+  };
+
+  static constexpr int kDefaultSeconds = 60;
+  static constexpr int kDefaultPeriod = 5;
+  static constexpr float kDefaultTolerance = 0.1f;
+  static constexpr int kSamplingRate = 16000;
+
+  /// @brief The feature sets of the short-lived configurations.
+  static const std::vector<std::vector<const char*>> kFeatureSets;
+  /// @brief The input sizes of the short-lived configurations.
+  static const std::vector<size_t> kSizes;
+
+  void Run() {
+    int seconds = EnvInt("SFE_SOAK_SECONDS", kDefaultSeconds);
+    int period = EnvInt("SFE_SOAK_PERIOD", kDefaultPeriod);
+    int threads = EnvInt(
+        "SFE_SOAK_THREADS",
+        std::max(2, std::min(8, static_cast<int>(
+            std::thread::hardware_concurrency()))));
+    auto input = MakeInput(kSizes.back());
+    auto& shared_set = kFeatureSets.front();
+    auto shared = setup_features_extraction(
+        shared_set.data(), shared_set.size(), kSizes.front(), kSamplingRate);
+    ASSERT_NE(nullptr, shared);
+    std::atomic<bool> stop(false), failed(false);
+    std::atomic<size_t> extractions(0), setups(0);
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; i++) {
+      workers.emplace_back([&, i]() {
+        std::mt19937 rng(i);
+        while (!stop && !failed) {
+          // A quarter of the extractions share the long-lived configuration
+          if (rng() % 4 == 0) {
+            failed = failed || !Extract(shared, shared_set.size(),
+                                        input.data());
+            extractions++;
+            continue;
+          }
+          auto& set = kFeatureSets[rng() % kFeatureSets.size()];
+          auto size = kSizes[rng() % kSizes.size()];
+          auto config = setup_features_extraction(
+              set.data(), set.size(), size, kSamplingRate);
+          if (config == nullptr) {
+            failed = true;
+            break;
+          }
+          setups++;
+          for (int j = 1 + rng() % 8; j > 0; j--) {
+            failed = failed || !Extract(config, set.size(), input.data());
+            extractions++;
+          }
+          destroy_features_configuration(config);
+        }
+      });
+    }
+    std::vector<Sample> samples;
+    auto start = std::chrono::steady_clock::now();
+    size_t last_extractions = 0, last_setups = 0;
+    for (int elapsed = period; elapsed <= seconds && !failed;
+         elapsed += period) {
+      std::this_thread::sleep_until(start + std::chrono::seconds(elapsed));
+      size_t done = extractions, created = setups;
+      samples.push_back(Measure(
+          elapsed, static_cast<double>(done - last_extractions) / period,
+          static_cast<double>(created - last_setups) / period));
+      last_extractions = done;
+      last_setups = created;
+      Report(samples.back());
+    }
+    stop = true;
+    for (auto& worker : workers) {
+      worker.join();
+    }
+    destroy_features_configuration(shared);
+    ASSERT_FALSE(failed);
+    CheckGrowth(samples, "rss", &Sample::Rss);
+    CheckGrowth(samples, "heap_used", &Sample::HeapUsed);
+  }
+
+ private:
+  static int EnvInt(const char* name, int defaultValue) {
+    auto value = std::getenv(name);
+    return value != nullptr? std::atoi(value) : defaultValue;
+  }
+
+  static float Tolerance() {
+    auto tolerance = std::getenv("SFE_SOAK_TOLERANCE");
+    if (tolerance == nullptr) {
+      return kDefaultTolerance;
+    }
+    return std::atof(tolerance);
+  }
+
+  static std::vector<int16_t> MakeInput(size_t length) {
+    std::vector<int16_t> input(length);
+    for (size_t i = 0; i < length; i++) {
+      input[i] = sinf(i / 4.0f) * 8000 + (i * 7919 % 2000) - 1000;
+    }
+    return input;
+  }
+
+  static bool Extract(FeaturesConfiguration* config, int count,
+                      int16_t* input) {
+    char** names;
+    void** results;
+    int* lengths;
+    if (extract_sound_features(config, input, &names, &results, &lengths) !=
+        FEATURE_EXTRACTION_RESULT_OK) {
+      return false;
+    }
+    free_results(count, names, results, lengths);
+    return true;
+  }
+
+  static Sample Measure(double seconds, double extractions, double setups) {
+    Sample sample;
+    sample.Seconds = seconds;
+    // The second field of statm is the resident set in pages
+    size_t pages = 0, resident = 0;
+    std::ifstream("/proc/self/statm") >> pages >> resident;
+    sample.Rss = resident * sysconf(_SC_PAGESIZE);
+#ifdef HAVE_MALLINFO2
+    auto heap = mallinfo2();
+#else
+    auto heap = mallinfo();
+#endif
+    sample.HeapUsed = heap.uordblks + heap.hblkhd;
+    sample.HeapFree = heap.fordblks;
+    sample.PoolUsed = MemoryPool::Instance().used_size();
+    sample.PoolIdle = MemoryPool::Instance().idle_size();
+    sample.Extractions = extractions;
+    sample.Setups = setups;
+    return sample;
+  }
+
+  static void Report(const Sample& sample) {
+    char line[512];
+    snprintf(line, sizeof(line),
+             "{\"set\": \"Soak\", \"seconds\": %.0f, \"rss\": %zu, "
+             "\"heap_used\": %zu, \"heap_free\": %zu, \"pool_used\": %zu, "
+             "\"pool_idle\": %zu, \"extractions_per_second\": %.1f, "
+             "\"setups_per_second\": %.1f}",
+             sample.Seconds, sample.Rss, sample.HeapUsed, sample.HeapFree,
+             sample.PoolUsed, sample.PoolIdle, sample.Extractions,
+             sample.Setups);
+    printf("%s\n", line);
+    fflush(stdout);
+    auto output = std::getenv("SFE_BENCHMARK_OUTPUT");
+    if (output != nullptr) {
+      std::ofstream(output, std::ios::app) << line << std::endl;
+    }
+  }
+
+  /// @brief Compares the medians of the first and the last thirds of
+  /// the samples after the warm-up, so that a single spike does not fail
+  /// the run while a steady creep does.
+  static void CheckGrowth(const std::vector<Sample>& samples,
+                          const char* name, size_t Sample::*field) {
+    size_t warmup = samples.size() / 4;
+    size_t third = (samples.size() - warmup) / 3;
+    if (third == 0) {
+      printf("Too few samples to check the growth of %s\n", name);
+      return;
+    }
+    auto median = [&](size_t begin) {
+      std::vector<size_t> values;
+      for (size_t i = begin; i < begin + third; i++) {
+        values.push_back(samples[i].*field);
+      }
+      std::nth_element(values.begin(), values.begin() + third / 2,
+                       values.end());
+      return static_cast<double>(values[third / 2]);
+    };
+    double first = median(warmup);
+    double last = median(samples.size() - third);
+    EXPECT_LE(last, first * (1 + Tolerance()))
+        << name << " grew from " << first << " to " << last;
+  }
+};
+
+const std::vector<std::vector<const char*>> Soak::kFeatureSets {
+  { "MFCC [Window(length=512), RDFT, SpectralEnergy, "
+    "FilterBank(squared=true), Log, Square, DCT, Selector(length=16)]" },
+  { "MFCC [Window(length=512), RDFT, SpectralEnergy, "
+    "FilterBank(squared=true), Log, Square, DCT, Selector(length=16)]",
+    "Energy [Window(length=400, step=160), Energy]" },
+  { "Centroid [Window, RDFT, ComplexMagnitude, Centroid]",
+    "Rolloff [Window, RDFT, ComplexMagnitude, Rolloff]",
+    "Stats [Window, Energy, Stats(interval=50)]" },
+  { "SBC [Window(length=512, type=rectangular), DWPT, SubbandEnergy, Log, "
+    "ZeroPadding, DCT]" }
+};
+
+const std::vector<size_t> Soak::kSizes { 16000, 24000, 48000 };
+
+TEST_F(Soak, ConfigurationsChurn) {
+  Run();
+}
+
+#include "tests/google/src/gtest_main.cc"
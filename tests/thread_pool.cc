@@ -0,0 +1,317 @@
+/*! @file thread_pool.cc
+ *  @brief Tests for ThreadPool.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+#include "src/thread_pool.h"
+
+using sound_feature_extraction::ThreadPool;
+using sound_feature_extraction::ExecutionOverrides;
+using sound_feature_extraction::ScopedExecutionOverrides;
+using sound_feature_extraction::CurrentExecutionOverrides;
+using sound_feature_extraction::ThreadsGovernor;
+using sound_feature_extraction::CancellationSource;
+using sound_feature_extraction::CancellationToken;
+using sound_feature_extraction::ExecutionCancelled;
+
+TEST(ThreadPool, ParallelFor) {
+  auto& pool = ThreadPool::Instance();
+  pool.set_threads_number(4);
+  ASSERT_EQ(4, pool.threads_number());
+  std::vector<int> hits(1000, 0);
+  std::atomic<int> ranges(0);
+  pool.ParallelFor(hits.size(), 1, 4, [&](size_t begin, size_t end) {
+    ranges++;
+    for (size_t i = begin; i < end; i++) {
+      hits[i]++;
+    }
+  });
+  ASSERT_EQ(4, ranges);
+  for (int hit : hits) {
+    ASSERT_EQ(1, hit);
+  }
+  // The grain limits the number of the ranges
+  ranges = 0;
+  pool.ParallelFor(10, 5, 4, [&](size_t begin, size_t end) {
+    ASSERT_EQ(5U, end - begin);
+    ranges++;
+  });
+  ASSERT_EQ(2, ranges);
+  ranges = 0;
+  pool.ParallelFor(0, 1, 4, [&](size_t, size_t) { ranges++; });
+  ASSERT_EQ(0, ranges);
+}
+
+TEST(ThreadPool, Nested) {
+  auto& pool = ThreadPool::Instance();
+  pool.set_threads_number(3);
+  std::atomic<int> sum(0);
+  std::set<int> workers;
+  std::mutex workers_mutex;
+  pool.ParallelFor(8, 1, 3, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      pool.ParallelFor(100, 1, 3, [&](size_t b, size_t e) {
+        sum += e - b;
+        std::lock_guard<std::mutex> lock(workers_mutex);
+        workers.insert(ThreadPool::CurrentThreadIndex());
+      });
+    }
+  });
+  ASSERT_EQ(800, sum);
+  ASSERT_LE(workers.size(), 3U);
+}
+
+TEST(ThreadPool, TaskGroup) {
+  auto& pool = ThreadPool::Instance();
+  pool.set_threads_number(2);
+  std::atomic<int> done(0);
+  {
+    ThreadPool::TaskGroup tasks;
+    for (int i = 0; i < 16; i++) {
+      tasks.Spawn([&done] { done++; });
+    }
+    tasks.Wait();
+    ASSERT_EQ(16, done);
+    tasks.Spawn([&done] { done++; });
+  }
+  ASSERT_EQ(17, done);
+  pool.set_threads_number(1);
+  std::atomic<int> ranges(0);
+  pool.ParallelFor(100, 1, 8, [&](size_t, size_t) { ranges++; });
+  ASSERT_EQ(1, ranges);
+}
+
+TEST(ThreadPool, Submit) {
+  auto& pool = ThreadPool::Instance();
+  pool.set_threads_number(3);
+  std::atomic<int> done(0);
+  for (int i = 0; i < 8; i++) {
+    pool.Submit([&done] { done++; });
+  }
+  // The workers drain the queue before they stop
+  pool.set_threads_number(1);
+  ASSERT_EQ(8, done);
+  // Executed in the calling thread
+  pool.Submit([&done] { done++; });
+  ASSERT_EQ(9, done);
+}
+
+TEST(ThreadPool, SubmitNotRunByWaiter) {
+  auto& pool = ThreadPool::Instance();
+  pool.set_threads_number(2);
+  std::promise<void> release;
+  auto released = release.get_future().share();
+  std::atomic<bool> busy(false);
+  pool.Submit([&busy, released] {
+    busy = true;
+    released.wait();
+  });
+  while (!busy) {
+    std::this_thread::yield();
+  }
+  std::atomic<int> runner(-1);
+  // The only worker is busy, so the waiter runs all the ranges itself
+  // and must leave the task submitted from the first one to the worker
+  std::atomic<int> ranges(0);
+  pool.ParallelFor(100, 1, 4, [&](size_t, size_t) {
+    if (ranges++ == 0) {
+      pool.Submit([&runner] { runner = ThreadPool::CurrentThreadIndex(); });
+    }
+  });
+  ASSERT_LT(1, ranges);
+  ASSERT_EQ(-1, runner);
+  release.set_value();
+  while (runner < 0) {
+    std::this_thread::yield();
+  }
+  ASSERT_NE(0, runner);
+}
+
+TEST(ThreadPool, Affinity) {
+  auto& pool = ThreadPool::Instance();
+  pool.set_threads_number(2);
+  pool.set_cpus({ 0 });
+  ASSERT_EQ(std::vector<int>({ 0 }), pool.cpus());
+  std::atomic<int> sum(0);
+  pool.ParallelFor(10, 1, 2, [&](size_t begin, size_t end) {
+    sum += end - begin;
+  });
+  ASSERT_EQ(10, sum);
+  pool.set_cpus({});
+  ASSERT_TRUE(pool.cpus().empty());
+  for (int cpu : ThreadPool::NumaNodeCpus(0)) {
+    ASSERT_GE(cpu, 0);
+  }
+  ASSERT_TRUE(ThreadPool::NumaNodeCpus(100000).empty());
+}
+
+TEST(ThreadPool, ExecutionOverrides) {
+  auto& pool = ThreadPool::Instance();
+  pool.set_threads_number(4);
+  ExecutionOverrides overrides;
+  overrides.ThreadsNumber = 2;
+  std::atomic<int> matched(0), mismatched(0);
+  {
+    ScopedExecutionOverrides scope(&overrides);
+    pool.ParallelFor(100, 1, 4, [&](size_t, size_t) {
+      if (CurrentExecutionOverrides() == &overrides) {
+        matched++;
+      } else {
+        mismatched++;
+      }
+    });
+  }
+  ASSERT_EQ(4, matched);
+  ASSERT_EQ(0, mismatched);
+  // The workers restore their own overrides after the task
+  ASSERT_EQ(nullptr, CurrentExecutionOverrides());
+  pool.ParallelFor(100, 1, 4, [&](size_t, size_t) {
+    if (CurrentExecutionOverrides() != nullptr) {
+      mismatched++;
+    }
+  });
+  ASSERT_EQ(0, mismatched);
+}
+
+TEST(ThreadPool, ThreadsGovernor) {
+  auto& pool = ThreadPool::Instance();
+  pool.set_threads_number(4);
+  auto& governor = ThreadsGovernor::Instance();
+  ASSERT_FALSE(governor.enabled());
+  auto chunks = [&pool]() {
+    std::atomic<int> count(0);
+    pool.ParallelFor(100, 1, 4, [&](size_t, size_t) { count++; });
+    return count.load();
+  };
+  {
+    ThreadsGovernor::Lease budget(3);
+    ASSERT_EQ(3, budget.threads());
+    ASSERT_EQ(3, chunks());
+    ASSERT_EQ(0, governor.State().Executions);
+  }
+  ASSERT_EQ(4, chunks());
+  governor.set_enabled(true);
+  {
+    ThreadsGovernor::Lease first(0);
+    ASSERT_EQ(4, first.threads());
+    ASSERT_EQ(4, chunks());
+    {
+      // The first execution sheds half of its threads
+      ThreadsGovernor::Lease second(0);
+      ASSERT_EQ(2, governor.State().Executions);
+      ASSERT_EQ(2, governor.State().Share);
+      ASSERT_EQ(2, first.threads());
+      ASSERT_EQ(2, chunks());
+      std::atomic<int> nested(0);
+      pool.ParallelFor(2, 1, 4, [&](size_t, size_t) {
+        // The workers inherit the lease
+        if (ThreadsGovernor::CurrentLease() == &second) {
+          nested++;
+        }
+      });
+      ASSERT_EQ(2, nested);
+      ThreadsGovernor::Lease third(1);
+      ASSERT_EQ(1, third.threads());
+      ASSERT_EQ(1, chunks());
+    }
+    // and takes them back
+    ASSERT_EQ(4, first.threads());
+  }
+  ASSERT_EQ(0, governor.State().Executions);
+  ASSERT_EQ(4, governor.State().Share);
+  governor.set_enabled(false);
+}
+
+TEST(ThreadPool, Cancellation) {
+  auto& pool = ThreadPool::Instance();
+  pool.set_threads_number(4);
+  ASSERT_FALSE(ExecutionCancelled());
+  CancellationSource source;
+  CancellationToken token(&source);
+  std::atomic<int> ranges(0);
+  pool.ParallelFor(4, 1, 4, [&](size_t, size_t) {
+    ranges++;
+  });
+  ASSERT_EQ(4, ranges);
+  ASSERT_FALSE(ExecutionCancelled());
+  source.Cancel();
+  ASSERT_TRUE(ExecutionCancelled());
+  ranges = 0;
+  pool.ParallelFor(4, 1, 4, [&](size_t, size_t) {
+    ranges++;
+  });
+  // Only the calling thread's range runs, the workers skip theirs
+  ASSERT_EQ(1, ranges);
+  {
+    // A new token is not cancelled by the past Cancel()
+    CancellationToken nested(&source);
+    ASSERT_FALSE(ExecutionCancelled());
+  }
+  {
+    CancellationToken timeout(nullptr, std::chrono::milliseconds(1));
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    ASSERT_TRUE(ExecutionCancelled());
+  }
+}
+
+TEST(ThreadPool, Fork) {
+  auto& pool = ThreadPool::Instance();
+  pool.set_threads_number(4);
+  pool.ParallelFor(4, 1, 4, [](size_t, size_t) {});
+  pid_t pid = fork();
+  ASSERT_NE(-1, pid);
+  if (pid == 0) {
+    // The workers of the parent do not exist in the child
+    std::atomic<int> ranges(0);
+    std::set<std::thread::id> threads;
+    std::mutex mutex;
+    pool.ParallelFor(4, 1, 4, [&](size_t, size_t) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      std::lock_guard<std::mutex> lock(mutex);
+      threads.insert(std::this_thread::get_id());
+      ranges++;
+    });
+    pool.set_threads_number(2);
+    _exit(ranges == 4 && threads.size() > 1? 0 : 1);
+  }
+  int status;
+  ASSERT_EQ(pid, waitpid(pid, &status, 0));
+  ASSERT_TRUE(WIFEXITED(status));
+  ASSERT_EQ(0, WEXITSTATUS(status));
+}
+
+#include "tests/google/src/gtest_main.cc"
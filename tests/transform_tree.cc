@@ -29,15 +29,57 @@
  */
 
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <new>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+#include <sound_feature_extraction/api.h>
+#include "src/cancellation.h"
+#include "src/omp_transform_base.h"
+#include "src/precomputed_state.h"
 #include "src/transform_base.h"
 #include "src/transform_tree.h"
+#include "tests/speech_sample.inc"
 
 using namespace sound_feature_extraction;  // NOLINT(*)
 using namespace sound_feature_extraction::formats;  // NOLINT(*)
 
+/// @brief The number of the heap allocations of the whole test, to check
+/// that the steady state TransformTree::Execute() does not allocate.
+static std::atomic<size_t> allocations_count(0);
+
+void* operator new(size_t size) {
+  allocations_count++;
+  void* ptr = malloc(size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+  free(ptr);
+}
+
 struct ParentChunk {
 };
 
+/// @brief The buffers which ParentTestTransform, InputTestTransform and
+/// InPlaceTestTransform saw during the last execution.
+static const void* parent_output = nullptr;
+static const void* child_input = nullptr;
+static const void* in_place_output = nullptr;
+/// @brief Whether ParallelTestTransform with Cost = 1 and Cost > 1 ran
+/// serially during the last execution.
+static bool serial_runs[2] = { false, false };
+
 class ParentTestFormat : public BufferFormatBase<ParentChunk> {
  public:
   virtual void Validate(const BuffersBase<ParentChunk>&) const override {
@@ -70,8 +112,9 @@ class ParentTestTransform
                                  BuffersBase<ParentChunk>*) const noexcept {
   }
 
-  virtual void Do(const BuffersBase<int16_t*>&, BuffersBase<ParentChunk> *)
+  virtual void Do(const BuffersBase<int16_t*>&, BuffersBase<ParentChunk>* out)
       const noexcept {
+    parent_output = &(*out)[0];
   }
 };
 
@@ -121,8 +164,94 @@ class ChildTestTransform
 
 ALWAYS_VALID_TP(ChildTestTransform, AnalysisLength)
 RTP(ChildTestTransform, AnalysisLength)
+
+class OverrunTestTransform
+    : public TransformBase<ParentTestFormat, ChildTestFormat> {
+ public:
+  TRANSFORM_INTRO("OverrunTest", "", OverrunTestTransform)
+
+ protected:
+  virtual void InitializeBuffers(const BuffersBase<ParentChunk>&,
+                                 BuffersBase<ChildChunk>*)
+  const noexcept {
+  }
+
+  virtual void Do(const BuffersBase<ParentChunk>&,
+                  BuffersBase<ChildChunk>* out) const noexcept {
+    reinterpret_cast<char*>(&(*out)[0])[out->SizeInBytes()] = 0;
+  }
+};
+
+class InputTestTransform
+    : public TransformBase<ParentTestFormat, ChildTestFormat> {
+ public:
+  TRANSFORM_INTRO("InputTest", "", InputTestTransform)
+
+ protected:
+  virtual void InitializeBuffers(const BuffersBase<ParentChunk>&,
+                                 BuffersBase<ChildChunk>*)
+  const noexcept {
+  }
+
+  virtual void Do(const BuffersBase<ParentChunk>& in,
+                  BuffersBase<ChildChunk>*) const noexcept {
+    child_input = &in[0];
+  }
+};
+
+class InPlaceTestTransform
+    : public TransformBase<ParentTestFormat, ParentTestFormat> {
+ public:
+  TRANSFORM_INTRO("InPlaceTest", "", InPlaceTestTransform)
+
+  virtual bool InPlace() const noexcept override {
+    return true;
+  }
+
+ protected:
+  virtual void InitializeBuffers(const BuffersBase<ParentChunk>&,
+                                 BuffersBase<ParentChunk>*)
+  const noexcept {
+  }
+
+  virtual void Do(const BuffersBase<ParentChunk>&,
+                  BuffersBase<ParentChunk>* out) const noexcept {
+    in_place_output = &(*out)[0];
+  }
+};
+
+class ParallelTestTransform
+    : public OmpAwareTransform<ParentTestFormat, ChildTestFormat> {
+ public:
+  TRANSFORM_INTRO("ParallelTest", "", ParallelTestTransform)
+
+  TP(Cost, int, 1, "The cost of processing one element")
+
+  virtual float ElementCost() const noexcept override {
+    return Cost();
+  }
+
+ protected:
+  virtual void InitializeBuffers(const BuffersBase<ParentChunk>&,
+                                 BuffersBase<ChildChunk>*)
+  const noexcept {
+  }
+
+  virtual void Do(const BuffersBase<ParentChunk>&,
+                  BuffersBase<ChildChunk>*) const noexcept {
+    serial_runs[Cost() > 1] = serial();
+  }
+};
+
+ALWAYS_VALID_TP(ParallelTestTransform, Cost)
+RTP(ParallelTestTransform, Cost)
+
 REGISTER_TRANSFORM(ParentTestTransform);
 REGISTER_TRANSFORM(ChildTestTransform);
+REGISTER_TRANSFORM(OverrunTestTransform);
+REGISTER_TRANSFORM(InputTestTransform);
+REGISTER_TRANSFORM(InPlaceTestTransform);
+REGISTER_TRANSFORM(ParallelTestTransform);
 
 class TransformTreeTest : public TransformTree, public testing::Test {
  public:
@@ -149,6 +278,419 @@ TEST_F(TransformTreeTest, AddFeature) {
   PrepareForExecution();
 }
 
+TEST_F(TransformTreeTest, MergeEquivalentParameters) {
+  AddFeature("One", { {"ParentTest", "" }, { "ChildTest", "" } });
+  ASSERT_EQ(0U, merged_nodes_count());
+  // Both parameters are the defaults written differently
+  AddFeature("Two", { {"ParentTest", "AmplifyFactor=01" },
+                      { "ChildTest", "AnalysisLength=128" } });
+  ASSERT_EQ(2U, merged_nodes_count());
+  size_t bytes = merged_bytes();
+  ASSERT_GT(bytes, 0U);
+  AddFeature("Three", { {"ParentTest", "AmplifyFactor=2" },
+                        { "ChildTest", "" } });
+  ASSERT_EQ(2U, merged_nodes_count());
+  ASSERT_EQ(bytes, merged_bytes());
+  PrepareForExecution();
+}
+
+TEST(TransformTree, CloseFloatParameters) {
+  TransformTree tt({ 4096, 16000 });  // NOLINT(*)
+  // The factors differ below 1e-6 and must not be merged
+  tt.AddFeature("One", { { "Preemphasis", "value=0.0000001" } });
+  tt.AddFeature("Two", { { "Preemphasis", "value=0.0000002" } });
+  tt.AddFeature("Three", { { "Preemphasis", "value=0.000030517578" } });
+  tt.AddFeature("Four", { { "Preemphasis", "value=0.000030517" } });
+  size_t merged = tt.merged_nodes_count();
+  // The same factor written differently is merged
+  tt.AddFeature("Five", { { "Preemphasis", "value=2e-7" } });
+  ASSERT_LT(merged, tt.merged_nodes_count());
+  tt.PrepareForExecution();
+  std::vector<int16_t> input(4096, 1);
+  auto results = tt.Execute(input.data());
+  auto value = [&](const char* name) {
+    return reinterpret_cast<const float*>((*results[name])[0])[1];
+  };
+  ASSERT_NE(value("One"), value("Two"));
+  ASSERT_NE(value("Three"), value("Four"));
+  ASSERT_EQ(value("Two"), value("Five"));
+}
+
+TEST(TransformTree, SignalsIndependent) {
+  TransformTree tt({ 4810, 16000 });  // NOLINT(*)
+  tt.set_batch_size(4);
+  tt.AddFeature("Spectrum", { { "Window", "length=512" }, { "RDFT", "" },
+                              { "SpectralEnergy", "" } });
+  std::string culprit;
+  ASSERT_TRUE(tt.SignalsIndependent(&culprit));
+  ASSERT_TRUE(culprit.empty());
+  tt.AddFeature("Delta", { { "Window", "length=512" }, { "RDFT", "" },
+                           { "SpectralEnergy", "" }, { "Delta", "" } });
+  ASSERT_FALSE(tt.SignalsIndependent(&culprit));
+  ASSERT_EQ("Delta", culprit);
+  TransformTree stats({ 4810, 16000 });  // NOLINT(*)
+  stats.set_batch_size(4);
+  stats.AddFeature("Stats", { { "Window", "length=512" }, { "Energy", "" },
+                              { "Stats", "" } });
+  ASSERT_FALSE(stats.SignalsIndependent(nullptr));
+}
+
+TEST_F(TransformTreeTest, AddEquivalence) {
+  ASSERT_THROW(AddEquivalence("Nonexistent", ""),
+               TransformNotRegisteredException);
+  AddEquivalence("ParentTest", "");
+  AddFeature("One", { {"ParentTest", "" }, { "ChildTest", "" } });
+  AddFeature("Two", { {"ParentTest", "AmplifyFactor=2" },
+                      { "ChildTest", "" } });
+  ASSERT_EQ(0U, merged_nodes_count());
+  ASSERT_EQ(2U, approximately_merged_nodes_count());
+  // The children must still have the same parameters
+  AddFeature("Three", { {"ParentTest", "AmplifyFactor=3" },
+                        { "ChildTest", "AnalysisLength=256" } });
+  ASSERT_EQ(3U, approximately_merged_nodes_count());
+  ASSERT_GT(approximate_sharing_speedup(), 1.f);
+  // Too late to change the structure of the tree
+  AddEquivalence("ChildTest", "");
+  PrepareForExecution();
+  Save("/tmp/test_tree.bin");
+  auto loaded = Load("/tmp/test_tree.bin");
+  ASSERT_EQ(3U, loaded->approximately_merged_nodes_count());
+  ASSERT_EQ(allocated_size(), loaded->allocated_size());
+}
+
+TEST_F(TransformTreeTest, AddEquivalenceParameters) {
+  AddEquivalence("ParentTest", "AmplifyFactor=01");
+  AddFeature("One", { {"ParentTest", "" }, { "ChildTest", "" } });
+  // Both transforms must have the value of the class
+  AddFeature("Two", { {"ParentTest", "AmplifyFactor=2" },
+                      { "ChildTest", "" } });
+  ASSERT_EQ(0U, approximately_merged_nodes_count());
+  ASSERT_EQ(1.f, approximate_sharing_speedup());
+  PrepareForExecution();
+}
+
+TEST_F(TransformTreeTest, SaveLoadErrors) {
+  AddFeature("One", { {"ParentTest", "" }, { "ChildTest", "" } });
+  ASSERT_THROW(Save("/tmp/test_tree.bin"), TreeIsNotPreparedException);
+  {
+    std::ofstream file("/tmp/test_tree.bin");
+    file << "garbage";
+  }
+  ASSERT_THROW(Load("/tmp/test_tree.bin"), InvalidTreeFileException);
+  ASSERT_THROW(Load("/tmp/nonexistent_tree.bin"), InvalidTreeFileException);
+  PrepareForExecution();
+  Save("/tmp/test_tree.bin");
+  auto loaded = Load("/tmp/test_tree.bin");
+  ASSERT_EQ(allocated_size(), loaded->allocated_size());
+}
+
+TEST_F(TransformTreeTest, LoadImage) {
+  AddFeature("One", { {"ParentTest", "" }, { "ChildTest", "" } });
+  PrepareForExecution();
+  Save("/tmp/test_tree.bin");
+  std::ifstream file("/tmp/test_tree.bin", std::ios::in | std::ios::binary);
+  std::string contents((std::istreambuf_iterator<char>(file)),
+                       std::istreambuf_iterator<char>());
+  void* ptr;
+  ASSERT_EQ(0, posix_memalign(&ptr, PrecomputedState::kAlignment,
+                              contents.size() + 1));
+  auto image = std::shared_ptr<char>(static_cast<char*>(ptr), free);
+  memcpy(image.get(), contents.data(), contents.size());
+  ASSERT_THROW(Load("image", image.get() + 1, contents.size(), image),
+               InvalidTreeFileException);
+  auto loaded = Load("image", image.get(), contents.size(), image);
+  ASSERT_EQ(allocated_size(), loaded->allocated_size());
+}
+
+TEST_F(TransformTreeTest, MemoryGuards) {
+  AddFeature("One", { {"ParentTest", "" }, { "ChildTest", "" } });
+  set_memory_guards(true);
+  set_memory_protection_period(4);
+  PrepareForExecution();
+  set_memory_guards(false);
+  ASSERT_TRUE(memory_guards());
+  ASSERT_EQ(4U, memory_protection_period());
+  std::vector<int16_t> input(4096);
+  for (int i = 0; i < 8; i++) {
+    Execute(input.data());
+  }
+  Save("/tmp/test_tree.bin");
+  auto loaded = Load("/tmp/test_tree.bin");
+  ASSERT_TRUE(loaded->memory_guards());
+  ASSERT_EQ(allocated_size(), loaded->allocated_size());
+}
+
+TEST_F(TransformTreeTest, MemoryGuardsOverrun) {
+  AddFeature("One", { {"ParentTest", "" }, { "OverrunTest", "" } });
+  set_memory_guards(true);
+  set_memory_protection(false);
+  PrepareForExecution();
+  std::vector<int16_t> input(4096);
+  ASSERT_DEATH(Execute(input.data()), "OverrunTest wrote past");
+}
+
+TEST_F(TransformTreeTest, ExecuteDoesNotAllocate) {
+  AddFeature("One", { {"ParentTest", "" }, { "ChildTest", "" } });
+  AddFeature("Two", { {"ParentTest", "AmplifyFactor=2" },
+                      { "ChildTest", "" } });
+  set_memory_protection(false);
+  PrepareForExecution();
+  std::vector<int16_t> input(4096);
+  auto& results = Execute(input.data());
+  ASSERT_EQ(2U, results.size());
+  size_t allocations = allocations_count;
+  for (int i = 0; i < 4; i++) {
+    ASSERT_EQ(&results, &Execute(input.data()));
+  }
+  ASSERT_EQ(allocations, allocations_count);
+  auto context = CreateExecutionContext();
+  Execute(input.data(), context.get());
+  allocations = allocations_count;
+  ASSERT_EQ(2U, Execute(input.data(), context.get()).size());
+  ASSERT_EQ(allocations, allocations_count);
+}
+
+TEST_F(TransformTreeTest, IdentityView) {
+  AddFeature("One", { {"ParentTest", "" }, { "Identity", "" },
+                      { "InputTest", "" } });
+  AddFeature("Two", { {"ParentTest", "" }, { "Identity", "" },
+                      { "ChildTest", "" } });
+  PrepareForExecution();
+  std::vector<int16_t> input(4096);
+  Execute(input.data());
+  ASSERT_NE(nullptr, parent_output);
+  ASSERT_EQ(parent_output, child_input);
+  auto context = CreateExecutionContext();
+  Execute(input.data(), context.get());
+  ASSERT_EQ(parent_output, child_input);
+  // The leaf Identity keeps its own copy
+  AddFeature("Three", { {"ParentTest", "" }, { "Identity", "" } });
+  ASSERT_EQ(3U, Execute(input.data()).size());
+  ASSERT_EQ(parent_output, child_input);
+}
+
+TEST_F(TransformTreeTest, ThousandsOfFeatures) {
+  const int kCount = 2000;
+  for (int i = 0; i < kCount; i++) {
+    AddFeature("F" + std::to_string(i),
+               { {"ParentTest", "" },
+                 { "ChildTest", "AnalysisLength=" + std::to_string(i + 1) } });
+  }
+  ASSERT_EQ(kCount - 1U, merged_nodes_count());
+  AddFeature("Last", { {"ParentTest", "" } });
+  RemoveFeature("F1");
+  ASSERT_EQ(static_cast<size_t>(kCount), FeatureNames().size());
+  ASSERT_EQ("F0", FeatureNames()[0]);
+  ASSERT_EQ("F2", FeatureNames()[1]);
+  ASSERT_EQ("Last", FeatureNames().back());
+  PrepareForExecution();
+  std::vector<int16_t> input(4096);
+  auto& results = Execute(input.data());
+  ASSERT_EQ(static_cast<size_t>(kCount), results.size());
+  auto& indexed = IndexedResults();
+  ASSERT_EQ(results.size(), indexed.size());
+  for (size_t i = 0; i < indexed.size(); i++) {
+    ASSERT_EQ(results.find(FeatureNames()[i])->second, indexed[i]);
+  }
+  ASSERT_NE(indexed[0], indexed.back());
+  auto context = CreateExecutionContext();
+  auto& context_results = Execute(input.data(), context.get());
+  ASSERT_EQ(context_results.find("Last")->second,
+            IndexedResults(context.get()).back());
+}
+
+TEST_F(TransformTreeTest, InPlace) {
+  AddFeature("One", { {"ParentTest", "" }, { "InPlaceTest", "" },
+                      { "InputTest", "" } });
+  PrepareForExecution();
+  std::vector<int16_t> input(4096);
+  Execute(input.data());
+  ASSERT_NE(nullptr, parent_output);
+  ASSERT_EQ(parent_output, in_place_output);
+  ASSERT_EQ(parent_output, child_input);
+  // The new sibling reads the parent before it is overwritten
+  AddFeature("Two", { {"ParentTest", "" }, { "InputTest", "" } });
+  ASSERT_EQ(2U, Execute(input.data()).size());
+}
+
+TEST_F(TransformTreeTest, NotInPlaceWithSiblings) {
+  AddFeature("One", { {"ParentTest", "" }, { "InPlaceTest", "" } });
+  AddFeature("Two", { {"ParentTest", "" }, { "ChildTest", "" } });
+  PrepareForExecution();
+  std::vector<int16_t> input(4096);
+  Execute(input.data());
+  ASSERT_NE(nullptr, in_place_output);
+  ASSERT_NE(parent_output, in_place_output);
+}
+
+TEST_F(TransformTreeTest, ExecuteFeaturesSubset) {
+  AddFeature("One", { {"ParentTest", "AmplifyFactor=2" },
+                      { "InputTest", "" } });
+  AddFeature("Two", { {"ParentTest", "" }, { "ChildTest", "" } });
+  PrepareForExecution();
+  std::vector<int16_t> input(4096);
+  child_input = nullptr;
+  ASSERT_EQ(2U, Execute(input.data(), { "Two" }).size());
+  ASSERT_EQ(nullptr, child_input);
+  Execute(input.data(), { "One" });
+  ASSERT_NE(nullptr, child_input);
+  ASSERT_THROW(Execute(input.data(), { "Three" }), FeatureNotFoundException);
+  auto context = CreateExecutionContext();
+  child_input = nullptr;
+  Execute(input.data(), { "Two" }, context.get());
+  ASSERT_EQ(nullptr, child_input);
+  Execute(input.data(), context.get());
+  ASSERT_NE(nullptr, child_input);
+}
+
+TEST_F(TransformTreeTest, Cancellation) {
+  AddFeature("Two", { {"ParentTest", "" }, { "ChildTest", "" } });
+  PrepareForExecution();
+  std::vector<int16_t> input(4096);
+  CancellationSource source;
+  {
+    CancellationToken token(&source);
+    source.Cancel();
+    child_input = nullptr;
+    ASSERT_THROW(Execute(input.data()), ExecutionCancelledException);
+    ASSERT_EQ(nullptr, child_input);
+    auto context = CreateExecutionContext();
+    ASSERT_THROW(Execute(input.data(), context.get()),
+                 ExecutionCancelledException);
+    ASSERT_EQ(nullptr, child_input);
+  }
+  // The executions which start after Cancel() are not affected
+  CancellationToken token(&source);
+  Execute(input.data());
+  ASSERT_NE(nullptr, child_input);
+}
+
+TEST_F(TransformTreeTest, SelectFeatures) {
+  AddFeature("One", { {"ParentTest", "AmplifyFactor=2" },
+                      { "InputTest", "" } });
+  AddFeature("Two", { {"ParentTest", "" }, { "ChildTest", "" } });
+  set_profiling_level(ProfilingLevel::kCoarse);
+  PrepareForExecution();
+  std::vector<int16_t> input(4096);
+  Execute(input.data());
+  std::vector<std::string> skipped;
+  auto selected = SelectFeatures(
+      { "Two", "One" }, std::chrono::hours(1), &skipped);
+  ASSERT_EQ(2U, selected.size());
+  ASSERT_TRUE(skipped.empty());
+  // The first feature is picked regardless of the budget
+  selected = SelectFeatures(
+      { "Two", "One" }, std::chrono::hours(0), &skipped);
+  ASSERT_EQ(std::vector<std::string>({ "Two" }), selected);
+  ASSERT_EQ(std::vector<std::string>({ "One" }), skipped);
+  ASSERT_THROW(SelectFeatures({ "Three" }, std::chrono::hours(1), nullptr),
+               FeatureNotFoundException);
+}
+
+TEST_F(TransformTreeTest, AdaptiveParallelism) {
+  AddFeature("One", { {"ParentTest", "" }, { "ParallelTest", "" } });
+  AddFeature("Two", { {"ParentTest", "" },
+                      { "ParallelTest", "Cost=1000000" } });
+  set_profiling_level(ProfilingLevel::kOff);
+  PrepareForExecution();
+  std::vector<int16_t> input(4096);
+  Execute(input.data());
+  // Estimated by the buffers sizes
+  ASSERT_TRUE(serial_runs[0]);
+  ASSERT_FALSE(serial_runs[1]);
+  // Both nodes take no time
+  set_profiling_level(ProfilingLevel::kCoarse);
+  Execute(input.data());
+  Execute(input.data());
+  ASSERT_TRUE(serial_runs[0]);
+  ASSERT_TRUE(serial_runs[1]);
+}
+
+TEST_F(TransformTreeTest, ForcedPlacement) {
+  AddFeature("One", { {"ParentTest", "" },
+                      { "ParallelTest", "placement=parallel" } });
+  AddFeature("Two", { {"ParentTest", "" },
+                      { "ParallelTest", "Cost=1000000,placement=serial" } });
+  set_profiling_level(ProfilingLevel::kCoarse);
+  PrepareForExecution();
+  std::vector<int16_t> input(4096);
+  for (int i = 0; i < 3; i++) {
+    Execute(input.data());
+    ASSERT_FALSE(serial_runs[0]);
+    ASSERT_TRUE(serial_runs[1]);
+  }
+  auto report = PlacementsReport();
+  ASSERT_EQ(1, std::count_if(report.begin(), report.end(), [](
+      const std::pair<std::string, Placement>& p) {
+    return p.second == Placement::kParallel;
+  }));
+}
+
+TEST_F(TransformTreeTest, WarmUp) {
+  AddFeature("One", { {"ParentTest", "" }, { "ChildTest", "" } });
+  set_warm_up(true);
+  child_input = nullptr;
+  PrepareForExecution();
+  // The warm-up executed the nodes and left no counters
+  ASSERT_NE(nullptr, child_input);
+  for (auto& counters : NodeCountersReport()) {
+    ASSERT_EQ(0U, counters.second.Runs) << counters.first;
+  }
+  std::vector<int16_t> input(4096);
+  Execute(input.data());
+}
+
+TEST_F(TransformTreeTest, MemoryBudget) {
+  AddFeature("One", { {"ParentTest", "" }, { "ChildTest", "" } });
+  set_memory_budget(1);
+  ASSERT_THROW(PrepareForExecution(), MemoryBudgetExceededException);
+}
+
+TEST_F(TransformTreeTest, Capture) {
+  AddFeature("One", { {"ParentTest", "" }, { "ChildTest", "" } });
+  AddFeature("Two", { {"ParentTest", "" }, { "InputTest", "" } });
+  PrepareForExecution();
+  ASSERT_THROW(StartCapture("/tmp/sfe_tree_capture.bin", { "Nonexistent" }),
+               TransformNotRegisteredException);
+  StartCapture("/tmp/sfe_tree_capture.bin", { "ChildTest" });
+  ASSERT_NE(nullptr, capture());
+  std::vector<int16_t> input(4096);
+  Execute(input.data());
+  auto context = CreateExecutionContext();
+  Execute(input.data(), context.get());
+  ASSERT_LE(2U, capture()->captured_records());
+  ASSERT_TRUE(StopCapture());
+  ASSERT_EQ(nullptr, capture());
+  std::ifstream file("/tmp/sfe_tree_capture.bin", std::ios::binary);
+  std::string contents((std::istreambuf_iterator<char>(file)),
+                       std::istreambuf_iterator<char>());
+  ASSERT_EQ(0, contents.compare(0, 8, BufferCapture::kMagic));
+  ASSERT_NE(std::string::npos, contents.find("ChildTest"));
+  ASSERT_EQ(std::string::npos, contents.find("InputTest"));
+}
+
+TEST_F(TransformTreeTest, ConstantInputShortcut) {
+  AddFeature("One", { {"ParentTest", "" }, { "ChildTest", "" } });
+  AddFeature("Two", { {"ParentTest", "" }, { "InputTest", "" } });
+  set_constant_input_shortcut(true);
+  PrepareForExecution();
+  std::vector<int16_t> input(4096);
+  Execute(input.data());
+  ASSERT_EQ(0U, constant_input_hits());
+  Execute(input.data());
+  ASSERT_EQ(1U, constant_input_hits());
+  auto context = CreateExecutionContext();
+  Execute(input.data(), context.get());
+  ASSERT_EQ(2U, constant_input_hits());
+  input[100] = 1;
+  Execute(input.data());
+  ASSERT_EQ(2U, constant_input_hits());
+  set_constant_input_shortcut(false);
+  std::fill(input.begin(), input.end(), 0);
+  Execute(input.data());
+  ASSERT_EQ(2U, constant_input_hits());
+}
+
 TEST_F(TransformTreeTest, Dump) {
   AddFeature("One", { {"ParentTest", "AmplifyFactor=1" },
                     { "ChildTest", "" } });
@@ -157,4 +699,694 @@ TEST_F(TransformTreeTest, Dump) {
   Dump("/tmp/ttdump.dot");
 }
 
+TEST_F(TransformTreeTest, Explain) {
+  AddFeature("One", { {"ParentTest", "" }, { "InPlaceTest", "" } });
+  AddFeature("Two", { {"ParentTest", "" }, { "ParallelTest", "" } });
+  ASSERT_THROW(Explain(), TreeIsNotPreparedException);
+  PrepareForExecution();
+  std::istringstream plan(Explain());
+  std::string line;
+  std::vector<std::string> rows;
+  while (std::getline(plan, line)) {
+    if (line[0] != '#') {
+      rows.push_back(line);
+    }
+  }
+  // The header and ParentTest, InPlaceTest and ParallelTest
+  ASSERT_EQ(4U, rows.size());
+  EXPECT_EQ(0U, rows[0].find("order\tid\tnode\tbuffers\tstorage"));
+  EXPECT_EQ(0U, rows[1].find("0\t"));
+  EXPECT_NE(std::string::npos, rows[1].find("ParentTest"));
+  int found = 0;
+  for (size_t i = 2; i < rows.size(); i++) {
+    if (rows[i].find("InPlaceTest") != std::string::npos) {
+      // Has siblings, so it can not overwrite the parent
+      EXPECT_NE(std::string::npos, rows[i].find("\town\t"));
+      found++;
+    } else if (rows[i].find("ParallelTest") != std::string::npos) {
+      EXPECT_TRUE(rows[i].find("\tserial\t") != std::string::npos ||
+                  rows[i].find("\tparallel\t") != std::string::npos);
+      found++;
+    }
+  }
+  EXPECT_EQ(2, found);
+  Dump("/tmp/ttdump_annotated.dot", true);
+}
+
+static void AddMFCCAndCentroid(TransformTree* tt) {
+  tt->AddFeature("MFCC", { { "Window", "length=512" }, { "RDFT", "" },
+      { "SpectralEnergy", "" }, { "FilterBank", "squared=true" },
+      { "Log", "" }, { "Square", "" }, { "DCT", "" },
+      { "Selector", "length=16" } });
+  tt->AddFeature("Centroid", { { "Window", "length=512" }, { "RDFT", "" },
+      { "ComplexMagnitude", "" }, { "Centroid", "" } });
+}
+
+TEST(TransformTree, ParallelExecution) {
+  TransformTree sequential( { 48000, 16000 } );  // NOLINT(*)
+  AddMFCCAndCentroid(&sequential);
+  TransformTree parallel( { 48000, 16000 } );  // NOLINT(*)
+  parallel.set_validate_after_each_transform(true);
+  parallel.set_parallel_execution(true);
+  ASSERT_TRUE(parallel.parallel_execution());
+  AddMFCCAndCentroid(&parallel);
+  int16_t* buffers = new int16_t[48000];
+  memcpy(buffers, data, sizeof(data));
+  sequential.PrepareForExecution();
+  parallel.PrepareForExecution();
+  auto expected = sequential.Execute(buffers);
+  auto res = parallel.Execute(buffers);
+  delete[] buffers;
+  ASSERT_EQ(2U, res.size());
+  for (auto& feature : expected) {
+    auto& actual = res[feature.first];
+    ASSERT_EQ(feature.second->Count(), actual->Count());
+    size_t size = feature.second->Format()->UnalignedSizeInBytes();
+    for (size_t i = 0; i < actual->Count(); i++) {
+      ASSERT_EQ(0, memcmp((*feature.second)[i], (*actual)[i], size))
+          << feature.first << " differs at " << i;
+    }
+  }
+  parallel.Dump("/tmp/mfcc_parallel.dot");
+}
+
+TEST(TransformTree, ExportTasks) {
+  TransformTree sequential( { 48000, 16000 } );  // NOLINT(*)
+  AddMFCCAndCentroid(&sequential);
+  TransformTree tt( { 48000, 16000 } );  // NOLINT(*)
+  AddMFCCAndCentroid(&tt);
+  sequential.PrepareForExecution();
+  tt.PrepareForExecution();
+  auto context = tt.CreateExecutionContext();
+  ASSERT_THROW(tt.ExportTasks(context.get()),
+               ParallelExecutionRequiredException);
+  TransformTree parallel( { 48000, 16000 } );  // NOLINT(*)
+  parallel.set_parallel_execution(true);
+  AddMFCCAndCentroid(&parallel);
+  parallel.PrepareForExecution();
+  context = parallel.CreateExecutionContext();
+  auto tasks = parallel.ExportTasks(context.get());
+  ASSERT_FALSE(tasks.empty());
+  bool ranged = false;
+  for (size_t i = 0; i < tasks.size(); i++) {
+    for (auto dep : tasks[i].Dependencies) {
+      ASSERT_LT(dep, i) << tasks[i].Name;
+    }
+    ranged |= tasks[i].Ranges > 1;
+  }
+  EXPECT_TRUE(ranged);
+  int16_t* buffers = new int16_t[48000];
+  memcpy(buffers, data, sizeof(data));
+  auto expected = sequential.Execute(buffers);
+  auto& res = parallel.StartTasks(buffers, context.get());
+  // Run in the topological order, splitting the ranges in halves
+  for (auto& task : tasks) {
+    task.Run(0, task.Ranges / 2 + 1);
+    if (task.Ranges / 2 + 1 < task.Ranges) {
+      task.Run(task.Ranges / 2 + 1, task.Ranges);
+    }
+  }
+  delete[] buffers;
+  ASSERT_EQ(2U, res.size());
+  for (auto& feature : expected) {
+    auto& actual = res.find(feature.first)->second;
+    ASSERT_EQ(feature.second->Count(), actual->Count());
+    size_t size = feature.second->Format()->UnalignedSizeInBytes();
+    for (size_t i = 0; i < actual->Count(); i++) {
+      ASSERT_EQ(0, memcmp((*feature.second)[i], (*actual)[i], size))
+          << feature.first << " differs at " << i;
+    }
+  }
+}
+
+TEST(TransformTree, ExecutionContexts) {
+  TransformTree tt( { 48000, 16000 } );  // NOLINT(*)
+  AddMFCCAndCentroid(&tt);
+  tt.PrepareForExecution();
+  int16_t* buffers = new int16_t[48000];
+  memcpy(buffers, data, sizeof(data));
+  auto expected = tt.Execute(buffers);
+  const int kContexts = 4;
+  std::vector<std::shared_ptr<TransformTree::ExecutionContext>> contexts;
+  for (int i = 0; i < kContexts; i++) {
+    contexts.push_back(tt.CreateExecutionContext());
+  }
+  std::vector<std::unordered_map<std::string,
+                                 std::shared_ptr<Buffers>>> res(kContexts);
+  #pragma omp parallel for num_threads(kContexts)
+  for (int i = 0; i < kContexts; i++) {
+    res[i] = tt.Execute(buffers, contexts[i].get());
+  }
+  delete[] buffers;
+  for (int c = 0; c < kContexts; c++) {
+    ASSERT_EQ(2U, res[c].size());
+    for (auto& feature : expected) {
+      auto& actual = res[c][feature.first];
+      ASSERT_NE((*feature.second)[0], (*actual)[0]);
+      ASSERT_EQ(feature.second->Count(), actual->Count());
+      size_t size = feature.second->Format()->UnalignedSizeInBytes();
+      for (size_t i = 0; i < actual->Count(); i++) {
+        ASSERT_EQ(0, memcmp((*feature.second)[i], (*actual)[i], size))
+            << feature.first << " differs at " << i << " in context " << c;
+      }
+    }
+    auto report = tt.ExecutionTimeReport(*contexts[c]);
+    ASSERT_GT(report["All"], 0.f);
+  }
+}
+
+TEST(TransformTree, CacheOptimization) {
+  auto cache_size = get_cpu_cache_size();
+  // Slice every chain
+  set_cpu_cache_size(32 * 1024);
+  for (auto strategy : { AllocationStrategy::kSlidingBlocks,
+                         AllocationStrategy::kIntervalPacking }) {
+    TransformTree reference( { 48000, 16000 } );  // NOLINT(*)
+    reference.set_cache_optimization(false);
+    reference.set_allocation_strategy(strategy);
+    AddMFCCAndCentroid(&reference);
+    TransformTree tt( { 48000, 16000 } );  // NOLINT(*)
+    tt.set_allocation_strategy(strategy);
+    ASSERT_EQ(strategy, tt.allocation_strategy());
+    AddMFCCAndCentroid(&tt);
+    reference.PrepareForExecution();
+    tt.PrepareForExecution();
+    int16_t* buffers = new int16_t[48000];
+    memcpy(buffers, data, sizeof(data));
+    auto expected = reference.Execute(buffers);
+    auto res = tt.Execute(buffers);
+    delete[] buffers;
+    ASSERT_EQ(2U, res.size());
+    for (auto& feature : expected) {
+      auto& actual = res[feature.first];
+      ASSERT_EQ(feature.second->Count(), actual->Count());
+      size_t size = feature.second->Format()->UnalignedSizeInBytes();
+      for (size_t i = 0; i < actual->Count(); i++) {
+        ASSERT_EQ(0, memcmp((*feature.second)[i], (*actual)[i], size))
+            << feature.first << " differs at " << i;
+      }
+    }
+  }
+  set_cpu_cache_size(cache_size);
+}
+
+TEST(TransformTree, BatchCacheOptimization) {
+  auto cache_size = get_cpu_cache_size();
+  set_cpu_cache_size(32 * 1024);
+  TransformTree reference( { 12000, 16000 } );  // NOLINT(*)
+  reference.set_cache_optimization(false);
+  reference.set_batch_size(4);
+  AddMFCCAndCentroid(&reference);
+  TransformTree tt( { 12000, 16000 } );  // NOLINT(*)
+  tt.set_batch_size(4);
+  AddMFCCAndCentroid(&tt);
+  reference.PrepareForExecution();
+  tt.PrepareForExecution();
+  set_cpu_cache_size(cache_size);
+  // The windows of each signal in the batch are sliced together with it
+  std::istringstream plan(tt.Explain());
+  std::string line;
+  bool window_sliced = false;
+  while (std::getline(plan, line)) {
+    if (line[0] == '#' || line.find("Window") == std::string::npos) {
+      continue;
+    }
+    std::vector<std::string> columns;
+    std::istringstream row(line);
+    for (std::string column; std::getline(row, column, '\t');) {
+      columns.push_back(column);
+    }
+    ASSERT_LT(11U, columns.size());
+    window_sliced |= columns[11] != "-";
+  }
+  EXPECT_TRUE(window_sliced);
+  int16_t* buffers = new int16_t[48000];
+  memcpy(buffers, data, sizeof(data));
+  auto expected = reference.Execute(buffers);
+  auto res = tt.Execute(buffers);
+  delete[] buffers;
+  ASSERT_EQ(2U, res.size());
+  for (auto& feature : expected) {
+    auto& actual = res[feature.first];
+    ASSERT_EQ(feature.second->Count(), actual->Count());
+    size_t size = feature.second->Format()->UnalignedSizeInBytes();
+    for (size_t i = 0; i < actual->Count(); i++) {
+      ASSERT_EQ(0, memcmp((*feature.second)[i], (*actual)[i], size))
+          << feature.first << " differs at " << i;
+    }
+  }
+}
+
+TEST(TransformTree, CacheAutotuning) {
+  TransformTree reference( { 48000, 16000 } );  // NOLINT(*)
+  reference.set_cache_optimization(false);
+  AddMFCCAndCentroid(&reference);
+  TransformTree tt( { 48000, 16000 } );  // NOLINT(*)
+  ASSERT_FALSE(tt.cache_autotuning());
+  tt.set_cache_autotuning(true);
+  ASSERT_TRUE(tt.cache_autotuning());
+  AddMFCCAndCentroid(&tt);
+  reference.PrepareForExecution();
+  tt.PrepareForExecution();
+  int16_t* buffers = new int16_t[48000];
+  memcpy(buffers, data, sizeof(data));
+  auto expected = reference.Execute(buffers);
+  auto res = tt.Execute(buffers);
+  delete[] buffers;
+  ASSERT_EQ(2U, res.size());
+  for (auto& feature : expected) {
+    auto& actual = res[feature.first];
+    ASSERT_EQ(feature.second->Count(), actual->Count());
+    size_t size = feature.second->Format()->UnalignedSizeInBytes();
+    for (size_t i = 0; i < actual->Count(); i++) {
+      ASSERT_EQ(0, memcmp((*feature.second)[i], (*actual)[i], size))
+          << feature.first << " differs at " << i;
+    }
+  }
+}
+
+TEST(TransformTree, SiblingReductionsCacheAutotuning) {
+  auto add_reductions = [](TransformTree* tt) {
+    for (auto reduction : { "Energy", "ZeroCrossings", "Mean" }) {
+      tt->AddFeature(reduction, { { "Window", "length=512" }, { "RDFT", "" },
+          { "ComplexMagnitude", "" }, { reduction, "" } });
+    }
+  };
+  TransformTree reference( { 48000, 16000 } );  // NOLINT(*)
+  reference.set_cache_optimization(false);
+  add_reductions(&reference);
+  TransformTree tt( { 48000, 16000 } );  // NOLINT(*)
+  tt.set_cache_autotuning(true);
+  add_reductions(&tt);
+  reference.PrepareForExecution();
+  tt.PrepareForExecution();
+  int16_t* buffers = new int16_t[48000];
+  memcpy(buffers, data, sizeof(data));
+  auto expected = reference.Execute(buffers);
+  auto res = tt.Execute(buffers);
+  delete[] buffers;
+  ASSERT_EQ(3U, res.size());
+  for (auto& feature : expected) {
+    auto& actual = res[feature.first];
+    ASSERT_EQ(feature.second->Count(), actual->Count());
+    size_t size = feature.second->Format()->UnalignedSizeInBytes();
+    for (size_t i = 0; i < actual->Count(); i++) {
+      ASSERT_EQ(0, memcmp((*feature.second)[i], (*actual)[i], size))
+          << feature.first << " differs at " << i;
+    }
+  }
+}
+
+TEST(TransformTree, ProfilingLevel) {
+  int16_t* buffers = new int16_t[48000];
+  memcpy(buffers, data, sizeof(data));
+  for (auto level : { ProfilingLevel::kOff, ProfilingLevel::kCoarse,
+                      ProfilingLevel::kFull }) {
+    TransformTree tt( { 48000, 16000 } );  // NOLINT(*)
+    ASSERT_EQ(ProfilingLevel::kCoarse, tt.profiling_level());
+    tt.set_profiling_level(level);
+    ASSERT_EQ(level, tt.profiling_level());
+    AddMFCCAndCentroid(&tt);
+    tt.PrepareForExecution();
+    ASSERT_TRUE(tt.ExecutionTimeReport().empty());
+    tt.Execute(buffers);
+    auto report = tt.ExecutionTimeReport();
+    ASSERT_GT(report["All"], 0.f);
+    auto counters = tt.NodeCountersReport();
+    ASSERT_FALSE(counters.empty());
+    if (level == ProfilingLevel::kOff) {
+      ASSERT_EQ(2U, report.size());
+      for (auto& node : counters) {
+        ASSERT_EQ(0U, node.second.Runs);
+      }
+      continue;
+    }
+    ASSERT_GT(report.size(), 2U);
+    ASSERT_GT(report["Window"], 0.f);
+    ASSERT_LT(report["Window"], 1.f);
+    for (auto& node : counters) {
+      // A sliced node runs once per slice
+      ASSERT_GE(node.second.Runs, 1U) << node.first;
+      ASSERT_GT(node.second.Ticks, 0U) << node.first;
+      if (level == ProfilingLevel::kCoarse) {
+        ASSERT_EQ(0U, node.second.Cycles) << node.first;
+      }
+    }
+    auto context = tt.CreateExecutionContext();
+    tt.Execute(buffers, context.get());
+    for (auto& node : tt.NodeCountersReport(*context)) {
+      ASSERT_GE(node.second.Runs, 1U) << node.first;
+    }
+  }
+  delete[] buffers;
+}
+
+TEST(TransformTree, ReleaseMemory) {
+  TransformTree tt( { 48000, 16000 } );  // NOLINT(*)
+  AddMFCCAndCentroid(&tt);
+  tt.PrepareForExecution();
+  int16_t* buffers = new int16_t[48000];
+  memcpy(buffers, data, sizeof(data));
+  std::unordered_map<std::string, std::vector<char>> expected;
+  for (auto& feature : tt.Execute(buffers)) {
+    auto& copy = expected[feature.first];
+    size_t size = feature.second->Format()->UnalignedSizeInBytes();
+    for (size_t i = 0; i < feature.second->Count(); i++) {
+      auto ptr = reinterpret_cast<const char*>((*feature.second)[i]);
+      copy.insert(copy.end(), ptr, ptr + size);
+    }
+  }
+  auto check = [&](
+      const std::unordered_map<std::string, std::shared_ptr<Buffers>>& res) {
+    ASSERT_EQ(expected.size(), res.size());
+    for (auto& feature : res) {
+      auto& copy = expected[feature.first];
+      size_t size = feature.second->Format()->UnalignedSizeInBytes();
+      ASSERT_EQ(copy.size(), size * feature.second->Count());
+      for (size_t i = 0; i < feature.second->Count(); i++) {
+        ASSERT_EQ(0, memcmp(copy.data() + i * size, (*feature.second)[i],
+                            size)) << feature.first << " differs at " << i;
+      }
+    }
+  };
+  tt.ReleaseMemory();
+  check(tt.Execute(buffers));
+  auto context = tt.CreateExecutionContext();
+  tt.ReleaseMemory();
+  check(tt.Execute(buffers, context.get()));
+  context->ReleaseMemory();
+  check(tt.Execute(buffers, context.get()));
+  check(tt.Execute(buffers));
+  delete[] buffers;
+}
+
+TEST(TransformTree, FuseTransforms) {
+  // The results reference the memory of the trees
+  std::unique_ptr<TransformTree> trees[2];
+  std::unordered_map<std::string, std::shared_ptr<Buffers>> results[2];
+  int16_t* buffers = new int16_t[48000];
+  memcpy(buffers, data, sizeof(data));
+  for (int fuse = 0; fuse < 2; fuse++) {
+    trees[fuse].reset(new TransformTree({ 48000, 16000 }));  // NOLINT(*)
+    auto& tt = *trees[fuse];
+    tt.set_fuse_transforms(fuse);
+    tt.AddFeature("MFCC", { { "Window", "length=512" }, { "RDFT", "" },
+        { "SpectralEnergy", "" }, { "FilterBank", "squared=true" },
+        { "Log", "" }, { "Square", "" }, { "DCT", "" },
+        { "Selector", "length=16" } });
+    tt.AddFeature("Hanning", { { "Window", "length=512,type=rectangular" },
+        { "WindowFunction", "type=hanning" }, { "RDFT", "" },
+        { "SpectralEnergy", "" } });
+    // RDFT is shared with ComplexMagnitude, so it must stay
+    tt.AddFeature("Spectrum", { { "Window", "length=256" }, { "RDFT", "" },
+        { "SpectralEnergy", "" } });
+    tt.AddFeature("Magnitude", { { "Window", "length=256" }, { "RDFT", "" },
+        { "ComplexMagnitude", "" } });
+    tt.PrepareForExecution();
+    results[fuse] = tt.Execute(buffers);
+    auto report = tt.ExecutionTimeReport();
+    ASSERT_EQ(fuse == 1, report.find("PowerSpectrum") != report.end());
+    ASSERT_NE(report.end(), report.find("RDFT"));
+    ASSERT_EQ(fuse == 0, report.find("WindowFunction") != report.end());
+    ASSERT_EQ(fuse == 1, report.find("ElementwiseChain") != report.end());
+    ASSERT_EQ(fuse == 0, report.find("Log") != report.end());
+  }
+  delete[] buffers;
+  ASSERT_EQ(4U, results[1].size());
+  for (auto& feature : results[0]) {
+    auto& actual = results[1][feature.first];
+    ASSERT_EQ(feature.second->Count(), actual->Count());
+    size_t size = feature.second->Format()->UnalignedSizeInBytes() /
+        sizeof(float);
+    ASSERT_EQ(size, actual->Format()->UnalignedSizeInBytes() / sizeof(float));
+    for (size_t i = 0; i < actual->Count(); i++) {
+      auto expected_data = reinterpret_cast<const float*>(
+          (*feature.second)[i]);
+      auto actual_data = reinterpret_cast<const float*>((*actual)[i]);
+      for (size_t j = 0; j < size; j++) {
+        ASSERT_NEAR(expected_data[j], actual_data[j],
+                    std::abs(expected_data[j]) * 1e-4f + 1e-4f)
+            << feature.first << " differs at " << i << ", " << j;
+      }
+    }
+  }
+}
+
+TEST(TransformTree, Accuracy) {
+  int16_t* buffers = new int16_t[48000];
+  memcpy(buffers, data, sizeof(data));
+  TransformTree exact( { 48000, 16000 } );  // NOLINT(*)
+  AddMFCCAndCentroid(&exact);
+  exact.PrepareForExecution();
+  auto expected = exact.Execute(buffers);
+  for (auto accuracy : { Accuracy::kBalanced, Accuracy::kFast }) {
+    TransformTree tt( { 48000, 16000 } );  // NOLINT(*)
+    tt.set_accuracy(accuracy);
+    AddMFCCAndCentroid(&tt);
+    EXPECT_EQ(accuracy, tt.accuracy());
+    tt.set_accuracy(Accuracy::kExact);
+    EXPECT_EQ(accuracy, tt.accuracy());
+    tt.PrepareForExecution();
+    auto res = tt.Execute(buffers);
+    auto& mfcc = *expected["MFCC"];
+    auto& approx = *res["MFCC"];
+    ASSERT_EQ(mfcc.Count(), approx.Count());
+    size_t size = mfcc.Format()->UnalignedSizeInBytes() / sizeof(float);
+    for (size_t i = 0; i < mfcc.Count(); i++) {
+      auto vexact = reinterpret_cast<const float*>(mfcc[i]);
+      auto vapprox = reinterpret_cast<const float*>(approx[i]);
+      for (size_t j = 0; j < size; j++) {
+        ASSERT_NEAR(vexact[j], vapprox[j], 1e-3f * (1 + fabsf(vexact[j])))
+            << i << " " << j;
+      }
+    }
+  }
+  // The explicit parameters take precedence
+  TransformTree tt( { 48000, 16000 } );  // NOLINT(*)
+  tt.set_accuracy(Accuracy::kFast);
+  tt.AddFeature("MFCC", { { "Window", "length=512" }, { "RDFT", "" },
+      { "SpectralEnergy", "" }, { "FilterBank", "squared=true" },
+      { "Log", "precision=accurate" }, { "Square", "" }, { "DCT", "" },
+      { "Selector", "length=16" } });
+  tt.PrepareForExecution();
+  auto res = tt.Execute(buffers);
+  delete[] buffers;
+  auto& mfcc = *expected["MFCC"];
+  size_t size = mfcc.Format()->UnalignedSizeInBytes();
+  for (size_t i = 0; i < mfcc.Count(); i++) {
+    ASSERT_EQ(0, memcmp(mfcc[i], (*res["MFCC"])[i], size)) << i;
+  }
+}
+
+TEST(TransformTree, SetTransformParameter) {
+  std::unique_ptr<TransformTree> trees[2];
+  std::unordered_map<std::string, std::shared_ptr<Buffers>> results[2];
+  int16_t* buffers = new int16_t[48000];
+  memcpy(buffers, data, sizeof(data));
+  for (int updated = 0; updated < 2; updated++) {
+    trees[updated].reset(new TransformTree({ 48000, 16000 }));  // NOLINT(*)
+    auto& tt = *trees[updated];
+    tt.AddFeature("MFCC", { { "Preemphasis",
+                              updated? "value=0.2" : "value=0.5" },
+                            { "Window", "length=512" }, { "RDFT", "" },
+                            { "SpectralEnergy", "" },
+                            { "FilterBank", "" }, { "Log", "" },
+                            { "DCT", "" } });
+    tt.PrepareForExecution();
+    if (updated) {
+      size_t allocated = tt.allocated_size();
+      tt.SetTransformParameter("MFCC", "Preemphasis", "value", "0.5");
+      ASSERT_THROW(tt.SetTransformParameter("MFCC", "Window", "length",
+                                            "256"),
+                   FormatChangingParameterException);
+      ASSERT_THROW(tt.SetTransformParameter("MFCC", "Energy", "", ""),
+                   TransformNotInFeatureException);
+      ASSERT_EQ(allocated, tt.allocated_size());
+    }
+    results[updated] = tt.Execute(buffers);
+  }
+  delete[] buffers;
+  auto& expected = results[0]["MFCC"];
+  auto& actual = results[1]["MFCC"];
+  ASSERT_EQ(expected->Count(), actual->Count());
+  size_t size = expected->Format()->SizeInBytes();
+  for (size_t i = 0; i < actual->Count(); i++) {
+    ASSERT_EQ(0, memcmp((*expected)[i], (*actual)[i], size)) << i;
+  }
+}
+
+TEST(TransformTree, MergeView) {
+  TransformTree tt({ 48000, 16000 });  // NOLINT(*)
+  tt.AddFeature("Energy", { { "Window", "length=512" }, { "Energy", "" } });
+  tt.AddFeature("Merged", { { "Window", "length=512" }, { "Energy", "" },
+      { "Merge", "" } });
+  tt.PrepareForExecution();
+  int16_t* buffers = new int16_t[48000];
+  memcpy(buffers, data, sizeof(data));
+  auto results = tt.Execute(buffers);
+  delete[] buffers;
+  auto& energy = results["Energy"];
+  auto& merged = results["Merged"];
+  ASSERT_EQ(1U, merged->Count());
+  // Energy writes right into the array
+  ASSERT_EQ(sizeof(float), energy->Stride());
+  ASSERT_EQ((*energy)[0], (*merged)[0]);
+  auto array = reinterpret_cast<const float*>((*merged)[0]);
+  for (size_t i = 0; i < energy->Count(); i++) {
+    ASSERT_EQ(*reinterpret_cast<const float*>((*energy)[i]), array[i]);
+  }
+}
+
+TEST(TransformTree, UsedSpectralBins) {
+  const std::vector<std::pair<std::string, std::string>> mfcc {
+      { "Window", "length=512" }, { "RDFT", "" }, { "SpectralEnergy", "" },
+      { "FilterBank", "frequency_max=4000" }, { "Log", "" }, { "DCT", "" } };
+  const std::vector<std::pair<std::string, std::string>> shc {
+      { "Window", "length=512" }, { "RDFT", "" }, { "ComplexMagnitude", "" },
+      { "SHC", "" } };
+  // The features which end at the spectra use all the bins
+  const std::vector<std::pair<std::string, std::string>> energies(
+      mfcc.begin(), mfcc.begin() + 3);
+  const std::vector<std::pair<std::string, std::string>> magnitudes(
+      shc.begin(), shc.begin() + 3);
+  int16_t* buffers = new int16_t[48000];
+  memcpy(buffers, data, sizeof(data));
+  auto compare = [](const Buffers& expected, const Buffers& actual,
+                    const std::string& name) {
+    ASSERT_EQ(expected.Count(), actual.Count()) << name;
+    size_t size = expected.Format()->UnalignedSizeInBytes();
+    for (size_t i = 0; i < actual.Count(); i++) {
+      ASSERT_EQ(0, memcmp(expected[i], actual[i], size))
+          << name << " differs at " << i;
+    }
+  };
+  for (int fuse = 0; fuse < 2; fuse++) {
+    TransformTree reference({ 48000, 16000 });  // NOLINT(*)
+    reference.set_fuse_transforms(fuse);
+    reference.AddFeature("MFCC", mfcc);
+    reference.AddFeature("SHC", shc);
+    reference.AddFeature("Energies", energies);
+    reference.AddFeature("Magnitudes", magnitudes);
+    reference.PrepareForExecution();
+    auto expected = reference.Execute(buffers);
+    TransformTree tt({ 48000, 16000 });  // NOLINT(*)
+    tt.set_fuse_transforms(fuse);
+    tt.set_validate_after_each_transform(true);
+    tt.AddFeature("MFCC", mfcc);
+    tt.AddFeature("SHC", shc);
+    tt.PrepareForExecution();
+    auto res = tt.Execute(buffers);
+    compare(*expected["MFCC"], *res["MFCC"], "MFCC");
+    compare(*expected["SHC"], *res["SHC"], "SHC");
+    // The existing spectra are calculated entirely after the new features
+    tt.AddFeature("Energies", energies);
+    tt.AddFeature("Magnitudes", magnitudes);
+    res = tt.Execute(buffers);
+    for (auto& feature : expected) {
+      compare(*feature.second, *res[feature.first], feature.first);
+    }
+  }
+  delete[] buffers;
+}
+
+TEST(TransformTree, SaveLoad) {
+  TransformTree tt({ 48000, 16000 });  // NOLINT(*)
+  tt.AddFeature("MFCC", { { "Window", "length=512" }, { "RDFT", "" },
+      { "SpectralEnergy", "" }, { "FilterBank", "squared=true" },
+      { "Log", "" }, { "Square", "" }, { "DCT", "" },
+      { "Selector", "length=16" } });
+  tt.AddFeature("Energy", { { "Window", "length=512" }, { "Energy", "" } });
+  tt.PrepareForExecution();
+  tt.Save("/tmp/test_mfcc_tree.bin");
+  auto loaded = TransformTree::Load("/tmp/test_mfcc_tree.bin");
+  ASSERT_EQ(tt.allocated_size(), loaded->allocated_size());
+  int16_t* buffers = new int16_t[48000];
+  memcpy(buffers, data, sizeof(data));
+  auto expected = tt.Execute(buffers);
+  auto actual = loaded->Execute(buffers);
+  delete[] buffers;
+  ASSERT_EQ(expected.size(), actual.size());
+  for (auto& feature : expected) {
+    auto& res = actual[feature.first];
+    ASSERT_EQ(feature.second->Count(), res->Count());
+    size_t size = feature.second->Format()->UnalignedSizeInBytes();
+    ASSERT_EQ(size, res->Format()->UnalignedSizeInBytes());
+    for (size_t i = 0; i < res->Count(); i++) {
+      ASSERT_EQ(0, memcmp((*feature.second)[i], (*res)[i], size))
+          << feature.first << " differs at " << i;
+    }
+  }
+}
+
+TEST(TransformTree, LiveChanges) {
+  const std::vector<std::pair<std::string, std::string>> mfcc {
+      { "Window", "length=512" }, { "RDFT", "" }, { "SpectralEnergy", "" },
+      { "FilterBank", "squared=true" }, { "Log", "" }, { "Square", "" },
+      { "DCT", "" }, { "Selector", "length=16" } };
+  const std::vector<std::pair<std::string, std::string>> energy {
+      { "Window", "length=512" }, { "Energy", "" } };
+  // MFCC without Selector ends inside the existing chain
+  const std::vector<std::pair<std::string, std::string>> cepstrum(
+      mfcc.begin(), mfcc.end() - 1);
+  TransformTree reference({ 48000, 16000 });  // NOLINT(*)
+  reference.AddFeature("MFCC", mfcc);
+  reference.AddFeature("Energy", energy);
+  reference.AddFeature("Cepstrum", cepstrum);
+  reference.PrepareForExecution();
+  TransformTree tt({ 48000, 16000 });  // NOLINT(*)
+  tt.AddFeature("MFCC", mfcc);
+  tt.PrepareForExecution();
+  auto context = tt.CreateExecutionContext();
+  tt.AddFeature("Energy", energy);
+  tt.AddFeature("Cepstrum", cepstrum);
+  ASSERT_THROW(tt.AddFeature("Broken", { { "Window", "length=512" },
+                                         { "NoSuchTransform", "" } }),
+               TransformNotRegisteredException);
+  int16_t* buffers = new int16_t[48000];
+  memcpy(buffers, data, sizeof(data));
+  ASSERT_THROW(tt.Execute(buffers, context.get()),
+               StaleExecutionContextException);
+  context = tt.CreateExecutionContext();
+  auto check = [&](const std::unordered_map<
+      std::string, std::shared_ptr<Buffers>>& actual) {
+    auto expected = reference.Execute(buffers);
+    for (auto& feature : actual) {
+      auto& res = expected[feature.first];
+      ASSERT_EQ(res->Count(), feature.second->Count());
+      size_t size = res->Format()->UnalignedSizeInBytes();
+      for (size_t i = 0; i < res->Count(); i++) {
+        ASSERT_EQ(0, memcmp((*res)[i], (*feature.second)[i], size))
+            << feature.first << " differs at " << i;
+      }
+    }
+  };
+  auto results = tt.Execute(buffers);
+  ASSERT_EQ(3U, results.size());
+  check(results);
+  check(tt.Execute(buffers, context.get()));
+  tt.RemoveFeature("MFCC");
+  ASSERT_THROW(tt.RemoveFeature("MFCC"), FeatureNotFoundException);
+  results = tt.Execute(buffers);
+  ASSERT_EQ(2U, results.size());
+  check(results);
+  tt.RemoveFeature("Cepstrum");
+  tt.AddFeature("MFCC", mfcc);
+  results = tt.Execute(buffers);
+  ASSERT_EQ(2U, results.size());
+  check(results);
+  delete[] buffers;
+}
+
+TEST(TransformFactory, Find) {
+  ASSERT_EQ(nullptr, TransformFactory::Instance().Find("Missing"));
+  auto constructors = TransformFactory::Instance().Find("ParentTest");
+  ASSERT_NE(nullptr, constructors);
+  ASSERT_EQ(1U, constructors->size());
+  auto transform = constructors->begin()->second();
+  ASSERT_EQ("ParentTest", transform->Name());
+  // The parameters are registered on the first use
+  ASSERT_EQ(1U, transform->SupportedParameters().count("AmplifyFactor"));
+  ASSERT_EQ(1U, TransformFactory::Instance().Map().count("ChildTest"));
+}
+
 #include "tests/google/src/gtest_main.cc"
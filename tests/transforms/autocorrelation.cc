@@ -32,6 +32,7 @@
 #include "src/transforms/autocorrelation.h"
 #include "tests/transforms/transform_test.h"
 #include <fftf/api.h>
+#include <cmath>
 
 using sound_feature_extraction::formats::ArrayFormatF;
 using sound_feature_extraction::BuffersBase;
@@ -54,7 +55,7 @@ class AutocorrelationTest : public TransformTest<Autocorrelation> {
 };
 
 TEST_F(AutocorrelationTest, Do) {
-  Do((*Input)[0], (*Output)[0]);
+  Do((*Input), &(*Output));
   ASSERT_NEAR((*Output)[0][0], 2 * 2.f / Size, 1.f);
   ASSERT_NEAR((*Output)[0][1], 3 * 2.f / Size, 1.f);
   ASSERT_NEAR((*Output)[0][3], -2 * 2.f / Size, 1.f);
@@ -63,9 +64,84 @@ TEST_F(AutocorrelationTest, Do) {
 
 TEST_F(AutocorrelationTest, DoNormalized) {
   set_normalize(true);
-  Do((*Input)[0], (*Output)[0]);
+  Do((*Input), &(*Output));
   for (int i = 0; i < Size * 2 - 1; i++) {
     ASSERT_LE((*Output)[0][i], 1.f) << i;
   }
   ASSERT_FLOAT_EQ(1.f, (*Output)[0][Size - 1]);
 }
+
+TEST_F(AutocorrelationTest, Batch) {
+  for (int size : { 5, 64, 300 }) {
+    // 70 frames do not fit into a single batch
+    const int count = 70;
+    SetUpTransform(count, size, 18000);
+    for (int i = 0; i < count; i++) {
+      for (int j = 0; j < size; j++) {
+        (*Input)[i][j] = sinf(i * 0.3f + j * (0.05f + i * 0.01f)) + j % 3;
+      }
+    }
+    for (bool normalize : { false, true }) {
+      set_normalize(normalize);
+      Do((*Input), &(*Output));
+      for (int i = 0; i < count; i++) {
+        double zero = 0;
+        for (int j = 0; j < size; j++) {
+          zero += (*Input)[i][j] * (*Input)[i][j];
+        }
+        for (int lag = 1 - size; lag < size; lag++) {
+          double sum = 0;
+          for (int j = std::max(0, -lag); j < size && j + lag < size; j++) {
+            sum += (*Input)[i][j] * (*Input)[i][j + lag];
+          }
+          if (normalize) {
+            sum /= zero;
+          }
+          ASSERT_NEAR(sum, (*Output)[i][size - 1 + lag],
+                      (normalize? 1 : zero) * 1e-5)
+              << size << " " << normalize << " " << i << " " << lag;
+        }
+      }
+    }
+  }
+}
+
+TEST_F(AutocorrelationTest, Lags) {
+  const int size = 512, count = 10;
+  // 13 lags are calculated directly, 400 through FFT
+  for (int lags : { 13, 400 }) {
+    set_lags(lags);
+    SetUpTransform(count, size, 16000);
+    ASSERT_EQ(static_cast<size_t>(lags), output_format_->Size());
+    ASSERT_EQ(lags == 13, direct());
+    for (int i = 0; i < count; i++) {
+      for (int j = 0; j < size; j++) {
+        (*Input)[i][j] = sinf(i * 0.3f + j * (0.05f + i * 0.01f)) + j % 3;
+      }
+    }
+    for (bool normalize : { false, true }) {
+      set_normalize(normalize);
+      Do((*Input), &(*Output));
+      for (int i = 0; i < count; i++) {
+        double zero = 0;
+        for (int j = 0; j < size; j++) {
+          zero += (*Input)[i][j] * (*Input)[i][j];
+        }
+        for (int lag = 0; lag < lags; lag++) {
+          double sum = 0;
+          for (int j = 0; j + lag < size; j++) {
+            sum += (*Input)[i][j] * (*Input)[i][j + lag];
+          }
+          if (normalize) {
+            sum /= zero;
+          }
+          ASSERT_NEAR(sum, (*Output)[i][lag], (normalize? 1 : zero) * 1e-5)
+              << lags << " " << normalize << " " << i << " " << lag;
+        }
+      }
+    }
+  }
+  set_lags(size + 1);
+  ASSERT_THROW(SetUpTransform(1, size, 16000),
+               sound_feature_extraction::InvalidParameterValueException);
+}
@@ -29,6 +29,8 @@
  */
 
 #include <cmath>
+#include <vector>
+#include "src/primitives/energy.h"
 #include "src/transforms/beat.h"
 #include "tests/transforms/transform_test.h"
 #include "tests/transforms/beat_test.inc"
@@ -51,6 +53,24 @@ TEST_F(BeatTest, Do) {
   ASSERT_NEAR(180.f, (*Output)[0][1][0], 5.f);
 }
 
+TEST_F(BeatTest, Decimate) {
+  // The default resolution2 requires more than the sampling rate
+  ASSERT_EQ(1, decimation());
+  set_resolution2(2);
+  set_decimate(false);
+  Initialize();
+  ASSERT_EQ(1, decimation());
+  Do((*Input), &(*Output));
+  float reference = (*Output)[0][1][0];
+  set_decimate(true);
+  Initialize();
+  // 240 * 242 / 120 = 484 Hz
+  ASSERT_EQ(6, decimation());
+  Do((*Input), &(*Output));
+  ASSERT_NEAR(reference, (*Output)[0][1][0], 2.f);
+  ASSERT_NEAR(180.f, (*Output)[0][1][0], 5.f);
+}
+
 TEST_F(BeatTest, CombConvolve) {
   auto data_size = sizeof(data_conv) / sizeof(data_conv[0]);
   float out[data_size + 2001 - 1];
@@ -59,3 +79,29 @@ TEST_F(BeatTest, CombConvolve) {
     ASSERT_NEAR(out[i], data_conv_result[i], 0.0001f) << "i = " << i;
   }
 }
+
+TEST_F(BeatTest, CombEnergy) {
+  const int size = 500;
+  std::vector<float> in(size), lags(size);
+  for (int i = 0; i < size; i++) {
+    in[i] = sinf(i * 0.13f) + (i % 11) * 0.1f;
+  }
+  for (int l = 0; l < size; l++) {
+    double sum = 0;
+    for (int i = 0; i + l < size; i++) {
+      sum += in[i] * in[i + l];
+    }
+    lags[l] = sum;
+  }
+  for (int pulses : { 1, 3, 5 }) {
+    for (int period : { 1, 7, 100, 260, 450 }) {
+      std::vector<float> conv(size + (pulses - 1) * period);
+      CombConvolve(in.data(), size, pulses, period, conv.data());
+      float reference = calculate_energy(false, false, conv.data(),
+                                         conv.size());
+      ASSERT_NEAR(reference,
+                  CombEnergy(lags.data(), size, pulses, period),
+                  reference * 1e-4f) << pulses << " " << period;
+    }
+  }
+}
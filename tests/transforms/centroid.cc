@@ -61,6 +61,19 @@ TEST_F(CentroidTest, Do) {
   ASSERT_EQF(res, (*Output)[0]);
 }
 
+TEST_F(CentroidTest, FixedLength) {
+  for (int size : { 129, 257, 513 }) {
+    SetUpTransform(1, size, 18000);
+    for (int i = 0; i < size; i++) {
+      (*Input)[0][i] = fabs(sinf(i * i) + i * cosf(i));
+    }
+    Do((*Input)[0], &(*Output)[0]);
+    double res = Do(false, (*Input)[0], size);
+    res /= input_format_->Duration();
+    ASSERT_EQF(res, (*Output)[0]) << size;
+  }
+}
+
 #define CLASS_NAME CentroidTest
 #define ITER_COUNT 400000
 #define NO_OUTPUT
@@ -64,5 +64,20 @@ TEST_F(ComplexMagnitudeTest, Do) {
   }
 }
 
+TEST_F(ComplexMagnitudeTest, FixedLength) {
+  for (int size : { 258, 514, 1026 }) {
+    SetUpTransform(1, size, 18000);
+    for (int i = 0; i < size; i++) {
+      (*Input)[0][i] = i;
+    }
+    Do((*Input)[0], (*Output)[0]);
+    for (int i = 0; i < size / 2; i++) {
+      float re = i * 2;
+      float im = i * 2 + 1;
+      ASSERT_EQF(sqrtf(re * re + im * im), (*Output)[0][i]) << size;
+    }
+  }
+}
+
 #define CLASS_NAME ComplexMagnitudeTest
 #include "tests/transforms/benchmark.inc"
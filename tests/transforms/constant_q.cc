@@ -0,0 +1,122 @@
+/*! @file constant_q.cc
+ *  @brief Tests for sound_feature_extraction::transforms::ConstantQ.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "src/transforms/constant_q.h"
+#include "src/transforms/filter_bank.h"
+#include "tests/transforms/transform_test.h"
+
+using sound_feature_extraction::formats::ArrayFormatF;
+using sound_feature_extraction::BuffersBase;
+using sound_feature_extraction::transforms::ConstantQ;
+
+class ConstantQTest : public TransformTest<ConstantQ> {
+ public:
+  int Length = 2048;
+  int Size = Length + 2;
+  float Frequency = 261.63f * 4;
+
+  virtual void SetUp() {
+    set_frequency_min(261.63f);
+    set_frequency_max(4000);
+    SetUpTransform(2, Size, 16000);
+    // The RDFT of the sine at the center of the 25-th bin
+    std::vector<float> signal(Length);
+    for (int n = 0; n < Length; n++) {
+      signal[n] = sinf(2 * M_PI * Frequency * n / 16000);
+    }
+    for (int j = 0; j < Size / 2; j++) {
+      double re = 0, im = 0;
+      for (int n = 0; n < Length; n++) {
+        re += signal[n] * cos(2 * M_PI * j * n / Length);
+        im -= signal[n] * sin(2 * M_PI * j * n / Length);
+      }
+      for (int frame = 0; frame < 2; frame++) {
+        (*Input)[frame][j * 2] = re;
+        (*Input)[frame][j * 2 + 1] = im;
+      }
+    }
+  }
+};
+
+TEST_F(ConstantQTest, Do) {
+  ASSERT_EQ(48U, output_format_->Size());
+  Do((*Input), &(*Output));
+  int peak = std::max_element((*Output)[0], (*Output)[0] + 48) -
+      (*Output)[0];
+  ASSERT_EQ(24, peak);
+  // The amplitude of the sine is 1, the window is normalized by its length
+  ASSERT_NEAR(0.54f * 0.54f / 4, (*Output)[0][24], 0.01f);
+  ASSERT_LT((*Output)[0][22], (*Output)[0][24] / 100);
+  ASSERT_LT((*Output)[0][26], (*Output)[0][24] / 100);
+  for (int i = 0; i < 48; i++) {
+    ASSERT_FLOAT_EQ((*Output)[0][i], (*Output)[1][i]) << i;
+  }
+  for (auto& kernel : kernels()) {
+    ASSERT_LT(kernel.end - kernel.begin, Size / 8);
+  }
+}
+
+TEST_F(ConstantQTest, Simd) {
+  Do((*Input), &(*Output));
+  std::vector<float> simd((*Output)[0], (*Output)[0] + 48);
+  set_use_simd(false);
+  Do((*Input), &(*Output));
+  set_use_simd(true);
+  for (int i = 0; i < 48; i++) {
+    ASSERT_NEAR(simd[i], (*Output)[0][i], simd[i] * 1e-4f + 1e-9f) << i;
+  }
+}
+
+TEST_F(ConstantQTest, Chroma) {
+  Do((*Input), &(*Output));
+  std::vector<float> bins((*Output)[0], (*Output)[0] + 48);
+  set_chroma(true);
+  SetUpTransform(2, Size, 16000);
+  ASSERT_EQ(12U, output_format_->Size());
+  Do((*Input), &(*Output));
+  for (int i = 0; i < 12; i++) {
+    float sum = 0;
+    for (int j = i; j < 48; j += 12) {
+      sum += bins[j];
+    }
+    ASSERT_NEAR(sum, (*Output)[0][i], sum * 1e-5f) << i;
+  }
+}
+
+TEST_F(ConstantQTest, InvalidRange) {
+  set_frequency_max(9000);
+  ASSERT_THROW(SetUpTransform(1, Size, 16000),
+               sound_feature_extraction::transforms::
+                   InvalidFrequencyRangeException);
+}
@@ -30,13 +30,17 @@
 
 
 #include "src/transforms/convolve.h"
+#include <algorithm>
+#include <cmath>
 #include <cstring>
+#include <vector>
 #include <fftf/api.h>
 #include "tests/transforms/transform_test.h"
 
 using sound_feature_extraction::formats::ArrayFormatF;
 using sound_feature_extraction::BuffersBase;
 using sound_feature_extraction::transforms::ConvolveFilter;
+using sound_feature_extraction::transforms::FIRFilterBase;
 using sound_feature_extraction::WindowType;
 
 class ConvolveTest : public TransformTest<ConvolveFilter> {
@@ -58,6 +62,114 @@ TEST_F(ConvolveTest, Do) {
   Output->Validate();
 }
 
+TEST_F(ConvolveTest, OverlapSave) {
+  ASSERT_TRUE(overlap_save());
+  ASSERT_FALSE(ChooseBlockLength(Size, 8));
+}
+
+class ConvolveOverlapSaveTest : public TransformTest<ConvolveFilter> {
+ public:
+  static constexpr int Size = 3001;
+  static constexpr int FilterLength = 257;
+
+  virtual void SetUp() {
+    set_window(WindowType::kWindowTypeHamming);
+    set_length(FilterLength);
+    SetUpTransform(1, Size, 16000);
+    for (int i = 0; i < Size; i++) {
+      (*Input)[0][i] = sinf(i * 0.05f) + (i % 7) * 0.1f;
+    }
+  }
+};
+
+constexpr int ConvolveOverlapSaveTest::Size;
+constexpr int ConvolveOverlapSaveTest::FilterLength;
+
+TEST_F(ConvolveOverlapSaveTest, Do) {
+  ASSERT_TRUE(overlap_save());
+  Do((*Input)[0], (*Output)[0]);
+  Output->Validate();
+  std::vector<float> filter(FilterLength);
+  CalculateFilter(filter.data());
+  const float* in = (*Input)[0];
+  for (int i = 0; i < Size + FilterLength - 1; i++) {
+    float ref = 0;
+    for (int j = std::max(0, i - Size + 1);
+         j < std::min(FilterLength, i + 1); j++) {
+      ref += in[i - j] * filter[j];
+    }
+    ASSERT_NEAR(ref, (*Output)[0][i], 1e-3f * (1 + fabsf(ref))) << i;
+  }
+}
+
+class ConvolveFFTTest : public TransformTest<ConvolveFilter> {
+ public:
+  static constexpr int Count = 5;
+  static constexpr int Size = 3001;
+  static constexpr int FilterLength = 257;
+
+  virtual void SetUp() {
+    set_window(WindowType::kWindowTypeHamming);
+    set_length(FilterLength);
+    SetUpTransform(Count, Size, 16000);
+    for (int t = 0; t < Count; t++) {
+      for (int i = 0; i < Size; i++) {
+        (*Input)[t][i] = sinf(i * 0.05f * (t + 1)) + ((i + t) % 7) * 0.1f;
+      }
+    }
+  }
+};
+
+constexpr int ConvolveFFTTest::Count;
+constexpr int ConvolveFFTTest::Size;
+constexpr int ConvolveFFTTest::FilterLength;
+
+TEST_F(ConvolveFFTTest, ChooseFFTLength) {
+  ASSERT_EQ(4096, fft_length());
+  ASSERT_EQ(0, ChooseFFTLength(Size, 8));
+  ASSERT_EQ(0, ChooseFFTLength(1 << 24, 1 << 10));
+}
+
+TEST_F(ConvolveFFTTest, Do) {
+  Do((*Input), &(*Output));
+  Output->Validate();
+  std::vector<float> filter(FilterLength);
+  CalculateFilter(filter.data());
+  for (int t = 0; t < Count; t++) {
+    const float* in = (*Input)[t];
+    for (int i = 0; i < Size + FilterLength - 1; i++) {
+      float ref = 0;
+      for (int j = std::max(0, i - Size + 1);
+           j < std::min(FilterLength, i + 1); j++) {
+        ref += in[i - j] * filter[j];
+      }
+      ASSERT_NEAR(ref, (*Output)[t][i], 1e-3f * (1 + fabsf(ref)))
+          << t << " " << i;
+    }
+  }
+}
+
+TEST_F(ConvolveFFTTest, OverlapSaveBatches) {
+  ASSERT_TRUE(overlap_save());
+  // The blocks of all the buffers are transformed in the shared batches
+  FIRFilterBase::Do((*Input), &(*Output));
+  Output->Validate();
+  std::vector<float> filter(FilterLength);
+  CalculateFilter(filter.data());
+  for (int t = 0; t < Count; t++) {
+    const float* in = (*Input)[t];
+    for (int i = 0; i < Size + FilterLength - 1; i++) {
+      float ref = 0;
+      for (int j = std::max(0, i - Size + 1);
+           j < std::min(FilterLength, i + 1); j++) {
+        ref += in[i - j] * filter[j];
+      }
+      ASSERT_NEAR(ref, (*Output)[t][i], 1e-3f * (1 + fabsf(ref)))
+          << t << " " << i;
+    }
+  }
+}
+
 const float ConvolveTest::Data[220500] = {
   61.450119, 41.283104, 12.235485, 21.311483, 55.787254, 85.637642, 107.480453, 117.278076, 114.257561, 97.687584, 
   70.307327, 34.594280, 4.257645, 42.398407, 74.504990, 97.820717, 109.145454, 108.546532, 95.937912, 74.359474, 
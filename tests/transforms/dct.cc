@@ -28,13 +28,19 @@
  *  under the License.
  */
 
+#include <cmath>
+#include <unordered_map>
+#include "src/transform_tree.h"
 #include "src/transforms/dct.h"
+#include "tests/speech_sample.inc"
 #include "tests/transforms/transform_test.h"
 
 using sound_feature_extraction::formats::ArrayFormatF;
 using sound_feature_extraction::BuffersBase;
 using sound_feature_extraction::transforms::DCT;
 using sound_feature_extraction::transforms::DCTInverse;
+using sound_feature_extraction::Buffers;
+using sound_feature_extraction::TransformTree;
 
 class DCTTest : public TransformTest<DCT> {
  public:
@@ -49,6 +55,23 @@ class DCTTest : public TransformTest<DCT> {
   }
 };
 
+class DCTTruncatedTest : public TransformTest<DCT> {
+ public:
+  int Size;
+
+  virtual void SetUp() {
+    Size = 32;
+    set_length(13);
+    // Not a multiple of the frames block
+    SetUpTransform(7, Size, 16000);
+    for (size_t b = 0; b < Input->Count(); b++) {
+      for (int i = 0; i < Size; i++) {
+        (*Input)[b][i] = sinf(i * (b + 1)) + 1;
+      }
+    }
+  }
+};
+
 class DCTInverseTest : public TransformTest<DCTInverse> {
  public:
   int Size;
@@ -67,7 +90,66 @@ TEST_F(DCTTest, Do) {
   Do((*Input), &(*Output));
 }
 
+TEST_F(DCTTruncatedTest, Do) {
+  ASSERT_EQ(13U, output_format_->Size());
+  Do((*Input), &(*Output));
+  for (size_t b = 0; b < Input->Count(); b++) {
+    for (int k = 0; k < 13; k++) {
+      double sum = 0;
+      for (int n = 0; n < Size; n++) {
+        sum += 2 * (*Input)[b][n] * cos(M_PI * k * (2 * n + 1) / (2. * Size));
+      }
+      ASSERT_NEAR(sum, (*Output)[b][k], 1e-4) << b << " " << k;
+    }
+  }
+}
+
 TEST_F(DCTInverseTest, Do) {
   ASSERT_EQ(input_format_->Size(), output_format_->Size());
   Do((*Input), &(*Output));
 }
+
+TEST(DCT, CepstrumFusion) {
+  std::unordered_map<std::string, std::shared_ptr<Buffers>> results[2];
+  int16_t* buffers = new int16_t[48000];
+  memcpy(buffers, data, sizeof(data));
+  for (int fuse = 0; fuse < 2; fuse++) {
+    TransformTree tt({ 48000, 16000 });  // NOLINT(*)
+    tt.set_fuse_transforms(fuse);
+    tt.AddFeature("MFCC", { { "Window", "length=512" }, { "RDFT", "" },
+        { "SpectralEnergy", "" }, { "FilterBank", "squared=true" },
+        { "Log", "" }, { "DCT", "" }, { "Selector", "length=13" } });
+    // The full DCT is a feature itself, so this tail must stay
+    tt.AddFeature("MFCCFull", { { "Window", "length=512" }, { "RDFT", "" },
+        { "SpectralEnergy", "" }, { "FilterBank", "squared=true,number=32" },
+        { "Log", "" }, { "DCT", "" } });
+    tt.AddFeature("MFCCShared", { { "Window", "length=512" }, { "RDFT", "" },
+        { "SpectralEnergy", "" }, { "FilterBank", "squared=true,number=32" },
+        { "Log", "" }, { "DCT", "" }, { "Selector", "length=13" } });
+    tt.PrepareForExecution();
+    results[fuse] = tt.Execute(buffers);
+    auto report = tt.ExecutionTimeReport();
+    ASSERT_EQ(fuse == 1, report.find("Cepstrum") != report.end());
+    ASSERT_NE(report.end(), report.find("DCT"));
+  }
+  delete[] buffers;
+  ASSERT_EQ(3U, results[1].size());
+  // The filter energies are summed in a different order
+  for (auto& feature : results[0]) {
+    auto& actual = results[1][feature.first];
+    ASSERT_EQ(feature.second->Count(), actual->Count());
+    size_t size = feature.second->Format()->UnalignedSizeInBytes() /
+        sizeof(float);
+    ASSERT_EQ(size, actual->Format()->UnalignedSizeInBytes() / sizeof(float));
+    for (size_t i = 0; i < actual->Count(); i++) {
+      auto expected_data = reinterpret_cast<const float*>(
+          (*feature.second)[i]);
+      auto actual_data = reinterpret_cast<const float*>((*actual)[i]);
+      for (size_t j = 0; j < size; j++) {
+        ASSERT_NEAR(expected_data[j], actual_data[j],
+                    std::abs(expected_data[j]) * 1e-4f + 1e-4f)
+            << feature.first << " differs at " << i << ", " << j;
+      }
+    }
+  }
+}
@@ -32,10 +32,13 @@
 #include "src/transforms/delta.h"
 #include "tests/transforms/transform_test.h"
 #include <fftf/api.h>
+#include <algorithm>
+#include <vector>
 
 using sound_feature_extraction::formats::ArrayFormatF;
 using sound_feature_extraction::BuffersBase;
 using sound_feature_extraction::transforms::Delta;
+using sound_feature_extraction::InstructionSet;
 
 class DeltaTest : public TransformTest<Delta> {
  public:
@@ -58,17 +61,98 @@ TEST_F(DeltaTest, Do) {
     ASSERT_NEAR((*Output)[0][i], 1, 0.00001f) << i;
   }
 }
-/*
+TEST_F(DeltaTest, InstructionSets) {
+  std::vector<float> reference(Size), res(Size);
+  for (int length = Size - 17; length <= Size; length++) {
+    DoSimple(false, (*Input)[0], (*Input)[1], length, reference.data());
+    for (int isa = 0; isa <= static_cast<int>(InstructionSet::kAVX512);
+         isa++) {
+      if (!IsSupported(static_cast<InstructionSet>(isa))) {
+        continue;
+      }
+      set_max_instruction_set(static_cast<InstructionSet>(isa));
+      DoSimple(true, (*Input)[0], (*Input)[1], length, res.data());
+      for (int i = 0; i < length; i++) {
+        ASSERT_EQ(reference[i], res[i]) << isa << " " << i;
+      }
+    }
+  }
+  set_max_instruction_set(InstructionSet::kAVX512);
+}
+
+/// @brief Calculates the regression deltas straightforwardly.
+static std::vector<std::vector<float>> Regression(
+    const std::vector<std::vector<float>>& rows, int rlength) {
+  int count = rows.size(), size = rows[0].size();
+  std::vector<std::vector<float>> res(count, std::vector<float>(size));
+  for (int t = 0; t < count; t++) {
+    int frame = t == 0? 1 : t == count - 1? count - 2 : t;
+    int k = std::min(rlength / 2, std::min(frame, count - 1 - frame));
+    float norm = 0;
+    for (int m = 1; m <= k; m++) {
+      norm += 2 * m * m;
+    }
+    for (int j = 0; j < size; j++) {
+      float sum = 0;
+      for (int m = 1; m <= k; m++) {
+        sum += (rows[frame + m][j] - rows[frame - m][j]) * m;
+      }
+      res[t][j] = sum / norm;
+    }
+  }
+  return res;
+}
+
 TEST_F(DeltaTest, DoRegression) {
-  set_type(sound_feature_extraction::transforms::kDeltaTypeRegression);
-  set_use_simd(false);
+  const int size = 37;
+  for (int count : { 3, 5, 70, 200 }) {
+    std::vector<std::vector<float>> rows(count, std::vector<float>(size));
+    for (int t = 0; t < count; t++) {
+      for (int j = 0; j < size; j++) {
+        rows[t][j] = sinf(t * (j + 1) * 0.13f) * 10 + j;
+      }
+    }
+    for (int rlength : { 3, 5, 9 }) {
+      auto delta = Regression(rows, rlength);
+      auto delta2 = Regression(delta, rlength);
+      set_type(sound_feature_extraction::transforms::DeltaType::kRegression);
+      set_rlength(rlength);
+      set_append(true);
+      set_acceleration(true);
+      SetUpTransform(count, size, 18000);
+      ASSERT_EQ(static_cast<size_t>(size * 3), output_format_->Size());
+      for (int t = 0; t < count; t++) {
+        std::copy(rows[t].begin(), rows[t].end(), (*Input)[t]);
+      }
+      Do((*Input), &(*Output));
+      for (int t = 0; t < count; t++) {
+        for (int j = 0; j < size; j++) {
+          ASSERT_EQ(rows[t][j], (*Output)[t][j]);
+          ASSERT_NEAR(delta[t][j], (*Output)[t][size + j], 1e-4f)
+              << count << " " << rlength << " " << t << " " << j;
+          ASSERT_NEAR(delta2[t][j], (*Output)[t][2 * size + j], 1e-4f)
+              << count << " " << rlength << " " << t << " " << j;
+        }
+      }
+    }
+  }
+}
+
+TEST_F(DeltaTest, DoSimpleAcceleration) {
+  const int count = 5;
+  set_acceleration(true);
+  SetUpTransform(count, Size, 18000);
+  for (int t = 0; t < count; t++) {
+    for (int i = 0; i < Size; i++) {
+      (*Input)[t][i] = t * t * i;
+    }
+  }
   Do((*Input), &(*Output));
-  set_use_simd(true);
-  auto output_simd = std::static_pointer_cast<Delta::OutBuffers>(
-      CreateOutputBuffers(Output->Count()));
-  Do((*Input), &(*output_simd));
-  for (int i = 0; i < Size; i++) {
-    ASSERT_NEAR((*Output)[0][i], (*output_simd)[0][i], 0.00001f) << i;
+  for (int t = 0; t < count; t++) {
+    for (int i = 0; i < Size; i++) {
+      int dt = std::max(t, 1);
+      ASSERT_EQ((2 * dt - 1) * i, (*Output)[t][i]) << t << " " << i;
+      ASSERT_EQ(dt > 1? 2 * i : 0, (*Output)[t][Size + i]) << t << " " << i;
+    }
   }
 }
-*/
@@ -29,12 +29,17 @@
  */
 
 
+#include <unordered_map>
+#include "src/transform_tree.h"
 #include "src/transforms/diff.h"
+#include "tests/speech_sample.inc"
 #include "tests/transforms/transform_test.h"
 
 using sound_feature_extraction::formats::ArrayFormatF;
 using sound_feature_extraction::BuffersBase;
 using sound_feature_extraction::transforms::Diff;
+using sound_feature_extraction::Buffers;
+using sound_feature_extraction::TransformTree;
 
 class DiffTest : public TransformTest<Diff> {
  public:
@@ -118,3 +123,31 @@ TEST_F(DiffTest, DoSWTNoRectify) {
 #define CLASS_NAME DiffTest
 #define ITER_COUNT 500000
 #include "tests/transforms/benchmark.inc"
+
+TEST(Diff, RectifyFusion) {
+  std::unique_ptr<TransformTree> trees[2];
+  std::unordered_map<std::string, std::shared_ptr<Buffers>> results[2];
+  int16_t* buffers = new int16_t[48000];
+  memcpy(buffers, data, sizeof(data));
+  for (int fuse = 0; fuse < 2; fuse++) {
+    trees[fuse].reset(new TransformTree({ 48000, 16000 }));  // NOLINT(*)
+    auto& tt = *trees[fuse];
+    tt.set_fuse_transforms(fuse);
+    tt.AddFeature("Onsets", { { "Window", "length=512" }, { "RDFT", "" },
+                              { "SpectralEnergy", "" }, { "Diff", "" },
+                              { "Rectify", "" }, { "Energy", "" } });
+    tt.PrepareForExecution();
+    results[fuse] = tt.Execute(buffers);
+    auto report = tt.ExecutionTimeReport();
+    ASSERT_EQ(fuse == 0, report.find("Rectify") != report.end());
+    ASSERT_NE(report.end(), report.find("Diff"));
+  }
+  delete[] buffers;
+  auto& expected = results[0]["Onsets"];
+  auto& actual = results[1]["Onsets"];
+  ASSERT_EQ(expected->Count(), actual->Count());
+  for (size_t i = 0; i < actual->Count(); i++) {
+    ASSERT_EQ(*reinterpret_cast<const float*>((*expected)[i]),
+              *reinterpret_cast<const float*>((*actual)[i])) << i;
+  }
+}
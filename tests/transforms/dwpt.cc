@@ -34,6 +34,8 @@
 using sound_feature_extraction::formats::ArrayFormatF;
 using sound_feature_extraction::BuffersBase;
 using sound_feature_extraction::transforms::DWPT;
+using sound_feature_extraction::primitives::WaveletFilterBank;
+using sound_feature_extraction::InstructionSet;
 
 class DWPTTest : public TransformTest<DWPT> {
  public:
@@ -50,6 +52,36 @@ class DWPTTest : public TransformTest<DWPT> {
 
 TEST_F(DWPTTest, Forward) {
   ASSERT_EQ(input_format_->Size(), output_format_->Size());
-  Do((*Input)[0], (*Output)[0]);
+  Do((*Input), &(*Output));
+}
+
+TEST_F(DWPTTest, Batch) {
+  const int count = 70;
+  SetUpTransform(count, Size, 16000);
+  for (int f = 0; f < count; f++) {
+    for (int i = 0; i < Size; i++) {
+      (*Input)[f][i] = sinf(i * (f + 1) * 0.05f);
+    }
+  }
+  WaveletFilterBank wfb(type(), order(), tree());
+  std::vector<float> reference(Size);
+  for (int isa = 0; isa <= static_cast<int>(InstructionSet::kAVX512);
+       isa++) {
+    if (!IsSupported(static_cast<InstructionSet>(isa))) {
+      continue;
+    }
+    set_max_instruction_set(static_cast<InstructionSet>(isa));
+    set_use_simd(isa != 0);
+    Do((*Input), &(*Output));
+    for (int f = 0; f < count; f++) {
+      wfb.Apply((*Input)[f], Size, reference.data());
+      for (int i = 0; i < Size; i++) {
+        ASSERT_NEAR(reference[i], (*Output)[f][i],
+                    fabsf(reference[i]) * 1e-4f + 1e-4f)
+            << isa << " " << f << " " << i;
+      }
+    }
+  }
+  set_max_instruction_set(InstructionSet::kAVX512);
 }
 
@@ -0,0 +1,166 @@
+/*! @file elementwise_chain.cc
+ *  @brief Tests for sound_feature_extraction::transforms::ElementwiseChain.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#include <cmath>
+#include <unordered_map>
+#include "src/formats/int16_to_float.h"
+#include "src/transform_tree.h"
+#include "src/transforms/elementwise_chain.h"
+#include "src/transforms/log.h"
+#include "src/transforms/rectify.h"
+#include "src/transforms/square.h"
+#include "tests/speech_sample.inc"
+#include "tests/transforms/transform_test.h"
+
+using sound_feature_extraction::BuffersBase;
+using sound_feature_extraction::Transform;
+using sound_feature_extraction::formats::ArrayFormat16;
+using sound_feature_extraction::formats::Int16ToFloatRaw;
+using sound_feature_extraction::transforms::ElementwiseChain;
+using sound_feature_extraction::transforms::ElementwiseWideningChain;
+using sound_feature_extraction::transforms::LogRaw;
+using sound_feature_extraction::transforms::NotElementwiseTransformException;
+using sound_feature_extraction::transforms::NotWideningTransformException;
+using sound_feature_extraction::transforms::Rectify;
+using sound_feature_extraction::transforms::Scale;
+using sound_feature_extraction::transforms::Square;
+using sound_feature_extraction::Buffers;
+using sound_feature_extraction::TransformTree;
+
+class ElementwiseChainTest : public TransformTest<ElementwiseChain> {
+ public:
+  int Size;
+
+  virtual void SetUp() {
+    // Not a multiple of the tile length
+    Size = kTileLength * 2 + 37;
+    AddStage(std::make_shared<Rectify>());
+    AddStage(std::make_shared<LogRaw>());
+    AddStage(std::make_shared<Square>());
+    SetUpTransform(1, Size, 16000);
+    for (int i = 0; i < Size; i++) {
+      (*Input)[0][i] = (i % 2 == 0? -1 : 1) * i * 0.01f;
+    }
+  }
+};
+
+TEST_F(ElementwiseChainTest, Do) {
+  ASSERT_EQ(3U, stages().size());
+  Do((*Input)[0], (*Output)[0]);
+  for (int i = 0; i < Size; i++) {
+    float value = logf(fabsf((*Input)[0][i]) + 1);
+    ASSERT_NEAR(value * value, (*Output)[0][i], 1e-5f * (1 + value * value))
+        << i;
+  }
+}
+
+TEST_F(ElementwiseChainTest, AddStage) {
+  ASSERT_THROW(AddStage(std::make_shared<ElementwiseChain>()),
+               NotElementwiseTransformException);
+}
+
+TEST(ElementwiseWideningChain, Do) {
+  auto chain = std::make_shared<ElementwiseWideningChain<int16_t>>(
+      std::make_shared<Int16ToFloatRaw>());
+  auto scale = std::make_shared<Scale>();
+  scale->set_scale(1.f / 32768);
+  scale->set_offset(1);
+  chain->AddStage(scale);
+  chain->AddStage(std::make_shared<Square>());
+  // The leading Scale is applied by the converter
+  ASSERT_EQ(1U, chain->stages().size());
+  ASSERT_EQ(1.f / 32768, chain->scale());
+  ASSERT_EQ(1.f, chain->offset());
+  int size = ElementwiseChain::kTileLength * 2 + 37;
+  auto format = std::make_shared<ArrayFormat16>(size, 16000);
+  chain->SetInputFormat(format, 1);
+  chain->Initialize();
+  BuffersBase<int16_t*> input(format, 1);
+  for (int i = 0; i < size; i++) {
+    input[0][i] = (i * 7919) % 65536 - 32768;
+  }
+  auto output = chain->CreateOutputBuffers(1);
+  std::static_pointer_cast<Transform>(chain)->Do(input, output.get());
+  auto out = static_cast<const float*>((*output)[0]);
+  for (int i = 0; i < size; i++) {
+    float value = input[0][i] / 32768.f + 1;
+    ASSERT_NEAR(value * value, out[i], 1e-6f) << i;
+  }
+}
+
+TEST(ElementwiseWideningChain, Constructor) {
+  ASSERT_THROW(ElementwiseWideningChain<int16_t>(std::make_shared<Square>()),
+               NotWideningTransformException);
+}
+
+TEST(ElementwiseNarrowingChain, Fusion) {
+  std::unique_ptr<TransformTree> trees[2];
+  std::unordered_map<std::string, std::shared_ptr<Buffers>> results[2];
+  int16_t* buffers = new int16_t[48000];
+  memcpy(buffers, data, sizeof(data));
+  for (int fuse = 0; fuse < 2; fuse++) {
+    trees[fuse].reset(new TransformTree({ 48000, 16000 }));  // NOLINT(*)
+    auto& tt = *trees[fuse];
+    tt.set_fuse_transforms(fuse);
+    tt.AddFeature("Float16", { { "Window", "length=512" }, { "RDFT", "" },
+        { "SpectralEnergy", "" }, { "FilterBank", "squared=true" },
+        { "Log", "" }, { "Rectify", "" }, { "Float16", "" } });
+    tt.AddFeature("Int8", { { "Window", "length=512" }, { "RDFT", "" },
+        { "SpectralEnergy", "" }, { "FilterBank", "squared=true" },
+        { "Log", "" }, { "Square", "" }, { "Int8", "scale=0.5" } });
+    // DCT is not elementwise, the conversion stays a separate node
+    tt.AddFeature("BFloat16", { { "Window", "length=512" }, { "RDFT", "" },
+        { "SpectralEnergy", "" }, { "FilterBank", "squared=true" },
+        { "Log", "" }, { "DCT", "" }, { "BFloat16", "" } });
+    tt.PrepareForExecution();
+    results[fuse] = tt.Execute(buffers);
+    auto report = tt.ExecutionTimeReport();
+    ASSERT_EQ(fuse == 1,
+              report.find("ElementwiseNarrowingChain") != report.end());
+    ASSERT_EQ(fuse == 0, report.find("Float16") != report.end());
+    ASSERT_EQ(fuse == 0, report.find("Int8") != report.end());
+    ASSERT_NE(report.end(), report.find("BFloat16"));
+  }
+  delete[] buffers;
+  ASSERT_EQ(3U, results[1].size());
+  ASSERT_EQ("Float16*", results[1]["Float16"]->Format()->Id());
+  ASSERT_EQ("BFloat16*", results[1]["BFloat16"]->Format()->Id());
+  for (auto& feature : results[0]) {
+    auto& actual = results[1][feature.first];
+    ASSERT_EQ(feature.second->Count(), actual->Count());
+    size_t size = feature.second->Format()->UnalignedSizeInBytes();
+    ASSERT_EQ(size, actual->Format()->UnalignedSizeInBytes());
+    for (size_t i = 0; i < actual->Count(); i++) {
+      ASSERT_EQ(0, memcmp((*feature.second)[i], (*actual)[i], size))
+          << feature.first << " differs at " << i;
+    }
+  }
+}
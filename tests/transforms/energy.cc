@@ -0,0 +1,76 @@
+/*! @file energy.cc
+ *  @brief Tests for sound_feature_extraction::transforms::Energy16.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+
+#include <cstdlib>
+#include "src/transforms/energy.h"
+#include "tests/transforms/transform_test.h"
+
+using sound_feature_extraction::transforms::Energy16;
+using sound_feature_extraction::InstructionSet;
+
+class Energy16Test : public TransformTest<Energy16> {
+ public:
+  int Size;
+
+  virtual void SetUp() {
+    Size = 1000;
+    SetUpTransform(2, Size, 16000);
+    for (int i = 0; i < Size; i++) {
+      (*Input)[0][i] = (i * 7919) % 65536 - 32768;
+      (*Input)[1][i] = -32768;
+    }
+  }
+};
+
+TEST_F(Energy16Test, Do) {
+  for (int b = 0; b < 2; b++) {
+    int64_t reference = 0;
+    for (int i = 0; i < Size; i++) {
+      reference += static_cast<int64_t>((*Input)[b][i]) * (*Input)[b][i];
+    }
+    for (int isa = 0; isa <= static_cast<int>(InstructionSet::kAVX512);
+         isa++) {
+      if (!IsSupported(static_cast<InstructionSet>(isa))) {
+        continue;
+      }
+      set_max_instruction_set(static_cast<InstructionSet>(isa));
+      Do((*Input)[b], &(*Output)[b]);
+      ASSERT_FLOAT_EQ(static_cast<float>(reference) / Size, (*Output)[b])
+          << b << " " << isa;
+    }
+    set_use_simd(false);
+    Do((*Input)[b], &(*Output)[b]);
+    ASSERT_FLOAT_EQ(static_cast<float>(reference) / Size, (*Output)[b]);
+    set_use_simd(true);
+  }
+  set_max_instruction_set(InstructionSet::kAVX512);
+}
@@ -31,6 +31,7 @@
 
 
 #include "src/transforms/filter_bank.h"
+#include <vector>
 #include "tests/transforms/transform_test.h"
 
 using sound_feature_extraction::formats::ArrayFormatF;
@@ -133,6 +134,40 @@ TEST_F(FilterBankTest, Do) {
 }
 
 
+class FilterBankBlocksTest : public TransformTest<FilterBank> {
+ public:
+  static constexpr int Size = 513;
+  static constexpr int Count = 2 * kFramesBlock + 3;
+
+  virtual void SetUp() {
+    set_number(40);
+    SetUpTransform(Count, Size, 16000);
+    for (int f = 0; f < Count; f++) {
+      for (int i = 0; i < Size; i++) {
+        (*Input)[f][i] = (f + 1) * ((i * 7) % 13 + 1);
+      }
+    }
+  }
+};
+
+constexpr int FilterBankBlocksTest::Size;
+constexpr int FilterBankBlocksTest::Count;
+
+TEST_F(FilterBankBlocksTest, Do) {
+  for (int i = 1; i < number(); i++) {
+    ASSERT_EQ(0, (filter_bank()[i].data - filter_bank()[0].data) %
+                 kRowAlignment);
+  }
+  Do(*Input, Output.get());
+  std::vector<float> frame(number());
+  for (int f = 0; f < Count; f++) {
+    Do((*Input)[f], frame.data());
+    for (int i = 0; i < number(); i++) {
+      ASSERT_NEAR(frame[i], (*Output)[f][i], frame[i] / 100000) << f << " " << i;
+    }
+  }
+}
+
 class ScaleTest : public ::testing::TestWithParam<std::tuple<ScaleType, float>>,
                   public FilterBank {
  protected:
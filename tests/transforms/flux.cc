@@ -64,6 +64,35 @@ TEST_F(FluxTest, Do) {
   EXPECT_NEAR(res, (*Output)[1], res / 10000);
 }
 
+TEST_F(FluxTest, FixedLength) {
+  for (int size : { 129, 257, 513 }) {
+    SetUpTransform(2, size, 18000);
+    for (int i = 0; i < size; i++) {
+      (*Input)[0][i] = i;
+      (*Input)[1][i] = i + 1;
+    }
+    Do((*Input), &(*Output));
+    float res = Do(false, (*Input)[1], size, (*Input)[0]);
+    EXPECT_NEAR(res, (*Output)[1], res / 10000) << size;
+  }
+}
+
+TEST_F(FluxTest, Parallel) {
+  const int count = 203;
+  SetUpTransform(count, Size, 18000);
+  for (int j = 0; j < count; j++) {
+    for (int i = 0; i < Size; i++) {
+      (*Input)[j][i] = (i * (j + 3)) % 17 + j;
+    }
+  }
+  Do((*Input), &(*Output));
+  for (int j = 1; j < count; j++) {
+    float res = Do(true, (*Input)[j], Size, (*Input)[j - 1]);
+    ASSERT_NEAR(res, (*Output)[j], res / 10000) << j;
+  }
+  ASSERT_EQ((*Output)[1], (*Output)[0]);
+}
+
 const float extra_param[FluxTest::Size] = { 0.f };
 
 #define CLASS_NAME FluxTest
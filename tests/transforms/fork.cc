@@ -53,3 +53,13 @@ TEST_F(ForkTest, Forward) {
   Do((*Input), &(*Output));
   ASSERT_EQ((*Input).Count() * kDefaultFactor, (*Output).Count());
 }
+
+TEST_F(ForkTest, StreamingStores) {
+  set_streaming_stores(true);
+  Do((*Input), &(*Output));
+  for (size_t i = 0; i < (*Output).Count(); i++) {
+    for (int j = 0; j < Size; j++) {
+      ASSERT_EQ((*Input)[0][j], (*Output)[i][j]);
+    }
+  }
+}
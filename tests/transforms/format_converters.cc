@@ -0,0 +1,372 @@
+/*! @file format_converters.cc
+ *  @brief Tests for the format converters.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "src/formats/float_to_float16.h"
+#include "src/formats/float_to_int16.h"
+#include "src/formats/float_to_int32.h"
+#include "src/formats/int16_to_float.h"
+#include "src/formats/int16_to_int32.h"
+#include "src/formats/int32_to_float.h"
+#include "src/formats/int32_to_int16.h"
+#include "tests/transforms/transform_test.h"
+
+using sound_feature_extraction::formats::FloatToBFloat16Raw;
+using sound_feature_extraction::formats::FloatToFloat16Raw;
+using sound_feature_extraction::formats::FloatToInt16Raw;
+using sound_feature_extraction::formats::FloatToInt32Raw;
+using sound_feature_extraction::formats::Int16ToFloatRaw;
+using sound_feature_extraction::formats::Int16ToInt32Raw;
+using sound_feature_extraction::formats::Int32ToFloatRaw;
+using sound_feature_extraction::formats::Int32ToInt16Raw;
+using sound_feature_extraction::InstructionSet;
+
+class Int16ToFloatTest : public TransformTest<Int16ToFloatRaw> {
+ public:
+  int Size;
+
+  virtual void SetUp() {
+    Size = 487;
+    SetUpTransform(1, Size, 16000);
+    for (int i = 0; i < Size; i++) {
+      (*Input)[0][i] = (i * 7919) % 65536 - 32768;
+    }
+  }
+};
+
+TEST_F(Int16ToFloatTest, InstructionSets) {
+  for (int isa = 0; isa <= static_cast<int>(InstructionSet::kAVX512); isa++) {
+    if (!IsSupported(static_cast<InstructionSet>(isa))) {
+      continue;
+    }
+    set_max_instruction_set(static_cast<InstructionSet>(isa));
+    ASSERT_LE(SimdInstructionSet(), static_cast<InstructionSet>(isa));
+    Do((*Input)[0], (*Output)[0]);
+    for (int i = 0; i < Size; i++) {
+      ASSERT_EQ((*Input)[0][i], (*Output)[0][i]) << isa << " " << i;
+    }
+  }
+  set_max_instruction_set(InstructionSet::kAVX512);
+}
+
+TEST_F(Int16ToFloatTest, DoWidening) {
+  for (int isa = 0; isa <= static_cast<int>(InstructionSet::kAVX512); isa++) {
+    if (!IsSupported(static_cast<InstructionSet>(isa))) {
+      continue;
+    }
+    set_max_instruction_set(static_cast<InstructionSet>(isa));
+    DoWidening((*Input)[0], Size, 1.f / 32768, 0.5f, (*Output)[0]);
+    for (int i = 0; i < Size; i++) {
+      ASSERT_EQ((*Input)[0][i] / 32768.f + 0.5f, (*Output)[0][i])
+          << isa << " " << i;
+    }
+  }
+  set_max_instruction_set(InstructionSet::kAVX512);
+}
+
+class Int16ToInt32Test : public TransformTest<Int16ToInt32Raw> {
+ public:
+  int Size;
+
+  virtual void SetUp() {
+    Size = 487;
+    SetUpTransform(1, Size, 16000);
+    for (int i = 0; i < Size; i++) {
+      (*Input)[0][i] = (i * 7919) % 65536 - 32768;
+    }
+  }
+};
+
+TEST_F(Int16ToInt32Test, InstructionSets) {
+  for (int isa = 0; isa <= static_cast<int>(InstructionSet::kAVX512); isa++) {
+    if (!IsSupported(static_cast<InstructionSet>(isa))) {
+      continue;
+    }
+    set_max_instruction_set(static_cast<InstructionSet>(isa));
+    ASSERT_LE(SimdInstructionSet(), static_cast<InstructionSet>(isa));
+    Do((*Input)[0], (*Output)[0]);
+    for (int i = 0; i < Size; i++) {
+      ASSERT_EQ((*Input)[0][i], (*Output)[0][i]) << isa << " " << i;
+    }
+  }
+  set_max_instruction_set(InstructionSet::kAVX512);
+}
+
+class Int32ToInt16Test : public TransformTest<Int32ToInt16Raw> {
+ public:
+  int Size;
+
+  virtual void SetUp() {
+    Size = 487;
+    SetUpTransform(1, Size, 16000);
+    // The edges check the saturation
+    for (int i = 0; i < Size; i++) {
+      (*Input)[0][i] = (i - Size / 2) * 150;
+    }
+  }
+};
+
+TEST_F(Int32ToInt16Test, InstructionSets) {
+  for (int isa = 0; isa <= static_cast<int>(InstructionSet::kAVX512); isa++) {
+    if (!IsSupported(static_cast<InstructionSet>(isa))) {
+      continue;
+    }
+    set_max_instruction_set(static_cast<InstructionSet>(isa));
+    ASSERT_LE(SimdInstructionSet(), static_cast<InstructionSet>(isa));
+    Do((*Input)[0], (*Output)[0]);
+    for (int i = 0; i < Size; i++) {
+      int value = (*Input)[0][i];
+      ASSERT_EQ(std::max(-32768, std::min(32767, value)), (*Output)[0][i])
+          << isa << " " << i;
+    }
+  }
+  set_max_instruction_set(InstructionSet::kAVX512);
+}
+
+class Int32ToFloatTest : public TransformTest<Int32ToFloatRaw> {
+ public:
+  int Size;
+
+  virtual void SetUp() {
+    Size = 487;
+    SetUpTransform(1, Size, 16000);
+    for (int i = 0; i < Size; i++) {
+      (*Input)[0][i] = (i - Size / 2) * 1000003;
+    }
+  }
+};
+
+TEST_F(Int32ToFloatTest, InstructionSets) {
+  for (int isa = 0; isa <= static_cast<int>(InstructionSet::kAVX512); isa++) {
+    if (!IsSupported(static_cast<InstructionSet>(isa))) {
+      continue;
+    }
+    set_max_instruction_set(static_cast<InstructionSet>(isa));
+    ASSERT_LE(SimdInstructionSet(), static_cast<InstructionSet>(isa));
+    Do((*Input)[0], (*Output)[0]);
+    for (int i = 0; i < Size; i++) {
+      ASSERT_EQ(static_cast<float>((*Input)[0][i]), (*Output)[0][i])
+          << isa << " " << i;
+    }
+    DoWidening((*Input)[0], Size, 0.25f, -1, (*Output)[0]);
+    for (int i = 0; i < Size; i++) {
+      ASSERT_EQ(static_cast<float>((*Input)[0][i]) * 0.25f - 1,
+                (*Output)[0][i]) << isa << " " << i;
+    }
+  }
+  set_max_instruction_set(InstructionSet::kAVX512);
+}
+
+class FloatToInt32Test : public TransformTest<FloatToInt32Raw> {
+ public:
+  int Size;
+
+  virtual void SetUp() {
+    Size = 487;
+    SetUpTransform(1, Size, 16000);
+    // Halves check the rounding to even, the edges check the saturation
+    for (int i = 0; i < Size; i++) {
+      (*Input)[0][i] = (i - Size / 2) * 0.5f;
+    }
+    (*Input)[0][0] = -1e10f;
+    (*Input)[0][Size - 1] = 1e10f;
+  }
+};
+
+TEST_F(FloatToInt32Test, InstructionSets) {
+  set_max_instruction_set(InstructionSet::kScalar);
+  Do((*Input)[0], (*Output)[0]);
+  std::vector<int32_t> reference((*Output)[0], (*Output)[0] + Size);
+  ASSERT_EQ(-2147483647 - 1, reference.front());
+  ASSERT_EQ(2147483520, reference.back());
+  ASSERT_EQ(0, reference[Size / 2 + 1]);
+  ASSERT_EQ(2, reference[Size / 2 + 3]);
+  ASSERT_EQ(-2, reference[Size / 2 - 3]);
+  for (int isa = 0; isa <= static_cast<int>(InstructionSet::kAVX512); isa++) {
+    if (!IsSupported(static_cast<InstructionSet>(isa))) {
+      continue;
+    }
+    set_max_instruction_set(static_cast<InstructionSet>(isa));
+    ASSERT_LE(SimdInstructionSet(), static_cast<InstructionSet>(isa));
+    Do((*Input)[0], (*Output)[0]);
+    for (int i = 0; i < Size; i++) {
+      ASSERT_EQ(reference[i], (*Output)[0][i]) << isa << " " << i;
+    }
+  }
+  set_max_instruction_set(InstructionSet::kAVX512);
+}
+
+class FloatToInt16Test : public TransformTest<FloatToInt16Raw> {
+ public:
+  int Size;
+
+  virtual void SetUp() {
+    Size = 487;
+    SetUpTransform(1, Size, 16000);
+    // Halves check the rounding to even, the edges check the saturation
+    for (int i = 0; i < Size; i++) {
+      (*Input)[0][i] = (i - Size / 2) * 150.5f;
+    }
+  }
+};
+
+TEST_F(FloatToInt16Test, InstructionSets) {
+  set_max_instruction_set(InstructionSet::kScalar);
+  Do((*Input)[0], (*Output)[0]);
+  std::vector<int16_t> reference((*Output)[0], (*Output)[0] + Size);
+  ASSERT_EQ(-32768, reference.front());
+  ASSERT_EQ(32767, reference.back());
+  ASSERT_EQ(150, reference[Size / 2 + 1]);
+  ASSERT_EQ(452, reference[Size / 2 + 3]);
+  for (int isa = 0; isa <= static_cast<int>(InstructionSet::kAVX512); isa++) {
+    if (!IsSupported(static_cast<InstructionSet>(isa))) {
+      continue;
+    }
+    set_max_instruction_set(static_cast<InstructionSet>(isa));
+    ASSERT_LE(SimdInstructionSet(), static_cast<InstructionSet>(isa));
+    Do((*Input)[0], (*Output)[0]);
+    for (int i = 0; i < Size; i++) {
+      ASSERT_EQ(reference[i], (*Output)[0][i]) << isa << " " << i;
+    }
+  }
+  set_max_instruction_set(InstructionSet::kAVX512);
+}
+
+class FloatToFloat16Test : public TransformTest<FloatToFloat16Raw> {
+ public:
+  int Size;
+
+  virtual void SetUp() {
+    Size = 487;
+    SetUpTransform(1, Size, 16000);
+    // Covers the subnormals, the normals and the overflows
+    for (int i = 0; i < Size; i++) {
+      (*Input)[0][i] = (i % 2? -1 : 1) * powf(2.f, (i - Size / 2) * 0.13f) *
+          (1 + i * 1e-3f);
+    }
+    (*Input)[0][0] = 1.f;
+    (*Input)[0][1] = 65504.f;
+    (*Input)[0][2] = 65520.f;
+    (*Input)[0][3] = 1e-7f;
+    (*Input)[0][4] = -2.f;
+    (*Input)[0][5] = 0.f;
+    // The halfway between 1 and the next binary16, rounds to even
+    (*Input)[0][6] = 1.f + 1.f / 2048;
+  }
+};
+
+TEST_F(FloatToFloat16Test, Values) {
+  set_max_instruction_set(InstructionSet::kScalar);
+  Do((*Input)[0], (*Output)[0]);
+  auto out = (*Output)[0];
+  ASSERT_EQ(0x3C00, out[0].Bits);
+  ASSERT_EQ(0x7BFF, out[1].Bits);
+  ASSERT_EQ(0x7C00, out[2].Bits);
+  ASSERT_EQ(0x0002, out[3].Bits);
+  ASSERT_EQ(0xC000, out[4].Bits);
+  ASSERT_EQ(0, out[5].Bits);
+  ASSERT_EQ(0x3C00, out[6].Bits);
+  for (int i = 7; i < Size; i++) {
+    float value = (*Input)[0][i];
+    if (fabsf(value) >= 6.1e-5f && fabsf(value) < 65504) {
+      ASSERT_NEAR(value, out[i], fabsf(value) / 2048) << i;
+    }
+  }
+  set_max_instruction_set(InstructionSet::kAVX512);
+}
+
+TEST_F(FloatToFloat16Test, InstructionSets) {
+  set_max_instruction_set(InstructionSet::kScalar);
+  Do((*Input)[0], (*Output)[0]);
+  std::vector<uint16_t> reference(Size);
+  for (int i = 0; i < Size; i++) {
+    reference[i] = (*Output)[0][i].Bits;
+  }
+  for (int isa = 0; isa <= static_cast<int>(InstructionSet::kAVX512); isa++) {
+    if (!IsSupported(static_cast<InstructionSet>(isa))) {
+      continue;
+    }
+    set_max_instruction_set(static_cast<InstructionSet>(isa));
+    ASSERT_LE(SimdInstructionSet(), static_cast<InstructionSet>(isa));
+    Do((*Input)[0], (*Output)[0]);
+    for (int i = 0; i < Size; i++) {
+      ASSERT_EQ(reference[i], (*Output)[0][i].Bits) << isa << " " << i;
+    }
+  }
+  set_max_instruction_set(InstructionSet::kAVX512);
+}
+
+class FloatToBFloat16Test : public TransformTest<FloatToBFloat16Raw> {
+ public:
+  int Size;
+
+  virtual void SetUp() {
+    Size = 487;
+    SetUpTransform(1, Size, 16000);
+    for (int i = 0; i < Size; i++) {
+      (*Input)[0][i] = (i % 2? -1 : 1) * powf(2.f, (i - Size / 2) * 0.5f) *
+          (1 + i * 1e-3f);
+    }
+    (*Input)[0][0] = 1.f;
+    // The halfway between 1 and the next bfloat16, rounds to even
+    (*Input)[0][1] = 1.f + 1.f / 256;
+    (*Input)[0][2] = 1.f + 3.f / 256;
+    (*Input)[0][3] = -3.f;
+  }
+};
+
+TEST_F(FloatToBFloat16Test, InstructionSets) {
+  set_max_instruction_set(InstructionSet::kScalar);
+  Do((*Input)[0], (*Output)[0]);
+  std::vector<uint16_t> reference(Size);
+  for (int i = 0; i < Size; i++) {
+    reference[i] = (*Output)[0][i].Bits;
+    float value = (*Input)[0][i];
+    ASSERT_NEAR(value, (*Output)[0][i], fabsf(value) / 256) << i;
+  }
+  ASSERT_EQ(0x3F80, reference[0]);
+  ASSERT_EQ(0x3F80, reference[1]);
+  ASSERT_EQ(0x3F82, reference[2]);
+  ASSERT_EQ(0xC040, reference[3]);
+  for (int isa = 0; isa <= static_cast<int>(InstructionSet::kAVX512); isa++) {
+    if (!IsSupported(static_cast<InstructionSet>(isa))) {
+      continue;
+    }
+    set_max_instruction_set(static_cast<InstructionSet>(isa));
+    ASSERT_LE(SimdInstructionSet(), static_cast<InstructionSet>(isa));
+    Do((*Input)[0], (*Output)[0]);
+    for (int i = 0; i < Size; i++) {
+      ASSERT_EQ(reference[i], (*Output)[0][i].Bits) << isa << " " << i;
+    }
+  }
+  set_max_instruction_set(InstructionSet::kAVX512);
+}
@@ -35,6 +35,7 @@
 using sound_feature_extraction::formats::ArrayFormatF;
 using sound_feature_extraction::BuffersBase;
 using sound_feature_extraction::transforms::FrequencyBands;
+using sound_feature_extraction::InstructionSet;
 
 class FrequencyBandsTest : public TransformTest<FrequencyBands> {
  public:
@@ -77,3 +78,111 @@ TEST_F(FrequencyBandsTest, InvalidBands) {
     set_bands("2000 15000 8000");
   }, sound_feature_extraction::InvalidParameterValueException);
 }
+
+TEST_F(FrequencyBandsTest, Parallel) {
+  const int bands = 20, windows = 3;
+  set_number(bands);
+  SetUpTransform(bands * windows, Size, 16000);
+  for (int w = 0; w < windows; w++) {
+    for (int i = 0; i < Size; i++) {
+      for (int b = 0; b < bands; b++) {
+        (*Input)[w * bands + b][i] = sinf(i / (10.f + w)) + (i % 7) / 7.f;
+      }
+    }
+  }
+  // DSPFilters calculates the reference
+  set_max_instruction_set(InstructionSet::kScalar);
+  Do((*Input), &(*Output));
+  std::vector<std::vector<float>> reference(bands * windows);
+  for (int i = 0; i < bands * windows; i++) {
+    reference[i].assign((*Output)[i], (*Output)[i] + Size);
+  }
+  set_parallel(true);
+  Initialize();
+  for (int isa = 0; isa <= static_cast<int>(InstructionSet::kAVX512);
+       isa++) {
+    if (!IsSupported(static_cast<InstructionSet>(isa))) {
+      continue;
+    }
+    set_max_instruction_set(static_cast<InstructionSet>(isa));
+    Do((*Input), &(*Output));
+    for (int i = 0; i < bands * windows; i++) {
+      for (int j = 0; j < Size; j++) {
+        ASSERT_NEAR(reference[i][j], (*Output)[i][j],
+                    fabsf(reference[i][j]) * 1e-4f + 1e-5f)
+            << isa << " " << i << " " << j;
+      }
+    }
+  }
+  set_max_instruction_set(InstructionSet::kAVX512);
+}
+
+TEST_F(FrequencyBandsTest, Lanes) {
+  // The incomplete last window is filtered as well
+  const int bands = 5, count = bands * 19 + 3;
+  set_number(bands);
+  SetUpTransform(count, Size, 16000);
+  for (int i = 0; i < count; i++) {
+    for (int j = 0; j < Size; j++) {
+      (*Input)[i][j] = sinf(j / (10.f + i)) + (j % 5) / 5.f;
+    }
+  }
+  set_max_instruction_set(InstructionSet::kScalar);
+  Do((*Input), &(*Output));
+  std::vector<std::vector<float>> reference(count);
+  for (int i = 0; i < count; i++) {
+    reference[i].assign((*Output)[i], (*Output)[i] + Size);
+  }
+  for (int isa = 0; isa <= static_cast<int>(InstructionSet::kAVX512);
+       isa++) {
+    if (!IsSupported(static_cast<InstructionSet>(isa))) {
+      continue;
+    }
+    set_max_instruction_set(static_cast<InstructionSet>(isa));
+    Do((*Input), &(*Output));
+    for (int i = 0; i < count; i++) {
+      for (int j = 0; j < Size; j++) {
+        ASSERT_NEAR(reference[i][j], (*Output)[i][j],
+                    fabsf(reference[i][j]) * 1e-4f + 1e-5f)
+            << isa << " " << i << " " << j;
+      }
+    }
+  }
+  set_max_instruction_set(InstructionSet::kAVX512);
+}
+
+TEST_F(FrequencyBandsTest, Decimation) {
+  const int bands = 4;
+  set_number(bands);
+  SetUpTransform(bands, Size, 16000);
+  for (int b = 0; b < bands; b++) {
+    for (int i = 0; i < Size; i++) {
+      (*Input)[b][i] = sinf(i / 10.f) + (i % 7) / 7.f;
+    }
+  }
+  Do((*Input), &(*Output));
+  std::vector<std::vector<float>> reference(bands);
+  for (int b = 0; b < bands; b++) {
+    reference[b].assign((*Output)[b], (*Output)[b] + Size);
+  }
+  // Each 2 kHz wide band lies within a single Nyquist zone of 4 kHz
+  set_decimation(4);
+  RecreateOutputBuffers();
+  Initialize();
+  ASSERT_EQ(4, decimation_factor());
+  ASSERT_EQ(static_cast<size_t>(Size / 4), output_format_->Size());
+  ASSERT_EQ(4000, output_format_->SamplingRate());
+  Do((*Input), &(*Output));
+  for (int b = 0; b < bands; b++) {
+    for (int i = 0; i < Size / 4; i++) {
+      ASSERT_FLOAT_EQ(reference[b][i * 4], (*Output)[b][i]) << b << " " << i;
+    }
+  }
+  // 4 is also the largest factor which does not alias
+  set_decimation(0);
+  RecreateOutputBuffers();
+  ASSERT_EQ(4, decimation_factor());
+  set_bands("4000");
+  RecreateOutputBuffers();
+  ASSERT_EQ(2, decimation_factor());
+}
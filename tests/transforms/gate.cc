@@ -0,0 +1,148 @@
+/*! @file gate.cc
+ *  @brief Tests for sound_feature_extraction::transforms::Gate.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <vector>
+#include "src/transform_tree.h"
+#include "src/transforms/gate.h"
+#include "tests/speech_sample.inc"
+#include "tests/transforms/transform_test.h"
+
+using sound_feature_extraction::transforms::Gate;
+using sound_feature_extraction::Buffers;
+using sound_feature_extraction::TransformTree;
+using sound_feature_extraction::UngateableTransformException;
+
+class GateTest : public TransformTest<Gate> {
+ public:
+  int Size;
+  int Count;
+
+  virtual void SetUp() {
+    Size = 256;
+    Count = 6;
+    SetUpTransform(Count, Size, 16000);
+    // The odd frames are silent
+    for (int j = 0; j < Count; j++) {
+      for (int i = 0; i < Size; i++) {
+        (*Input)[j][i] = j % 2 == 0? (j + 1) * (i % 7 - 3.f) : 0.01f;
+      }
+    }
+    set_threshold(1);
+  }
+};
+
+TEST_F(GateTest, Do) {
+  for (int j = 0; j < Count; j++) {
+    Do((*Input)[j], (*Output)[j]);
+    for (int i = 0; i < Size; i++) {
+      ASSERT_EQ((*Input)[j][i], (*Output)[j][i]) << j << " " << i;
+    }
+  }
+}
+
+TEST_F(GateTest, Select) {
+  uint32_t selected[6];
+  ASSERT_EQ(3u, Select(*Input, selected, Output.get()));
+  for (int j = 0; j < 3; j++) {
+    ASSERT_EQ(j * 2u, selected[j]);
+    for (int i = 0; i < Size; i++) {
+      ASSERT_EQ((*Input)[j * 2][i], (*Output)[j][i]) << j << " " << i;
+    }
+  }
+  set_threshold(1000);
+  ASSERT_EQ(0u, Select(*Input, selected, Output.get()));
+}
+
+TEST(Gate, MFCC) {
+  int16_t* buffers = new int16_t[48000];
+  memcpy(buffers, data, sizeof(data));
+  TransformTree plain( { 48000, 16000 } );  // NOLINT(*)
+  plain.AddFeature("Energy", { { "Window", "length=512" }, { "Energy", "" } });
+  plain.AddFeature("MFCC", { { "Window", "length=512" }, { "RDFT", "" },
+      { "SpectralEnergy", "" }, { "FilterBank", "" }, { "Log", "" },
+      { "DCT", "" } });
+  plain.PrepareForExecution();
+  auto expected = plain.Execute(buffers);
+  auto& energy = *expected["Energy"];
+  std::vector<float> energies(energy.Count());
+  for (size_t i = 0; i < energies.size(); i++) {
+    energies[i] = *reinterpret_cast<const float*>(energy[i]);
+  }
+  std::nth_element(energies.begin(), energies.begin() + energies.size() / 2,
+                   energies.end());
+  float threshold = energies[energies.size() / 2];
+  auto& mfcc = *expected["MFCC"];
+  size_t length = mfcc.Format()->UnalignedSizeInBytes() / sizeof(float);
+  auto check = [&](const Buffers& gated) {
+    ASSERT_EQ(mfcc.Count(), gated.Count());
+    size_t passed = 0, skipped = 0;
+    for (size_t i = 0; i < gated.Count(); i++) {
+      auto actual = reinterpret_cast<const float*>(gated[i]);
+      if (*reinterpret_cast<const float*>(energy[i]) <= threshold) {
+        skipped++;
+        for (size_t j = 0; j < length; j++) {
+          ASSERT_EQ(-100.f, actual[j]) << i;
+        }
+        continue;
+      }
+      passed++;
+      auto reference = reinterpret_cast<const float*>(mfcc[i]);
+      for (size_t j = 0; j < length; j++) {
+        ASSERT_NEAR(reference[j], actual[j],
+                    std::max(fabsf(reference[j]) * 1e-4f, 1e-4f)) << i;
+      }
+    }
+    ASSERT_GT(passed, 0U);
+    ASSERT_GT(skipped, 0U);
+  };
+  auto gate = "threshold=" + std::to_string(threshold) + ",fill=-100";
+  for (bool parallel : { false, true }) {
+    TransformTree tt( { 48000, 16000 } );  // NOLINT(*)
+    tt.set_validate_after_each_transform(true);
+    tt.set_parallel_execution(parallel);
+    tt.AddFeature("MFCC", { { "Window", "length=512" }, { "Gate", gate },
+        { "RDFT", "" }, { "SpectralEnergy", "" }, { "FilterBank", "" },
+        { "Log", "" }, { "DCT", "" } });
+    tt.PrepareForExecution();
+    check(*tt.Execute(buffers).at("MFCC"));
+    auto context = tt.CreateExecutionContext();
+    check(*tt.Execute(buffers, context.get()).at("MFCC"));
+    check(*tt.Execute(buffers).at("MFCC"));
+  }
+  delete[] buffers;
+  TransformTree delta( { 48000, 16000 } );  // NOLINT(*)
+  delta.AddFeature("Delta", { { "Window", "length=512" }, { "Gate", gate },
+      { "Delta", "" } });
+  ASSERT_THROW(delta.PrepareForExecution(), UngateableTransformException);
+}
@@ -29,12 +29,15 @@
  */
 
 #include <cmath>
+#include <vector>
 #include "src/transforms/log.h"
 #include "tests/transforms/transform_test.h"
 
 using sound_feature_extraction::formats::ArrayFormatF;
 using sound_feature_extraction::BuffersBase;
 using sound_feature_extraction::transforms::LogRaw;
+using sound_feature_extraction::transforms::LogarithmBase;
+using sound_feature_extraction::InstructionSet;
 
 class LogTest : public TransformTest<LogRaw> {
  public:
@@ -82,6 +85,58 @@ TEST_F(LogTest, DoBare) {
   }
 }
 
+TEST_F(LogTest, DoFast) {
+  set_precision(sound_feature_extraction::transforms::Precision::kFast);
+  for (auto base : { LogarithmBase::kE, LogarithmBase::k2,
+                     LogarithmBase::k10 }) {
+    set_base(base);
+    for (bool simd : { false, true }) {
+      set_use_simd(simd);
+      Do((*Input)[0], (*Output)[0]);
+      for (int i = 0; i < Size; i++) {
+        double x = (i + Size / 2.0) / Size + 1;
+        double vlog = base == LogarithmBase::kE? log(x) :
+            base == LogarithmBase::k2? log2(x) : log10(x);
+        ASSERT_NEAR(vlog, (*Output)[0][i], 1e-6) << simd << " " << i;
+      }
+    }
+  }
+}
+
+TEST_F(LogTest, InstructionSets) {
+  set_use_simd(false);
+  Do((*Input)[0], (*Output)[0]);
+  std::vector<float> reference((*Output)[0], (*Output)[0] + Size);
+  set_use_simd(true);
+  for (int isa = 0; isa <= static_cast<int>(InstructionSet::kAVX512); isa++) {
+    if (!IsSupported(static_cast<InstructionSet>(isa))) {
+      continue;
+    }
+    set_max_instruction_set(static_cast<InstructionSet>(isa));
+    ASSERT_LE(SimdInstructionSet(), static_cast<InstructionSet>(isa));
+    Do((*Input)[0], (*Output)[0]);
+    for (int i = 0; i < Size; i++) {
+      ASSERT_NEAR(reference[i], (*Output)[0][i],
+                  std::abs(reference[i]) * 1e-6f + 1e-7f) << isa << " " << i;
+    }
+  }
+  set_max_instruction_set(InstructionSet::kAVX512);
+}
+
+TEST_F(LogTest, FixedLength) {
+  for (int size : { 256, 257, 512, 1024 }) {
+    SetUpTransform(1, size, 18000);
+    for (int i = 0; i < size; i++) {
+      (*Input)[0][i] = (i + size / 2.0f) / size;
+    }
+    Do((*Input)[0], (*Output)[0]);
+    for (int i = 0; i < size; i++) {
+      float vlog = logf((i + size / 2.0f) / size + 1);
+      ASSERT_EQF(vlog, (*Output)[0][i]) << size << " " << i;
+    }
+  }
+}
+
 #define CLASS_NAME LogTest
 #include "tests/transforms/benchmark.inc"
 
@@ -28,7 +28,9 @@
  *  under the License.
  */
 
+#include <cmath>
 #include <fstream>
+#include <vector>
 #include "src/transforms/lowpass_filter.h"
 #include "tests/transforms/transform_test.h"
 #include "src/primitives/window.h"
@@ -39,6 +41,7 @@
 #define ASSERT_EQF(a, b) ASSERT_NEAR(a, b, EPSILON)
 
 using sound_feature_extraction::transforms::LowpassFilter;
+using sound_feature_extraction::InstructionSet;
 
 class LowpassFilterTest : public TransformTest<LowpassFilter> {
  public:
@@ -65,3 +68,61 @@ TEST_F(LowpassFilterTest, CalculateLowpassFilter) {
   fs << "]\n";
   */
 }
+
+TEST_F(LowpassFilterTest, Lanes) {
+  // Two complete groups of lanes on AVX and an incomplete one
+  const int count = 19;
+  SetUpTransform(count, Size, 5000);
+  for (int i = 0; i < count; i++) {
+    for (size_t j = 0; j < Size; j++) {
+      (*Input)[i][j] = data_signal[(j + i * 7) % Size] * (1 + i * 0.1f);
+    }
+  }
+  set_max_instruction_set(InstructionSet::kScalar);
+  ASSERT_EQ(1, BufferLanes());
+  Do((*Input), &(*Output));
+  std::vector<std::vector<float>> reference(count);
+  for (int i = 0; i < count; i++) {
+    reference[i].assign((*Output)[i], (*Output)[i] + Size);
+  }
+  for (int isa = 0; isa <= static_cast<int>(InstructionSet::kAVX512);
+       isa++) {
+    if (!IsSupported(static_cast<InstructionSet>(isa))) {
+      continue;
+    }
+    set_max_instruction_set(static_cast<InstructionSet>(isa));
+    Do((*Input), &(*Output));
+    for (int i = 0; i < count; i++) {
+      for (size_t j = 0; j < Size; j++) {
+        ASSERT_NEAR(reference[i][j], (*Output)[i][j],
+                    fabsf(reference[i][j]) * 1e-4f + 1e-4f)
+            << isa << " " << i << " " << j;
+      }
+    }
+  }
+  set_max_instruction_set(InstructionSet::kAVX512);
+}
+
+TEST_F(LowpassFilterTest, Segments) {
+  set_min_segment_length(0);
+  Initialize();
+  ASSERT_EQ(1, Segments());
+  Do((*Input), &(*Output));
+  std::vector<float> reference((*Output)[0], (*Output)[0] + 10 * Size);
+  set_threads_number(4);
+  set_min_segment_length(Size);
+  Initialize();
+  ASSERT_EQ(4, Segments());
+  Do((*Input), &(*Output));
+  for (size_t i = 0; i < reference.size(); i++) {
+    ASSERT_NEAR(reference[i], (*Output)[0][i],
+                fabsf(reference[i]) * 1e-4f + 1e-4f) << i;
+  }
+  // In place
+  memcpy((*Output)[0], (*Input)[0], 10 * Size * sizeof(float));
+  FilterSegments((*Output)[0], (*Output)[0]);
+  for (size_t i = 0; i < reference.size(); i++) {
+    ASSERT_NEAR(reference[i], (*Output)[0][i],
+                fabsf(reference[i]) * 1e-4f + 1e-4f) << i;
+  }
+}
@@ -0,0 +1,71 @@
+/*! @file lpc.cc
+ *  @brief Tests for sound_feature_extraction::transforms::LPC.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+#include <cmath>
+#include <vector>
+#include "src/primitives/lpc.h"
+#include "src/transforms/lpc.h"
+#include "tests/transforms/transform_test.h"
+
+using sound_feature_extraction::formats::ArrayFormatF;
+using sound_feature_extraction::BuffersBase;
+using sound_feature_extraction::transforms::LPC;
+
+class LPCTest : public TransformTest<LPC> {
+ public:
+  int Size;
+  int Count;
+
+  virtual void SetUp() {
+    Size = 13;
+    Count = 150;
+    SetUpTransform(Count, Size, 16000);
+    for (int f = 0; f < Count; f++) {
+      for (int k = 0; k < Size; k++) {
+        (*Input)[f][k] = powf(0.9f - (f % 7) * 0.1f, k) + (k == 0);
+      }
+    }
+  }
+};
+
+TEST_F(LPCTest, Do) {
+  set_error(true);
+  RecreateOutputBuffers();
+  Do((*Input), &(*Output));
+  std::vector<float> lpc(Size - 1);
+  for (int f = 0; f < Count; f++) {
+    float error = ldr_lpc(false, (*Input)[f], Size, lpc.data());
+    ASSERT_NEAR(error, (*Output)[f][0], fabsf(error) * 1e-4f) << f;
+    for (int k = 0; k < Size - 1; k++) {
+      ASSERT_NEAR(lpc[k], (*Output)[f][k + 1], fabsf(lpc[k]) * 1e-4f + 1e-5f)
+          << f << " " << k;
+    }
+  }
+}
@@ -30,12 +30,18 @@
 
 
 #include <cmath>
+#include <unordered_map>
+#include <vector>
+#include "src/transform_tree.h"
 #include "src/transforms/lpc_cc.h"
+#include "tests/speech_sample.inc"
 #include "tests/transforms/transform_test.h"
 
 using sound_feature_extraction::formats::ArrayFormatF;
 using sound_feature_extraction::BuffersBase;
 using sound_feature_extraction::transforms::LPC2CC;
+using sound_feature_extraction::Buffers;
+using sound_feature_extraction::TransformTree;
 
 class LPC2CCTest : public TransformTest<LPC2CC> {
  public:
@@ -74,3 +80,81 @@ TEST_F(LPC2CCTest, Do) {
     ASSERT_NEAR(valid_cc[i], (*Output)[0][i], fabsf(valid_cc[i] / 100000));
   }
 }
+
+TEST_F(LPC2CCTest, DoBatch) {
+  const int count = 37;
+  SetUpTransform(count, Size, 18000);
+  set_size(Size + 5);
+  for (int t = 0; t < count; t++) {
+    for (int i = 0; i < Size; i++) {
+      (*Input)[t][i] = sinf(i + t * 0.1f) / (i + 1);
+    }
+    (*Input)[t][0] = 1 + t * 0.01f;
+  }
+  std::vector<float> expected(Size + 5);
+  for (bool simd : { false, true }) {
+    set_use_simd(simd);
+    Do((*Input), &(*Output));
+    for (int t = 0; t < count; t++) {
+      Do((*Input)[t], expected.data());
+      for (size_t i = 0; i < expected.size(); i++) {
+        ASSERT_NEAR(expected[i], (*Output)[t][i],
+                    fabsf(expected[i]) * 1e-5f + 1e-6f)
+            << simd << " " << t << " " << i;
+      }
+    }
+  }
+}
+
+TEST(LPC2CC, LPCFusion) {
+  std::unique_ptr<TransformTree> trees[2];
+  std::unordered_map<std::string, std::shared_ptr<Buffers>> results[2];
+  int16_t* buffers = new int16_t[48000];
+  memcpy(buffers, data, sizeof(data));
+  for (int fuse = 0; fuse < 2; fuse++) {
+    trees[fuse].reset(new TransformTree({ 48000, 16000 }));  // NOLINT(*)
+    auto& tt = *trees[fuse];
+    tt.set_fuse_transforms(fuse);
+    // The second half of the autocorrelation are the non-negative lags
+    tt.AddFeature("LPCC", { { "Window", "length=512" },
+        { "Autocorrelation", "" }, { "Selector", "length=512,from=right" },
+        { "Selector", "length=13" }, { "LPC", "" }, { "LPCtoCC", "" } });
+    tt.AddFeature("LPCCError", { { "Window", "length=512" },
+        { "Autocorrelation", "" }, { "Selector", "length=512,from=right" },
+        { "Selector", "length=13" }, { "LPC", "error=true" },
+        { "LPCtoCC", "size=20" } });
+    // LPC is a feature itself, so it must stay
+    tt.AddFeature("LPC", { { "Window", "length=512" },
+        { "Autocorrelation", "" }, { "Selector", "length=512,from=right" },
+        { "Selector", "length=17" }, { "LPC", "" } });
+    tt.AddFeature("LPCCShared", { { "Window", "length=512" },
+        { "Autocorrelation", "" }, { "Selector", "length=512,from=right" },
+        { "Selector", "length=17" }, { "LPC", "" }, { "LPCtoCC", "" } });
+    tt.PrepareForExecution();
+    results[fuse] = tt.Execute(buffers);
+    auto report = tt.ExecutionTimeReport();
+    ASSERT_EQ(fuse == 1, report.find("LPCC") != report.end());
+    ASSERT_NE(report.end(), report.find("LPC"));
+    ASSERT_NE(report.end(), report.find("LPCtoCC"));
+  }
+  delete[] buffers;
+  ASSERT_EQ(4U, results[1].size());
+  // The leading lags are calculated directly instead of through FFT
+  for (auto& feature : results[0]) {
+    auto& actual = results[1][feature.first];
+    ASSERT_EQ(feature.second->Count(), actual->Count());
+    size_t size = feature.second->Format()->UnalignedSizeInBytes() /
+        sizeof(float);
+    ASSERT_EQ(size, actual->Format()->UnalignedSizeInBytes() / sizeof(float));
+    for (size_t i = 0; i < actual->Count(); i++) {
+      auto expected_data = reinterpret_cast<const float*>(
+          (*feature.second)[i]);
+      auto actual_data = reinterpret_cast<const float*>((*actual)[i]);
+      for (size_t j = 0; j < size; j++) {
+        ASSERT_NEAR(expected_data[j], actual_data[j],
+                    std::abs(expected_data[j]) * 1e-3f + 1e-4f)
+            << feature.first << " differs at " << i << ", " << j;
+      }
+    }
+  }
+}
@@ -30,12 +30,14 @@
 
 
 #include <cmath>
+#include <vector>
 #include "src/transforms/mean.h"
 #include "tests/transforms/transform_test.h"
 
 using sound_feature_extraction::formats::ArrayFormatF;
 using sound_feature_extraction::formats::FixedArray;
 using sound_feature_extraction::BuffersBase;
+using sound_feature_extraction::formats::FieldColumn;
 using sound_feature_extraction::transforms::Mean;
 
 class MeanTest : public TransformTest<Mean> {
@@ -119,6 +121,29 @@ TEST_F(MeanTest, DoSimd) {
                 sound_feature_extraction::transforms::kMeanTypeGeometric));
 }
 
+TEST_F(MeanTest, DoFast) {
+  Do((*Input)[0], &(*Output)[0]);
+  float amean = ((*Output)[0])
+      [sound_feature_extraction::transforms::kMeanTypeArithmetic];
+  float gmean = ((*Output)[0])
+      [sound_feature_extraction::transforms::kMeanTypeGeometric];
+  set_precision(sound_feature_extraction::transforms::Precision::kFast);
+  for (bool simd : { false, true }) {
+    set_use_simd(simd);
+    Do((*Input)[0], &(*Output)[0]);
+    ASSERT_NEAR(amean, ((*Output)[0])
+        [sound_feature_extraction::transforms::kMeanTypeArithmetic],
+        amean * 1e-5f) << simd;
+    ASSERT_NEAR(gmean, ((*Output)[0])
+        [sound_feature_extraction::transforms::kMeanTypeGeometric],
+        gmean * 1e-5f) << simd;
+  }
+  (*Input)[0][Size / 2] = 0;
+  Do((*Input)[0], &(*Output)[0]);
+  ASSERT_EQ(0, ((*Output)[0])
+      [sound_feature_extraction::transforms::kMeanTypeGeometric]);
+}
+
 TEST_F(MeanTest, DoCase1) {
   float data[] {
        14.000000, 12.147677, 7.239147,  1.920708,  5.957093,  9.768391,
@@ -257,3 +282,29 @@ TEST_F(MeanTest, DoCase2) {
 #undef BENCH_NAME
 #define BENCH_NAME BenchmarkGeometric
 #include "tests/transforms/benchmark.inc"
+
+TEST_F(MeanTest, StructOfArrays) {
+  SetUpTransform(37, Size, 18000);
+  for (size_t i = 0; i < Input->Count(); i++) {
+    for (int j = 0; j < Size; j++) {
+      (*Input)[i][j] = (i + 1) * (j + 1);
+    }
+  }
+  ASSERT_TRUE(SupportsSoAOutput());
+  Do(*Input, Output.get());
+  std::vector<FixedArray<sound_feature_extraction::transforms::
+      kMeanTypeCount>> reference;
+  for (size_t i = 0; i < Output->Count(); i++) {
+    reference.push_back((*Output)[i]);
+  }
+  set_soa_output(true);
+  Do(*Input, Output.get());
+  set_soa_output(false);
+  for (int j = 0; j < sound_feature_extraction::transforms::kMeanTypeCount;
+       j++) {
+    auto column = FieldColumn(Output.get(), j);
+    for (size_t i = 0; i < Output->Count(); i++) {
+      ASSERT_EQ(reference[i][j], column[i]) << i << " " << j;
+    }
+  }
+}
@@ -29,12 +29,14 @@
  */
 
 #include <cmath>
+#include <vector>
 #include "src/transforms/mix_stereo.h"
 #include "tests/transforms/transform_test.h"
 
 using sound_feature_extraction::formats::ArrayFormat16;
 using sound_feature_extraction::BuffersBase;
 using sound_feature_extraction::transforms::MixStereo;
+using sound_feature_extraction::InstructionSet;
 
 class MixStereoTest : public TransformTest<MixStereo> {
  public:
@@ -57,3 +59,25 @@ TEST_F(MixStereoTest, Do) {
     ASSERT_EQ(-i, (*Output)[0][i]);
   }
 }
+
+TEST_F(MixStereoTest, InstructionSets) {
+  for (int i = 0; i < Size; i++) {
+    (*Input)[0][i] = (i * 7919) % 65536 - 32768;
+  }
+  set_use_simd(false);
+  Do((*Input)[0], (*Output)[0]);
+  std::vector<int16_t> reference((*Output)[0], (*Output)[0] + Size / 2);
+  set_use_simd(true);
+  for (int isa = 0; isa <= static_cast<int>(InstructionSet::kAVX512); isa++) {
+    if (!IsSupported(static_cast<InstructionSet>(isa))) {
+      continue;
+    }
+    set_max_instruction_set(static_cast<InstructionSet>(isa));
+    ASSERT_LE(SimdInstructionSet(), static_cast<InstructionSet>(isa));
+    Do((*Input)[0], (*Output)[0]);
+    for (int i = 0; i < Size / 2; i++) {
+      ASSERT_EQ(reference[i], (*Output)[0][i]) << isa << " " << i;
+    }
+  }
+  set_max_instruction_set(InstructionSet::kAVX512);
+}
@@ -0,0 +1,83 @@
+/*! @file multi_resolution_spectrum.cc
+ *  @brief Tests for sound_feature_extraction::transforms::MultiResolutionSpectrum.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#include <cmath>
+#include "src/transforms/multi_resolution_spectrum.h"
+#include "tests/transforms/transform_test.h"
+
+using sound_feature_extraction::formats::ArrayFormatF;
+using sound_feature_extraction::BuffersBase;
+using sound_feature_extraction::transforms::MultiResolutionSpectrum;
+using sound_feature_extraction::WindowType;
+
+class MultiResolutionSpectrumTest
+    : public TransformTest<MultiResolutionSpectrum> {
+ public:
+  int Size = 256;
+
+  virtual void SetUp() {
+    set_window(WindowType::kWindowTypeRectangular);
+    set_levels(3);
+    SetUpTransform(1, Size, 16000);
+    for (int i = 0; i < Size; i++) {
+      (*Input)[0][i] = sinf(i * 0.3f) + cosf(i * 0.05f) * (i % 7) / 7;
+    }
+  }
+};
+
+TEST_F(MultiResolutionSpectrumTest, Do) {
+  ASSERT_EQ(129U + 65U + 33U, output_format_->Size());
+  Do((*Input)[0], (*Output)[0]);
+  const float* out = (*Output)[0];
+  for (int length = Size; length >= Size / 4; length /= 2) {
+    const float* part = (*Input)[0] + (Size - length) / 2;
+    for (int k = 0; k <= length / 2; k++) {
+      double re = 0, im = 0;
+      for (int n = 0; n < length; n++) {
+        re += part[n] * cos(2 * M_PI * k * n / length);
+        im -= part[n] * sin(2 * M_PI * k * n / length);
+      }
+      double energy = re * re + im * im;
+      ASSERT_NEAR(energy, out[k], 1e-3 * energy + 1e-3) << length << " " << k;
+    }
+    out += length / 2 + 1;
+  }
+}
+
+TEST_F(MultiResolutionSpectrumTest, InvalidLevels) {
+  set_levels(9);
+  ASSERT_THROW(SetUpTransform(1, Size, 16000),
+               sound_feature_extraction::InvalidParameterValueException);
+}
+
+#define CLASS_NAME MultiResolutionSpectrumTest
+#define ITER_COUNT 50000
+#include "tests/transforms/benchmark.inc"
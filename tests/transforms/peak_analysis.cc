@@ -62,3 +62,17 @@ TEST_F(PeakAnalysisTest, Do) {
   ASSERT_FLOAT_EQ(1, (*Output)[0][(Size - 1) * 2 + 1]);
   ASSERT_NEAR(0.25f, (*Output)[0][(Size - 1) * 2 + 2], 0.002f);
 }
+
+TEST_F(PeakAnalysisTest, Ties) {
+  // The first of the equal highest peaks wins, zero sum is replaced with 1
+  for (int i = 0; i < Size; i++) {
+    (*Input)[0][i][0] = i + 2;
+    (*Input)[0][i][1] = i % 2? 1 : -1;
+  }
+  Do((*Input)[0], (*Output)[0]);
+  ASSERT_FLOAT_EQ(3, (*Output)[0][0]);
+  for (int i = 0; i < Size; i++) {
+    ASSERT_FLOAT_EQ((i + 2) / 3.f, (*Output)[0][i * 2 + 1]);
+    ASSERT_FLOAT_EQ((*Input)[0][i][1], (*Output)[0][i * 2 + 2]);
+  }
+}
@@ -31,6 +31,7 @@
 
 #include "src/transforms/peak_detection.h"
 #include <cmath>
+#include <vector>
 #include "tests/transforms/transform_test.h"
 
 using sound_feature_extraction::formats::ArrayFormatF;
@@ -62,3 +63,17 @@ TEST_F(PeakDetectionTest, Do) {
     EXPECT_NEAR((*Output)[0][i][1], 1, 0.05f) << i;
   }
 }
+
+TEST_F(PeakDetectionTest, FindExtrema) {
+  std::vector<ExtremumPoint> scalar(Size), simd(Size);
+  for (auto type : { kExtremumTypeMinimum, kExtremumTypeMaximum,
+                     kExtremumTypeBoth }) {
+    int count = FindExtrema(false, (*Input)[0], Size, type, scalar.data());
+    ASSERT_GT(count, 0);
+    ASSERT_EQ(count, FindExtrema(true, (*Input)[0], Size, type, simd.data()));
+    for (int i = 0; i < count; i++) {
+      ASSERT_EQ(scalar[i].position, simd[i].position) << i;
+      ASSERT_EQ(scalar[i].value, simd[i].value) << i;
+    }
+  }
+}
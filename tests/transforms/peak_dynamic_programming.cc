@@ -0,0 +1,155 @@
+/*! @file peak_dynamic_programming.cc
+ *  @brief Tests for sound_feature_extraction::transforms::PeakDynamicProgramming.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "src/transforms/peak_dynamic_programming.h"
+#include "tests/transforms/transform_test.h"
+
+using sound_feature_extraction::transforms::PeakDynamicProgramming;
+
+const int kBuffers = 7;
+const int kPeaks = 3;
+
+class PeakDynamicProgrammingTest
+    : public TransformTest<PeakDynamicProgramming> {
+ public:
+  virtual void SetUp() {
+    SetUpTransform(kBuffers, kPeaks, 18000);
+    for (int i = 0; i < kBuffers; i++) {
+      for (int j = 0; j < kPeaks; j++) {
+        (*Input)[i][j][0] = 100 + ((i * 7 + j * 13) % 11) * 10;
+        (*Input)[i][j][1] = 1 + (i + j) % 4;
+      }
+    }
+  }
+
+  /// @brief Finds the cheapest path by enumerating all of them.
+  std::vector<float> BruteForce() const {
+    std::vector<float> best;
+    float min_cost = std::numeric_limits<float>::infinity();
+    std::vector<int> path(kBuffers);
+    int paths = pow(kPeaks, kBuffers);
+    for (int p = 0; p < paths; p++) {
+      for (int i = 0, code = p; i < kBuffers; i++, code /= kPeaks) {
+        path[i] = code % kPeaks;
+      }
+      float cost = 0;
+      for (int i = 1; i < kBuffers; i++) {
+        const auto& from = (*Input)[i - 1][path[i - 1]];
+        const auto& to = (*Input)[i][path[i]];
+        float step = (to[0] - from[0]) * (to[0] - from[0]);
+        if (mind_values()) {
+          step *= sqrtf(from[1] / to[1]);
+        }
+        cost += step;
+      }
+      if (cost < min_cost) {
+        min_cost = cost;
+        best.clear();
+        for (int i = 0; i < kBuffers; i++) {
+          best.push_back((*Input)[i][path[i]][0]);
+        }
+      }
+    }
+    return best;
+  }
+};
+
+TEST_F(PeakDynamicProgrammingTest, Do) {
+  for (bool mind : { false, true }) {
+    set_mind_values(mind);
+    auto reference = BruteForce();
+    Do((*Input), &(*Output));
+    for (int i = 0; i < kBuffers; i++) {
+      ASSERT_FLOAT_EQ(reference[i], (*Output)[i]) << mind << " " << i;
+    }
+  }
+}
+
+TEST_F(PeakDynamicProgrammingTest, Beam) {
+  auto reference = BruteForce();
+  set_beam(kPeaks);
+  Do((*Input), &(*Output));
+  for (int i = 0; i < kBuffers; i++) {
+    ASSERT_FLOAT_EQ(reference[i], (*Output)[i]) << i;
+  }
+  set_beam(1);
+  Do((*Input), &(*Output));
+  for (int i = 0; i < kBuffers; i++) {
+    bool found = false;
+    for (int j = 0; j < kPeaks; j++) {
+      found |= (*Input)[i][j][0] == (*Output)[i];
+    }
+    ASSERT_TRUE(found) << i;
+  }
+}
+
+TEST_F(PeakDynamicProgrammingTest, EmptyBuffer) {
+  for (int j = 0; j < kPeaks; j++) {
+    (*Input)[3][j][0] = 0;
+  }
+  Do((*Input), &(*Output));
+  ASSERT_EQ(0, (*Output)[3]);
+  for (int i = 0; i < kBuffers; i++) {
+    if (i != 3) {
+      ASSERT_NE(0, (*Output)[i]) << i;
+    }
+  }
+}
+
+TEST_F(PeakDynamicProgrammingTest, Streaming) {
+  set_streaming(true);
+  Do((*Input), &(*Output));
+  auto reference = BruteForce();
+  for (int i = 0; i < kBuffers; i++) {
+    ASSERT_FLOAT_EQ(reference[i], (*Output)[i]) << i;
+  }
+  // Both constant paths cost nothing by themselves, only the previous
+  // call's last peak favors the near one
+  float last = (*Output)[kBuffers - 1];
+  for (int i = 0; i < kBuffers; i++) {
+    (*Input)[i][0][0] = last + 1000;
+    (*Input)[i][1][0] = last + 1;
+    (*Input)[i][2][0] = 0;
+  }
+  Do((*Input), &(*Output));
+  for (int i = 0; i < kBuffers; i++) {
+    ASSERT_FLOAT_EQ(last + 1, (*Output)[i]) << i;
+  }
+  ResetState();
+  Do((*Input), &(*Output));
+  for (int i = 0; i < kBuffers; i++) {
+    ASSERT_FLOAT_EQ(last + 1000, (*Output)[i]) << i;
+  }
+}
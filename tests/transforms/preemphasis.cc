@@ -29,12 +29,17 @@
  */
 
 #include <cmath>
+#include <unordered_map>
+#include "src/transform_tree.h"
 #include "src/transforms/preemphasis.h"
+#include "tests/speech_sample.inc"
 #include "tests/transforms/transform_test.h"
 
 using sound_feature_extraction::formats::ArrayFormatF;
 using sound_feature_extraction::BuffersBase;
 using sound_feature_extraction::transforms::Preemphasis;
+using sound_feature_extraction::Buffers;
+using sound_feature_extraction::TransformTree;
 
 class PreemphasisTest : public TransformTest<Preemphasis> {
  public:
@@ -58,6 +63,41 @@ TEST_F(PreemphasisTest, Do) {
   }
 }
 
+TEST(Preemphasis, MixFusion) {
+  std::unique_ptr<TransformTree> trees[2];
+  std::unordered_map<std::string, std::shared_ptr<Buffers>> results[2];
+  int16_t* buffers = new int16_t[48000];
+  memcpy(buffers, data, sizeof(data));
+  for (int fuse = 0; fuse < 2; fuse++) {
+    trees[fuse].reset(new TransformTree({ 48000, 16000 }));  // NOLINT(*)
+    auto& tt = *trees[fuse];
+    tt.set_fuse_transforms(fuse);
+    tt.AddFeature("Energy", { { "Preemphasis", "value=0.2" },
+                              { "Window", "length=512" },
+                              { "Energy", "" } });
+    tt.AddFeature("MixedEnergy", { { "Mix", "" },
+                                   { "Preemphasis", "value=0.2" },
+                                   { "Window", "length=512" },
+                                   { "Energy", "" } });
+    tt.PrepareForExecution();
+    results[fuse] = tt.Execute(buffers);
+    auto report = tt.ExecutionTimeReport();
+    ASSERT_EQ(fuse == 0, report.find("Mix") != report.end());
+    ASSERT_NE(report.end(), report.find("Preemphasis"));
+  }
+  delete[] buffers;
+  ASSERT_EQ(2U, results[1].size());
+  for (auto& feature : results[0]) {
+    auto& actual = results[1][feature.first];
+    ASSERT_EQ(feature.second->Count(), actual->Count());
+    for (size_t i = 0; i < actual->Count(); i++) {
+      float expected = *reinterpret_cast<const float*>((*feature.second)[i]);
+      ASSERT_NEAR(expected, *reinterpret_cast<const float*>((*actual)[i]),
+                  std::abs(expected) * 1e-4f) << feature.first << " " << i;
+    }
+  }
+}
+
 #undef CLASS_NAME
 #define CLASS_NAME PreemphasisTest
 #define PARAM_REORDER
@@ -0,0 +1,88 @@
+/*! @file quantize.cc
+ *  @brief Tests for sound_feature_extraction::transforms::Quantize.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#include <cmath>
+#include <vector>
+#include "src/transforms/quantize.h"
+#include "tests/transforms/transform_test.h"
+
+using sound_feature_extraction::transforms::Quantize;
+using sound_feature_extraction::InstructionSet;
+
+class QuantizeTest : public TransformTest<Quantize> {
+ public:
+  int Size;
+
+  virtual void SetUp() {
+    Size = 487;
+    SetUpTransform(1, Size, 16000);
+    // Halves check the rounding to even, the edges check the saturation
+    for (int i = 0; i < Size; i++) {
+      (*Input)[0][i] = (i - Size / 2) * 0.25f;
+    }
+    (*Input)[0][0] = -1000;
+    (*Input)[0][Size - 1] = 1000;
+    set_scale(2);
+  }
+};
+
+TEST_F(QuantizeTest, Do) {
+  set_max_instruction_set(InstructionSet::kScalar);
+  Do((*Input)[0], (*Output)[0]);
+  auto out = (*Output)[0];
+  ASSERT_EQ(-128, out[0]);
+  ASSERT_EQ(127, out[Size - 1]);
+  ASSERT_EQ(0, out[Size / 2]);
+  ASSERT_EQ(0, out[Size / 2 + 1]);
+  ASSERT_EQ(1, out[Size / 2 + 2]);
+  ASSERT_EQ(2, out[Size / 2 + 3]);
+  ASSERT_EQ(-2, out[Size / 2 - 3]);
+  ASSERT_EQ(121, out[Size - 2]);
+  set_max_instruction_set(InstructionSet::kAVX512);
+}
+
+TEST_F(QuantizeTest, InstructionSets) {
+  set_max_instruction_set(InstructionSet::kScalar);
+  Do((*Input)[0], (*Output)[0]);
+  std::vector<int8_t> reference((*Output)[0], (*Output)[0] + Size);
+  for (int isa = 0; isa <= static_cast<int>(InstructionSet::kAVX512); isa++) {
+    if (!IsSupported(static_cast<InstructionSet>(isa))) {
+      continue;
+    }
+    set_max_instruction_set(static_cast<InstructionSet>(isa));
+    ASSERT_LE(SimdInstructionSet(), static_cast<InstructionSet>(isa));
+    Do((*Input)[0], (*Output)[0]);
+    for (int i = 0; i < Size; i++) {
+      ASSERT_EQ(reference[i], (*Output)[0][i]) << isa << " " << i;
+    }
+  }
+  set_max_instruction_set(InstructionSet::kAVX512);
+}
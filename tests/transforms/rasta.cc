@@ -10,7 +10,9 @@
  *  Copyright 2015 Samsung R&D Institute Russia
  */
 
+#include <cmath>
 #include <fstream>
+#include <vector>
 #include "src/transforms/rasta.h"
 #include "tests/transforms/transform_test.h"
 #include "src/primitives/window.h"
@@ -21,6 +23,7 @@
 #define ASSERT_EQF(a, b) ASSERT_NEAR(a, b, EPSILON)
 
 using sound_feature_extraction::transforms::RASTA;
+using sound_feature_extraction::transforms::BandRASTA;
 
 class RASTAFilterTest : public TransformTest<RASTA> {
  public:
@@ -47,3 +50,92 @@ TEST_F(RASTAFilterTest, CalculateRASTAFilter) {
   fs << "]\n";
   */
 }
+
+class BandRASTATest : public TransformTest<BandRASTA> {
+ public:
+  /// @brief Filters each band of rows along time in double precision.
+  static std::vector<std::vector<float>> Reference(
+      const std::vector<std::vector<float>>& rows) {
+    RASTA rasta;
+    rasta.set_pole(0.94);
+    auto sections = rasta.Sections();
+    std::vector<std::vector<float>> result(rows);
+    for (size_t b = 0; b < rows[0].size(); b++) {
+      std::vector<double> state(sections.size() * 4, 0);
+      for (size_t n = 0; n < rows.size(); n++) {
+        double x = rows[n][b];
+        for (size_t s = 0; s < sections.size(); s++) {
+          const auto& c = sections[s];
+          double* st = &state[s * 4];
+          double y = c.b0 * x + c.b1 * st[0] + c.b2 * st[1] - c.a1 * st[2] -
+              c.a2 * st[3];
+          st[1] = st[0];
+          st[0] = x;
+          st[3] = st[2];
+          st[2] = y;
+          x = y;
+        }
+        result[n][b] = x;
+      }
+    }
+    return result;
+  }
+};
+
+TEST_F(BandRASTATest, Do) {
+  // One complete group of bands and an incomplete one
+  const int count = 50, size = 21;
+  set_pole(0.94);
+  SetUpTransform(count, size, 18000);
+  std::vector<std::vector<float>> rows;
+  for (int i = 0; i < count; i++) {
+    for (int j = 0; j < size; j++) {
+      (*Input)[i][j] = cosf(i * (j + 1) * 0.13f) + j;
+    }
+    rows.emplace_back((*Input)[i], (*Input)[i] + size);
+  }
+  auto reference = Reference(rows);
+  for (bool simd : { false, true }) {
+    set_use_simd(simd);
+    Do((*Input), &(*Output));
+    for (int i = 0; i < count; i++) {
+      for (int j = 0; j < size; j++) {
+        ASSERT_NEAR(reference[i][j], (*Output)[i][j], 1e-4f)
+            << simd << " " << i << " " << j;
+      }
+    }
+  }
+}
+
+TEST_F(BandRASTATest, Streaming) {
+  const int count = 20, size = 19, chunks = 3;
+  set_pole(0.94);
+  SetUpTransform(count, size, 18000);
+  set_streaming(true);
+  std::vector<std::vector<float>> rows;
+  for (int c = 0; c < chunks; c++) {
+    for (int i = 0; i < count; i++) {
+      for (int j = 0; j < size; j++) {
+        (*Input)[i][j] = sinf((c * count + i) * (j + 1) * 0.21f);
+      }
+      rows.emplace_back((*Input)[i], (*Input)[i] + size);
+    }
+    auto reference = Reference(rows);
+    Do((*Input), &(*Output));
+    for (int i = 0; i < count; i++) {
+      for (int j = 0; j < size; j++) {
+        ASSERT_NEAR(reference[c * count + i][j], (*Output)[i][j], 1e-4f)
+            << c << " " << i << " " << j;
+      }
+    }
+  }
+  ResetState();
+  Do((*Input), &(*Output));
+  auto reference = Reference(std::vector<std::vector<float>>(
+      rows.end() - count, rows.end()));
+  for (int i = 0; i < count; i++) {
+    for (int j = 0; j < size; j++) {
+      ASSERT_NEAR(reference[i][j], (*Output)[i][j], 1e-4f) << i << " " << j;
+    }
+  }
+}
@@ -28,6 +28,7 @@
  *  under the License.
  */
 
+#include <vector>
 #include "src/transform_tree.h"
 #include "src/transforms/rdft.h"
 #include "tests/speech_sample.inc"
@@ -70,6 +71,24 @@ TEST_F(RDFTTest, Do) {
   Do((*Input), &(*Output));
 }
 
+TEST_F(RDFTTest, CachedPlan) {
+  Do((*Input), &(*Output));
+  std::vector<float> first((*Output)[0], (*Output)[0] + Size + 2);
+  for (int i = 0; i < Size; i++) {
+    (*Input)[0][i] *= 2;
+  }
+  Do((*Input), &(*Output));
+  for (int i = 0; i < Size + 2; i++) {
+    ASSERT_NEAR(first[i] * 2, (*Output)[0][i], 1e-4f * (1 + fabs(first[i])));
+  }
+  auto previous = Output;
+  RecreateOutputBuffers();
+  Do((*Input), &(*Output));
+  for (int i = 0; i < Size + 2; i++) {
+    ASSERT_EQ((*previous)[0][i], (*Output)[0][i]);
+  }
+}
+
 TEST_F(RDFTInverseTest, Do) {
   Do((*Input), &(*Output));
 }
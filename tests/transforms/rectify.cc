@@ -29,12 +29,14 @@
  */
 
 #include <cmath>
+#include <vector>
 #include "src/transforms/rectify.h"
 #include "tests/transforms/transform_test.h"
 
 using sound_feature_extraction::formats::ArrayFormatF;
 using sound_feature_extraction::BuffersBase;
 using sound_feature_extraction::transforms::Rectify;
+using sound_feature_extraction::InstructionSet;
 
 class RectifyTest : public TransformTest<Rectify> {
  public:
@@ -59,6 +61,25 @@ TEST_F(RectifyTest, Do) {
   }
 }
 
+TEST_F(RectifyTest, InstructionSets) {
+  set_use_simd(false);
+  Do((*Input)[0], (*Output)[0]);
+  std::vector<float> reference((*Output)[0], (*Output)[0] + Size);
+  set_use_simd(true);
+  for (int isa = 0; isa <= static_cast<int>(InstructionSet::kAVX512); isa++) {
+    if (!IsSupported(static_cast<InstructionSet>(isa))) {
+      continue;
+    }
+    set_max_instruction_set(static_cast<InstructionSet>(isa));
+    ASSERT_LE(SimdInstructionSet(), static_cast<InstructionSet>(isa));
+    Do((*Input)[0], (*Output)[0]);
+    for (int i = 0; i < Size; i++) {
+      ASSERT_EQ(reference[i], (*Output)[0][i]) << isa << " " << i;
+    }
+  }
+  set_max_instruction_set(InstructionSet::kAVX512);
+}
+
 #define CLASS_NAME RectifyTest
 #define ITER_COUNT 500000
 #include "tests/transforms/benchmark.inc"
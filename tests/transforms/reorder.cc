@@ -51,7 +51,15 @@ class ReorderTest : public TransformTest<Reorder> {
 TEST_F(ReorderTest, Do) {
   ASSERT_EQ(120U, output_format_->Size());
   Do((*Input)[0], (*Output)[0]);
-  for (int i = Size; i < 120; i++) {
-    ASSERT_EQ(i / 10 + 12 * (i % 10), (*Output)[0][i]);
+  for (int i = 0; i < 120; i++) {
+    ASSERT_EQ(i / 10 + 12 * (i % 10), (*Output)[0][i]) << i;
+  }
+}
+
+TEST_F(ReorderTest, Scalar) {
+  set_use_simd(false);
+  Do((*Input)[0], (*Output)[0]);
+  for (int i = 0; i < 120; i++) {
+    ASSERT_EQ(indices()[i], (*Output)[0][i]) << i;
   }
 }
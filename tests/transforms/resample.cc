@@ -0,0 +1,134 @@
+/*! @file resample.cc
+ *  @brief Tests for sound_feature_extraction::transforms::Resample.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+
+#include <cmath>
+#include <vector>
+#include "src/transforms/resample.h"
+#include "tests/transforms/transform_test.h"
+
+using sound_feature_extraction::transforms::Resample;
+using sound_feature_extraction::InstructionSet;
+
+class ResampleTest : public TransformTest<Resample> {
+ public:
+  /// @brief Fills the only input buffer with a sine of the specified
+  /// frequency.
+  void Sine(float frequency, int rate) {
+    for (size_t i = 0; i < input_format_->Size(); i++) {
+      (*Input)[0][i] = sinf(2 * M_PI * frequency * i / rate);
+    }
+  }
+};
+
+TEST_F(ResampleTest, Downsample) {
+  set_up(1);
+  set_down(2);
+  SetUpTransform(1, 4000, 16000);
+  ASSERT_EQ(2000U, output_format_->Size());
+  ASSERT_EQ(8000, output_format_->SamplingRate());
+  Sine(500, 16000);
+  Do((*Input)[0], (*Output)[0]);
+  // The delay of the causal filter in the output samples
+  float delay = (length() - 1) / 2.f / 2;
+  for (int i = length(); i < 2000; i++) {
+    ASSERT_NEAR(sinf(2 * M_PI * 500 * (i - delay) / 8000), (*Output)[0][i],
+                0.01f) << i;
+  }
+}
+
+TEST_F(ResampleTest, AntiAliasing) {
+  SetUpTransform(1, 4000, 16000);
+  Sine(6000, 16000);
+  Do((*Input)[0], (*Output)[0]);
+  float energy = 0;
+  for (int i = length(); i < 2000; i++) {
+    energy += (*Output)[0][i] * (*Output)[0][i];
+  }
+  ASSERT_LT(sqrtf(energy / (2000 - length())), 0.01f);
+}
+
+TEST_F(ResampleTest, Rational) {
+  set_up(6);
+  set_down(4);
+  SetUpTransform(1, 1001, 16000);
+  // 6 / 4 is reduced to 3 / 2
+  ASSERT_EQ((length() + 2) / 3, phase_length());
+  ASSERT_EQ(1502U, output_format_->Size());
+  ASSERT_EQ(24000, output_format_->SamplingRate());
+  Sine(1000, 16000);
+  Do((*Input)[0], (*Output)[0]);
+  float delay = (length() - 1) / 2.f / 2;
+  for (int i = length(); i < 1502; i++) {
+    ASSERT_NEAR(sinf(2 * M_PI * 1000 * (i - delay) / 24000), (*Output)[0][i],
+                0.01f) << i;
+  }
+  std::vector<float> reference((*Output)[0], (*Output)[0] + 1502);
+  for (int isa = 0; isa <= static_cast<int>(InstructionSet::kAVX512);
+       isa++) {
+    if (!IsSupported(static_cast<InstructionSet>(isa))) {
+      continue;
+    }
+    set_max_instruction_set(static_cast<InstructionSet>(isa));
+    Do((*Input)[0], (*Output)[0]);
+    for (int i = 0; i < 1502; i++) {
+      ASSERT_NEAR(reference[i], (*Output)[0][i], 1e-5f) << isa << " " << i;
+    }
+  }
+  set_max_instruction_set(InstructionSet::kAVX512);
+}
+
+TEST_F(ResampleTest, Streaming) {
+  const int chunk = 600, chunks = 5;
+  set_up(2);
+  set_down(3);
+  SetUpTransform(1, chunk * chunks, 18000);
+  for (int i = 0; i < chunk * chunks; i++) {
+    (*Input)[0][i] = sinf(i * 0.05f) + (i % 17) * 0.01f;
+  }
+  std::vector<float> signal((*Input)[0], (*Input)[0] + chunk * chunks);
+  Do((*Input)[0], (*Output)[0]);
+  std::vector<float> reference((*Output)[0],
+                               (*Output)[0] + output_format_->Size());
+  set_streaming(true);
+  SetUpTransform(1, chunk, 18000);
+  ASSERT_EQ(400U, output_format_->Size());
+  for (int c = 0; c < chunks; c++) {
+    memcpy((*Input)[0], signal.data() + c * chunk, chunk * sizeof(float));
+    Do((*Input)[0], (*Output)[0]);
+    for (int i = 0; i < 400; i++) {
+      ASSERT_NEAR(reference[c * 400 + i], (*Output)[0][i], 1e-5f)
+          << c << " " << i;
+    }
+  }
+  ResetState();
+  set_streaming(false);
+}
@@ -0,0 +1,94 @@
+/*! @file rotate.cc
+ *  @brief Tests for sound_feature_extraction::transforms::Rotate.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#include <unordered_map>
+#include "src/transform_tree.h"
+#include "src/transforms/rotate.h"
+#include "tests/speech_sample.inc"
+#include "tests/transforms/transform_test.h"
+
+using sound_feature_extraction::transforms::RotateF;
+using sound_feature_extraction::Buffers;
+using sound_feature_extraction::TransformTree;
+
+class RotateTest : public TransformTest<RotateF> {
+ public:
+  virtual void SetUp() {
+    // Neither the size nor the count is a multiple of the tile
+    SetUpTransform(37, 203, 16000);
+    for (size_t i = 0; i < Input->Count(); i++) {
+      for (size_t j = 0; j < input_format_->Size(); j++) {
+        (*Input)[i][j] = i * 1000 + j;
+      }
+    }
+  }
+};
+
+TEST_F(RotateTest, Do) {
+  ASSERT_EQ(37U, output_format_->Size());
+  ASSERT_EQ(203U, Output->Count());
+  for (bool serial : { true, false }) {
+    set_serial(serial);
+    Do(*Input, Output.get());
+    for (size_t i = 0; i < Output->Count(); i++) {
+      for (size_t j = 0; j < output_format_->Size(); j++) {
+        ASSERT_EQ(j * 1000 + i, (*Output)[i][j]) << i << " " << j;
+      }
+    }
+  }
+}
+
+TEST(Rotate, Elision) {
+  std::unique_ptr<TransformTree> trees[2];
+  std::unordered_map<std::string, std::shared_ptr<Buffers>> results[2];
+  int16_t* buffers = new int16_t[48000];
+  memcpy(buffers, data, sizeof(data));
+  for (int fuse = 0; fuse < 2; fuse++) {
+    trees[fuse].reset(new TransformTree({ 48000, 16000 }));  // NOLINT(*)
+    auto& tt = *trees[fuse];
+    tt.set_fuse_transforms(fuse);
+    tt.AddFeature("Energy", { { "Window", "length=512" }, { "RDFT", "" },
+        { "SpectralEnergy", "" }, { "Rotate", "" }, { "Rotate", "" } });
+    tt.PrepareForExecution();
+    results[fuse] = tt.Execute(buffers);
+    auto report = tt.ExecutionTimeReport();
+    ASSERT_EQ(fuse == 0, report.find("Rotate") != report.end());
+  }
+  delete[] buffers;
+  auto& expected = results[0]["Energy"];
+  auto& actual = results[1]["Energy"];
+  ASSERT_EQ(expected->Count(), actual->Count());
+  size_t size = expected->Format()->UnalignedSizeInBytes();
+  ASSERT_EQ(size, actual->Format()->UnalignedSizeInBytes());
+  for (size_t i = 0; i < actual->Count(); i++) {
+    ASSERT_EQ(0, memcmp((*expected)[i], (*actual)[i], size)) << i;
+  }
+}
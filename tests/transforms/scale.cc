@@ -0,0 +1,85 @@
+/*! @file scale.cc
+ *  @brief Tests for sound_feature_extraction::transforms::Scale.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#include <cmath>
+#include <vector>
+#include "src/transforms/scale.h"
+#include "tests/transforms/transform_test.h"
+
+using sound_feature_extraction::transforms::Scale;
+using sound_feature_extraction::InstructionSet;
+
+class ScaleTest : public TransformTest<Scale> {
+ public:
+  int Size;
+
+  virtual void SetUp() {
+    Size = 487;
+    SetUpTransform(1, Size, 16000);
+    for (int i = 0; i < Size; i++) {
+      (*Input)[0][i] = (i - Size / 2) * 0.25f;
+    }
+    set_scale(-2);
+    set_offset(0.5f);
+  }
+};
+
+TEST_F(ScaleTest, Do) {
+  set_max_instruction_set(InstructionSet::kScalar);
+  Do((*Input)[0], (*Output)[0]);
+  for (int i = 0; i < Size; i++) {
+    ASSERT_EQ((*Input)[0][i] * -2 + 0.5f, (*Output)[0][i]) << i;
+  }
+  set_max_instruction_set(InstructionSet::kAVX512);
+}
+
+TEST_F(ScaleTest, InstructionSets) {
+  set_max_instruction_set(InstructionSet::kScalar);
+  Do((*Input)[0], (*Output)[0]);
+  std::vector<float> reference((*Output)[0], (*Output)[0] + Size);
+  for (int isa = 0; isa <= static_cast<int>(InstructionSet::kAVX512); isa++) {
+    if (!IsSupported(static_cast<InstructionSet>(isa))) {
+      continue;
+    }
+    set_max_instruction_set(static_cast<InstructionSet>(isa));
+    ASSERT_LE(SimdInstructionSet(), static_cast<InstructionSet>(isa));
+    Do((*Input)[0], (*Output)[0]);
+    for (int i = 0; i < Size; i++) {
+      ASSERT_EQ(reference[i], (*Output)[0][i]) << isa << " " << i;
+    }
+  }
+  set_max_instruction_set(InstructionSet::kAVX512);
+}
+
+TEST_F(ScaleTest, Validation) {
+  ASSERT_THROW(set_scale(NAN),
+               sound_feature_extraction::InvalidParameterValueException);
+}
@@ -56,6 +56,7 @@ TEST_F(SelectorTest, Do) {
                       (*Output)[0],
                       6 * sizeof(float)));  // NOLINT(*)
   set_from(sound_feature_extraction::transforms::Anchor::kRight);
+  Initialize();
   Do((*Input)[0], (*Output)[0]);
   ASSERT_EQ(0, memcmp((*Input)[0] + 512 - 6,
                       (*Output)[0],
@@ -79,6 +80,7 @@ TEST_F(SelectorTest, DoSelect) {
     ASSERT_FLOAT_EQ(0, (*Output)[0][i]) << i;
   }
   set_from(sound_feature_extraction::transforms::Anchor::kRight);
+  Initialize();
   Do((*Input)[0], (*Output)[0]);
   ASSERT_EQ(0, memcmp((*Input)[0] + 512 - 80,
                       (*Output)[0] + 40,
@@ -87,3 +89,27 @@ TEST_F(SelectorTest, DoSelect) {
     ASSERT_FLOAT_EQ(0, (*Output)[0][i]) << i;
   }
 }
+
+TEST_F(SelectorTest, Offset) {
+  set_from(sound_feature_extraction::transforms::Anchor::kLeft);
+  set_length(6);
+  set_offset(10);
+  SetUpTransform(1, Size, 16000);
+  for (int i = 0; i < Size; i++) {
+    (*Input)[0][i] = i;
+  }
+  ASSERT_EQ(6U, output_format_->Size());
+  Do((*Input)[0], (*Output)[0]);
+  ASSERT_EQ(0, memcmp((*Input)[0] + 10,
+                      (*Output)[0],
+                      6 * sizeof(float)));  // NOLINT(*)
+  set_from(sound_feature_extraction::transforms::Anchor::kRight);
+  Initialize();
+  Do((*Input)[0], (*Output)[0]);
+  ASSERT_EQ(0, memcmp((*Input)[0] + 512 - 6 - 10,
+                      (*Output)[0],
+                      6 * sizeof(float)));  // NOLINT(*)
+  set_offset(510);
+  ASSERT_THROW(SetUpTransform(1, Size, 16000),
+               sound_feature_extraction::InvalidParameterValueException);
+}
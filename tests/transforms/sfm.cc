@@ -0,0 +1,77 @@
+/*! @file sfm.cc
+ *  @brief Tests for sound_feature_extraction::transforms::SFM.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#include <cmath>
+#include "src/transforms/sfm.h"
+#include "tests/transforms/transform_test.h"
+
+using sound_feature_extraction::transforms::SFM;
+using sound_feature_extraction::transforms::kMeanTypeArithmetic;
+using sound_feature_extraction::transforms::kMeanTypeGeometric;
+
+class SFMTest : public TransformTest<SFM> {
+ public:
+  virtual void SetUp() {
+    SetUpTransform(4, 16000);
+    for (size_t i = 0; i < Input->Count(); i++) {
+      (*Input)[i][kMeanTypeArithmetic] = 2;
+      (*Input)[i][kMeanTypeGeometric] = 1;
+    }
+  }
+};
+
+TEST_F(SFMTest, Do) {
+  Do(*Input, Output.get());
+  for (size_t i = 0; i < Output->Count(); i++) {
+    ASSERT_FLOAT_EQ(logf(0.5f), (*Output)[i]);
+  }
+  auto stats = Statistics();
+  EXPECT_EQ(0u, stats.ZeroGeometric);
+  EXPECT_EQ(0u, stats.ZeroArithmetic);
+  EXPECT_EQ(0u, stats.DifferentSigns);
+}
+
+TEST_F(SFMTest, Degenerate) {
+  (*Input)[0][kMeanTypeGeometric] = 0;
+  (*Input)[1][kMeanTypeArithmetic] = 0;
+  (*Input)[2][kMeanTypeArithmetic] = -1;
+  for (int iteration = 1; iteration <= 2; iteration++) {
+    Do(*Input, Output.get());
+    for (int i = 0; i < 3; i++) {
+      ASSERT_EQ(0, (*Output)[i]);
+    }
+    ASSERT_FLOAT_EQ(logf(0.5f), (*Output)[3]);
+    auto stats = Statistics();
+    EXPECT_EQ(iteration, static_cast<int>(stats.ZeroGeometric));
+    EXPECT_EQ(iteration, static_cast<int>(stats.ZeroArithmetic));
+    EXPECT_EQ(iteration, static_cast<int>(stats.DifferentSigns));
+  }
+}
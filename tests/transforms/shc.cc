@@ -29,6 +29,7 @@
  */
 
 #include <cmath>
+#include <vector>
 #include <simd/detect_peaks.h>
 #include "src/transforms/shc.h"
 #include "tests/transforms/transform_test.h"
@@ -73,3 +74,25 @@ TEST_F(SHCTest, Do) {
   EXPECT_EQ(90, results[2].position);
   EXPECT_NEAR(0.6133f, results[2].value, 0.0001f);
 }
+
+TEST_F(SHCTest, DoFrames) {
+  const int count = 11;
+  SetUpTransform(count, Size, 18000);
+  for (int t = 0; t < count; t++) {
+    for (int i = 0; i < Size; i++) {
+      (*Input)[t][i] = fabsf(sinf(i * M_PI / (150 + t * 10)));
+    }
+  }
+  std::vector<float> expected(output_format_->Size());
+  for (bool simd : { false, true }) {
+    set_use_simd(simd);
+    Do((*Input), &(*Output));
+    for (int t = 0; t < count; t++) {
+      Do((*Input)[t], expected.data());
+      for (size_t i = 0; i < expected.size(); i++) {
+        ASSERT_NEAR(expected[i], (*Output)[t][i], 0.0001f)
+            << simd << " " << t << " " << i;
+      }
+    }
+  }
+}
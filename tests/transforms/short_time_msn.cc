@@ -32,6 +32,8 @@
 #include "src/transforms/short_time_msn.h"
 #include "tests/transforms/transform_test.h"
 #include <fftf/api.h>
+#include <algorithm>
+#include <vector>
 
 using sound_feature_extraction::formats::ArrayFormatF;
 using sound_feature_extraction::BuffersBase;
@@ -72,3 +74,78 @@ TEST_F(ShortTimeMeanScaleNormalizationTest, Do) {
   ASSERT_NEAR((*Output)[9][1], 0.5, 0.00001f);
   ASSERT_NEAR((*Output)[9][2], 0.5, 0.00001f);
 }
+
+/// @brief The straightforward O(count * size * length) implementation.
+static void NormalizeReference(const std::vector<std::vector<float>>& rows,
+                               int length,
+                               std::vector<std::vector<float>>* out) {
+  int back = length / 2, front = length - back;
+  int count = rows.size();
+  out->assign(count, std::vector<float>(rows[0].size()));
+  for (int i = 0; i < count; i++) {
+    for (size_t j = 0; j < rows[0].size(); j++) {
+      int begin = std::max(i - back, 0), end = std::min(i + front, count);
+      float sum = 0, min = rows[i][j], max = rows[i][j];
+      for (int k = begin; k < end; k++) {
+        sum += rows[k][j];
+        min = std::min(min, rows[k][j]);
+        max = std::max(max, rows[k][j]);
+      }
+      (*out)[i][j] = max - min > 0?
+          (rows[i][j] - sum / (end - begin)) / (max - min) : 0;
+    }
+  }
+}
+
+TEST_F(ShortTimeMeanScaleNormalizationTest, SlidingWindow) {
+  const int count = 97, size = 37;
+  std::vector<std::vector<float>> rows(count, std::vector<float>(size));
+  for (int i = 0; i < count; i++) {
+    for (int j = 0; j < size; j++) {
+      rows[i][j] = sinf(i * (j + 1) * 0.37f) + ((i * 7919 + j) % 13) / 13.f;
+    }
+  }
+  for (int length : { 2, 5, 8, 31, 96, 300 }) {
+    std::vector<std::vector<float>> reference;
+    NormalizeReference(rows, length, &reference);
+    set_length(length);
+    SetUpTransform(count, size, 18000);
+    for (int i = 0; i < count; i++) {
+      std::copy(rows[i].begin(), rows[i].end(), (*Input)[i]);
+    }
+    Do((*Input), &(*Output));
+    for (int i = 0; i < count; i++) {
+      for (int j = 0; j < size; j++) {
+        ASSERT_NEAR(reference[i][j], (*Output)[i][j], 1e-4f)
+            << length << " " << i << " " << j;
+      }
+    }
+  }
+}
+
+TEST_F(ShortTimeMeanScaleNormalizationTest, SlidingWindowStreaming) {
+  const int count = 20, size = 19, length = 9, chunks = 4;
+  set_length(length);
+  SetUpTransform(count, size, 18000);
+  set_streaming(true);
+  std::vector<std::vector<float>> history;
+  for (int c = 0; c < chunks; c++) {
+    std::vector<std::vector<float>> rows(history);
+    for (int i = 0; i < count; i++) {
+      for (int j = 0; j < size; j++) {
+        (*Input)[i][j] = cosf((c * count + i) * (j + 1) * 0.21f);
+      }
+      rows.emplace_back((*Input)[i], (*Input)[i] + size);
+    }
+    std::vector<std::vector<float>> reference;
+    NormalizeReference(rows, length, &reference);
+    Do((*Input), &(*Output));
+    for (int i = 0; i < count; i++) {
+      for (int j = 0; j < size; j++) {
+        ASSERT_NEAR(reference[history.size() + i][j], (*Output)[i][j], 1e-4f)
+            << c << " " << i << " " << j;
+      }
+    }
+    history.assign(rows.end() - length / 2, rows.end());
+  }
+}
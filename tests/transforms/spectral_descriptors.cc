@@ -0,0 +1,127 @@
+/*! @file spectral_descriptors.cc
+ *  @brief Tests for sound_feature_extraction::transforms::SpectralDescriptors.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#include <cmath>
+#include "src/transforms/spectral_descriptors.h"
+#include "tests/transforms/transform_test.h"
+
+using sound_feature_extraction::formats::ArrayFormatF;
+using sound_feature_extraction::BuffersBase;
+using sound_feature_extraction::transforms::SpectralDescriptors;
+using sound_feature_extraction::transforms::kSpectralDescriptorCentroid;
+using sound_feature_extraction::transforms::kSpectralDescriptorRolloff;
+using sound_feature_extraction::transforms::kSpectralDescriptorFlux;
+using sound_feature_extraction::transforms::kSpectralDescriptorEnergy;
+
+class SpectralDescriptorsTest : public TransformTest<SpectralDescriptors> {
+ public:
+  static const int Size;
+  static const int Count;
+
+  virtual void SetUp() {
+    SetUpTransform(Count, Size, 18000);
+    for (int b = 0; b < Count; b++) {
+      for (int i = 0; i < Size; i++) {
+        (*Input)[b][i] = 1 + (i * (b + 1)) % 7;
+      }
+    }
+  }
+
+  float Centroid(int b) {
+    float sum = 0, weighted = 0;
+    for (int i = 0; i < Size; i++) {
+      sum += (*Input)[b][i];
+      weighted += i * (*Input)[b][i];
+    }
+    return weighted / sum / input_format_->Duration();
+  }
+
+  float Rolloff(int b) {
+    float sum = 0;
+    for (int i = 0; i < Size; i++) {
+      sum += (*Input)[b][i];
+    }
+    float psum = 0;
+    int i;
+    for (i = 0; i < Size && psum < sum * ratio(); i++) {
+      psum += (*Input)[b][i];
+    }
+    return (i - 1) / input_format_->Duration();
+  }
+
+  float Flux(int b) {
+    float max_input = 0, max_prev = 0;
+    for (int i = 0; i < Size; i++) {
+      max_input = std::max(max_input, (*Input)[b][i]);
+      max_prev = std::max(max_prev, (*Input)[b - 1][i]);
+    }
+    float res = 0;
+    for (int i = 0; i < Size; i++) {
+      float diff = (*Input)[b][i] / max_input - (*Input)[b - 1][i] / max_prev;
+      res += diff * diff;
+    }
+    return sqrtf(res);
+  }
+
+  float Energy(int b) {
+    float res = 0;
+    for (int i = 0; i < Size; i++) {
+      res += (*Input)[b][i] * (*Input)[b][i];
+    }
+    return res / Size;
+  }
+};
+
+const int SpectralDescriptorsTest::Size = 100;
+const int SpectralDescriptorsTest::Count = 4;
+
+#define ASSERT_EQF(a, b) ASSERT_NEAR(a, b, std::abs(a) / 10000)
+
+TEST_F(SpectralDescriptorsTest, Do) {
+  Do((*Input), &(*Output));
+  for (int b = 0; b < Count; b++) {
+    ASSERT_EQF(Centroid(b), (*Output)[b][kSpectralDescriptorCentroid]);
+    ASSERT_EQF(Rolloff(b), (*Output)[b][kSpectralDescriptorRolloff]);
+    ASSERT_EQF(Flux(b > 0? b : 1), (*Output)[b][kSpectralDescriptorFlux]);
+    ASSERT_EQF(Energy(b), (*Output)[b][kSpectralDescriptorEnergy]);
+  }
+}
+
+TEST_F(SpectralDescriptorsTest, Subset) {
+  set_descriptors({ kSpectralDescriptorRolloff, kSpectralDescriptorEnergy });
+  Do((*Input), &(*Output));
+  for (int b = 0; b < Count; b++) {
+    ASSERT_EQ(0, (*Output)[b][kSpectralDescriptorCentroid]);
+    ASSERT_EQF(Rolloff(b), (*Output)[b][kSpectralDescriptorRolloff]);
+    ASSERT_EQ(0, (*Output)[b][kSpectralDescriptorFlux]);
+    ASSERT_EQF(Energy(b), (*Output)[b][kSpectralDescriptorEnergy]);
+  }
+}
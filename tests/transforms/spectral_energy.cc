@@ -64,6 +64,53 @@ TEST_F(SpectralEnergyTest, Do) {
   }
 }
 
+TEST_F(SpectralEnergyTest, Unpacked) {
+  set_unpacked(true);
+  RecreateOutputBuffers();
+  ASSERT_EQ(static_cast<size_t>(Size - 2), output_format_->Size());
+  Do((*Input)[0], (*Output)[0]);
+  int length = Size - 2;
+  for (int i = 0; i <= length / 2; i++) {
+    float re = i * 2;
+    float im = i * 2 + 1;
+    ASSERT_EQF((re * re + im * im) / 1600.0f, (*Output)[0][i]);
+  }
+  // The same as after UnpackRDFT
+  for (int i = length / 2 + 1; i < length; i++) {
+    ASSERT_EQ((*Output)[0][length - i], (*Output)[0][i]);
+  }
+}
+
+TEST_F(SpectralEnergyTest, FixedLength) {
+  for (int size : { 258, 514, 1026 }) {
+    SetUpTransform(1, size, 18000);
+    for (int i = 0; i < size; i++) {
+      (*Input)[0][i] = i / 40.0f;
+    }
+    Do((*Input)[0], (*Output)[0]);
+    for (int i = 0; i < size / 2; i++) {
+      float re = i * 2;
+      float im = i * 2 + 1;
+      ASSERT_EQF((re * re + im * im) / 1600.0f, (*Output)[0][i]) << size;
+    }
+  }
+}
+
+TEST_F(SpectralEnergyTest, UsedElements) {
+  set_used_elements({ 10, 100 });
+  Do((*Input)[0], (*Output)[0]);
+  // Widened to the multiples of 8
+  for (int i = 0; i < Size / 2; i++) {
+    float re = i * 2;
+    float im = i * 2 + 1;
+    if (i < 8 || i >= 104) {
+      ASSERT_EQ(0.f, (*Output)[0][i]) << i;
+    } else {
+      ASSERT_EQF((re * re + im * im) / 1600.0f, (*Output)[0][i]) << i;
+    }
+  }
+}
+
 #define CLASS_NAME SpectralEnergyTest
 #define ITER_COUNT 500000
 #include "tests/transforms/benchmark.inc"
@@ -28,6 +28,7 @@
  *  under the License.
  */
 
+#include <vector>
 #include "src/transforms/square.h"
 #include "tests/transforms/transform_test.h"
 
@@ -35,6 +36,7 @@ using sound_feature_extraction::formats::ArrayFormat16;
 using sound_feature_extraction::formats::ArrayFormatF;
 using sound_feature_extraction::BuffersBase;
 using sound_feature_extraction::transforms::Square;
+using sound_feature_extraction::InstructionSet;
 
 class SquareTest : public TransformTest<Square> {
  public:
@@ -60,6 +62,25 @@ TEST_F(SquareTest, Do) {
   }
 }
 
+TEST_F(SquareTest, InstructionSets) {
+  set_use_simd(false);
+  Do((*Input)[0], (*Output)[0]);
+  std::vector<float> reference((*Output)[0], (*Output)[0] + Size);
+  set_use_simd(true);
+  for (int isa = 0; isa <= static_cast<int>(InstructionSet::kAVX512); isa++) {
+    if (!IsSupported(static_cast<InstructionSet>(isa))) {
+      continue;
+    }
+    set_max_instruction_set(static_cast<InstructionSet>(isa));
+    ASSERT_LE(SimdInstructionSet(), static_cast<InstructionSet>(isa));
+    Do((*Input)[0], (*Output)[0]);
+    for (int i = 0; i < Size; i++) {
+      ASSERT_EQ(reference[i], (*Output)[0][i]) << isa << " " << i;
+    }
+  }
+  set_max_instruction_set(InstructionSet::kAVX512);
+}
+
 #define CLASS_NAME SquareTest
 #define ITER_COUNT 300000
 #include "tests/transforms/benchmark.inc"
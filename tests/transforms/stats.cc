@@ -29,14 +29,22 @@
  */
 
 
+#include <cmath>
 #include <random>
+#include <unordered_map>
+#include <vector>
+#include "src/transform_tree.h"
 #include "src/transforms/stats.h"
+#include "tests/speech_sample.inc"
 #include "tests/transforms/transform_test.h"
 
 using sound_feature_extraction::formats::ArrayFormatF;
 using sound_feature_extraction::BuffersBase;
 using sound_feature_extraction::transforms::Stats;
 using sound_feature_extraction::transforms::StatsType;
+using sound_feature_extraction::InstructionSet;
+using sound_feature_extraction::Buffers;
+using sound_feature_extraction::TransformTree;
 
 class StatsTest : public TransformTest<Stats> {
  public:
@@ -53,6 +61,45 @@ class StatsTest : public TransformTest<Stats> {
   }
 };
 
+/// @brief Calculates the stats of in[0, length) with two passes in double.
+static void StatsReference(const float* in, int length,
+                           const std::set<StatsType>& types,
+                           std::vector<float>* out) {
+  double mean = 0;
+  for (int i = 0; i < length; i++) {
+    mean += in[i];
+  }
+  mean /= length;
+  double u2 = 0, u3 = 0, u4 = 0;
+  for (int i = 0; i < length; i++) {
+    double d = in[i] - mean;
+    u2 += d * d;
+    u3 += d * d * d;
+    u4 += d * d * d * d;
+  }
+  u2 /= length;
+  u3 /= length;
+  u4 /= length;
+  for (auto type : types) {
+    switch (type) {
+      case StatsType::kStatsTypeAverage:
+        out->push_back(mean);
+        break;
+      case StatsType::kStatsTypeStdDeviation:
+        out->push_back(sqrt(u2));
+        break;
+      case StatsType::kStatsTypeSkewness:
+        out->push_back(u3 / (u2 * sqrt(u2)));
+        break;
+      case StatsType::kStatsTypeKurtosis:
+        out->push_back(u4 / (u2 * u2) - 3);
+        break;
+      default:
+        break;
+    }
+  }
+}
+
 #define EPSILON 0.15f
 
 #define ASSERT_EQF(a, b) ASSERT_NEAR(a, b, EPSILON)
@@ -714,3 +761,110 @@ TEST_F(StatsTest, DoRealCase) {
   Do((*Input)[0], (*Output)[0]);
   Output->Validate();
 }
+
+TEST_F(StatsTest, SinglePass) {
+  const int size = 1001;
+  SetUpTransform(1, size, 16000);
+  // The big offset breaks the unstable raw moments
+  for (int i = 0; i < size; i++) {
+    (*Input)[0][i] = 4000 + sinf(i * 0.37f) * 50 + (i % 13);
+  }
+  const std::vector<std::set<StatsType>> subsets {
+    { StatsType::kStatsTypeKurtosis },
+    { StatsType::kStatsTypeStdDeviation, StatsType::kStatsTypeSkewness },
+    { StatsType::kStatsTypeAverage, StatsType::kStatsTypeStdDeviation,
+      StatsType::kStatsTypeSkewness, StatsType::kStatsTypeKurtosis }
+  };
+  for (auto& types : subsets) {
+    for (int interval : { size, 300 }) {
+      set_types(types);
+      set_interval(interval);
+      set_overlap(interval / 3);
+      RecreateOutputBuffers();
+      std::vector<float> reference;
+      int step = interval - overlap();
+      for (int i = 0; i < size - interval + 1; i += step) {
+        StatsReference((*Input)[0] + i, interval, types, &reference);
+      }
+      if ((size - interval) % step != 0) {
+        StatsReference((*Input)[0] + size - interval, interval, types,
+                       &reference);
+      }
+      ASSERT_EQ(reference.size(), output_format_->Size());
+      for (int isa = 0; isa <= static_cast<int>(InstructionSet::kAVX512);
+           isa++) {
+        if (!IsSupported(static_cast<InstructionSet>(isa))) {
+          continue;
+        }
+        set_max_instruction_set(static_cast<InstructionSet>(isa));
+        Do((*Input)[0], (*Output)[0]);
+        for (size_t i = 0; i < reference.size(); i++) {
+          ASSERT_NEAR(reference[i], (*Output)[0][i],
+                      fabsf(reference[i]) * 1e-4f + 1e-4f)
+              << types.size() << " " << interval << " " << isa << " " << i;
+        }
+      }
+      set_max_instruction_set(InstructionSet::kAVX512);
+    }
+  }
+}
+
+TEST_F(StatsTest, Streaming) {
+  const int size = 700, chunks = 5;
+  SetUpTransform(1, size, 16000);
+  set_streaming(true);
+  std::vector<float> all;
+  for (int c = 0; c < chunks; c++) {
+    for (int i = 0; i < size; i++) {
+      (*Input)[0][i] = c * 3 + cosf((c * size + i) * 0.01f) * (c + 1);
+    }
+    all.insert(all.end(), (*Input)[0], (*Input)[0] + size);
+    std::vector<float> reference;
+    StatsReference(all.data(), all.size(), types(), &reference);
+    Do((*Input)[0], (*Output)[0]);
+    for (size_t i = 0; i < reference.size(); i++) {
+      ASSERT_NEAR(reference[i], (*Output)[0][i],
+                  fabsf(reference[i]) * 1e-4f + 1e-4f) << c << " " << i;
+    }
+  }
+  ResetState();
+  Do((*Input)[0], (*Output)[0]);
+  std::vector<float> reference;
+  StatsReference((*Input)[0], size, types(), &reference);
+  ASSERT_NEAR(reference[0], (*Output)[0][0], fabsf(reference[0]) * 1e-4f);
+}
+
+TEST(Stats, RotatedFusion) {
+  int16_t* buffers = new int16_t[48000];
+  memcpy(buffers, data, sizeof(data));
+  for (auto params : { "", "interval=20,overlap=5", "types=average" }) {
+    std::unique_ptr<TransformTree> trees[2];
+    std::unordered_map<std::string, std::shared_ptr<Buffers>> results[2];
+    for (int fuse = 0; fuse < 2; fuse++) {
+      trees[fuse].reset(new TransformTree({ 48000, 16000 }));  // NOLINT(*)
+      auto& tt = *trees[fuse];
+      tt.set_fuse_transforms(fuse);
+      tt.AddFeature("MFCC", { { "Window", "length=512" }, { "RDFT", "" },
+          { "SpectralEnergy", "" }, { "FilterBank", "" }, { "Log", "" },
+          { "DCT", "" }, { "Rotate", "" }, { "Stats", params } });
+      tt.PrepareForExecution();
+      results[fuse] = tt.Execute(buffers);
+      auto report = tt.ExecutionTimeReport();
+      ASSERT_EQ(fuse == 0, report.find("Rotate") != report.end()) << params;
+    }
+    auto& expected = results[0]["MFCC"];
+    auto& actual = results[1]["MFCC"];
+    ASSERT_EQ(expected->Count(), actual->Count()) << params;
+    size_t size = expected->Format()->UnalignedSizeInBytes() / sizeof(float);
+    for (size_t i = 0; i < actual->Count(); i++) {
+      auto expected_data = reinterpret_cast<const float*>((*expected)[i]);
+      auto actual_data = reinterpret_cast<const float*>((*actual)[i]);
+      for (size_t j = 0; j < size; j++) {
+        ASSERT_NEAR(expected_data[j], actual_data[j],
+                    std::abs(expected_data[j]) * 1e-4f + 1e-4f)
+            << params << " " << i << " " << j;
+      }
+    }
+  }
+  delete[] buffers;
+}
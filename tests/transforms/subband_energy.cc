@@ -28,12 +28,18 @@
  *  under the License.
  */
 
+#include <cmath>
+#include <unordered_map>
+#include "src/transform_tree.h"
 #include "src/transforms/subband_energy.h"
+#include "tests/speech_sample.inc"
 #include "tests/transforms/transform_test.h"
 
 using sound_feature_extraction::formats::ArrayFormatF;
 using sound_feature_extraction::BuffersBase;
 using sound_feature_extraction::transforms::SubbandEnergy;
+using sound_feature_extraction::Buffers;
+using sound_feature_extraction::TransformTree;
 
 class SubbandEnergyTest : public TransformTest<SubbandEnergy> {
  public:
@@ -67,3 +73,34 @@ TEST_F(SubbandEnergyTest, Do) {
   ASSERT_EQF(SumOfSquares(quarter * 4) - SumOfSquares(quarter * 2),
              output[2]);
 }
+
+TEST(SubbandEnergy, DWPTFusion) {
+  std::unique_ptr<TransformTree> trees[2];
+  std::unordered_map<std::string, std::shared_ptr<Buffers>> results[2];
+  int16_t* buffers = new int16_t[48000];
+  memcpy(buffers, data, sizeof(data));
+  for (int fuse = 0; fuse < 2; fuse++) {
+    trees[fuse].reset(new TransformTree({ 48000, 16000 }));  // NOLINT(*)
+    auto& tt = *trees[fuse];
+    tt.set_fuse_transforms(fuse);
+    tt.AddFeature("SBE", { { "Window", "length=512" }, { "DWPT", "" },
+                           { "SubbandEnergy", "" } });
+    tt.PrepareForExecution();
+    results[fuse] = tt.Execute(buffers);
+    auto report = tt.ExecutionTimeReport();
+    ASSERT_EQ(fuse == 0, report.find("DWPT") != report.end());
+  }
+  delete[] buffers;
+  auto& expected = results[0]["SBE"];
+  auto& actual = results[1]["SBE"];
+  ASSERT_EQ(expected->Count(), actual->Count());
+  size_t size = expected->Format()->UnalignedSizeInBytes() / sizeof(float);
+  for (size_t i = 0; i < actual->Count(); i++) {
+    auto expected_data = reinterpret_cast<const float*>((*expected)[i]);
+    auto actual_data = reinterpret_cast<const float*>((*actual)[i]);
+    for (size_t j = 0; j < size; j++) {
+      ASSERT_NEAR(expected_data[j], actual_data[j],
+                  std::abs(expected_data[j]) * 1e-4f + 1e-4f) << i << " " << j;
+    }
+  }
+}
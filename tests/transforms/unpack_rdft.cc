@@ -29,12 +29,18 @@
  */
 
 
+#include <cmath>
+#include <unordered_map>
+#include "src/transform_tree.h"
 #include "src/transforms/unpack_rdft.h"
+#include "tests/speech_sample.inc"
 #include "tests/transforms/transform_test.h"
 
 using sound_feature_extraction::formats::ArrayFormatF;
 using sound_feature_extraction::BuffersBase;
 using sound_feature_extraction::transforms::UnpackRDFT;
+using sound_feature_extraction::Buffers;
+using sound_feature_extraction::TransformTree;
 
 class UnpackRDFTTest : public TransformTest<UnpackRDFT> {
  public:
@@ -66,3 +72,44 @@ TEST_F(UnpackRDFTTest, DoComplex) {
     ASSERT_EQ(2 * (Size - 2) - i + 1, (*Output)[0][i + 1]);
   }
 }
+
+TEST(UnpackRDFT, Elision) {
+  std::unique_ptr<TransformTree> trees[2];
+  std::unordered_map<std::string, std::shared_ptr<Buffers>> results[2];
+  int16_t* buffers = new int16_t[48000];
+  memcpy(buffers, data, sizeof(data));
+  for (int fuse = 0; fuse < 2; fuse++) {
+    trees[fuse].reset(new TransformTree({ 48000, 16000 }));  // NOLINT(*)
+    auto& tt = *trees[fuse];
+    tt.set_fuse_transforms(fuse);
+    tt.AddFeature("Energy", { { "Window", "length=512" }, { "RDFT", "" },
+        { "UnpackRDFT", "" }, { "SpectralEnergy", "" } });
+    tt.AddFeature("Magnitude", { { "Window", "length=512" }, { "RDFT", "" },
+        { "UnpackRDFT", "" }, { "ComplexMagnitude", "" } });
+    tt.AddFeature("Real", { { "Window", "length=512" }, { "RDFT", "" },
+        { "UnpackRDFT", "" }, { "C2R", "" } });
+    tt.PrepareForExecution();
+    results[fuse] = tt.Execute(buffers);
+    auto report = tt.ExecutionTimeReport();
+    ASSERT_EQ(fuse == 0, report.find("UnpackRDFT") != report.end());
+  }
+  delete[] buffers;
+  ASSERT_EQ(3U, results[1].size());
+  for (auto& feature : results[0]) {
+    auto& actual = results[1][feature.first];
+    ASSERT_EQ(feature.second->Count(), actual->Count());
+    size_t size = feature.second->Format()->UnalignedSizeInBytes() /
+        sizeof(float);
+    ASSERT_EQ(size, actual->Format()->UnalignedSizeInBytes() / sizeof(float));
+    for (size_t i = 0; i < actual->Count(); i++) {
+      auto expected_data = reinterpret_cast<const float*>(
+          (*feature.second)[i]);
+      auto actual_data = reinterpret_cast<const float*>((*actual)[i]);
+      for (size_t j = 0; j < size; j++) {
+        ASSERT_NEAR(expected_data[j], actual_data[j],
+                    std::abs(expected_data[j]) * 1e-4f + 1e-4f)
+            << feature.first << " differs at " << i << ", " << j;
+      }
+    }
+  }
+}
@@ -29,6 +29,7 @@
  */
 
 
+#include <unordered_map>
 #include "src/transforms/window.h"
 #include "tests/transforms/transform_test.h"
 #include "src/transform_tree.h"
@@ -37,6 +38,12 @@
 #include "tests/speech_sample.inc"
 
 using sound_feature_extraction::transforms::Window;
+using sound_feature_extraction::InstructionSet;
+using sound_feature_extraction::WindowType;
+using sound_feature_extraction::SharedWindow;
+using sound_feature_extraction::WindowElement;
+using sound_feature_extraction::Buffers;
+using sound_feature_extraction::TransformTree;
 
 class WindowTest : public TransformTest<Window> {
  public:
@@ -61,8 +68,115 @@ TEST_F(WindowTest, Do) {
                       sizeof(float) * Size));
 }
 
+TEST_F(WindowTest, InstructionSets) {
+  set_predft(false);
+  Initialize();
+  for (int isa = 0; isa <= static_cast<int>(InstructionSet::kAVX512); isa++) {
+    if (!IsSupported(static_cast<InstructionSet>(isa))) {
+      continue;
+    }
+    set_max_instruction_set(static_cast<InstructionSet>(isa));
+    ASSERT_LE(ApplyWindowInstructionSet(), static_cast<InstructionSet>(isa));
+    // Unaligned pointers exercise the masked and scalar tails
+    for (int offset = 0; offset < 3; offset++) {
+      float output[Size] __attribute__((aligned (32)));
+      ApplyWindow(true, window_.get() + offset, Size - offset,
+                  (*Input)[0] + offset, output);
+      for (int i = 0; i < Size - offset; i++) {
+        ASSERT_EQ(window_.get()[i + offset] * (*Input)[0][i + offset],
+                  output[i]) << isa << " " << offset << " " << i;
+      }
+    }
+  }
+  set_max_instruction_set(InstructionSet::kAVX512);
+}
+
 TEST_F(WindowTest, DoPreDft) {
   set_predft(true);
   Initialize();
   Do((*Input)[0], (*Output)[0]);
 }
+
+TEST_F(WindowTest, SharedWindow) {
+  set_predft(false);
+  Initialize();
+  auto table = SharedWindow(WindowType::kWindowTypeHamming, Size);
+  ASSERT_EQ(window_.get(), table.get());
+  for (int i = 0; i < Size; i++) {
+    ASSERT_EQ(WindowElement(WindowType::kWindowTypeHamming, Size, i),
+              table.get()[i]);
+  }
+  window_.reset();
+  Initialize();
+  ASSERT_EQ(table.get(), window_.get());
+  ASSERT_NE(table.get(),
+            SharedWindow(WindowType::kWindowTypeHamming, Size, true).get());
+}
+
+TEST(Window, RectangularView) {
+  TransformTree reference( { 48000, 16000 } );  // NOLINT(*)
+  reference.AddFeature("Frames", { { "Window",
+      "length=512,step=128,type=rectangular" } });
+  TransformTree tt( { 48000, 16000 } );  // NOLINT(*)
+  tt.AddFeature("Frames", { { "Window",
+      "length=512,step=128,type=rectangular" } });
+  tt.AddFeature("Energy", { { "Window",
+      "length=512,step=128,type=rectangular" }, { "Energy", "" } });
+  reference.PrepareForExecution();
+  tt.PrepareForExecution();
+  int16_t* buffers = new int16_t[48000];
+  memcpy(buffers, data, sizeof(data));
+  auto expected = reference.Execute(buffers);
+  auto res = tt.Execute(buffers);
+  ASSERT_EQ(2U, res.size());
+  auto& frames = res["Frames"];
+  ASSERT_EQ(expected["Frames"]->Count(), frames->Count());
+  // The frames overlap in the input instead of being copied
+  ASSERT_EQ(128 * sizeof(int16_t), frames->Stride());
+  size_t size = frames->Format()->UnalignedSizeInBytes();
+  for (size_t i = 0; i < frames->Count(); i++) {
+    ASSERT_EQ(static_cast<void*>(buffers + i * 128), (*frames)[i]);
+    ASSERT_EQ(0, memcmp((*expected["Frames"])[i], (*frames)[i], size));
+  }
+  auto context = tt.CreateExecutionContext();
+  auto& context_frames = tt.Execute(buffers, context.get()).at("Frames");
+  ASSERT_EQ(static_cast<void*>(buffers + 128), (*context_frames)[1]);
+  delete[] buffers;
+}
+
+TEST(Window, SlidingReductions) {
+  std::unique_ptr<TransformTree> trees[2];
+  std::unordered_map<std::string, std::shared_ptr<Buffers>> results[2];
+  int16_t* buffers = new int16_t[48000];
+  memcpy(buffers, data, sizeof(data));
+  for (int fuse = 0; fuse < 2; fuse++) {
+    trees[fuse].reset(new TransformTree({ 48000, 16000 }));  // NOLINT(*)
+    auto& tt = *trees[fuse];
+    tt.set_fuse_transforms(fuse);
+    tt.AddFeature("Energy", { { "Window", "length=512,step=160,"
+                                          "type=rectangular" },
+                              { "Energy", "" } });
+    tt.AddFeature("ZeroCrossings", { { "Window", "length=512,step=160,"
+                                                 "type=rectangular" },
+                                     { "ZeroCrossings", "" } });
+    tt.PrepareForExecution();
+    results[fuse] = tt.Execute(buffers);
+    auto report = tt.ExecutionTimeReport();
+    ASSERT_EQ(fuse == 1, report.find("SlidingEnergy") != report.end());
+    ASSERT_EQ(fuse == 1,
+              report.find("SlidingZeroCrossings") != report.end());
+    ASSERT_EQ(fuse == 0, report.find("Window") != report.end());
+  }
+  delete[] buffers;
+  ASSERT_EQ(2U, results[1].size());
+  // The integer samples are summed exactly
+  for (auto& feature : results[0]) {
+    auto& actual = results[1][feature.first];
+    ASSERT_EQ(feature.second->Count(), actual->Count());
+    size_t size = feature.second->Format()->UnalignedSizeInBytes();
+    for (size_t i = 0; i < actual->Count(); i++) {
+      ASSERT_EQ(0, memcmp((*feature.second)[i], (*actual)[i], size))
+          << feature.first << " differs at " << i;
+    }
+  }
+}
@@ -28,11 +28,16 @@
  *  under the License.
  */
 
+#include <vector>
 #include "tests/transforms/transform_test.h"
 #include "src/transforms/window_splitter.h"
 
 using sound_feature_extraction::transforms::WindowSplitterF;
 using sound_feature_extraction::transforms::WindowSplitterFInverse;
+using sound_feature_extraction::transforms::WindowSplitter16;
+using sound_feature_extraction::InstructionSet;
+using sound_feature_extraction::BuffersBase;
+using sound_feature_extraction::formats::ArrayFormatF;
 
 class WindowSplitterTest : public TransformTest<WindowSplitterF> {
  public:
@@ -49,6 +54,22 @@ class WindowSplitterTest : public TransformTest<WindowSplitterF> {
   }
 };
 
+class WindowSplitter16Test : public TransformTest<WindowSplitter16> {
+ public:
+  int Size;
+
+  virtual void SetUp() {
+    Size = 509 + 205;
+    set_length(509);
+    SetUpTransform(3, Size, 16000);
+    for (int j = 0; j < 3; j++) {
+      for (int i = 0; i < Size; i++) {
+        (*Input)[j][i] = (i * 7919 + j) % 65536 - 32768;
+      }
+    }
+  }
+};
+
 class WindowSplitterInverseTest : public TransformTest<WindowSplitterFInverse> {
  public:
   int Size;
@@ -70,6 +91,31 @@ TEST_F(WindowSplitterTest, Do) {
   ASSERT_EQ(512U, output_format_->Size());
 }
 
+TEST_F(WindowSplitter16Test, Tiles) {
+  set_type(sound_feature_extraction::WindowType::kWindowTypeRectangular);
+  set_interleaved(false);
+  set_length(64);
+  set_step(100);
+  const int count = 19, size = 64 + 100 * 20;
+  SetUpTransform(count, size, 16000);
+  for (int i = 0; i < count; i++) {
+    for (int k = 0; k < size; k++) {
+      (*Input)[i][k] = (k * 7919 + i) % 65536 - 32768;
+    }
+  }
+  ASSERT_EQ(count * 21U, Output->Count());
+  for (bool serial : { true, false }) {
+    set_serial(serial);
+    Do(*Input, Output.get());
+    for (int j = 0; j < 21; j++) {
+      for (int i = 0; i < count; i++) {
+        ASSERT_EQ(0, memcmp((*Input)[i] + j * 100, (*Output)[j * count + i],
+                            64 * sizeof(int16_t))) << i << " " << j;
+      }
+    }
+  }
+}
+
 TEST_F(WindowSplitterInverseTest, DoInterleaved) {
   set_interleaved(true);
   set_step(309);
@@ -79,3 +125,51 @@ TEST_F(WindowSplitterInverseTest, DoInterleaved) {
   ASSERT_EQ(1953U, output_format_->Size());
   Do(*Input, Output.get());
 }
+
+TEST_F(WindowSplitter16Test, InstructionSets) {
+  set_use_simd(false);
+  Do(*Input, Output.get());
+  ASSERT_EQ(Input->Count() * 2, Output->Count());
+  std::vector<std::vector<int16_t>> reference;
+  for (size_t i = 0; i < Output->Count(); i++) {
+    reference.emplace_back((*Output)[i], (*Output)[i] + 509);
+  }
+  set_use_simd(true);
+  for (int isa = 0; isa <= static_cast<int>(InstructionSet::kAVX512); isa++) {
+    if (!IsSupported(static_cast<InstructionSet>(isa))) {
+      continue;
+    }
+    set_max_instruction_set(static_cast<InstructionSet>(isa));
+    Do(*Input, Output.get());
+    for (size_t i = 0; i < Output->Count(); i++) {
+      for (int j = 0; j < 509; j++) {
+        ASSERT_EQ(reference[i][j], (*Output)[i][j]) << isa << " " << j;
+      }
+    }
+  }
+  set_max_instruction_set(InstructionSet::kAVX512);
+}
+
+TEST_F(WindowSplitter16Test, DoFloat) {
+  set_type(sound_feature_extraction::WindowType::kWindowTypeHanning);
+  Initialize();
+  Do(*Input, Output.get());
+  auto format = std::make_shared<ArrayFormatF>(509, 16000);
+  BuffersBase<float*> floats(format, Output->Count());
+  for (int isa = 0; isa <= static_cast<int>(InstructionSet::kAVX512); isa++) {
+    if (!IsSupported(static_cast<InstructionSet>(isa))) {
+      continue;
+    }
+    set_max_instruction_set(static_cast<InstructionSet>(isa));
+    ASSERT_LE(FloatInstructionSet(), static_cast<InstructionSet>(isa));
+    for (bool streaming : { false, true }) {
+      DoFloat(*Input, &floats, streaming);
+      for (size_t i = 0; i < Output->Count(); i++) {
+        for (int j = 0; j < 509; j++) {
+          ASSERT_EQ((*Output)[i][j], floats[i][j]) << isa << " " << j;
+        }
+      }
+    }
+  }
+  set_max_instruction_set(InstructionSet::kAVX512);
+}
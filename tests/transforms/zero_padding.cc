@@ -28,12 +28,17 @@
  *  under the License.
  */
 
+#include <unordered_map>
+#include "src/transform_tree.h"
 #include "src/transforms/zero_padding.h"
+#include "tests/speech_sample.inc"
 #include "tests/transforms/transform_test.h"
 
 using sound_feature_extraction::formats::ArrayFormatF;
 using sound_feature_extraction::BuffersBase;
 using sound_feature_extraction::transforms::ZeroPadding;
+using sound_feature_extraction::Buffers;
+using sound_feature_extraction::TransformTree;
 
 class ZeroPaddingTest : public TransformTest<ZeroPadding> {
  public:
@@ -55,3 +60,58 @@ TEST_F(ZeroPaddingTest, Do) {
     ASSERT_EQ(0.f, (*Output)[0][i]);
   }
 }
+
+TEST_F(ZeroPaddingTest, PadZeroed) {
+  set_pad_zeroed(true);
+  for (int i = Size; i < 512; i++) {
+    (*Output)[0][i] = 1.f;
+  }
+  // The copy must still be padded
+  Do((*Input)[0], (*Output)[0]);
+  for (int i = Size; i < 512; i++) {
+    ASSERT_EQ(0.f, (*Output)[0][i]);
+  }
+  auto buffer = (*Output)[0];
+  memcpy(buffer, (*Input)[0], Size * sizeof(buffer[0]));
+  buffer[Size] = 1.f;
+  Do(buffer, buffer);
+  ASSERT_EQ(1.f, buffer[Size]);
+}
+
+TEST(ZeroPadding, InPlace) {
+  std::unique_ptr<TransformTree> trees[2];
+  std::unordered_map<std::string, std::shared_ptr<Buffers>> results[2];
+  int16_t* buffers = new int16_t[48000];
+  memcpy(buffers, data, sizeof(data));
+  for (int copy = 0; copy < 2; copy++) {
+    trees[copy].reset(new TransformTree({ 48000, 16000 }));  // NOLINT(*)
+    auto& tt = *trees[copy];
+    tt.set_validate_after_each_transform(true);
+    tt.AddFeature("Spectrum", { { "Window", "length=400, step=160" },
+                                { "ZeroPadding", "" }, { "RDFT", "" },
+                                { "SpectralEnergy", "" } });
+    if (copy) {
+      // The sibling reads the unpadded windows, so they are copied
+      tt.AddFeature("Energy", { { "Window", "length=400, step=160" },
+                                { "Energy", "" } });
+    }
+    tt.PrepareForExecution();
+    results[copy] = tt.Execute(buffers);
+  }
+  // The padded windows are pinned, the context zeroes the pads of its own
+  // memory only once
+  auto context = trees[0]->CreateExecutionContext();
+  trees[0]->Execute(buffers, context.get());
+  auto& again = trees[0]->Execute(buffers, context.get()).find(
+      "Spectrum")->second;
+  delete[] buffers;
+  auto& expected = results[1]["Spectrum"];
+  auto& actual = results[0]["Spectrum"];
+  ASSERT_EQ(expected->Count(), actual->Count());
+  ASSERT_EQ(expected->Count(), again->Count());
+  size_t size = expected->Format()->UnalignedSizeInBytes();
+  for (size_t i = 0; i < actual->Count(); i++) {
+    ASSERT_EQ(0, memcmp((*expected)[i], (*actual)[i], size)) << i;
+    ASSERT_EQ(0, memcmp((*expected)[i], (*again)[i], size)) << i;
+  }
+}
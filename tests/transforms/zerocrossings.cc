@@ -37,6 +37,7 @@ using sound_feature_extraction::formats::ArrayFormat16;
 using sound_feature_extraction::BuffersBase;
 using sound_feature_extraction::transforms::ZeroCrossingsF;
 using sound_feature_extraction::transforms::ZeroCrossings16;
+using sound_feature_extraction::InstructionSet;
 
 class ZeroCrossingsWindowTest : public TransformTest<ZeroCrossingsF> {
  public:
@@ -61,6 +62,25 @@ TEST_F(ZeroCrossingsWindowTest, Do) {
   ASSERT_EQ(Size / 2 + 1, slowres);
 }
 
+TEST_F(ZeroCrossingsWindowTest, InstructionSets) {
+  for (int i = 0; i < Size; i++) {
+    (*Input)[0][i] = (i % 7 == 0)? 0 : ((i * 7919) % 200 - 100) / 7.f;
+  }
+  for (int length = Size - 17; length <= Size; length++) {
+    int reference = DoInternal(false, (*Input)[0], length);
+    for (int isa = 0; isa <= static_cast<int>(InstructionSet::kAVX512);
+         isa++) {
+      if (!IsSupported(static_cast<InstructionSet>(isa))) {
+        continue;
+      }
+      set_max_instruction_set(static_cast<InstructionSet>(isa));
+      ASSERT_EQ(reference, DoInternal(true, (*Input)[0], length))
+          << isa << " " << length;
+    }
+  }
+  set_max_instruction_set(InstructionSet::kAVX512);
+}
+
 #define CLASS_NAME ZeroCrossingsWindowTest
 #define ITER_COUNT 400000
 #define NO_OUTPUT
@@ -89,6 +109,27 @@ TEST_F(ZeroCrossingsRawTest, Do) {
   ASSERT_EQ(Size / 2, slowres);
 }
 
+TEST_F(ZeroCrossingsRawTest, InstructionSets) {
+  for (int i = 0; i < Size; i++) {
+    (*Input)[0][i] = (i % 5 == 0)? 0 : (i * 7919) % 65536 - 32768;
+  }
+  (*Input)[0][10] = (*Input)[0][11] = 77;
+  (*Input)[0][20] = -77;
+  for (int length = Size - 33; length <= Size; length++) {
+    int reference = DoInternal(false, (*Input)[0], length);
+    for (int isa = 0; isa <= static_cast<int>(InstructionSet::kAVX512);
+         isa++) {
+      if (!IsSupported(static_cast<InstructionSet>(isa))) {
+        continue;
+      }
+      set_max_instruction_set(static_cast<InstructionSet>(isa));
+      ASSERT_EQ(reference, DoInternal(true, (*Input)[0], length))
+          << isa << " " << length;
+    }
+  }
+  set_max_instruction_set(InstructionSet::kAVX512);
+}
+
 #undef CLASS_NAME
 #define CLASS_NAME ZeroCrossingsRawTest
 #undef INPUT_TYPE
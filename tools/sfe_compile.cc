@@ -0,0 +1,215 @@
+/*! @file sfe_compile.cc
+ *  @brief Compiles a prepared feature configuration into a plugin.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#include <getopt.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sound_feature_extraction/api.h>
+
+void PrintUsage(const char* name) {
+  fprintf(stderr,
+          "Usage: %s -f FEATURE [-f FEATURE ...] -s SIZE -r RATE "
+          "-o OUTPUT [-p PLUGIN]\n"
+          "  -f, --feature  the feature in the library's syntax, e.g.,\n"
+          "                 \"MFCC [Window, RDFT, SpectralEnergy, "
+          "FilterBank, Log, DCT]\"\n"
+          "  -s, --size     the number of samples in each input buffer\n"
+          "  -r, --rate     the sampling rate\n"
+          "  -o, --output   the C++ source file to generate\n"
+          "  -p, --plugin   compile the source into this shared library with "
+          "$CXX\n"
+          "                 and $CXXFLAGS, see "
+          "load_compiled_features_configuration()\n",
+          name);
+}
+
+/// @brief Escapes the string for a C++ literal.
+std::string Quote(const std::string& str) {
+  std::string res("\"");
+  for (char c : str) {
+    switch (c) {
+      case '"':
+      case '\\':
+        res += '\\';
+        res += c;
+        break;
+      case '\n':
+        res += "\\n";
+        break;
+      default:
+        res += c;
+        break;
+    }
+  }
+  return res + '"';
+}
+
+/// @brief Prepares the configuration and returns the image which
+/// save_features_configuration() writes.
+bool PrepareImage(const std::vector<const char*>& features, size_t size,
+                  int rate, std::string* image) {
+  auto config = setup_features_extraction(&features[0], features.size(),
+                                          size, rate);
+  if (config == nullptr) {
+    fprintf(stderr, "Failed to set up the features extraction\n");
+    return false;
+  }
+  char tmp[] = "/tmp/sfe_compile_XXXXXX";
+  int fd = mkstemp(tmp);
+  if (fd < 0) {
+    perror("mkstemp");
+    destroy_features_configuration(config);
+    return false;
+  }
+  close(fd);
+  bool saved = save_features_configuration(config, tmp) ==
+      FEATURE_EXTRACTION_RESULT_OK;
+  destroy_features_configuration(config);
+  if (saved) {
+    std::ifstream file(tmp, std::ios::in | std::ios::binary);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    *image = contents.str();
+  }
+  unlink(tmp);
+  return saved;
+}
+
+bool WriteSource(const std::vector<const char*>& features, size_t size,
+                 int rate, const std::string& image, const char* output) {
+  std::string joined;
+  for (auto feature : features) {
+    if (!joined.empty()) {
+      joined += '\n';
+    }
+    joined += feature;
+  }
+  FILE* file = fopen(output, "w");
+  if (file == nullptr) {
+    perror(output);
+    return false;
+  }
+  fprintf(file,
+          "// Generated by sfe-compile, do not edit.\n"
+          "#include <sound_feature_extraction/api.h>\n\n"
+          "alignas(64) static const unsigned char kImage[] = {");
+  for (size_t i = 0; i < image.size(); i++) {
+    fprintf(file, "%s%u,", i % 16 == 0? "\n  " : " ",
+            static_cast<unsigned char>(image[i]));
+  }
+  fprintf(file,
+          "\n};\n\n"
+          "extern \"C\" {\n"
+          "extern const CompiledFeaturesConfiguration "
+          "sfe_compiled_features_configuration;\n"
+          "const CompiledFeaturesConfiguration "
+          "sfe_compiled_features_configuration = {\n"
+          "  %s,\n  %zu, %d,\n  kImage, sizeof(kImage)\n};\n"
+          "}\n", Quote(joined).c_str(), size, rate);
+  return fclose(file) == 0;
+}
+
+bool CompilePlugin(const char* source, const char* plugin) {
+  const char* cxx = getenv("CXX");
+  const char* flags = getenv("CXXFLAGS");
+  std::string command(cxx != nullptr? cxx : "c++");
+  command += " -std=c++11 -shared -fPIC ";
+  if (flags != nullptr) {
+    command += flags;
+    command += ' ';
+  }
+  command += std::string("-o '") + plugin + "' '" + source + "'";
+  if (system(command.c_str()) != 0) {
+    fprintf(stderr, "Failed to run %s\n", command.c_str());
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char** argv) {
+  static const option kOptions[] = {
+    { "feature", required_argument, nullptr, 'f' },
+    { "size", required_argument, nullptr, 's' },
+    { "rate", required_argument, nullptr, 'r' },
+    { "output", required_argument, nullptr, 'o' },
+    { "plugin", required_argument, nullptr, 'p' },
+    { "help", no_argument, nullptr, 'h' },
+    { nullptr, 0, nullptr, 0 }
+  };
+  std::vector<const char*> features;
+  long size = 0;
+  int rate = 0;
+  const char* output = nullptr;
+  const char* plugin = nullptr;
+  int opt;
+  while ((opt = getopt_long(argc, argv, "f:s:r:o:p:h", kOptions,
+                            nullptr)) != -1) {
+    switch (opt) {
+      case 'f':
+        features.push_back(optarg);
+        break;
+      case 's':
+        size = atol(optarg);
+        break;
+      case 'r':
+        rate = atoi(optarg);
+        break;
+      case 'o':
+        output = optarg;
+        break;
+      case 'p':
+        plugin = optarg;
+        break;
+      default:
+        PrintUsage(argv[0]);
+        return opt == 'h'? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+  }
+  if (features.empty() || size <= 0 || rate <= 0 || output == nullptr) {
+    PrintUsage(argv[0]);
+    return EXIT_FAILURE;
+  }
+  std::string image;
+  if (!PrepareImage(features, size, rate, &image) ||
+      !WriteSource(features, size, rate, image, output)) {
+    return EXIT_FAILURE;
+  }
+  if (plugin != nullptr && !CompilePlugin(output, plugin)) {
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,665 @@
+/*! @file sfe_extract.cc
+ *  @brief Extracts the features from many audio files into a columnar file.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+#include <sound_feature_extraction/api.h>
+
+/// @file
+/// The output file is designed to be memory mapped by the readers:
+///
+///   ColumnsHeader
+///   names: FeaturesCount feature names, then FilesCount input paths,
+///          each as uint32_t length followed by the characters
+///   index: ColumnEntry[FeaturesCount][FilesCount] at IndexOffset
+///   data:  the results of each feature for all the files one after
+///          another (a column), every block aligned to kBlockAlignment
+///
+/// The feature names go in the order of query_features_layout().
+///
+/// In the sharded mode the nodes of a cluster share a directory (e.g., on
+/// NFS), which holds only the lists of the input paths and the results:
+///
+///   <shard>.todo                 waits for a worker; the first line is
+///                                "# attempts N", then a path per line
+///   <shard>.<host>.<pid>.running is being processed by that worker
+///   <shard>.done                 succeeded, the results are in <shard>.cols
+///   <shard>.failed               failed more than --retries times
+///
+/// The workers claim the shards by renaming them, which is atomic, so no
+/// coordinator has to run while the shards are processed.
+
+namespace {
+
+constexpr char kColumnsMagic[8] = "SFECOLS";
+constexpr uint32_t kColumnsVersion = 1;
+constexpr size_t kBlockAlignment = 64;
+
+struct ColumnsHeader {
+  char Magic[8];
+  uint32_t Version;
+  uint32_t FeaturesCount;
+  uint64_t FilesCount;
+  uint64_t IndexOffset;
+};
+
+struct ColumnEntry {
+  uint64_t Offset;
+  uint64_t Size;
+};
+
+size_t Align(size_t value, size_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+/// @brief The memory mapped input file.
+struct Input {
+  std::string Path;
+  void* Mapping = MAP_FAILED;
+  size_t MappingSize = 0;
+  /// @brief The interleaved PCM samples inside Mapping.
+  const int16_t* Samples = nullptr;
+  size_t Length = 0;
+  int Channels = 1;
+  int SamplingRate = 0;
+  FeaturesConfiguration* Config = nullptr;
+  std::chrono::steady_clock::duration Latency {};
+  bool Failed = false;
+};
+
+uint32_t ReadLE32(const uint8_t* ptr) {
+  return ptr[0] | (ptr[1] << 8) | (ptr[2] << 16) |
+      (static_cast<uint32_t>(ptr[3]) << 24);
+}
+
+uint16_t ReadLE16(const uint8_t* ptr) {
+  return ptr[0] | (ptr[1] << 8);
+}
+
+/// @brief Locates the samples of the 16-bit PCM RIFF/WAVE file.
+bool ParseWav(Input* input) {
+  auto data = reinterpret_cast<const uint8_t*>(input->Mapping);
+  size_t size = input->MappingSize;
+  if (size < 12 || memcmp(data, "RIFF", 4) != 0 ||
+      memcmp(data + 8, "WAVE", 4) != 0) {
+    fprintf(stderr, "%s: not a RIFF/WAVE file\n", input->Path.c_str());
+    return false;
+  }
+  bool format_found = false;
+  for (size_t pos = 12; pos + 8 <= size;) {
+    uint32_t chunk_size = ReadLE32(data + pos + 4);
+    const uint8_t* chunk = data + pos + 8;
+    if (chunk_size > size - pos - 8) {
+      chunk_size = size - pos - 8;
+    }
+    if (memcmp(data + pos, "fmt ", 4) == 0 && chunk_size >= 16) {
+      uint16_t tag = ReadLE16(chunk);
+      uint16_t bits = ReadLE16(chunk + 14);
+      if ((tag != 1 && tag != 0xFFFE) || bits != 16) {
+        fprintf(stderr, "%s: only 16-bit PCM is supported\n",
+                input->Path.c_str());
+        return false;
+      }
+      input->Channels = ReadLE16(chunk + 2);
+      input->SamplingRate = ReadLE32(chunk + 4);
+      format_found = true;
+    } else if (memcmp(data + pos, "data", 4) == 0) {
+      if (!format_found || input->Channels < 1) {
+        fprintf(stderr, "%s: \"data\" goes before \"fmt \"\n",
+                input->Path.c_str());
+        return false;
+      }
+      if (reinterpret_cast<uintptr_t>(chunk) % sizeof(int16_t) != 0) {
+        fprintf(stderr, "%s: the samples are misaligned\n",
+                input->Path.c_str());
+        return false;
+      }
+      input->Samples = reinterpret_cast<const int16_t*>(chunk);
+      input->Length = chunk_size / sizeof(int16_t) / input->Channels;
+      return true;
+    }
+    pos += 8 + chunk_size + (chunk_size & 1);
+  }
+  fprintf(stderr, "%s: no \"data\" chunk\n", input->Path.c_str());
+  return false;
+}
+
+bool MapInput(Input* input, int rawSamplingRate) {
+  int fd = open(input->Path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    fprintf(stderr, "%s: %s\n", input->Path.c_str(), strerror(errno));
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) < 0 || st.st_size == 0) {
+    fprintf(stderr, "%s: empty or unreadable\n", input->Path.c_str());
+    close(fd);
+    return false;
+  }
+  input->MappingSize = st.st_size;
+  input->Mapping = mmap(nullptr, input->MappingSize, PROT_READ, MAP_PRIVATE,
+                        fd, 0);
+  close(fd);
+  if (input->Mapping == MAP_FAILED) {
+    fprintf(stderr, "%s: mmap() failed: %s\n", input->Path.c_str(),
+            strerror(errno));
+    return false;
+  }
+  // The samples are read once from the beginning to the end
+  madvise(input->Mapping, input->MappingSize, MADV_SEQUENTIAL);
+  if (rawSamplingRate > 0) {
+    input->Samples = reinterpret_cast<const int16_t*>(input->Mapping);
+    input->Length = input->MappingSize / sizeof(int16_t);
+    input->SamplingRate = rawSamplingRate;
+    return true;
+  }
+  return ParseWav(input);
+}
+
+void PrintUsage(const char* name) {
+  fprintf(stderr,
+          "Usage: %s -f FEATURE [-f FEATURE ...] -o OUTPUT [-j JOBS] "
+          "[-r RATE] FILE...\n"
+          "       %s -d DIR -s SHARDS FILE...\n"
+          "       %s -d DIR -f FEATURE [-f FEATURE ...] [-j JOBS] [-r RATE] "
+          "[-R RETRIES]\n"
+          "       %s -d DIR -q\n"
+          "  -f, --feature    the feature in the library's syntax, e.g.,\n"
+          "                   \"MFCC [Window, RDFT, SpectralEnergy, "
+          "FilterBank, Log, DCT]\"\n"
+          "  -o, --output     the columnar file to write\n"
+          "  -j, --jobs       the number of files processed concurrently "
+          "(the number of CPUs by default)\n"
+          "  -r, --raw        the inputs are headerless mono 16-bit PCM with "
+          "the specified sampling rate\n"
+          "  -d, --shard-dir  the directory shared by the workers; without "
+          "-s or -q,\n"
+          "                   process its shards until none is left\n"
+          "  -s, --split      split the files into this number of shards\n"
+          "  -R, --retries    how many times a failed shard is retried "
+          "(2 by default)\n"
+          "  -q, --requeue    return the shards of the dead workers to "
+          "the queue\n", name, name, name, name);
+}
+
+double Seconds(const std::chrono::steady_clock::duration& d) {
+  return std::chrono::duration_cast<std::chrono::duration<double>>(d).count();
+}
+
+void ReportStats(const std::vector<Input>& inputs,
+                 const std::chrono::steady_clock::duration& wall,
+                 size_t outputSize) {
+  std::vector<double> latencies;
+  double audio = 0;
+  size_t bytes = 0;
+  for (auto& input : inputs) {
+    if (input.Failed) {
+      continue;
+    }
+    latencies.push_back(Seconds(input.Latency) * 1000);
+    audio += static_cast<double>(input.Length) / input.SamplingRate;
+    bytes += input.Length * input.Channels * sizeof(int16_t);
+  }
+  if (latencies.empty()) {
+    return;
+  }
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [&latencies](double p) {
+    return latencies[std::min(latencies.size() - 1,
+                              static_cast<size_t>(p * latencies.size()))];
+  };
+  double seconds = Seconds(wall);
+  fprintf(stderr,
+          "Processed %zu files (%.1f s of audio, %.1f MiB) in %.3f s\n"
+          "Throughput: %.1f files/s, %.1f MiB/s, %.1fx realtime\n"
+          "Latency, ms: p50 %.2f, p90 %.2f, p99 %.2f, max %.2f\n"
+          "Output: %.1f MiB\n",
+          latencies.size(), audio, bytes / 1048576.0, seconds,
+          latencies.size() / seconds, bytes / 1048576.0 / seconds,
+          audio / seconds, percentile(0.5), percentile(0.9),
+          percentile(0.99), latencies.back(), outputSize / 1048576.0);
+}
+
+/// @brief The configurations shared by the files of the same format
+/// (length, channels and sampling rate).
+typedef std::map<std::tuple<size_t, int, int>, FeaturesConfiguration*>
+    Configs;
+
+/// @brief Extracts the features from the files into the columnar output.
+/// @return The exit code.
+int ExtractFiles(const std::vector<const char*>& features,
+                 const std::vector<std::string>& paths, const char* output,
+                 int jobs, int rawSamplingRate, Configs* configs) {
+  std::vector<Input> inputs;
+  for (auto& path : paths) {
+    Input input;
+    input.Path = path;
+    if (!MapInput(&input, rawSamplingRate) || input.Length == 0) {
+      if (input.Mapping != MAP_FAILED) {
+        munmap(input.Mapping, input.MappingSize);
+      }
+      continue;
+    }
+    auto& config = (*configs)[std::make_tuple(
+        input.Length, input.Channels, input.SamplingRate)];
+    if (config == nullptr) {
+      config = input.Channels == 1?
+          setup_features_extraction(features.data(), features.size(),
+                                    input.Length, input.SamplingRate) :
+          setup_features_extraction_multichannel(
+              features.data(), features.size(), input.Length,
+              input.Channels, input.SamplingRate,
+              CHANNELS_LAYOUT_INTERLEAVED);
+      if (config == nullptr) {
+        fprintf(stderr, "Failed to set up the extraction for %s\n",
+                input.Path.c_str());
+        // The worker goes on with the next shard
+        munmap(input.Mapping, input.MappingSize);
+        for (auto& mapped : inputs) {
+          munmap(mapped.Mapping, mapped.MappingSize);
+        }
+        return EXIT_FAILURE;
+      }
+    }
+    input.Config = config;
+    inputs.push_back(input);
+  }
+  if (inputs.empty()) {
+    fprintf(stderr, "No valid input files\n");
+    return EXIT_FAILURE;
+  }
+
+  // Plan the output layout
+  std::vector<std::string> names;
+  std::vector<ColumnEntry> index;
+  size_t offset = sizeof(ColumnsHeader);
+  size_t index_offset = 0;
+  {
+    std::vector<std::vector<int>> lengths(inputs.size());
+    for (size_t i = 0; i < inputs.size(); i++) {
+      char** feature_names;
+      int* result_lengths;
+      int count;
+      query_features_layout(inputs[i].Config, &feature_names,
+                            &result_lengths, &count);
+      lengths[i].assign(result_lengths, result_lengths + count);
+      if (names.empty()) {
+        names.assign(feature_names, feature_names + count);
+      }
+      free_results(count, feature_names, nullptr, result_lengths);
+    }
+    for (auto& name : names) {
+      offset += sizeof(uint32_t) + name.size();
+    }
+    for (auto& input : inputs) {
+      offset += sizeof(uint32_t) + input.Path.size();
+    }
+    offset = Align(offset, alignof(ColumnEntry));
+    index_offset = offset;
+    offset += names.size() * inputs.size() * sizeof(ColumnEntry);
+    index.resize(names.size() * inputs.size());
+    for (size_t f = 0; f < names.size(); f++) {
+      for (size_t i = 0; i < inputs.size(); i++) {
+        offset = Align(offset, kBlockAlignment);
+        index[f * inputs.size() + i] = { offset,
+                                         static_cast<uint64_t>(
+                                             lengths[i][f]) };
+        offset += lengths[i][f];
+      }
+    }
+  }
+
+  int fd = open(output, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0 || ftruncate(fd, offset) < 0) {
+    fprintf(stderr, "%s: %s\n", output, strerror(errno));
+    return EXIT_FAILURE;
+  }
+  auto columns = reinterpret_cast<char*>(
+      mmap(nullptr, offset, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0));
+  close(fd);
+  if (columns == MAP_FAILED) {
+    fprintf(stderr, "%s: mmap() failed: %s\n", output, strerror(errno));
+    return EXIT_FAILURE;
+  }
+  ColumnsHeader header;
+  memcpy(header.Magic, kColumnsMagic, sizeof(header.Magic));
+  header.Version = kColumnsVersion;
+  header.FeaturesCount = names.size();
+  header.FilesCount = inputs.size();
+  header.IndexOffset = index_offset;
+  memcpy(columns, &header, sizeof(header));
+  char* ptr = columns + sizeof(header);
+  auto append_string = [&ptr](const std::string& str) {
+    uint32_t length = str.size();
+    memcpy(ptr, &length, sizeof(length));
+    memcpy(ptr + sizeof(length), str.data(), length);
+    ptr += sizeof(length) + length;
+  };
+  for (auto& name : names) {
+    append_string(name);
+  }
+  for (auto& input : inputs) {
+    append_string(input.Path);
+  }
+  memcpy(columns + index_offset, index.data(),
+         index.size() * sizeof(ColumnEntry));
+
+  // Each worker takes the next file; the configurations keep one execution
+  // context per concurrent extraction, so at most "jobs" of them exist
+  std::atomic<size_t> next(0);
+  auto work = [&]() {
+    std::vector<void*> outputs(names.size());
+    for (size_t i; (i = next++) < inputs.size();) {
+      auto& input = inputs[i];
+      for (size_t f = 0; f < names.size(); f++) {
+        outputs[f] = columns + index[f * inputs.size() + i].Offset;
+      }
+      auto start = std::chrono::steady_clock::now();
+      // The library does not write to the input
+      auto samples = const_cast<int16_t*>(input.Samples);
+      if (input.Channels == 1) {
+        input.Failed = extract_sound_features_into(
+            input.Config, samples, outputs.data()) !=
+            FEATURE_EXTRACTION_RESULT_OK;
+      } else {
+        char** feature_names;
+        void** results;
+        int* result_lengths;
+        input.Failed = extract_sound_features_batch(
+            input.Config, samples, &feature_names, &results,
+            &result_lengths) != FEATURE_EXTRACTION_RESULT_OK;
+        if (!input.Failed) {
+          for (size_t f = 0; f < names.size(); f++) {
+            auto it = std::find(names.begin(), names.end(), feature_names[f]);
+            memcpy(outputs[it - names.begin()], results[f],
+                   result_lengths[f]);
+          }
+          free_results(names.size(), feature_names, results, result_lengths);
+        }
+      }
+      input.Latency = std::chrono::steady_clock::now() - start;
+      if (input.Failed) {
+        fprintf(stderr, "%s: extraction failed\n", input.Path.c_str());
+      }
+      munmap(input.Mapping, input.MappingSize);
+    }
+  };
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> workers;
+  for (int j = 1; j < std::min<int>(jobs, inputs.size()); j++) {
+    workers.emplace_back(work);
+  }
+  work();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  auto wall = std::chrono::steady_clock::now() - start;
+  bool failed = msync(columns, offset, MS_SYNC) < 0;
+  munmap(columns, offset);
+  ReportStats(inputs, wall, offset);
+  failed |= std::any_of(inputs.begin(), inputs.end(),
+                        [](const Input& input) { return input.Failed; });
+  return failed? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/// @brief Returns the names of the directory entries with the suffix,
+/// sorted.
+std::vector<std::string> ListShards(const std::string& dir,
+                                    const std::string& suffix) {
+  std::vector<std::string> ret;
+  DIR* handle = opendir(dir.c_str());
+  if (handle == nullptr) {
+    fprintf(stderr, "%s: %s\n", dir.c_str(), strerror(errno));
+    return ret;
+  }
+  while (auto entry = readdir(handle)) {
+    std::string name = entry->d_name;
+    if (name.size() > suffix.size() &&
+        name.compare(name.size() - suffix.size(), suffix.size(),
+                     suffix) == 0) {
+      ret.push_back(name);
+    }
+  }
+  closedir(handle);
+  std::sort(ret.begin(), ret.end());
+  return ret;
+}
+
+/// @brief Writes the shard list, which starts with the attempts count.
+bool WriteShard(const std::string& file, int attempts,
+                const std::vector<std::string>& paths) {
+  std::ofstream stream(file);
+  stream << "# attempts " << attempts << '\n';
+  for (auto& path : paths) {
+    stream << path << '\n';
+  }
+  return static_cast<bool>(stream);
+}
+
+bool ReadShard(const std::string& file, int* attempts,
+               std::vector<std::string>* paths) {
+  std::ifstream stream(file);
+  std::string line;
+  if (!std::getline(stream, line) ||
+      sscanf(line.c_str(), "# attempts %d", attempts) != 1) {
+    return false;
+  }
+  while (std::getline(stream, line)) {
+    if (!line.empty()) {
+      paths->push_back(line);
+    }
+  }
+  return true;
+}
+
+/// @brief Splits the files into the shards of the same size.
+int SplitShards(const std::string& dir, const std::vector<std::string>& paths,
+                int shards) {
+  shards = std::min<int>(shards, paths.size());
+  for (int i = 0; i < shards; i++) {
+    std::vector<std::string> shard(
+        paths.begin() + paths.size() * i / shards,
+        paths.begin() + paths.size() * (i + 1) / shards);
+    char name[32];
+    snprintf(name, sizeof(name), "/%06d.todo", i);
+    if (!WriteShard(dir + name, 0, shard)) {
+      fprintf(stderr, "%s%s: failed to write\n", dir.c_str(), name);
+      return EXIT_FAILURE;
+    }
+  }
+  fprintf(stderr, "Split %zu files into %d shards\n", paths.size(), shards);
+  return EXIT_SUCCESS;
+}
+
+/// @brief Returns the shards of the dead workers to the queue.
+int RequeueShards(const std::string& dir) {
+  int count = 0;
+  for (auto& name : ListShards(dir, ".running")) {
+    auto shard = name.substr(0, name.find('.'));
+    if (rename((dir + '/' + name).c_str(),
+               (dir + '/' + shard + ".todo").c_str()) == 0) {
+      count++;
+    }
+  }
+  fprintf(stderr, "Requeued %d shards\n", count);
+  return EXIT_SUCCESS;
+}
+
+/// @brief Claims and processes the shards until none is left.
+int ProcessShards(const std::string& dir,
+                  const std::vector<const char*>& features, int jobs,
+                  int rawSamplingRate, int retries, Configs* configs) {
+  char host[256] = "localhost";
+  gethostname(host, sizeof(host) - 1);
+  std::string owner = std::string(".") + host + '.' +
+      std::to_string(getpid()) + ".running";
+  int processed = 0, failed = 0;
+  for (bool claimed = true; claimed;) {
+    claimed = false;
+    for (auto& name : ListShards(dir, ".todo")) {
+      auto shard = dir + '/' + name.substr(0, name.find('.'));
+      // Someone else could have claimed it since the listing
+      if (rename((dir + '/' + name).c_str(), (shard + owner).c_str()) != 0) {
+        continue;
+      }
+      claimed = true;
+      int attempts;
+      std::vector<std::string> paths;
+      if (!ReadShard(shard + owner, &attempts, &paths)) {
+        fprintf(stderr, "%s: malformed shard\n", shard.c_str());
+        rename((shard + owner).c_str(), (shard + ".failed").c_str());
+        failed++;
+        continue;
+      }
+      fprintf(stderr, "Processing %s (%zu files, attempt %d)\n",
+              shard.c_str(), paths.size(), attempts + 1);
+      if (ExtractFiles(features, paths, (shard + ".cols").c_str(), jobs,
+                       rawSamplingRate, configs) == EXIT_SUCCESS) {
+        rename((shard + owner).c_str(), (shard + ".done").c_str());
+        processed++;
+      } else if (attempts < retries &&
+                 WriteShard(shard + owner, attempts + 1, paths)) {
+        rename((shard + owner).c_str(), (shard + ".todo").c_str());
+      } else {
+        rename((shard + owner).c_str(), (shard + ".failed").c_str());
+        failed++;
+      }
+    }
+  }
+  fprintf(stderr, "Worker %s finished: %d shards done, %d failed\n",
+          owner.substr(1, owner.size() - 9).c_str(), processed, failed);
+  return failed > 0? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  static const option kOptions[] = {
+    { "feature", required_argument, nullptr, 'f' },
+    { "output", required_argument, nullptr, 'o' },
+    { "jobs", required_argument, nullptr, 'j' },
+    { "raw", required_argument, nullptr, 'r' },
+    { "shard-dir", required_argument, nullptr, 'd' },
+    { "split", required_argument, nullptr, 's' },
+    { "retries", required_argument, nullptr, 'R' },
+    { "requeue", no_argument, nullptr, 'q' },
+    { "help", no_argument, nullptr, 'h' },
+    { nullptr, 0, nullptr, 0 }
+  };
+  std::vector<const char*> features;
+  const char* output = nullptr;
+  int jobs = std::max(1u, std::thread::hardware_concurrency());
+  int raw_sampling_rate = 0;
+  const char* shard_dir = nullptr;
+  int shards = 0;
+  int retries = 2;
+  bool requeue = false;
+  int opt;
+  while ((opt = getopt_long(argc, argv, "f:o:j:r:d:s:R:qh", kOptions,
+                            nullptr)) != -1) {
+    switch (opt) {
+      case 'f':
+        features.push_back(optarg);
+        break;
+      case 'o':
+        output = optarg;
+        break;
+      case 'j':
+        jobs = atoi(optarg);
+        break;
+      case 'r':
+        raw_sampling_rate = atoi(optarg);
+        break;
+      case 'd':
+        shard_dir = optarg;
+        break;
+      case 's':
+        shards = atoi(optarg);
+        break;
+      case 'R':
+        retries = atoi(optarg);
+        break;
+      case 'q':
+        requeue = true;
+        break;
+      default:
+        PrintUsage(argv[0]);
+        return opt == 'h'? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+  }
+  std::vector<std::string> paths(argv + optind, argv + argc);
+  if (shard_dir != nullptr && requeue) {
+    return RequeueShards(shard_dir);
+  }
+  if (shard_dir != nullptr && shards > 0 && !paths.empty()) {
+    return SplitShards(shard_dir, paths, shards);
+  }
+  bool worker = shard_dir != nullptr && paths.empty() && retries >= 0;
+  if (features.empty() || jobs < 1 ||
+      (!worker && (output == nullptr || paths.empty()))) {
+    PrintUsage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  // The files are processed concurrently, so each extraction is sequential
+  set_omp_transforms_max_threads_num(1);
+  // The files of the same format share the prepared configuration, also
+  // between the shards
+  Configs configs;
+  int ret = worker?
+      ProcessShards(shard_dir, features, jobs, raw_sampling_rate, retries,
+                    &configs) :
+      ExtractFiles(features, paths, output, jobs, raw_sampling_rate,
+                   &configs);
+  for (auto& config : configs) {
+    destroy_features_configuration(config.second);
+  }
+  return ret;
+}
@@ -0,0 +1,368 @@
+/*! @file sfe_replay.cc
+ *  @brief Replays the recorded extractions as a benchmark.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#include <getopt.h>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <sound_feature_extraction/api.h>
+
+/// @file
+/// Reads the file written by start_traffic_recording() (see
+/// src/traffic_recorder.h for its layout), sets up the recorded
+/// configurations and executes each record several times. The report has
+/// a line per transform tree node, "name<TAB>calls<TAB>seconds", and
+/// the "throughput" line with the samples per second; it can be passed
+/// back with -b to print the differences between the builds.
+
+namespace {
+
+struct Record {
+  std::string Features;
+  int SamplingRate;
+  int SampleType;
+  uint64_t Samples;
+  std::vector<char> Data;
+};
+
+struct Config {
+  FeaturesConfiguration* Handle;
+  int FeaturesCount;
+};
+
+void PrintUsage(const char* name) {
+  fprintf(stderr,
+          "Usage: %s [-n REPEATS] [-o REPORT] [-b BASELINE] TRAFFIC\n"
+          "  -n, --repeats   how many times each record is executed "
+          "(10 by default)\n"
+          "  -o, --output    write the report to this file\n"
+          "  -b, --baseline  print the differences from this report\n",
+          name);
+}
+
+bool ReadString(std::ifstream* file, std::string* str) {
+  uint32_t length;
+  if (!file->read(reinterpret_cast<char*>(&length), sizeof(length))) {
+    return false;
+  }
+  str->resize(length);
+  return length == 0 || static_cast<bool>(file->read(&(*str)[0], length));
+}
+
+bool ReadRecord(std::ifstream* file, Record* record) {
+  std::string fingerprint;
+  uint32_t count;
+  if (!ReadString(file, &fingerprint) ||
+      !file->read(reinterpret_cast<char*>(&count), sizeof(count))) {
+    return false;
+  }
+  record->Features.clear();
+  for (uint32_t i = 0; i < count; i++) {
+    std::string feature;
+    if (!ReadString(file, &feature)) {
+      return false;
+    }
+    record->Features += feature + '\n';
+  }
+  int32_t rate, type;
+  uint64_t size;
+  if (!file->read(reinterpret_cast<char*>(&rate), sizeof(rate)) ||
+      !file->read(reinterpret_cast<char*>(&type), sizeof(type)) ||
+      !file->read(reinterpret_cast<char*>(&record->Samples),
+                  sizeof(record->Samples)) ||
+      !file->read(reinterpret_cast<char*>(&size), sizeof(size))) {
+    return false;
+  }
+  record->SamplingRate = rate;
+  record->SampleType = type;
+  record->Data.resize(size);
+  return static_cast<bool>(file->read(record->Data.data(), size));
+}
+
+bool ReadRecords(const char* path, std::vector<Record>* records) {
+  std::ifstream file(path, std::ios::in | std::ios::binary);
+  char magic[8];
+  if (!file.read(magic, sizeof(magic)) ||
+      memcmp(magic, "SFETRAFC", sizeof(magic)) != 0) {
+    fprintf(stderr, "%s is not a traffic recording\n", path);
+    return false;
+  }
+  Record record;
+  while (file.peek() != EOF) {
+    if (!ReadRecord(&file, &record)) {
+      fprintf(stderr, "%s is truncated after %zu records\n", path,
+              records->size());
+      break;
+    }
+    records->push_back(record);
+  }
+  return !records->empty();
+}
+
+/// @brief Sets up the configuration of the record, once for all the records
+/// with the same features and format.
+const Config* Setup(const Record& record,
+                    std::map<std::string, Config>* configs) {
+  auto key = record.Features + std::to_string(record.SamplingRate) + ' ' +
+      std::to_string(record.SampleType) + ' ' +
+      std::to_string(record.Samples);
+  auto it = configs->find(key);
+  if (it != configs->end()) {
+    return &it->second;
+  }
+  std::vector<std::string> lines;
+  size_t begin = 0, end;
+  while ((end = record.Features.find('\n', begin)) != std::string::npos) {
+    lines.push_back(record.Features.substr(begin, end - begin));
+    begin = end + 1;
+  }
+  std::vector<const char*> features;
+  for (auto& line : lines) {
+    features.push_back(line.c_str());
+  }
+  auto setup = record.SampleType == 1? setup_features_extraction_int32 :
+      record.SampleType == 2? setup_features_extraction_float :
+      setup_features_extraction;
+  auto fc = setup(features.data(), features.size(), record.Samples,
+                  record.SamplingRate);
+  if (fc == nullptr) {
+    fprintf(stderr, "Failed to set up the recorded features:\n%s",
+            record.Features.c_str());
+    return nullptr;
+  }
+  auto& config = (*configs)[key];
+  config = { fc, static_cast<int>(features.size()) };
+  return &config;
+}
+
+bool Execute(const Config& config, const Record& record) {
+  auto fc = config.Handle;
+  char** names;
+  void** results;
+  int* lengths;
+  FeatureExtractionResult result;
+  auto data = const_cast<char*>(record.Data.data());
+  switch (record.SampleType) {
+    case 1:
+      result = extract_sound_features_int32(
+          fc, reinterpret_cast<int32_t*>(data), &names, &results, &lengths);
+      break;
+    case 2:
+      result = extract_sound_features_float(
+          fc, reinterpret_cast<float*>(data), &names, &results, &lengths);
+      break;
+    default:
+      result = extract_sound_features(
+          fc, reinterpret_cast<int16_t*>(data), &names, &results, &lengths);
+      break;
+  }
+  if (result != FEATURE_EXTRACTION_RESULT_OK) {
+    return false;
+  }
+  free_results(config.FeaturesCount, names, results, lengths);
+  return true;
+}
+
+typedef std::map<std::string, std::pair<int, double>> Report;
+
+Report CollectReport(const std::map<std::string, Config>& configs) {
+  Report report;
+  for (auto& config : configs) {
+    char** names;
+    NodeProfile* profiles;
+    int length;
+    report_extraction_profile(config.second.Handle, &names, &profiles,
+                              &length);
+    for (int i = 0; i < length; i++) {
+      auto& node = report[names[i]];
+      node.first += profiles[i].calls;
+      node.second += profiles[i].total;
+    }
+    destroy_extraction_profile(names, profiles, length);
+  }
+  return report;
+}
+
+bool ReadReport(const char* path, Report* report, double* throughput) {
+  std::ifstream file(path);
+  if (!file) {
+    perror(path);
+    return false;
+  }
+  std::string line;
+  while (std::getline(file, line)) {
+    auto tab = line.find('\t');
+    if (tab == std::string::npos) {
+      continue;
+    }
+    auto name = line.substr(0, tab);
+    if (name == "throughput") {
+      *throughput = atof(line.c_str() + tab + 1);
+      continue;
+    }
+    auto& node = (*report)[name];
+    char* end;
+    node.first = strtol(line.c_str() + tab + 1, &end, 10);
+    node.second = atof(end);
+  }
+  return true;
+}
+
+double PerCall(const std::pair<int, double>& node) {
+  return node.first > 0? node.second / node.first : 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  static const option kOptions[] = {
+    { "repeats", required_argument, nullptr, 'n' },
+    { "output", required_argument, nullptr, 'o' },
+    { "baseline", required_argument, nullptr, 'b' },
+    { "help", no_argument, nullptr, 'h' },
+    { nullptr, 0, nullptr, 0 }
+  };
+  int repeats = 10;
+  const char* output = nullptr;
+  const char* baseline = nullptr;
+  int opt;
+  while ((opt = getopt_long(argc, argv, "n:o:b:h", kOptions,
+                            nullptr)) != -1) {
+    switch (opt) {
+      case 'n':
+        repeats = atoi(optarg);
+        break;
+      case 'o':
+        output = optarg;
+        break;
+      case 'b':
+        baseline = optarg;
+        break;
+      default:
+        PrintUsage(argv[0]);
+        return opt == 'h'? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+  }
+  if (optind != argc - 1 || repeats < 1) {
+    PrintUsage(argv[0]);
+    return EXIT_FAILURE;
+  }
+  std::vector<Record> records;
+  if (!ReadRecords(argv[optind], &records)) {
+    return EXIT_FAILURE;
+  }
+  std::map<std::string, Config> configs;
+  std::vector<const Config*> handles;
+  for (auto& record : records) {
+    auto config = Setup(record, &configs);
+    if (config == nullptr) {
+      return EXIT_FAILURE;
+    }
+    handles.push_back(config);
+  }
+  // The first pass warms up the plans and the caches, enabling
+  // the profiling afterwards drops its statistics
+  for (size_t i = 0; i < records.size(); i++) {
+    Execute(*handles[i], records[i]);
+  }
+  for (auto& config : configs) {
+    set_extraction_profiling(config.second.Handle,
+                             EXTRACTION_PROFILING_STATISTICS);
+  }
+  uint64_t samples = 0;
+  int failed = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int repeat = 0; repeat < repeats; repeat++) {
+    for (size_t i = 0; i < records.size(); i++) {
+      if (Execute(*handles[i], records[i])) {
+        samples += records[i].Samples;
+      } else {
+        failed++;
+      }
+    }
+  }
+  double seconds = std::chrono::duration_cast<std::chrono::duration<double>>(
+      std::chrono::steady_clock::now() - start).count();
+  double throughput = samples / seconds;
+  auto report = CollectReport(configs);
+  printf("%zu records, %zu configurations, %d failed extractions\n"
+         "%.0f samples/s, %.3f ms per record\n", records.size(),
+         configs.size(), failed, throughput,
+         seconds * 1000 / (records.size() * repeats));
+  Report base;
+  double base_throughput = 0;
+  if (baseline != nullptr && ReadReport(baseline, &base, &base_throughput)) {
+    if (base_throughput > 0) {
+      printf("throughput %+.1f%%\n",
+             (throughput / base_throughput - 1) * 100);
+    }
+    printf("%-60s %12s %12s %8s\n", "node", "baseline us", "us", "delta");
+    for (auto& node : report) {
+      auto it = base.find(node.first);
+      if (it == base.end() || PerCall(it->second) == 0) {
+        continue;
+      }
+      double was = PerCall(it->second), now = PerCall(node.second);
+      printf("%-60s %12.2f %12.2f %+7.1f%%\n", node.first.c_str(),
+             was * 1e6, now * 1e6, (now / was - 1) * 100);
+    }
+  } else {
+    printf("%-60s %8s %12s\n", "node", "calls", "us");
+    for (auto& node : report) {
+      printf("%-60s %8d %12.2f\n", node.first.c_str(), node.second.first,
+             PerCall(node.second) * 1e6);
+    }
+  }
+  if (output != nullptr) {
+    FILE* file = fopen(output, "w");
+    if (file == nullptr) {
+      perror(output);
+      return EXIT_FAILURE;
+    }
+    fprintf(file, "throughput\t%f\n", throughput);
+    for (auto& node : report) {
+      fprintf(file, "%s\t%d\t%g\n", node.first.c_str(), node.second.first,
+              node.second.second);
+    }
+    fclose(file);
+  }
+  for (auto& config : configs) {
+    destroy_features_configuration(config.second.Handle);
+  }
+  return failed > 0? EXIT_FAILURE : EXIT_SUCCESS;
+}